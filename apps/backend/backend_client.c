@@ -55,9 +55,13 @@
 #include <sys/socket.h>
 #include <sys/param.h>
 #include <sys/types.h>
+#include <sys/wait.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <netinet/in.h>
+#ifdef HAVE_MALLOC_TRIM
+#include <malloc.h>
+#endif
 
 /* cligen */
 #include <cligen/cligen.h>
@@ -71,6 +75,37 @@
 #include "backend_handle.h"
 #include "backend_get.h"
 #include "backend_client.h"
+#include "backend_stamp.h"
+#include "backend_push.h"
+#include "backend_replica.h"
+
+/*! Stats of a YANG tree, valid for one YANG generation
+ *
+ * @see clixon_stats_module_get
+ */
+struct stats_yang{
+    uint64_t sy_gen;  /* YANG generation, see yang_stats_generation */
+    uint64_t sy_nr;   /* Number of YANG statements */
+    size_t   sy_size; /* Size in bytes */
+};
+
+/* yang_stmt pointer as string -> struct stats_yang */
+static clicon_hash_t *_stats_yang = NULL;
+
+/*! Source text of a YANG module as escaped XML character data, valid for one YANG generation
+ *
+ * @see from_client_get_schema
+ */
+struct schema_text{
+    uint64_t st_gen;    /* YANG generation, see yang_stats_generation */
+    char     st_text[]; /* Null-terminated */
+};
+
+/* yang_stmt pointer as string -> struct schema_text */
+static clicon_hash_t *_schema_text = NULL;
+
+/* Bytes returned to the OS after operations, see CLICON_MEMORY_TRIM */
+static uint64_t _memory_trimmed = 0;
 
 /*! Find client by session-id 
  *
@@ -126,6 +161,283 @@ ce_client_descr(struct client_entry *ce,
     return retval;
 }
 
+/*! Add message-id attribute of a pipelined request to its reply
+ *
+ * Replies of pipelined requests may be sent out of order. The client matches
+ * replies to requests by message-id.
+ * @param[in,out] cbret  Reply message on the form <rpc-reply ...>
+ * @param[in]     msgid  message-id of request
+ * @retval        0      OK
+ * @retval       -1      Error
+ */
+static int
+ce_reply_msgid(cbuf *cbret,
+               char *msgid)
+{
+    int    retval = -1;
+    cbuf  *cb = NULL;
+    char  *str;
+    char  *p;
+
+    str = cbuf_get(cbret);
+    if (strncmp(str, "<rpc-reply", strlen("<rpc-reply")) != 0 ||
+        (p = strchr(str, '>')) == NULL)
+        goto ok;
+    if (*(p-1) == '/')
+        p--;
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if (cbuf_append_buf(cb, str, p-str) < 0){
+        clixon_err(OE_UNIX, errno, "cbuf_append_buf");
+        goto done;
+    }
+    cprintf(cb, " message-id=\"");
+    if (xml_chardata_cbuf_append(cb, 1, msgid) < 0)
+        goto done;
+    cprintf(cb, "\"%s", p);
+    cbuf_reset(cbret);
+    cprintf(cbret, "%s", cbuf_get(cb));
+ ok:
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Send reply message to a client
+ *
+ * @param[in]  h      Clixon handle
+ * @param[in]  ce     Client entry
+ * @param[in]  cbret  Reply message
+ * @retval     0      OK, or client closed socket
+ * @retval    -1      Error
+ */
+static int
+ce_reply_send(clixon_handle        h,
+              struct client_entry *ce,
+              cbuf                *cbret)
+{
+    int   retval = -1;
+    cbuf *cbce = NULL;
+
+    if (ce_client_descr(ce, &cbce) < 0)
+        goto done;
+    if (backend_client_notify_flush(ce) < 0)
+        goto done;
+    if (send_msg_reply(ce->ce_s, cbuf_get(cbce), cbuf_get(cbret), cbuf_len(cbret)+1) < 0){
+        switch (errno){
+        case EPIPE:
+            /* man (2) write: 
+             * EPIPE  fd is connected to a pipe or socket whose reading end is 
+             * closed.  When this happens the writing process will also receive 
+             * a SIGPIPE signal. 
+             * In Clixon this means a client, eg restconf, netconf or cli closes
+             * the (UNIX domain) socket.
+             */
+        case ECONNRESET:
+            clixon_log(h, LOG_WARNING, "client rpc reset");
+            break;
+        default:
+            goto done;
+        }
+    }
+    retval = 0;
+ done:
+    if (cbce)
+        cbuf_free(cbce);
+    return retval;
+}
+
+/*! Discard notification queue of client
+ */
+static void
+ce_notify_purge(struct client_entry *ce)
+{
+    struct ce_notify *cn;
+
+    while ((cn = ce->ce_notify) != NULL){
+        ce->ce_notify = cn->cn_next;
+        ce->ce_notify_dropped++;
+        stream_msg_free(cn->cn_msg);
+        free(cn);
+    }
+    ce->ce_notify_last = NULL;
+    ce->ce_notify_len = 0;
+}
+
+/*! Write queued notifications to client socket
+ *
+ * @param[in]  ce     Client entry
+ * @param[in]  block  0: Write until socket would block, 1: Write all
+ * @retval     0      OK, queue may not be empty if not block, or client closed socket
+ * @retval    -1      Error
+ */
+static int
+ce_notify_write(struct client_entry *ce,
+                int                  block)
+{
+    int               retval = -1;
+    struct ce_notify *cn;
+    stream_msg       *sm;
+    ssize_t           n;
+
+    while ((cn = ce->ce_notify) != NULL){
+        sm = cn->cn_msg;
+        if ((n = send(ce->ce_s, sm->sm_buf + cn->cn_off, sm->sm_len - cn->cn_off,
+                      block?0:MSG_DONTWAIT)) < 0){
+            if (errno == EINTR)
+                continue;
+            if ((errno == EAGAIN || errno == EWOULDBLOCK) && !block)
+                break;
+            if (errno == ECONNRESET || errno == EPIPE || errno == EBADF){
+                /* Client shutdown, drop queue, socket is closed when read fails */
+                ce_notify_purge(ce);
+                break;
+            }
+            clixon_err(OE_UNIX, errno, "send");
+            goto done;
+        }
+        cn->cn_off += n;
+        if (cn->cn_off < sm->sm_len)
+            continue;
+        ce->ce_notify = cn->cn_next;
+        ce->ce_notify_len -= sm->sm_len;
+        stream_msg_free(sm);
+        free(cn);
+    }
+    if (ce->ce_notify == NULL){
+        ce->ce_notify_last = NULL;
+        if (ce->ce_notify_drop == 1){
+            clixon_log(ce->ce_handle, LOG_NOTICE, "client %d: notifications resumed", ce->ce_nr);
+            ce->ce_notify_drop = 0;
+        }
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Writable callback of client socket: write queued notifications, unregister when empty
+ *
+ * @param[in]  fd   Client socket
+ * @param[in]  arg  Client entry
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+ce_notify_writable(int   fd,
+                   void *arg)
+{
+    int                  retval = -1;
+    struct client_entry *ce = (struct client_entry *)arg;
+
+    if (ce_notify_write(ce, 0) < 0)
+        goto done;
+    if (ce->ce_notify == NULL)
+        clixon_event_unreg_fd_write(fd, ce_notify_writable);
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Send notification to client without blocking, queue what cannot be written
+ *
+ * The message is shared with other subscribers of the same event, a queued message keeps
+ * a reference. The queue is written when the socket is writable.
+ * If the queue exceeds CLICON_STREAM_QUEUE_MAX, CLICON_STREAM_QUEUE_POLICY decides if the
+ * notification is dropped or if the client is disconnected.
+ * @param[in]  h      Clixon handle
+ * @param[in]  ce     Client entry
+ * @param[in]  sm     Notification message
+ * @retval     1      OK, sent or queued
+ * @retval     0      OK, dropped since queue is full
+ * @retval    -1      Error
+ */
+static int
+ce_notify_send(clixon_handle        h,
+               struct client_entry *ce,
+               stream_msg          *sm)
+{
+    int               retval = -1;
+    struct ce_notify *cn;
+    uint32_t          max;
+    int               empty;
+    char             *policy;
+
+    if (ce->ce_notify_drop == 2){ /* Disconnected */
+        ce->ce_notify_dropped++;
+        netconf_monitoring_counter_inc(h, "dropped-notifications");
+        retval = 0;
+        goto done;
+    }
+    max = clicon_option_int(h, "CLICON_STREAM_QUEUE_MAX");
+    if (max && ce->ce_notify_len + sm->sm_len > max){
+        ce->ce_notify_dropped++;
+        netconf_monitoring_counter_inc(h, "dropped-notifications");
+        policy = clicon_option_str(h, "CLICON_STREAM_QUEUE_POLICY");
+        if (policy && strcmp(policy, "disconnect") == 0){
+            /* The client is not removed here since the stream subscriptions are being
+             * traversed, the read of the socket fails and removes it */
+            clixon_log(h, LOG_WARNING, "client %d: notification queue full, disconnected",
+                       ce->ce_nr);
+            clixon_event_unreg_fd_write(ce->ce_s, ce_notify_writable);
+            ce_notify_purge(ce);
+            shutdown(ce->ce_s, SHUT_RDWR);
+            ce->ce_notify_drop = 2;
+        }
+        else if (ce->ce_notify_drop == 0){
+            clixon_log(h, LOG_WARNING, "client %d: notification queue full, notifications dropped",
+                       ce->ce_nr);
+            ce->ce_notify_drop = 1;
+        }
+        retval = 0;
+        goto done;
+    }
+    if ((cn = malloc(sizeof(*cn))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    memset(cn, 0, sizeof(*cn));
+    sm->sm_refcnt++;
+    cn->cn_msg = sm;
+    empty = (ce->ce_notify == NULL);
+    if (empty)
+        ce->ce_notify = cn;
+    else
+        ce->ce_notify_last->cn_next = cn;
+    ce->ce_notify_last = cn;
+    ce->ce_notify_len += sm->sm_len;
+    /* If not empty, the socket is already waited for */
+    if (empty){
+        if (ce_notify_write(ce, 0) < 0)
+            goto done;
+        if (ce->ce_notify &&
+            clixon_event_reg_fd_write(ce->ce_s, ce_notify_writable, ce, "queued notifications") < 0)
+            goto done;
+    }
+    retval = 1;
+ done:
+    return retval;
+}
+
+/*! Write all queued notifications to client, before a reply is sent
+ *
+ * @param[in]  ce     Client entry
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+int
+backend_client_notify_flush(struct client_entry *ce)
+{
+    if (ce->ce_notify == NULL)
+        return 0;
+    clixon_event_unreg_fd_write(ce->ce_s, ce_notify_writable);
+    return ce_notify_write(ce, 1);
+}
+
 /*! Stream callback for netconf stream notification (RFC 5277)
  *
  * @param[in]  h     Clixon handle
@@ -144,7 +456,8 @@ ce_event_cb(clixon_handle h,
 {
     int                  retval = -1;
     struct client_entry *ce = (struct client_entry *)arg;
-    cbuf                *cbce = NULL;
+    stream_msg          *sm = NULL;
+    int                  ret;
 
     clixon_debug(CLIXON_DBG_BACKEND, "op:%d", op);
     switch (op){
@@ -154,31 +467,33 @@ ce_event_cb(clixon_handle h,
             backend_client_rm(h, ce);
         break;
     default:
-        if (ce_client_descr(ce, &cbce) < 0)
+        /* Serialized once and shared by all subscribers of the event */
+        if ((sm = stream_msg_get(event)) == NULL)
             goto done;
-        if (send_msg_notify_xml(h, ce->ce_s, cbuf_get(cbce), event) < 0){
-            if (errno == ECONNRESET || errno == EPIPE){
-                clixon_log(h, LOG_WARNING, "client %d reset", ce->ce_nr);
-            }
+        if ((ret = ce_notify_send(h, ce, sm)) < 0)
+            goto done;
+        if (ret == 0)
             break;
-        }
         /* note there may be other notifications than RFC5277 streams */
         ce->ce_out_notifications++;
         netconf_monitoring_counter_inc(h, "out-notifications");
     }
     retval = 0;
  done:
-    if (cbce)
-        cbuf_free(cbce);
+    if (sm)
+        stream_msg_free(sm);
     return retval;
 }
 
 /*! Unlock all db:s of a client and call user unlock calback 
  *
+ * Also lock waits of the client are removed, and other waiting sessions are woken
  * @param[in]  h       Clixon handle
  * @param[in]  id      Session id
  * @see xmldb_unlock_all  unlocks, but does not call user callbacks which is a backend thing
  */
+static void lock_wait_purge(uint32_t id);
+
 static int
 release_all_dbs(clixon_handle h,
                 uint32_t      id)
@@ -196,6 +511,7 @@ release_all_dbs(clixon_handle h,
             goto done;
         xmldb_modified_set(h, "candidate", 0); /* reset dirty bit */
     }
+    lock_wait_purge(id);
     /* get all db:s */
     if (clicon_hash_keys(clicon_db_elmnt(h), &keys, &klen) < 0)
         goto done;
@@ -209,6 +525,8 @@ release_all_dbs(clixon_handle h,
             clicon_db_elmnt_set(h, keys[i], de);
             if (clixon_plugin_lockdb_all(h, keys[i], 0, id) < 0)
                 goto done;
+            if (backend_lock_wait_wake(h, keys[i]) < 0)
+                goto done;
         }
     }
     retval = 0;
@@ -283,6 +601,9 @@ backend_monitoring_state_get(clixon_handle h,
         cprintf(cb, "<in-bad-rpcs>%u</in-bad-rpcs>", ce->ce_in_bad_rpcs);
         cprintf(cb, "<out-rpc-errors>%u</out-rpc-errors>", ce->ce_out_rpc_errors);
         cprintf(cb, "<out-notifications>%u</out-notifications>", ce->ce_out_notifications);
+        if (ce->ce_notify_dropped)
+            cprintf(cb, "<dropped-notifications xmlns=\"%s\">%u</dropped-notifications>",
+                    CLIXON_LIB_NS, ce->ce_notify_dropped);
         cprintf(cb, "</session>");
     }
     cprintf(cb, "</sessions>");
@@ -302,6 +623,84 @@ backend_monitoring_state_get(clixon_handle h,
     goto done;
 }
 
+/*! Translate candidate to the private candidate of a session
+ *
+ * If CLICON_XMLDB_PRIVATE_CANDIDATE is set, each session edits its own candidate, forked
+ * from running at first use. A base fork of running is kept for the rebase at commit.
+ * @param[in]  h    Clixon handle
+ * @param[in]  ce   Client entry
+ * @param[in]  db   Datastore name of request
+ * @retval     db   Datastore to use, db itself if not candidate or not private
+ * @retval     NULL Error
+ * @see backend_candidate_reset
+ */
+char *
+backend_candidate_db(clixon_handle        h,
+                     struct client_entry *ce,
+                     char                *db)
+{
+    char name[64];
+
+    if (strcmp(db, "candidate") != 0 ||
+        !clicon_option_bool(h, "CLICON_XMLDB_PRIVATE_CANDIDATE"))
+        return db;
+    if (ce->ce_candidate == NULL){
+        snprintf(name, sizeof(name), "candidate-%u", ce->ce_id);
+        if ((ce->ce_candidate = strdup(name)) == NULL){
+            clixon_err(OE_UNIX, errno, "strdup");
+            return NULL;
+        }
+        snprintf(name, sizeof(name), "candidate-%u-base", ce->ce_id);
+        if ((ce->ce_candidate_base = strdup(name)) == NULL){
+            clixon_err(OE_UNIX, errno, "strdup");
+            return NULL;
+        }
+        if (backend_candidate_reset(h, ce) < 0)
+            return NULL;
+    }
+    return ce->ce_candidate;
+}
+
+/*! Reset private candidate of a session to running, eg discard-changes or after commit
+ *
+ * @param[in]  h    Clixon handle
+ * @param[in]  ce   Client entry
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+backend_candidate_reset(clixon_handle        h,
+                        struct client_entry *ce)
+{
+    if (ce->ce_candidate == NULL)
+        return 0;
+    if (xmldb_fork(h, "running", ce->ce_candidate_base) < 0)
+        return -1;
+    if (xmldb_fork(h, "running", ce->ce_candidate) < 0)
+        return -1;
+    return 0;
+}
+
+/*! Remove private candidate of a session
+ *
+ * Private candidates are only in memory, remove cache and datastore entry
+ * @param[in]  h    Clixon handle
+ * @param[in]  ce   Client entry
+ */
+static int
+backend_candidate_rm(clixon_handle        h,
+                     struct client_entry *ce)
+{
+    if (ce->ce_candidate == NULL)
+        return 0;
+    if (xmldb_clear(h, ce->ce_candidate) < 0 ||
+        xmldb_clear(h, ce->ce_candidate_base) < 0)
+        return -1;
+    clicon_hash_del(clicon_db_elmnt(h), ce->ce_candidate);
+    clicon_hash_del(clicon_db_elmnt(h), ce->ce_candidate_base);
+    return 0;
+}
+
 /*! Remove client entry state
  *
  * Close down everything wrt clients (eg sockets, subscriptions)
@@ -350,6 +749,10 @@ backend_client_rm(clixon_handle        h,
     clixon_debug(CLIXON_DBG_BACKEND, "");
     /* for all streams: XXX better to do it top-level? */
     stream_ss_delete_all(h, ce_event_cb, (void*)ce);
+    backend_push_session_rm(h, myid);
+    clixon_pagination_cursor_rm(h, myid);
+    if (ce->ce_notify && ce->ce_s)
+        clixon_event_unreg_fd_write(ce->ce_s, ce_notify_writable);
     c0 = backend_client_list(h);
     ce_prev = &c0; /* this points to stack and is not real backpointer */
     for (c = *ce_prev; c; c = c->ce_next){
@@ -365,6 +768,10 @@ backend_client_rm(clixon_handle        h,
         }
         ce_prev = &c->ce_next;
     }
+    if (backend_candidate_rm(h, ce) < 0)
+        goto done;
+    if (ce->ce_memtag)
+        clixon_mem_tag_release(ce->ce_memtag);
     retval = backend_client_delete(h, ce); /* actually purge it */
  done:
     return retval;
@@ -402,7 +809,7 @@ clixon_stats_datastore_get(clixon_handle h,
         xt = xmldb_cache_get(h, dbname);
     }
     if (xt != NULL){
-        if (xml_stats(xt, &nr, &sz) < 0)
+        if (xmldb_cache_stats(h, dbname, &nr, &sz) < 0)
             goto done;
         cprintf(cb, "<datastore><name>%s</name><nr>%" PRIu64 "</nr>"
                 "<size>%zu</size></datastore>",
@@ -418,8 +825,10 @@ clixon_stats_datastore_get(clixon_handle h,
 
 /*! Get clixon per yang-spec stats
  *
+ * Stats are kept per YANG node until a YANG statement is created or freed, see
+ * yang_stats_generation()
  * @param[in]     h       Clixon handle
- * @param[in]     dbname  Datastore name
+ * @param[in]     ys      YANG domain or module
  * @param[in,out] cb      Cligen buf
  * @retval        0       OK
  * @retval       -1       Error
@@ -429,23 +838,47 @@ clixon_stats_module_get(clixon_handle h,
                         yang_stmt    *ys,
                         cbuf         *cb)
 {
-    int       retval = -1;
-    uint64_t  nr = 0;
-    size_t    sz = 0;
-    cxobj    *xn = NULL;
+    int                retval = -1;
+    struct stats_yang  sy = {0,};
+    struct stats_yang *syp;
+    char               key[32];
 
     if (ys == NULL)
         return 0;
-    if (yang_stats(ys, 0, &nr, &sz) < 0)
+    if (_stats_yang == NULL &&
+        (_stats_yang = clicon_hash_init()) == NULL)
         goto done;
-    cprintf(cb, "<nr>%" PRIu64 "</nr><size>%zu</size>", nr, sz);
+    snprintf(key, sizeof(key), "%p", ys);
+    if ((syp = clicon_hash_value(_stats_yang, key, NULL)) == NULL ||
+        syp->sy_gen != yang_stats_generation()){
+        if (yang_stats(ys, 0, &sy.sy_nr, &sy.sy_size) < 0)
+            goto done;
+        sy.sy_gen = yang_stats_generation();
+        if (clicon_hash_add(_stats_yang, key, &sy, sizeof(sy)) == NULL)
+            goto done;
+        syp = &sy;
+    }
+    cprintf(cb, "<nr>%" PRIu64 "</nr><size>%zu</size>", syp->sy_nr, syp->sy_size);
     retval = 0;
  done:
-    if (xn)
-        xml_free(xn);
     return retval;
 }
 
+/*! Free kept per yang-spec stats
+ *
+ * @param[in]  h    Clixon handle
+ * @retval     0    OK
+ */
+int
+backend_client_stats_free(clixon_handle h)
+{
+    if (_stats_yang){
+        clicon_hash_free(_stats_yang);
+        _stats_yang = NULL;
+    }
+    return 0;
+}
+
 /*! Do lock checks and lock
 
  * @param[in]  h     Clixon handle
@@ -513,63 +946,293 @@ do_lock(clixon_handle h,
     goto done;
 }
 
-/*! Loads all or part of a specified configuration to target configuration
- * 
- * @param[in]  h       Clixon handle 
- * @param[in]  xn      Request: <rpc><xn></rpc> 
- * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error.. 
- * @param[in]  arg     client-entry
- * @param[in]  regarg  User argument given at rpc_callback_register() 
+/*! Session waiting for a datastore lock, see cl:wait attribute of lock rpc
+ */
+struct lock_waiter {
+    struct lock_waiter *lw_next;
+    clixon_handle       lw_h;       /* Clixon handle */
+    uint32_t            lw_id;      /* Session id of waiting client */
+    char               *lw_db;      /* Datastore */
+};
+
+/* FIFO queue of sessions waiting for datastore locks */
+static struct lock_waiter *_lock_waiters = NULL;
+
+/* Set if a lock wait run is scheduled */
+static int                 _lock_wait_sched = 0;
+
+static int lock_wait_timeout(int fd, void *arg);
+
+/*! Remove a lock waiter from the queue and free it
+ *
+ * @param[in]  lw   Lock waiter
+ */
+static void
+lock_wait_free(struct lock_waiter *lw)
+{
+    struct lock_waiter **lwp;
+
+    for (lwp = &_lock_waiters; *lwp; lwp = &(*lwp)->lw_next)
+        if (*lwp == lw){
+            *lwp = lw->lw_next;
+            break;
+        }
+    clixon_event_unreg_timeout(lock_wait_timeout, lw);
+    if (lw->lw_db)
+        free(lw->lw_db);
+    free(lw);
+}
+
+/*! Park a session waiting for a datastore lock, the reply is deferred
+ *
+ * @param[in]  h       Clixon handle
+ * @param[in]  ce      Client entry
+ * @param[in]  db      Datastore
+ * @param[in]  wait    Max time to wait in seconds
  * @retval     0       OK
  * @retval    -1       Error
- * @note  According to RFC 7950 8.3: constraints MUST be enforced:
- * o  during parsing of RPC payloads
- * o  during processing of the <edit-config> operation
- * But Clixon is flexible in allowing invalid XML payload here, only some specialized
- * validations are made.
- * However, what really should be done is to apply the change to the datastore and then
- * validate, if error, discard to previous state. 
- * But this could discard other previous changes to candidate.
+ * @see backend_lock_wait_wake
  */
 static int
-from_client_edit_config(clixon_handle h,
-                        cxobj        *xn,
-                        cbuf         *cbret,
-                        void         *arg,
-                        void         *regarg)
+lock_wait_add(clixon_handle        h,
+              struct client_entry *ce,
+              const char          *db,
+              uint32_t             wait)
 {
-    int                 retval = -1;
-    struct client_entry *ce = (struct client_entry *)arg;
-    uint32_t            myid = ce->ce_id;
-    uint32_t            iddb;
-    char               *target;
-    cxobj              *xc;
-    cxobj              *x;
-    enum operation_type operation = OP_MERGE;
-    int                 non_config = 0;
-    yang_stmt          *yspec;
-    cbuf               *cbx = NULL; /* Assist cbuf */
-    int                 ret;
-    char               *username;
-    cxobj              *xret = NULL;
-    char               *attr;
-    int                 autocommit = 0;
-    char               *val = NULL;
-    cvec               *nsc = NULL;
-    char               *prefix = NULL;
+    int                  retval = -1;
+    struct lock_waiter  *lw = NULL;
+    struct lock_waiter **lwp;
+    struct timeval       t;
 
-    username = clicon_username_get(h);
-    if ((yspec =  clicon_dbspec_yang(h)) == NULL){
-        clixon_err(OE_YANG, ENOENT, "No yang spec9");
+    if ((lw = malloc(sizeof(*lw))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
         goto done;
     }
-    if ((target = netconf_db_find(xn, "target")) == NULL){
-        if (netconf_missing_element(cbret, "protocol", "target", NULL) < 0)
-            goto done;
-        goto ok;
-    }
-    if ((cbx = cbuf_new()) == NULL){
-        clixon_err(OE_XML, errno, "cbuf_new");
+    memset(lw, 0, sizeof(*lw));
+    lw->lw_h = h;
+    lw->lw_id = ce->ce_id;
+    if ((lw->lw_db = strdup(db)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    gettimeofday(&t, NULL);
+    t.tv_sec += wait;
+    if (clixon_event_reg_timeout(t, lock_wait_timeout, lw, "lock wait") < 0)
+        goto done;
+    if (backend_client_defer(ce) < 0){
+        clixon_event_unreg_timeout(lock_wait_timeout, lw);
+        goto done;
+    }
+    for (lwp = &_lock_waiters; *lwp; lwp = &(*lwp)->lw_next)
+        ;
+    *lwp = lw;
+    lw = NULL;
+    clixon_debug(CLIXON_DBG_BACKEND, "session %u waits for lock of %s", ce->ce_id, db);
+    retval = 0;
+ done:
+    if (lw){
+        if (lw->lw_db)
+            free(lw->lw_db);
+        free(lw);
+    }
+    return retval;
+}
+
+/*! Lock wait timed out, reply lock-denied
+ *
+ * @param[in]  fd   Not used
+ * @param[in]  arg  Lock waiter
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+lock_wait_timeout(int   fd,
+                  void *arg)
+{
+    int                 retval = -1;
+    struct lock_waiter *lw = (struct lock_waiter *)arg;
+    clixon_handle       h = lw->lw_h;
+    uint32_t            id = lw->lw_id;
+    cbuf               *cbx = NULL;
+    cbuf               *cbret = NULL;
+
+    if ((cbx = cbuf_new()) == NULL || (cbret = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cbx, "<session-id>%u</session-id>", xmldb_islocked(h, lw->lw_db));
+    if (netconf_lock_denied(cbret, cbuf_get(cbx), "Operation failed, lock is already held") < 0)
+        goto done;
+    lock_wait_free(lw);
+    if (backend_client_reply_deferred(h, id, cbret) < 0)
+        goto done;
+    retval = 0;
+ done:
+    if (cbx)
+        cbuf_free(cbx);
+    if (cbret)
+        cbuf_free(cbret);
+    return retval;
+}
+
+/*! Grant datastore locks to waiting sessions in FIFO order
+ *
+ * @param[in]  fd   Not used
+ * @param[in]  arg  Clixon handle
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+lock_wait_run(int   fd,
+              void *arg)
+{
+    int                 retval = -1;
+    clixon_handle       h = (clixon_handle)arg;
+    struct lock_waiter *lw;
+    struct lock_waiter *lw_next;
+    uint32_t            id;
+    cbuf               *cbret = NULL;
+    int                 ret;
+
+    _lock_wait_sched = 0;
+    if ((cbret = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    for (lw = _lock_waiters; lw; lw = lw_next){
+        lw_next = lw->lw_next;
+        if (xmldb_islocked(h, lw->lw_db) != 0)
+            continue;
+        id = lw->lw_id;
+        if (ce_find_byid(backend_client_list(h), id) == NULL){
+            lock_wait_free(lw);
+            continue;
+        }
+        cbuf_reset(cbret);
+        if ((ret = do_lock(h, cbret, id, lw->lw_db)) < 0)
+            goto done;
+        if (ret == 1)
+            cprintf(cbret, "<rpc-reply xmlns=\"%s\"><ok/></rpc-reply>", NETCONF_BASE_NAMESPACE);
+        clixon_debug(CLIXON_DBG_BACKEND, "session %u waited for lock of %s: %s",
+                     id, lw->lw_db, ret?"granted":"denied");
+        lock_wait_free(lw);
+        if (backend_client_reply_deferred(h, id, cbret) < 0)
+            goto done;
+        lw_next = _lock_waiters; /* Replies may change the queue */
+    }
+    retval = 0;
+ done:
+    if (cbret)
+        cbuf_free(cbret);
+    return retval;
+}
+
+/*! Datastore may have been unlocked, wake the next session waiting for the lock
+ *
+ * The lock is granted in a separate event, not in the context of the unlock
+ * @param[in]  h   Clixon handle
+ * @param[in]  db  Datastore
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+int
+backend_lock_wait_wake(clixon_handle h,
+                       const char   *db)
+{
+    struct lock_waiter *lw;
+    struct timeval      t;
+
+    if (_lock_wait_sched || xmldb_islocked(h, db) != 0)
+        return 0;
+    for (lw = _lock_waiters; lw; lw = lw->lw_next)
+        if (strcmp(lw->lw_db, db) == 0)
+            break;
+    if (lw == NULL)
+        return 0;
+    gettimeofday(&t, NULL);
+    if (clixon_event_reg_timeout(t, lock_wait_run, h, "lock wait wake") < 0)
+        return -1;
+    _lock_wait_sched = 1;
+    return 0;
+}
+
+/*! Remove all lock waits of a session, eg when it is closed
+ *
+ * @param[in]  id  Session id
+ */
+static void
+lock_wait_purge(uint32_t id)
+{
+    struct lock_waiter *lw;
+    struct lock_waiter *lw_next;
+
+    for (lw = _lock_waiters; lw; lw = lw_next){
+        lw_next = lw->lw_next;
+        if (lw->lw_id == id)
+            lock_wait_free(lw);
+    }
+}
+
+/*! Loads all or part of a specified configuration to target configuration
+ * 
+ * @param[in]  h       Clixon handle 
+ * @param[in]  xn      Request: <rpc><xn></rpc> 
+ * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error.. 
+ * @param[in]  arg     client-entry
+ * @param[in]  regarg  User argument given at rpc_callback_register() 
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @note  According to RFC 7950 8.3: constraints MUST be enforced:
+ * o  during parsing of RPC payloads
+ * o  during processing of the <edit-config> operation
+ * But Clixon is flexible in allowing invalid XML payload here, only some specialized
+ * validations are made.
+ * However, what really should be done is to apply the change to the datastore and then
+ * validate, if error, discard to previous state. 
+ * But this could discard other previous changes to candidate.
+ */
+static int
+from_client_edit_config(clixon_handle h,
+                        cxobj        *xn,
+                        cbuf         *cbret,
+                        void         *arg,
+                        void         *regarg)
+{
+    int                 retval = -1;
+    struct client_entry *ce = (struct client_entry *)arg;
+    uint32_t            myid = ce->ce_id;
+    uint32_t            iddb;
+    char               *target;
+    char               *db;
+    cxobj              *xc;
+    cxobj              *x;
+    enum operation_type operation = OP_MERGE;
+    int                 non_config = 0;
+    yang_stmt          *yspec;
+    cbuf               *cbx = NULL; /* Assist cbuf */
+    int                 ret;
+    char               *username;
+    cxobj              *xret = NULL;
+    char               *attr;
+    int                 autocommit = 0;
+    char               *val = NULL;
+    cvec               *nsc = NULL;
+    char               *prefix = NULL;
+    int                 bulk;
+    cxobj              *xcand = NULL;
+
+    username = clicon_username_get(h);
+    if ((yspec =  clicon_dbspec_yang(h)) == NULL){
+        clixon_err(OE_YANG, ENOENT, "No yang spec9");
+        goto done;
+    }
+    if ((target = netconf_db_find(xn, "target")) == NULL){
+        if (netconf_missing_element(cbret, "protocol", "target", NULL) < 0)
+            goto done;
+        goto ok;
+    }
+    if ((cbx = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
         goto done;
     }
     /* Check if target locked by other client */
@@ -586,6 +1249,8 @@ from_client_edit_config(clixon_handle h,
         if (ret == 0)
             goto ok;
     }
+    if ((db = backend_candidate_db(h, ce, target)) == NULL)
+        goto done;
     if (xml_nsctx_node(xn, &nsc) < 0)
         goto done;
     /* Get prefix of netconf base namespace in the incoming message */
@@ -617,63 +1282,131 @@ from_client_edit_config(clixon_handle h,
     /* <config> yang spec may be set to anyxml by ingress yang check,...*/
     if (xml_spec(xc) != NULL)
         xml_spec_set(xc, NULL);
-    /* Populate XML with Yang spec. Binding is done in from_client_msg only frm an RPC perspective,
-     * where <config> is ANYDATA
-     */
-    if ((ret = xml_bind_yang(h, xc, YB_MODULE, yspec, &xret)) < 0)
-        goto done;
-    if (ret == 0){
-        if (clixon_xml2cbuf(cbret, xret, 0, 0, NULL, -1, 0) < 0)
+    bulk = clicon_option_int(h, "CLICON_NETCONF_BULK_SIZE");
+    if (bulk > 0 && ce->ce_msg_len > (size_t)bulk){
+        /* Large payload: bind, check state data, unique, list keys and sort in one pass */
+        if ((ret = xml_bind_yang_bulk(h, xc, yspec,
+                                      !clicon_option_bool(h, "CLICON_NETCONF_DUPLICATE_ALLOW"),
+                                      &xret)) < 0)
             goto done;
-        goto ok;
+        if (ret == 1 && (ret = xml_yang_validate_minmax(xc, 1, &xret)) < 0)
+            goto done;
+        if (ret == 0){
+            if (clixon_xml2cbuf(cbret, xret, 0, 0, NULL, -1, 0) < 0)
+                goto done;
+            goto ok;
+        }
     }
-    /* (Mark all nodes that are not configure data and) set return */
-    if ((ret = xml_non_config_data(xc, &xret)) < 0)
-        goto done;
-    if (ret == 0){
-        if (clixon_xml2cbuf(cbret, xret, 0, 0, NULL, -1, 0) < 0)
+    else {
+        /* Populate XML with Yang spec. Binding is done in from_client_msg only frm an RPC perspective,
+         * where <config> is ANYDATA
+         * Content of a binary message is already bound, see CLICON_SOCK_BINARY
+         */
+        if ((x = xml_child_i_type(xc, 0, CX_ELMNT)) != NULL && xml_spec(x) != NULL)
+            ret = 1;
+        else if ((ret = xml_bind_yang(h, xc, YB_MODULE, yspec, &xret)) < 0)
+            goto done;
+        if (ret == 0){
+            if (clixon_xml2cbuf(cbret, xret, 0, 0, NULL, -1, 0) < 0)
+                goto done;
+            goto ok;
+        }
+        /* (Mark all nodes that are not configure data and) set return */
+        if ((ret = xml_non_config_data(xc, &xret)) < 0)
+            goto done;
+        if (ret == 0){
+            if (clixon_xml2cbuf(cbret, xret, 0, 0, NULL, -1, 0) < 0)
+                goto done;
+            goto ok;
+        }
+        if (non_config){
+            if (netconf_invalid_value(cbret, "protocol", "State data not allowed")< 0)
+                goto done;
+            goto ok;
+        }
+        /* Limited validation of incoming payload
+         */
+        if ((ret = xml_yang_validate_minmax(xc, 1, &xret)) < 0)
+            goto done;
+        /* Disable duplicate check in NETCONF messages.*/
+        if (clicon_option_bool(h, "CLICON_NETCONF_DUPLICATE_ALLOW"))
+            ;
+        else if (ret == 1 && (ret = xml_yang_validate_unique_recurse(xc, &xret)) < 0)
+            goto done;
+        /* xmldb_put (difflist handling) requires list keys */
+        if (ret == 1 && (ret = xml_yang_validate_list_key_only(xc, &xret)) < 0)
+            goto done;
+        if (ret == 0){
+            if (clixon_xml2cbuf(cbret, xret, 0, 0, NULL, -1, 0) < 0)
+                goto done;
+            goto ok;
+        }
+        /* Cant do this earlier since we dont have a yang spec to
+         * the upper part of the tree, until we get the "config" tree.
+         */
+        if (xml_sort_recurse(xc) < 0)
             goto done;
-        goto ok;
     }
-    if (non_config){
-        if (netconf_invalid_value(cbret, "protocol", "State data not allowed")< 0)
+    /* Running is changed without a confirmed-commit, reverse diffs of an ongoing one do not cover it */
+    if (strcmp(target, "running") == 0 &&
+        rollback_diff_materialize(h) < 0){
+        if (netconf_operation_failed(cbret, "application", clixon_err_reason())< 0)
             goto done;
         goto ok;
     }
-    /* Limited validation of incoming payload
-     */
-    if ((ret = xml_yang_validate_minmax(xc, 1, &xret)) < 0)
-        goto done;
-    /* Disable duplicate check in NETCONF messages.*/
-    if (clicon_option_bool(h, "CLICON_NETCONF_DUPLICATE_ALLOW"))
-        ;
-    else if (ret == 1 && (ret = xml_yang_validate_unique_recurse(xc, &xret)) < 0)
-        goto done;
-    /* xmldb_put (difflist handling) requires list keys */
-    if (ret == 1 && (ret = xml_yang_validate_list_key_only(xc, &xret)) < 0)
-        goto done;
-    if (ret == 0){
-        if (clixon_xml2cbuf(cbret, xret, 0, 0, NULL, -1, 0) < 0)
+    /* Fast-path: apply edit directly to running as a commit transaction */
+    if (strcmp(target, "running") == 0 &&
+        clicon_option_bool(h, "CLICON_XMLDB_RUNNING_DIRECT")){
+        if ((ret = running_direct_commit(h, xc, operation, username, cbret)) < 0){
+            if (netconf_operation_failed(cbret, "application", clixon_err_reason())< 0)
+                goto done;
+            goto ok;
+        }
+        if (ret == 0)
+            goto ok;
+        goto copystartup;
+    }
+    /* Clixon extension: autocommit */
+    if ((attr = xml_find_value(xn, "autocommit")) != NULL &&
+        strcmp(attr,"true") == 0)
+        autocommit = 1;
+    /* Fast-path of autocommit, eg RESTCONF, of an unmodified candidate: apply edit
+     * directly to running, then the same edit to candidate, without a candidate commit */
+    if ((clicon_autocommit(h) || autocommit) &&
+        strcmp(db, "candidate") == 0 &&
+        clicon_option_bool(h, "CLICON_XMLDB_RUNNING_DIRECT") &&
+        clicon_option_bool(h, "CLICON_XMLDB_RUNNING_DIRECT_SPARSE") &&
+        xmldb_modified_get(h, db) == 0 &&
+        confirmed_commit_state_get(h) == INACTIVE &&
+        ((iddb = xmldb_islocked(h, "running")) == 0 || iddb == myid)){
+        if ((xcand = xml_dup(xc)) == NULL)
             goto done;
-        goto ok;
+        if ((ret = running_direct_commit(h, xc, operation, username, cbret)) < 0){
+            if (netconf_operation_failed(cbret, "application", clixon_err_reason())< 0)
+                goto done;
+            goto ok;
+        }
+        if (ret == 0)
+            goto ok;
+        if ((ret = xmldb_put(h, db, operation, xcand, username, cbret)) < 0)
+            goto done;
+        if (ret == 0){ /* Should not happen since running accepted it */
+            cbuf_reset(cbret);
+            if (xmldb_copy(h, "running", db) < 0)
+                goto done;
+        }
+        goto copystartup;
     }
-    /* Cant do this earlier since we dont have a yang spec to
-     * the upper part of the tree, until we get the "config" tree.
-     */
-    if (xml_sort_recurse(xc) < 0)
-        goto done;
-    if ((ret = xmldb_put(h, target, operation, xc, username, cbret)) < 0){
+    if ((ret = xmldb_put(h, db, operation, xc, username, cbret)) < 0){
         if (netconf_operation_failed(cbret, "protocol", clixon_err_reason())< 0)
             goto done;
         goto ok;
     }
     if (ret == 0)
         goto ok;
-    xmldb_modified_set(h, target, 1); /* mark as dirty */
-    /* Clixon extension: autocommit */
-    if ((attr = xml_find_value(xn, "autocommit")) != NULL &&
-        strcmp(attr,"true") == 0)
-        autocommit = 1;
+    xmldb_modified_set(h, db, 1); /* mark as dirty */
+    if (backend_stamp_edit(h, db, xc) < 0)
+        goto done;
     /* If autocommit option is set or requested by client */
     if (clicon_autocommit(h) || autocommit) {
         /* if this is from a restconf client ...
@@ -719,6 +1452,7 @@ from_client_edit_config(clixon_handle h,
             goto ok;
         }
     }
+ copystartup:
     /* Clixon extension: copy */
     if ((attr = xml_find_value(xn, "copystartup")) != NULL &&
         strcmp(attr,"true") == 0){
@@ -747,6 +1481,8 @@ from_client_edit_config(clixon_handle h,
         xml_free(xret);
     if (cbx)
         cbuf_free(cbx);
+    if (xcand)
+        xml_free(xcand);
     clixon_debug(CLIXON_DBG_BACKEND, "done cbret:%s", cbuf_get(cbret));
     return retval;
 } /* from_client_edit_config */
@@ -776,6 +1512,8 @@ from_client_copy_config(clixon_handle h,
     struct client_entry *ce = (struct client_entry *)arg;
     char                *source;
     char                *target;
+    char                *db;
+    char                *src;
     uint32_t             iddb;
     uint32_t             myid = ce->ce_id;
     cbuf                *cbx = NULL; /* Assist cbuf */
@@ -810,7 +1548,23 @@ from_client_copy_config(clixon_handle h,
         if (ret == 0)
             goto ok;
     }
-    if (xmldb_copy(h, source, target) < 0){
+    if ((db = backend_candidate_db(h, ce, target)) == NULL ||
+        (src = backend_candidate_db(h, ce, source)) == NULL)
+        goto done;
+    if (db == target && src != source){
+        if (netconf_operation_not_supported(cbret, "protocol",
+                                            "Copy from private candidate, use commit") < 0)
+            goto done;
+        goto ok;
+    }
+    if (strcmp(target, "running") == 0 &&
+        rollback_diff_materialize(h) < 0){
+        if (netconf_operation_failed(cbret, "application", clixon_err_reason())< 0)
+            goto done;
+        goto ok;
+    }
+    /* Private candidate is only in memory */
+    if ((db == target ? xmldb_copy(h, source, target) : xmldb_fork(h, src, db)) < 0){
         if ((cbmsg = cbuf_new()) == NULL){
             clixon_err(OE_UNIX, errno, "cbuf_new");
             goto done;
@@ -820,7 +1574,9 @@ from_client_copy_config(clixon_handle h,
             goto done;
         goto ok;
     }
-    xmldb_modified_set(h, target, 1); /* mark as dirty */
+    xmldb_modified_set(h, db, 1); /* mark as dirty */
+    if (backend_stamp_edit(h, db, NULL) < 0)
+        goto done;
     cprintf(cbret, "<rpc-reply xmlns=\"%s\"><ok/></rpc-reply>", NETCONF_BASE_NAMESPACE);
  ok:
     retval = 0;
@@ -856,6 +1612,9 @@ from_client_delete_config(clixon_handle h,
     uint32_t             myid = ce->ce_id;
     cbuf                *cbx = NULL; /* Assist cbuf */
     cbuf                *cbmsg = NULL;
+    char                *db;
+    cxobj               *xt = NULL;
+    int                  ret;
 
     /* XXX should use prefix cf edit_config */
     if ((target = netconf_db_find(xe, "target")) == NULL ||
@@ -876,6 +1635,24 @@ from_client_delete_config(clixon_handle h,
             goto done;
         goto ok;
     }
+    if ((db = backend_candidate_db(h, ce, target)) == NULL)
+        goto done;
+    if (db != target){ /* Private candidate is only in memory, replace with empty tree */
+        if ((xt = xml_new(DATASTORE_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
+            goto done;
+        if ((ret = xmldb_put(h, db, OP_REPLACE, xt, clicon_username_get(h), cbret)) < 0){
+            if (netconf_operation_failed(cbret, "protocol", clixon_err_reason())< 0)
+                goto done;
+            goto ok;
+        }
+        if (ret == 0)
+            goto ok;
+        xmldb_modified_set(h, db, 1); /* mark as dirty */
+        if (backend_stamp_edit(h, db, NULL) < 0)
+            goto done;
+        cprintf(cbret, "<rpc-reply xmlns=\"%s\"><ok/></rpc-reply>", NETCONF_BASE_NAMESPACE);
+        goto ok;
+    }
     if (xmldb_delete(h, target) < 0){
         if ((cbmsg = cbuf_new()) == NULL){
             clixon_err(OE_UNIX, errno, "cbuf_new");
@@ -897,10 +1674,14 @@ from_client_delete_config(clixon_handle h,
         goto ok;
     }
     xmldb_modified_set(h, target, 1); /* mark as dirty */
+    if (backend_stamp_edit(h, target, NULL) < 0)
+        goto done;
     cprintf(cbret, "<rpc-reply xmlns=\"%s\"><ok/></rpc-reply>", NETCONF_BASE_NAMESPACE);
  ok:
     retval = 0;
   done:
+    if (xt)
+        xml_free(xt);
     if (cbmsg)
         cbuf_free(cbmsg);
     if (cbx)
@@ -910,6 +1691,8 @@ from_client_delete_config(clixon_handle h,
 
 /*! Lock the configuration system of a device
  *
+ * If the lock is held by another session and the lock has a cl:wait attribute with a
+ * time in seconds, the session waits for the lock in FIFO order instead of being denied.
  * @param[in]  h       Clixon handle 
  * @param[in]  xe      Request: <rpc><xn></rpc>
  * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error..
@@ -932,6 +1715,8 @@ from_client_lock(clixon_handle h,
     int                  ret;
     cbuf                *cbx = NULL; /* Assist cbuf */
     uint32_t             iddb;
+    char                *str;
+    uint32_t             wait = 0;
 
     if ((db = netconf_db_find(xe, "target")) == NULL){
         if (netconf_missing_element(cbret, "protocol", "target", NULL) < 0)
@@ -947,6 +1732,24 @@ from_client_lock(clixon_handle h,
      * 1) A lock is already held by any NETCONF session or another entity.
      */
     if ((iddb = xmldb_islocked(h, db)) != 0){
+        /* Optionally wait for the lock, reply when granted or timed out */
+        if (iddb != id &&
+            (str = xml_find_type_value(xe, CLIXON_LIB_PREFIX, "wait", CX_ATTR)) != NULL){
+            if ((ret = parse_uint32(str, &wait, NULL)) < 0){
+                clixon_err(OE_XML, errno, "parse_uint32");
+                goto done;
+            }
+            if (ret == 0){
+                if (netconf_bad_attribute(cbret, "protocol", "wait", "Invalid wait time") < 0)
+                    goto done;
+                goto ok;
+            }
+            if (wait > 0){
+                if (lock_wait_add(h, ce, db, wait) < 0)
+                    goto done;
+                goto ok;
+            }
+        }
         cprintf(cbx, "<session-id>%u</session-id>", iddb);
         if (netconf_lock_denied(cbret, cbuf_get(cbx), "Operation failed, lock is already held") < 0)
             goto done;
@@ -1024,6 +1827,8 @@ from_client_unlock(clixon_handle h,
         /* user callback */
         if (clixon_plugin_lockdb_all(h, db, 0, id) < 0)
             goto done;
+        if (backend_lock_wait_wake(h, db) < 0)
+            goto done;
         if (cprintf(cbret, "<rpc-reply xmlns=\"%s\"><ok/></rpc-reply>", NETCONF_BASE_NAMESPACE) < 0)
             goto done;
     }
@@ -1058,6 +1863,8 @@ from_client_close_session(clixon_handle h,
     if (release_all_dbs(h, id) < 0)
         return -1;
     stream_ss_delete_all(h, ce_event_cb, (void*)ce);
+    if (backend_push_session_rm(h, id) < 0)
+        return -1;
     cprintf(cbret, "<rpc-reply xmlns=\"%s\"><ok/></rpc-reply>", NETCONF_BASE_NAMESPACE);
     return 0;
 }
@@ -1196,7 +2003,7 @@ from_client_create_subscription(clixon_handle h,
     /* Add subscriber to stream - to make notifications for this client */
     if (stream_ss_add(h, stream, selector,
                       starttime?&start:NULL, stoptime?&stop:NULL,
-                      ce_event_cb, (void*)ce) < 0)
+                      ce_event_cb, (void*)ce) == NULL)
         goto done;
     /* Replay of this stream to specific subscription according to start and
      * stop (if present). 
@@ -1217,21 +2024,100 @@ from_client_create_subscription(clixon_handle h,
     return retval;
 }
 
-/*! Retrieve a schema from the NETCONF server.
+/*! Append source text of a YANG module as XML character data, cached per module
  *
- * @param[in]  h       Clixon handle
- * @param[in]  xe      Request: <rpc><xn></rpc> 
- * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error.. 
- * @param[in]  arg     client-entry
- * @param[in]  regarg  User argument given at rpc_callback_register() 
+ * The file is read and escaped once per module and YANG generation
+ * @param[in]  ymod    YANG module or submodule
+ * @param[out] cb      Reply buffer
  * @retval     0       OK
  * @retval    -1       Error
- * @see RFC6022, ietf-netconf-monitoring.yang
  */
 static int
-from_client_get_schema(clixon_handle h,
-                       cxobj        *xe,
-                       cbuf         *cbret,
+get_schema_text(yang_stmt *ymod,
+                cbuf      *cb)
+{
+    int                 retval = -1;
+    struct schema_text *st;
+    struct schema_text *st1 = NULL;
+    cbuf               *cbyang = NULL;
+    cbuf               *cbesc = NULL;
+    const char         *filename;
+    char                key[32];
+    size_t              len;
+
+    if (_schema_text == NULL &&
+        (_schema_text = clicon_hash_init()) == NULL)
+        goto done;
+    snprintf(key, sizeof(key), "%p", ymod);
+    if ((st = clicon_hash_value(_schema_text, key, NULL)) == NULL ||
+        st->st_gen != yang_stats_generation()){
+        if ((cbyang = cbuf_new()) == NULL ||
+            (cbesc = cbuf_new()) == NULL){
+            clixon_err(OE_UNIX, errno, "cbuf_new");
+            goto done;
+        }
+        if ((filename = yang_filename_get(ymod)) != NULL){
+            if (clicon_file_cbuf(filename, cbyang) < 0)
+                goto done;
+        }
+        if (xml_chardata_cbuf_append(cbesc, 0, cbuf_get(cbyang)) < 0)
+            goto done;
+        len = cbuf_len(cbesc) + 1;
+        if ((st1 = malloc(sizeof(*st1) + len)) == NULL){
+            clixon_err(OE_UNIX, errno, "malloc");
+            goto done;
+        }
+        st1->st_gen = yang_stats_generation();
+        memcpy(st1->st_text, cbuf_get(cbesc), len);
+        if (clicon_hash_add(_schema_text, key, st1, sizeof(*st1) + len) == NULL)
+            goto done;
+        if ((st = clicon_hash_value(_schema_text, key, NULL)) == NULL){
+            clixon_err(OE_UNIX, ENOENT, "schema text %s not found", key);
+            goto done;
+        }
+    }
+    cbuf_append_str(cb, st->st_text);
+    retval = 0;
+ done:
+    if (st1)
+        free(st1);
+    if (cbyang)
+        cbuf_free(cbyang);
+    if (cbesc)
+        cbuf_free(cbesc);
+    return retval;
+}
+
+/*! Free cached schema texts
+ *
+ * @param[in]  h    Clixon handle
+ * @retval     0    OK
+ */
+int
+backend_client_schema_free(clixon_handle h)
+{
+    if (_schema_text){
+        clicon_hash_free(_schema_text);
+        _schema_text = NULL;
+    }
+    return 0;
+}
+
+/*! Retrieve a schema from the NETCONF server.
+ *
+ * @param[in]  h       Clixon handle
+ * @param[in]  xe      Request: <rpc><xn></rpc> 
+ * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error.. 
+ * @param[in]  arg     client-entry
+ * @param[in]  regarg  User argument given at rpc_callback_register() 
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @see RFC6022, ietf-netconf-monitoring.yang
+ */
+static int
+from_client_get_schema(clixon_handle h,
+                       cxobj        *xe,
+                       cbuf         *cbret,
                        void         *arg,
                        void         *regarg)
 {
@@ -1245,9 +2131,7 @@ from_client_get_schema(clixon_handle h,
     yang_stmt  *ymod;
     yang_stmt  *ymatch;
     yang_stmt  *yrev;
-    cbuf       *cbyang = NULL;
     cbuf       *cbmsg = NULL;
-    const char *filename;
     int        inext;
 
     if ((yspec =  clicon_dbspec_yang(h)) == NULL){
@@ -1319,23 +2203,14 @@ from_client_get_schema(clixon_handle h,
     }
     cprintf(cbret, "<rpc-reply xmlns=\"%s\"><data xmlns=\"%s\">",
             NETCONF_BASE_NAMESPACE, NETCONF_MONITORING_NAMESPACE);
-    if ((cbyang = cbuf_new()) == NULL){
-        clixon_err(OE_UNIX, errno, "cbuf_new");
+    if (get_schema_text(ymatch, cbret) < 0)
         goto done;
-    }
-    if ((filename = yang_filename_get(ymatch)) != NULL){
-        if (clicon_file_cbuf(filename, cbyang) < 0)
-            goto done;
-    }
-    xml_chardata_cbuf_append(cbret, 0, cbuf_get(cbyang));
     cprintf(cbret, "</data></rpc-reply>");
  ok:
     retval = 0;
  done:
     if (cbmsg)
         cbuf_free(cbmsg);
-    if (cbyang)
-        cbuf_free(cbyang);
     if (nsc)
         xml_nsctx_free(nsc);
     return retval;
@@ -1400,6 +2275,428 @@ from_client_ping(clixon_handle h,
     return 0;
 }
 
+/*! Get entity tag, generation and last modified time of a datastore or of a top-level node of running
+ *
+ * @param[in]  h       Clixon handle
+ * @param[in]  xe      Request: <rpc><xn></rpc>
+ * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error..
+ * @param[in]  arg     client-entry
+ * @param[in]  regarg  User argument given at rpc_callback_register()
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @see backend_stamp_get
+ */
+static int
+from_client_datastore_stamp(clixon_handle h,
+                            cxobj        *xe,
+                            cbuf         *cbret,
+                            void         *arg,
+                            void         *regarg)
+{
+    int            retval = -1;
+    cbuf          *cb = NULL;
+    struct timeval tv;
+    char           timestr[28];
+    char          *db;
+    uint64_t       gen;
+    int            ret;
+
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if ((db = xml_find_body(xe, "datastore")) != NULL && strcmp(db, "running") != 0){
+        if ((ret = xmldb_exists(h, db)) < 0)
+            goto done;
+        if (ret == 0){
+            if (netconf_invalid_value(cbret, "protocol", "No such datastore") < 0)
+                goto done;
+            goto ok;
+        }
+        if (backend_stamp_db_get(h, db, cb, &gen, &tv) < 0)
+            goto done;
+    }
+    else if (backend_stamp_get(h, xml_find_body(xe, "node"), cb, &gen, &tv) < 0)
+        goto done;
+    if (time2str(&tv, timestr, sizeof(timestr)) < 0){
+        clixon_err(OE_UNIX, errno, "time2str");
+        goto done;
+    }
+    cprintf(cbret, "<rpc-reply xmlns=\"%s\">", NETCONF_BASE_NAMESPACE);
+    cprintf(cbret, "<etag xmlns=\"%s\">%s</etag>", CLIXON_LIB_NS, cbuf_get(cb));
+    cprintf(cbret, "<generation xmlns=\"%s\">%" PRIu64 "</generation>", CLIXON_LIB_NS, gen);
+    cprintf(cbret, "<last-modified xmlns=\"%s\">%s</last-modified>", CLIXON_LIB_NS, timestr);
+    cprintf(cbret, "</rpc-reply>");
+ ok:
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Stream callback of on-change subscriptions
+ *
+ * As ce_event_cb, but removing the stream subscription does not remove the client,
+ * subscriptions are removed by delete-push or when the session ends
+ * @see backend_push_establish
+ */
+static int
+push_event_cb(clixon_handle h,
+              int           op,
+              cxobj        *event,
+              void         *arg)
+{
+    if (op == 1)
+        return 0;
+    return ce_event_cb(h, op, event, arg);
+}
+
+/*! Establish an on-change or periodic subscription of a datastore for this session
+ *
+ * @param[in]  h       Clixon handle
+ * @param[in]  xe      Request: <rpc><xn></rpc>
+ * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error..
+ * @param[in]  arg     client-entry
+ * @param[in]  regarg  User argument given at rpc_callback_register()
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @see backend_push_establish
+ */
+static int
+from_client_establish_push(clixon_handle h,
+                           cxobj        *xe,
+                           cbuf         *cbret,
+                           void         *arg,
+                           void         *regarg)
+{
+    int                  retval = -1;
+    struct client_entry *ce = (struct client_entry *)arg;
+    char                *db;
+    char                *xpath = NULL;
+    char                *str;
+    cxobj               *x;
+    cvec                *nsc = NULL;
+    uint32_t             dampening = 0;
+    uint32_t             period = 0;
+    uint32_t             id;
+    int                  ret;
+
+    if ((db = xml_find_body(xe, "datastore")) == NULL)
+        db = "running";
+    if (strcmp(db, "running") != 0 && strcmp(db, "operational") != 0){
+        if (netconf_invalid_value(cbret, "application", "Only running and operational datastores") < 0)
+            goto done;
+        goto ok;
+    }
+    if ((str = xml_find_body(xe, "dampening-period")) != NULL){
+        if ((ret = netconf_parse_uint32("dampening-period", str, NULL, 0, cbret, &dampening)) < 0)
+            goto done;
+        if (ret == 0)
+            goto ok;
+    }
+    if ((str = xml_find_body(xe, "period")) != NULL){
+        if ((ret = netconf_parse_uint32("period", str, NULL, 0, cbret, &period)) < 0)
+            goto done;
+        if (ret == 0)
+            goto ok;
+        if (period == 0 || dampening != 0){
+            if (netconf_invalid_value(cbret, "application",
+                                      "Period must be positive and not combined with dampening-period") < 0)
+                goto done;
+            goto ok;
+        }
+    }
+    if ((x = xml_find_type(xe, NULL, "xpath", CX_ELMNT)) != NULL &&
+        (xpath = xml_body(x)) != NULL){
+        /* Prefixes of selection in context of the xpath element */
+        if (xml_nsctx_node(x, &nsc) < 0)
+            goto done;
+    }
+    ret = backend_push_establish(h, ce->ce_id, db, xpath, nsc, dampening, period,
+                                 push_event_cb, (void*)ce, &id, cbret);
+    nsc = NULL; /* consumed */
+    if (ret < 0)
+        goto done;
+    if (ret == 0)
+        goto ok;
+    cprintf(cbret, "<rpc-reply xmlns=\"%s\">", NETCONF_BASE_NAMESPACE);
+    cprintf(cbret, "<id xmlns=\"%s\">%u</id>", CLIXON_LIB_NS, id);
+    cprintf(cbret, "</rpc-reply>");
+ ok:
+    retval = 0;
+ done:
+    if (nsc)
+        xml_nsctx_free(nsc);
+    return retval;
+}
+
+/*! Delete an on-change subscription of this session
+ *
+ * @param[in]  h       Clixon handle
+ * @param[in]  xe      Request: <rpc><xn></rpc>
+ * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error..
+ * @param[in]  arg     client-entry
+ * @param[in]  regarg  User argument given at rpc_callback_register()
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @see backend_push_delete
+ */
+static int
+from_client_delete_push(clixon_handle h,
+                        cxobj        *xe,
+                        cbuf         *cbret,
+                        void         *arg,
+                        void         *regarg)
+{
+    int                  retval = -1;
+    struct client_entry *ce = (struct client_entry *)arg;
+    char                *str;
+    uint32_t             id;
+    int                  ret;
+
+    if ((str = xml_find_body(xe, "id")) == NULL){
+        if (netconf_missing_element(cbret, "protocol", "id", NULL) < 0)
+            goto done;
+        goto ok;
+    }
+    if ((ret = netconf_parse_uint32("id", str, NULL, 0, cbret, &id)) < 0)
+        goto done;
+    if (ret == 0)
+        goto ok;
+    if ((ret = backend_push_delete(h, ce->ce_id, id)) < 0)
+        goto done;
+    if (ret == 0){
+        if (netconf_invalid_value(cbret, "application", "No such subscription") < 0)
+            goto done;
+        goto ok;
+    }
+    cprintf(cbret, "<rpc-reply xmlns=\"%s\"><ok/></rpc-reply>", NETCONF_BASE_NAMESPACE);
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Stop following the primary and accept writes, eg on fail-over to a standby
+ *
+ * @param[in]  h       Clixon handle
+ * @param[in]  xe      Request: <rpc><xn></rpc>
+ * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error..
+ * @param[in]  arg     client-entry
+ * @param[in]  regarg  User argument given at rpc_callback_register()
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @see backend_replica_promote
+ */
+static int
+from_client_replica_promote(clixon_handle h,
+                            cxobj        *xe,
+                            cbuf         *cbret,
+                            void         *arg,
+                            void         *regarg)
+{
+    int retval = -1;
+
+    if (backend_replica_promote(h) == 0){
+        if (netconf_operation_failed(cbret, "application", "Not a replica") < 0)
+            goto done;
+        goto ok;
+    }
+    cprintf(cbret, "<rpc-reply xmlns=\"%s\"><ok/></rpc-reply>", NETCONF_BASE_NAMESPACE);
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Mark changed nodes and their ancestors for xml_copy_marked
+ *
+ * @param[in]  vec    Vector of changed nodes
+ * @param[in]  len    Length of vector
+ * @see from_client_datastore_diff
+ */
+static void
+datastore_diff_mark(cxobj **vec,
+                    int     len)
+{
+    int i;
+
+    for (i=0; i<len; i++){
+        xml_flag_set(vec[i], XML_FLAG_MARK);
+        xml_apply_ancestor(vec[i], (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_CHANGE);
+    }
+}
+
+/*! Mark nodes in x1 that match ancestors of changes in x0
+ *
+ * The parent of a node deleted from x0 also exists in x1, and must be in both diff trees
+ * to give the same context as a diff of the whole trees.
+ * Only nodes marked with XML_FLAG_CHANGE are visited.
+ * @param[in]  x0     XML tree with marked ancestors
+ * @param[in]  x1     XML tree where matching nodes are marked
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+datastore_diff_sync(cxobj *x0,
+                    cxobj *x1)
+{
+    int    retval = -1;
+    cxobj *x0c;
+    cxobj *x1c;
+
+    x0c = NULL;
+    while ((x0c = xml_child_each(x0, x0c, CX_ELMNT)) != NULL) {
+        if (xml_flag(x0c, XML_FLAG_CHANGE) == 0)
+            continue;
+        x1c = NULL;
+        if (match_base_child(x1, x0c, xml_spec(x0c), &x1c) < 0)
+            goto done;
+        if (x1c == NULL)
+            continue;
+        xml_flag_set(x1c, XML_FLAG_CHANGE);
+        if (datastore_diff_sync(x0c, x1c) < 0)
+            goto done;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Get the differences between two datastores as changed subtrees only
+ *
+ * The source reply contains nodes deleted or changed in source, the target reply contains
+ * nodes added or changed in target, both with their ancestors and list keys.
+ * If source is running and all edits of target are marked, only marked subtrees are
+ * compared, as in a commit diff, see CLICON_XMLDB_DIFF_INCREMENTAL
+ * @param[in]  h       Clixon handle
+ * @param[in]  xe      Request: <rpc><xn></rpc>
+ * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error..
+ * @param[in]  arg     client-entry
+ * @param[in]  regarg  User argument given at rpc_callback_register()
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @see clicon_rpc_datastore_diff
+ */
+static int
+from_client_datastore_diff(clixon_handle h,
+                           cxobj        *xe,
+                           cbuf         *cbret,
+                           void         *arg,
+                           void         *regarg)
+{
+    int     retval = -1;
+    char   *db[2];
+    cxobj  *xt[2] = {NULL, NULL};
+    cxobj  *xd[2] = {NULL, NULL};
+    cxobj  *xerr = NULL;
+    cxobj  *xnacm;
+    cxobj **xvec = NULL;
+    size_t  xlen;
+    cxobj **dvec = NULL;
+    int     dlen = 0;
+    cxobj **avec = NULL;
+    int     alen = 0;
+    cxobj **scvec = NULL;
+    cxobj **tcvec = NULL;
+    int     clen = 0;
+    int     flag = 0;
+    int     ret;
+    int     i;
+
+    if ((db[0] = xml_find_body(xe, "source")) == NULL)
+        db[0] = "running";
+    if ((db[1] = xml_find_body(xe, "target")) == NULL)
+        db[1] = "candidate";
+    for (i=0; i<2; i++){
+        if ((ret = xmldb_exists(h, db[i])) < 0)
+            goto done;
+        if (ret == 0){
+            if (netconf_invalid_value(cbret, "protocol", "No such datastore") < 0)
+                goto done;
+            goto ok;
+        }
+    }
+    xnacm = clicon_nacm_cache(h);
+    for (i=0; i<2; i++){
+        if ((ret = xmldb_get0(h, db[i], YB_MODULE, NULL, "/", 1, WITHDEFAULTS_EXPLICIT,
+                              &xt[i], NULL, &xerr)) < 0)
+            goto done;
+        if (ret == 0){
+            if (clixon_xml2cbuf(cbret, xerr, 0, 0, NULL, -1, 0) < 0)
+                goto done;
+            goto ok;
+        }
+        /* Clear flags xpath for get */
+        xml_apply0(xt[i], CX_ELMNT, (xml_applyfn_t*)xml_flag_reset,
+                   (void*)(XML_FLAG_MARK|XML_FLAG_CHANGE));
+        if (xnacm != NULL){
+            if (xpath_vec(xt[i], NULL, "/", &xvec, &xlen) < 0)
+                goto done;
+            if (nacm_datanode_read(h, xt[i], xvec, xlen, clicon_username_get(h), xnacm) < 0)
+                goto done;
+            free(xvec);
+            xvec = NULL;
+        }
+    }
+    /* Marks of target are relative to running, see validate_common */
+    if (clicon_option_bool(h, "CLICON_XMLDB_DIFF_INCREMENTAL") &&
+        strcmp(db[0], "running") == 0 && strcmp(db[1], "running") != 0){
+        if ((ret = xmldb_edited_get(h, db[1])) < 0)
+            goto done;
+        if (ret == 1)
+            flag = XML_FLAG_EDITED;
+    }
+    if (xml_diff_flagged(xt[0], xt[1], flag,
+                         &dvec, &dlen,
+                         &avec, &alen,
+                         &scvec, &tcvec, &clen) < 0)
+        goto done;
+    datastore_diff_mark(dvec, dlen);
+    datastore_diff_mark(scvec, clen);
+    datastore_diff_mark(avec, alen);
+    datastore_diff_mark(tcvec, clen);
+    if (datastore_diff_sync(xt[0], xt[1]) < 0)
+        goto done;
+    if (datastore_diff_sync(xt[1], xt[0]) < 0)
+        goto done;
+    cprintf(cbret, "<rpc-reply xmlns=\"%s\">", NETCONF_BASE_NAMESPACE);
+    for (i=0; i<2; i++){
+        if ((xd[i] = xml_new(NETCONF_OUTPUT_DATA, NULL, CX_ELMNT)) == NULL)
+            goto done;
+        if (xml_copy_marked(xt[i], xd[i]) < 0)
+            goto done;
+        cprintf(cbret, "<%s xmlns=\"%s\">", i==0?"source":"target", CLIXON_LIB_NS);
+        if (clixon_xml2cbuf(cbret, xd[i], 0, 0, NULL, -1, 1) < 0)
+            goto done;
+        cprintf(cbret, "</%s>", i==0?"source":"target");
+    }
+    cprintf(cbret, "</rpc-reply>");
+ ok:
+    retval = 0;
+ done:
+    for (i=0; i<2; i++){
+        if (xt[i])
+            xml_free(xt[i]);
+        if (xd[i])
+            xml_free(xd[i]);
+    }
+    if (xerr)
+        xml_free(xerr);
+    if (xvec)
+        free(xvec);
+    if (dvec)
+        free(dvec);
+    if (avec)
+        free(avec);
+    if (scvec)
+        free(scvec);
+    if (tcvec)
+        free(tcvec);
+    return retval;
+}
+
 /*! Check liveness of backend daemon,  just send a reply
  *
  * @param[in]  h       Clixon handle
@@ -1419,6 +2716,9 @@ from_client_stats(clixon_handle h,
 {
     int        retval = -1;
     uint64_t   nr;
+    uint64_t   hits;
+    uint64_t   misses;
+    uint64_t   huge;
     char      *str;
     int        modules = 0;
     yang_stmt *yspec0;
@@ -1443,6 +2743,20 @@ from_client_stats(clixon_handle h,
     nr=0;
     yang_stats_global(&nr);
     cprintf(cbret, "<yangnr>%" PRIu64 "</yangnr>", nr);
+    xpath_cache_stats(&nr, &hits, &misses);
+    cprintf(cbret, "<xpath-cache-nr>%" PRIu64 "</xpath-cache-nr>", nr);
+    cprintf(cbret, "<xpath-cache-hits>%" PRIu64 "</xpath-cache-hits>", hits);
+    cprintf(cbret, "<xpath-cache-misses>%" PRIu64 "</xpath-cache-misses>", misses);
+    nacm_decision_stats(h, &nr, &hits, &misses);
+    cprintf(cbret, "<nacm-cache-nr>%" PRIu64 "</nacm-cache-nr>", nr);
+    cprintf(cbret, "<nacm-cache-hits>%" PRIu64 "</nacm-cache-hits>", hits);
+    cprintf(cbret, "<nacm-cache-misses>%" PRIu64 "</nacm-cache-misses>", misses);
+    xml_arena_stats(&nr, &hits, &misses, &huge);
+    cprintf(cbret, "<arena-objects>%" PRIu64 "</arena-objects>", nr);
+    cprintf(cbret, "<arena-chunks>%" PRIu64 "</arena-chunks>", hits);
+    cprintf(cbret, "<arena-regions>%" PRIu64 "</arena-regions>", misses);
+    cprintf(cbret, "<arena-huge-regions>%" PRIu64 "</arena-huge-regions>", huge);
+    cprintf(cbret, "<memory-trimmed>%" PRIu64 "</memory-trimmed>", _memory_trimmed);
     cprintf(cbret, "</global>");
     cprintf(cbret, "<datastores xmlns=\"%s\">", CLIXON_LIB_NS);
     if (clixon_stats_datastore_get(h, "running", cbret) < 0)
@@ -1481,6 +2795,16 @@ from_client_stats(clixon_handle h,
         }
     }
     cprintf(cbret, "</module-sets>");
+    if (clixon_latency_enabled()){
+        cprintf(cbret, "<latency xmlns=\"%s\">", CLIXON_LIB_NS);
+        if (clixon_latency2cbuf(cbret) < 0)
+            goto done;
+        cprintf(cbret, "</latency>");
+    }
+    cprintf(cbret, "<memory xmlns=\"%s\">", CLIXON_LIB_NS);
+    if (clixon_mem2cbuf(cbret) < 0)
+        goto done;
+    cprintf(cbret, "</memory>");
     cprintf(cbret, "</rpc-reply>");
     retval = 0;
  done:
@@ -1582,6 +2906,212 @@ from_client_process_control(clixon_handle  h,
     return retval;
 }
 
+/* Datastore holding candidate while an atomic batch is applied */
+#define BATCH_DB "batch"
+
+/*! Check if an rpc reply contains an error
+ *
+ * @param[in]  cb   Reply as string
+ * @retval     1    Error reply
+ * @retval     0    OK reply
+ */
+static int
+batch_reply_error(cbuf *cb)
+{
+    return strstr(cbuf_get(cb), "<rpc-error") != NULL;
+}
+
+/*! Handle one rpc of a batch, see from_client_batch
+ *
+ * @param[in]  h       Clixon handle
+ * @param[in]  ce      Client entry
+ * @param[in]  xrpc    Request: <rpc><get-config>...</get-config></rpc>, unbound
+ * @param[in]  atomic  Atomic batch: only edit-config of candidate is allowed
+ * @param[out] cbret   Reply of rpc, eg <rpc-reply>..., <rpc-error..
+ * @retval     0       OK, cbret set
+ * @retval    -1       Error
+ */
+static int
+batch_rpc(clixon_handle        h,
+          struct client_entry *ce,
+          cxobj               *xrpc,
+          int                  atomic,
+          cbuf                *cbret)
+{
+    int        retval = -1;
+    yang_stmt *yspec;
+    cxobj     *xerr = NULL;
+    cxobj     *xe;
+    cxobj     *xt;
+    cxobj     *xnacm;
+    yang_stmt *ymod;
+    char      *rpc;
+    char      *ns = NULL;
+    int        nr = 0;
+    int        ret;
+
+    yspec = clicon_dbspec_yang(h);
+    if (xml2ns(xrpc, xml_prefix(xrpc), &ns) < 0)
+        goto done;
+    if (strcmp(xml_name(xrpc), "rpc") != 0 ||
+        ns == NULL || strcmp(ns, NETCONF_BASE_NAMESPACE) != 0){
+        if (netconf_unknown_element(cbret, "protocol", xml_name(xrpc), "Expected rpc in batch") < 0)
+            goto done;
+        goto ok;
+    }
+    if ((xe = xml_child_i_type(xrpc, 0, CX_ELMNT)) == NULL){
+        if (netconf_missing_element(cbret, "protocol", "rpc", "Empty rpc in batch") < 0)
+            goto done;
+        goto ok;
+    }
+    rpc = xml_name(xe);
+    /* Operations whose replies are never deferred or streamed */
+    if (xml2ns(xe, xml_prefix(xe), &ns) < 0)
+        goto done;
+    if (ns == NULL || strcmp(ns, NETCONF_BASE_NAMESPACE) != 0 ||
+        (strcmp(rpc, "get") != 0 &&
+         strcmp(rpc, "get-config") != 0 &&
+         strcmp(rpc, "edit-config") != 0)){
+        if (netconf_operation_not_supported(cbret, "protocol", rpc) < 0)
+            goto done;
+        goto ok;
+    }
+    if (atomic && strcmp(rpc, "edit-config") == 0){
+        if ((xt = xpath_first(xe, NULL, "target/*")) == NULL ||
+            strcmp(xml_name(xt), "candidate") != 0){
+            if (netconf_operation_not_supported(cbret, "application",
+                                                "Atomic batch only edits candidate") < 0)
+                goto done;
+            goto ok;
+        }
+    }
+    if (backend_replica_write(h, "ietf-netconf", rpc)){
+        if (netconf_operation_not_supported(cbret, "application",
+                                            "Read-only replica, write to the primary") < 0)
+            goto done;
+        goto ok;
+    }
+    if ((ret = xml_bind_yang_rpc(h, xrpc, yspec, &xerr)) < 0)
+        goto done;
+    if (ret > 0 && (ret = xml_yang_validate_rpc(h, xrpc, 1, &xerr)) < 0)
+        goto done;
+    if (ret == 0){
+        if (clixon_xml2cbuf(cbret, xerr, 0, 0, NULL, -1, 0) < 0)
+            goto done;
+        goto ok;
+    }
+    /* NACM of batch rpc is checked and cached, see from_client_msg */
+    if ((xnacm = clicon_nacm_cache(h)) != NULL){
+        if ((ymod = ys_module(xml_spec(xe))) == NULL){
+            clixon_err(OE_XML, ENOENT, "rpc yang does not have module");
+            goto done;
+        }
+        if ((ret = nacm_rpc(h, rpc, yang_argument_get(ymod), clicon_username_get(h), xnacm, cbret)) < 0)
+            goto done;
+        if (ret == 0)
+            goto ok;
+    }
+    clixon_err_reset();
+    if ((ret = rpc_callback_call(h, xe, ce, &nr, cbret)) < 0){
+        if (netconf_operation_failed(cbret, "application", clixon_err_reason())< 0)
+            goto done;
+        goto ok;
+    }
+    if (ret == 1 && nr == 0){
+        if (netconf_operation_not_supported(cbret, "application", "RPC operation not supported")< 0)
+            goto done;
+    }
+ ok:
+    retval = 0;
+ done:
+    if (xerr)
+        xml_free(xerr);
+    return retval;
+}
+
+/*! Handle several get, get-config and edit-config operations in one message
+ *
+ * Each rpc of operations gets a reply in replies, in the same order.
+ * If not atomic, all operations are made regardless of errors.
+ * If atomic, candidate is restored and the rest of the operations are skipped on the
+ * first error, and the reply is the error.
+ * @param[in]  h       Clixon handle
+ * @param[in]  xe      Request: <rpc><xn></rpc>
+ * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error..
+ * @param[in]  arg     client-entry
+ * @param[in]  regarg  User argument given at rpc_callback_register()
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+from_client_batch(clixon_handle h,
+                  cxobj        *xe,
+                  cbuf         *cbret,
+                  void         *arg,
+                  void         *regarg)
+{
+    int                  retval = -1;
+    struct client_entry *ce = (struct client_entry *)arg;
+    cxobj               *xops;
+    cxobj               *xrpc;
+    char                *str;
+    int                  atomic = 0;
+    int                  saved = 0;
+    int                  modified = 0;
+    int                  stream = ce->ce_stream;
+    cbuf                *cb = NULL;
+    cbuf                *cbr = NULL;
+
+    if ((str = xml_find_body(xe, "atomic")) != NULL && strcmp(str, "true") == 0)
+        atomic = 1;
+    if ((cb = cbuf_new()) == NULL ||
+        (cbr = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    /* Replies of operations are collected, not streamed */
+    ce->ce_stream = 0;
+    if ((xops = xml_find_type(xe, NULL, "operations", CX_ELMNT)) != NULL){
+        xrpc = NULL;
+        while ((xrpc = xml_child_each(xops, xrpc, CX_ELMNT)) != NULL) {
+            cbuf_reset(cbr);
+            if (atomic && !saved && xml_find_type(xrpc, NULL, "edit-config", CX_ELMNT) != NULL){
+                /* Candidate before first edit, shared if CLICON_XMLDB_COPY_ON_WRITE */
+                if (xmldb_copy(h, "candidate", BATCH_DB) < 0)
+                    goto done;
+                modified = xmldb_modified_get(h, "candidate");
+                saved = 1;
+            }
+            if (batch_rpc(h, ce, xrpc, atomic, cbr) < 0)
+                goto done;
+            if (atomic && batch_reply_error(cbr)){
+                if (saved){
+                    if (xmldb_copy(h, BATCH_DB, "candidate") < 0)
+                        goto done;
+                    if (xmldb_modified_set(h, "candidate", modified) < 0)
+                        goto done;
+                }
+                cprintf(cbret, "%s", cbuf_get(cbr));
+                goto ok;
+            }
+            cprintf(cb, "%s", cbuf_get(cbr));
+        }
+    }
+    cprintf(cbret, "<rpc-reply xmlns=\"%s\"><replies xmlns=\"%s\">%s</replies></rpc-reply>",
+            NETCONF_BASE_NAMESPACE, CLIXON_LIB_NS, cbuf_get(cb));
+ ok:
+    retval = 0;
+ done:
+    ce->ce_stream = stream;
+    if (saved)
+        xmldb_delete(h, BATCH_DB);
+    if (cb)
+        cbuf_free(cb);
+    if (cbr)
+        cbuf_free(cbr);
+    return retval;
+}
+
 /*! Clixon hello to check liveness
  *
  * @param[in]  h       Clixon handle
@@ -1599,6 +3129,8 @@ from_client_hello(clixon_handle       h,
 {
     int      retval = -1;
     char    *val;
+    cxobj   *xcaps;
+    cxobj   *xc;
 
     if ((val = xml_find_type_value(x, "cl", "transport", CX_ATTR)) != NULL){
         if ((ce->ce_transport = strdup(val)) == NULL){
@@ -1612,6 +3144,13 @@ from_client_hello(clixon_handle       h,
             goto done;
         }
     }
+    /* Client may request binary replies, see CLICON_SOCK_BINARY */
+    if ((xcaps = xml_find_type(x, NULL, "capabilities", CX_ELMNT)) != NULL){
+        xc = NULL;
+        while ((xc = xml_child_each(xcaps, xc, CX_ELMNT)) != NULL)
+            if (clicon_strcmp(xml_body(xc), CLIXON_BINARY_CAPABILITY) == 0)
+                ce->ce_binary = 1;
+    }
     cprintf(cbret, "<hello xmlns=\"%s\"><session-id>%u</session-id></hello>",
             NETCONF_BASE_NAMESPACE, ce->ce_id);
     retval = 0;
@@ -1619,6 +3158,377 @@ from_client_hello(clixon_handle       h,
     return retval;
 }
 
+/*! Read worker: forked process computing the reply of a read-only RPC
+ *
+ * @see CLICON_BACKEND_READ_WORKERS
+ */
+struct read_worker {
+    clixon_handle rw_h;
+    uint32_t      rw_id;   /* Session id of client */
+    pid_t         rw_pid;  /* Worker process */
+    cbuf         *rw_cb;   /* Reply read from worker so far */
+    char         *rw_msgid;/* message-id of pipelined request, or NULL if deferred */
+};
+
+/* Number of running read workers */
+static int      _read_workers = 0;
+
+/* In a read worker process: write end of pipe to backend, otherwise -1 */
+static int      _read_worker_fd = -1;
+
+/* In a read worker process: rpc-error counter of client at fork */
+static uint32_t _read_worker_errs = 0;
+
+/*! Check if an rpc is a read-only operation that can be handled by a read worker
+ *
+ * @param[in]  x    rpc element
+ * @retval     1    Yes, get, get-config or get-schema
+ * @retval     0    No
+ * @retval    -1    Error
+ */
+static int
+read_worker_rpc(cxobj *x)
+{
+    cxobj *xe;
+    char  *name;
+    char  *ns = NULL;
+
+    if (xml_child_nr_type(x, CX_ELMNT) != 1)
+        return 0;
+    xe = xml_child_i_type(x, 0, CX_ELMNT);
+    name = xml_name(xe);
+    if (xml2ns(xe, xml_prefix(xe), &ns) < 0)
+        return -1;
+    if (ns == NULL)
+        return 0;
+    if (strcmp(ns, NETCONF_BASE_NAMESPACE) == 0)
+        return strcmp(name, "get") == 0 || strcmp(name, "get-config") == 0;
+    if (strcmp(ns, NETCONF_MONITORING_NAMESPACE) == 0)
+        return strcmp(name, "get-schema") == 0;
+    return 0;
+}
+
+/*! Event callback when reply data arrives from a read worker, send reply on EOF
+ *
+ * The reply is prefixed with a status character: 'e' if the reply contains an
+ * rpc-error, 'o' otherwise, or 's' if the worker has sent the reply directly to the
+ * client, see CLICON_BACKEND_STREAM_CHUNK.
+ * @param[in]  fd   Read end of pipe to worker
+ * @param[in]  arg  Read worker
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+read_worker_done(int   fd,
+                 void *arg)
+{
+    int                  retval = -1;
+    struct read_worker  *rw = (struct read_worker *)arg;
+    clixon_handle        h = rw->rw_h;
+    struct client_entry *ce;
+    cbuf                *cbret = NULL;
+    char                 buf[4096];
+    ssize_t              n;
+    int                  status = 0;
+    char                *str;
+
+    if ((n = read(fd, buf, sizeof(buf))) < 0){
+        if (errno == EINTR)
+            goto ok;
+        clixon_err(OE_UNIX, errno, "read");
+    }
+    else if (n > 0){
+        if (cbuf_append_buf(rw->rw_cb, buf, n) < 0){
+            clixon_err(OE_UNIX, errno, "cbuf_append_buf");
+            goto done;
+        }
+        goto ok;
+    }
+    /* EOF or read error: worker is done */
+    clixon_event_unreg_fd(fd, read_worker_done);
+    close(fd);
+    _read_workers--;
+    if (waitpid(rw->rw_pid, &status, 0) < 0)
+        clixon_log(h, LOG_WARNING, "%s: waitpid(%d): %s", __FUNCTION__, rw->rw_pid, strerror(errno));
+    str = cbuf_get(rw->rw_cb);
+    if (cbuf_len(rw->rw_cb) == 1 && str[0] == 's'){
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            clixon_log(h, LOG_WARNING, "%s: read worker %d failed with status %#x after streaming reply",
+                       __FUNCTION__, rw->rw_pid, status);
+        if (backend_client_reply_deferred(h, rw->rw_id, NULL) < 0)
+            goto done;
+        goto freerw;
+    }
+    if (n < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0 || cbuf_len(rw->rw_cb) < 2){
+        clixon_log(h, LOG_WARNING, "%s: read worker %d failed with status %#x",
+                   __FUNCTION__, rw->rw_pid, status);
+        if ((cbret = cbuf_new()) == NULL){
+            clixon_err(OE_UNIX, errno, "cbuf_new");
+            goto done;
+        }
+        if (netconf_operation_failed(cbret, "application", "Read worker failed") < 0)
+            goto done;
+        if (rw->rw_msgid && ce_reply_msgid(cbret, rw->rw_msgid) < 0)
+            goto done;
+        str = "e";
+    }
+    ce = ce_find_byid(backend_client_list(h), rw->rw_id);
+    if (str[0] == 'e' && ce != NULL){
+        ce->ce_out_rpc_errors++;
+        netconf_monitoring_counter_inc(h, "out-rpc-errors");
+    }
+    if (cbret == NULL){
+        /* Strip status character */
+        if ((cbret = cbuf_new()) == NULL){
+            clixon_err(OE_UNIX, errno, "cbuf_new");
+            goto done;
+        }
+        cprintf(cbret, "%s", str+1);
+    }
+    if (rw->rw_msgid == NULL){
+        if (backend_client_reply_deferred(h, rw->rw_id, cbret) < 0)
+            goto done;
+    }
+    else if (ce != NULL){ /* Pipelined: client socket is read meanwhile */
+        if (ce_reply_send(h, ce, cbret) < 0)
+            goto done;
+    }
+ freerw:
+    cbuf_free(rw->rw_cb);
+    if (rw->rw_msgid)
+        free(rw->rw_msgid);
+    free(rw);
+ ok:
+    retval = 0;
+ done:
+    if (cbret)
+        cbuf_free(cbret);
+    return retval;
+}
+
+/*! Hand over a read-only rpc to a forked read worker
+ *
+ * The worker computes the reply on a copy-on-write snapshot of the datastores and
+ * writes it to a pipe, while the backend continues serving other clients. The
+ * client socket is not read until the reply has been sent, see backend_client_defer,
+ * unless the request is pipelined.
+ * @param[in]  h      Clixon handle
+ * @param[in]  ce     Client entry
+ * @param[in]  x      rpc element
+ * @param[in]  msgid  message-id of pipelined request, or NULL
+ * @retval     1    Backend: handed over to worker, reply is sent by read_worker_done
+ * @retval     0    Handle rpc in this process: not applicable, or in worker
+ * @retval    -1    Error
+ */
+static int
+read_worker_fork(clixon_handle        h,
+                 struct client_entry *ce,
+                 cxobj               *x,
+                 char                *msgid)
+{
+    int                 retval = -1;
+    struct read_worker *rw = NULL;
+    int                 fds[2] = {-1, -1};
+    int                 maxw;
+    int                 ret;
+    pid_t               pid;
+
+    maxw = clicon_option_int(h, "CLICON_BACKEND_READ_WORKERS");
+    if (maxw <= 0 || _read_workers >= maxw || _read_worker_fd != -1)
+        goto skip;
+    if ((ret = read_worker_rpc(x)) < 0)
+        goto done;
+    if (ret == 0)
+        goto skip;
+    if ((rw = malloc(sizeof(*rw))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    memset(rw, 0, sizeof(*rw));
+    if ((rw->rw_cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if (msgid && (rw->rw_msgid = strdup(msgid)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    if (pipe(fds) < 0){
+        clixon_err(OE_UNIX, errno, "pipe");
+        goto done;
+    }
+    if ((pid = fork()) < 0){
+        clixon_err(OE_UNIX, errno, "fork");
+        goto done;
+    }
+    if (pid == 0){ /* Worker */
+        close(fds[0]);
+        fds[0] = -1;
+        _read_worker_fd = fds[1];
+        _read_worker_errs = ce->ce_out_rpc_errors;
+        fds[1] = -1;
+        goto skip;
+    }
+    /* Backend */
+    close(fds[1]);
+    fds[1] = -1;
+    clixon_debug(CLIXON_DBG_BACKEND, "rpc of ce_id:%u in read worker %d", ce->ce_id, pid);
+    rw->rw_h = h;
+    rw->rw_id = ce->ce_id;
+    rw->rw_pid = pid;
+    _read_workers++;
+    if (msgid == NULL && backend_client_defer(ce) < 0)
+        goto done;
+    if (clixon_event_reg_fd(fds[0], read_worker_done, rw, "read worker") < 0)
+        goto done;
+    fds[0] = -1;
+    rw = NULL;
+    retval = 1;
+    goto done;
+ skip:
+    retval = 0;
+ done:
+    if (fds[0] != -1)
+        close(fds[0]);
+    if (fds[1] != -1)
+        close(fds[1]);
+    if (rw){
+        if (rw->rw_cb)
+            cbuf_free(rw->rw_cb);
+        if (rw->rw_msgid)
+            free(rw->rw_msgid);
+        free(rw);
+    }
+    return retval;
+}
+
+/*! Write reply of a read worker to the backend and exit
+ *
+ * @param[in]  ce     Client entry
+ * @param[in]  cbret  Reply message
+ * @param[in]  msgid  message-id of pipelined request, or NULL
+ * @param[in]  rv     Return value of rpc handling
+ * @note Does not return
+ */
+static void
+read_worker_exit(struct client_entry *ce,
+                 cbuf                *cbret,
+                 char                *msgid,
+                 int                  rv)
+{
+    char    status;
+    char   *p;
+    size_t  len;
+    ssize_t n;
+
+    if (ce->ce_streamed){ /* Reply sent directly to client, possibly in part on error */
+        status = 's';
+        if (write(_read_worker_fd, &status, 1) != 1)
+            _exit(1);
+        _exit(rv < 0 ? 1 : 0);
+    }
+    if (cbret == NULL)
+        _exit(1);
+    if (rv < 0){
+        cbuf_reset(cbret);
+        if (netconf_operation_failed(cbret, "application",
+                                     clixon_err_category()?clixon_err_reason():"unknown") < 0)
+            _exit(1);
+        if (msgid && ce_reply_msgid(cbret, msgid) < 0)
+            _exit(1);
+    }
+    status = (rv < 0 || ce->ce_out_rpc_errors != _read_worker_errs) ? 'e' : 'o';
+    if (write(_read_worker_fd, &status, 1) != 1)
+        _exit(1);
+    p = cbuf_get(cbret);
+    len = cbuf_len(cbret);
+    while (len > 0){
+        if ((n = write(_read_worker_fd, p, len)) < 0){
+            if (errno == EINTR)
+                continue;
+            _exit(1);
+        }
+        p += n;
+        len -= n;
+    }
+    close(_read_worker_fd);
+    _exit(0);
+}
+
+/*! Decode binary rpc message from client and bind rpc envelope to yang
+ *
+ * Content of the rpc, eg edit-config config, keeps the binding of the client if the
+ * yang specs are equal, otherwise it is unbound as after XML parsing
+ * @param[in]  h      Clixon handle
+ * @param[in]  msg    Binary message
+ * @param[in]  yspec  Yang spec
+ * @param[out] xt     XML tree
+ * @param[out] xerr   Error XML if not bound
+ * @retval     1      OK
+ * @retval     0      Yang binding failed, xerr set
+ * @retval    -1      Error
+ * @see clixon_xml_parse_string  with YB_RPC for XML messages
+ */
+static int
+from_client_binary(clixon_handle h,
+                   char         *msg,
+                   yang_stmt    *yspec,
+                   cxobj       **xt,
+                   cxobj       **xerr)
+{
+    int    retval = -1;
+    int    bound;
+    cxobj *x;
+    int    ret;
+
+    if (clixon_binary_parse_string(msg, yspec, xt, &bound) < 0)
+        goto done;
+    x = NULL;
+    while ((x = xml_child_each(*xt, x, CX_ELMNT)) != NULL){
+        if ((ret = xml_bind_yang_rpc(h, x, yspec, xerr)) < 0)
+            goto done;
+        if (ret == 0){
+            if (*xerr && clixon_xml_attr_copy(x, *xerr, "message-id") < 0)
+                goto done;
+            goto fail;
+        }
+    }
+    if (xml_sort_recurse(*xt) < 0)
+        goto done;
+    retval = 1;
+ done:
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Return memory of the transient trees of an operation to the OS
+ *
+ * Free arena chunks are released, and with the heap policy also free memory of the
+ * system allocator if the operation released at least CLICON_MEMORY_TRIM_THRESHOLD
+ * bytes of arena memory.
+ * @param[in]  h     Clixon handle
+ * @param[in]  trim  Trim policy
+ * @see CLICON_MEMORY_TRIM
+ */
+static void
+backend_memory_trim(clixon_handle         h,
+                    enum memory_trim_mode trim)
+{
+    uint64_t bytes;
+
+    bytes = xml_arena_trim();
+    _memory_trimmed += bytes;
+#ifdef HAVE_MALLOC_TRIM
+    if (trim == MEMORY_TRIM_HEAP && bytes > 0 &&
+        bytes >= (uint64_t)clicon_option_int(h, "CLICON_MEMORY_TRIM_THRESHOLD")){
+        clixon_debug(CLIXON_DBG_BACKEND, "malloc_trim after %" PRIu64 " bytes", bytes);
+        malloc_trim(0);
+    }
+#endif
+}
+
 /*! An internal clixon NETCONF message has arrived from a local client. Receive and dispatch.
  *
  * @param[in]   h    Clixon handle
@@ -1652,9 +3562,21 @@ from_client_msg(clixon_handle        h,
     char                *rpcprefix;
     char                *namespace = NULL;
     int                  nr = 0;
-    cbuf                *cbce = NULL;
+    char                *msgid = NULL;
+    char                *str;
+    struct timespec      t0;
+    clixon_span          sp = {0,};
+    int                  memtag;
+    enum memory_trim_mode trim;
 
     clixon_debug(CLIXON_DBG_BACKEND | CLIXON_DBG_DETAIL, "");
+    clixon_latency_start(&t0);
+    /* Trees of the request are allocated from an arena released when it completes */
+    if ((trim = clicon_memory_trim(h)) != MEMORY_TRIM_NONE)
+        xml_arena_push();
+    if (clixon_mem_enabled() && ce->ce_memtag == 0)
+        ce->ce_memtag = clixon_mem_tag("session %u", ce->ce_id);
+    memtag = clixon_mem_tag_set(ce->ce_memtag ? ce->ce_memtag : CLIXON_MEM_TAG_OTHER);
     yspec = clicon_dbspec_yang(h);
     /* Return netconf message. Should be filled in by the dispatch(sub) functions 
      * as wither rpc-error or by positive response.
@@ -1666,7 +3588,15 @@ from_client_msg(clixon_handle        h,
     /* Decode msg from client -> xml top (ct) and session id 
      * Bind is a part of the decode function
      */
-    if ((ret = clixon_xml_parse_string(msg, YB_RPC, yspec, &xt, &xret)) < 0){
+    if (ce->ce_binary && clixon_binary_msg(msg)){
+        /* Binary rpc from client, see CLICON_SOCK_BINARY */
+        if ((ret = from_client_binary(h, msg, yspec, &xt, &xret)) < 0){
+            if (netconf_malformed_message(cbret, "Binary parse error") < 0)
+                goto done;
+            goto reply;
+        }
+    }
+    else if ((ret = clixon_xml_parse_string(msg, YB_RPC, yspec, &xt, &xret)) < 0){
         if (netconf_malformed_message(cbret, "XML parse error") < 0)
             goto done;
         goto reply;
@@ -1694,6 +3624,10 @@ from_client_msg(clixon_handle        h,
     }
     rpcname = xml_name(x);
     rpcprefix = xml_prefix(x);
+    /* Pipelined request: reply may be sent out of order, tagged with message-id */
+    if ((str = xml_find_type_value(x, CLIXON_LIB_PREFIX, "pipeline", CX_ATTR)) != NULL &&
+        strcmp(str, "true") == 0)
+        msgid = xml_find_type_value(x, NULL, "message-id", CX_ATTR);
 #ifdef NOTACTIVE /* May need to re-activate */
     /* Sanity check:
      * op_id from internal message can be out-of-sync from client's sessions-id for the following reasons:
@@ -1773,13 +3707,26 @@ from_client_msg(clixon_handle        h,
     }
     ce->ce_in_rpcs++; /* Track all RPCs */
     netconf_monitoring_counter_inc(h, "in-rpcs");
+    /* Read-only rpc may be handled by a forked read worker */
+    if ((ret = read_worker_fork(h, ce, x, msgid)) < 0)
+        goto done;
+    if (ret == 1)
+        goto ok;
 
+    /* Replies of pipelined requests are not streamed since they may interleave */
+    ce->ce_stream = (msgid == NULL);
+    ce->ce_streamed = 0;
     xe = NULL;
     username = xml_find_value(x, "username");
     /* May be used by callbacks, etc */
     clicon_username_set(h, username);
+    /* Trace context of client, see CLICON_TRACE_FILE */
+    if (clixon_trace_enabled())
+        clixon_trace_parent_set(xml_find_type_value(x, CLIXON_LIB_PREFIX, "traceparent", CX_ATTR));
     while ((xe = xml_child_each(x, xe, CX_ELMNT)) != NULL) {
         rpc = xml_name(xe);
+        clixon_trace_span_end(&sp);
+        clixon_trace_span_start(&sp, "rpc %s", rpc);
         if ((ye = xml_spec(xe)) == NULL){
             if (netconf_operation_not_supported(cbret, "protocol", rpc) < 0)
                 goto done;
@@ -1794,6 +3741,15 @@ from_client_msg(clixon_handle        h,
         module = yang_argument_get(ymod);
         clixon_debug(CLIXON_DBG_BACKEND, "module:%s rpc:%s ce_id:%u s:%d", module,
                      rpc, ce->ce_id, ce->ce_s);
+        /* Configuration is written on the primary, see CLICON_BACKEND_REPLICA_OF */
+        if (backend_replica_write(h, module, rpc)){
+            if (netconf_operation_not_supported(cbret, "application",
+                                                "Read-only replica, write to the primary") < 0)
+                goto done;
+            ce->ce_out_rpc_errors++;
+            netconf_monitoring_counter_inc(h, "out-rpc-errors");
+            goto reply;
+        }
         /* Pre-NACM access step */
         xnacm = NULL;
 
@@ -1821,7 +3777,7 @@ from_client_msg(clixon_handle        h,
                 goto reply;
             }
             /* NACM rpc operation exec validation */
-            if ((ret = nacm_rpc(rpc, module, username, xnacm, cbret)) < 0)
+            if ((ret = nacm_rpc(h, rpc, module, username, xnacm, cbret)) < 0)
                 goto done;
             if (ret == 0){ /* Not permitted and cbret set */
                 ce->ce_out_rpc_errors++;
@@ -1857,37 +3813,42 @@ from_client_msg(clixon_handle        h,
                 goto done;
         }
     } /* while */
+    /* Reply is sent later, see backend_client_reply_deferred */
+    if (ce->ce_pending){
+        if (msgid && (ce->ce_pending_msgid = strdup(msgid)) == NULL){
+            clixon_err(OE_UNIX, errno, "strdup");
+            goto done;
+        }
+        goto ok;
+    }
  reply:
+    /* Reply already sent in chunks, see CLICON_BACKEND_STREAM_CHUNK */
+    if (ce->ce_streamed)
+        goto ok;
     if (cbuf_len(cbret) == 0)
         if (netconf_operation_failed(cbret, "application",
                                      clixon_err_category()?clixon_err_reason():"unknown")< 0)
             goto done;
+    if (msgid && ce_reply_msgid(cbret, msgid) < 0)
+        goto done;
+    if (_read_worker_fd != -1) /* Reply is written to backend on exit */
+        goto ok;
     // XXX    clixon_debug(CLIXON_DBG_MSG, "Reply:%s", cbuf_get(cbret));
     /* XXX problem here is that cbret has not been parsed so may contain 
        parse errors */
-    if (ce_client_descr(ce, &cbce) < 0)
+    if (ce_reply_send(h, ce, cbret) < 0)
         goto done;
-    if (send_msg_reply(ce->ce_s, cbuf_get(cbce), cbuf_get(cbret), cbuf_len(cbret)+1) < 0){
-        switch (errno){
-        case EPIPE:
-            /* man (2) write: 
-             * EPIPE  fd is connected to a pipe or socket whose reading end is 
-             * closed.  When this happens the writing process will also receive 
-             * a SIGPIPE signal. 
-             * In Clixon this means a client, eg restconf, netconf or cli closes
-             * the (UNIX domain) socket.
-             */
-        case ECONNRESET:
-            clixon_log(h, LOG_WARNING, "client rpc reset");
-            break;
-        default:
-            goto done;
-        }
-    }
-    // ok:
+  ok:
     retval = 0;
   done:
     clixon_debug(CLIXON_DBG_BACKEND | CLIXON_DBG_DETAIL, "retval:%d", retval);
+    if (rpc)
+        clixon_latency_stop(&t0, "rpc", rpc);
+    clixon_trace_span_end(&sp);
+    ce->ce_stream = 0;
+    clixon_mem_tag_set(memtag);
+    if (_read_worker_fd != -1)
+        read_worker_exit(ce, cbret, msgid, retval); /* Does not return */
     if (xnacm){
         xml_free(xnacm);
         if (clicon_nacm_cache_set(h, NULL) < 0)
@@ -1897,10 +3858,12 @@ from_client_msg(clixon_handle        h,
         xml_free(xret);
     if (xt)
         xml_free(xt);
-    if (cbce)
-        cbuf_free(cbce);
     if (cbret)
         cbuf_free(cbret);
+    if (trim != MEMORY_TRIM_NONE){
+        xml_arena_pop();
+        backend_memory_trim(h, trim);
+    }
     /* Sanity: log if clixon_err() is not called ! */
     if (retval < 0 && clixon_err_category() < 0)
         clixon_log(h, LOG_NOTICE, "%s: Internal error: No clixon_err call on RPC error (message: %s)",
@@ -1909,6 +3872,61 @@ from_client_msg(clixon_handle        h,
     return retval;// -1 here terminates backend
 }
 
+/*! Receive and dispatch messages from a client
+ *
+ * A client may pipeline requests, ie send several requests without waiting for
+ * replies. All complete messages in buffered input are handled, unless the reply
+ * of a message is deferred, in which case the rest is handled when the reply is sent.
+ * @param[in]   h    Clixon handle
+ * @param[in]   ce   Client entry
+ * @param[in]   rd   Read from client socket, otherwise only handle buffered input
+ * @retval      0    OK
+ * @retval     -1    Error
+ */
+static int
+from_client_rcv(clixon_handle        h,
+                struct client_entry *ce,
+                int                  rd)
+{
+    int      retval = -1;
+    uint32_t id = ce->ce_id;
+    int      eof = 0;
+    cbuf    *cbce = NULL;
+    cbuf    *cb = NULL;
+
+    if (ce->ce_rcv == NULL &&
+        (ce->ce_rcv = clixon_msg_rcv_new()) == NULL)
+        goto done;
+    if (ce_client_descr(ce, &cbce) < 0)
+        goto done;
+    do {
+        if (clixon_msg_rcv11_next(ce->ce_s, cbuf_get(cbce), ce->ce_rcv, rd, &cb, &eof) < 0)
+            goto done;
+        rd = 0;
+        if (eof){
+            backend_client_rm(h, ce);
+            netconf_monitoring_counter_inc(h, "dropped-sessions");
+            break;
+        }
+        if (cb == NULL) /* Need more input */
+            break;
+        ce->ce_msg_len = cbuf_len(cb);
+        if (from_client_msg(h, ce, cbuf_get(cb)) < 0)
+            goto done;
+        cbuf_free(cb);
+        cb = NULL;
+        /* Client may have been removed by the rpc, eg kill-session */
+    } while ((ce = ce_find_byid(backend_client_list(h), id)) != NULL &&
+             ce->ce_pending == 0);
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    if (cbce)
+        cbuf_free(cbce);
+    return retval;
+}
+
 /*! Internal clixon message has arrived from a client. Receive and dispatch.
  *
  * Internal clixon is NETCONF 1.1 chunked encoding
@@ -1925,35 +3943,121 @@ from_client(int   s,
     int                  retval = -1;
     struct client_entry *ce = (struct client_entry *)arg;
     clixon_handle        h = ce->ce_handle;
-    int                  eof = 0;
-    cbuf                *cbce = NULL;
-    cbuf                *cb = NULL;
 
     clixon_debug(CLIXON_DBG_BACKEND | CLIXON_DBG_DETAIL, "");
     if (s != ce->ce_s){
         clixon_err(OE_NETCONF, EINVAL, "Internal error: s != ce->ce_s");
         goto done;
     }
-    if (ce_client_descr(ce, &cbce) < 0)
+    if (from_client_rcv(h, ce, 1) < 0)
         goto done;
-    if (clixon_msg_rcv11(s, cbuf_get(cbce), 0, &cb, &eof) < 0) /* XXX why not descr here? */
-        goto done;
-    if (eof){
-        backend_client_rm(h, ce);
-        netconf_monitoring_counter_inc(h, "dropped-sessions");
-    }
-    else if (from_client_msg(h, ce, cbuf_get(cb)) < 0)
+    /* Publish running to local frontends if changed by the request */
+    if (xmldb_snapshot_write(h) < 0)
+        clixon_log(h, LOG_WARNING, "%s: snapshot: %s", __FUNCTION__, clixon_err_reason());
+    /* No references into datastore caches remain between requests */
+    if (xmldb_lazy_evict(h) < 0)
         goto done;
     retval = 0;
   done:
     clixon_debug(CLIXON_DBG_BACKEND | CLIXON_DBG_DETAIL, "retval:%d", retval);
-    if (cb)
-        cbuf_free(cb);
-    if (cbce)
-        cbuf_free(cbce);
     return retval; /* -1 here terminates backend */
 }
 
+/*! Timer callback: handle pipelined messages buffered while a reply was deferred
+ *
+ * The input is already read from the client sockets, so there is no socket event
+ * @param[in]   s    Not used
+ * @param[in]   arg  Clixon handle
+ * @retval      0    OK
+ * @retval     -1    Error
+ */
+static int
+from_client_resume(int   s,
+                   void *arg)
+{
+    clixon_handle        h = (clixon_handle)arg;
+    struct client_entry *ce;
+
+    do {
+        for (ce = backend_client_list(h); ce; ce = ce->ce_next)
+            if (ce->ce_pending == 0 && ce->ce_rcv && clixon_msg_rcv_pending(ce->ce_rcv))
+                break;
+        if (ce && from_client_rcv(h, ce, 0) < 0)
+            return -1;
+    } while (ce != NULL);
+    if (xmldb_snapshot_write(h) < 0)
+        clixon_log(h, LOG_WARNING, "%s: snapshot: %s", __FUNCTION__, clixon_err_reason());
+    return xmldb_lazy_evict(h);
+}
+
+/*! Defer the reply to the message being handled from a client
+ *
+ * The client socket is not read until the reply is sent, which keeps the order
+ * of requests and replies of the session.
+ * @param[in]  ce   Client entry
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see backend_client_reply_deferred
+ */
+int
+backend_client_defer(struct client_entry *ce)
+{
+    if (clixon_event_unreg_fd(ce->ce_s, from_client) < 0){
+        clixon_err(OE_EVENTS, ENOENT, "Client socket %d not registered", ce->ce_s);
+        return -1;
+    }
+    ce->ce_pending = 1;
+    return 0;
+}
+
+/*! Send a deferred reply to a client and resume reading from it
+ *
+ * @param[in]  h      Clixon handle
+ * @param[in]  id     Session id of client
+ * @param[in]  cbret  Reply message, message-id is added if request was pipelined.
+ *                    NULL if reply already sent, only resume reading
+ * @retval     0      OK, or client is gone
+ * @retval    -1      Error
+ * @see backend_client_defer
+ */
+int
+backend_client_reply_deferred(clixon_handle h,
+                              uint32_t      id,
+                              cbuf         *cbret)
+{
+    int                  retval = -1;
+    struct client_entry *ce;
+    struct timeval       t;
+
+    if ((ce = ce_find_byid(backend_client_list(h), id)) == NULL ||
+        ce->ce_pending == 0){
+        clixon_log(h, LOG_NOTICE, "%s: client %u is gone, reply dropped", __FUNCTION__, id);
+        goto ok;
+    }
+    ce->ce_pending = 0;
+    if (ce->ce_pending_msgid){
+        if (cbret && ce_reply_msgid(cbret, ce->ce_pending_msgid) < 0)
+            goto done;
+        free(ce->ce_pending_msgid);
+        ce->ce_pending_msgid = NULL;
+    }
+    if (cbret && ce_reply_send(h, ce, cbret) < 0)
+        goto done;
+    if (clixon_event_reg_fd_prio(ce->ce_s, from_client, (void*)ce, "local netconf client socket",
+                                 clicon_option_bool(h, "CLICON_SOCK_PRIO")) < 0)
+        goto done;
+    /* Requests pipelined after the deferred one may already have been read */
+    if (ce->ce_rcv && clixon_msg_rcv_pending(ce->ce_rcv)){
+        gettimeofday(&t, NULL);
+        if (clixon_event_reg_timeout(t, from_client_resume, h, "pipelined client messages") < 0)
+            goto done;
+    }
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Init backend rpc: Set up standard netconf rpc callbacks
  *
  * @param[in]  h     Clixon handle
@@ -2030,12 +4134,33 @@ backend_rpc_init(clixon_handle h)
     if (rpc_callback_register(h, from_client_stats, NULL,
                               CLIXON_LIB_NS, "stats") < 0)
         goto done;
+    if (rpc_callback_register(h, clixon_profile_rpc, "backend",
+                              CLIXON_LIB_NS, "profile") < 0)
+        goto done;
     if (rpc_callback_register(h, from_client_restart_plugin, NULL,
                               CLIXON_LIB_NS, "restart-plugin") < 0)
         goto done;
     if (rpc_callback_register(h, from_client_process_control, NULL,
                               CLIXON_LIB_NS, "process-control") < 0)
         goto done;
+    if (rpc_callback_register(h, from_client_batch, NULL,
+                              CLIXON_LIB_NS, "batch") < 0)
+        goto done;
+    if (rpc_callback_register(h, from_client_datastore_stamp, NULL,
+                              CLIXON_LIB_NS, "datastore-stamp") < 0)
+        goto done;
+    if (rpc_callback_register(h, from_client_datastore_diff, NULL,
+                              CLIXON_LIB_NS, "datastore-diff") < 0)
+        goto done;
+    if (rpc_callback_register(h, from_client_establish_push, NULL,
+                              CLIXON_LIB_NS, "establish-push") < 0)
+        goto done;
+    if (rpc_callback_register(h, from_client_delete_push, NULL,
+                              CLIXON_LIB_NS, "delete-push") < 0)
+        goto done;
+    if (rpc_callback_register(h, from_client_replica_promote, NULL,
+                              CLIXON_LIB_NS, "replica-promote") < 0)
+        goto done;
     retval =0;
  done:
     return retval;
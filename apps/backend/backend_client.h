@@ -42,7 +42,15 @@
  */
 int backend_monitoring_state_get(clixon_handle h, yang_stmt *yspec, char *xpath, cvec *nsc, cxobj **xret, cxobj **xerr);
 int backend_client_rm(clixon_handle h, struct client_entry *ce);
+int backend_client_notify_flush(struct client_entry *ce);
 int from_client(int fd, void *arg);
+int backend_client_defer(struct client_entry *ce);
+int backend_client_reply_deferred(clixon_handle h, uint32_t id, cbuf *cbret);
+int backend_lock_wait_wake(clixon_handle h, const char *db);
+char *backend_candidate_db(clixon_handle h, struct client_entry *ce, char *db);
+int backend_candidate_reset(clixon_handle h, struct client_entry *ce);
 int backend_rpc_init(clixon_handle h);
+int backend_client_stats_free(clixon_handle h);
+int backend_client_schema_free(clixon_handle h);
 
 #endif  /* _BACKEND_CLIENT_H_ */
@@ -71,6 +71,9 @@
 #include "backend_handle.h"
 #include "clixon_backend_commit.h"
 #include "backend_client.h"
+#include "backend_stamp.h"
+#include "backend_push.h"
+#include "backend_startup.h"
 
 /*! Key values are checked for validity independent of user-defined callbacks
  *
@@ -84,6 +87,7 @@
  * @param[in]   h       Clixon handle
  * @param[in]   yspec   Yang spec
  * @param[in]   td      Transaction data
+ * @param[in]   incr    Only validate the diff of td, see CLICON_VALIDATE_INCREMENTAL
  * @param[out]  xret    Error XML tree. Free with xml_free after use
  * @retval      1       Validation OK       
  * @retval      0       Validation failed (with cbret set)
@@ -93,16 +97,28 @@ static int
 generic_validate(clixon_handle       h,
                  yang_stmt          *yspec,
                  transaction_data_t *td,
+                 int                 incr,
                  cxobj             **xret)
 {
-    int        retval = -1;
-    cxobj     *x2;
-    int        i;
-    int        ret;
-    cbuf      *cb = NULL;
+    int             retval = -1;
+    cxobj          *x2;
+    int             i;
+    int             ret;
+    cbuf           *cb = NULL;
+    struct timespec t0;
+    clixon_span     sp = {0,};
 
-    /* All entries */
-    if ((ret = xml_yang_validate_all_top(h, td->td_target, xret)) < 0)
+    clixon_latency_start(&t0);
+    clixon_trace_span_start(&sp, "commit validate");
+    /* All entries, or only those affected by the diff */
+    if (incr)
+        ret = xml_yang_validate_diff(h, td->td_target,
+                                     td->td_avec, td->td_alen,
+                                     td->td_dvec, td->td_dlen,
+                                     td->td_tcvec, td->td_clen, xret);
+    else
+        ret = xml_yang_validate_all_top(h, td->td_target, xret);
+    if (ret < 0)
         goto done;
     if (ret == 0)
         goto fail;
@@ -126,6 +142,8 @@ generic_validate(clixon_handle       h,
     // ok:
     retval = 1;
  done:
+    clixon_latency_stop(&t0, "commit", "validate");
+    clixon_trace_span_end(&sp);
     if (cb)
         cbuf_free(cb);
     return retval;
@@ -155,6 +173,8 @@ generic_validate(clixon_handle       h,
  * 4. Validate startup db. (valid)
  * 5. If valid fails, call startup-cb(Invalid, msdiff), keep startup in candidate and commit failsafe db. Done.
  * 6. Call startup-cb(OK, msdiff) and commit.
+ * If the startup db and the backend are unchanged since the last validation, the validated
+ * tree is read from CLICON_STARTUP_SNAPSHOT instead and steps 1-5 are skipped.
  * @see validate_common   for incoming validate/commit
  */
 static int
@@ -171,7 +191,15 @@ startup_common(clixon_handle       h,
     cxobj              *x;
     cxobj              *xret = NULL;
     cxobj              *xerr = NULL;
+    int                 snapshot = 0;
 
+    /* Unchanged since last validated startup: skip upgrade and validation */
+    if (clicon_quit_upgrade_get(h) == 0){
+        if ((snapshot = startup_snapshot_read(h, db, &xt)) < 0)
+            goto done;
+        if (snapshot == 1)
+            goto transaction;
+    }
     /* If CLICON_XMLDB_MODSTATE is enabled, then get the db XML with 
      * potentially non-matching module-state in msdiff
      */
@@ -294,6 +322,7 @@ startup_common(clixon_handle       h,
         goto done;
 
     /* Handcraft transition with with only add tree */
+ transaction:
     td->td_target = xt;
     xt = NULL;
     x = NULL;
@@ -307,23 +336,28 @@ startup_common(clixon_handle       h,
     if (plugin_transaction_begin_all(h, td) < 0)
         goto done;
 
-    /* 5. Make generic validation on all new or changed data.
-       Note this is only call that uses 3-values */
-    clixon_debug(CLIXON_DBG_BACKEND, "Validating startup %s", db);
-    if ((ret = generic_validate(h, yspec, td, &xret)) < 0)
-        goto done;
-    if (ret == 0){
-        if (clixon_xml2cbuf(cbret, xret, 0, 0, NULL, -1, 0) < 0)
+    if (snapshot == 0){
+        /* 5. Make generic validation on all new or changed data.
+           Note this is only call that uses 3-values */
+        clixon_debug(CLIXON_DBG_BACKEND, "Validating startup %s", db);
+        if ((ret = generic_validate(h, yspec, td, 0, &xret)) < 0)
+            goto done;
+        if (ret == 0){
+            if (clixon_xml2cbuf(cbret, xret, 0, 0, NULL, -1, 0) < 0)
+                goto done;
+            goto fail; /* STARTUP_INVALID */
+        }
+        /* 6. Call plugin transaction validate callbacks */
+        if (plugin_transaction_validate_all(h, td) < 0)
             goto done;
-        goto fail; /* STARTUP_INVALID */
     }
-    /* 6. Call plugin transaction validate callbacks */
-    if (plugin_transaction_validate_all(h, td) < 0)
-        goto done;
-
     /* 7. Call plugin transaction complete callbacks */
     if (plugin_transaction_complete_all(h, td) < 0)
         goto done;
+    /* Save validated tree for next restart */
+    if (snapshot == 0 &&
+        startup_snapshot_write(h, db, td->td_target) < 0)
+        goto done;
  ok:
     retval = 1;
  done:
@@ -464,6 +498,86 @@ startup_commit(clixon_handle  h,
     goto done;
 }
 
+/*! Mark deleted, added and changed nodes of a transaction diff in the src and target trees
+ *
+ * @param[in]  td      Transaction data
+ */
+static void
+transaction_mark(transaction_data_t *td)
+{
+    int    i;
+    cxobj *xn;
+
+    for (i=0; i<td->td_dlen; i++){ /* Also down */
+        xn = td->td_dvec[i];
+        xml_flag_set(xn, XML_FLAG_DEL);
+        xml_apply(xn, CX_ELMNT, (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_DEL);
+        xml_apply_ancestor(xn, (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_CHANGE);
+    }
+    for (i=0; i<td->td_alen; i++){ /* Also down */
+        xn = td->td_avec[i];
+        xml_flag_set(xn, XML_FLAG_ADD);
+        xml_apply(xn, CX_ELMNT, (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_ADD);
+        xml_apply_ancestor(xn, (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_CHANGE);
+    }
+    for (i=0; i<td->td_clen; i++){ /* Also up */
+        xn = td->td_scvec[i];
+        xml_flag_set(xn, XML_FLAG_CHANGE);
+        xml_apply_ancestor(xn, (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_CHANGE);
+        xn = td->td_tcvec[i];
+        xml_flag_set(xn, XML_FLAG_CHANGE);
+        xml_apply_ancestor(xn, (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_CHANGE);
+    }
+}
+
+/*! Validate a transaction with a computed and marked diff
+ *
+ * Call begin, validate and complete plugin callbacks and make generic validation
+ * @param[in]  h       Clixon handle
+ * @param[in]  yspec   Yang spec
+ * @param[in]  td      Transaction data
+ * @param[in]  incr    Only validate the diff, running is then assumed to be valid
+ * @param[out] xret    Error XML tree, if retval is 0. Free with xml_free after use
+ * @retval     1       Validation OK       
+ * @retval     0       Validation failed (with xret set)
+ * @retval    -1       Error
+ */
+static int
+transaction_validate(clixon_handle       h,
+                     yang_stmt          *yspec,
+                     transaction_data_t *td,
+                     int                 incr,
+                     cxobj             **xret)
+{
+    int retval = -1;
+    int ret;
+
+    /* 4. Call plugin transaction start callbacks */
+    if (plugin_transaction_begin_all(h, td) < 0)
+        goto done;
+
+    /* 5. Make generic validation on all new or changed data.
+       Note this is only call that uses 3-values */
+    if ((ret = generic_validate(h, yspec, td, incr, xret)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
+
+    /* 6. Call plugin transaction validate callbacks */
+    if (plugin_transaction_validate_all(h, td) < 0)
+        goto done;
+
+    /* 7. Call plugin transaction complete callbacks */
+    if (plugin_transaction_complete_all(h, td) < 0)
+        goto done;
+    retval = 1;
+ done:
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
 /*! Validate a candidate db and comnpare to running
  *
  * Get both source and dest datastore, validate target, compute diffs
@@ -471,6 +585,7 @@ startup_commit(clixon_handle  h,
  * @param[in]  h       Clixon handle
  * @param[in]  db      The (candidate) database. The wanted backend state
  * @param[in]  td      Transaction data
+ * @param[in]  incr    Only validate the diff, running is then assumed to be valid
  * @param[out] xret    Error XML tree, if retval is 0. Free with xml_free after use
  * @retval     1       Validation OK       
  * @retval     0       Validation failed (with xret set)
@@ -483,13 +598,15 @@ static int
 validate_common(clixon_handle       h,
                 char               *db,
                 transaction_data_t *td,
+                int                 incr,
                 cxobj             **xret)
 {
-    int         retval = -1;
-    yang_stmt  *yspec;
-    int         i;
-    cxobj      *xn;
-    int         ret;
+    int             retval = -1;
+    yang_stmt      *yspec;
+    int             ret;
+    int             flag;
+    struct timespec t0;
+    clixon_span     sp = {0,};
 
     if ((yspec = clicon_dbspec_yang(h)) == NULL){
         clixon_err(OE_FATAL, 0, "No DB_SPEC");
@@ -518,58 +635,40 @@ validate_common(clixon_handle       h,
     /* Clear flags xpath for get */
     xml_apply0(td->td_src, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset,
                (void*)(XML_FLAG_MARK|XML_FLAG_CHANGE));
-    /* 3. Compute differences */
-    if (xml_diff(td->td_src,
-                 td->td_target,
-                 &td->td_dvec,      /* removed: only in running */
-                 &td->td_dlen,
-                 &td->td_avec,      /* added: only in candidate */
-                 &td->td_alen,
-                 &td->td_scvec,     /* changed: original values */
-                 &td->td_tcvec,     /* changed: wanted values */
-                 &td->td_clen) < 0)
+    /* 3. Compute differences
+     * If all edits since db was equal to running are marked, only traverse marked subtrees
+     */
+    flag = 0;
+    if (clicon_option_bool(h, "CLICON_XMLDB_DIFF_INCREMENTAL")){
+        if ((ret = xmldb_edited_get(h, db)) < 0)
+            goto done;
+        if (ret == 1)
+            flag = XML_FLAG_EDITED;
+    }
+    clixon_latency_start(&t0);
+    clixon_trace_span_start(&sp, "commit diff");
+    ret = xml_diff_flagged(td->td_src,
+                           td->td_target,
+                           flag,
+                           &td->td_dvec,      /* removed: only in running */
+                           &td->td_dlen,
+                           &td->td_avec,      /* added: only in candidate */
+                           &td->td_alen,
+                           &td->td_scvec,     /* changed: original values */
+                           &td->td_tcvec,     /* changed: wanted values */
+                           &td->td_clen);
+    clixon_trace_span_end(&sp);
+    if (ret < 0)
         goto done;
+    clixon_latency_stop(&t0, "commit", "diff");
     if (clixon_debug_get() & CLIXON_DBG_DETAIL)
         transaction_dbg(h, CLIXON_DBG_DETAIL, td, __FUNCTION__);
     /* Mark as changed in tree */
-    for (i=0; i<td->td_dlen; i++){ /* Also down */
-        xn = td->td_dvec[i];
-        xml_flag_set(xn, XML_FLAG_DEL);
-        xml_apply(xn, CX_ELMNT, (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_DEL);
-        xml_apply_ancestor(xn, (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_CHANGE);
-    }
-    for (i=0; i<td->td_alen; i++){ /* Also down */
-        xn = td->td_avec[i];
-        xml_flag_set(xn, XML_FLAG_ADD);
-        xml_apply(xn, CX_ELMNT, (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_ADD);
-        xml_apply_ancestor(xn, (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_CHANGE);
-    }
-    for (i=0; i<td->td_clen; i++){ /* Also up */
-        xn = td->td_scvec[i];
-        xml_flag_set(xn, XML_FLAG_CHANGE);
-        xml_apply_ancestor(xn, (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_CHANGE);
-        xn = td->td_tcvec[i];
-        xml_flag_set(xn, XML_FLAG_CHANGE);
-        xml_apply_ancestor(xn, (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_CHANGE);
-    }
-    /* 4. Call plugin transaction start callbacks */
-    if (plugin_transaction_begin_all(h, td) < 0)
-        goto done;
-
-    /* 5. Make generic validation on all new or changed data.
-       Note this is only call that uses 3-values */
-    if ((ret = generic_validate(h, yspec, td, xret)) < 0)
+    transaction_mark(td);
+    if ((ret = transaction_validate(h, yspec, td, incr, xret)) < 0)
         goto done;
     if (ret == 0)
         goto fail;
-
-    /* 6. Call plugin transaction validate callbacks */
-    if (plugin_transaction_validate_all(h, td) < 0)
-        goto done;
-
-    /* 7. Call plugin transaction complete callbacks */
-    if (plugin_transaction_complete_all(h, td) < 0)
-        goto done;
     retval = 1;
  done:
     return retval;
@@ -606,7 +705,7 @@ candidate_validate(clixon_handle h,
     if ((td = transaction_new()) == NULL)
         goto done;
         /* Common steps (with commit) */
-    if ((ret = validate_common(h, db, td, &xret)) < 0){
+    if ((ret = validate_common(h, db, td, 0, &xret)) < 0){
         /* A little complex due to several sources of validation fails or errors.
          * (1) xerr is set -> translate to cbret; (2) cbret set use that; otherwise
          * use clixon_err. 
@@ -645,6 +744,256 @@ candidate_validate(clixon_handle h,
     goto done;
 }
 
+/*! Commit transaction parked while plugin commits are pending
+ *
+ * @see candidate_commit_pending_cb
+ */
+struct commit_pending {
+    struct commit_pending *cpe_next;
+    clixon_handle       cpe_h;
+    transaction_data_t *cpe_td;
+    char               *cpe_db;     /* Candidate database */
+    uint32_t           *cpe_ids;    /* Session ids of clients waiting for reply, first owns locks */
+    int                 cpe_nids;   /* Length of cpe_ids */
+    int                 cpe_lockdb; /* db was locked by the commit */
+    int                 cpe_lockrun; /* running was locked by the commit */
+};
+
+/* List of parked commits */
+static struct commit_pending *_commit_pending = NULL;
+
+/* Group commit: session ids of commits waiting for the group commit timer
+ * @see CLICON_COMMIT_GROUP_WINDOW
+ */
+static uint32_t *_commit_group = NULL;
+static int       _commit_group_len = 0;
+
+/*! Complete a commit transaction after all plugins have committed
+ *
+ * @param[in]  h          Clixon handle
+ * @param[in]  db         A candidate database, not necessarily "candidate"
+ * @param[in]  td         Transaction data
+ * @retval     0          OK
+ * @retval    -1          Error
+ */
+static int
+candidate_commit_finish(clixon_handle       h,
+                        char               *db,
+                        transaction_data_t *td)
+{
+    int retval = -1;
+
+    /* After commit, make a post-commit call (sure that all plugins have committed) */
+    if (plugin_transaction_commit_done_all(h, td) < 0)
+        goto done;
+    /* Mark changed top-level nodes while source tree is still valid */
+    if (backend_stamp_mark(h, td) < 0)
+        goto done;
+    if (backend_push_commit(h, td) < 0)
+        goto done;
+    /* 8. Success: Copy candidate to running 
+     */
+    if (xmldb_copy(h, db, "running") < 0)
+        goto done;
+    if (backend_stamp_commit(h) < 0)
+        goto done;
+    xmldb_modified_set(h, db, 0); /* reset dirty bit */
+    /* Here pointers to old (source) tree are obsolete */
+    if (td->td_dvec){
+        td->td_dlen = 0;
+        free(td->td_dvec);
+        td->td_dvec = NULL;
+    }
+    if (td->td_scvec){
+        free(td->td_scvec);
+        td->td_scvec = NULL;
+    }
+    /* 9. Call plugin transaction end callbacks */
+    plugin_transaction_end_all(h, td);
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Free a parked commit transaction and release the datastore locks it holds
+ *
+ * @param[in]  cpe        Parked commit
+ */
+static int
+commit_pending_free(struct commit_pending *cpe)
+{
+    clixon_handle           h = cpe->cpe_h;
+    struct commit_pending **cpp;
+
+    for (cpp = &_commit_pending; *cpp; cpp = &(*cpp)->cpe_next)
+        if (*cpp == cpe){
+            *cpp = cpe->cpe_next;
+            break;
+        }
+    if (cpe->cpe_lockdb && xmldb_islocked(h, cpe->cpe_db) == cpe->cpe_ids[0])
+        xmldb_unlock(h, cpe->cpe_db);
+    if (cpe->cpe_lockrun && xmldb_islocked(h, "running") == cpe->cpe_ids[0])
+        xmldb_unlock(h, "running");
+    /* Errors are logged, wake is best effort when freeing */
+    if (cpe->cpe_db)
+        backend_lock_wait_wake(h, cpe->cpe_db);
+    backend_lock_wait_wake(h, "running");
+    if (cpe->cpe_td)
+        transaction_free(cpe->cpe_td);
+    if (cpe->cpe_db)
+        free(cpe->cpe_db);
+    if (cpe->cpe_ids)
+        free(cpe->cpe_ids);
+    free(cpe);
+    return 0;
+}
+
+/*! Check if a datastore lock is held by a parked commit
+ *
+ * @param[in]  id   Session id of lock
+ * @retval     1    Lock is held by a parked commit
+ * @retval     0    No
+ */
+static int
+commit_pending_lock(uint32_t id)
+{
+    struct commit_pending *cpe;
+
+    for (cpe = _commit_pending; cpe; cpe = cpe->cpe_next)
+        if (cpe->cpe_ids[0] == id && (cpe->cpe_lockdb || cpe->cpe_lockrun))
+            return 1;
+    return 0;
+}
+
+/*! A pending plugin commit file descriptor is readable
+ *
+ * When all pending commits are completed, complete or revert the transaction and
+ * send the deferred reply to the client.
+ * @param[in]  fd   Pending commit file descriptor
+ * @param[in]  arg  Parked commit, struct commit_pending
+ * @retval     0    OK
+ * @retval    -1    Error (fatal)
+ */
+static int
+candidate_commit_pending_cb(int   fd,
+                            void *arg)
+{
+    int                    retval = -1;
+    struct commit_pending *cpe = (struct commit_pending *)arg;
+    clixon_handle          h = cpe->cpe_h;
+    transaction_data_t    *td = cpe->cpe_td;
+    cbuf                  *cbret = NULL;
+    int                    ret;
+    int                    i;
+
+    clixon_err_reset();
+    if ((ret = plugin_transaction_pending_event(h, td, fd)) < 0)
+        goto done;
+    if (!plugin_transaction_pending_fd(td, fd))
+        clixon_event_unreg_fd(fd, candidate_commit_pending_cb);
+    if (ret == 2) /* Still pending */
+        goto ok;
+    if ((cbret = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if (ret == 1 && candidate_commit_finish(h, cpe->cpe_db, td) == 0){
+        if (strcmp(cpe->cpe_db, "candidate") == 0 &&
+            clicon_option_bool(h, "CLICON_AUTOLOCK")){
+            xmldb_unlock(h, "candidate");
+            if (backend_lock_wait_wake(h, "candidate") < 0)
+                goto done;
+        }
+        cprintf(cbret, "<rpc-reply xmlns=\"%s\"><ok/></rpc-reply>", NETCONF_BASE_NAMESPACE);
+    }
+    else {
+        clixon_debug(CLIXON_DBG_BACKEND, "Commit candidate failed");
+        plugin_transaction_abort_all(h, td);
+        if (netconf_operation_failed(cbret, "application",
+                                     clixon_err_category()?clixon_err_reason():"Pending commit failed") < 0)
+            goto done;
+    }
+    for (i = 0; i < cpe->cpe_nids; i++)
+        if (backend_client_reply_deferred(h, cpe->cpe_ids[i], cbret) < 0)
+            goto done;
+    commit_pending_free(cpe);
+ ok:
+    retval = 0;
+ done:
+    if (cbret)
+        cbuf_free(cbret);
+    return retval;
+}
+
+/*! Park a commit transaction until its pending plugin commits complete
+ *
+ * The datastores are locked by the first client while the commit is pending, other
+ * clients may still read running.
+ * @param[in]  h          Clixon handle
+ * @param[in]  db         A candidate database, not necessarily "candidate"
+ * @param[in]  ids        Session ids of clients waiting for reply
+ * @param[in]  nids       Length of ids
+ * @param[in]  td         Transaction data, consumed on success
+ * @retval     0          OK
+ * @retval    -1          Error
+ */
+static int
+candidate_commit_park(clixon_handle       h,
+                      char               *db,
+                      uint32_t           *ids,
+                      int                 nids,
+                      transaction_data_t *td)
+{
+    int                    retval = -1;
+    struct commit_pending *cpe = NULL;
+    struct trans_pending  *tp;
+
+    if ((cpe = malloc(sizeof(*cpe))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    memset(cpe, 0, sizeof(*cpe));
+    cpe->cpe_h = h;
+    if ((cpe->cpe_ids = malloc(nids*sizeof(*ids))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    memcpy(cpe->cpe_ids, ids, nids*sizeof(*ids));
+    cpe->cpe_nids = nids;
+    if ((cpe->cpe_db = strdup(db)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    for (tp = td->td_pending; tp; tp = tp->tp_next){
+        if (tp->tp_rv != 1)
+            continue;
+        if (clixon_event_reg_fd(tp->tp_fd, candidate_commit_pending_cb, cpe, "pending commit") < 0){
+            for (tp = td->td_pending; tp; tp = tp->tp_next)
+                clixon_event_unreg_fd(tp->tp_fd, candidate_commit_pending_cb);
+            goto done;
+        }
+    }
+    if (xmldb_islocked(h, db) == 0){
+        if (xmldb_lock(h, db, ids[0]) < 0)
+            goto done;
+        cpe->cpe_lockdb = 1;
+    }
+    if (xmldb_islocked(h, "running") == 0){
+        if (xmldb_lock(h, "running", ids[0]) < 0)
+            goto done;
+        cpe->cpe_lockrun = 1;
+    }
+    cpe->cpe_td = td;
+    cpe->cpe_next = _commit_pending;
+    _commit_pending = cpe;
+    cpe = NULL;
+    retval = 0;
+ done:
+    if (cpe)
+        commit_pending_free(cpe);
+    return retval;
+}
+
 /*! Do a diff between candidate and running, then start a commit transaction
  *
  * The code reverts changes if the commit fails. But if the revert
@@ -654,19 +1003,23 @@ candidate_validate(clixon_handle h,
  * @param[in]  xe         Request: <rpc><xn></rpc>  (or NULL)
  * @param[in]  db         A candidate database, not necessarily "candidate"
  * @param[in]  myid       Client id of triggering incoming message (or 0)
- * @param[in]  vlev       Validation level (0: full validation) // obsolete
+ * @param[in]  ids        Park the transaction if plugin commits are pending and defer reply
+ *                        to these session ids, or NULL to wait
+ * @param[in]  nids       Length of ids
  * @param[out] cbret      Return xml tree, eg <rpc-reply>..., <rpc-error.. (if retval = 0)
+ * @retval     2          Plugin commits pending, reply is sent by candidate_commit_pending_cb
  * @retval     1          Validation OK       
  * @retval     0          Validation failed (with cbret set)
  * @retval    -1          Error - or validation failed 
  */
-int
-candidate_commit(clixon_handle  h,
-                 cxobj         *xe,
-                 char          *db,
-                 uint32_t       myid,
-                 validate_level vlev, // obsolete
-                 cbuf          *cbret)
+static int
+candidate_commit1(clixon_handle  h,
+                  cxobj         *xe,
+                  char          *db,
+                  uint32_t       myid,
+                  uint32_t      *ids,
+                  int            nids,
+                  cbuf          *cbret)
 {
     int                 retval = -1;
     transaction_data_t *td = NULL;
@@ -682,7 +1035,9 @@ candidate_commit(clixon_handle  h,
     /* Common steps (with validate). Load candidate and running and compute diffs
      * Note this is only call that uses 3-values
      */
-    if ((ret = validate_common(h, db, td, &xret)) < 0)
+    if ((ret = validate_common(h, db, td,
+                               clicon_option_bool(h, "CLICON_VALIDATE_INCREMENTAL"),
+                               &xret)) < 0)
         goto done;
 
     /* If the confirmed-commit feature is enabled, execute phase 2:
@@ -702,7 +1057,7 @@ candidate_commit(clixon_handle  h,
     if (if_feature(yspec, "ietf-netconf", "confirmed-commit")
         && confirmed_commit_state_get(h) != ROLLBACK
         && xe != NULL){
-        if (handle_confirmed_commit(h, xe, myid) < 0)
+        if (handle_confirmed_commit(h, xe, myid, td) < 0)
             goto done;
     }
     if (ret == 0){
@@ -713,35 +1068,692 @@ candidate_commit(clixon_handle  h,
     /* 7. Call plugin transaction commit callbacks */
     if (plugin_transaction_commit_all(h, td) < 0)
         goto done;
-    /* After commit, make a post-commit call (sure that all plugins have committed) */
-    if (plugin_transaction_commit_done_all(h, td) < 0)
+    if (plugin_transaction_pending(td)){
+        if (ids != NULL && nids > 0){
+            if (candidate_commit_park(h, db, ids, nids, td) < 0)
+                goto done;
+            td = NULL;
+            retval = 2;
+            goto done;
+        }
+        if (plugin_transaction_pending_wait(h, td) < 0)
+            goto done;
+    }
+    if (candidate_commit_finish(h, db, td) < 0)
         goto done;
-    /* 8. Success: Copy candidate to running 
-     */
-    if (xmldb_copy(h, db, "running") < 0)
+    retval = 1;
+ done:
+    /* In case of failure (or error), call plugin transaction termination callbacks */
+    if (td){
+        if (retval < 1)
+            plugin_transaction_abort_all(h, td);
+        transaction_free(td);
+    }
+    if (xret)
+        xml_free(xret);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Do a diff between candidate and running, then start a commit transaction
+ *
+ * Pending plugin commits are waited for, see transaction_commit_pending
+ * @param[in]  h          Clixon handle
+ * @param[in]  xe         Request: <rpc><xn></rpc>  (or NULL)
+ * @param[in]  db         A candidate database, not necessarily "candidate"
+ * @param[in]  myid       Client id of triggering incoming message (or 0)
+ * @param[in]  vlev       Validation level (0: full validation) // obsolete
+ * @param[out] cbret      Return xml tree, eg <rpc-reply>..., <rpc-error.. (if retval = 0)
+ * @retval     1          Validation OK       
+ * @retval     0          Validation failed (with cbret set)
+ * @retval    -1          Error - or validation failed 
+ */
+int
+candidate_commit(clixon_handle  h,
+                 cxobj         *xe,
+                 char          *db,
+                 uint32_t       myid,
+                 validate_level vlev, // obsolete
+                 cbuf          *cbret)
+{
+    return candidate_commit1(h, xe, db, myid, NULL, 0, cbret);
+}
+
+/*! Check if a top-level yang node is touched by a direct edit of running
+ *
+ * @param[in]  ys    Top-level yang node
+ * @param[in]  yvec  Yang nodes of top-level elements of the edit, or NULL for all
+ * @param[in]  ylen  Length of yvec
+ * @retval     1     Touched
+ * @retval     0     Not touched
+ */
+static int
+running_direct_touched(yang_stmt  *ys,
+                       yang_stmt **yvec,
+                       int         ylen)
+{
+    int i;
+
+    if (yvec == NULL)
+        return 1;
+    for (i=0; i<ylen; i++)
+        if (yvec[i] == ys)
+            return 1;
+    return 0;
+}
+
+/*! Make a partial copy of running with the top-level elements touched by an edit
+ *
+ * @param[in]  x0    Running cache top
+ * @param[in]  yvec  Yang nodes of touched top-level elements, or NULL for all
+ * @param[in]  ylen  Length of yvec
+ * @param[out] xtp   Copy of x0 with touched top-level elements. Free with xml_free
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+running_direct_copy(cxobj      *x0,
+                    yang_stmt **yvec,
+                    int         ylen,
+                    cxobj     **xtp)
+{
+    int    retval = -1;
+    cxobj *xt = NULL;
+    cxobj *x;
+    cxobj *xc;
+
+    if ((xt = xml_new(xml_name(x0), NULL, CX_ELMNT)) == NULL)
         goto done;
-    xmldb_modified_set(h, db, 0); /* reset dirty bit */
-    /* Here pointers to old (source) tree are obsolete */
-    if (td->td_dvec){
-        td->td_dlen = 0;
-        free(td->td_dvec);
-        td->td_dvec = NULL;
+    if (xml_copy_one(x0, xt) < 0)
+        goto done;
+    x = NULL;
+    while ((x = xml_child_each(x0, x, -1)) != NULL){
+        if (xml_type(x) == CX_ELMNT){
+            if (!running_direct_touched(xml_spec(x), yvec, ylen))
+                continue;
+            if (xml_lazy_load_recurse(x) < 0)
+                goto done;
+        }
+        if ((xc = xml_dup(x)) == NULL)
+            goto done;
+        if (xml_addsub(xt, xc) < 0)
+            goto done;
     }
-    if (td->td_scvec){
-        free(td->td_scvec);
-        td->td_scvec = NULL;
+    *xtp = xt;
+    xt = NULL;
+    retval = 0;
+ done:
+    if (xt)
+        xml_free(xt);
+    return retval;
+}
+
+/*! Move top-level elements not touched by an edit from one tree to another
+ *
+ * Used to lend the untouched part of running to the target tree of a direct commit
+ * for validation, and to give it back afterwards.
+ * @param[in]  xfrom Top of tree to move from
+ * @param[in]  xto   Top of tree to move to
+ * @param[in]  yvec  Yang nodes of touched top-level elements, or NULL for all
+ * @param[in]  ylen  Length of yvec
+ * @param[in]  load  Load lazy subtrees of moved elements
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+running_direct_move(cxobj      *xfrom,
+                    cxobj      *xto,
+                    yang_stmt **yvec,
+                    int         ylen,
+                    int         load)
+{
+    int    retval = -1;
+    int    i;
+    cxobj *x;
+
+    if (yvec == NULL)
+        goto ok;
+    for (i=xml_child_nr(xfrom)-1; i>=0; i--){
+        x = xml_child_i(xfrom, i);
+        if (xml_type(x) != CX_ELMNT ||
+            running_direct_touched(xml_spec(x), yvec, ylen))
+            continue;
+        if (load && xml_lazy_load_recurse(x) < 0)
+            goto done;
+        if (xml_child_rm(xfrom, i) < 0)
+            goto done;
+        if (xml_addsub(xto, x) < 0)
+            goto done;
     }
+    if (xml_sort(xto) < 0)
+        goto done;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
 
-    /* 9. Call plugin transaction end callbacks */
+/*! Restore touched top-level elements of running after a failed direct commit
+ *
+ * @param[in]  h     Clixon handle
+ * @param[in]  x0    Running cache top
+ * @param[in]  xsrc  Partial copy of running before the edit, emptied by the call
+ * @param[in]  yvec  Yang nodes of touched top-level elements, or NULL for all
+ * @param[in]  ylen  Length of yvec
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+running_direct_restore(clixon_handle h,
+                       cxobj        *x0,
+                       cxobj        *xsrc,
+                       yang_stmt   **yvec,
+                       int           ylen)
+{
+    int    retval = -1;
+    int    i;
+    cxobj *x;
+
+    for (i=xml_child_nr(x0)-1; i>=0; i--){
+        x = xml_child_i(x0, i);
+        if (xml_type(x) == CX_ELMNT &&
+            running_direct_touched(xml_spec(x), yvec, ylen))
+            if (xml_purge(x) < 0)
+                goto done;
+    }
+    while ((x = xml_child_each(xsrc, NULL, CX_ELMNT)) != NULL){
+        if (xml_rm(x) < 0)
+            goto done;
+        xml_apply0(x, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset,
+                   (void*)(XML_FLAG_ADD|XML_FLAG_DEL|XML_FLAG_CHANGE));
+        xml_flag_set(x, XML_FLAG_CACHE_DIRTY);
+        if (xml_addsub(x0, x) < 0)
+            goto done;
+    }
+    if (xml_sort(x0) < 0)
+        goto done;
+    if (xmldb_write_cache2file(h, "running") < 0)
+        goto done;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Check if an edit node is copied as a whole subtree to the sparse trees of a direct commit
+ *
+ * Only containers and list entries without operation attribute are descended. A node
+ * with children in a choice or in an ordered-by user list is also copied as a whole,
+ * since the edit may remove or reorder siblings it does not name.
+ * @param[in]  x1    Edit node
+ * @retval     1     Copy the whole subtree
+ * @retval     0     Copy the node with its list keys and descend the edit
+ * @see running_sparse_commit
+ */
+static int
+running_sparse_whole(cxobj *x1)
+{
+    yang_stmt *y;
+    cxobj     *x1c;
+
+    if ((y = xml_spec(x1)) == NULL)
+        return 1;
+    if (yang_keyword_get(y) != Y_CONTAINER && yang_keyword_get(y) != Y_LIST)
+        return 1;
+    if (xml_find_type(x1, NULL, "operation", CX_ATTR) != NULL)
+        return 1;
+    if (xml_child_nr_type(x1, CX_ELMNT) == 0)
+        return 1;
+    x1c = NULL;
+    while ((x1c = xml_child_each(x1, x1c, CX_ELMNT)) != NULL){
+        if ((y = xml_spec(x1c)) == NULL ||
+            yang_choice(y) != NULL ||
+            yang_find(y, Y_ORDERED_BY, "user") != NULL)
+            return 1;
+    }
+    return 0;
+}
+
+/*! Check if an edit node is a key of its parent list entry
+ *
+ * @param[in]  x1    Edit node
+ * @param[in]  x1c   Child of x1
+ * @retval     1     x1c is a key of list entry x1
+ * @retval     0     No
+ */
+static int
+running_sparse_key(cxobj *x1,
+                   cxobj *x1c)
+{
+    yang_stmt *y;
+
+    if ((y = xml_spec(x1)) == NULL || yang_keyword_get(y) != Y_LIST)
+        return 0;
+    return yang_key_match(y, xml_name(x1c), NULL) == 1;
+}
+
+/*! Copy an XML node with its attributes and list keys, but without other children
+ *
+ * @param[in]  x0    XML node
+ * @param[in]  xp    Parent of the copy, or NULL
+ * @param[out] xnp   Copy of x0
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+running_sparse_node(cxobj  *x0,
+                    cxobj  *xp,
+                    cxobj **xnp)
+{
+    int        retval = -1;
+    cxobj     *xn = NULL;
+    cxobj     *x;
+    cxobj     *xc;
+    yang_stmt *y;
+    cg_var    *cvi;
+    int        i;
+
+    if ((xn = xml_new(xml_name(x0), NULL, CX_ELMNT)) == NULL)
+        goto done;
+    if (xml_copy_one(x0, xn) < 0)
+        goto done;
+    /* Attributes are first among the children */
+    for (i=0; i<xml_child_nr_attr(x0); i++){
+        if ((xc = xml_dup(xml_child_i(x0, i))) == NULL)
+            goto done;
+        if (xml_addsub(xn, xc) < 0)
+            goto done;
+    }
+    if ((y = xml_spec(x0)) != NULL && yang_keyword_get(y) == Y_LIST){
+        cvi = NULL;
+        while ((cvi = cvec_each(yang_cvec_get(y), cvi)) != NULL){
+            if ((x = xml_find_type(x0, NULL, cv_string_get(cvi), CX_ELMNT)) == NULL)
+                continue;
+            if ((xc = xml_dup(x)) == NULL)
+                goto done;
+            if (xml_addsub(xn, xc) < 0)
+                goto done;
+        }
+    }
+    if (xp && xml_addsub(xp, xn) < 0)
+        goto done;
+    *xnp = xn;
+    xn = NULL;
+    retval = 0;
+ done:
+    if (xn)
+        xml_free(xn);
+    return retval;
+}
+
+/*! Copy the nodes of running on the paths of an edit, before the edit is applied
+ *
+ * Nodes of running matching edit nodes are looked up by key, and copied as a whole
+ * subtree, marked with XML_FLAG_MARK, or with keys only and descended, see
+ * running_sparse_whole. Nodes that do not exist are not copied.
+ * @param[in]  x0    Node of running
+ * @param[in]  x1    Corresponding edit node
+ * @param[in]  xs    Corresponding node of sparse copy
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+running_sparse_src(cxobj *x0,
+                   cxobj *x1,
+                   cxobj *xs)
+{
+    int    retval = -1;
+    cxobj *x1c;
+    cxobj *x0c;
+    cxobj *xsc;
+
+    if (xml_lazy_load(x0) < 0)
+        goto done;
+    x1c = NULL;
+    while ((x1c = xml_child_each(x1, x1c, CX_ELMNT)) != NULL){
+        if (running_sparse_key(x1, x1c))
+            continue;
+        if (match_base_child(x0, x1c, xml_spec(x1c), &x0c) < 0)
+            goto done;
+        if (x0c == NULL)
+            continue;
+        if (running_sparse_whole(x1c)){
+            if (xml_lazy_load_recurse(x0c) < 0)
+                goto done;
+            if ((xsc = xml_dup(x0c)) == NULL)
+                goto done;
+            if (xml_addsub(xs, xsc) < 0)
+                goto done;
+            xml_flag_set(xsc, XML_FLAG_MARK);
+        }
+        else {
+            if (running_sparse_node(x0c, xs, &xsc) < 0)
+                goto done;
+            if (running_sparse_src(x0c, x1c, xsc) < 0)
+                goto done;
+        }
+    }
+    if (xml_sort(xs) < 0)
+        goto done;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Copy the nodes of running on the paths of an edit, after the edit is applied
+ *
+ * A node is copied as a whole subtree, marked with XML_FLAG_MARK, if it did not exist
+ * before the edit or was copied as a whole then.
+ * @param[in]  x0    Node of running
+ * @param[in]  x1    Corresponding edit node
+ * @param[in]  xsrc  Corresponding node of sparse copy before the edit, or NULL
+ * @param[in]  xs    Corresponding node of sparse copy
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see running_sparse_src
+ */
+static int
+running_sparse_target(cxobj *x0,
+                      cxobj *x1,
+                      cxobj *xsrc,
+                      cxobj *xs)
+{
+    int    retval = -1;
+    cxobj *x1c;
+    cxobj *x0c;
+    cxobj *xsrcc;
+    cxobj *xsc;
+
+    x1c = NULL;
+    while ((x1c = xml_child_each(x1, x1c, CX_ELMNT)) != NULL){
+        if (running_sparse_key(x1, x1c))
+            continue;
+        if (match_base_child(x0, x1c, xml_spec(x1c), &x0c) < 0)
+            goto done;
+        if (x0c == NULL)
+            continue;
+        xsrcc = NULL;
+        if (xsrc && match_base_child(xsrc, x1c, xml_spec(x1c), &xsrcc) < 0)
+            goto done;
+        if (xsrcc == NULL || xml_flag(xsrcc, XML_FLAG_MARK)){
+            if ((xsc = xml_dup(x0c)) == NULL)
+                goto done;
+            if (xml_addsub(xs, xsc) < 0)
+                goto done;
+            xml_flag_set(xsc, XML_FLAG_MARK);
+        }
+        else {
+            if (running_sparse_node(x0c, xs, &xsc) < 0)
+                goto done;
+            if (running_sparse_target(x0c, x1c, xsrcc, xsc) < 0)
+                goto done;
+        }
+    }
+    if (xml_sort(xs) < 0)
+        goto done;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Find the node of running that corresponds to a node of a sparse copy of it
+ *
+ * Match the ancestors of the sparse node one level at a time from the top
+ * @param[in]  x0    Running cache top
+ * @param[in]  xs    Node of sparse copy
+ * @param[out] x0p   Corresponding node of running, or NULL if not found
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+running_sparse_find(cxobj  *x0,
+                    cxobj  *xs,
+                    cxobj **x0p)
+{
+    cxobj *xp;
+
+    *x0p = NULL;
+    if ((xp = xml_parent(xs)) == NULL){
+        *x0p = x0;
+        return 0;
+    }
+    if (running_sparse_find(x0, xp, &xp) < 0)
+        return -1;
+    if (xp == NULL)
+        return 0;
+    return match_base_child(xp, xs, xml_spec(xs), x0p);
+}
+
+/*! Reset diff marks of a sparse direct commit in running
+ *
+ * Only added and changed nodes, and their ancestors, are flagged in running
+ * @param[in]  td    Transaction data, with td_target set to running
+ * @see transaction_mark
+ */
+static void
+running_sparse_unmark(transaction_data_t *td)
+{
+    int    i;
+    cxobj *xn;
+
+    for (i=0; i<td->td_alen; i++){
+        xn = td->td_avec[i];
+        xml_apply0(xn, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset, (void*)XML_FLAG_ADD);
+        xml_apply_ancestor(xn, (xml_applyfn_t*)xml_flag_reset, (void*)XML_FLAG_CHANGE);
+    }
+    for (i=0; i<td->td_clen; i++){
+        xn = td->td_tcvec[i];
+        xml_flag_reset(xn, XML_FLAG_CHANGE);
+        xml_apply_ancestor(xn, (xml_applyfn_t*)xml_flag_reset, (void*)XML_FLAG_CHANGE);
+    }
+}
+
+/*! Restore the nodes of running on the paths of an edit after a failed direct commit
+ *
+ * Nodes copied as a whole are replaced by their copies before the edit, others are
+ * descended.
+ * @param[in]  x0    Node of running
+ * @param[in]  x1    Corresponding edit node
+ * @param[in]  xsrc  Corresponding node of sparse copy before the edit, emptied by the call
+ * @param[in]  xs    Corresponding node of sparse copy after the edit, or NULL
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+running_sparse_restore(cxobj *x0,
+                       cxobj *x1,
+                       cxobj *xsrc,
+                       cxobj *xs)
+{
+    int    retval = -1;
+    cxobj *x1c;
+    cxobj *x0c;
+    cxobj *xsrcc;
+    cxobj *xsc;
+    int    sort = 0;
+
+    x1c = NULL;
+    while ((x1c = xml_child_each(x1, x1c, CX_ELMNT)) != NULL){
+        if (running_sparse_key(x1, x1c))
+            continue;
+        if (match_base_child(x0, x1c, xml_spec(x1c), &x0c) < 0)
+            goto done;
+        xsrcc = NULL;
+        if (xsrc && match_base_child(xsrc, x1c, xml_spec(x1c), &xsrcc) < 0)
+            goto done;
+        xsc = NULL;
+        if (xs && match_base_child(xs, x1c, xml_spec(x1c), &xsc) < 0)
+            goto done;
+        if (x0c && xsrcc && xsc && !xml_flag(xsc, XML_FLAG_MARK)){
+            if (running_sparse_restore(x0c, x1c, xsrcc, xsc) < 0)
+                goto done;
+            continue;
+        }
+        if (x0c && xml_purge(x0c) < 0)
+            goto done;
+        if (xsrcc){
+            if (xml_rm(xsrcc) < 0)
+                goto done;
+            xml_apply0(xsrcc, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset,
+                       (void*)(XML_FLAG_ADD|XML_FLAG_DEL|XML_FLAG_CHANGE|XML_FLAG_MARK));
+            xml_flag_set(xsrcc, XML_FLAG_CACHE_DIRTY);
+            if (xml_addsub(x0, xsrcc) < 0)
+                goto done;
+            sort++;
+        }
+        xml_flag_set(x0, XML_FLAG_CACHE_DIRTY);
+        xml_apply_ancestor(x0, (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_CACHE_DIRTY);
+    }
+    if (sort && xml_sort(x0) < 0)
+        goto done;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Apply an edit directly to running as a commit transaction, diffing the edit paths only
+ *
+ * As running_direct_commit, but instead of copying the touched top-level elements, only
+ * the nodes of running on the paths of the edit are copied, before and after the edit,
+ * looked up by key. The diff of the copies is moved to running, which is the target tree
+ * of the transaction. The cost is thereby proportional to the depth of the edit and the
+ * logarithm of the size of the lists it descends, not the size of the lists.
+ * @param[in]  h         Clixon handle
+ * @param[in]  x0        Running cache top
+ * @param[in]  xc        Edit, <config> of edit-config bound to yang and sorted
+ * @param[in]  op        Default operation, not replace
+ * @param[in]  username  User name for NACM
+ * @param[out] cbret     Error reply if retval is 0
+ * @retval     1         OK
+ * @retval     0         Edit or validation failed (with cbret set)
+ * @retval    -1         Error
+ * @note transaction_src() only contains the paths of the edit, transaction_target() is
+ *       running and must not be modified by plugins
+ * @note Nodes of running removed as a side-effect of the edit outside its paths are not
+ *       in the diff
+ * @see CLICON_XMLDB_RUNNING_DIRECT_SPARSE
+ */
+static int
+running_sparse_commit(clixon_handle       h,
+                      cxobj              *x0,
+                      cxobj              *xc,
+                      enum operation_type op,
+                      char               *username,
+                      cbuf               *cbret)
+{
+    int                 retval = -1;
+    transaction_data_t *td = NULL;
+    yang_stmt          *yspec;
+    cxobj              *xs = NULL;
+    cxobj              *xret = NULL;
+    cxobj             **vec;
+    int                 len;
+    int                 i;
+    int                 j;
+    int                 marked = 0;
+    int                 ret;
+
+    clixon_debug(CLIXON_DBG_BACKEND, "");
+    if ((yspec = clicon_dbspec_yang(h)) == NULL){
+        clixon_err(OE_FATAL, 0, "No DB_SPEC");
+        goto done;
+    }
+    /* 1. Start transaction */
+    if ((td = transaction_new()) == NULL)
+        goto done;
+    /* 2. This is the state we are going from, on the edit paths */
+    if (running_sparse_node(x0, NULL, &td->td_src) < 0)
+        goto done;
+    if (running_sparse_src(x0, xc, td->td_src) < 0)
+        goto done;
+    /* 3. Apply edit in place */
+    if ((ret = xmldb_put(h, "running", op, xc, username, cbret)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
+    if ((x0 = xmldb_cache_get(h, "running")) == NULL){
+        clixon_err(OE_DB, ENOENT, "No running cache");
+        goto done;
+    }
+    /* This is the state we are going to, on the edit paths */
+    if (running_sparse_node(x0, NULL, &xs) < 0)
+        goto done;
+    if (running_sparse_target(x0, xc, td->td_src, xs) < 0)
+        goto done;
+    xml_apply0(td->td_src, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset, (void*)XML_FLAG_MARK);
+    /* 4. Compute differences of the edit paths */
+    if (xml_diff(td->td_src,
+                 xs,
+                 &td->td_dvec,      /* removed */
+                 &td->td_dlen,
+                 &td->td_avec,      /* added */
+                 &td->td_alen,
+                 &td->td_scvec,     /* changed: original values */
+                 &td->td_tcvec,     /* changed: wanted values */
+                 &td->td_clen) < 0)
+        goto done;
+    /* Added and changed nodes refer to running, which is the target */
+    for (j=0; j<2; j++){
+        vec = j ? td->td_tcvec : td->td_avec;
+        len = j ? td->td_clen : td->td_alen;
+        for (i=0; i<len; i++){
+            if (running_sparse_find(x0, vec[i], &vec[i]) < 0)
+                goto done;
+            if (vec[i] == NULL){
+                clixon_err(OE_XML, ENOENT, "Changed node not found in running");
+                goto done;
+            }
+        }
+    }
+    td->td_target = x0;
+    if (clixon_debug_get() & CLIXON_DBG_DETAIL)
+        transaction_dbg(h, CLIXON_DBG_DETAIL, td, __FUNCTION__);
+    transaction_mark(td);
+    marked++;
+    if ((ret = transaction_validate(h, yspec, td,
+                                    clicon_option_bool(h, "CLICON_VALIDATE_INCREMENTAL"),
+                                    &xret)) < 0)
+        goto done;
+    if (ret == 0){
+        if (clixon_xml2cbuf(cbret, xret, 0, 0, NULL, -1, 0) < 0)
+            goto done;
+        goto fail;
+    }
+    /* 5. Call plugin transaction commit callbacks */
+    if (plugin_transaction_commit_all(h, td) < 0)
+        goto done;
+    if (plugin_transaction_pending(td) &&
+        plugin_transaction_pending_wait(h, td) < 0)
+        goto done;
+    if (plugin_transaction_commit_done_all(h, td) < 0)
+        goto done;
+    /* 6. Call plugin transaction end callbacks */
     plugin_transaction_end_all(h, td);
     retval = 1;
  done:
-    /* In case of failure (or error), call plugin transaction termination callbacks */
     if (td){
-        if (retval < 1)
+        if (marked)
+            running_sparse_unmark(td);
+        td->td_target = NULL; /* Running cache is not freed */
+        if (retval < 1){
             plugin_transaction_abort_all(h, td);
+            if (td->td_src &&
+                (x0 = xmldb_cache_get(h, "running")) != NULL){
+                /* Edit failed: which nodes were copied as a whole is also needed */
+                if (xs == NULL &&
+                    (running_sparse_node(x0, NULL, &xs) < 0 ||
+                     running_sparse_target(x0, xc, td->td_src, xs) < 0))
+                    retval = -1;
+                else if (running_sparse_restore(x0, xc, td->td_src, xs) < 0 ||
+                         xmldb_write_cache2file(h, "running") < 0)
+                    retval = -1;
+            }
+        }
         transaction_free(td);
     }
+    if (xs)
+        xml_free(xs);
     if (xret)
         xml_free(xret);
     return retval;
@@ -750,6 +1762,381 @@ candidate_commit(clixon_handle  h,
     goto done;
 }
 
+/*! Apply an edit directly to running as a commit transaction
+ *
+ * Fast-path of edit-config with running as target, without a candidate round-trip:
+ * the edit is applied in place to the running cache, and only the top-level elements
+ * touched by the edit are diffed. Untouched top-level elements are moved into the
+ * target tree during validation and commit, and are not copied.
+ * If validation or commit fails, the touched elements of running are restored.
+ * @param[in]  h         Clixon handle
+ * @param[in]  xc        Edit, <config> of edit-config bound to yang and sorted
+ * @param[in]  op        Default operation
+ * @param[in]  username  User name for NACM
+ * @param[out] cbret     Error reply if retval is 0
+ * @retval     1         OK
+ * @retval     0         Edit or validation failed (with cbret set)
+ * @retval    -1         Error
+ * @note transaction_src() only contains the top-level elements touched by the edit
+ * @see CLICON_XMLDB_RUNNING_DIRECT
+ * @see running_sparse_commit  If CLICON_XMLDB_RUNNING_DIRECT_SPARSE is set
+ */
+int
+running_direct_commit(clixon_handle       h,
+                      cxobj              *xc,
+                      enum operation_type op,
+                      char               *username,
+                      cbuf               *cbret)
+{
+    int                 retval = -1;
+    transaction_data_t *td = NULL;
+    yang_stmt          *yspec;
+    yang_stmt         **yvec = NULL;
+    int                 ylen = 0;
+    cxobj              *x0 = NULL;
+    cxobj              *x;
+    cxobj              *xret = NULL;
+    int                 moved = 0;
+    int                 sparse;
+    int                 ret;
+
+    clixon_debug(CLIXON_DBG_BACKEND, "");
+    if ((yspec = clicon_dbspec_yang(h)) == NULL){
+        clixon_err(OE_FATAL, 0, "No DB_SPEC");
+        goto done;
+    }
+    /* Ensure running is in cache */
+    if (xmldb_cache_get(h, "running") == NULL){
+        if ((ret = xmldb_get0(h, "running", YB_MODULE, NULL, "/", 1, 0, &x, NULL, &xret)) < 0)
+            goto done;
+        if (ret == 0){
+            if (clixon_xml2cbuf(cbret, xret, 0, 0, NULL, -1, 0) < 0)
+                goto done;
+            goto fail;
+        }
+        xml_free(x);
+    }
+    if ((x0 = xmldb_cache_get(h, "running")) == NULL){
+        clixon_err(OE_DB, ENOENT, "No running cache");
+        goto done;
+    }
+    /* Top-level yang nodes touched by the edit, all if replace */
+    sparse = clicon_option_bool(h, "CLICON_XMLDB_RUNNING_DIRECT_SPARSE");
+    if (op != OP_REPLACE){
+        if ((yvec = calloc(xml_child_nr_type(xc, CX_ELMNT) + 1, sizeof(yang_stmt*))) == NULL){
+            clixon_err(OE_UNIX, errno, "calloc");
+            goto done;
+        }
+        x = NULL;
+        while ((x = xml_child_each(xc, x, CX_ELMNT)) != NULL){
+            if (xml_spec(x) == NULL){
+                free(yvec);
+                yvec = NULL;
+                break;
+            }
+            if (yang_choice(xml_spec(x)) != NULL)
+                sparse = 0;
+            if (!running_direct_touched(xml_spec(x), yvec, ylen))
+                yvec[ylen++] = xml_spec(x);
+        }
+    }
+    /* Only diff the paths of the edit */
+    if (sparse && yvec != NULL){
+        retval = running_sparse_commit(h, x0, xc, op, username, cbret);
+        goto done;
+    }
+    /* 1. Start transaction */
+    if ((td = transaction_new()) == NULL)
+        goto done;
+    /* 2. This is the state we are going from */
+    if (running_direct_copy(x0, yvec, ylen, &td->td_src) < 0)
+        goto done;
+    /* 3. Apply edit in place */
+    if ((ret = xmldb_put(h, "running", op, xc, username, cbret)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
+    if ((x0 = xmldb_cache_get(h, "running")) == NULL){
+        clixon_err(OE_DB, ENOENT, "No running cache");
+        goto done;
+    }
+    /* This is the state we are going to */
+    if (running_direct_copy(x0, yvec, ylen, &td->td_target) < 0)
+        goto done;
+    /* 4. Compute differences of touched parts only */
+    if (xml_diff(td->td_src,
+                 td->td_target,
+                 &td->td_dvec,      /* removed */
+                 &td->td_dlen,
+                 &td->td_avec,      /* added */
+                 &td->td_alen,
+                 &td->td_scvec,     /* changed: original values */
+                 &td->td_tcvec,     /* changed: wanted values */
+                 &td->td_clen) < 0)
+        goto done;
+    if (clixon_debug_get() & CLIXON_DBG_DETAIL)
+        transaction_dbg(h, CLIXON_DBG_DETAIL, td, __FUNCTION__);
+    transaction_mark(td);
+    /* Lend untouched parts of running to target for validation, eg leafrefs */
+    if (running_direct_move(x0, td->td_target, yvec, ylen,
+                            clicon_option_bool(h, "CLICON_XMLDB_MULTI_LAZY")) < 0)
+        goto done;
+    moved++;
+    if ((ret = transaction_validate(h, yspec, td,
+                                    clicon_option_bool(h, "CLICON_VALIDATE_INCREMENTAL"),
+                                    &xret)) < 0)
+        goto done;
+    if (ret == 0){
+        if (clixon_xml2cbuf(cbret, xret, 0, 0, NULL, -1, 0) < 0)
+            goto done;
+        goto fail;
+    }
+    /* 5. Call plugin transaction commit callbacks */
+    if (plugin_transaction_commit_all(h, td) < 0)
+        goto done;
+    if (plugin_transaction_pending(td) &&
+        plugin_transaction_pending_wait(h, td) < 0)
+        goto done;
+    if (plugin_transaction_commit_done_all(h, td) < 0)
+        goto done;
+    /* 6. Call plugin transaction end callbacks */
+    plugin_transaction_end_all(h, td);
+    retval = 1;
+ done:
+    if (td){
+        if (moved && running_direct_move(td->td_target, x0, yvec, ylen, 0) < 0)
+            retval = -1;
+        if (retval < 1){
+            plugin_transaction_abort_all(h, td);
+            if (td->td_src &&
+                xmldb_cache_unshare(h, "running") == 0 &&
+                (x0 = xmldb_cache_get(h, "running")) != NULL &&
+                running_direct_restore(h, x0, td->td_src, yvec, ylen) < 0)
+                retval = -1;
+        }
+        transaction_free(td);
+    }
+    if (yvec)
+        free(yvec);
+    if (xret)
+        xml_free(xret);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Replace top-level elements of running with a copy of the primary running
+ *
+ * Used by read-only replicas: the data is already validated and committed by the primary,
+ * and is not validated again. Plugin transaction callbacks are not called, but the change
+ * is stamped and sent to on-change subscriptions of the replica.
+ * @param[in]  h     Clixon handle
+ * @param[in]  xt    Top-level elements of running of the primary, bound to yang and
+ *                   sorted, emptied by the call
+ * @param[in]  yvec  Yang nodes of top-level elements to replace, or NULL for all
+ * @param[in]  ylen  Length of yvec
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see backend_replica_init
+ */
+int
+running_replica_apply(clixon_handle h,
+                      cxobj        *xt,
+                      yang_stmt   **yvec,
+                      int           ylen)
+{
+    int                 retval = -1;
+    transaction_data_t *td = NULL;
+    cxobj              *x0;
+    cxobj              *x;
+    cxobj              *xret = NULL;
+    db_elmnt           *de;
+    int                 ret;
+
+    clixon_debug(CLIXON_DBG_BACKEND, "");
+    /* Ensure running is in cache */
+    if (xmldb_cache_get(h, "running") == NULL){
+        if ((ret = xmldb_get0(h, "running", YB_MODULE, NULL, "/", 1, 0, &x, NULL, &xret)) < 0)
+            goto done;
+        if (ret == 0){
+            clixon_err_netconf(h, OE_DB, 0, xret, "Replica running");
+            goto done;
+        }
+        xml_free(x);
+    }
+    /* Cache may be shared with another datastore, see CLICON_XMLDB_COPY_ON_WRITE */
+    if (xmldb_cache_unshare(h, "running") < 0)
+        goto done;
+    if ((x0 = xmldb_cache_get(h, "running")) == NULL){
+        clixon_err(OE_DB, ENOENT, "No running cache");
+        goto done;
+    }
+    if ((td = transaction_new()) == NULL)
+        goto done;
+    if (running_direct_copy(x0, yvec, ylen, &td->td_src) < 0)
+        goto done;
+    if (running_direct_copy(xt, NULL, 0, &td->td_target) < 0)
+        goto done;
+    if (xml_diff(td->td_src,
+                 td->td_target,
+                 &td->td_dvec,      /* removed */
+                 &td->td_dlen,
+                 &td->td_avec,      /* added */
+                 &td->td_alen,
+                 &td->td_scvec,     /* changed: original values */
+                 &td->td_tcvec,     /* changed: wanted values */
+                 &td->td_clen) < 0)
+        goto done;
+    if (td->td_dlen == 0 && td->td_alen == 0 && td->td_clen == 0)
+        goto ok;
+    if (clixon_debug_get() & CLIXON_DBG_DETAIL)
+        transaction_dbg(h, CLIXON_DBG_DETAIL, td, __FUNCTION__);
+    transaction_mark(td);
+    if (backend_stamp_mark(h, td) < 0)
+        goto done;
+    if (backend_push_commit(h, td) < 0)
+        goto done;
+    /* Swap in the elements of the primary and write running */
+    if (running_direct_restore(h, x0, xt, yvec, ylen) < 0)
+        goto done;
+    if ((de = clicon_db_elmnt_get(h, "running")) != NULL)
+        de->de_epoch++;
+    if (xmldb_edited_invalidate(h, "running") < 0)
+        goto done;
+    if (backend_stamp_commit(h) < 0)
+        goto done;
+ ok:
+    retval = 0;
+ done:
+    if (td)
+        transaction_free(td);
+    if (xret)
+        xml_free(xret);
+    return retval;
+}
+
+static int commit_group_timeout(int fd, void *arg);
+
+/*! Register group commit timer
+ *
+ * @param[in]  h       Clixon handle
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @see CLICON_COMMIT_GROUP_WINDOW
+ */
+static int
+commit_group_timer_reg(clixon_handle h)
+{
+    struct timeval now;
+    struct timeval t;
+    struct timeval t1 = {0,};
+    uint32_t       ms;
+
+    ms = clicon_option_int(h, "CLICON_COMMIT_GROUP_WINDOW");
+    t1.tv_sec = ms/1000;
+    t1.tv_usec = (ms%1000)*1000;
+    gettimeofday(&now, NULL);
+    timeradd(&now, &t1, &t);
+    return clixon_event_reg_timeout(t, commit_group_timeout, h, "group commit");
+}
+
+/*! Group commit timer: commit candidate once for all commit requests of the group
+ *
+ * The group is delayed while a commit is parked. All clients get the same reply.
+ * @param[in]  fd   Not used
+ * @param[in]  arg  Clixon handle
+ * @retval     0    OK
+ * @retval    -1    Error (fatal)
+ */
+static int
+commit_group_timeout(int   fd,
+                     void *arg)
+{
+    int            retval = -1;
+    clixon_handle  h = (clixon_handle)arg;
+    uint32_t      *ids = NULL;
+    int            nids;
+    cbuf          *cbret = NULL;
+    uint32_t       iddb;
+    int            ret;
+    int            i;
+
+    if (_commit_pending != NULL){ /* A commit is in progress, wait */
+        if (commit_group_timer_reg(h) < 0)
+            goto done;
+        goto ok;
+    }
+    ids = _commit_group;
+    nids = _commit_group_len;
+    _commit_group = NULL;
+    _commit_group_len = 0;
+    if (nids == 0)
+        goto ok;
+    clixon_debug(CLIXON_DBG_BACKEND, "group commit of %d sessions", nids);
+    if ((cbret = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    /* Datastores may have been locked by another client since the commits arrived */
+    if ((iddb = xmldb_islocked(h, "candidate")) == 0)
+        iddb = xmldb_islocked(h, "running");
+    for (i = 0; iddb && i < nids; i++)
+        if (ids[i] == iddb)
+            break;
+    clixon_err_reset();
+    if (iddb && i == nids){
+        if (netconf_in_use(cbret, "protocol", "Operation failed, lock is already held") < 0)
+            goto done;
+    }
+    else if ((ret = candidate_commit1(h, NULL, "candidate", ids[0], ids, nids, cbret)) < 0){
+        clixon_debug(CLIXON_DBG_BACKEND, "Group commit failed");
+        if (netconf_operation_failed(cbret, "application", clixon_err_reason())< 0)
+            goto done;
+    }
+    else if (ret == 2) /* Plugin commits pending, replies when completed */
+        goto ok;
+    else if (ret == 1)
+        cprintf(cbret, "<rpc-reply xmlns=\"%s\"><ok/></rpc-reply>", NETCONF_BASE_NAMESPACE);
+    for (i = 0; i < nids; i++)
+        if (backend_client_reply_deferred(h, ids[i], cbret) < 0)
+            goto done;
+ ok:
+    retval = 0;
+ done:
+    if (ids)
+        free(ids);
+    if (cbret)
+        cbuf_free(cbret);
+    return retval;
+}
+
+/*! Add a commit request to the group commit, the reply is deferred until the group is committed
+ *
+ * @param[in]  h       Clixon handle
+ * @param[in]  ce      Client entry
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+commit_group_add(clixon_handle        h,
+                 struct client_entry *ce)
+{
+    uint32_t *ids;
+
+    if ((ids = realloc(_commit_group, (_commit_group_len+1)*sizeof(*ids))) == NULL){
+        clixon_err(OE_UNIX, errno, "realloc");
+        return -1;
+    }
+    _commit_group = ids;
+    if (backend_client_defer(ce) < 0)
+        return -1;
+    _commit_group[_commit_group_len++] = ce->ce_id;
+    if (_commit_group_len == 1 && commit_group_timer_reg(h) < 0)
+        return -1;
+    return 0;
+}
+
 /*! Commit the candidate configuration as the device's new current configuration
  *
  * @param[in]  h       Clixon handle
@@ -791,6 +2178,9 @@ from_client_commit(clixon_handle h,
     cbuf                *cbx = NULL; /* Assist cbuf */
     int                  ret;
     yang_stmt           *yspec;
+    int                  group;
+    char                *db;
+    char                *conflict = NULL;
 
     if ((yspec = clicon_dbspec_yang(h)) == NULL) {
         clixon_err(OE_YANG, ENOENT, "No yang spec");
@@ -802,9 +2192,14 @@ from_client_commit(clixon_handle h,
         if (ret == 0)
             goto ok;
     }
-    /* Check if target locked by other client */
+    /* Group commit, not of commits with confirmed-commit parameters or private candidates */
+    group = clicon_option_int(h, "CLICON_COMMIT_GROUP_WINDOW") > 0 &&
+        !clicon_option_bool(h, "CLICON_AUTOLOCK") &&
+        !clicon_option_bool(h, "CLICON_XMLDB_PRIVATE_CANDIDATE") &&
+        xml_child_nr_type(xe, CX_ELMNT) == 0;
+    /* Check if target locked by other client, a grouped commit waits for a parked commit */
     iddb = xmldb_islocked(h, "candidate");
-    if (iddb && myid != iddb){
+    if (iddb && myid != iddb && !(group && commit_pending_lock(iddb))){
         if ((cbx = cbuf_new()) == NULL){
             clixon_err(OE_XML, errno, "cbuf_new");
             goto done;
@@ -814,7 +2209,7 @@ from_client_commit(clixon_handle h,
         goto ok;
     }
     iddb = xmldb_islocked(h, "running");
-    if (iddb && myid != iddb){
+    if (iddb && myid != iddb && !(group && commit_pending_lock(iddb))){
         if ((cbx = cbuf_new()) == NULL){
             clixon_err(OE_XML, errno, "cbuf_new");
             goto done;
@@ -823,22 +2218,57 @@ from_client_commit(clixon_handle h,
             goto done;
         goto ok;
     }
-    if ((ret = candidate_commit(h, xe, "candidate", myid, 0, cbret)) < 0){ /* Assume validation fail, nofatal */
+    if ((db = backend_candidate_db(h, ce, "candidate")) == NULL)
+        goto done;
+    if (strcmp(db, "candidate") != 0){
+        /* Private candidate: keep changes committed by others since fork */
+        if ((ret = xmldb_rebase(h, db, ce->ce_candidate_base, "running", &conflict)) < 0)
+            goto done;
+        if (ret == 0){
+            if ((cbx = cbuf_new()) == NULL){
+                clixon_err(OE_XML, errno, "cbuf_new");
+                goto done;
+            }
+            cprintf(cbx, "Commit conflict with running at %s", conflict ? conflict : "/");
+            if (netconf_operation_failed(cbret, "application", cbuf_get(cbx)) < 0)
+                goto done;
+            goto ok;
+        }
+    }
+    if (group){ /* Reply when group is committed */
+        if (commit_group_add(h, ce) < 0)
+            goto done;
+        goto ok;
+    }
+    if ((ret = candidate_commit1(h, xe, db, myid, &myid, 1, cbret)) < 0){ /* Assume validation fail, nofatal */
         clixon_debug(CLIXON_DBG_BACKEND, "Commit candidate failed");
         if (ret < 0)
             if (netconf_operation_failed(cbret, "application", clixon_err_reason())< 0)
                 goto done;
         goto ok;
     }
-    if (clicon_option_bool(h, "CLICON_AUTOLOCK"))
+    if (ret == 2){ /* Plugin commits pending, reply when completed */
+        if (backend_client_defer(ce) < 0)
+            goto done;
+        goto ok;
+    }
+    if (clicon_option_bool(h, "CLICON_AUTOLOCK")){
         xmldb_unlock(h, "candidate");
+        if (backend_lock_wait_wake(h, "candidate") < 0)
+            goto done;
+    }
     if (ret == 0)
         clixon_debug(CLIXON_DBG_BACKEND, "Commit candidate failed");
-    else
+    else {
+        if (backend_candidate_reset(h, ce) < 0)
+            goto done;
         cprintf(cbret, "<rpc-reply xmlns=\"%s\"><ok/></rpc-reply>", NETCONF_BASE_NAMESPACE);
+    }
  ok:
     retval = 0;
  done:
+    if (conflict)
+        free(conflict);
     if (cbx)
         cbuf_free(cbx);
     return retval; /* may be zero if we ignoring errors from commit */
@@ -867,6 +2297,7 @@ from_client_discard_changes(clixon_handle h,
     uint32_t             myid = ce->ce_id;
     uint32_t             iddb;
     cbuf                *cbx = NULL; /* Assist cbuf */
+    char                *db;
 
     /* Check if target locked by other client */
     iddb = xmldb_islocked(h, "candidate");
@@ -880,14 +2311,24 @@ from_client_discard_changes(clixon_handle h,
             goto done;
         goto ok;
     }
-    if (xmldb_copy(h, "running", "candidate") < 0){
+    if ((db = backend_candidate_db(h, ce, "candidate")) == NULL)
+        goto done;
+    if (strcmp(db, "candidate") != 0){ /* Private candidate */
+        if (backend_candidate_reset(h, ce) < 0)
+            goto done;
+    }
+    else if (xmldb_copy(h, "running", "candidate") < 0){
         if (netconf_operation_failed(cbret, "application", clixon_err_reason())< 0)
             goto done;
         goto ok;
     }
-    xmldb_modified_set(h, "candidate", 0); /* reset dirty bit */
+    xmldb_modified_set(h, db, 0); /* reset dirty bit */
+    if (backend_stamp_edit(h, db, NULL) < 0)
+        goto done;
     if (clicon_option_bool(h, "CLICON_AUTOLOCK")){
         xmldb_unlock(h, "candidate");
+        if (backend_lock_wait_wake(h, "candidate") < 0)
+            goto done;
     }
     cprintf(cbret, "<rpc-reply xmlns=\"%s\"><ok/></rpc-reply>", NETCONF_BASE_NAMESPACE);
  ok:
@@ -916,9 +2357,10 @@ from_client_validate(clixon_handle h,
                      void         *arg,
                      void         *regarg)
 {
-    int   retval = -1;
-    int   ret;
-    char *db;
+    int                  retval = -1;
+    struct client_entry *ce = (struct client_entry *)arg;
+    int                  ret;
+    char                *db;
 
     clixon_debug(CLIXON_DBG_BACKEND, "");
     if ((db = netconf_db_find(xe, "source")) == NULL){
@@ -926,6 +2368,8 @@ from_client_validate(clixon_handle h,
             goto done;
         goto ok;
     }
+    if ((db = backend_candidate_db(h, ce, db)) == NULL)
+        goto done;
     if ((ret = candidate_validate(h, db, cbret)) < 0)
         goto done;
     if (ret == 1)
@@ -1027,7 +2471,7 @@ from_client_restart_one(clixon_handle    h,
         goto fail;
     /* Make generic validation on all new or changed data.
        Note this is only call that uses 3-values */
-    if ((ret = generic_validate(h, yspec, td, &xerr)) < 0)
+    if ((ret = generic_validate(h, yspec, td, 0, &xerr)) < 0)
         goto done;
     if (ret == 0){
         if (clixon_xml2cbuf(cbret, xerr, 0, 0, NULL, -1, 0) < 0)
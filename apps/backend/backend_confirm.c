@@ -293,6 +293,747 @@ xe_timeout(cxobj *xe)
     return 0;
 }
 
+/*! Copy the path from a top of tree down to a node into another tree
+ *
+ * Ancestors are copied one level with attributes and list keys, leafs and leaf-lists
+ * are copied with their body.
+ * @param[in]  x0t   Top of original tree
+ * @param[in]  x0    Orig node (go up from this until = x0t)
+ * @param[in]  x1t   New tree
+ * @param[out] x1pp  Copy of x0 in new tree
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see xml_copy_bottom_recurse  in datastore read
+ */
+static int
+rollback_diff_path(cxobj  *x0t,
+                   cxobj  *x0,
+                   cxobj  *x1t,
+                   cxobj **x1pp)
+{
+    int        retval = -1;
+    cxobj     *x0p;
+    cxobj     *x1p = NULL;
+    cxobj     *x1 = NULL;
+    cxobj     *x0a;
+    cxobj     *x1a;
+    cxobj     *x0k;
+    yang_stmt *y;
+    cvec      *cvk;
+    cg_var    *cvi;
+
+    if (x0 == x0t){
+        *x1pp = x1t;
+        goto ok;
+    }
+    if ((x0p = xml_parent(x0)) == NULL){
+        clixon_err(OE_XML, EFAULT, "Reached top of tree");
+        goto done;
+    }
+    if (rollback_diff_path(x0t, x0p, x1t, &x1p) < 0)
+        goto done;
+    y = xml_spec(x0);
+    if (match_base_child(x1p, x0, y, &x1) < 0)
+        goto done;
+    if (x1 == NULL){
+        if (y && (yang_keyword_get(y) == Y_LEAF || yang_keyword_get(y) == Y_LEAF_LIST)){
+            if ((x1 = xml_dup(x0)) == NULL)
+                goto done;
+            if (xml_addsub(x1p, x1) < 0){
+                xml_free(x1);
+                goto done;
+            }
+        }
+        else {
+            if ((x1 = xml_new(xml_name(x0), x1p, CX_ELMNT)) == NULL)
+                goto done;
+            if (xml_copy_one(x0, x1) < 0)
+                goto done;
+            x0a = NULL;
+            while ((x0a = xml_child_each(x0, x0a, CX_ATTR)) != NULL) {
+                if ((x1a = xml_new(xml_name(x0a), x1, CX_ATTR)) == NULL)
+                    goto done;
+                if (xml_copy_one(x0a, x1a) < 0)
+                    goto done;
+            }
+            if (y && yang_keyword_get(y) == Y_LIST){
+                cvk = yang_cvec_get(y);
+                cvi = NULL;
+                while ((cvi = cvec_each(cvk, cvi)) != NULL) {
+                    if ((x0k = xml_find_type(x0, NULL, cv_string_get(cvi), CX_ELMNT)) == NULL)
+                        continue;
+                    if ((x1a = xml_dup(x0k)) == NULL)
+                        goto done;
+                    if (xml_addsub(x1, x1a) < 0){
+                        xml_free(x1a);
+                        goto done;
+                    }
+                }
+            }
+        }
+        if (xml_sort(x1p) < 0)
+            goto done;
+    }
+    *x1pp = x1;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Find the node in another tree with the same path as a node
+ *
+ * @param[in]  x0t   Top of original tree
+ * @param[in]  x0    Orig node (go up from this until = x0t)
+ * @param[in]  x1t   Other tree
+ * @param[out] x1pp  Node in other tree, or NULL if not found
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+rollback_diff_match(cxobj  *x0t,
+                    cxobj  *x0,
+                    cxobj  *x1t,
+                    cxobj **x1pp)
+{
+    int    retval = -1;
+    cxobj *x1p = NULL;
+
+    *x1pp = NULL;
+    if (x0 == x0t){
+        *x1pp = x1t;
+        goto ok;
+    }
+    if (xml_parent(x0) == NULL)
+        goto ok;
+    if (rollback_diff_match(x0t, xml_parent(x0), x1t, &x1p) < 0)
+        goto done;
+    if (x1p && match_base_child(x1p, x0, xml_spec(x0), x1pp) < 0)
+        goto done;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Check if a node or any of its ancestors is part of an ordered-by user list already in the diff
+ *
+ * @param[in]  xt  Top of tree
+ * @param[in]  x   Node
+ * @retval     1   Yes, covered by ordered-by user list
+ * @retval     0   No
+ */
+static int
+rollback_diff_marked(cxobj *xt,
+                     cxobj *x)
+{
+    while (x && x != xt){
+        if (xml_flag(x, XML_FLAG_MARK))
+            return 1;
+        x = xml_parent(x);
+    }
+    return 0;
+}
+
+/*! Add yang:insert position of an ordered-by user entry relative to previous entry
+ *
+ * @param[in]  x     Entry in reverse diff
+ * @param[in]  y     Yang of list or leaf-list
+ * @param[in]  prev  Previous entry in original tree, or NULL if first
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see RFC 7950 Sec 7.7.9 and 7.8.6
+ */
+static int
+rollback_diff_insert(cxobj     *x,
+                     yang_stmt *y,
+                     cxobj     *prev)
+{
+    int     retval = -1;
+    cbuf   *cb = NULL;
+    cvec   *cvk;
+    cg_var *cvi;
+    char   *prefix;
+    char   *ns = NULL;
+    char   *val;
+    char    q;
+
+    if (xml_add_attr(x, "insert", prev?"after":"first", "yang", YANG_XML_NAMESPACE) == NULL)
+        goto done;
+    if (prev == NULL)
+        goto ok;
+    if (yang_keyword_get(y) == Y_LEAF_LIST){
+        if (xml_add_attr(x, "value", xml_body(prev), "yang", YANG_XML_NAMESPACE) == NULL)
+            goto done;
+        goto ok;
+    }
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    /* Key predicates are prefixed with the module prefix of the list */
+    prefix = yang_find_myprefix(y);
+    if (xml2ns(x, prefix, &ns) < 0)
+        goto done;
+    if (ns == NULL &&
+        xmlns_set(x, prefix, yang_find_mynamespace(y)) < 0)
+        goto done;
+    cvk = yang_cvec_get(y);
+    cvi = NULL;
+    while ((cvi = cvec_each(cvk, cvi)) != NULL) {
+        if ((val = xml_find_body(prev, cv_string_get(cvi))) == NULL)
+            val = "";
+        q = strchr(val, '\'') ? '"' : '\'';
+        cprintf(cb, "[%s:%s=%c%s%c]", prefix, cv_string_get(cvi), q, val, q);
+    }
+    if (xml_add_attr(x, "key", cbuf_get(cb), "yang", YANG_XML_NAMESPACE) == NULL)
+        goto done;
+ ok:
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Add reverse diff of an ordered-by user list or leaf-list with added or deleted entries
+ *
+ * The diff of an ordered-by user list marks the entries after the first difference
+ * as deleted and added. Positions can not be restored from these entries only, instead
+ * all original entries are replaced in order with yang:insert and entries not in the
+ * original are removed.
+ * Entries of the list in both trees are marked with XML_FLAG_MARK and their
+ * parents added to xvec.
+ * @param[in]  td    Transaction data with computed diff
+ * @param[in]  x0t   Top of tree of x0, src or target of td
+ * @param[in]  x0    Added (in target) or deleted (in src) node
+ * @param[in]  xc    Reverse diff
+ * @param[in]  xvec  Parents of marked entries
+ * @retval     1     OK, list added to reverse diff
+ * @retval     0     Not an ordered-by user list or leaf-list
+ * @retval    -1     Error
+ */
+static int
+rollback_diff_ordered(transaction_data_t *td,
+                      cxobj              *x0t,
+                      cxobj              *x0,
+                      cxobj              *xc,
+                      clixon_xvec        *xvec)
+{
+    int        retval = -1;
+    yang_stmt *y;
+    cxobj     *xsp = NULL; /* Parent in src */
+    cxobj     *xtp = NULL; /* Parent in target */
+    cxobj     *xp = NULL;  /* Parent in reverse diff */
+    cxobj     *xs;
+    cxobj     *xt;
+    cxobj     *xprev;
+    cxobj     *x1;
+    int        i;
+
+    if ((y = xml_spec(x0)) == NULL ||
+        (yang_keyword_get(y) != Y_LIST && yang_keyword_get(y) != Y_LEAF_LIST) ||
+        yang_find(y, Y_ORDERED_BY, "user") == NULL)
+        goto notordered;
+    if (x0t == td->td_src){
+        xsp = xml_parent(x0);
+        if (rollback_diff_match(td->td_src, xsp, td->td_target, &xtp) < 0)
+            goto done;
+    }
+    else {
+        xtp = xml_parent(x0);
+        if (rollback_diff_match(td->td_target, xtp, td->td_src, &xsp) < 0)
+            goto done;
+    }
+    if (xsp == NULL || xtp == NULL)
+        goto notordered;
+    if (rollback_diff_path(td->td_src, xsp, xc, &xp) < 0)
+        goto done;
+    /* Remove entries of nested lists or paths already in the reverse diff, they are replaced */
+    i = 0;
+    while (i < xml_child_nr(xp)){
+        x1 = xml_child_i(xp, i);
+        if (xml_type(x1) == CX_ELMNT && xml_spec(x1) == y)
+            xml_purge(x1);
+        else
+            i++;
+    }
+    /* Replace all original entries in order */
+    xprev = NULL;
+    xs = NULL;
+    while ((xs = xml_child_each(xsp, xs, CX_ELMNT)) != NULL) {
+        if (xml_spec(xs) != y)
+            continue;
+        xml_flag_set(xs, XML_FLAG_MARK);
+        if ((x1 = xml_dup(xs)) == NULL)
+            goto done;
+        if (xml_addsub(xp, x1) < 0){
+            xml_free(x1);
+            goto done;
+        }
+        if (xml_add_attr(x1, "operation", "replace",
+                         NETCONF_BASE_PREFIX, NETCONF_BASE_NAMESPACE) == NULL)
+            goto done;
+        if (rollback_diff_insert(x1, y, xprev) < 0)
+            goto done;
+        xprev = xs;
+    }
+    /* Remove entries not in original */
+    xt = NULL;
+    while ((xt = xml_child_each(xtp, xt, CX_ELMNT)) != NULL) {
+        if (xml_spec(xt) != y)
+            continue;
+        xml_flag_set(xt, XML_FLAG_MARK);
+        if (match_base_child(xsp, xt, y, &xs) < 0)
+            goto done;
+        if (xs != NULL)
+            continue;
+        if (rollback_diff_path(td->td_target, xt, xc, &x1) < 0)
+            goto done;
+        if (xml_add_attr(x1, "operation", "remove",
+                         NETCONF_BASE_PREFIX, NETCONF_BASE_NAMESPACE) == NULL)
+            goto done;
+    }
+    if (clixon_xvec_append(xvec, xsp) < 0 ||
+        clixon_xvec_append(xvec, xtp) < 0)
+        goto done;
+    retval = 1;
+ done:
+    return retval;
+ notordered:
+    retval = 0;
+    goto done;
+}
+
+/*! Get name of file with reverse diffs of a confirmed-commit sequence
+ *
+ * @param[in]  h         Clixon handle
+ * @param[out] filename  Filename. Free after use
+ * @retval     0         OK
+ * @retval    -1         Error
+ */
+static int
+rollback_diff_file(clixon_handle h,
+                   char        **filename)
+{
+    int   retval = -1;
+    cbuf *cb = NULL;
+    char *dir;
+
+    if ((dir = clicon_xmldb_dir(h)) == NULL){
+        clixon_err(OE_CFG, ENOENT, "CLICON_XMLDB_DIR not set");
+        goto done;
+    }
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cb, "%s/rollback.diff", dir);
+    if ((*filename = strdup(cbuf_get(cb))) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Read reverse diffs of a confirmed-commit sequence
+ *
+ * @param[in]  h     Clixon handle
+ * @param[out] xtp   XML tree: <rollback-diff><config>...</config>*</rollback-diff>, or NULL
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+rollback_diff_read(clixon_handle h,
+                   cxobj       **xtp)
+{
+    int    retval = -1;
+    char  *filename = NULL;
+    FILE  *f = NULL;
+    cxobj *xt = NULL;
+    cxobj *xd;
+
+    *xtp = NULL;
+    if (rollback_diff_file(h, &filename) < 0)
+        goto done;
+    if ((f = fopen(filename, "r")) == NULL){
+        if (errno == ENOENT)
+            goto ok;
+        clixon_err(OE_UNIX, errno, "fopen(%s)", filename);
+        goto done;
+    }
+    if (clixon_xml_parse_file(f, YB_NONE, NULL, &xt, NULL) < 0)
+        goto done;
+    if ((xd = xml_find_type(xt, NULL, "rollback-diff", CX_ELMNT)) == NULL){
+        clixon_err(OE_XML, 0, "Malformed rollback file: %s", filename);
+        goto done;
+    }
+    if (xml_rm(xd) < 0)
+        goto done;
+    *xtp = xd;
+ ok:
+    retval = 0;
+ done:
+    if (xt)
+        xml_free(xt);
+    if (f)
+        fclose(f);
+    if (filename)
+        free(filename);
+    return retval;
+}
+
+/*! Write reverse diffs of a confirmed-commit sequence to file
+ *
+ * Written to a temporary file which is synced and renamed
+ * @param[in]  h     Clixon handle
+ * @param[in]  xt    XML tree: <rollback-diff><config>...</config>*</rollback-diff>
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+rollback_diff_write(clixon_handle h,
+                    cxobj        *xt)
+{
+    int   retval = -1;
+    char *filename = NULL;
+    cbuf *cb = NULL;
+    FILE *f = NULL;
+
+    if (rollback_diff_file(h, &filename) < 0)
+        goto done;
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cb, "%s.tmp", filename);
+    if ((f = fopen(cbuf_get(cb), "w")) == NULL){
+        clixon_err(OE_UNIX, errno, "fopen(%s)", cbuf_get(cb));
+        goto done;
+    }
+    if (clixon_xml2file(f, xt, 0, 0, NULL, fprintf, 0, 0) < 0)
+        goto done;
+    if (fflush(f) != 0 || fsync(fileno(f)) < 0){
+        clixon_err(OE_UNIX, errno, "fsync(%s)", cbuf_get(cb));
+        goto done;
+    }
+    fclose(f);
+    f = NULL;
+    if (rename(cbuf_get(cb), filename) < 0){
+        clixon_err(OE_UNIX, errno, "rename(%s)", filename);
+        goto done;
+    }
+    retval = 0;
+ done:
+    if (f)
+        fclose(f);
+    if (cb)
+        cbuf_free(cb);
+    if (filename)
+        free(filename);
+    return retval;
+}
+
+/*! Add reverse diff of a commit transaction to the rollback of a confirmed-commit sequence
+ *
+ * The reverse diff is an edit that restores running as it was before the commit:
+ * nodes added by the commit are removed, and deleted or changed nodes are merged
+ * with their original values. Ordered-by user lists with added or deleted entries
+ * are replaced entry by entry with their original positions.
+ * The reverse diff of the latest commit is applied first.
+ * Only the diff is stored, running is not copied. Applying the reverse diff to
+ * running as it was before the commit leaves it unchanged.
+ * @param[in]  h      Clixon handle
+ * @param[in]  td     Transaction data with computed diff
+ * @param[in]  first  First commit of a sequence, discard earlier reverse diffs
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see CLICON_BACKEND_ROLLBACK_DIFF
+ */
+static int
+rollback_diff_add(clixon_handle      h,
+                  transaction_data_t *td,
+                  int                 first)
+{
+    int          retval = -1;
+    cxobj       *xt = NULL;
+    cxobj       *xc = NULL;
+    clixon_xvec *xvec = NULL;
+    cxobj       *xn;
+    cxobj       *xp;
+    cxobj       *x1;
+    cxobj       *x;
+    int          i;
+    int          ret;
+
+    if (!first && rollback_diff_read(h, &xt) < 0)
+        goto done;
+    if (xt == NULL &&
+        (xt = xml_new("rollback-diff", NULL, CX_ELMNT)) == NULL)
+        goto done;
+    if ((xc = xml_new(NETCONF_INPUT_CONFIG, NULL, CX_ELMNT)) == NULL)
+        goto done;
+    if ((xvec = clixon_xvec_new()) == NULL)
+        goto done;
+    /* Added nodes are removed */
+    for (i=0; i<td->td_alen; i++){
+        xn = td->td_avec[i];
+        if (xml_flag(xn, XML_FLAG_DEFAULT) ||
+            rollback_diff_marked(td->td_target, xn))
+            continue;
+        if ((ret = rollback_diff_ordered(td, td->td_target, xn, xc, xvec)) < 0)
+            goto done;
+        if (ret == 1)
+            continue;
+        if (rollback_diff_path(td->td_target, xn, xc, &x1) < 0)
+            goto done;
+        if (xml_add_attr(x1, "operation", "remove",
+                         NETCONF_BASE_PREFIX, NETCONF_BASE_NAMESPACE) == NULL)
+            goto done;
+    }
+    /* Deleted and changed nodes are merged with original value */
+    for (i=0; i<td->td_dlen + td->td_clen; i++){
+        xn = i<td->td_dlen ? td->td_dvec[i] : td->td_scvec[i-td->td_dlen];
+        if (xml_flag(xn, XML_FLAG_DEFAULT) ||
+            rollback_diff_marked(td->td_src, xn))
+            continue;
+        if (i<td->td_dlen){
+            if ((ret = rollback_diff_ordered(td, td->td_src, xn, xc, xvec)) < 0)
+                goto done;
+            if (ret == 1)
+                continue;
+        }
+        if (rollback_diff_path(td->td_src, xml_parent(xn), xc, &xp) < 0)
+            goto done;
+        if ((x1 = xml_dup(xn)) == NULL)
+            goto done;
+        if (xml_addsub(xp, x1) < 0){
+            xml_free(x1);
+            goto done;
+        }
+        if (xml_sort(xp) < 0)
+            goto done;
+    }
+    /* Latest reverse diff first */
+    if (xml_child_insert_pos(xt, xc, 0) < 0)
+        goto done;
+    xml_parent_set(xc, xt);
+    xc = NULL;
+    if (rollback_diff_write(h, xt) < 0)
+        goto done;
+    retval = 0;
+ done:
+    if (xvec){
+        for (i=0; i<clixon_xvec_len(xvec); i++){
+            x = NULL;
+            while ((x = xml_child_each(clixon_xvec_i(xvec, i), x, CX_ELMNT)) != NULL)
+                xml_flag_reset(x, XML_FLAG_MARK);
+        }
+        clixon_xvec_free(xvec);
+    }
+    if (xc)
+        xml_free(xc);
+    if (xt)
+        xml_free(xt);
+    return retval;
+}
+
+/*! Check if a confirmed-commit sequence has persisted reverse diffs
+ *
+ * @param[in]  h   Clixon handle
+ * @retval     1   Yes, reverse diffs exist
+ * @retval     0   No
+ * @retval    -1   Error
+ */
+static int
+rollback_diff_exists(clixon_handle h)
+{
+    int         retval = -1;
+    char       *filename = NULL;
+    struct stat st;
+
+    if (rollback_diff_file(h, &filename) < 0)
+        goto done;
+    retval = lstat(filename, &st) == 0;
+ done:
+    if (filename)
+        free(filename);
+    return retval;
+}
+
+/*! Remove the persisted reverse diffs of a confirmed-commit sequence
+ *
+ * @param[in]  h   Clixon handle
+ * @retval     0   OK, also if it did not exist
+ * @retval    -1   Error
+ */
+int
+rollback_diff_delete(clixon_handle h)
+{
+    int   retval = -1;
+    char *filename = NULL;
+
+    if (rollback_diff_file(h, &filename) < 0)
+        goto done;
+    if (unlink(filename) < 0 && errno != ENOENT){
+        clixon_err(OE_UNIX, errno, "unlink(%s)", filename);
+        goto done;
+    }
+    retval = 0;
+ done:
+    if (filename)
+        free(filename);
+    return retval;
+}
+
+/*! Create the rollback database by applying the reverse diffs to another database
+ *
+ * Running is only copied when a rollback is actually made.
+ * If there are no reverse diffs, the rollback database is used as is.
+ * @param[in]  h     Clixon handle
+ * @param[in]  from  Database the commits of the sequence were made to, eg running
+ * @param[out] cbret Error reply if retval is 0
+ * @retval     1     OK
+ * @retval     0     Reverse diff could not be applied (with cbret set)
+ * @retval    -1     Error
+ */
+int
+rollback_db_create(clixon_handle h,
+                   char         *from,
+                   cbuf         *cbret)
+{
+    int        retval = -1;
+    yang_stmt *yspec;
+    cxobj     *xt = NULL;
+    cxobj     *xc;
+    cxobj     *xerr = NULL;
+    int        ret;
+
+    if ((yspec = clicon_dbspec_yang(h)) == NULL){
+        clixon_err(OE_YANG, ENOENT, "No yang spec");
+        goto done;
+    }
+    if (rollback_diff_read(h, &xt) < 0)
+        goto done;
+    if (xt == NULL)
+        goto ok;
+    if (xmldb_copy(h, from, "rollback") < 0)
+        goto done;
+    xc = NULL;
+    while (xt && (xc = xml_child_each(xt, xc, CX_ELMNT)) != NULL){
+        if ((ret = xml_bind_yang(h, xc, YB_MODULE, yspec, &xerr)) < 0)
+            goto done;
+        if (ret == 0){
+            if (clixon_xml2cbuf(cbret, xerr, 0, 0, NULL, -1, 0) < 0)
+                goto done;
+            goto fail;
+        }
+        if (xml_sort_recurse(xc) < 0)
+            goto done;
+        if ((ret = xmldb_put(h, "rollback", OP_NONE, xc, NULL, cbret)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+    }
+ ok:
+    retval = 1;
+ done:
+    if (xerr)
+        xml_free(xerr);
+    if (xt)
+        xml_free(xt);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Check if a confirmed-commit sequence has a rollback, as database or as reverse diffs
+ *
+ * @param[in]  h   Clixon handle
+ * @retval     1   Yes
+ * @retval     0   No
+ * @retval    -1   Error
+ */
+int
+rollback_db_exists(clixon_handle h)
+{
+    int ret;
+
+    if ((ret = xmldb_exists(h, "rollback")) != 0)
+        return ret;
+    return rollback_diff_exists(h);
+}
+
+/*! Delete the rollback of a confirmed-commit sequence, both database and reverse diffs
+ *
+ * @param[in]  h   Clixon handle
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+int
+rollback_db_delete(clixon_handle h)
+{
+    int retval = -1;
+
+    if (xmldb_delete(h, "rollback") < 0)
+        goto done;
+    if (rollback_diff_delete(h) < 0)
+        goto done;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Replace reverse diffs of a confirmed-commit sequence with the rollback database
+ *
+ * Reverse diffs only cover commits of the sequence. Before running is changed in any
+ * other way during the confirm window, eg edit-config or copy-config to running,
+ * the reverse diffs are applied to a copy of running, and that rollback database is
+ * used from then on.
+ * @param[in]  h      Clixon handle
+ * @retval     0      OK, or no reverse diffs
+ * @retval    -1      Error
+ * @see CLICON_BACKEND_ROLLBACK_DIFF
+ */
+int
+rollback_diff_materialize(clixon_handle h)
+{
+    int   retval = -1;
+    cbuf *cbret = NULL;
+    int   ret;
+
+    if (confirmed_commit_state_get(h) == INACTIVE ||
+        confirmed_commit_state_get(h) == ROLLBACK)
+        goto ok;
+    if ((ret = rollback_diff_exists(h)) < 0)
+        goto done;
+    if (ret == 0)
+        goto ok;
+    if ((cbret = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if ((ret = rollback_db_create(h, "running", cbret)) < 0)
+        goto done;
+    if (ret == 0){
+        clixon_err(OE_DB, 0, "Reverse diff could not be applied: %s", cbuf_get(cbret));
+        goto done;
+    }
+    if (rollback_diff_delete(h) < 0)
+        goto done;
+ ok:
+    retval = 0;
+ done:
+    if (cbret)
+        cbuf_free(cbret);
+    return retval;
+}
+
 /*! Cancel a scheduled rollback as previously registered by schedule_rollback_event()
  *
  * @param[in]   h       Clixon handle
@@ -392,7 +1133,7 @@ cancel_confirmed_commit(clixon_handle h)
 
     confirmed_commit_state_set(h, INACTIVE);
 
-    if (xmldb_delete(h, "rollback") < 0)
+    if (rollback_db_delete(h) < 0)
         clixon_err(OE_DB, 0, "Error deleting the rollback configuration");
     return 0;
 }
@@ -477,15 +1218,17 @@ check_valid_confirming_commit(clixon_handle h,
  * @param[in]   h          Clixon handle
  * @param[in]   xe         Commit rpc xml or NULL
  * @param[in]   myid       Current session-id, only valid > 0 if call is made as a result of an incoming message
+ * @param[in]   td         Transaction data with computed diff of the commit
  * @retval      0          OK
  * @retval     -1          Error
  * @note There are some calls to this function where myid is 0 (which is invalid). It is unclear if such calls
  *       actually occur, and if so, if they are correctly handled. The calls are from do_rollback() and load_failsafe()
  */
 int
-handle_confirmed_commit(clixon_handle h,
-                        cxobj        *xe,
-                        uint32_t      myid)
+handle_confirmed_commit(clixon_handle    h,
+                        cxobj           *xe,
+                        uint32_t         myid,
+                        transaction_data td)
 {
     int           retval = -1;
     char         *persist;
@@ -553,13 +1296,13 @@ handle_confirmed_commit(clixon_handle h,
                        confirm_timeout);
         }
 
-        /* The confirmed-commits and confirming-commits can overlap; the rollback database is created at the beginning
+        /* The confirmed-commits and confirming-commits can overlap; the rollback is created at the beginning
          * of such a sequence and deleted at the end; hence its absence implies this is the first of a sequence. **
          *
          *
          * |    edit
          * |    | confirmed-commit
-         * |    | copy t=0 running to rollback
+         * |    | copy t=0 running to rollback database
          * |    | | edit
          * |    | | | both
          * |    | | | | edit
@@ -572,13 +1315,19 @@ handle_confirmed_commit(clixon_handle h,
          * edit = edit of the candidate configuration
          * both = both a confirmed-commit and confirming-commit in the same RPC
          *
-         * As shown, the rollback database created at t=2 is comprised of the running database from t=0
-         * Thus, if there is a rollback event at t=7, the t=0 configuration will be committed.
+         * As shown, the rollback database is created only once at the start of the sequence.
+         * Thus, if there is a rollback event at t=7, the configuration at t=0 will be committed.
+         *
+         * With CLICON_BACKEND_ROLLBACK_DIFF, running is not copied at t=2. Instead the reverse diff of each
+         * commit is prepended to a list of reverse diffs. If there is a rollback event at t=7, the reverse diffs
+         * are applied to running creating the t=0 configuration in the rollback database which is committed.
+         * If running is changed by other means than a commit during the sequence, the rollback database is
+         * created from the reverse diffs before that change, see rollback_diff_materialize().
          *
-         *  ** the rollback database may be present at system startup if there was a crash during a confirmed-commit;
-         *     in the case the system is configured to startup from running and the rollback database is present, the
-         *     rollback database will be committed to running and then deleted.  If the system is configured to use a
-         *     startup configuration instead, any present rollback database will be deleted.
+         *  ** the rollback may be present at system startup if there was a crash during a confirmed-commit;
+         *     in the case the system is configured to startup from running and the rollback is present, the
+         *     rollback is applied and committed to running and then deleted.  If the system is configured to use a
+         *     startup configuration instead, any present rollback will be deleted.
          *
          */
 
@@ -586,7 +1335,19 @@ handle_confirmed_commit(clixon_handle h,
         if (db_exists == -1) {
             clixon_err(OE_DAEMON, 0, "there was an error while checking existence of the rollback database");
             goto done;
-        } else if (db_exists == 0) {
+        }
+        if (db_exists == 0 && clicon_option_bool(h, "CLICON_BACKEND_ROLLBACK_DIFF")){
+            /* Store reverse diff unless rollback database already exists */
+            if ((db_exists = rollback_diff_exists(h)) == -1) {
+                clixon_err(OE_DAEMON, 0, "there was an error while checking existence of the rollback");
+                goto done;
+            }
+            if (rollback_diff_add(h, (transaction_data_t *)td, db_exists == 0) < 0) {
+                clixon_err(OE_DAEMON, 0, "there was an error while storing the reverse diff of running to the rollback.");
+                goto done;
+            }
+        }
+        else if (db_exists == 0) {
             // db does not yet exists
             if (xmldb_copy(h, "running", "rollback") < 0) {
                 clixon_err(OE_DAEMON, 0, "there was an error while copying the running configuration to rollback database.");
@@ -602,9 +1363,9 @@ handle_confirmed_commit(clixon_handle h,
     }
     else {
         /* There was no subsequent confirmed-commit, meaning this is the end of the confirmed/confirming sequence;
-         * The new configuration is already committed to running and the rollback database can now be deleted
+         * The new configuration is already committed to running and the rollback can now be deleted
          */
-        if (xmldb_delete(h, "rollback") < 0) {
+        if (rollback_db_delete(h) < 0) {
             clixon_err(OE_DB, 0, "Error deleting the rollback configuration");
             goto done;
         }
@@ -617,8 +1378,8 @@ handle_confirmed_commit(clixon_handle h,
 
 /*! Do a rollback of the running configuration to the state prior to initiation of a confirmed-commit
  *
- * The "running" configuration prior to the first confirmed-commit was stored in another database named "rollback".
- * Here, it is committed as if it is the candidate configuration.
+ * The rollback database, or with CLICON_BACKEND_ROLLBACK_DIFF the reverse diffs of the confirmed-commits
+ * applied to running, is committed as if it is the candidate configuration.
  *
  * Execution has arrived here because do_rollback() was called by one of:
  *  1. backend_client_rm()          (client disconnected and confirmed-commit is ephemeral)
@@ -657,7 +1418,8 @@ do_rollback(clixon_handle h,
         confirmed_commit_persist_id_set(h, NULL);
     }
     confirmed_commit_state_set(h, ROLLBACK);
-    if (candidate_commit(h, NULL, "rollback", 0, 0, cbret) < 0) { /* Assume validation fail, nofatal */
+    if (rollback_db_create(h, "running", cbret) < 1 ||
+        candidate_commit(h, NULL, "rollback", 0, 0, cbret) < 0) { /* Assume validation fail, nofatal */
         /* theoretically, this should never error, since the rollback database was previously active and therefore
          * had itself been previously and successfully committed.
          */
@@ -669,6 +1431,8 @@ do_rollback(clixon_handle h,
             clixon_log(h, LOG_CRIT, "An error occurred renaming the rollback database.");
             errstate |= ROLLBACK_DB_NOT_DELETED;
         }
+        if (rollback_diff_delete(h) < 0)
+            errstate |= ROLLBACK_DB_NOT_DELETED;
 
         /* Attempt to load the failsafe config */
 
@@ -685,7 +1449,7 @@ do_rollback(clixon_handle h,
     }
     cbuf_free(cbret);
 
-    if (xmldb_delete(h, "rollback") < 0) {
+    if (rollback_db_delete(h) < 0) {
         clixon_log(h, LOG_WARNING, "A rollback occurred but the rollback_db wasn't deleted.");
         errstate |= ROLLBACK_DB_NOT_DELETED;
         goto done;
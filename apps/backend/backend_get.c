@@ -71,6 +71,7 @@
 #include "backend_client.h"
 #include "backend_handle.h"
 #include "backend_get.h"
+#include "backend_oper.h"
 
 /*! Restconf get capabilities
  *
@@ -305,6 +306,39 @@ get_statedata(clixon_handle     h,
             goto fail;
         }
     }
+    if (clixon_latency_enabled() &&
+        (xpath == NULL || strcmp(xpath, "/") == 0 || strstr(xpath, "latency") != 0)){
+        cprintf(cb, "<latency xmlns=\"%s\">", CLIXON_LIB_NS);
+        if (clixon_latency2cbuf(cb) < 0)
+            goto done;
+        cprintf(cb, "</latency>");
+        if (x1){
+            xml_free(x1);
+            x1 = NULL;
+        }
+        if ((ret = clixon_xml_parse_string(cbuf_get(cb), YB_MODULE, yspec, &x1, &xerr)) < 0)
+            goto done;
+        if (ret == 0){
+            if (clixon_netconf_internal_error(xerr, " . Internal error, latency state returned invalid XML", NULL) < 0)
+                goto done;
+            if (*xret)
+                xml_free(*xret);
+            *xret = xerr;
+            xerr = NULL;
+            goto fail;
+        }
+        if (xpath_first(x1, nsc, "%s", xpath) != NULL){
+            if ((ret = netconf_trymerge(x1, yspec, xret)) < 0)
+                goto done;
+            if (ret == 0)
+                goto fail;
+        }
+    }
+    /* State pushed by plugins, see clixon_statedata_push */
+    if ((ret = backend_oper_get(h, yspec, xpath, nsc, xret)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
     /* Use plugin state callbacks */
     if ((ret = clixon_plugin_statedata_all(h, yspec, nsc, xpath, xret)) < 0)
         goto done;
@@ -380,9 +414,71 @@ filter_xpath_again(clixon_handle h,
     return retval;
 }
 
+/*! Flush callback of a streaming get reply: send serialized output as a chunk to client
+ *
+ * @param[in]  cb   Serialized reply so far
+ * @param[in]  arg  Client entry
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+get_reply_flush(cbuf *cb,
+                void *arg)
+{
+    struct client_entry *ce = (struct client_entry *)arg;
+
+    return clixon_msg_send11_chunk(ce->ce_s, NULL, cbuf_get(cb), cbuf_len(cb), 0);
+}
+
+/*! Encode get reply in binary format, see CLICON_SOCK_BINARY
+ *
+ * The result tree is temporarily wrapped in an rpc-reply envelope
+ * @param[in]  h      Clixon handle
+ * @param[in]  xret   Result XML tree, renamed to data
+ * @param[in]  depth  Max depth of data, -1 is unlimited
+ * @param[in]  wdef   With-defaults parameter
+ * @param[out] cbret  Binary reply message
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+get_reply_binary(clixon_handle     h,
+                 cxobj            *xret,
+                 int32_t           depth,
+                 withdefaults_type wdef,
+                 cbuf             *cbret)
+{
+    int    retval = -1;
+    cxobj *xreply = NULL;
+
+    if ((xreply = xml_new("rpc-reply", NULL, CX_ELMNT)) == NULL)
+        goto done;
+    if (xmlns_set(xreply, NULL, NETCONF_BASE_NAMESPACE) < 0)
+        goto done;
+    if (xml_name_set(xret, NETCONF_OUTPUT_DATA) < 0)
+        goto done;
+    if (xml_addsub(xreply, xret) < 0)
+        goto done;
+    if (clixon_xml2binary_cbuf(cbret, xreply, clicon_dbspec_yang(h), 2,
+                               depth>0?depth+2:depth, wdef) < 0)
+        goto done;
+    retval = 0;
+ done:
+    if (xreply){
+        if (xml_parent(xret) == xreply)
+            xml_rm(xret);
+        xml_free(xreply);
+    }
+    return retval;
+}
+
 /*! Help function for NACM access and return message
  *
+ * If the client has requested binary replies, the reply is encoded in binary format.
+ * Otherwise if CLICON_BACKEND_STREAM_CHUNK is set and the client entry allows it, the
+ * reply is serialized and sent to the client in chunks, and cbret is left empty.
  * @param[in]  h        Clixon handle 
+ * @param[in]  ce       Client entry
  * @param[in]  xret     Result XML tree
  * @param[in]  xvec    xpath lookup result on xret
  * @param[in]  xlen    length of xvec
@@ -397,6 +493,7 @@ filter_xpath_again(clixon_handle h,
  */
 static int
 get_nacm_and_reply(clixon_handle        h,
+                   struct client_entry *ce,
                    cxobj               *xret,
                    cxobj              **xvec,
                    size_t               xlen,
@@ -409,6 +506,7 @@ get_nacm_and_reply(clixon_handle        h,
 {
     int     retval = -1;
     cxobj  *xnacm = NULL;
+    int     chunk;
 
     /* Pre-NACM access step */
     xnacm = clicon_nacm_cache(h);
@@ -420,6 +518,31 @@ get_nacm_and_reply(clixon_handle        h,
     cprintf(cbret, "<rpc-reply xmlns=\"%s\">", NETCONF_BASE_NAMESPACE);     /* OK */
     if (xret==NULL)
         cprintf(cbret, "<data/>");
+    else if (ce->ce_binary && ce->ce_stream && xml_parent(xret) == NULL &&
+             wdef != WITHDEFAULTS_REPORT_ALL_TAGGED){
+        cbuf_reset(cbret);
+        if (get_reply_binary(h, xret, depth, wdef, cbret) < 0)
+            goto done;
+        goto ok;
+    }
+    else if (ce->ce_stream &&
+             (chunk = clicon_option_int(h, "CLICON_BACKEND_STREAM_CHUNK")) > 0){
+        if (xml_name_set(xret, NETCONF_OUTPUT_DATA) < 0)
+            goto done;
+        /* Send reply in chunks while serializing, see get_reply_flush
+         * Mark as streamed first: no other reply may be sent once chunks are sent */
+        if (backend_client_notify_flush(ce) < 0)
+            goto done;
+        ce->ce_streamed = 1;
+        if (clixon_xml2cbuf_stream(cbret, xret, 0, depth>0?depth+1:depth, 0, wdef, chunk,
+                                   get_reply_flush, ce) < 0)
+            goto done;
+        cprintf(cbret, "</rpc-reply>");
+        if (clixon_msg_send11_chunk(ce->ce_s, NULL, cbuf_get(cbret), cbuf_len(cbret), 1) < 0)
+            goto done;
+        cbuf_reset(cbret);
+        goto ok;
+    }
     else{
         if (xml_name_set(xret, NETCONF_OUTPUT_DATA) < 0)
             goto done;
@@ -428,11 +551,126 @@ get_nacm_and_reply(clixon_handle        h,
             goto done;
     }
     cprintf(cbret, "</rpc-reply>");
+ ok:
     retval = 0;
  done:
     return retval;
 }
 
+/*! Reply to a config-only get directly from the datastore cache, without copying
+ *
+ * Only if no NACM read rules apply and the reply is XML without tagged defaults, see
+ * get_config_view_ok. The reply is the same as if made via xmldb_get0 and get_nacm_and_reply.
+ * @param[in]  h        Clixon handle
+ * @param[in]  ce       Client entry
+ * @param[in]  db       Database name
+ * @param[in]  xpath    XPath point to object to get
+ * @param[in]  nsc      Namespace context of xpath
+ * @param[in]  depth    Nr of levels to print, -1 is all
+ * @param[in]  wdef     With-defaults parameter
+ * @param[out] cbret    Return xml tree, eg <rpc-reply>..., <rpc-error..
+ * @retval     0        OK
+ * @retval    -1        Error
+ * @see xmldb_get0_view
+ */
+static int
+get_config_view(clixon_handle        h,
+                struct client_entry *ce,
+                char                *db,
+                char                *xpath,
+                cvec                *nsc,
+                int32_t              depth,
+                withdefaults_type    wdef,
+                cbuf                *cbret)
+{
+    int     retval = -1;
+    cxobj  *xt = NULL;
+    cxobj **xvec = NULL;
+    size_t  xlen = 0;
+    cxobj  *xerr = NULL;
+    cbuf   *cbmsg = NULL;
+    int     chunk;
+    int     ret;
+
+    if ((ret = xmldb_get0_view(h, db, YB_MODULE, nsc, xpath?xpath:"/", &xt, &xvec, &xlen, &xerr)) < 0) {
+        if ((cbmsg = cbuf_new()) == NULL){
+            clixon_err(OE_UNIX, errno, "cbuf_new");
+            goto done;
+        }
+        cprintf(cbmsg, "Get %s datastore: %s", db, clixon_err_reason());
+        if (netconf_operation_failed(cbret, "application", cbuf_get(cbmsg)) < 0)
+            goto done;
+        goto ok;
+    }
+    if (ret == 0){
+        if (clixon_xml2cbuf(cbret, xerr, 0, 0, NULL, -1, 0) < 0)
+            goto done;
+        goto ok;
+    }
+    cprintf(cbret, "<rpc-reply xmlns=\"%s\">", NETCONF_BASE_NAMESPACE);
+    if (xlen == 0)
+        cprintf(cbret, "<%s/>", NETCONF_OUTPUT_DATA);
+    else if (ce->ce_stream &&
+             (chunk = clicon_option_int(h, "CLICON_BACKEND_STREAM_CHUNK")) > 0){
+        /* See get_nacm_and_reply */
+        if (backend_client_notify_flush(ce) < 0)
+            goto done;
+        ce->ce_streamed = 1;
+        cprintf(cbret, "<%s>", NETCONF_OUTPUT_DATA);
+        if (clixon_xml2cbuf_view(cbret, xt, depth, wdef, chunk,
+                                 get_reply_flush, ce) < 0)
+            goto done;
+        cprintf(cbret, "</%s></rpc-reply>", NETCONF_OUTPUT_DATA);
+        if (clixon_msg_send11_chunk(ce->ce_s, NULL, cbuf_get(cbret), cbuf_len(cbret), 1) < 0)
+            goto done;
+        cbuf_reset(cbret);
+        goto ok;
+    }
+    else {
+        cprintf(cbret, "<%s>", NETCONF_OUTPUT_DATA);
+        if (clixon_xml2cbuf_view(cbret, xt, depth, wdef, 0, NULL, NULL) < 0)
+            goto done;
+        cprintf(cbret, "</%s>", NETCONF_OUTPUT_DATA);
+    }
+    cprintf(cbret, "</rpc-reply>");
+ ok:
+    retval = 0;
+ done:
+    if (xvec){
+        xmldb_get0_view_clear(xvec, xlen);
+        free(xvec);
+    }
+    if (xerr)
+        xml_free(xerr);
+    if (cbmsg)
+        cbuf_free(cbmsg);
+    return retval;
+}
+
+/*! Check if a config-only get can be replied from a view of the datastore cache
+ *
+ * @param[in]  h        Clixon handle
+ * @param[in]  ce       Client entry
+ * @param[in]  depth    Nr of levels to print, -1 is all, 0 is none
+ * @param[in]  wdef     With-defaults parameter
+ * @retval     1        Yes, use get_config_view
+ * @retval     0        No, NACM, binary reply, tagged defaults or no output
+ */
+static int
+get_config_view_ok(clixon_handle        h,
+                   struct client_entry *ce,
+                   int32_t              depth,
+                   withdefaults_type    wdef)
+{
+    if (clicon_nacm_cache(h) != NULL)
+        return 0;
+    if (ce->ce_binary && ce->ce_stream)
+        return 0;
+    if (wdef == WITHDEFAULTS_REPORT_ALL_TAGGED || depth == 0)
+        return 0;
+    return 1;
+}
+
 /*! Help function for parsing restconf query parameter and setting netconf attribute
  *
  * Parse and set a uint32 numeric value,
@@ -532,7 +770,7 @@ get_pagination_partial(clixon_handle        h,
         locked = 1;
     else
         locked = 0;
-    if ((ret = clixon_pagination_cb_call(h, xpath, locked,
+    if ((ret = clixon_pagination_cb_call(h, xpath, locked, ce->ce_id,
                                          offset, limit,
                                          xret)) < 0)
         goto done;
@@ -576,6 +814,178 @@ get_pagination_partial(clixon_handle        h,
     goto done;
 }
 
+/*! Encode a list-pagination cursor from list entry key values
+ *
+ * The key values are percent-encoded and delimited by ',' as list keys in RFC 8040 api-path,
+ * and then base64 encoded as the next and previous annotations
+ * @param[in]  cvv     Key values, see xml_key_values
+ * @param[out] curp    Cursor, malloced. Free with free()
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @see list_pagination_cursor_decode
+ */
+static int
+list_pagination_cursor_encode(cvec  *cvv,
+                              char **curp)
+{
+    int     retval = -1;
+    cbuf   *cb = NULL;
+    cg_var *cv = NULL;
+    int     i = 0;
+
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    while ((cv = cvec_each(cvv, cv)) != NULL){
+        if (i++)
+            cprintf(cb, ",");
+        if (uri_percent_cbuf_append(cb, cv_string_get(cv)?cv_string_get(cv):"") < 0)
+            goto done;
+    }
+    if (base64_encode(cbuf_get(cb), curp) < 0)
+        goto done;
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Decode a list-pagination cursor to list entry key values
+ *
+ * @param[in]  cursor  Cursor, see list_pagination_cursor_encode
+ * @param[out] cvp     Key values. Free with cvec_free()
+ * @retval     1       OK
+ * @retval     0       Invalid cursor
+ * @retval    -1       Error
+ */
+static int
+list_pagination_cursor_decode(char  *cursor,
+                              cvec **cvp)
+{
+    int     retval = -1;
+    char   *str = NULL;
+    char  **vec = NULL;
+    int     nvec;
+    char   *val = NULL;
+    cvec   *cvv = NULL;
+    cg_var *cv;
+    int     i;
+    int     ret;
+
+    if ((ret = base64_decode(cursor, &str)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
+    if ((vec = clicon_strsep(str, ",", &nvec)) == NULL)
+        goto done;
+    if ((cvv = cvec_new(0)) == NULL){
+        clixon_err(OE_UNIX, errno, "cvec_new");
+        goto done;
+    }
+    for (i=0; i<nvec; i++){
+        if (uri_percent_decode(vec[i], &val) < 0)
+            goto done;
+        if ((cv = cvec_add(cvv, CGV_STRING)) == NULL){
+            clixon_err(OE_UNIX, errno, "cvec_add");
+            goto done;
+        }
+        if (cv_string_set(cv, val) == NULL){
+            clixon_err(OE_UNIX, errno, "cv_string_set");
+            goto done;
+        }
+        free(val);
+        val = NULL;
+    }
+    *cvp = cvv;
+    cvv = NULL;
+    retval = 1;
+ done:
+    if (val)
+        free(val);
+    if (cvv)
+        cvec_free(cvv);
+    if (vec)
+        free(vec);
+    if (str)
+        free(str);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Check if key values of a list entry are equal to a list-pagination cursor
+ *
+ * @param[in]  x       List or leaf-list entry
+ * @param[in]  y       Yang spec of x
+ * @param[in]  cursor  Key values of cursor
+ * @retval     1       Equal
+ * @retval     0       Not equal
+ * @retval    -1       Error
+ */
+static int
+list_pagination_cursor_match(cxobj     *x,
+                             yang_stmt *y,
+                             cvec      *cursor)
+{
+    int     retval = -1;
+    cvec   *cvv = NULL;
+    int     i;
+
+    if (xml_key_values(x, y, &cvv) < 0)
+        goto done;
+    retval = 0;
+    if (cvec_len(cvv) != cvec_len(cursor))
+        goto done;
+    for (i=0; i<cvec_len(cvv); i++)
+        if (strcmp(cv_string_get(cvec_i(cvv, i)), cv_string_get(cvec_i(cursor, i))) != 0)
+            goto done;
+    retval = 1;
+ done:
+    if (cvv)
+        cvec_free(cvv);
+    return retval;
+}
+
+/*! Add next and previous cursor annotations to first entry of a list-pagination result
+ *
+ * @param[in]  x         First entry of result
+ * @param[in]  next      Key values of entry after the result, or NULL
+ * @param[in]  previous  Key values of first entry of previous page, or NULL
+ * @retval     0         OK
+ * @retval    -1         Error
+ */
+static int
+list_pagination_cursor_attr(cxobj *x,
+                            cvec  *next,
+                            cvec  *previous)
+{
+    int   retval = -1;
+    char *cur = NULL;
+
+    if (next){
+        if (list_pagination_cursor_encode(next, &cur) < 0)
+            goto done;
+        if (xml_add_attr(x, "next", cur, "lp", "urn:ietf:params:xml:ns:yang:ietf-list-pagination") == NULL)
+            goto done;
+        free(cur);
+        cur = NULL;
+    }
+    if (previous){
+        if (list_pagination_cursor_encode(previous, &cur) < 0)
+            goto done;
+        if (xml_add_attr(x, "previous", cur, "lp", "urn:ietf:params:xml:ns:yang:ietf-list-pagination") == NULL)
+            goto done;
+    }
+    retval = 0;
+ done:
+    if (cur)
+        free(cur);
+    return retval;
+}
+
 /*! Specialized get for list-pagination
  *
  * It is specialized enough to have its own function. Specifically, extra attributes as well
@@ -637,15 +1047,17 @@ get_list_pagination(clixon_handle        h,
     char      *sort_by = NULL;
     char      *direction = NULL;
     char      *where = NULL;
+    char      *str;
+    int        cursorp = 0;    /* Cursor pagination, add next and previous annotations */
+    cvec      *cursor = NULL;
+    cvec      *next = NULL;
+    cvec      *previous = NULL;
+    uint32_t   remaining = 0;
+    int        paged = 0;      /* Page read directly from datastore */
     int        extflag = 0;
     int        i;
     int        j;
     int        ret;
-#ifdef LIST_PAGINATION_REMAINING
-    cxobj     *xcache;
-    uint32_t   total;
-    uint32_t   remaining = 0;
-#endif
 
     if (cbret == NULL){
         clixon_err(OE_PLUGIN, EINVAL, "cbret is NULL");
@@ -716,18 +1128,54 @@ get_list_pagination(clixon_handle        h,
         if (strcmp(direction, "forwards") == 0)
             direction = NULL;
     }
-    /* the "offset" parameter (see Section 3.1.5) or
-       NYI: the "cursor" parameter (see Section 3.1.6)
+    /* the "offset" parameter (see Section 3.1.5)
        lastly "the "limit" parameter (see Section 3.1.7) */
     if ((ret = list_pagination_hdr(h, xe, &offset, &limit, cbret)) < 0)
         goto done;
     if (ret == 0)
         goto ok;
+    /* or the "cursor" parameter (see Section 3.1.6), an empty cursor is the first entry */
+    if ((x = xml_find_type(xe, NULL, "cursor", CX_ELMNT)) != NULL){
+        cursorp = 1;
+        if ((str = xml_body(x)) != NULL && strlen(str)){
+            if ((ret = list_pagination_cursor_decode(str, &cursor)) < 0)
+                goto done;
+            if (ret == 0){
+                if (netconf_invalid_value(cbret, "application", "list-pagination cursor not found") < 0)
+                    goto done;
+                goto ok;
+            }
+        }
+    }
     /* Read config */
     switch (content){
     case CONTENT_CONFIG:    /* config data only */
     case CONTENT_ALL:       /* both config and state */
-        /* Build a "predicate" cbuf */
+        /* Read only the page from the datastore if there is no state and no where filter */
+        if (where == NULL && yang_config_ancestor(ylist) &&
+            (content == CONTENT_CONFIG || yang_config_only(ylist))){
+            if ((ret = xmldb_get_page(h, db, nsc, xpath?xpath:"/", sort_by, direction != NULL,
+                                      offset, cursor, limit, wdef, &xret,
+                                      &remaining, &next, &previous)) < 0){
+                if ((cbmsg = cbuf_new()) == NULL){
+                    clixon_err(OE_UNIX, errno, "cbuf_new");
+                    goto done;
+                }
+                cprintf(cbmsg, "Get %s datastore: %s", db, clixon_err_reason());
+                if (netconf_operation_failed(cbret, "application", cbuf_get(cbmsg)) < 0)
+                    goto done;
+                goto ok;
+            }
+            if (ret == 0){
+                if (netconf_invalid_value(cbret, "application", "list-pagination cursor not found") < 0)
+                    goto done;
+                goto ok;
+            }
+            if (ret == 2){
+                paged = 1;
+                break;
+            }
+        }
         if ((ret = xmldb_get0(h, db, YB_MODULE, nsc, xpath?xpath:"/", 1, wdef, &xret, NULL, &xerr)) < 0) {
             if ((cbmsg = cbuf_new()) == NULL){
                 clixon_err(OE_UNIX, errno, "cbuf_new");
@@ -754,7 +1202,7 @@ get_list_pagination(clixon_handle        h,
         break;
     case CONTENT_ALL:       /* both config and state */
     case CONTENT_NONCONFIG: /* state data only */
-        if (partial_pagination_cb) /* Partial reads, special handling */
+        if (partial_pagination_cb || paged) /* Partial reads, special handling */
             break;
         if ((ret = get_statedata(h, xpath?xpath:"/", nsc, &xret)) < 0)
             goto done;
@@ -777,7 +1225,7 @@ get_list_pagination(clixon_handle        h,
         if (ret == 0)
             goto ok;
     }
-    else {
+    else if (!paged) {
         /* first processes the "where" parameter (see Section 3.1.1) */
         if (where){
             if (xpath_vec(xret, nsc, "%s[%s]", &xvec, &xlen, xpath?xpath:"/", where) < 0)
@@ -820,17 +1268,41 @@ get_list_pagination(clixon_handle        h,
                     break;
                 }
             }
+            xml_childvec_reordered(xp);
         }
         /* the "offset" parameter (see Section 3.1.5)
            lastly "the "limit" parameter (see Section 3.1.7) */
         if (xpath_vec(xret, nsc, "%s", &xvec, &xlen, xpath?xpath:"/") < 0)
             goto done;
+        if (cursor){
+            for (i=0; i<xlen; i++){
+                if ((ret = list_pagination_cursor_match(xvec[i], ylist, cursor)) < 0)
+                    goto done;
+                if (ret == 1)
+                    break;
+            }
+            if (i == xlen){
+                if (netconf_invalid_value(cbret, "application", "list-pagination cursor not found") < 0)
+                    goto done;
+                goto ok;
+            }
+            offset = i;
+        }
+        if (offset > xlen)
+            offset = xlen;
         if (limit == 0)
             upper = xlen;
         else{
             if ((upper = offset+limit) > xlen)
                 upper = xlen;
         }
+        remaining = xlen - upper;
+        if (upper < xlen &&
+            xml_key_values(xvec[upper], ylist, &next) < 0)
+            goto done;
+        if (offset > 0 &&
+            xml_key_values(xvec[(limit && offset > limit) ? offset - limit : 0], ylist, &previous) < 0)
+            goto done;
         for (i=offset; i<upper; i++){
             if ((x = xvec[i]) == NULL)
                 break;
@@ -847,28 +1319,21 @@ get_list_pagination(clixon_handle        h,
             free(xvec);
             xvec = NULL;
         }
-#ifdef LIST_PAGINATION_REMAINING
-        /* Get total/remaining
-         */
-        if ((xcache = xmldb_cache_get(h, db)) != NULL){
-            if (xpath_count(xcache, nsc, xpath, &total) < 0)
-                goto done;
-            if (total >= (offset + limit))
-                remaining = total - (offset + limit);
-        }
-#endif
     }
     if (xpath_vec(xret, nsc, "%s", &xvec, &xlen, xpath?xpath:"/") < 0)
         goto done;
     /* Help function to filter out anything that is outside of xpath */
     if (filter_xpath_again(h, yspec, xret, xvec, xlen, xpath, nsc) < 0)
         goto done;
+    /* Add cursor annotations Sec 3.1.6 on the first element in the result set */
+    if (cursorp && xlen &&
+        list_pagination_cursor_attr(xvec[0], next, previous) < 0)
+        goto done;
 #ifdef LIST_PAGINATION_REMAINING
     /* Add remaining attribute Sec 3.1.5: 
        Any list or leaf-list that is limited includes, on the first element in the result set, 
        a metadata value [RFC7952] called "remaining"*/
-    if (limit && x1){ 
-        cxobj *xa;
+    if (limit && xlen){ 
         cbuf  *cba = NULL;
 
         /* Add remaining attribute */
@@ -877,17 +1342,23 @@ get_list_pagination(clixon_handle        h,
             goto done;
         }
         cprintf(cba, "%u", remaining);
-        if (xml_add_attr(x1, "remaining", cbuf_get(cba), "cp", "http://clicon.org/clixon-netconf-list-pagination") == NULL)
+        if (xml_add_attr(xvec[0], "remaining", cbuf_get(cba), "lp", "urn:ietf:params:xml:ns:yang:ietf-list-pagination") == NULL)
         goto done;
         if (cba)
             cbuf_free(cba);
     }
 #endif /* LIST_PAGINATION_REMAINING */
-    if (get_nacm_and_reply(h, xret, xvec, xlen, xpath, nsc, username, depth, wdef, cbret) < 0)
+    if (get_nacm_and_reply(h, ce, xret, xvec, xlen, xpath, nsc, username, depth, wdef, cbret) < 0)
         goto done;
  ok:
     retval = 0;
  done:
+    if (cursor)
+        cvec_free(cursor);
+    if (next)
+        cvec_free(next);
+    if (previous)
+        cvec_free(previous);
     if (xvec)
         free(xvec);
     if (cbmsg)
@@ -1012,6 +1483,12 @@ get_common(clixon_handle        h,
     /* Read configuration */
     switch (content){
     case CONTENT_CONFIG:    /* config data only */
+        /* No NACM: reply from the cache without copy */
+        if (get_config_view_ok(h, ce, depth, wdef)){
+            if (get_config_view(h, ce, db, xpath, nsc, depth, wdef, cbret) < 0)
+                goto done;
+            goto ok;
+        }
         /* specific xpath. with-default gets masked in get_nacm_and_reply */
         if ((ret = xmldb_get0(h, db, YB_MODULE, nsc, xpath?xpath:"/", 1, WITHDEFAULTS_REPORT_ALL, &xret, NULL, &xerr)) < 0) {
             if ((cbmsg = cbuf_new()) == NULL){
@@ -1135,7 +1612,7 @@ get_common(clixon_handle        h,
         goto done;
     if (filter_xpath_again(h, yspec, xret, xvec, xlen, xpath, nsc) < 0)
         goto done;
-    if (get_nacm_and_reply(h, xret, xvec, xlen, xpath, nsc, username, depth, wdef, cbret) < 0)
+    if (get_nacm_and_reply(h, ce, xret, xvec, xlen, xpath, nsc, username, depth, wdef, cbret) < 0)
         goto done;
  ok:
     retval = 0;
@@ -1166,6 +1643,79 @@ get_common(clixon_handle        h,
     return retval;
 }
 
+/*! Get running config, and state data if not config only, without NACM
+ *
+ * For internal readers such as periodic subscriptions, a reduced get_common
+ * @param[in]  h        Clixon handle
+ * @param[in]  content  Config only, or config and state
+ * @param[in]  xpath    XPath selection, or NULL for all
+ * @param[in]  nsc      Namespace context of xpath
+ * @param[out] xret     Selected nodes with ancestors, or rpc-error if 0. Free after use
+ * @retval     1        OK
+ * @retval     0        Failed, xret contains rpc-error
+ * @retval    -1        Error
+ * @see get_common
+ */
+int
+backend_get_data(clixon_handle   h,
+                 netconf_content content,
+                 char           *xpath,
+                 cvec           *nsc,
+                 cxobj         **xret)
+{
+    int        retval = -1;
+    yang_stmt *yspec;
+    cxobj     *xt = NULL;
+    cxobj     *xerr = NULL;
+    cxobj    **xvec = NULL;
+    size_t     xlen;
+    int        ret;
+
+    if ((yspec = clicon_dbspec_yang(h)) == NULL){
+        clixon_err(OE_YANG, ENOENT, "No yang spec");
+        goto done;
+    }
+    if ((ret = xmldb_get0(h, "running", YB_MODULE, nsc, xpath?xpath:"/", 1,
+                          WITHDEFAULTS_REPORT_ALL, &xt, NULL, &xerr)) < 0)
+        goto done;
+    if (ret == 0){
+        *xret = xerr;
+        xerr = NULL;
+        goto fail;
+    }
+    if (content != CONTENT_CONFIG){
+        if ((ret = get_statedata(h, xpath?xpath:"/", nsc, &xt)) < 0)
+            goto done;
+        if (ret == 0){ /* Error from callback (error in xt) */
+            *xret = xt;
+            xt = NULL;
+            goto fail;
+        }
+        if (xml_global_defaults(h, xt, nsc, xpath, yspec, 1) < 0)
+            goto done;
+        if (xml_default_recurse(xt, 1, 0) < 0)
+            goto done;
+    }
+    if (xpath_vec(xt, nsc, "%s", &xvec, &xlen, xpath?xpath:"/") < 0)
+        goto done;
+    if (filter_xpath_again(h, yspec, xt, xvec, xlen, xpath, nsc) < 0)
+        goto done;
+    *xret = xt;
+    xt = NULL;
+    retval = 1;
+ done:
+    if (xvec)
+        free(xvec);
+    if (xt)
+        xml_free(xt);
+    if (xerr)
+        xml_free(xerr);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
 /*! Retrieve all or part of a specified configuration.
  *
  * @param[in]  h       Clixon handle
@@ -1192,6 +1742,8 @@ from_client_get_config(clixon_handle h,
         clixon_err(OE_XML, 0, "db not found");
         goto done;
     }
+    if ((db = backend_candidate_db(h, ce, db)) == NULL)
+        goto done;
     retval = get_common(h, ce, xe, CONTENT_CONFIG, db, cbret);
  done:
     return retval;
@@ -39,6 +39,10 @@
 #include "clixon_config.h" /* generated by config & autoconf */
 #endif
 
+#ifdef __linux__
+#define _GNU_SOURCE /* sched_setaffinity */
+#include <sched.h>
+#endif
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
@@ -77,6 +81,10 @@
 #include "backend_handle.h"
 #include "backend_startup.h"
 #include "backend_plugin_restconf.h"
+#include "backend_stamp.h"
+#include "backend_oper.h"
+#include "backend_push.h"
+#include "backend_replica.h"
 
 /* Command line options to be passed to getopt(3) */
 #define BACKEND_OPTS "hVD:f:E:l:C:d:p:b:Fza:u:P:1qs:c:U:g:y:o:"
@@ -112,15 +120,24 @@ backend_terminate(clixon_handle h)
     /* Free changelog */
     if ((x = clicon_xml_changelog_get(h)) != NULL)
         xml_free(x);
+    /* Free dependency map of incremental validation */
+    xml_yang_validate_depmap_free(h);
     yang_exit(h);
     if ((nsctx = clicon_nsctx_global_get(h)) != NULL)
         cvec_free(nsctx);
     clicon_data_cvec_del(h, "netconf-statistics");
     if ((x = clicon_nacm_ext(h)) != NULL)
         xml_free(x);
+    nacm_policy_free(h);
     if ((x = clicon_conf_xml(h)) != NULL)
         xml_free(x);
     confirmed_commit_free(h);
+    backend_stamp_free(h);
+    backend_oper_free(h);
+    backend_push_free(h);
+    backend_replica_free(h);
+    backend_client_stats_free(h);
+    backend_client_schema_free(h);
     stream_publish_exit();
     /* Delete all plugins, RPC callbacks, and upgrade callbacks */
     clixon_plugin_module_exit(h);
@@ -128,7 +145,13 @@ backend_terminate(clixon_handle h)
     clixon_process_delete_all(h); 
 
     xpath_optimize_exit();
+    clixon_latency_exit();
+    clixon_profile_exit();
+    clixon_trace_exit();
     clixon_pagination_free(h);
+    clixon_statedata_cache_free(h);
+    clixon_statedata_path_free(h);
+    clixon_transaction_path_free(h);
     
     if (pidfile)
         unlink(pidfile);   
@@ -203,6 +226,7 @@ nacm_load_external(clixon_handle h)
     cxobj      *xt = NULL;
     struct stat st;
     FILE       *f = NULL;
+    int         ret;
 
     filename = clicon_option_str(h, "CLICON_NACM_FILE");
     if (filename == NULL || strlen(filename)==0){
@@ -217,20 +241,27 @@ nacm_load_external(clixon_handle h)
         clixon_err(OE_UNIX, 0, "%s is not a regular file", filename);
         goto done;
     }
-    if ((f = fopen(filename, "r")) == NULL) {
-        clixon_err(OE_UNIX, errno, "configure file: %s", filename);
-        return -1;
-    }
     if ((yspec = yspec_new1(h, YANG_DOMAIN_TOP, YANG_NACM_TOP)) == NULL)
         goto done;
     if (yang_spec_parse_module(h, "ietf-netconf-acm", NULL, yspec) < 0)
         goto done;
-    /* Read configfile */
-    if (clixon_xml_parse_file(f, YB_MODULE, yspec, &xt, NULL) < 0)
-        goto done;
-    if (xt == NULL){
-        clixon_err(OE_XML, 0, "No xml tree in %s", filename);
+    /* Read from cache if file is unchanged */
+    if ((ret = startup_cache_read(h, "nacm", filename, yspec, &xt)) < 0)
         goto done;
+    if (ret == 0){
+        if ((f = fopen(filename, "r")) == NULL) {
+            clixon_err(OE_UNIX, errno, "configure file: %s", filename);
+            goto done;
+        }
+        /* Read configfile */
+        if (clixon_xml_parse_file(f, YB_MODULE, yspec, &xt, NULL) < 0)
+            goto done;
+        if (xt == NULL){
+            clixon_err(OE_XML, 0, "No xml tree in %s", filename);
+            goto done;
+        }
+        if (startup_cache_write(h, "nacm", filename, yspec, xt) < 0)
+            goto done;
     }
     if (clicon_nacm_ext_set(h, xt) < 0)
         goto done;
@@ -407,6 +438,60 @@ ret2status(int                  ret,
     return retval;
 }
 
+/*! Bind backend to the CPUs of a NUMA node
+ *
+ * Threads created later, eg datastore and validate workers, inherit the binding.
+ * Failure is logged but not fatal.
+ * @param[in]  h     Clixon handle
+ * @param[in]  node  NUMA node
+ * @retval     0     OK
+ * @see CLICON_XML_ARENA_NUMA_NODE
+ */
+static int
+backend_numa_bind(clixon_handle h,
+                  int           node)
+{
+#ifdef __linux__
+    char      path[64];
+    FILE     *f;
+    cpu_set_t set;
+    char     *s;
+    char      line[1024];
+    int       lo;
+    int       hi;
+    int       i;
+    int       n;
+
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+    if ((f = fopen(path, "r")) == NULL){
+        clixon_log(h, LOG_WARNING, "%s: %s: %s", __func__, path, strerror(errno));
+        return 0;
+    }
+    CPU_ZERO(&set);
+    /* Format is eg 0-3,8-11 */
+    if (fgets(line, sizeof(line), f) != NULL){
+        s = line;
+        while (sscanf(s, "%d%n", &lo, &n) == 1){
+            s += n;
+            hi = lo;
+            if (*s == '-' && sscanf(s+1, "%d%n", &hi, &n) == 1)
+                s += n+1;
+            for (i = lo; i <= hi && i < CPU_SETSIZE; i++)
+                CPU_SET(i, &set);
+            if (*s != ',')
+                break;
+            s++;
+        }
+    }
+    fclose(f);
+    if (CPU_COUNT(&set) == 0)
+        clixon_log(h, LOG_WARNING, "%s: no CPUs in NUMA node %d", __func__, node);
+    else if (sched_setaffinity(0, sizeof(set), &set) < 0)
+        clixon_log(h, LOG_WARNING, "%s: sched_setaffinity: %s", __func__, strerror(errno));
+#endif /* __linux__ */
+    return 0;
+}
+
 #if 0 /* DEBUG */
 /* Debug timer */
 int
@@ -616,6 +701,8 @@ main(int    argc,
     /* Read debug and log options from config file if not given by command-line */
     if (clixon_options_main_helper(h, dbg, logdst, __PROGRAM__) < 0)
         goto done;
+    if (clixon_trace_init(h, __PROGRAM__) < 0)
+        goto done;
     /* Initialize plugin module by creating a handle holding plugin and callback lists */
     if (clixon_plugin_module_init(h) < 0)
         goto done;
@@ -830,6 +917,18 @@ main(int    argc,
             goto done;
     }
     yang_start(h);
+    xml_arena_enable(clicon_option_bool(h, "CLICON_XML_ARENA") ||
+                     clicon_memory_trim(h) != MEMORY_TRIM_NONE);
+    /* Chunks are mapped from the OS so that they can be returned after operations */
+    xml_arena_release(clicon_memory_trim(h) != MEMORY_TRIM_NONE);
+    if (clicon_option_bool(h, "CLICON_XML_ARENA")){
+        xml_arena_layout(clicon_xml_arena_hugepages(h),
+                         clicon_option_int(h, "CLICON_XML_ARENA_NUMA_NODE"));
+        if (clicon_option_int(h, "CLICON_XML_ARENA_NUMA_NODE") >= 0 &&
+            backend_numa_bind(h, clicon_option_int(h, "CLICON_XML_ARENA_NUMA_NODE")) < 0)
+            goto done;
+    }
+    xml_bind_anydata_opaque(clicon_option_bool(h, "CLICON_XMLDB_ANYDATA_OPAQUE"));
     /* Create top-level data yangs */
     if ((yspec = yspec_new1(h, YANG_DOMAIN_TOP, YANG_DATA_TOP)) == NULL)
         goto done;
@@ -888,10 +987,21 @@ main(int    argc,
         goto done;
     if (clicon_nsctx_global_set(h, nsctx_global) < 0)
         goto done;
+#ifdef XML_EXPLICIT_INDEX
+    /* Declare search indexes from config, before any datastore is read */
+    if (yang_search_index_options(h, yspec) < 0)
+        goto done;
+#endif
 
     /* Initialize server socket and save it to handle */
     if (backend_rpc_init(h) < 0)
         goto done;
+    if (backend_stamp_init(h) < 0)
+        goto done;
+    if (backend_oper_init(h) < 0)
+        goto done;
+    if (backend_push_init(h) < 0)
+        goto done;
 
     /* Must be after netconf_module_load, but before startup code */
     if (clicon_option_bool(h, "CLICON_XML_CHANGELOG"))
@@ -945,8 +1055,8 @@ main(int    argc,
     }
     switch (startup_mode){
     case SM_INIT: /* Scratch running and start from empty */
-        /* Delete any rollback database, if it exists */
-        xmldb_delete(h, "rollback");
+        /* Delete any rollback, if it exists */
+        rollback_db_delete(h);
         /* [Delete and] create running db */
         if (xmldb_db_reset(h, "running") < 0)
             goto done;
@@ -1122,6 +1232,12 @@ main(int    argc,
     /* Just before event-loop, after socket bind/listen */
     if (netconf_monitoring_statistics_init(h) < 0)
         goto done;
+    /* Follow running of primary, replaces running after startup */
+    if (backend_replica_init(h) < 0)
+        goto done;
+    /* Publish running to local frontends, if CLICON_XMLDB_SNAPSHOT */
+    if (xmldb_snapshot_write(h) < 0)
+        goto done;
     clixon_log(h, LOG_NOTICE, "%s: %u Started", __PROGRAM__, getpid());
     if (clixon_event_loop(h) < 0)
         goto done;
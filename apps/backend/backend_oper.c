@@ -0,0 +1,424 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2016 Olof Hagsand and Benny Holmgren
+  Copyright (C) 2017-2019 Olof Hagsand
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC (Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Operational state pushed by plugins
+ *
+ * Plugins push state data incrementally with clixon_statedata_push, as edits with an
+ * operation (merge, replace, create, delete, remove) of state subtrees, from any thread.
+ * Updates are queued and applied by the event loop in batches, to an in-memory state
+ * tree that get serves directly, merged with config and with state of statedata callbacks.
+ * Each batch increments a generation and, if CLICON_STREAM_DATASTORE_CHANGE is set, is sent
+ * as a datastore-change notification of the "operational" datastore with the changed
+ * top-level nodes.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <syslog.h>
+#include <sys/time.h>
+#ifdef HAVE_LIBPTHREAD
+#include <pthread.h>
+#endif
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include <clixon/clixon.h>
+
+#include "clixon_backend_plugin.h"
+#include "backend_stamp.h"
+#include "backend_oper.h"
+#include "backend_push.h"
+
+/*! One queued state update
+ */
+struct oper_update {
+    struct oper_update *ou_next;
+    enum operation_type ou_op;   /* Operation of update */
+    char               *ou_xml;  /* State subtrees as XML */
+};
+
+#ifdef HAVE_LIBPTHREAD
+static pthread_mutex_t      _oper_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+static struct oper_update  *_oper_queue = NULL;       /* Queued updates, in order */
+static struct oper_update **_oper_tail = &_oper_queue;
+static int                  _oper_fds[2] = {-1, -1}; /* Wakeup pipe of event loop */
+static cxobj               *_oper_xt = NULL;          /* State tree, <config>... */
+static uint64_t             _oper_gen = 0;            /* Generation, incremented per batch */
+
+static void
+oper_lock(void)
+{
+#ifdef HAVE_LIBPTHREAD
+    pthread_mutex_lock(&_oper_mutex);
+#endif
+}
+
+static void
+oper_unlock(void)
+{
+#ifdef HAVE_LIBPTHREAD
+    pthread_mutex_unlock(&_oper_mutex);
+#endif
+}
+
+static void
+oper_update_free(struct oper_update *ou)
+{
+    if (ou->ou_xml)
+        free(ou->ou_xml);
+    free(ou);
+}
+
+/*! Apply one update to the state tree
+ *
+ * Invalid updates are logged and skipped, the plugin that pushed it is not told
+ * @param[in]  h      Clixon handle
+ * @param[in]  yspec  Yang spec
+ * @param[in]  ou     Update
+ * @param[in]  nodes  Changed top-level nodes are added to this vector
+ * @param[out] all    Set if a node has no yang, ie all nodes changed
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+oper_update_apply(clixon_handle       h,
+                  yang_stmt          *yspec,
+                  struct oper_update *ou,
+                  cvec               *nodes,
+                  int                *all)
+{
+    int    retval = -1;
+    cxobj *xt = NULL;
+    cxobj *xerr = NULL;
+    cxobj *x = NULL;
+    cbuf  *cbret = NULL;
+    int    ret;
+
+    if ((xt = xml_new(NETCONF_INPUT_CONFIG, NULL, CX_ELMNT)) == NULL)
+        goto done;
+    if ((ret = clixon_xml_parse_string(ou->ou_xml, YB_MODULE, yspec, &xt, &xerr)) < 0){
+        clixon_log(h, LOG_WARNING, "%s: invalid state update skipped: %s",
+                   __FUNCTION__, clixon_err_reason());
+        clixon_err_reset();
+        goto ok;
+    }
+    if (ret == 0){
+        clixon_log_xml(h, LOG_WARNING, xerr, "%s: state update not bound to yang, skipped",
+                       __FUNCTION__);
+        goto ok;
+    }
+    while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL)
+        if (backend_stamp_node_add(nodes, x, all) < 0)
+            goto done;
+    if ((cbret = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if ((ret = xmldb_modify_tree(h, _oper_xt, xt, ou->ou_op, cbret)) < 0)
+        goto done;
+    if (ret == 0)
+        clixon_log(h, LOG_WARNING, "%s: state update failed, skipped: %s",
+                   __FUNCTION__, cbuf_get(cbret));
+    else if (backend_push_state(h, xt, ou->ou_op) < 0)
+        goto done;
+ ok:
+    retval = 0;
+ done:
+    if (cbret)
+        cbuf_free(cbret);
+    if (xerr)
+        xml_free(xerr);
+    if (xt)
+        xml_free(xt);
+    return retval;
+}
+
+/*! Apply all queued updates to the state tree as one batch
+ *
+ * @param[in]  h      Clixon handle
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+oper_apply(clixon_handle h)
+{
+    int                 retval = -1;
+    struct oper_update *ou0;
+    struct oper_update *ou;
+    yang_stmt          *yspec;
+    cvec               *nodes = NULL;
+    int                 all = 0;
+
+    oper_lock();
+    ou0 = _oper_queue;
+    _oper_queue = NULL;
+    _oper_tail = &_oper_queue;
+    oper_unlock();
+    if (ou0 == NULL)
+        goto ok;
+    if ((yspec = clicon_dbspec_yang(h)) == NULL){
+        clixon_err(OE_YANG, ENOENT, "No yang spec");
+        goto done;
+    }
+    if (_oper_xt == NULL){
+        if ((_oper_xt = xml_new(DATASTORE_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
+            goto done;
+        xml_flag_set(_oper_xt, XML_FLAG_TOP);
+    }
+    if ((nodes = cvec_new(0)) == NULL){
+        clixon_err(OE_UNIX, errno, "cvec_new");
+        goto done;
+    }
+    for (ou = ou0; ou != NULL; ou = ou->ou_next)
+        if (oper_update_apply(h, yspec, ou, nodes, &all) < 0)
+            goto done;
+    _oper_gen++;
+    clixon_debug(CLIXON_DBG_BACKEND, "generation:%" PRIu64, _oper_gen);
+    if (backend_stamp_state(h, _oper_gen, all ? NULL : nodes) < 0)
+        goto done;
+ ok:
+    retval = 0;
+ done:
+    while ((ou = ou0) != NULL){
+        ou0 = ou->ou_next;
+        oper_update_free(ou);
+    }
+    if (nodes)
+        cvec_free(nodes);
+    return retval;
+}
+
+/*! Event loop wakeup: updates have been queued
+ */
+static int
+oper_wakeup(int   fd,
+            void *arg)
+{
+    clixon_handle h = (clixon_handle)arg;
+    char          buf[64];
+
+    while (read(fd, buf, sizeof(buf)) > 0)
+        ;
+    return oper_apply(h);
+}
+
+/*! Push state data update to the operational state of the backend, from any thread
+ *
+ * The update is queued and applied in order by the event loop, together with other
+ * queued updates. It is then returned by get, merged with config and with state of
+ * statedata callbacks.
+ * An invalid update is logged and skipped when applied.
+ * @param[in]  h    Clixon handle
+ * @param[in]  op   Operation: OP_MERGE, OP_REPLACE, OP_CREATE, OP_DELETE or OP_REMOVE,
+ *                  can be superceded by operation attributes in xml as in edit-config
+ * @param[in]  xml  One or several top-level state subtrees as XML string, is copied
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @code
+ *   if (clixon_statedata_push(h, OP_MERGE,
+ *         "<interfaces-state xmlns=\"urn:example:if\"><interface><name>eth0</name>"
+ *         "<in-octets>4711</in-octets></interface></interfaces-state>") < 0)
+ *      err;
+ * @endcode
+ * @see clixon_statedata_push_flush  Apply updates immediately
+ */
+int
+clixon_statedata_push(clixon_handle       h,
+                      enum operation_type op,
+                      const char         *xml)
+{
+    struct oper_update *ou;
+    int                 wakeup;
+
+    if ((ou = malloc(sizeof(*ou))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        return -1;
+    }
+    memset(ou, 0, sizeof(*ou));
+    ou->ou_op = op;
+    if ((ou->ou_xml = strdup(xml)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        free(ou);
+        return -1;
+    }
+    oper_lock();
+    wakeup = (_oper_queue == NULL);
+    *_oper_tail = ou;
+    _oper_tail = &ou->ou_next;
+    oper_unlock();
+    /* Full pipe means wakeup already pending */
+    if (wakeup && _oper_fds[1] != -1 &&
+        write(_oper_fds[1], "u", 1) < 0 && errno != EAGAIN)
+        clixon_log(h, LOG_WARNING, "%s: write: %s", __FUNCTION__, strerror(errno));
+    return 0;
+}
+
+/*! Apply queued state data updates now, in the main thread
+ *
+ * @param[in]  h    Clixon handle
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see clixon_statedata_push
+ */
+int
+clixon_statedata_push_flush(clixon_handle h)
+{
+    return oper_apply(h);
+}
+
+/*! Get pushed state data matching xpath and merge it into a state tree
+ *
+ * Queued updates are applied first, so that get returns all updates pushed before it.
+ * The wakeup pipe is not read here, since get may be served by a forked read worker
+ * @param[in]     h      Clixon handle
+ * @param[in]     yspec  Yang spec
+ * @param[in]     xpath  XPath, or NULL for all
+ * @param[in]     nsc    Namespace context of xpath
+ * @param[in,out] xret   State tree, pushed state is merged into it
+ * @retval        1      OK
+ * @retval        0      Merge failed, xret replaced with netconf-error
+ * @retval       -1      Error
+ */
+int
+backend_oper_get(clixon_handle h,
+                 yang_stmt    *yspec,
+                 char         *xpath,
+                 cvec         *nsc,
+                 cxobj       **xret)
+{
+    int    retval = -1;
+    cxobj *x1 = NULL;
+    int    ret;
+
+    if (oper_apply(h) < 0)
+        goto done;
+    if (_oper_xt == NULL || xml_child_nr_type(_oper_xt, CX_ELMNT) == 0)
+        goto ok;
+    if (xpath_first(_oper_xt, nsc, "%s", xpath?xpath:"/") == NULL)
+        goto ok;
+    if (xmldb_get_copy(h, _oper_xt, nsc, xpath, WITHDEFAULTS_EXPLICIT, &x1) < 0)
+        goto done;
+    if ((ret = netconf_trymerge(x1, yspec, xret)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
+ ok:
+    retval = 1;
+ done:
+    if (x1)
+        xml_free(x1);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Initialize pushed state data, register wakeup pipe in event loop
+ *
+ * Updates pushed before are applied on first wakeup
+ * @param[in]  h    Clixon handle
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+backend_oper_init(clixon_handle h)
+{
+    int retval = -1;
+    int i;
+
+    if (pipe(_oper_fds) < 0){
+        clixon_err(OE_UNIX, errno, "pipe");
+        goto done;
+    }
+    for (i = 0; i < 2; i++)
+        if (fcntl(_oper_fds[i], F_SETFL, O_NONBLOCK) < 0 ||
+            fcntl(_oper_fds[i], F_SETFD, FD_CLOEXEC) < 0){
+            clixon_err(OE_UNIX, errno, "fcntl");
+            goto done;
+        }
+    if (clixon_event_reg_fd(_oper_fds[0], oper_wakeup, h, "state push") < 0)
+        goto done;
+    if (_oper_queue != NULL &&
+        write(_oper_fds[1], "u", 1) < 0){
+        clixon_err(OE_UNIX, errno, "write");
+        goto done;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Free pushed state data and queued updates
+ *
+ * @param[in]  h    Clixon handle
+ */
+int
+backend_oper_free(clixon_handle h)
+{
+    struct oper_update *ou;
+
+    if (_oper_fds[0] != -1){
+        clixon_event_unreg_fd(_oper_fds[0], oper_wakeup);
+        close(_oper_fds[0]);
+        close(_oper_fds[1]);
+        _oper_fds[0] = _oper_fds[1] = -1;
+    }
+    oper_lock();
+    while ((ou = _oper_queue) != NULL){
+        _oper_queue = ou->ou_next;
+        oper_update_free(ou);
+    }
+    _oper_tail = &_oper_queue;
+    oper_unlock();
+    if (_oper_xt){
+        xml_free(_oper_xt);
+        _oper_xt = NULL;
+    }
+    _oper_gen = 0;
+    return 0;
+}
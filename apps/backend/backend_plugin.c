@@ -43,6 +43,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <stdarg.h>
 #include <dlfcn.h>
 #include <unistd.h>
@@ -52,7 +53,11 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/param.h>
+#include <time.h>
+#include <sys/time.h>
+#include <sys/select.h>
 #include <netinet/in.h>
+#include <sys/wait.h>
 
 /* cligen */
 #include <cligen/cligen.h>
@@ -289,6 +294,8 @@ clixon_plugin_statedata_one(clixon_plugin_t *cp,
     plgstatedata_t *fn;          /* Plugin statedata fn */
     cxobj          *x = NULL;
     void           *wh = NULL;
+    int             memtag;
+    int             rv;
 
     if ((fn = clixon_plugin_api_get(cp)->ca_statedata) != NULL){
         if ((x = xml_new(DATASTORE_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
@@ -296,7 +303,10 @@ clixon_plugin_statedata_one(clixon_plugin_t *cp,
         wh = NULL;
         if (clixon_resource_check(h, &wh, clixon_plugin_name_get(cp), __FUNCTION__) < 0)
             goto done;
-        if (fn(h, nsc, xpath, x) < 0){
+        memtag = clixon_mem_tag_set(clixon_mem_tag("plugin %s", clixon_plugin_name_get(cp)));
+        rv = fn(h, nsc, xpath, x);
+        clixon_mem_tag_set(memtag);
+        if (rv < 0){
             if (clixon_resource_check(h, &wh, clixon_plugin_name_get(cp), __FUNCTION__) < 0)
                 goto done;
             if (clixon_err_category() < 0)
@@ -321,10 +331,629 @@ clixon_plugin_statedata_one(clixon_plugin_t *cp,
     goto done;
 }
 
+/*! Cached state data of a plugin subtree
+ *
+ * @see clixon_statedata_cache_register
+ */
+struct statedata_cache{
+    struct statedata_cache *sc_next;
+    char                   *sc_plugin; /* Plugin name */
+    char                   *sc_xpath;  /* Subtree as xpath */
+    cvec                   *sc_nsc;    /* Namespace context of xpath */
+    uint32_t                sc_ttl;    /* Time to live [ms] */
+    struct timeval          sc_expire; /* Expiry time of cached tree */
+    cxobj                  *sc_xt;     /* Cached state tree, or NULL */
+};
+
+/*! Bind, sort and remove defaults of the result of a statedata callback
+ *
+ * @param[in]     cp      Plugin handle
+ * @param[in]     h       Clixon handle
+ * @param[in]     yspec   Yang spec
+ * @param[in]     rv      Result of callback, 1: OK, 0: callback failed
+ * @param[in]     x       State tree returned by callback, or NULL, is consumed
+ * @param[out]    xp      State tree, or NULL if no state
+ * @param[in,out] xret    Replaced with netconf-error if 0 is returned
+ * @retval        1       OK
+ * @retval        0       Statedata callback failed (xret set with netconf-error)
+ * @retval       -1       Error
+ */
+static int
+clixon_plugin_statedata_bind(clixon_plugin_t *cp,
+                             clixon_handle    h,
+                             yang_stmt       *yspec,
+                             int              rv,
+                             cxobj           *x,
+                             cxobj          **xp,
+                             cxobj          **xret)
+{
+    int     retval = -1;
+    int     ret;
+    cbuf   *cberr = NULL;
+    cxobj  *xerr = NULL;
+
+    if (rv == 0){
+        if ((cberr = cbuf_new()) == NULL){
+            clixon_err(OE_UNIX, errno, "cbuf_new");
+            goto done;
+        }
+        /* error reason should be in clixon_err_reason */
+        cprintf(cberr, "Internal error, state callback in plugin %s returned invalid XML: %s",
+                clixon_plugin_name_get(cp), clixon_err_reason());
+        if (netconf_operation_failed_xml(&xerr, "application", cbuf_get(cberr)) < 0)
+            goto done;
+        xml_free(*xret);
+        *xret = xerr;
+        xerr = NULL;
+        goto fail;
+    }
+    if (x == NULL)
+        goto ok;
+    if (xml_child_nr(x) == 0){
+        xml_free(x);
+        x = NULL;
+        goto ok;
+    }
+    clixon_debug_xml(CLIXON_DBG_BACKEND | CLIXON_DBG_DETAIL, x, "%s STATE:", clixon_plugin_name_get(cp));
+    /* XXX: ret == 0 invalid yang binding should be handled as internal error */
+    if ((ret = xml_bind_yang(h, x, YB_MODULE, yspec, &xerr)) < 0)
+        goto done;
+    if (ret == 0){
+        if (clixon_netconf_internal_error(xerr,
+                                          ". Internal error, state callback returned invalid XML from plugin: ",
+                                          clixon_plugin_name_get(cp)) < 0)
+            goto done;
+        xml_free(*xret);
+        *xret = xerr;
+        xerr = NULL;
+        goto fail;
+    }
+    if (xml_sort_recurse(x) < 0)
+        goto done;
+    /* Remove global defaults and empty non-presence containers */
+    /* XXX: only for state data and according to with-defaults setting */
+    if (xml_default_nopresence(x, 2, 0) < 0)
+        goto done;
+ ok:
+    *xp = x;
+    x = NULL;
+    retval = 1;
+ done:
+    if (xerr)
+        xml_free(xerr);
+    if (cberr)
+        cbuf_free(cberr);
+    if (x)
+        xml_free(x);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Call statedata callback of one plugin and bind, sort and remove defaults of the result
+ *
+ * @param[in]     cp      Plugin handle
+ * @param[in]     h       Clixon handle
+ * @param[in]     yspec   Yang spec
+ * @param[in]     nsc     Namespace context
+ * @param[in]     xpath   String with XPATH syntax. or NULL for all
+ * @param[out]    xp      State tree, or NULL if no state
+ * @param[in,out] xret    Replaced with netconf-error if 0 is returned
+ * @retval        1       OK
+ * @retval        0       Statedata callback failed (xret set with netconf-error)
+ * @retval       -1       Error
+ */
+static int
+clixon_plugin_statedata_get(clixon_plugin_t *cp,
+                            clixon_handle    h,
+                            yang_stmt       *yspec,
+                            cvec            *nsc,
+                            char            *xpath,
+                            cxobj          **xp,
+                            cxobj          **xret)
+{
+    int     ret;
+    cxobj  *x = NULL;
+
+    if ((ret = clixon_plugin_statedata_one(cp, h, nsc, xpath, &x)) < 0)
+        return -1;
+    return clixon_plugin_statedata_bind(cp, h, yspec, ret, x, xp, xret);
+}
+
+/*! Get state data of a plugin from its cached subtrees, call plugin for expired subtrees
+ *
+ * The plugin is called with the registered xpath of a subtree, not the requested xpath.
+ * @param[in]     cp      Plugin handle
+ * @param[in]     h       Clixon handle
+ * @param[in]     yspec   Yang spec
+ * @param[in]     sc0     Cache list
+ * @param[out]    xp      State tree, or NULL if no state
+ * @param[in,out] xret    Replaced with netconf-error if 0 is returned
+ * @retval        1       OK
+ * @retval        0       Statedata callback failed (xret set with netconf-error)
+ * @retval       -1       Error
+ */
+static int
+statedata_cache_get(clixon_plugin_t        *cp,
+                    clixon_handle           h,
+                    yang_stmt              *yspec,
+                    struct statedata_cache *sc0,
+                    cxobj                 **xp,
+                    cxobj                 **xret)
+{
+    int                     retval = -1;
+    struct statedata_cache *sc;
+    struct timeval          now;
+    struct timeval          t;
+    cxobj                  *x = NULL;
+    cxobj                  *x1 = NULL;
+    int                     ret;
+
+    gettimeofday(&now, NULL);
+    for (sc = sc0; sc; sc = sc->sc_next){
+        if (strcmp(sc->sc_plugin, clixon_plugin_name_get(cp)) != 0)
+            continue;
+        if (sc->sc_xt == NULL || !timercmp(&now, &sc->sc_expire, <)){
+            if (sc->sc_xt){
+                xml_free(sc->sc_xt);
+                sc->sc_xt = NULL;
+            }
+            if ((ret = clixon_plugin_statedata_get(cp, h, yspec, sc->sc_nsc, sc->sc_xpath,
+                                                   &sc->sc_xt, xret)) < 0)
+                goto done;
+            if (ret == 0)
+                goto fail;
+            /* No state is also cached */
+            if (sc->sc_xt == NULL &&
+                (sc->sc_xt = xml_new(DATASTORE_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
+                goto done;
+            t.tv_sec = sc->sc_ttl/1000;
+            t.tv_usec = (sc->sc_ttl%1000)*1000;
+            timeradd(&now, &t, &sc->sc_expire);
+        }
+        if (xml_child_nr(sc->sc_xt) == 0)
+            continue;
+        /* Merge moves nodes, merge a copy */
+        if ((x1 = xml_dup(sc->sc_xt)) == NULL)
+            goto done;
+        if ((ret = netconf_trymerge(x1, yspec, &x)) < 0)
+            goto done;
+        if (ret == 0){
+            xml_free(*xret);
+            *xret = x;
+            x = NULL;
+            goto fail;
+        }
+        xml_free(x1);
+        x1 = NULL;
+    }
+    *xp = x;
+    x = NULL;
+    retval = 1;
+ done:
+    if (x1)
+        xml_free(x1);
+    if (x)
+        xml_free(x);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Schema path of state data served by a plugin
+ *
+ * @see clixon_statedata_path_register
+ */
+struct statedata_path{
+    struct statedata_path *sp_next;
+    char                  *sp_plugin; /* Plugin name */
+    char                  *sp_xpath;  /* Schema path as xpath, no predicates */
+    cvec                  *sp_nsc;    /* Namespace context of xpath */
+    int                    sp_resolved; /* sp_cplist is resolved (or invalid if NULL) */
+    clixon_path           *sp_cplist; /* Parsed and yang-resolved path */
+};
+
+/*! Check if xpath is a simple path with key predicates, ie can be parsed as instance-id
+ *
+ * @param[in]  xpath  XPath
+ * @retval     1      Simple path
+ * @retval     0      Not a simple path, eg "//x" or functions
+ */
+static int
+statedata_xpath_simple(const char *xpath)
+{
+    if (xpath == NULL || *xpath != '/')
+        return 0;
+    if (strstr(xpath, "//") != NULL || strstr(xpath, "..") != NULL)
+        return 0;
+    if (strpbrk(xpath, "()|*<>!") != NULL)
+        return 0;
+    return 1;
+}
+
+/*! Parse canonical xpath as instance-id and resolve yang
+ *
+ * @param[in]  yspec   Yang spec
+ * @param[in]  xpath   Canonical xpath
+ * @param[out] cplistp Path parse-tree, or NULL if "/"
+ * @retval     1       OK
+ * @retval     0       Not resolved
+ * @retval    -1       Error
+ */
+static int
+statedata_path_parse(yang_stmt    *yspec,
+                     char         *xpath,
+                     clixon_path **cplistp)
+{
+    *cplistp = NULL;
+    if (strcmp(xpath, "/") == 0)
+        return 1;
+    return clixon_instance_id_parse(yspec, cplistp, NULL, "%s", xpath);
+}
+
+/*! Resolve registered path of a plugin on first use, ie when all yangs are loaded
+ *
+ * An invalid path is logged and the plugin is called as if the path was not registered
+ * @param[in]  h       Clixon handle
+ * @param[in]  yspec   Yang spec
+ * @param[in]  sp      Registered path
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+statedata_path_resolve(clixon_handle          h,
+                       yang_stmt             *yspec,
+                       struct statedata_path *sp)
+{
+    int    retval = -1;
+    char  *xpath1 = NULL;
+    cvec  *nsc1 = NULL;
+    cbuf  *reason = NULL;
+    int    ret;
+
+    if (sp->sp_resolved)
+        return 0;
+    sp->sp_resolved = 1;
+    if ((ret = xpath2canonical(sp->sp_xpath, sp->sp_nsc, yspec, &xpath1, &nsc1, &reason)) < 0)
+        goto done;
+    if (ret == 1 && statedata_xpath_simple(xpath1) && strcmp(xpath1, "/") != 0){
+        if ((ret = statedata_path_parse(yspec, xpath1, &sp->sp_cplist)) < 0)
+            goto done;
+    }
+    else
+        ret = 0;
+    if (ret == 0 || sp->sp_cplist == NULL)
+        clixon_log(h, LOG_WARNING, "%s: Invalid state data path %s of plugin %s, ignored",
+                   __func__, sp->sp_xpath, sp->sp_plugin);
+    retval = 0;
+ done:
+    if (xpath1)
+        free(xpath1);
+    if (nsc1)
+        xml_nsctx_free(nsc1);
+    if (reason)
+        cbuf_free(reason);
+    return retval;
+}
+
+/*! Intersect requested path with registered paths of a plugin
+ *
+ * For every registered path intersecting the request, the deepest of the two is returned as
+ * restricted xpath: the request if it is below the registered path, otherwise the request
+ * followed by the remaining steps of the registered path.
+ * @param[in]  h       Clixon handle
+ * @param[in]  cp      Plugin handle
+ * @param[in]  yspec   Yang spec
+ * @param[in]  sp0     Registered paths
+ * @param[in]  cprq    Parsed request, or NULL for "/"
+ * @param[in]  xpathrq Canonical request xpath
+ * @param[out] xpaths  Restricted xpaths, NULL if the plugin has no (valid) registered path
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+statedata_path_intersect(clixon_handle          h,
+                         clixon_plugin_t       *cp,
+                         yang_stmt             *yspec,
+                         struct statedata_path *sp0,
+                         clixon_path           *cprq,
+                         char                  *xpathrq,
+                         cvec                 **xpaths)
+{
+    int                    retval = -1;
+    struct statedata_path *sp;
+    clixon_path           *c1;
+    clixon_path           *c2;
+    cbuf                  *cb = NULL;
+    cvec                  *cvv = NULL;
+
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    for (sp = sp0; sp; sp = sp->sp_next){
+        if (strcmp(sp->sp_plugin, clixon_plugin_name_get(cp)) != 0)
+            continue;
+        if (statedata_path_resolve(h, yspec, sp) < 0)
+            goto done;
+        if (sp->sp_cplist == NULL)
+            continue;
+        if (cvv == NULL && (cvv = cvec_new(0)) == NULL){
+            clixon_err(OE_UNIX, errno, "cvec_new");
+            goto done;
+        }
+        /* Walk both paths while they are on the same yang nodes */
+        c1 = cprq;
+        c2 = sp->sp_cplist;
+        while (c1 && c2 && c1->cp_yang == c2->cp_yang){
+            c1 = NEXTQ(clixon_path *, c1);
+            c2 = NEXTQ(clixon_path *, c2);
+            if (c1 == cprq)
+                c1 = NULL;
+            if (c2 == sp->sp_cplist)
+                c2 = NULL;
+        }
+        if (c1 && c2) /* Diverge */
+            continue;
+        cbuf_reset(cb);
+        if (strcmp(xpathrq, "/") != 0)
+            cprintf(cb, "%s", xpathrq);
+        while (c2){ /* Remaining steps of registered path */
+            cprintf(cb, "/%s:%s", c2->cp_prefix, c2->cp_id);
+            if ((c2 = NEXTQ(clixon_path *, c2)) == sp->sp_cplist)
+                c2 = NULL;
+        }
+        if (cvec_add_string(cvv, NULL, cbuf_get(cb)) < 0){
+            clixon_err(OE_UNIX, errno, "cvec_add_string");
+            goto done;
+        }
+    }
+    *xpaths = cvv;
+    cvv = NULL;
+    retval = 0;
+ done:
+    if (cvv)
+        cvec_free(cvv);
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Fork a plugin worker process with a pipe to the backend
+ *
+ * @param[out] pid   Worker process, in the backend
+ * @param[out] fd    Read end of pipe in the backend, write end in the worker
+ * @retval     1     Backend, worker started
+ * @retval     0     Worker
+ * @retval    -1     Error
+ * @see plugin_worker_exit  Write result and exit in the worker
+ * @see plugin_worker_result  Read result in the backend
+ */
+static int
+plugin_worker_fork(pid_t *pid,
+                   int   *fd)
+{
+    int fds[2];
+
+    if (pipe(fds) < 0){
+        clixon_err(OE_UNIX, errno, "pipe");
+        return -1;
+    }
+    if ((*pid = fork()) < 0){
+        clixon_err(OE_UNIX, errno, "fork");
+        close(fds[0]);
+        close(fds[1]);
+        return -1;
+    }
+    if (*pid == 0){
+        close(fds[0]);
+        *fd = fds[1];
+        return 0;
+    }
+    close(fds[1]);
+    *fd = fds[0];
+    return 1;
+}
+
+/*! Write result of a plugin worker to the backend and exit the worker
+ *
+ * @param[in]  fd   Write end of pipe
+ * @param[in]  cb   Result: a status character followed by data
+ * @note Does not return
+ */
+static void
+plugin_worker_exit(int   fd,
+                   cbuf *cb)
+{
+    char   *p;
+    size_t  len;
+    ssize_t n;
+
+    p = cbuf_get(cb);
+    len = cbuf_len(cb);
+    while (len > 0){
+        if ((n = write(fd, p, len)) < 0){
+            if (errno == EINTR)
+                continue;
+            _exit(1);
+        }
+        p += n;
+        len -= n;
+    }
+    close(fd);
+    _exit(0);
+}
+
+/*! Read result of a plugin worker and reap it
+ *
+ * @param[in]  pid   Worker process
+ * @param[in]  fd    Read end of pipe, closed on return
+ * @param[in]  name  Plugin name, for errors
+ * @param[out] cbp   Result: a status character followed by data. Free with cbuf_free
+ * @retval     0     OK
+ * @retval    -1     Error, or worker failed
+ */
+static int
+plugin_worker_result(pid_t       pid,
+                     int         fd,
+                     const char *name,
+                     cbuf      **cbp)
+{
+    int     retval = -1;
+    cbuf   *cb = NULL;
+    char    buf[4096];
+    ssize_t n;
+    int     status;
+    int     reaped = 0;
+
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    while ((n = read(fd, buf, sizeof(buf))) != 0){
+        if (n < 0){
+            if (errno == EINTR)
+                continue;
+            clixon_err(OE_UNIX, errno, "read");
+            goto done;
+        }
+        if (cbuf_append_buf(cb, buf, n) < 0){
+            clixon_err(OE_UNIX, errno, "cbuf_append_buf");
+            goto done;
+        }
+    }
+    reaped++;
+    while (waitpid(pid, &status, 0) < 0){
+        if (errno != EINTR){
+            clixon_err(OE_UNIX, errno, "waitpid");
+            goto done;
+        }
+    }
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0 || cbuf_len(cb) == 0){
+        clixon_err(OE_PLUGIN, 0, "Worker %d of plugin %s failed", pid, name);
+        goto done;
+    }
+    *cbp = cb;
+    cb = NULL;
+    retval = 0;
+ done:
+    if (!reaped){
+        kill(pid, SIGKILL);
+        waitpid(pid, NULL, 0);
+    }
+    close(fd);
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Statedata call of one plugin in a get, plugins with own workers are called concurrently
+ *
+ * @see CLIXON_PLUGIN_STATEDATA_WORKER
+ */
+struct statedata_batch {
+    pid_t            sb_pid;     /* Worker process, read its result */
+    int              sb_fd;      /* Read end of pipe from worker */
+    int              sb_started; /* -1: candidate, 1: worker started */
+    int              sb_skip;    /* No registered path intersects request */
+    clixon_plugin_t *sb_cp;      /* Plugin */
+    cvec            *sb_xpaths;  /* Restricted xpaths, or NULL if not scoped */
+    cvec            *sb_nsc;     /* Namespace context of worker call */
+    char            *sb_xpath;   /* XPath of worker call */
+};
+
+/*! Statedata worker: call statedata callback of one plugin and write the state tree
+ *
+ * The result is '1' followed by the state tree, '0' followed by the reason if the
+ * callback failed, or '-' followed by the reason on error
+ * @param[in]  h    Clixon handle
+ * @param[in]  sb   Plugin call
+ * @param[in]  fd   Write end of pipe
+ * @note Does not return
+ */
+static void
+statedata_worker(clixon_handle           h,
+                 struct statedata_batch *sb,
+                 int                     fd)
+{
+    cbuf  *cb = NULL;
+    cxobj *x = NULL;
+    int    ret;
+
+    if ((cb = cbuf_new()) == NULL)
+        _exit(1);
+    if ((ret = clixon_plugin_statedata_one(sb->sb_cp, h, sb->sb_nsc, sb->sb_xpath, &x)) < 0)
+        cprintf(cb, "-%s", clixon_err_reason()?clixon_err_reason():"");
+    else if (ret == 0)
+        cprintf(cb, "0%s", clixon_err_reason()?clixon_err_reason():"");
+    else {
+        cprintf(cb, "1");
+        if (x && clixon_xml2cbuf(cb, x, 0, 0, NULL, -1, 0) < 0)
+            _exit(1);
+    }
+    plugin_worker_exit(fd, cb);
+}
+
+/*! Read state tree of a statedata worker
+ *
+ * @param[in]  sb   Plugin call with started worker
+ * @param[out] xp   State tree, or NULL
+ * @retval     1    OK
+ * @retval     0    Statedata callback failed, reason in clixon_err_reason
+ * @retval    -1    Error
+ */
+static int
+statedata_worker_result(struct statedata_batch *sb,
+                        cxobj                 **xp)
+{
+    int    retval = -1;
+    cbuf  *cb = NULL;
+    char  *str;
+    cxobj *xt = NULL;
+    cxobj *x;
+
+    sb->sb_started = 0;
+    if (plugin_worker_result(sb->sb_pid, sb->sb_fd, clixon_plugin_name_get(sb->sb_cp), &cb) < 0)
+        goto done;
+    str = cbuf_get(cb);
+    switch (str[0]){
+    case '1':
+        if (cbuf_len(cb) > 1){
+            if (clixon_xml_parse_string(str+1, YB_NONE, NULL, &xt, NULL) < 0)
+                goto done;
+            if ((x = xml_child_i_type(xt, 0, CX_ELMNT)) != NULL){
+                xml_rm(x);
+                *xp = x;
+            }
+        }
+        retval = 1;
+        break;
+    case '0':
+        clixon_err(OE_PLUGIN, 0, "%s", str+1);
+        retval = 0;
+        break;
+    default:
+        clixon_err(OE_PLUGIN, 0, "State callback in plugin %s: %s",
+                   clixon_plugin_name_get(sb->sb_cp), str+1);
+        break;
+    }
+ done:
+    if (xt)
+        xml_free(xt);
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
 /*! Go through all backend statedata callbacks and collect state data
  *
  * This is internal system call, plugin is invoked (does not call) this function
- * Backend plugins can register 
+ * State of plugins with subtrees registered with clixon_statedata_cache_register is taken
+ * from the cache, and the plugin is only called when a cached subtree has expired
+ * Plugins with flag CLIXON_PLUGIN_STATEDATA_WORKER are called concurrently in forked worker
+ * processes of their own, if there are several of them. Results are merged in plugin order.
  * @param[in]     h       clicon handle
  * @param[in]     yspec   Yang spec
  * @param[in]     nsc     Namespace context
@@ -342,59 +971,155 @@ clixon_plugin_statedata_all(clixon_handle   h,
                             char           *xpath,
                             cxobj         **xret)
 {
-    int              retval = -1;
-    int              ret;
-    cxobj           *x = NULL;
-    clixon_plugin_t *cp = NULL;
-    cbuf            *cberr = NULL;
-    cxobj           *xerr = NULL;
+    int                     retval = -1;
+    int                     ret;
+    cxobj                  *x = NULL;
+    cxobj                  *x1 = NULL;
+    clixon_plugin_t        *cp = NULL;
+    clixon_plugin_t       **vec;
+    clixon_plugin_api      *api;
+    struct statedata_cache *sc0 = NULL;
+    struct statedata_cache *sc;
+    struct statedata_path  *sp0 = NULL;
+    int                     scoped = 0;
+    char                   *xpathc = NULL;
+    cvec                   *nscc = NULL;
+    cvec                   *nsall = NULL;
+    cbuf                   *reason = NULL;
+    clixon_path            *cprq = NULL;
+    cg_var                 *cv;
+    struct statedata_batch *sb = NULL;
+    struct statedata_batch *sb1;
+    int                     slen = 0;
+    int                     nworkers = 0;
+    int                     i;
 
     clixon_debug(CLIXON_DBG_BACKEND | CLIXON_DBG_DETAIL, "");
-    while ((cp = clixon_plugin_each(h, cp)) != NULL) {
-        if ((ret = clixon_plugin_statedata_one(cp, h, nsc, xpath, &x)) < 0)
+    clicon_ptr_get(h, "statedata-cache", (void**)&sc0);
+    clicon_ptr_get(h, "statedata-paths", (void**)&sp0);
+    /* Parse request once if plugins have registered paths, complex xpaths are not scoped */
+    if (sp0 && statedata_xpath_simple(xpath)){
+        if ((ret = xpath2canonical(xpath, nsc, yspec, &xpathc, &nscc, &reason)) < 0)
             goto done;
-        if (ret == 0){
-            if ((cberr = cbuf_new()) == NULL){
-                clixon_err(OE_UNIX, errno, "cbuf_new");
+        if (ret == 1 && statedata_xpath_simple(xpathc)){
+            if ((ret = statedata_path_parse(yspec, xpathc, &cprq)) < 0)
                 goto done;
+            if (ret == 1){
+                if (xml_nsctx_yangspec(yspec, &nsall) < 0)
+                    goto done;
+                scoped = 1;
+                clicon_ptr_set(h, "statedata-request", cprq);
             }
-            /* error reason should be in clixon_err_reason */
-            cprintf(cberr, "Internal error, state callback in plugin %s returned invalid XML: %s",
-                    clixon_plugin_name_get(cp), clixon_err_reason());
-            if (netconf_operation_failed_xml(&xerr, "application", cbuf_get(cberr)) < 0)
-                goto done;
-            xml_free(*xret);
-            *xret = xerr;
-            xerr = NULL;
-            goto fail;
         }
-        if (x == NULL)
+    }
+    /* Only plugins with a statedata callback */
+    if ((vec = clixon_plugin_hook(h, offsetof(clixon_plugin_api, ca_statedata))) == NULL)
+        goto done;
+    while (vec[slen])
+        slen++;
+    if (slen && (sb = calloc(slen, sizeof(*sb))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    /* First pass: find what to call in each plugin */
+    for (i = 0; i < slen; i++) {
+        cp = vec[i];
+        sb1 = &sb[i];
+        sb1->sb_cp = cp;
+        if (scoped &&
+            statedata_path_intersect(h, cp, yspec, sp0, cprq, xpathc, &sb1->sb_xpaths) < 0)
+            goto done;
+        if (sb1->sb_xpaths && cvec_len(sb1->sb_xpaths) == 0){
+            sb1->sb_skip = 1;
             continue;
-        if (xml_child_nr(x) == 0){
-            xml_free(x);
-            x = NULL;
+        }
+        api = clixon_plugin_api_get(cp);
+        if (api->ca_statedata == NULL ||
+            (api->ca_trans_flags & CLIXON_PLUGIN_STATEDATA_WORKER) == 0)
+            continue;
+        if (sb1->sb_xpaths && cvec_len(sb1->sb_xpaths) != 1)
             continue;
+        for (sc = sc0; sc; sc = sc->sc_next)
+            if (strcmp(sc->sc_plugin, clixon_plugin_name_get(cp)) == 0)
+                break;
+        if (sc != NULL)
+            continue;
+        if (sb1->sb_xpaths){
+            sb1->sb_nsc = nsall;
+            sb1->sb_xpath = cv_string_get(cvec_i(sb1->sb_xpaths, 0));
         }
-        clixon_debug_xml(CLIXON_DBG_BACKEND | CLIXON_DBG_DETAIL, x, "%s STATE:", clixon_plugin_name_get(cp));
-        /* XXX: ret == 0 invalid yang binding should be handled as internal error */
-        if ((ret = xml_bind_yang(h, x, YB_MODULE, yspec, &xerr)) < 0)
-            goto done;
-        if (ret == 0){
-            if (clixon_netconf_internal_error(xerr,
-                                              ". Internal error, state callback returned invalid XML from plugin: ",
-                                              clixon_plugin_name_get(cp)) < 0)
+        else{
+            sb1->sb_nsc = nsc;
+            sb1->sb_xpath = xpath;
+        }
+        sb1->sb_started = -1; /* Candidate */
+        nworkers++;
+    }
+    /* Start plugins with workers concurrently */
+    for (i = 0; i < slen; i++){
+        sb1 = &sb[i];
+        if (sb1->sb_started != -1)
+            continue;
+        sb1->sb_started = 0;
+        if (nworkers < 2)
+            continue;
+        if ((ret = plugin_worker_fork(&sb1->sb_pid, &sb1->sb_fd)) < 0){
+            clixon_log(h, LOG_NOTICE, "%s: %s, calling plugin '%s' in order",
+                       __FUNCTION__, clixon_err_reason(), clixon_plugin_name_get(sb1->sb_cp));
+            clixon_err_reset();
+            continue;
+        }
+        if (ret == 0) /* Worker */
+            statedata_worker(h, sb1, sb1->sb_fd);
+        sb1->sb_started = 1;
+    }
+    /* Second pass: call other plugins and merge results in plugin order */
+    for (i = 0; i < slen; i++){
+        sb1 = &sb[i];
+        cp = sb1->sb_cp;
+        if (sb1->sb_skip)
+            continue;
+        for (sc = sc0; sc; sc = sc->sc_next)
+            if (strcmp(sc->sc_plugin, clixon_plugin_name_get(cp)) == 0)
+                break;
+        if (sb1->sb_started == 1){
+            if ((ret = statedata_worker_result(sb1, &x1)) < 0)
                 goto done;
-            xml_free(*xret);
-            *xret = xerr;
-            xerr = NULL;
-            goto fail;
+            ret = clixon_plugin_statedata_bind(cp, h, yspec, ret, x1, &x, xret);
+            x1 = NULL;
         }
-        if (xml_sort_recurse(x) < 0)
-            goto done;
-        /* Remove global defaults and empty non-presence containers */
-        /* XXX: only for state data and according to with-defaults setting */
-        if (xml_default_nopresence(x, 2, 0) < 0)
+        else if (sc != NULL)
+            ret = statedata_cache_get(cp, h, yspec, sc, &x, xret);
+        else if (sb1->sb_xpaths){
+            /* Call plugin once per intersecting path with restricted xpath */
+            cv = NULL;
+            ret = 1;
+            while ((cv = cvec_each(sb1->sb_xpaths, cv)) != NULL){
+                if ((ret = clixon_plugin_statedata_get(cp, h, yspec, nsall, cv_string_get(cv),
+                                                       &x1, xret)) <= 0)
+                    break;
+                if (x1 == NULL)
+                    continue;
+                if ((ret = netconf_trymerge(x1, yspec, &x)) <= 0){
+                    if (ret == 0){
+                        xml_free(*xret);
+                        *xret = x;
+                        x = NULL;
+                    }
+                    break;
+                }
+                xml_free(x1);
+                x1 = NULL;
+            }
+        }
+        else
+            ret = clixon_plugin_statedata_get(cp, h, yspec, nsc, xpath, &x, xret);
+        if (ret < 0)
             goto done;
+        if (ret == 0)
+            goto fail;
+        if (x == NULL)
+            continue;
         if (xpath_first(x, nsc, "%s", xpath) != NULL){
             if ((ret = netconf_trymerge(x, yspec, xret)) < 0)
                 goto done;
@@ -405,13 +1130,35 @@ clixon_plugin_statedata_all(clixon_handle   h,
             xml_free(x);
             x = NULL;
         }
-    } /* while plugin */
+    } /* for plugin */
     retval = 1;
  done:
-    if (xerr)
-        xml_free(xerr);
-    if (cberr)
-        cbuf_free(cberr);
+    if (sb){
+        for (i = 0; i < slen; i++){
+            if (sb[i].sb_started == 1){ /* Stop and reap workers not read, eg after error */
+                kill(sb[i].sb_pid, SIGKILL);
+                waitpid(sb[i].sb_pid, NULL, 0);
+                close(sb[i].sb_fd);
+            }
+            if (sb[i].sb_xpaths)
+                cvec_free(sb[i].sb_xpaths);
+        }
+        free(sb);
+    }
+    if (scoped)
+        clicon_ptr_del(h, "statedata-request");
+    if (cprq)
+        clixon_path_free(cprq);
+    if (reason)
+        cbuf_free(reason);
+    if (nsall)
+        xml_nsctx_free(nsall);
+    if (nscc)
+        xml_nsctx_free(nscc);
+    if (xpathc)
+        free(xpathc);
+    if (x1)
+        xml_free(x1);
     if (x)
         xml_free(x);
     return retval;
@@ -420,6 +1167,226 @@ clixon_plugin_statedata_all(clixon_handle   h,
     goto done;
 }
 
+/*! Register a schema path of state data served by a plugin
+ *
+ * A plugin with registered paths is only called for requests intersecting one of its paths,
+ * once per intersecting path and with a restricted xpath: the requested xpath if it is below
+ * the registered path, else the requested xpath extended to the registered path.
+ * The parsed request with list keys is available with clixon_statedata_request().
+ * Requests with xpaths that are not simple paths, eg "//x", call all plugins as before.
+ * @param[in]  h       Clixon handle
+ * @param[in]  plugin  Plugin name, ie filename without extension, eg "example_backend"
+ * @param[in]  xpath   Schema path, eg "/if:interfaces-state"
+ * @param[in]  nsc     Namespace context of xpath, is copied
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @code
+ *   if (clixon_statedata_path_register(h, "example_backend", "/ex:state", nsc) < 0)
+ *      err;
+ * @endcode
+ */
+int
+clixon_statedata_path_register(clixon_handle h,
+                               const char   *plugin,
+                               const char   *xpath,
+                               cvec         *nsc)
+{
+    int                    retval = -1;
+    struct statedata_path *sp0 = NULL;
+    struct statedata_path *sp = NULL;
+
+    if ((sp = malloc(sizeof(*sp))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    memset(sp, 0, sizeof(*sp));
+    if ((sp->sp_plugin = strdup(plugin)) == NULL ||
+        (sp->sp_xpath = strdup(xpath)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    if (nsc && (sp->sp_nsc = cvec_dup(nsc)) == NULL){
+        clixon_err(OE_UNIX, errno, "cvec_dup");
+        goto done;
+    }
+    clicon_ptr_get(h, "statedata-paths", (void**)&sp0);
+    sp->sp_next = sp0;
+    if (clicon_ptr_set(h, "statedata-paths", sp) < 0)
+        goto done;
+    sp = NULL;
+    retval = 0;
+ done:
+    if (sp){
+        if (sp->sp_plugin)
+            free(sp->sp_plugin);
+        if (sp->sp_xpath)
+            free(sp->sp_xpath);
+        free(sp);
+    }
+    return retval;
+}
+
+/*! Get parsed request path in a statedata callback of a plugin with registered paths
+ *
+ * List keys of the request are in cp_cvk of the list elements.
+ * @param[in]  h       Clixon handle
+ * @retval     cplist  Parsed and yang-resolved request path
+ * @retval     NULL    Request is "/", or no plugin has a registered path
+ * @see clixon_statedata_path_register
+ */
+clixon_path *
+clixon_statedata_request(clixon_handle h)
+{
+    clixon_path *cplist = NULL;
+
+    clicon_ptr_get(h, "statedata-request", (void**)&cplist);
+    return cplist;
+}
+
+/*! Free registered state data paths
+ *
+ * @param[in]  h      Clixon handle
+ */
+int
+clixon_statedata_path_free(clixon_handle h)
+{
+    struct statedata_path *sp = NULL;
+    struct statedata_path *sp1;
+
+    clicon_ptr_get(h, "statedata-paths", (void**)&sp);
+    while (sp){
+        sp1 = sp->sp_next;
+        if (sp->sp_plugin)
+            free(sp->sp_plugin);
+        if (sp->sp_xpath)
+            free(sp->sp_xpath);
+        if (sp->sp_nsc)
+            cvec_free(sp->sp_nsc);
+        if (sp->sp_cplist)
+            clixon_path_free(sp->sp_cplist);
+        free(sp);
+        sp = sp1;
+    }
+    clicon_ptr_del(h, "statedata-paths");
+    return 0;
+}
+
+/*! Register a state data subtree of a plugin to be cached
+ *
+ * After this, the statedata callback of the plugin is called with the xpath of its registered
+ * subtrees instead of the requested xpath, and the result is served to all requests until
+ * the TTL expires or the cache is invalidated. The registered subtrees of a plugin should
+ * therefore cover all state of the plugin.
+ * @param[in]  h       Clixon handle
+ * @param[in]  plugin  Plugin name, ie filename without extension, eg "example_backend"
+ * @param[in]  xpath   Subtree as xpath, eg "/" for all state of the plugin
+ * @param[in]  nsc     Namespace context of xpath, is copied
+ * @param[in]  ttl     Time to live of cached state [ms]
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @code
+ *   if (clixon_statedata_cache_register(h, "example_backend", "/", NULL, 1000) < 0)
+ *      err;
+ * @endcode
+ * @see clixon_statedata_cache_invalidate
+ */
+int
+clixon_statedata_cache_register(clixon_handle h,
+                                const char   *plugin,
+                                const char   *xpath,
+                                cvec         *nsc,
+                                uint32_t      ttl)
+{
+    int                     retval = -1;
+    struct statedata_cache *sc0 = NULL;
+    struct statedata_cache *sc = NULL;
+
+    if ((sc = malloc(sizeof(*sc))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    memset(sc, 0, sizeof(*sc));
+    if ((sc->sc_plugin = strdup(plugin)) == NULL ||
+        (sc->sc_xpath = strdup(xpath)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    if (nsc && (sc->sc_nsc = cvec_dup(nsc)) == NULL){
+        clixon_err(OE_UNIX, errno, "cvec_dup");
+        goto done;
+    }
+    sc->sc_ttl = ttl;
+    clicon_ptr_get(h, "statedata-cache", (void**)&sc0);
+    sc->sc_next = sc0;
+    if (clicon_ptr_set(h, "statedata-cache", sc) < 0)
+        goto done;
+    sc = NULL;
+    retval = 0;
+ done:
+    if (sc){
+        if (sc->sc_plugin)
+            free(sc->sc_plugin);
+        if (sc->sc_xpath)
+            free(sc->sc_xpath);
+        free(sc);
+    }
+    return retval;
+}
+
+/*! Invalidate cached state data, eg when the plugin knows its state has changed
+ *
+ * The plugin is called on next request
+ * @param[in]  h       Clixon handle
+ * @param[in]  plugin  Plugin name, or NULL for all plugins
+ * @retval     0       OK
+ * @see clixon_statedata_cache_register
+ */
+int
+clixon_statedata_cache_invalidate(clixon_handle h,
+                                  const char   *plugin)
+{
+    struct statedata_cache *sc = NULL;
+
+    clicon_ptr_get(h, "statedata-cache", (void**)&sc);
+    for (; sc; sc = sc->sc_next){
+        if (plugin && strcmp(sc->sc_plugin, plugin) != 0)
+            continue;
+        if (sc->sc_xt){
+            xml_free(sc->sc_xt);
+            sc->sc_xt = NULL;
+        }
+    }
+    return 0;
+}
+
+/*! Free state data cache
+ *
+ * @param[in]  h      Clixon handle
+ */
+int
+clixon_statedata_cache_free(clixon_handle h)
+{
+    struct statedata_cache *sc = NULL;
+    struct statedata_cache *sc1;
+
+    clicon_ptr_get(h, "statedata-cache", (void**)&sc);
+    while (sc){
+        sc1 = sc->sc_next;
+        if (sc->sc_plugin)
+            free(sc->sc_plugin);
+        if (sc->sc_xpath)
+            free(sc->sc_xpath);
+        if (sc->sc_nsc)
+            cvec_free(sc->sc_nsc);
+        if (sc->sc_xt)
+            xml_free(sc->sc_xt);
+        free(sc);
+        sc = sc1;
+    }
+    clicon_ptr_del(h, "statedata-cache");
+    return 0;
+}
+
 /*! Lock database status has changed status
  *
  * @param[in]  cp      Plugin handle
@@ -472,12 +1439,15 @@ clixon_plugin_lockdb_all(clixon_handle h,
                          )
 
 {
-    int              retval = -1;
-    clixon_plugin_t *cp = NULL;
+    int               retval = -1;
+    clixon_plugin_t **vec;
+    int               i;
 
     clixon_debug(CLIXON_DBG_BACKEND | CLIXON_DBG_DETAIL, "");
-    while ((cp = clixon_plugin_each(h, cp)) != NULL) {
-        if (clixon_plugin_lockdb_one(cp, h, db, lock, id) < 0)
+    if ((vec = clixon_plugin_hook(h, offsetof(clixon_plugin_api, ca_lockdb))) == NULL)
+        goto done;
+    for (i=0; vec[i]; i++) {
+        if (clixon_plugin_lockdb_one(vec[i], h, db, lock, id) < 0)
             goto done;
     }
     retval = 0;
@@ -485,12 +1455,83 @@ clixon_plugin_lockdb_all(clixon_handle h,
     return retval;
 }
 
+/*! Server-side pagination cursor of a session
+ *
+ * Continuation token returned by a pagination callback, valid for the page starting at
+ * pc_offset of the same list and session.
+ * There is at most one cursor per session and list, ie sequential paging
+ * @see clixon_pagination_cb_call
+ */
+struct pagination_cursor{
+    struct pagination_cursor *pc_next;
+    uint32_t                  pc_id;     /* Session id */
+    char                     *pc_xpath;  /* Registered XPath of list */
+    uint32_t                  pc_offset; /* Offset of the page the token continues */
+    char                     *pc_token;  /* Continuation token from plugin */
+    struct timeval            pc_expire; /* Expiry time of cursor */
+};
+
+/*! Free a pagination cursor
+ */
+static int
+pagination_cursor_free(struct pagination_cursor *pc)
+{
+    if (pc->pc_xpath)
+        free(pc->pc_xpath);
+    if (pc->pc_token)
+        free(pc->pc_token);
+    free(pc);
+    return 0;
+}
+
+/*! Remove expired cursors and find cursor of a session and list
+ *
+ * @param[in]  h      Clixon handle
+ * @param[in]  id     Session id
+ * @param[in]  xpath  Registered XPath of list
+ * @param[in]  now    Current time
+ * @retval     pc     Cursor (not expired)
+ * @retval     NULL   Not found
+ */
+static struct pagination_cursor *
+pagination_cursor_find(clixon_handle   h,
+                       uint32_t        id,
+                       char           *xpath,
+                       struct timeval *now)
+{
+    struct pagination_cursor  *pc0 = NULL;
+    struct pagination_cursor **pcp;
+    struct pagination_cursor  *pc;
+    struct pagination_cursor  *pcf = NULL;
+
+    clicon_ptr_get(h, "pagination-cursors", (void**)&pc0);
+    pcp = &pc0;
+    while ((pc = *pcp) != NULL){
+        if (!timercmp(now, &pc->pc_expire, <)){
+            *pcp = pc->pc_next;
+            pagination_cursor_free(pc);
+            continue;
+        }
+        if (pc->pc_id == id && strcmp(pc->pc_xpath, xpath) == 0)
+            pcf = pc;
+        pcp = &pc->pc_next;
+    }
+    clicon_ptr_set(h, "pagination-cursors", pc0);
+    return pcf;
+}
+
 /*! Traverse state data callbacks for partial pagination state callbacks
  * 
  * Only if list-pagination-partial-state extension is set
+ * If a callback returns a continuation token with pagination_cursor_set(), it is kept as
+ * a cursor of the session for CLICON_PAGINATION_CURSOR_TIMEOUT seconds. If the session then
+ * requests the page following this page, the token is given to the callback, see
+ * pagination_cursor(). This makes sequential paging linear instead of quadratic in the
+ * callback.
  * @param[in]  h      Clixon handle
  * @param[in]  xpath  Registered XPath using canonical prefixes
  * @param[in]  locked Running datastore is locked by this caller
+ * @param[in]  id     Session id of caller
  * @param[in]  offset Start of pagination interval
  * @param[in]  limit  Number of elements (limit)
  * @param[out] xstate Returned xml state tree
@@ -501,26 +1542,93 @@ int
 clixon_pagination_cb_call(clixon_handle h,
                           char         *xpath,
                           int           locked,
+                          uint32_t      id,
                           uint32_t      offset,
                           uint32_t      limit,
                           cxobj        *xstate)
 {
-    int                 retval = -1;
-    pagination_data_t   pd;
-    dispatcher_entry_t *htable = NULL;
-
+    int                       retval = -1;
+    pagination_data_t         pd = {0,};
+    dispatcher_entry_t       *htable = NULL;
+    struct pagination_cursor *pc0 = NULL;
+    struct pagination_cursor *pc;
+    struct timeval            now;
+    uint32_t                  timeout;
+
+    timeout = clicon_option_int(h, "CLICON_PAGINATION_CURSOR_TIMEOUT");
+    gettimeofday(&now, NULL);
+    pc = pagination_cursor_find(h, id, xpath, &now);
     pd.pd_offset = offset;
     pd.pd_limit = limit;
     pd.pd_locked = locked;
     pd.pd_xstate = xstate;
+    if (pc && pc->pc_offset == offset && timeout)
+        pd.pd_cursor = pc->pc_token;
     clicon_ptr_get(h, "pagination-entries", (void**)&htable);
     if (htable && dispatcher_call_handlers(htable, h, xpath, &pd) < 0)
         goto done;
+    if (pd.pd_next && timeout && limit != 0){
+        if (pc == NULL){
+            if ((pc = malloc(sizeof(*pc))) == NULL){
+                clixon_err(OE_UNIX, errno, "malloc");
+                goto done;
+            }
+            memset(pc, 0, sizeof(*pc));
+            pc->pc_id = id;
+            if ((pc->pc_xpath = strdup(xpath)) == NULL){
+                clixon_err(OE_UNIX, errno, "strdup");
+                free(pc);
+                goto done;
+            }
+            clicon_ptr_get(h, "pagination-cursors", (void**)&pc0);
+            pc->pc_next = pc0;
+            clicon_ptr_set(h, "pagination-cursors", pc);
+        }
+        else if (pc->pc_token)
+            free(pc->pc_token);
+        pc->pc_token = pd.pd_next;
+        pd.pd_next = NULL;
+        pc->pc_offset = offset + limit;
+        pc->pc_expire = now;
+        pc->pc_expire.tv_sec += timeout;
+    }
+    else if (pc)
+        pc->pc_expire = now; /* Last page or random access: remove on next call */
     retval = 1; // XXX 0?
  done:
+    if (pd.pd_next)
+        free(pd.pd_next);
     return retval;
 }
 
+/*! Remove pagination cursors of a session, or all
+ *
+ * @param[in]  h      Clixon handle
+ * @param[in]  id     Session id, or 0 for all sessions
+ * @retval     0      OK
+ */
+int
+clixon_pagination_cursor_rm(clixon_handle h,
+                            uint32_t      id)
+{
+    struct pagination_cursor  *pc0 = NULL;
+    struct pagination_cursor **pcp;
+    struct pagination_cursor  *pc;
+
+    clicon_ptr_get(h, "pagination-cursors", (void**)&pc0);
+    pcp = &pc0;
+    while ((pc = *pcp) != NULL){
+        if (id == 0 || pc->pc_id == id){
+            *pcp = pc->pc_next;
+            pagination_cursor_free(pc);
+        }
+        else
+            pcp = &pc->pc_next;
+    }
+    clicon_ptr_set(h, "pagination-cursors", pc0);
+    return 0;
+}
+
 /*! Register a state data callback
  *
  * @param[in]  h      Clixon handle
@@ -564,6 +1672,7 @@ clixon_pagination_free(clixon_handle h)
     clicon_ptr_get(h, "pagination-entries", (void**)&htable);
     if (htable)
         dispatcher_free(htable);
+    clixon_pagination_cursor_rm(h, 0);
     return 0;
 }
 
@@ -588,6 +1697,188 @@ transaction_new(void)
     return td;
 }
 
+/*! Schema path of configuration handled by a plugin
+ *
+ * @see clixon_transaction_path_register
+ */
+struct transaction_path{
+    struct transaction_path *ta_next;
+    char                    *ta_plugin;   /* Plugin name */
+    char                    *ta_xpath;    /* Schema path as xpath, no predicates */
+    cvec                    *ta_nsc;      /* Namespace context of xpath */
+    int                      ta_resolved; /* ta_yang is resolved (or invalid if NULL) */
+    yang_stmt               *ta_yang;     /* Yang spec of path */
+};
+
+/*! Register a schema path of configuration handled by a plugin
+ *
+ * A plugin with registered paths has its transaction callbacks skipped in transactions
+ * where nothing changed at, below or above any of its paths, see transaction_changed.
+ * Register all paths the plugin reads in its callbacks, including eg leafref targets.
+ * @param[in]  h       Clixon handle
+ * @param[in]  plugin  Plugin name, ie filename without extension, eg "example_backend"
+ * @param[in]  xpath   Schema path, eg "/if:interfaces"
+ * @param[in]  nsc     Namespace context of xpath, is copied
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @code
+ *   if (clixon_transaction_path_register(h, "example_backend", "/ex:table", nsc) < 0)
+ *      err;
+ * @endcode
+ */
+int
+clixon_transaction_path_register(clixon_handle h,
+                                 const char   *plugin,
+                                 const char   *xpath,
+                                 cvec         *nsc)
+{
+    int                      retval = -1;
+    struct transaction_path *ta0 = NULL;
+    struct transaction_path *ta = NULL;
+
+    if ((ta = malloc(sizeof(*ta))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    memset(ta, 0, sizeof(*ta));
+    if ((ta->ta_plugin = strdup(plugin)) == NULL ||
+        (ta->ta_xpath = strdup(xpath)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    if (nsc && (ta->ta_nsc = cvec_dup(nsc)) == NULL){
+        clixon_err(OE_UNIX, errno, "cvec_dup");
+        goto done;
+    }
+    clicon_ptr_get(h, "transaction-paths", (void**)&ta0);
+    ta->ta_next = ta0;
+    if (clicon_ptr_set(h, "transaction-paths", ta) < 0)
+        goto done;
+    ta = NULL;
+    retval = 0;
+ done:
+    if (ta){
+        if (ta->ta_plugin)
+            free(ta->ta_plugin);
+        if (ta->ta_xpath)
+            free(ta->ta_xpath);
+        free(ta);
+    }
+    return retval;
+}
+
+/*! Free registered transaction paths
+ *
+ * @param[in]  h      Clixon handle
+ */
+int
+clixon_transaction_path_free(clixon_handle h)
+{
+    struct transaction_path *ta = NULL;
+    struct transaction_path *ta1;
+
+    clicon_ptr_get(h, "transaction-paths", (void**)&ta);
+    while (ta){
+        ta1 = ta->ta_next;
+        if (ta->ta_plugin)
+            free(ta->ta_plugin);
+        if (ta->ta_xpath)
+            free(ta->ta_xpath);
+        if (ta->ta_nsc)
+            cvec_free(ta->ta_nsc);
+        free(ta);
+        ta = ta1;
+    }
+    clicon_ptr_del(h, "transaction-paths");
+    return 0;
+}
+
+/*! Resolve registered transaction path of a plugin on first use, ie when all yangs are loaded
+ *
+ * An invalid path is logged and ignored
+ * @param[in]  h       Clixon handle
+ * @param[in]  ta      Registered path
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+transaction_path_resolve(clixon_handle            h,
+                         struct transaction_path *ta)
+{
+    int          retval = -1;
+    yang_stmt   *yspec;
+    char        *xpath1 = NULL;
+    cvec        *nsc1 = NULL;
+    cbuf        *reason = NULL;
+    clixon_path *cplist = NULL;
+    int          ret;
+
+    if (ta->ta_resolved)
+        return 0;
+    ta->ta_resolved = 1;
+    yspec = clicon_dbspec_yang(h);
+    if ((ret = xpath2canonical(ta->ta_xpath, ta->ta_nsc, yspec, &xpath1, &nsc1, &reason)) < 0)
+        goto done;
+    if (ret == 1 && statedata_xpath_simple(xpath1) && strcmp(xpath1, "/") != 0){
+        if ((ret = statedata_path_parse(yspec, xpath1, &cplist)) < 0)
+            goto done;
+    }
+    else
+        ret = 0;
+    if (ret == 1 && cplist)
+        ta->ta_yang = PREVQ(clixon_path *, cplist)->cp_yang;
+    if (ta->ta_yang == NULL)
+        clixon_log(h, LOG_WARNING, "%s: Invalid transaction path %s of plugin %s, ignored",
+                   __func__, ta->ta_xpath, ta->ta_plugin);
+    retval = 0;
+ done:
+    if (cplist)
+        clixon_path_free(cplist);
+    if (xpath1)
+        free(xpath1);
+    if (nsc1)
+        xml_nsctx_free(nsc1);
+    if (reason)
+        cbuf_free(reason);
+    return retval;
+}
+
+/*! Check if the transaction callbacks of a plugin can be skipped
+ *
+ * @param[in]  h       Clixon handle
+ * @param[in]  cp      Plugin handle
+ * @param[in]  td      Transaction data
+ * @retval     1       Skip, the plugin has registered paths and none of them changed
+ * @retval     0       Call the plugin
+ * @retval    -1       Error
+ * @see clixon_transaction_path_register
+ */
+static int
+plugin_transaction_skip(clixon_handle       h,
+                        clixon_plugin_t    *cp,
+                        transaction_data_t *td)
+{
+    struct transaction_path *ta = NULL;
+    int                      registered = 0;
+    int                      ret;
+
+    clicon_ptr_get(h, "transaction-paths", (void**)&ta);
+    for (; ta; ta = ta->ta_next){
+        if (strcmp(ta->ta_plugin, clixon_plugin_name_get(cp)) != 0)
+            continue;
+        if (transaction_path_resolve(h, ta) < 0)
+            return -1;
+        if (ta->ta_yang == NULL)
+            continue;
+        registered = 1;
+        if ((ret = transaction_changed((transaction_data)td, ta->ta_yang)) < 0)
+            return -1;
+        if (ret == 1)
+            return 0;
+    }
+    return registered;
+}
+
 /*! Free transaction structure 
  *
  * @param[in]  td      Transaction data will be deallocated after the call
@@ -595,6 +1886,12 @@ transaction_new(void)
 int
 transaction_free(transaction_data_t *td)
 {
+    struct trans_pending *tp;
+
+    while ((tp = td->td_pending) != NULL){
+        td->td_pending = tp->tp_next;
+        free(tp);
+    }
     if (td->td_src)
         xml_free(td->td_src);
     if (td->td_target)
@@ -607,6 +1904,10 @@ transaction_free(transaction_data_t *td)
         free(td->td_scvec);
     if (td->td_tcvec)
         free(td->td_tcvec);
+    if (td->td_ychanged)
+        free(td->td_ychanged);
+    if (td->td_ytouched)
+        free(td->td_ytouched);
     free(td);
     return 0;
 }
@@ -618,14 +1919,47 @@ plugin_transaction_call_one(clixon_handle       h,
 			    const char         *fnname,
 			    transaction_data_t *td)
 {
-    int  retval = -1;
-    int  rv;
-    void *wh = NULL;
-
+    int             retval = -1;
+    int             rv;
+    void           *wh = NULL;
+    struct timespec t0;
+    char            type[32];
+    const char     *str;
+    size_t          len;
+    int             i;
+    clixon_span     sp = {0,};
+    int             memtag;
+
+    if ((rv = plugin_transaction_skip(h, cp, td)) < 0)
+        goto done;
+    if (rv == 1){
+        retval = 0;
+        goto done;
+    }
     wh = NULL;
     if (clixon_resource_check(h, &wh, clixon_plugin_name_get(cp), fnname) < 0)
         goto done;
+    if (clixon_latency_enabled() || clixon_trace_enabled()){
+        /* plugin_transaction_<callback>_one -> trans-<callback> */
+        str = fnname;
+        if (strncmp(str, "plugin_transaction_", strlen("plugin_transaction_")) == 0)
+            str += strlen("plugin_transaction_");
+        len = strlen(str);
+        if (len > 4 && strcmp(&str[len-4], "_one") == 0)
+            len -= 4;
+        snprintf(type, sizeof(type), "trans-%.*s", (int)len, str);
+        for (i=0; type[i]; i++)
+            if (type[i] == '_')
+                type[i] = '-';
+        clixon_trace_span_start(&sp, "plugin %s %s", clixon_plugin_name_get(cp), type);
+    }
+    clixon_latency_start(&t0);
+    memtag = clixon_mem_tag_set(clixon_mem_tag("plugin %s", clixon_plugin_name_get(cp)));
     rv = fn(h, (transaction_data)td);
+    clixon_mem_tag_set(memtag);
+    if (clixon_latency_enabled())
+        clixon_latency_stop(&t0, type, clixon_plugin_name_get(cp));
+    clixon_trace_span_end(&sp);
     if (clixon_resource_check(h, &wh, clixon_plugin_name_get(cp), fnname) < 0)
         goto done;
     if (rv < 0) {
@@ -672,12 +2006,15 @@ int
 plugin_transaction_begin_all(clixon_handle       h,
                              transaction_data_t *td)
 {
-    int            retval = -1;
-    clixon_plugin_t *cp = NULL;
+    int               retval = -1;
+    clixon_plugin_t **vec;
+    int               i;
 
     clixon_debug(CLIXON_DBG_BACKEND | CLIXON_DBG_DETAIL, "");
-    while ((cp = clixon_plugin_each(h, cp)) != NULL) {
-        if (plugin_transaction_begin_one(cp, h, td) < 0)
+    if ((vec = clixon_plugin_hook(h, offsetof(clixon_plugin_api, ca_trans_begin))) == NULL)
+        goto done;
+    for (i=0; vec[i]; i++) {
+        if (plugin_transaction_begin_one(vec[i], h, td) < 0)
             goto done;
     }
     retval = 0;
@@ -716,11 +2053,14 @@ int
 plugin_transaction_validate_all(clixon_handle       h,
                                 transaction_data_t *td)
 {
-    int            retval = -1;
-    clixon_plugin_t *cp = NULL;
+    int               retval = -1;
+    clixon_plugin_t **vec;
+    int               i;
 
-    while ((cp = clixon_plugin_each(h, cp)) != NULL) {
-        if (plugin_transaction_validate_one(cp, h, td) < 0)
+    if ((vec = clixon_plugin_hook(h, offsetof(clixon_plugin_api, ca_trans_validate))) == NULL)
+        goto done;
+    for (i=0; vec[i]; i++) {
+        if (plugin_transaction_validate_one(vec[i], h, td) < 0)
             goto done;
     }
     retval = 0;
@@ -762,11 +2102,14 @@ int
 plugin_transaction_complete_all(clixon_handle       h,
                                 transaction_data_t *td)
 {
-    int            retval = -1;
-    clixon_plugin_t *cp = NULL;
+    int               retval = -1;
+    clixon_plugin_t **vec;
+    int               i;
 
-    while ((cp = clixon_plugin_each(h, cp)) != NULL) {
-        if (plugin_transaction_complete_one(cp, h, td) < 0)
+    if ((vec = clixon_plugin_hook(h, offsetof(clixon_plugin_api, ca_trans_complete))) == NULL)
+        goto done;
+    for (i=0; vec[i]; i++) {
+        if (plugin_transaction_complete_one(vec[i], h, td) < 0)
             goto done;
     }
     retval = 0;
@@ -774,29 +2117,62 @@ plugin_transaction_complete_all(clixon_handle       h,
     return retval;
 }
 
+/*! Commit call of an independent plugin, one of a batch called concurrently
+ *
+ * @see CLIXON_PLUGIN_TRANS_INDEPENDENT
+ */
+struct plugin_commit_batch {
+    pid_t               pb_pid;     /* Worker process */
+    int                 pb_fd;      /* Read end of pipe from worker */
+    int                 pb_started; /* Worker started, read its result */
+    clixon_plugin_t    *pb_cp;      /* Plugin */
+    int                 pb_nr;      /* Order of plugin, first is 1 */
+    clixon_handle       pb_h;
+    transaction_data_t *pb_td;
+    int                 pb_rv;      /* Return value of trans_commit callback */
+};
+
 /*! Revert a commit
  *
- * @param[in]  h   CLICON handle
- * @param[in]  td  Transaction data
- * @param[in]  nr  The plugin where an error occured. 
+ * @param[in]  h    CLICON handle
+ * @param[in]  td   Transaction data
+ * @param[in]  nr   The plugin where an error occured. 
+ * @param[in]  pb   Batch of concurrent plugins, failed ones are not reverted, or NULL
+ * @param[in]  plen Length of pb
+ * Plugins whose pending commit failed are not reverted either
  * @retval     0       OK
  * @retval    -1       Error
  * The revert is made in plugin before this one. Eg if error occurred in
  * plugin 2, then the revert will be made in plugins 1 and 0.
  */
 static int
-plugin_transaction_revert_all(clixon_handle       h,
-                              transaction_data_t *td,
-                              int                 nr)
+plugin_transaction_revert_all(clixon_handle               h,
+                              transaction_data_t         *td,
+                              int                         nr,
+                              struct plugin_commit_batch *pb,
+                              int                         plen)
 {
-    int              retval = 0;
-    clixon_plugin_t *cp = NULL;
-    trans_cb_t      *fn;
+    int                   retval = 0;
+    clixon_plugin_t      *cp = NULL;
+    trans_cb_t           *fn;
+    int                   k;
+    struct trans_pending *tp;
 
     while ((cp = clixon_plugin_each_revert(h, cp, nr)) != NULL) {
         if ((fn = clixon_plugin_api_get(cp)->ca_trans_revert) == NULL)
             continue;
-
+        if (plugin_transaction_skip(h, cp, td) != 0)
+            continue;
+        for (k = 0; k < plen; k++)
+            if (pb[k].pb_cp == cp && pb[k].pb_rv < 0)
+                break;
+        if (k < plen)
+            continue;
+        for (tp = td->td_pending; tp; tp = tp->tp_next)
+            if (tp->tp_cp == cp && tp->tp_rv < 0)
+                break;
+        if (tp != NULL)
+            continue;
         if ((retval = fn(h, (transaction_data)td)) < 0){
             clixon_log(h, LOG_NOTICE, "%s: Plugin '%s' trans_revert callback failed",
                            __FUNCTION__, clixon_plugin_name_get(cp));
@@ -841,6 +2217,99 @@ plugin_transaction_commit_one(clixon_plugin_t      *cp,
     return 0;
 }
 
+/*! Commit worker: call trans_commit of one independent plugin and write the result
+ *
+ * The result is '1' if OK, or '-' followed by the reason if the callback failed
+ * @param[in]  h    Clixon handle
+ * @param[in]  pb   Plugin call
+ * @param[in]  fd   Write end of pipe
+ * @note Does not return
+ */
+static void
+plugin_commit_worker(clixon_handle               h,
+                     struct plugin_commit_batch *pb,
+                     int                         fd)
+{
+    cbuf *cb = NULL;
+
+    if ((cb = cbuf_new()) == NULL)
+        _exit(1);
+    if (plugin_transaction_commit_one(pb->pb_cp, h, pb->pb_td) < 0)
+        cprintf(cb, "-%s", clixon_err_reason()?clixon_err_reason():"");
+    else
+        cprintf(cb, "1");
+    plugin_worker_exit(fd, cb);
+}
+
+/*! Call trans_commit of a batch of independent plugins concurrently and wait for all
+ *
+ * Each callback is called in a forked worker process of its own, or in order if the fork fails
+ * @param[in]  h       Clixon handle
+ * @param[in]  pb      Batch of independent plugins
+ * @param[in]  plen    Length of pb
+ * @retval     0       OK
+ * @retval    -1       Error: one or several callbacks failed, see pb_rv
+ * @note The error of the first failed callback in plugin order is kept
+ */
+static int
+plugin_transaction_commit_batch(clixon_handle               h,
+                                struct plugin_commit_batch *pb,
+                                int                         plen)
+{
+    int   retval = 0;
+    int   k;
+    int   ret;
+    cbuf *cb;
+    void *es = NULL;
+
+    if (plen == 1){
+        pb[0].pb_td->td_cp = pb[0].pb_cp;
+        pb[0].pb_rv = plugin_transaction_commit_one(pb[0].pb_cp, h, pb[0].pb_td);
+        pb[0].pb_td->td_cp = NULL;
+        return pb[0].pb_rv;
+    }
+    for (k = 0; k < plen; k++){
+        pb[k].pb_started = 0;
+        if ((ret = plugin_worker_fork(&pb[k].pb_pid, &pb[k].pb_fd)) == 1){
+            pb[k].pb_started = 1;
+            continue;
+        }
+        if (ret == 0) /* Worker */
+            plugin_commit_worker(h, &pb[k], pb[k].pb_fd);
+        clixon_log(h, LOG_NOTICE, "%s: %s, calling plugin '%s' in order",
+                   __FUNCTION__, clixon_err_reason(), clixon_plugin_name_get(pb[k].pb_cp));
+        clixon_err_reset();
+        pb[k].pb_rv = plugin_transaction_commit_one(pb[k].pb_cp, h, pb[k].pb_td);
+        if (pb[k].pb_rv < 0 && es == NULL)
+            es = clixon_err_save();
+    }
+    for (k = 0; k < plen; k++){
+        if (pb[k].pb_started){
+            pb[k].pb_started = 0;
+            cb = NULL;
+            pb[k].pb_rv = -1;
+            if (plugin_worker_result(pb[k].pb_pid, pb[k].pb_fd,
+                                     clixon_plugin_name_get(pb[k].pb_cp), &cb) == 0){
+                if (cbuf_get(cb)[0] == '1')
+                    pb[k].pb_rv = 0;
+                else
+                    clixon_err(OE_PLUGIN, 0, "%s", cbuf_get(cb)+1);
+                cbuf_free(cb);
+            }
+            if (pb[k].pb_rv < 0 && es == NULL)
+                es = clixon_err_save();
+        }
+        if (pb[k].pb_rv < 0){
+            clixon_log(h, LOG_NOTICE, "%s: Plugin '%s' trans_commit callback failed",
+                       __FUNCTION__, clixon_plugin_name_get(pb[k].pb_cp));
+            retval = -1;
+        }
+    }
+    if (es)
+        clixon_err_restore(es);
+    return retval;
+}
+
 /*! Call transaction_commit callbacks in all backend plugins
  *
  * @param[in]  h       Clixon handle
@@ -850,22 +2319,219 @@ plugin_transaction_commit_one(clixon_plugin_t      *cp,
  * If any of the commit callbacks fail by returning -1, a revert of the 
  * transaction is tried by calling the commit callbacsk with reverse arguments
  * and in reverse order.
+ * Consecutive plugins with flag CLIXON_PLUGIN_TRANS_INDEPENDENT are called concurrently.
+ * Other plugins are called in order and wait for the preceding independent plugins.
+ * If an independent plugin fails, commit-failed is called in all failed plugins of
+ * its batch, and revert in all others, including succeeded plugins of the batch.
+ * A plugin may leave its commit pending, see transaction_commit_pending. The caller
+ * then completes the transaction with plugin_transaction_pending_wait or
+ * plugin_transaction_pending_event.
  */
 int
 plugin_transaction_commit_all(clixon_handle       h,
                               transaction_data_t *td)
 {
-    int            retval = -1;
-    clixon_plugin_t *cp = NULL;
-    int            i=0;
+    int                         retval = -1;
+    clixon_plugin_t            *cp = NULL;
+    clixon_plugin_api          *api;
+    int                         i=0;
+    struct plugin_commit_batch *pb = NULL;
+    struct plugin_commit_batch *pb1;
+    int                         plen = 0;
+    int                         k;
+    int                         ret;
 
     while ((cp = clixon_plugin_each(h, cp)) != NULL) {
         i++;
-        if (plugin_transaction_commit_one(cp, h, td) < 0){
+        if ((ret = plugin_transaction_skip(h, cp, td)) < 0)
+            goto done;
+        if (ret == 1)
+            continue;
+        api = clixon_plugin_api_get(cp);
+        if (api->ca_trans_commit && (api->ca_trans_flags & CLIXON_PLUGIN_TRANS_INDEPENDENT)){
+            if ((pb1 = realloc(pb, (plen+1)*sizeof(*pb))) == NULL){
+                clixon_err(OE_UNIX, errno, "realloc");
+                goto done;
+            }
+            pb = pb1;
+            memset(&pb[plen], 0, sizeof(*pb));
+            pb[plen].pb_cp = cp;
+            pb[plen].pb_nr = i;
+            pb[plen].pb_h = h;
+            pb[plen].pb_td = td;
+            plen++;
+            continue;
+        }
+        if (plen){
+            if (plugin_transaction_commit_batch(h, pb, plen) < 0)
+                goto fail;
+            plen = 0;
+        }
+        td->td_cp = cp;
+        ret = plugin_transaction_commit_one(cp, h, td);
+        td->td_cp = NULL;
+        if (ret < 0){
             /* First make an effort ro revert transaction for the failed plugin */
             plugin_transaction_commit_failed(cp, h, td);
             /* Make an effort to revert transaction */
-            plugin_transaction_revert_all(h, td, i-1);
+            plugin_transaction_revert_all(h, td, i-1, NULL, 0);
+            goto done;
+        }
+    }
+    if (plen && plugin_transaction_commit_batch(h, pb, plen) < 0)
+        goto fail;
+    retval = 0;
+ done:
+    if (pb)
+        free(pb);
+    return retval;
+ fail:
+    for (k = 0; k < plen; k++)
+        if (pb[k].pb_rv < 0)
+            plugin_transaction_commit_failed(pb[k].pb_cp, h, td);
+    plugin_transaction_revert_all(h, td, pb[plen-1].pb_nr, pb, plen);
+    goto done;
+}
+
+/*! Get number of still pending asynchronous commits of a transaction
+ *
+ * @param[in]  td      Transaction data
+ * @retval     n       Number of pending commits, 0 if none
+ * @see transaction_commit_pending
+ */
+int
+plugin_transaction_pending(transaction_data_t *td)
+{
+    struct trans_pending *tp;
+    int                   n = 0;
+
+    for (tp = td->td_pending; tp; tp = tp->tp_next)
+        if (tp->tp_rv == 1)
+            n++;
+    return n;
+}
+
+/*! Revert a transaction if one or several pending commits failed
+ *
+ * commit-failed is called in the failed plugins, and revert in all other plugins
+ * @param[in]  h       Clixon handle
+ * @param[in]  td      Transaction data
+ * @retval     1       Some commit failed, transaction reverted
+ * @retval     0       No commit failed
+ */
+static int
+plugin_transaction_pending_failed(clixon_handle       h,
+                                  transaction_data_t *td)
+{
+    struct trans_pending *tp;
+    clixon_plugin_t      *cp = NULL;
+    int                   nr = 0;
+    int                   failed = 0;
+
+    for (tp = td->td_pending; tp; tp = tp->tp_next)
+        if (tp->tp_rv < 0){
+            clixon_log(h, LOG_NOTICE, "%s: Plugin '%s' pending trans_commit failed",
+                       __FUNCTION__, clixon_plugin_name_get(tp->tp_cp));
+            plugin_transaction_commit_failed(tp->tp_cp, h, td);
+            failed++;
+        }
+    if (failed == 0)
+        return 0;
+    while ((cp = clixon_plugin_each(h, cp)) != NULL)
+        nr++;
+    plugin_transaction_revert_all(h, td, nr, NULL, 0);
+    return 1;
+}
+
+/*! Call completion callback of a readable pending commit file descriptor
+ *
+ * @param[in]  h       Clixon handle
+ * @param[in]  td      Transaction data
+ * @param[in]  fd      Readable file descriptor
+ * @retval     2       Commits are still pending
+ * @retval     1       All commits are completed OK
+ * @retval     0       All commits are completed, but some failed and transaction is reverted
+ * @retval    -1       Error
+ * fd should be unregistered from the event loop unless it is still pending, see
+ * plugin_transaction_pending_fd
+ */
+int
+plugin_transaction_pending_event(clixon_handle       h,
+                                 transaction_data_t *td,
+                                 int                 fd)
+{
+    struct trans_pending *tp;
+
+    for (tp = td->td_pending; tp; tp = tp->tp_next)
+        if (tp->tp_rv == 1 && tp->tp_fd == fd)
+            break;
+    if (tp == NULL){
+        clixon_err(OE_PLUGIN, ENOENT, "No pending commit on fd %d", fd);
+        return -1;
+    }
+    if ((tp->tp_rv = tp->tp_fn(h, fd, (transaction_data)td, tp->tp_arg)) < 0)
+        tp->tp_rv = -1;
+    else if (tp->tp_rv > 1)
+        tp->tp_rv = 1;
+    if (plugin_transaction_pending(td))
+        return 2;
+    return plugin_transaction_pending_failed(h, td)?0:1;
+}
+
+/*! Check if a file descriptor is still pending in a transaction
+ *
+ * @param[in]  td      Transaction data
+ * @param[in]  fd      File descriptor
+ * @retval     1       fd is pending
+ * @retval     0       fd is not pending
+ */
+int
+plugin_transaction_pending_fd(transaction_data_t *td,
+                              int                 fd)
+{
+    struct trans_pending *tp;
+
+    for (tp = td->td_pending; tp; tp = tp->tp_next)
+        if (tp->tp_rv == 1 && tp->tp_fd == fd)
+            return 1;
+    return 0;
+}
+
+/*! Block until all pending commits of a transaction are completed
+ *
+ * Used when there is no client to defer the reply to, eg startup and rollback
+ * @param[in]  h       Clixon handle
+ * @param[in]  td      Transaction data
+ * @retval     0       OK, all commits are completed
+ * @retval    -1       Error, or some commit failed and the transaction is reverted
+ */
+int
+plugin_transaction_pending_wait(clixon_handle       h,
+                                transaction_data_t *td)
+{
+    int                   retval = -1;
+    struct trans_pending *tp;
+    fd_set                fdset;
+    int                   ret;
+
+    while ((tp = td->td_pending) != NULL){
+        while (tp && tp->tp_rv != 1)
+            tp = tp->tp_next;
+        if (tp == NULL)
+            break;
+        FD_ZERO(&fdset);
+        FD_SET(tp->tp_fd, &fdset);
+        if (select(tp->tp_fd+1, &fdset, NULL, NULL, NULL) < 0){
+            if (errno == EINTR)
+                continue;
+            clixon_err(OE_EVENTS, errno, "select");
+            goto done;
+        }
+        if ((ret = plugin_transaction_pending_event(h, td, tp->tp_fd)) < 0)
+            goto done;
+        if (ret == 0){
+            if (!clixon_err_category())
+                clixon_err(OE_PLUGIN, 0, "Pending commit failed");
             goto done;
         }
     }
@@ -906,11 +2572,14 @@ int
 plugin_transaction_commit_done_all(clixon_handle       h,
                                    transaction_data_t *td)
 {
-    int            retval = -1;
-    clixon_plugin_t *cp = NULL;
+    int               retval = -1;
+    clixon_plugin_t **vec;
+    int               i;
 
-    while ((cp = clixon_plugin_each(h, cp)) != NULL) {
-        if (plugin_transaction_commit_done_one(cp, h, td) < 0)
+    if ((vec = clixon_plugin_hook(h, offsetof(clixon_plugin_api, ca_trans_commit_done))) == NULL)
+        goto done;
+    for (i=0; vec[i]; i++) {
+        if (plugin_transaction_commit_done_one(vec[i], h, td) < 0)
             goto done;
     }
     retval = 0;
@@ -949,12 +2618,15 @@ int
 plugin_transaction_end_all(clixon_handle h,
                            transaction_data_t *td)
 {
-    int            retval = -1;
-    clixon_plugin_t *cp = NULL;
+    int               retval = -1;
+    clixon_plugin_t **vec;
+    int               i;
 
     clixon_debug(CLIXON_DBG_BACKEND | CLIXON_DBG_DETAIL, "");
-    while ((cp = clixon_plugin_each(h, cp)) != NULL) {
-        if (plugin_transaction_end_one(cp, h, td) < 0)
+    if ((vec = clixon_plugin_hook(h, offsetof(clixon_plugin_api, ca_trans_end))) == NULL)
+        goto done;
+    for (i=0; vec[i]; i++) {
+        if (plugin_transaction_end_one(vec[i], h, td) < 0)
             goto done;
     }
     retval = 0;
@@ -985,14 +2657,18 @@ int
 plugin_transaction_abort_all(clixon_handle       h,
                              transaction_data_t *td)
 {
-    int            retval = -1;
-    clixon_plugin_t *cp = NULL;
+    int               retval = -1;
+    clixon_plugin_t **vec;
+    int               i;
 
     clixon_debug(CLIXON_DBG_BACKEND | CLIXON_DBG_DETAIL, "");
-    while ((cp = clixon_plugin_each(h, cp)) != NULL) {
-        if (plugin_transaction_abort_one(cp, h, td) < 0)
+    if ((vec = clixon_plugin_hook(h, offsetof(clixon_plugin_api, ca_trans_abort))) == NULL)
+        goto done;
+    for (i=0; vec[i]; i++) {
+        if (plugin_transaction_abort_one(vec[i], h, td) < 0)
             ; /* dont abort on error */
     }
     retval = 0;
+ done:
     return retval;
 }
@@ -0,0 +1,904 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2016 Olof Hagsand and Benny Holmgren
+  Copyright (C) 2017-2019 Olof Hagsand
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC (Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+ *
+ * On-change subscriptions of datastores, after RFC 8641 YANG-Push
+ *
+ * A session establishes a subscription of running or of the state data pushed by
+ * backend plugins, with an optional xpath selection and a dampening period, see
+ * establish-push of clixon-lib. The changes of every commit, and of every batch of
+ * pushed state, that touch selected nodes are made into YANG-Patch edits (RFC 8072)
+ * and sent as a push-change-update notification on the YANG-PUSH stream.
+ * Each subscription is a stream subscription of the session with a filter on its id,
+ * so that updates are delivered, queued and counted as other notifications.
+ * Edits made within the dampening period are collected and sent in one update when
+ * it expires.
+ * A subscription with a period is instead periodic: the selected data is sent as a
+ * push-update notification every period. Periodic subscriptions of the same datastore,
+ * selection and period share one sampler with one timer, the data is read and the
+ * notification is serialized once per period, with the ids of all its subscriptions.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <syslog.h>
+#include <sys/time.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include <clixon/clixon.h>
+
+#include "clixon_backend_plugin.h"
+#include "backend_get.h"
+#include "backend_push.h"
+
+/* On-change subscription event stream, see CLICON_STREAM_YANG_PUSH */
+#define PUSH_STREAM "YANG-PUSH"
+
+/*! Periodic sampling shared by subscriptions of the same datastore, selection and period
+ */
+struct push_sampler {
+    struct push_sampler *sp_next;
+    clixon_handle        sp_h;
+    char                *sp_datastore; /* running or operational */
+    char                *sp_xpath;     /* Canonical selection filter or NULL */
+    cvec                *sp_nsc;       /* Canonical namespace context of selection */
+    uint32_t             sp_period;    /* Period in centiseconds */
+    struct timeval       sp_tick;      /* Time of next sample */
+    int                  sp_refs;      /* Number of subscriptions */
+};
+
+/*! One on-change or periodic subscription
+ */
+struct push_sub {
+    struct push_sub  *ps_next;
+    clixon_handle     ps_h;
+    uint32_t          ps_id;         /* Subscription id */
+    uint32_t          ps_session;    /* Session id of subscriber */
+    char             *ps_datastore;  /* running or operational */
+    char             *ps_xpath;      /* Selection filter or NULL */
+    cvec             *ps_nsc;        /* Namespace context of selection */
+    uint32_t          ps_dampening;  /* Dampening period in centiseconds */
+    struct timeval    ps_last;       /* Time of last update */
+    int               ps_timer;      /* Dampening timer registered */
+    uint64_t          ps_patch;      /* Patch id of next update */
+    cbuf             *ps_edits;      /* Edits of next update */
+    int               ps_nedit;      /* Number of edits in ps_edits */
+    struct stream_subscription *ps_ss; /* Stream subscription of session */
+    struct push_sampler *ps_sampler; /* Periodic subscription sampler, or NULL */
+};
+
+static struct push_sub *_push_subs = NULL;
+static struct push_sampler *_push_samplers = NULL;
+static uint32_t         _push_id = 0;     /* Last subscription id */
+static int              _push_stream = 0; /* Stream added */
+
+static int push_timeout(int fd, void *arg);
+static int push_sample_timeout(int fd, void *arg);
+
+static void
+push_sampler_free(struct push_sampler *sp)
+{
+    clixon_event_unreg_timeout(push_sample_timeout, sp);
+    if (sp->sp_datastore)
+        free(sp->sp_datastore);
+    if (sp->sp_xpath)
+        free(sp->sp_xpath);
+    if (sp->sp_nsc)
+        xml_nsctx_free(sp->sp_nsc);
+    free(sp);
+}
+
+/*! Release a sampler of a subscription, free it when no subscriptions remain
+ */
+static void
+push_sampler_release(struct push_sampler *sp)
+{
+    struct push_sampler **spp;
+
+    if (--sp->sp_refs > 0)
+        return;
+    for (spp = &_push_samplers; *spp != NULL; spp = &(*spp)->sp_next)
+        if (*spp == sp){
+            *spp = sp->sp_next;
+            break;
+        }
+    push_sampler_free(sp);
+}
+
+static void
+push_sub_free(struct push_sub *ps)
+{
+    if (ps->ps_sampler)
+        push_sampler_release(ps->ps_sampler);
+    if (ps->ps_timer)
+        clixon_event_unreg_timeout(push_timeout, ps);
+    if (ps->ps_datastore)
+        free(ps->ps_datastore);
+    if (ps->ps_xpath)
+        free(ps->ps_xpath);
+    if (ps->ps_nsc)
+        xml_nsctx_free(ps->ps_nsc);
+    if (ps->ps_edits)
+        cbuf_free(ps->ps_edits);
+    free(ps);
+}
+
+static int
+push_cmp(const void *a,
+         const void *b)
+{
+    cxobj *xa = *(cxobj **)a;
+    cxobj *xb = *(cxobj **)b;
+
+    return xa < xb ? -1 : xa > xb ? 1 : 0;
+}
+
+/*! Is node in a vector sorted by push_cmp
+ */
+static int
+push_in(cxobj  **vec,
+        size_t   len,
+        cxobj   *x)
+{
+    return len && bsearch(&x, vec, len, sizeof(cxobj *), push_cmp) != NULL;
+}
+
+/*! Print api-path of a node from the top of its tree
+ */
+static int
+push_api_path(cxobj *x,
+              cbuf  *cb)
+{
+    cxobj *xp;
+
+    if ((xp = xml_parent(x)) != NULL && xml_spec(xp) != NULL)
+        if (push_api_path(xp, cb) < 0)
+            return -1;
+    return xml2api_path_1(x, cb);
+}
+
+/*! Add one edit to the next update of a subscription
+ *
+ * @param[in]  ps   Subscription
+ * @param[in]  op   YANG-Patch operation
+ * @param[in]  x    Changed node, value of the edit unless delete or remove
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+push_edit_add(struct push_sub *ps,
+              const char      *op,
+              cxobj           *x)
+{
+    int    retval = -1;
+    cxobj *xc = NULL;
+    cvec  *nsc = NULL;
+
+    cprintf(ps->ps_edits, "<edit><edit-id>%d</edit-id>", ++ps->ps_nedit);
+    cprintf(ps->ps_edits, "<operation>%s</operation><target>", op);
+    if (push_api_path(x, ps->ps_edits) < 0)
+        goto done;
+    cprintf(ps->ps_edits, "</target>");
+    if (strcmp(op, "delete") != 0 && strcmp(op, "remove") != 0){
+        /* Copy to declare namespaces inherited from ancestors */
+        if ((xc = xml_dup(x)) == NULL)
+            goto done;
+        if (xml_nsctx_node(x, &nsc) < 0)
+            goto done;
+        if (xmlns_set_all(xc, nsc) < 0)
+            goto done;
+        cprintf(ps->ps_edits, "<value>");
+        if (clixon_xml2cbuf(ps->ps_edits, xc, 0, 0, NULL, -1, 0) < 0)
+            goto done;
+        cprintf(ps->ps_edits, "</value>");
+    }
+    cprintf(ps->ps_edits, "</edit>");
+    retval = 0;
+ done:
+    if (nsc)
+        xml_nsctx_free(nsc);
+    if (xc)
+        xml_free(xc);
+    return retval;
+}
+
+/*! Get nodes of a tree selected by a subscription, sorted by push_cmp
+ *
+ * Errors of the selection are logged, no nodes are then selected
+ * @param[in]  h     Clixon handle
+ * @param[in]  ps    Subscription with selection filter
+ * @param[in]  xt    Top of tree
+ * @param[out] vecp  Selected nodes, free after use
+ * @param[out] lenp  Number of selected nodes
+ * @retval     0     OK
+ */
+static int
+push_select(clixon_handle     h,
+            struct push_sub  *ps,
+            cxobj            *xt,
+            cxobj          ***vecp,
+            size_t           *lenp)
+{
+    *vecp = NULL;
+    *lenp = 0;
+    if (xt == NULL)
+        return 0;
+    if (xpath_vec(xt, ps->ps_nsc, "%s", vecp, lenp, ps->ps_xpath) < 0){
+        clixon_log(h, LOG_WARNING, "%s: subscription %u: %s",
+                   __FUNCTION__, ps->ps_id, clixon_err_reason());
+        clixon_err_reset();
+        *lenp = 0;
+    }
+    if (*lenp > 1)
+        qsort(*vecp, *lenp, sizeof(cxobj *), push_cmp);
+    return 0;
+}
+
+/*! Add edits of changed nodes of one tree that are selected by a subscription
+ *
+ * A change is sent if the changed node or one of its ancestors is selected.
+ * If only descendants of a changed node are selected, the change is sent for the
+ * topmost selected descendants
+ * @param[in]  ps    Subscription
+ * @param[in]  sel   Selected nodes, sorted by push_cmp, if ps has a selection
+ * @param[in]  nsel  Number of selected nodes
+ * @param[in]  vec   Changed nodes
+ * @param[in]  len   Number of changed nodes
+ * @param[in]  op    YANG-Patch operation of the changes
+ * @retval     0     OK
+ * @retval    -1    Error
+ */
+static int
+push_changes(struct push_sub *ps,
+             cxobj          **sel,
+             size_t           nsel,
+             cxobj          **vec,
+             size_t           len,
+             const char      *op)
+{
+    int     retval = -1;
+    cxobj **chg = NULL;
+    cxobj  *xp;
+    size_t  i;
+
+    if (len == 0)
+        goto ok;
+    if (ps->ps_xpath == NULL){
+        for (i=0; i<len; i++)
+            if (push_edit_add(ps, op, vec[i]) < 0)
+                goto done;
+        goto ok;
+    }
+    if (nsel == 0)
+        goto ok;
+    for (i=0; i<len; i++)
+        for (xp = vec[i]; xp != NULL; xp = xml_parent(xp))
+            if (push_in(sel, nsel, xp)){
+                if (push_edit_add(ps, op, vec[i]) < 0)
+                    goto done;
+                break;
+            }
+    if ((chg = malloc(len*sizeof(cxobj *))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    memcpy(chg, vec, len*sizeof(cxobj *));
+    qsort(chg, len, sizeof(cxobj *), push_cmp);
+    for (i=0; i<nsel; i++)
+        for (xp = xml_parent(sel[i]); xp != NULL; xp = xml_parent(xp)){
+            if (push_in(sel, nsel, xp)) /* Sent with selected ancestor */
+                break;
+            if (push_in(chg, len, xp)){
+                if (push_edit_add(ps, op, sel[i]) < 0)
+                    goto done;
+                break;
+            }
+        }
+ ok:
+    retval = 0;
+ done:
+    if (chg)
+        free(chg);
+    return retval;
+}
+
+/*! Send collected edits of a subscription as a push-change-update notification
+ *
+ * @param[in]  h    Clixon handle
+ * @param[in]  ps   Subscription
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+push_send(clixon_handle    h,
+          struct push_sub *ps)
+{
+    int retval = -1;
+
+    gettimeofday(&ps->ps_last, NULL);
+    if (ps->ps_nedit == 0)
+        goto ok;
+    if (stream_notify(h, PUSH_STREAM,
+                      "<push-change-update xmlns=\"%s\"><id>%u</id><datastore>%s</datastore>"
+                      "<datastore-changes><yang-patch><patch-id>%" PRIu64 "</patch-id>%s"
+                      "</yang-patch></datastore-changes></push-change-update>",
+                      CLIXON_LIB_NS, ps->ps_id, ps->ps_datastore, ps->ps_patch,
+                      cbuf_get(ps->ps_edits)) < 0)
+        goto done;
+    ps->ps_patch++;
+    cbuf_reset(ps->ps_edits);
+    ps->ps_nedit = 0;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Dampening period of a subscription has expired, send collected edits
+ *
+ * @param[in]  fd   Not used
+ * @param[in]  arg  Subscription
+ */
+static int
+push_timeout(int   fd,
+             void *arg)
+{
+    struct push_sub *ps = (struct push_sub *)arg;
+
+    ps->ps_timer = 0;
+    return push_send(ps->ps_h, ps);
+}
+
+/*! Send collected edits of a subscription now, or when its dampening period expires
+ *
+ * @param[in]  h    Clixon handle
+ * @param[in]  ps   Subscription
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+push_update(clixon_handle    h,
+            struct push_sub *ps)
+{
+    struct timeval now;
+    struct timeval t;
+    struct timeval t1;
+
+    if (ps->ps_nedit == 0 || ps->ps_timer)
+        return 0;
+    if (ps->ps_dampening == 0)
+        return push_send(h, ps);
+    gettimeofday(&now, NULL);
+    t1.tv_sec = ps->ps_dampening / 100;
+    t1.tv_usec = (ps->ps_dampening % 100) * 10000;
+    timeradd(&ps->ps_last, &t1, &t);
+    if (!timercmp(&now, &t, <))
+        return push_send(h, ps);
+    if (clixon_event_reg_timeout(t, push_timeout, ps, "yang-push dampening") < 0)
+        return -1;
+    ps->ps_timer = 1;
+    return 0;
+}
+
+/*! Send changes of a commit to subscriptions of running
+ *
+ * Must be called while the source tree of the transaction is valid
+ * @param[in]  h    Clixon handle
+ * @param[in]  td   Transaction data
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+backend_push_commit(clixon_handle       h,
+                    transaction_data_t *td)
+{
+    int              retval = -1;
+    struct push_sub *ps;
+    cxobj          **src = NULL;
+    cxobj          **tgt = NULL;
+    size_t           nsrc = 0;
+    size_t           ntgt = 0;
+
+    for (ps = _push_subs; ps != NULL; ps = ps->ps_next){
+        if (ps->ps_sampler || strcmp(ps->ps_datastore, "running") != 0)
+            continue;
+        if (ps->ps_xpath){
+            push_select(h, ps, td->td_src, &src, &nsrc);
+            push_select(h, ps, td->td_target, &tgt, &ntgt);
+        }
+        if (push_changes(ps, src, nsrc, td->td_dvec, td->td_dlen, "delete") < 0)
+            goto done;
+        if (push_changes(ps, tgt, ntgt, td->td_avec, td->td_alen, "create") < 0)
+            goto done;
+        if (push_changes(ps, tgt, ntgt, td->td_tcvec, td->td_clen, "replace") < 0)
+            goto done;
+        if (src){
+            free(src);
+            src = NULL;
+        }
+        if (tgt){
+            free(tgt);
+            tgt = NULL;
+        }
+        if (push_update(h, ps) < 0)
+            goto done;
+    }
+    retval = 0;
+ done:
+    if (src)
+        free(src);
+    if (tgt)
+        free(tgt);
+    return retval;
+}
+
+/*! Send an update of pushed state data to subscriptions of operational
+ *
+ * @param[in]  h    Clixon handle
+ * @param[in]  xt   Update, top-level symbol is dummy
+ * @param[in]  op   Operation of update
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see clixon_statedata_push
+ */
+int
+backend_push_state(clixon_handle       h,
+                   cxobj              *xt,
+                   enum operation_type op)
+{
+    int              retval = -1;
+    struct push_sub *ps;
+    cxobj          **vec = NULL;
+    int              len = 0;
+    cxobj          **sel = NULL;
+    size_t           nsel = 0;
+    cxobj           *x = NULL;
+    const char      *opstr;
+
+    if (_push_subs == NULL)
+        goto ok;
+    opstr = op == OP_NONE ? "merge" : xml_operation2str(op);
+    while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL)
+        if (cxvec_append(x, &vec, &len) < 0)
+            goto done;
+    for (ps = _push_subs; ps != NULL; ps = ps->ps_next){
+        if (ps->ps_sampler || strcmp(ps->ps_datastore, "operational") != 0)
+            continue;
+        if (ps->ps_xpath)
+            push_select(h, ps, xt, &sel, &nsel);
+        if (push_changes(ps, sel, nsel, vec, (size_t)len, opstr) < 0)
+            goto done;
+        if (sel){
+            free(sel);
+            sel = NULL;
+        }
+        if (push_update(h, ps) < 0)
+            goto done;
+    }
+ ok:
+    retval = 0;
+ done:
+    if (sel)
+        free(sel);
+    if (vec)
+        free(vec);
+    return retval;
+}
+
+/*! Sample the data of a periodic sampler and send it to all its subscriptions
+ *
+ * The notification has the ids of all subscriptions of the sampler, each of them
+ * matches it with its stream filter
+ * @param[in]  h    Clixon handle
+ * @param[in]  sp   Sampler
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+push_sample(clixon_handle        h,
+            struct push_sampler *sp)
+{
+    int              retval = -1;
+    struct push_sub *ps;
+    cxobj           *xt = NULL;
+    cbuf            *cb = NULL;
+    netconf_content  content;
+    int              ret;
+
+    content = strcmp(sp->sp_datastore, "operational") == 0 ? CONTENT_ALL : CONTENT_CONFIG;
+    if ((ret = backend_get_data(h, content, sp->sp_xpath, sp->sp_nsc, &xt)) < 0)
+        goto done;
+    if (ret == 0){
+        clixon_log_xml(h, LOG_WARNING, xt, "%s: periodic sample of %s failed, skipped",
+                       __FUNCTION__, sp->sp_datastore);
+        goto ok;
+    }
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cb, "<push-update xmlns=\"%s\">", CLIXON_LIB_NS);
+    for (ps = _push_subs; ps != NULL; ps = ps->ps_next)
+        if (ps->ps_sampler == sp)
+            cprintf(cb, "<id>%u</id>", ps->ps_id);
+    cprintf(cb, "<datastore>%s</datastore><datastore-contents>", sp->sp_datastore);
+    if (clixon_xml2cbuf(cb, xt, 0, 0, NULL, -1, 1) < 0)
+        goto done;
+    cprintf(cb, "</datastore-contents></push-update>");
+    if (stream_notify(h, PUSH_STREAM, "%s", cbuf_get(cb)) < 0)
+        goto done;
+ ok:
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    if (xt)
+        xml_free(xt);
+    return retval;
+}
+
+/*! Period of a sampler has expired, schedule the next and sample
+ *
+ * @param[in]  fd   Not used
+ * @param[in]  arg  Sampler
+ */
+static int
+push_sample_timeout(int   fd,
+                    void *arg)
+{
+    struct push_sampler *sp = (struct push_sampler *)arg;
+    struct timeval       now;
+    struct timeval       t1;
+
+    gettimeofday(&now, NULL);
+    t1.tv_sec = sp->sp_period / 100;
+    t1.tv_usec = (sp->sp_period % 100) * 10000;
+    timeradd(&sp->sp_tick, &t1, &sp->sp_tick);
+    if (timercmp(&sp->sp_tick, &now, <)) /* Late, skip missed periods */
+        timeradd(&now, &t1, &sp->sp_tick);
+    if (clixon_event_reg_timeout(sp->sp_tick, push_sample_timeout, sp, "yang-push period") < 0)
+        return -1;
+    return push_sample(sp->sp_h, sp);
+}
+
+/*! Find or create the sampler of a periodic subscription
+ *
+ * @param[in]  h          Clixon handle
+ * @param[in]  datastore  running or operational
+ * @param[in]  xpath      Selection filter, or NULL for all
+ * @param[in]  nsc        Namespace context of selection
+ * @param[in]  period     Period in centiseconds
+ * @param[out] spp        Sampler, with a new reference
+ * @param[out] cbret      Error message if retval is 0
+ * @retval     1          OK
+ * @retval     0          Failed, cbret contains error message
+ * @retval    -1          Error
+ */
+static int
+push_sampler_get(clixon_handle         h,
+                 const char           *datastore,
+                 const char           *xpath,
+                 cvec                 *nsc,
+                 uint32_t              period,
+                 struct push_sampler **spp,
+                 cbuf                 *cbret)
+{
+    int                  retval = -1;
+    struct push_sampler *sp = NULL;
+    char                *xpath1 = NULL;
+    cvec                *nsc1 = NULL;
+    cbuf                *cbreason = NULL;
+    yang_stmt           *yspec;
+    struct timeval       now;
+    struct timeval       t1;
+    int                  ret;
+
+    if ((yspec = clicon_dbspec_yang(h)) == NULL){
+        clixon_err(OE_YANG, ENOENT, "No yang spec");
+        goto done;
+    }
+    /* Canonical prefixes so that equal selections are shared */
+    if (xpath){
+        if ((ret = xpath2canonical(xpath, nsc, yspec, &xpath1, &nsc1, &cbreason)) < 0)
+            goto done;
+        if (ret == 0){
+            if (netconf_invalid_value(cbret, "application", cbuf_get(cbreason)) < 0)
+                goto done;
+            goto fail;
+        }
+    }
+    for (sp = _push_samplers; sp != NULL; sp = sp->sp_next)
+        if (sp->sp_period == period &&
+            strcmp(sp->sp_datastore, datastore) == 0 &&
+            (xpath1 ? (sp->sp_xpath && strcmp(sp->sp_xpath, xpath1) == 0) : sp->sp_xpath == NULL))
+            break;
+    if (sp == NULL){
+        if ((sp = malloc(sizeof(*sp))) == NULL){
+            clixon_err(OE_UNIX, errno, "malloc");
+            goto done;
+        }
+        memset(sp, 0, sizeof(*sp));
+        sp->sp_h = h;
+        sp->sp_period = period;
+        sp->sp_xpath = xpath1;
+        xpath1 = NULL;
+        sp->sp_nsc = nsc1;
+        nsc1 = NULL;
+        if ((sp->sp_datastore = strdup(datastore)) == NULL){
+            clixon_err(OE_UNIX, errno, "strdup");
+            push_sampler_free(sp);
+            goto done;
+        }
+        /* First sample after one period */
+        gettimeofday(&now, NULL);
+        t1.tv_sec = period / 100;
+        t1.tv_usec = (period % 100) * 10000;
+        timeradd(&now, &t1, &sp->sp_tick);
+        if (clixon_event_reg_timeout(sp->sp_tick, push_sample_timeout, sp, "yang-push period") < 0){
+            push_sampler_free(sp);
+            goto done;
+        }
+        sp->sp_next = _push_samplers;
+        _push_samplers = sp;
+    }
+    sp->sp_refs++;
+    *spp = sp;
+    retval = 1;
+ done:
+    if (xpath1)
+        free(xpath1);
+    if (nsc1)
+        xml_nsctx_free(nsc1);
+    if (cbreason)
+        cbuf_free(cbreason);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Establish an on-change or periodic subscription
+ *
+ * @param[in]  h          Clixon handle
+ * @param[in]  session    Session id of subscriber
+ * @param[in]  datastore  running or operational
+ * @param[in]  xpath      Selection filter, or NULL for all changes
+ * @param[in]  nsc        Namespace context of selection, consumed
+ * @param[in]  dampening  Dampening period in centiseconds, if on-change
+ * @param[in]  period     Period in centiseconds if periodic, 0 if on-change
+ * @param[in]  fn         Stream callback of session
+ * @param[in]  arg        Argument of stream callback
+ * @param[out] id         Subscription id
+ * @param[out] cbret      Error message if retval is 0
+ * @retval     1          OK
+ * @retval     0          Failed, cbret contains error message
+ * @retval    -1          Error
+ */
+int
+backend_push_establish(clixon_handle h,
+                       uint32_t      session,
+                       const char   *datastore,
+                       const char   *xpath,
+                       cvec         *nsc,
+                       uint32_t      dampening,
+                       uint32_t      period,
+                       stream_fn_t   fn,
+                       void         *arg,
+                       uint32_t     *id,
+                       cbuf         *cbret)
+{
+    int              retval = -1;
+    struct push_sub *ps = NULL;
+    xpath_tree      *xptree = NULL;
+    cbuf            *cb = NULL;
+    int              ret;
+
+    if (!_push_stream){
+        if (netconf_operation_not_supported(cbret, "application",
+                                            "Subscriptions not enabled, see CLICON_STREAM_YANG_PUSH") < 0)
+            goto done;
+        goto fail;
+    }
+    if (xpath && xpath_parse(xpath, &xptree) < 0){
+        clixon_err_reset();
+        if (netconf_invalid_value(cbret, "application", "Invalid xpath selection") < 0)
+            goto done;
+        goto fail;
+    }
+    if ((ps = malloc(sizeof(*ps))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    memset(ps, 0, sizeof(*ps));
+    ps->ps_h = h;
+    ps->ps_session = session;
+    ps->ps_nsc = nsc;
+    nsc = NULL;
+    ps->ps_dampening = dampening;
+    if ((ps->ps_datastore = strdup(datastore)) == NULL ||
+        (xpath && (ps->ps_xpath = strdup(xpath)) == NULL)){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    if ((ps->ps_edits = cbuf_new()) == NULL ||
+        (cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if (period){
+        if ((ret = push_sampler_get(h, datastore, xpath, ps->ps_nsc, period,
+                                    &ps->ps_sampler, cbret)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+    }
+    ps->ps_id = ++_push_id;
+    cprintf(cb, "%s[id='%u']", period ? "push-update" : "push-change-update", ps->ps_id);
+    if ((ps->ps_ss = stream_ss_add(h, PUSH_STREAM, cbuf_get(cb), NULL, NULL, fn, arg)) == NULL)
+        goto done;
+    ps->ps_next = _push_subs;
+    _push_subs = ps;
+    *id = ps->ps_id;
+    ps = NULL;
+    retval = 1;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    if (xptree)
+        xpath_tree_free(xptree);
+    if (nsc)
+        xml_nsctx_free(nsc);
+    if (ps)
+        push_sub_free(ps);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Delete a subscription and its stream subscription
+ */
+static int
+push_delete(clixon_handle      h,
+            struct push_sub  **psp)
+{
+    struct push_sub *ps = *psp;
+    event_stream_t  *es;
+
+    *psp = ps->ps_next;
+    if (ps->ps_ss && (es = stream_find(h, PUSH_STREAM)) != NULL)
+        if (stream_ss_rm(h, es, ps->ps_ss, 1) < 0)
+            return -1;
+    push_sub_free(ps);
+    return 0;
+}
+
+/*! Delete a subscription of a session
+ *
+ * @param[in]  h        Clixon handle
+ * @param[in]  session  Session id of subscriber
+ * @param[in]  id       Subscription id
+ * @retval     1        OK
+ * @retval     0        No such subscription of session
+ * @retval    -1        Error
+ */
+int
+backend_push_delete(clixon_handle h,
+                    uint32_t      session,
+                    uint32_t      id)
+{
+    struct push_sub **psp;
+
+    for (psp = &_push_subs; *psp != NULL; psp = &(*psp)->ps_next)
+        if ((*psp)->ps_id == id && (*psp)->ps_session == session){
+            if (push_delete(h, psp) < 0)
+                return -1;
+            return 1;
+        }
+    return 0;
+}
+
+/*! Delete all subscriptions of a session
+ *
+ * @param[in]  h        Clixon handle
+ * @param[in]  session  Session id of subscriber
+ * @retval     0        OK
+ * @retval    -1        Error
+ */
+int
+backend_push_session_rm(clixon_handle h,
+                        uint32_t      session)
+{
+    struct push_sub **psp = &_push_subs;
+
+    while (*psp != NULL)
+        if ((*psp)->ps_session == session){
+            if (push_delete(h, psp) < 0)
+                return -1;
+        }
+        else
+            psp = &(*psp)->ps_next;
+    return 0;
+}
+
+/*! Initialize subscriptions, add stream if CLICON_STREAM_YANG_PUSH
+ *
+ * @param[in]  h    Clixon handle
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+backend_push_init(clixon_handle h)
+{
+    if (clicon_option_bool(h, "CLICON_STREAM_YANG_PUSH")){
+        if (stream_add(h, PUSH_STREAM, "On-change subscriptions, see clixon-lib establish-push", 0, NULL) < 0)
+            return -1;
+        _push_stream = 1;
+    }
+    return 0;
+}
+
+/*! Free subscriptions and samplers
+ *
+ * Stream subscriptions are freed with the streams
+ * @param[in]  h    Clixon handle
+ */
+int
+backend_push_free(clixon_handle h)
+{
+    struct push_sub     *ps;
+    struct push_sampler *sp;
+
+    while ((ps = _push_subs) != NULL){
+        _push_subs = ps->ps_next;
+        push_sub_free(ps);
+    }
+    while ((sp = _push_samplers) != NULL){
+        _push_samplers = sp->sp_next;
+        push_sampler_free(sp);
+    }
+    _push_stream = 0;
+    return 0;
+}
@@ -0,0 +1,600 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2016 Olof Hagsand and Benny Holmgren
+  Copyright (C) 2017-2019 Olof Hagsand
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC (Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+ *
+ * Read-only replicas of running, see CLICON_BACKEND_REPLICA_OF
+ *
+ * A replica backend follows running of a primary backend over its internal socket.
+ * It subscribes to the DATASTORE-CHANGE stream of the primary, see
+ * CLICON_STREAM_DATASTORE_CHANGE, and for every commit of running on the primary it
+ * reads the changed top-level nodes with get-config and replaces them in its own
+ * running. All of running is read initially, on reconnect, and if a generation is
+ * missed, eg when the stream queue of the primary drops a notification.
+ * The data is already validated by the primary and is not validated again, and no
+ * plugin transaction callbacks are made. Changes are stamped and sent to on-change
+ * subscriptions of the replica as on a commit.
+ * Writes of configuration data are rejected, so that readers (get, get-config,
+ * subscriptions) may be spread over several replicas while writes go to the primary.
+ * A replica may be promoted to a writable backend with replica-promote of clixon-lib,
+ * eg when used as a hot standby.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <errno.h>
+#include <syslog.h>
+#include <sys/time.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include <clixon/clixon.h>
+
+#include "clixon_backend_transaction.h"
+#include "clixon_backend_commit.h"
+#include "backend_replica.h"
+
+/* Change feed stream of primary, see backend_stamp.c */
+#define REPLICA_STREAM "DATASTORE-CHANGE"
+
+/* Seconds between attempts to connect to the primary */
+#define REPLICA_RETRY 1
+
+static char    *_replica_of = NULL; /* Internal socket of primary, NULL if not replica */
+static int      _replica_s = -1;    /* Socket for get-config */
+static uint32_t _replica_id = 0;    /* Session-id of _replica_s on primary */
+static int      _replica_ns = -1;   /* Socket for notifications */
+static uint64_t _replica_gen = 0;   /* Generation of primary running last read */
+
+static int replica_notify_cb(int s, void *arg);
+static int replica_timeout(int fd, void *arg);
+
+/*! Close sockets to primary
+ */
+static void
+replica_close(void)
+{
+    if (_replica_ns != -1){
+        clixon_event_unreg_fd(_replica_ns, replica_notify_cb);
+        close(_replica_ns);
+        _replica_ns = -1;
+    }
+    if (_replica_s != -1){
+        close(_replica_s);
+        _replica_s = -1;
+    }
+    _replica_id = 0;
+}
+
+/*! Send rpc to primary and wait for reply
+ *
+ * @param[in]  h     Clixon handle
+ * @param[in]  s     Socket to primary
+ * @param[in]  id    Session-id, 0 for hello
+ * @param[in]  cb    Message
+ * @param[out] xret  Reply, unbound. Free with xml_free
+ * @retval     0     OK
+ * @retval    -1     Error, also if the reply is an rpc-error
+ */
+static int
+replica_rpc(clixon_handle h,
+            int           s,
+            uint32_t      id,
+            cbuf         *cb,
+            cxobj       **xret)
+{
+    int                retval = -1;
+    struct clicon_msg *msg = NULL;
+    char              *retdata = NULL;
+    cxobj             *xerr;
+    int                eof = 0;
+
+    if ((msg = clicon_msg_encode(id, "%s", cbuf_get(cb))) == NULL)
+        goto done;
+    if (clicon_rpc(s, _replica_of, msg, &retdata, &eof) < 0)
+        goto done;
+    if (eof || retdata == NULL){
+        clixon_err(OE_PROTO, ESHUTDOWN, "Unexpected close of primary %s", _replica_of);
+        goto done;
+    }
+    if (clixon_xml_parse_string(retdata, YB_NONE, NULL, xret, NULL) < 0)
+        goto done;
+    if ((xerr = xpath_first(*xret, NULL, "//rpc-error")) != NULL){
+        clixon_err_netconf(h, OE_NETCONF, 0, xerr, "Primary %s", _replica_of);
+        goto done;
+    }
+    retval = 0;
+ done:
+    if (msg)
+        free(msg);
+    if (retdata)
+        free(retdata);
+    return retval;
+}
+
+/*! Start rpc message to primary
+ */
+static void
+replica_rpc_start(clixon_handle h,
+                  cbuf         *cb)
+{
+    char *username;
+
+    cbuf_reset(cb);
+    cprintf(cb, "<rpc xmlns=\"%s\"", NETCONF_BASE_NAMESPACE);
+    if ((username = clicon_username_get(h)) != NULL){
+        cprintf(cb, " %s:username=\"%s\"", CLIXON_LIB_PREFIX, username);
+        cprintf(cb, " xmlns:%s=\"%s\"", CLIXON_LIB_PREFIX, CLIXON_LIB_NS);
+    }
+    cprintf(cb, " %s>", NETCONF_MESSAGE_ID_ATTR);
+}
+
+/*! Connect to the internal socket of primary and make a hello
+ *
+ * @param[in]  h     Clixon handle
+ * @param[out] sp    Socket
+ * @param[out] idp   Session-id on primary
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+replica_connect(clixon_handle h,
+                int          *sp,
+                uint32_t     *idp)
+{
+    int    retval = -1;
+    int    s = -1;
+    cbuf  *cb = NULL;
+    cxobj *xret = NULL;
+    char  *str;
+    int    ret;
+
+    if (_replica_of[0] == '/'){
+        if (clicon_rpc_connect_unix(h, _replica_of, &s) < 0)
+            goto done;
+    }
+    else if (clicon_rpc_connect_inet(h, _replica_of, clicon_sock_port(h), &s) < 0)
+        goto done;
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cb, "<hello xmlns=\"%s\">", NETCONF_BASE_NAMESPACE);
+    cprintf(cb, "<capabilities><capability>%s</capability></capabilities>",
+            NETCONF_BASE_CAPABILITY_1_1);
+    cprintf(cb, "</hello>");
+    if (replica_rpc(h, s, 0, cb, &xret) < 0)
+        goto done;
+    if ((str = xml_find_body(xpath_first(xret, NULL, "hello"), "session-id")) == NULL){
+        clixon_err(OE_XML, 0, "hello session-id");
+        goto done;
+    }
+    if ((ret = parse_uint32(str, idp, NULL)) <= 0){
+        clixon_err(OE_XML, errno, "parse_uint32");
+        goto done;
+    }
+    *sp = s;
+    s = -1;
+    retval = 0;
+ done:
+    if (s != -1)
+        close(s);
+    if (cb)
+        cbuf_free(cb);
+    if (xret)
+        xml_free(xret);
+    return retval;
+}
+
+/*! Read top-level nodes of running from primary and replace them in running
+ *
+ * @param[in]  h     Clixon handle
+ * @param[in]  yvec  Yang nodes of top-level elements, or NULL for all
+ * @param[in]  ylen  Length of yvec
+ * @param[in]  gen   Read generation of primary and set it, otherwise keep it
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+replica_sync(clixon_handle h,
+             yang_stmt   **yvec,
+             int           ylen,
+             int           gen)
+{
+    int        retval = -1;
+    yang_stmt *yspec;
+    yang_stmt *ymod;
+    cbuf      *cb = NULL;
+    cxobj     *xret = NULL;
+    cxobj     *xerr = NULL;
+    cxobj     *xd;
+    char      *str;
+    int        i;
+    int        ret;
+
+    yspec = clicon_dbspec_yang(h);
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    /* Generation before get-config: later changes are notified and read again */
+    if (gen){
+        replica_rpc_start(h, cb);
+        cprintf(cb, "<datastore-stamp xmlns=\"%s\"/></rpc>", CLIXON_LIB_NS);
+        if (replica_rpc(h, _replica_s, _replica_id, cb, &xret) < 0)
+            goto done;
+        if ((str = xml_find_body(xpath_first(xret, NULL, "rpc-reply"), "generation")) == NULL){
+            clixon_err(OE_XML, 0, "No generation in datastore-stamp of primary %s, "
+                       "is CLICON_STREAM_DATASTORE_CHANGE set?", _replica_of);
+            goto done;
+        }
+        if ((ret = parse_uint64(str, &_replica_gen, NULL)) <= 0){
+            clixon_err(OE_XML, errno, "parse_uint64");
+            goto done;
+        }
+        xml_free(xret);
+        xret = NULL;
+    }
+    replica_rpc_start(h, cb);
+    cprintf(cb, "<get-config><source><running/></source>");
+    if (yvec){
+        cprintf(cb, "<%s:filter xmlns:%s=\"%s\" %s:type=\"xpath\" %s:select=\"",
+                NETCONF_BASE_PREFIX, NETCONF_BASE_PREFIX, NETCONF_BASE_NAMESPACE,
+                NETCONF_BASE_PREFIX, NETCONF_BASE_PREFIX);
+        for (i=0; i<ylen; i++)
+            cprintf(cb, "%s/r%d:%s", i?" | ":"", i, yang_argument_get(yvec[i]));
+        cprintf(cb, "\"");
+        for (i=0; i<ylen; i++){
+            ymod = ys_module(yvec[i]);
+            cprintf(cb, " xmlns:r%d=\"%s\"", i, yang_find_mynamespace(ymod));
+        }
+        cprintf(cb, "/>");
+    }
+    cprintf(cb, "</get-config></rpc>");
+    if (replica_rpc(h, _replica_s, _replica_id, cb, &xret) < 0)
+        goto done;
+    if ((xd = xpath_first(xret, NULL, "rpc-reply/data")) == NULL){
+        clixon_err(OE_XML, 0, "No data in get-config reply of primary %s", _replica_of);
+        goto done;
+    }
+    if ((ret = xml_bind_yang(h, xd, YB_MODULE, yspec, &xerr)) < 0)
+        goto done;
+    if (ret == 0){
+        clixon_err_netconf(h, OE_YANG, 0, xerr, "Running of primary %s", _replica_of);
+        goto done;
+    }
+    if (xml_sort_recurse(xd) < 0)
+        goto done;
+    /* As when running is read from file */
+    if (xml_default_recurse(xd, 0, 0) < 0)
+        goto done;
+    if (running_replica_apply(h, xd, yvec, ylen) < 0)
+        goto done;
+    /* Publish running to local frontends, if CLICON_XMLDB_SNAPSHOT */
+    if (xmldb_snapshot_write(h) < 0)
+        goto done;
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    if (xret)
+        xml_free(xret);
+    if (xerr)
+        xml_free(xerr);
+    return retval;
+}
+
+/*! Connect to primary, subscribe to changes and read all of running
+ *
+ * On failure, the sockets are closed and a new attempt is made after REPLICA_RETRY
+ * @param[in]  h     Clixon handle
+ * @retval     0     OK
+ * @retval    -1     Fatal error
+ */
+static int
+replica_start(clixon_handle h)
+{
+    int            retval = -1;
+    cbuf          *cb = NULL;
+    cxobj         *xret = NULL;
+    uint32_t       id;
+    struct timeval t;
+
+    replica_close();
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    /* Subscribe first so that no change is lost while running is read */
+    if (replica_connect(h, &_replica_ns, &id) < 0)
+        goto retry;
+    replica_rpc_start(h, cb);
+    cprintf(cb, "<create-subscription xmlns=\"%s\"><stream>%s</stream></create-subscription></rpc>",
+            EVENT_RFC5277_NAMESPACE, REPLICA_STREAM);
+    if (replica_rpc(h, _replica_ns, id, cb, &xret) < 0)
+        goto retry;
+    if (clixon_event_reg_fd(_replica_ns, replica_notify_cb, h, "replica notification socket") < 0)
+        goto done;
+    if (replica_connect(h, &_replica_s, &_replica_id) < 0)
+        goto retry;
+    if (replica_sync(h, NULL, 0, 1) < 0)
+        goto retry;
+    clixon_log(h, LOG_NOTICE, "Replica of %s at generation %" PRIu64, _replica_of, _replica_gen);
+ ok:
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    if (xret)
+        xml_free(xret);
+    return retval;
+ retry:
+    clixon_log(h, LOG_WARNING, "Replica of %s: %s, retrying", _replica_of,
+               clixon_err_category()?clixon_err_reason():"unknown");
+    clixon_err_reset();
+    replica_close();
+    gettimeofday(&t, NULL);
+    t.tv_sec += REPLICA_RETRY;
+    if (clixon_event_reg_timeout(t, replica_timeout, h, "replica connect") < 0)
+        goto done;
+    goto ok;
+}
+
+/*! Timer for new attempt to connect to primary
+ */
+static int
+replica_timeout(int   fd,
+                void *arg)
+{
+    clixon_handle h = (clixon_handle)arg;
+
+    if (_replica_of == NULL)
+        return 0;
+    return replica_start(h);
+}
+
+/*! Read top-level nodes changed on primary, or all of running if a generation is missed
+ *
+ * @param[in]  h     Clixon handle
+ * @param[in]  xn    Notification: <datastore-change>
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+replica_change(clixon_handle h,
+               cxobj        *xn)
+{
+    int         retval = -1;
+    yang_stmt  *yspec;
+    yang_stmt  *ymod;
+    yang_stmt  *ys;
+    yang_stmt **yvec = NULL;
+    int         ylen = 0;
+    cxobj      *x;
+    char       *str;
+    char       *name;
+    uint64_t    gen;
+    int         all = 0;
+    int         ret;
+
+    if ((str = xml_find_body(xn, "datastore")) == NULL ||
+        strcmp(str, "running") != 0)
+        goto ok;
+    if ((str = xml_find_body(xn, "generation")) == NULL ||
+        (ret = parse_uint64(str, &gen, NULL)) <= 0){
+        clixon_err(OE_XML, EINVAL, "Invalid generation in datastore-change");
+        goto done;
+    }
+    if (gen <= _replica_gen) /* Already read */
+        goto ok;
+    yspec = clicon_dbspec_yang(h);
+    if ((yvec = calloc(xml_child_nr_type(xn, CX_ELMNT), sizeof(yang_stmt*))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    x = NULL;
+    while ((x = xml_child_each(xn, x, CX_ELMNT)) != NULL){
+        if (strcmp(xml_name(x), "node") != 0 ||
+            (str = xml_body(x)) == NULL)
+            continue;
+        ys = NULL;
+        if ((name = strchr(str, ':')) != NULL){
+            *name = '\0';
+            if ((ymod = yang_find_module_by_name(yspec, str)) != NULL)
+                ys = yang_find_datanode(ymod, name+1);
+            *name = ':';
+        }
+        if (ys == NULL){ /* Unknown node, eg yang of primary differs */
+            all++;
+            break;
+        }
+        yvec[ylen++] = ys;
+    }
+    /* No nodes means all changed */
+    if (all || ylen == 0 || gen != _replica_gen + 1){
+        clixon_debug(CLIXON_DBG_BACKEND, "read all at generation %" PRIu64, gen);
+        if (replica_sync(h, NULL, 0, 1) < 0)
+            goto done;
+    }
+    else {
+        if (replica_sync(h, yvec, ylen, 0) < 0)
+            goto done;
+        _replica_gen = gen;
+    }
+ ok:
+    retval = 0;
+ done:
+    if (yvec)
+        free(yvec);
+    return retval;
+}
+
+/*! Notification from primary
+ *
+ * @param[in]  s    Notification socket
+ * @param[in]  arg  Clixon handle
+ * @retval     0    OK
+ * @retval    -1    Error (fatal)
+ */
+static int
+replica_notify_cb(int   s,
+                  void *arg)
+{
+    int           retval = -1;
+    clixon_handle h = (clixon_handle)arg;
+    cbuf         *cb = NULL;
+    cxobj        *xt = NULL;
+    cxobj        *xn;
+    int           eof = 0;
+
+    if (clixon_msg_rcv11(s, NULL, 0, &cb, &eof) < 0)
+        goto retry;
+    if (eof){
+        clixon_err(OE_PROTO, ESHUTDOWN, "Primary closed socket");
+        goto retry;
+    }
+    if (cb == NULL)
+        goto ok;
+    if (clixon_xml_parse_string(cbuf_get(cb), YB_NONE, NULL, &xt, NULL) < 0)
+        goto retry;
+    if ((xn = xpath_first(xt, NULL, "notification/datastore-change")) != NULL &&
+        replica_change(h, xn) < 0)
+        goto retry;
+ ok:
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    if (xt)
+        xml_free(xt);
+    return retval;
+ retry:
+    /* Read all of running again when connected */
+    if (replica_start(h) < 0)
+        goto done;
+    goto ok;
+}
+
+/*! Check if an rpc writes configuration data, which is not allowed on a replica
+ *
+ * @param[in]  h       Clixon handle
+ * @param[in]  module  Module of rpc
+ * @param[in]  rpc     Name of rpc
+ * @retval     1       Replica and rpc writes, reject
+ * @retval     0       OK
+ */
+int
+backend_replica_write(clixon_handle h,
+                      const char   *module,
+                      const char   *rpc)
+{
+    if (_replica_of == NULL)
+        return 0;
+    if (strcmp(module, "ietf-netconf") == 0)
+        return (strcmp(rpc, "edit-config") == 0 ||
+                strcmp(rpc, "copy-config") == 0 ||
+                strcmp(rpc, "delete-config") == 0 ||
+                strcmp(rpc, "commit") == 0 ||
+                strcmp(rpc, "cancel-commit") == 0);
+    if (strcmp(module, "ietf-netconf-nmda") == 0)
+        return strcmp(rpc, "edit-data") == 0;
+    return 0;
+}
+
+/*! Stop following primary and make running writable
+ *
+ * @param[in]  h    Clixon handle
+ * @retval     1    OK
+ * @retval     0    Not a replica
+ */
+int
+backend_replica_promote(clixon_handle h)
+{
+    if (_replica_of == NULL)
+        return 0;
+    clixon_log(h, LOG_NOTICE, "Replica of %s promoted at generation %" PRIu64,
+               _replica_of, _replica_gen);
+    backend_replica_free(h);
+    return 1;
+}
+
+/*! Start following running of primary if CLICON_BACKEND_REPLICA_OF is set
+ *
+ * Should be called after startup, the startup datastore of a replica is replaced by
+ * running of the primary.
+ * If the primary is not reachable, new attempts are made until it is.
+ * @param[in]  h    Clixon handle
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+backend_replica_init(clixon_handle h)
+{
+    char *str;
+
+    if ((str = clicon_option_str(h, "CLICON_BACKEND_REPLICA_OF")) == NULL ||
+        strlen(str) == 0)
+        return 0;
+    if ((_replica_of = strdup(str)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        return -1;
+    }
+    return replica_start(h);
+}
+
+/*! Close connection to primary
+ *
+ * @param[in]  h    Clixon handle
+ */
+int
+backend_replica_free(clixon_handle h)
+{
+    if (_replica_of == NULL)
+        return 0;
+    replica_close();
+    clixon_event_unreg_timeout(replica_timeout, h);
+    free(_replica_of);
+    _replica_of = NULL;
+    _replica_gen = 0;
+    return 0;
+}
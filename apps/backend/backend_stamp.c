@@ -0,0 +1,518 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2016 Olof Hagsand and Benny Holmgren
+  Copyright (C) 2017-2019 Olof Hagsand
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC (Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Change stamps of the running datastore, used for restconf entity tags
+ *
+ * A generation counter is incremented on every commit and every top-level node
+ * of running changed by the commit is stamped with the new generation and time.
+ * Changes of running not made by commit, eg edit-config or copy-config directly to
+ * running, are detected by the running cache epoch and restamp all nodes.
+ * Stamps are kept in memory only: the entity tag includes the backend start time so
+ * that tags are not reused over a backend restart.
+ * If CLICON_STREAM_DATASTORE_CHANGE is set, every new generation of running and every
+ * edit of another datastore is also sent as a datastore-change notification on the
+ * DATASTORE-CHANGE stream, with the changed top-level nodes, so that frontends can
+ * invalidate caches without polling. So is every batch of state pushed by plugins, as
+ * changes of the "operational" datastore, see clixon_statedata_push.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <syslog.h>
+#include <time.h>
+#include <sys/time.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include <clixon/clixon.h>
+
+#include "clixon_backend_plugin.h"
+#include "backend_stamp.h"
+
+/* NACM rules, combined with the stamp of any node since they change read access */
+#define STAMP_NACM "ietf-netconf-acm:nacm"
+
+/* Change feed event stream, see CLICON_STREAM_DATASTORE_CHANGE */
+#define STAMP_STREAM "DATASTORE-CHANGE"
+
+/*! Change stamp of a node or of the whole datastore
+ */
+struct stamp {
+    uint64_t       st_gen;   /* Generation of last change */
+    struct timeval st_time;  /* Time of last change */
+};
+
+static int           _stamp_init = 0;
+static time_t        _stamp_boot;          /* Backend start, part of entity tag */
+static uint64_t      _stamp_epoch;         /* Running cache epoch at last stamp */
+static struct stamp  _stamp_base;          /* Stamp of nodes not in _stamp_nodes */
+static struct stamp  _stamp_last;          /* Last change of whole datastore */
+static clicon_hash_t *_stamp_nodes = NULL; /* <module>:<name> -> struct stamp */
+static cvec         *_stamp_pending = NULL; /* Nodes marked by commit in progress */
+static int           _stamp_pending_all = 0; /* Commit changes node without yang */
+static clicon_hash_t *_stamp_dbs = NULL;  /* Other datastores: <db> -> struct stamp */
+static int           _stamp_stream = 0;    /* Change feed stream added */
+
+/*! Get epoch of a datastore cache, 0 if not cached
+ */
+static uint64_t
+stamp_db_epoch(clixon_handle h,
+               const char   *db)
+{
+    db_elmnt *de;
+
+    if ((de = clicon_db_elmnt_get(h, db)) == NULL)
+        return 0;
+    return de->de_epoch;
+}
+
+/*! Get epoch of running cache, 0 if not cached
+ */
+static uint64_t
+stamp_epoch(clixon_handle h)
+{
+    return stamp_db_epoch(h, "running");
+}
+
+/*! Send datastore-change notification on change feed stream
+ *
+ * @param[in]  h      Clixon handle
+ * @param[in]  db     Name of datastore
+ * @param[in]  gen    New generation of running, or cache epoch of other datastores
+ * @param[in]  nodes  Changed top-level nodes as <module>:<name>, NULL if all
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+stamp_notify(clixon_handle h,
+             const char   *db,
+             uint64_t      gen,
+             cvec         *nodes)
+{
+    int     retval = -1;
+    cbuf   *cb = NULL;
+    cg_var *cv = NULL;
+
+    if (!_stamp_stream)
+        goto ok;
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cb, "<datastore-change xmlns=\"%s\">", CLIXON_LIB_NS);
+    cprintf(cb, "<datastore>%s</datastore>", db);
+    cprintf(cb, "<generation>%" PRIu64 "</generation>", gen);
+    if (nodes)
+        while ((cv = cvec_each(nodes, cv)) != NULL)
+            cprintf(cb, "<node>%s</node>", cv_name_get(cv));
+    cprintf(cb, "</datastore-change>");
+    if (stream_notify(h, STAMP_STREAM, "%s", cbuf_get(cb)) < 0)
+        goto done;
+ ok:
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Restamp all nodes with a new generation
+ */
+static int
+stamp_reset(void)
+{
+    _stamp_last.st_gen++;
+    gettimeofday(&_stamp_last.st_time, NULL);
+    _stamp_base = _stamp_last;
+    if (_stamp_nodes)
+        clicon_hash_free(_stamp_nodes);
+    if ((_stamp_nodes = clicon_hash_init()) == NULL)
+        return -1;
+    return 0;
+}
+
+/*! Initialize stamps or restamp all if running changed outside a commit
+ */
+static int
+stamp_sync(clixon_handle h)
+{
+    uint64_t epoch;
+
+    epoch = stamp_epoch(h);
+    if (!_stamp_init){
+        _stamp_boot = time(NULL);
+        _stamp_last.st_gen = 0;
+        if (stamp_reset() < 0)
+            return -1;
+        _stamp_epoch = epoch;
+        _stamp_init = 1;
+    }
+    else if (epoch != _stamp_epoch){
+        clixon_debug(CLIXON_DBG_BACKEND, "running changed outside commit");
+        if (stamp_reset() < 0)
+            return -1;
+        _stamp_epoch = epoch;
+        if (stamp_notify(h, "running", _stamp_last.st_gen, NULL) < 0)
+            return -1;
+    }
+    return 0;
+}
+
+/*! Add top-level node of x as <module>:<name> to a node vector
+ *
+ * @param[in]  nodes  Node vector
+ * @param[in]  x      Changed node
+ * @param[out] all    Set if node has no yang, ie all nodes changed
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+int
+backend_stamp_node_add(cvec  *nodes,
+                       cxobj *x,
+                       int   *all)
+{
+    int        retval = -1;
+    cxobj     *xp;
+    yang_stmt *ys;
+    yang_stmt *ymod;
+    cbuf      *cb = NULL;
+
+    while ((xp = xml_parent(x)) != NULL && xml_parent(xp) != NULL)
+        x = xp;
+    if ((ys = xml_spec(x)) == NULL || (ymod = ys_module(ys)) == NULL){
+        *all = 1;
+        goto ok;
+    }
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cb, "%s:%s", yang_argument_get(ymod), xml_name(x));
+    if (cvec_find(nodes, cbuf_get(cb)) == NULL &&
+        cvec_add_string(nodes, cbuf_get(cb), NULL) < 0){
+        clixon_err(OE_UNIX, errno, "cvec_add_string");
+        goto done;
+    }
+ ok:
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Mark top-level nodes changed by a commit, before running is written
+ *
+ * Must be called while the source tree of the transaction is valid
+ * @param[in]  h    Clixon handle
+ * @param[in]  td   Transaction data
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see backend_stamp_commit  Called when running is written
+ */
+int
+backend_stamp_mark(clixon_handle       h,
+                   transaction_data_t *td)
+{
+    int retval = -1;
+    int i;
+
+    if (stamp_sync(h) < 0)
+        goto done;
+    if (_stamp_pending == NULL &&
+        (_stamp_pending = cvec_new(0)) == NULL){
+        clixon_err(OE_UNIX, errno, "cvec_new");
+        goto done;
+    }
+    for (i=0; i<td->td_dlen; i++)
+        if (backend_stamp_node_add(_stamp_pending, td->td_dvec[i], &_stamp_pending_all) < 0)
+            goto done;
+    for (i=0; i<td->td_alen; i++)
+        if (backend_stamp_node_add(_stamp_pending, td->td_avec[i], &_stamp_pending_all) < 0)
+            goto done;
+    for (i=0; i<td->td_clen; i++)
+        if (backend_stamp_node_add(_stamp_pending, td->td_tcvec[i], &_stamp_pending_all) < 0)
+            goto done;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Stamp nodes marked by commit with a new generation, after running is written
+ *
+ * @param[in]  h    Clixon handle
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see backend_stamp_mark
+ */
+int
+backend_stamp_commit(clixon_handle h)
+{
+    int     retval = -1;
+    cg_var *cv = NULL;
+
+    if (_stamp_pending_all){
+        if (stamp_reset() < 0)
+            goto done;
+        if (stamp_notify(h, "running", _stamp_last.st_gen, NULL) < 0)
+            goto done;
+    }
+    else if (_stamp_pending && cvec_len(_stamp_pending)){
+        _stamp_last.st_gen++;
+        gettimeofday(&_stamp_last.st_time, NULL);
+        while ((cv = cvec_each(_stamp_pending, cv)) != NULL)
+            if (clicon_hash_add(_stamp_nodes, cv_name_get(cv), &_stamp_last, sizeof(_stamp_last)) == NULL)
+                goto done;
+        if (stamp_notify(h, "running", _stamp_last.st_gen, _stamp_pending) < 0)
+            goto done;
+    }
+    clixon_debug(CLIXON_DBG_BACKEND, "generation:%" PRIu64, _stamp_last.st_gen);
+    _stamp_epoch = stamp_epoch(h);
+    _stamp_pending_all = 0;
+    if (_stamp_pending){
+        cvec_free(_stamp_pending);
+        _stamp_pending = NULL;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Get entity tag, generation and last modified time of running or of a top-level node
+ *
+ * The stamp of a node is combined with the stamp of the NACM rules.
+ * @param[in]  h      Clixon handle
+ * @param[in]  node   Top-level node as <module>:<name>, or NULL for whole datastore
+ * @param[out] cbetag Entity tag (without quotes)
+ * @param[out] gen    Generation of last change
+ * @param[out] tv     Last modified time
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+int
+backend_stamp_get(clixon_handle   h,
+                  const char     *node,
+                  cbuf           *cbetag,
+                  uint64_t       *gen,
+                  struct timeval *tv)
+{
+    int           retval = -1;
+    struct stamp  st;
+    struct stamp *stn;
+    struct stamp *sta;
+
+    if (stamp_sync(h) < 0)
+        goto done;
+    if (node == NULL)
+        st = _stamp_last;
+    else {
+        if ((stn = clicon_hash_value(_stamp_nodes, node, NULL)) == NULL)
+            stn = &_stamp_base;
+        if ((sta = clicon_hash_value(_stamp_nodes, STAMP_NACM, NULL)) == NULL)
+            sta = &_stamp_base;
+        st = stn->st_gen >= sta->st_gen ? *stn : *sta;
+    }
+    cprintf(cbetag, "%lx-%" PRIx64, (unsigned long)_stamp_boot, st.st_gen);
+    *gen = st.st_gen;
+    *tv = st.st_time;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Get entity tag, generation and last modified time of another datastore than running
+ *
+ * Other datastores are not stamped by commit, instead the stamp changes whenever the
+ * cache epoch of the datastore changes. The generation of running is part of the tag
+ * since NACM rules in running change read access
+ * @param[in]  h      Clixon handle
+ * @param[in]  db     Name of datastore, eg candidate
+ * @param[out] cbetag Entity tag (without quotes)
+ * @param[out] gen    Generation, ie cache epoch of datastore
+ * @param[out] tv     Last modified time
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see backend_stamp_get  for running
+ */
+int
+backend_stamp_db_get(clixon_handle   h,
+                     const char     *db,
+                     cbuf           *cbetag,
+                     uint64_t       *gen,
+                     struct timeval *tv)
+{
+    int           retval = -1;
+    struct stamp  st0;
+    struct stamp *st;
+    uint64_t      epoch;
+
+    if (stamp_sync(h) < 0)
+        goto done;
+    if (_stamp_dbs == NULL &&
+        (_stamp_dbs = clicon_hash_init()) == NULL)
+        goto done;
+    epoch = stamp_db_epoch(h, db);
+    if ((st = clicon_hash_value(_stamp_dbs, db, NULL)) == NULL ||
+        st->st_gen != epoch){
+        st0.st_gen = epoch;
+        gettimeofday(&st0.st_time, NULL);
+        if (clicon_hash_add(_stamp_dbs, db, &st0, sizeof(st0)) == NULL)
+            goto done;
+        st = &st0;
+    }
+    cprintf(cbetag, "%lx-%" PRIx64 "-%s-%" PRIx64,
+            (unsigned long)_stamp_boot, _stamp_last.st_gen, db, epoch);
+    *gen = epoch;
+    if (timercmp(&_stamp_last.st_time, &st->st_time, >))
+        *tv = _stamp_last.st_time;
+    else
+        *tv = st->st_time;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Datastore has been edited outside a commit, send change feed notification
+ *
+ * Changes of running outside a commit restamp all nodes, see stamp_sync
+ * @param[in]  h    Clixon handle
+ * @param[in]  db   Name of datastore
+ * @param[in]  xc   Edited config, children are changed top-level nodes, or NULL if all
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+backend_stamp_edit(clixon_handle h,
+                   const char   *db,
+                   cxobj        *xc)
+{
+    int    retval = -1;
+    cvec  *nodes = NULL;
+    cxobj *x = NULL;
+    int    all = 0;
+
+    if (!_stamp_stream)
+        goto ok;
+    if (strcmp(db, "running") == 0){
+        if (stamp_sync(h) < 0)
+            goto done;
+        goto ok;
+    }
+    if (xc != NULL){
+        if ((nodes = cvec_new(0)) == NULL){
+            clixon_err(OE_UNIX, errno, "cvec_new");
+            goto done;
+        }
+        while ((x = xml_child_each(xc, x, CX_ELMNT)) != NULL)
+            if (backend_stamp_node_add(nodes, x, &all) < 0)
+                goto done;
+    }
+    if (stamp_notify(h, db, stamp_db_epoch(h, db), all ? NULL : nodes) < 0)
+        goto done;
+ ok:
+    retval = 0;
+ done:
+    if (nodes)
+        cvec_free(nodes);
+    return retval;
+}
+
+/*! Pushed state data has changed, send change feed notification
+ *
+ * @param[in]  h      Clixon handle
+ * @param[in]  gen    Generation of state data
+ * @param[in]  nodes  Changed top-level nodes as <module>:<name>, NULL if all
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see clixon_statedata_push
+ */
+int
+backend_stamp_state(clixon_handle h,
+                    uint64_t      gen,
+                    cvec         *nodes)
+{
+    return stamp_notify(h, "operational", gen, nodes);
+}
+
+/*! Initialize change stamps, add change feed stream if CLICON_STREAM_DATASTORE_CHANGE
+ *
+ * @param[in]  h    Clixon handle
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+backend_stamp_init(clixon_handle h)
+{
+    if (clicon_option_bool(h, "CLICON_STREAM_DATASTORE_CHANGE")){
+        if (stream_add(h, STAMP_STREAM, "Datastore changes, see clixon-lib datastore-change", 0, NULL) < 0)
+            return -1;
+        _stamp_stream = 1;
+    }
+    return 0;
+}
+
+/*! Free change stamps
+ *
+ * @param[in]  h    Clixon handle
+ */
+int
+backend_stamp_free(clixon_handle h)
+{
+    if (_stamp_nodes){
+        clicon_hash_free(_stamp_nodes);
+        _stamp_nodes = NULL;
+    }
+    if (_stamp_pending){
+        cvec_free(_stamp_pending);
+        _stamp_pending = NULL;
+    }
+    if (_stamp_dbs){
+        clicon_hash_free(_stamp_dbs);
+        _stamp_dbs = NULL;
+    }
+    _stamp_init = 0;
+    _stamp_stream = 0;
+    return 0;
+}
@@ -45,6 +45,8 @@
 #include <unistd.h>
 #include <stdarg.h>
 #include <errno.h>
+#include <stdint.h>
+#include <inttypes.h>
 #include <signal.h>
 #include <fcntl.h>
 #include <time.h>
@@ -151,19 +153,22 @@ startup_mode_startup(clixon_handle        h,
     }
 
     /* When a confirming-commit is issued, the confirmed-commit timeout
-     * callback is removed and then the rollback database is deleted.
+     * callback is removed and then the rollback is deleted.
      *
-     * The presence of a rollback database means that before the rollback
-     * database was deleted, either clixon_backend crashed or the machine
+     * The presence of a rollback means that before the rollback
+     * was deleted, either clixon_backend crashed or the machine
      * rebooted.
      */
     if (if_feature(yspec, "ietf-netconf", "confirmed-commit")) {
-        if ((rollback_exists = xmldb_exists(h, "rollback")) < 0) {
-            clixon_err(OE_DAEMON, 0, "Error checking for the existence of the rollback database");
+        if ((rollback_exists = rollback_db_exists(h)) < 0) {
+            clixon_err(OE_DAEMON, 0, "Error checking for the existence of the rollback");
             goto done;
         }
         if (rollback_exists == 1) {
-            ret = startup_commit(h, "rollback", cbret);
+            /* Apply any reverse diffs to running as it was before the crash */
+            if ((ret = rollback_db_create(h, "running", cbret)) == 1)
+                ret = startup_commit(h, "rollback", cbret);
+            rollback_diff_delete(h);
             switch(ret) {
                 case -1:
                 case 0:
@@ -207,14 +212,25 @@ startup_mode_startup(clixon_handle        h,
 
 /*! Merge xml in filename into database
  *
+ * If CLICON_STARTUP_CACHE_DIR is set, the parsed file is read from cache if unchanged,
+ * otherwise a copy of the parsed file is returned to be cached after validation.
+ * @param[in]  h        Clixon handle
+ * @param[in]  filename Extra XML file
+ * @param[in]  db       Database to merge into
+ * @param[out] xcachep  Parsed file to cache after validation. Free with xml_free. May be NULL
+ * @param[out] cached   Set to 1 if the file was read from cache
+ * @param[out] cbret    If status is invalid contains error message
  * @retval    1       Validation OK       
  * @retval    0       Validation failed (with cbret set)
  * @retval   -1       Error
+ * @note With the fast XML parser and no cache the file is merged entry by entry, see xmldb_put_stream
  */
 static int
 load_extraxml(clixon_handle h,
               char         *filename,
               const char   *db,
+              cxobj       **xcachep,
+              int          *cached,
               cbuf         *cbret)
 {
     int        retval =  -1;
@@ -222,15 +238,31 @@ load_extraxml(clixon_handle h,
     cxobj     *xerr = NULL;
     FILE      *fp = NULL;
     yang_stmt *yspec = NULL;
+    int        cache;
     int        ret;
 
     if (filename == NULL)
         return 1;
+    yspec = clicon_dbspec_yang(h);
+    cache = clicon_option_str(h, "CLICON_STARTUP_CACHE_DIR") != NULL;
+    if (cache){
+        if ((ret = startup_cache_read(h, "extraxml", filename, yspec, &xt)) < 0)
+            goto done;
+        if (ret == 1){
+            *cached = 1;
+            retval = xmldb_put(h, (char*)db, OP_MERGE, xt, clicon_username_get(h), cbret);
+            goto done;
+        }
+    }
     if ((fp = fopen(filename, "r")) == NULL){
         clixon_err(OE_UNIX, errno, "open(%s)", filename);
         goto done;
     }
-    yspec = clicon_dbspec_yang(h);
+    /* Merge entry by entry while parsing */
+    if (xml_parser_mode_get() == XML_PARSER_FAST && !cache){
+        retval = xmldb_put_stream(h, db, OP_MERGE, fp, clicon_username_get(h), cbret);
+        goto done;
+    }
     /* No yang check yet because it has <config> as top symbol, do it later after that is removed */
     if (clixon_xml_parse_file(fp, YB_NONE, yspec, &xt, &xerr) < 0)
         goto done;
@@ -249,6 +281,9 @@ load_extraxml(clixon_handle h,
         retval = 0;
         goto done;
     }
+    /* xmldb_put may change xt, eg strip operation attributes */
+    if (cache && xcachep && xt && (*xcachep = xml_dup(xt)) == NULL)
+        goto done;
     /* Merge user reset state */
     retval = xmldb_put(h, (char*)db, OP_MERGE, xt, clicon_username_get(h), cbret);
  done:
@@ -266,6 +301,8 @@ load_extraxml(clixon_handle h,
  * it does not trigger validation calbacks.
  * The function uses an extra "tmp" database, loads the file to it, and calls
  * the reset function on it.
+ * If the reset callbacks add nothing and the file is read unchanged from the cache in
+ * CLICON_STARTUP_CACHE_DIR, it has already been validated and validation is skipped.
  * @param[in]  h       Clixon handle
  * @param[in]  file    (Optional) extra xml file
  * @param[out] status  Startup status
@@ -289,6 +326,9 @@ startup_extraxml(clixon_handle h,
     int         ret;
     cxobj       *xt0 = NULL;
     cxobj       *xt = NULL;
+    cxobj       *xcache = NULL;
+    int          cached = 0;
+    int          empty = 0;
 
     /* Clear tmp db */
     if (xmldb_db_reset(h, tmp_db) < 0)
@@ -298,8 +338,21 @@ startup_extraxml(clixon_handle h,
         goto done;
     /* Extra XML can also be added via file */
     if (file){
+        /* A cached file is only known to be valid by itself */
+        if (clicon_option_str(h, "CLICON_STARTUP_CACHE_DIR") != NULL){
+            if ((ret = xmldb_get0(h, tmp_db, YB_MODULE, NULL, NULL, 1, 0, &xt0, NULL, NULL)) < 0)
+                goto done;
+            if (ret == 0){
+                clixon_err(OE_DB, 0, "Error when reading from %s, unknown error", tmp_db);
+                goto done;
+            }
+            empty = xml_child_nr_type(xt0, CX_ELMNT) == 0;
+            xml_free(xt0);
+            xt0 = NULL;
+        }
         /* Parse and load file into tmp db */
-        if ((ret = load_extraxml(h, file, tmp_db, cbret)) < 0)
+        if ((ret = load_extraxml(h, file, tmp_db,
+                                 empty?&xcache:NULL, &cached, cbret)) < 0)
             goto done;
         if (ret == 0)
             goto fail;
@@ -322,13 +375,20 @@ startup_extraxml(clixon_handle h,
     xt = NULL;
     /* Clear db cache so that it can be read by startup */
     xmldb_clear(h, tmp_db);
-    /* Validate the tmp db and return possibly upgraded xml in xt */
-    if ((ret = startup_validate(h, tmp_db, &xt, cbret)) < 0)
-        goto done;
-    if (ret == 0)
-        goto fail;
-    if (xt==NULL || xml_child_nr(xt)==0)
-        goto ok;
+    if (cached && empty){
+        clixon_debug(CLIXON_DBG_BACKEND, "Extra XML unchanged, skip validation");
+    }
+    else {
+        /* Validate the tmp db and return possibly upgraded xml in xt */
+        if ((ret = startup_validate(h, tmp_db, &xt, cbret)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+        if (xcache && startup_cache_write(h, "extraxml", file, clicon_dbspec_yang(h), xcache) < 0)
+            goto done;
+        if (xt==NULL || xml_child_nr(xt)==0)
+            goto ok;
+    }
     /* Ensure yang bindings and defaults that were scratched in startup_validate */
     if (xmldb_populate(h, tmp_db) < 0)
         goto done;
@@ -340,6 +400,8 @@ startup_extraxml(clixon_handle h,
  ok:
     retval = 1;
  done:
+    if (xcache)
+        xml_free(xcache);
     if (xt)
         xml_free(xt);
     if (xt0)
@@ -385,3 +447,496 @@ startup_module_state(clixon_handle h,
     retval = 0;
     goto done;
 }
+
+/*! Mix a file into a digest, FNV-1a of its contents and length
+ *
+ * @param[in]     filename  File, if it does not exist only a marker is mixed in
+ * @param[in,out] digest    Digest
+ * @retval        0         OK
+ * @retval       -1         Error
+ */
+static int
+startup_snapshot_digest_file(const char *filename,
+                             uint64_t   *digest)
+{
+    int           retval = -1;
+    FILE         *f = NULL;
+    unsigned char buf[65536];
+    size_t        len;
+    size_t        i;
+    uint64_t      h = *digest;
+    uint64_t      total = 0;
+
+    if ((f = fopen(filename, "r")) == NULL){
+        if (errno != ENOENT){
+            clixon_err(OE_UNIX, errno, "fopen(%s)", filename);
+            goto done;
+        }
+        h = (h ^ 0xff) * 0x100000001b3ULL;
+    }
+    else {
+        while ((len = fread(buf, 1, sizeof(buf), f)) > 0){
+            for (i=0; i<len; i++)
+                h = (h ^ buf[i]) * 0x100000001b3ULL;
+            total += len;
+        }
+        if (ferror(f)){
+            clixon_err(OE_UNIX, errno, "fread(%s)", filename);
+            goto done;
+        }
+        h = (h ^ total) * 0x100000001b3ULL;
+    }
+    *digest = h;
+    retval = 0;
+ done:
+    if (f)
+        fclose(f);
+    return retval;
+}
+
+/*! Mix a string into a digest
+ */
+static void
+startup_snapshot_digest_str(const char *str,
+                            uint64_t   *digest)
+{
+    const char *p;
+    uint64_t    h = *digest;
+
+    for (p = str; *p; p++)
+        h = (h ^ (unsigned char)*p) * 0x100000001b3ULL;
+    *digest = h;
+}
+
+/*! Compute digest of the backend: the clixon build and each plugin file
+ *
+ * Covers the clixon build and the file, size and modification time of each plugin.
+ * @param[in]  h       Clixon handle
+ * @param[out] digest  Digest
+ */
+static void
+startup_snapshot_digest_backend(clixon_handle h,
+                                uint64_t     *digest)
+{
+    clixon_plugin_t *cp = NULL;
+    char            *name;
+    struct stat      st;
+    uint64_t         h0 = 0xcbf29ce484222325ULL;
+
+    startup_snapshot_digest_str(CLIXON_GITHASH, &h0);
+    while ((cp = clixon_plugin_each(h, cp)) != NULL){
+        name = clixon_plugin_name_get(cp);
+        startup_snapshot_digest_str(name, &h0);
+        if (stat(name, &st) == 0){
+            h0 = (h0 ^ (uint64_t)st.st_size) * 0x100000001b3ULL;
+            h0 = (h0 ^ (uint64_t)st.st_mtim.tv_sec) * 0x100000001b3ULL;
+            h0 = (h0 ^ (uint64_t)st.st_mtim.tv_nsec) * 0x100000001b3ULL;
+        }
+    }
+    *digest = h0;
+}
+
+/*! Compute digest of a startup datastore and the backend that validated it
+ *
+ * Covers the datastore file and its journal, and the backend, see
+ * startup_snapshot_digest_backend. The YANG spec is covered by the fingerprint
+ * of the binary snapshot itself, see clixon_binary_parse_file.
+ * @param[in]  h       Clixon handle
+ * @param[in]  db      Startup datastore, eg startup or tmp
+ * @param[out] digest  Digest
+ * @retval     1       OK
+ * @retval     0       Not applicable, eg datastore split in multiple files
+ * @retval    -1       Error
+ */
+static int
+startup_snapshot_digest(clixon_handle h,
+                        const char   *db,
+                        uint64_t     *digest)
+{
+    int       retval = -1;
+    char     *filename = NULL;
+    uint64_t  h0;
+
+    if (clicon_option_bool(h, "CLICON_XMLDB_MULTI"))
+        goto skip;
+    startup_snapshot_digest_backend(h, &h0);
+    if (xmldb_db2file(h, db, &filename) < 0)
+        goto done;
+    if (startup_snapshot_digest_file(filename, &h0) < 0)
+        goto done;
+    free(filename);
+    filename = NULL;
+    if (xmldb_db2journal(h, db, &filename) < 0)
+        goto done;
+    if (startup_snapshot_digest_file(filename, &h0) < 0)
+        goto done;
+    *digest = h0;
+    retval = 1;
+ done:
+    if (filename)
+        free(filename);
+    return retval;
+ skip:
+    retval = 0;
+    goto done;
+}
+
+/*! Read a binary tree from file if its saved digest is equal to a given digest
+ *
+ * @param[in]  file    Binary tree file. The digest is in the same file name with suffix ".digest"
+ * @param[in]  digest  Expected digest
+ * @param[in]  yspec   YANG spec the tree must be bound to
+ * @param[out] xtp     Tree, bound to YANG and sorted, if retval is 1. Free with xml_free
+ * @retval     1       OK
+ * @retval     0       No file, digest or YANG spec changed
+ * @retval    -1       Error
+ */
+static int
+startup_snapshot_load(const char *file,
+                      uint64_t    digest,
+                      yang_stmt  *yspec,
+                      cxobj     **xtp)
+{
+    int        retval = -1;
+    cbuf      *cb = NULL;
+    FILE      *f = NULL;
+    uint64_t   saved;
+    cxobj     *xt = NULL;
+    int        bound = 0;
+    int        ret;
+
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cb, "%s.digest", file);
+    if ((f = fopen(cbuf_get(cb), "r")) == NULL)
+        goto skip;
+    ret = fscanf(f, "%" SCNx64, &saved);
+    fclose(f);
+    f = NULL;
+    if (ret != 1)
+        goto skip;
+    if (digest != saved){
+        clixon_debug(CLIXON_DBG_BACKEND, "Input changed since %s", file);
+        goto skip;
+    }
+    if ((f = fopen(file, "r")) == NULL)
+        goto skip;
+    if (clixon_binary_parse_file(f, YB_MODULE, yspec, &xt, &bound) < 0)
+        goto done;
+    if (!bound){
+        clixon_debug(CLIXON_DBG_BACKEND, "YANG changed since %s", file);
+        goto skip;
+    }
+    *xtp = xt;
+    xt = NULL;
+    retval = 1;
+ done:
+    if (f)
+        fclose(f);
+    if (xt)
+        xml_free(xt);
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+ skip:
+    retval = 0;
+    goto done;
+}
+
+/*! Remove the digest of a binary tree file, so that the file is not used
+ *
+ * @param[in]  file    Binary tree file
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+startup_snapshot_remove(const char *file)
+{
+    int   retval = -1;
+    cbuf *cb = NULL;
+
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cb, "%s.digest", file);
+    if (unlink(cbuf_get(cb)) < 0 && errno != ENOENT){
+        clixon_err(OE_UNIX, errno, "unlink(%s)", cbuf_get(cb));
+        goto done;
+    }
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Write a binary tree to file, with a digest of its input
+ *
+ * Any old digest is removed first, so that a tree is never paired with the digest
+ * of another input. Both files are written to temporary files and renamed.
+ * @param[in]  file    Binary tree file. The digest is in the same file name with suffix ".digest"
+ * @param[in]  digest  Digest of input
+ * @param[in]  yspec   YANG spec the tree is bound to
+ * @param[in]  xt      Tree
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+startup_snapshot_save(const char *file,
+                      uint64_t    digest,
+                      yang_stmt  *yspec,
+                      cxobj      *xt)
+{
+    int        retval = -1;
+    cbuf      *cb = NULL;
+    cbuf      *cbtmp = NULL;
+    FILE      *f = NULL;
+
+    if ((cb = cbuf_new()) == NULL || (cbtmp = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if (startup_snapshot_remove(file) < 0)
+        goto done;
+    cprintf(cb, "%s.digest", file);
+    cprintf(cbtmp, "%s.tmp", file);
+    if ((f = fopen(cbuf_get(cbtmp), "w")) == NULL){
+        clixon_err(OE_UNIX, errno, "fopen(%s)", cbuf_get(cbtmp));
+        goto done;
+    }
+    if (clixon_xml2binary_file(f, xt, yspec) < 0)
+        goto done;
+    if (fclose(f) < 0){
+        f = NULL;
+        clixon_err(OE_UNIX, errno, "fclose(%s)", cbuf_get(cbtmp));
+        goto done;
+    }
+    f = NULL;
+    if (rename(cbuf_get(cbtmp), file) < 0){
+        clixon_err(OE_UNIX, errno, "rename(%s)", file);
+        goto done;
+    }
+    cbuf_reset(cbtmp);
+    cprintf(cbtmp, "%s.tmp", cbuf_get(cb));
+    if ((f = fopen(cbuf_get(cbtmp), "w")) == NULL){
+        clixon_err(OE_UNIX, errno, "fopen(%s)", cbuf_get(cbtmp));
+        goto done;
+    }
+    fprintf(f, "%016" PRIx64 "\n", digest);
+    if (fclose(f) < 0){
+        f = NULL;
+        clixon_err(OE_UNIX, errno, "fclose(%s)", cbuf_get(cbtmp));
+        goto done;
+    }
+    f = NULL;
+    if (rename(cbuf_get(cbtmp), cbuf_get(cb)) < 0){
+        clixon_err(OE_UNIX, errno, "rename(%s)", cbuf_get(cb));
+        goto done;
+    }
+    retval = 0;
+ done:
+    if (f)
+        fclose(f);
+    if (retval < 0 && cbtmp && cbuf_len(cbtmp))
+        unlink(cbuf_get(cbtmp));
+    if (cb)
+        cbuf_free(cb);
+    if (cbtmp)
+        cbuf_free(cbtmp);
+    return retval;
+}
+
+/*! Read validated startup snapshot if the startup datastore and backend are unchanged
+ *
+ * The snapshot is the bound, sorted and default-populated startup tree that passed
+ * validation, in binary format in CLICON_STARTUP_SNAPSHOT. The digest of the datastore
+ * and backend it was validated with is in the same file name with suffix ".digest".
+ * @param[in]  h    Clixon handle
+ * @param[in]  db   Startup datastore, eg startup or tmp
+ * @param[out] xtp  Snapshot tree, bound to YANG and sorted, if retval is 1. Free with xml_free
+ * @retval     1    Snapshot valid, validation can be skipped
+ * @retval     0    No valid snapshot, validate as usual
+ * @retval    -1    Error
+ * @see startup_snapshot_write
+ */
+int
+startup_snapshot_read(clixon_handle h,
+                      const char   *db,
+                      cxobj       **xtp)
+{
+    int        retval = -1;
+    char      *snapshot;
+    uint64_t   digest;
+    int        ret;
+
+    if ((snapshot = clicon_option_str(h, "CLICON_STARTUP_SNAPSHOT")) == NULL)
+        goto skip;
+    if ((ret = startup_snapshot_digest(h, db, &digest)) < 0)
+        goto done;
+    if (ret == 0)
+        goto skip;
+    if ((ret = startup_snapshot_load(snapshot, digest, clicon_dbspec_yang(h), xtp)) < 0)
+        goto done;
+    if (ret == 0)
+        goto skip;
+    clixon_debug(CLIXON_DBG_BACKEND, "%s unchanged, using validated startup snapshot", db);
+    retval = 1;
+ done:
+    return retval;
+ skip:
+    retval = 0;
+    goto done;
+}
+
+/*! Write validated startup tree as snapshot, with digest of datastore and backend
+ *
+ * @param[in]  h    Clixon handle
+ * @param[in]  db   Startup datastore the tree was read from, eg startup or tmp
+ * @param[in]  xt   Validated startup tree, bound to YANG and sorted
+ * @retval     0    OK, or no snapshot configured
+ * @retval    -1    Error
+ * @see startup_snapshot_read
+ */
+int
+startup_snapshot_write(clixon_handle h,
+                       const char   *db,
+                       cxobj        *xt)
+{
+    int        retval = -1;
+    char      *snapshot;
+    uint64_t   digest;
+    int        ret;
+
+    if ((snapshot = clicon_option_str(h, "CLICON_STARTUP_SNAPSHOT")) == NULL)
+        goto ok;
+    if ((ret = startup_snapshot_digest(h, db, &digest)) < 0)
+        goto done;
+    if (ret == 0){
+        if (startup_snapshot_remove(snapshot) < 0)
+            goto done;
+        goto ok;
+    }
+    if (startup_snapshot_save(snapshot, digest, clicon_dbspec_yang(h), xt) < 0)
+        goto done;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Get cache file name and digest of a startup input file
+ *
+ * @param[in]  h       Clixon handle
+ * @param[in]  name    Cache name, eg extraxml or nacm
+ * @param[in]  file    Input file
+ * @param[out] cb      Cache file name
+ * @param[out] digest  Digest of the input file, its name and the backend
+ * @retval     1       OK
+ * @retval     0       No cache configured
+ * @retval    -1       Error
+ */
+static int
+startup_cache_digest(clixon_handle h,
+                     const char   *name,
+                     const char   *file,
+                     cbuf         *cb,
+                     uint64_t     *digest)
+{
+    char     *dir;
+    uint64_t  h0;
+
+    if ((dir = clicon_option_str(h, "CLICON_STARTUP_CACHE_DIR")) == NULL)
+        return 0;
+    cprintf(cb, "%s/%s.bin", dir, name);
+    startup_snapshot_digest_backend(h, &h0);
+    startup_snapshot_digest_str(file, &h0);
+    if (startup_snapshot_digest_file(file, &h0) < 0)
+        return -1;
+    *digest = h0;
+    return 1;
+}
+
+/*! Read parsed startup input file from cache, if the file is unchanged
+ *
+ * Startup input files, such as the extra XML file and the external NACM file, are cached
+ * after parsing and validation in binary format in CLICON_STARTUP_CACHE_DIR.
+ * @param[in]  h     Clixon handle
+ * @param[in]  name  Cache name, eg extraxml or nacm
+ * @param[in]  file  Input file
+ * @param[in]  yspec YANG spec of the input
+ * @param[out] xtp   Parsed tree, bound to YANG and sorted, if retval is 1. Free with xml_free
+ * @retval     1     OK, file is unchanged since it was cached
+ * @retval     0     Not cached, parse and validate the file as usual
+ * @retval    -1     Error
+ * @see startup_cache_write
+ */
+int
+startup_cache_read(clixon_handle h,
+                   const char   *name,
+                   const char   *file,
+                   yang_stmt    *yspec,
+                   cxobj       **xtp)
+{
+    int       retval = -1;
+    cbuf     *cb = NULL;
+    uint64_t  digest;
+    int       ret;
+
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if ((ret = startup_cache_digest(h, name, file, cb, &digest)) < 0)
+        goto done;
+    if (ret == 0){
+        retval = 0;
+        goto done;
+    }
+    if ((retval = startup_snapshot_load(cbuf_get(cb), digest, yspec, xtp)) == 1)
+        clixon_debug(CLIXON_DBG_BACKEND, "%s unchanged, using %s", file, cbuf_get(cb));
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Write parsed and validated startup input file to cache
+ *
+ * @param[in]  h     Clixon handle
+ * @param[in]  name  Cache name, eg extraxml or nacm
+ * @param[in]  file  Input file
+ * @param[in]  yspec YANG spec of the input
+ * @param[in]  xt    Parsed and validated tree, bound to YANG and sorted
+ * @retval     0     OK, or no cache configured
+ * @retval    -1     Error
+ * @see startup_cache_read
+ */
+int
+startup_cache_write(clixon_handle h,
+                    const char   *name,
+                    const char   *file,
+                    yang_stmt    *yspec,
+                    cxobj        *xt)
+{
+    int       retval = -1;
+    cbuf     *cb = NULL;
+    uint64_t  digest;
+    int       ret;
+
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if ((ret = startup_cache_digest(h, name, file, cb, &digest)) < 0)
+        goto done;
+    if (ret == 1 && startup_snapshot_save(cbuf_get(cb), digest, yspec, xt) < 0)
+        goto done;
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
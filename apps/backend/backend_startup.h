@@ -45,5 +45,9 @@
 int startup_mode_startup(clixon_handle h, char *db, cbuf *cbret);
 int startup_extraxml(clixon_handle h, char *file, cbuf *cbret);
 int startup_module_state(clixon_handle h, yang_stmt *yspec);
+int startup_snapshot_read(clixon_handle h, const char *db, cxobj **xtp);
+int startup_snapshot_write(clixon_handle h, const char *db, cxobj *xt);
+int startup_cache_read(clixon_handle h, const char *name, const char *file, yang_stmt *yspec, cxobj **xtp);
+int startup_cache_write(clixon_handle h, const char *name, const char *file, yang_stmt *yspec, cxobj *xt);
 
 #endif  /* _BACKEND_STARTUP_H_ */
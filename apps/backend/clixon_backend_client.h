@@ -45,6 +45,15 @@
 /*
  * Types
  */
+/* Notification queued to a client that could not be written without blocking
+ * @see ce_notify_send
+ */
+struct ce_notify{
+    struct ce_notify     *cn_next;
+    stream_msg           *cn_msg;     /* Shared notification message */
+    size_t                cn_off;     /* Bytes of message already written */
+};
+
 /* Backend client entry.
  * Keep state about every connected client.
  * References from RFC 6022, ietf-netconf-monitoring.yang sessions container
@@ -73,6 +82,25 @@ struct client_entry{
     uint32_t              ce_in_bad_rpcs;    /* Not correct <rpc> messages */
     uint32_t              ce_out_rpc_errors; /*  <rpc-error> messages*/
     uint32_t              ce_out_notifications; /* Outgoing notifications */
+    size_t                ce_msg_len;        /* Length of incoming message being handled */
+    int                   ce_pending;        /* Reply deferred, eg pending commit */
+    char                 *ce_pending_msgid;  /* message-id of deferred reply, if pipelined */
+    clixon_msg_rcv       *ce_rcv;            /* Receive state of pipelined messages */
+    int                   ce_stream;         /* Reply of message being handled may be streamed
+                                                or binary, ie not pipelined */
+    int                   ce_streamed;       /* Reply has been streamed to client socket */
+    int                   ce_binary;         /* Client accepts binary replies, see CLICON_SOCK_BINARY */
+    struct ce_notify     *ce_notify;         /* Notifications not yet written to client socket */
+    struct ce_notify     *ce_notify_last;    /* Last in notification queue */
+    size_t                ce_notify_len;     /* Bytes in notification queue */
+    int                   ce_notify_drop;    /* 1: Notifications are dropped, queue is full,
+                                                2: Disconnected, see CLICON_STREAM_QUEUE_POLICY */
+    uint32_t              ce_notify_dropped; /* Dropped notifications */
+    int                   ce_memtag;         /* Memory tag of session, 0 if none, see
+                                                CLICON_MEMORY_STATS */
+    char                 *ce_candidate;      /* Private candidate datastore, or NULL,
+                                                see CLICON_XMLDB_PRIVATE_CANDIDATE */
+    char                 *ce_candidate_base; /* Running at fork/rebase of private candidate */
 };
 typedef struct client_entry client_entry;
 
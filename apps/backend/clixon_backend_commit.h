@@ -62,7 +62,12 @@ enum confirmed_commit_state confirmed_commit_state_get(clixon_handle h);
 uint32_t confirmed_commit_session_id_get(clixon_handle h);
 int cancel_rollback_event(clixon_handle h);
 int cancel_confirmed_commit(clixon_handle h);
-int handle_confirmed_commit(clixon_handle h, cxobj *xe, uint32_t myid);
+int handle_confirmed_commit(clixon_handle h, cxobj *xe, uint32_t myid, transaction_data td);
+int rollback_db_exists(clixon_handle h);
+int rollback_db_delete(clixon_handle h);
+int rollback_diff_delete(clixon_handle h);
+int rollback_diff_materialize(clixon_handle h);
+int rollback_db_create(clixon_handle h, char *from, cbuf *cbret);
 int do_rollback(clixon_handle h, uint8_t *errs);
 int from_client_cancel_commit(clixon_handle h,  cxobj *xe, cbuf *cbret, void *arg, void *regarg);
 int from_client_confirmed_commit(clixon_handle h, cxobj *xe, uint32_t myid, cbuf *cbret);
@@ -73,6 +78,9 @@ int startup_commit(clixon_handle h, char *db, cbuf *cbret);
 int candidate_validate(clixon_handle h, char *db, cbuf *cbret);
 int candidate_commit(clixon_handle h, cxobj *xe, char *db, uint32_t myid,
                      validate_level vlev, cbuf *cbret);
+int running_direct_commit(clixon_handle h, cxobj *xc, enum operation_type op,
+                          char *username, cbuf *cbret);
+int running_replica_apply(clixon_handle h, cxobj *xt, yang_stmt **yvec, int ylen);
 
 int from_client_commit(clixon_handle h, cxobj *xe, cbuf *cbret, void *arg, void *regarg);
 int from_client_discard_changes(clixon_handle h, cxobj *xe, cbuf *cbret, void *arg, void *regarg);
@@ -191,6 +191,7 @@ backend_client_delete(clixon_handle        h,
     struct client_entry   *c;
     struct client_entry  **ce_prev;
     struct backend_handle *bh = handle(h);
+    struct ce_notify      *cn;
 
     ce_prev = &bh->bh_ce_list;
     for (c = *ce_prev; c; c = c->ce_next){
@@ -202,6 +203,19 @@ backend_client_delete(clixon_handle        h,
                 free(ce->ce_transport);
             if (ce->ce_source_host)
                 free(ce->ce_source_host);
+            if (ce->ce_pending_msgid)
+                free(ce->ce_pending_msgid);
+            if (ce->ce_candidate)
+                free(ce->ce_candidate);
+            if (ce->ce_candidate_base)
+                free(ce->ce_candidate_base);
+            if (ce->ce_rcv)
+                clixon_msg_rcv_free(ce->ce_rcv);
+            while ((cn = ce->ce_notify) != NULL){
+                ce->ce_notify = cn->cn_next;
+                stream_msg_free(cn->cn_msg);
+                free(cn);
+            }
             ce->ce_next = NULL;
             free(ce);
             break;
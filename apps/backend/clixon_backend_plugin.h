@@ -66,8 +66,28 @@ typedef struct {
     cxobj    **td_scvec;    /* Source changed xml vector */
     cxobj    **td_tcvec;    /* Target changed xml vector */
     int        td_clen;     /* Changed xml vector length */
+    clixon_plugin_t *td_cp; /* Plugin whose trans_commit callback is called, or NULL */
+    struct trans_pending *td_pending; /* Pending asynchronous commits */
+    int        td_yindexed; /* td_ychanged and td_ytouched are built, see transaction_changed */
+    yang_stmt **td_ychanged; /* Sorted yang specs of changed nodes */
+    int        td_ychlen;   /* Length of td_ychanged */
+    yang_stmt **td_ytouched; /* Sorted yang specs of changed nodes, their ancestors and modules */
+    int        td_ytolen;   /* Length of td_ytouched */
 } transaction_data_t;
 
+/*! Pending asynchronous commit of one plugin
+ *
+ * @see transaction_commit_pending
+ */
+struct trans_pending {
+    struct trans_pending *tp_next;
+    clixon_plugin_t      *tp_cp;    /* Plugin whose commit is pending */
+    int                   tp_fd;    /* Completion file descriptor */
+    trans_pending_cb_t   *tp_fn;    /* Completion callback */
+    void                 *tp_arg;   /* Completion callback argument */
+    int                   tp_rv;    /* 1: pending, 0: completed, -1: failed */
+};
+
 /*! Pagination userdata 
  *
  * Pagination can use a lock/transaction mechanism 
@@ -77,9 +97,13 @@ typedef struct {
  * state (such as a cache) and can expect more pagination calls until the running db-lock is 
  * released, (see ca_lockdb)
  * The transaction is the regular lock/unlock db of running-db of a specific session.
+ * Sequential paging may instead use a cursor: the plugin returns an opaque continuation token
+ * with a page, which is given back to the plugin when the same session requests the next page.
  * @param[in]  offset     Offset, for list pagination
  * @param[in]  limit      Limit, for list pagination
  * @param[in]  locked     "running" datastore is locked by this caller
+ * @param[in]  cursor     Continuation token of previous page, or NULL
+ * @param[out] next       Continuation token of next page, malloced, or NULL
  * @param[out] xstate     Returned xml data state tree
  * @see pagination_data in clixon_plugin.h
  * @see pagination_offset() and other accessor functions
@@ -88,6 +112,8 @@ typedef struct {
     uint32_t          pd_offset;    /* Start of pagination interval */
     uint32_t          pd_limit;     /* Number of elements (limit) */
     int               pd_locked;    /* Running datastore is locked by this caller */
+    char             *pd_cursor;    /* Continuation token from previous page, or NULL */
+    char             *pd_next;      /* Continuation token set by plugin, or NULL */
     cxobj            *pd_xstate;    /* Returned xml state tree */
 } pagination_data_t;
 
@@ -101,12 +127,23 @@ int clixon_plugin_pre_daemon_all(clixon_handle h);
 int clixon_plugin_daemon_all(clixon_handle h);
 
 int clixon_plugin_statedata_all(clixon_handle h, yang_stmt *yspec, cvec *nsc, char *xpath, cxobj **xtop);
+int clixon_statedata_cache_register(clixon_handle h, const char *plugin, const char *xpath, cvec *nsc, uint32_t ttl);
+int clixon_statedata_cache_invalidate(clixon_handle h, const char *plugin);
+int clixon_statedata_cache_free(clixon_handle h);
+int clixon_statedata_path_register(clixon_handle h, const char *plugin, const char *xpath, cvec *nsc);
+clixon_path *clixon_statedata_request(clixon_handle h);
+int clixon_statedata_path_free(clixon_handle h);
+int clixon_statedata_push(clixon_handle h, enum operation_type op, const char *xml);
+int clixon_statedata_push_flush(clixon_handle h);
 int clixon_plugin_lockdb_all(clixon_handle h, char *db, int lock, int id);
+int clixon_transaction_path_register(clixon_handle h, const char *plugin, const char *xpath, cvec *nsc);
+int clixon_transaction_path_free(clixon_handle h);
 
 int clixon_pagination_cb_register(clixon_handle h, handler_function fn, char *path, void *arg);
-int clixon_pagination_cb_call(clixon_handle h, char *xpath, int locked,
+int clixon_pagination_cb_call(clixon_handle h, char *xpath, int locked, uint32_t id,
                               uint32_t offset, uint32_t limit,
                               cxobj *xstate);
+int clixon_pagination_cursor_rm(clixon_handle h, uint32_t id);
 int clixon_pagination_free(clixon_handle h);
 
 transaction_data_t * transaction_new(void);
@@ -123,6 +160,10 @@ int plugin_transaction_complete_all(clixon_handle h, transaction_data_t *td);
 
 int plugin_transaction_commit_one(clixon_plugin_t *cp, clixon_handle h, transaction_data_t *td);
 int plugin_transaction_commit_all(clixon_handle h, transaction_data_t *td);
+int plugin_transaction_pending(transaction_data_t *td);
+int plugin_transaction_pending_event(clixon_handle h, transaction_data_t *td, int fd);
+int plugin_transaction_pending_fd(transaction_data_t *td, int fd);
+int plugin_transaction_pending_wait(clixon_handle h, transaction_data_t *td);
 
 int plugin_transaction_commit_done_one(clixon_plugin_t *cp, clixon_handle h, transaction_data_t *td);
 int plugin_transaction_commit_done_all(clixon_handle h, transaction_data_t *td);
@@ -45,6 +45,7 @@
 #include <stdarg.h>
 #include <string.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <inttypes.h>
 #include <errno.h>
 #include <ctype.h>
@@ -213,6 +214,182 @@ transaction_clen(transaction_data td)
     return ((transaction_data_t *)td)->td_clen;
 }
 
+/*! Compare yang statements by address, for qsort and bsearch
+ */
+static int
+transaction_ycmp(const void *a,
+                 const void *b)
+{
+    uintptr_t ya = (uintptr_t)*(yang_stmt **)a;
+    uintptr_t yb = (uintptr_t)*(yang_stmt **)b;
+
+    return ya < yb ? -1 : ya > yb;
+}
+
+/*! Append yang spec to vector unless equal to the last entry
+ */
+static int
+transaction_yappend(yang_stmt   *ys,
+                    yang_stmt ***vecp,
+                    int         *lenp)
+{
+    yang_stmt **vec;
+
+    if (*lenp && (*vecp)[*lenp-1] == ys)
+        return 0;
+    /* Capacity is 16, then the next power of two */
+    if (*lenp == 0 || (*lenp >= 16 && (*lenp & (*lenp-1)) == 0)){
+        if ((vec = realloc(*vecp, (*lenp ? 2*(*lenp) : 16)*sizeof(*vec))) == NULL){
+            clixon_err(OE_UNIX, errno, "realloc");
+            return -1;
+        }
+        *vecp = vec;
+    }
+    (*vecp)[(*lenp)++] = ys;
+    return 0;
+}
+
+/*! Sort yang vector and remove duplicates
+ */
+static void
+transaction_ysort(yang_stmt **vec,
+                  int        *lenp)
+{
+    int i;
+    int j;
+
+    if (*lenp == 0)
+        return;
+    qsort(vec, *lenp, sizeof(*vec), transaction_ycmp);
+    for (i=1, j=1; i<*lenp; i++)
+        if (vec[i] != vec[j-1])
+            vec[j++] = vec[i];
+    *lenp = j;
+}
+
+/*! Add yang spec of a changed node, and of its ancestors and module to the index
+ */
+static int
+transaction_yindex(transaction_data_t *td,
+                   cxobj              *x,
+                   yang_stmt         **yprev)
+{
+    yang_stmt *ys;
+    yang_stmt *yp;
+
+    if ((ys = xml_spec(x)) == NULL || ys == *yprev)
+        return 0;
+    *yprev = ys;
+    if (transaction_yappend(ys, &td->td_ychanged, &td->td_ychlen) < 0)
+        return -1;
+    for (yp = ys; yp && yang_keyword_get(yp) != Y_SPEC; yp = yang_parent_get(yp))
+        if (transaction_yappend(yp, &td->td_ytouched, &td->td_ytolen) < 0)
+            return -1;
+    if ((yp = ys_module(ys)) != NULL &&
+        transaction_yappend(yp, &td->td_ytouched, &td->td_ytolen) < 0)
+        return -1;
+    return 0;
+}
+
+/*! Check if a schema subtree has changed in a transaction
+ *
+ * The changed nodes of the transaction are indexed by yang spec on first call, so that
+ * plugins can find out cheaply if their part of the configuration has changed, without
+ * scanning the change vectors.
+ * @param[in]  td   transaction_data
+ * @param[in]  ys   Yang spec of a data node, or a yang module
+ * @retval     1    A node at, below or above ys was added, deleted or changed
+ * @retval     0    No change of ys
+ * @retval    -1    Error
+ * @see clixon_transaction_path_register  Skip plugin callbacks if no registered path changed
+ */
+int
+transaction_changed(transaction_data td,
+                    yang_stmt       *ys)
+{
+    transaction_data_t *td0 = (transaction_data_t *)td;
+    yang_stmt          *yprev = NULL;
+    yang_stmt          *yp;
+    int                 i;
+
+    if (!td0->td_yindexed){
+        for (i=0; i<td0->td_dlen; i++)
+            if (transaction_yindex(td0, td0->td_dvec[i], &yprev) < 0)
+                return -1;
+        for (i=0; i<td0->td_alen; i++)
+            if (transaction_yindex(td0, td0->td_avec[i], &yprev) < 0)
+                return -1;
+        for (i=0; i<td0->td_clen; i++)
+            if (transaction_yindex(td0, td0->td_tcvec[i], &yprev) < 0)
+                return -1;
+        transaction_ysort(td0->td_ychanged, &td0->td_ychlen);
+        transaction_ysort(td0->td_ytouched, &td0->td_ytolen);
+        td0->td_yindexed = 1;
+    }
+    /* Change at or below ys */
+    if (td0->td_ytolen &&
+        bsearch(&ys, td0->td_ytouched, td0->td_ytolen, sizeof(ys), transaction_ycmp) != NULL)
+        return 1;
+    /* Added or deleted subtree containing ys */
+    for (yp = yang_parent_get(ys); yp && yang_keyword_get(yp) != Y_SPEC; yp = yang_parent_get(yp))
+        if (td0->td_ychlen &&
+            bsearch(&yp, td0->td_ychanged, td0->td_ychlen, sizeof(yp), transaction_ycmp) != NULL)
+            return 1;
+    return 0;
+}
+
+/*! Mark the commit of the calling plugin as pending and complete it asynchronously
+ *
+ * Call from a trans_commit callback that has started a slow operation, eg a device
+ * push, and return 0. The backend continues with the other plugins, and then serves
+ * other clients from running until fn reports completion. Thereafter the transaction
+ * resumes with commit_done, or with commit_failed and revert if fn fails.
+ * The datastore locks are held while the commit is pending.
+ * @param[in]  td   transaction_data
+ * @param[in]  fd   File descriptor that is readable when the operation has progressed
+ * @param[in]  fn   Completion callback, called when fd is readable
+ * @param[in]  arg  Argument to fn
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @note Not allowed in concurrent callbacks, see CLIXON_PLUGIN_TRANS_INDEPENDENT
+ * @note For internal commits, eg startup and rollback, the backend blocks until completion
+ * @note If a later plugin fails, the pending commit is reverted and fn is not called
+ */
+int
+transaction_commit_pending(transaction_data    td,
+                           int                 fd,
+                           trans_pending_cb_t *fn,
+                           void               *arg)
+{
+    transaction_data_t   *td0 = (transaction_data_t *)td;
+    struct trans_pending *tp;
+    struct trans_pending **tpp;
+
+    if (fd < 0 || fn == NULL){
+        clixon_err(OE_PLUGIN, EINVAL, "fd or fn is invalid");
+        return -1;
+    }
+    if (td0->td_cp == NULL){
+        clixon_err(OE_PLUGIN, EINVAL, "Pending commit only allowed in (non-concurrent) trans_commit callback");
+        return -1;
+    }
+    if ((tp = malloc(sizeof(*tp))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        return -1;
+    }
+    memset(tp, 0, sizeof(*tp));
+    tp->tp_cp = td0->td_cp;
+    tp->tp_fd = fd;
+    tp->tp_fn = fn;
+    tp->tp_arg = arg;
+    tp->tp_rv = 1;
+    /* Append to keep plugin order */
+    for (tpp = &td0->td_pending; *tpp; tpp = &(*tpp)->tp_next)
+        ;
+    *tpp = tp;
+    return 0;
+}
+
 /*! Print info about transaction on FILE, including what has changed
  *
  * @param[in] f   stdio FILE
@@ -403,6 +580,49 @@ pagination_locked(pagination_data pd)
     return ((pagination_data_t *)pd)->pd_locked;
 }
 
+/*! Get pagination data: continuation token of previous page
+ *
+ * A token set with pagination_cursor_set() by the plugin when returning the previous page
+ * is returned if the same session requests the subsequent page of the same list before
+ * CLICON_PAGINATION_CURSOR_TIMEOUT.
+ * The plugin may then continue from the token instead of skipping offset entries.
+ * @param[in]  pd     Pagination userdata
+ * @retval     token  Continuation token
+ * @retval     NULL   No token: start from offset
+ */
+char*
+pagination_cursor(pagination_data pd)
+{
+    return ((pagination_data_t *)pd)->pd_cursor;
+}
+
+/*! Set pagination data: continuation token of next page
+ *
+ * The token is opaque to clixon and is copied. Any plugin state associated with the token
+ * should expire by itself since the token may never be used.
+ * @param[in]  pd     Pagination userdata
+ * @param[in]  token  Continuation token of entry following this page, or NULL for last page
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see pagination_cursor
+ */
+int
+pagination_cursor_set(pagination_data pd,
+                      const char     *token)
+{
+    pagination_data_t *pdt = (pagination_data_t *)pd;
+
+    if (pdt->pd_next){
+        free(pdt->pd_next);
+        pdt->pd_next = NULL;
+    }
+    if (token && (pdt->pd_next = strdup(token)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        return -1;
+    }
+    return 0;
+}
+
 /*! Get pagination data: Returned xml state tree
  *
  * @param[in]  pd     Pagination userdata
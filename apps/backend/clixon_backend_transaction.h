@@ -60,6 +60,8 @@ size_t  transaction_alen(transaction_data td);
 cxobj **transaction_scvec(transaction_data td);
 cxobj **transaction_tcvec(transaction_data td);
 size_t  transaction_clen(transaction_data td);
+int     transaction_changed(transaction_data td, yang_stmt *ys);
+int     transaction_commit_pending(transaction_data td, int fd, trans_pending_cb_t *fn, void *arg);
 
 int transaction_print(FILE *f, transaction_data th);
 int transaction_dbg(clixon_handle h, int dbglevel, transaction_data th, const char *msg);
@@ -72,6 +74,8 @@ int transaction_log(clixon_handle h, transaction_data th, int level, const char
 uint32_t pagination_offset(pagination_data pd);
 uint32_t pagination_limit(pagination_data pd);
 int      pagination_locked(pagination_data pd);
+char    *pagination_cursor(pagination_data pd);
+int      pagination_cursor_set(pagination_data pd, const char *token);
 cxobj   *pagination_xstate(pagination_data pd);
 
 #endif /* _CLIXON_BACKEND_TRANSACTION_H_ */
@@ -362,6 +362,374 @@ mtpoint_paths(yang_stmt *yspec0,
     return retval;
 }
 
+/*! Batch of CLI edits sent as one edit-config
+ *
+ * Edits of commands read from a file are merged into one edit tree, which is sent when
+ * it is full, when an edit overlaps a previous edit, before any other command, and at
+ * the end of the file.
+ * @see cli_batch_begin
+ */
+struct cli_batch {
+    cxobj *cb_xtop;   /* Accumulated edit-config tree */
+    int    cb_nr;     /* Number of edits in tree */
+    char  *cb_name;   /* File name for error messages */
+    int    cb_line;   /* Line number of current command */
+    int    cb_line0;  /* Line number of first edit in tree */
+    int    cb_line1;  /* Line number of last edit in tree */
+};
+
+/*! Start a batch of CLI edits
+ *
+ * @param[in]  h     Clixon handle
+ * @param[in]  name  File name for error messages
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see cli_batch_end
+ */
+static int
+cli_batch_begin(clixon_handle h,
+                const char   *name)
+{
+    int               retval = -1;
+    struct cli_batch *cb;
+
+    if ((cb = malloc(sizeof(*cb))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    memset(cb, 0, sizeof(*cb));
+    if ((cb->cb_name = strdup(name)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        free(cb);
+        goto done;
+    }
+    if (clicon_ptr_set(h, "cli-batch", cb) < 0){
+        free(cb->cb_name);
+        free(cb);
+        goto done;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Send accumulated CLI edits of a batch, if any
+ *
+ * @param[in]  h     Clixon handle
+ * @retval     0     OK, or no batch
+ * @retval    -1     Error, including the lines of the edits
+ */
+static int
+cli_batch_flush(clixon_handle h)
+{
+    int               retval = -1;
+    struct cli_batch *cb = NULL;
+    cbuf             *cbx = NULL;
+
+    if (clicon_ptr_get(h, "cli-batch", (void**)&cb) < 0 || cb == NULL ||
+        cb->cb_xtop == NULL)
+        return 0;
+    if ((cbx = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    if (clixon_xml2cbuf(cbx, cb->cb_xtop, 0, 0, NULL, -1, 0) < 0)
+        goto done;
+    xml_free(cb->cb_xtop);
+    cb->cb_xtop = NULL;
+    cb->cb_nr = 0;
+    if (clicon_rpc_edit_config(h, "candidate", OP_NONE, cbuf_get(cbx)) < 0){
+        clixon_err(clixon_err_category(), clixon_err_subnr(), "%s: lines %d-%d: %s",
+                   cb->cb_name, cb->cb_line0, cb->cb_line1, clixon_err_reason());
+        goto done;
+    }
+    retval = 0;
+ done:
+    if (cbx)
+        cbuf_free(cbx);
+    return retval;
+}
+
+/*! Send remaining CLI edits and end the batch
+ *
+ * @param[in]  h     Clixon handle
+ * @param[in]  send  If 0, discard remaining edits, eg on error
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+cli_batch_end(clixon_handle h,
+              int           send)
+{
+    int               retval = -1;
+    struct cli_batch *cb = NULL;
+
+    if (clicon_ptr_get(h, "cli-batch", (void**)&cb) < 0 || cb == NULL)
+        return 0;
+    if (send && cli_batch_flush(h) < 0)
+        goto done;
+    retval = 0;
+ done:
+    clicon_ptr_del(h, "cli-batch");
+    if (cb->cb_xtop)
+        xml_free(cb->cb_xtop);
+    free(cb->cb_name);
+    free(cb);
+    return retval;
+}
+
+/*! Set line number of current command of CLI batch
+ *
+ * @param[in]  h     Clixon handle
+ * @param[in]  line  Line number
+ */
+static void
+cli_batch_line(clixon_handle h,
+               int           line)
+{
+    struct cli_batch *cb = NULL;
+
+    if (clicon_ptr_get(h, "cli-batch", (void**)&cb) == 0 && cb != NULL)
+        cb->cb_line = line;
+}
+
+/*! Flush CLI batch unless the callback of a matched command is a batched edit
+ *
+ * Commands other than edits may depend on the edits made before them, such as commit
+ * @param[in]  h     Clixon handle
+ * @param[in]  co    Matched CLIgen object
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see clicon_parse
+ */
+int
+cli_batch_check(clixon_handle h,
+                cg_obj       *co)
+{
+    struct cli_batch *cb = NULL;
+    cg_callback      *cc;
+    cgv_fnstype_t    *fn;
+
+    if (clicon_ptr_get(h, "cli-batch", (void**)&cb) < 0 || cb == NULL ||
+        cb->cb_xtop == NULL)
+        return 0;
+    if ((cc = co->co_callbacks) != NULL && co_callback_next(cc) == NULL){
+        fn = cc->cc_fn_vec;
+        if (fn == cli_set || fn == cli_merge || fn == cli_create ||
+            fn == cli_remove || fn == cli_del ||
+            fn == cli_auto_set || fn == cli_auto_merge || fn == cli_auto_create ||
+            fn == cli_auto_del)
+            return 0;
+    }
+    return cli_batch_flush(h);
+}
+
+/*! Check if a node is in another case of a choice than any sibling of the parent
+ *
+ * Edits of different cases do not commute, the last removes the other
+ * @param[in]  xp    Parent in batch tree
+ * @param[in]  x     New child
+ * @retval     1     Conflict
+ * @retval     0     No conflict
+ */
+static int
+cli_batch_choice(cxobj *xp,
+                 cxobj *x)
+{
+    yang_stmt *y;
+    yang_stmt *ych;
+    yang_stmt *ycase;
+    yang_stmt *yc;
+    yang_stmt *ycch;
+    yang_stmt *yccase;
+    cxobj     *xc;
+
+    if ((y = xml_spec(x)) == NULL || yang_choice_case_get(y, &ycase, &ych) == 0)
+        return 0;
+    if (ycase == NULL) /* Shortcut case */
+        ycase = y;
+    xc = NULL;
+    while ((xc = xml_child_each(xp, xc, CX_ELMNT)) != NULL) {
+        if ((yc = xml_spec(xc)) == NULL || yc == y ||
+            yang_choice_case_get(yc, &yccase, &ycch) == 0 || ycch != ych)
+            continue;
+        if ((yccase ? yccase : yc) != ycase)
+            return 1;
+    }
+    return 0;
+}
+
+/*! Move a node of an edit tree to the batch tree
+ *
+ * @param[in]  x0    Parent in batch tree
+ * @param[in]  x1    Node in edit tree
+ * @param[in]  rmop  Remove operation attribute of xbot, it is in a subtree of an earlier edit
+ * @param[in]  xbot  Node of operation in edit tree
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+cli_batch_insert(cxobj *x0,
+                 cxobj *x1,
+                 int    rmop,
+                 cxobj *xbot)
+{
+    cxobj *xa;
+
+    if (rmop && (xa = xml_find_type(xbot, NETCONF_BASE_PREFIX, "operation", CX_ATTR)) != NULL)
+        xml_purge(xa);
+    if (xml_rm(x1) < 0)
+        return -1;
+    return xml_insert(x0, x1, INS_LAST, NULL, NULL);
+}
+
+/*! Add one CLI edit to the batch tree if it does not overlap earlier edits
+ *
+ * Edits of disjoint subtrees commute and are merged. Otherwise only two overlaps are
+ * merged: a leaf set inside a subtree set earlier, and a replace of a subtree with
+ * earlier edits, which removes them.
+ * @param[in]  x0    Batch tree
+ * @param[in]  xtop  Edit tree, where nodes added to batch tree are removed
+ * @param[in]  xbot  Node of operation in edit tree
+ * @param[in]  op    Operation of edit
+ * @retval     1     Added
+ * @retval     0     Overlap, not added
+ * @retval    -1     Error
+ */
+static int
+cli_batch_merge(cxobj              *x0,
+                cxobj              *xtop,
+                cxobj              *xbot,
+                enum operation_type op)
+{
+    int                 retval = -1;
+    cxobj             **vec = NULL;
+    int                 veclen = 0;
+    cxobj              *x;
+    cxobj              *x1;
+    cxobj              *x0c;
+    char               *opstr;
+    enum operation_type op0;
+    int                 literal = 0;
+    int                 leaf;
+    int                 i;
+
+    for (x = xbot; x != xtop; x = xml_parent(x))
+        if (cxvec_prepend(x, &vec, &veclen) < 0)
+            goto done;
+    leaf = xml_spec(xbot) && yang_keyword_get(xml_spec(xbot)) == Y_LEAF;
+    for (i=0; i<veclen; i++){
+        x1 = vec[i];
+        x0c = NULL;
+        if (match_base_child(x0, x1, xml_spec(x1), &x0c) < 0)
+            goto done;
+        if (x0c == NULL){
+            if (cli_batch_choice(x0, x1))
+                goto overlap;
+            if (cli_batch_insert(x0, x1, literal, xbot) < 0)
+                goto done;
+            goto added;
+        }
+        if (!literal &&
+            (opstr = xml_find_type_value(x0c, NETCONF_BASE_PREFIX, "operation", CX_ATTR)) != NULL){
+            /* Earlier edit of this node or of an ancestor of xbot */
+            if (xml_operation(opstr, &op0) < 0)
+                goto done;
+            if (!leaf ||
+                (op0 != OP_MERGE && op0 != OP_REPLACE) ||
+                (op != OP_MERGE && op != OP_REPLACE))
+                goto overlap;
+            if (x1 != xbot){
+                /* Leaf inside subtree of earlier edit: add it to that subtree */
+                literal++;
+                x0 = x0c;
+                continue;
+            }
+        }
+        else if (x1 != xbot){
+            x0 = x0c;
+            continue;
+        }
+        else if (!literal && op != OP_REPLACE)
+            goto overlap;
+        /* Same leaf: last value wins, or replace of subtree with earlier edits */
+        xml_purge(x0c);
+        if (cli_batch_insert(x0, x1, literal, xbot) < 0)
+            goto done;
+        goto added;
+    }
+ overlap:
+    retval = 0;
+    goto done;
+ added:
+    retval = 1;
+ done:
+    if (vec)
+        free(vec);
+    return retval;
+}
+
+/*! Add a CLI edit to the batch, if a batch is active
+ *
+ * @param[in]  h     Clixon handle
+ * @param[in]  xtop  Edit tree, where nodes added to batch are removed
+ * @param[in]  xbot  Node of operation in edit tree
+ * @param[in]  op    Operation of edit
+ * @retval     1     Added to batch
+ * @retval     0     No batch, send edit
+ * @retval    -1     Error
+ * @see CLICON_CLI_BATCH_SIZE
+ */
+static int
+cli_batch_add(clixon_handle       h,
+              cxobj              *xtop,
+              cxobj              *xbot,
+              enum operation_type op)
+{
+    int               retval = -1;
+    struct cli_batch *cb = NULL;
+    int               ret;
+    int               max;
+
+    if (clicon_ptr_get(h, "cli-batch", (void**)&cb) < 0 || cb == NULL)
+        return 0;
+    if (xbot == xtop){ /* Edit of whole datastore */
+        if (cli_batch_flush(h) < 0)
+            goto done;
+        return 0;
+    }
+    if (cb->cb_xtop != NULL){
+        if ((ret = cli_batch_merge(cb->cb_xtop, xtop, xbot, op)) < 0)
+            goto done;
+        if (ret == 0 && cli_batch_flush(h) < 0)
+            goto done;
+    }
+    else
+        ret = 0;
+    if (ret == 0){ /* Start new batch tree with this edit */
+        if ((cb->cb_xtop = xml_new(NETCONF_INPUT_CONFIG, NULL, CX_ELMNT)) == NULL)
+            goto done;
+        cb->cb_line0 = cb->cb_line;
+        if ((ret = cli_batch_merge(cb->cb_xtop, xtop, xbot, op)) < 0)
+            goto done;
+        if (ret == 0){
+            xml_free(cb->cb_xtop);
+            cb->cb_xtop = NULL;
+            retval = 0;
+            goto done;
+        }
+    }
+    cb->cb_nr++;
+    cb->cb_line1 = cb->cb_line;
+    if ((max = clicon_option_int(h, "CLICON_CLI_BATCH_SIZE")) > 0 && cb->cb_nr >= max){
+        if (cli_batch_flush(h) < 0)
+            goto done;
+    }
+    retval = 1;
+ done:
+    return retval;
+}
+
 /*! Modify xml datastore from a callback using xml key format strings
  *
  * @param[in]  h     Clixon handle
@@ -497,6 +865,11 @@ cli_dbxml(clixon_handle       h,
      */
     if ((ret = xml_apply0(xbot, CX_ELMNT, identityref_add_ns, yspec0)) < 0)
         goto done;
+    /* Loading a CLI file: add to batch instead of sending */
+    if ((ret = cli_batch_add(h, xtop, xbot, op)) < 0)
+        goto done;
+    if (ret == 1)
+        goto ok;
     if ((cb = cbuf_new()) == NULL){
         clixon_err(OE_XML, errno, "cbuf_new");
         goto done;
@@ -505,6 +878,7 @@ cli_dbxml(clixon_handle       h,
         goto done;
     if (clicon_rpc_edit_config(h, "candidate", OP_NONE, cbuf_get(cb)) < 0)
         goto done;
+ ok:
     retval = 0;
  done:
     if (api_path_fmt_cb)
@@ -1080,6 +1454,7 @@ cli_validate(clixon_handle h,
  * @retval     0      OK
  * @retval    -1      Error
  * @note JSON and CLI are NYI
+ * @note XML and TEXT get only the changed subtrees from the backend, see clicon_rpc_datastore_diff
  */
 int
 compare_db_names(clixon_handle    h,
@@ -1093,19 +1468,26 @@ compare_db_names(clixon_handle    h,
     cxobj           *xerr = NULL;
     cbuf            *cb = NULL;
 
-    if (clicon_rpc_get_config(h, NULL, db1, "/", NULL, NULL, &xc1) < 0)
-        goto done;
-    if ((xerr = xpath_first(xc1, NULL, "/rpc-error")) != NULL){
-        if (clixon_err_netconf(h, OE_NETCONF, 0, xerr, "Get configuration") < 0)
+    /* XML and TEXT diffs only need the changed subtrees, computed by the backend */
+    if (format == FORMAT_XML || format == FORMAT_TEXT){
+        if (clicon_rpc_datastore_diff(h, db1, db2, &xc1, &xc2) < 0)
             goto done;
-        goto done;
     }
-    if (clicon_rpc_get_config(h, NULL, db2, "/", NULL, NULL, &xc2) < 0)
-        goto done;
-    if ((xerr = xpath_first(xc2, NULL, "/rpc-error")) != NULL){
-        if (clixon_err_netconf(h, OE_NETCONF, 0, xerr, "Get configuration") < 0)
+    else {
+        if (clicon_rpc_get_config(h, NULL, db1, "/", NULL, NULL, &xc1) < 0)
             goto done;
-        goto done;
+        if ((xerr = xpath_first(xc1, NULL, "/rpc-error")) != NULL){
+            if (clixon_err_netconf(h, OE_NETCONF, 0, xerr, "Get configuration") < 0)
+                goto done;
+            goto done;
+        }
+        if (clicon_rpc_get_config(h, NULL, db2, "/", NULL, NULL, &xc2) < 0)
+            goto done;
+        if ((xerr = xpath_first(xc2, NULL, "/rpc-error")) != NULL){
+            if (clixon_err_netconf(h, OE_NETCONF, 0, xerr, "Get configuration") < 0)
+                goto done;
+            goto done;
+        }
     }
     /* Note that XML and TEXT uses a (new) structured in-mem algorithm while 
      * JSON and CLI uses (old) UNIX file diff.
@@ -1234,6 +1616,7 @@ load_config_file(clixon_handle h,
     yang_stmt       *yspec;
     cxobj           *xerr = NULL;
     char            *lineptr = NULL;
+    int              batch = 0;
 
     if (cvec_len(argv) < 2 || cvec_len(argv) > 4){
         clixon_err(OE_PLUGIN, EINVAL, "Received %d arguments. Expected: <dbname>,<varname>[,<format>]",
@@ -1312,7 +1695,12 @@ load_config_file(clixon_handle h,
             cligen_result result;            /* match result */
             int           evalresult = 0;    /* if result == 1, calback result */
             size_t        n;
+            int           line = 0;
 
+            /* Edits are merged and sent in batches, see CLICON_CLI_BATCH_SIZE */
+            if (cli_batch_begin(h, filename) < 0)
+                goto done;
+            batch++;
             while(!cligen_exiting(cli_cligen(h))) {
                 lineptr = NULL; n = 0;
                 if (getline(&lineptr, &n, fp) < 0){
@@ -1320,20 +1708,26 @@ load_config_file(clixon_handle h,
                         clixon_err(OE_UNIX, errno, "getline");
                         goto done;
                     }
-                    goto ok; /* eof, skip backend rpc since this is done by cli code */
+                    break;
                 }
+                cli_batch_line(h, ++line);
                 if (clicon_parse(h, lineptr, &mode, &result, &evalresult) < 0)
                     goto done;
-                if (result != 1) /* Not unique match */
-                    goto done;
-                if (evalresult < 0)
+                if (result != 1 || evalresult < 0){ /* Not unique match or callback error */
+                    lineptr[strcspn(lineptr, "\n")] = '\0';
+                    clixon_err(OE_CFG, EINVAL, "%s: line %d: %s", filename, line, lineptr);
                     goto done;
+                }
                 if (lineptr){
                     free(lineptr);
                     lineptr = NULL;
                 }
             }
-            break;
+            /* skip backend rpc since this is done by cli code */
+            batch = 0;
+            if (cli_batch_end(h, 1) < 0)
+                goto done;
+            goto ok;
         }
     default:
         clixon_err(OE_PLUGIN, 0, "format: %s not implemented", formatstr);
@@ -1360,6 +1754,8 @@ load_config_file(clixon_handle h,
  ok:
     ret = 0;
  done:
+    if (batch)
+        cli_batch_end(h, 0);
     if (cbxml)
         cbuf_free(cbxml);
     if (lineptr)
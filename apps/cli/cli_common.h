@@ -43,6 +43,8 @@ void  cli_signal_block(clixon_handle h);
 void  cli_signal_unblock(clixon_handle h);
 int   mtpoint_paths(yang_stmt *yspec0, char *mtpoint, char *api_path_fmt1, char **api_path_fmt01);
 cvec *cvec_append(cvec *cvv0, cvec *cvv1);
+int   expand_dbvar_cache_free(clixon_handle h);
+int   cli_batch_check(clixon_handle h, cg_obj *co);
 
 /* If you do not find a function here it may be in clixon_cli_api.h which is 
    the external API */
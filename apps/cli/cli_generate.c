@@ -88,9 +88,12 @@ You can see which CLISPEC it generates via clixon_cli -D 2:
 #include <stdlib.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <unistd.h>
+#include <inttypes.h>
 #include <syslog.h>
 #include <signal.h>
 #include <sys/param.h>
+#include <sys/stat.h>
 
 /* cligen */
 #include <cligen/cligen.h>
@@ -532,7 +535,7 @@ yang2cli_var_pattern(clixon_handle h,
         pattern = cv_string_get(cvp);
         invert = cv_flag(cvp, V_INVERT);
         cprintf(cb, " regexp:%s\"", invert?"!":"");
-        if (mode == REGEXP_POSIX){
+        if (mode != REGEXP_LIBXML2){ /* CLIgen has no pcre2, use posix */
             posix = NULL;
             if (regexp_xsd2posix(pattern, &posix) < 0)
                 goto done;
@@ -1749,6 +1752,198 @@ yang2cli_grouping(clixon_handle      h,
     goto done;
 }
 
+/*! Autocli cache of the generated clispec of the modules of one tree
+ *
+ * See CLICON_CLI_AUTOCLI_CACHE_DIR. A cache file is a header line followed by the non-empty
+ * clispecs of the modules, each as a line with module name and length (including the
+ * terminating null character) followed by the clispec:
+ *   # clixon autocli <version> <key>
+ *   <module> <len>
+ *   <clispec>\0
+ * The key is the digest of the yang spec with options and plugins, see yang_spec_digest.
+ */
+struct autocli_cache {
+    char          *ac_filename; /* Cache file */
+    uint64_t       ac_key;      /* Cache key */
+    char          *ac_buf;      /* Content of loaded cache file, or NULL */
+    clicon_hash_t *ac_mods;     /* Loaded: module name -> clispec in ac_buf */
+    FILE          *ac_f;        /* Not loaded: temporary cache file being written */
+    char          *ac_tmpname;  /* Name of temporary cache file */
+};
+
+/* Version of autocli cache file, change when generated clispec changes */
+#define AUTOCLI_CACHE_VERSION 1
+
+/*! Free autocli cache, and remove temporary file unless written
+ */
+static void
+autocli_cache_free(struct autocli_cache *ac)
+{
+    if (ac->ac_f){
+        fclose(ac->ac_f);
+        unlink(ac->ac_tmpname);
+    }
+    if (ac->ac_tmpname)
+        free(ac->ac_tmpname);
+    if (ac->ac_mods)
+        clicon_hash_free(ac->ac_mods);
+    if (ac->ac_buf)
+        free(ac->ac_buf);
+    if (ac->ac_filename)
+        free(ac->ac_filename);
+    free(ac);
+}
+
+/*! Load autocli cache file of a tree, index the clispecs of the modules
+ *
+ * @param[in]  ac     Autocli cache
+ * @retval     1      Loaded
+ * @retval     0      No cache file, or it does not match
+ * @retval    -1      Error
+ */
+static int
+autocli_cache_load(struct autocli_cache *ac)
+{
+    int           retval = -1;
+    int           fd = -1;
+    struct stat   st;
+    char         *p;
+    char         *end;
+    char         *nl;
+    char         *sp;
+    unsigned long version;
+    uint64_t      key;
+    size_t        len;
+
+    if ((fd = open(ac->ac_filename, O_RDONLY)) < 0)
+        goto miss;
+    if (fstat(fd, &st) < 0 || st.st_size == 0)
+        goto miss;
+    if ((ac->ac_buf = malloc(st.st_size + 1)) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    if (read(fd, ac->ac_buf, st.st_size) != st.st_size)
+        goto bad;
+    ac->ac_buf[st.st_size] = '\0';
+    end = ac->ac_buf + st.st_size;
+    if (sscanf(ac->ac_buf, "# clixon autocli %lu %" SCNx64, &version, &key) != 2 ||
+        version != AUTOCLI_CACHE_VERSION ||
+        (nl = strchr(ac->ac_buf, '\n')) == NULL)
+        goto bad;
+    if (key != ac->ac_key)
+        goto miss;
+    if ((ac->ac_mods = clicon_hash_init()) == NULL)
+        goto done;
+    p = nl + 1;
+    while (p < end){
+        if ((nl = memchr(p, '\n', end - p)) == NULL ||
+            (sp = memchr(p, ' ', nl - p)) == NULL)
+            goto bad;
+        *sp = '\0';
+        len = strtoul(sp + 1, NULL, 10);
+        if (len == 0 || len > (size_t)(end - (nl + 1)) || nl[len] != '\0')
+            goto bad;
+        nl++;
+        if (clicon_hash_add(ac->ac_mods, p, &nl, sizeof(nl)) == NULL)
+            goto done;
+        p = nl + len;
+    }
+    retval = 1;
+ done:
+    if (fd >= 0)
+        close(fd);
+    return retval;
+ bad:
+    clixon_log(NULL, LOG_WARNING, "Autocli cache %s: format error, ignored", ac->ac_filename);
+ miss:
+    if (ac->ac_mods){
+        clicon_hash_free(ac->ac_mods);
+        ac->ac_mods = NULL;
+    }
+    if (ac->ac_buf){
+        free(ac->ac_buf);
+        ac->ac_buf = NULL;
+    }
+    retval = 0;
+    goto done;
+}
+
+/*! Open autocli cache of a tree: load cache file or start writing a new
+ *
+ * @param[in]  h         Clixon handle
+ * @param[in]  yspec     Yang spec
+ * @param[in]  treename  Name of tree
+ * @param[out] acp       Autocli cache, or NULL if not used. Free with autocli_cache_free
+ * @retval     0         OK
+ * @retval    -1         Error
+ */
+static int
+autocli_cache_open(clixon_handle          h,
+                   yang_stmt             *yspec,
+                   char                  *treename,
+                   struct autocli_cache **acp)
+{
+    int                   retval = -1;
+    struct autocli_cache *ac = NULL;
+    char                 *cachedir;
+    cbuf                 *cb = NULL;
+    uint64_t              key;
+    int                   ret;
+
+    *acp = NULL;
+    if ((cachedir = clicon_option_str(h, "CLICON_CLI_AUTOCLI_CACHE_DIR")) == NULL ||
+        strlen(cachedir) == 0)
+        goto ok;
+    if ((ret = yang_spec_digest(h, yspec, &key)) < 0)
+        goto done;
+    if (ret == 0)
+        goto ok;
+    if ((ac = malloc(sizeof(*ac))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    memset(ac, 0, sizeof(*ac));
+    ac->ac_key = key;
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cb, "%s/%s.clispec", cachedir, treename);
+    if ((ac->ac_filename = strdup(cbuf_get(cb))) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    if ((ret = autocli_cache_load(ac)) < 0)
+        goto done;
+    if (ret == 1)
+        clixon_debug(CLIXON_DBG_CLI, "loaded %s", ac->ac_filename);
+    else {
+        /* Written to a temporary file of this process, renamed when complete */
+        cprintf(cb, ".%u.tmp", (unsigned)getpid());
+        if ((ac->ac_tmpname = strdup(cbuf_get(cb))) == NULL){
+            clixon_err(OE_UNIX, errno, "strdup");
+            goto done;
+        }
+        if ((ac->ac_f = fopen(ac->ac_tmpname, "w")) == NULL){
+            clixon_log(h, LOG_WARNING, "Autocli cache %s: %s, not written",
+                       ac->ac_tmpname, strerror(errno));
+            goto ok;
+        }
+        fprintf(ac->ac_f, "# clixon autocli %d %016" PRIx64 "\n", AUTOCLI_CACHE_VERSION, key);
+    }
+    *acp = ac;
+    ac = NULL;
+ ok:
+    retval = 0;
+ done:
+    if (ac)
+        autocli_cache_free(ac);
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
 /*! Generate clispec for all modules in yspec (except excluded)
  * 
  * Called in cli main function for top-level yangs. But may also be called dynamically for
@@ -1777,6 +1972,10 @@ yang2cli_yspec(clixon_handle      h,
     int             i;
     int             config;
     int             inext;
+    struct autocli_cache *ac = NULL;
+    char          **strp;
+    char           *str;
+    int             werr;
 
     if ((pt0 = pt_new()) == NULL){
         clixon_err(OE_UNIX, errno, "pt_new");
@@ -1786,6 +1985,8 @@ yang2cli_yspec(clixon_handle      h,
         clixon_err(OE_XML, errno, "cbuf_new");
         goto done;
     }
+    if (autocli_cache_open(h, yspec, treename, &ac) < 0)
+        goto done;
     /* Traverse YANG, loop through all modules and generate CLI */
     inext = 0;
     while ((ymod = yn_iter(yspec, &inext)) != NULL){
@@ -1796,11 +1997,23 @@ yang2cli_yspec(clixon_handle      h,
             goto done;
         if (!enable)
             continue;
-        cbuf_reset(cb);
-        if (yang2cli_stmt(h, ymod, 0, cb) < 0)
-            goto done;
-        if (cbuf_len(cb) == 0)
-            continue;
+        if (ac && ac->ac_mods){ /* Clispec from cache, modules not there are empty */
+            if ((strp = clicon_hash_value(ac->ac_mods, yang_argument_get(ymod), NULL)) == NULL)
+                continue;
+            str = *strp;
+        }
+        else {
+            cbuf_reset(cb);
+            if (yang2cli_stmt(h, ymod, 0, cb) < 0)
+                goto done;
+            if (cbuf_len(cb) == 0)
+                continue;
+            str = cbuf_get(cb);
+            if (ac && ac->ac_f){
+                fprintf(ac->ac_f, "%s %zu\n", yang_argument_get(ymod), strlen(str) + 1);
+                fwrite(str, 1, strlen(str) + 1, ac->ac_f);
+            }
+        }
         /* Note Tie-break of same top-level symbol: prefix is NYI
          * Needs to move cligen_parse_str() call here instead of later
          */
@@ -1813,8 +2026,8 @@ yang2cli_yspec(clixon_handle      h,
             goto done;
         }
         /* Parse the buffer using cligen parser. load cli syntax */
-        if (clispec_parse_str(cli_cligen(h), cbuf_get(cb), "yang2cli", NULL, pt, NULL) < 0){
-            fprintf(stderr, "%s\n", cbuf_get(cb));
+        if (clispec_parse_str(cli_cligen(h), str, "yang2cli", NULL, pt, NULL) < 0){
+            fprintf(stderr, "%s\n", str);
             goto done;
         }
         clixon_debug(CLIXON_DBG_CLI, "Generated auto-cli for module:%s",
@@ -1839,10 +2052,10 @@ yang2cli_yspec(clixon_handle      h,
         //      pt_print(stderr,pt);
         if (clicon_data_int_get(h, "autocli-print-debug") == 1)
             clixon_log(h, LOG_NOTICE, "%s: Top-level cli-spec %s:\n%s",
-                       __FUNCTION__, treename, cbuf_get(cb));
+                       __FUNCTION__, treename, str);
         else
             clixon_debug(CLIXON_DBG_CLI | CLIXON_DBG_DETAIL, "Top-level cli-spec %s:\n%s",
-                         treename, cbuf_get(cb));
+                         treename, str);
         if (cligen_parsetree_merge(pt0, NULL, pt) < 0){
             clixon_err(OE_YANG, errno, "cligen_parsetree_merge");
             goto done;
@@ -1850,6 +2063,18 @@ yang2cli_yspec(clixon_handle      h,
         pt_free(pt, 1);
         pt = NULL;
     } /* ymod */
+    /* All modules generated: replace cache file */
+    if (ac && ac->ac_f){
+        werr = ferror(ac->ac_f);
+        if (fclose(ac->ac_f) != 0)
+            werr = 1;
+        ac->ac_f = NULL;
+        if (werr || rename(ac->ac_tmpname, ac->ac_filename) < 0){
+            clixon_log(h, LOG_WARNING, "Autocli cache %s: %s, not written",
+                       ac->ac_filename, strerror(errno));
+            unlink(ac->ac_tmpname);
+        }
+    }
     /* Resolve the expand callback functions in the generated syntax.
      * This "should" only be GENERATE_EXPAND_XMLDB
      * handle=NULL for global namespace, this means expand callbacks must be in
@@ -1875,6 +2100,8 @@ yang2cli_yspec(clixon_handle      h,
 #endif
     retval = 0;
  done:
+    if (ac)
+        autocli_cache_free(ac);
     if (pt)
         pt_free(pt, 1);
     if (pt0)
@@ -1925,16 +2152,23 @@ yang2cli_grouping_wrap(cligen_handle ch,
         clixon_err(OE_UNIX, EINVAL, "Missing namep");
         goto done;
     }
+    /* Called on every treeref expansion in match and completion: return early without
+     * decoding if not a grouping or if the grouping tree is already generated */
+    if (strncmp(name, "grouping" AUTOCLI_CMD_DELIM, strlen("grouping" AUTOCLI_CMD_DELIM)) != 0)
+        goto ok;
+    if (cligen_ph_find(ch, name) != NULL){
+        if ((*namep = strdup(name)) == NULL){
+            clixon_err(OE_UNIX, errno, "strdup");
+            goto done;
+        }
+        goto ok;
+    }
     h = cligen_userhandle(ch);
     yspec = clicon_dbspec_yang(h);
     if (yang2cli_cmd_decode(name, AUTOCLI_CMD_DELIM, &tag, &domain, &spec, &modname, &grouping) < 0)
         goto done;
     if (tag == NULL || strcmp(tag, "grouping") != 0)
         goto ok;
-    if (cligen_ph_find(ch, name) != NULL){
-        *namep = strdup(name);
-        goto ok;
-    }
     if (domain == NULL || spec == NULL || modname == NULL || grouping == NULL){
         clixon_err(OE_YANG, 0, "yang2cli cmd label invalid format");
         goto done;
@@ -184,6 +184,7 @@ cli_terminate(clixon_handle h)
         xml_free(x);
     clicon_data_cvec_del(h, "cli-edit-cvv");;
     clicon_data_cvec_del(h, "cli-edit-filter");;
+    expand_dbvar_cache_free(h);
     xpath_optimize_exit();
     /* Delete all plugins, and RPC callbacks */
     clixon_plugin_module_exit(h);
@@ -67,6 +67,7 @@
 #include "cli_plugin.h"
 #include "cli_handle.h"
 #include "cli_generate.h"
+#include "cli_common.h"
 
 /*
  * Constants
@@ -572,7 +573,10 @@ clicon_parse(clixon_handle  h,
             cli_output_reset();
             if (!cligen_exiting(ch)) {
                 clixon_err_reset();
-                if ((ret = cligen_eval(ch, match_obj, cvv)) < 0) {
+                /* Send batched edits before other commands */
+                if ((ret = cli_batch_check(h, match_obj)) < 0)
+                    cli_handler_err(stdout);
+                else if ((ret = cligen_eval(ch, match_obj, cvv)) < 0) {
                     cli_handler_err(stdout);
                     if (clixon_err_subnr() == ESHUTDOWN)
                         goto done;
@@ -185,6 +185,199 @@ xpath_append(cbuf      *cb0,
     return retval;
 }
 
+/*! Cached expanded values of one datastore xpath
+ *
+ * A list of cached values is valid as long as the datastore-stamp of the datastore is
+ * unchanged.
+ * @see expand_dbvar_cache_get
+ */
+struct expand_cache {
+    struct expand_cache *ec_next;   /* LRU list, most recently used first */
+    char                *ec_db;     /* Name of datastore */
+    char                *ec_xpath;  /* XPath of expanded values */
+    char                *ec_etag;   /* Entity tag of datastore when values were fetched */
+    cvec                *ec_values; /* Expanded values */
+};
+
+/*! Free one cached expansion
+ */
+static void
+expand_cache_free1(struct expand_cache *ec)
+{
+    if (ec->ec_db)
+        free(ec->ec_db);
+    if (ec->ec_xpath)
+        free(ec->ec_xpath);
+    if (ec->ec_etag)
+        free(ec->ec_etag);
+    if (ec->ec_values)
+        cvec_free(ec->ec_values);
+    free(ec);
+}
+
+/*! Look up cached expanded values of an xpath in a datastore
+ *
+ * The entity tag of the datastore is fetched from the backend, a cheap request compared to
+ * getting the config. A cached entry of another entity tag is removed.
+ * @param[in]  h      Clixon handle
+ * @param[in]  db     Name of datastore
+ * @param[in]  xpath  XPath of expanded values
+ * @param[out] etag   Entity tag of datastore, malloced, or NULL if cache is not used
+ * @param[out] values Cached values, or NULL if not cached
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see expand_dbvar_cache_add
+ */
+static int
+expand_dbvar_cache_get(clixon_handle h,
+                       char         *db,
+                       char         *xpath,
+                       char        **etag,
+                       cvec        **values)
+{
+    int                  retval = -1;
+    struct expand_cache *ec0 = NULL;
+    struct expand_cache *ec;
+    struct expand_cache *ecprev = NULL;
+    struct timeval       tv;
+    int                  ret;
+
+    *etag = NULL;
+    *values = NULL;
+    if (clicon_option_int(h, "CLICON_CLI_EXPAND_CACHE_SIZE") <= 0)
+        goto ok;
+    if ((ret = clicon_rpc_datastore_stamp(h, db, NULL, etag, &tv)) < 0)
+        goto done;
+    if (ret == 0) /* Not supported by backend */
+        goto ok;
+    clicon_ptr_get(h, "expand-dbvar-cache", (void**)&ec0);
+    for (ec = ec0; ec; ecprev = ec, ec = ec->ec_next){
+        if (strcmp(ec->ec_db, db) == 0 && strcmp(ec->ec_xpath, xpath) == 0)
+            break;
+    }
+    if (ec == NULL)
+        goto ok;
+    if (ecprev)
+        ecprev->ec_next = ec->ec_next;
+    else
+        ec0 = ec->ec_next;
+    if (strcmp(ec->ec_etag, *etag) != 0){
+        expand_cache_free1(ec);
+    }
+    else {
+        ec->ec_next = ec0;
+        ec0 = ec;
+        *values = ec->ec_values;
+    }
+    if (clicon_ptr_set(h, "expand-dbvar-cache", ec0) < 0)
+        goto done;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Add expanded values of an xpath in a datastore to the cache
+ *
+ * The least recently used entry is evicted if there are more than
+ * CLICON_CLI_EXPAND_CACHE_SIZE entries
+ * @param[in]  h      Clixon handle
+ * @param[in]  db     Name of datastore
+ * @param[in]  xpath  XPath of expanded values
+ * @param[in]  etag   Entity tag of datastore, consumed
+ * @param[in]  values Expanded values, copied starting at index i0
+ * @param[in]  i0     First value to cache
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see expand_dbvar_cache_get
+ */
+static int
+expand_dbvar_cache_add(clixon_handle h,
+                       char         *db,
+                       char         *xpath,
+                       char         *etag,
+                       cvec         *values,
+                       int           i0)
+{
+    int                  retval = -1;
+    struct expand_cache *ec0 = NULL;
+    struct expand_cache *ec = NULL;
+    struct expand_cache *eclast;
+    struct expand_cache *ec1;
+    int                  i;
+    int                  max;
+
+    if ((ec = malloc(sizeof(*ec))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        free(etag);
+        goto done;
+    }
+    memset(ec, 0, sizeof(*ec));
+    ec->ec_etag = etag;
+    if ((ec->ec_db = strdup(db)) == NULL ||
+        (ec->ec_xpath = strdup(xpath)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    if ((ec->ec_values = cvec_new(0)) == NULL){
+        clixon_err(OE_UNIX, errno, "cvec_new");
+        goto done;
+    }
+    for (i = i0; i < cvec_len(values); i++)
+        if (cvec_add_string(ec->ec_values, NULL, cv_string_get(cvec_i(values, i))) < 0){
+            clixon_err(OE_UNIX, errno, "cvec_add_string");
+            goto done;
+        }
+    clicon_ptr_get(h, "expand-dbvar-cache", (void**)&ec0);
+    ec->ec_next = ec0;
+    ec0 = ec;
+    ec = NULL;
+    /* Evict least recently used */
+    max = clicon_option_int(h, "CLICON_CLI_EXPAND_CACHE_SIZE");
+    for (i = 1, eclast = ec0; eclast->ec_next != NULL && i < max; i++)
+        eclast = eclast->ec_next;
+    while ((ec1 = eclast->ec_next) != NULL){
+        eclast->ec_next = ec1->ec_next;
+        expand_cache_free1(ec1);
+    }
+    if (clicon_ptr_set(h, "expand-dbvar-cache", ec0) < 0)
+        goto done;
+    retval = 0;
+ done:
+    if (ec)
+        expand_cache_free1(ec);
+    return retval;
+}
+
+/*! Free cached expanded values of expand_dbvar
+ *
+ * @param[in]  h      Clixon handle
+ */
+int
+expand_dbvar_cache_free(clixon_handle h)
+{
+    struct expand_cache *ec = NULL;
+    struct expand_cache *ec1;
+
+    clicon_ptr_get(h, "expand-dbvar-cache", (void**)&ec);
+    while (ec){
+        ec1 = ec->ec_next;
+        expand_cache_free1(ec);
+        ec = ec1;
+    }
+    clicon_ptr_del(h, "expand-dbvar-cache");
+    return 0;
+}
+
+/*! Qsort function of expanded leafref target nodes on body value
+ */
+static int
+expand_dbvar_cmp(const void *a,
+                 const void *b)
+{
+    return strcmp(xml_body(*(cxobj **)a), xml_body(*(cxobj **)b));
+}
+
 /*! Completion callback of variable for configured data and automatically generated data model
  *
  * Returns an expand-type list of commands as used by cligen 'expand' 
@@ -203,6 +396,7 @@ xpath_append(cbuf      *cb0,
  * @retval      0        OK
  * @retval     -1        Error
  * @see cli_expand_var_generate where api_path_fmt + mt-point are generated
+ * Values are cached until the datastore changes, see CLICON_CLI_EXPAND_CACHE_SIZE
  * The syntax of <api_path_fmt> is of RFC8040 api-path with the following extension:
  *   %s  Represents the values of cvv in order starting from element 1
  *   %k  Represents the (first) key of the (previous) list
@@ -248,6 +442,12 @@ expand_dbvar(void   *h,
     char            *str;
     int              grouping_treeref;
     cvec            *callback_cvv;
+    char            *etag = NULL;
+    cvec            *values = NULL;
+    int              i0;
+    int              j;
+    int              leafref = 0;
+    clicon_hash_t   *hash = NULL;
 
     if (argv == NULL || (cvec_len(argv) != 2 && cvec_len(argv) != 3)){
         clixon_err(OE_PLUGIN, EINVAL, "requires arguments: <db> <apipathfmt> [<mountpt>]");
@@ -380,6 +580,15 @@ expand_dbvar(void   *h,
          */
         if (xpath_append(cbxpath, yang_argument_get(ypath), y, nsc) < 0)
             goto done;
+        leafref++;
+    }
+    if (expand_dbvar_cache_get(h, dbstr, cbuf_get(cbxpath), &etag, &values) < 0)
+        goto done;
+    if (values != NULL){
+        cv = NULL;
+        while ((cv = cvec_each(values, cv)) != NULL)
+            cvec_add_string(commands, NULL, cv_string_get(cv));
+        goto ok;
     }
     /* Get configuration based on cbxpath */
     if (clicon_rpc_get_config(h, NULL, dbstr, cbuf_get(cbxpath), nsc, NULL, &xt) < 0)
@@ -393,9 +602,19 @@ expand_dbvar(void   *h,
     /* Loop for inserting into commands cvec. 
      * Detect duplicates: for ordered-by system assume list is ordered, so you need
      * just remember previous
-     * but for ordered-by system, check the whole list
+     * but for ordered-by user, look up in a hash of the values so far.
+     * Leafref targets may come from several lists, and are expanded as a sorted set
      */
     bodystr0 = NULL;
+    i0 = cvec_len(commands);
+    if (leafref){
+        j = 0;
+        for (i = 0; i < xlen; i++)
+            if ((bodystr = xml_body(xvec[i])) != NULL)
+                xvec[j++] = xvec[i];
+        xlen = j;
+        qsort(xvec, xlen, sizeof(*xvec), expand_dbvar_cmp);
+    }
     for (i = 0; i < xlen; i++) {
         x = xvec[i];
         if (xml_type(x) == CX_BODY)
@@ -404,18 +623,24 @@ expand_dbvar(void   *h,
             bodystr = xml_body(x);
         if (bodystr == NULL)
             continue; /* no body, cornercase */
-        if ((y = xml_spec(x)) != NULL &&
+        if (!leafref &&
+            (y = xml_spec(x)) != NULL &&
             (yp = yang_parent_get(y)) != NULL &&
             yang_keyword_get(yp) == Y_LIST &&
             yang_find(yp, Y_ORDERED_BY, "user") != NULL){
-            /* Detect duplicates linearly in existing values */
-            {
-                cg_var *cv = NULL;
+            /* Detect duplicates in a hash of existing values */
+            if (hash == NULL){
+                if ((hash = clicon_hash_init()) == NULL)
+                    goto done;
+                cv = NULL;
                 while ((cv = cvec_each(commands, cv)) != NULL)
-                    if (strcmp(cv_string_get(cv), bodystr) == 0)
-                        break;
-                if (cv == NULL)
-                    cvec_add_string(commands, NULL, bodystr);
+                    if (clicon_hash_add(hash, cv_string_get(cv), NULL, 0) == NULL)
+                        goto done;
+            }
+            if (clicon_hash_lookup(hash, bodystr) == NULL){
+                if (clicon_hash_add(hash, bodystr, NULL, 0) == NULL)
+                    goto done;
+                cvec_add_string(commands, NULL, bodystr);
             }
         }
         else{
@@ -426,9 +651,19 @@ expand_dbvar(void   *h,
             cvec_add_string(commands, NULL, bodystr);
         }
     }
+    if (etag){
+        ret = expand_dbvar_cache_add(h, dbstr, cbuf_get(cbxpath), etag, commands, i0);
+        etag = NULL; /* consumed */
+        if (ret < 0)
+            goto done;
+    }
  ok:
     retval = 0;
  done:
+    if (hash)
+        clicon_hash_free(hash);
+    if (etag)
+        free(etag);
     if (nsc0)
         cvec_free(nsc0);
     if (api_path_fmt_cb)
@@ -581,62 +816,38 @@ show_yang(clixon_handle h,
     return retval;
 }
 
-/*! Common internal show routine for several show cli callbacks
+/*! Print a tree fetched from the backend in a show format
  *
  * @param[in] h            Clixon handle
- * @param[in] db           Datastore
+ * @param[in] xt           XML tree from backend
  * @param[in] format       Output format
- * @param[in] pretty        
- * @param[in] state
- * @param[in] withdefault  RFC 6243 with-default modes
+ * @param[in] pretty       Pretty-print
  * @param[in] extdefault   with-defaults with propriatary extensions
  * @param[in] prepend      CLI prefix to prepend cli syntax, eg "set "
- * @param[in] xpath        XPath
- * @param[in] fromroot     If 0, display config from node of XPATH, if 1 display from root
+ * @param[in] xpath        XPath of objects to print
  * @param[in] nsc          Namespace mapping for xpath
  * @param[in] skiptop      If set, do not show object itself, only its children
  * @retval    0            OK
  * @retval   -1            Error
-  */
-int
-cli_show_common(clixon_handle    h,
-                char            *db,
-                enum format_enum format,
-                int              pretty,
-                int              state,
-                char            *withdefault,
-                char            *extdefault,
-                char            *prepend,
-                char            *xpath,
-                int              fromroot,
-                cvec            *nsc,
-                int              skiptop
-                )
+ * @see cli_show_common
+ */
+static int
+cli_show_print(clixon_handle    h,
+               cxobj           *xt,
+               enum format_enum format,
+               int              pretty,
+               char            *extdefault,
+               char            *prepend,
+               char            *xpath,
+               cvec            *nsc,
+               int              skiptop)
 {
-    int              retval = -1;
-    cxobj           *xt = NULL;
-    cxobj           *xerr;
-    cxobj          **vec = NULL;
-    size_t           veclen;
-    cxobj           *xp;
-    int              i;
+    int     retval = -1;
+    cxobj **vec = NULL;
+    size_t  veclen;
+    cxobj  *xp;
+    int     i;
 
-    if (state && strcmp(db, "running") != 0){
-        clixon_err(OE_FATAL, 0, "Show state only for running database, not %s", db);
-        goto done;
-    }
-    if (state == 0){     /* Get configuration-only from a database */
-        if (clicon_rpc_get_config(h, NULL, db, xpath, nsc, withdefault, &xt) < 0)
-            goto done;
-    }
-    else {               /* Get configuration and state from running */
-        if (clicon_rpc_get(h, xpath, nsc, CONTENT_ALL, -1, withdefault, &xt) < 0)
-            goto done;
-    }
-    if ((xerr = xpath_first(xt, NULL, "/rpc-error")) != NULL){
-        clixon_err_netconf(h, OE_NETCONF, 0, xerr, "Get configuration");
-        goto done;
-    }
     /* Special tagged modes: strip wd:default=true attribute and (optionally) nodes associated with it */
     if (extdefault &&
         (strcmp(extdefault, "report-all-tagged-strip") == 0 ||
@@ -649,8 +860,6 @@ cli_show_common(clixon_handle    h,
         if (xml_default_nopresence(xt, 2, 0) < 0)
             goto done;
     }
-    if (fromroot)
-        xpath="/";
     if (xpath_vec(xt, nsc, "%s", &vec, &veclen, xpath) < 0)
         goto done;
     if (veclen){
@@ -705,9 +914,169 @@ cli_show_common(clixon_handle    h,
     else if (format == FORMAT_JSON)
         cligen_output(stdout, "{}\n");
     retval = 0;
-done:
+ done:
     if (vec)
         free(vec);
+    return retval;
+}
+
+/*! Fetch and print top-level config data nodes of a yang module or a top-level choice, one by one
+ *
+ * @param[in] h            Clixon handle
+ * @param[in] ys           Yang module, submodule, choice or case
+ * @param[in] db           Datastore
+ * @param[in] format       Output format
+ * @param[in] pretty       Pretty-print
+ * @param[in] withdefault  RFC 6243 with-default modes
+ * @param[in] extdefault   with-defaults with propriatary extensions
+ * @param[in] prepend      CLI prefix to prepend cli syntax, eg "set "
+ * @retval    0            OK
+ * @retval   -1            Error
+ * @see cli_show_common  where CLICON_CLI_SHOW_PAGED is checked
+ */
+static int
+cli_show_paged(clixon_handle    h,
+               yang_stmt       *ys,
+               char            *db,
+               enum format_enum format,
+               int              pretty,
+               char            *withdefault,
+               char            *extdefault,
+               char            *prepend)
+{
+    int        retval = -1;
+    yang_stmt *yc;
+    char      *prefix;
+    char      *ns;
+    cbuf      *cb = NULL;
+    cvec      *nsc = NULL;
+    cxobj     *xt = NULL;
+    cxobj     *xerr;
+    int        inext;
+
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    inext = 0;
+    while ((yc = yn_iter(ys, &inext)) != NULL){
+        if (yang_keyword_get(yc) == Y_CHOICE || yang_keyword_get(yc) == Y_CASE){
+            if (cli_show_paged(h, yc, db, format, pretty, withdefault, extdefault, prepend) < 0)
+                goto done;
+            continue;
+        }
+        if (!yang_datanode(yc) || !yang_config(yc))
+            continue;
+        if ((prefix = yang_find_myprefix(yc)) == NULL ||
+            (ns = yang_find_mynamespace(yc)) == NULL)
+            continue;
+        if ((nsc = xml_nsctx_init(prefix, ns)) == NULL)
+            goto done;
+        cbuf_reset(cb);
+        cprintf(cb, "/%s:%s", prefix, yang_argument_get(yc));
+        if (clicon_rpc_get_config(h, NULL, db, cbuf_get(cb), nsc, withdefault, &xt) < 0)
+            goto done;
+        if ((xerr = xpath_first(xt, NULL, "/rpc-error")) != NULL){
+            clixon_err_netconf(h, OE_NETCONF, 0, xerr, "Get configuration");
+            goto done;
+        }
+        if (xml_child_nr_type(xt, CX_ELMNT) &&
+            cli_show_print(h, xt, format, pretty, extdefault, prepend, "/", NULL, 0) < 0)
+            goto done;
+        xml_free(xt);
+        xt = NULL;
+        xml_nsctx_free(nsc);
+        nsc = NULL;
+    }
+    retval = 0;
+ done:
+    if (xt)
+        xml_free(xt);
+    if (nsc)
+        xml_nsctx_free(nsc);
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Common internal show routine for several show cli callbacks
+ *
+ * If CLICON_CLI_SHOW_PAGED is set, a whole datastore shown in pretty xml, text or cli format
+ * is fetched and printed per top-level data node, so that output starts after the first node.
+ * @param[in] h            Clixon handle
+ * @param[in] db           Datastore
+ * @param[in] format       Output format
+ * @param[in] pretty        
+ * @param[in] state
+ * @param[in] withdefault  RFC 6243 with-default modes
+ * @param[in] extdefault   with-defaults with propriatary extensions
+ * @param[in] prepend      CLI prefix to prepend cli syntax, eg "set "
+ * @param[in] xpath        XPath
+ * @param[in] fromroot     If 0, display config from node of XPATH, if 1 display from root
+ * @param[in] nsc          Namespace mapping for xpath
+ * @param[in] skiptop      If set, do not show object itself, only its children
+ * @retval    0            OK
+ * @retval   -1            Error
+  */
+int
+cli_show_common(clixon_handle    h,
+                char            *db,
+                enum format_enum format,
+                int              pretty,
+                int              state,
+                char            *withdefault,
+                char            *extdefault,
+                char            *prepend,
+                char            *xpath,
+                int              fromroot,
+                cvec            *nsc,
+                int              skiptop
+                )
+{
+    int              retval = -1;
+    cxobj           *xt = NULL;
+    cxobj           *xerr;
+    yang_stmt       *yspec;
+    yang_stmt       *ymod;
+    int              inext;
+
+    if (state && strcmp(db, "running") != 0){
+        clixon_err(OE_FATAL, 0, "Show state only for running database, not %s", db);
+        goto done;
+    }
+    if (state == 0 && skiptop == 0 &&
+        (xpath == NULL || strcmp(xpath, "/") == 0) &&
+        ((format == FORMAT_XML && pretty) || format == FORMAT_TEXT || format == FORMAT_CLI) &&
+        clicon_option_bool(h, "CLICON_CLI_SHOW_PAGED")){
+        yspec = clicon_dbspec_yang(h);
+        inext = 0;
+        while ((ymod = yn_iter(yspec, &inext)) != NULL){
+            if (yang_keyword_get(ymod) != Y_MODULE && yang_keyword_get(ymod) != Y_SUBMODULE)
+                continue;
+            if (cli_show_paged(h, ymod, db, format, pretty, withdefault, extdefault, prepend) < 0)
+                goto done;
+        }
+        goto ok;
+    }
+    if (state == 0){     /* Get configuration-only from a database */
+        if (clicon_rpc_get_config(h, NULL, db, xpath, nsc, withdefault, &xt) < 0)
+            goto done;
+    }
+    else {               /* Get configuration and state from running */
+        if (clicon_rpc_get(h, xpath, nsc, CONTENT_ALL, -1, withdefault, &xt) < 0)
+            goto done;
+    }
+    if ((xerr = xpath_first(xt, NULL, "/rpc-error")) != NULL){
+        clixon_err_netconf(h, OE_NETCONF, 0, xerr, "Get configuration");
+        goto done;
+    }
+    if (fromroot)
+        xpath="/";
+    if (cli_show_print(h, xt, format, pretty, extdefault, prepend, xpath, nsc, skiptop) < 0)
+        goto done;
+ ok:
+    retval = 0;
+done:
     if (xt)
         xml_free(xt);
     return retval;
@@ -1488,6 +1857,7 @@ cli_pagination(clixon_handle h,
  * @param[in,out] cb      Cligen buffer to write to
  * @param[in]     xn      XML Parse-tree (to translate)
  * @param[in]     prepend Print this text in front of all commands.
+ * @param[in]     fo      Buffered output to flush after children, or NULL
  * @retval        0       OK
  * @retval       -1       Error
  * @see clixon_cli2file
@@ -1496,7 +1866,8 @@ static int
 cli2cbuf(clixon_handle     h,
          cbuf             *cb,
          cxobj            *xn,
-         char             *prepend)
+         char             *prepend,
+         clicon_file_out  *fo)
 {
     int              retval = -1;
     cxobj           *xe = NULL;
@@ -1597,136 +1968,9 @@ cli2cbuf(clixon_handle     h,
             if (match)
                 continue; /* Not key itself */
         }
-        if (cli2cbuf(h, cb, xe, cbuf_get(cbpre)) < 0)
+        if (cli2cbuf(h, cb, xe, cbuf_get(cbpre), fo) < 0)
             goto done;
-    }
- ok:
-    retval = 0;
- done:
-    if (cbpre)
-        cbuf_free(cbpre);
-    return retval;
-}
-
-/*! Translate from XML to CLI commands, internal
- *
- * Howto: join strings and pass them down. 
- * Identify unique/index keywords for correct set syntax.
- * @param[in] h        Clixon handle
- * @param[in] f        Output FILE (eg stdout)
- * @param[in] xn       XML Parse-tree (to translate)
- * @param[in] prepend  Print this text in front of all commands.
- * @param[in] fn       Callback to make print function
- * @retval    0        OK
- * @retval   -1        Error
- */
-static int
-cli2file(clixon_handle     h,
-         FILE             *f,
-         cxobj            *xn,
-         char             *prepend,
-         clicon_output_cb *fn)
-{
-    int              retval = -1;
-    cxobj           *xe = NULL;
-    cbuf            *cbpre = NULL;
-    yang_stmt       *ys;
-    int              match;
-    char            *body;
-    int              compress = 0;
-    autocli_listkw_t listkw;
-    int              exist = 0;
-    char            *name;
-
-    if (autocli_list_keyword(h, &listkw) < 0)
-        goto done;
-    if (xml_type(xn)==CX_ATTR)
-        goto ok;
-    if ((ys = xml_spec(xn)) == NULL)
-        goto ok;
-    if (yang_extension_value(ys, "hide-show", CLIXON_AUTOCLI_NS, &exist, NULL) < 0)
-        goto done;
-    if (exist)
-        goto ok;
-    exist = 0;
-    if (yang_extension_value(ys, "alias", CLIXON_AUTOCLI_NS, &exist, &name) < 0)
-        goto done;
-    if (!exist)
-        name = xml_name(xn);
-    /* If leaf/leaf-list or presence container, then print line */
-    if (yang_keyword_get(ys) == Y_LEAF ||
-        yang_keyword_get(ys) == Y_LEAF_LIST){
-        if (prepend)
-            (*fn)(f, "%s", prepend);
-        if (listkw != AUTOCLI_LISTKW_NONE)
-            (*fn)(f, "%s ", name);
-        if ((body = xml_body(xn)) != NULL){
-            if (index(body, ' '))
-                (*fn)(f, "\"%s\"", body);
-            else
-                (*fn)(f, "%s", body);
-        }
-        (*fn)(f, "\n");
-        goto ok;
-    }
-    /* Create prepend variable string */
-    if ((cbpre = cbuf_new()) == NULL){
-        clixon_err(OE_PLUGIN, errno, "cbuf_new");
-        goto done;
-    }
-    if (prepend)
-        cprintf(cbpre, "%s", prepend);
-
-    /* If non-presence container && HIDE mode && only child is 
-     * a list, then skip container keyword
-     * See also yang2cli_container */
-    if (autocli_compress(h, ys, &compress) < 0)
-        goto done;
-    if (!compress)
-        cprintf(cbpre, "%s ", xml_name(xn));
-
-    /* If list then first loop through keys */
-    if (yang_keyword_get(ys) == Y_LIST){
-        xe = NULL;
-        while ((xe = xml_child_each(xn, xe, -1)) != NULL){
-            if ((match = yang_key_match(ys, xml_name(xe), NULL)) < 0)
-                goto done;
-            if (!match)
-                continue;
-            if (listkw == AUTOCLI_LISTKW_ALL)
-                cprintf(cbpre, "%s ", xml_name(xe));
-            cprintf(cbpre, "%s ", xml_body(xe));
-        }
-    }
-    else if ((yang_keyword_get(ys) == Y_CONTAINER) &&
-             yang_find(ys, Y_PRESENCE, NULL) != NULL){
-        /* If presence container, then print as leaf (but continue to children) */
-        if (prepend)
-            (*fn)(f, "%s", prepend);
-        if (listkw != AUTOCLI_LISTKW_NONE)
-            (*fn)(f, "%s ", xml_name(xn));
-        if ((body = xml_body(xn)) != NULL){
-            if (index(body, ' '))
-                (*fn)(f, "\"%s\"", body);
-            else
-                (*fn)(f, "%s", body);
-        }
-        (*fn)(f, "\n");
-    }
-
-    /* For lists, print cbpre before its elements */
-    if (yang_keyword_get(ys) == Y_LIST)
-        (*fn)(f, "%s\n", cbuf_get(cbpre));
-    /* Then loop through all other (non-keys) */
-    xe = NULL;
-    while ((xe = xml_child_each(xn, xe, -1)) != NULL){
-        if (yang_keyword_get(ys) == Y_LIST){
-            if ((match = yang_key_match(ys, xml_name(xe), NULL)) < 0)
-                goto done;
-            if (match)
-                continue; /* Not key itself */
-        }
-        if (cli2file(h, f, xe, cbuf_get(cbpre), fn) < 0)
+        if (fo && clicon_file_out_check(fo) < 0)
             goto done;
     }
  ok:
@@ -1759,23 +2003,30 @@ clixon_cli2file(clixon_handle     h,
                 clicon_output_cb *fn,
                 int               skiptop)
 {
-    int   retval = 1;
-    cxobj *xc;
+    int             retval = 1;
+    cxobj          *xc;
+    clicon_file_out fo = {0,};
 
-    if (fn == NULL)
-        fn = fprintf;
+    if (clicon_file_out_init(&fo, f, fn) < 0)
+        goto done;
     if (skiptop){
         xc = NULL;
-        while ((xc = xml_child_each(xn, xc, CX_ELMNT)) != NULL)
-            if (cli2file(h, f, xc, prepend, fn) < 0)
+        while ((xc = xml_child_each(xn, xc, CX_ELMNT)) != NULL){
+            if (cli2cbuf(h, fo.fo_cb, xc, prepend, &fo) < 0)
+                goto done;
+            if (clicon_file_out_check(&fo) < 0)
                 goto done;
+        }
     }
     else {
-        if (cli2file(h, f, xn, prepend, fn) < 0)
+        if (cli2cbuf(h, fo.fo_cb, xn, prepend, &fo) < 0)
             goto done;
     }
+    if (clicon_file_out_flush(fo.fo_cb, &fo) < 0)
+        goto done;
     retval = 0;
  done:
+    clicon_file_out_free(&fo);
     return retval;
 }
 
@@ -1806,11 +2057,11 @@ clixon_cli2cbuf(clixon_handle     h,
     if (skiptop){
         xc = NULL;
         while ((xc = xml_child_each(xn, xc, CX_ELMNT)) != NULL)
-            if (cli2cbuf(h, cb, xc, prepend) < 0)
+            if (cli2cbuf(h, cb, xc, prepend, NULL) < 0)
                 goto done;
     }
     else {
-        if (cli2cbuf(h, cb, xn, prepend) < 0)
+        if (cli2cbuf(h, cb, xn, prepend, NULL) < 0)
             goto done;
     }
     retval = 0;
@@ -212,3 +212,176 @@ xml_filter(cxobj *xfilter,
     return retval;
 }
 
+
+/*! Get or create a prefix of a namespace for a translated xpath
+ *
+ * @param[in]  nsc     Namespace context in scope of the filter, new prefixes are added
+ * @param[in]  xfilter Filter xml, new namespace declarations are added
+ * @param[in]  ns      Namespace
+ * @param[out] prefix  Prefix (direct pointer)
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+xml_filter_prefix(cvec  *nsc,
+                  cxobj *xfilter,
+                  char  *ns,
+                  char **prefix)
+{
+    int   retval = -1;
+    char  pf[16];
+    int   i;
+
+    if (xml_nsctx_get_prefix(nsc, ns, prefix) == 1 && *prefix != NULL)
+        goto ok;
+    for (i=0; ; i++){
+        snprintf(pf, sizeof(pf), "nf%d", i);
+        if (xml_nsctx_get(nsc, pf) == NULL)
+            break;
+    }
+    if (xml_nsctx_add(nsc, pf, ns) < 0)
+        goto done;
+    if (xmlns_set(xfilter, pf, ns) < 0)
+        goto done;
+    if (xml_nsctx_get_prefix(nsc, ns, prefix) == 0)
+        goto done;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Translate one filter node of a subtree filter to xpath steps
+ *
+ * Content match nodes are translated to predicates. A single containment or selection node
+ * is descended into, but only if there are no content match nodes since their values are
+ * otherwise not part of the xpath result.
+ * @param[in]  f       Filter node
+ * @param[in]  nsc     Namespace context
+ * @param[in]  xfilter Top-level filter xml
+ * @param[in]  cb      XPath buffer
+ * @retval     1       OK
+ * @retval     0       Filter node can not be translated
+ * @retval    -1       Error
+ */
+static int
+xml_filter2xpath_node(cxobj *f,
+                      cvec  *nsc,
+                      cxobj *xfilter,
+                      cbuf  *cb)
+{
+    cxobj *c;
+    cxobj *cs = NULL;
+    char  *ns = NULL;
+    char  *prefix;
+    char  *fstr;
+    int    containments = 0;
+    int    contents = 0;
+    char   q;
+
+    /* Attribute match is not translated */
+    c = NULL;
+    while ((c = xml_child_each(f, c, CX_ATTR)) != NULL) {
+        if (strcmp(xml_name(c), "xmlns") == 0 ||
+            (xml_prefix(c) && strcmp(xml_prefix(c), "xmlns") == 0))
+            continue;
+        return 0;
+    }
+    if (xml2ns(f, xml_prefix(f), &ns) < 0)
+        return -1;
+    if (ns == NULL)
+        return 0;
+    if (xml_filter_prefix(nsc, xfilter, ns, &prefix) < 0)
+        return -1;
+    cprintf(cb, "/%s:%s", prefix, xml_name(f));
+    c = NULL;
+    while ((c = xml_child_each(f, c, CX_ELMNT)) != NULL) {
+        if ((fstr = leafstring(c)) == NULL){
+            containments++;
+            cs = c;
+            continue;
+        }
+        contents++;
+        if (strchr(fstr, '\'') == NULL)
+            q = '\'';
+        else if (strchr(fstr, '"') == NULL)
+            q = '"';
+        else
+            return 0;
+        if (xml2ns(c, xml_prefix(c), &ns) < 0)
+            return -1;
+        if (ns == NULL)
+            return 0;
+        if (xml_filter_prefix(nsc, xfilter, ns, &prefix) < 0)
+            return -1;
+        cprintf(cb, "[%s:%s=%c%s%c]", prefix, xml_name(c), q, fstr, q);
+    }
+    if (containments == 1 && contents == 0)
+        return xml_filter2xpath_node(cs, nsc, xfilter, cb);
+    return 1;
+}
+
+/*! Translate a subtree filter to an xpath and set it as select attribute of the filter
+ *
+ * The xpath selects a superset of the subtree filter. It is evaluated by the backend so that
+ * only matching subtrees are read from the datastore, which may use list key and search index
+ * optimizations. The result is thereafter pruned exactly by xml_filter().
+ * Namespace declarations of prefixes in the xpath are added to the filter.
+ * @param[in]  xfilter  Filter xml, <filter type="subtree">
+ * @retval     1        OK, select attribute set
+ * @retval     0        Filter can not be translated, filter unchanged
+ * @retval    -1        Error
+ * @see xml_filter
+ */
+int
+xml_filter2xpath(cxobj *xfilter)
+{
+    int    retval = -1;
+    cvec  *nsc = NULL;
+    cxobj *f;
+    cxobj *xf = NULL;
+    cbuf  *cb = NULL;
+    int    ret;
+
+    if (xml_child_nr_type(xfilter, CX_ELMNT) == 0 ||
+        xml_find_type(xfilter, NULL, "select", CX_ATTR) != NULL)
+        goto fail;
+    /* Translate a copy so that added namespace declarations can be discarded on failure */
+    if ((xf = xml_new(xml_name(xfilter), NULL, CX_ELMNT)) == NULL)
+        goto done;
+    if (xml_nsctx_node(xfilter, &nsc) < 0)
+        goto done;
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    f = NULL;
+    while ((f = xml_child_each(xfilter, f, CX_ELMNT)) != NULL) {
+        if (leafstring(f)) /* Top-level content match selects all, see xml_filter */
+            goto fail;
+        if (cbuf_len(cb))
+            cprintf(cb, " | ");
+        if ((ret = xml_filter2xpath_node(f, nsc, xf, cb)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+    }
+    f = NULL;
+    while ((f = xml_child_each(xf, f, CX_ATTR)) != NULL)
+        if (xmlns_set(xfilter, xml_name(f), xml_value(f)) < 0)
+            goto done;
+    if (xml_add_attr(xfilter, "select", cbuf_get(cb), NULL, NULL) == NULL)
+        goto done;
+    retval = 1;
+ done:
+    if (xf)
+        xml_free(xf);
+    if (cb)
+        cbuf_free(cb);
+    if (nsc)
+        cvec_free(nsc);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
@@ -68,9 +68,10 @@
 
 //#include "clixon_netconf.h"
 #include "netconf_rpc.h"
+#include "netconf_server.h"
 
 /* Command line options to be passed to getopt(3) */
-#define NETCONF_OPTS "hVD:f:E:l:C:q01ca:u:d:p:y:U:t:eo:"
+#define NETCONF_OPTS "hVD:f:E:l:C:q01ca:u:d:p:y:U:t:eSo:"
 
 #define NETCONF_LOGFILE "/tmp/clixon_netconf.log"
 
@@ -91,48 +92,14 @@ static int ignore_packet_errors = 1;
 /* Hello request received */
 static int _netconf_hello_nr = 0;
 
-/*! Copy attributes from incoming request to reply. Skip already present (dont overwrite)
+/*! Options of a netconf session
  *
- * RFC 6241:
- * If additional attributes are present in an <rpc> element, a NETCONF
- * peer MUST return them unmodified in the <rpc-reply> element.  This
- * includes any "xmlns" attributes.
- * @param[in]     xrpc  Incoming message on the form <rpc>...
- * @param[in,out] xrep  Reply message on the form <rpc-reply>...
- * @retval        0     OK
- * @retval       -1     Error
+ * @see netconf_session_start
  */
-static int
-netconf_add_request_attr(cxobj *xrpc,
-                         cxobj *xrep)
-{
-    int    retval = -1;
-    cxobj *xa;
-    cxobj *xa2 = NULL;
-
-    xa = NULL;
-    while ((xa = xml_child_each(xrpc, xa, CX_ATTR)) != NULL){
-        /* If attribute already exists, dont copy it */
-        if (xml_find_type(xrep, NULL, xml_name(xa), CX_ATTR) != NULL)
-            continue; /* Skip already present (dont overwrite) */
-        /* Filter all clixon-lib attributes and namespace declaration 
-         * to avoid leaking internal attributes to external NETCONF
-         * note this is only done on top-level.
-         */
-        if (xml_prefix(xa) && strcmp(xml_prefix(xa), CLIXON_LIB_PREFIX) == 0)
-            continue;
-        if (xml_prefix(xa) && strcmp(xml_prefix(xa), "xmlns") == 0 &&
-            strcmp(xml_name(xa), CLIXON_LIB_PREFIX) == 0)
-            continue;
-        if ((xa2 = xml_dup(xa)) ==NULL)
-            goto done;
-        if (xml_addsub(xrep, xa2) < 0)
-            goto done;
-    }
-    retval = 0;
- done:
-    return retval;
-}
+struct netconf_session_opts {
+    int            so_quiet; /* Do not send hello */
+    struct timeval so_tv;    /* Session timeout */
+};
 
 /*! Process netconf hello message
  *
@@ -264,8 +231,10 @@ netconf_rpc_message(clixon_handle h,
             goto done;
         goto ok;
     }
-    if (netconf_rpc_dispatch(h, xrpc, &xret, eof) < 0)
+    if ((ret = netconf_rpc_dispatch(h, xrpc, &xret, eof)) < 0)
         goto done;
+    if (ret == 1) /* Reply already sent */
+        goto ok;
 
     /* Is there a return message in xret? */
     if (xret == NULL){
@@ -425,7 +394,7 @@ netconf_input_cb(int   s,
     cxobj         *xreq;
     cxobj         *xerr = NULL;
     int            ret;
-    unsigned char  buf[BUFSIZ]; /* from stdio.h, typically 8K */
+    static unsigned char buf[NETCONF_INPUT_BUFLEN];
     ssize_t        buflen = sizeof(buf);
     unsigned char *p = buf;
     ssize_t        len;
@@ -578,12 +547,15 @@ netconf_terminate(clixon_handle h)
 {
     cvec       *nsctx;
     cxobj      *x;
+    uint32_t    id;
 
     if (clixon_exit_get() == 0)
         clixon_exit_set(1);
     /* Delete all plugins, and RPC callbacks */
     clixon_plugin_module_exit(h);
-    clicon_rpc_close_session(h);
+    /* No backend session in a session server or a process handing over to it */
+    if (clicon_session_id_get(h, &id) == 0)
+        clicon_rpc_close_session(h);
     yang_exit(h);
     if ((nsctx = clicon_nsctx_global_get(h)) != NULL)
         cvec_free(nsctx);
@@ -621,6 +593,58 @@ timeout_fn(int s,
     return -1;
 }
 
+/*! Start a netconf session on stdin and stdout
+ *
+ * Get session-id from backend, send hello and register input of session
+ * @param[in]  h    Clixon handle
+ * @param[in]  arg  Session options
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see netconf_server_accept  Called in child of session server
+ */
+static int
+netconf_session_start(clixon_handle h,
+                      void         *arg)
+{
+    int                          retval = -1;
+    struct netconf_session_opts *so = (struct netconf_session_opts *)arg;
+    uint32_t                     id;
+    struct timeval               t;
+
+    /* Send hello request to backend to get session-id back
+     * This is done once at the beginning of the session and then this is
+     * used by the client, even though new TCP sessions are created for
+     * each message sent to the backend.
+     */
+    if (clicon_hello_req(h, "cl:netconf", NULL, &id) < 0)
+        goto done;
+    clicon_session_id_set(h, id);
+
+    /* Send hello to northbound client 
+     * Note that this is a violation of RDFC 6241 Sec 8.1:
+     * When the NETCONF session is opened, each peer(both client and server) MUST send a <hello..
+     */
+    if (!so->so_quiet){
+        if (send_hello(h, 1, id) < 0)
+            goto done;
+    }
+#ifdef __AFL_HAVE_MANUAL_CONTROL
+    /* American fuzzy loop deferred init, see CLICON_NETCONF_HELLO_OPTIONAL=true, see a speedup of x10 */
+    __AFL_INIT();
+#endif
+    if (clixon_event_reg_fd(0, netconf_input_cb, h, "netconf socket") < 0)
+        goto done;
+    if (so->so_tv.tv_sec || so->so_tv.tv_usec){
+        gettimeofday(&t, NULL);
+        timeradd(&t, &so->so_tv, &t);
+        if (clixon_event_reg_timeout(t, timeout_fn, NULL, "timeout") < 0)
+            goto done;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Usage help routine
  *
  * @param[in]  h      Clixon handle
@@ -650,6 +674,7 @@ usage(clixon_handle h,
             "\t-U <user>\tOver-ride unix user with a pseudo user for NACM.\n"
             "\t-t <sec>\tTimeout in seconds. Quit after this time.\n"
             "\t-e \t\tDont ignore errors on packet input.\n"
+            "\t-S \t\tRun as persistent session server on CLICON_NETCONF_SERVER_SOCK\n"
             "\t-o \"<option>=<value>\"\tGive configuration option overriding config file (see clixon-config.yang)\n",
             argv0,
             clicon_netconf_dir(h)
@@ -667,15 +692,13 @@ main(int    argc,
     int              retval = -1;
     int              c;
     char            *argv0 = argv[0];
-    int              quiet = 0;
+    struct netconf_session_opts so = {0,};
     clixon_handle    h;
     char            *dir;
     int              logdst = CLIXON_LOG_SYSLOG;
     struct passwd   *pw;
-    struct timeval   tv = {0,}; /* timeout */
     yang_stmt       *yspec = NULL;
     char            *str;
-    uint32_t         id;
     cvec            *nsctx_global = NULL; /* Global namespace context */
     size_t           cligen_buflen;
     size_t           cligen_bufthreshold;
@@ -685,6 +708,9 @@ main(int    argc,
     enum format_enum config_dump_format = FORMAT_XML;
     int              print_version = 0;
     int32_t          d;
+    int              server = 0;
+    char            *sockpath;
+    int              ret;
 
     /* Create handle */
     if ((h = clixon_handle_init()) == NULL)
@@ -776,7 +802,7 @@ main(int    argc,
             config_dump++;
             break;
         case 'q':  /* quiet: dont write hello */
-            quiet++;
+            so.so_quiet++;
             break;
         case 'a': /* internal backend socket address family */
             clicon_option_str_set(h, "CLICON_SOCK_FAMILY", optarg);
@@ -807,11 +833,14 @@ main(int    argc,
                 goto done;
             break;
         case 't': /* timeout in seconds */
-            tv.tv_sec = atoi(optarg);
+            so.so_tv.tv_sec = atoi(optarg);
             break;
         case 'e': /* dont ignore packet errors */
             ignore_packet_errors = 0;
             break;
+        case 'S': /* persistent session server */
+            server++;
+            break;
         case '0': /* Force EOM */
             clicon_option_int_set(h, "CLICON_NETCONF_BASE_CAPABILITY", 0);
             clicon_option_bool_set(h, "CLICON_NETCONF_HELLO_OPTIONAL", 1);
@@ -850,6 +879,19 @@ main(int    argc,
     if ((sz = clicon_option_int(h, "CLICON_LOG_STRING_LIMIT")) != 0)
         clixon_log_string_limit_set(sz);
 
+    /* Hand over session to persistent session server, if it runs */
+    sockpath = clicon_option_str(h, "CLICON_NETCONF_SERVER_SOCK");
+    if (server && sockpath == NULL){
+        clixon_err(OE_FATAL, 0, "-S requires CLICON_NETCONF_SERVER_SOCK");
+        goto done;
+    }
+    if (!server && sockpath != NULL && !config_dump && !print_version){
+        if ((ret = netconf_server_shim(h, sockpath)) < 0)
+            goto done;
+        if (ret == 1)
+            goto ok;
+    }
+
     /* Set default namespace according to CLICON_NAMESPACE_NETCONF_DEFAULT */
     xml_nsctx_namespace_netconf_default(h);
 
@@ -931,36 +973,13 @@ main(int    argc,
     /* Debug dump of config options */
     clicon_option_dump(h, CLIXON_DBG_INIT);
 
-    /* Send hello request to backend to get session-id back
-     * This is done once at the beginning of the session and then this is
-     * used by the client, even though new TCP sessions are created for
-     * each message sent to the backend.
-     */
-    if (clicon_hello_req(h, "cl:netconf", NULL, &id) < 0)
-        goto done;
-    clicon_session_id_set(h, id);
-
-    /* Send hello to northbound client 
-     * Note that this is a violation of RDFC 6241 Sec 8.1:
-     * When the NETCONF session is opened, each peer(both client and server) MUST send a <hello..
-     */
-    if (!quiet){
-        if (send_hello(h, 1, id) < 0)
+    /* Either serve sessions in forked children, or this session */
+    if (server){
+        if (netconf_server_init(h, sockpath, netconf_session_start, &so) < 0)
             goto done;
     }
-#ifdef __AFL_HAVE_MANUAL_CONTROL
-    /* American fuzzy loop deferred init, see CLICON_NETCONF_HELLO_OPTIONAL=true, see a speedup of x10 */
-    __AFL_INIT();
-#endif
-    if (clixon_event_reg_fd(0, netconf_input_cb, h, "netconf socket") < 0)
+    else if (netconf_session_start(h, &so) < 0)
         goto done;
-    if (tv.tv_sec || tv.tv_usec){
-        struct timeval t;
-        gettimeofday(&t, NULL);
-        timeradd(&t, &tv, &t);
-        if (clixon_event_reg_timeout(t, timeout_fn, NULL, "timeout") < 0)
-            goto done;
-    }
     if (clixon_event_loop(h) < 0)
         goto done;
  ok:
@@ -73,12 +73,214 @@
 #include "netconf_filter.h"
 #include "netconf_rpc.h"
 
+/*! Copy attributes from incoming request to reply. Skip already present (dont overwrite)
+ *
+ * RFC 6241:
+ * If additional attributes are present in an <rpc> element, a NETCONF
+ * peer MUST return them unmodified in the <rpc-reply> element.  This
+ * includes any "xmlns" attributes.
+ * @param[in]     xrpc  Incoming message on the form <rpc>...
+ * @param[in,out] xrep  Reply message on the form <rpc-reply>...
+ * @retval        0     OK
+ * @retval       -1     Error
+ */
+int
+netconf_add_request_attr(cxobj *xrpc,
+                         cxobj *xrep)
+{
+    int    retval = -1;
+    cxobj *xa;
+    cxobj *xa2 = NULL;
+
+    xa = NULL;
+    while ((xa = xml_child_each(xrpc, xa, CX_ATTR)) != NULL){
+        /* If attribute already exists, dont copy it */
+        if (xml_find_type(xrep, NULL, xml_name(xa), CX_ATTR) != NULL)
+            continue; /* Skip already present (dont overwrite) */
+        /* Filter all clixon-lib attributes and namespace declaration 
+         * to avoid leaking internal attributes to external NETCONF
+         * note this is only done on top-level.
+         */
+        if (xml_prefix(xa) && strcmp(xml_prefix(xa), CLIXON_LIB_PREFIX) == 0)
+            continue;
+        if (xml_prefix(xa) && strcmp(xml_prefix(xa), "xmlns") == 0 &&
+            strcmp(xml_name(xa), CLIXON_LIB_PREFIX) == 0)
+            continue;
+        if ((xa2 = xml_dup(xa)) ==NULL)
+            goto done;
+        if (xml_addsub(xrep, xa2) < 0)
+            goto done;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*
  * <rpc [attributes]> 
     <!- - tag elements in a request from a client application - -> 
     </rpc> 
  */
 
+/*! State of a get-config reply passed through from backend to client
+ *
+ * @see netconf_get_config_stream
+ */
+struct get_config_stream {
+    cxobj *gs_xrpc;  /* Incoming rpc, its attributes are added to the reply */
+    cbuf  *gs_cb;    /* Reply data until rpc-reply start-tag, or whole reply if not passed */
+    int    gs_state; /* 0: start of reply, 1: passed through, 2: collected */
+};
+
+/*! Check start of get-config reply and pass it through if it is an rpc-reply start-tag
+ *
+ * The start-tag is parsed as an empty element, the request attributes are added and it is
+ * serialized again. Any other reply, such as an empty rpc-reply, is collected instead.
+ * @param[in]  gs   Stream state
+ * @param[in]  eom  Last data of reply
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+netconf_get_config_stream_start(struct get_config_stream *gs,
+                                int                       eom)
+{
+    int    retval = -1;
+    char  *str;
+    char  *gt;
+    cbuf  *cbh = NULL;
+    cxobj *xt = NULL;
+    cxobj *xrep;
+    size_t len;
+
+    str = cbuf_get(gs->gs_cb);
+    if (strncmp(str, "<rpc-reply", strlen("<rpc-reply")) != 0){
+        if (cbuf_len(gs->gs_cb) >= strlen("<rpc-reply"))
+            gs->gs_state = 2;
+        goto ok;
+    }
+    if ((gt = strchr(str, '>')) == NULL)
+        goto ok; /* Need more data */
+    if (gt[-1] == '/'){
+        gs->gs_state = 2;
+        goto ok;
+    }
+    if ((cbh = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    /* Envelope as empty element */
+    cprintf(cbh, "%.*s/>", (int)(gt - str), str);
+    if (clixon_xml_parse_string(cbuf_get(cbh), YB_NONE, NULL, &xt, NULL) < 0)
+        goto done;
+    if ((xrep = xml_find_type(xt, NULL, "rpc-reply", CX_ELMNT)) == NULL){
+        gs->gs_state = 2;
+        goto ok;
+    }
+    if (netconf_add_request_attr(gs->gs_xrpc, xrep) < 0)
+        goto done;
+    cbuf_reset(cbh);
+    if (clixon_xml2cbuf(cbh, xrep, 0, 0, NULL, -1, 0) < 0)
+        goto done;
+    len = cbuf_len(cbh);
+    if (len < 2 || strcmp(cbuf_get(cbh) + len - 2, "/>") != 0){
+        gs->gs_state = 2;
+        goto ok;
+    }
+    cbuf_trunc(cbh, len - 2);
+    cbuf_append(cbh, '>');
+    gt++;
+    if (cbuf_append_buf(cbh, gt, cbuf_len(gs->gs_cb) - (gt - str)) < 0){
+        clixon_err(OE_UNIX, errno, "cbuf_append_buf");
+        goto done;
+    }
+    if (clixon_msg_send11_chunk(1, NULL, cbuf_get(cbh), cbuf_len(cbh), eom) < 0)
+        goto done;
+    cbuf_reset(gs->gs_cb);
+    gs->gs_state = 1;
+ ok:
+    retval = 0;
+ done:
+    if (cbh)
+        cbuf_free(cbh);
+    if (xt)
+        xml_free(xt);
+    return retval;
+}
+
+/*! Receive get-config reply data from backend and pass it to client as chunks
+ *
+ * @see clixon_msg_stream_cb
+ */
+static int
+netconf_get_config_stream_cb(char  *buf,
+                             size_t len,
+                             int    eom,
+                             void  *arg)
+{
+    int                       retval = -1;
+    struct get_config_stream *gs = (struct get_config_stream *)arg;
+
+    if (gs->gs_state == 1){
+        if (clixon_msg_send11_chunk(1, NULL, buf, len, eom) < 0)
+            goto done;
+        goto ok;
+    }
+    if (cbuf_append_buf(gs->gs_cb, buf, len) < 0){
+        clixon_err(OE_UNIX, errno, "cbuf_append_buf");
+        goto done;
+    }
+    if (gs->gs_state == 0 &&
+        netconf_get_config_stream_start(gs, eom) < 0)
+        goto done;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Get configuration and pass reply through from backend to client without parsing it
+ *
+ * The reply is written to the client in NETCONF 1.1 chunks as it arrives from the backend.
+ * Only the rpc-reply start-tag is parsed in order to add the attributes of the request.
+ * If the reply does not start with a rpc-reply start-tag it is collected and returned.
+ * @param[in]  h       Clixon handle
+ * @param[in]  xn      Sub-tree (under xorig) at <rpc>...</rpc> level.
+ * @param[out] xret    Return XML, if not passed through
+ * @retval     1       Reply passed through and sent to client
+ * @retval     0       OK, reply in xret
+ * @retval    -1       Error
+ * @see CLICON_NETCONF_PASSTHROUGH
+ */
+static int
+netconf_get_config_stream(clixon_handle h,
+                          cxobj        *xn,
+                          cxobj       **xret)
+{
+    int                      retval = -1;
+    struct get_config_stream gs = {0,};
+
+    gs.gs_xrpc = xml_parent(xn);
+    if ((gs.gs_cb = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    if (clicon_rpc_netconf_stream(h, xml_parent(xn), netconf_get_config_stream_cb, &gs) < 0)
+        goto done;
+    if (gs.gs_state == 1){
+        retval = 1;
+        goto done;
+    }
+    if (clixon_xml_parse_string(cbuf_get(gs.gs_cb), YB_NONE, NULL, xret, NULL) < 0)
+        goto done;
+    retval = 0;
+ done:
+    if (gs.gs_cb)
+        cbuf_free(gs.gs_cb);
+    return retval;
+}
+
+
 static int
 netconf_get_config_subtree(clixon_handle h,
                            cxobj        *xfilter,
@@ -111,6 +313,7 @@ ok:
  * @param[in]  h       Clixon handle
  * @param[in]  xn      Sub-tree (under xorig) at <rpc>...</rpc> level.
  * @param[out] xret    Return XML, error or OK
+ * @retval     1       Reply passed through and sent to client, see CLICON_NETCONF_PASSTHROUGH
  * @retval     0       OK
  * @retval    -1       Error
  * @note filter type subtree and xpath is supported, but xpath is preferred, and
@@ -179,9 +382,21 @@ netconf_get_config(clixon_handle h,
      /* ie <filter>...</filter> */
     if ((xfilter = xpath_first(xn, nsc, "%s%sfilter", prefix ? prefix : "", prefix ? ":" : "")) != NULL)
         ftype = xml_find_value(xfilter, "type");
+    /* Pass reply through if it needs no filtering here */
+    if (clicon_option_bool(h, "CLICON_NETCONF_PASSTHROUGH") &&
+        clicon_data_int_get(h, NETCONF_FRAMING_TYPE) == NETCONF_SSH_CHUNKED &&
+        !clicon_option_bool(h, "CLICON_SOCK_BINARY") &&
+        (xfilter == NULL || (ftype != NULL && strcmp(ftype, "xpath") == 0))){
+        retval = netconf_get_config_stream(h, xn, xret);
+        goto done;
+    }
     if (xfilter == NULL || ftype == NULL || strcmp(ftype, "subtree") == 0) {
-        /* Get whole config first, then filter. This is suboptimal
+        /* Translate subtree filter to an xpath select so that the backend only reads
+         * matching subtrees, if possible. Otherwise get whole config.
+         * Then filter exactly
          */
+        if (xfilter && xml_filter2xpath(xfilter) < 0)
+            goto done;
         if (clicon_rpc_netconf_xml(h, xml_parent(xn), xret, NULL) < 0)
             goto done;
         /* Now filter on whole tree */
@@ -361,6 +576,7 @@ netconf_edit_config(clixon_handle h,
  * @param[in]  h       Clixon handle
  * @param[in]  xn      Sub-tree (under xorig) at <rpc>...</rpc> level.
  * @param[out] xret    Return XML, error or OK
+ * @retval     1       Reply passed through and sent to client, see CLICON_NETCONF_PASSTHROUGH
  * @retval     0       OK
  * @retval    -1       Error
  * @note filter type subtree and xpath is supported, but xpath is preferred, and
@@ -393,8 +609,12 @@ netconf_get(clixon_handle h,
     if ((xfilter = xpath_first(xn, nsc, "%s%sfilter", prefix ? prefix : "", prefix ? ":" : "")) != NULL)
         ftype = xml_find_value(xfilter, "type");
     if (xfilter == NULL || ftype == NULL || strcmp(ftype, "subtree") == 0) {
-        /* Get whole config + state first, then filter. This is suboptimal
+        /* Translate subtree filter to an xpath select so that the backend only reads
+         * matching subtrees, if possible. Otherwise get whole config + state.
+         * Then filter exactly
          */
+        if (xfilter && xml_filter2xpath(xfilter) < 0)
+            goto done;
         if (clicon_rpc_netconf_xml(h, xml_parent(xn), xret, NULL) < 0)
             goto done;
         /* Now filter on whole tree */
@@ -692,6 +912,7 @@ netconf_application_rpc(clixon_handle h,
  * @param[in]  xn      Sub-tree (under xorig) at <rpc>...</rpc> level.
  * @param[out] xret    Return XML, error or OK
  * @param[out] eof     Set to 1 if pending close socket
+ * @retval     1       OK, reply already sent to client
  * @retval     0       OK, can also be netconf error 
  * @retval    -1       Error, fatal
  */
@@ -736,7 +957,9 @@ netconf_rpc_dispatch(clixon_handle h,
                 goto done;
         }
         else if (strcmp(xml_name(xe), "get-config") == 0){
-            if (netconf_get_config(h, xe, xret) < 0)
+            if ((retval = netconf_get_config(h, xe, xret)) < 0)
+                goto done;
+            if (retval == 1) /* Reply already sent */
                 goto done;
         }
         else if (strcmp(xml_name(xe), "edit-config") == 0){
@@ -42,6 +42,7 @@
 /*
  * Prototypes
  */
+int netconf_add_request_attr(cxobj *xrpc, cxobj *xrep);
 int 
 netconf_rpc_dispatch(clixon_handle h,
                      cxobj        *xn,
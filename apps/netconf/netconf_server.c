@@ -0,0 +1,443 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2016 Olof Hagsand and Benny Holmgren
+  Copyright (C) 2017-2019 Olof Hagsand
+  Copyright (C) 2020-2024 Olof Hagsand and Rubicon Communications, LLC (Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ *
+ * Persistent netconf session server
+ * The server loads configuration, plugins and YANG once, and listens on the unix socket
+ * CLICON_NETCONF_SERVER_SOCK. A clixon_netconf started per session, eg as a sshd subsystem,
+ * connects to the socket, passes its stdin and stdout to the server with SCM_RIGHTS and waits
+ * until the session closes. The server forks a child per session which runs the session on
+ * the passed descriptors with the already loaded YANG.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <syslog.h>
+#include <sys/param.h>
+#include <sys/stat.h>
+#define __USE_GNU   /* for ucred */
+#define _GNU_SOURCE /* for ucred */
+#include <sys/socket.h>
+#ifdef HAVE_LOCAL_PEERCRED
+#include <sys/ucred.h>
+#endif
+#include <sys/types.h>
+#include <sys/un.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include <clixon/clixon.h>
+
+#include "netconf_server.h"
+
+/*! State of netconf session server
+ */
+struct netconf_server {
+    clixon_handle       ns_h;   /* Clixon handle */
+    int                 ns_s;   /* Listen socket */
+    netconf_session_cb *ns_fn;  /* Start session in child */
+    void               *ns_arg; /* Argument to ns_fn */
+};
+
+/* Single server per process */
+static struct netconf_server _netconf_server = {0,};
+
+/*! Send stdin and stdout descriptors over unix socket
+ *
+ * One byte of data is sent along with the descriptors
+ * @param[in]  s    Unix socket
+ * @param[in]  fds  Descriptors
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+netconf_server_fds_send(int  s,
+                        int *fds)
+{
+    int             retval = -1;
+    struct msghdr   msg = {0,};
+    struct cmsghdr *cmsg;
+    struct iovec    iov;
+    char            ch = 0;
+    char            buf[CMSG_SPACE(2*sizeof(int))];
+
+    memset(buf, 0, sizeof(buf));
+    iov.iov_base = &ch;
+    iov.iov_len = 1;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = buf;
+    msg.msg_controllen = sizeof(buf);
+    cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(2*sizeof(int));
+    memcpy(CMSG_DATA(cmsg), fds, 2*sizeof(int));
+    while (sendmsg(s, &msg, 0) < 0){
+        if (errno == EINTR)
+            continue;
+        clixon_err(OE_UNIX, errno, "sendmsg");
+        goto done;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Receive stdin and stdout descriptors over unix socket
+ *
+ * @param[in]  s    Unix socket
+ * @param[out] fds  Descriptors
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+netconf_server_fds_recv(int  s,
+                        int *fds)
+{
+    int             retval = -1;
+    struct msghdr   msg = {0,};
+    struct cmsghdr *cmsg;
+    struct iovec    iov;
+    char            ch;
+    char            buf[CMSG_SPACE(2*sizeof(int))];
+    ssize_t         n;
+
+    iov.iov_base = &ch;
+    iov.iov_len = 1;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = buf;
+    msg.msg_controllen = sizeof(buf);
+    while ((n = recvmsg(s, &msg, 0)) < 0){
+        if (errno == EINTR)
+            continue;
+        clixon_err(OE_UNIX, errno, "recvmsg");
+        goto done;
+    }
+    if ((cmsg = CMSG_FIRSTHDR(&msg)) == NULL ||
+        cmsg->cmsg_level != SOL_SOCKET ||
+        cmsg->cmsg_type != SCM_RIGHTS ||
+        cmsg->cmsg_len != CMSG_LEN(2*sizeof(int))){
+        clixon_err(OE_UNIX, 0, "Expected stdin and stdout descriptors");
+        goto done;
+    }
+    memcpy(fds, CMSG_DATA(cmsg), 2*sizeof(int));
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Get user name of peer of unix socket
+ *
+ * @param[in]  s     Unix socket
+ * @param[out] name  User name, malloced
+ * @retval     0     OK
+ * @retval    -1    Error
+ */
+static int
+netconf_server_peer(int    s,
+                    char **name)
+{
+    int          retval = -1;
+#if defined(HAVE_SO_PEERCRED)
+    socklen_t    clen;
+    struct ucred cr = {0,};
+
+    clen =  sizeof(cr);
+    if (getsockopt(s, SOL_SOCKET, SO_PEERCRED, &cr, &clen) < 0){
+        clixon_err(OE_UNIX, errno, "getsockopt");
+        goto done;
+    }
+    if (uid2name(cr.uid, name) < 0)
+        goto done;
+#elif defined(HAVE_GETPEEREID)
+    uid_t        euid;
+    uid_t        guid;
+
+    if (getpeereid(s, &euid, &guid) < 0){
+        clixon_err(OE_UNIX, errno, "getpeereid");
+        goto done;
+    }
+    if (uid2name(euid, name) < 0)
+        goto done;
+#else
+#error "Need getsockopt O_PEERCRED or getpeereid for unix socket peer cred"
+#endif
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Accept a session, fork a child and start the session in the child on the passed descriptors
+ *
+ * The child keeps the connection to the session process open until it exits.
+ * The session user is the user of the connecting process.
+ * @param[in]  fd   Listen socket
+ * @param[in]  arg  Netconf server
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+netconf_server_accept(int   fd,
+                      void *arg)
+{
+    int                    retval = -1;
+    struct netconf_server *ns = (struct netconf_server *)arg;
+    clixon_handle          h = ns->ns_h;
+    int                    s = -1;
+    int                    fds[2] = {-1, -1};
+    char                  *name = NULL;
+    pid_t                  pid;
+    int                    i;
+
+    if ((s = accept(fd, NULL, NULL)) < 0){
+        clixon_err(OE_UNIX, errno, "accept");
+        goto done;
+    }
+    if (netconf_server_peer(s, &name) < 0 ||
+        netconf_server_fds_recv(s, fds) < 0){
+        /* Error of one session, not of server */
+        clixon_log(h, LOG_WARNING, "%s: %s", __FUNCTION__, clixon_err_reason());
+        clixon_err_reset();
+        goto ok;
+    }
+    if ((pid = fork()) < 0){
+        clixon_err(OE_UNIX, errno, "fork");
+        goto done;
+    }
+    if (pid == 0){ /* Child: run session */
+        clixon_event_unreg_fd(ns->ns_s, netconf_server_accept);
+        close(ns->ns_s);
+        set_signal(SIGCHLD, SIG_DFL, NULL);
+        if (fcntl(s, F_SETFD, FD_CLOEXEC) < 0){
+            clixon_err(OE_UNIX, errno, "fcntl");
+            goto done;
+        }
+        s = -1; /* Closed on exit */
+        for (i=0; i<2; i++){
+            if (fds[i] != i){
+                if (dup2(fds[i], i) < 0){
+                    clixon_err(OE_UNIX, errno, "dup2");
+                    goto done;
+                }
+                if (fds[i] > 1)
+                    close(fds[i]);
+            }
+            fds[i] = -1;
+        }
+        /* Do not share backend socket of server */
+        if ((i = clicon_client_socket_get(h)) >= 0){
+            close(i);
+            clicon_client_socket_set(h, -1);
+        }
+        if (name && clicon_username_set(h, name) < 0)
+            goto done;
+        clixon_debug(CLIXON_DBG_NETCONF, "session of %s pid: %d", name?name:"", getpid());
+        if (ns->ns_fn(h, ns->ns_arg) < 0)
+            goto done;
+    }
+ ok:
+    retval = 0;
+ done:
+    for (i=0; i<2; i++)
+        if (fds[i] > 1)
+            close(fds[i]);
+    if (s != -1)
+        close(s);
+    if (name)
+        free(name);
+    return retval;
+}
+
+/*! Open listen socket of netconf session server
+ *
+ * Same permissions as backend socket: owner and CLICON_SOCK_GROUP
+ * @param[in]  h        Clixon handle
+ * @param[in]  sockpath Unix socket path
+ * @retval     s        Socket
+ * @retval    -1        Error
+ */
+static int
+netconf_server_socket(clixon_handle h,
+                      const char   *sockpath)
+{
+    int                s = -1;
+    struct sockaddr_un addr;
+    mode_t             old_mask;
+    char              *group;
+    gid_t              gid;
+    struct stat        st;
+
+    if (lstat(sockpath, &st) == 0 && unlink(sockpath) < 0){
+        clixon_err(OE_UNIX, errno, "unlink(%s)", sockpath);
+        goto err;
+    }
+    if ((group = clicon_sock_group(h)) == NULL){
+        clixon_err(OE_FATAL, 0, "clicon_sock_group option not set");
+        goto err;
+    }
+    if (group_name2gid(group, &gid) < 0)
+        goto err;
+    if ((s = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) {
+        clixon_err(OE_UNIX, errno, "socket");
+        goto err;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, sockpath, sizeof(addr.sun_path)-1);
+    old_mask = umask(S_IRWXO | S_IXGRP | S_IXUSR);
+    if (bind(s, (struct sockaddr *)&addr, SUN_LEN(&addr)) < 0){
+        clixon_err(OE_UNIX, errno, "bind");
+        umask(old_mask);
+        goto err;
+    }
+    umask(old_mask);
+    if (lchown(sockpath, -1, gid) < 0){
+        clixon_err(OE_UNIX, errno, "lchown(%s, %s)", sockpath, group);
+        goto err;
+    }
+    if (listen(s, SOMAXCONN) < 0){
+        clixon_err(OE_UNIX, errno, "listen");
+        goto err;
+    }
+    clixon_debug(CLIXON_DBG_NETCONF, "Listen on netconf server socket at %s", sockpath);
+    return s;
+ err:
+    if (s != -1)
+        close(s);
+    return -1;
+}
+
+/*! Start persistent netconf session server
+ *
+ * Listen for sessions in the event loop. Each session runs in a forked child where fn is
+ * called to start the session on stdin and stdout.
+ * @param[in]  h        Clixon handle
+ * @param[in]  sockpath Unix socket path, see CLICON_NETCONF_SERVER_SOCK
+ * @param[in]  fn       Start a session in child
+ * @param[in]  arg      Argument to fn
+ * @retval     0        OK
+ * @retval    -1        Error
+ */
+int
+netconf_server_init(clixon_handle       h,
+                    const char         *sockpath,
+                    netconf_session_cb *fn,
+                    void               *arg)
+{
+    int                    retval = -1;
+    struct netconf_server *ns = &_netconf_server;
+
+    /* Reap session children */
+    if (set_signal(SIGCHLD, SIG_IGN, NULL) < 0){
+        clixon_err(OE_UNIX, errno, "Setting SIGCHLD signal");
+        goto done;
+    }
+    ns->ns_h = h;
+    ns->ns_fn = fn;
+    ns->ns_arg = arg;
+    if ((ns->ns_s = netconf_server_socket(h, sockpath)) < 0)
+        goto done;
+    if (clixon_event_reg_fd(ns->ns_s, netconf_server_accept, ns, "netconf server socket") < 0)
+        goto done;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Hand over a session to a persistent netconf session server
+ *
+ * Connect to server, pass stdin and stdout, and wait until the session closes
+ * @param[in]  h        Clixon handle
+ * @param[in]  sockpath Unix socket path, see CLICON_NETCONF_SERVER_SOCK
+ * @retval     1        Session served and closed
+ * @retval     0        No server, run session in this process
+ * @retval    -1        Error
+ */
+int
+netconf_server_shim(clixon_handle h,
+                    const char   *sockpath)
+{
+    int                retval = -1;
+    struct sockaddr_un addr;
+    int                s = -1;
+    int                fds[2] = {0, 1};
+    int                fd;
+    char               ch;
+
+    if ((s = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) {
+        clixon_err(OE_UNIX, errno, "socket");
+        goto done;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, sockpath, sizeof(addr.sun_path)-1);
+    if (connect(s, (struct sockaddr *)&addr, SUN_LEN(&addr)) < 0){
+        clixon_debug(CLIXON_DBG_NETCONF, "No netconf server at %s: %s", sockpath, strerror(errno));
+        retval = 0;
+        goto done;
+    }
+    if (netconf_server_fds_send(s, fds) < 0)
+        goto done;
+    /* Only the server uses the session descriptors from now on */
+    if ((fd = open("/dev/null", O_RDWR)) < 0){
+        clixon_err(OE_UNIX, errno, "open(/dev/null)");
+        goto done;
+    }
+    dup2(fd, 0);
+    dup2(fd, 1);
+    if (fd > 1)
+        close(fd);
+    /* Wait until server closes session */
+    while (read(s, &ch, 1) < 0 && errno == EINTR)
+        ;
+    retval = 1;
+ done:
+    if (s != -1)
+        close(s);
+    return retval;
+}
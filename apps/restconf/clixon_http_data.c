@@ -44,6 +44,8 @@
 #include <string.h>
 #include <unistd.h>
 #include <errno.h>
+#include <ctype.h>
+#include <stdint.h>
 #include <signal.h>
 #include <syslog.h>
 #include <fcntl.h>
@@ -265,6 +267,70 @@ http_data_check_file_path(clixon_handle h,
     goto done;
 }
 
+/*! Parse a single byte range of a Range request header
+ *
+ * Multiple ranges and other range units are not supported, the whole file is then sent.
+ * @param[in]  range  Range header value, eg "bytes=0-499", "bytes=500-" or "bytes=-500"
+ * @param[in]  fsz    File size
+ * @param[out] start  First byte of range
+ * @param[out] len    Length of range
+ * @retval     2      Valid range, reply with 206 Partial Content
+ * @retval     1      Invalid or unsupported range, ignore and reply with whole file
+ * @retval     0      Range not satisfiable, reply with 416
+ * @see RFC 7233 Sec 2.1
+ */
+static int
+http_data_range(const char *range,
+                off_t       fsz,
+                off_t      *start,
+                off_t      *len)
+{
+    const char        *p;
+    char              *end;
+    unsigned long long a;
+    unsigned long long b;
+
+    if (strncmp(range, "bytes=", 6) != 0 || index(range, ',') != NULL)
+        return 1;
+    p = range + 6;
+    if (*p == '-'){ /* suffix-byte-range-spec: last n bytes */
+        if (!isdigit(p[1]))
+            return 1;
+        b = strtoull(p+1, &end, 10);
+        if (*end != '\0')
+            return 1;
+        if (b == 0 || fsz == 0)
+            return 0;
+        if (b > fsz)
+            b = fsz;
+        *start = fsz - b;
+        *len = b;
+        return 2;
+    }
+    if (!isdigit(*p))
+        return 1;
+    a = strtoull(p, &end, 10);
+    if (*end != '-')
+        return 1;
+    p = end + 1;
+    if (*p == '\0') /* Open range to end of file */
+        b = fsz;
+    else {
+        if (!isdigit(*p))
+            return 1;
+        b = strtoull(p, &end, 10);
+        if (*end != '\0' || b < a)
+            return 1;
+    }
+    if (a >= fsz)
+        return 0;
+    if (b >= fsz)
+        b = fsz - 1;
+    *start = a;
+    *len = b - a + 1;
+    return 2;
+}
+
 /*! Read file data request
  *
  * @param[in]  h         Clixon handle
@@ -285,17 +351,24 @@ api_http_data_file(clixon_handle h,
     int    retval = -1;
     cbuf  *cbfile = NULL;
     char  *filename = NULL;
-    cbuf  *cbdata = NULL;
     FILE  *f = NULL;
+    int    fd = -1;
     off_t  fsz = 0;
     long   fsize;
     char  *www_data_root = NULL;
     char  *suffix;
     char  *media;
-    char  *buf = NULL;
-    size_t sz;
     char  *media_list = NULL;
+    char  *range;
+    off_t  start = 0;
+    off_t  len = 0;
+    int    code = 200;
     int    ret;
+    char  *coding_list;
+    cbuf  *cbgz = NULL;
+    FILE  *fgz;
+    struct stat st;
+    int    gzip = 0;
 
     clixon_debug(CLIXON_DBG_RESTCONF, "");
     if ((cbfile = cbuf_new()) == NULL){
@@ -344,11 +417,32 @@ api_http_data_file(clixon_handle h,
             goto ok;
         }
     }
+    /* Precompressed file <filename>.gz in same directory, if client accepts gzip */
+    if (clicon_option_bool(h, "CLICON_HTTP_DATA_PRECOMPRESSED") &&
+        (coding_list = restconf_param_get(h, "HTTP_ACCEPT_ENCODING")) != NULL &&
+        restconf_coding_in_list("gzip", coding_list)){
+        if ((cbgz = cbuf_new()) == NULL){
+            clixon_err(OE_UNIX, errno, "cbuf_new");
+            goto done;
+        }
+        cprintf(cbgz, "%s.gz", filename);
+        /* Ensure not soft link */
+        if (lstat(cbuf_get(cbgz), &st) == 0 && S_ISREG(st.st_mode) &&
+            (fgz = fopen(cbuf_get(cbgz), "rb")) != NULL){
+            clixon_debug(CLIXON_DBG_RESTCONF, "precompressed: %s", cbuf_get(cbgz));
+            fclose(f);
+            f = fgz;
+            fsz = st.st_size;
+            filename = cbuf_get(cbgz);
+            gzip = 1;
+        }
+    }
     /* Size could have been taken from stat() but this reduces the race condition interval 
      * There is still one without flock
      */
     fseek(f, 0, SEEK_END);
     fsize = ftell(f);
+    len = fsize;
     /* Extra sanity check, had some problems with wrong file types */
     if (fsz != fsize){
         clixon_debug(CLIXON_DBG_RESTCONF, "Error file %s size mismatch sz:%zu vs %li",
@@ -357,50 +451,53 @@ api_http_data_file(clixon_handle h,
             goto done;
         goto ok;
     }
-    fseek(f, 0, SEEK_SET);  /* same as rewind(f); */
-    if ((cbdata = cbuf_new_alloc(fsize+1)) == NULL){
-        clixon_err(OE_UNIX, errno, "cbuf_new_alloc");
-        goto done;
+    /* Single byte range, unless If-Range since no validators are kept for files */
+    if ((range = restconf_param_get(h, "HTTP_RANGE")) != NULL &&
+        restconf_param_get(h, "HTTP_IF_RANGE") == NULL){
+        if ((ret = http_data_range(range, fsz, &start, &len)) == 0){
+            if (restconf_reply_header(req, "Content-Range", "bytes */%jd", (intmax_t)fsz) < 0)
+                goto done;
+            if (api_http_data_err(h, req, 416) < 0)
+                goto done;
+            goto ok;
+        }
+        if (ret == 2)
+            code = 206;
     }
-    /* Unoptimized, no direct read but requires an extra copy,
-     * the cligen buf API should have some mechanism for this case without the extra copy.
-     */
-    if ((buf = malloc(fsize)) == NULL){
-        clixon_err(OE_UNIX, errno, "malloc");
+    /* Body is not read here, the open file is handed over and written when sent */
+    if ((fd = dup(fileno(f))) < 0){
+        clixon_err(OE_UNIX, errno, "dup");
         goto done;
     }
-    if ((ret = fread(buf, fsize, 1, f)) < 0){
-        clixon_err(OE_UNIX, errno, "fread");
+    if (restconf_reply_header(req, "Content-Type", "%s", media) < 0)
         goto done;
-    }
-    sz = (size_t)ret;
-    if (sz != 1){
-        clixon_debug(CLIXON_DBG_RESTCONF, "Error fread(%s) sz:%zu", filename, sz);
-        if (api_http_data_err(h, req, 500) < 0) /* Internal error? */
-            goto done;
-        goto ok;
-    }
-    if (cbuf_append_buf(cbdata, buf, fsize) < 0){
-        clixon_err(OE_UNIX, errno, "cbuf_append_str");
+    if (restconf_reply_header(req, "Accept-Ranges", "bytes") < 0)
         goto done;
-    }
-    if (restconf_reply_header(req, "Content-Type", "%s", media) < 0)
+    if (code == 206 &&
+        restconf_reply_header(req, "Content-Range", "bytes %jd-%jd/%jd",
+                              (intmax_t)start, (intmax_t)(start+len-1), (intmax_t)fsz) < 0)
         goto done;
-    if (restconf_reply_send(req, 200, cbdata, head) < 0)
+    if (gzip){
+        if (restconf_reply_header(req, "Content-Encoding", "gzip") < 0)
+            goto done;
+        if (restconf_reply_header(req, "Vary", "Accept-Encoding") < 0)
+            goto done;
+    }
+    if (restconf_reply_send_file(req, code, fd, start, len, head) < 0)
         goto done;
-    cbdata = NULL; /* consumed by reply-send */
+    fd = -1; /* consumed by reply-send */
     clixon_debug(CLIXON_DBG_RESTCONF, "Read %s OK", filename);
  ok:
     retval = 0;
  done:
-    if (buf)
-        free(buf);
+    if (fd != -1)
+        close(fd);
     if (f)
         fclose(f);
+    if (cbgz)
+        cbuf_free(cbgz);
     if (cbfile)
         cbuf_free(cbfile);
-    if (cbdata)
-        cbuf_free(cbdata);
  return retval;
 }
 
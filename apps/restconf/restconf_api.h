@@ -38,6 +38,25 @@
 #ifndef _RESTCONF_API_H_
 #define _RESTCONF_API_H_
 
+/*
+ * Types
+ */
+/*! Producer of a streamed reply body
+ *
+ * Serializes the body into cb and calls flush with the output whenever cb exceeds size.
+ * Output remaining in cb on return is sent last.
+ * @param[in]  arg      Producer argument
+ * @param[in]  cb       Output buffer
+ * @param[in]  size     Flush output when cb exceeds this size
+ * @param[in]  flush    Flush callback, resets cb
+ * @param[in]  flusharg Flush callback argument
+ * @retval     0        OK
+ * @retval    -1        Error
+ * @see restconf_reply_send_stream
+ */
+typedef int (restconf_body_fn)(void *arg, cbuf *cb, size_t size,
+                               clixon_xml_flush_cb *flush, void *flusharg);
+
 /*
  * Prototypes
  */
@@ -46,6 +65,11 @@ int restconf_reply_header(void *req, const char *name, const char *vfmt, ...)  _
 /* note cb is consumed dont free */
 int restconf_reply_send(void *req, int code, cbuf *cb, int head);
 
+/* note fd is consumed dont close */
+int restconf_reply_send_file(void *req, int code, int fd, off_t offset, size_t len, int head);
+
+int restconf_reply_send_stream(void *req, int code, size_t size, restconf_body_fn *fn, void *arg);
+
 cbuf *restconf_get_indata(void *req);
 
 #endif /* _RESTCONF_API_H_ */
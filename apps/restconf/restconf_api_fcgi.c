@@ -230,6 +230,122 @@ restconf_reply_send(void  *req0,
     return retval;
 }
 
+/*! Send HTTP reply with a message body taken from a region of a file
+ *
+ * @param[in]  req    Fastcgi request handle
+ * @param[in]  code   Status code
+ * @param[in]  fd     Open file descriptor. Note is consumed
+ * @param[in]  offset Start of body in file
+ * @param[in]  len    Length of body
+ * @param[in]  head   Only send headers, dont send body. 
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see restconf_reply_send
+ */
+int
+restconf_reply_send_file(void  *req0,
+                         int    code,
+                         int    fd,
+                         off_t  offset,
+                         size_t len,
+                         int    head)
+{
+    FCGX_Request *req = (FCGX_Request *)req0;
+    int           retval = -1;
+    const char   *reason_phrase;
+    char          buf[BUFSIZ];
+    ssize_t       n;
+
+    FCGX_SetExitStatus(code, req->out);
+    if ((reason_phrase = restconf_code2reason(code)) == NULL)
+        reason_phrase="";
+    if (restconf_reply_header(req, "Status", "%d %s", code, reason_phrase) < 0)
+        goto done;
+    FCGX_FPrintF(req->out, "\r\n");
+    while (!head && len > 0){
+        if ((n = pread(fd, buf, len<sizeof(buf)?len:sizeof(buf), offset)) < 0){
+            clixon_err(OE_UNIX, errno, "pread");
+            goto done;
+        }
+        if (n == 0)
+            break;
+        FCGX_PutStr(buf, n, req->out);
+        offset += n;
+        len -= n;
+    }
+    FCGX_FFlush(req->out);
+    retval = 0;
+ done:
+    close(fd);
+    return retval;
+}
+
+/*! Write streamed reply body output to fastcgi output stream
+ *
+ * @param[in]  cb   Output
+ * @param[in]  arg  Fastcgi request handle
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+restconf_reply_flush(cbuf *cb,
+                     void *arg)
+{
+    FCGX_Request *req = (FCGX_Request *)arg;
+
+    if (FCGX_PutStr(cbuf_get(cb), cbuf_len(cb), req->out) < 0){
+        clixon_err(OE_RESTCONF, errno, "FCGX_PutStr");
+        return -1;
+    }
+    return 0;
+}
+
+/*! Send HTTP reply with a message body produced while it is sent
+ *
+ * @param[in]  req   Fastcgi request handle
+ * @param[in]  code  Status code
+ * @param[in]  size  Producer output is flushed in this size
+ * @param[in]  fn    Body producer
+ * @param[in]  arg   Body producer argument
+ * @retval     1     OK, reply sent as stream
+ * @retval    -1     Error
+ * @note Body is partially sent on error
+ */
+int
+restconf_reply_send_stream(void             *req0,
+                           int               code,
+                           size_t            size,
+                           restconf_body_fn *fn,
+                           void             *arg)
+{
+    FCGX_Request *req = (FCGX_Request *)req0;
+    int           retval = -1;
+    const char   *reason_phrase;
+    cbuf         *cb = NULL;
+
+    FCGX_SetExitStatus(code, req->out);
+    if ((reason_phrase = restconf_code2reason(code)) == NULL)
+        reason_phrase="";
+    if (restconf_reply_header(req, "Status", "%d %s", code, reason_phrase) < 0)
+        goto done;
+    FCGX_FPrintF(req->out, "\r\n");
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if (fn(arg, cb, size, restconf_reply_flush, req) < 0)
+        goto done;
+    if (restconf_reply_flush(cb, req) < 0)
+        goto done;
+    FCGX_FPrintF(req->out, "\r\n");
+    FCGX_FFlush(req->out);
+    retval = 1;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
 /*! Get input data from http request, eg such as curl -X PUT http://... <indata>
  *
  * @param[in]  req        Fastcgi request handle
@@ -63,6 +63,9 @@
 #include "restconf_lib.h"
 #include "restconf_api.h"  /* Virtual api */
 #include "restconf_native.h"
+#ifdef HAVE_LIBNGHTTP2
+#include "restconf_nghttp2.h"
+#endif
 
 /*! Add HTTP header field name and value to reply
  *
@@ -185,6 +188,90 @@ restconf_reply_send(void  *req0,
     return retval;
 }
 
+/*! Send HTTP reply with a message body taken from a region of a file
+ *
+ * The file is not read here, the region is written to the connection when the reply
+ * is sent, using sendfile or mmap for HTTP/1 and read on demand for HTTP/2.
+ * @param[in]  req    Generic http handle
+ * @param[in]  code   Status code
+ * @param[in]  fd     Open file descriptor. Note is consumed
+ * @param[in]  offset Start of body in file
+ * @param[in]  len    Length of body
+ * @param[in]  head   Only send headers, dont send body. 
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see restconf_reply_send
+ */
+int
+restconf_reply_send_file(void  *req0,
+                         int    code,
+                         int    fd,
+                         off_t  offset,
+                         size_t len,
+                         int    head)
+{
+    int                   retval = -1;
+    restconf_stream_data *sd = (restconf_stream_data *)req0;
+
+    clixon_debug(CLIXON_DBG_RESTCONF, "code:%d len:%zu", code, len);
+    if (sd == NULL){
+        clixon_err(OE_CFG, EINVAL, "sd is NULL");
+        goto done;
+    }
+    sd->sd_code = code;
+    sd->sd_body_len = len;
+    sd->sd_body_offset = 0;
+    if (sd->sd_file_fd != -1)
+        close(sd->sd_file_fd);
+    sd->sd_file_fd = -1;
+    if (head || len == 0)
+        close(fd);
+    else{
+        sd->sd_file_fd = fd;
+        sd->sd_file_offset = offset;
+    }
+    fd = -1;
+    retval = 0;
+ done:
+    if (fd != -1)
+        close(fd);
+    return retval;
+}
+
+/*! Send HTTP reply with a message body produced while it is sent
+ *
+ * Only HTTP/2 is supported: the body is produced in a separate process and sent in
+ * DATA frames as output becomes available, without Content-Length.
+ * @param[in]  req   Generic http handle
+ * @param[in]  code  Status code
+ * @param[in]  size  Producer output is flushed, and at most buffered, in this size
+ * @param[in]  fn    Body producer
+ * @param[in]  arg   Body producer argument
+ * @retval     1     OK, reply sent as stream
+ * @retval     0     Not supported, send reply with restconf_reply_send
+ * @retval    -1     Error
+ */
+int
+restconf_reply_send_stream(void             *req0,
+                           int               code,
+                           size_t            size,
+                           restconf_body_fn *fn,
+                           void             *arg)
+{
+    restconf_stream_data *sd = (restconf_stream_data *)req0;
+
+    clixon_debug(CLIXON_DBG_RESTCONF, "code:%d", code);
+    if (sd == NULL){
+        clixon_err(OE_CFG, EINVAL, "sd is NULL");
+        return -1;
+    }
+#ifdef HAVE_LIBNGHTTP2
+    if (sd->sd_conn->rc_proto == HTTP_2)
+        return http2_reply_stream(sd, code, size, fn, arg);
+#endif
+    return 0;
+}
+
 /*! Get input data from http request, eg such as curl -X PUT http://... <indata>
  *
  * @param[in]  req        Request handle
@@ -0,0 +1,203 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+  *
+
+  * Response cache of restconf GET of configuration data
+  * Small LRU of serialized replies keyed on path, query, user and media type.
+  * An entry is valid as long as its entity tag equals the current one of the backend,
+  * that is, until a commit changes the data.
+  */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <syslog.h>
+#include <sys/time.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include <clixon/clixon.h>
+
+#include "restconf_cache.h"
+
+/*! One cached reply
+ */
+struct restconf_cache {
+    qelem_t               rce_qelem;  /* List header, most recently used first */
+    char                 *rce_key;    /* Path, query, user and media type */
+    char                 *rce_etag;   /* Entity tag of reply */
+    cbuf                 *rce_body;   /* Serialized reply body */
+};
+
+static struct restconf_cache *_restconf_cache = NULL;
+static int                    _restconf_cache_len = 0;
+
+static int
+restconf_cache_entry_free(struct restconf_cache *rce)
+{
+    if (rce->rce_key)
+        free(rce->rce_key);
+    if (rce->rce_etag)
+        free(rce->rce_etag);
+    if (rce->rce_body)
+        cbuf_free(rce->rce_body);
+    free(rce);
+    return 0;
+}
+
+/*! Look up a cached reply
+ *
+ * An entry with another entity tag is stale and removed
+ * @param[in]  h     Clixon handle
+ * @param[in]  key   Cache key
+ * @param[in]  etag  Current entity tag
+ * @param[out] cbp   Copy of cached body, free with cbuf_free
+ * @retval     1     Hit, cbp set
+ * @retval     0     Miss
+ * @retval    -1     Error
+ */
+int
+restconf_cache_get(clixon_handle h,
+                   const char   *key,
+                   const char   *etag,
+                   cbuf        **cbp)
+{
+    struct restconf_cache *rce;
+    cbuf                  *cb;
+
+    if ((rce = _restconf_cache) != NULL)
+        do {
+            if (strcmp(rce->rce_key, key) == 0){
+                DELQ(rce, _restconf_cache, struct restconf_cache *);
+                if (strcmp(rce->rce_etag, etag) != 0){
+                    _restconf_cache_len--;
+                    restconf_cache_entry_free(rce);
+                    return 0;
+                }
+                INSQ(rce, _restconf_cache);
+                if ((cb = cbuf_new()) == NULL){
+                    clixon_err(OE_UNIX, errno, "cbuf_new");
+                    return -1;
+                }
+                if (cbuf_append_buf(cb, cbuf_get(rce->rce_body), cbuf_len(rce->rce_body)) < 0){
+                    clixon_err(OE_UNIX, errno, "cbuf_append_buf");
+                    cbuf_free(cb);
+                    return -1;
+                }
+                *cbp = cb;
+                return 1;
+            }
+            rce = NEXTQ(struct restconf_cache *, rce);
+        } while (rce && rce != _restconf_cache);
+    return 0;
+}
+
+/*! Add a reply to the cache, evict the least recently used if full
+ *
+ * @param[in]  h     Clixon handle
+ * @param[in]  key   Cache key
+ * @param[in]  etag  Entity tag of reply
+ * @param[in]  cb    Reply body, copied
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see CLICON_RESTCONF_CACHE
+ */
+int
+restconf_cache_put(clixon_handle h,
+                   const char   *key,
+                   const char   *etag,
+                   cbuf         *cb)
+{
+    int                    retval = -1;
+    struct restconf_cache *rce = NULL;
+    struct restconf_cache *rlru;
+    int                    size;
+
+    if ((size = clicon_option_int(h, "CLICON_RESTCONF_CACHE")) <= 0)
+        goto ok;
+    while (_restconf_cache_len >= size){
+        rlru = PREVQ(struct restconf_cache *, _restconf_cache);
+        DELQ(rlru, _restconf_cache, struct restconf_cache *);
+        _restconf_cache_len--;
+        restconf_cache_entry_free(rlru);
+    }
+    if ((rce = malloc(sizeof(*rce))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    memset(rce, 0, sizeof(*rce));
+    if ((rce->rce_key = strdup(key)) == NULL ||
+        (rce->rce_etag = strdup(etag)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    if ((rce->rce_body = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if (cbuf_append_buf(rce->rce_body, cbuf_get(cb), cbuf_len(cb)) < 0){
+        clixon_err(OE_UNIX, errno, "cbuf_append_buf");
+        goto done;
+    }
+    INSQ(rce, _restconf_cache);
+    _restconf_cache_len++;
+    rce = NULL;
+ ok:
+    retval = 0;
+ done:
+    if (rce)
+        restconf_cache_entry_free(rce);
+    return retval;
+}
+
+/*! Free all cached replies
+ */
+int
+restconf_cache_free(void)
+{
+    struct restconf_cache *rce;
+
+    while ((rce = _restconf_cache) != NULL){
+        DELQ(rce, _restconf_cache, struct restconf_cache *);
+        restconf_cache_entry_free(rce);
+    }
+    _restconf_cache_len = 0;
+    return 0;
+}
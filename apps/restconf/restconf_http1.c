@@ -294,6 +294,45 @@ http1_upgrade_http2(clixon_handle         h,
 }
 #endif /* HAVE_LIBNGHTTP2 */
 
+/*! Check if the connection is to be kept open after the current request
+ *
+ * HTTP/1.1 is persistent unless the client sends "Connection: close", HTTP/1.0 only
+ * if the client sends "Connection: keep-alive"
+ * @param[in] h   Clixon handle
+ * @param[in] rc  Restconf connection
+ * @retval    1   Keep connection open
+ * @retval    0   Close connection after reply
+ * @see rfc7230 Sec 6.3
+ */
+static int
+http1_keepalive(clixon_handle  h,
+                restconf_conn *rc)
+{
+    char  *val;
+    char  *p;
+    size_t len;
+    int    close = 0;
+    int    keep = 0;
+
+    if ((val = restconf_param_get(h, "HTTP_CONNECTION")) != NULL){
+        p = val;
+        while (*p){
+            p += strspn(p, " \t,");
+            len = strcspn(p, " \t,");
+            if (len == 5 && strncasecmp(p, "close", len) == 0)
+                close++;
+            else if (len == 10 && strncasecmp(p, "keep-alive", len) == 0)
+                keep++;
+            p += len;
+        }
+    }
+    if (close)
+        return 0;
+    if (rc->rc_proto_d1 == 1 && rc->rc_proto_d2 == 0)
+        return keep?1:0;
+    return 1;
+}
+
 /*! Construct an HTTP/1 reply (dont actually send it)
  */
 static int
@@ -311,15 +350,10 @@ restconf_http1_reply(restconf_conn        *rc,
      * (Successful) response to a CONNECT request (Section 4.3.6 of
      * [RFC7231]).
      */
-    if (sd->sd_code != 204 && sd->sd_code > 199 && !rc->rc_event_stream)
+    if (sd->sd_code != 204 && sd->sd_code != 304 && sd->sd_code > 199 && !rc->rc_event_stream)
         if (restconf_reply_header(sd, "Content-Length", "%zu", sd->sd_body_len) < 0)
             goto done;
     /* Create reply and write headers */
-#if 0 /* XXX need some keep-alive logic here */
-    /* protocol is HTTP/1.0 and clients wants to keep established */
-    if (restconf_reply_header(sd, "Connection", "keep-alive") < 0)
-        goto done;
-#endif
     cprintf(sd->sd_outp_buf, "HTTP/%u.%u %u %s\r\n",
             rc->rc_proto_d1,
             rc->rc_proto_d2,
@@ -362,6 +396,7 @@ restconf_http1_path_root(clixon_handle  h,
     char                 *subject = NULL;
     cxobj                *xerr = NULL;
     int                   pretty;
+    int                   keepalive;
 #ifdef HAVE_LIBNGHTTP2
     int                   ret;
 #endif
@@ -372,6 +407,7 @@ restconf_http1_path_root(clixon_handle  h,
         clixon_err(OE_RESTCONF, EINVAL, "No stream_data");
         goto done;
     }
+    keepalive = http1_keepalive(h, rc);
     /* Sanity check */
     if (restconf_param_get(h, "REQUEST_URI") == NULL){
         if (netconf_invalid_value_xml(&xerr, "protocol", "Missing REQUEST_URI ") < 0)
@@ -458,7 +494,19 @@ restconf_http1_path_root(clixon_handle  h,
     }
     else
         sd->sd_code = 404; /* catch all without body/media */
+    if (restconf_native_compress(h, sd) < 0)
+        goto done;
  fail:
+    if (!rc->rc_event_stream){
+        if (!keepalive){
+            rc->rc_exit = 1; /* Close after reply */
+            if (restconf_reply_header(sd, "Connection", "close") < 0)
+                goto done;
+        }
+        else if (rc->rc_proto_d2 == 0)
+            if (restconf_reply_header(sd, "Connection", "keep-alive") < 0)
+                goto done;
+    }
    if (restconf_param_del_all(h) < 0)
         goto done;
 #ifdef HAVE_LIBNGHTTP2
@@ -36,6 +36,36 @@
 #ifndef _RESTCONF_HTTP1_H_
 #define _RESTCONF_HTTP1_H_
 
+/*
+ * Types
+ */
+/* Slice of HTTP/1 input as offset and length, the input buffer may be reallocated
+ * while a request is read
+ */
+typedef struct {
+    size_t hl_off;
+    size_t hl_len;
+} http1_slice;
+
+/* Incremental HTTP/1 request header scanner state
+ * @see CLICON_RESTCONF_HTTP1_PARSER
+ */
+struct http1_scan {
+    size_t        hs_line;      /* Start of first line not scanned */
+    size_t        hs_searched;  /* Input searched for end of line */
+    size_t        hs_hlen;      /* Header length including empty line, 0 if incomplete */
+    unsigned long hs_clen;      /* Content-Length, 0 if none */
+    http1_slice   hs_method;    /* Request method, length 0 before request line */
+    http1_slice   hs_path;      /* Request target path, without trailing slash */
+    http1_slice   hs_query;     /* Query after ?, length 0 if none */
+    int           hs_d1;        /* HTTP version digit 1 */
+    int           hs_d2;        /* HTTP version digit 2 */
+    http1_slice  *hs_fields;    /* Header field names and values, in pairs */
+    int           hs_nfields;   /* Number of header fields */
+    int           hs_maxfields; /* Allocated number of header fields */
+};
+typedef struct http1_scan http1_scan;
+
 /*
  * Prototypes
  */
@@ -45,5 +75,9 @@ int clixon_http1_parse_buf(clixon_handle h, restconf_conn *rc, char *buf, size_t
 int restconf_http1_path_root(clixon_handle h, restconf_conn *rc);
 int http1_check_expect(clixon_handle h, restconf_conn *rc, restconf_stream_data *sd);
 int http1_check_content_length(clixon_handle h, restconf_stream_data *sd, int *status);
+int http1_scan_header(http1_scan *hs, const char *buf, size_t len);
+void http1_scan_reset(http1_scan *hs);
+void http1_scan_free(http1_scan *hs);
+int http1_scan_request(clixon_handle h, restconf_conn *rc, char *buf, size_t n);
 
 #endif  /* _RESTCONF_HTTP1_H_ */
@@ -0,0 +1,426 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Incremental HTTP/1.1 request header scanner according to RFC 7230
+ * An alternative to the flex/bison parser in clixon_http1_parse.[ly] selected by
+ * CLICON_RESTCONF_HTTP1_PARSER. Request and header lines are scanned when they are
+ * complete, and only once also when a header arrives in several reads. The request
+ * line and header fields are kept as slices of the connection input buffer until the
+ * request is processed.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <errno.h>
+#include <signal.h>
+#include <openssl/ssl.h>
+
+#ifdef HAVE_LIBNGHTTP2
+#include <nghttp2/nghttp2.h>
+#endif
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include <clixon/clixon.h>
+
+#include "restconf_lib.h"
+#include "restconf_handle.h"
+#include "restconf_native.h"
+#include "restconf_http1.h"
+
+/* Character classes of request line and header, see clixon_http1_parse.l */
+#define H1_TCHAR 0x01 /* Token char, eg of method and field name */
+#define H1_PCHAR 0x02 /* Path char, except % */
+#define H1_QCHAR 0x04 /* Query char, except % */
+
+/* Start number of header fields */
+#define H1_FIELDS_START 16
+
+static const uint8_t _h1_class[256] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 7, 0, 1, 7, 1, 7, 7, 6, 6, 7, 7, 6, 7, 7, 4,
+    7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 6, 6, 0, 6, 0, 4,
+    6, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+    7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 0, 0, 0, 1, 7,
+    1, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+    7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 0, 1, 0, 7, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+};
+
+/*! Scan a percent-encoded octet
+ *
+ * @param[in]  buf  Input
+ * @param[in]  i    Index of %
+ * @param[in]  end  End of line
+ * @retval     1    Valid %XX
+ * @retval     0    Invalid
+ */
+static int
+h1_pct(const char *buf,
+       size_t      i,
+       size_t      end)
+{
+    return i+2 < end && isxdigit(buf[i+1] & 0xff) && isxdigit(buf[i+2] & 0xff);
+}
+
+/*! Scan request line: method SP request-target SP HTTP-version
+ *
+ * @param[in]  hs   Scanner state
+ * @param[in]  buf  Input
+ * @param[in]  s    Start of line
+ * @param[in]  end  End of line, ie index of CR
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+http1_scan_reqline(http1_scan *hs,
+                   const char *buf,
+                   size_t      s,
+                   size_t      end)
+{
+    size_t i = s;
+    size_t j;
+
+    while (i < end && (_h1_class[buf[i] & 0xff] & H1_TCHAR))
+        i++;
+    if (i == s || i == end || buf[i] != ' '){
+        clixon_err(OE_RESTCONF, 0, "HTTP/1 request method");
+        return -1;
+    }
+    hs->hs_method.hl_off = s;
+    hs->hs_method.hl_len = i - s;
+    j = ++i;
+    if (i == end || buf[i] != '/'){
+        clixon_err(OE_RESTCONF, 0, "HTTP/1 request target is not an absolute path");
+        return -1;
+    }
+    while (i < end && buf[i] != ' ' && buf[i] != '?'){
+        if (buf[i] == '/' || (_h1_class[buf[i] & 0xff] & H1_PCHAR))
+            i++;
+        else if (buf[i] == '%' && h1_pct(buf, i, end))
+            i += 3;
+        else{
+            clixon_err(OE_RESTCONF, 0, "HTTP/1 request target");
+            return -1;
+        }
+    }
+    hs->hs_path.hl_off = j;
+    hs->hs_path.hl_len = i - j;
+    /* As the parser, remove trailing slash */
+    if (hs->hs_path.hl_len > 1 && buf[i-1] == '/')
+        hs->hs_path.hl_len--;
+    if (i < end && buf[i] == '?'){
+        j = ++i;
+        while (i < end && buf[i] != ' '){
+            if (_h1_class[buf[i] & 0xff] & H1_QCHAR)
+                i++;
+            else if (buf[i] == '%' && h1_pct(buf, i, end))
+                i += 3;
+            else{
+                clixon_err(OE_RESTCONF, 0, "HTTP/1 request query");
+                return -1;
+            }
+        }
+        hs->hs_query.hl_off = j;
+        hs->hs_query.hl_len = i - j;
+    }
+    if (end - i != 9 ||
+        strncmp(buf+i, " HTTP/", 6) != 0 ||
+        !isdigit(buf[i+6] & 0xff) ||
+        buf[i+7] != '.' ||
+        !isdigit(buf[i+8] & 0xff)){
+        clixon_err(OE_RESTCONF, 0, "HTTP/1 request version");
+        return -1;
+    }
+    hs->hs_d1 = buf[i+6] - '0';
+    hs->hs_d2 = buf[i+8] - '0';
+    return 0;
+}
+
+/*! Scan header field: field-name ":" OWS field-value OWS
+ *
+ * Fields with empty values are skipped, as by the parser
+ * @param[in]  hs   Scanner state
+ * @param[in]  buf  Input
+ * @param[in]  s    Start of line
+ * @param[in]  end  End of line, ie index of CR
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+http1_scan_field(http1_scan *hs,
+                 const char *buf,
+                 size_t      s,
+                 size_t      end)
+{
+    size_t       i = s;
+    size_t       v;
+    size_t       ve;
+    size_t       j;
+    http1_slice *hl;
+    int          max;
+
+    while (i < end && (_h1_class[buf[i] & 0xff] & H1_TCHAR))
+        i++;
+    if (i == s || i == end || buf[i] != ':'){
+        clixon_err(OE_RESTCONF, 0, "HTTP/1 header field name");
+        return -1;
+    }
+    v = i + 1;
+    while (v < end && (buf[v] == ' ' || buf[v] == '\t'))
+        v++;
+    ve = end;
+    while (ve > v && (buf[ve-1] == ' ' || buf[ve-1] == '\t'))
+        ve--;
+    for (j=v; j<ve; j++)
+        if (buf[j] == '\r' || buf[j] == '\0'){
+            clixon_err(OE_RESTCONF, 0, "HTTP/1 header field value");
+            return -1;
+        }
+    if (ve == v)
+        return 0;
+    if (hs->hs_nfields == hs->hs_maxfields){
+        max = hs->hs_maxfields ? 2*hs->hs_maxfields : H1_FIELDS_START;
+        if ((hl = realloc(hs->hs_fields, 2*max*sizeof(http1_slice))) == NULL){
+            clixon_err(OE_UNIX, errno, "realloc");
+            return -1;
+        }
+        hs->hs_fields = hl;
+        hs->hs_maxfields = max;
+    }
+    hl = &hs->hs_fields[2*hs->hs_nfields++];
+    hl[0].hl_off = s;
+    hl[0].hl_len = i - s;
+    hl[1].hl_off = v;
+    hl[1].hl_len = ve - v;
+    if (i - s == 14 && strncasecmp(buf+s, "Content-Length", 14) == 0)
+        hs->hs_clen = strtoul(buf+v, NULL, 10);
+    return 0;
+}
+
+/*! Scan HTTP/1 request header incrementally
+ *
+ * Call again with the same, longer, input when more is read: only lines not scanned
+ * before are scanned.
+ * @param[in]  hs   Scanner state
+ * @param[in]  buf  Input, starting with request line
+ * @param[in]  len  Length of input
+ * @retval     1    Header complete, see hs_hlen and hs_clen
+ * @retval     0    Header incomplete, read more
+ * @retval    -1    Error, malformed header
+ * @see http1_scan_reset  Reset state after a request is processed
+ */
+int
+http1_scan_header(http1_scan *hs,
+                  const char *buf,
+                  size_t      len)
+{
+    size_t start;
+    char  *p;
+    size_t e;
+    size_t end;
+
+    if (hs->hs_hlen)
+        return 1;
+    while (1){
+        start = hs->hs_searched > hs->hs_line ? hs->hs_searched : hs->hs_line;
+        if (start >= len ||
+            (p = memchr(buf+start, '\n', len-start)) == NULL){
+            hs->hs_searched = len;
+            return 0;
+        }
+        e = p - buf;
+        hs->hs_searched = e;
+        if (e == hs->hs_line || buf[e-1] != '\r'){
+            clixon_err(OE_RESTCONF, 0, "HTTP/1 line not terminated by CRLF");
+            return -1;
+        }
+        end = e - 1;
+        if (hs->hs_method.hl_len == 0){
+            if (http1_scan_reqline(hs, buf, hs->hs_line, end) < 0)
+                return -1;
+        }
+        else if (end == hs->hs_line){
+            hs->hs_hlen = e + 1;
+            return 1;
+        }
+        else if (http1_scan_field(hs, buf, hs->hs_line, end) < 0)
+            return -1;
+        hs->hs_line = e + 1;
+    }
+}
+
+/*! Reset scanner state before next request
+ *
+ * @param[in]  hs   Scanner state
+ */
+void
+http1_scan_reset(http1_scan *hs)
+{
+    http1_slice *fields = hs->hs_fields;
+    int          max = hs->hs_maxfields;
+
+    memset(hs, 0, sizeof(*hs));
+    hs->hs_fields = fields;
+    hs->hs_maxfields = max;
+}
+
+/*! Free scanner state
+ *
+ * @param[in]  hs   Scanner state
+ */
+void
+http1_scan_free(http1_scan *hs)
+{
+    if (hs->hs_fields)
+        free(hs->hs_fields);
+    free(hs);
+}
+
+/*! Null-terminate a slice in place
+ *
+ * @param[in]  buf  Input
+ * @param[in]  hl   Slice, followed by at least one char in buf
+ * @param[out] c    Char replaced by the terminator, restore with h1_slice_restore
+ * @retval     str  Slice as string
+ */
+static char *
+h1_slice_term(char        *buf,
+              http1_slice *hl,
+              char        *c)
+{
+    *c = buf[hl->hl_off + hl->hl_len];
+    buf[hl->hl_off + hl->hl_len] = '\0';
+    return buf + hl->hl_off;
+}
+
+#define h1_slice_restore(buf, hl, c) ((buf)[(hl)->hl_off + (hl)->hl_len] = (c))
+
+/*! Set request parameters, query and body of a scanned HTTP/1 request
+ *
+ * Side-effects as by clixon_http1_parse_string. Slices are terminated in place while
+ * they are copied, the input is unchanged on return. The scanner state is reset.
+ * @param[in]  h    Clixon handle
+ * @param[in]  rc   Restconf connection, with scanner state
+ * @param[in]  buf  Input of one request, starting with request line
+ * @param[in]  n    Length of request including body
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+http1_scan_request(clixon_handle  h,
+                   restconf_conn *rc,
+                   char          *buf,
+                   size_t         n)
+{
+    int                   retval = -1;
+    http1_scan           *hs = rc->rc_h1scan;
+    restconf_stream_data *sd;
+    http1_slice          *hl;
+    char                 *name;
+    char                 *val;
+    char                  c1;
+    char                  c2;
+    int                   ret;
+    int                   i;
+
+    if (hs->hs_hlen == 0){
+        if ((ret = http1_scan_header(hs, buf, n)) < 0)
+            goto done;
+        if (ret == 0){
+            clixon_err(OE_RESTCONF, 0, "HTTP/1 header incomplete or too long");
+            goto done;
+        }
+    }
+    if ((sd = restconf_stream_find(rc, 0)) == NULL){
+        clixon_err(OE_RESTCONF, 0, "stream 0 not found");
+        goto done;
+    }
+    rc->rc_proto_d1 = hs->hs_d1;
+    rc->rc_proto_d2 = hs->hs_d2;
+    clixon_debug(CLIXON_DBG_RESTCONF, "http/%d.%d", hs->hs_d1, hs->hs_d2);
+    val = h1_slice_term(buf, &hs->hs_method, &c1);
+    ret = restconf_param_set(h, "REQUEST_METHOD", val);
+    h1_slice_restore(buf, &hs->hs_method, c1);
+    if (ret < 0)
+        goto done;
+    val = h1_slice_term(buf, &hs->hs_path, &c1);
+    ret = restconf_param_set(h, "REQUEST_URI", val);
+    h1_slice_restore(buf, &hs->hs_path, c1);
+    if (ret < 0)
+        goto done;
+    if (hs->hs_query.hl_len){
+        val = h1_slice_term(buf, &hs->hs_query, &c1);
+        ret = uri_str2cvec(val, '&', '=', 1, &sd->sd_qvec);
+        h1_slice_restore(buf, &hs->hs_query, c1);
+        if (ret < 0)
+            goto done;
+    }
+    for (i=0; i<hs->hs_nfields; i++){
+        hl = &hs->hs_fields[2*i];
+        name = h1_slice_term(buf, &hl[0], &c1);
+        val = h1_slice_term(buf, &hl[1], &c2);
+        ret = restconf_convert_hdr(h, name, val);
+        h1_slice_restore(buf, &hl[1], c2);
+        h1_slice_restore(buf, &hl[0], c1);
+        if (ret < 0)
+            goto done;
+    }
+    if (n > hs->hs_hlen &&
+        cbuf_append_buf(sd->sd_indata, buf + hs->hs_hlen, n - hs->hs_hlen) < 0){
+        clixon_err(OE_RESTCONF, errno, "cbuf_append_buf");
+        goto done;
+    }
+    retval = 0;
+ done:
+    http1_scan_reset(hs);
+    return retval;
+}
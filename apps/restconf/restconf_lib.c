@@ -308,6 +308,50 @@ restconf_media_in_list(char *media,
     return retval;
 }
 
+/*! Check if a content-coding is accepted in an Accept-Encoding header
+ *
+ * Example: coding="gzip";
+ *          list="deflate, gzip;q=0.8, br;q=0"
+ * Returns: 1
+ * @param[in]  coding  Content-coding, eg "gzip"
+ * @param[in]  list    Accept-Encoding header value
+ * @retval     1       Accepted, explicitly or by "*", with q > 0
+ * @retval     0       Not accepted
+ * @see RFC 7231 Sec 5.3.4
+ */
+int
+restconf_coding_in_list(const char *coding,
+                        const char *list)
+{
+    const char *p = list;
+    const char *name;
+    size_t      len;
+    double      q;
+    int         star = 0;
+
+    while (p && *p != '\0'){
+        while (*p == ' ' || *p == '\t' || *p == ',')
+            p++;
+        name = p;
+        while (*p != '\0' && *p != ',' && *p != ';' && *p != ' ' && *p != '\t')
+            p++;
+        len = p - name;
+        q = 1.0;
+        while (*p != '\0' && *p != ','){
+            if (*p == 'q' && *(p+1) == '=')
+                q = strtod(p+2, NULL);
+            p++;
+        }
+        if (len == 0)
+            continue;
+        if (len == strlen(coding) && strncasecmp(name, coding, len) == 0)
+            return q > 0.0;
+        if (len == 1 && *name == '*')
+            star = q > 0.0;
+    }
+    return star;
+}
+
 const char *
 restconf_media_int2str(restconf_media media)
 {
@@ -435,6 +479,7 @@ restconf_terminate(clixon_handle h)
         close(fs);
     /* Delete all plugins, and RPC callbacks */
     clixon_plugin_module_exit(h);
+    clicon_rpc_session_pool_close(h);
     clicon_rpc_close_session(h);
     yang_exit(h);
     if ((nsctx = clicon_nsctx_global_get(h)) != NULL)
@@ -442,6 +487,8 @@ restconf_terminate(clixon_handle h)
     if ((x = clicon_conf_xml(h)) != NULL)
         xml_free(x);
     xpath_optimize_exit();
+    clixon_profile_exit();
+    clixon_trace_exit();
     clixon_err_exit();
     clixon_debug(CLIXON_DBG_RESTCONF, "pid:%u done", getpid());
     restconf_handle_exit(h);
@@ -606,6 +653,61 @@ restconf_main_extension_cb(clixon_handle h,
     return retval;
 }
 
+/*! Send edit-config with a bound config tree to backend
+ *
+ * The rpc envelope is given as text. If CLICON_SOCK_BINARY is set, the config tree is
+ * sent in binary format with its yang binding, so that the payload is not serialized
+ * and parsed again. Otherwise as XML text.
+ * @param[in]  h        Clixon handle
+ * @param[in]  cbx      Start of rpc: <rpc ...><edit-config ...>..., without config or end tags
+ * @param[in]  xconfig  Config tree, top-level without parent
+ * @param[out] xret     Reply from backend
+ * @retval     0        OK
+ * @retval    -1        Error
+ * @see clicon_rpc_netconf_bound
+ */
+int
+restconf_edit_config(clixon_handle h,
+                     cbuf         *cbx,
+                     cxobj        *xconfig,
+                     cxobj       **xret)
+{
+    int    retval = -1;
+    cxobj *xt = NULL;
+    cxobj *xrpc;
+    cxobj *xedit;
+
+    if (!clicon_option_bool(h, "CLICON_SOCK_BINARY")){
+        if (clixon_xml2cbuf(cbx, xconfig, 0, 0, NULL, -1, 0) < 0)
+            goto done;
+        cprintf(cbx, "</edit-config></rpc>");
+        if (clicon_rpc_netconf(h, cbuf_get(cbx), xret, NULL) < 0)
+            goto done;
+        goto ok;
+    }
+    cprintf(cbx, "</edit-config></rpc>");
+    if (clixon_xml_parse_string(cbuf_get(cbx), YB_NONE, NULL, &xt, NULL) < 0)
+        goto done;
+    if ((xrpc = xml_find_type(xt, NULL, "rpc", CX_ELMNT)) == NULL ||
+        (xedit = xml_find_type(xrpc, NULL, "edit-config", CX_ELMNT)) == NULL){
+        clixon_err(OE_XML, EINVAL, "Malformed edit-config envelope");
+        goto done;
+    }
+    if (xml_addsub(xedit, xconfig) < 0)
+        goto done;
+    /* rpc/edit-config/config is envelope */
+    retval = clicon_rpc_netconf_bound(h, xrpc, 3, xret);
+    xml_rm(xconfig);
+    if (retval < 0)
+        goto done;
+ ok:
+    retval = 0;
+ done:
+    if (xt)
+        xml_free(xt);
+    return retval;
+}
+
 /*! Extract uri-encoded uri-path without arguments
  *
  * Use REQUEST_URI parameter and strip ?args
@@ -788,6 +890,9 @@ restconf_authentication_cb(clixon_handle  h,
         retval = 0;
         goto notauth;
     }
+    /* Use backend session of pool bound to user, see CLICON_SOCK_SESSIONS */
+    if (clicon_rpc_session_select(h, clicon_username_get(h)) < 0)
+        goto done;
     /* If set but no user, set a dummy user */
     retval = 1;
  done:
@@ -931,3 +1036,57 @@ restconf_socket_init(const char   *netns0,
     return retval;
 }
 
+
+/*! Profile RPC in restconf: profile the restconf daemon locally or forward to backend
+ *
+ * @param[in]  h       Clixon handle
+ * @param[in]  xe      Request: <rpc><xn></rpc>
+ * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error..
+ * @param[in]  arg     Domain specific arg, ie request
+ * @param[in]  regarg  User argument given at rpc_callback_register()
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @see clixon_profile_rpc
+ */
+static int
+restconf_profile_rpc(clixon_handle h,
+                     cxobj        *xe,
+                     cbuf         *cbret,
+                     void         *arg,
+                     void         *regarg)
+{
+    int    retval = -1;
+    char  *daemon;
+    cxobj *xret = NULL;
+    cxobj *xreply;
+
+    if ((daemon = xml_find_body(xe, "daemon")) != NULL &&
+        strcmp(daemon, "restconf") == 0)
+        return clixon_profile_rpc(h, xe, cbret, arg, "restconf");
+    if (clicon_rpc_netconf_xml(h, xml_parent(xe), &xret, NULL) < 0)
+        goto done;
+    if ((xreply = xpath_first(xret, NULL, "rpc-reply")) == NULL){
+        clixon_err(OE_XML, EINVAL, "No rpc-reply from backend");
+        goto done;
+    }
+    if (clixon_xml2cbuf(cbret, xreply, 0, 0, NULL, -1, 0) < 0)
+        goto done;
+    retval = 0;
+ done:
+    if (xret)
+        xml_free(xret);
+    return retval;
+}
+
+/*! Register local RPC callbacks of the restconf daemon
+ *
+ * @param[in]  h  Clixon handle
+ * @retval     0  OK
+ * @retval    -1  Error
+ */
+int
+restconf_rpc_init(clixon_handle h)
+{
+    return rpc_callback_register(h, restconf_profile_rpc, NULL,
+                                 CLIXON_LIB_NS, "profile");
+}
@@ -86,6 +86,7 @@ int restconf_err2code(char *tag);
 const char *restconf_code2reason(int code);
 const restconf_media restconf_media_str2int(char *media);
 int   restconf_media_in_list(char *media, char *list);
+int   restconf_coding_in_list(const char *coding, const char *list);
 const restconf_media restconf_media_list_str2int(char *list);
 const char *restconf_media_int2str(restconf_media media);
 int   restconf_str2proto(char *str);
@@ -96,11 +97,13 @@ int   get_user_cookie(char *cookiestr, char  *attribute, char **val);
 int   restconf_terminate(clixon_handle h);
 int   restconf_insert_attributes(cxobj *xdata, cvec *qvec);
 int   restconf_main_extension_cb(clixon_handle h, yang_stmt *yext, yang_stmt *ys);
+int   restconf_edit_config(clixon_handle h, cbuf *cbx, cxobj *xconfig, cxobj **xret);
 char *restconf_uripath(clixon_handle h);
 int   restconf_drop_privileges(clixon_handle h);
 int   restconf_authentication_cb(clixon_handle h, void *req, int pretty, restconf_media media_out);
 int   restconf_config_init(clixon_handle h, cxobj *xrestconf);
 int   restconf_socket_init(const char *netns0, const char *addrstr, const char *addrtype, uint16_t port, int backlog, int flags, int *ss);
+int   restconf_rpc_init(clixon_handle h);
 
 #endif /* _RESTCONF_LIB_H_ */
 
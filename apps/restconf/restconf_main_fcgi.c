@@ -86,6 +86,7 @@
 #include "restconf_methods_get.h"
 #include "restconf_methods_post.h"
 #include "restconf_stream.h"
+#include "restconf_cache.h"
 
 /* Command line options to be passed to getopt(3) */
 #define RESTCONF_OPTS "hVD:f:E:l:C:p:d:y:a:u:rW:R:t:o:"
@@ -245,7 +246,7 @@ restconf_sig_term(int arg)
     close(_MYSOCK);
 }
 
-/*! Reap stream child
+/*! Reap child
  *
  * XXX The -1 should be changed to proper pid, see eg clixon_process_waitpid
  */
@@ -253,10 +254,8 @@ static void
 restconf_sig_child(int arg)
 {
     int status;
-    int pid;
 
-    if ((pid = waitpid(-1, &status, 0)) != -1 && WIFEXITED(status))
-        stream_child_free(_CLIXON_HANDLE, pid);
+    (void)waitpid(-1, &status, 0);
 }
 
 /*! Usage help routine
@@ -474,6 +473,8 @@ main(int    argc,
     /* Read debug and log options from config file if not given by command-line */
     if (clixon_options_main_helper(h, dbg, logdst, __PROGRAM__) < 0)
         goto done;
+    if (clixon_trace_init(h, __PROGRAM__) < 0)
+        goto done;
     /* Access the remaining argv/argc options (after --) w clicon-argv_get() */
     clicon_argv_set(h, argv0, argc, argv);
 
@@ -504,6 +505,9 @@ main(int    argc,
     /* Initialize plugin module by creating a handle holding plugin and callback lists */
     if (clixon_plugin_module_init(h) < 0)
         goto done;
+    /* Local clixon-lib RPCs, eg profile */
+    if (restconf_rpc_init(h) < 0)
+        goto done;
     /* In case ietf-yang-metadata is loaded by application, handle annotation extension */
     if (yang_metadata_init(h) < 0)
         goto done;
@@ -707,6 +711,9 @@ main(int    argc,
         }
         if (restconf_param_del_all(h) < 0)
             goto done;
+        /* No event loop: stop profiling here if its duration has passed */
+        if (clixon_profile_poll() < 0)
+            goto done;
         if (finish)
             FCGX_Finish_r(req);
         else if (clixon_exit_get()){
@@ -724,7 +731,7 @@ main(int    argc,
  ok:
     retval = 0;
  done:
-    stream_child_freeall(h);
+    restconf_cache_free();
     restconf_terminate(h);
     return retval;
 }
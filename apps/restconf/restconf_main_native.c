@@ -120,6 +120,7 @@
 #include <stdio.h>
 #include <unistd.h>
 #include <string.h>
+#include <inttypes.h>
 #include <syslog.h>
 #include <pwd.h>
 #include <ctype.h>
@@ -128,6 +129,7 @@
 #include <sys/socket.h>
 #include <arpa/inet.h>
 #include <sys/resource.h>
+#include <sys/wait.h>
 
 #include <openssl/ssl.h>
 #include <openssl/rand.h>
@@ -150,6 +152,7 @@
 #include "restconf_api.h"       /* generic not shared with plugins */
 #include "restconf_err.h"
 #include "restconf_root.h"
+#include "restconf_cache.h"
 #include "restconf_native.h"   /* Restconf-openssl mode specific headers*/
 #ifdef HAVE_LIBNGHTTP2
 #include "restconf_nghttp2.h"  /* http/2 */
@@ -331,8 +334,30 @@ alpn_select_proto_cb(SSL                  *ssl,
     unsigned char *inp;
     unsigned char len;
     int           pref = 0;
+#if OPENSSL_VERSION_NUMBER >= 0x10101000L
+    SSL_SESSION         *sess;
+    const unsigned char *prev = NULL;
+    size_t               prevlen = 0;
+#endif
 
     clixon_debug(CLIXON_DBG_RESTCONF, "");
+#if OPENSSL_VERSION_NUMBER >= 0x10101000L
+    /* Resumed session: reuse the protocol selected in the original handshake if offered */
+    if ((sess = SSL_get_session(ssl)) != NULL)
+        SSL_SESSION_get0_alpn_selected(sess, &prev, &prevlen);
+    if (prev != NULL && prevlen > 0){
+        inp = (unsigned char*)in;
+        while ((inp-in) < inlen) {
+            len = *inp++;
+            if (len == prevlen && memcmp(inp, prev, len) == 0){
+                *outlen = len;
+                *out = inp;
+                return SSL_TLSEXT_ERR_OK;
+            }
+            inp += len;
+        }
+    }
+#endif
     /* select http/1.1 */
     inp = (unsigned char*)in;
     while ((inp-in) < inlen) {
@@ -386,13 +411,60 @@ restconf_ssl_context_create(clixon_handle h)
     SSL_CTX_set_options(ctx, SSL_OP_NO_SSLv3 | SSL_OP_NO_TLSv1 | SSL_OP_NO_TLSv1_1);
 
     SSL_CTX_set_options(ctx, SSL_MODE_RELEASE_BUFFERS | SSL_OP_NO_COMPRESSION);
-    //    SSL_CTX_set_timeout(ctx, cfg->ssl_ctx_timeout); /* default 300s */
     /* Application Layer Protocol Negotiation (alpn) callback */
     SSL_CTX_set_alpn_select_cb(ctx, alpn_select_proto_cb, h);
  done:
     return ctx;
 }
 
+/*! Configure TLS session resumption
+ *
+ * Session cache is internal to each process, ie not shared between restconf workers.
+ * Session ticket keys are generated here, before workers are forked, so that a ticket
+ * issued by one worker can be resumed by any other.
+ * A resumed session keeps the peer certificate and verify result of the full handshake.
+ * @param[in]  h    Clixon handle
+ * @param[in]  ctx  SSL context
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see restconf_workers
+ */
+static int
+restconf_ssl_session_configure(clixon_handle h,
+                               SSL_CTX      *ctx)
+{
+    int           retval = -1;
+    uint32_t      cachesize;
+    unsigned char keys[48]; /* name, hmac and aes keys */
+
+    cachesize = clicon_option_int(h, "CLICON_RESTCONF_TLS_SESSION_CACHE");
+    if (cachesize){
+        SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_SERVER);
+        SSL_CTX_sess_set_cache_size(ctx, cachesize);
+    }
+    else
+        SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_OFF);
+    SSL_CTX_set_timeout(ctx, clicon_option_int(h, "CLICON_RESTCONF_TLS_SESSION_TIMEOUT"));
+    if (clicon_option_bool(h, "CLICON_RESTCONF_TLS_TICKETS")){
+        if (RAND_bytes(keys, sizeof(keys)) != 1){
+            clixon_err(OE_SSL, 0, "RAND_bytes");
+            goto done;
+        }
+        if (SSL_CTX_set_tlsext_ticket_keys(ctx, keys, sizeof(keys)) != 1){
+            clixon_err(OE_SSL, 0, "SSL_CTX_set_tlsext_ticket_keys");
+            goto done;
+        }
+        OPENSSL_cleanse(keys, sizeof(keys));
+    }
+    else
+        SSL_CTX_set_options(ctx, SSL_OP_NO_TICKET);
+    clixon_debug(CLIXON_DBG_RESTCONF, "session cache:%u tickets:%d", cachesize,
+                 clicon_option_bool(h, "CLICON_RESTCONF_TLS_TICKETS"));
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*
  * @param[in]  ctx                 SSL context
  * @param[in]  server_cert_path    Server cert
@@ -432,7 +504,8 @@ restconf_ssl_context_configure(clixon_handle h,
 
     SSL_CTX_set_session_id_context(ctx, (void *)&session_id_context, sizeof(session_id_context));
     SSL_CTX_set_app_data(ctx, h);
-    SSL_CTX_set_session_cache_mode(ctx, 0);
+    if (restconf_ssl_session_configure(h, ctx) < 0)
+        goto done;
 
     /* Set the key and cert */
     if (SSL_CTX_use_certificate_chain_file(ctx, server_cert_path) != 1) {
@@ -547,6 +620,11 @@ restconf_accept_client(int   fd,
     h = rsock->rs_h;
     len = sizeof(from);
     if ((s = accept(rsock->rs_ss, &from, &len)) < 0){
+        /* Listen socket shared by workers, another worker accepted it */
+        if (errno == EAGAIN || errno == EWOULDBLOCK){
+            retval = 0;
+            goto done;
+        }
         clixon_err(OE_UNIX, errno, "accept");
         goto done;
     }
@@ -631,8 +709,14 @@ restconf_native_terminate(clixon_handle h)
                 free(rsock->rs_addrtype);
             if (rsock->rs_from_addr)
                 free(rsock->rs_from_addr);
+            if (rsock->rs_dests)
+                free(rsock->rs_dests);
             free(rsock);
         }
+        restconf_bucket_free_all(rn);
+        if (rn->rn_handshakes)
+            clixon_log(h, LOG_INFO, "TLS handshakes: %" PRIu64 " resumed: %" PRIu64 " avg: %" PRIu64 "us",
+                       rn->rn_handshakes, rn->rn_resumed, rn->rn_handshake_us/rn->rn_handshakes);
         if (rn->rn_ctx)
             SSL_CTX_free(rn->rn_ctx);
         free(rn);
@@ -805,8 +889,11 @@ openssl_init_socket(clixon_handle h,
     }
     retval = 0;
  done:
-    if (rsock)
+    if (rsock){
+        if (rsock->rs_dests)
+            free(rsock->rs_dests);
         free(rsock);
+    }
     return retval;
 }
 
@@ -893,6 +980,40 @@ restconf_openssl_init(clixon_handle h,
     }
     rn = restconf_native_handle_get(h);
     rn->rn_ctx = ctx;
+    /* Rate limiting of read requests per client */
+    if ((x = xpath_first(xrestconf, nsc, "rate-limit/rate")) != NULL &&
+        (bstr = xml_body(x)) != NULL)
+        rn->rn_rate = strtoul(bstr, NULL, 10);
+    rn->rn_burst = 10;
+    if ((x = xpath_first(xrestconf, nsc, "rate-limit/burst")) != NULL &&
+        (bstr = xml_body(x)) != NULL &&
+        strtoul(bstr, NULL, 10) > 0)
+        rn->rn_burst = strtoul(bstr, NULL, 10);
+    if ((x = xpath_first(xrestconf, nsc, "rate-limit/pipeline-depth")) != NULL &&
+        (bstr = xml_body(x)) != NULL)
+        rn->rn_pipeline_depth = strtoul(bstr, NULL, 10);
+    /* HTTP/2 settings, defaults as in clixon-restconf.yang */
+    rn->rn_h2_max_streams = 100;
+    rn->rn_h2_window = 65535;
+    rn->rn_h2_conn_window = 65535;
+    rn->rn_h2_max_frame = 16384;
+    rn->rn_h2_coalesce = 16384;
+    if ((x = xpath_first(xrestconf, nsc, "http2/max-concurrent-streams")) != NULL &&
+        (bstr = xml_body(x)) != NULL)
+        rn->rn_h2_max_streams = strtoul(bstr, NULL, 10);
+    if ((x = xpath_first(xrestconf, nsc, "http2/initial-window-size")) != NULL &&
+        (bstr = xml_body(x)) != NULL)
+        rn->rn_h2_window = strtoul(bstr, NULL, 10);
+    if ((x = xpath_first(xrestconf, nsc, "http2/connection-window-size")) != NULL &&
+        (bstr = xml_body(x)) != NULL)
+        rn->rn_h2_conn_window = strtoul(bstr, NULL, 10);
+    if ((x = xpath_first(xrestconf, nsc, "http2/max-frame-size")) != NULL &&
+        (bstr = xml_body(x)) != NULL)
+        rn->rn_h2_max_frame = strtoul(bstr, NULL, 10);
+    if ((x = xpath_first(xrestconf, nsc, "http2/write-coalesce")) != NULL &&
+        (bstr = xml_body(x)) != NULL)
+        rn->rn_h2_coalesce = strtoul(bstr, NULL, 10);
+    rn->rn_http1_parser = clicon_restconf_http1_parser(h);
     /* get the list of socket config-data */
     if (xpath_vec(xrestconf, nsc, "socket", &vec, &veclen) < 0)
         goto done;
@@ -1116,6 +1237,129 @@ restconf_sig_term(int arg)
     clixon_exit_set(1);
 }
 
+/*! Start a restconf worker process after fork
+ *
+ * The worker inherits the listen sockets and the SSL context of the master.
+ * @param[in]  h    Clixon handle
+ * @param[in]  nr   Worker number, callhome is only made by worker 0
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+restconf_worker_init(clixon_handle h,
+                     int           nr)
+{
+    restconf_native_handle *rn;
+    restconf_socket        *rsock;
+    int                     s;
+
+    /* Backend session of master is not shared, make own hello */
+    clicon_rpc_session_pool_close(h);
+    if ((s = clicon_client_socket_get(h)) != -1){
+        close(s);
+        clicon_client_socket_set(h, -1);
+    }
+    clicon_session_id_del(h);
+    if (nr != 0 &&
+        (rn = restconf_native_handle_get(h)) != NULL &&
+        (rsock = rn->rn_sockets) != NULL){
+        do {
+            if (rsock->rs_callhome && restconf_callhome_timer_unreg(rsock) < 0)
+                return -1;
+            rsock = NEXTQ(restconf_socket *, rsock);
+        } while (rsock && rsock != rn->rn_sockets);
+    }
+    return 0;
+}
+
+/*! Fork restconf worker processes sharing the listen sockets and supervise them
+ *
+ * The master does not accept connections. It re-forks workers that exit, and on
+ * SIGTERM/SIGINT terminates the workers and returns.
+ * @param[in]  h        Clixon handle
+ * @param[in]  workers  Number of worker processes
+ * @retval     1        In worker: continue with event loop
+ * @retval     0        In master: workers terminated
+ * @retval    -1        Error
+ * @see CLICON_RESTCONF_WORKERS
+ */
+static int
+restconf_workers(clixon_handle h,
+                 int           workers)
+{
+    int     retval = -1;
+    pid_t  *pids = NULL;
+    time_t *started = NULL;
+    pid_t   pid;
+    int     status;
+    int     i;
+
+    if ((pids = calloc(workers, sizeof(*pids))) == NULL ||
+        (started = calloc(workers, sizeof(*started))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    /* Interrupt waitpid on termination */
+    if (set_signal_flags(SIGTERM, 0, restconf_sig_term, NULL) < 0 ||
+        set_signal_flags(SIGINT, 0, restconf_sig_term, NULL) < 0){
+        clixon_err(OE_UNIX, errno, "Setting signal");
+        goto done;
+    }
+    while (!clixon_exit_get()){
+        for (i=0; i<workers; i++){
+            if (pids[i] != 0)
+                continue;
+            /* Avoid busy re-fork of a worker failing at start */
+            if (started[i] != 0 && time(NULL) - started[i] < 1)
+                sleep(1);
+            if ((pid = fork()) < 0){
+                clixon_err(OE_UNIX, errno, "fork");
+                goto done;
+            }
+            if (pid == 0){ /* worker */
+                if (set_signal(SIGTERM, restconf_sig_term, NULL) < 0 ||
+                    set_signal(SIGINT, restconf_sig_term, NULL) < 0){
+                    clixon_err(OE_UNIX, errno, "Setting signal");
+                    goto done;
+                }
+                if (restconf_worker_init(h, i) < 0)
+                    goto done;
+                retval = 1;
+                goto done;
+            }
+            clixon_debug(CLIXON_DBG_RESTCONF, "worker %d pid %d", i, pid);
+            pids[i] = pid;
+            started[i] = time(NULL);
+        }
+        if ((pid = waitpid(-1, &status, 0)) < 0){
+            if (errno == EINTR)
+                continue;
+            clixon_err(OE_UNIX, errno, "waitpid");
+            goto done;
+        }
+        for (i=0; i<workers; i++)
+            if (pids[i] == pid){
+                if (!clixon_exit_get())
+                    clixon_log(h, LOG_WARNING, "%s: worker %d pid %d exited with status %#x, restarting",
+                               __PROGRAM__, i, pid, status);
+                pids[i] = 0;
+            }
+    }
+    for (i=0; i<workers; i++)
+        if (pids[i] != 0)
+            kill(pids[i], SIGTERM);
+    for (i=0; i<workers; i++)
+        if (pids[i] != 0)
+            waitpid(pids[i], &status, 0);
+    retval = 0;
+ done:
+    if (pids)
+        free(pids);
+    if (started)
+        free(started);
+    return retval;
+}
+
 /*! Usage help routine
  *
  * @param[in]  argv0  command line
@@ -1172,6 +1416,7 @@ main(int    argc,
     enum format_enum        config_dump_format = FORMAT_XML;
     int                     print_version = 0;
     int                     stream_timeout = 0;
+    int                     workers;
     int32_t                 d;
 
     /* Create handle */
@@ -1334,6 +1579,8 @@ main(int    argc,
     /* Read debug and log options from config file if not given by command-line */
     if (clixon_options_main_helper(h, dbg, logdst, __PROGRAM__) < 0)
         goto done;
+    if (clixon_trace_init(h, __PROGRAM__) < 0)
+        goto done;
 
     /* Access the remaining argv/argc options (after --) w clicon-argv_get() */
     clicon_argv_set(h, argv0, argc, argv);
@@ -1353,6 +1600,9 @@ main(int    argc,
     /* Initialize plugin module by creating a handle holding plugin and callback lists */
     if (clixon_plugin_module_init(h) < 0)
         goto done;
+    /* Local clixon-lib RPCs, eg profile */
+    if (restconf_rpc_init(h) < 0)
+        goto done;
     yang_start(h);
     /* Call start function in all plugins before we go interactive */
     if (clixon_plugin_start_all(h) < 0)
@@ -1388,6 +1638,13 @@ main(int    argc,
      */
     clicon_data_set(h, "session-transport", "cl:restconf");
 
+    /* Fork workers sharing the listen sockets, master supervises them */
+    if ((workers = clicon_option_int(h, "CLICON_RESTCONF_WORKERS")) > 1){
+        if ((ret = restconf_workers(h, workers)) < 0)
+            goto done;
+        if (ret == 0)
+            goto ok;
+    }
     /* Main event loop */
     if (clixon_event_loop(h) < 0)
         goto done;
@@ -1398,6 +1655,7 @@ main(int    argc,
     if (xrestconf)
         xml_free(xrestconf);
     restconf_native_terminate(h);
+    restconf_cache_free();
     restconf_terminate(h);
     return retval;
 }
@@ -38,6 +38,7 @@
 #ifdef HAVE_CONFIG_H
 #include "clixon_config.h" /* generated by config & autoconf */
 #endif
+#define _GNU_SOURCE /* for strptime and timegm */
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
@@ -62,10 +63,146 @@
 #include "restconf_api.h"
 #include "restconf_err.h"
 #include "restconf_methods_get.h"
+#include "restconf_cache.h"
 
 /* Forward */
 static int api_data_pagination(clixon_handle h, void *req, char *api_path, int pi, cvec *qvec, int pretty, restconf_media media_out);
 
+/*! Check conditional GET request headers against entity tag and last modified time
+ *
+ * @param[in]  h        Clixon handle
+ * @param[in]  etag     Current entity tag (without quotes)
+ * @param[in]  lastmod  Last modified time
+ * @retval     1        Not modified, reply with 304
+ * @retval     0        Modified or no conditional headers
+ * @see RFC 7232 Sec 3.2, 3.3, 6
+ */
+static int
+api_data_not_modified(clixon_handle   h,
+                      const char     *etag,
+                      struct timeval *lastmod)
+{
+    char     *str;
+    char     *p;
+    char     *tag;
+    size_t    len;
+    struct tm tm = {0,};
+    time_t    t;
+
+    /* If-None-Match, takes precedence over If-Modified-Since */
+    if ((str = restconf_param_get(h, "HTTP_IF_NONE_MATCH")) != NULL){
+        len = strlen(etag);
+        p = str;
+        while (*p != '\0'){
+            while (*p == ' ' || *p == ',')
+                p++;
+            if (*p == '*')
+                return 1;
+            if (strncmp(p, "W/", 2) == 0) /* weak comparison */
+                p += 2;
+            tag = p;
+            while (*p != '\0' && *p != ',')
+                p++;
+            if (p - tag >= len + 2 && tag[0] == '"' &&
+                strncmp(tag+1, etag, len) == 0 && tag[len+1] == '"')
+                return 1;
+        }
+        return 0;
+    }
+    if ((str = restconf_param_get(h, "HTTP_IF_MODIFIED_SINCE")) != NULL){
+        if (strptime(str, "%a, %d %b %Y %H:%M:%S GMT", &tm) == NULL)
+            return 0;
+        t = timegm(&tm);
+        if (lastmod->tv_sec <= t)
+            return 1;
+    }
+    return 0;
+}
+
+/*! Add ETag and Last-Modified reply headers
+ *
+ * @param[in]  req      Generic Www handle
+ * @param[in]  etag     Entity tag (without quotes)
+ * @param[in]  lastmod  Last modified time
+ * @retval     0        OK
+ * @retval    -1        Error
+ */
+static int
+api_data_etag_headers(void           *req,
+                      const char     *etag,
+                      struct timeval *lastmod)
+{
+    char      timestr[32];
+    struct tm tm;
+
+    if (restconf_reply_header(req, "ETag", "\"%s\"", etag) < 0)
+        return -1;
+    if (gmtime_r(&lastmod->tv_sec, &tm) != NULL &&
+        strftime(timestr, sizeof(timestr), "%a, %d %b %Y %H:%M:%S GMT", &tm) > 0)
+        if (restconf_reply_header(req, "Last-Modified", "%s", timestr) < 0)
+            return -1;
+    return 0;
+}
+
+/*! Reply body of a streamed GET
+ *
+ * @see api_data_get_body
+ */
+struct get_body {
+    cxobj         *gb_xret;   /* Data root reply, or NULL */
+    cxobj        **gb_xvec;   /* Reply nodes if not data root */
+    size_t         gb_xlen;   /* Length of gb_xvec */
+    int            gb_pretty; /* Pretty-print */
+    restconf_media gb_media;  /* Output media */
+};
+
+/*! Serialize GET reply body while it is sent
+ *
+ * Same output as the non-streamed case in api_data_get2. With size SIZE_MAX flush is
+ * never called and the whole body is serialized in cb.
+ * @see restconf_body_fn
+ */
+static int
+api_data_get_body(void                *arg,
+                  cbuf                *cb,
+                  size_t               size,
+                  clixon_xml_flush_cb *flush,
+                  void                *flusharg)
+{
+    int              retval = -1;
+    struct get_body *gb = (struct get_body *)arg;
+    size_t           i;
+
+    switch (gb->gb_media){
+    case YANG_DATA_XML:
+        if (gb->gb_xret){
+            if (clixon_xml2cbuf_stream(cb, gb->gb_xret, gb->gb_pretty, -1, 0,
+                                       WITHDEFAULTS_REPORT_ALL, size, flush, flusharg) < 0)
+                goto done;
+            break;
+        }
+        for (i=0; i<gb->gb_xlen; i++)
+            if (clixon_xml2cbuf_stream(cb, gb->gb_xvec[i], gb->gb_pretty, -1, 0,
+                                       WITHDEFAULTS_REPORT_ALL, size, flush, flusharg) < 0)
+                goto done;
+        break;
+    case YANG_DATA_JSON:
+        if (gb->gb_xret){
+            if (clixon_json2cbuf_stream(cb, gb->gb_xret, gb->gb_pretty, size, flush, flusharg) < 0)
+                goto done;
+        }
+        else if (xml2json_cbuf_vec_stream(cb, gb->gb_xvec, gb->gb_xlen, gb->gb_pretty,
+                                          size, flush, flusharg) < 0)
+            goto done;
+        break;
+    default:
+        break;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Generic GET (both HEAD and GET)
  * According to restconf 
  * @param[in]  h        Clixon handle
@@ -127,6 +264,15 @@ api_data_get2(clixon_handle  h,
     yang_stmt *y = NULL;
     char      *defaults = NULL;
     cvec      *nscd = NULL;
+    char      *etag = NULL;
+    struct timeval lastmod;
+    yang_stmt *ytop;
+    cbuf      *cbnode = NULL;
+    cbuf      *cbkey = NULL;
+    cg_var    *cv;
+    uint32_t   chunk = 0;
+    int        streaming = 0;
+    struct get_body gb = {0,};
 
     clixon_debug(CLIXON_DBG_RESTCONF, "");
     if ((yspec = clicon_dbspec_yang(h)) == NULL){
@@ -202,6 +348,51 @@ api_data_get2(clixon_handle  h,
         defaults = attr;
     }
 
+    /* Configuration data only: entity tag of running, see RFC 8040 Sec 3.4.1 */
+    if (clicon_option_bool(h, "CLICON_RESTCONF_ETAG") &&
+        (content == CONTENT_CONFIG || (y != NULL && yang_config_only(y)))){
+        if (y != NULL){
+            ytop = y;
+            while (yang_parent_get(ytop) != NULL &&
+                   yang_keyword_get(yang_parent_get(ytop)) != Y_MODULE &&
+                   yang_keyword_get(yang_parent_get(ytop)) != Y_SUBMODULE)
+                ytop = yang_parent_get(ytop);
+            if ((cbnode = cbuf_new()) == NULL){
+                clixon_err(OE_UNIX, errno, "cbuf_new");
+                goto done;
+            }
+            cprintf(cbnode, "%s:%s", yang_argument_get(ys_module(ytop)), yang_argument_get(ytop));
+        }
+        if ((ret = clicon_rpc_datastore_stamp(h, NULL, cbnode?cbuf_get(cbnode):NULL, &etag, &lastmod)) < 0)
+            goto done;
+        if (ret == 1 && api_data_not_modified(h, etag, &lastmod)){
+            if (api_data_etag_headers(req, etag, &lastmod) < 0)
+                goto done;
+            if (restconf_reply_header(req, "Cache-Control", "no-cache") < 0)
+                goto done;
+            if (restconf_reply_send(req, 304, NULL, 0) < 0)
+                goto done;
+            goto ok;
+        }
+        if (ret == 1 && clicon_option_int(h, "CLICON_RESTCONF_CACHE") > 0){
+            /* Response cache key: user, media, pretty, path and query */
+            if ((cbkey = cbuf_new()) == NULL){
+                clixon_err(OE_UNIX, errno, "cbuf_new");
+                goto done;
+            }
+            cprintf(cbkey, "%s %d %d %s?", clicon_username_get(h)?clicon_username_get(h):"",
+                    media_out, pretty, api_path?api_path:"");
+            cv = NULL;
+            while ((cv = cvec_each(qvec, cv)) != NULL)
+                cprintf(cbkey, "%s=%s&", cv_name_get(cv), cv_string_get(cv));
+            if ((ret = restconf_cache_get(h, cbuf_get(cbkey), etag, &cbx)) < 0)
+                goto done;
+            if (ret == 1){
+                clixon_debug(CLIXON_DBG_RESTCONF, "cache hit:%s", cbuf_get(cbkey));
+                goto reply;
+            }
+        }
+    }
     clixon_debug(CLIXON_DBG_RESTCONF, "path:%s", xpath);
     ret = clicon_rpc_get(h, xpath, nsc, content, depth, defaults, &xret);
 
@@ -230,7 +421,17 @@ api_data_get2(clixon_handle  h,
         clixon_err(OE_UNIX, errno, "cbuf_new");
         goto done;
     }
+    /* Serialize while sending, unless reply is cached or possibly compressed */
+    if (!head && cbkey == NULL &&
+        (chunk = clicon_option_int(h, "CLICON_RESTCONF_STREAM_CHUNK")) > 0 &&
+        (clicon_option_int(h, "CLICON_RESTCONF_COMPRESS") == 0 ||
+         restconf_param_get(h, "HTTP_ACCEPT_ENCODING") == NULL))
+        streaming++;
     if (xpath==NULL || strcmp(xpath,"/")==0){ /* Special case: data root */
+        if (streaming){
+            gb.gb_xret = xret;
+            goto stream;
+        }
         switch (media_out){
         case YANG_DATA_XML:
             if (clixon_xml2cbuf(cbx, xret, 0, pretty, NULL, -1, 0) < 0) /* Dont print top object?  */
@@ -265,6 +466,23 @@ api_data_get2(clixon_handle  h,
                 goto done;
             goto ok;
         }
+        if (streaming){
+            if (media_out == YANG_DATA_XML)
+                for (i=0; i<xlen; i++){
+                    x = xvec[i];
+                    if (xml_nsctx_node(x, &nscd) < 0)
+                        goto done;
+                    if (xmlns_set_all(x, nscd) < 0)
+                        goto done;
+                    if (nscd){
+                        cvec_free(nscd);
+                        nscd = NULL;
+                    }
+                }
+            gb.gb_xvec = xvec;
+            gb.gb_xlen = xlen;
+            goto stream;
+        }
         switch (media_out){
         case YANG_DATA_XML:
             for (i=0; i<xlen; i++){
@@ -293,17 +511,47 @@ api_data_get2(clixon_handle  h,
         }
     }
     clixon_debug(CLIXON_DBG_RESTCONF, "cbuf:%s", cbuf_get(cbx));
+    if (cbkey && restconf_cache_put(h, cbuf_get(cbkey), etag, cbx) < 0)
+        goto done;
+ reply:
     if (restconf_reply_header(req, "Content-Type", "%s", restconf_media_int2str(media_out)) < 0)
         goto done;
     if (restconf_reply_header(req, "Cache-Control", "no-cache") < 0)
         goto done;
+    if (etag && api_data_etag_headers(req, etag, &lastmod) < 0)
+        goto done;
     if (restconf_reply_send(req, 200, cbx, head) < 0)
         goto done;
     cbx = NULL;
+    goto ok;
+ stream:
+    gb.gb_pretty = pretty;
+    gb.gb_media = media_out;
+    if (restconf_reply_header(req, "Content-Type", "%s", restconf_media_int2str(media_out)) < 0)
+        goto done;
+    if (restconf_reply_header(req, "Cache-Control", "no-cache") < 0)
+        goto done;
+    if (etag && api_data_etag_headers(req, etag, &lastmod) < 0)
+        goto done;
+    if ((ret = restconf_reply_send_stream(req, 200, chunk, api_data_get_body, &gb)) < 0)
+        goto done;
+    if (ret == 0){ /* Not supported by transport, serialize whole body without flushing */
+        if (api_data_get_body(&gb, cbx, SIZE_MAX, NULL, NULL) < 0)
+            goto done;
+        if (restconf_reply_send(req, 200, cbx, head) < 0)
+            goto done;
+        cbx = NULL;
+    }
  ok:
     retval = 0;
  done:
     clixon_debug(CLIXON_DBG_RESTCONF, "retval:%d", retval);
+    if (etag)
+        free(etag);
+    if (cbnode)
+        cbuf_free(cbnode);
+    if (cbkey)
+        cbuf_free(cbkey);
     if (xpath)
         free(xpath);
     if (nscd)
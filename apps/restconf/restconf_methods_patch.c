@@ -93,645 +93,746 @@ static const map_str2int yang_patch_op_map[] = {
     {NULL,         -1}
 };
 
+/* Netconf edit-config operation of each yang patch operation
+ * insert is a create and move a merge, both with yang:insert attributes
+ */
+static const enum operation_type yang_patch_op2netconf[] = {
+    OP_CREATE,  /* create */
+    OP_DELETE,  /* delete */
+    OP_CREATE,  /* insert */
+    OP_MERGE,   /* merge */
+    OP_MERGE,   /* move */
+    OP_REPLACE, /* replace */
+    OP_REMOVE   /* remove */
+};
+
 static const yang_patch_op_t
 yang_patch_op2int(char *op)
 {
     return clicon_str2int(yang_patch_op_map, op);
 }
 
-/*! Add square brackets after the surrounding curly brackets in JSON
+/*! Send a yang-patch-status reply
  *
-  * Needed, in order to modify the result of clixon_json2cbuf() to be valid input
-  * to api_data_post() and api_data_write()
-  * @param[in]  x_simple_patch  a cxobj to pass to clixon_json2cbuf()
-  * @retval     cbuf            With the modified json
-  * @retval     NULL            Error
-  */
-static cbuf*
-yang_patch_xml2json_modified_cbuf(cxobj *x_simple_patch)
+ * @param[in]  h         Clixon handle
+ * @param[in]  req       Generic Www handle
+ * @param[in]  patchid   Patch-id of the request
+ * @param[in]  editid    Edit-id of failed edit, or NULL for global errors
+ * @param[in]  xerr      Tree containing rpc-error, or NULL if patch succeeded
+ * @param[in]  pretty    Set to 1 for pretty-printed xml/json output
+ * @param[in]  media_out Output media
+ * @retval     0         OK
+ * @retval    -1         Error
+ * @see RFC 8072 Sec 2.3
+ */
+static int
+yang_patch_status(clixon_handle  h,
+                  void          *req,
+                  char          *patchid,
+                  char          *editid,
+                  cxobj         *xerr,
+                  int            pretty,
+                  restconf_media media_out)
 {
-    cbuf *json_simple_patch = NULL;
-    cbuf *cb = NULL;
-    char *json_simple_patch_tmp;
-    int   brace_count = 0;
-    size_t len;
-        
-    json_simple_patch = cbuf_new();
-    if (json_simple_patch == NULL)
-        return NULL;
-    cb = cbuf_new();
-    if (clixon_json2cbuf(cb, x_simple_patch, 0, 0) < 0)
-        goto done;
-
-    // Insert a '[' after the first '{' to get the JSON to match what api_data_post/write() expect
-    json_simple_patch_tmp = cbuf_get(cb);
-    len = strlen(json_simple_patch_tmp);
-    for (int l = 0; l < len; l++) {
-        char c = json_simple_patch_tmp[l];
-        if (c == '{') {
-            brace_count++;
-            if (brace_count == 2) { // We've reached the second brace, insert a '[' before it
-                cbuf_append(json_simple_patch,(int)'[');
-            }
-        }
-        cbuf_append(json_simple_patch,(int)c);
-    }
+    int    retval = -1;
+    cbuf  *cb = NULL;
+    cxobj *xe = NULL;
+    cxobj *xtag;
+    int    code = 200;
+    int    json;
 
-    // Insert a ']' before the last '}' to get the JSON to match what api_data_post() expects
-    for (int l = cbuf_len(json_simple_patch) - 1; l >= 0; l--) {
-        char c = cbuf_get(json_simple_patch)[l];
-        if (c == '}') {
-            // Truncate and add a string, as there is not a function to insert a char into a cbuf
-            cbuf_trunc(json_simple_patch, l);
-            cbuf_append_str(json_simple_patch, "]}");
-            break;
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if (xerr != NULL){
+        if ((xe = xpath_first(xerr, NULL, "//rpc-error")) == NULL){
+            clixon_err(OE_XML, 0, "Internal error, no rpc-error");
+            goto done;
         }
+        if ((xtag = xpath_first(xe, NULL, "error-tag")) == NULL ||
+            (code = restconf_err2code(xml_body(xtag))) < 0)
+            code = 500; /* internal server error */
+        if (xml_name_set(xe, "error") < 0)
+            goto done;
     }
-    cbuf_free(cb);
-    return json_simple_patch;
-}
-
-/*! yang_patch_strip_after_last_slash 
- *
- * Strip /... from end  of val
- * so that e.g. "/interface=eth2" becomes "/"
- * or "/interface_list=mylist/interface=eth2" becomes "/interface_list=mylist/"
- *
- * @param[in]  val     value to strip
- * @retval     cbuf    with the stripped string
- * @retval     NULL    error
- */
-static cbuf*
-yang_patch_strip_after_last_slash(char* val)
-{
-    cbuf *cb;
-    cbuf *val_tmp;
-    int   idx;
-    
-    cb = cbuf_new();
-    val_tmp = cbuf_new();
-    cbuf_append_str(val_tmp, val);
-    idx = cbuf_len(val_tmp);
-    for (int l = cbuf_len(val_tmp) - 1; l>= 0; l--) {
-        if (cbuf_get(val_tmp)[l] == '/') {
-            idx = l;
-            break;
+    json = (media_out == YANG_DATA_JSON || media_out == YANG_PATCH_JSON);
+    if (json)
+        cprintf(cb, "{\"ietf-yang-patch:yang-patch-status\":{\"patch-id\":\"%s\"",
+                patchid?patchid:"");
+    else{
+        cprintf(cb, "<yang-patch-status xmlns=\"urn:ietf:params:xml:ns:yang:ietf-yang-patch\"><patch-id>");
+        if (xml_chardata_cbuf_append(cb, 0, patchid?patchid:"") < 0)
+            goto done;
+        cprintf(cb, "</patch-id>");
+    }
+    if (xe == NULL)
+        cprintf(cb, json?",\"ok\":[null]":"<ok/>");
+    else {
+        if (editid){
+            if (json)
+                cprintf(cb, ",\"edit-status\":{\"edit\":[{\"edit-id\":\"%s\"", editid);
+            else{
+                cprintf(cb, "<edit-status><edit><edit-id>");
+                if (xml_chardata_cbuf_append(cb, 0, editid) < 0)
+                    goto done;
+                cprintf(cb, "</edit-id>");
+            }
+        }
+        if (json){
+            cprintf(cb, ",\"errors\":");
+            if (clixon_json2cbuf(cb, xe, pretty, 0, 0) < 0)
+                goto done;
+        }
+        else{
+            cprintf(cb, "<errors>");
+            if (clixon_xml2cbuf(cb, xe, 0, pretty, NULL, -1, 0) < 0)
+                goto done;
+            cprintf(cb, "</errors>");
         }
+        if (editid)
+            cprintf(cb, json?"}]}":"</edit></edit-status>");
     }
-    if (idx == cbuf_len(val_tmp)) // Didn't find a slash in the loop above
-        return NULL;
-    cbuf_trunc(val_tmp, idx + 1);
-    if (cbuf_append_str(cb, cbuf_get(val_tmp)) < 0)
-        return NULL;
-    cbuf_free(val_tmp);
-    return cb;
+    cprintf(cb, json?"}}\r\n":"</yang-patch-status>\r\n");
+    if (restconf_reply_header(req, "Content-Type", "%s", restconf_media_int2str(media_out)) < 0)
+        goto done;
+    if (restconf_reply_send(req, code, cb, 0) < 0)
+        goto done;
+    cb = NULL;
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
 }
 
-/*! YANG PATCH replace method
+/*! Parse the value of a YANG patch edit as the target node
  *
- * @param[in]  h         Clixon handle
- * @param[in]  req       Generic Www handle
- * @param[in]  pi        Offset, where to start api-path
- * @param[in]  qvec      Vector of query string (QUERY_STRING)
- * @param[in]  pretty    Set to 1 for pretty-printed xml/json output
- * @param[in]  media_out Output media
- * @param[in]  ds       0 if "data" resource, 1 if rfc8527 "ds" resource
- * @param[in]  simplepatch_request_uri URI for patch request, e.g. "/restconf/data/ietf-interfaces:interfaces"
- * @param[in]  target_val       value in "target" field of edit in YANG patch
- * @param[in]  value_vec_len    number of elements in the "value" array of an edit in YANG patch
- * @param[in]  value_vec        pointer to the "value" array of an edit in YANG patch
- * @param[in]  x_simple_patch   pointer to XML containing module name, e.g. <ietf-interfaces:interface/>
- * @retval     0    OK
- * @retval    -1    Error
+ * The value is anydata in the patch and therefore not bound to YANG. It is serialized as
+ * JSON prefixed with the module of the target and parsed under the parent of the target,
+ * in the same way as data of a PUT. Missing list keys of a merge value are taken from the
+ * target.
+ * @param[in]  yspec   Yang spec
+ * @param[in]  xvalue  Value element of the edit
+ * @param[in]  xbot    Target node
+ * @param[in]  ybot    Yang of target node
+ * @param[out] xdatap  Value bound to YANG, not in any tree, free with xml_free
+ * @param[out] xerr    Error reason if retval is 0
+ * @retval     1       OK
+ * @retval     0       Invalid value, see xerr
+ * @retval    -1       Error
  */
 static int
-yang_patch_do_replace(clixon_handle  h,
-                      void          *req,
-                      int            pi,
-                      cvec          *qvec,
-                      int            pretty,
-                      restconf_media media_out,
-                      ietf_ds_t      ds,
-                      cbuf          *simple_patch_request_uri,
-                      char          *target_val,       
-                      int            value_vec_len,
-                      cxobj        **value_vec,
-                      cxobj         *x_simple_patch
-                      )
+yang_patch_value(yang_stmt *yspec,
+                 cxobj     *xvalue,
+                 cxobj     *xbot,
+                 yang_stmt *ybot,
+                 cxobj    **xdatap,
+                 cxobj    **xerr)
 {
-    int    retval = -1;
-    cxobj *value_vec_tmp = NULL;
-    cbuf  *delete_req_uri = NULL;
-    cbuf  *post_req_uri = NULL;
-    cbuf  *json_simple_patch = NULL;
-    
-    if ((delete_req_uri = cbuf_new()) == NULL){
-        clixon_err(OE_UNIX, errno, "cbuf_new");
-        goto done;
+    int        retval = -1;
+    cxobj     *xv;
+    cxobj     *xj = NULL;
+    cxobj     *xdata0 = NULL;
+    cxobj     *xdata;
+    cxobj     *xfrom;
+    cxobj     *xa;
+    cxobj     *xac;
+    cxobj     *xk;
+    yang_stmt *ymod;
+    cvec      *cvk;
+    cg_var    *cvi;
+    char      *keyname;
+    char      *kb;
+    char      *vb;
+    cbuf      *cb = NULL;
+    int        i;
+    int        ret;
+
+    if (xml_child_nr_type(xvalue, CX_ELMNT) != 1){
+        if (netconf_malformed_message_xml(xerr, "The value MUST contain exactly one instance of the target resource") < 0)
+            goto done;
+        goto fail;
     }
-    if ((json_simple_patch = cbuf_new()) == NULL){
+    xv = xml_child_i_type(xvalue, 0, CX_ELMNT);
+    if (strcmp(xml_name(xv), xml_name(xbot)) != 0){
+        if (netconf_bad_element_xml(xerr, "application", xml_name(xv), "Value element does not match target") < 0)
+            goto done;
+        goto fail;
+    }
+    if ((cb = cbuf_new()) == NULL){
         clixon_err(OE_UNIX, errno, "cbuf_new");
         goto done;
     }
-    // Make delete_req_uri something like "/restconf/data/ietf-interfaces:interfaces"
-    if (cbuf_append_str(delete_req_uri, cbuf_get(simple_patch_request_uri)) < 0){
-        clixon_err(OE_UNIX, errno, "cbuf_append_str");
+    if (ys_real_module(ybot, &ymod) < 0)
         goto done;
-    }
-
-    // Add the target to delete_req_uri,
-    // so it's something like "/restconf/data/ietf-interfaces:interfaces/interface=eth2"
-    if (cbuf_append_str(delete_req_uri, target_val) <  0){
-        clixon_err(OE_UNIX, errno, "cbuf_append_str");
+    if ((xj = xml_dup(xv)) == NULL)
         goto done;
+    xml_prefix_set(xj, NULL);
+    cprintf(cb, "%s:%s", yang_argument_get(ymod), xml_name(xv));
+    if (xml_name_set(xj, cbuf_get(cb)) < 0)
+        goto done;
+    /* List keys of value must match target, missing keys are copied from target */
+    if (yang_keyword_get(ybot) == Y_LIST){
+        cvk = yang_cvec_get(ybot);
+        cvi = NULL;
+        i = 0;
+        while ((cvi = cvec_each(cvk, cvi)) != NULL) {
+            keyname = cv_string_get(cvi);
+            kb = xml_find_body(xbot, keyname);
+            if ((xk = xml_find_type(xj, NULL, keyname, CX_ELMNT)) != NULL){
+                if ((vb = xml_body(xk)) == NULL || kb == NULL || strcmp(vb, kb) != 0){
+                    if (netconf_operation_failed_xml(xerr, "protocol", "Target keys do not match value keys") < 0)
+                        goto done;
+                    goto fail;
+                }
+            }
+            else if ((xk = xml_find_type(xbot, NULL, keyname, CX_ELMNT)) != NULL){
+                if ((xk = xml_dup(xk)) == NULL)
+                    goto done;
+                if (xml_child_insert_pos(xj, xk, i) < 0)
+                    goto done;
+                xml_parent_set(xk, xj);
+            }
+            i++;
+        }
     }
-
-    // Delete the object with the old values
-    if (api_data_delete(h, req, cbuf_get(delete_req_uri), pi, pretty, YANG_DATA_JSON, ds) < 0)
+    cbuf_reset(cb);
+    if (clixon_json2cbuf(cb, xj, 0, 0, 0) < 0)
         goto done;
-
-    // Now set up for the post request.
-    // Strip /... from end  of target val
-    // so that e.g. "/interface=eth2" becomes "/"
-    // or "/interface_list=mylist/interface=eth2" becomes "/interface_list=mylist/"
-    if ((post_req_uri = yang_patch_strip_after_last_slash(target_val)) == NULL)
+    /* Create a dummy data tree parent to hook in the parsed data, see api_data_write */
+    if ((xdata0 = xml_new(XML_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
         goto done;
-
-    // Make post_req_uri something like "/restconf/data/ietf-interfaces:interfaces"
-    if (cbuf_append_str(simple_patch_request_uri, cbuf_get(post_req_uri)) < 0){
-        clixon_err(OE_UNIX, errno, "cbuf_append_str");
+    xfrom = xml_parent(xbot);
+    if (xml_copy_one(xfrom, xdata0) < 0)
         goto done;
+    xa = NULL;
+    while ((xa = xml_child_each(xfrom, xa, CX_ATTR)) != NULL) {
+        if ((xac = xml_new(xml_name(xa), xdata0, CX_ATTR)) == NULL)
+            goto done;
+        if (xml_copy(xa, xac) < 0)
+            goto done;
     }
-    // Now insert the new values into the data
-    // (which will include the key value and all other mandatory values)
-    for (int k = 0; k < value_vec_len; k++) {
-        if (value_vec[k] != NULL) {
-            value_vec_tmp = xml_dup(value_vec[k]);
-            xml_addsub(x_simple_patch, value_vec_tmp);
-        }
+    if ((ret = clixon_json_parse_string(cbuf_get(cb), 1,
+                                        xml_spec(xdata0)?YB_PARENT:YB_MODULE,
+                                        yspec, &xdata0, xerr)) < 0){
+        if (netconf_malformed_message_xml(xerr, clixon_err_reason()) < 0)
+            goto done;
+        goto fail;
     }
-    // Convert the data to json
-    if (clixon_json2cbuf(json_simple_patch, x_simple_patch, 0, 0) < 0)
-        goto done;
-
-    // Send the POST request
-    if (api_data_post(h, req, cbuf_get(simple_patch_request_uri), pi, qvec, cbuf_get(json_simple_patch), pretty, YANG_DATA_JSON, media_out, ds ) < 0)
+    if (ret == 0)
+        goto fail;
+    if ((xdata = xml_child_i_type(xdata0, 0, CX_ELMNT)) == NULL){
+        if (netconf_malformed_message_xml(xerr, "The value MUST contain exactly one instance of the target resource") < 0)
+            goto done;
+        goto fail;
+    }
+    if (xml_rm(xdata) < 0)
         goto done;
-    retval = 0;
+    *xdatap = xdata;
+    retval = 1;
  done:
-    if (post_req_uri)
-        cbuf_free(post_req_uri);
-    if (delete_req_uri)
-        cbuf_free(delete_req_uri);
-    if (json_simple_patch)
-        cbuf_free(json_simple_patch);
-    if (value_vec_tmp)
-        xml_free(value_vec_tmp);
+    if (cb)
+        cbuf_free(cb);
+    if (xj)
+        xml_free(xj);
+    if (xdata0)
+        xml_free(xdata0);
     return retval;
+ fail:
+    retval = 0;
+    goto done;
 }
 
-/*! YANG PATCH create method
+/*! Get the current config of a move target from candidate
  *
- * @param[in]  h         Clixon handle
- * @param[in]  req       Generic Www handle
- * @param[in]  pi        Offset, where to start api-path
- * @param[in]  qvec      Vector of query string (QUERY_STRING)
- * @param[in]  pretty    Set to 1 for pretty-printed xml/json output
- * @param[in]  media_out Output media
- * @param[in]  ds       0 if "data" resource, 1 if rfc8527 "ds" resource
- * @param[in]  simplepatch_request_uri URI for patch request, e.g. "/restconf/data/ietf-interfaces:interfaces"
- * @param[in]  value_vec_len    number of elements in the "value" array of an edit in YANG patch
- * @param[in]  value_vec        pointer to the "value" array of an edit in YANG patch
- * @param[in]  x_simple_patch   pointer to XML containing module name, e.g. <ietf-interfaces:interface/>
- * @retval     0    OK
- * @retval    -1    Error
+ * A merge with yang:insert replaces the existing list entry, therefore the whole entry
+ * is needed to move it.
+ * @param[in]  h       Clixon handle
+ * @param[in]  yspec   Yang spec
+ * @param[in]  path    Api-path of target
+ * @param[in]  ybot    Yang of target node
+ * @param[out] xdatap  Existing target node, not in any tree, free with xml_free
+ * @param[out] xerr    Error reason if retval is 0
+ * @retval     1       OK
+ * @retval     0       Target does not exist, or other error, see xerr
+ * @retval    -1       Error
  */
 static int
-yang_patch_do_create(clixon_handle  h,
-                     void          *req,
-                     int            pi,
-                     cvec          *qvec,
-                     int            pretty,
-                     restconf_media media_out,
-                     ietf_ds_t      ds,
-                     cbuf          *simple_patch_request_uri,
-                     int            value_vec_len,
-                     cxobj        **value_vec,
-                     cxobj         *x_simple_patch
-                     )
+yang_patch_move_get(clixon_handle h,
+                    yang_stmt    *yspec,
+                    char         *path,
+                    yang_stmt    *ybot,
+                    cxobj       **xdatap,
+                    cxobj       **xerr)
 {
     int    retval = -1;
-    cxobj *value_vec_tmp = NULL;
-    cbuf  *cb = NULL;
-    
-    // Send the POST request
-    if ((cb = cbuf_new()) == NULL){
-        clixon_err(OE_UNIX, errno, "cbuf_new");
+    char  *xpath = NULL;
+    cvec  *nsc = NULL;
+    cxobj *xret = NULL;
+    cxobj *x;
+    int    ret;
+
+    if ((ret = api_path2xpath(path, yspec, &xpath, &nsc, xerr)) < 0)
         goto done;
+    if (ret == 0)
+        goto fail;
+    if (clicon_rpc_get_config(h, clicon_username_get(h), "candidate", xpath, nsc, NULL, &xret) < 0)
+        goto done;
+    if (xpath_first(xret, NULL, "//rpc-error") != NULL){
+        *xerr = xret;
+        xret = NULL;
+        goto fail;
     }
-    for (int k = 0; k < value_vec_len; k++) {
-        if (value_vec[k] != NULL) {
-            if ((value_vec_tmp = xml_dup(value_vec[k])) == NULL)
-                goto done;
-            xml_addsub(x_simple_patch, value_vec_tmp);
-        }
+    if ((x = xpath_first(xret, nsc, "%s", xpath)) == NULL){
+        if (netconf_data_missing_xml(xerr, "Move target does not exist") < 0)
+            goto done;
+        goto fail;
     }
-    if (clixon_json2cbuf(cb, x_simple_patch, 0, 0) < 0)
+    if ((x = xml_dup(x)) == NULL)
         goto done;
-    if (api_data_post(h, req, cbuf_get(simple_patch_request_uri),
-                      pi, qvec,
-                      cbuf_get(cb), pretty, YANG_DATA_JSON, media_out, ds) < 0)
-        goto done;
-     retval = 0;
+    if (xml_spec(x) == NULL)
+        xml_spec_set(x, ybot);
+    *xdatap = x;
+    retval = 1;
  done:
-     if (cb)
-         cbuf_free(cb);
+    if (xpath)
+        free(xpath);
+    if (nsc)
+        xml_nsctx_free(nsc);
+    if (xret)
+        xml_free(xret);
     return retval;
+ fail:
+    retval = 0;
+    goto done;
 }
 
-/*! YANG PATCH insert method
+/*! Compile a single yang patch "edit" element into an edit-config tree
  *
- * @param[in]  h                Clixon handle
- * @param[in]  req              Generic Www handle
- * @param[in]  pi               Offset, where to start api-path
- * @param[in]  pretty           Set to 1 for pretty-printed xml/json output
- * @param[in]  media_out        Output media
- * @param[in]  ds       0       if "data" resource, 1 if rfc8527 "ds" resource
- * @param[in]  simple_patch_request_uri URI for patch request, e.g. "/restconf/data/ietf-interfaces:interfaces"
- * @param[in]  value_vec_len    number of elements in the "value" array of an edit in YANG patch
- * @param[in]  value_vec        pointer to the "value" array of an edit in YANG patch
- * @param[in]  x_simple_patch   pointer to XML containing module name, e.g. <ietf-interfaces:interface/>
- * @param[in]  where_val       value in "where" field of edit in YANG patch
- * @param[in]  api_path        full API path, e.g. "/restconf/data/example-jukebox:jukebox/playlist=Foo-One" 
- * @param[in]  point_val       value in "point" field of edit in YANG patch
- * @retval     0               OK
- * @retval    -1               Error
+ * The tree is a single path from the top to the target node, with the netconf operation
+ * and yang:insert attributes of the edit on the target node.
+ * @param[in]  h         Clixon handle
+ * @param[in]  yspec     Yang spec
+ * @param[in]  api_path  Api-path of the target resource of the patch, or NULL
+ * @param[in]  xn        XML edit element
+ * @param[out] xtp       Edit-config tree, free with xml_free
+ * @param[out] xtargetp  Target node in xtp
+ * @param[out] xerr      Error reason if retval is 0
+ * @retval     1         OK
+ * @retval     0         Invalid edit, see xerr
+ * @retval    -1         Error
  */
 static int
-yang_patch_do_insert(clixon_handle  h,
-                     void          *req,
-                     int            pi,
-                     int            pretty,
-                     restconf_media media_out,
-                     ietf_ds_t      ds,
-                     cbuf          *simple_patch_request_uri,
-                     int            value_vec_len,
-                     cxobj        **value_vec,
-                     cxobj         *x_simple_patch,
-                     char          *where_val,
-                     char          *api_path,
-                     char          *point_val
-                     )
+yang_patch_compile(clixon_handle h,
+                   yang_stmt    *yspec,
+                   char         *api_path,
+                   cxobj        *xn,
+                   cxobj       **xtp,
+                   cxobj       **xtargetp,
+                   cxobj       **xerr)
 {
-    int     retval = -1;
-    cxobj  *value_vec_tmp = NULL;
-    cbuf   *json_simple_patch;
-    cg_var *cv;
-    cbuf   *point_str = NULL;
-    cvec   *qvec_tmp = NULL;
-    
-    if ((point_str = cbuf_new()) == NULL){
-        clixon_err(OE_UNIX, errno, "cbuf_new");
-        goto done;
+    int             retval = -1;
+    yang_patch_op_t operation;
+    char           *target_val;
+    char           *where_val = NULL;
+    char           *point_val = NULL;
+    char           *opstr;
+    cxobj          *xt = NULL;
+    cxobj          *xbot;
+    cxobj          *xp;
+    cxobj          *xvalue;
+    cxobj          *xdata = NULL;
+    yang_stmt      *ybot = NULL;
+    cbuf           *path = NULL;
+    cbuf           *point = NULL;
+    cvec           *qvec = NULL;
+    int             ret;
+
+    clixon_debug_xml(CLIXON_DBG_RESTCONF, xn, "%d xn:", __LINE__);
+    if ((target_val = xml_find_body(xn, "target")) == NULL){
+        if (netconf_missing_element_xml(xerr, "protocol", "target", NULL) < 0)
+            goto done;
+        goto fail;
+    }
+    if ((opstr = xml_find_body(xn, "operation")) == NULL){
+        if (netconf_missing_element_xml(xerr, "protocol", "operation", NULL) < 0)
+            goto done;
+        goto fail;
+    }
+    if ((int)(operation = yang_patch_op2int(opstr)) < 0){
+        if (netconf_invalid_value_xml(xerr, "protocol", "Unknown yang patch operation") < 0)
+            goto done;
+        goto fail;
+    }
+    if (operation == YANG_PATCH_OP_INSERT || operation == YANG_PATCH_OP_MOVE){
+        if ((where_val = xml_find_body(xn, "where")) == NULL)
+            where_val = "last";
+        point_val = xml_find_body(xn, "point");
+        if ((strcmp(where_val, "before") == 0 || strcmp(where_val, "after") == 0) &&
+            point_val == NULL){
+            if (netconf_missing_element_xml(xerr, "protocol", "point", NULL) < 0)
+                goto done;
+            goto fail;
+        }
     }
-    if ((qvec_tmp = cvec_new(0)) == NULL){
+    if ((path = cbuf_new()) == NULL){
         clixon_err(OE_UNIX, errno, "cbuf_new");
         goto done;
     }
-    // Loop through the XML, and get each value
-    for (int k = 0; k < value_vec_len; k++) {
-        if (value_vec[k] != NULL) {
-            value_vec_tmp = xml_dup(value_vec[k]);
-            xml_addsub(x_simple_patch, value_vec_tmp);
-        }
+    if (api_path)
+        cprintf(path, "%s", api_path);
+    if (strcmp(target_val, "/") != 0)
+        cprintf(path, "%s", target_val);
+    if (cbuf_len(path) == 0 || strcmp(cbuf_get(path), "/") == 0){
+        if (netconf_operation_not_supported_xml(xerr, "protocol", "Edit of whole datastore not supported") < 0)
+            goto done;
+        goto fail;
     }
-    if ((json_simple_patch = yang_patch_xml2json_modified_cbuf(x_simple_patch)) == NULL)
+    if ((xt = xml_new(NETCONF_INPUT_CONFIG, NULL, CX_ELMNT)) == NULL)
         goto done;
-
-    // Set the insert attributes
-    if ((cv = cvec_add(qvec_tmp, CGV_STRING)) == NULL){
-        clixon_err(OE_UNIX, errno, "cvec_add");
+    xbot = xt;
+    if ((ret = api_path2xml(cbuf_get(path), yspec, xt, YC_DATANODE, 1, &xbot, &ybot, xerr)) < 0)
         goto done;
+    if (ret == 0)
+        goto fail;
+    if (xbot == xt || ybot == NULL){
+        if (netconf_operation_not_supported_xml(xerr, "protocol", "Edit of whole datastore not supported") < 0)
+            goto done;
+        goto fail;
     }
-    cv_name_set(cv, "insert");
-    if (where_val)
-        cv_string_set(cv, where_val);
-    cbuf_append_str(point_str, api_path);
-    if (point_val)
-        cbuf_append_str(point_str, point_val);
-    if ((cv = cvec_add(qvec_tmp, CGV_STRING)) == NULL){
-        clixon_err(OE_UNIX, errno, "cvec_add");
-        goto done;
+    switch (operation){
+    case YANG_PATCH_OP_CREATE:
+    case YANG_PATCH_OP_INSERT:
+    case YANG_PATCH_OP_MERGE:
+    case YANG_PATCH_OP_REPLACE:
+        if ((xvalue = xml_find_type(xn, NULL, "value", CX_ELMNT)) == NULL){
+            if (netconf_missing_element_xml(xerr, "protocol", "value", NULL) < 0)
+                goto done;
+            goto fail;
+        }
+        if ((ret = yang_patch_value(yspec, xvalue, xbot, ybot, &xdata, xerr)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+        break;
+    case YANG_PATCH_OP_MOVE:
+        if ((ret = yang_patch_move_get(h, yspec, cbuf_get(path), ybot, &xdata, xerr)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+        break;
+    default: /* delete, remove */
+        break;
     }
-    cv_name_set(cv, "point");
-    cv_string_set(cv, cbuf_get(point_str));
-
-    // Send the POST request
-    if (api_data_post(h, req, cbuf_get(simple_patch_request_uri), pi, qvec_tmp, cbuf_get(json_simple_patch), pretty, YANG_DATA_JSON, media_out, ds)<  0)
+    if (xdata != NULL){ /* Replace target with value */
+        xp = xml_parent(xbot);
+        xml_purge(xbot);
+        if (xml_addsub(xp, xdata) < 0)
+            goto done;
+        if (xml_spec(xp) == NULL &&
+            xml_find_type(xdata, NULL, "xmlns", CX_ATTR) == NULL &&
+            xmlns_set(xdata, NULL, yang_find_mynamespace(ybot)) < 0)
+            goto done;
+        xbot = xdata;
+        xdata = NULL;
+    }
+    if (xml_add_attr(xbot, "operation",
+                     xml_operation2str(yang_patch_op2netconf[operation]),
+                     NETCONF_BASE_PREFIX, NULL) == NULL)
         goto done;
-    retval = 0;
+    if (where_val){
+        /* Translate to restconf insert/point query and then to yang:insert attributes */
+        if ((qvec = cvec_new(0)) == NULL){
+            clixon_err(OE_UNIX, errno, "cvec_new");
+            goto done;
+        }
+        if (cvec_add_string(qvec, "insert", where_val) < 0)
+            goto done;
+        if (point_val){
+            if ((point = cbuf_new()) == NULL){
+                clixon_err(OE_UNIX, errno, "cbuf_new");
+                goto done;
+            }
+            cprintf(point, "%s%s", api_path?api_path:"", point_val);
+            if (cvec_add_string(qvec, "point", cbuf_get(point)) < 0)
+                goto done;
+        }
+        if (restconf_insert_attributes(xbot, qvec) < 0)
+            goto done;
+    }
+    *xtp = xt;
+    xt = NULL;
+    *xtargetp = xbot;
+    retval = 1;
  done:
-    if (qvec_tmp)
-        cvec_free(qvec_tmp);
-    if (point_str)
-        cbuf_free(point_str);
-    if (json_simple_patch)
-        cbuf_free(json_simple_patch);
+    if (qvec)
+        cvec_free(qvec);
+    if (point)
+        cbuf_free(point);
+    if (path)
+        cbuf_free(path);
+    if (xdata)
+        xml_free(xdata);
+    if (xt)
+        xml_free(xt);
     return retval;
+ fail:
+    retval = 0;
+    goto done;
 }
 
-/*! YANG PATCH merge method
+/*! Add a compiled edit to the transaction plan
  *
- * @param[in]  h               Clixon handle
- * @param[in]  req             Generic Www handle
- * @param[in]  pi              Offset, where to start api-path
- * @param[in]  qvec            Vector of query string (QUERY_STRING)
- * @param[in]  pretty          Set to 1 for pretty-printed xml/json output
- * @param[in]  media_out       Output media
- * @param[in]  ds       0      if "data" resource, 1 if rfc8527 "ds" resource
- * @param[in]  simple_patch_request_uri URI for patch request, e.g. "/restconf/data/ietf-interfaces:interfaces"
- * @param[in]  value_vec_len   number of elements in the "value" array of an edit in YANG patch
- * @param[in]  value_vec       pointer to the "value" array of an edit in YANG patch
- * @param[in]  x_simple_patch  pointer to XML containing module name, e.g. "<ietf-interfaces:interface/>"
- * @param[in]  where_val       value in "where" field of edit in YANG patch
- * @param[in]  key_xn          XML with key tag and value, e.g. "<name>Foo-One</name>"
- * @retval     0               OK
- * @retval    -1               Error
+ * Interior nodes of the edit shared with earlier edits of the plan are reused, the rest of
+ * the edit tree is moved into the plan. The plan index maps the api-path of every node in
+ * the plan to the node. An edit conflicts with the plan if its target, or an ancestor or
+ * descendant of it, already is the target of an edit in the plan, since the backend does
+ * not apply two operations on the same node in one edit-config.
+ * @param[in]  xplan    Plan edit-config tree
+ * @param[in]  ht       Plan index
+ * @param[in]  xtarget  Target node of compiled edit tree, nodes are moved to xplan
+ * @param[in]  check    If set, only check for conflict, do not add
+ * @retval     1        OK, no conflict
+ * @retval     0        Conflict, edit not added
+ * @retval    -1        Error
  */
 static int
-yang_patch_do_merge(clixon_handle  h,
-                    void          *req,
-                    int            pi,
-                    cvec          *qvec,
-                    int            pretty,
-                    restconf_media media_out,
-                    ietf_ds_t      ds,
-                    cbuf          *simple_patch_request_uri,
-                    int            value_vec_len,
-                    cxobj        **value_vec,
-                    cxobj         *x_simple_patch,
-                    cxobj         *key_xn
-                    )
+yang_patch_plan_add(cxobj         *xplan,
+                    clicon_hash_t *ht,
+                    cxobj         *xtarget,
+                    int            check)
 {
-    int    retval = -1;
-    cxobj *value_vec_tmp = NULL;
-    cbuf  *cb = NULL;
-    cbuf  *json_simple_patch = NULL;
-        
+    int     retval = -1;
+    cxobj **xvec = NULL;
+    int     xlen = 0;
+    cxobj  *x;
+    cxobj  *xp;
+    cxobj **xpp;
+    cbuf   *cb = NULL;
+    size_t  vlen;
+    int     i;
+
+    /* Path from top to target, excluding top */
+    for (x = xtarget; xml_parent(x) != NULL; x = xml_parent(x))
+        xlen++;
+    if ((xvec = calloc(xlen, sizeof(cxobj *))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    i = xlen;
+    for (x = xtarget; xml_parent(x) != NULL; x = xml_parent(x))
+        xvec[--i] = x;
     if ((cb = cbuf_new()) == NULL){
         clixon_err(OE_UNIX, errno, "cbuf_new");
         goto done;
     }
-    if (key_xn != NULL)
-        xml_addsub(x_simple_patch, key_xn);
-    
-    // Loop through the XML, create JSON from each one, and submit a simple patch
-    for (int k = 0; k < value_vec_len; k++) {
-        if (value_vec[k] != NULL) {
-            value_vec_tmp = xml_dup(value_vec[k]);
-            xml_addsub(x_simple_patch, value_vec_tmp);
-        }
-        cbuf_reset(cb); /* reuse cb */
-        if (clixon_json2cbuf(cb, x_simple_patch, 0, 0) < 0)
+    xp = xplan;
+    for (i=0; i<xlen; i++){
+        if (xml2api_path_1(xvec[i], cb) < 0)
             goto done;
-
-        if ((json_simple_patch = yang_patch_xml2json_modified_cbuf(x_simple_patch)) == NULL)
+        if ((xpp = clicon_hash_value(ht, cbuf_get(cb), &vlen)) != NULL){
+            if (i == xlen-1 ||
+                xml_find_type(*xpp, NETCONF_BASE_PREFIX, "operation", CX_ATTR) != NULL)
+                goto conflict;
+            xp = *xpp;
+            continue;
+        }
+        if (check)
+            break;
+        /* Move rest of edit to plan and index it */
+        if (xml_rm(xvec[i]) < 0)
             goto done;
-        // Send the simple patch request
-        if (api_data_write(h, req, cbuf_get(simple_patch_request_uri), pi, qvec, cbuf_get(json_simple_patch), pretty, YANG_DATA_JSON, media_out, 1, ds ) < 0)
+        if (xml_addsub(xp, xvec[i]) < 0)
             goto done;
-        if (json_simple_patch){
-            cbuf_free(json_simple_patch);
-            json_simple_patch = NULL;
+        while (1){
+            if (clicon_hash_add(ht, cbuf_get(cb), &xvec[i], sizeof(cxobj *)) == NULL)
+                goto done;
+            if (++i == xlen)
+                break;
+            if (xml2api_path_1(xvec[i], cb) < 0)
+                goto done;
         }
+        break;
     }
-    retval = 0;
+    retval = 1;
  done:
     if (cb)
         cbuf_free(cb);
-    if (json_simple_patch)
-        cbuf_free(json_simple_patch);
+    if (xvec)
+        free(xvec);
     return retval;
+ conflict:
+    retval = 0;
+    goto done;
 }
 
-/*! Process a single yang patch "edit/value" element
+/*! Send an edit-config of candidate to the backend
  *
- * @param[in]  xn        XML value element
- * @retval     0         OK
- * @retval    -1         Error
+ * @param[in]  h       Clixon handle
+ * @param[in]  yspec   Yang spec
+ * @param[in]  xt      Edit-config tree
+ * @param[in]  commit  If set, commit candidate if edit succeeds (autocommit)
+ * @param[in]  ds      0 if "data" resource, 1 if rfc8527 "ds" resource
+ * @param[out] xret    Reply, free with xml_free
+ * @retval     0       OK, check xret for rpc-error
+ * @retval    -1       Error
+ * @see api_data_write
  */
 static int
-yang_patch_do_value(clixon_handle  h,
-                    void          *req,
-                    int            pi,
-                    cvec          *qvec,
-                    int            pretty,
-                    restconf_media media_out,
-                    ietf_ds_t      ds,
-                    cxobj         *xn,
-                    char          *modname,
-                    yang_patch_op_t operation,
-                    char          *where_val,
-                    char          *point_val,
-                    cbuf          *simple_patch_request_uri,
-                    char          *target_val,
-                    char          *api_path,
-                    cxobj         *key_xn
-                    )
+yang_patch_send(clixon_handle h,
+                yang_stmt    *yspec,
+                cxobj        *xt,
+                int           commit,
+                ietf_ds_t     ds,
+                cxobj       **xret)
 {
-    int     retval = -1;
-    cxobj **values_child_vec;
-    char   *key_node_id;
-    cbuf   *patch_header = NULL;
-    cxobj  *x_simple_patch = NULL;
-    int     value_vec_len;
-    cxobj **value_vec;
-
-    values_child_vec = xml_childvec_get(xn);
-    key_node_id = xml_name(*values_child_vec);
-    /* Create cbufs:s */
-    if ((patch_header = cbuf_new()) == NULL){
+    int   retval = -1;
+    cbuf *cbx = NULL;
+    char *username;
+
+    if ((cbx = cbuf_new()) == NULL){
         clixon_err(OE_UNIX, errno, "cbuf_new");
         goto done;
     }
-    cprintf(patch_header, "%s:%s", modname, key_node_id);
-    if ((x_simple_patch = xml_new(cbuf_get(patch_header), NULL, CX_ELMNT)) == NULL)
-        goto done;
-    value_vec_len = xml_child_nr(*values_child_vec);
-    value_vec = xml_childvec_get(*values_child_vec);
-    switch (operation){
-    case YANG_PATCH_OP_REPLACE:
-        if (yang_patch_do_replace(h, req, pi, qvec, pretty, media_out, ds, simple_patch_request_uri, target_val, value_vec_len, value_vec, x_simple_patch) < 0)
-            goto done;
-        break;
-    case YANG_PATCH_OP_CREATE:
-        if (yang_patch_do_create(h, req, pi, qvec, pretty, media_out, ds, simple_patch_request_uri, value_vec_len, value_vec, x_simple_patch) < 0)
-            goto done;
-        break;
-    case YANG_PATCH_OP_INSERT:
-        if (yang_patch_do_insert(h, req, pi, pretty, media_out, ds, simple_patch_request_uri, value_vec_len, value_vec, x_simple_patch, where_val, api_path, point_val) < 0)
-            goto done;
-        break;
-    case YANG_PATCH_OP_MERGE:
-        if (yang_patch_do_merge(h, req, pi, qvec, pretty, media_out, ds, simple_patch_request_uri, value_vec_len, value_vec, x_simple_patch, key_xn) < 0)
-            goto done;
-        break;
-    default:
-        break;
+    cprintf(cbx, "<rpc xmlns=\"%s\"", NETCONF_BASE_NAMESPACE);
+    cprintf(cbx, " xmlns:%s=\"%s\"", NETCONF_BASE_PREFIX, NETCONF_BASE_NAMESPACE);
+    if ((username = clicon_username_get(h)) != NULL){
+        cprintf(cbx, " %s:username=\"%s\"", CLIXON_LIB_PREFIX, username);
+        cprintf(cbx, " xmlns:%s=\"%s\"", CLIXON_LIB_PREFIX, CLIXON_LIB_NS);
     }
+    cprintf(cbx, " %s", NETCONF_MESSAGE_ID_ATTR);
+    cprintf(cbx, ">");
+    cprintf(cbx, "<edit-config");
+    if (commit){
+        /* RFC8040 Sec 1.4, see api_data_write */
+        if ((IETF_DS_NONE == ds) &&
+            if_feature(yspec, "ietf-netconf", "startup") &&
+            !clicon_option_bool(h, "CLICON_RESTCONF_STARTUP_DONTUPDATE")){
+            cprintf(cbx, " %s:copystartup=\"true\"", CLIXON_LIB_PREFIX);
+            cprintf(cbx, " xmlns:%s=\"%s\"", CLIXON_LIB_PREFIX, CLIXON_LIB_NS);
+        }
+        cprintf(cbx, " %s:autocommit=\"true\" xmlns:%s=\"%s\"",
+                CLIXON_LIB_PREFIX, CLIXON_LIB_PREFIX, CLIXON_LIB_NS);
+    }
+    cprintf(cbx, "><target><candidate /></target>");
+    cprintf(cbx, "<default-operation>none</default-operation>");
+    if (restconf_edit_config(h, cbx, xt, xret) < 0)
+        goto done;
     retval = 0;
  done:
-    if (x_simple_patch)
-        xml_free(x_simple_patch);
-    if (patch_header)
-        cbuf_free(patch_header);
+    if (cbx)
+        cbuf_free(cbx);
     return retval;
 }
 
-/*! Process a single yang patch "edit" element
+/*! Send the plan so far without commit and start a new plan
  *
- * @param[in]  h         Clixon handle
- * @param[in]  req       Generic Www handle
- * @param[in]  pi        Offset, where to start api-path
- * @param[in]  qvec      Vector of query string (QUERY_STRING)
- * @param[in]  pretty    Set to 1 for pretty-printed xml/json output
- * @param[in]  media_out Output media
- * @param[in]  xn        XML edit element
- * @retval     0         OK
- * @retval    -1         Error
+ * @param[in]     h      Clixon handle
+ * @param[in]     yspec  Yang spec
+ * @param[in,out] xplan  Plan edit-config tree, replaced with an empty tree
+ * @param[in,out] ht     Plan index, replaced with an empty index
+ * @param[in]     ds     0 if "data" resource, 1 if rfc8527 "ds" resource
+ * @param[out]    xret   Reply if retval is 0, free with xml_free
+ * @retval        1      OK
+ * @retval        0      Edit-config failed, see xret
+ * @retval       -1      Error
  */
 static int
-yang_patch_do_edit(clixon_handle  h,
-                   void          *req,
-                   int            pi,
-                   cvec          *qvec,
-                   int            pretty,
-                   restconf_media media_out,
-                   ietf_ds_t      ds,
-                   yang_stmt     *yspec,
-                   cxobj         *xn,
-                   char          *uripath0,
-                   char          *api_path
-                   )
+yang_patch_flush(clixon_handle   h,
+                 yang_stmt      *yspec,
+                 cxobj         **xplan,
+                 clicon_hash_t **ht,
+                 ietf_ds_t       ds,
+                 cxobj         **xret)
 {
-    int        retval = -1;
-    cxobj    **vec = NULL;
-    size_t     veclen = 0;
-    int        ret;
-    cxobj     *xerr = NULL;    /* malloced must be freed */
-    cxobj     *xtop; 
-    cxobj     *xbot = NULL;
-    yang_patch_op_t operation;
-    char      *where_val = NULL;
-    char      *point_val = NULL;
-    char      *target_val = NULL;
-    char      *modname;
-    cxobj    **key_vec = NULL;
-    cxobj     *key_xn = NULL;
-    int        i;
-    cxobj     *x; /* general purpose xml-tree pointer */
-    cbuf      *simple_patch_request_uri = NULL;
-    cbuf      *api_path_target = NULL;
-    yang_stmt *ybot = NULL;
-    yang_stmt *ymod;
+    int    retval = -1;
+    cxobj *xr = NULL;
 
-    clixon_debug_xml(CLIXON_DBG_RESTCONF, xn, "%d xn:", __LINE__);
-    /* Create cbufs:s */
-    if ((simple_patch_request_uri = cbuf_new()) == NULL){
-        clixon_err(OE_UNIX, errno, "cbuf_new");
-        goto done;
-    }
-    if ((api_path_target = cbuf_new()) == NULL){
-        clixon_err(OE_UNIX, errno, "cbuf_new");
+    if (xml_child_nr_type(*xplan, CX_ELMNT) == 0)
+        goto ok;
+    if (yang_patch_send(h, yspec, *xplan, 0, ds, &xr) < 0)
         goto done;
-    }
-    if ((x = xpath_first(xn, NULL, "target")) == NULL){
-        clixon_err(OE_YANG, 0, "target mandatory element not found");
+    if (xpath_first(xr, NULL, "//rpc-error") != NULL){
+        *xret = xr;
+        xr = NULL;
+        retval = 0;
         goto done;
     }
-    target_val = xml_body(x);
-    if ((x = xpath_first(xn, NULL, "operation")) == NULL){
-        clixon_err(OE_YANG, 0, "operation mandatory element not found");
+    xml_free(*xplan);
+    if ((*xplan = xml_new(NETCONF_INPUT_CONFIG, NULL, CX_ELMNT)) == NULL)
         goto done;
-    }
-    operation = yang_patch_op2int(xml_body(x));
-    /* target and operation are mandatory */
-    if (target_val == NULL){
-        clixon_err(OE_YANG, 0, "operation/target: mandatory element not found");
+    clicon_hash_free(*ht);
+    if ((*ht = clicon_hash_init()) == NULL)
         goto done;
-    }
-    if (operation == YANG_PATCH_OP_INSERT){
-        if ((x = xpath_first(xn, NULL, "point")) != NULL)
-            point_val = xml_body(x);
-        if ((x = xpath_first(xn, NULL, "where")) != NULL)
-            where_val = xml_body(x);
-        if (point_val == NULL || where_val == NULL){
-            clixon_err(OE_YANG, 0, "point/where: expected element not found");
-            goto done;
-        }
-    }
-    // Construct request URI
-    cprintf(simple_patch_request_uri, "%s", uripath0);
-    cprintf(api_path_target, "%s", api_path);
-    if (operation == YANG_PATCH_OP_MERGE) {
-        cbuf_append_str(api_path_target, target_val);
-        cbuf_append_str(simple_patch_request_uri, target_val);
-    }
+ ok:
+    retval = 1;
+ done:
+    if (xr)
+        xml_free(xr);
+    return retval;
+}
 
-    if ((xtop = xml_new(NETCONF_INPUT_CONFIG, NULL, CX_ELMNT)) == NULL)
-        goto done;
+/*! Find the edit of a failed patch by applying its edits one by one
+ *
+ * Candidate is discarded before and after. If no single edit fails, the error was in the
+ * commit, such as a validation error, and is not related to a specific edit.
+ * @param[in]  h       Clixon handle
+ * @param[in]  yspec   Yang spec
+ * @param[in]  api_path Api-path of the target resource of the patch, or NULL
+ * @param[in]  vec     Edit elements
+ * @param[in]  veclen  Number of edits applied when patch failed
+ * @param[in]  ds      0 if "data" resource, 1 if rfc8527 "ds" resource
+ * @param[out] editidp Edit-id of failed edit, or NULL
+ * @param[out] xerrp   Error of failed edit, or NULL, free with xml_free
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+yang_patch_replay(clixon_handle h,
+                  yang_stmt    *yspec,
+                  char         *api_path,
+                  cxobj       **vec,
+                  size_t        veclen,
+                  ietf_ds_t     ds,
+                  char        **editidp,
+                  cxobj       **xerrp)
+{
+    int    retval = -1;
+    cxobj *xt = NULL;
+    cxobj *xtarget;
+    cxobj *xret = NULL;
+    int    i;
+    int    ret;
 
-    // Get key field
-    /* Translate api_path to xml in the form of xtop/xbot */
-    xbot = xtop;
-    if ((ret = api_path2xml(cbuf_get(api_path_target), yspec, xtop, YC_DATANODE, 1, &xbot, &ybot, &xerr)) < 0)
+    if (clicon_rpc_discard_changes(h) < 0)
         goto done;
-    if (ret == 0){ /* validation failed */
-        if (api_return_err0(h, req, xerr, pretty, media_out, 0) < 0)
+    for (i=0; i<veclen; i++){
+        if ((ret = yang_patch_compile(h, yspec, api_path, vec[i], &xt, &xtarget, &xret)) < 0)
             goto done;
-        goto ok;
-    }
-    /* Get module name */
-    if (ys_real_module(ybot, &ymod) < 0)
-        goto done;
-    modname = yang_argument_get(ymod);
-    // XXX this seems to be hardcoded to a yang list?
-    if ((key_vec = xml_childvec_get(xbot)) != NULL)
-        key_xn = key_vec[0];
-    // Get values (for "delete" and "remove", there are no values)
-    xpath_vec(xn, NULL, "value", &vec, &veclen);
-
-    // Loop through the values
-    for (i = 0; i < veclen; i++) {
-        if (yang_patch_do_value(h, req, pi, qvec, pretty, media_out, ds,
-                                vec[i], modname,
-                                operation, where_val, point_val, simple_patch_request_uri, target_val,
-                                api_path, key_xn) < 0)
-            goto done;
-    }
-    if (operation == YANG_PATCH_OP_DELETE ||
-        operation == YANG_PATCH_OP_REMOVE){
-        cbuf_append_str(simple_patch_request_uri, target_val);
-        if (operation == YANG_PATCH_OP_DELETE) {
-            // TODO - send error
-        } else {
-            // TODO - do not send error
+        if (ret == 1){
+            if (yang_patch_send(h, yspec, xt, 0, ds, &xret) < 0)
+                goto done;
+            xml_free(xt);
+            xt = NULL;
+        }
+        if (xpath_first(xret, NULL, "//rpc-error") != NULL){
+            *editidp = xml_find_body(vec[i], "edit-id");
+            *xerrp = xret;
+            xret = NULL;
+            break;
         }
-        api_data_delete(h, req, cbuf_get(simple_patch_request_uri), pi, pretty, YANG_DATA_JSON, ds);
+        xml_free(xret);
+        xret = NULL;
     }
- ok:
+    if (clicon_rpc_discard_changes(h) < 0)
+        goto done;
     retval = 0;
  done:
-    if (vec)
-        free(vec);
-    if (simple_patch_request_uri)
-        cbuf_free(simple_patch_request_uri);
-    if (api_path_target)
-        cbuf_free(api_path_target);
-    if (xtop)
-        xml_free(xtop);
-    if (xerr)
-        xml_free(xerr);
+    if (xt)
+        xml_free(xt);
+    if (xret)
+        xml_free(xret);
     return retval;
 }
 
@@ -749,11 +850,14 @@ yang_patch_do_edit(clixon_handle  h,
  * @param[in]  ds       0 if "data" resource, 1 if rfc8527 "ds" resource
  * @retval     0         OK
  * @retval    -1         Error
- * Netconf:  <edit-config> (nc:operation="merge")
+ * Netconf:  <edit-config> of candidate, committed after last edit
  * @see RFC8072
  * YANG patch can be used to "create", "delete", "insert", "merge", "move", "replace", and/or
    "remove" a resource within the target resource.
- * Currently "move" not supported
+ * The edits are compiled into a plan of as few edit-config trees as possible: a new tree is
+ * only started when an edit conflicts with the current tree, or before a move which reads
+ * the current candidate. All but the last tree are sent without commit, the last with
+ * autocommit. If the patch fails, it is replayed edit by edit to report the failed edit.
  */
 int
 api_data_yang_patch(clixon_handle  h,
@@ -774,9 +878,17 @@ api_data_yang_patch(clixon_handle  h,
     char          *api_path;
     cxobj         *xerr = NULL;    /* malloced must be freed */
     int            ret;
-    char          *uripath0 = NULL;
     size_t         veclen;
     cxobj        **vec = NULL;
+    char          *patchid;
+    char          *editid = NULL;
+    cxobj         *xplan = NULL;
+    clicon_hash_t *ht = NULL;
+    cxobj         *xt = NULL;
+    cxobj         *xtarget;
+    cxobj         *xret = NULL;
+    char          *opstr;
+    int            sent = 0;
 
     clixon_debug(CLIXON_DBG_RESTCONF, "api_path:\"%s\"", api_path0);
     if ((yspec = clicon_dbspec_yang(h)) == NULL){
@@ -829,25 +941,66 @@ api_data_yang_patch(clixon_handle  h,
             goto done;
         goto ok;
     }
-    /* Save original uripath (will be changed by sub-calls) */
-    if ((uripath0 = restconf_uripath(h)) == NULL)
-        goto done;
-    /* Find all edit operations and loop over them
-     */
+    patchid = xml_find_body(xml_child_i_type(xpatch, 0, CX_ELMNT), "patch-id");
     if (xpath_vec(xpatch, NULL, "yang-patch/edit", &vec, &veclen) < 0)
         goto done;
+    if ((xplan = xml_new(NETCONF_INPUT_CONFIG, NULL, CX_ELMNT)) == NULL)
+        goto done;
+    if ((ht = clicon_hash_init()) == NULL)
+        goto done;
     for (i = 0; i < veclen; i++) {
-        if (yang_patch_do_edit(h, req, pi, qvec, pretty, media_out, ds,
-                               yspec,
-                               vec[i],
-                               uripath0, api_path) < 0)
+        /* A move reads the target from candidate, which must include earlier edits */
+        if ((opstr = xml_find_body(vec[i], "operation")) != NULL &&
+            yang_patch_op2int(opstr) == YANG_PATCH_OP_MOVE){
+            if ((ret = yang_patch_flush(h, yspec, &xplan, &ht, ds, &xret)) < 0)
+                goto done;
+            sent++;
+            if (ret == 0)
+                goto failed;
+        }
+        if ((ret = yang_patch_compile(h, yspec, api_path, vec[i], &xt, &xtarget, &xerr)) < 0)
+            goto done;
+        if (ret == 0){
+            editid = xml_find_body(vec[i], "edit-id");
+            if (sent && clicon_rpc_discard_changes(h) < 0)
+                goto done;
+            if (yang_patch_status(h, req, patchid, editid, xerr, pretty, media_out) < 0)
+                goto done;
+            goto ok;
+        }
+        if ((ret = yang_patch_plan_add(xplan, ht, xtarget, 1)) < 0)
             goto done;
+        if (ret == 0){ /* Conflict with plan: send it and start a new */
+            if ((ret = yang_patch_flush(h, yspec, &xplan, &ht, ds, &xret)) < 0)
+                goto done;
+            sent++;
+            if (ret == 0)
+                goto failed;
+        }
+        if (yang_patch_plan_add(xplan, ht, xtarget, 0) < 0)
+            goto done;
+        xml_free(xt);
+        xt = NULL;
+    }
+    if (xml_child_nr_type(xplan, CX_ELMNT) != 0){
+        if (yang_patch_send(h, yspec, xplan, 1, ds, &xret) < 0)
+            goto done;
+        if (xpath_first(xret, NULL, "//rpc-error") != NULL)
+            goto failed;
     }
+    if (yang_patch_status(h, req, patchid, NULL, NULL, pretty, media_out) < 0)
+        goto done;
  ok:
     retval = 0;
  done:
-    if (uripath0)
-        free(uripath0);
+    if (xt)
+        xml_free(xt);
+    if (xret)
+        xml_free(xret);
+    if (xplan)
+        xml_free(xplan);
+    if (ht)
+        clicon_hash_free(ht);
     if (vec)
         free(vec);
     if (xerr)
@@ -855,6 +1008,12 @@ api_data_yang_patch(clixon_handle  h,
     if (xpatch)
         xml_free(xpatch);
     return retval;
+ failed: /* Edits 0..i-1 were sent when the plan failed */
+    if (yang_patch_replay(h, yspec, api_path, vec, i, ds, &editid, &xerr) < 0)
+        goto done;
+    if (yang_patch_status(h, req, patchid, editid, xerr?xerr:xret, pretty, media_out) < 0)
+        goto done;
+    goto ok;
 }
 
 #else // CLIXON_YANG_PATCH
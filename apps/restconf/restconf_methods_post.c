@@ -366,11 +366,8 @@ api_data_post(clixon_handle h,
             CLIXON_LIB_PREFIX, CLIXON_LIB_PREFIX, CLIXON_LIB_NS);
     cprintf(cbx, "><target><candidate /></target>");
     cprintf(cbx, "<default-operation>none</default-operation>");
-    if (clixon_xml2cbuf(cbx, xtop, 0, 0, NULL, -1, 0) < 0)
-        goto done;
-    cprintf(cbx, "</edit-config></rpc>");
     clixon_debug(CLIXON_DBG_RESTCONF, "xml: %s api_path:%s", cbuf_get(cbx), api_path);
-    if (clicon_rpc_netconf(h, cbuf_get(cbx), &xret, NULL) < 0)
+    if (restconf_edit_config(h, cbx, xtop, &xret) < 0)
         goto done;
     if ((xe = xpath_first(xret, NULL, "//rpc-error")) != NULL){
         if (api_return_err(h, req, xe, pretty, media_out, 0) < 0)
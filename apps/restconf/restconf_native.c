@@ -41,12 +41,18 @@
 #include <stdio.h>
 #include <unistd.h>
 #include <string.h>
+#include <inttypes.h>
 #include <syslog.h>
 #include <pwd.h>
 #include <ctype.h>
 #include <signal.h>
 #include <sys/stat.h>
 #include <sys/socket.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#ifdef HAVE_SYS_SENDFILE_H
+#include <sys/sendfile.h>
+#endif
 #include <arpa/inet.h>
 #include <sys/resource.h>
 
@@ -57,6 +63,9 @@
 #ifdef HAVE_LIBNGHTTP2
 #include <nghttp2/nghttp2.h>
 #endif
+#ifdef HAVE_LIBZ
+#include <zlib.h>
+#endif
 
 /* cligen */
 #include <cligen/cligen.h>
@@ -67,6 +76,7 @@
 /* restconf */
 #include "restconf_lib.h"       /* generic shared with plugins */
 #include "restconf_handle.h"
+#include "restconf_api.h"
 #include "restconf_err.h"
 #include "restconf_native.h"    /* Restconf-openssl mode specific headers*/
 #ifdef HAVE_LIBNGHTTP2
@@ -78,8 +88,20 @@
 #endif
 #include "restconf_stream.h"
 
+/* Output chunk size of reply compression */
+#define RESTCONF_COMPRESS_CHUNK 65536
+
+/* Coalesced HTTP/1 output of pipelined replies is written at this size */
+#define RESTCONF_HTTP1_COALESCE 16384
+
+/* Max size of an incomplete HTTP/1 request header before it is parsed as an error */
+#define RESTCONF_HTTP1_HEADER_MAX 65536
+
 /* Forward */
 static int restconf_idle_cb(int fd, void *arg);
+#ifdef HAVE_HTTP1
+static int restconf_http1_resume(int fd, void *arg);
+#endif
 
 /*! Create restconf stream
  *
@@ -99,6 +121,8 @@ restconf_stream_data_new(restconf_conn *rc,
     memset(sd, 0, sizeof(restconf_stream_data));
     sd->sd_stream_id = stream_id;
     sd->sd_fd = -1;
+    sd->sd_file_fd = -1;
+    sd->sd_prod_s = -1;
     if ((sd->sd_inbuf = cbuf_new()) == NULL){
         clixon_err(OE_UNIX, errno, "cbuf_new");
         goto done;
@@ -156,6 +180,11 @@ restconf_stream_free(restconf_stream_data *sd)
     if (sd->sd_fd != -1) {
         close(sd->sd_fd);
     }
+    if (sd->sd_file_fd != -1)
+        close(sd->sd_file_fd);
+#ifdef HAVE_LIBNGHTTP2
+    http2_producer_close(sd);
+#endif
     if (sd->sd_inbuf)
         cbuf_free(sd->sd_inbuf);
     if (sd->sd_indata)
@@ -176,6 +205,102 @@ restconf_stream_free(restconf_stream_data *sd)
     return 0;
 }
 
+/*! Refill token bucket according to time elapsed since last refill
+ *
+ * @param[in]  rn   Restconf native handle
+ * @param[in]  rb   Token bucket
+ * @param[in]  now  Current time
+ */
+static void
+restconf_bucket_refill(restconf_native_handle *rn,
+                       restconf_bucket        *rb,
+                       struct timeval         *now)
+{
+    struct timeval td;
+
+    timersub(now, &rb->rb_t, &td);
+    rb->rb_tokens += (td.tv_sec + td.tv_usec/1000000.0) * rn->rn_rate;
+    if (rb->rb_tokens > rn->rn_burst)
+        rb->rb_tokens = rn->rn_burst;
+    rb->rb_t = *now;
+}
+
+/*! Find or create token bucket of a client address
+ *
+ * Buckets without connections that are full again are removed
+ * @param[in]  rn    Restconf native handle
+ * @param[in]  addr  Client address as string
+ * @retval     rb    Token bucket, reference counted
+ * @retval     NULL  Error
+ */
+static restconf_bucket *
+restconf_bucket_get(restconf_native_handle *rn,
+                    const char             *addr)
+{
+    restconf_bucket *rb;
+    restconf_bucket *rb1 = NULL;
+    struct timeval   now;
+    int              i;
+    int              len;
+
+    gettimeofday(&now, NULL);
+    len = 0;
+    if ((rb = rn->rn_buckets) != NULL)
+        do {
+            len++;
+            rb = NEXTQ(restconf_bucket *, rb);
+        } while (rb != rn->rn_buckets);
+    rb = rn->rn_buckets;
+    for (i=0; i<len; i++){
+        rb1 = NEXTQ(restconf_bucket *, rb);
+        if (strcmp(rb->rb_addr, addr) == 0){
+            restconf_bucket_refill(rn, rb, &now);
+            rb->rb_refs++;
+            return rb;
+        }
+        if (rb->rb_refs == 0){
+            restconf_bucket_refill(rn, rb, &now);
+            if (rb->rb_tokens >= rn->rn_burst){
+                DELQ(rb, rn->rn_buckets, restconf_bucket *);
+                free(rb->rb_addr);
+                free(rb);
+            }
+        }
+        rb = rb1;
+    }
+    if ((rb = malloc(sizeof(*rb))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        return NULL;
+    }
+    memset(rb, 0, sizeof(*rb));
+    if ((rb->rb_addr = strdup(addr)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        free(rb);
+        return NULL;
+    }
+    rb->rb_tokens = rn->rn_burst;
+    rb->rb_t = now;
+    rb->rb_refs = 1;
+    INSQ(rb, rn->rn_buckets);
+    return rb;
+}
+
+/*! Free all token buckets
+ *
+ * @param[in]  rn    Restconf native handle
+ */
+void
+restconf_bucket_free_all(restconf_native_handle *rn)
+{
+    restconf_bucket *rb;
+
+    while ((rb = rn->rn_buckets) != NULL){
+        DELQ(rb, rn->rn_buckets, restconf_bucket *);
+        free(rb->rb_addr);
+        free(rb);
+    }
+}
+
 /*! Create restconf connection struct, per connect, ie transient
  *
  * @param[in] h     Clixon handle
@@ -188,7 +313,8 @@ restconf_conn_new(clixon_handle    h,
                   int              s,
                   restconf_socket *rsock)
 {
-    restconf_conn *rc;
+    restconf_conn          *rc;
+    restconf_native_handle *rn;
 
     if ((rc = (restconf_conn*)malloc(sizeof(restconf_conn))) == NULL){
         clixon_err(OE_UNIX, errno, "malloc");
@@ -199,6 +325,12 @@ restconf_conn_new(clixon_handle    h,
     rc->rc_s = s;
     rc->rc_callhome = rsock->rs_callhome;
     rc->rc_socket = rsock;
+    if (!rsock->rs_callhome && rsock->rs_from_addr &&
+        (rn = restconf_native_handle_get(h)) != NULL && rn->rn_rate)
+        if ((rc->rc_bucket = restconf_bucket_get(rn, rsock->rs_from_addr)) == NULL){
+            free(rc);
+            return NULL;
+        }
     INSQ(rc, rsock->rs_conns);
     clixon_debug(CLIXON_DBG_RESTCONF, "%p", rc);
     return rc;
@@ -231,6 +363,18 @@ restconf_conn_free(restconf_conn *rc)
         if (sd)
             restconf_stream_free(sd);
     }
+    if (rc->rc_inpend)
+        cbuf_free(rc->rc_inpend);
+    if (rc->rc_outbuf)
+        cbuf_free(rc->rc_outbuf);
+#ifdef HAVE_HTTP1
+    if (rc->rc_deferred)
+        clixon_event_unreg_timeout(restconf_http1_resume, rc);
+    if (rc->rc_h1scan)
+        http1_scan_free(rc->rc_h1scan);
+#endif
+    if (rc->rc_bucket)
+        rc->rc_bucket->rb_refs--;
     /* Free connect from server sock */
     if ((rsock = rc->rc_socket) != NULL &&
         (rc1 = rsock->rs_conns) != NULL){
@@ -380,6 +524,127 @@ restconf_connection_sanity(clixon_handle         h,
     return retval;
 }
 
+#ifdef HAVE_LIBZ
+/*! Compress a buffer with zlib in chunks
+ *
+ * @param[in]  in    Input buffer
+ * @param[in]  gzip  1: gzip format, 0: zlib format (http deflate)
+ * @param[out] cbout Compressed data, free with cbuf_free
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+native_deflate(cbuf  *in,
+               int    gzip,
+               cbuf **cbout)
+{
+    int           retval = -1;
+    z_stream      zs = {0,};
+    unsigned char chunk[RESTCONF_COMPRESS_CHUNK];
+    cbuf         *cb = NULL;
+    int           zret = Z_OK;
+    int           init = 0;
+
+    if (deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + (gzip?16:0),
+                     8, Z_DEFAULT_STRATEGY) != Z_OK){
+        clixon_err(OE_UNIX, 0, "deflateInit2: %s", zs.msg?zs.msg:"");
+        goto done;
+    }
+    init++;
+    if ((cb = cbuf_new_alloc(cbuf_len(in)/4 + 64)) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new_alloc");
+        goto done;
+    }
+    zs.next_in = (unsigned char*)cbuf_get(in);
+    zs.avail_in = cbuf_len(in);
+    while (zret != Z_STREAM_END){
+        zs.next_out = chunk;
+        zs.avail_out = sizeof(chunk);
+        if ((zret = deflate(&zs, Z_FINISH)) == Z_STREAM_ERROR){
+            clixon_err(OE_UNIX, 0, "deflate: %s", zs.msg?zs.msg:"");
+            goto done;
+        }
+        if (cbuf_append_buf(cb, chunk, sizeof(chunk) - zs.avail_out) < 0){
+            clixon_err(OE_UNIX, errno, "cbuf_append_buf");
+            goto done;
+        }
+    }
+    *cbout = cb;
+    cb = NULL;
+    retval = 0;
+ done:
+    if (init)
+        deflateEnd(&zs);
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+#endif /* HAVE_LIBZ */
+
+/*! Compress reply body if the client accepts it
+ *
+ * Applies to 200 replies with a body of at least CLICON_RESTCONF_COMPRESS bytes and
+ * without Content-Encoding, eg not to precompressed http-data files.
+ * gzip is preferred over deflate. HEAD replies are not compressed since the body
+ * is not kept.
+ * Call after the reply is made, but before request parameters are cleared.
+ * @param[in]  h     Clixon handle
+ * @param[in]  sd    Http stream with reply
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see RFC 7231 Sec 3.1.2.2 and 5.3.4
+ */
+int
+restconf_native_compress(clixon_handle         h,
+                         restconf_stream_data *sd)
+{
+    int       retval = -1;
+#ifdef HAVE_LIBZ
+    uint32_t  threshold;
+    char     *list;
+    int       gzip;
+    cbuf     *cbz = NULL;
+
+    if ((threshold = clicon_option_int(h, "CLICON_RESTCONF_COMPRESS")) == 0 ||
+        sd->sd_code != 200 ||
+        sd->sd_body == NULL ||
+        sd->sd_body_len < threshold ||
+        sd->sd_conn->rc_event_stream ||
+        cvec_find(sd->sd_outp_hdrs, "Content-Encoding") != NULL ||
+        (list = restconf_param_get(h, "HTTP_ACCEPT_ENCODING")) == NULL)
+        goto ok;
+    if (restconf_coding_in_list("gzip", list))
+        gzip = 1;
+    else if (restconf_coding_in_list("deflate", list))
+        gzip = 0;
+    else
+        goto ok;
+    if (native_deflate(sd->sd_body, gzip, &cbz) < 0)
+        goto done;
+    clixon_debug(CLIXON_DBG_RESTCONF, "%s %zu -> %zu", gzip?"gzip":"deflate",
+                 sd->sd_body_len, cbuf_len(cbz));
+    if (cbuf_len(cbz) >= sd->sd_body_len)
+        goto ok;
+    if (restconf_reply_header(sd, "Content-Encoding", "%s", gzip?"gzip":"deflate") < 0)
+        goto done;
+    if (restconf_reply_header(sd, "Vary", "Accept-Encoding") < 0)
+        goto done;
+    cbuf_free(sd->sd_body);
+    sd->sd_body = cbz;
+    sd->sd_body_len = cbuf_len(cbz);
+    sd->sd_body_offset = 0;
+    cbz = NULL;
+ ok:
+#endif /* HAVE_LIBZ */
+    retval = 0;
+#ifdef HAVE_LIBZ
+ done:
+    if (cbz)
+        cbuf_free(cbz);
+#endif
+    return retval;
+}
+
 /* Write buf to socket
  *
  * Only (at least mostly?) for HTTP/1
@@ -486,6 +751,114 @@ native_buf_write(clixon_handle    h,
     goto done;
 }
 
+
+/*! Write a file region reply body on a socket without copying it to a buffer
+ *
+ * Plain sockets use sendfile(2) where available. TLS sockets use SSL_sendfile if kernel
+ * TLS is enabled on the connection. Otherwise the region is mapped with mmap(2) and
+ * written as is.
+ * The file descriptor is closed when done.
+ * @param[in]  h    Clixon handle
+ * @param[in]  sd   Http stream with file body, see restconf_reply_send_file
+ * @param[in]  rc   Restconf connection
+ * @retval     1    OK
+ * @retval     0    OK, but socket write returned error, caller should close rc
+ * @retval    -1    Error
+ * @note The file is assumed not to be truncated while sent, mmap may otherwise signal
+ */
+int
+native_file_write(clixon_handle         h,
+                  restconf_stream_data *sd,
+                  restconf_conn        *rc)
+{
+    int     retval = -1;
+    off_t   offset;
+    size_t  totlen = 0;
+    ssize_t len;
+    void   *map = MAP_FAILED;
+    off_t   pgoff = 0;
+    int     ret;
+
+    if (sd->sd_file_fd == -1)
+        goto ok;
+    offset = sd->sd_file_offset;
+    clixon_debug(CLIXON_DBG_RESTCONF, "offset:%jd len:%zu ssl:%d",
+                 (intmax_t)offset, sd->sd_body_len, rc->rc_ssl?1:0);
+#ifdef HAVE_SYS_SENDFILE_H
+    if (rc->rc_ssl == NULL){
+        while (totlen < sd->sd_body_len){
+            if ((len = sendfile(rc->rc_s, sd->sd_file_fd, &offset, sd->sd_body_len-totlen)) < 0){
+                switch (errno){
+                case EAGAIN:     /* Operation would block */
+                    clixon_debug(CLIXON_DBG_RESTCONF, "sendfile EAGAIN");
+                    usleep(10000);
+                    continue;
+                    break;
+                case ECONNRESET: /* Connection reset by peer */
+                case EPIPE:   /* Broken pipe */
+                    goto closed; /* Close socket */
+                    break;
+                default:
+                    clixon_err(OE_UNIX, errno, "sendfile");
+                    goto done;
+                    break;
+                }
+            }
+            if (len == 0){ /* File truncated, Content-Length cannot be met */
+                clixon_err(OE_UNIX, 0, "sendfile: unexpected end of file");
+                goto closed;
+            }
+            totlen += len;
+        }
+        goto ok;
+    }
+#endif /* HAVE_SYS_SENDFILE_H */
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L && !defined(OPENSSL_NO_KTLS)
+    if (BIO_get_ktls_send(SSL_get_wbio(rc->rc_ssl))){
+        while (totlen < sd->sd_body_len){
+            if ((len = SSL_sendfile(rc->rc_ssl, sd->sd_file_fd, offset,
+                                    sd->sd_body_len-totlen, 0)) <= 0){
+                if (SSL_get_error(rc->rc_ssl, len) == SSL_ERROR_WANT_WRITE){
+                    clixon_debug(CLIXON_DBG_RESTCONF, "SSL_sendfile EAGAIN");
+                    usleep(10000);
+                    continue;
+                }
+                if (errno == ECONNRESET || errno == EPIPE)
+                    goto closed;
+                clixon_err(OE_SSL, 0, "SSL_sendfile");
+                goto done;
+            }
+            offset += len;
+            totlen += len;
+        }
+        goto ok;
+    }
+#endif
+    /* mmap offset must be page aligned */
+    pgoff = offset % sysconf(_SC_PAGESIZE);
+    if ((map = mmap(NULL, sd->sd_body_len + pgoff, PROT_READ, MAP_PRIVATE,
+                    sd->sd_file_fd, offset - pgoff)) == MAP_FAILED){
+        clixon_err(OE_UNIX, errno, "mmap");
+        goto done;
+    }
+    if ((ret = native_buf_write(h, (char*)map + pgoff, sd->sd_body_len, rc, __FUNCTION__)) < 0)
+        goto done;
+    if (ret == 0)
+        goto closed;
+ ok:
+    retval = 1;
+ done:
+    if (map != MAP_FAILED)
+        munmap(map, sd->sd_body_len + pgoff);
+    if (sd->sd_file_fd != -1){
+        close(sd->sd_file_fd);
+        sd->sd_file_fd = -1;
+    }
+    return retval;
+ closed:
+    retval = 0;
+    goto done;
+}
 /*! Send early handcoded bad request reply before actual packet received, just after accept
  *
  * @param[in]  h    Clixon handle
@@ -655,21 +1028,151 @@ read_regular(restconf_conn *rc,
 
 #ifdef HAVE_HTTP1
 
-/*! Restconf HTTP/1 processing after chunk of bytes read
+/*! Length of first HTTP/1 request in pipelined input
+ *
+ * The request is the header up to and including an empty line and a body of
+ * Content-Length bytes
+ * @param[in]  buf   Input starting with a request header
+ * @param[in]  len   Length of input
+ * @retval     n     Length of first request, or of input if body is incomplete
+ * @retval     0     Header is incomplete
+ */
+static size_t
+http1_request_len(const char *buf,
+                  size_t      len)
+{
+    size_t        i;
+    size_t        hlen = 0;
+    unsigned long clen = 0;
+
+    for (i=0; i+3<len; i++)
+        if (buf[i] == '\r' && buf[i+1] == '\n' && buf[i+2] == '\r' && buf[i+3] == '\n'){
+            hlen = i + 4;
+            break;
+        }
+    if (hlen == 0)
+        return 0;
+    for (i=0; i+15<hlen; i++)
+        if ((i == 0 || buf[i-1] == '\n') &&
+            strncasecmp(buf+i, "Content-Length:", 15) == 0){
+            clen = strtoul(buf+i+15, NULL, 10);
+            break;
+        }
+    if (clen >= len - hlen)
+        return len;
+    return hlen + clen;
+}
+
+/*! Check rate limit of an HTTP/1 request, and take a token if it is limited
+ *
+ * Only read requests (GET and HEAD) are limited. Writes and /restconf/operations
+ * are prioritized, ie always admitted
+ * @param[in]  rn   Restconf native handle
+ * @param[in]  rb   Token bucket of client
+ * @param[in]  buf  Request, starting with request line
+ * @param[in]  len  Length of request
+ * @param[out] t    Time when a token is available, if not admitted
+ * @retval     1    Admitted
+ * @retval     0    Not admitted, defer until t
+ * @see clixon-restconf.yang rate-limit
+ */
+static int
+http1_rate_admit(restconf_native_handle *rn,
+                 restconf_bucket        *rb,
+                 const char             *buf,
+                 size_t                  len,
+                 struct timeval         *t)
+{
+    struct timeval now;
+    struct timeval td;
+    double         wait;
+    size_t         i;
+
+    if (strncmp(buf, "GET ", len<4?len:4) != 0 && strncmp(buf, "HEAD ", len<5?len:5) != 0)
+        return 1;
+    /* Second path segment of request-target, eg /restconf/operations */
+    i = buf[0]=='G' ? 4 : 5;
+    if (i < len && buf[i] == '/')
+        for (i++; i < len && buf[i] != '/' && buf[i] != ' '; i++);
+    if (i + 11 <= len && strncmp(buf+i, "/operations", 11) == 0)
+        return 1;
+    gettimeofday(&now, NULL);
+    restconf_bucket_refill(rn, rb, &now);
+    if (rb->rb_tokens >= 1.0){
+        rb->rb_tokens -= 1.0;
+        return 1;
+    }
+    wait = (1.0 - rb->rb_tokens) / rn->rn_rate;
+    td.tv_sec = (time_t)wait;
+    td.tv_usec = (suseconds_t)((wait - td.tv_sec) * 1000000) + 1;
+    timeradd(&now, &td, t);
+    return 0;
+}
+
+/*! Pause reading and processing of an HTTP/1 connection until a later time
+ *
+ * Remaining input is processed by restconf_http1_resume
+ * @param[in]  rc    Restconf connection handle
+ * @param[in]  t     Time to resume
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+restconf_http1_defer(restconf_conn  *rc,
+                     struct timeval *t)
+{
+    clixon_debug(CLIXON_DBG_RESTCONF, "%d", rc->rc_s);
+    clixon_event_unreg_fd(rc->rc_s, restconf_connection);
+    if (clixon_event_reg_timeout(*t, restconf_http1_resume, rc, "restconf deferred request") < 0)
+        return -1;
+    rc->rc_deferred = 1;
+    return 0;
+}
+
+/*! Write coalesced HTTP/1 output of a connection
  *
+ * @param[in]  h     Clixon handle
+ * @param[in]  rc    Restconf connection handle
+ * @param[in]  sd    Http stream
+ * @retval     1     OK
+ * @retval     0     Socket write returned error, caller should close rc
+ * @retval    -1     Error
+ */
+static int
+http1_native_flush(clixon_handle         h,
+                   restconf_conn        *rc,
+                   restconf_stream_data *sd)
+{
+    int retval = 1;
+
+    if (cbuf_len(sd->sd_outp_buf)){
+        retval = native_buf_write(h, cbuf_get(sd->sd_outp_buf), cbuf_len(sd->sd_outp_buf),
+                                  rc, __FUNCTION__);
+        cbuf_reset(sd->sd_outp_buf);
+    }
+    return retval;
+}
+
+/*! Restconf HTTP/1 processing of one request, or of the part read so far
+ *
+ * The reply is appended to the output buffer, which is written when a reply is a file
+ * or an event stream, the connection is to be closed, or the buffer exceeds
+ * RESTCONF_HTTP1_COALESCE
  * @param[in]  rc           Restconf connection handle 
  * @param[in]  buf          Input buffer
  * @param[in]  n            Length of data in input buffer
  * @param[out] readmore     If set, read data again, do not continue processing
+ * @param[out] replied      Set if request was complete and replied
  * @retval     1            OK
  * @retval     0            Socket closed, quit
  * @retval    -1            Error
  */
 static int
-restconf_http1_process(restconf_conn *rc,
+restconf_http1_request(restconf_conn *rc,
                        char          *buf,
                        size_t         n,
-                       int           *readmore)
+                       int           *readmore,
+                       int           *replied)
 {
     int                   retval = -1;
     restconf_stream_data *sd;
@@ -707,13 +1210,21 @@ restconf_http1_process(restconf_conn *rc,
         /* multi-buffer for multiple reads 
          * This is different from sd_indata that it is before and includes headers
          */
-        if (cbuf_append_buf(sd->sd_inbuf, buf, n) < 0){
-            clixon_err(OE_UNIX, errno, "cbuf_append");
-            goto done;
+        if (rc->rc_h1scan)
+            ret = http1_scan_request(h, rc, buf, n);
+        else {
+            if (cbuf_append_buf(sd->sd_inbuf, buf, n) < 0){
+                clixon_err(OE_UNIX, errno, "cbuf_append");
+                goto done;
+            }
+            ret = clixon_http1_parse_string(h, rc, cbuf_get(sd->sd_inbuf));
         }
-        if (clixon_http1_parse_string(h, rc, cbuf_get(sd->sd_inbuf)) < 0){
-            /* XXX This does not work for SSL */
-            if (rc->rc_ssl){
+        if (ret < 0){
+            /* The scanner fails on malformed input only, it waits for the whole header
+             * XXX This does not work for SSL */
+            if (rc->rc_h1scan)
+                ret = 0;
+            else if (rc->rc_ssl){
                 ret = SSL_pending(rc->rc_ssl);
             }
             else if ((ret = clixon_event_poll(rc->rc_s)) < 0)
@@ -732,7 +1243,11 @@ restconf_http1_process(restconf_conn *rc,
                 goto done;
             }
             cprintf(cberr, "<errors xmlns=\"urn:ietf:params:xml:ns:yang:ietf-restconf\"><error><error-type>protocol</error-type><error-tag>malformed-message</error-tag><error-message>%s</error-message></error></errors>", clixon_err_reason());
-            if ((ret = native_send_badrequest(h, "application/yang-data+xml", cbuf_get(cberr), rc)) < 0)
+            /* Replies to earlier pipelined requests first */
+            if ((ret = http1_native_flush(h, rc, sd)) < 0)
+                goto done;
+            if (ret == 1 &&
+                (ret = native_send_badrequest(h, "application/yang-data+xml", cbuf_get(cberr), rc)) < 0)
                 goto done;
             if (http1_native_clear_input(h, sd) < 0)
                 goto done;
@@ -747,11 +1262,10 @@ restconf_http1_process(restconf_conn *rc,
         if ((ret = http1_check_expect(h, rc, sd)) < 0)
             goto done;
         if (ret == 1){
-            if ((ret = native_buf_write(h, cbuf_get(sd->sd_outp_buf), cbuf_len(sd->sd_outp_buf),
-                                        rc, __FUNCTION__)) < 0)
-                goto done;
+            ret = http1_native_flush(h, rc, sd);
             cvec_reset(sd->sd_outp_hdrs);
-            cbuf_reset(sd->sd_outp_buf);
+            if (ret < 0)
+                goto done;
             if (ret == 0){
                 if (restconf_close_ssl_socket(rc, __FUNCTION__, 0) < 0)
                     goto done;
@@ -781,11 +1295,18 @@ restconf_http1_process(restconf_conn *rc,
     /* main restconf processing */
     if (restconf_http1_path_root(h, rc) < 0)
         goto done;
-    if ((ret = native_buf_write(h, cbuf_get(sd->sd_outp_buf), cbuf_len(sd->sd_outp_buf),
-                                rc, __FUNCTION__)) < 0)
-        goto done;
+    (*replied)++;
+    ret = 1;
+    /* Coalesce replies of pipelined requests */
+    if (sd->sd_file_fd != -1 || rc->rc_event_stream || rc->rc_exit || sd->sd_upgrade2 ||
+        cbuf_len(sd->sd_outp_buf) >= RESTCONF_HTTP1_COALESCE){
+        if ((ret = http1_native_flush(h, rc, sd)) < 0)
+            goto done;
+        if (ret == 1 &&
+            (ret = native_file_write(h, sd, rc)) < 0)
+            goto done;
+    }
     cvec_reset(sd->sd_outp_hdrs); /* Can be done in native_send_reply */
-    cbuf_reset(sd->sd_outp_buf);
     cbuf_reset(sd->sd_inbuf);
     cbuf_reset(sd->sd_indata);
     if (sd->sd_body)
@@ -809,6 +1330,144 @@ restconf_http1_process(restconf_conn *rc,
     retval = 0;
     goto done;
 }
+
+/*! Restconf HTTP/1 processing after chunk of bytes read
+ *
+ * Input is kept per connection and split into requests, so that several pipelined
+ * requests in one read are processed in order. Their replies are written together
+ * when no complete request remains.
+ * @param[in]  rc           Restconf connection handle 
+ * @param[in]  buf          Input buffer
+ * @param[in]  n            Length of data in input buffer
+ * @param[out] readmore     If set, read data again, do not continue processing
+ * @retval     1            OK
+ * @retval     0            Socket closed, quit
+ * @retval    -1            Error
+ */
+static int
+restconf_http1_process(restconf_conn *rc,
+                       char          *buf,
+                       size_t         n,
+                       int           *readmore)
+{
+    int                   retval = -1;
+    restconf_stream_data *sd;
+    clixon_handle         h;
+    cbuf                 *cbin;
+    size_t                len;
+    size_t                rest;
+    unsigned long         clen;
+    char                 *str;
+    int                   status;
+    int                   replied;
+    int                   nr = 0;
+    int                   ret;
+    restconf_native_handle *rn;
+    struct timeval        t;
+
+    h = rc->rc_h;
+    if ((sd = restconf_stream_find(rc, 0)) == NULL){
+        clixon_err(OE_RESTCONF, EINVAL, "restconf stream not found");
+        goto done;
+    }
+    if ((rn = restconf_native_handle_get(h)) == NULL){
+        clixon_err(OE_RESTCONF, EFAULT, "No restconf native handle");
+        goto done;
+    }
+    if ((cbin = rc->rc_inpend) == NULL &&
+        (cbin = rc->rc_inpend = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if (n && cbuf_append_buf(cbin, buf, n) < 0){
+        clixon_err(OE_UNIX, errno, "cbuf_append_buf");
+        goto done;
+    }
+    if (rn->rn_http1_parser == XML_PARSER_FAST && rc->rc_h1scan == NULL){
+        if ((rc->rc_h1scan = calloc(1, sizeof(http1_scan))) == NULL){
+            clixon_err(OE_UNIX, errno, "calloc");
+            goto done;
+        }
+    }
+    while (cbuf_len(cbin) && !rc->rc_deferred){
+        if (http1_check_content_length(h, sd, &status) < 0)
+            goto done;
+        if (status == 1){ /* Rest of body of current request */
+            len = cbuf_len(cbin);
+            if ((str = restconf_param_get(h, "HTTP_CONTENT_LENGTH")) != NULL &&
+                (clen = strtoul(str, NULL, 10)) > cbuf_len(sd->sd_indata) &&
+                clen - cbuf_len(sd->sd_indata) < len)
+                len = clen - cbuf_len(sd->sd_indata);
+        }
+        else if (rc->rc_h1scan){
+            /* Only lines not scanned in earlier reads are scanned */
+            if ((ret = http1_scan_header(rc->rc_h1scan, cbuf_get(cbin), cbuf_len(cbin))) < 0)
+                len = cbuf_len(cbin); /* Malformed, replied with error as request */
+            else if (ret == 0){
+                if (cbuf_len(cbin) < RESTCONF_HTTP1_HEADER_MAX)
+                    break;
+                len = cbuf_len(cbin);
+            }
+            else if ((clen = rc->rc_h1scan->hs_clen) >= cbuf_len(cbin) - rc->rc_h1scan->hs_hlen)
+                len = cbuf_len(cbin);
+            else
+                len = rc->rc_h1scan->hs_hlen + clen;
+        }
+        else if ((len = http1_request_len(cbuf_get(cbin), cbuf_len(cbin))) == 0){
+            /* Header incomplete: wait for more, unless unreasonably long */
+            if (cbuf_len(cbin) < RESTCONF_HTTP1_HEADER_MAX)
+                break;
+            len = cbuf_len(cbin);
+        }
+        /* Scheduling of a new request: let other connections in, or rate limit */
+        if (status != 1){
+            if (rn->rn_pipeline_depth && nr >= rn->rn_pipeline_depth){
+                gettimeofday(&t, NULL);
+                if (restconf_http1_defer(rc, &t) < 0)
+                    goto done;
+                break;
+            }
+            if (rc->rc_bucket &&
+                http1_rate_admit(rn, rc->rc_bucket, cbuf_get(cbin), len, &t) == 0){
+                if (restconf_http1_defer(rc, &t) < 0)
+                    goto done;
+                break;
+            }
+        }
+        replied = 0;
+        if ((ret = restconf_http1_request(rc, cbuf_get(cbin), len, readmore, &replied)) < 0)
+            goto done;
+        if (ret == 0)
+            goto closed;
+        /* Remove processed request from input */
+        rest = cbuf_len(cbin) - len;
+        memmove(cbuf_get(cbin), cbuf_get(cbin) + len, rest);
+        cbuf_trunc(cbin, rest);
+        if (!replied || *readmore || sd->sd_upgrade2)
+            break;
+        nr++;
+        *readmore = 0;
+    }
+    if ((ret = http1_native_flush(h, rc, sd)) < 0)
+        goto done;
+    if (ret == 1 &&
+        (ret = native_file_write(h, sd, rc)) < 0)
+        goto done;
+    if (ret == 0){
+        if (restconf_close_ssl_socket(rc, __FUNCTION__, 0) < 0)
+            goto done;
+        goto closed;
+    }
+    /* TLS may have buffered more requests than the socket signals */
+    if (*readmore == 0 && !rc->rc_deferred && rc->rc_ssl && SSL_pending(rc->rc_ssl) > 0)
+        (*readmore)++;
+    retval = 1;
+ done:
+    return retval;
+ closed:
+    retval = 0;
+    goto done;
+}
 #endif
 
 #ifdef HAVE_LIBNGHTTP2
@@ -944,6 +1603,49 @@ restconf_native_handle_get(clixon_handle h)
 
 /*---------------------------- Connect ---------------------------------*/
 
+#ifdef HAVE_HTTP1
+/*! Resume a deferred HTTP/1 connection: process remaining input and read again
+ *
+ * @param[in]  fd   Not used
+ * @param[in]  arg  Restconf connection handle
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see restconf_http1_defer
+ */
+static int
+restconf_http1_resume(int   fd,
+                      void *arg)
+{
+    int            retval = -1;
+    restconf_conn *rc = (restconf_conn *)arg;
+    int            readmore = 0;
+    int            ret;
+
+    clixon_debug(CLIXON_DBG_RESTCONF, "%d", rc->rc_s);
+    rc->rc_deferred = 0;
+    if (clixon_event_reg_fd(rc->rc_s, restconf_connection, (void*)rc, "restconf client socket") < 0)
+        goto done;
+    if ((ret = restconf_http1_process(rc, NULL, 0, &readmore)) < 0)
+        goto done;
+    if (ret == 0) /* closed */
+        goto ok;
+    gettimeofday(&rc->rc_t, NULL); /* activity timer */
+    if (readmore){
+        if (restconf_connection(rc->rc_s, rc) < 0)
+            goto done;
+        goto ok;
+    }
+#ifdef HAVE_LIBNGHTTP2
+    if (restconf_http2_upgrade(rc) < 0)
+        goto done;
+#endif
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+#endif /* HAVE_HTTP1 */
+
 /*! New data connection after accept, receive and reply on data socket
  *
  * @param[in]   s    Socket where message arrived. read from this.
@@ -1255,6 +1957,9 @@ restconf_ssl_accept_client(clixon_handle    h,
     const unsigned char    *alpn = NULL;
     unsigned int            alpnlen = 0;
     restconf_http_proto     proto = HTTP_11;  /* Non-SSL negotiation NYI */
+    struct timeval          t0;
+    struct timeval          t1;
+    uint64_t                us;
 
     clixon_debug(CLIXON_DBG_RESTCONF, "");
 #ifdef HAVE_LIBNGHTTP2
@@ -1307,6 +2012,7 @@ restconf_ssl_accept_client(clixon_handle    h,
             clixon_err(OE_SSL, 0, "SSL_set_fd");
             goto done;
         }
+        gettimeofday(&t0, NULL);
         readmore = 1;
         while (readmore){
             readmore = 0;
@@ -1370,6 +2076,17 @@ restconf_ssl_accept_client(clixon_handle    h,
                 }
             } /* SSL_accept */
         } /* while(readmore) */
+        /* Handshake counters, resumed handshakes skip cert verification */
+        gettimeofday(&t1, NULL);
+        timersub(&t1, &t0, &t1);
+        us = (uint64_t)t1.tv_sec*1000000 + t1.tv_usec;
+        rn->rn_handshakes++;
+        rn->rn_handshake_us += us;
+        if (SSL_session_reused(rc->rc_ssl))
+            rn->rn_resumed++;
+        clixon_debug(CLIXON_DBG_RESTCONF, "%s handshake %" PRIu64 "us, resumed %" PRIu64 " of %" PRIu64,
+                     SSL_session_reused(rc->rc_ssl)?"resumed":"full", us,
+                     rn->rn_resumed, rn->rn_handshakes);
         /* Sets data and len to point to the client's requested protocol for this connection. */
 #ifndef OPENSSL_NO_NEXTPROTONEG
         SSL_get0_next_proto_negotiated(rc->rc_ssl, &alpn, &alpnlen);
@@ -1578,8 +2295,198 @@ restconf_idle_timer(restconf_conn *rc)
     return retval;
 }
     
+/* Call home destination
+ * @see clixon-restconf.yang call-home/endpoint
+ */
+struct restconf_dest {
+    struct sockaddr_in6 rd_sin6; /* Address, sin6 because it is larger than sin and sa */
+    size_t              rd_len;  /* Length of address */
+    int                 rd_s;    /* Socket of connect in progress, or -1 */
+};
+
+static int restconf_callhome_dial(restconf_socket *rsock);
+static int restconf_callhome_next(int fd, void *arg);
+static int restconf_callhome_connected(int fd, void *arg);
+
+/*! Close connects in progress of a callhome attempt
+ *
+ * @param[in]  rsock  restconf_socket
+ */
+static void
+restconf_callhome_cancel(restconf_socket *rsock)
+{
+    struct restconf_dest *rd;
+    int                   i;
+
+    clixon_event_unreg_timeout(restconf_callhome_next, rsock);
+    for (i=0; i<rsock->rs_ndests; i++){
+        rd = &rsock->rs_dests[i];
+        if (rd->rd_s == -1)
+            continue;
+        clixon_event_unreg_fd_write(rd->rd_s, restconf_callhome_connected);
+        close(rd->rd_s);
+        rd->rd_s = -1;
+    }
+}
+
+/*! Callhome connection is up: close other connects and accept SSL
+ *
+ * @param[in]  rsock  restconf_socket
+ * @param[in]  s      Connected socket
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+restconf_callhome_up(restconf_socket *rsock,
+                     int              s)
+{
+    int            retval = -1;
+    restconf_conn *rc = NULL;
+    int            flags;
+    int            ret;
+
+    clixon_debug(CLIXON_DBG_RESTCONF, "connect %hu OK", rsock->rs_port);
+    restconf_callhome_cancel(rsock);
+    /* Connects are non-blocking, the connection is as an accepted socket */
+    if ((flags = fcntl(s, F_GETFL, 0)) < 0 ||
+        fcntl(s, F_SETFL, flags & ~O_NONBLOCK) < 0){
+        clixon_err(OE_UNIX, errno, "fcntl");
+        close(s);
+        goto done;
+    }
+    rsock->rs_attempts = 0;
+    rsock->rs_fails = 0;
+    if ((ret = restconf_ssl_accept_client(rsock->rs_h, s, rsock, &rc)) < 0)
+        goto done;
+    /* ret == 0 means already closed */
+    if (ret == 1 && rsock->rs_periodic && rsock->rs_idle_timeout){
+        if (restconf_idle_timer(rc) < 0)
+            goto done;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! A connect of a callhome attempt failed: dial next or, if all failed, set timer
+ *
+ * @param[in]  rsock  restconf_socket
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+restconf_callhome_failed(restconf_socket *rsock)
+{
+    int i;
+
+    if (rsock->rs_dial_next < rsock->rs_ndests){
+        clixon_event_unreg_timeout(restconf_callhome_next, rsock);
+        return restconf_callhome_dial(rsock);
+    }
+    for (i=0; i<rsock->rs_ndests; i++)
+        if (rsock->rs_dests[i].rd_s != -1)
+            return 0; /* Wait for connects in progress */
+    rsock->rs_attempts++;
+    rsock->rs_fails++;
+    /* Fail: Initiate new timer */
+    return restconf_callhome_timer(rsock, 0);
+}
+
+/*! Socket of a callhome connect in progress is writable, ie connected or failed
+ *
+ * @param[in]  fd   Socket
+ * @param[in]  arg  restconf_socket
+ */
+static int
+restconf_callhome_connected(int   fd,
+                            void *arg)
+{
+    restconf_socket *rsock = (restconf_socket *)arg;
+    int              i;
+    int              err = 0;
+    socklen_t        len = sizeof(err);
+
+    clixon_event_unreg_fd_write(fd, restconf_callhome_connected);
+    for (i=0; i<rsock->rs_ndests; i++)
+        if (rsock->rs_dests[i].rd_s == fd){
+            rsock->rs_dests[i].rd_s = -1;
+            break;
+        }
+    if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) < 0)
+        err = errno;
+    if (err){
+        clixon_debug(CLIXON_DBG_RESTCONF, "connect %d fail:%d %s", i, err, strerror(err));
+        close(fd);
+        return restconf_callhome_failed(rsock);
+    }
+    return restconf_callhome_up(rsock, fd);
+}
+
+/*! Dial next destination of a callhome attempt
+ *
+ * Connects are non-blocking. If more destinations remain, the next is dialed after
+ * attempt-delay unless a connection is up or fails before that.
+ * @param[in]  rsock  restconf_socket
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+restconf_callhome_dial(restconf_socket *rsock)
+{
+    int                   retval = -1;
+    struct restconf_dest *rd;
+    struct sockaddr      *sa;
+    struct timeval        now;
+    struct timeval        t;
+    struct timeval        t1;
+    int                   s;
+
+    rd = &rsock->rs_dests[rsock->rs_dial_next++];
+    sa = (struct sockaddr *)&rd->rd_sin6;
+    if ((s = socket(sa->sa_family, SOCK_STREAM | SOCK_NONBLOCK, 0)) < 0) {
+        clixon_err(OE_UNIX, errno, "socket");
+        goto done;
+    }
+    if (connect(s, sa, rd->rd_len) == 0)
+        return restconf_callhome_up(rsock, s);
+    if (errno != EINPROGRESS){
+        clixon_debug(CLIXON_DBG_RESTCONF, "connect %d fail:%d %s",
+                     rsock->rs_dial_next-1, errno, strerror(errno));
+        close(s);
+        return restconf_callhome_failed(rsock);
+    }
+    rd->rd_s = s;
+    if (clixon_event_reg_fd_write(s, restconf_callhome_connected, rsock, "restconf callhome connect") < 0)
+        goto done;
+    if (rsock->rs_dial_next < rsock->rs_ndests){
+        gettimeofday(&now, NULL);
+        t1.tv_sec = rsock->rs_attempt_delay/1000;
+        t1.tv_usec = (rsock->rs_attempt_delay%1000)*1000;
+        timeradd(&now, &t1, &t);
+        if (clixon_event_reg_timeout(t, restconf_callhome_next, rsock,
+                                     "restconf callhome attempt delay") < 0)
+            goto done;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Attempt delay timer callback, dial next destination
+ *
+ * @param[in]  fd   No-op
+ * @param[in]  arg  restconf_socket
+ */
+static int
+restconf_callhome_next(int   fd,
+                       void *arg)
+{
+    return restconf_callhome_dial((restconf_socket *)arg);
+}
+
 /*! Callhome timer callback
  *
+ * Start a connect attempt to the destinations, the first connection is used
  * @param[in]  fd   No-op
  * @param[in]  arg  restconf_socket
  * Can be called directly, but typically call wrapper restconf_callhome_timer instead
@@ -1591,48 +2498,18 @@ restconf_callhome_cb(int   fd,
                      void *arg)
 {
     int              retval = -1;
-    clixon_handle    h;
     restconf_socket *rsock = NULL;
-    struct sockaddr_in6 sin6 = {0,}; // because its larger than sin and sa
-    struct sockaddr *sa = (struct sockaddr *)&sin6;
-    size_t           sa_len;
-    int              s;
-    restconf_conn   *rc = NULL;
-    int              ret;
 
     rsock = (restconf_socket *)arg;
-    if (rsock == NULL || !rsock->rs_callhome){
-        clixon_err(OE_YANG, EINVAL, "rsock is NULL");
+    if (rsock == NULL || !rsock->rs_callhome || rsock->rs_ndests == 0){
+        clixon_err(OE_YANG, EINVAL, "rsock is NULL or has no destinations");
         goto done;
     }
     clixon_debug(CLIXON_DBG_RESTCONF, "\"%s\"", rsock->rs_description);
-    h = rsock->rs_h;
-    /* Already computed in restconf_socket_init, could be saved in rsock? */
-    if (clixon_inet2sin(rsock->rs_addrtype, rsock->rs_addrstr, rsock->rs_port, sa, &sa_len) < 0)
-        goto done;
-    if ((s = socket(sa->sa_family, SOCK_STREAM, 0)) < 0) {
-        clixon_err(OE_UNIX, errno, "socket");
+    restconf_callhome_cancel(rsock);
+    rsock->rs_dial_next = 0;
+    if (restconf_callhome_dial(rsock) < 0)
         goto done;
-    }
-    if (connect(s, sa, sa_len) < 0){
-        clixon_debug(CLIXON_DBG_RESTCONF, "connect %hu fail:%d %s", rsock->rs_port, errno, strerror(errno));
-        close(s);
-        rsock->rs_attempts++;
-        /* Fail: Initiate new timer */
-        if (restconf_callhome_timer(rsock, 0) < 0)
-            goto done;
-    }
-    else {
-        clixon_debug(CLIXON_DBG_RESTCONF, "connect %hu OK", rsock->rs_port);
-        rsock->rs_attempts = 0;
-        if ((ret = restconf_ssl_accept_client(h, s, rsock, &rc)) < 0)
-            goto done;
-        /* ret == 0 means already closed */
-        if (ret == 1 && rsock->rs_periodic && rsock->rs_idle_timeout){
-            if (restconf_idle_timer(rc) < 0)
-                goto done;
-        }
-    }
     retval = 0;
  done:
     return retval;
@@ -1641,9 +2518,37 @@ restconf_callhome_cb(int   fd,
 int
 restconf_callhome_timer_unreg(restconf_socket *rsock)
 {
+    restconf_callhome_cancel(rsock);
     return clixon_event_unreg_timeout(restconf_callhome_cb, rsock);
 }
 
+/*! Delay until next callhome attempt after failed attempts
+ *
+ * Exponential backoff up to backoff-max, with jitter in the upper half so that many
+ * servers calling the same client do not retry in step
+ * @param[in]  rsock  restconf_socket
+ * @param[out] t1     Delay
+ */
+static void
+restconf_callhome_backoff(restconf_socket *rsock,
+                          struct timeval  *t1)
+{
+    uint64_t us;
+
+    us = 1000000;
+    if (rsock->rs_fails > 1)
+        us <<= (rsock->rs_fails - 1 < 32 ? rsock->rs_fails - 1 : 32);
+    if (rsock->rs_backoff_max > 1){
+        if (us > (uint64_t)rsock->rs_backoff_max*1000000)
+            us = (uint64_t)rsock->rs_backoff_max*1000000;
+        us = us/2 + random() % (us/2 + 1);
+    }
+    else
+        us = 1000000;
+    t1->tv_sec = us / 1000000;
+    t1->tv_usec = us % 1000000;
+}
+
 /*! Set callhome timer, which tries to connect to callhome client
  *
  * Implement callhome re-connect strategies in ietf-restconf-server.yang
@@ -1676,18 +2581,22 @@ restconf_callhome_timer(restconf_socket *rsock,
         if ((status == 1) || rsock->rs_attempts >= rsock->rs_max_attempts){
             rsock->rs_period_nr++;
             rsock->rs_attempts = 0;
+            rsock->rs_fails = 0;
             t1.tv_sec = rsock->rs_start + rsock->rs_period_nr*rsock->rs_period;
             while (t1.tv_sec < now.tv_sec)
                 t1.tv_sec += rsock->rs_period;
             t = t1;
         }
         else {
-            t1.tv_sec = 1;
+            restconf_callhome_backoff(rsock, &t1);
             timeradd(&now, &t1, &t);
         }
     }
     else{ /* persistent: try again: attempts? */
-        t1.tv_sec = 1;
+        if (status == 1)
+            t1.tv_sec = 1;
+        else
+            restconf_callhome_backoff(rsock, &t1);
         timeradd(&now, &t1, &t);
     }
     if ((cb = cbuf_new()) == NULL){
@@ -1713,6 +2622,68 @@ restconf_callhome_timer(restconf_socket *rsock,
     return retval;
 }
 
+/*! Set callhome destinations: socket address and endpoints
+ *
+ * @param[in]  xs        socket config
+ * @param[in]  nsc       Namespace context
+ * @param[in]  rsock     restconf socket
+ * @param[in]  address   Socket address
+ * @param[in]  addrtype  Socket address type, inet:ipv4-address or inet:ipv6-address
+ * @param[in]  port      Socket port, also of endpoints without port
+ * @retval     0         OK
+ * @retval    -1         Error
+ */
+static int
+restconf_callhome_dests(cxobj           *xs,
+                        cvec            *nsc,
+                        restconf_socket *rsock,
+                        char            *address,
+                        char            *addrtype,
+                        uint16_t         port)
+{
+    int                   retval = -1;
+    cxobj               **vec = NULL;
+    size_t                veclen = 0;
+    struct restconf_dest *rd;
+    cxobj                *x;
+    char                 *addr;
+    char                 *str;
+    uint16_t              p;
+    int                   i;
+
+    if (xpath_vec(xs, nsc, "call-home/endpoint", &vec, &veclen) < 0)
+        goto done;
+    if ((rsock->rs_dests = calloc(veclen+1, sizeof(struct restconf_dest))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    for (i=0; i<veclen+1; i++){
+        rd = &rsock->rs_dests[i];
+        rd->rd_s = -1;
+        addr = address;
+        p = port;
+        if (i > 0){
+            if ((x = xpath_first(vec[i-1], nsc, "address")) == NULL ||
+                (addr = xml_body(x)) == NULL){
+                clixon_err(OE_XML, EINVAL, "Mandatory endpoint address not given");
+                goto done;
+            }
+            addrtype = strchr(addr, ':') ? "inet:ipv6-address" : "inet:ipv4-address";
+            if ((x = xpath_first(vec[i-1], nsc, "port")) != NULL &&
+                (str = xml_body(x)) != NULL)
+                p = strtoul(str, NULL, 10);
+        }
+        if (clixon_inet2sin(addrtype, addr, p, (struct sockaddr *)&rd->rd_sin6, &rd->rd_len) < 0)
+            goto done;
+    }
+    rsock->rs_ndests = veclen + 1;
+    retval = 0;
+ done:
+    if (vec)
+        free(vec);
+    return retval;
+}
+
 /*! Extract socket info from backend config 
  *
  * @param[in]  h         Clixon handle
@@ -1861,6 +2832,16 @@ restconf_socket_extract(clixon_handle    h,
                 goto done;
             }
         }
+        rsock->rs_backoff_max = 1;
+        if ((x = xpath_first(xs, nsc, "call-home/reconnect-strategy/backoff-max")) != NULL &&
+            (str = xml_body(x)) != NULL)
+            rsock->rs_backoff_max = strtoul(str, NULL, 10);
+        rsock->rs_attempt_delay = 250;
+        if ((x = xpath_first(xs, nsc, "call-home/attempt-delay")) != NULL &&
+            (str = xml_body(x)) != NULL)
+            rsock->rs_attempt_delay = strtoul(str, NULL, 10);
+        if (restconf_callhome_dests(xs, nsc, rsock, *address, *addrtype, *port) < 0)
+            goto done;
     }
     retval = 0;
  done:
@@ -82,6 +82,12 @@ typedef struct  {
     cbuf                 *sd_body;      /* http output body as cbuf terminated with \r\n */
     size_t                sd_body_len;  /* Content-Length, note for HEAD body body can be NULL and this non-zero */
     size_t                sd_body_offset; /* Offset into body */
+    int                   sd_file_fd;   /* If != -1, body is sd_body_len bytes read from file */
+    off_t                 sd_file_offset; /* Start of body in file */
+    int                   sd_prod_s;    /* Pipe from reply body producer process, or -1 */
+    pid_t                 sd_prod_pid;  /* Reply body producer process, or 0 */
+    size_t                sd_prod_size; /* Stop reading producer when this much is buffered */
+    int                   sd_prod_paused; /* Producer pipe not read until body is sent */
     cbuf                 *sd_inbuf;     /* Receive/input buf (whole message) */
     cbuf                 *sd_indata;    /* Receive/input data body */
     char                 *sd_path;      /* Uri path, uri-encoded, without args (eg ?) */
@@ -96,6 +102,17 @@ typedef struct  {
 
 typedef struct restconf_socket restconf_socket;
 
+/* Token bucket of a client address for rate limiting of read requests
+ * @see clixon-restconf.yang rate-limit
+ */
+typedef struct restconf_bucket {
+    qelem_t               rb_qelem;     /* List header */
+    char                 *rb_addr;      /* Client address as string */
+    double                rb_tokens;    /* Available tokens */
+    struct timeval        rb_t;         /* Time of last refill */
+    int                   rb_refs;      /* Number of connections using the bucket */
+} restconf_bucket;
+
 /* Restconf connection handle 
  * Per connection request
  */
@@ -122,6 +139,11 @@ typedef struct restconf_conn {
     struct timeval        rc_t;         /* Timestamp of last read/write activity, used by callhome
                                            idle-timeout algorithm */
     int                   rc_event_stream;    /* Event notification stream socket (maybe in sd?) */
+    cbuf                 *rc_inpend;    /* HTTP/1 input not yet processed, eg pipelined requests */
+    restconf_bucket      *rc_bucket;    /* Token bucket of client address, if rate limited */
+    int                   rc_deferred;  /* Socket is paused, remaining input is processed later */
+    cbuf                 *rc_outbuf;    /* HTTP/2 frames coalesced into one write */
+    struct http1_scan    *rc_h1scan;    /* HTTP/1 header scanner, if CLICON_RESTCONF_HTTP1_PARSER is fast */
 } restconf_conn;
 
 /* Restconf per socket handle
@@ -158,6 +180,12 @@ typedef struct restconf_socket{
     restconf_conn *rs_conns;  /* List of transient connect sockets */
     char          *rs_from_addr; /* From IP address as seen by accept (mv to rc?) */
     int            rs_stream_timeout; /* Close stream after <s> (debug) */
+    struct restconf_dest *rs_dests; /* Callhome: destinations, socket address first */
+    int            rs_ndests;   /* Callhome: number of destinations */
+    int            rs_dial_next; /* Callhome: next destination to dial in this attempt */
+    uint32_t       rs_attempt_delay; /* Callhome: ms before dialing next destination */
+    uint32_t       rs_backoff_max; /* Callhome: max s between failed attempts */
+    uint32_t       rs_fails;    /* Callhome: consecutive failed attempts, for backoff */
 } restconf_socket;
 
 /* Restconf handle 
@@ -167,6 +195,19 @@ typedef struct {
     SSL_CTX         *rn_ctx;       /* SSL context */
     restconf_socket *rn_sockets;   /* List of restconf server (ready for accept) sockets */
     void            *rn_arg;       /* Packet specific handle */
+    uint64_t         rn_handshakes; /* Number of completed TLS handshakes */
+    uint64_t         rn_resumed;   /* Of which were resumed sessions */
+    uint64_t         rn_handshake_us; /* Accumulated handshake time in microseconds */
+    uint32_t         rn_rate;      /* Read requests per second per client, 0 is no limit */
+    uint32_t         rn_burst;     /* Token bucket size */
+    uint32_t         rn_pipeline_depth; /* Max requests per connection before others, 0 no limit */
+    uint32_t         rn_h2_max_streams; /* HTTP/2 max concurrent streams */
+    uint32_t         rn_h2_window;  /* HTTP/2 initial stream window size */
+    uint32_t         rn_h2_conn_window; /* HTTP/2 connection window size */
+    uint32_t         rn_h2_max_frame; /* HTTP/2 max frame size */
+    uint32_t         rn_h2_coalesce; /* HTTP/2 frames are written in chunks of this size, 0 is per frame */
+    int              rn_http1_parser; /* HTTP/1 request parser, see CLICON_RESTCONF_HTTP1_PARSER */
+    restconf_bucket *rn_buckets;   /* Token buckets of client addresses */
 } restconf_native_handle;
 
 /*
@@ -175,12 +216,15 @@ typedef struct {
 restconf_stream_data *restconf_stream_data_new(restconf_conn *rc, int32_t stream_id);
 restconf_stream_data *restconf_stream_find(restconf_conn *rc, int32_t id);
 int               restconf_stream_free(restconf_stream_data *sd);
+void              restconf_bucket_free_all(restconf_native_handle *rn);
 restconf_conn    *restconf_conn_new(clixon_handle h, int s, restconf_socket *socket);
 int               ssl_x509_name_oneline(SSL *ssl, char **oneline);
 
 int               restconf_close_ssl_socket(restconf_conn *rc, const char *callfn, int sslerr0);
 int               restconf_connection_sanity(clixon_handle h, restconf_conn *rc, restconf_stream_data *sd);
+int               restconf_native_compress(clixon_handle h, restconf_stream_data *sd);
 int               native_buf_write(clixon_handle h, char *buf, size_t buflen, restconf_conn *rc, const char *callfn);
+int               native_file_write(clixon_handle h, restconf_stream_data *sd, restconf_conn *rc);
 restconf_native_handle *restconf_native_handle_get(clixon_handle h);
 int               restconf_connection(int s, void *arg);
 int               restconf_ssl_accept_client(clixon_handle h, int s, restconf_socket *rsock, restconf_conn  **rcp);
@@ -60,6 +60,7 @@
 #include <assert.h>
 #include <signal.h>
 #include <sys/stat.h>
+#include <sys/wait.h>
 #include <sys/socket.h>
 #include <arpa/inet.h>
 #include <sys/resource.h>
@@ -156,28 +157,20 @@ nghttp2_print_headers(nghttp2_nv *nva,
 }
 #endif /* NOTUSED */
 
-/*! Send data to remote peer, Send at most the |length| bytes of |data|.
+/*! Write data to remote peer, blocks until all is written
  *
- * This callback is required if the application uses
- * `nghttp2_session_send()` to send data to the remote endpoint.  If
- * the application uses solely `nghttp2_session_mem_send()` instead,
- * this callback function is unnecessary.
- * It must return the number of bytes sent if it succeeds.  
- * If it cannot send any single byte without blocking,
- * it must return :enum:`NGHTTP2_ERR_WOULDBLOCK`.  
- * For other errors, it must return :enum:`NGHTTP2_ERR_CALLBACK_FAILURE`.
- * @param[in] session   Nghttp2 session struct
- * @param[in] user_data  User data, in effect Restconf connection
+ * @param[in] rc      Restconf connection
+ * @param[in] buf     Data
+ * @param[in] buflen  Length of data
+ * @retval    len     Number of bytes written
+ * @retval    err     NGHTTP2_ERR_CALLBACK_FAILURE
  */
 static ssize_t
-session_send_callback(nghttp2_session *session,
-                      const uint8_t   *buf,
-                      size_t           buflen,
-                      int              flags,
-                      void            *user_data)
+http2_write(restconf_conn *rc,
+            const uint8_t *buf,
+            size_t         buflen)
 {
     int            retval = NGHTTP2_ERR_CALLBACK_FAILURE;
-    restconf_conn *rc = (restconf_conn *)user_data;
     int            er;
     ssize_t        len;
     ssize_t        totlen = 0;
@@ -265,6 +258,118 @@ session_send_callback(nghttp2_session *session,
     return retval == 0 ? totlen : retval;
 }
 
+/*! Write frames coalesced in the output buffer of the connection
+ *
+ * @param[in] rc      Restconf connection
+ * @retval    0       OK
+ * @retval    err     NGHTTP2_ERR_CALLBACK_FAILURE
+ */
+static int
+http2_flush(restconf_conn *rc)
+{
+    ssize_t len;
+
+    if (rc->rc_outbuf == NULL || cbuf_len(rc->rc_outbuf) == 0)
+        return 0;
+    len = http2_write(rc, (const uint8_t *)cbuf_get(rc->rc_outbuf), cbuf_len(rc->rc_outbuf));
+    cbuf_reset(rc->rc_outbuf);
+    return len < 0 ? len : 0;
+}
+
+/*! Send data to remote peer, Send at most the |length| bytes of |data|.
+ *
+ * This callback is required if the application uses
+ * `nghttp2_session_send()` to send data to the remote endpoint.  If
+ * the application uses solely `nghttp2_session_mem_send()` instead,
+ * this callback function is unnecessary.
+ * It must return the number of bytes sent if it succeeds.  
+ * If it cannot send any single byte without blocking,
+ * it must return :enum:`NGHTTP2_ERR_WOULDBLOCK`.  
+ * For other errors, it must return :enum:`NGHTTP2_ERR_CALLBACK_FAILURE`.
+ * Frames are appended to the output buffer of the connection and written when
+ * write-coalesce octets are pending, or in http2_session_send
+ * @param[in] session   Nghttp2 session struct
+ * @param[in] user_data  User data, in effect Restconf connection
+ */
+static ssize_t
+session_send_callback(nghttp2_session *session,
+                      const uint8_t   *buf,
+                      size_t           buflen,
+                      int              flags,
+                      void            *user_data)
+{
+    restconf_conn          *rc = (restconf_conn *)user_data;
+    restconf_native_handle *rn;
+    ssize_t                 len;
+
+    rn = restconf_native_handle_get(rc->rc_h);
+    if (rn->rn_h2_coalesce == 0)
+        return http2_write(rc, buf, buflen);
+    if (rc->rc_outbuf == NULL &&
+        (rc->rc_outbuf = cbuf_new_alloc(rn->rn_h2_coalesce)) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new_alloc");
+        return NGHTTP2_ERR_CALLBACK_FAILURE;
+    }
+    if (cbuf_len(rc->rc_outbuf) + buflen > rn->rn_h2_coalesce &&
+        (len = http2_flush(rc)) < 0)
+        return len;
+    if (buflen >= rn->rn_h2_coalesce)
+        return http2_write(rc, buf, buflen);
+    if (cbuf_append_buf(rc->rc_outbuf, (void*)buf, buflen) < 0){
+        clixon_err(OE_UNIX, errno, "cbuf_append_buf");
+        return NGHTTP2_ERR_CALLBACK_FAILURE;
+    }
+    return buflen;
+}
+
+/*! Send pending frames of the session and write coalesced frames
+ *
+ * Use instead of nghttp2_session_send
+ * @param[in] rc      Restconf connection
+ * @retval    0       OK
+ * @retval    ngerr   Nghttp2 error
+ */
+int
+http2_session_send(restconf_conn *rc)
+{
+    int ngerr;
+
+    if ((ngerr = nghttp2_session_send(rc->rc_ngsession)) != 0)
+        return ngerr;
+    return http2_flush(rc);
+}
+
+/*! Length of DATA frames, larger than the default 16K if max-frame-size allows
+ *
+ * @param[in] session_remote_window_size  Connection window of peer
+ * @param[in] stream_remote_window_size   Stream window of peer
+ * @param[in] remote_max_frame_size       SETTINGS_MAX_FRAME_SIZE of peer
+ * @param[in] user_data                   User data, in effect Restconf connection
+ */
+static ssize_t
+data_source_read_length_callback(nghttp2_session *session,
+                                 uint8_t          frame_type,
+                                 int32_t          stream_id,
+                                 int32_t          session_remote_window_size,
+                                 int32_t          stream_remote_window_size,
+                                 uint32_t         remote_max_frame_size,
+                                 void            *user_data)
+{
+    restconf_conn          *rc = (restconf_conn *)user_data;
+    restconf_native_handle *rn;
+    ssize_t                 len;
+
+    rn = restconf_native_handle_get(rc->rc_h);
+    len = rn->rn_h2_max_frame;
+    if (len > remote_max_frame_size)
+        len = remote_max_frame_size;
+    if (len > session_remote_window_size)
+        len = session_remote_window_size;
+    if (len > stream_remote_window_size)
+        len = stream_remote_window_size;
+    return len > 0 ? len : 1;
+}
+
 /*! Invoked when |session| wants to receive data from the remote peer.  
  *
  * @param[in] session   Nghttp2 session struct
@@ -368,6 +473,214 @@ restconf_nghttp2_path(restconf_stream_data *sd)
     return retval; /* void */
 }
 
+/*! Write reply body producer output to pipe
+ *
+ * Called in producer process. Writes block until the parent has read, which gives
+ * backpressure
+ * @param[in]  cb   Output
+ * @param[in]  arg  Pointer to pipe socket
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+http2_producer_flush(cbuf *cb,
+                     void *arg)
+{
+    int     s = *(int*)arg;
+    char   *buf = cbuf_get(cb);
+    size_t  len = cbuf_len(cb);
+    ssize_t n;
+
+    while (len > 0){
+        if ((n = write(s, buf, len)) < 0){
+            if (errno == EINTR)
+                continue;
+            clixon_err(OE_UNIX, errno, "write");
+            return -1;
+        }
+        buf += n;
+        len -= n;
+    }
+    return 0;
+}
+
+/*! Reply body producer output is available, append to body and resume DATA frames
+ *
+ * Producer pipe is not read more when sd_prod_size bytes are buffered until they
+ * are sent, see restconf_sd_read
+ * @param[in]  s    Pipe socket
+ * @param[in]  arg  Restconf stream data
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+http2_producer_cb(int   s,
+                  void *arg)
+{
+    int                   retval = -1;
+    restconf_stream_data *sd = (restconf_stream_data *)arg;
+    restconf_conn        *rc = sd->sd_conn;
+    char                  buf[16384];
+    ssize_t               n;
+    int                   status = 0;
+    nghttp2_error         ngerr;
+
+    if ((n = read(s, buf, sizeof(buf))) < 0){
+        if (errno == EINTR || errno == EAGAIN)
+            goto ok;
+        clixon_err(OE_UNIX, errno, "read");
+        goto done;
+    }
+    if (n == 0){ /* Producer done */
+        clixon_debug(CLIXON_DBG_RESTCONF, "eof");
+        clixon_event_unreg_fd(s, http2_producer_cb);
+        close(s);
+        sd->sd_prod_s = -1;
+        if (waitpid(sd->sd_prod_pid, &status, 0) < 0)
+            status = -1;
+        sd->sd_prod_pid = 0;
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0){
+            clixon_log(rc->rc_h, LOG_WARNING, "%s: reply producer failed with status %#x",
+                       __FUNCTION__, status);
+            /* Dont let client take partial body as complete */
+            if ((ngerr = nghttp2_submit_rst_stream(rc->rc_ngsession, NGHTTP2_FLAG_NONE,
+                                                   sd->sd_stream_id,
+                                                   NGHTTP2_INTERNAL_ERROR)) < 0){
+                clixon_err(OE_NGHTTP2, ngerr, "nghttp2_submit_rst_stream");
+                goto done;
+            }
+        }
+    }
+    else {
+        if (sd->sd_body == NULL){
+            if ((sd->sd_body = cbuf_new()) == NULL){
+                clixon_err(OE_UNIX, errno, "cbuf_new");
+                goto done;
+            }
+            sd->sd_body_offset = 0;
+        }
+        else if (sd->sd_body_offset == cbuf_len(sd->sd_body)){
+            cbuf_reset(sd->sd_body);
+            sd->sd_body_offset = 0;
+        }
+        if (cbuf_append_buf(sd->sd_body, buf, n) < 0){
+            clixon_err(OE_UNIX, errno, "cbuf_append_buf");
+            goto done;
+        }
+        if (cbuf_len(sd->sd_body) - sd->sd_body_offset >= sd->sd_prod_size){
+            clixon_event_unreg_fd(s, http2_producer_cb);
+            sd->sd_prod_paused = 1;
+        }
+    }
+    if ((ngerr = nghttp2_session_resume_data(rc->rc_ngsession, sd->sd_stream_id)) < 0 &&
+        ngerr != NGHTTP2_ERR_INVALID_ARGUMENT){ /* Not deferred */
+        clixon_err(OE_NGHTTP2, ngerr, "nghttp2_session_resume_data");
+        goto done;
+    }
+    if (http2_session_send(rc) != 0){
+        /* Peer gone, also stops producer */
+        if (restconf_close_ssl_socket(rc, __FUNCTION__, 0) < 0)
+            goto done;
+    }
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Send HTTP/2 reply with a body produced in a separate process while it is sent
+ *
+ * The producer is forked and writes the body to a pipe. Copy-on-write shares the
+ * data to serialize, eg a reply XML tree, without copying it. The pipe is read in
+ * the event loop and sent in DATA frames as output is available, the data provider
+ * defers while waiting for more, see restconf_sd_read.
+ * No Content-Length is sent.
+ * @param[in]  sd    Restconf stream data
+ * @param[in]  code  Status code
+ * @param[in]  size  Producer output is flushed, and at most buffered, in this size
+ * @param[in]  fn    Body producer
+ * @param[in]  arg   Body producer argument
+ * @retval     1     OK
+ * @retval    -1     Error
+ * @see restconf_reply_send_stream
+ */
+int
+http2_reply_stream(restconf_stream_data *sd,
+                   int                   code,
+                   size_t                size,
+                   restconf_body_fn     *fn,
+                   void                 *arg)
+{
+    int   retval = -1;
+    int   sp[2] = {-1, -1};
+    pid_t pid;
+    cbuf *cb;
+    int   rv = -1;
+
+    if (pipe(sp) < 0){
+        clixon_err(OE_UNIX, errno, "pipe");
+        goto done;
+    }
+    if ((pid = fork()) < 0){
+        clixon_err(OE_UNIX, errno, "fork");
+        goto done;
+    }
+    if (pid == 0){ /* Producer: only writes to pipe, inherited sockets are not used */
+        close(sp[0]);
+        if ((cb = cbuf_new()) != NULL &&
+            fn(arg, cb, size, http2_producer_flush, &sp[1]) == 0 &&
+            http2_producer_flush(cb, &sp[1]) == 0)
+            rv = 0;
+        _exit(rv < 0 ? 1 : 0);
+    }
+    close(sp[1]);
+    sp[1] = -1;
+    clixon_debug(CLIXON_DBG_RESTCONF, "producer pid:%d", pid);
+    sd->sd_code = code;
+    sd->sd_body_len = 0;
+    if (sd->sd_body){
+        cbuf_free(sd->sd_body);
+        sd->sd_body = NULL;
+    }
+    sd->sd_body_offset = 0;
+    sd->sd_prod_s = sp[0];
+    sp[0] = -1;
+    sd->sd_prod_pid = pid;
+    sd->sd_prod_size = size;
+    sd->sd_prod_paused = 0;
+    if (clixon_event_reg_fd(sd->sd_prod_s, http2_producer_cb, sd, "reply producer") < 0)
+        goto done;
+    retval = 1;
+ done:
+    if (sp[0] != -1)
+        close(sp[0]);
+    if (sp[1] != -1)
+        close(sp[1]);
+    return retval;
+}
+
+/*! Stop reply body producer, if any, and release its resources
+ *
+ * @param[in]  sd    Restconf stream data
+ * @retval     0     OK
+ */
+int
+http2_producer_close(restconf_stream_data *sd)
+{
+    if (sd->sd_prod_s != -1){
+        if (!sd->sd_prod_paused)
+            clixon_event_unreg_fd(sd->sd_prod_s, http2_producer_cb);
+        close(sd->sd_prod_s);
+        sd->sd_prod_s = -1;
+    }
+    if (sd->sd_prod_pid > 0){
+        kill(sd->sd_prod_pid, SIGKILL);
+        waitpid(sd->sd_prod_pid, NULL, 0);
+        sd->sd_prod_pid = 0;
+    }
+    return 0;
+}
+
 /*! Data callback, just pass pointer to cbuf
  *
  * @param[in] session    Nghttp2 session struct
@@ -402,8 +715,42 @@ restconf_sd_read(nghttp2_session     *session,
     cbuf                 *cb;
     size_t                len = 0;
     size_t                remain;
+    ssize_t               n;
 
     clixon_debug(CLIXON_DBG_RESTCONF, "");
+    if (sd->sd_prod_s != -1){ /* Body from producer process, more may come */
+        cb = sd->sd_body;
+        if (cb == NULL || sd->sd_body_offset == cbuf_len(cb))
+            return NGHTTP2_ERR_DEFERRED; /* Resumed in http2_producer_cb */
+        remain = cbuf_len(cb) - sd->sd_body_offset;
+        len = (remain <= length) ? remain : length;
+        memcpy(buf, cbuf_get(cb) + sd->sd_body_offset, len);
+        sd->sd_body_offset += len;
+        if (sd->sd_prod_paused &&
+            cbuf_len(cb) - sd->sd_body_offset < sd->sd_prod_size){
+            if (clixon_event_reg_fd(sd->sd_prod_s, http2_producer_cb, sd, "reply producer") < 0)
+                return NGHTTP2_ERR_CALLBACK_FAILURE;
+            sd->sd_prod_paused = 0;
+        }
+        clixon_debug(CLIXON_DBG_RESTCONF, "producer retval:%zu", len);
+        return len;
+    }
+    if (sd->sd_file_fd != -1){ /* Read file body on demand directly into frame buffer */
+        remain = sd->sd_body_len - sd->sd_body_offset;
+        len = (remain <= length) ? remain : length;
+        if ((n = pread(sd->sd_file_fd, buf, len, sd->sd_file_offset + sd->sd_body_offset)) <= 0){
+            clixon_err(OE_UNIX, errno, "pread");
+            return NGHTTP2_ERR_TEMPORAL_CALLBACK_FAILURE;
+        }
+        sd->sd_body_offset += n;
+        if (sd->sd_body_offset >= sd->sd_body_len){
+            *data_flags |= NGHTTP2_DATA_FLAG_EOF;
+            close(sd->sd_file_fd);
+            sd->sd_file_fd = -1;
+        }
+        clixon_debug(CLIXON_DBG_RESTCONF, "file retval:%zd", n);
+        return n;
+    }
     if ((cb = sd->sd_body) == NULL){ /* shouldnt happen */
         if (rc->rc_event_stream && rc->rc_exit == 0) {
             return NGHTTP2_ERR_DEFERRED;
@@ -551,6 +898,8 @@ http2_exec(restconf_conn        *rc,
         clixon_debug(CLIXON_DBG_RESTCONF, "path not found");
         sd->sd_code = 404;    /* not found */
     }
+    if (restconf_native_compress(rc->rc_h, sd) < 0)
+        goto done;
     if (restconf_param_del_all(rc->rc_h) < 0) // XXX
         goto done;
 
@@ -985,7 +1334,7 @@ http2_recv(restconf_conn       *rc,
      * @see session_send_callback()
      */
     clixon_err_reset();
-    if ((ngerr = nghttp2_session_send(rc->rc_ngsession)) != 0){
+    if ((ngerr = http2_session_send(rc)) != 0){
         if (clixon_err_category())
             goto done;
         else
@@ -1005,12 +1354,21 @@ http2_recv(restconf_conn       *rc,
 int
 http2_send_server_connection(restconf_conn *rc)
 {
-    int                    retval = -1;
-    nghttp2_settings_entry iv[2] = {{NGHTTP2_SETTINGS_MAX_CONCURRENT_STREAMS, 100}
-                                    ,{NGHTTP2_SETTINGS_ENABLE_PUSH, 0}};
-    nghttp2_error          ngerr;
+    int                     retval = -1;
+    restconf_native_handle *rn;
+    nghttp2_settings_entry  iv[4];
+    nghttp2_error           ngerr;
 
     clixon_debug(CLIXON_DBG_RESTCONF, "");
+    rn = restconf_native_handle_get(rc->rc_h);
+    iv[0].settings_id = NGHTTP2_SETTINGS_MAX_CONCURRENT_STREAMS;
+    iv[0].value = rn->rn_h2_max_streams;
+    iv[1].settings_id = NGHTTP2_SETTINGS_ENABLE_PUSH;
+    iv[1].value = 0;
+    iv[2].settings_id = NGHTTP2_SETTINGS_INITIAL_WINDOW_SIZE;
+    iv[2].value = rn->rn_h2_window;
+    iv[3].settings_id = NGHTTP2_SETTINGS_MAX_FRAME_SIZE;
+    iv[3].value = rn->rn_h2_max_frame;
     if ((ngerr = nghttp2_submit_settings(rc->rc_ngsession,
                                          NGHTTP2_FLAG_NONE,
                                          iv,
@@ -1018,7 +1376,16 @@ http2_send_server_connection(restconf_conn *rc)
         clixon_err(OE_NGHTTP2, ngerr, "nghttp2_submit_settings");
         goto done;
     }
-    if ((ngerr = nghttp2_session_send(rc->rc_ngsession)) != 0){
+    /* Connection window is not a setting, it is increased by a window update */
+    if (rn->rn_h2_conn_window > NGHTTP2_INITIAL_CONNECTION_WINDOW_SIZE &&
+        (ngerr = nghttp2_submit_window_update(rc->rc_ngsession,
+                                              NGHTTP2_FLAG_NONE,
+                                              0,
+                                              rn->rn_h2_conn_window - NGHTTP2_INITIAL_CONNECTION_WINDOW_SIZE)) != 0){
+        clixon_err(OE_NGHTTP2, ngerr, "nghttp2_submit_window_update");
+        goto done;
+    }
+    if ((ngerr = http2_session_send(rc)) != 0){
         clixon_err(OE_NGHTTP2, ngerr, "nghttp2_session_send");
         goto done;
     }
@@ -1055,6 +1422,7 @@ http2_session_init(restconf_conn *rc)
     nghttp2_session_callbacks_set_on_begin_frame_callback(callbacks, on_begin_frame_callback);
 
     nghttp2_session_callbacks_set_send_data_callback(callbacks, send_data_callback);
+    nghttp2_session_callbacks_set_data_source_read_length_callback(callbacks, data_source_read_length_callback);
     nghttp2_session_callbacks_set_on_extension_chunk_recv_callback(callbacks, on_extension_chunk_recv_callback);
     nghttp2_session_callbacks_set_error_callback(callbacks, error_callback);
 #if (NGHTTP2_VERSION_NUM > 0x011201) /* Unsure of version number */
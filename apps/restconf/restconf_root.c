@@ -480,6 +480,7 @@ api_root_restconf(clixon_handle        h,
     char          *username = NULL;
     int            ret;
     cxobj         *xerr = NULL;
+    clixon_span    sp = {0,};
 
     clixon_debug(CLIXON_DBG_RESTCONF, "");
     if (req == NULL){
@@ -489,6 +490,11 @@ api_root_restconf(clixon_handle        h,
     request_method = restconf_param_get(h, "REQUEST_METHOD");
     if ((path = restconf_uripath(h)) == NULL)
         goto done;
+    /* Trace context of client, propagated to backend, see CLICON_TRACE_FILE */
+    if (clixon_trace_enabled()){
+        clixon_trace_parent_set(restconf_param_get(h, "HTTP_TRACEPARENT"));
+        clixon_trace_span_start(&sp, "%s %s", request_method, path);
+    }
     pretty = restconf_pretty_get(h);
     /* Get media for output (proactive negotiation) RFC7231 by using
      * Accept:. This is for methods that have output, such as GET,
@@ -625,6 +631,7 @@ api_root_restconf(clixon_handle        h,
     retval = 0;
  done:
     clixon_debug(CLIXON_DBG_RESTCONF, "retval:%d", retval);
+    clixon_trace_span_end(&sp);
 #ifdef WITH_RESTCONF_FCGI
     if (cb)
         cbuf_free(cb);
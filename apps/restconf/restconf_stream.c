@@ -117,14 +117,35 @@ api_path_is_stream(clixon_handle h)
     return retval;
 }
 
+/*! Check if a stream request may share the backend subscription of other requests
+ *
+ * Replay with start-time or stop-time needs its own subscription
+ * @param[in]  qvec  Query parameters
+ * @retval     1     Shareable
+ * @retval     0     Not shareable
+ */
+static int
+stream_shareable(cvec *qvec)
+{
+    cg_var *cv = NULL;
+
+    while (qvec && (cv = cvec_each(qvec, cv)) != NULL)
+        if (strcmp(cv_name_get(cv), "start-time") == 0 ||
+            strcmp(cv_name_get(cv), "stop-time") == 0)
+            return 0;
+    return 1;
+}
+
 /*! Send subscription to backend
  *
+ * If shared and there is a subscription of the stream, it is used instead
  * @param[in]  h         Clixon handle
  * @param[in]  req       Generic Www handle (can be part of clixon handle)
  * @param[in]  name      Stream name
  * @param[in]  qvec
  * @param[in]  pretty    Pretty-print json/xml reply
  * @param[in]  media_out Restconf output media
+ * @param[in]  shared    Use shared subscription of stream, see stream_shared_socket
  * @param[out] sp        Socket -1 if not set (only fcgi)
  * @retval     0    OK
  * @retval    -1    Error
@@ -136,6 +157,7 @@ restconf_subscription(clixon_handle  h,
                       cvec          *qvec,
                       int            pretty,
                       restconf_media media_out,
+                      int            shared,
                       int           *sp)
 {
     int     retval = -1;
@@ -149,6 +171,10 @@ restconf_subscription(clixon_handle  h,
 
     clixon_debug(CLIXON_DBG_STREAM, "");
     *sp = -1;
+    if (shared && (s = stream_shared_socket(h, name)) != -1){
+        clixon_debug(CLIXON_DBG_STREAM, "shared subscription of %s", name);
+        goto setup;
+    }
     if ((cb = cbuf_new()) == NULL){
         clixon_err(OE_XML, errno, "cbuf_new");
         goto done;
@@ -178,6 +204,7 @@ restconf_subscription(clixon_handle  h,
             goto done;
         goto ok;
     }
+ setup:
     /* Setting up stream */
     if (restconf_reply_header(req, "Server", "clixon") < 0)
         goto done;
@@ -236,6 +263,7 @@ api_stream(clixon_handle h,
     restconf_media media_reply = YANG_DATA_XML;
     char          *media_list = NULL;
     char          *stream_name;
+    int            shared;
     int            ret;
 
     clixon_debug(CLIXON_DBG_STREAM, "");
@@ -302,10 +330,11 @@ api_stream(clixon_handle h,
         goto done;
     if (ret == 0)
         goto ok;
-    if (restconf_subscription(h, req, stream_name, qvec, pretty, media_reply, &besock) < 0)
+    shared = stream_shareable(qvec);
+    if (restconf_subscription(h, req, stream_name, qvec, pretty, media_reply, shared, &besock) < 0)
         goto done;
     if (besock != -1){
-        if (stream_sockets_setup(h, req, timeout, besock, finish) < 0)
+        if (stream_sockets_setup(h, req, timeout, besock, shared?stream_name:NULL, finish) < 0)
             goto done;
     }
  ok:
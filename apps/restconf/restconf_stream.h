@@ -41,11 +41,10 @@
  * Prototypes
  */
 int api_path_is_stream(clixon_handle h);
-int restconf_subscription(clixon_handle h, void *req, char *name, cvec *qvec, int pretty,  restconf_media media_out, int *sp);
+int restconf_subscription(clixon_handle h, void *req, char *name, cvec *qvec, int pretty,  restconf_media media_out, int shared, int *sp);
 int api_stream(clixon_handle h, void *req, cvec *qvec, int timeout, int *finish);
-int stream_sockets_setup(clixon_handle h, void *req, int timeout, int besock, int *finish);
+int stream_shared_socket(clixon_handle h, char *name);
+int stream_sockets_setup(clixon_handle h, void *req, int timeout, int besock, char *name, int *finish);
 int stream_close(clixon_handle h, void *req); // only native
-int stream_child_free(clixon_handle h, int pid); // only fcgi
-int stream_child_freeall(clixon_handle h); // only fcgi
 
 #endif /* _RESTCONF_STREAM_H_ */
@@ -59,9 +59,7 @@
    * Note that this implementation includes some hardcoded things for FCGI.
    * These are:
    * - req->listen_sock is used to register incoming fd events from (nginx) fcgi server
-   * - The stream_child struct copies the FCGX_Request by value, so FCGX_Free() can be called 
-   *   asynchronously
-   * - In the forked variant, FCGX_Finish_r() and  FCGX_Free() are called (minor)
+   * - The stream runs a local event loop until closed, no process is forked per stream
  */
 
 #ifdef HAVE_CONFIG_H
@@ -99,73 +97,20 @@
 #include "restconf_lib.h"
 #include "restconf_stream.h"
 
-/*
- * Constants
- */
-/* Enable for forking stream subscription loop. 
- * Disable to get single threading but blocking on streams
- * XXX: Integrate with top-level events
- */
-#undef STREAM_FORK
-
-/* Keep track of children - when they exit - their FCGX handle needs to be 
- * freed with  FCGX_Free(&rbk, 0);
- */
-struct stream_child{
-    qelem_t              sc_q;   /* queue header */
-    int                  sc_pid; /* Child process id */
-    FCGX_Request         sc_r;   /* FCGI stream data. XXX this is by value */
-};
-/* Linked list of children
- * @note could hang STREAM_CHILD list on clicon handle instead.
- */
-static struct stream_child *STREAM_CHILD = NULL;
-
 static int backend_eof = 0;
 
-/*! Find restconf child using PID and cleanup FCGI Request data
+/*! Get backend socket of shared subscription of a stream
  *
- * For forked, called on SIGCHILD
- * @param[in]  h   Clixon handle
- * @param[in]  pid Process id of child
- * @note could hang STREAM_CHILD list on clicon handle instead.
+ * A fcgi stream runs its own event loop until it is closed, so subscriptions are not shared
+ * @param[in]  h     Clixon handle
+ * @param[in]  name  Stream name
+ * @retval    -1     No shared subscription of stream
  */
 int
-stream_child_free(clixon_handle h,
-                  int           pid)
+stream_shared_socket(clixon_handle h,
+                     char         *name)
 {
-    struct stream_child *sc;
-
-    if ((sc = STREAM_CHILD) != NULL){
-        do {
-            if (pid == sc->sc_pid){
-                DELQ(sc, STREAM_CHILD, struct stream_child *);
-                FCGX_Free(&sc->sc_r, 0); /* XXX pointer to actual copied struct */
-                free(sc);
-                goto done;
-            }
-            sc = NEXTQ(struct stream_child *, sc);
-        } while (sc && sc != STREAM_CHILD);
-    }
- done:
-    return 0;
-}
-
-/*! Free all streams
- *
- * Typically called on restconf exit
- */
-int
-stream_child_freeall(clixon_handle h)
-{
-    struct stream_child *sc;
-
-    while ((sc = STREAM_CHILD) != NULL){
-        DELQ(sc, STREAM_CHILD, struct stream_child *);
-        FCGX_Free(&sc->sc_r, 1); /* XXX pointer to actual copied struct */
-        free(sc);
-    }
-    return 0;
+    return -1;
 }
 
 /*! Callback when stream notifications arrive from backend
@@ -305,6 +250,7 @@ stream_timeout_end(int   s,
  * @param[in]  req     Generic Www handle (can be part of clixon handle)
  * @param[in]  timeout Stream timeout
  * @param[in]  besock  Socket to backend
+ * @param[in]  name    Stream name if subscription is shared, not used
  * @param[out] finish  Set to zero, if request should not be finnished by upper layer
  * @retval     0       OK
  * @retval    -1       Error
@@ -315,80 +261,45 @@ stream_sockets_setup(clixon_handle h,
                      void         *req,
                      int           timeout,
                      int           besock,
+                     char         *name,
                      int          *finish)
 {
     int            retval = -1;
     FCGX_Request  *rfcgi = (FCGX_Request *)req; /* XXX */
-#ifdef STREAM_FORK
-    int            pid;
-    struct stream_child *sc;
 
-    if ((pid = fork()) == 0){ /* child */
-#if 0 // Leaks
-        if (pvec)
-            free(pvec);
-        if (qvec)
-            cvec_free(qvec);
-        if (pcvec)
-            cvec_free(pcvec);
-#endif
-#endif /* STREAM_FORK */
-        backend_eof = 0;
-        /* Listen to backend socket */
-        if (clixon_event_reg_fd(besock,
-                                stream_fcgi_backend_cb,
-                                req,
-                                "stream socket") < 0)
-            goto done;
-        if (clixon_event_reg_fd(rfcgi->listen_sock,
-                                stream_fcgi_uplink_cb,
-                                req,
-                                "stream socket") < 0)
-            goto done;
-        /* Timeout of notification stream, close after limited lifetime, for debug */
-        if (timeout){
-            struct timeval   t;
-            gettimeofday(&t, NULL);
-            t.tv_sec += timeout;
-            clixon_event_reg_timeout(t, stream_timeout_end, req, "Stream timeout");
-        }
-        /* Poll upstream errors */
-        fcgi_stream_timeout(0, req);
-        /* Start loop */
-        clixon_event_loop(h);
-        clixon_debug(CLIXON_DBG_STREAM, "after loop");
-        if (backend_eof == 0)
-            if (clicon_rpc_close_session(h) < 0)
-                goto done;
-        clixon_event_unreg_fd(besock, stream_fcgi_backend_cb);
-        close(besock);
-        clixon_event_unreg_fd(rfcgi->listen_sock, stream_fcgi_uplink_cb);
-        clixon_event_unreg_timeout(fcgi_stream_timeout, (void*)req);
-        clixon_event_unreg_timeout(stream_timeout_end, (void*)req);
-        clixon_exit_set(0); /* reset */
-#ifdef STREAM_FORK
-#if 0 /* Seems to be a global resource, but there is till some timing error here */
-        FCGX_Finish_r(rfcgi);
-        FCGX_Free(rfcgi, 0);
-#endif
-        restconf_terminate(h);
-        exit(0);
-    }
-    /* parent */
-    /* Create stream_child struct and store pid and FCGI data, when child
-     * killed, call FCGX_Free
-     */
-    if ((sc = malloc(sizeof(struct stream_child))) == NULL){
-        clixon_err(OE_XML, errno, "malloc");
+    backend_eof = 0;
+    /* Listen to backend socket */
+    if (clixon_event_reg_fd(besock,
+                            stream_fcgi_backend_cb,
+                            req,
+                            "stream socket") < 0)
+        goto done;
+    if (clixon_event_reg_fd(rfcgi->listen_sock,
+                            stream_fcgi_uplink_cb,
+                            req,
+                            "stream socket") < 0)
         goto done;
+    /* Timeout of notification stream, close after limited lifetime, for debug */
+    if (timeout){
+        struct timeval   t;
+        gettimeofday(&t, NULL);
+        t.tv_sec += timeout;
+        clixon_event_reg_timeout(t, stream_timeout_end, req, "Stream timeout");
     }
-    memset(sc, 0, sizeof(struct stream_child));
-    sc->sc_pid = pid;
-    sc->sc_r = *rfcgi; /* XXX by value */
-
-    ADDQ(sc, STREAM_CHILD);
-    *finish = 0; /* If spawn child, we should not finish this stream */
-#endif /* STREAM_FORK */
+    /* Poll upstream errors */
+    fcgi_stream_timeout(0, req);
+    /* Start loop */
+    clixon_event_loop(h);
+    clixon_debug(CLIXON_DBG_STREAM, "after loop");
+    if (backend_eof == 0)
+        if (clicon_rpc_close_session(h) < 0)
+            goto done;
+    clixon_event_unreg_fd(besock, stream_fcgi_backend_cb);
+    close(besock);
+    clixon_event_unreg_fd(rfcgi->listen_sock, stream_fcgi_uplink_cb);
+    clixon_event_unreg_timeout(fcgi_stream_timeout, (void*)req);
+    clixon_event_unreg_timeout(stream_timeout_end, (void*)req);
+    clixon_exit_set(0); /* reset */
     retval = 0;
  done:
     clixon_debug(CLIXON_DBG_STREAM, "retval:%d", retval);
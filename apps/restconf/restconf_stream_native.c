@@ -60,6 +60,7 @@
 #include <sys/socket.h>
 #include <arpa/inet.h>
 #include <sys/resource.h>
+#include <poll.h>
 
 #include <openssl/ssl.h>
 #include <openssl/rand.h>
@@ -87,7 +88,34 @@
 
 #ifdef HAVE_LIBNGHTTP2
 #include "restconf_nghttp2.h"
+#endif
+
+/* Client of a backend subscription, ie an event stream request
+ */
+typedef struct stream_client{
+    qelem_t               sc_qelem;  /* List header */
+    struct stream_sub    *sc_sub;    /* Backend subscription */
+    restconf_stream_data *sc_sd;     /* Event stream request */
+    cbuf                 *sc_queue;  /* Encoded events not yet written */
+    int                   sc_wait;   /* Waiting for socket to be writable */
+    int                   sc_drop;   /* 1: Events dropped since queue full, 2: Disconnected */
+} stream_client;
+
+/* Backend subscription of a notification stream
+ * Requests of the same stream without start-time or stop-time share one subscription.
+ * Each notification is encoded once and queued to all clients.
+ */
+typedef struct stream_sub{
+    qelem_t               ss_qelem;   /* List header */
+    char                 *ss_name;    /* Stream name, NULL if not shared */
+    int                   ss_s;       /* Backend notification socket */
+    stream_client        *ss_clients; /* Clients of subscription */
+} stream_sub;
+
+/* List of backend subscriptions */
+static stream_sub *_stream_subs = NULL;
 
+#ifdef HAVE_LIBNGHTTP2
 static int
 restconf_http2_send_notification(clixon_handle         h,
                                  restconf_stream_data *sd,
@@ -98,15 +126,13 @@ restconf_http2_send_notification(clixon_handle         h,
     nghttp2_session      *session;
     nghttp2_error         ngerr;
     nghttp2_data_provider data_prd;
-    int32_t               stream_id;
 
     data_prd.source.ptr = sd;
     data_prd.read_callback = restconf_sd_read;
     session = rc->rc_ngsession;
-    stream_id = 1;
     if ((ngerr = nghttp2_submit_data(session,
                                      0, // flags
-                                     stream_id,
+                                     sd->sd_stream_id,
                                      (data_prd.source.ptr != NULL)?&data_prd:NULL
                                      )) < 0){
         clixon_err(OE_NGHTTP2, ngerr, "nghttp2_submit_response");
@@ -118,10 +144,193 @@ restconf_http2_send_notification(clixon_handle         h,
 }
 #endif // NGHTTP2
 
+/*! Get backend socket of shared subscription of a stream
+ *
+ * @param[in]  h     Clixon handle
+ * @param[in]  name  Stream name
+ * @retval     s     Backend notification socket
+ * @retval    -1     No shared subscription of stream
+ */
+int
+stream_shared_socket(clixon_handle h,
+                     char         *name)
+{
+    stream_sub *ss;
+
+    if ((ss = _stream_subs) != NULL){
+        do {
+            if (ss->ss_name && strcmp(ss->ss_name, name) == 0)
+                return ss->ss_s;
+            ss = NEXTQ(stream_sub *, ss);
+        } while (ss && ss != _stream_subs);
+    }
+    return -1;
+}
+
+static int stream_client_writable(int fd, void *arg);
+
+/*! Disconnect client, the read of the socket fails and closes the connection
+ *
+ * The connection is not closed here since clients of the subscription may be traversed
+ */
+static void
+stream_client_disconnect(stream_client *sc)
+{
+    restconf_conn *rc = sc->sc_sd->sd_conn;
+
+    if (sc->sc_wait){
+        clixon_event_unreg_fd_write(rc->rc_s, stream_client_writable);
+        sc->sc_wait = 0;
+    }
+    if (sc->sc_queue)
+        cbuf_reset(sc->sc_queue);
+    shutdown(rc->rc_s, SHUT_RDWR);
+    sc->sc_drop = 2;
+}
+
+/*! Write queued events of client
+ *
+ * @param[in]  h   Clixon handle
+ * @param[in]  sc  Stream client
+ * @retval     0   OK, or client disconnected
+ * @retval    -1   Error
+ */
+static int
+stream_client_write(clixon_handle  h,
+                    stream_client *sc)
+{
+    int                   retval = -1;
+    restconf_stream_data *sd = sc->sc_sd;
+    restconf_conn        *rc = sd->sd_conn;
+    int                   ret;
+
+    if (sc->sc_queue == NULL || cbuf_len(sc->sc_queue) == 0)
+        goto ok;
+#ifdef HAVE_LIBNGHTTP2
+    if (rc->rc_proto == HTTP_2){
+        if (restconf_reply_send(sd, 200, sc->sc_queue, 0) < 0)
+            goto done;
+        sc->sc_queue = NULL;
+        if (restconf_http2_send_notification(h, sd, rc) < 0)
+            goto done;
+        if (http2_session_send(rc) != 0)
+            goto done;
+        if (sd->sd_body){
+            cbuf_free(sd->sd_body);
+            sd->sd_body = NULL;
+        }
+    }
+    else
+#endif // HAVE_LIBNGHTTP2
+        {
+            if ((ret = native_buf_write(h, cbuf_get(sc->sc_queue), cbuf_len(sc->sc_queue),
+                                        rc, "native stream")) < 0)
+                goto done;
+            if (ret == 0){
+                stream_client_disconnect(sc);
+                goto ok;
+            }
+            cbuf_reset(sc->sc_queue);
+        }
+    if (sc->sc_drop == 1){
+        clixon_log(h, LOG_NOTICE, "stream %s: events resumed", sd->sd_path?sd->sd_path:"");
+        sc->sc_drop = 0;
+    }
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Writable callback of client socket: write queued events and unregister
+ *
+ * @param[in]  fd   Client socket
+ * @param[in]  arg  Stream client
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+stream_client_writable(int   fd,
+                       void *arg)
+{
+    stream_client *sc = (stream_client *)arg;
+
+    clixon_event_unreg_fd_write(fd, stream_client_writable);
+    sc->sc_wait = 0;
+    return stream_client_write(sc->sc_sd->sd_conn->rc_h, sc);
+}
+
+/*! Queue event to client and write it if socket is writable
+ *
+ * If the queue of the client exceeds CLICON_STREAM_QUEUE_MAX, CLICON_STREAM_QUEUE_POLICY
+ * decides if the event is dropped or if the client is disconnected.
+ * @param[in]  h    Clixon handle
+ * @param[in]  sc   Stream client
+ * @param[in]  cb   Encoded event
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+stream_client_send(clixon_handle  h,
+                   stream_client *sc,
+                   cbuf          *cb)
+{
+    int            retval = -1;
+    restconf_conn *rc = sc->sc_sd->sd_conn;
+    uint32_t       max;
+    char          *policy;
+    struct pollfd  pfd = {0,};
+
+    if (sc->sc_drop == 2) /* Disconnected */
+        goto ok;
+    if (sc->sc_queue == NULL && (sc->sc_queue = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    max = clicon_option_int(h, "CLICON_STREAM_QUEUE_MAX");
+    if (max && cbuf_len(sc->sc_queue) + cbuf_len(cb) > max){
+        policy = clicon_option_str(h, "CLICON_STREAM_QUEUE_POLICY");
+        if (policy && strcmp(policy, "disconnect") == 0){
+            clixon_log(h, LOG_WARNING, "stream %s: event queue full, disconnected",
+                       sc->sc_sd->sd_path?sc->sc_sd->sd_path:"");
+            stream_client_disconnect(sc);
+        }
+        else if (sc->sc_drop == 0){
+            clixon_log(h, LOG_WARNING, "stream %s: event queue full, events dropped",
+                       sc->sc_sd->sd_path?sc->sc_sd->sd_path:"");
+            sc->sc_drop = 1;
+        }
+        goto ok;
+    }
+    if (cbuf_append_buf(sc->sc_queue, cbuf_get(cb), cbuf_len(cb)) < 0){
+        clixon_err(OE_UNIX, errno, "cbuf_append_buf");
+        goto done;
+    }
+    /* If waiting, the queue is written when the socket is writable */
+    if (sc->sc_wait)
+        goto ok;
+    pfd.fd = rc->rc_s;
+    pfd.events = POLLOUT;
+    if (poll(&pfd, 1, 0) == 1 && (pfd.revents & POLLOUT)){
+        if (stream_client_write(h, sc) < 0)
+            goto done;
+    }
+    else {
+        if (clixon_event_reg_fd_write(rc->rc_s, stream_client_writable, sc, "stream events") < 0)
+            goto done;
+        sc->sc_wait = 1;
+    }
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Callback when stream notifications arrive from backend
  *
+ * The notification is encoded once and queued to all clients of the subscription
  * @param[in]  s    Socket
- * @param[in]  req  Generic Www handle (can be part of clixon handle)
+ * @param[in]  arg  Backend subscription
  * @retval     0    OK
  * @retval    -1    Error
  * @see netconf_notification_cb
@@ -131,30 +340,46 @@ stream_native_backend_cb(int   s,
                          void *arg)
 {
     int                   retval = -1;
-    restconf_stream_data *sd = (restconf_stream_data *)arg;
+    stream_sub           *ss = (stream_sub *)arg;
+    stream_client        *sc;
     int                   eof;
     cxobj                *xtop = NULL; /* top xml */
     cxobj                *xn;        /* notification xml */
-    cbuf                 *cbx = NULL;
     cbuf                 *cb = NULL;
     cbuf                 *cbmsg = NULL;
     int                   pretty = 0;
     int                   ret;
-    restconf_conn        *rc = sd->sd_conn;
-    clixon_handle         h = rc->rc_h;
-#ifdef HAVE_LIBNGHTTP2
-    nghttp2_error         ngerr;
-#endif
+    int                   n;
+    int                   i;
+    restconf_conn       **rcvec = NULL;
+    clixon_handle         h;
 
     clixon_debug(CLIXON_DBG_STREAM|CLIXON_DBG_DETAIL, "");
+    h = ss->ss_clients->sc_sd->sd_conn->rc_h;
     pretty = restconf_pretty_get(h);
     if (clixon_msg_rcv11(s, NULL, 0, &cbmsg, &eof) < 0)
         goto done;
     clixon_debug(CLIXON_DBG_STREAM, "%s", cbuf_get(cbmsg));
-    /* handle close from remote end: this will exit the client */
+    /* handle close from remote end: this will exit the clients */
     if (eof){
         clixon_debug(CLIXON_DBG_STREAM, "eof");
-        restconf_close_ssl_socket(rc, __FUNCTION__, 0);
+        /* Closing a client may free the subscription, close a copy of the clients */
+        n = 0;
+        sc = ss->ss_clients;
+        do {
+            n++;
+            sc = NEXTQ(stream_client *, sc);
+        } while (sc != ss->ss_clients);
+        if ((rcvec = calloc(n, sizeof(*rcvec))) == NULL){
+            clixon_err(OE_UNIX, errno, "calloc");
+            goto done;
+        }
+        for (i=0; i<n; i++){
+            rcvec[i] = sc->sc_sd->sd_conn;
+            sc = NEXTQ(stream_client *, sc);
+        }
+        for (i=0; i<n; i++)
+            restconf_close_ssl_socket(rcvec[i], __FUNCTION__, 0);
         goto ok;
     }
     if ((ret = clixon_xml_parse_string(cbuf_get(cbmsg), YB_NONE, NULL, &xtop, NULL)) < 0)
@@ -168,10 +393,6 @@ stream_native_backend_cb(int   s,
         clixon_err(OE_PLUGIN, errno, "cbuf_new");
         goto done;
     }
-    if ((cbx = cbuf_new()) == NULL){
-        clixon_err(OE_PLUGIN, errno, "cbuf_new");
-        goto done;
-    }
     if ((xn = xpath_first(xtop, NULL, "notification")) == NULL)
         goto ok;
     cprintf(cb, "data: ");
@@ -179,24 +400,12 @@ stream_native_backend_cb(int   s,
         goto done;
     cprintf(cb, "\r\n");
     cprintf(cb, "\r\n");
-#ifdef HAVE_LIBNGHTTP2
-    if (rc->rc_proto == HTTP_2){
-        if (restconf_reply_send(sd, 200, cb, 0) < 0)
-            goto done;
-        cb = NULL;
-        if (restconf_http2_send_notification(h, sd, rc) < 0)
-            goto done;
-        if ((ngerr = nghttp2_session_send(rc->rc_ngsession)) != 0)
+    sc = ss->ss_clients;
+    do {
+        if (stream_client_send(h, sc, cb) < 0)
             goto done;
-        if (sd->sd_body){
-            cbuf_free(sd->sd_body);
-            sd->sd_body = NULL;
-        }
-    }
-    else
-#endif // HAVE_LIBNGHTTP2
-        if ((ret = native_buf_write(h, cbuf_get(cb), cbuf_len(cb), rc, "native stream")) < 0)
-        goto done;
+        sc = NEXTQ(stream_client *, sc);
+    } while (sc != ss->ss_clients);
  ok:
     retval = 0;
  done:
@@ -207,8 +416,8 @@ stream_native_backend_cb(int   s,
         cbuf_free(cbmsg);
     if (cb)
         cbuf_free(cb);
-    if (cbx)
-        cbuf_free(cbx);
+    if (rcvec)
+        free(rcvec);
     return retval;
 }
 
@@ -233,7 +442,7 @@ stream_timeout_end(int   s,
             clixon_err(OE_NGHTTP2, ngerr, "nghttp2_session_terminate_session %d", ngerr);
             goto done; // XXX not here in original?
         }
-        if ((ngerr = nghttp2_session_send(rc->rc_ngsession)) != 0){
+        if ((ngerr = http2_session_send(rc)) != 0){
             clixon_err(OE_NGHTTP2, ngerr, "nghttp2_session_send %d", ngerr);
             goto done; // XXX not here in original?
         }
@@ -251,6 +460,7 @@ stream_timeout_end(int   s,
 /*! Close notification stream
  *
  * Only stream aspects, to close full socket, call eg restconf_close_ssl_socket
+ * The backend subscription is closed when its last client is closed.
  */
 int
 stream_close(clixon_handle h,
@@ -258,22 +468,54 @@ stream_close(clixon_handle h,
 
 {
     restconf_conn *rc = (restconf_conn *)req;
+    stream_sub    *ss;
+    stream_client *sc = NULL;
 
     clixon_debug(CLIXON_DBG_STREAM, "");
-    clicon_rpc_close_session(h);
-    clixon_event_unreg_fd(rc->rc_event_stream, stream_native_backend_cb);
     clixon_event_unreg_timeout(stream_timeout_end, req);
-    close(rc->rc_event_stream);
+    if ((ss = _stream_subs) != NULL){
+        do {
+            if ((sc = ss->ss_clients) != NULL){
+                do {
+                    if (sc->sc_sd->sd_conn == rc)
+                        goto found;
+                    sc = NEXTQ(stream_client *, sc);
+                } while (sc != ss->ss_clients);
+            }
+            ss = NEXTQ(stream_sub *, ss);
+        } while (ss && ss != _stream_subs);
+    }
+    rc->rc_event_stream = 0;
+    return 0;
+ found:
+    DELQ(sc, ss->ss_clients, stream_client *);
+    if (sc->sc_wait)
+        clixon_event_unreg_fd_write(rc->rc_s, stream_client_writable);
+    if (sc->sc_queue)
+        cbuf_free(sc->sc_queue);
+    free(sc);
     rc->rc_event_stream = 0;
+    if (ss->ss_clients == NULL){
+        clicon_rpc_close_session(h);
+        clixon_event_unreg_fd(ss->ss_s, stream_native_backend_cb);
+        close(ss->ss_s);
+        DELQ(ss, _stream_subs, stream_sub *);
+        if (ss->ss_name)
+            free(ss->ss_name);
+        free(ss);
+    }
     return 0;
 }
 
 /*! Native specific code for setting up stream sockets
  *
+ * Add the request as client of the backend subscription of the socket, create the
+ * subscription if it is new.
  * @param[in]  h       Clixon handle
  * @param[in]  req     Generic Www handle (can be part of clixon handle)
  * @param[in]  timeout Stream timeout
  * @param[in]  besock  Socket to backend
+ * @param[in]  name    Stream name if subscription is shared, else NULL
  * @param[out] finish  Set to zero, if request should not be finnished by upper layer
  * @retval     0       OK
  * @retval    -1       Error
@@ -284,18 +526,56 @@ stream_sockets_setup(clixon_handle h,
                      void         *req,
                      int           timeout,
                      int           besock,
+                     char         *name,
                      int          *finish)
 {
     int                   retval = -1;
     restconf_stream_data *sd = (restconf_stream_data *)req;
     restconf_conn        *rc;
+    stream_sub           *ss;
+    stream_client        *sc;
 
-    /* Listen to backend socket */
-    if (clixon_event_reg_fd(besock,
-                            stream_native_backend_cb,
-                            req,
-                            "stream socket") < 0)
+    if ((ss = _stream_subs) != NULL){
+        do {
+            if (ss->ss_s == besock)
+                break;
+            ss = NEXTQ(stream_sub *, ss);
+        } while (ss != _stream_subs);
+        if (ss->ss_s != besock)
+            ss = NULL;
+    }
+    if (ss == NULL){
+        if ((ss = malloc(sizeof(*ss))) == NULL){
+            clixon_err(OE_UNIX, errno, "malloc");
+            goto done;
+        }
+        memset(ss, 0, sizeof(*ss));
+        ss->ss_s = besock;
+        if (name && (ss->ss_name = strdup(name)) == NULL){
+            clixon_err(OE_UNIX, errno, "strdup");
+            free(ss);
+            goto done;
+        }
+        /* Listen to backend socket */
+        if (clixon_event_reg_fd(besock,
+                                stream_native_backend_cb,
+                                ss,
+                                "stream socket") < 0){
+            if (ss->ss_name)
+                free(ss->ss_name);
+            free(ss);
+            goto done;
+        }
+        ADDQ(ss, _stream_subs);
+    }
+    if ((sc = malloc(sizeof(*sc))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
         goto done;
+    }
+    memset(sc, 0, sizeof(*sc));
+    sc->sc_sub = ss;
+    sc->sc_sd = sd;
+    ADDQ(sc, ss->ss_clients);
     rc = sd->sd_conn;
     rc->rc_event_stream = besock;
     /* Timeout of notification stream, close after limited lifetime, for debug */
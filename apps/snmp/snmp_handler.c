@@ -43,6 +43,7 @@
 #include <syslog.h>
 #include <errno.h>
 #include <sys/types.h>
+#include <sys/time.h>
 #include <signal.h>
 
 /* net-snmp */
@@ -1143,68 +1144,94 @@ snmp_table_set(clixon_handle               h,
     goto done;
 }
 
-/*! Find "next" object from oids minus key and return that.
+/*! Compare the OIDs of two table snapshot entries, for qsort
+ */
+static int
+snmp_table_entry_cmp(const void *a,
+                     const void *b)
+{
+    const struct snmp_table_entry *ste0 = (const struct snmp_table_entry *)a;
+    const struct snmp_table_entry *ste1 = (const struct snmp_table_entry *)b;
+
+    return snmp_oid_compare(ste0->ste_oid, ste0->ste_oidlen, ste1->ste_oid, ste1->ste_oidlen);
+}
+
+/*! Get snapshot of a table sorted by OID, get it from backend if not cached
  *
- * @param[in]  h        Clixon handle
- * @param[in]  ylist    Yang of table (of list type)
- * @param[in]  oids     OID of ultimate scalar value
- * @param[in]  oidslen  OID length of scalar
- * @param[in]  reqinfo  Agent transaction request structure
- * @param[in]  request The netsnmp request info structure.
- * @retval     1        OK
- * @retval     0        Failed
+ * A snapshot is reused until it is older than CLICON_SNMP_TABLE_CACHE_TTL, so that a walk
+ * of a table makes one backend get instead of one per object.
+ * A snapshot is also reused by all varbinds of the PDU it was fetched for, including all
+ * repetitions of a GETBULK, which net-snmp gives to the handler one repetition at a time.
+ * @param[in]  sh       Clixon snmp handle of table
+ * @param[in]  transid  Transaction id of PDU, or 0
+ * @param[out] stsp     Table snapshot, do not free, kept in sh
+ * @retval     0        OK
  * @retval    -1        Error
- * XXX: merge with cache
  */
 static int
-snmp_table_getnext(clixon_handle               h,
-                   yang_stmt                  *ylist,
-                   oid                        *oids,
-                   size_t                      oidslen,
-                   netsnmp_agent_request_info *reqinfo,
-                   netsnmp_request_info       *request)
+snmp_table_snapshot(clixon_snmp_handle          *sh,
+                    long                         transid,
+                    struct snmp_table_snapshot **stsp)
 {
-    int        retval = -1;
-    cvec      *nsc = NULL;
-    char      *xpath = NULL;
-    cxobj     *xt = NULL;
-    cxobj     *xerr;
-    cxobj     *xtable;
-    cxobj     *xrow;
-    cxobj     *xcol;
-    yang_stmt *ycol;
-    yang_stmt *ys;
-    int        ret;
-    cvec      *cvk_name;
-    oid        oidc[MAX_OID_LEN] = {0,}; /* Table / list oid */
-    size_t     oidclen = MAX_OID_LEN;
-    oid        oidk[MAX_OID_LEN] = {0,}; /* Key oid */
-    size_t     oidklen = MAX_OID_LEN;
-    oid        oidnext[MAX_OID_LEN] = {0x7fffffff,}; /* Next oid: start with high value */
-    size_t     oidnextlen = MAX_OID_LEN;
-    int        found = 0;
-    cxobj     *xnext = NULL;
-    yang_stmt *ynext = NULL;
-    cbuf      *cb = NULL;
+    int                         retval = -1;
+    clixon_handle               h = sh->sh_h;
+    yang_stmt                  *ylist = sh->sh_ys;
+    struct snmp_table_snapshot *sts = NULL;
+    struct snmp_table_entry    *ste;
+    struct timeval              now;
+    struct timeval              td;
+    uint32_t                    ttl;
+    cvec                       *nsc = NULL;
+    char                       *xpath = NULL;
+    cxobj                      *xerr;
+    cxobj                      *xtable;
+    cxobj                      *xrow;
+    cxobj                      *xcol;
+    yang_stmt                  *ycol;
+    yang_stmt                  *ys;
+    cvec                       *cvk_name;
+    oid                         oidc[MAX_OID_LEN] = {0,}; /* Column oid */
+    size_t                      oidclen;
+    oid                         oidk[MAX_OID_LEN] = {0,}; /* Key oid */
+    size_t                      oidklen = MAX_OID_LEN;
+    int                         veclen = 0;
+    int                         ret;
 
-    clixon_debug(CLIXON_DBG_SNMP, "");
+    gettimeofday(&now, NULL);
+    ttl = clicon_option_int(h, "CLICON_SNMP_TABLE_CACHE_TTL");
+    if ((sts = sh->sh_snapshot) != NULL){
+        timersub(&now, &sts->sts_time, &td);
+        if ((transid != 0 && sts->sts_transid == transid) ||
+            (ttl > 0 && td.tv_sec >= 0 &&
+             td.tv_sec*1000 + td.tv_usec/1000 < ttl)){
+            *stsp = sts;
+            goto ok;
+        }
+        snmp_table_snapshot_free(sts);
+        sh->sh_snapshot = sts = NULL;
+    }
     if ((ys = yang_parent_get(ylist)) == NULL ||
         yang_keyword_get(ys) != Y_CONTAINER){
         clixon_err(OE_YANG, EINVAL, "ylist parent is not list");
         goto done;
     }
+    if ((sts = calloc(1, sizeof(*sts))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    sts->sts_time = now;
+    sts->sts_transid = transid;
     if (xml_nsctx_yang(ys, &nsc) < 0)
         goto done;
     if (snmp_yang2xpath(ys, NULL, &xpath) < 0)
         goto done;
-    if (clicon_rpc_get(h, xpath, nsc, CONTENT_ALL, -1, NULL, &xt) < 0)
+    if (clicon_rpc_get(h, xpath, nsc, CONTENT_ALL, -1, NULL, &sts->sts_xt) < 0)
         goto done;
-    if ((xerr = xpath_first(xt, NULL, "/rpc-error")) != NULL){
+    if ((xerr = xpath_first(sts->sts_xt, NULL, "/rpc-error")) != NULL){
         clixon_err_netconf(h, OE_NETCONF, 0, xerr, "Get configuration");
         goto done;
     }
-    if ((xtable = xpath_first(xt, nsc, "%s", xpath)) != NULL) {
-        /* Make a clone of key-list, but replace names with values */
+    if ((xtable = xpath_first(sts->sts_xt, nsc, "%s", xpath)) != NULL) {
         if ((cvk_name = yang_cvec_get(ylist)) == NULL){
             clixon_err(OE_YANG, 0, "No keys");
             goto done;
@@ -1212,7 +1239,8 @@ snmp_table_getnext(clixon_handle               h,
         xrow = NULL;
         while ((xrow = xml_child_each(xtable, xrow, CX_ELMNT)) != NULL) {
             /* Get key part of OID from XML list entry */
-            if ((ret = snmp_xmlkey2val_oid(xrow, cvk_name, NULL, /*&cvk_oid,*/ oidk, &oidklen)) < 0)
+            oidklen = MAX_OID_LEN;
+            if ((ret = snmp_xmlkey2val_oid(xrow, cvk_name, NULL, oidk, &oidklen)) < 0)
                 goto done;
             if (ret == 0)
                 continue; /* skip row, not all indexes */
@@ -1222,6 +1250,7 @@ snmp_table_getnext(clixon_handle               h,
                     continue;
                 if (yang_keyword_get(ycol) != Y_LEAF)
                     continue;
+                oidclen = MAX_OID_LEN;
                 if ((ret = yangext_oid_get(ycol, oidc, &oidclen, NULL)) < 0)
                     goto done;
                 if (ret == 0)
@@ -1229,41 +1258,178 @@ snmp_table_getnext(clixon_handle               h,
                 /* Append key oid */
                 if (oid_append(oidc, &oidclen, oidk, oidklen) < 0)
                     goto done;
-                /* Get smallest larger */
-                if (oid_eq(oidc, oidclen, oids, oidslen) > 0 &&
-                    oid_eq(oidc, oidclen, oidnext, oidnextlen) < 0){
-                    memcpy(oidnext, oidc, oidclen*sizeof(*oidnext));
-                    oidnextlen = oidclen;
-                    xnext = xcol;
-                    ynext = ycol;
-                    found++;
+                if (sts->sts_len >= veclen){
+                    veclen = veclen ? 2*veclen : 64;
+                    if ((ste = realloc(sts->sts_vec, veclen*sizeof(*ste))) == NULL){
+                        clixon_err(OE_UNIX, errno, "realloc");
+                        goto done;
+                    }
+                    sts->sts_vec = ste;
+                }
+                ste = &sts->sts_vec[sts->sts_len];
+                if ((ste->ste_oid = malloc(oidclen*sizeof(oid))) == NULL){
+                    clixon_err(OE_UNIX, errno, "malloc");
+                    goto done;
                 }
+                memcpy(ste->ste_oid, oidc, oidclen*sizeof(oid));
+                ste->ste_oidlen = oidclen;
+                ste->ste_x = xcol;
+                ste->ste_y = ycol;
+                sts->sts_len++;
             } /* while xcol */
         } /* while xrow */
     }
-    if (found){
-        if (snmp_scalar_return(xnext, ynext, oidnext, oidnextlen, reqinfo, request) < 0)
-            goto done;
-        if ((cb = cbuf_new()) == NULL){
-            clixon_err(OE_UNIX, errno, "cbuf_new");
-            goto done;
-        }
-        oid_cbuf(cb, oidnext, oidnextlen);
-        clixon_debug(CLIXON_DBG_SNMP, "next: %s", cbuf_get(cb));
-    }
-    retval = found;
+    if (sts->sts_len > 1)
+        qsort(sts->sts_vec, sts->sts_len, sizeof(*sts->sts_vec), snmp_table_entry_cmp);
+    clixon_debug(CLIXON_DBG_SNMP, "snapshot: %d objects", sts->sts_len);
+    sh->sh_snapshot = sts;
+    *stsp = sts;
+    sts = NULL;
+ ok:
+    retval = 0;
  done:
-    if (cb)
-        cbuf_free(cb);
+    if (sts && sts != sh->sh_snapshot)
+        snmp_table_snapshot_free(sts);
     if (xpath)
         free(xpath);
-    if (xt)
-        xml_free(xt);
     if (nsc)
         xml_nsctx_free(nsc);
     return retval;
 }
 
+/*! Find entry in table snapshot with binary search
+ *
+ * @param[in]  sts      Table snapshot
+ * @param[in]  oids     OID to search for
+ * @param[in]  oidslen  OID length
+ * @param[in]  next     0: entry with equal OID, 1: first entry with larger OID
+ * @retval     ste      Entry
+ * @retval     NULL     Not found
+ */
+static struct snmp_table_entry *
+snmp_table_snapshot_find(struct snmp_table_snapshot *sts,
+                         oid                        *oids,
+                         size_t                      oidslen,
+                         int                         next)
+{
+    struct snmp_table_entry *ste;
+    int                      low = 0;
+    int                      high = sts->sts_len;
+    int                      mid;
+    int                      cmp;
+
+    /* Find first entry with OID larger than (next) or equal to (!next) oids */
+    while (low < high){
+        mid = (low + high) / 2;
+        ste = &sts->sts_vec[mid];
+        cmp = snmp_oid_compare(ste->ste_oid, ste->ste_oidlen, oids, oidslen);
+        if (cmp < 0 || (next && cmp == 0))
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    if (low == sts->sts_len)
+        return NULL;
+    ste = &sts->sts_vec[low];
+    if (!next &&
+        snmp_oid_compare(ste->ste_oid, ste->ste_oidlen, oids, oidslen) != 0)
+        return NULL;
+    return ste;
+}
+
+/*! Get object from a cached table snapshot
+ *
+ * Only if CLICON_SNMP_TABLE_CACHE_TTL is set, if the PDU has several varbinds of the table,
+ * or if the PDU already has a snapshot, and if there are no pending row creations.
+ * Objects not in the snapshot, such as defaults, are handled by snmp_table_get
+ * @param[in]  sh       Clixon snmp handle of table
+ * @param[in]  transid  Transaction id of PDU, or 0
+ * @param[in]  multi    The PDU has several varbinds of the table
+ * @param[in]  oids     OID of ultimate scalar value
+ * @param[in]  oidslen  OID length of scalar
+ * @param[in]  reqinfo  Agent transaction request structure
+ * @param[in]  request  The netsnmp request info structure.
+ * @retval     1        OK
+ * @retval     0        Not found in snapshot
+ * @retval    -1        Error
+ */
+static int
+snmp_table_get_cached(clixon_snmp_handle         *sh,
+                      long                        transid,
+                      int                         multi,
+                      oid                        *oids,
+                      size_t                      oidslen,
+                      netsnmp_agent_request_info *reqinfo,
+                      netsnmp_request_info       *request)
+{
+    struct snmp_table_snapshot *sts = NULL;
+    struct snmp_table_entry    *ste;
+    cxobj                      *xcache = NULL;
+
+    if (clicon_option_int(sh->sh_h, "CLICON_SNMP_TABLE_CACHE_TTL") == 0 && !multi &&
+        (transid == 0 || sh->sh_snapshot == NULL || sh->sh_snapshot->sts_transid != transid))
+        return 0;
+    clicon_ptr_get(sh->sh_h, "snmp-rowstatus-tree", (void**)&xcache);
+    if (xcache != NULL)
+        return 0;
+    if (snmp_table_snapshot(sh, transid, &sts) < 0)
+        return -1;
+    if ((ste = snmp_table_snapshot_find(sts, oids, oidslen, 0)) == NULL)
+        return 0;
+    if (snmp_scalar_return(ste->ste_x, ste->ste_y, ste->ste_oid, ste->ste_oidlen, reqinfo, request) < 0)
+        return -1;
+    return 1;
+}
+
+/*! Find "next" object from oids minus key and return that.
+ *
+ * The next object is found with binary search in a snapshot of the table
+ * @param[in]  sh       Clixon snmp handle of table
+ * @param[in]  transid  Transaction id of PDU, or 0
+ * @param[in]  oids     OID of ultimate scalar value
+ * @param[in]  oidslen  OID length of scalar
+ * @param[in]  reqinfo  Agent transaction request structure
+ * @param[in]  request The netsnmp request info structure.
+ * @retval     1        OK
+ * @retval     0        Failed
+ * @retval    -1        Error
+ * @see snmp_table_snapshot
+ */
+static int
+snmp_table_getnext(clixon_snmp_handle         *sh,
+                   long                        transid,
+                   oid                        *oids,
+                   size_t                      oidslen,
+                   netsnmp_agent_request_info *reqinfo,
+                   netsnmp_request_info       *request)
+{
+    int                         retval = -1;
+    struct snmp_table_snapshot *sts = NULL;
+    struct snmp_table_entry    *ste;
+    cbuf                       *cb = NULL;
+
+    clixon_debug(CLIXON_DBG_SNMP, "");
+    if (snmp_table_snapshot(sh, transid, &sts) < 0)
+        goto done;
+    if ((ste = snmp_table_snapshot_find(sts, oids, oidslen, 1)) == NULL){
+        retval = 0;
+        goto done;
+    }
+    if (snmp_scalar_return(ste->ste_x, ste->ste_y, ste->ste_oid, ste->ste_oidlen, reqinfo, request) < 0)
+        goto done;
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    oid_cbuf(cb, ste->ste_oid, ste->ste_oidlen);
+    clixon_debug(CLIXON_DBG_SNMP, "next: %s", cbuf_get(cb));
+    retval = 1;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
 /*! SNMP table operation handler
  *
  * @param[in]  handler Registered MIB handler structure
@@ -1287,6 +1453,7 @@ clixon_snmp_table_handler1(netsnmp_mib_handler          *handler,
     int                     ret;
     netsnmp_variable_list  *requestvb;
     int                     err = 0;
+    long                    transid = 0; /* PDU of request */
 
     clixon_debug(CLIXON_DBG_SNMP | CLIXON_DBG_DETAIL, "");
     if ((ret = snmp_common_handler(handler, nhreg, reqinfo, request, 1, &sh)) < 0)
@@ -1296,8 +1463,17 @@ clixon_snmp_table_handler1(netsnmp_mib_handler          *handler,
         goto ok;
     }
     requestvb = request->requestvb;
+    if (reqinfo->asp && reqinfo->asp->pdu)
+        transid = reqinfo->asp->pdu->transid;
     switch(reqinfo->mode){
     case MODE_GET: // 160
+        if ((ret = snmp_table_get_cached(sh, transid,
+                                         request->next != NULL || request->prev != NULL,
+                                         requestvb->name, requestvb->name_length,
+                                         reqinfo, request)) < 0)
+            goto done;
+        if (ret == 1)
+            break;
         /* Create xpath from YANG table OID + 1 + n + cvk/key = requestvb->name 
          */
         if ((ret = snmp_table_get(sh->sh_h, sh->sh_ys,
@@ -1315,7 +1491,7 @@ clixon_snmp_table_handler1(netsnmp_mib_handler          *handler,
         break;
     case MODE_GETNEXT: // 161
         /* Register table sub-oid:s of existing entries in clixon */
-        if ((ret = snmp_table_getnext(sh->sh_h, sh->sh_ys,
+        if ((ret = snmp_table_getnext(sh, transid,
                                       requestvb->name, requestvb->name_length,
                                       reqinfo, request)) < 0)
             goto done;
@@ -1338,6 +1514,11 @@ clixon_snmp_table_handler1(netsnmp_mib_handler          *handler,
     case MODE_SET_RESERVE2: // 1
         break;
     case MODE_SET_ACTION:   // 2
+        /* Table is changed, next get makes a new snapshot */
+        if (sh->sh_snapshot){
+            snmp_table_snapshot_free(sh->sh_snapshot);
+            sh->sh_snapshot = NULL;
+        }
         if ((ret = snmp_table_set(sh->sh_h, sh->sh_ys,
                                   requestvb->name, requestvb->name_length,
                                   reqinfo, request, &err)) < 0)
@@ -51,6 +51,7 @@
 #endif
 
 #include <stdio.h>
+#include <stdint.h>
 #include <unistd.h>
 #include <pwd.h>
 #include <syslog.h>
@@ -444,6 +445,78 @@ yang_extension_value_opt(yang_stmt *ys,
     return retval;
 }
 
+/*! Compiled SNMP mapping of one YANG node
+ *
+ * Keeps the result of resolving the smiv2 extensions and types of a YANG node, so that
+ * requests do not resolve them again.
+ * @see snmp_yang_map_get
+ */
+struct snmp_yang_map {
+    struct snmp_yang_map *sm_next;     /* Next in bucket */
+    yang_stmt            *sm_ys;       /* YANG node */
+    int                   sm_oidret;   /* yangext_oid_get: 1: OID, 0: no OID, -1: not resolved */
+    oid                  *sm_oid;      /* OID of smiv2:oid, if sm_oidret is 1 */
+    size_t                sm_oidlen;
+    char                 *sm_oidstr;   /* smiv2:oid string, direct pointer to YANG extension */
+    int                   sm_asn1[2];  /* type_yang2asn1 not extended/extended, or -1 */
+};
+
+#define SNMP_YANG_MAP_BUCKETS 1024
+static struct snmp_yang_map *_snmp_yang_map[SNMP_YANG_MAP_BUCKETS] = {NULL,};
+static uint64_t              _snmp_yang_map_gen = 0; /* YANG generation of mapping */
+
+/*! Free all compiled SNMP mappings of YANG nodes
+ */
+void
+snmp_yang_map_free(void)
+{
+    struct snmp_yang_map *sm;
+    int                   i;
+
+    for (i=0; i<SNMP_YANG_MAP_BUCKETS; i++)
+        while ((sm = _snmp_yang_map[i]) != NULL){
+            _snmp_yang_map[i] = sm->sm_next;
+            if (sm->sm_oid)
+                free(sm->sm_oid);
+            free(sm);
+        }
+}
+
+/*! Get compiled SNMP mapping of YANG node, create an empty mapping if not found
+ *
+ * The mapping is removed if YANG statements are created or freed, since it points to
+ * YANG nodes, see yang_stats_generation
+ * @param[in]  ys   YANG node
+ * @retval     sm   Mapping
+ * @retval     NULL Error
+ */
+static struct snmp_yang_map *
+snmp_yang_map_get(yang_stmt *ys)
+{
+    struct snmp_yang_map *sm;
+    uint64_t              gen;
+    int                   i;
+
+    if ((gen = yang_stats_generation()) != _snmp_yang_map_gen){
+        snmp_yang_map_free();
+        _snmp_yang_map_gen = gen;
+    }
+    i = ((uintptr_t)ys >> 4) % SNMP_YANG_MAP_BUCKETS;
+    for (sm = _snmp_yang_map[i]; sm; sm = sm->sm_next)
+        if (sm->sm_ys == ys)
+            return sm;
+    if ((sm = calloc(1, sizeof(*sm))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        return NULL;
+    }
+    sm->sm_ys = ys;
+    sm->sm_oidret = -1;
+    sm->sm_asn1[0] = sm->sm_asn1[1] = -1;
+    sm->sm_next = _snmp_yang_map[i];
+    _snmp_yang_map[i] = sm;
+    return sm;
+}
+
 /*! Given a YANG node, return SMIv2 oid extension as OID 
  *
  * @param[in]  yn        Yang node
@@ -453,12 +526,13 @@ yang_extension_value_opt(yang_stmt *ys,
  * @retval     1         OK
  * @retval     0         Invalid, not found
  * @retval    -1         Error
+ * @see yangext_oid_get  Compiled mapping
  */
-int
-yangext_oid_get(yang_stmt *yn,
-                oid       *objid,
-                size_t    *objidlen,
-                char     **objidstrp)
+static int
+yangext_oid_get1(yang_stmt *yn,
+                 oid       *objid,
+                 size_t    *objidlen,
+                 char     **objidstrp)
 {
     int        retval = -1;
     int        exist = 0;
@@ -492,6 +566,55 @@ yangext_oid_get(yang_stmt *yn,
     goto done;
 }
 
+/*! Given a YANG node, return SMIv2 oid extension as OID, from compiled mapping
+ *
+ * The extension is only resolved the first time for each YANG node
+ * @param[in]  yn        Yang node
+ * @param[out] objid     OID vector, assume allocated with MAX_OID_LEN > oidlen
+ * @param[out] objidlen  Length of OID vector on return
+ * @param[out] objidstrp Pointer to string (direct not malloced) optional
+ * @retval     1         OK
+ * @retval     0         Invalid, not found
+ * @retval    -1         Error
+ */
+int
+yangext_oid_get(yang_stmt *yn,
+                oid       *objid,
+                size_t    *objidlen,
+                char     **objidstrp)
+{
+    struct snmp_yang_map *sm;
+    oid                   objid1[MAX_OID_LEN];
+    size_t                objid1len = MAX_OID_LEN;
+
+    if ((sm = snmp_yang_map_get(yn)) == NULL)
+        return -1;
+    if (sm->sm_oidret < 0){
+        if ((sm->sm_oidret = yangext_oid_get1(yn, objid1, &objid1len, &sm->sm_oidstr)) < 0)
+            return -1;
+        if (sm->sm_oidret == 1){
+            if ((sm->sm_oid = malloc(objid1len*sizeof(oid))) == NULL){
+                clixon_err(OE_UNIX, errno, "malloc");
+                sm->sm_oidret = -1;
+                return -1;
+            }
+            memcpy(sm->sm_oid, objid1, objid1len*sizeof(oid));
+            sm->sm_oidlen = objid1len;
+        }
+    }
+    if (sm->sm_oidret == 0)
+        return 0;
+    if (sm->sm_oidlen > *objidlen){
+        clixon_err(OE_XML, ENOBUFS, "snmp_parse_oid");
+        return -1;
+    }
+    memcpy(objid, sm->sm_oid, sm->sm_oidlen*sizeof(oid));
+    *objidlen = sm->sm_oidlen;
+    if (objidstrp)
+        *objidstrp = sm->sm_oidstr;
+    return 1;
+}
+
 /*! Given a YANG node, return 1 if leaf has oid directive in it, otherwise 0
  *
  * @param[in]  yn        Yang node
@@ -561,10 +684,33 @@ snmp_handle_free(void *arg)
             }
             free(sh->sh_table_info);
         }
+        if (sh->sh_snapshot)
+            snmp_table_snapshot_free(sh->sh_snapshot);
         free(sh);
     }
 }
 
+/*! Free table snapshot
+ *
+ * @param[in]  sts  Table snapshot
+ * @see snmp_table_snapshot
+ */
+void
+snmp_table_snapshot_free(struct snmp_table_snapshot *sts)
+{
+    int i;
+
+    if (sts->sts_vec){
+        for (i=0; i<sts->sts_len; i++)
+            if (sts->sts_vec[i].ste_oid)
+                free(sts->sts_vec[i].ste_oid);
+        free(sts->sts_vec);
+    }
+    if (sts->sts_xt)
+        xml_free(sts->sts_xt);
+    free(sts);
+}
+
 /*! Translate from YANG to SNMP asn1.1 type ids (not value)
  *
  * @param[in]    ys         YANG leaf node
@@ -575,11 +721,12 @@ snmp_handle_free(void *arg)
  * @see type_yang2snmp, yang only
  * @note there are some special cases where extended clixon asn1-types are used to convey info
  * to type_snmpstr2val, these types are prefixed with CLIXON_ASN_
+ * @see type_yang2asn1  Compiled mapping
  */
-int
-type_yang2asn1(yang_stmt    *ys,
-               int          *asn1_type,
-               int           extended)
+static int
+type_yang2asn1_1(yang_stmt    *ys,
+                 int          *asn1_type,
+                 int           extended)
 {
     int        retval = -1;
     char      *restype;         /* resolved type */
@@ -630,6 +777,36 @@ type_yang2asn1(yang_stmt    *ys,
     return retval;
 }
 
+/*! Translate from YANG to SNMP asn1.1 type ids (not value), from compiled mapping
+ *
+ * The type is only resolved the first time for each YANG node
+ * @param[in]    ys         YANG leaf node
+ * @param[out]   asn1_type  ASN.1 type id
+ * @param[in]    extended   Special case clixon extended types used in xml<->asn1 data conversions
+ * @retval       0          OK
+ * @retval      -1          Error
+ */
+int
+type_yang2asn1(yang_stmt    *ys,
+               int          *asn1_type,
+               int           extended)
+{
+    struct snmp_yang_map *sm;
+    int                   at;
+
+    if ((sm = snmp_yang_map_get(ys)) == NULL)
+        return -1;
+    extended = extended ? 1 : 0;
+    if (sm->sm_asn1[extended] < 0){
+        if (type_yang2asn1_1(ys, &at, extended) < 0)
+            return -1;
+        sm->sm_asn1[extended] = at;
+    }
+    if (asn1_type)
+        *asn1_type = sm->sm_asn1[extended];
+    return 0;
+}
+
 /*! Translate from yang/xml/clixon to SNMP/ASN.1
  *
  * @param[in]   snmpval  Malloc:ed snmp type
@@ -63,6 +63,25 @@ extern "C" {
 /*
  * Types 
  */
+/* Column value of one row in a table snapshot
+ */
+struct snmp_table_entry {
+    oid          *ste_oid;             /* OID of column with row index appended */
+    size_t        ste_oidlen;
+    cxobj        *ste_x;               /* XML leaf in snapshot tree */
+    yang_stmt    *ste_y;               /* YANG leaf */
+};
+
+/* Snapshot of a table sorted by OID, see CLICON_SNMP_TABLE_CACHE_TTL
+ */
+struct snmp_table_snapshot {
+    cxobj                   *sts_xt;   /* XML tree from backend */
+    struct snmp_table_entry *sts_vec;  /* Entries sorted by OID */
+    int                      sts_len;
+    struct timeval           sts_time; /* Time of backend get */
+    long                     sts_transid; /* Transaction id of PDU of backend get, or 0 */
+};
+
 /* Userdata to pass around in netsmp callbacks
  */
 struct clixon_snmp_handle {
@@ -76,6 +95,7 @@ struct clixon_snmp_handle {
     cvec         *sh_cvk_orig;         /* Index/Key variable values (original) */
     netsnmp_table_registration_info *sh_table_info; /* To mimic table-handler in libnetsnmp code
                                                      * save only to free properly */
+    struct snmp_table_snapshot *sh_snapshot; /* Table only: snapshot for GET/GETNEXT */
 };
 typedef struct clixon_snmp_handle clixon_snmp_handle;
 
@@ -88,12 +108,14 @@ int    oid_cbuf(cbuf *cb, const oid *objid, size_t objidlen);
 int    oid_print(FILE *f, const oid *objid, size_t objidlen);
 int    snmp_yang_type_get(yang_stmt *ys, yang_stmt **yrefp, char **origtypep, yang_stmt **yrestypep, char **restypep);
 int    yang_extension_value_opt(yang_stmt *ys, char *id, int *exist, char **value);
+void   snmp_yang_map_free(void);
 int    yangext_oid_get(yang_stmt *yn, oid *objid, size_t *objidlen, char **objidstr);
 int    yangext_is_oid_exist(yang_stmt *yn);
 int    snmp_access_str2int(char *modes_str);
 const char *snmp_msg_int2str(int msg);
 void  *snmp_handle_clone(void *arg);
 void   snmp_handle_free(void *arg);
+void   snmp_table_snapshot_free(struct snmp_table_snapshot *sts);
 int    type_yang2asn1(yang_stmt *ys, int *asn1_type, int extended);
 int    type_snmp2xml(yang_stmt                  *ys,
                      int                        *asn1type,
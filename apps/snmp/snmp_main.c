@@ -121,6 +121,7 @@ snmp_terminate(clixon_handle h)
         x = NULL;
     }
     clicon_rpc_close_session(h);
+    snmp_yang_map_free();
     yang_exit(h);
     if ((nsctx = clicon_nsctx_global_get(h)) != NULL)
         cvec_free(nsctx);
@@ -238,6 +238,8 @@ mibyang_table_register(clixon_handle h,
     yang_stmt                       *ys;
     char                            *name;
     int                              inext;
+    oid                              coloid[MAX_OID_LEN];
+    size_t                           coloidlen;
 
     if ((ys = yang_parent_get(ylist)) == NULL ||
         yang_keyword_get(ys) != Y_CONTAINER){
@@ -315,13 +317,16 @@ mibyang_table_register(clixon_handle h,
     }
     table_info->min_column = 1;
 
-    /* Count columns */
+    /* Count columns, and compile their OIDs for requests, see yangext_oid_get */
     table_info->max_column = 0;
     inext = 0;
     while ((yleaf = yn_iter(ylist, &inext)) != NULL) {
            if ((yang_keyword_get(yleaf) != Y_LEAF) || (ret = yangext_is_oid_exist(yleaf)) != 1)
             continue;
         table_info->max_column++;
+        coloidlen = MAX_OID_LEN;
+        if (yangext_oid_get(yleaf, coloid, &coloidlen, NULL) < 0)
+            goto done;
     }
     if ((ret = netsnmp_register_table(nhreg, table_info)) != SNMPERR_SUCCESS){
         clixon_err(OE_SNMP, ret, "netsnmp_register_table");
@@ -453,6 +458,10 @@ mibyang_augment_register(clixon_handle h,
  * currently exists. This means it registers for a static table. If new rows or columns
  * are created or deleted this will not change the OID registration.
  * That is, the table registration is STATIC
+ * @note Not used by clixon_snmp: a table is registered once with one handler for the whole
+ *       table, see mibyang_table_register, and rows are read from the backend when requested,
+ *       see snmp_table_snapshot. Added and deleted rows are therefore seen without any
+ *       re-registration.
  * @param[in]  h     Clixon handle
  * @param[in]  ys    Mib-Yang node (container)
  * @param[in]  ylist Mib-Yang node (list)
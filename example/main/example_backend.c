@@ -639,6 +639,8 @@ example_statefile(clixon_handle     h,
 
 /*! Example of state pagination callback and how to use pagination_data
  *
+ * A continuation token of the next page is set with the index of its first entry. If
+ * the backend gives the token back, the page starts at the token and is logged.
  * @param[in]  h        Generic handler
  * @param[in]  xpath    Registered XPath using canonical prefixes
  * @param[in]  userargs Per-call user arguments
@@ -667,6 +669,8 @@ example_pagination(void            *h0,
     uint32_t      upper;
     int           ret;
     cvec         *nsc = NULL;
+    char         *cursor;
+    char          token[16];
 
     /* If -S is set, then read state data from file */
     if (!_state || !_state_file)
@@ -700,11 +704,19 @@ example_pagination(void            *h0,
     if (xpath_vec(xt, nsc, "%s", &xvec, &xlen, xpath) < 0)
         goto done;
     lower = offset;
+    /* Continue from token of previous page, see CLICON_PAGINATION_CURSOR_TIMEOUT */
+    if ((cursor = pagination_cursor(pd)) != NULL){
+        clixon_log(h, LOG_NOTICE, "%s: cursor %s", __FUNCTION__, cursor);
+        lower = atoi(cursor);
+    }
     if (limit == 0)
         upper = xlen;
     else{
-        if ((upper = offset+limit) > xlen)
+        if ((upper = lower+limit) > xlen)
             upper = xlen;
+        snprintf(token, sizeof(token), "%u", upper);
+        if (pagination_cursor_set(pd, upper < xlen ? token : NULL) < 0)
+            goto done;
     }
     /* Mark elements to copy:
      * For every node found in x0, mark the tree as changed 
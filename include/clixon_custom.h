@@ -49,9 +49,10 @@
 
 /*! Optimize special list key searches in XPath finds
  *
- * Identify xpaths that search for exactly a list key, eg: "y[k='3']" and then call
- * binary search. This only works if "y" has proper yang binding and is sorted by system
- * Dont optimize on "hierarchical" lists such as: a/y[k='3'], where a is another list.
+ * Identify xpaths that search for all list keys, eg: "y[k='3']", a leaf-list value
+ * eg "y[.='3']", or an explicit search index, and then call binary search. This only
+ * works if "y" has proper yang binding and is sorted by system
+ * @see xpath_list_optimize_fn for rules
  */
 #define XPATH_LIST_OPTIMIZE
 
@@ -64,6 +65,43 @@
  */
 #define XML_EXPLICIT_INDEX
 
+/*! Cache integer values of XML leafs and leaf-lists inline in the XML node
+ *
+ * Integer list keys and leaf-list values are compared as 64-bit integers in xml_cmp,
+ * parsed directly from the body without creating a cligen variable.
+ * Costs 8 bytes per XML element.
+ */
+#define XML_NUM_CACHE
+
+/*! Cache xpath to root in XML nodes
+ *
+ * xml2xpath() without namespace context caches the resulting path in each XML node and
+ * its ancestors, so that paths of many nodes in the same list, eg changed nodes after a
+ * commit or denied nodes in NACM, only print their last step.
+ * Costs a pointer and a generation number per XML element. All cached paths are
+ * invalidated when a node with a cached path is renamed, moved or its key is changed.
+ */
+#define XML_PATH_CACHE
+
+/*! Cache structural hash of XML subtrees in XML elements
+ *
+ * xml_tree_hash() computes a 64-bit hash of an XML subtree bottom-up and caches it in each
+ * element. A change of a name, value or child clears the cache of the node and its
+ * ancestors. xml_diff and xml_tree_equal skip subtrees with equal hashes, eg unchanged
+ * parts of candidate and running.
+ * Costs 8 bytes per XML element.
+ */
+#define XML_HASH_CACHE
+
+/*! Intern XML element names and prefixes
+ *
+ * If set, XML node names and prefixes point into a shared reference-counted string table
+ * instead of each node having its own copy. Reduces memory for large trees with many
+ * nodes of the same name, and name comparisons of XML nodes can compare pointers first.
+ * Note: names returned by xml_name() and xml_prefix() must not be modified in-place.
+ */
+#define XML_NAME_INTERN
+
 /*! Let state data be ordered-by system
  *
  * RFC 7950 is cryptic about this
@@ -204,3 +242,23 @@
  * If not set, reduces memory with 8 bytes per yang-stmt.
  */
 #undef YANG_SPEC_LINENR
+
+/*! Minimum number of children of a yang node for building a child lookup index
+ *
+ * yang_find and yang_find_datanode look up children with a linear scan. Nodes with at least
+ * this number of children get a lazily built hash index on (keyword, argument).
+ * Typical such nodes are yang-specs (modules), modules (groupings, typedefs, identities) and
+ * large containers.
+ * Set to 0 to disable the index.
+ */
+#define YANG_FIND_INDEX_MIN 16
+
+/*! Maximum number of processes started in one scheduling round of the process manager
+ *
+ * When many registered processes are started or restarted at once, eg after a commit,
+ * remaining starts are made in following rounds, so that the event loop is served
+ * in-between.
+ * Set to 0 for no limit.
+ * @see clixon_process_sched
+ */
+#define PROCESS_SCHED_START_MAX 32
@@ -63,6 +63,19 @@ typedef enum {
     CLIXON_CLIENT_SSH
 } clixon_client_type;
 
+/*! Completion callback of an asynchronous get
+ *
+ * @param[in]  ch     Clixon client handle
+ * @param[in]  xpath  XPath of the request
+ * @param[in]  val    Value, or NULL if not found or on error
+ * @param[in]  err    0 if OK, -1 on error, eg an rpc-error reply or closed socket
+ * @param[in]  arg    Argument given to clixon_client_get_async
+ * @retval     0      OK
+ * @retval    -1      Error, clixon_client_poll returns -1
+ * @see clixon_client_get_async
+ */
+typedef int (clixon_client_cb)(clixon_client_handle ch, const char *xpath, const char *val, int err, void *arg);
+
 /*
  * Prototypes
  */
@@ -83,6 +96,11 @@ int   clixon_client_get_uint8(clixon_client_handle ch, uint8_t *rval, const char
 int   clixon_client_get_uint16(clixon_client_handle ch, uint16_t *rval, const char *xnamespace, const char *xpath);
 int   clixon_client_get_uint32(clixon_client_handle ch, uint32_t *rval, const char *xnamespace, const char *xpath);
 int   clixon_client_get_uint64(clixon_client_handle ch, uint64_t *rval, const char *xnamespace, const char *xpath);
+int   clixon_client_get_batch(clixon_client_handle ch, const char *xnamespace, const char **xpaths, int n, char **vals);
+int   clixon_client_get_async(clixon_client_handle ch, const char *xnamespace, const char *xpath, clixon_client_cb *fn, void *arg);
+int   clixon_client_poll(clixon_client_handle ch, int timeout);
+int   clixon_client_pending(clixon_client_handle ch);
+int   clixon_client_cache(clixon_client_handle ch, int enable);
 
 /* Access functions */
 int   clixon_client_socket_get(clixon_client_handle ch);
@@ -109,6 +109,7 @@ int clicon_client_socket_set(clixon_handle h, int s);
 /* Set and get module state full and brief cached tree */
 cxobj *clicon_modst_cache_get(clixon_handle h, int brief);
 int clicon_modst_cache_set(clixon_handle h, int brief, cxobj *xms);
+uint64_t clicon_modst_cache_gen(clixon_handle h, int brief);
 
 /* Set and get yang/xml module revision changelog */
 cxobj *clicon_xml_changelog_get(clixon_handle h);
@@ -56,6 +56,18 @@ struct db_elmnt {
                                  */
     int            de_empty;    /* Empty on read from file, xmldb_readfile and xmldb_put sets it */
     int            de_volatile; /* Disable auto-sync of cache to disk on every update (ie xmldb_put) */
+    int            de_edited;   /* All differences to running are marked with XML_FLAG_EDITED
+                                 * Set by copy to/from running, reset when cache is freed */
+    int            de_journal;  /* Number of entries in journal file since last snapshot */
+    pid_t          de_flush_pid;     /* Child process writing file in background, or 0 */
+    int            de_flush_fd;      /* Pipe to flush child, readable when it exits */
+    int            de_flush_pending; /* Cache changed during flush, write again when done */
+    int            de_flush_uring;   /* File is written with io_uring in background */
+    uint64_t       de_epoch;    /* Incremented when cache changes, see xmldb_snapshot_write */
+    int            de_stats_valid; /* de_stats_* are stats of cache at de_stats_epoch */
+    uint64_t       de_stats_epoch; /* Epoch of stats, see xmldb_cache_stats */
+    uint64_t       de_stats_nr;    /* Number of XML nodes of cache */
+    size_t         de_stats_size;  /* Size of cache in bytes */
 };
 typedef struct db_elmnt db_elmnt;
 
@@ -67,6 +79,8 @@ db_elmnt *clicon_db_elmnt_get(clixon_handle h, const char *db);
 int clicon_db_elmnt_set(clixon_handle h, const char *db, db_elmnt *xc);
 int xmldb_db2file(clixon_handle h, const char *db, char **filename);
 int xmldb_db2subdir(clixon_handle h, const char *db, char **dir);
+int xmldb_db2journal(clixon_handle h, const char *db, char **filename);
+int xmldb_journal_remove(clixon_handle h, const char *db);
 
 /* API */
 int xmldb_connect(clixon_handle h);
@@ -76,12 +90,30 @@ int xmldb_get(clixon_handle h, const char *db, cvec *nsc, char *xpath, cxobj **x
 int xmldb_get0(clixon_handle h, const char *db, yang_bind yb,
                cvec *nsc, const char *xpath, int copy, withdefaults_type wdef,
                cxobj **xret, modstate_diff_t *msd, cxobj **xerr);
+int xmldb_get_copy(clixon_handle h, cxobj *x0t, cvec *nsc, const char *xpath,
+                   withdefaults_type wdef, cxobj **xret);
+int xmldb_get0_view(clixon_handle h, const char *db, yang_bind yb, cvec *nsc, const char *xpath,
+                    cxobj **xtp, cxobj ***xvecp, size_t *xlenp, cxobj **xerr);
+int xmldb_get0_view_clear(cxobj **xvec, size_t xlen);
+int xmldb_get_page(clixon_handle h, const char *db, cvec *nsc, const char *xpath,
+                   char *sort_by, int backwards, uint32_t offset, cvec *cursor, uint32_t limit,
+                   withdefaults_type wdef, cxobj **xret,
+                   uint32_t *remaining, cvec **next, cvec **previous);
 /* in clixon_datastore_write.[ch]: */
 int xmldb_put(clixon_handle h, const char *db, enum operation_type op, cxobj *xt, char *username, cbuf *cbret);
+int xmldb_put_stream(clixon_handle h, const char *db, enum operation_type op, FILE *fp, char *username, cbuf *cbret);
+int xmldb_modify_tree(clixon_handle h, cxobj *x0, cxobj *x1, enum operation_type op, cbuf *cbret);
 int xmldb_dump(clixon_handle h, FILE *f, cxobj *xt, enum format_enum format, int pretty, withdefaults_type wdef, int multi, const char *multidb);
 int xmldb_write_cache2file(clixon_handle h, const char *db);
+int xmldb_flush_wait(clixon_handle h, const char *db);
+ /* in clixon_datastore_snapshot.c: */
+int xmldb_snapshot_write(clixon_handle h);
+int xmldb_snapshot_get(clixon_handle h, char *username, cvec *nsc, char *xpath,
+                       withdefaults_type wdef, cxobj **xret);
 
 int xmldb_copy(clixon_handle h, const char *from, const char *to);
+int xmldb_fork(clixon_handle h, const char *from, const char *to);
+int xmldb_rebase(clixon_handle h, const char *db, const char *base, const char *onto, char **conflict);
 int xmldb_lock(clixon_handle h, const char *db, uint32_t id);
 int xmldb_unlock(clixon_handle h, const char *db);
 int xmldb_unlock_all(clixon_handle h, uint32_t id);
@@ -94,15 +126,21 @@ int xmldb_create(clixon_handle h, const char *db);
 /* utility functions */
 int xmldb_db_reset(clixon_handle h, const char *db);
 cxobj *xmldb_cache_get(clixon_handle h, const char *db);
+int xmldb_cache_stats(clixon_handle h, const char *db, uint64_t *nrp, size_t *szp);
+int xmldb_cache_unshare(clixon_handle h, const char *db);
 int xmldb_modified_get(clixon_handle h, const char *db);
 int xmldb_modified_set(clixon_handle h, const char *db, int value);
 int xmldb_empty_get(clixon_handle h, const char *db);
 int xmldb_empty_set(clixon_handle h, const char *db, int value);
 int xmldb_volatile_get(clixon_handle h, const char   *db);
 int xmldb_volatile_set(clixon_handle h, const char *db, int value);
+int xmldb_edited_get(clixon_handle h, const char *db);
+int xmldb_edited_invalidate(clixon_handle h, const char *db);
 int xmldb_print(clixon_handle h, FILE *f);
 int xmldb_rename(clixon_handle h, const char *db, const char *newdb, const char *suffix);
 int xmldb_populate(clixon_handle h, const char *db);
+int xmldb_lazy_evict(clixon_handle h);
+int xmldb_feature_disable(clixon_handle h, const char *module, const char *feature);
 int xmldb_multi_upgrade(clixon_handle h, const char *db);
 
 #endif /* _CLIXON_DATASTORE_H */
@@ -85,15 +85,35 @@
 #define CLIXON_DBG_APP3		0x00400000	/* External application 3 */
 #define CLIXON_DBG_SMASK	0x00ffffff	/* Subject mask */
 
+/*
+ * Variables
+ */
+/* Global debug level, use clixon_debug_get(). Exported only for inline check in macros */
+extern int _clixon_debug_level;
+
 /*
  * Macros
  */
+/*! Check debug level inline before evaluating arguments and calling clixon_debug_fn
+ *
+ * Define CLIXON_DEBUG_DISABLE at compile-time, eg CPPFLAGS=-DCLIXON_DEBUG_DISABLE, to
+ * remove all debug calls. Arguments are still type-checked.
+ */
+#ifdef CLIXON_DEBUG_DISABLE
+#define clixon_debug_gate(l) (0)
+#elif defined(__GNUC__) || defined(__clang__)
+#define clixon_debug_gate(l) __builtin_expect(_clixon_debug_level != 0 && clixon_debug_isset(l), 0)
+#else
+#define clixon_debug_gate(l) (_clixon_debug_level != 0 && clixon_debug_isset(l))
+#endif
+
 #if defined(__GNUC__)
 #define clixon_debug(l, _fmt, args...) \
 	do { \
 		_Pragma("GCC diagnostic push") \
 		_Pragma("GCC diagnostic ignored \"-Wformat-zero-length\"") \
-		clixon_debug_fn(NULL, __FUNCTION__, __LINE__, (l), NULL, _fmt, ##args); \
+		if (clixon_debug_gate(l)) \
+		    clixon_debug_fn(NULL, __FUNCTION__, __LINE__, (l), NULL, _fmt, ##args); \
 		_Pragma("GCC diagnostic pop") \
 	} while (0)
 
@@ -101,7 +121,8 @@
 	do { \
 		_Pragma("GCC diagnostic push") \
 		_Pragma("GCC diagnostic ignored \"-Wformat-zero-length\"") \
-		clixon_debug_fn(NULL, __FUNCTION__, __LINE__, (l), (x), _fmt, ##args); \
+		if (clixon_debug_gate(l)) \
+		    clixon_debug_fn(NULL, __FUNCTION__, __LINE__, (l), (x), _fmt, ##args); \
 		_Pragma("GCC diagnostic pop") \
 	} while (0)
 
@@ -110,7 +131,8 @@
 	do { \
 		_Pragma("clang diagnostic push") \
 		_Pragma("clangGCC diagnostic ignored \"-Wformat-zero-length\"") \
-		clixon_debug_fn(NULL, __FUNCTION__, __LINE__, (l), NULL, _fmt, ##args); \
+		if (clixon_debug_gate(l)) \
+		    clixon_debug_fn(NULL, __FUNCTION__, __LINE__, (l), NULL, _fmt, ##args); \
 		_Pragma("clangGCC diagnostic pop") \
 	} while (0)
 
@@ -118,15 +140,22 @@
 	do { \
 		_Pragma("clangGCC diagnostic push") \
 		_Pragma("clangGCC diagnostic ignored \"-Wformat-zero-length\"") \
-		clixon_debug_fn(NULL, __FUNCTION__, __LINE__, (l), (x), _fmt, ##args); \
+		if (clixon_debug_gate(l)) \
+		    clixon_debug_fn(NULL, __FUNCTION__, __LINE__, (l), (x), _fmt, ##args); \
 		_Pragma("clangGCC diagnostic pop") \
 	} while (0)
 
 #else
 #define clixon_debug(l, _fmt, args...) \
-		clixon_debug_fn(NULL, __FUNCTION__, __LINE__, (l), NULL, _fmt, ##args)
+	do { \
+		if (clixon_debug_gate(l)) \
+		    clixon_debug_fn(NULL, __FUNCTION__, __LINE__, (l), NULL, _fmt, ##args); \
+	} while (0)
 #define clixon_debug_xml(l, x, _fmt, args...) \
-		clixon_debug_fn(NULL, __FUNCTION__, __LINE__, (l), (x), _fmt, ##args)
+	do { \
+		if (clixon_debug_gate(l)) \
+		    clixon_debug_fn(NULL, __FUNCTION__, __LINE__, (l), (x), _fmt, ##args); \
+	} while (0)
 #endif
 
 /*
@@ -138,10 +167,13 @@ int clixon_debug_key_dump(FILE *f);
 int clixon_debug_init(clixon_handle h, int dbglevel);
 int clixon_debug_get(void);
 int clixon_debug_fn(clixon_handle h, const char *fn, const int line, int dbglevel, cxobj *x, const char *format, ...) __attribute__ ((format (printf, 6, 7)));
+int clixon_debug_ring_init(size_t size);
+int clixon_debug_ring_flush(void);
+void clixon_debug_ring_exit(void);
 
 static inline int clixon_debug_isset(unsigned n)
 {
-	unsigned level = clixon_debug_get();
+	unsigned level = _clixon_debug_level;
 	unsigned detail = (n & CLIXON_DBG_DMASK) >> CLIXON_DBG_DSHIFT;
 	unsigned subject = (n & CLIXON_DBG_SMASK);
 
@@ -66,9 +66,17 @@ typedef struct _dispatcher_entry dispatcher_entry_t;
 
 struct _dispatcher_entry {
     /*
-     * the name of this node, NOT the complete path
+     * the name of this node, NOT the complete path, without key
      */
     char *node_name;
+    size_t node_len;
+
+    /*
+     * key of a keyed node, eg c of b=c
+     * if NULL then this node matches any key
+     */
+    char *node_key;
+    size_t node_key_len;
 
     /*
      * peer points at peer to the right of this one
@@ -77,17 +85,29 @@ struct _dispatcher_entry {
     dispatcher_entry_t *peer;
 
     /*
-     * peer_head points at leftmost peer at this level
-     * if NULL, then this is the leftmost and first on the list
-     * XXX: it seems it points to itself if it is first on the list? 
+     * points at first node of children list, in order of registration
+     * if NULL, then no children
      */
-    dispatcher_entry_t *peer_head;
+    dispatcher_entry_t *children;
 
     /*
-     * points at peer_head of children list
-     * if NULL, then no children
+     * hash table of children without key by name, open addressing
+     * child_size is a power of 2
      */
-    dispatcher_entry_t *children;
+    dispatcher_entry_t **child_hash;
+    size_t child_size;
+    size_t child_nr;
+
+    /*
+     * child * that matches any name
+     */
+    dispatcher_entry_t *wildcard;
+
+    /*
+     * first keyed variant of this node without key, and next keyed variant
+     */
+    dispatcher_entry_t *keyed;
+    dispatcher_entry_t *next_key;
 
     /*
      * pointer to handler function for this node
@@ -105,6 +125,7 @@ struct _dispatcher_entry {
  */
 int dispatcher_register_handler(dispatcher_entry_t **root, dispatcher_definition *x);
 int dispatcher_call_handlers(dispatcher_entry_t *root, void *handle, char *path, void *user_args);
+int dispatcher_call_handlers_vec(dispatcher_entry_t *root, void *handle, char **paths, size_t npaths, void *user_args);
 int dispatcher_free(dispatcher_entry_t *root);
 int dispatcher_print(FILE *f, int level, dispatcher_entry_t *root);
 
@@ -52,6 +52,8 @@ int clicon_sig_ignore_get(void);
 int clixon_event_reg_fd(int fd, int (*fn)(int, void*), void *arg, char *str);
 int clixon_event_reg_fd_prio(int fd, int (*fn)(int, void*), void *arg, char *str, int prio);
 int clixon_event_unreg_fd(int s, int (*fn)(int, void*));
+int clixon_event_reg_fd_write(int fd, int (*fn)(int, void*), void *arg, char *str);
+int clixon_event_unreg_fd_write(int s, int (*fn)(int, void*));
 int clixon_event_reg_timeout(struct timeval t,  int (*fn)(int, void*),
                              void *arg, char *str);
 int clixon_event_unreg_timeout(int (*fn)(int, void*), void *arg);
@@ -39,11 +39,43 @@
 #ifndef _CLIXON_FILE_H_
 #define _CLIXON_FILE_H_
 
+/*
+ * Constants
+ */
+/* Buffered file output is flushed when it exceeds this size */
+#define CLICON_FILE_OUT_SIZE (1024*1024)
+
+/*
+ * Types
+ */
+/*! Buffered output to a file, shared by the XML, JSON, text and CLI serializers
+ *
+ * Output is appended to fo_cb and flushed in large chunks
+ * @see clicon_file_out_init
+ */
+typedef struct {
+    cbuf             *fo_cb;    /* Output buffer */
+    FILE             *fo_f;     /* Output file */
+    clicon_output_cb *fo_fn;    /* Output function, or NULL to write to file descriptor of fo_f */
+    int               fo_reuse; /* fo_cb is the reusable buffer */
+} clicon_file_out;
+
+/*
+ * Prototypes
+ */
+
 int clicon_file_dirent(const char *dir, struct dirent **ent,
                        const char *regexp, mode_t type);
 int clicon_files_recursive(const char *dir, const char *regexp, cvec *cvv);
 int clicon_file_copy(char *src, char *target);
 int clicon_dir_copy(char *src, char *target);
 int clicon_file_cbuf(const char *filename, cbuf *cb);
+int clicon_file_buf(FILE *fp, char **bufp, size_t *lenp, size_t *maplenp);
+int clicon_file_buf_free(char *buf, size_t maplen);
+void clicon_file_uring_set(int enable);
+int clicon_file_out_init(clicon_file_out *fo, FILE *f, clicon_output_cb *fn);
+int clicon_file_out_flush(cbuf *cb, void *arg);
+int clicon_file_out_check(clicon_file_out *fo);
+int clicon_file_out_free(clicon_file_out *fo);
 
 #endif /* _CLIXON_FILE_H_ */
@@ -43,9 +43,15 @@
 /*
  * Prototypes
  */
+int json_parser_mode_set(int mode);
+int json_parser_mode_get(void);
 int json2xml_decode(cxobj *x, cxobj **xerr);
 int clixon_json2cbuf(cbuf *cb, cxobj *x, int pretty, int skiptop, int autocliext);
 int xml2json_cbuf_vec(cbuf *cb, cxobj **vec, size_t veclen, int pretty, int skiptop);
+int clixon_json2cbuf_stream(cbuf *cb, cxobj *xt, int pretty, size_t size,
+                            int (*fn)(cbuf *cb, void *arg), void *arg);
+int xml2json_cbuf_vec_stream(cbuf *cb, cxobj **vec, size_t veclen, int pretty, size_t size,
+                             int (*fn)(cbuf *cb, void *arg), void *arg);
 int clixon_json2file(FILE *f, cxobj *x, int pretty, clicon_output_cb *fn, int skiptop, int autocliext);
 int json_print(FILE *f, cxobj *x);
 int xml2json_vec(FILE *f, cxobj **vec, size_t veclen, int pretty, clicon_output_cb *fn, int skiptop);
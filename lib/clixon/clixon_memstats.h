@@ -0,0 +1,80 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2016 Olof Hagsand and Benny Holmgren
+  Copyright (C) 2017-2019 Olof Hagsand
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC (Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Memory accounting per tag, eg datastore, session or plugin
+ * @see clixon_memstats.c
+ */
+
+#ifndef _CLIXON_MEMSTATS_H_
+#define _CLIXON_MEMSTATS_H_
+
+/*
+ * Constants
+ */
+/* Max number of tags, a tag fits in the high byte of the allocation flags of an XML node */
+#define CLIXON_MEM_TAG_MAX      256
+
+/* Predefined tags */
+#define CLIXON_MEM_TAG_NONE     0 /* Not accounted, eg allocated before accounting enabled */
+#define CLIXON_MEM_TAG_OTHER    1 /* Allocated outside any tagged operation */
+#define CLIXON_MEM_TAG_YANG     2 /* YANG statements */
+#define CLIXON_MEM_TAG_NOTIFY   3 /* Serialized notifications, including replay buffers */
+
+/*
+ * Variables
+ */
+/* Exported only for inline checks in macros, use clixon_mem_tag_get() */
+extern int _clixon_mem_enabled;
+extern int _clixon_mem_tag;
+
+/*
+ * Macros
+ */
+/* Tag of new XML nodes, CLIXON_MEM_TAG_NONE if accounting is disabled */
+#define clixon_mem_tag_current() (_clixon_mem_enabled ? _clixon_mem_tag : CLIXON_MEM_TAG_NONE)
+
+/*
+ * Prototypes
+ */
+int  clixon_mem_enable(int enable);
+int  clixon_mem_enabled(void);
+int  clixon_mem_tag(const char *format, ...) __attribute__ ((format (printf, 1, 2)));
+int  clixon_mem_tag_set(int tag);
+void clixon_mem_tag_release(int tag);
+void clixon_mem_charge(int tag, int64_t bytes);
+int  clixon_mem2cbuf(cbuf *cb);
+void clixon_mem_exit(void);
+
+#endif /* _CLIXON_MEMSTATS_H_ */
@@ -56,12 +56,15 @@ enum nacm_access{
 /*
  * Prototypes
  */
-int nacm_rpc(char *rpc, char *module, char *username, cxobj *xnacm, cbuf *cbret);
+int nacm_rpc(clixon_handle h, char *rpc, char *module, char *username, cxobj *xnacm, cbuf *cbret);
+int nacm_decision_stats(clixon_handle h, uint64_t *nr, uint64_t *hits, uint64_t *misses);
 int nacm_datanode_read(clixon_handle h, cxobj *xt, cxobj **xvec, size_t xlen, char *username,
                        cxobj *nacm_xtree);
 int nacm_datanode_write(clixon_handle h, cxobj *xr, cxobj *xt,
                         enum nacm_access access,
                         char *username, cxobj *xnacm, cbuf *cbret);
+int nacm_policy_free(clixon_handle h);
+int nacm_access_check(clixon_handle h, cxobj *xnacm, char *peername, char *username);
 int nacm_access_pre(clixon_handle h, char *peername, char *username, cxobj **xnacmp, cbuf *cbret);
 int verify_nacm_user(clixon_handle h, enum nacm_credentials_t cred, char *peername, char *nacmname, char *rpcname, cbuf *cbret);
 
@@ -41,6 +41,10 @@
  */
 #define NETCONF_FRAMING_TYPE "netconf-framing-type"
 
+/* Size of input read buffer, large reads are scanned in bulk by netconf_input_msg2
+ */
+#define NETCONF_INPUT_BUFLEN 65536
+
 /*
  * Prototypes
  */
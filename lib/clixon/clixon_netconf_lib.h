@@ -67,6 +67,11 @@
  */
 #define NETCONF_BASE_CAPABILITY_1_1 "urn:ietf:params:netconf:base:1.1"
 
+/* Clixon internal capability: backend may send replies in binary format
+ * @see CLICON_SOCK_BINARY
+ */
+#define CLIXON_BINARY_CAPABILITY "http://clicon.org/lib/binary:1.0"
+
 /* See RFC 7950 Sec 5.3.1: YANG defines an XML namespace for NETCONF <edit-config> 
  * operations, <error-info> content, and the <action> element.
  */
@@ -91,7 +91,27 @@ enum nacm_credentials_t{
  */
 enum regexp_mode{
     REGEXP_POSIX,
-    REGEXP_LIBXML2
+    REGEXP_LIBXML2,
+    REGEXP_PCRE2
+};
+
+/*! Datastore file compression
+ *
+ * @see compress_mode in clixon-config.yang
+ */
+enum compress_mode{
+    COMPRESS_NONE,
+    COMPRESS_ZSTD
+};
+
+/*! Memory trim policy after backend operations
+ *
+ * @see memory_trim_mode in clixon-config.yang
+ */
+enum memory_trim_mode{
+    MEMORY_TRIM_NONE,
+    MEMORY_TRIM_ARENA,
+    MEMORY_TRIM_HEAP
 };
 
 /*
@@ -203,6 +223,14 @@ enum priv_mode_t clicon_restconf_privileges_mode(clixon_handle h);
 enum nacm_credentials_t clicon_nacm_credentials(clixon_handle h);
 
 enum regexp_mode clicon_yang_regexp(clixon_handle h);
+enum compress_mode clicon_xmldb_compress(clixon_handle h);
+int clicon_xpath_eval(clixon_handle h);
+int clicon_xml_parser(clixon_handle h);
+int clicon_json_parser(clixon_handle h);
+int clicon_text_syntax_parser(clixon_handle h);
+int clicon_restconf_http1_parser(clixon_handle h);
+int clicon_xml_arena_hugepages(clixon_handle h);
+enum memory_trim_mode clicon_memory_trim(clixon_handle h);
 /*-- Specific option access functions for non-yang options --*/
 int clicon_quiet_mode(clixon_handle h);
 int clicon_quiet_mode_set(clixon_handle h, int val);
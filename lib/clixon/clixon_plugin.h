@@ -254,6 +254,19 @@ typedef void *transaction_data;
 /* Transaction callback */
 typedef int (trans_cb_t)(clixon_handle h, transaction_data td);
 
+/*! Completion callback of a pending asynchronous transaction commit
+ *
+ * Called when the file descriptor registered with transaction_commit_pending is readable
+ * @param[in]  h    Clixon handle
+ * @param[in]  fd   File descriptor given in transaction_commit_pending
+ * @param[in]  td   Transaction data
+ * @param[in]  arg  Argument given in transaction_commit_pending
+ * @retval     1    Still pending, wait for the fd again
+ * @retval     0    Commit completed OK
+ * @retval    -1    Commit failed, the transaction is reverted
+ */
+typedef int (trans_pending_cb_t)(clixon_handle h, int fd, transaction_data td, void *arg);
+
 /*! Hook to override default prompt with explicit function
  *
  * Format prompt before each getline 
@@ -363,6 +376,20 @@ enum startup_status{
     STARTUP_OK           /* Everything OK (may still be modules-mismatch) */
 };
 
+/*! Backend plugin flags, see ca_trans_flags
+ *
+ * CLIXON_PLUGIN_TRANS_INDEPENDENT: The trans_commit callback does not depend on other plugins,
+ * and may run concurrently with the trans_commit callbacks of other independent plugins
+ * in a forked worker process of its own. Its effects must then be outside the backend
+ * process, eg system configuration: changes of backend memory are lost when the worker
+ * exits, and the commit cannot be left pending, see transaction_commit_pending.
+ * CLIXON_PLUGIN_STATEDATA_WORKER: The statedata callback may run concurrently with the
+ * statedata callbacks of other such plugins in a forked worker process of its own.
+ * Changes of backend memory are then lost, only the state tree is returned.
+ */
+#define CLIXON_PLUGIN_TRANS_INDEPENDENT    0x01
+#define CLIXON_PLUGIN_STATEDATA_WORKER     0x02
+
 /* plugin init struct for the api 
  * Note: Implicit init function
  */
@@ -407,6 +434,7 @@ struct clixon_plugin_api{
             trans_cb_t       *cb_trans_end;      /* Transaction completed  */
             trans_cb_t       *cb_trans_abort;    /* Transaction aborted */
             datastore_upgrade_t *cb_datastore_upgrade; /* General-purpose datastore upgrade */
+            uint32_t          cb_trans_flags;    /* See CLIXON_PLUGIN_TRANS_* */
         } cau_backend;
     } u;
 };
@@ -430,6 +458,7 @@ struct clixon_plugin_api{
 #define ca_trans_end      u.cau_backend.cb_trans_end
 #define ca_trans_abort    u.cau_backend.cb_trans_abort
 #define ca_datastore_upgrade  u.cau_backend.cb_datastore_upgrade
+#define ca_trans_flags    u.cau_backend.cb_trans_flags
 
 /*
  * Macros
@@ -465,6 +494,7 @@ typedef struct {
     void         *rc_arg;       /* Application specific argument to cb */
     char         *rc_namespace;/* Namespace to combine with name tag */
     char         *rc_name;      /* Xml/json tag/name */
+    void         *rc_next;      /* Next RPC callback with same namespace and name */
 } rpc_callback_t;
 
 /*
@@ -488,6 +518,8 @@ clixon_plugin_t *clixon_plugin_each(clixon_handle h, clixon_plugin_t *cpprev);
 
 clixon_plugin_t *clixon_plugin_each_revert(clixon_handle h, clixon_plugin_t *cpprev, int nr);
 
+clixon_plugin_t **clixon_plugin_hook(clixon_handle h, size_t offset);
+
 clixon_plugin_t *clixon_plugin_find(clixon_handle h, const char *name);
 
 int clixon_plugins_load(clixon_handle h, const char *function, const char *dir, const char *regexp);
@@ -73,9 +73,11 @@ int clixon_process_argv_get(clixon_handle h, const char *name, char ***argv, int
 int clixon_process_register(clixon_handle h, const char *name, const char *descr, const char *netns, uid_t uid, gid_t gid, int fdkeep, proc_cb_t *callback, char **argv, int argc);
 int clixon_process_delete_all(clixon_handle h);
 int clixon_process_operation(clixon_handle h, const char *name, proc_operation op, const int wrapit);
+int clixon_process_operation_batch(clixon_handle h, char **names, int nnames, proc_operation op, const int wrapit);
 int clixon_process_status(clixon_handle h, const char *name, cbuf *cbret);
 int clixon_process_start_all(clixon_handle h);
 int clixon_process_waitpid(clixon_handle h);
+int clixon_resource_check_mode_set(int mode);
 int clixon_resource_check(clixon_handle h, void **wh, const char *name, const char *fn);
 
 #endif  /* _CLIXON_PROC_H_ */
@@ -53,6 +53,24 @@ struct clicon_msg {
     char        op_body[0]; /* rest of message, actual data */
 };
 
+/*! Receive state of a socket where NETCONF 1.1 messages may be pipelined
+ *
+ * @see clixon_msg_rcv11_next
+ */
+typedef struct clixon_msg_rcv clixon_msg_rcv;
+
+/*! Callback receiving a message in pieces
+ *
+ * @param[in]  buf  Message data, not null-terminated
+ * @param[in]  len  Length of data, may be 0 on the last call
+ * @param[in]  eom  Set on the last call of a message
+ * @param[in]  arg  Argument given by caller
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see clixon_msg_rcv11_stream
+ */
+typedef int (clixon_msg_stream_cb)(char *buf, size_t len, int eom, void *arg);
+
 /*
  * Prototypes
  */
@@ -73,7 +91,14 @@ int clixon_msg_send10(int s, const char *descr, cbuf *cb);
 int clixon_rpc10(int sock, const char *descr, cbuf *msgin, cbuf *msgret, int *eof);
 
 /* NETCONF 1.1 */
+int clixon_msg_send11(int s, const char *descr, cbuf *cb);
+int clixon_msg_send11_chunk(int s, const char *descr, const char *data, size_t len, int eom);
 int clixon_msg_rcv11(int s, const char *descr, int intr, cbuf **cb, int *eof);
+int clixon_msg_rcv11_stream(int s, const char *descr, clixon_msg_stream_cb *fn, void *arg, int *eof);
+clixon_msg_rcv *clixon_msg_rcv_new(void);
+int clixon_msg_rcv_free(clixon_msg_rcv *mr);
+int clixon_msg_rcv_pending(clixon_msg_rcv *mr);
+int clixon_msg_rcv11_next(int s, const char *descr, clixon_msg_rcv *mr, int rd, cbuf **cb, int *eof);
 int clicon_rpc(int sock, const char *descr, struct clicon_msg *msg, char **xret, int *eof);
 int send_msg_reply(int s, const char *descr, char *data, uint32_t datalen);
 int send_msg_notify_xml(clixon_handle h, int s, const char *descr, cxobj *xev);
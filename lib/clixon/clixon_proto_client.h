@@ -42,11 +42,34 @@
 #ifndef _CLIXON_PROTO_CLIENT_H_
 #define _CLIXON_PROTO_CLIENT_H_
 
+/*
+ * Types
+ */
+/*! Completion callback of an asynchronous rpc
+ *
+ * @param[in]  h     Clixon handle
+ * @param[in]  xret  Reply as xml tree, or NULL if backend closed the socket. Freed after call
+ * @param[in]  arg   Argument given in clicon_rpc_netconf_xml_async
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+typedef int (clicon_rpc_async_cb)(clixon_handle h, cxobj *xret, void *arg);
+
+/*
+ * Prototypes
+ */
+
 int clicon_rpc_connect(clixon_handle h, int *sock0);
 int clicon_rpc_msg(clixon_handle h, struct clicon_msg *msg, cxobj **xret0);
+int clicon_rpc_session_select(clixon_handle h, char *username);
+int clicon_rpc_session_pool_close(clixon_handle h);
 int clicon_rpc_msg_persistent(clixon_handle h, struct clicon_msg *msg, cxobj **xret0, int *sock0);
 int clicon_rpc_netconf(clixon_handle h, char *xmlst, cxobj **xret, int *sp);
 int clicon_rpc_netconf_xml(clixon_handle h, cxobj *xml, cxobj **xret, int *sp);
+int clicon_rpc_netconf_bound(clixon_handle h, cxobj *xrpc, int env, cxobj **xret);
+int clicon_rpc_netconf_stream(clixon_handle h, cxobj *xml, clixon_msg_stream_cb *fn, void *arg);
+int clicon_rpc_netconf_xml_async(clixon_handle h, int s, cxobj *xml, clicon_rpc_async_cb *fn, void *arg);
+int clicon_rpc_async_close(clixon_handle h, int s);
 int clicon_rpc_get_config(clixon_handle h, char *username, char *db, char *xpath, cvec *nsc, char *defaults, cxobj **xret);
 int clicon_rpc_edit_config(clixon_handle h, char *db, enum operation_type op,
                            char *xml);
@@ -70,6 +93,9 @@ int clicon_rpc_create_subscription(clixon_handle h, char *stream, char *filter,
 int clicon_rpc_debug(clixon_handle h, int level);
 int clicon_rpc_restconf_debug(clixon_handle h, int level);
 int clicon_hello_req(clixon_handle h, char *transport, char *source_host, uint32_t *id);
+int clicon_rpc_batch(clixon_handle h, int atomic, const char *ops, cxobj **xret);
+int clicon_rpc_datastore_stamp(clixon_handle h, const char *db, const char *node, char **etag, struct timeval *tv);
+int clicon_rpc_datastore_diff(clixon_handle h, const char *db1, const char *db2, cxobj **xt1, cxobj **xt2);
 int clicon_rpc_restart_plugin(clixon_handle h, char *plugin);
 
 #endif  /* _CLIXON_PROTO_CLIENT_H_ */
@@ -55,21 +55,47 @@
  */
 typedef int (*stream_fn_t)(clixon_handle h, int op, cxobj *event, void *arg);
 
+/*! Subscription filter, shared by all subscriptions of a stream with the same filter
+ *
+ * The filter is parsed and compiled once, and evaluated once per event
+ */
+struct stream_filter{
+    struct stream_filter       *sf_next;
+    char                       *sf_xpath;  /* Canonical xpath */
+    struct xpath_tree          *sf_xptree; /* Parsed and compiled xpath */
+    int                         sf_refcnt; /* Number of subscriptions using filter */
+    uint64_t                    sf_seq;    /* Event of last evaluation */
+    int                         sf_match;  /* Result of last evaluation */
+};
+
 struct stream_subscription{
     qelem_t                     ss_q;   /* queue header */
     char                       *ss_stream; /* Name of associated stream */
     char                       *ss_xpath;  /* Filter selector as xpath */
+    struct stream_filter       *ss_filter; /* Compiled filter, or NULL if no filter */
     struct timeval              ss_starttime; /* Replay starttime */
     struct timeval              ss_stoptime; /* Replay stoptime */
     stream_fn_t                 ss_fn;     /* Callback when event occurs */
     void                       *ss_arg;    /* Callback argument */
 };
 
-/* Replay time-series */
+/*! Notification message serialized once and shared by all subscribers of an event
+ *
+ * The message is XML with NETCONF 1.1 chunked framing, as sent on internal sockets.
+ * Each holder keeps a reference, the message is freed when the last is released.
+ * @see stream_msg_get
+ */
+struct stream_msg{
+    int     sm_refcnt; /* Reference count */
+    size_t  sm_len;    /* Length of framed message */
+    char   *sm_buf;    /* Framed message */
+};
+typedef struct stream_msg stream_msg;
+
+/* Replay record, in a ring ordered by time, see event_stream */
 struct stream_replay{
-    qelem_t        r_q;   /* queue header */
     struct timeval r_tv;  /* time index */
-    cxobj         *r_xml; /* event in xml form */
+    stream_msg    *r_msg; /* event serialized, shared with notification */
 };
 
 /* See RFC8040 9.3, stream list, no replay support for now
@@ -79,10 +105,18 @@ struct event_stream{
     char                *es_name; /* name of notification event stream */
     char                *es_description;
     struct stream_subscription *es_subscription;
+    struct stream_filter *es_filter; /* Filters of subscriptions */
     int                  es_replay_enabled; /* set if replay is enables */
     struct timeval       es_retention; /* replay retention - how much to save */
-    struct stream_replay *es_replay;
-
+    size_t               es_retention_size; /* replay retention in bytes, 0 is no limit */
+    struct stream_replay *es_replay;   /* Ring of replay records, oldest at es_replay_head */
+    int                  es_replay_max;  /* Allocated records in ring */
+    int                  es_replay_head; /* Index of oldest record */
+    int                  es_replay_len;  /* Number of records */
+    size_t               es_replay_size; /* Bytes of serialized records */
+    char                *es_replay_file; /* Replay file, see CLICON_STREAM_REPLAY_DIR, or NULL */
+    int                  es_replay_fd;   /* Open replay file or -1 */
+    size_t               es_replay_fsize; /* Size of replay file */
 };
 typedef struct event_stream event_stream_t;
 
@@ -104,6 +138,8 @@ struct stream_subscription *stream_ss_find(event_stream_t *es,
 int stream_ss_delete_all(clixon_handle h, stream_fn_t fn, void *arg);
 int stream_ss_delete(clixon_handle h, char *name, stream_fn_t fn, void *arg);
 
+stream_msg *stream_msg_get(cxobj *xevent);
+int stream_msg_free(stream_msg *sm);
 int stream_notify_xml(clixon_handle h, char *stream, cxobj *xml);
 int stream_notify(clixon_handle h, char *stream, const char *event, ...)  __attribute__ ((format (printf, 3, 4)));
 
@@ -65,18 +65,27 @@ int    clixon_strsep2(char *str, char *delim1, char *delim2, char ***vcp, int *n
 char  *clicon_strjoin (int argc, char **argv, char *delim);
 char  *clixon_string_del_join(char *str1, char *del, char *str2);
 int    clixon_strsplit(char *nodeid, const int delim, char **prefix, char **id);
+int    uri_str_next(char **sp, char delim1, char delim2, int decode, char **name, char **value);
 int    uri_str2cvec(char *string, char delim1, char delim2, int decode, cvec **cvp);
 int    uri_percent_encode(char **encp, const char *fmt, ...) __attribute__ ((format (printf, 2, 3)));
+int    uri_percent_cbuf_append(cbuf *cb, const char *str);
 int    xml_chardata_encode(char **escp, int quote, const char *fmt, ... ) __attribute__ ((format (printf, 3, 4)));
 int    xml_chardata_cbuf_append(cbuf *cb, int quote, char *str);
 int    xml_chardata_decode(char **escp, const char *fmt,...);
 int    uri_percent_decode(char *enc, char **str);
+size_t uri_percent_decode_inplace(char *str);
+int    base64_encode(const char *str, char **encp);
+int    base64_decode(const char *enc, char **strp);
 int    nodeid_split(char *nodeid, char **prefix, char **id);
 char  *clixon_trim(char *str);
 char  *clixon_trim2(char *str, char *trims);
 int    clicon_strcmp(char *s1, char *s2);
 int    clixon_unicode2utf8(char *ucstr, char *utfstr, size_t utflen);
 int    clixon_str_subst(char *str, cvec *cvv, cbuf *cb);
+int    clixon_cbuf_indent(cbuf *cb, int n);
+cbuf  *clixon_cbuf_borrow(size_t size);
+int    clixon_cbuf_release(cbuf *cb);
+int    clixon_cbuf_pool_free(void);
 
 #ifndef HAVE_STRNDUP
 char *clicon_strndup (const char *, size_t);
@@ -39,6 +39,8 @@
 /*
  * Prototypes
  */
+int text_syntax_parser_mode_set(int mode);
+int text_syntax_parser_mode_get(void);
 int clixon_text2file(FILE *f, cxobj *xn, int level, clicon_output_cb *fn, int skiptop, int autocliext);
 int clixon_text2cbuf(cbuf *cb, cxobj *xn, int level, int skiptop, int autocliext);
 int clixon_text_diff2cbuf(cbuf *cb, cxobj *x0, cxobj *x1);
@@ -0,0 +1,78 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2016 Olof Hagsand and Benny Holmgren
+  Copyright (C) 2017-2019 Olof Hagsand
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC (Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Tracing spans of operations, propagated with W3C trace context
+ * @see clixon_trace.c
+ */
+
+#ifndef _CLIXON_TRACE_H_
+#define _CLIXON_TRACE_H_
+
+/*
+ * Constants
+ */
+/* Length of W3C traceparent string "00-<trace-id>-<parent-id>-<flags>", not including null */
+#define CLIXON_TRACEPARENT_LEN 55
+
+/*
+ * Types
+ */
+/*! Span of a traced operation
+ *
+ * Declared on the stack of the traced function and initialized to zero.
+ * Spans started in the same process are nested: a span started while another span is
+ * active becomes its child.
+ */
+typedef struct clixon_span {
+    struct clixon_span *sp_prev;       /* Enclosing span, or NULL */
+    uint64_t            sp_start;      /* Start time in unix nanoseconds, 0 if not started */
+    char                sp_trace[33];  /* Trace id, 32 hex digits */
+    char                sp_id[17];     /* Span id, 16 hex digits */
+    char                sp_parent[17]; /* Parent span id, or empty if root span */
+    char                sp_name[64];   /* Name of operation */
+} clixon_span;
+
+/*
+ * Prototypes
+ */
+int  clixon_trace_init(clixon_handle h, const char *service);
+int  clixon_trace_enabled(void);
+int  clixon_trace_parent_set(const char *traceparent);
+int  clixon_trace_traceparent(char *buf, size_t len);
+void clixon_trace_span_start(clixon_span *sp, const char *format, ...) __attribute__ ((format (printf, 2, 3)));
+void clixon_trace_span_end(clixon_span *sp);
+void clixon_trace_exit(void);
+
+#endif /* _CLIXON_TRACE_H_ */
@@ -46,9 +46,15 @@
 int xml_yang_validate_rpc(clixon_handle h, cxobj *xrpc, int expanddefault, cxobj **xret);
 int xml_yang_validate_rpc_reply(clixon_handle h, cxobj *xrpc, cxobj **xret);
 int xml_yang_validate_add(clixon_handle h, cxobj *xt, cxobj **xret);
+int xml_yang_validate_list_key(cxobj *xt, cxobj **xret);
 int xml_yang_validate_list_key_only(cxobj *xt, cxobj **xret);
 int xml_yang_validate_all(clixon_handle h, cxobj *xt, cxobj **xret);
 int xml_yang_validate_all_top(clixon_handle h, cxobj *xt, cxobj **xret);
+int xml_yang_validate_diff(clixon_handle h, cxobj *xt, cxobj **avec, int alen, cxobj **dvec, int dlen, cxobj **tcvec, int clen, cxobj **xret);
+int xml_yang_validate_depmap_free(clixon_handle h);
+int xml_leafref_index_keep(cxobj *xtop);
+void xml_leafref_index_drop(cxobj *xtop);
+int xml_leafref_index_lookup(cxobj *xt, yang_stmt *ys, yang_stmt *ypath, cxobj **xrefp);
 int rpc_reply_check(clixon_handle h, char *rpcname, cbuf *cbret);
 
 #endif  /* _CLIXON_VALIDATE_H_ */
@@ -179,8 +179,30 @@ typedef struct xml cxobj; /* struct defined in clicon_xml.c */
  */
 typedef int (xml_applyfn_t)(cxobj *x, void *arg);
 
+/* Load children of node with XML_FLAG_LAZY set, see xml_lazy_register */
+typedef int (xml_lazyfn_t)(cxobj *x, void *arg);
+
 typedef struct clixon_xml_vec clixon_xvec; /* struct defined in clicon_xml_vec.c */
 
+/* Iterator over children of an XML node, allocated by caller, eg on the stack
+ * Unlike xml_child_each, iteration state is kept in the iterator instead of the XML nodes
+ * @see xml_iter_init
+ */
+typedef struct xml_iter {
+    cxobj          *xi_parent; /* Parent, or NULL if not element */
+    cxobj          *xi_last;   /* Last returned child, used to detect changes of parent */
+    int             xi_i;      /* Index after last returned child */
+    enum cxobj_type xi_type;   /* Type of children, or CX_ERROR (-1) for any */
+} xml_iter_t;
+
+/* Huge pages of XML arena regions, see xml_arena_layout and CLICON_XML_ARENA_HUGEPAGES
+ */
+enum xml_arena_pages{
+    XML_ARENA_PAGES_NONE = 0,   /* Chunks allocated with posix_memalign */
+    XML_ARENA_PAGES_TRANSPARENT,/* 2MB regions with madvise(MADV_HUGEPAGE) */
+    XML_ARENA_PAGES_EXPLICIT,   /* 2MB regions with MAP_HUGETLB, fallback to transparent */
+};
+
 /* Alternative tree formats,
  * @see format_int2str, format_str2int, datastore_format in clixon-lib.yang
  */
@@ -190,6 +212,7 @@ enum format_enum{
     FORMAT_TEXT,
     FORMAT_CLI,
     FORMAT_NETCONF,
+    FORMAT_BINARY,
     FORMAT_DEFAULT
 };
 
@@ -206,14 +229,30 @@ enum format_enum{
 #define XML_FLAG_DEFAULT   0x40 /* Added when a value is set as default @see xml_default */
 #define XML_FLAG_TOP       0x80 /* Top datastore symbol */
 #define XML_FLAG_BODYKEY  0x100 /* Text parsing key to be translated from body to key */
+#define XML_FLAG_OPAQUE   0x100 /* Element: anydata/anyxml children kept as one raw XML body,
+                                 * @see xml_opaque_make. Only bodies have XML_FLAG_BODYKEY */
 #define XML_FLAG_ANYDATA  0x200 /* Treat as anydata, eg mount-points before bound */
 #define XML_FLAG_CACHE_DIRTY 0x400 /* This part of XML tree is not synced to disk */
+#define XML_FLAG_EDITED   0x800 /* Node or child edited since datastore was equal to running
+                                 * @see xml_diff_flagged */
+#define XML_FLAG_LAZY    0x1000 /* Children not loaded, see xml_lazy_load */
+#define XML_FLAG_LAZY_LOADED 0x2000 /* Children loaded on demand, may be evicted */
+#define XML_FLAG_LAZY_REF 0x4000 /* Loaded node referenced since last eviction sweep */
+#define XML_FLAG_NS_SPEC 0x8000 /* Namespace of element is that of its YANG module, checked
+                                 * by bind, @see xml2ns */
 
 /*
  * Prototypes
  */
 char     *xml_type2str(enum cxobj_type type);
 int       xml_stats_global(uint64_t *nr);
+int       xml_arena_enable(int enable);
+int       xml_arena_layout(int pages, int numa);
+int       xml_arena_release(int enable);
+uint64_t  xml_arena_trim(void);
+int       xml_arena_stats(uint64_t *objects, uint64_t *chunks, uint64_t *regions, uint64_t *huge);
+int       xml_arena_push(void);
+int       xml_arena_pop(void);
 int       xml_stats(cxobj *xt, uint64_t *nrp, size_t *szp);
 char     *xml_name(cxobj *xn);
 int       xml_name_set(cxobj *xn, char *name);
@@ -244,15 +283,22 @@ enum cxobj_type xml_type(cxobj *xn);
 int       xml_child_nr(cxobj *xn);
 int       xml_child_nr_type(cxobj *xn, enum cxobj_type type);
 int       xml_child_nr_notype(cxobj *xn, enum cxobj_type type);
+int       xml_child_nr_attr(cxobj *xn);
 cxobj    *xml_child_i(cxobj *xn, int i);
 cxobj    *xml_child_i_type(cxobj *xn, int i, enum cxobj_type type);
 cxobj    *xml_child_i_set(cxobj *xt, int i, cxobj *xc);
 int       xml_child_order(cxobj *xn, cxobj *xc);
 cxobj    *xml_child_each(cxobj *xparent, cxobj *xprev,  enum cxobj_type type);
 cxobj    *xml_child_each_attr(cxobj *xparent, cxobj *xprev);
+cxobj    *xml_child_yang(cxobj *xp, yang_stmt *yc);
+cxobj    *xml_child_yang_next(cxobj *xp, cxobj *xprev);
+cxobj    *xml_child_yang_key(cxobj *xp, yang_stmt *yc, yang_stmt *ykey, const char *val, int sorted);
+void      xml_iter_init(xml_iter_t *it, cxobj *xparent, enum cxobj_type type);
+cxobj    *xml_iter_next(xml_iter_t *it);
 int       xml_child_insert_pos(cxobj *x, cxobj *xc, int pos);
 int       xml_childvec_set(cxobj *x, int len);
 cxobj   **xml_childvec_get(cxobj *x);
+void      xml_childvec_reordered(cxobj *x);
 int       clixon_child_xvec_append(cxobj *x, clixon_xvec *xv);
 cxobj    *xml_new(char *name, cxobj *xn_parent, enum cxobj_type type);
 cxobj    *xml_new_body(char *name, cxobj *parent, char *val);
@@ -260,6 +306,8 @@ yang_stmt *xml_spec(cxobj *x);
 int       xml_spec_set(cxobj *x, yang_stmt *spec);
 cg_var   *xml_cv(cxobj *x);
 int       xml_cv_set(cxobj *x, cg_var *cv);
+yang_stmt *xml_union_type(cxobj *x);
+int       xml_union_type_set(cxobj *x, yang_stmt *ytype);
 cxobj    *xml_find(cxobj *xn_parent, char *name);
 int       xml_addsub(cxobj *xp, cxobj *xc);
 cxobj    *xml_wrap_all(cxobj *xp, char *tag);
@@ -286,23 +334,46 @@ int       xml_free(cxobj *xn);
 int       xml_copy_one(cxobj *xn0, cxobj *xn1);
 int       xml_copy(cxobj *x0, cxobj *x1);
 cxobj    *xml_dup(cxobj *x0);
+int       xml_freeze(cxobj *xt);
+cxobj    *xml_share(cxobj *xt);
+int       xml_shared(cxobj *xt);
+int       xml_mutable(cxobj **xtp);
+uint64_t  xml_tree_hash(cxobj *x);
 int       cxvec_dup(cxobj **vec0, int len0, cxobj ***vec1, int *len1);
 int       cxvec_append(cxobj *x, cxobj ***vec, int *len);
 int       cxvec_prepend(cxobj *x, cxobj ***vec, int *len);
 int       xml_apply(cxobj *xn, enum cxobj_type type, xml_applyfn_t fn, void *arg);
 int       xml_apply0(cxobj *xn, enum cxobj_type type, xml_applyfn_t fn, void *arg);
 int       xml_apply_ancestor(cxobj *xn, xml_applyfn_t fn, void *arg);
+int       xml_lazy_register(xml_lazyfn_t *fn, void *arg);
+int       xml_lazy_load(cxobj *x);
+int       xml_lazy_load_recurse(cxobj *x);
 int       xml_isancestor(cxobj *x, cxobj *xp);
 cxobj    *xml_root(cxobj *xn);
 int       xml_operation(char *opstr, enum operation_type *op);
 char     *xml_operation2str(enum operation_type op);
 int       xml_attr_insert2val(char *instr, enum insert_type *ins);
 cxobj    *xml_add_attr(cxobj *xn, char *name, char *value, char *prefix, char *ns);
+#ifdef XML_NAME_INTERN
+char     *xml_name_intern(const char *name);
+void      xml_name_intern_free(char *iname);
+int       xml_name_interned(cxobj *x);
+#endif
+#ifdef XML_NUM_CACHE
+int       xml_num_get(cxobj *x, int *neg, uint64_t *val);
+int       xml_num_set(cxobj *x, int neg, uint64_t val);
+#endif
+#ifdef XML_PATH_CACHE
+char     *xml_path_cache_get(cxobj *x, int spec);
+int       xml_path_cache_set(cxobj *x, int spec, char *path);
+void      xml_path_cache_invalidate(cxobj *x);
+#endif
 #ifdef XML_EXPLICIT_INDEX
 int       xml_search_index_p(cxobj *x);
 int       xml_search_vector_get(cxobj *x, char *name, clixon_xvec **xvec);
 int       xml_search_child_insert(cxobj *xp, cxobj *x);
 int       xml_search_child_rm(cxobj *xp, cxobj *x);
+int       xml_search_index_rebuild(cxobj *xt);
 cxobj    *xml_child_index_each(cxobj *xparent, char *name, cxobj *xprev, enum cxobj_type type);
 
 #endif
@@ -0,0 +1,52 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, indicate
+  your decision by deleting the provisions above and replace them with the 
+  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Binary serialization of bound XML trees, used as datastore snapshot format
+ * and as reply format on the internal backend socket
+ * @see CLICON_XMLDB_FORMAT  binary
+ * @see CLICON_SOCK_BINARY
+ */
+#ifndef _CLIXON_XML_BINARY_H
+#define _CLIXON_XML_BINARY_H
+
+/*
+ * Prototypes
+ */
+int clixon_xml2binary_file(FILE *f, cxobj *xt, yang_stmt *yspec);
+int clixon_binary_parse_file(FILE *fp, yang_bind yb, yang_stmt *yspec, cxobj **xt, int *bound);
+int clixon_xml2binary_cbuf(cbuf *cb, cxobj *xt, yang_stmt *yspec, int env, int32_t depth, withdefaults_type wdef);
+int clixon_binary_msg(const char *str);
+int clixon_binary_parse_string(const char *str, yang_stmt *yspec, cxobj **xt, int *bound);
+
+#endif /* _CLIXON_XML_BINARY_H */
@@ -45,10 +45,13 @@
  */
 int xml_bind_yang_unknown_anydata(int val);
 int xml_bind_netconf_message_id_optional(int val);
+int xml_bind_anydata_opaque(int val);
 int xml_bind_yang_rpc(clixon_handle h, cxobj *xrpc, yang_stmt *yspec, cxobj **xerr);
 int xml_bind_yang_rpc_reply(clixon_handle h, cxobj *xrpc, char *name, yang_stmt *yspec, cxobj **xerr);
+int xml_bind_yang_node(clixon_handle h, cxobj *xt, yang_bind yb, yang_stmt *yspec, cxobj **xerr);
 int xml_bind_yang0(clixon_handle h, cxobj *xt, yang_bind yb, yang_stmt *yspec, cxobj **xerr);
 int xml_bind_yang(clixon_handle h, cxobj *xt, yang_bind yb, yang_stmt *yspec, cxobj **xerr);
+int xml_bind_yang_bulk(clixon_handle h, cxobj *xt, yang_stmt *yspec, int unique, cxobj **xerr);
 int xml_bind_special(cxobj *xd, yang_stmt *yspec, char *schema_nodeid);
 
 #endif  /* _CLIXON_XML_BIND_H_ */
@@ -49,6 +49,7 @@ typedef enum yang_class yang_class;
 /*
  * Prototypes
  */
+int xml_default_node(cxobj *xn, int state);
 int xml_default_recurse(cxobj *xn, int state, int flag);
 int xml_global_defaults(clixon_handle h, cxobj *xn, cvec *nsc, const char *xpath, yang_stmt *yspec, int state);
 int xml_default_nopresence(cxobj *xn, int mode, int flag);
@@ -40,9 +40,45 @@
 #ifndef _CLIXON_XML_IO_H_
 #define _CLIXON_XML_IO_H_
 
+/*
+ * Types
+ */
+/*! Flush callback of streaming serialization
+ *
+ * @param[in]  cb   Output serialized so far, reset after call
+ * @param[in]  arg  Callback argument
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see clixon_xml2cbuf_stream
+ */
+typedef int (clixon_xml_flush_cb)(cbuf *cb, void *arg);
+
+/*! Entry callback of streaming parse, called for each completed top-most list entry
+ *
+ * @param[in]  x    List entry, bound and sorted, with its ancestors up to the top
+ * @param[in]  arg  Callback argument
+ * @retval     2    OK, entry is consumed and freed by the parser
+ * @retval     1    OK, entry is kept in the parse tree
+ * @retval     0    Failed, stop parsing
+ * @retval    -1    Error
+ * @see clixon_xml_parse_file_stream
+ */
+typedef int (clixon_xml_entry_cb)(cxobj *x, void *arg);
+
+/*! XML or JSON parser used by clixon_xml_parse_string/-file and clixon_json_parse_string/-file
+ *
+ * @see CLICON_XML_PARSER
+ * @see CLICON_JSON_PARSER
+ */
+enum xml_parser_mode{
+    XML_PARSER_BISON = 0, /* Flex/bison parser, the reference */
+    XML_PARSER_FAST,      /* Hand-written single-pass scanner */
+};
+
 /*
  * Prototypes
  */
+int   xml2output_wdef(cxobj *x, withdefaults_type wdef, int *tag);
 int   clixon_xml2file1(FILE *f, cxobj *xn, int level, int pretty, char *prefix,
                        clicon_output_cb *fn, int skiptop, int autocliext, withdefaults_type wdef,
                        int multi);
@@ -56,12 +92,23 @@ int   clixon_xml2cbuf1(cbuf *cb, cxobj *x, int level, int prettyprint, char *pre
                        int32_t depth, int skiptop, withdefaults_type wdef);
 int   clixon_xml2cbuf(cbuf *cb, cxobj *x, int level, int prettyprint, char *prefix, int32_t depth, 
 int skiptop);
+int   clixon_xml2cbuf_stream(cbuf *cb, cxobj *xn, int pretty, int32_t depth, int skiptop,
+                             withdefaults_type wdef, size_t size, clixon_xml_flush_cb *fn, void *arg);
+int   clixon_xml2cbuf_view(cbuf *cb, cxobj *xn, int32_t depth, withdefaults_type wdef,
+                           size_t size, clixon_xml_flush_cb *fn, void *arg);
 int   xmltree2cbuf(cbuf *cb, cxobj *x, int level);
+int   xml_parser_mode_set(int mode);
+int   xml_parser_mode_get(void);
 int   clixon_xml_parse_file(FILE *f, yang_bind yb, yang_stmt *yspec, cxobj **xt, cxobj **xerr);
+int   clixon_xml_parse_file_stream(FILE *f, yang_stmt *yspec, int defaults,
+                                   clixon_xml_entry_cb *fn, void *arg, cxobj **xt, cxobj **xerr);
 int   clixon_xml_parse_string(const char *str, yang_bind yb, yang_stmt *yspec, cxobj **xt, cxobj **xerr);
 int   clixon_xml_parse_va(yang_bind yb, yang_stmt *yspec, cxobj **xt, cxobj **xerr,
                         const char *format, ...)  __attribute__ ((format (printf, 5, 6)));
 int   clixon_xml_attr_copy(cxobj *xin, cxobj *xout, char *name);
+int   xml_opaque_raw(cxobj *xb);
+int   xml_opaque_make(cxobj *x);
+int   xml_opaque_expand(cxobj *x);
 int   clixon_xml_diff2cbuf(cbuf *cb, cxobj *x0, cxobj *x1);
 
 #endif  /* _CLIXON_XML_IO_H_ */
@@ -58,6 +58,8 @@ int     xml_nsctx_get_prefix(cvec *cvv, char *ns, char **prefix);
 int     xml_nsctx_add(cvec *nsc, char *prefix, char *ns);
 int     xml_nsctx_node(cxobj *x, cvec **ncp);
 int     xml_nsctx_yang(yang_stmt *yn, cvec **ncp);
+cvec   *xml_nsctx_yang_shared(yang_stmt *yn);
+void    xml_nsctx_yang_shared_free(yang_stmt *ymod);
 int     xml_nsctx_yangspec(yang_stmt *yspec, cvec **ncp);
 int     xml_nsctx_cbuf(cbuf *cb, cvec *nsc);
 int     xml2ns(cxobj *x, char *localname, char **ns);
@@ -41,12 +41,16 @@
 /*
  * Prototypes
  */
+int xml_cv_get(cxobj *x, cg_var **cvp);
 int xml_cmp(cxobj *x1, cxobj *x2, int same, int skip1, char *expl);
 int xml_sort(cxobj *x);
 int xml_sort_by(cxobj *x, char *indexvar);
+int xml_sort_level(cxobj *xn);
 int xml_sort_recurse(cxobj *xn);
 int xml_insert(cxobj *xp, cxobj *xc, enum insert_type ins, char *key_val, cvec *nsckey);
+int xml_insert_pos_hint(cxobj *xp, cxobj *xi, int pos);
 int xml_sort_verify(cxobj *x, void *arg);
+int xml_child_range_yang(cxobj *xp, yang_stmt *yc, int *lo, int *hi);
 #ifdef XML_EXPLICIT_INDEX
 int xml_search_indexvar_binary_pos(cxobj *xp, char *indexvar, clixon_xvec *xvec,
                                    int low, int upper, int max, int *eq);
@@ -102,6 +102,27 @@ enum xp_type{
     XP_PRIME_FN,
 };
 
+/*! XPath evaluation mode
+ *
+ * @see CLICON_XPATH_EVAL
+ */
+enum xpath_eval_mode{
+    XPATH_EVAL_INTERPRET = 0, /* Recursive evaluation of the parse tree */
+    XPATH_EVAL_COMPILE,       /* Compiled evaluation if possible, otherwise interpret */
+    XPATH_EVAL_DIFFERENTIAL   /* Both, error if results differ */
+};
+
+struct xp_ctx;
+struct xpath_tree;
+struct xp_fnarg;
+
+/*! Implementation of an XPath function, resolved at parse time
+ *
+ * @see xp_function_fn
+ */
+typedef int (xpath_fn_t)(struct xp_ctx *xc, struct xpath_tree *xs, cvec *nsc, int localonly,
+                         struct xp_ctx **xrp);
+
 /*! XPATH Parsing generates a tree of nodes that is later traversed
  *
  * That is, a tree-structured XPath.
@@ -118,6 +139,10 @@ struct xpath_tree{
     struct xpath_tree *xs_c0;     /* child 0 */
     struct xpath_tree *xs_c1;     /* child 1 */
     int                xs_match;  /* meta: match this node */
+    struct xpath_prog *xs_prog;   /* meta: compiled program, top node only */
+    char              *xs_iname;  /* meta: interned xs_s1 of XP_NODE, see xml_name_intern */
+    xpath_fn_t        *xs_fn;     /* meta: function of XP_PRIME_FN, see xp_function_fn */
+    struct xp_fnarg   *xs_fnarg;  /* meta: pre-compiled constant argument of function args */
 };
 typedef struct xpath_tree xpath_tree;
 
@@ -134,9 +159,15 @@ int   xpath_tree_eq(xpath_tree *xt1, xpath_tree *xt2, xpath_tree ***vec, size_t
 xpath_tree *xpath_tree_traverse(xpath_tree *xt, ...);
 int   xpath_tree_free(xpath_tree *xs);
 int   xpath_parse(const char *xpath, xpath_tree **xptree);
+int   xpath_cache_size_set(uint32_t size);
+int   xpath_cache_stats(uint64_t *nr, uint64_t *hits, uint64_t *misses);
+int   xpath_eval_mode_set(int mode);
+int   xpath_eval_mode_get(void);
 int   xpath_vec_ctx(cxobj *xcur, cvec *nsc, const char *xpath, int localonly, xp_ctx  **xrp);
+int   xpath_tree_vec_ctx(cxobj *xcur, cvec *nsc, xpath_tree *xptree, int localonly, xp_ctx **xrp);
 
 int    xpath_vec_bool(cxobj *xcur, cvec *nsc, const char *xpformat, ...) __attribute__ ((format (printf, 3, 4)));
+int    xpath_tree_vec_bool(cxobj *xcur, cvec *nsc, xpath_tree *xptree);
 int    xpath_vec_flag(cxobj *xcur, cvec *nsc, const char *xpformat, uint16_t flags,
                    cxobj ***vec, size_t *veclen, ...) __attribute__ ((format (printf, 3, 7)));
 
@@ -38,8 +38,25 @@
 #ifndef _CLIXON_XPATH_OPTIMIZE_H
 #define _CLIXON_XPATH_OPTIMIZE_H
 
+/*
+ * Types
+ */
+/*! XPath optimizer rules
+ *
+ * @see xpath_list_optimize_stats
+ */
+enum xpath_optimize_rule{
+    XPATH_OPT_LIST_KEY = 0,  /* y[k1='a'][k2='b']: all list keys in any order */
+    XPATH_OPT_LEAF_LIST,     /* y[.='a']: leaf-list value */
+    XPATH_OPT_SEARCH_INDEX,  /* y[i='a']: leaf with search_index extension */
+    XPATH_OPT_NR             /* Number of rules */
+};
 
-int  xpath_list_optimize_stats(int *hits);
+/*
+ * Prototypes
+ */
+int  xpath_list_optimize_stats(int *hits, int *rulehits);
+const char *xpath_optimize_rule2str(int rule);
 int  xpath_list_optimize_set(int enable);
 void xpath_optimize_exit(void);
 int  xpath_optimize_check(xpath_tree *xs, cxobj *xv, cxobj ***xvec0, int *xlen0);
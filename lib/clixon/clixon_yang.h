@@ -62,6 +62,8 @@
                                * list elements using this index with binary search */
 #endif
 #define YANG_FLAG_STATE_LOCAL  0x10  /* Local inverted value of Y_CONFIG child */
+#define YANG_FLAG_INTEGER      0x20  /* Leaf or leaf-list of integer type, set when a value is
+                                      * first parsed, see xml_cmp. */
 #define YANG_FLAG_DISABLED     0x40  /* Disabled due to if-feature evaluate to false
                                       * Transformed to ANYDATA but some code may need to check
                                       * why it is an ANYDATA
@@ -100,6 +102,10 @@
                                       * may be different from orig, therefore do not use link to
                                       * original. May also be due to deviations of derived trees
                                       */
+#define YANG_FLAG_FINDINDEX   0x4000 /* Use external table to access child lookup index,
+                                      * see yang_find and YANG_FIND_INDEX_MIN */
+#define YANG_FLAG_ARG_SHARED  0x8000 /* Argument is not owned by node: it points into the shared
+                                      * mapping of a yang cache file, see CLICON_YANG_CACHE_DIR */
 /*! Names of top-level data YANGs
  */
 #define YANG_DOMAIN_TOP "top"
@@ -208,6 +214,7 @@ enum yang_class{
 typedef enum yang_class yang_class;
 
 struct xml;
+struct xpath_tree;
 
 /* This is the external handle type exposed in the API.
  * The internal struct is defined in clixon_yang_internal.h */
@@ -265,6 +272,7 @@ int        yang_cv_set(yang_stmt *ys, cg_var *cv);
 cvec      *yang_cvec_get(yang_stmt *ys);
 int        yang_cvec_set(yang_stmt *ys, cvec *cvv);
 cg_var    *yang_cvec_add(yang_stmt *ys, enum cv_type type, char *name);
+int        yang_identity_derived(yang_stmt *ybaseid, const char *idref);
 int        yang_cvec_rm(yang_stmt *ys, char *name);
 uint16_t   yang_flag_get(yang_stmt *ys, uint16_t flag);
 int        yang_flag_set(yang_stmt *ys, uint16_t flag);
@@ -279,11 +287,13 @@ uint32_t   yang_linenum_get(yang_stmt *ys);
 int        yang_linenum_set(yang_stmt *ys, uint32_t linenum);
 void      *yang_typecache_get(yang_stmt *ys);
 int        yang_typecache_set(yang_stmt *ys, void *ycache);
+int        yang_xpath_cache_get(yang_stmt *ys, int canonical, char **xpath, struct xpath_tree **xptree, cvec **nsc);
 yang_stmt* yang_mymodule_get(yang_stmt *ys);
 int        yang_mymodule_set(yang_stmt *ys, yang_stmt *ym);
 
 /* Stats */
 int        yang_stats_global(uint64_t *nr);
+uint64_t   yang_stats_generation(void);
 int        yang_stats(yang_stmt *y, enum rfc_6020 keyw, uint64_t *nrp, size_t *szp);
 
 /* Other functions */
@@ -301,6 +311,7 @@ int        ys_cp(yang_stmt *nw, yang_stmt *old);
 yang_stmt *ys_dup(yang_stmt *old);
 int        yn_insert(yang_stmt *ys_parent, yang_stmt *ys_child);
 int        yn_insert1(yang_stmt *ys_parent, yang_stmt *ys_child);
+int        yang_find_index_reset(yang_stmt *yn);
 yang_stmt *yn_iter(yang_stmt *yparent, int *inext);
 char      *yang_key2str(int keyword);
 int        yang_str2key(char *str);
@@ -312,6 +323,7 @@ yang_stmt *ys_domain(yang_stmt *ys);
 yang_stmt *ys_mounts(yang_stmt *ys);
 yang_stmt *yang_find(yang_stmt *yn, int keyword, const char *argument);
 yang_stmt *yang_find_datanode(yang_stmt *yn, char *argument);
+yang_stmt *yang_find_datanode_ns(yang_stmt *yn, const char *ns, char *argument);
 yang_stmt *yang_find_schemanode(yang_stmt *yn, char *argument);
 char      *yang_find_myprefix(yang_stmt *ys);
 char      *yang_find_mynamespace(yang_stmt *ys);
@@ -320,6 +332,7 @@ int        yang_find_namespace_by_prefix(yang_stmt *ys, char *prefix, char **ns)
 yang_stmt *yang_myroot(yang_stmt *ys);
 int        yang_choice_case_get(yang_stmt *yc, yang_stmt **ycase, yang_stmt **ychoice);
 yang_stmt *yang_choice(yang_stmt *y);
+int        yang_choice_members(yang_stmt *ychoice, yang_stmt ***nodes, yang_stmt ***branches, int *len);
 int        yang_order(yang_stmt *y);
 int        yang_print_cb(FILE *f, yang_stmt *yn, clicon_output_cb *fn);
 int        yang_print(FILE *f, yang_stmt *yn);
@@ -337,13 +350,16 @@ int        yang_abs_schema_nodeid(yang_stmt *ys, char *schema_nodeid, yang_stmt
 int        yang_desc_schema_nodeid(yang_stmt *yn, char *schema_nodeid, yang_stmt **yres);
 int        yang_config(yang_stmt *ys);
 int        yang_config_ancestor(yang_stmt *ys);
+int        yang_config_only(yang_stmt *y);
 int        yang_features(clixon_handle h, yang_stmt *yt);
+int        yang_feature_disable(clixon_handle h, yang_stmt *yspec, const char *module, const char *feature, yang_applyfn_t *fn, void *arg);
 cvec      *yang_arg2cvec(yang_stmt *ys, char *delimi);
 int        yang_key_match(yang_stmt *yn, char *name, int *lastkey);
 int        yang_type_cache_get2(yang_stmt *ytype, yang_stmt **resolved, int *options,
                                 cvec **cvv, cvec *patterns, cvec *regexps, uint8_t *fraction);
 int        yang_type_cache_set2(yang_stmt *ys, yang_stmt *resolved, int options, cvec *cvv,
                                 cvec *patterns, uint8_t fraction, int rxmode, cvec *regexps);
+cvec      *yang_type_cache_regexps(yang_stmt *ytype);
 yang_stmt *yang_anydata_add(yang_stmt *yp, char *name);
 int        yang_extension_value(yang_stmt *ys, char *name, char *ns, int *exist, char **value);
 int        yang_sort_subelements(yang_stmt *ys);
@@ -354,5 +370,10 @@ int        ys_populate_feature(clixon_handle h, yang_stmt *ys);
 int        yang_init(clixon_handle h);
 int        yang_start(clixon_handle h);
 int        yang_exit(clixon_handle h);
+#ifdef XML_EXPLICIT_INDEX
+int        yang_list_index_add(yang_stmt *ys);
+int        yang_search_index_add(yang_stmt *yspec, char *schema_nodeid);
+int        yang_search_index_options(clixon_handle h, yang_stmt *yspec);
+#endif
 
 #endif  /* _CLIXON_YANG_H_ */
@@ -62,6 +62,7 @@ int        yang_spec_parse_module(clixon_handle h, const char *module,
 yang_stmt *yang_parse_str(char *str, const char *name, yang_stmt *yspec);
 int        yang_spec_parse_file(clixon_handle h, char *filename, yang_stmt *yspec);
 int        yang_spec_load_dir(clixon_handle h, char *dir, yang_stmt *yspec);
+int        yang_spec_digest(clixon_handle h, yang_stmt *yspec, uint64_t *digest);
 int        ys_parse_date_arg(char *datearg, uint32_t *dateint);
 cg_var    *ys_parse(yang_stmt *ys, enum cv_type cvtype);
 int        ys_parse_sub(yang_stmt *ys, const char *filename, char *extra);
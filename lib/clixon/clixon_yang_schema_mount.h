@@ -61,6 +61,7 @@ int yang_mount_get_yspec_any(yang_stmt *y, yang_stmt **yspec);
 int yang_mount_set(yang_stmt *yu, char *xpath, yang_stmt *yspec);
 int xml_yang_mount_get(clixon_handle h, cxobj *x, validate_level *vl, char **xpathp, yang_stmt **yspec);
 int xml_yang_mount_set(clixon_handle h, cxobj *x,  yang_stmt *yspec);
+int xml_yang_mount_del(clixon_handle h, cxobj *x);
 int yang_mount_xtop2xmnt(cxobj *xtop, cvec **cvvp);
 int yang_mount_yspec2ymnt(yang_stmt *yspec, cvec **cvvp);
 int yang_schema_mount_statedata(clixon_handle h, yang_stmt *yspec, char *xpath, cvec *nsc, cxobj **xret, cxobj **xerr);
@@ -55,6 +55,7 @@ typedef struct yang_type_cache yang_type_cache;
 /*
  * Prototypes
  */
+int        compile_pattern2regexp(clixon_handle h, yang_stmt *ytype, cvec *patterns, cvec *regexps);
 int        ys_resolve_type(yang_stmt *ys, void *arg);
 int        yang2cv_type(char *ytype, enum cv_type *cv_type);
 char      *cv2yang_type(enum cv_type cv_type);
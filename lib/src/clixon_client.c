@@ -37,14 +37,21 @@
 #endif
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <unistd.h>
 #include <syslog.h>
 #include <string.h>
 #include <errno.h>
 #include <assert.h>
+#include <poll.h>
+#include <time.h>
+#include <inttypes.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
 #include <netinet/in.h>
+#ifdef HAVE_LIBPTHREAD
+#include <pthread.h>
+#endif
 
 /* cligen */
 #include <cligen/cligen.h>
@@ -82,6 +89,42 @@
 
 #define chandle(ch) (assert(clixon_client_handle_check(ch)==0),(struct clixon_client_handle *)(ch))
 
+/* Stream of datastore generation notifications invalidating the read cache */
+#define CLIENT_CACHE_STREAM "DATASTORE-CHANGE"
+
+/* Client handles may be shared by threads. Calls of the clixon library, which has
+ * global state, are serialized by one lock. It is released while waiting for input
+ * and while calling completion callbacks
+ */
+#ifdef HAVE_LIBPTHREAD
+static pthread_mutex_t _client_mutex = PTHREAD_MUTEX_INITIALIZER;
+#define CLIENT_LOCK()   pthread_mutex_lock(&_client_mutex)
+#define CLIENT_UNLOCK() pthread_mutex_unlock(&_client_mutex)
+#define CLIENT_BROADCAST(cch) pthread_cond_broadcast(&(cch)->cch_cond)
+#else
+#define CLIENT_LOCK()
+#define CLIENT_UNLOCK()
+#define CLIENT_BROADCAST(cch)
+#endif
+
+/*! Request on a shared IPC connection
+ *
+ * Requests are pipelined with unique message-ids and replies are matched by message-id.
+ */
+struct client_req {
+    qelem_t           cr_qelem;  /* List header */
+    uint32_t          cr_id;     /* message-id */
+    int               cr_done;   /* Reply received, or connection closed */
+    cxobj            *cr_xret;   /* Reply, NULL if connection closed */
+    clixon_client_cb *cr_fn;     /* Completion callback, NULL if a thread waits for reply */
+    void             *cr_arg;    /* Completion callback argument */
+    char             *cr_xpath;  /* XPath of asynchronous get */
+    char             *cr_key;    /* Read cache key, or NULL */
+    uint64_t          cr_epoch;  /* Read cache epoch when sent */
+    int               cr_hit;    /* Read cache hit, value in cr_val */
+    char             *cr_val;    /* Value of read cache hit */
+};
+
 /*! Internal structure of clixon client handle. 
  */
 struct clixon_client_handle{
@@ -92,6 +135,20 @@ struct clixon_client_handle{
     char              *cch_descr;  /* Description of socket / peer for logging  XXX NYI */
     int                cch_pid;    /* Sub-process-id Only applies for NETCONF/SSH */
     int                cch_locked; /* State variable: 1 means locked */
+    clixon_msg_rcv    *cch_rcv;    /* Receive state of IPC socket */
+    uint32_t           cch_msgid;  /* Last message-id of IPC requests */
+    int                cch_reading;/* A thread reads replies from IPC socket */
+    int                cch_eof;    /* IPC socket closed by backend */
+    struct client_req *cch_pending;   /* Requests waiting for reply */
+    struct client_req *cch_completed; /* Asynchronous requests waiting for callback */
+    int                cch_async;  /* Nr of asynchronous requests not yet called back */
+    clicon_hash_t     *cch_cache;  /* Read cache: value per namespace and xpath, or NULL */
+    uint64_t           cch_epoch;  /* Read cache epoch, incremented when flushed */
+    int                cch_notify; /* Socket of DATASTORE-CHANGE subscription, or -1 */
+    clixon_msg_rcv    *cch_notify_rcv; /* Receive state of subscription socket */
+#ifdef HAVE_LIBPTHREAD
+    pthread_cond_t     cch_cond;   /* Signals replies and end of reading */
+#endif
 };
 
 /*! Check struct magic number for sanity checks
@@ -376,10 +433,17 @@ clixon_client_connect(clixon_handle      h,
     cch->cch_magic   = CLIXON_CLIENT_MAGIC;
     cch->cch_type = socktype;
     cch->cch_h = h;
+    cch->cch_notify = -1;
+#ifdef HAVE_LIBPTHREAD
+    pthread_cond_init(&cch->cch_cond, NULL);
+#endif
+    CLIENT_LOCK();
     switch (socktype){
     case CLIXON_CLIENT_IPC:
         if (clicon_rpc_connect(h, &cch->cch_socket) < 0)
             goto err;
+        if ((cch->cch_rcv = clixon_msg_rcv_new()) == NULL)
+            goto err;
         break;
     case CLIXON_CLIENT_NETCONF:
         if (clixon_client_connect_netconf(h, cch) < 0)
@@ -391,39 +455,97 @@ clixon_client_connect(clixon_handle      h,
             goto err;
 #else
         clixon_err(OE_UNIX, 0, "No ssh bin");
-        goto done;
+        goto err;
 #endif
         break;
     } /* switch */
+    CLIENT_UNLOCK();
  done:
     clixon_debug(CLIXON_DBG_DEFAULT, "retval:%p", cch);
     return cch;
  err:
+    CLIENT_UNLOCK();
     if (cch)
         clixon_client_disconnect(cch);
     cch = NULL;
     goto done;
 }
 
+/*! Free a request on a shared IPC connection
+ *
+ * @param[in]  cr  Request
+ */
+static int
+client_req_free(struct client_req *cr)
+{
+    if (cr->cr_xret)
+        xml_free(cr->cr_xret);
+    if (cr->cr_xpath)
+        free(cr->cr_xpath);
+    if (cr->cr_key)
+        free(cr->cr_key);
+    if (cr->cr_val)
+        free(cr->cr_val);
+    free(cr);
+    return 0;
+}
+
+/*! Stop the read cache and close its subscription socket
+ *
+ * @param[in]  cch   Clixon client handle, locked
+ */
+static int
+client_cache_close(struct clixon_client_handle *cch)
+{
+    if (cch->cch_cache){
+        clicon_hash_free(cch->cch_cache);
+        cch->cch_cache = NULL;
+    }
+    cch->cch_epoch++;
+    if (cch->cch_notify != -1){
+        close(cch->cch_notify);
+        cch->cch_notify = -1;
+    }
+    if (cch->cch_notify_rcv){
+        clixon_msg_rcv_free(cch->cch_notify_rcv);
+        cch->cch_notify_rcv = NULL;
+    }
+    return 0;
+}
+
 /*! Disconnect client
  *
  * @param[in]  ch        Clixon client session handle
  * @retval     0         OK
  * @retval    -1         Error
  * @see clixon_client_connect where the handle is created
- * The handle is deallocated
+ * The handle is deallocated. Outstanding asynchronous requests are dropped without
+ * calling their callbacks. No other thread may use the handle.
  */
 int
 clixon_client_disconnect(clixon_client_handle ch)
 {
     int                          retval = -1;
     struct clixon_client_handle *cch = chandle(ch);
+    struct client_req           *cr;
 
     clixon_debug(CLIXON_DBG_DEFAULT, "");
     if (cch == NULL){
         clixon_err(OE_XML, EINVAL, "Expected cch handle");
         goto done;
     }
+    CLIENT_LOCK();
+    while ((cr = cch->cch_pending) != NULL){
+        DELQ(cr, cch->cch_pending, struct client_req *);
+        client_req_free(cr);
+    }
+    while ((cr = cch->cch_completed) != NULL){
+        DELQ(cr, cch->cch_completed, struct client_req *);
+        client_req_free(cr);
+    }
+    client_cache_close(cch);
+    if (cch->cch_rcv)
+        clixon_msg_rcv_free(cch->cch_rcv);
     /* unlock (if locked) */
     if (cch->cch_locked)
         ;//     (void)clixon_client_lock(cch->cch_socket, 0, "running");
@@ -435,10 +557,16 @@ clixon_client_disconnect(clixon_client_handle ch)
     case CLIXON_CLIENT_SSH:
     case CLIXON_CLIENT_NETCONF:
         if (clixon_proc_socket_close(cch->cch_pid,
-                                     cch->cch_socket) < 0)
+                                     cch->cch_socket) < 0){
+            CLIENT_UNLOCK();
             goto done;
+        }
         break;
     }
+    CLIENT_UNLOCK();
+#ifdef HAVE_LIBPTHREAD
+    pthread_cond_destroy(&cch->cch_cond);
+#endif
     free(cch);
     retval = 0;
  done:
@@ -479,49 +607,48 @@ clixon_xml_bottom(cxobj  *xtop,
     return retval;
 }
 
-/*! Internal function to construct a get-config and query a value from the backend
+/*! Append the start tag of an rpc to a message
  *
- * @param[in]  h         Clixon handle
- * @param[in]  sock      Socket
- * @param[in]  descr     Description of peer for logging
- * @param[in]  namespace Default namespace used for non-prefixed entries in xpath. (Alt use nsc)
+ * @param[in]  msg       Message buffer
+ * @param[in]  id        message-id of a pipelined IPC request, or 0
+ */
+static int
+clixon_client_rpc_start(cbuf    *msg,
+                        uint32_t id)
+{
+    cprintf(msg, "<rpc xmlns=\"%s\"", NETCONF_BASE_NAMESPACE);
+    cprintf(msg, " xmlns:%s=\"%s\"",
+            NETCONF_BASE_PREFIX, NETCONF_BASE_NAMESPACE);
+    if (id)
+        cprintf(msg, " message-id=\"%u\" xmlns:%s=\"%s\" %s:pipeline=\"true\"",
+                id, CLIXON_LIB_PREFIX, CLIXON_LIB_NS, CLIXON_LIB_PREFIX);
+    else
+        cprintf(msg, " %s", NETCONF_MESSAGE_ID_ATTR);
+    cprintf(msg, ">");
+    return 0;
+}
+
+/*! Append a get-config rpc of running to a message
+ *
+ * @param[in]  msg       Message buffer
+ * @param[in]  id        message-id of a pipelined IPC request, or 0
+ * @param[in]  namespace Default namespace used for non-prefixed entries in xpath
  * @param[in]  xpath     XPath
- * @param[out] xdata     XML data tree (may or may not include the intended data)
  * @retval     0         OK
  * @retval    -1         Error
- * @note configurable netconf framing type, now hardwired to 0
  */
 static int
-clixon_client_get_xdata(clixon_handle h,
-                        int         sock,
-                        const char *descr,
-                        const char *namespace,
-                        const char *xpath,
-                        cxobj     **xdata)
+clixon_client_get_config_msg(cbuf       *msg,
+                             uint32_t    id,
+                             const char *namespace,
+                             const char *xpath)
 {
     int          retval = -1;
-    cxobj       *xret = NULL;
-    cxobj       *xd;
-    cbuf        *msg = NULL;
-    cbuf        *msgret = NULL;
     const char  *db = "running";
     cvec        *nsc = NULL;
-    int          eof = 0;
 
-    clixon_debug(CLIXON_DBG_DEFAULT, "");
-    if ((msg = cbuf_new()) == NULL){
-        clixon_err(OE_PLUGIN, errno, "cbuf_new");
-        goto done;
-    }
-    if ((msgret = cbuf_new()) == NULL){
-        clixon_err(OE_PLUGIN, errno, "cbuf_new");
-        goto done;
-    }
-    cprintf(msg, "<rpc xmlns=\"%s\"", NETCONF_BASE_NAMESPACE);
-    cprintf(msg, " xmlns:%s=\"%s\"",
-            NETCONF_BASE_PREFIX, NETCONF_BASE_NAMESPACE);
-    cprintf(msg, " %s", NETCONF_MESSAGE_ID_ATTR);
-    cprintf(msg, "><get-config><source><%s/></source>", db);
+    clixon_client_rpc_start(msg, id);
+    cprintf(msg, "<get-config><source><%s/></source>", db);
     if (xpath && strlen(xpath)){
         cprintf(msg, "<%s:filter %s:type=\"xpath\" xmlns=\"%s\" %s:select=\"%s\"",
                 NETCONF_BASE_PREFIX,
@@ -534,6 +661,36 @@ clixon_client_get_xdata(clixon_handle h,
         cprintf(msg, "/>");
     }
     cprintf(msg, "</get-config></rpc>");
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Send a message to the backend and receive its reply
+ *
+ * @param[in]  sock      Socket
+ * @param[in]  descr     Description of peer for logging
+ * @param[in]  msg       Message, framed on return
+ * @param[out] xret      XML reply tree. Free with xml_free
+ * @retval     0         OK
+ * @retval    -1         Error
+ * @note configurable netconf framing type, now hardwired to 0
+ * @see client_rpc  Pipelined on IPC socket
+ */
+static int
+clixon_client_rpc(int         sock,
+                  const char *descr,
+                  cbuf       *msg,
+                  cxobj     **xret)
+{
+    int   retval = -1;
+    cbuf *msgret = NULL;
+    int   eof = 0;
+
+    if ((msgret = cbuf_new()) == NULL){
+        clixon_err(OE_PLUGIN, errno, "cbuf_new");
+        goto done;
+    }
     if (netconf_output_encap(0, msg) < 0) // XXX configurable session
         goto done;
     if (clixon_msg_send10(sock, descr, msg) < 0)
@@ -545,83 +702,560 @@ clixon_client_get_xdata(clixon_handle h,
         clixon_err(OE_PROTO, ESHUTDOWN, "Unexpected close of CLICON_SOCK. Clixon backend daemon may have crashed.");
         goto done;
     }
-    if (clixon_xml_parse_string(cbuf_get(msgret), YB_NONE, NULL, &xret, NULL) < 0)
+    if (clixon_xml_parse_string(cbuf_get(msgret), YB_NONE, NULL, xret, NULL) < 0)
+        goto done;
+    retval = 0;
+ done:
+    if (msgret)
+        cbuf_free(msgret);
+    return retval;
+}
+
+/*! Wait for another thread reading replies, or for timeout
+ *
+ * @param[in]  cch      Clixon client handle, locked
+ * @param[in]  timeout  Timeout in ms, -1 for no timeout
+ */
+static int
+client_wait(struct clixon_client_handle *cch,
+            int                          timeout)
+{
+#ifdef HAVE_LIBPTHREAD
+    struct timespec ts;
+
+    if (timeout < 0)
+        pthread_cond_wait(&cch->cch_cond, &_client_mutex);
+    else {
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_sec += timeout/1000;
+        ts.tv_nsec += (timeout%1000)*1000000L;
+        if (ts.tv_nsec >= 1000000000L){
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000L;
+        }
+        pthread_cond_timedwait(&cch->cch_cond, &_client_mutex, &ts);
+    }
+#endif
+    return 0;
+}
+
+/*! Key of a value in read cache
+ *
+ * @param[in]  namespace Default namespace of xpath
+ * @param[in]  xpath     XPath
+ * @retval     key       Key, free with free
+ * @retval     NULL      Error
+ */
+static char *
+client_cache_key(const char *namespace,
+                 const char *xpath)
+{
+    char  *key = NULL;
+    cbuf  *cb = NULL;
+
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cb, "%s %s", namespace?namespace:"", xpath?xpath:"");
+    if ((key = strdup(cbuf_get(cb))) == NULL)
+        clixon_err(OE_UNIX, errno, "strdup");
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return key;
+}
+
+/*! Flush read cache
+ *
+ * @param[in]  cch   Clixon client handle, locked
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+client_cache_flush(struct clixon_client_handle *cch)
+{
+    clixon_debug(CLIXON_DBG_DEFAULT, "epoch:%" PRIu64, cch->cch_epoch);
+    cch->cch_epoch++;
+    if (cch->cch_cache == NULL)
+        return 0;
+    clicon_hash_free(cch->cch_cache);
+    if ((cch->cch_cache = clicon_hash_init()) == NULL)
+        return -1;
+    return 0;
+}
+
+/*! Read pending datastore generation notifications, without blocking
+ *
+ * The read cache is flushed on any change of running. If the subscription is closed,
+ * the read cache is stopped, since changes could be missed.
+ * @param[in]  cch   Clixon client handle, locked
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+client_notify_input(struct clixon_client_handle *cch)
+{
+    int           retval = -1;
+    struct pollfd pfd;
+    cbuf         *cb = NULL;
+    cxobj        *xt = NULL;
+    cxobj        *xn;
+    char         *str;
+    int           eof = 0;
+    int           rd;
+
+    while (cch->cch_notify != -1){
+        rd = 0;
+        /* Poll under lock so that no thread blocks on the read */
+        if (!clixon_msg_rcv_pending(cch->cch_notify_rcv)){
+            pfd.fd = cch->cch_notify;
+            pfd.events = POLLIN;
+            pfd.revents = 0;
+            if (poll(&pfd, 1, 0) <= 0 || pfd.revents == 0)
+                break;
+            rd = 1;
+        }
+        if (clixon_msg_rcv11_next(cch->cch_notify, cch->cch_descr, cch->cch_notify_rcv,
+                                  rd, &cb, &eof) < 0)
+            goto done;
+        if (eof){
+            clixon_log(cch->cch_h, LOG_WARNING, "%s: subscription closed, read cache stopped",
+                       __FUNCTION__);
+            client_cache_close(cch);
+            break;
+        }
+        if (cb == NULL)
+            continue;
+        if (clixon_xml_parse_string(cbuf_get(cb), YB_NONE, NULL, &xt, NULL) < 0)
+            goto done;
+        if ((xn = xpath_first(xt, NULL, "notification/datastore-change")) != NULL &&
+            (str = xml_find_body(xn, "datastore")) != NULL &&
+            strcmp(str, "running") == 0)
+            if (client_cache_flush(cch) < 0)
+                goto done;
+        xml_free(xt);
+        xt = NULL;
+        cbuf_free(cb);
+        cb = NULL;
+    }
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    if (xt)
+        xml_free(xt);
+    return retval;
+}
+
+/*! Look up a value in read cache
+ *
+ * Notifications received are handled first, so that a value is not older than the
+ * last notification read.
+ * @param[in]  cch   Clixon client handle, locked
+ * @param[in]  key   Cache key
+ * @param[out] val   Value, or NULL if not found in running. Free with free
+ * @retval     1     Hit
+ * @retval     0     Miss, or cache not enabled
+ * @retval    -1     Error
+ */
+static int
+client_cache_get(struct clixon_client_handle *cch,
+                 const char                  *key,
+                 char                       **val)
+{
+    char *v;
+
+    *val = NULL;
+    if (cch->cch_cache == NULL)
+        return 0;
+    if (client_notify_input(cch) < 0)
+        return -1;
+    if (cch->cch_cache == NULL ||
+        clicon_hash_lookup(cch->cch_cache, key) == NULL)
+        return 0;
+    if ((v = clicon_hash_value(cch->cch_cache, key, NULL)) != NULL &&
+        (*val = strdup(v)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        return -1;
+    }
+    return 1;
+}
+
+/*! Add a value to read cache, unless flushed since the request was sent
+ *
+ * @param[in]  cch   Clixon client handle, locked
+ * @param[in]  key   Cache key, or NULL
+ * @param[in]  epoch Read cache epoch when request was sent
+ * @param[in]  val   Value, or NULL if not found
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+client_cache_put(struct clixon_client_handle *cch,
+                 const char                  *key,
+                 uint64_t                     epoch,
+                 char                        *val)
+{
+    if (cch->cch_cache == NULL || key == NULL)
+        return 0;
+    if (client_notify_input(cch) < 0)
+        return -1;
+    if (cch->cch_cache == NULL || epoch != cch->cch_epoch)
+        return 0;
+    if (clicon_hash_add(cch->cch_cache, key, val, val?strlen(val)+1:0) == NULL)
+        return -1;
+    return 0;
+}
+
+/*! Next message-id of a request
+ *
+ * @param[in]  cch   Clixon client handle, locked
+ * @retval     id    message-id of pipelined IPC request
+ * @retval     0     Not pipelined, other socket types
+ */
+static uint32_t
+client_msgid(struct clixon_client_handle *cch)
+{
+    if (cch->cch_type != CLIXON_CLIENT_IPC)
+        return 0;
+    if (++cch->cch_msgid == 0) /* 0 means not pipelined */
+        cch->cch_msgid++;
+    return cch->cch_msgid;
+}
+
+/*! Create a request on a shared IPC connection with a new message-id
+ *
+ * @param[in]  cch   Clixon client handle, locked
+ * @retval     cr    Request, free with client_req_free
+ * @retval     NULL  Error
+ */
+static struct client_req *
+client_req_new(struct clixon_client_handle *cch)
+{
+    struct client_req *cr;
+
+    if ((cr = malloc(sizeof(*cr))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        return NULL;
+    }
+    memset(cr, 0, sizeof(*cr));
+    cr->cr_id = client_msgid(cch);
+    cr->cr_epoch = cch->cch_epoch;
+    return cr;
+}
+
+/*! Send a request on a shared IPC connection
+ *
+ * @param[in]  cch   Clixon client handle, locked
+ * @param[in]  cr    Request, added to pending requests if sent
+ * @param[in]  msg   Message on the form <rpc message-id=...>, see clixon_client_rpc_start
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+client_req_send(struct clixon_client_handle *cch,
+                struct client_req           *cr,
+                cbuf                        *msg)
+{
+    if (cch->cch_eof){
+        clixon_err(OE_PROTO, ESHUTDOWN, "Unexpected close of CLICON_SOCK. Clixon backend daemon may have crashed.");
+        return -1;
+    }
+    if (clixon_msg_send11(cch->cch_socket, cch->cch_descr, msg) < 0)
+        return -1;
+    ADDQ(cr, cch->cch_pending);
+    return 0;
+}
+
+/*! Handle a reply on a shared IPC connection
+ *
+ * The reply is matched to a pending request by message-id. A waiting thread is
+ * woken, and an asynchronous request is queued for its callback.
+ * @param[in]  cch   Clixon client handle, locked
+ * @param[in]  str   Reply message
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+client_reply(struct clixon_client_handle *cch,
+             char                        *str)
+{
+    int                retval = -1;
+    cxobj             *xret = NULL;
+    cxobj             *xreply;
+    char              *msgid = NULL;
+    uint32_t           id = 0;
+    struct client_req *cr;
+
+    if (clixon_xml_parse_string(str, YB_NONE, NULL, &xret, NULL) < 0)
+        goto done;
+    if ((xreply = xml_find_type(xret, NULL, "rpc-reply", CX_ELMNT)) != NULL &&
+        (msgid = xml_find_type_value(xreply, NULL, "message-id", CX_ATTR)) != NULL)
+        id = strtoul(msgid, NULL, 10);
+    if ((cr = cch->cch_pending) != NULL)
+        do {
+            if (cr->cr_id == id)
+                break;
+            cr = NEXTQ(struct client_req *, cr);
+        } while (cr && cr != cch->cch_pending);
+    if (cr == NULL || cr->cr_id != id){
+        clixon_log(cch->cch_h, LOG_WARNING, "%s: reply with unknown message-id %s dropped",
+                   __FUNCTION__, msgid?msgid:"");
+        goto ok;
+    }
+    DELQ(cr, cch->cch_pending, struct client_req *);
+    cr->cr_xret = xret;
+    xret = NULL;
+    cr->cr_done = 1;
+    if (cr->cr_fn)
+        ADDQ(cr, cch->cch_completed);
+ ok:
+    retval = 0;
+ done:
+    if (xret)
+        xml_free(xret);
+    return retval;
+}
+
+/*! Read replies from a shared IPC connection
+ *
+ * One thread at a time reads, without holding the lock while waiting for input.
+ * Other threads wait until the reader has handled its input.
+ * If backend closes the socket, all pending requests are completed with no reply.
+ * @param[in]  cch      Clixon client handle, locked
+ * @param[in]  timeout  Timeout in ms, -1 for no timeout
+ * @retval     0        OK, replies may have been received
+ * @retval    -1        Error
+ */
+static int
+client_input(struct clixon_client_handle *cch,
+             int                          timeout)
+{
+    int                retval = -1;
+    struct pollfd      pfd[2];
+    int                nfds = 1;
+    struct client_req *cr;
+    cbuf              *cb = NULL;
+    int                eof = 0;
+    int                rd = 1;
+    int                ret;
+
+    if (cch->cch_reading) /* Another thread reads */
+        return client_wait(cch, timeout);
+    cch->cch_reading = 1;
+    if (!clixon_msg_rcv_pending(cch->cch_rcv)){
+        pfd[0].fd = cch->cch_socket;
+        pfd[0].events = POLLIN;
+        pfd[0].revents = 0;
+        if (cch->cch_notify != -1){
+            pfd[1].fd = cch->cch_notify;
+            pfd[1].events = POLLIN;
+            pfd[1].revents = 0;
+            nfds++;
+        }
+        CLIENT_UNLOCK();
+        ret = poll(pfd, nfds, timeout);
+        CLIENT_LOCK();
+        if (ret < 0){
+            if (errno == EINTR)
+                goto ok;
+            clixon_err(OE_UNIX, errno, "poll");
+            goto done;
+        }
+        if (nfds > 1 && pfd[1].revents && client_notify_input(cch) < 0)
+            goto done;
+        if (pfd[0].revents == 0)
+            goto ok;
+    }
+    do {
+        if (clixon_msg_rcv11_next(cch->cch_socket, cch->cch_descr, cch->cch_rcv, rd, &cb, &eof) < 0)
+            goto done;
+        rd = 0;
+        if (eof){
+            cch->cch_eof = 1;
+            while ((cr = cch->cch_pending) != NULL){
+                DELQ(cr, cch->cch_pending, struct client_req *);
+                cr->cr_done = 1;
+                if (cr->cr_fn)
+                    ADDQ(cr, cch->cch_completed);
+            }
+            break;
+        }
+        if (cb == NULL)
+            break;
+        if (client_reply(cch, cbuf_get(cb)) < 0)
+            goto done;
+        cbuf_free(cb);
+        cb = NULL;
+    } while (1);
+ ok:
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    cch->cch_reading = 0;
+    CLIENT_BROADCAST(cch);
+    return retval;
+}
+
+/*! Send a message to the backend and receive its reply, pipelined on IPC socket
+ *
+ * On IPC, other threads may have requests outstanding on the same socket. Other
+ * socket types have one request at a time.
+ * @param[in]  cch   Clixon client handle, locked
+ * @param[in]  id    message-id of msg, see client_msgid
+ * @param[in]  msg   Message on the form <rpc>, see clixon_client_rpc_start
+ * @param[out] xret  XML reply tree. Free with xml_free
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+client_rpc(struct clixon_client_handle *cch,
+           uint32_t                     id,
+           cbuf                        *msg,
+           cxobj                      **xret)
+{
+    int                retval = -1;
+    struct client_req *cr = NULL;
+
+    if (cch->cch_type != CLIXON_CLIENT_IPC)
+        return clixon_client_rpc(cch->cch_socket, cch->cch_descr, msg, xret);
+    if ((cr = malloc(sizeof(*cr))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    memset(cr, 0, sizeof(*cr));
+    cr->cr_id = id;
+    if (client_req_send(cch, cr, msg) < 0){
+        free(cr);
+        cr = NULL;
+        goto done;
+    }
+    while (!cr->cr_done)
+        if (client_input(cch, -1) < 0)
+            goto done;
+    if (cr->cr_xret == NULL){
+        clixon_err(OE_PROTO, ESHUTDOWN, "Unexpected close of CLICON_SOCK. Clixon backend daemon may have crashed.");
         goto done;
+    }
+    *xret = cr->cr_xret;
+    cr->cr_xret = NULL;
+    retval = 0;
+ done:
+    if (cr){
+        if (!cr->cr_done)
+            DELQ(cr, cch->cch_pending, struct client_req *);
+        client_req_free(cr);
+    }
+    return retval;
+}
+
+/*! Get the value of the bottom-most leaf of a get-config reply
+ *
+ * @param[in]  h     Clixon handle
+ * @param[in]  xret  Reply on the form <rpc-reply><data>...
+ * @param[out] val   Value, or NULL if not found. Free with free
+ * @retval     0     OK
+ * @retval    -1     Error, eg rpc-error reply
+ */
+static int
+client_reply_val(clixon_handle h,
+                 cxobj        *xret,
+                 char        **val)
+{
+    int    retval = -1;
+    cxobj *xd;
+    cxobj *xobj = NULL;
+    char  *str;
+
+    *val = NULL;
     if ((xd = xpath_first(xret, NULL, "/rpc-reply/rpc-error")) != NULL){
         xd = xml_parent(xd); /* point to rpc-reply */
         clixon_err_netconf(h, OE_NETCONF, 0, xd, "Get configuration");
         goto done; /* Not fatal */
     }
-    else if ((xd = xpath_first(xret, NULL, "/rpc-reply/data")) == NULL){
-        if ((xd = xml_new(NETCONF_OUTPUT_DATA, NULL, CX_ELMNT)) == NULL)
+    if ((xd = xpath_first(xret, NULL, "/rpc-reply/data")) != NULL &&
+        xml_child_nr_type(xd, CX_ELMNT) != 0){
+        if (clixon_xml_bottom(xd, &xobj) < 0)
             goto done;
-    }
-    else{
-        if (xml_rm(xd) < 0)
+        if (xobj && (str = xml_body(xobj)) != NULL &&
+            (*val = strdup(str)) == NULL){
+            clixon_err(OE_UNIX, errno, "strdup");
             goto done;
+        }
     }
-    *xdata = xd;
     retval = 0;
  done:
-    clixon_debug(CLIXON_DBG_DEFAULT, "retval:%d", retval);
-    if (xret)
-        xml_free(xret);
-    if (msg)
-        cbuf_free(msg);
-    if (msgret)
-        cbuf_free(msgret);
     return retval;
 }
 
 /*! Generic get value of body
  *
- * @param[in]  h         Clixon handle
- * @param[in]  sock      Open socket
- * @param[in]  descr     Description of peer for logging
+ * Look up in read cache if enabled, otherwise query the backend.
+ * @param[in]  cch       Clixon client handle, locked
  * @param[in]  namespace Default namespace used for non-prefixed entries in xpath.
  * @param[in]  xpath     XPath
- * @param[out] val       Output value
+ * @param[out] val       Output value. Free with free
  * @retval     0         OK
- * @retval    -1         Error
+ * @retval    -1         Error, including value not found
  */
 static int
-clixon_client_get_body_val(clixon_handle h,
-                           int         sock,
-                           const char *descr,
-                           const char *namespace,
-                           const char *xpath,
-                           char      **val)
+clixon_client_get_body_val(struct clixon_client_handle *cch,
+                           const char                  *namespace,
+                           const char                  *xpath,
+                           char                       **val)
 {
-    int    retval = -1;
-    cxobj *xdata = NULL;
-    cxobj *xobj = NULL;
+    int       retval = -1;
+    cxobj    *xret = NULL;
+    cbuf     *msg = NULL;
+    char     *key = NULL;
+    uint64_t  epoch;
+    uint32_t  id;
+    int       ret;
 
     clixon_debug(CLIXON_DBG_DEFAULT, "");
     if (val == NULL){
         clixon_err(OE_XML, EINVAL, "Expected val");
         goto done;
     }
-    if (clixon_client_get_xdata(h, sock, descr, namespace, xpath, &xdata) < 0)
-        goto done;
-    if (xdata == NULL){
-        clixon_err(OE_XML, EINVAL, "No xml obj found");
-        goto done;
+    *val = NULL;
+    epoch = cch->cch_epoch;
+    if (cch->cch_cache){
+        if ((key = client_cache_key(namespace, xpath)) == NULL)
+            goto done;
+        if ((ret = client_cache_get(cch, key, val)) < 0)
+            goto done;
+        if (ret == 1)
+            goto found;
     }
-    /* Is this an error, maybe an "unset" retval ? */
-    if (xml_child_nr_type(xdata, CX_ELMNT) == 0){
-        clixon_err(OE_XML, EINVAL, "Value not found");
+    if ((msg = cbuf_new()) == NULL){
+        clixon_err(OE_PLUGIN, errno, "cbuf_new");
         goto done;
     }
-    if (clixon_xml_bottom(xdata, &xobj) < 0)
+    id = client_msgid(cch);
+    if (clixon_client_get_config_msg(msg, id, namespace, xpath) < 0)
+        goto done;
+    if (client_rpc(cch, id, msg, &xret) < 0)
         goto done;
-    if (xobj == NULL){
-        clixon_err(OE_XML, EINVAL, "No xml value found");
+    if (client_reply_val(cch->cch_h, xret, val) < 0)
+        goto done;
+    if (client_cache_put(cch, key, epoch, *val) < 0)
+        goto done;
+ found:
+    if (*val == NULL){
+        clixon_err(OE_XML, EINVAL, "Value not found");
         goto done;
     }
-    *val = xml_body(xobj);
     retval = 0;
  done:
     clixon_debug(CLIXON_DBG_DEFAULT, "retval:%d", retval);
+    if (key)
+        free(key);
+    if (xret)
+        xml_free(xret);
+    if (msg)
+        cbuf_free(msg);
     return retval;
 }
 
@@ -648,8 +1282,8 @@ clixon_client_get_bool(clixon_client_handle ch,
     uint8_t                      val0=0;
 
     clixon_debug(CLIXON_DBG_DEFAULT, "");
-    if (clixon_client_get_body_val(cch->cch_h, cch->cch_socket, cch->cch_descr,
-                                   namespace, xpath, &val) < 0)
+    CLIENT_LOCK();
+    if (clixon_client_get_body_val(cch, namespace, xpath, &val) < 0)
         goto done;
     if ((ret = parse_bool(val, &val0, &reason)) < 0){
         clixon_err(OE_XML, errno, "parse_bool");
@@ -662,6 +1296,9 @@ clixon_client_get_bool(clixon_client_handle ch,
     *rval = (int)val0;
     retval = 0;
  done:
+    CLIENT_UNLOCK();
+    if (val)
+        free(val);
     if (reason)
         free(reason);
     return retval;
@@ -689,13 +1326,16 @@ clixon_client_get_str(clixon_client_handle ch,
     char                        *val = NULL;
 
     clixon_debug(CLIXON_DBG_DEFAULT, "");
-    if (clixon_client_get_body_val(cch->cch_h, cch->cch_socket, cch->cch_descr,
-                                   namespace, xpath, &val) < 0)
+    CLIENT_LOCK();
+    if (clixon_client_get_body_val(cch, namespace, xpath, &val) < 0)
         goto done;
     strncpy(rval, val, n-1);
     rval[n-1]= '\0';
     retval = 0;
  done:
+    CLIENT_UNLOCK();
+    if (val)
+        free(val);
     return retval;
 }
 
@@ -721,8 +1361,8 @@ clixon_client_get_uint8(clixon_client_handle ch,
     int                          ret;
 
     clixon_debug(CLIXON_DBG_DEFAULT, "");
-    if (clixon_client_get_body_val(cch->cch_h, cch->cch_socket, cch->cch_descr,
-                                   namespace, xpath, &val) < 0)
+    CLIENT_LOCK();
+    if (clixon_client_get_body_val(cch, namespace, xpath, &val) < 0)
         goto done;
     if ((ret = parse_uint8(val, rval, &reason)) < 0){
         clixon_err(OE_XML, errno, "parse_bool");
@@ -734,6 +1374,9 @@ clixon_client_get_uint8(clixon_client_handle ch,
     }
     retval = 0;
  done:
+    CLIENT_UNLOCK();
+    if (val)
+        free(val);
     if (reason)
         free(reason);
     return retval;
@@ -761,8 +1404,8 @@ clixon_client_get_uint16(clixon_client_handle ch,
     int                          ret;
 
     clixon_debug(CLIXON_DBG_DEFAULT, "");
-    if (clixon_client_get_body_val(cch->cch_h, cch->cch_socket, cch->cch_descr,
-                                   namespace, xpath, &val) < 0)
+    CLIENT_LOCK();
+    if (clixon_client_get_body_val(cch, namespace, xpath, &val) < 0)
         goto done;
     if ((ret = parse_uint16(val, rval, &reason)) < 0){
         clixon_err(OE_XML, errno, "parse_bool");
@@ -774,6 +1417,9 @@ clixon_client_get_uint16(clixon_client_handle ch,
     }
     retval = 0;
  done:
+    CLIENT_UNLOCK();
+    if (val)
+        free(val);
     if (reason)
         free(reason);
     return retval;
@@ -801,8 +1447,8 @@ clixon_client_get_uint32(clixon_client_handle ch,
     int                          ret;
 
     clixon_debug(CLIXON_DBG_DEFAULT, "");
-    if (clixon_client_get_body_val(cch->cch_h, cch->cch_socket, cch->cch_descr,
-                                   namespace, xpath, &val) < 0)
+    CLIENT_LOCK();
+    if (clixon_client_get_body_val(cch, namespace, xpath, &val) < 0)
         goto done;
     if (val == NULL){
         clixon_err(OE_XML, EFAULT, "val is NULL");
@@ -818,6 +1464,9 @@ clixon_client_get_uint32(clixon_client_handle ch,
     }
     retval = 0;
  done:
+    CLIENT_UNLOCK();
+    if (val)
+        free(val);
     clixon_debug(CLIXON_DBG_DEFAULT, "retval:%d", retval);
     if (reason)
         free(reason);
@@ -846,8 +1495,8 @@ clixon_client_get_uint64(clixon_client_handle  ch,
     int                          ret;
 
     clixon_debug(CLIXON_DBG_DEFAULT, "");
-    if (clixon_client_get_body_val(cch->cch_h, cch->cch_socket, cch->cch_descr,
-                                   namespace, xpath, &val) < 0)
+    CLIENT_LOCK();
+    if (clixon_client_get_body_val(cch, namespace, xpath, &val) < 0)
         goto done;
     if ((ret = parse_uint64(val, rval, &reason)) < 0){
         clixon_err(OE_XML, errno, "parse_bool");
@@ -859,11 +1508,394 @@ clixon_client_get_uint64(clixon_client_handle  ch,
     }
     retval = 0;
  done:
+    CLIENT_UNLOCK();
+    if (val)
+        free(val);
     if (reason)
         free(reason);
     return retval;
 }
 
+/*! Client-api get values of several leafs in one batch message
+ *
+ * One message and reply for all leafs instead of one per leaf. Values in the read
+ * cache, if enabled, are not requested.
+ * @param[in]  ch        Clixon client handle
+ * @param[in]  namespace Default namespace used for non-prefixed entries in xpaths
+ * @param[in]  xpaths    Vector of XPaths, each to one leaf
+ * @param[in]  n         Length of xpaths and vals
+ * @param[out] vals      Vector of values. Set to NULL if not found. Free each with free()
+ * @retval     0         OK
+ * @retval    -1         Error
+ * @see clicon_rpc_batch
+ */
+int
+clixon_client_get_batch(clixon_client_handle ch,
+                        const char          *namespace,
+                        const char         **xpaths,
+                        int                  n,
+                        char               **vals)
+{
+    int                          retval = -1;
+    struct clixon_client_handle *cch = chandle(ch);
+    cbuf                        *msg = NULL;
+    cxobj                       *xret = NULL;
+    cxobj                       *xr;
+    cxobj                       *xd;
+    cxobj                       *xobj;
+    cxobj                       *xerr;
+    char                        *val;
+    char                       **keys = NULL;
+    int                         *miss = NULL;
+    int                          nmiss = 0;
+    uint64_t                     epoch;
+    uint32_t                     id;
+    int                          i;
+    int                          j;
+    int                          ret;
+
+    clixon_debug(CLIXON_DBG_DEFAULT, "");
+    for (i=0; i<n; i++)
+        vals[i] = NULL;
+    CLIENT_LOCK();
+    if (n == 0)
+        goto ok;
+    epoch = cch->cch_epoch;
+    if ((miss = calloc(n, sizeof(int))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    if (cch->cch_cache &&
+        (keys = calloc(n, sizeof(char *))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    for (i=0; i<n; i++){
+        if (keys){
+            if ((keys[i] = client_cache_key(namespace, xpaths[i])) == NULL)
+                goto done;
+            if ((ret = client_cache_get(cch, keys[i], &vals[i])) < 0)
+                goto done;
+            if (ret == 1)
+                continue;
+        }
+        miss[nmiss++] = i;
+    }
+    if (nmiss == 0)
+        goto ok;
+    if ((msg = cbuf_new()) == NULL){
+        clixon_err(OE_PLUGIN, errno, "cbuf_new");
+        goto done;
+    }
+    id = client_msgid(cch);
+    clixon_client_rpc_start(msg, id);
+    cprintf(msg, "<batch xmlns=\"%s\"><operations>", CLIXON_LIB_NS);
+    for (j=0; j<nmiss; j++)
+        if (clixon_client_get_config_msg(msg, 0, namespace, xpaths[miss[j]]) < 0)
+            goto done;
+    cprintf(msg, "</operations></batch></rpc>");
+    if (client_rpc(cch, id, msg, &xret) < 0)
+        goto done;
+    if ((xerr = xpath_first(xret, NULL, "/rpc-reply/rpc-error")) != NULL){
+        clixon_err_netconf(cch->cch_h, OE_NETCONF, 0, xml_parent(xerr), "Get configuration batch");
+        goto done;
+    }
+    if ((xr = xpath_first(xret, NULL, "/rpc-reply/replies")) == NULL){
+        clixon_err(OE_XML, EINVAL, "No batch replies found");
+        goto done;
+    }
+    /* Replies are in the order of requests */
+    xd = NULL;
+    for (j=0; j<nmiss; j++){
+        i = miss[j];
+        if ((xd = xml_child_each(xr, xd, CX_ELMNT)) == NULL)
+            break;
+        if ((xobj = xml_find_type(xd, NULL, NETCONF_OUTPUT_DATA, CX_ELMNT)) == NULL)
+            continue; /* Not cached, eg rpc-error */
+        if (xml_child_nr_type(xobj, CX_ELMNT) != 0){
+            if (clixon_xml_bottom(xobj, &xobj) < 0)
+                goto done;
+            if ((val = xml_body(xobj)) != NULL &&
+                (vals[i] = strdup(val)) == NULL){
+                clixon_err(OE_UNIX, errno, "strdup");
+                goto done;
+            }
+        }
+        if (keys && client_cache_put(cch, keys[i], epoch, vals[i]) < 0)
+            goto done;
+    }
+ ok:
+    retval = 0;
+ done:
+    CLIENT_UNLOCK();
+    clixon_debug(CLIXON_DBG_DEFAULT, "retval:%d", retval);
+    if (retval < 0)
+        for (i=0; i<n; i++)
+            if (vals[i]){
+                free(vals[i]);
+                vals[i] = NULL;
+            }
+    if (keys){
+        for (i=0; i<n; i++)
+            if (keys[i])
+                free(keys[i]);
+        free(keys);
+    }
+    if (miss)
+        free(miss);
+    if (xret)
+        xml_free(xret);
+    if (msg)
+        cbuf_free(msg);
+    return retval;
+}
+
+/*! Client-api asynchronous get of a leaf value
+ *
+ * The request is pipelined on the IPC socket of the handle, which may be shared by
+ * several threads with outstanding requests. The value is returned to the completion
+ * callback, called from clixon_client_poll. A value in the read cache, if enabled,
+ * is also returned via the callback.
+ * @param[in]  ch        Clixon client handle
+ * @param[in]  namespace Default namespace used for non-prefixed entries in xpath
+ * @param[in]  xpath     XPath of a leaf
+ * @param[in]  fn        Completion callback
+ * @param[in]  arg       Completion callback argument
+ * @retval     0         OK, request sent
+ * @retval    -1         Error
+ * @code
+ *   if (clixon_client_get_async(ch, "urn:example:clixon", "/table/parameter[name='x']/value",
+ *                               my_cb, myarg) < 0)
+ *      err;
+ *   while (clixon_client_pending(ch) > 0)
+ *      if (clixon_client_poll(ch, 1000) < 0)
+ *         err;
+ * @endcode
+ * @note Only for CLIXON_CLIENT_IPC
+ */
+int
+clixon_client_get_async(clixon_client_handle ch,
+                        const char          *namespace,
+                        const char          *xpath,
+                        clixon_client_cb    *fn,
+                        void                *arg)
+{
+    int                          retval = -1;
+    struct clixon_client_handle *cch = chandle(ch);
+    struct client_req           *cr = NULL;
+    cbuf                        *msg = NULL;
+    int                          ret;
+
+    clixon_debug(CLIXON_DBG_DEFAULT, "");
+    CLIENT_LOCK();
+    if (cch->cch_type != CLIXON_CLIENT_IPC){
+        clixon_err(OE_PROTO, EINVAL, "Asynchronous requests require CLIXON_CLIENT_IPC");
+        goto done;
+    }
+    if ((cr = client_req_new(cch)) == NULL)
+        goto done;
+    cr->cr_fn = fn;
+    cr->cr_arg = arg;
+    if ((cr->cr_xpath = strdup(xpath?xpath:"")) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    if (cch->cch_cache){
+        if ((cr->cr_key = client_cache_key(namespace, xpath)) == NULL)
+            goto done;
+        if ((ret = client_cache_get(cch, cr->cr_key, &cr->cr_val)) < 0)
+            goto done;
+        if (ret == 1){
+            cr->cr_hit = 1;
+            cr->cr_done = 1;
+            ADDQ(cr, cch->cch_completed);
+            cr = NULL;
+            cch->cch_async++;
+            goto ok;
+        }
+    }
+    if ((msg = cbuf_new()) == NULL){
+        clixon_err(OE_PLUGIN, errno, "cbuf_new");
+        goto done;
+    }
+    if (clixon_client_get_config_msg(msg, cr->cr_id, namespace, xpath) < 0)
+        goto done;
+    if (client_req_send(cch, cr, msg) < 0)
+        goto done;
+    cr = NULL;
+    cch->cch_async++;
+ ok:
+    retval = 0;
+ done:
+    CLIENT_UNLOCK();
+    if (cr)
+        client_req_free(cr);
+    if (msg)
+        cbuf_free(msg);
+    return retval;
+}
+
+/*! Call completion callbacks of asynchronous gets, waiting for replies if needed
+ *
+ * Callbacks are called without holding the client lock, and may make new requests.
+ * If no reply has arrived, wait at most timeout for replies.
+ * @param[in]  ch        Clixon client handle
+ * @param[in]  timeout   Timeout in ms, -1 for no timeout, 0 to not wait
+ * @retval     n         Number of callbacks called
+ * @retval    -1         Error, or a callback returned -1
+ * @see clixon_client_get_async
+ */
+int
+clixon_client_poll(clixon_client_handle ch,
+                   int                  timeout)
+{
+    int                          retval = -1;
+    struct clixon_client_handle *cch = chandle(ch);
+    struct client_req           *cr;
+    char                        *val;
+    int                          err;
+    int                          n = 0;
+    int                          ret;
+
+    CLIENT_LOCK();
+    if (cch->cch_completed == NULL && cch->cch_async > 0 &&
+        client_input(cch, timeout) < 0)
+        goto done;
+    while ((cr = cch->cch_completed) != NULL){
+        DELQ(cr, cch->cch_completed, struct client_req *);
+        cch->cch_async--;
+        val = NULL;
+        err = 0;
+        if (cr->cr_hit){
+            val = cr->cr_val;
+            cr->cr_val = NULL;
+        }
+        else if (cr->cr_xret == NULL){
+            clixon_err(OE_PROTO, ESHUTDOWN, "Unexpected close of CLICON_SOCK. Clixon backend daemon may have crashed.");
+            err = -1;
+        }
+        else if (client_reply_val(cch->cch_h, cr->cr_xret, &val) < 0)
+            err = -1;
+        else if (client_cache_put(cch, cr->cr_key, cr->cr_epoch, val) < 0){
+            client_req_free(cr);
+            goto done;
+        }
+        CLIENT_UNLOCK();
+        ret = cr->cr_fn(ch, cr->cr_xpath, val, err, cr->cr_arg);
+        CLIENT_LOCK();
+        if (val)
+            free(val);
+        client_req_free(cr);
+        n++;
+        if (ret < 0)
+            goto done;
+    }
+    retval = n;
+ done:
+    CLIENT_UNLOCK();
+    return retval;
+}
+
+/*! Number of asynchronous gets whose callbacks are not yet called
+ *
+ * @param[in]  ch     Clixon client handle
+ * @retval     n      Number of outstanding asynchronous gets
+ */
+int
+clixon_client_pending(clixon_client_handle ch)
+{
+    struct clixon_client_handle *cch = chandle(ch);
+    int                          n;
+
+    CLIENT_LOCK();
+    n = cch->cch_async;
+    CLIENT_UNLOCK();
+    return n;
+}
+
+/*! Enable or disable local read cache of values of running
+ *
+ * Values read with the get functions are cached per namespace and xpath. The cache
+ * is flushed when a datastore generation notification of running arrives on a
+ * subscription of the DATASTORE-CHANGE stream, see CLICON_STREAM_DATASTORE_CHANGE.
+ * Notifications are read before a value is looked up. The cache is eventually
+ * consistent: a value may be stale until the notification of a change has arrived.
+ * @param[in]  ch        Clixon client handle
+ * @param[in]  enable    0: disable and flush, 1: enable
+ * @retval     0         OK
+ * @retval    -1         Error, eg backend has no DATASTORE-CHANGE stream
+ * @note Only for CLIXON_CLIENT_IPC
+ */
+int
+clixon_client_cache(clixon_client_handle ch,
+                    int                  enable)
+{
+    int                          retval = -1;
+    struct clixon_client_handle *cch = chandle(ch);
+    cbuf                        *msg = NULL;
+    cbuf                        *cbret = NULL;
+    cxobj                       *xret = NULL;
+    cxobj                       *xerr;
+    int                          eof = 0;
+
+    clixon_debug(CLIXON_DBG_DEFAULT, "enable:%d", enable);
+    CLIENT_LOCK();
+    if (!enable){
+        client_cache_close(cch);
+        goto ok;
+    }
+    if (cch->cch_cache != NULL)
+        goto ok;
+    if (cch->cch_type != CLIXON_CLIENT_IPC){
+        clixon_err(OE_PROTO, EINVAL, "Read cache requires CLIXON_CLIENT_IPC");
+        goto done;
+    }
+    /* Subscribe before any value is cached so that no change is missed */
+    if (clicon_rpc_connect(cch->cch_h, &cch->cch_notify) < 0){
+        cch->cch_notify = -1;
+        goto done;
+    }
+    if ((msg = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    clixon_client_rpc_start(msg, 0);
+    cprintf(msg, "<create-subscription xmlns=\"%s\"><stream>%s</stream></create-subscription></rpc>",
+            EVENT_RFC5277_NAMESPACE, CLIENT_CACHE_STREAM);
+    if (clixon_msg_send11(cch->cch_notify, cch->cch_descr, msg) < 0)
+        goto done;
+    if (clixon_msg_rcv11(cch->cch_notify, cch->cch_descr, 0, &cbret, &eof) < 0)
+        goto done;
+    if (eof){
+        clixon_err(OE_PROTO, ESHUTDOWN, "Unexpected close of CLICON_SOCK. Clixon backend daemon may have crashed.");
+        goto done;
+    }
+    if (clixon_xml_parse_string(cbuf_get(cbret), YB_NONE, NULL, &xret, NULL) < 0)
+        goto done;
+    if ((xerr = xpath_first(xret, NULL, "//rpc-error")) != NULL){
+        clixon_err_netconf(cch->cch_h, OE_NETCONF, 0, xerr, "Create subscription");
+        goto done;
+    }
+    if ((cch->cch_notify_rcv = clixon_msg_rcv_new()) == NULL)
+        goto done;
+    if ((cch->cch_cache = clicon_hash_init()) == NULL)
+        goto done;
+    cch->cch_epoch++;
+ ok:
+    retval = 0;
+ done:
+    if (retval < 0)
+        client_cache_close(cch);
+    CLIENT_UNLOCK();
+    if (xret)
+        xml_free(xret);
+    if (msg)
+        cbuf_free(msg);
+    if (cbret)
+        cbuf_free(cbret);
+    return retval;
+}
+
 /* Access functions */
 /*! Client-api get uint64
  *
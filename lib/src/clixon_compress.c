@@ -0,0 +1,342 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2016 Olof Hagsand and Benny Holmgren
+  Copyright (C) 2017-2019 Olof Hagsand
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC (Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+  * Streaming compression of datastore files, see CLICON_XMLDB_COMPRESS
+  * The serializers write to and the parsers read from a stdio stream that compresses or
+  * decompresses in chunks, so that neither the uncompressed nor the compressed file is
+  * held in memory.
+ */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE /* fopencookie */
+#endif
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/types.h>
+#ifdef HAVE_LIBZSTD
+#include <zstd.h>
+#endif
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_err.h"
+#include "clixon_debug.h"
+#include "clixon_options.h"
+#include "clixon_compress.h"
+
+/* First bytes of a zstd frame, little-endian ZSTD_MAGICNUMBER */
+static const unsigned char zstd_magic[4] = {0x28, 0xb5, 0x2f, 0xfd};
+
+#ifdef HAVE_LIBZSTD
+
+/* Compressing write stream */
+struct zstd_wr {
+    FILE      *zw_f;       /* Compressed output, not closed */
+    ZSTD_CCtx *zw_cctx;
+    char      *zw_out;     /* Compressed chunk */
+    size_t     zw_outlen;
+};
+
+/* Decompressing read stream */
+struct zstd_rd {
+    FILE          *zr_f;     /* Compressed input, closed with stream */
+    ZSTD_DCtx     *zr_dctx;
+    char          *zr_in;    /* Compressed chunk */
+    size_t         zr_inlen;
+    ZSTD_inBuffer  zr_inb;   /* Unconsumed part of chunk */
+    size_t         zr_last;  /* Last return of ZSTD_decompressStream, 0 at end of frame */
+    int            zr_more;  /* Output buffer was filled, more output may be pending */
+    int            zr_eof;
+};
+
+/*! Compress and write out chunks
+ *
+ * @param[in]  zw    Write stream
+ * @param[in]  in    Input, or NULL at end
+ * @param[in]  op    ZSTD_e_continue or ZSTD_e_end
+ * @retval     0     OK
+ * @retval    -1     Error, errno set
+ */
+static int
+zstd_wr_stream(struct zstd_wr    *zw,
+               ZSTD_inBuffer     *in,
+               ZSTD_EndDirective  op)
+{
+    ZSTD_inBuffer  empty = {NULL, 0, 0};
+    ZSTD_outBuffer out;
+    size_t         r;
+
+    if (in == NULL)
+        in = &empty;
+    do {
+        out.dst = zw->zw_out;
+        out.size = zw->zw_outlen;
+        out.pos = 0;
+        r = ZSTD_compressStream2(zw->zw_cctx, &out, in, op);
+        if (ZSTD_isError(r)){
+            errno = EIO;
+            return -1;
+        }
+        if (out.pos && fwrite(zw->zw_out, 1, out.pos, zw->zw_f) != out.pos)
+            return -1;
+    } while (op == ZSTD_e_end ? r != 0 : in->pos < in->size);
+    return 0;
+}
+
+static ssize_t
+zstd_cookie_write(void       *cookie,
+                  const char *buf,
+                  size_t      len)
+{
+    struct zstd_wr *zw = (struct zstd_wr *)cookie;
+    ZSTD_inBuffer   in = {buf, len, 0};
+
+    if (zstd_wr_stream(zw, &in, ZSTD_e_continue) < 0)
+        return -1;
+    return len;
+}
+
+/*! End frame and free write stream, the output file is not closed */
+static int
+zstd_cookie_wclose(void *cookie)
+{
+    struct zstd_wr *zw = (struct zstd_wr *)cookie;
+    int             retval;
+
+    retval = zstd_wr_stream(zw, NULL, ZSTD_e_end);
+    ZSTD_freeCCtx(zw->zw_cctx);
+    free(zw->zw_out);
+    free(zw);
+    return retval;
+}
+
+static ssize_t
+zstd_cookie_read(void  *cookie,
+                 char  *buf,
+                 size_t len)
+{
+    struct zstd_rd *zr = (struct zstd_rd *)cookie;
+    ZSTD_outBuffer  out = {buf, len, 0};
+    size_t          n;
+    size_t          r;
+
+    while (out.pos < out.size){
+        if (zr->zr_inb.pos == zr->zr_inb.size && !zr->zr_more){
+            if (zr->zr_eof)
+                break;
+            if ((n = fread(zr->zr_in, 1, zr->zr_inlen, zr->zr_f)) == 0){
+                if (ferror(zr->zr_f)){
+                    errno = EIO;
+                    return -1;
+                }
+                zr->zr_eof = 1;
+                break;
+            }
+            zr->zr_inb.src = zr->zr_in;
+            zr->zr_inb.size = n;
+            zr->zr_inb.pos = 0;
+        }
+        r = ZSTD_decompressStream(zr->zr_dctx, &out, &zr->zr_inb);
+        if (ZSTD_isError(r)){
+            errno = EIO;
+            return -1;
+        }
+        zr->zr_last = r;
+        zr->zr_more = (out.pos == out.size);
+    }
+    /* Truncated frame */
+    if (out.pos == 0 && zr->zr_eof && zr->zr_last != 0){
+        errno = EIO;
+        return -1;
+    }
+    return out.pos;
+}
+
+/*! Free read stream and close input file */
+static int
+zstd_cookie_rclose(void *cookie)
+{
+    struct zstd_rd *zr = (struct zstd_rd *)cookie;
+    int             retval;
+
+    retval = fclose(zr->zr_f);
+    ZSTD_freeDCtx(zr->zr_dctx);
+    free(zr->zr_in);
+    free(zr);
+    return retval;
+}
+
+#endif /* HAVE_LIBZSTD */
+
+/*! Open a stream that compresses to a file
+ *
+ * The compressed end of the file is written when the stream is closed with fclose, which
+ * fails if the file cannot be written. f is not closed, eg so that it can be synced after.
+ * @param[in]  f      Output file
+ * @param[in]  mode   Compression algorithm
+ * @param[in]  level  Compression level, or 0 for the default of the algorithm
+ * @retval     fz     Compressing stream, close with fclose
+ * @retval     NULL   Error
+ * @code
+ *   if ((fz = clixon_compress_open(f, COMPRESS_ZSTD, 3)) == NULL)
+ *      err;
+ *   fprintf(fz, ...);
+ *   if (fclose(fz) != 0)
+ *      err;
+ * @endcode
+ */
+FILE *
+clixon_compress_open(FILE              *f,
+                     enum compress_mode mode,
+                     int                level)
+{
+#ifdef HAVE_LIBZSTD
+    FILE                   *fz = NULL;
+    struct zstd_wr         *zw = NULL;
+    cookie_io_functions_t   fns = {NULL, zstd_cookie_write, NULL, zstd_cookie_wclose};
+
+    if (mode != COMPRESS_ZSTD){
+        clixon_err(OE_UNIX, EINVAL, "Compression %d not supported", mode);
+        goto done;
+    }
+    if ((zw = calloc(1, sizeof(*zw))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    zw->zw_f = f;
+    zw->zw_outlen = ZSTD_CStreamOutSize();
+    if ((zw->zw_cctx = ZSTD_createCCtx()) == NULL ||
+        (zw->zw_out = malloc(zw->zw_outlen)) == NULL){
+        clixon_err(OE_UNIX, errno, "ZSTD_createCCtx");
+        goto done;
+    }
+    if (level && ZSTD_isError(ZSTD_CCtx_setParameter(zw->zw_cctx, ZSTD_c_compressionLevel, level))){
+        clixon_err(OE_CFG, EINVAL, "zstd compression level %d", level);
+        goto done;
+    }
+    if ((fz = fopencookie(zw, "w", fns)) == NULL){
+        clixon_err(OE_UNIX, errno, "fopencookie");
+        goto done;
+    }
+    zw = NULL;
+ done:
+    if (zw){
+        if (zw->zw_cctx)
+            ZSTD_freeCCtx(zw->zw_cctx);
+        if (zw->zw_out)
+            free(zw->zw_out);
+        free(zw);
+    }
+    return fz;
+#else
+    clixon_err(OE_UNIX, ENOTSUP, "Not built with zstd, see configure --with-libzstd");
+    return NULL;
+#endif
+}
+
+/*! Replace an open file with a decompressing stream if it is compressed
+ *
+ * The format is detected from the start of the file, so that uncompressed files are read
+ * as they are, eg after compression is enabled.
+ * @param[in,out] fpp  Open file from its start. Replaced by a stream that closes it
+ * @retval        0    OK, *fpp is unchanged or a decompressing stream
+ * @retval       -1    Error, *fpp is unchanged
+ */
+int
+clixon_decompress_file(FILE **fpp)
+{
+    int                     retval = -1;
+    unsigned char           magic[sizeof(zstd_magic)];
+#ifdef HAVE_LIBZSTD
+    FILE                   *fz;
+    struct zstd_rd         *zr = NULL;
+    cookie_io_functions_t   fns = {zstd_cookie_read, NULL, NULL, zstd_cookie_rclose};
+#endif
+
+    if (pread(fileno(*fpp), magic, sizeof(magic), 0) != sizeof(magic) ||
+        memcmp(magic, zstd_magic, sizeof(magic)) != 0)
+        goto ok;
+#ifdef HAVE_LIBZSTD
+    if ((zr = calloc(1, sizeof(*zr))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    zr->zr_f = *fpp;
+    zr->zr_inlen = ZSTD_DStreamInSize();
+    zr->zr_last = 1;
+    if ((zr->zr_dctx = ZSTD_createDCtx()) == NULL ||
+        (zr->zr_in = malloc(zr->zr_inlen)) == NULL){
+        clixon_err(OE_UNIX, errno, "ZSTD_createDCtx");
+        goto done;
+    }
+    if ((fz = fopencookie(zr, "r", fns)) == NULL){
+        clixon_err(OE_UNIX, errno, "fopencookie");
+        goto done;
+    }
+    clixon_debug(CLIXON_DBG_DATASTORE, "zstd compressed");
+    zr = NULL;
+    *fpp = fz;
+#else
+    clixon_err(OE_UNIX, ENOTSUP, "File is zstd compressed, not built with zstd, see configure --with-libzstd");
+    goto done;
+#endif
+ ok:
+    retval = 0;
+ done:
+#ifdef HAVE_LIBZSTD
+    if (zr){
+        if (zr->zr_dctx)
+            ZSTD_freeDCtx(zr->zr_dctx);
+        if (zr->zr_in)
+            free(zr->zr_in);
+        free(zr);
+    }
+#endif
+    return retval;
+}
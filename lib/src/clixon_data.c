@@ -727,8 +727,27 @@ clicon_modst_cache_get(clixon_handle h,
     return NULL;
 }
 
+/*! Get YANG generation when module state cache was set
+ *
+ * @param[in]  h     Clixon handle
+ * @param[in]  brief 0: Full module state tree, 1: Brief tree (datastore)
+ * @retval     gen   YANG generation, see yang_stats_generation, or 0 if not set
+ */
+uint64_t
+clicon_modst_cache_gen(clixon_handle h,
+                       int           brief)
+{
+    clicon_hash_t *cdat = clicon_data(h);
+    void          *p;
+
+    if ((p = clicon_hash_value(cdat, brief?"modst_brief_gen":"modst_full_gen", NULL)) != NULL)
+        return *(uint64_t *)p;
+    return 0;
+}
+
 /*! Set module state cache
  *
+ * The YANG generation is recorded, see clicon_modst_cache_gen
  * @param[in] h     Clixon handle
  * @param[in] brief 0: Full module state tree, 1: Brief tree (datastore)
  * @param[in] xms   Module state cache XML tree
@@ -742,6 +761,7 @@ clicon_modst_cache_set(clixon_handle h,
 {
     clicon_hash_t  *cdat = clicon_data(h);
     cxobj          *x;
+    uint64_t        gen;
 
     if ((x = clicon_modst_cache_get(h, brief)) != NULL)
         xml_free(x);
@@ -751,6 +771,9 @@ clicon_modst_cache_set(clixon_handle h,
         return -1;
     if (clicon_hash_add(cdat, brief?"modst_brief":"modst_full", &x, sizeof(x))==NULL)
         return -1;
+    gen = yang_stats_generation();
+    if (clicon_hash_add(cdat, brief?"modst_brief_gen":"modst_full_gen", &gen, sizeof(gen))==NULL)
+        return -1;
  ok:
     return 0;
 }
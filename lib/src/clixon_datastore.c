@@ -71,6 +71,7 @@
 #include "clixon_log.h"
 #include "clixon_debug.h"
 #include "clixon_string.h"
+#include "clixon_map.h"
 #include "clixon_file.h"
 #include "clixon_yang_module.h"
 #include "clixon_plugin.h"
@@ -80,10 +81,16 @@
 #include "clixon_xml_bind.h"
 #include "clixon_xml_default.h"
 #include "clixon_xml_io.h"
+#include "clixon_xpath_ctx.h"
+#include "clixon_xpath.h"
+#include "clixon_xml_map.h"
 #include "clixon_json.h"
+#include "clixon_validate.h"
 #include "clixon_datastore.h"
 #include "clixon_datastore_write.h"
+#include "clixon_uring.h"
 #include "clixon_datastore_read.h"
+#include "clixon_memstats.h"
 
 /*! Get xml database element including id, xml cache, empty on startup and dirty bit
  *
@@ -125,6 +132,90 @@ clicon_db_elmnt_set(clixon_handle h,
     return 0;
 }
 
+/*! Free XML cache tree of a datastore, or release it if shared with another datastore
+ *
+ * @param[in]  h    Clixon handle
+ * @param[in]  db   Name of database
+ * @param[in]  de   Database element, de_xml is set to NULL
+ */
+static void
+xmldb_cache_free(clixon_handle h,
+                 const char   *db,
+                 db_elmnt     *de)
+{
+    if (de->de_xml){
+        xml_leafref_index_drop(de->de_xml);
+        xml_free(de->de_xml); /* Releases one reference if shared, see xml_share */
+        de->de_xml = NULL;
+    }
+    de->de_edited = 0;
+    de->de_epoch++;
+}
+
+/*! Reset edit marks in an XML cache tree, only traversing marked subtrees
+ *
+ * @param[in]  x    XML node
+ * @param[in]  arg  General-purpose argument (not used)
+ * @retval     2    Locally abort this subtree, continue with others
+ * @retval     0    OK, continue
+ */
+static int
+xmldb_edited_reset(cxobj *x,
+                   void  *arg)
+{
+    if (xml_flag(x, XML_FLAG_EDITED) == 0)
+        return 2;
+    xml_flag_reset(x, XML_FLAG_EDITED);
+    return 0;
+}
+
+/*! Reset edit marks of a datastore cache tree
+ *
+ * @param[in]  xt   XML cache tree, or NULL
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+xmldb_edited_clear(cxobj *xt)
+{
+    if (xt == NULL)
+        return 0;
+    xml_flag_reset(xt, XML_FLAG_EDITED);
+    return xml_apply(xt, CX_ELMNT, xmldb_edited_reset, NULL);
+}
+
+/*! Make a private copy of a shared datastore cache before modifying it
+ *
+ * Must be called before the cache tree of a datastore is modified in place.
+ * No-op if the cache is not shared, except that leafref indexes of the tree are dropped
+ * @param[in]  h    Clixon handle
+ * @param[in]  db   Name of database
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see xmldb_copy  where caches are shared if CLICON_XMLDB_COPY_ON_WRITE is set
+ */
+int
+xmldb_cache_unshare(clixon_handle h,
+                    const char   *db)
+{
+    int       retval = -1;
+    db_elmnt *de;
+
+    if ((de = clicon_db_elmnt_get(h, db)) == NULL || de->de_xml == NULL)
+        goto ok;
+    if (xml_shared(de->de_xml)){
+        clixon_debug(CLIXON_DBG_DATASTORE, "%s", db);
+        if (xml_mutable(&de->de_xml) < 0)
+            goto done;
+    }
+    else /* Modified in place */
+        xml_leafref_index_drop(de->de_xml);
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Translate from symbolic database name to actual filename in file-system
  *
  * Internal function for explicit XMLDB_MULTI use or not
@@ -235,6 +326,382 @@ xmldb_db2subdir(clixon_handle h,
     return retval;
 }
 
+/*! Translate from symbolic database name to journal filename in file-system
+ *
+ * @param[in]   h        Clixon handle
+ * @param[in]   db       Symbolic database name, eg "candidate", "running"
+ * @param[out]  filename Journal filename. Unallocate after use with free()
+ * @retval      0        OK
+ * @retval     -1        Error
+ * @see CLICON_XMLDB_JOURNAL
+ */
+int
+xmldb_db2journal(clixon_handle h,
+                 const char   *db,
+                 char        **filename)
+{
+    int   retval = -1;
+    cbuf *cb = NULL;
+    char *dir;
+
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    if ((dir = clicon_xmldb_dir(h)) == NULL){
+        clixon_err(OE_XML, errno, "CLICON_XMLDB_DIR not set");
+        goto done;
+    }
+    cprintf(cb, "%s/%s_db.journal", dir, db);
+    if ((*filename = strdup4(cbuf_get(cb))) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Remove journal file of datastore if any
+ *
+ * @param[in]   h        Clixon handle
+ * @param[in]   db       Symbolic database name, eg "candidate", "running"
+ * @retval      0        OK
+ * @retval     -1        Error
+ */
+int
+xmldb_journal_remove(clixon_handle h,
+                     const char   *db)
+{
+    int   retval = -1;
+    char *filename = NULL;
+
+    if (xmldb_db2journal(h, db, &filename) < 0)
+        goto done;
+    if (unlink(filename) < 0 && errno != ENOENT){
+        clixon_err(OE_UNIX, errno, "unlink(%s)", filename);
+        goto done;
+    }
+    retval = 0;
+ done:
+    if (filename)
+        free(filename);
+    return retval;
+}
+
+/*! Load lazy xmldb-multi split node on demand, registered with xml_lazy_register
+ *
+ * Find which datastore cache the node belongs to and load the node from its sub-file
+ * @param[in]  x    XML node with XML_FLAG_LAZY set
+ * @param[in]  arg  Clixon handle
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+xmldb_lazy_loadfn(cxobj *x,
+                  void  *arg)
+{
+    int           retval = -1;
+    clixon_handle h = (clixon_handle)arg;
+    cxobj        *xt;
+    char        **keys = NULL;
+    size_t        klen;
+    size_t        i;
+    db_elmnt     *de;
+    char         *subdir = NULL;
+
+    xt = xml_root(x);
+    if (clicon_hash_keys(clicon_db_elmnt(h), &keys, &klen) < 0)
+        goto done;
+    for (i = 0; i < klen; i++){
+        if ((de = clicon_hash_value(clicon_db_elmnt(h), keys[i], NULL)) != NULL &&
+            de->de_xml == xt)
+            break;
+    }
+    if (i == klen){
+        clixon_err(OE_DB, 0, "Lazy node %s not in any datastore cache", xml_name(x));
+        goto done;
+    }
+    if (xmldb_db2subdir(h, keys[i], &subdir) < 0)
+        goto done;
+    if (xmldb_lazy_load1(h, x, subdir) < 0)
+        goto done;
+    retval = 0;
+ done:
+    if (subdir)
+        free(subdir);
+    if (keys)
+        free(keys);
+    return retval;
+}
+
+/* Vector of loaded lazy nodes, see xmldb_lazy_evict */
+struct xmldb_lazy_vec {
+    cxobj **lv_vec;
+    int     lv_len;
+};
+
+/*! Apply callback collecting loaded lazy nodes in a vector */
+static int
+xmldb_lazy_collect(cxobj *x,
+                   void  *arg)
+{
+    struct xmldb_lazy_vec *lv = (struct xmldb_lazy_vec *)arg;
+
+    if (xml_flag(x, XML_FLAG_LAZY_LOADED) == 0)
+        return 0;
+    if (cxvec_append(x, &lv->lv_vec, &lv->lv_len) < 0)
+        return -1;
+    return 2;
+}
+
+/*! Unload children of loaded lazy node, the sub-file is known to be in sync
+ *
+ * @param[in]  x    XML split node with XML_FLAG_LAZY_LOADED set
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+xmldb_lazy_unload(cxobj *x)
+{
+    cxobj *xc;
+
+    while ((xc = xml_child_i_type(x, 0, CX_ELMNT)) != NULL)
+        if (xml_purge(xc) < 0)
+            return -1;
+    xml_flag_reset(x, XML_FLAG_LAZY_LOADED|XML_FLAG_LAZY_REF);
+    xml_flag_set(x, XML_FLAG_LAZY);
+    return 0;
+}
+
+/*! Evict clean loaded lazy subtrees from datastore caches
+ *
+ * Keep at most CLICON_XMLDB_MULTI_CACHE loaded subtrees per datastore.
+ * Approximates LRU with a clock algorithm: a subtree referenced since the last sweep
+ * gets a second chance, see XML_FLAG_LAZY_REF. Subtrees not synced to disk and
+ * datastores that are volatile or shared are never evicted.
+ * Call only where the backend holds no pointers into datastore caches, eg between requests
+ * @param[in]  h   Clixon handle
+ * @retval     0   OK
+ * @retval    -1   Error
+ * @see CLICON_XMLDB_MULTI_LAZY
+ */
+int
+xmldb_lazy_evict(clixon_handle h)
+{
+    int       retval = -1;
+    char    **keys = NULL;
+    size_t    klen;
+    size_t    i;
+    db_elmnt *de;
+    int       max;
+    int       n;
+    int       j;
+    int       pass;
+    cxobj    *x;
+    struct xmldb_lazy_vec lv = {NULL, 0};
+
+    if (!clicon_option_bool(h, "CLICON_XMLDB_MULTI_LAZY") ||
+        (max = clicon_option_int(h, "CLICON_XMLDB_MULTI_CACHE")) <= 0)
+        goto ok;
+    if (clicon_hash_keys(clicon_db_elmnt(h), &keys, &klen) < 0)
+        goto done;
+    for (i = 0; i < klen; i++){
+        if ((de = clicon_hash_value(clicon_db_elmnt(h), keys[i], NULL)) == NULL ||
+            de->de_xml == NULL ||
+            de->de_volatile ||
+            xml_shared(de->de_xml))
+            continue;
+        lv.lv_len = 0;
+        if (xml_apply(de->de_xml, CX_ELMNT, xmldb_lazy_collect, &lv) < 0)
+            goto done;
+        n = lv.lv_len;
+        /* First pass gives referenced subtrees a second chance, second pass evicts any */
+        for (pass = 0; pass < 2 && n > max; pass++){
+            for (j = 0; j < lv.lv_len && n > max; j++){
+                x = lv.lv_vec[j];
+                if (xml_flag(x, XML_FLAG_LAZY) || xml_flag(x, XML_FLAG_CACHE_DIRTY))
+                    continue;
+                if (pass == 0 && xml_flag(x, XML_FLAG_LAZY_REF)){
+                    xml_flag_reset(x, XML_FLAG_LAZY_REF);
+                    continue;
+                }
+                clixon_debug(CLIXON_DBG_DATASTORE, "Evict %s from %s", xml_name(x), keys[i]);
+                if (xmldb_lazy_unload(x) < 0)
+                    goto done;
+                n--;
+            }
+        }
+    }
+ ok:
+    retval = 0;
+ done:
+    if (lv.lv_vec)
+        free(lv.lv_vec);
+    if (keys)
+        free(keys);
+    return retval;
+}
+
+/* Yang nodes disabled by a feature, see xmldb_feature_disable */
+struct xmldb_feature_vec {
+    yang_stmt **fv_vec;
+    int        *fv_kept;  /* Node changed to anydata, otherwise removed */
+    int         fv_len;
+};
+
+/*! Yang feature callback collecting disabled yang nodes
+ *
+ * Nodes removed are freed after the callback, only their addresses are used
+ */
+static int
+xmldb_feature_collect(yang_stmt *ys,
+                      void      *arg)
+{
+    struct xmldb_feature_vec *fv = (struct xmldb_feature_vec *)arg;
+    yang_stmt               **vec;
+    int                      *kept;
+
+    if ((vec = realloc(fv->fv_vec, (fv->fv_len+1)*sizeof(yang_stmt*))) == NULL){
+        clixon_err(OE_UNIX, errno, "realloc");
+        return -1;
+    }
+    fv->fv_vec = vec;
+    if ((kept = realloc(fv->fv_kept, (fv->fv_len+1)*sizeof(int))) == NULL){
+        clixon_err(OE_UNIX, errno, "realloc");
+        return -1;
+    }
+    fv->fv_kept = kept;
+    vec[fv->fv_len] = ys;
+    kept[fv->fv_len] = yang_flag_get(ys, YANG_FLAG_DISABLED) != 0;
+    fv->fv_len++;
+    return 0;
+}
+
+/*! Apply callback unbinding xml nodes */
+static int
+xmldb_feature_unbind(cxobj *x,
+                     void  *arg)
+{
+    xml_spec_set(x, NULL);
+    return 0;
+}
+
+/*! Re-bind XML cache tree after nodes have been disabled by a feature
+ *
+ * Children of nodes changed to anydata are unbound, nodes bound to removed yang are purged
+ * @param[in]  xt   XML node
+ * @param[in]  fv   Disabled yang nodes
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+xmldb_feature_rebind(cxobj                    *xt,
+                     struct xmldb_feature_vec *fv)
+{
+    int        retval = -1;
+    cxobj     *x;
+    yang_stmt *y;
+    int        i;
+    int        j;
+
+    i = 0;
+    while ((x = xml_child_i_type(xt, i, CX_ELMNT)) != NULL){
+        if ((y = xml_spec(x)) != NULL){
+            for (j = 0; j < fv->fv_len; j++)
+                if (fv->fv_vec[j] == y)
+                    break;
+            if (j < fv->fv_len){
+                if (!fv->fv_kept[j]){ /* y is freed */
+                    clixon_debug(CLIXON_DBG_DATASTORE, "Purge %s", xml_name(x));
+                    /* Unbind first since xml_purge may access the spec */
+                    if (xml_apply0(x, CX_ELMNT, xmldb_feature_unbind, NULL) < 0)
+                        goto done;
+                    if (xml_purge(x) < 0)
+                        goto done;
+                    continue;
+                }
+                if (xml_apply(x, CX_ELMNT, xmldb_feature_unbind, NULL) < 0)
+                    goto done;
+                i++;
+                continue;
+            }
+        }
+        if (xmldb_feature_rebind(x, fv) < 0)
+            goto done;
+        i++;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Disable a yang feature in the running backend and re-bind datastore caches
+ *
+ * The yang spec is changed in place, see yang_feature_disable, and only the datastore cache
+ * subtrees bound to disabled nodes are changed, clients need not reconnect.
+ * Config data of disabled nodes is kept as anydata, as when loading with the feature disabled.
+ * @param[in]  h       Clixon handle
+ * @param[in]  module  Name of module defining the feature
+ * @param[in]  feature Feature name
+ * @retval     1       OK, feature disabled
+ * @retval     0       No such feature, or feature not enabled
+ * @retval    -1       Error
+ * @note Enabling a feature, or changing deviations, requires a backend restart
+ */
+int
+xmldb_feature_disable(clixon_handle h,
+                      const char   *module,
+                      const char   *feature)
+{
+    int       retval = -1;
+    char    **keys = NULL;
+    size_t    klen;
+    size_t    i;
+    size_t    k;
+    db_elmnt *de;
+    db_elmnt *de1;
+    int       ret;
+    struct xmldb_feature_vec fv = {NULL, NULL, 0};
+
+    if ((ret = yang_feature_disable(h, clicon_dbspec_yang(h), module, feature,
+                                    xmldb_feature_collect, &fv)) < 0)
+        goto done;
+    /* Dependency map of incremental validation may refer to removed yangs */
+    if (ret == 1 && xml_yang_validate_depmap_free(h) < 0)
+        goto done;
+    if (ret == 0 || fv.fv_len == 0)
+        goto ok;
+    if (clicon_hash_keys(clicon_db_elmnt(h), &keys, &klen) < 0)
+        goto done;
+    for (i = 0; i < klen; i++){
+        if ((de = clicon_hash_value(clicon_db_elmnt(h), keys[i], NULL)) == NULL ||
+            de->de_xml == NULL)
+            continue;
+        /* Shared caches are re-bound once */
+        for (k = 0; k < i; k++)
+            if ((de1 = clicon_hash_value(clicon_db_elmnt(h), keys[k], NULL)) != NULL &&
+                de1->de_xml == de->de_xml)
+                break;
+        if (k < i)
+            continue;
+        if (xmldb_feature_rebind(de->de_xml, &fv) < 0)
+            goto done;
+    }
+ ok:
+    retval = ret;
+ done:
+    if (fv.fv_vec)
+        free(fv.fv_vec);
+    if (fv.fv_kept)
+        free(fv.fv_kept);
+    if (keys)
+        free(keys);
+    return retval;
+}
+
 /*! Connect to a datastore plugin, allocate resources to be used in API calls
  *
  * @param[in]  h    Clixon handle
@@ -244,6 +711,11 @@ xmldb_db2subdir(clixon_handle h,
 int
 xmldb_connect(clixon_handle h)
 {
+    if (clicon_option_bool(h, "CLICON_XMLDB_MULTI") &&
+        clicon_option_bool(h, "CLICON_XMLDB_MULTI_LAZY"))
+        xml_lazy_register(xmldb_lazy_loadfn, h);
+    if (xmldb_uring(h))
+        clicon_file_uring_set(1);
     return 0;
 }
 
@@ -266,11 +738,20 @@ xmldb_disconnect(clixon_handle h)
         goto done;
     for(i = 0; i < klen; i++) 
         if ((de = clicon_hash_value(clicon_db_elmnt(h), keys[i], NULL)) != NULL){
-            if (de->de_xml){
-                xml_free(de->de_xml);
-                de->de_xml = NULL;
-            }
+            if (xmldb_flush_wait(h, keys[i]) < 0)
+                goto done;
+            /* Compact journal into snapshot */
+            if (de->de_journal && de->de_xml && !de->de_volatile)
+                if (xmldb_write_cache2file(h, keys[i]) < 0)
+                    goto done;
+            xmldb_cache_free(h, keys[i], de);
         }
+    xml_lazy_register(NULL, NULL);
+    if (xmldb_uring(h)){
+        clicon_file_uring_set(0);
+        if (clixon_uring_exit() < 0)
+            goto done;
+    }
     retval = 0;
  done:
     if (keys)
@@ -278,6 +759,49 @@ xmldb_disconnect(clixon_handle h)
     return retval;
 }
 
+/*! Copy journal file of datastore, or remove destination journal if source has none
+ *
+ * @param[in]  h     Clixon handle
+ * @param[in]  from  Source datastore
+ * @param[in]  to    Destination datastore
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+xmldb_journal_copy(clixon_handle h,
+                   const char   *from,
+                   const char   *to)
+{
+    int         retval = -1;
+    char       *fromfile = NULL;
+    char       *tofile = NULL;
+    struct stat st = {0,};
+    db_elmnt   *de1;
+    db_elmnt   *de2;
+
+    if (xmldb_db2journal(h, from, &fromfile) < 0)
+        goto done;
+    if (xmldb_db2journal(h, to, &tofile) < 0)
+        goto done;
+    if (stat(fromfile, &st) == 0){
+        if (clicon_file_copy(fromfile, tofile) < 0)
+            goto done;
+    }
+    else if (xmldb_journal_remove(h, to) < 0)
+        goto done;
+    if ((de2 = clicon_db_elmnt_get(h, to)) != NULL){
+        de1 = clicon_db_elmnt_get(h, from);
+        de2->de_journal = de1 ? de1->de_journal : 0;
+    }
+    retval = 0;
+ done:
+    if (fromfile)
+        free(fromfile);
+    if (tofile)
+        free(tofile);
+    return retval;
+}
+
 /*! Copy datastore from db1 to db2
  *
  * May include copying datastore directory structure
@@ -286,6 +810,8 @@ xmldb_disconnect(clixon_handle h)
  * @param[in]  to    Destination datastore
  * @retval     0     OK
  * @retval    -1     Error
+ * @note If CLICON_XMLDB_COPY_ON_WRITE is set, the in-memory cache is shared and copied on
+ *       first modification, see xmldb_cache_unshare
   */
 int 
 xmldb_copy(clixon_handle h,
@@ -304,8 +830,11 @@ xmldb_copy(clixon_handle h,
     char       *todir = NULL;
     char       *subdir = NULL;
     struct stat st = {0,};
+    int         async;
+    int         memtag;
 
     clixon_debug(CLIXON_DBG_DATASTORE, "%s %s", from, to);
+    memtag = clixon_mem_tag_set(clixon_mem_tag("datastore %s", to));
     /* XXX lock */
     /* Copy in-memory cache */
     /* 1. "to" xml tree in x1 */
@@ -313,13 +842,35 @@ xmldb_copy(clixon_handle h,
         x1 = de1->de_xml;
     if ((de2 = clicon_db_elmnt_get(h, to)) != NULL)
         x2 = de2->de_xml;
+    /* Files are copied below unless written from cache in the background */
+    if ((async = xmldb_flush_async(h)) == 0 || x1 == NULL){
+        if (xmldb_flush_wait(h, from) < 0)
+            goto done;
+        if (xmldb_flush_wait(h, to) < 0)
+            goto done;
+    }
+    /* Lazy nodes refer to sub-files of from, load before copy */
+    if (x1 && x1 != x2 && xml_lazy_load_recurse(x1) < 0)
+        goto done;
     if (x1 == NULL && x2 == NULL){
         /* do nothing */
     }
+    else if (x1 == x2){ /* already shared */
+        /* do nothing */
+    }
     else if (x1 == NULL){  /* free x2 and set to NULL */
-        xml_free(x2);
+        xmldb_cache_free(h, to, de2);
         x2 = NULL;
     }
+    else if (clicon_option_bool(h, "CLICON_XMLDB_COPY_ON_WRITE")){
+        /* Share x1, copied on first modification, see xmldb_cache_unshare */
+        if (x2)
+            xmldb_cache_free(h, to, de2);
+        if (xml_freeze(x1) < 0)
+            goto done;
+        if ((x2 = xml_share(x1)) == NULL)
+            goto done;
+    }
     else  if (x2 == NULL){ /* create x2 and copy from x1 */
         if ((x2 = xml_new(xml_name(x1), NULL, CX_ELMNT)) == NULL)
             goto done;
@@ -328,7 +879,7 @@ xmldb_copy(clixon_handle h,
             goto done;
     }
     else{ /* copy x1 to x2 */
-        xml_free(x2);
+        xmldb_cache_free(h, to, de2);
         if ((x2 = xml_new(xml_name(x1), NULL, CX_ELMNT)) == NULL)
             goto done;
         xml_flag_set(x2, XML_FLAG_TOP);
@@ -341,6 +892,18 @@ xmldb_copy(clixon_handle h,
     if (de2)
         de0 = *de2;
     de0.de_xml = x2; /* The new tree */
+    de0.de_epoch++;
+    /* Track if all differences to running are marked, see xml_diff_flagged */
+    if (strcmp(from, "running") == 0 || strcmp(to, "running") == 0){
+        /* from and to are now equal to running */
+        if (xmldb_edited_clear(x1) < 0)
+            goto done;
+        if (x2 != x1 && xmldb_edited_clear(x2) < 0)
+            goto done;
+        de0.de_edited = 1;
+    }
+    else
+        de0.de_edited = de1 ? de1->de_edited : 0;
     if (clicon_option_bool(h, "CLICON_XMLDB_MULTI")){
         if (xmldb_db2subdir(h, to, &subdir) < 0)
             goto done;
@@ -352,15 +915,30 @@ xmldb_copy(clixon_handle h,
         }
     }
     clicon_db_elmnt_set(h, to, &de0);
+    if (strcmp(to, "running") == 0){
+        if (xmldb_edited_invalidate(h, from) < 0)
+            goto done;
+        if ((de1 = clicon_db_elmnt_get(h, from)) != NULL)
+            de1->de_edited = 1;
+    }
     /* Copy the files themselves (above only in-memory cache)
      * Alt, dump the cache to file
      */
+    if (async && x2 != NULL){
+        if (xmldb_write_cache2file(h, to) < 0)
+            goto done;
+        goto ok;
+    }
     if (xmldb_db2file(h, from, &fromfile) < 0)
         goto done;
     if (xmldb_db2file(h, to, &tofile) < 0)
         goto done;
     if (clicon_file_copy(fromfile, tofile) < 0)
         goto done;
+    if (clicon_option_bool(h, "CLICON_XMLDB_JOURNAL")){
+        if (xmldb_journal_copy(h, from, to) < 0)
+            goto done;
+    }
     if (clicon_option_bool(h, "CLICON_XMLDB_MULTI")) {
         if (xmldb_db2subdir(h, from, &fromdir) < 0)
             goto done;
@@ -369,9 +947,11 @@ xmldb_copy(clixon_handle h,
         if (clicon_dir_copy(fromdir, todir) < 0)
             goto done;
     }
+ ok:
     retval = 0;
  done:
     clixon_debug(CLIXON_DBG_DATASTORE, "retval:%d", retval);
+    clixon_mem_tag_set(memtag);
     if (subdir)
         free(subdir);
     if (fromdir)
@@ -385,6 +965,152 @@ xmldb_copy(clixon_handle h,
     return retval;
 }
 
+/*! Fork a datastore in memory, eg a private candidate from running
+ *
+ * Same as xmldb_copy but only the in-memory cache is copied, with copy-on-write if
+ * CLICON_XMLDB_COPY_ON_WRITE is set, ie in constant time. Files are not copied and
+ * "to" is volatile, ie it is not written to disk on update.
+ * @param[in]  h     Clixon handle
+ * @param[in]  from  Source database
+ * @param[in]  to    Destination database
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see xmldb_copy
+ * @see xmldb_rebase
+ */
+int
+xmldb_fork(clixon_handle h,
+           const char   *from,
+           const char   *to)
+{
+    int       retval = -1;
+    db_elmnt *de1;
+    db_elmnt *de2;
+    db_elmnt  de0 = {0,};
+    cxobj    *x1;
+    cxobj    *x2 = NULL;
+
+    clixon_debug(CLIXON_DBG_DATASTORE, "%s %s", from, to);
+    if ((x1 = xmldb_cache_get(h, from)) == NULL){
+        /* Load cache of from */
+        if (xmldb_get0(h, from, YB_MODULE, NULL, "/", 0, 0, &x2, NULL, NULL) < 0)
+            goto done;
+        if (x2){
+            xml_free(x2);
+            x2 = NULL;
+        }
+        if ((x1 = xmldb_cache_get(h, from)) == NULL){
+            clixon_err(OE_DB, ENOENT, "No cache of datastore %s", from);
+            goto done;
+        }
+    }
+    if ((de2 = clicon_db_elmnt_get(h, to)) != NULL){
+        if (de2->de_xml == x1)
+            goto ok;
+        de0 = *de2;
+        xmldb_cache_free(h, to, &de0);
+    }
+    if (xml_lazy_load_recurse(x1) < 0)
+        goto done;
+    if (clicon_option_bool(h, "CLICON_XMLDB_COPY_ON_WRITE")){
+        if (xml_freeze(x1) < 0)
+            goto done;
+        if ((x2 = xml_share(x1)) == NULL)
+            goto done;
+    }
+    else if ((x2 = xml_dup(x1)) == NULL)
+        goto done;
+    de0.de_xml = x2;
+    de0.de_epoch++;
+    de0.de_volatile = 1;
+    if ((de1 = clicon_db_elmnt_get(h, from)) != NULL)
+        de0.de_edited = de1->de_edited;
+    if (strcmp(from, "running") == 0){
+        if (xmldb_edited_clear(x1) < 0)
+            goto done;
+        if (x2 != x1 && xmldb_edited_clear(x2) < 0)
+            goto done;
+        de0.de_edited = 1;
+    }
+    clicon_db_elmnt_set(h, to, &de0);
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Rebase a datastore forked from a base onto a new version of the base
+ *
+ * A three-way merge of the changes of db relative to base onto onto, eg a private
+ * candidate onto running that has been committed by others since it was forked.
+ * On success, db is onto with the changes of db, and base is a new fork of onto.
+ * If onto has not changed since base was forked (and they share cache), nothing is done.
+ * @param[in]  h         Clixon handle
+ * @param[in]  db        Datastore forked from base, eg private candidate
+ * @param[in]  base      Datastore with the tree db was forked from, see xmldb_fork
+ * @param[in]  onto      Datastore to rebase on, eg running
+ * @param[out] conflict  Path of first conflicting node, if conflict. Free with free()
+ * @retval     1         OK
+ * @retval     0         Conflict, changes of db and onto overlap
+ * @retval    -1         Error
+ * @see xml_rebase
+ */
+int
+xmldb_rebase(clixon_handle h,
+             const char   *db,
+             const char   *base,
+             const char   *onto,
+             char        **conflict)
+{
+    int       retval = -1;
+    cxobj    *xp;
+    cxobj    *xb;
+    cxobj    *xr;
+    cxobj    *xn = NULL;
+    cxobj    *xc = NULL;
+    db_elmnt *de;
+    db_elmnt  de0 = {0,};
+    int       ret;
+
+    clixon_debug(CLIXON_DBG_DATASTORE, "%s %s %s", db, base, onto);
+    if ((xp = xmldb_cache_get(h, db)) == NULL ||
+        (xb = xmldb_cache_get(h, base)) == NULL ||
+        (xr = xmldb_cache_get(h, onto)) == NULL){
+        clixon_err(OE_DB, ENOENT, "No cache of datastore %s, %s or %s", db, base, onto);
+        goto done;
+    }
+    if (xb == xr) /* Unchanged since fork */
+        goto ok;
+    if (xml_lazy_load_recurse(xr) < 0)
+        goto done;
+    if ((ret = xml_rebase(xb, xp, xr, &xn, &xc)) < 0)
+        goto done;
+    if (ret == 0){
+        if (conflict && xml2xpath(xc, NULL, 0, 1, conflict) < 0)
+            goto done;
+        goto fail;
+    }
+    de = clicon_db_elmnt_get(h, db);
+    de0 = *de;
+    xmldb_cache_free(h, db, &de0);
+    de0.de_xml = xn;
+    de0.de_epoch++;
+    de0.de_edited = 0;
+    clicon_db_elmnt_set(h, db, &de0);
+    xn = NULL;
+    if (xmldb_fork(h, onto, base) < 0)
+        goto done;
+ ok:
+    retval = 1;
+ done:
+    if (xn)
+        xml_free(xn);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
 /*! Lock database
  *
  * @param[in]  h    Clixon handle
@@ -554,15 +1280,13 @@ int
 xmldb_clear(clixon_handle h,
             const char   *db)
 {
-    cxobj    *xt = NULL;
     db_elmnt *de = NULL;
 
-    if ((de = clicon_db_elmnt_get(h, db)) != NULL){
-        if ((xt = de->de_xml) != NULL){
-            xml_free(xt);
-            de->de_xml = NULL;
-        }
-    }
+    /* File is read when cache is gone, ensure it is written */
+    if (xmldb_flush_wait(h, db) < 0)
+        return -1;
+    if ((de = clicon_db_elmnt_get(h, db)) != NULL)
+        xmldb_cache_free(h, db, de);
     return 0;
 }
 
@@ -588,10 +1312,15 @@ xmldb_delete(clixon_handle h,
     int            ndp;
     int            i;
     char          *regexp = NULL;
+    db_elmnt      *de;
 
     clixon_debug(CLIXON_DBG_DATASTORE | CLIXON_DBG_DETAIL, "%s", db);
     if (xmldb_clear(h, db) < 0)
         goto done;
+    if (xmldb_journal_remove(h, db) < 0)
+        goto done;
+    if ((de = clicon_db_elmnt_get(h, db)) != NULL)
+        de->de_journal = 0;
     if (xmldb_db2file(h, db, &filename) < 0)
         goto done;
     if (lstat(filename, &st) == 0)
@@ -654,17 +1383,18 @@ xmldb_create(clixon_handle h,
     char       *filename = NULL;
     int         fd = -1;
     db_elmnt   *de = NULL;
-    cxobj      *xt = NULL;
     char       *subdir = NULL;
     struct stat st = {0,};
 
     clixon_debug(CLIXON_DBG_DATASTORE | CLIXON_DBG_DETAIL, "%s", db);
+    if (xmldb_flush_wait(h, db) < 0)
+        goto done;
     if ((de = clicon_db_elmnt_get(h, db)) != NULL){
-        if ((xt = de->de_xml) != NULL){
-            xml_free(xt);
-            de->de_xml = NULL;
-        }
+        xmldb_cache_free(h, db, de);
+        de->de_journal = 0;
     }
+    if (xmldb_journal_remove(h, db) < 0)
+        goto done;
     if (clicon_option_bool(h, "CLICON_XMLDB_MULTI")){
         if (xmldb_db2subdir(h, db, &subdir) < 0)
             goto done;
@@ -731,6 +1461,47 @@ xmldb_cache_get(clixon_handle h,
     return de->de_xml;
 }
 
+/*! Get statistics of datastore XML cache
+ *
+ * The stats are computed with xml_stats() once per change of the cache and then kept
+ * until the cache changes (ie de_epoch is incremented or the cache is reloaded), so that
+ * repeated polling of an unchanged datastore does not traverse the tree.
+ * @param[in]  h    Clixon handle
+ * @param[in]  db   Database name
+ * @param[out] nrp  Number of XML nodes
+ * @param[out] szp  Size of XML cache in bytes
+ * @retval     1    OK
+ * @retval     0    No cache
+ * @retval    -1    Error
+ * @see xml_stats
+ */
+int
+xmldb_cache_stats(clixon_handle h,
+                  const char   *db,
+                  uint64_t     *nrp,
+                  size_t       *szp)
+{
+    db_elmnt *de;
+    uint64_t  nr = 0;
+    size_t    sz = 0;
+
+    if ((de = clicon_db_elmnt_get(h, db)) == NULL || de->de_xml == NULL)
+        return 0;
+    if (!de->de_stats_valid || de->de_stats_epoch != de->de_epoch){
+        if (xml_stats(de->de_xml, &nr, &sz) < 0)
+            return -1;
+        de->de_stats_nr = nr;
+        de->de_stats_size = sz;
+        de->de_stats_epoch = de->de_epoch;
+        de->de_stats_valid = 1;
+    }
+    if (nrp)
+        *nrp = de->de_stats_nr;
+    if (szp)
+        *szp = de->de_stats_size;
+    return 1;
+}
+
 /*! Get modified flag from datastore
  *
  * @param[in]  h     Clixon handle
@@ -868,6 +1639,64 @@ xmldb_volatile_set(clixon_handle h,
     return 0;
 }
 
+/*! Get edited flag of datastore cache
+ *
+ * If set, all differences between the datastore cache and running are marked with
+ * XML_FLAG_EDITED, which means that a commit diff may skip unmarked subtrees.
+ * @param[in]  h     Clixon handle
+ * @param[in]  db    Database name
+ * @retval     1     All differences to running are marked
+ * @retval     0     Not known, full diff is necessary
+ * @retval    -1     Error (datastore does not exist)
+ * @see xml_diff_flagged
+ * @see CLICON_XMLDB_DIFF_INCREMENTAL
+ */
+int
+xmldb_edited_get(clixon_handle h,
+                 const char   *db)
+{
+    db_elmnt *de;
+
+    if ((de = clicon_db_elmnt_get(h, db)) == NULL){
+        clixon_err(OE_CFG, EFAULT, "datastore %s does not exist", db);
+        return -1;
+    }
+    return de->de_edited;
+}
+
+/*! Reset edited flag of all datastores except one, eg when running is modified
+ *
+ * @param[in]  h     Clixon handle
+ * @param[in]  db    Database name not to reset
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see xmldb_edited_get
+ */
+int
+xmldb_edited_invalidate(clixon_handle h,
+                        const char   *db)
+{
+    int       retval = -1;
+    char    **keys = NULL;
+    size_t    klen;
+    int       i;
+    db_elmnt *de;
+
+    if (clicon_hash_keys(clicon_db_elmnt(h), &keys, &klen) < 0)
+        goto done;
+    for (i = 0; i < klen; i++){
+        if (strcmp(keys[i], db) == 0)
+            continue;
+        if ((de = clicon_hash_value(clicon_db_elmnt(h), keys[i], NULL)) != NULL)
+            de->de_edited = 0;
+    }
+    retval = 0;
+ done:
+    if (keys)
+        free(keys);
+    return retval;
+}
+
 /* Print the datastore meta-info to file
  */
 int
@@ -915,15 +1744,26 @@ xmldb_rename(clixon_handle h,
              const char    *newdb,
              const char    *suffix)
 {
-    int    retval = -1;
-    char  *old;
-    char  *fname = NULL;
-    cbuf  *cb = NULL;
+    int       retval = -1;
+    char     *old;
+    char     *fname = NULL;
+    cbuf     *cb = NULL;
+    db_elmnt *de;
 
     if ((xmldb_db2file(h, db, &old)) < 0)
         goto done;
     if (newdb == NULL && suffix == NULL)        // no-op
         goto done;
+    if (xmldb_flush_wait(h, db) < 0)
+        goto done;
+    /* Fold journal into snapshot so that the renamed file is complete */
+    if ((de = clicon_db_elmnt_get(h, db)) != NULL &&
+        de->de_journal && de->de_xml && !de->de_volatile){
+        if (xmldb_write_cache2file(h, db) < 0)
+            goto done;
+    }
+    if (xmldb_journal_remove(h, db) < 0)
+        goto done;
     if ((cb = cbuf_new()) == NULL){
         clixon_err(OE_XML, errno, "cbuf_new");
         goto done;
@@ -962,6 +1802,8 @@ xmldb_populate(clixon_handle h,
     yang_stmt *yspec;
     int        ret;
 
+    if (xmldb_cache_unshare(h, db) < 0)
+        goto done;
     if ((x = xmldb_cache_get(h, db)) == NULL){
         clixon_err(OE_XML, 0, "XML cache not found");
         goto done;
@@ -42,6 +42,7 @@
 #include <unistd.h>
 #include <errno.h>
 #include <string.h>
+#include <ctype.h>
 #include <limits.h>
 #include <stdint.h>
 #include <sys/types.h>
@@ -66,23 +67,31 @@
 #include "clixon_debug.h"
 #include "clixon_file.h"
 #include "clixon_xml_sort.h"
+#include "clixon_xml_vec.h"
 #include "clixon_xml_bind.h"
 #include "clixon_options.h"
 #include "clixon_data.h"
 #include "clixon_xpath_ctx.h"
 #include "clixon_xpath.h"
+#include "clixon_xpath_yang.h"
 #include "clixon_json.h"
+#include "clixon_digest.h"
 #include "clixon_nacm.h"
 #include "clixon_path.h"
 #include "clixon_netconf_lib.h"
+#include "clixon_xml_binary.h"
 #include "clixon_yang_module.h"
 #include "clixon_yang_parse_lib.h"
 #include "clixon_xml_map.h"
 #include "clixon_xml_default.h"
 #include "clixon_xml_io.h"
 #include "clixon_xml_nsctx.h"
+#include "clixon_validate.h"
 #include "clixon_datastore.h"
 #include "clixon_datastore_read.h"
+#include "clixon_datastore_write.h"
+#include "clixon_memstats.h"
+#include "clixon_compress.h"
 
 #define handle(xh) (assert(text_handle_check(xh)==0),(struct text_handle *)(xh))
 
@@ -91,10 +100,13 @@
  * @see xmldb_multi_write_arg
  */
 struct xmldb_multi_read_arg {
+    clixon_handle    mr_h;
     char            *mr_subdir;
     yang_stmt       *mr_yspec;
     enum format_enum mr_format;
     cxobj          **mr_xerr;
+    int              mr_lazy;   /* Do not parse sub-files, mark split nodes as lazy */
+    int              mr_loaded; /* Number of lazy nodes loaded eagerly */
 };
 
 /*! Ensure that xt only has a single sub-element and that is "config" 
@@ -228,15 +240,158 @@ xml_copy_bottom_recurse(cxobj  *x0t,
     return retval;
 }
 
+/*! Copy xml tree x0 to x1 except nodes not reported for a with-defaults mode
+ *
+ * Default leaves and empty non-presence containers (and values equal to the default if trim)
+ * are not copied, instead of copying and removing them afterwards.
+ * The top node x0 itself is always copied.
+ * @param[in]  x0    Old xml tree
+ * @param[in]  x1    New xml tree, must exist
+ * @param[in]  wdef  With-defaults parameter, WITHDEFAULTS_REPORT_ALL is same as xml_copy
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see xml2output_wdef
+ */
+static int
+xml_copy_wdef(cxobj            *x0,
+              cxobj            *x1,
+              withdefaults_type wdef)
+{
+    int    retval = -1;
+    cxobj *x;
+    cxobj *xcopy;
+    int    ret;
+
+    if (wdef == WITHDEFAULTS_REPORT_ALL || wdef == WITHDEFAULTS_REPORT_ALL_TAGGED)
+        return xml_copy(x0, x1);
+    if (xml_copy_one(x0, x1) <0)
+        goto done;
+    x = NULL;
+    while ((x = xml_child_each(x0, x, -1)) != NULL) {
+        if (xml_type(x) == CX_ELMNT){
+            if ((ret = xml2output_wdef(x, wdef, NULL)) < 0)
+                goto done;
+            if (ret == 0)
+                continue;
+        }
+        if ((xcopy = xml_new(xml_name(x), x1, xml_type(x))) == NULL)
+            goto done;
+        if (xml_copy_wdef(x, xcopy, wdef) < 0) /* recursion */
+            goto done;
+    }
+    if (xml_type(x0) == CX_ELMNT && xml_spec(x1) == xml_spec(x0))
+        xml_union_type_set(x1, xml_union_type(x0));
+    retval = 0;
+  done:
+    return retval;
+}
+
+/*! Copy marked nodes as xml_copy_marked, without defaults of copied subtrees
+ *
+ * @param[in]   x0
+ * @param[in]   x1
+ * @param[in]   wdef    With-defaults parameter, see xml_copy_wdef
+ * @retval      0       OK
+ * @retval     -1       Error
+ * @see xml_copy_marked
+ */
+static int
+xml_copy_marked_wdef(cxobj            *x0,
+                     cxobj            *x1,
+                     withdefaults_type wdef)
+{
+    int        retval = -1;
+    int        mark;
+    cxobj     *x;
+    cxobj     *xcopy;
+    int        iskey;
+    yang_stmt *yt;
+    char      *name;
+    char      *prefix;
+
+    if (x0 == NULL || x1 == NULL){
+        clixon_err(OE_UNIX, EINVAL, "x0 or x1 is NULL");
+        goto done;
+    }
+    yt = xml_spec(x0); /* can be null */
+    xml_spec_set(x1, yt);
+   /* Copy prefix*/
+    if ((prefix = xml_prefix(x0)) != NULL)
+        if (xml_prefix_set(x1, prefix) < 0)
+            goto done;
+    /* Copy all attributes */
+    x = NULL;
+    while ((x = xml_child_each_attr(x0, x)) != NULL) {
+        name = xml_name(x);
+        if ((xcopy = xml_new(name, x1, CX_ATTR)) == NULL)
+            goto done;
+        if (xml_copy(x, xcopy) < 0)
+            goto done;
+    }
+
+    /* Go through children to detect any marked nodes:
+     * (3) Special case: key nodes in lists are copied if any 
+     * node in list is marked
+     */
+    mark = 0;
+    x = NULL;
+    while ((x = xml_child_each(x0, x, CX_ELMNT)) != NULL) {
+        if (xml_flag(x, XML_FLAG_MARK|XML_FLAG_CHANGE)){
+            mark++;
+            break;
+        }
+    }
+    x = NULL;
+    while ((x = xml_child_each(x0, x, CX_ELMNT)) != NULL) {
+        name = xml_name(x);
+        if (xml_flag(x, XML_FLAG_MARK)){
+            /* (2) the complete subtree of that node is copied. */
+            if ((xcopy = xml_new(name, x1, CX_ELMNT)) == NULL)
+                goto done;
+            if (xml_copy_wdef(x, xcopy, wdef) < 0)
+                goto done;
+            continue;
+        }
+        if (xml_flag(x, XML_FLAG_CHANGE)){
+            /*  Copy individual nodes marked with XML_FLAG_CHANGE */
+            if ((xcopy = xml_new(name, x1, CX_ELMNT)) == NULL)
+                goto done;
+            if (xml_copy_marked_wdef(x, xcopy, wdef) < 0)
+                goto done;
+        }
+        /* (3) Special case: key nodes in lists are copied if any 
+         * node in list is marked */
+        if (mark && yt && yang_keyword_get(yt) == Y_LIST){
+            /* XXX: I think yang_key_match is suboptimal here */
+            if ((iskey = yang_key_match(yt, name, NULL)) < 0)
+                goto done;
+            if (iskey){
+                if ((xcopy = xml_new(name, x1, CX_ELMNT)) == NULL)
+                    goto done;
+                if (xml_copy(x, xcopy) < 0)
+                    goto done;
+            }
+        }
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Copy an XML tree bottom-up
  *
+ * @param[in]  x0t   Top of tree
+ * @param[in]  x0    Node to copy with its subtree, and its ancestors up to x0t
+ * @param[in]  x1t   Top of new tree
+ * @param[in]  wdef  With-defaults parameter, subtree defaults are not copied, see xml_copy_wdef
  * @retval     0    OK
  * @retval    -1    OK
  */
 static int
-xml_copy_from_bottom(cxobj  *x0t,
-                     cxobj  *x0,
-                     cxobj  *x1t)
+xml_copy_from_bottom(cxobj            *x0t,
+                     cxobj            *x0,
+                     cxobj            *x1t,
+                     withdefaults_type wdef)
 {
     int        retval = -1;
     cxobj     *x1p    = NULL;
@@ -257,7 +412,7 @@ xml_copy_from_bottom(cxobj  *x0t,
     if (x1 == NULL){ /* If not, create it and copy complete tree */
         if ((x1 = xml_new(xml_name(x0), x1p, CX_ELMNT)) == NULL)
             goto done;
-        if (xml_copy(x0, x1) < 0)
+        if (xml_copy_wdef(x0, x1, wdef) < 0)
             goto done;
     }
  ok:
@@ -495,12 +650,19 @@ xmldb_multi_read_applyfn(cxobj *x,
         xml_purge(xa);
         if ((xa = xml_find_type(x, "xmlns", CLIXON_LIB_PREFIX, CX_ATTR)) != NULL)
             xml_purge(xa);
+        if (mr->mr_lazy){
+            /* Loaded on demand, see xmldb_lazy_load1 */
+            xml_flag_set(x, XML_FLAG_LAZY);
+            goto ok;
+        }
         dbfile = cbuf_get(cb);
         clixon_debug(CLIXON_DBG_DATASTORE, "Parsing: %s", dbfile);
         if ((fp = fopen(dbfile, "r")) == NULL){
             clixon_err(OE_CFG, errno, "fopen(%s)", dbfile);
             goto done;
         }
+        if (clixon_decompress_file(&fp) < 0)
+            goto done;
         switch (mr->mr_format){
         case FORMAT_JSON:
             if (clixon_json_parse_file(fp, 1, YB_NONE, mr->mr_yspec, &x, mr->mr_xerr) < 0)
@@ -516,6 +678,7 @@ xmldb_multi_read_applyfn(cxobj *x,
             break;
         }
     }
+ ok:
     retval = 0;
  done:
     if (cb)
@@ -525,6 +688,166 @@ xmldb_multi_read_applyfn(cxobj *x,
     return retval;
 }
 
+/*! Load children of lazy xmldb-multi split node from its sub-file
+ *
+ * The sub-file name is derived from the path of the node as when written.
+ * Element children added while not loaded, ie defaults, are replaced.
+ * @param[in]  h       Clixon handle
+ * @param[in]  x       XML split node with XML_FLAG_LAZY set, bound to yang
+ * @param[in]  subdir  Sub-file directory of datastore
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @see CLICON_XMLDB_MULTI_LAZY
+ */
+int
+xmldb_lazy_load1(clixon_handle h,
+                 cxobj        *x,
+                 const char   *subdir)
+{
+    int              retval = -1;
+    char            *xpath = NULL;
+    char            *hexstr = NULL;
+    cbuf            *cb = NULL;
+    FILE            *fp = NULL;
+    cxobj           *xc;
+    cxobj           *xerr = NULL;
+    char            *formatstr;
+    enum format_enum format = FORMAT_XML;
+    int              ret;
+
+    xml_flag_reset(x, XML_FLAG_LAZY);
+    while ((xc = xml_child_i_type(x, 0, CX_ELMNT)) != NULL)
+        if (xml_purge(xc) < 0)
+            goto done;
+    if (xml2xpath(x, NULL, 1, 0, &xpath) < 0)
+        goto done;
+    if (clixon_digest_hex(xpath, &hexstr) < 0)
+        goto done;
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cb, "%s/%s.xml", subdir, hexstr);
+    clixon_debug(CLIXON_DBG_DATASTORE, "Lazy load: %s", cbuf_get(cb));
+    if ((formatstr = clicon_option_str(h, "CLICON_XMLDB_FORMAT")) != NULL &&
+        (format = format_str2int(formatstr)) < 0){
+        clixon_err(OE_XML, 0, "format not found %s", formatstr);
+        goto done;
+    }
+    if ((fp = fopen(cbuf_get(cb), "r")) == NULL){
+        clixon_err(OE_CFG, errno, "fopen(%s)", cbuf_get(cb));
+        goto done;
+    }
+    if (clixon_decompress_file(&fp) < 0)
+        goto done;
+    switch (format){
+    case FORMAT_JSON:
+        if (clixon_json_parse_file(fp, 1, YB_NONE, NULL, &x, &xerr) < 0)
+            goto done;
+        break;
+    case FORMAT_XML:
+        if (clixon_xml_parse_file(fp, YB_NONE, NULL, &x, &xerr) < 0)
+            goto done;
+        break;
+    default:
+        clixon_err(OE_DB, 0, "Format not supported");
+        goto done;
+        break;
+    }
+    if ((ret = xml_bind_yang(h, x, YB_PARENT, NULL, &xerr)) < 0)
+        goto done;
+    if (ret == 0){
+        clixon_err(OE_DB, 0, "YANG binding of %s failed", cbuf_get(cb));
+        goto done;
+    }
+    if (xml_sort_recurse(x) < 0)
+        goto done;
+    if (xml_default_recurse(x, 0, 0) < 0)
+        goto done;
+    xml_flag_set(x, XML_FLAG_LAZY_LOADED|XML_FLAG_LAZY_REF);
+    retval = 0;
+ done:
+    if (fp)
+        fclose(fp);
+    if (xerr)
+        xml_free(xerr);
+    if (cb)
+        cbuf_free(cb);
+    if (hexstr)
+        free(hexstr);
+    if (xpath)
+        free(xpath);
+    return retval;
+}
+
+/*! Callback function to load lazy split nodes that are not containers
+ *
+ * Only containers can be loaded on demand since keys of list entries are in the sub-file
+ * @param[in]  x    XML node
+ * @param[in]  arg  Multi read argument
+ * @retval     0    OK, continue
+ * @retval    -1    Error
+ */
+static int
+xmldb_lazy_eager_applyfn(cxobj *x,
+                         void  *arg)
+{
+    struct xmldb_multi_read_arg *mr = (struct xmldb_multi_read_arg *) arg;
+    yang_stmt                   *y;
+
+    if (xml_flag(x, XML_FLAG_LAZY) &&
+        ((y = xml_spec(x)) == NULL || yang_keyword_get(y) != Y_CONTAINER)){
+        if (xmldb_lazy_load1(mr->mr_h, x, mr->mr_subdir) < 0)
+            return -1;
+        mr->mr_loaded++;
+    }
+    return 0;
+}
+
+/*! Callback function for xmldb-multi read prefetch
+ *
+ * Look for link attribute in XML, and if found advise the kernel to read the linked file.
+ * The kernel then reads all sub-files in parallel while they are parsed one by one.
+ * @param[in]  x    XML node
+ * @param[in]  arg  Multi read argument
+ * @retval     0    OK, continue
+ * @retval    -1    Error
+ * @see xmldb_multi_read_applyfn
+ */
+static int
+xmldb_multi_prefetch_applyfn(cxobj *x,
+                             void  *arg)
+{
+    struct xmldb_multi_read_arg *mr = (struct xmldb_multi_read_arg *) arg;
+    int                     retval = -1;
+    cxobj                  *xa;
+    char                   *filename;
+    cbuf                   *cb = NULL;
+    int                     fd = -1;
+
+    if ((xa = xml_find_type(x, CLIXON_LIB_PREFIX, "link", CX_ATTR)) != NULL &&
+        (filename = xml_value(xa)) != NULL){
+        if ((cb = cbuf_new()) == NULL){
+            clixon_err(OE_XML, errno, "cbuf_new");
+            goto done;
+        }
+        cprintf(cb, "%s/%s", mr->mr_subdir, filename);
+        /* Errors are reported when the file is parsed */
+        if ((fd = open(cbuf_get(cb), O_RDONLY)) >= 0){
+#ifdef POSIX_FADV_WILLNEED
+            (void)posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+#endif
+        }
+    }
+    retval = 0;
+ done:
+    if (fd != -1)
+        close(fd);
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
 /*! Common read function that reads an XML tree from file
  *
  * @param[in]  th     Datastore text handle
@@ -539,6 +862,7 @@ xmldb_multi_read_applyfn(cxobj *x,
  * @retval     0      Parse OK but yang assigment not made (or only partial) and xerr set
  * @retval    -1      Error
  * @note Use of 1 for OK
+ * @note If CLICON_XMLDB_JOURNAL is set, journal entries are replayed which binds yang also if yb is YB_NONE
  * @note retval 0 is NYI because calling functions cannot handle it yet
  * XXX if this code pass tests this code can be rewritten, esp the modstate stuff
  */
@@ -570,6 +894,7 @@ xmldb_readfile(clixon_handle    h,
     cxobj           *x;
     yang_stmt       *yspec1 = NULL;
     struct xmldb_multi_read_arg mr = {0, };
+    int              bound = 0;
 
     if (yb != YB_MODULE && yb != YB_NONE){
         clixon_err(OE_XML, EINVAL, "yb is %d but should be module or none", yb);
@@ -595,6 +920,8 @@ xmldb_readfile(clixon_handle    h,
         clixon_err(OE_UNIX, errno, "open(%s)", dbfile);
         goto done;
     }
+    if (clixon_decompress_file(&fp) < 0)
+        goto done;
     /* Read whole datastore file on the form:
      * <config>
      *   modstate*  # this is analyzed, stripped and returned as msdiff in text_read_modstate
@@ -610,6 +937,11 @@ xmldb_readfile(clixon_handle    h,
         if (clixon_xml_parse_file(fp, YB_NONE, yspec, &x0, xerr) < 0)
             goto done;
         break;
+    case FORMAT_BINARY:
+        /* Bound and sorted on load if yang is unchanged since written */
+        if (clixon_binary_parse_file(fp, yb, yspec, &x0, &bound) < 0)
+            goto done;
+        break;
     default:
         clixon_err(OE_DB, 0, "Format %s not supported", formatstr);
         goto done;
@@ -618,9 +950,15 @@ xmldb_readfile(clixon_handle    h,
     if (clicon_option_bool(h, "CLICON_XMLDB_MULTI")){
         if (xmldb_db2subdir(h, db, &mr.mr_subdir) < 0)
             goto done;
+        mr.mr_h = h;
         mr.mr_format = format;
         mr.mr_yspec = yspec;
         mr.mr_xerr = xerr;
+        /* Lazy needs yang binding to find out which nodes can be loaded later */
+        mr.mr_lazy = clicon_option_bool(h, "CLICON_XMLDB_MULTI_LAZY") && yb == YB_MODULE;
+        if (clicon_option_int(h, "CLICON_XMLDB_MULTI_WORKERS") > 1 &&
+            xml_apply(x0, CX_ELMNT, (xml_applyfn_t*)xmldb_multi_prefetch_applyfn, &mr) < 0)
+            goto done;
         if (xml_apply(x0, CX_ELMNT, (xml_applyfn_t*)xmldb_multi_read_applyfn, &mr) < 0)
             goto done;
     }
@@ -727,11 +1065,28 @@ xmldb_readfile(clixon_handle    h,
         } /* if msdiff */
         /* xml looks like: <top><config><x>... actually YB_MODULE_NEXT 
          */
-        if ((ret = xml_bind_yang(h, x0, YB_MODULE, yspec1?yspec1:yspec, xerr)) < 0)
-            goto done;
-        if (ret == 0)
-            goto fail;
-        if (xml_sort_recurse(x0) < 0)
+        if (bound && yspec1 == NULL)
+            ; /* Binary snapshot already bound and sorted */
+        else {
+            if ((ret = xml_bind_yang(h, x0, YB_MODULE, yspec1?yspec1:yspec, xerr)) < 0)
+                goto done;
+            if (ret == 0)
+                goto fail;
+            if (xml_sort_recurse(x0) < 0)
+                goto done;
+        }
+        if (mr.mr_lazy){
+            if (xml_apply(x0, CX_ELMNT, xmldb_lazy_eager_applyfn, &mr) < 0)
+                goto done;
+            /* List keys are now loaded */
+            if (mr.mr_loaded && xml_sort_recurse(x0) < 0)
+                goto done;
+        }
+    }
+    /* Apply edits appended since snapshot was written */
+    if (clicon_option_bool(h, "CLICON_XMLDB_JOURNAL") &&
+        !clicon_option_bool(h, "CLICON_XMLDB_MULTI")){
+        if (xmldb_journal_replay(h, db, yb, yspec1?yspec1:yspec, x0, de, xerr) < 0)
             goto done;
     }
     if (xp){
@@ -765,84 +1120,36 @@ xmldb_readfile(clixon_handle    h,
     goto done;
 }
 
-/*! Get content of database using xpath. return a set of matching sub-trees
+/*! Copy the sub-trees of a datastore tree matching xpath to a new minimal tree
  *
- * The function returns a minimal tree that includes all sub-trees that match
- * xpath.
- * This is a clixon datastore plugin of the the xmldb api
  * @param[in]  h      Clixon handle
- * @param[in]  db     Name of database to search in (filename including dir path
- * @param[in]  yb     How to bind yang to XML top-level when parsing
+ * @param[in]  x0t    Top of datastore tree, eg cache or snapshot, bound to yang
  * @param[in]  nsc    External XML namespace context, or NULL
  * @param[in]  xpath  String with XPath syntax. or NULL for all
- * @param[in]  wdef   With-defaults parameter, see RFC 6243
+ * @param[in]  wdef   With-defaults parameter: defaults not reported in this mode are not
+ *                    copied in matching sub-trees, ancestors are always copied
  * @param[out] xret   Single return XML tree. Free with xml_free()
- * @param[out] msdiff If set, return modules-state differences
- * @param[out] xerr   XML error if retval is 0
- * @retval     1      OK
- * @retval     0      Parse OK but yang assigment not made (or only partial) and xerr set
+ * @retval     0      OK
  * @retval    -1      Error
+ * @see xmldb_get0
  */
-static int
-xmldb_get_cache(clixon_handle     h,
-                const char       *db,
-                yang_bind         yb,
-                cvec             *nsc,
-                const char       *xpath,
-                withdefaults_type wdef,
-                cxobj           **xret,
-                modstate_diff_t  *msdiff,
-                cxobj           **xerr)
+int
+xmldb_get_copy(clixon_handle     h,
+               cxobj            *x0t,
+               cvec             *nsc,
+               const char       *xpath,
+               withdefaults_type wdef,
+               cxobj           **xret)
 {
     int        retval = -1;
     yang_stmt *yspec;
-    cxobj     *x0t = NULL; /* (cached) top of tree */
     cxobj     *x0;
     cxobj    **xvec = NULL;
     size_t     xlen;
     int        i;
-    db_elmnt  *de = NULL;
     cxobj     *x1t = NULL;
-    db_elmnt   de0 = {0,};
-    int        ret;
 
-    clixon_debug(CLIXON_DBG_DATASTORE, "db %s", db);
-    if (xret == NULL){
-        clixon_err(OE_DB, EINVAL, "xret is NULL");
-        return -1;
-    }
-    if ((yspec = clicon_dbspec_yang(h)) == NULL){
-        clixon_err(OE_YANG, ENOENT, "No yang spec");
-        goto done;
-    }
-    de = clicon_db_elmnt_get(h, db);
-    if (de == NULL || de->de_xml == NULL){ /* Cache miss, read XML from file */
-        /* If there is no xml x0 tree (in cache), then read it from file */
-        /* xml looks like: <top><config><x>... where "x" is a top-level symbol in a module */
-        if ((ret = xmldb_readfile(h, db, yb, yspec, &x0t, &de0, msdiff, xerr)) < 0)
-            goto done;
-        if (ret == 0)
-            goto fail;
-        /* Should we validate file if read from disk?
-         * No, argument against: we may want to have a semantically wrong file and wish to edit?
-         */
-        de0.de_xml = x0t;
-        if (de)
-            de0.de_id = de->de_id;
-        clicon_db_elmnt_set(h, db, &de0); /* Content is copied */
-        /* Add default global values (to make xpath below include defaults) */
-        // Alt:  xmldb_populate(h, db)
-        if (yb != YB_NONE) {
-            if (xml_global_defaults(h, x0t, nsc, xpath, yspec, 0) < 0)
-                goto done;
-            /* Add default recursive values */
-            if (xml_default_recurse(x0t, 0, 0) < 0)
-                goto done;
-        }
-    } /* x0t == NULL */
-    else
-        x0t = de->de_xml;
-    /* Here x0t looks like: <config>...</config> */
+    yspec = clicon_dbspec_yang(h);
     /* Given the xpath, return a vector of matches in xvec 
      * Can we do everything in one go?
      * 0) Make a new tree
@@ -853,6 +1160,10 @@ xmldb_get_cache(clixon_handle     h,
      */
     if (xpath_vec(x0t, nsc, "%s", &xvec, &xlen, xpath?xpath:"/") < 0)
         goto done;
+    /* Matching subtrees are copied or returned, ensure they are loaded */
+    for (i=0; i<xlen; i++)
+        if (xml_lazy_load_recurse(xvec[i]) < 0)
+            goto done;
     // XXX: Remove copying and return x0 eventually
     /* Make new tree by copying top-of-tree from x0t to x1t */
     if ((x1t = xml_new(xml_name(x0t), NULL, CX_ELMNT)) == NULL)
@@ -866,7 +1177,7 @@ xmldb_get_cache(clixon_handle     h,
          */
         for (i=0; i<xlen; i++){
             x0 = xvec[i];
-            if (xml_copy_from_bottom(x0t, x0, x1t) < 0) /* config */
+            if (xml_copy_from_bottom(x0t, x0, x1t, wdef) < 0) /* config */
                 goto done;
         }
     }
@@ -880,7 +1191,7 @@ xmldb_get_cache(clixon_handle     h,
             xml_flag_set(x0, XML_FLAG_MARK);
             xml_apply_ancestor(x0, (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_CHANGE);
         }
-        if (xml_copy_marked(x0t, x1t) < 0) /* config */
+        if (xml_copy_marked_wdef(x0t, x1t, wdef) < 0) /* config */
             goto done;
         if (xml_apply(x0t, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset, (void*)(XML_FLAG_MARK|XML_FLAG_CHANGE)) < 0)
             goto done;
@@ -893,13 +1204,150 @@ xmldb_get_cache(clixon_handle     h,
         if (disable_nacm_on_empty(x1t, yspec) < 0)
             goto done;
     }
+    *xret = x1t;
+    x1t = NULL;
+    retval = 0;
+ done:
+    if (x1t)
+        xml_free(x1t);
+    if (xvec)
+        free(xvec);
+    return retval;
+}
+
+/*! Get datastore cache, read it from file if not present
+ *
+ * @param[in]  h      Clixon handle
+ * @param[in]  db     Name of database to search in (filename including dir path
+ * @param[in]  yb     How to bind yang to XML top-level when parsing
+ * @param[in]  nsc    External XML namespace context, or NULL
+ * @param[in]  xpath  String with XPath syntax. or NULL for all
+ * @param[out] x0tp   Top of cached tree, eg <config>...</config>
+ * @param[out] msdiff If set, return modules-state differences
+ * @param[out] xerr   XML error if retval is 0
+ * @retval     1      OK
+ * @retval     0      Parse OK but yang assigment not made (or only partial) and xerr set
+ * @retval    -1      Error
+ */
+static int
+xmldb_cache_load(clixon_handle     h,
+                 const char       *db,
+                 yang_bind         yb,
+                 cvec             *nsc,
+                 const char       *xpath,
+                 cxobj           **x0tp,
+                 modstate_diff_t  *msdiff,
+                 cxobj           **xerr)
+{
+    int        retval = -1;
+    yang_stmt *yspec;
+    cxobj     *x0t = NULL; /* (cached) top of tree */
+    db_elmnt  *de = NULL;
+    db_elmnt   de0 = {0,};
+    int        ret;
+
+    if ((yspec = clicon_dbspec_yang(h)) == NULL){
+        clixon_err(OE_YANG, ENOENT, "No yang spec");
+        goto done;
+    }
+    de = clicon_db_elmnt_get(h, db);
+    if (de == NULL || de->de_xml == NULL){ /* Cache miss, read XML from file */
+        /* If there is no xml x0 tree (in cache), then read it from file */
+        /* xml looks like: <top><config><x>... where "x" is a top-level symbol in a module */
+        if ((ret = xmldb_readfile(h, db, yb, yspec, &x0t, &de0, msdiff, xerr)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+        /* Should we validate file if read from disk?
+         * No, argument against: we may want to have a semantically wrong file and wish to edit?
+         */
+        de0.de_xml = x0t;
+        if (de){
+            de0.de_id = de->de_id;
+            /* Keep epoch increasing over reloads, a reset epoch may be taken as unchanged */
+            de0.de_epoch = de->de_epoch + 1;
+        }
+        clicon_db_elmnt_set(h, db, &de0); /* Content is copied */
+        /* Add default global values (to make xpath below include defaults) */
+        // Alt:  xmldb_populate(h, db)
+        if (yb != YB_NONE) {
+            if (xml_global_defaults(h, x0t, nsc, xpath, yspec, 0) < 0)
+                goto done;
+            /* Add default recursive values */
+            if (xml_default_recurse(x0t, 0, 0) < 0)
+                goto done;
+        }
+    } /* x0t == NULL */
+    else
+        x0t = de->de_xml;
+    /* Keep leafref indexes until the cache is modified, see xmldb_cache_unshare */
+    if (clicon_option_bool(h, "CLICON_XMLDB_LEAFREF_INDEX") &&
+        xml_leafref_index_keep(x0t) < 0)
+        goto done;
+    *x0tp = x0t;
+    retval = 1;
+ done:
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Get content of database using xpath. return a set of matching sub-trees
+ *
+ * The function returns a minimal tree that includes all sub-trees that match
+ * xpath.
+ * This is a clixon datastore plugin of the the xmldb api
+ * @param[in]  h      Clixon handle
+ * @param[in]  db     Name of database to search in (filename including dir path
+ * @param[in]  yb     How to bind yang to XML top-level when parsing
+ * @param[in]  nsc    External XML namespace context, or NULL
+ * @param[in]  xpath  String with XPath syntax. or NULL for all
+ * @param[in]  wdef   With-defaults parameter, see RFC 6243
+ * @param[out] xret   Single return XML tree. Free with xml_free()
+ * @param[out] msdiff If set, return modules-state differences
+ * @param[out] xerr   XML error if retval is 0
+ * @retval     1      OK
+ * @retval     0      Parse OK but yang assigment not made (or only partial) and xerr set
+ * @retval    -1      Error
+ */
+static int
+xmldb_get_cache(clixon_handle     h,
+                const char       *db,
+                yang_bind         yb,
+                cvec             *nsc,
+                const char       *xpath,
+                withdefaults_type wdef,
+                cxobj           **xret,
+                modstate_diff_t  *msdiff,
+                cxobj           **xerr)
+{
+    int        retval = -1;
+    cxobj     *x0t = NULL; /* (cached) top of tree */
+    cxobj     *x1t = NULL;
+    int        ret;
+    int        memtag;
+
+    clixon_debug(CLIXON_DBG_DATASTORE, "db %s", db);
+    if (xret == NULL){
+        clixon_err(OE_DB, EINVAL, "xret is NULL");
+        return -1;
+    }
+    memtag = clixon_mem_tag_set(clixon_mem_tag("datastore %s", db));
+    ret = xmldb_cache_load(h, db, yb, nsc, xpath, &x0t, msdiff, xerr);
+    clixon_mem_tag_set(memtag);
+    if (ret < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
+    /* Here x0t looks like: <config>...</config> */
+    if (xmldb_get_copy(h, x0t, nsc, xpath, wdef, &x1t) < 0)
+        goto done;
     clixon_debug_xml(CLIXON_DBG_DATASTORE | CLIXON_DBG_DETAIL, x1t, "");
     *xret = x1t;
     retval = 1;
  done:
     clixon_debug(CLIXON_DBG_DATASTORE | CLIXON_DBG_DETAIL, "retval:%d", retval);
-    if (xvec)
-        free(xvec);
     return retval;
  fail:
     retval = 0;
@@ -1000,7 +1448,8 @@ xmldb_get0(clixon_handle    h,
 
     if (wdef != WITHDEFAULTS_EXPLICIT)
         return xmldb_get_cache(h, db, yb, nsc, xpath, 0, xret, msdiff, xerr);
-    if ((ret = xmldb_get_cache(h, db, yb, nsc, xpath, 0, &x, msdiff, xerr)) < 0)
+    /* Defaults are not copied, remove remaining empty containers */
+    if ((ret = xmldb_get_cache(h, db, yb, nsc, xpath, WITHDEFAULTS_EXPLICIT, &x, msdiff, xerr)) < 0)
         goto done;
     if (ret == 0)
         goto fail;
@@ -1017,3 +1466,415 @@ xmldb_get0(clixon_handle    h,
     retval = 0;
     goto done;
 }
+
+/*! Clear view flags of the cached datastore tree
+ *
+ * @param[in]  xvec   Matching nodes returned by xmldb_get0_view
+ * @param[in]  xlen   Length of xvec
+ * @retval     0      OK
+ * @see xmldb_get0_view
+ */
+int
+xmldb_get0_view_clear(cxobj **xvec,
+                      size_t  xlen)
+{
+    size_t i;
+
+    for (i=0; i<xlen; i++){
+        xml_flag_reset(xvec[i], XML_FLAG_MARK|XML_FLAG_CHANGE);
+        xml_apply_ancestor(xvec[i], (xml_applyfn_t*)xml_flag_reset, (void*)XML_FLAG_CHANGE);
+    }
+    return 0;
+}
+
+/*! Get a read-only view of the cached datastore tree matching xpath, without copying
+ *
+ * Matching nodes are marked with XML_FLAG_MARK and their ancestors with XML_FLAG_CHANGE in
+ * the cache, which is what xmldb_get_copy copies. The view is printed with
+ * clixon_xml2cbuf_view and must be cleared with xmldb_get0_view_clear before the
+ * datastore is accessed again.
+ * @param[in]  h      Clixon handle
+ * @param[in]  db     Name of datastore, eg "running"
+ * @param[in]  yb     How to bind yang to XML top-level when parsing
+ * @param[in]  nsc    External XML namespace context, or NULL
+ * @param[in]  xpath  String with XPath syntax. or NULL for all
+ * @param[out] xtp    Cached top of tree, with defaults as report-all. Do not modify or free
+ * @param[out] xvecp  Matching nodes. Free after use
+ * @param[out] xlenp  Length of xvec
+ * @param[out] xerr   XML error if retval is 0
+ * @retval     1      OK
+ * @retval     0      Parse OK but yang assigment not made (or only partial) and xerr set
+ * @retval    -1      Error
+ * @code
+ *   if ((ret = xmldb_get0_view(h, "running", YB_MODULE, nsc, xpath, &xt, &xvec, &xlen, &xerr)) < 0)
+ *      err;
+ *   if (ret == 1){
+ *      clixon_xml2cbuf_view(cb, xt, -1, WITHDEFAULTS_EXPLICIT, 0, NULL, NULL);
+ *      xmldb_get0_view_clear(xvec, xlen);
+ *   }
+ *   if (xvec)
+ *      free(xvec);
+ * @endcode
+ * @see xmldb_get0 which returns a copy
+ */
+int
+xmldb_get0_view(clixon_handle h,
+                const char   *db,
+                yang_bind     yb,
+                cvec         *nsc,
+                const char   *xpath,
+                cxobj       **xtp,
+                cxobj      ***xvecp,
+                size_t       *xlenp,
+                cxobj       **xerr)
+{
+    int     retval = -1;
+    cxobj  *x0t = NULL;
+    cxobj **xvec = NULL;
+    size_t  xlen = 0;
+    size_t  i;
+    int     ret;
+
+    if ((ret = xmldb_cache_load(h, db, yb, nsc, xpath, &x0t, NULL, xerr)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
+    if (xpath_vec(x0t, nsc, "%s", &xvec, &xlen, xpath?xpath:"/") < 0)
+        goto done;
+    for (i=0; i<xlen; i++){
+        if (xml_lazy_load_recurse(xvec[i]) < 0)
+            goto done;
+        xml_flag_set(xvec[i], XML_FLAG_MARK);
+        xml_apply_ancestor(xvec[i], (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_CHANGE);
+    }
+    *xtp = x0t;
+    *xvecp = xvec;
+    xvec = NULL;
+    *xlenp = xlen;
+    retval = 1;
+ done:
+    if (xvec){
+        xmldb_get0_view_clear(xvec, xlen);
+        free(xvec);
+    }
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Create a list or leaf-list entry with only key values, for comparison with xml_cmp
+ *
+ * @param[in]  y     Yang spec of list or leaf-list
+ * @param[in]  cvv   Vector of key values in key order
+ * @param[out] xp    New entry. Free with xml_free()
+ * @retval     1     OK
+ * @retval     0     Wrong number of key values
+ * @retval    -1     Error
+ * @see xml_key_values
+ */
+static int
+xml_page_entry_new(yang_stmt *y,
+                   cvec      *cvv,
+                   cxobj    **xp)
+{
+    int     retval = -1;
+    cxobj  *x = NULL;
+    cxobj  *xk;
+    cvec   *cvk;
+    cg_var *cvi = NULL;
+    char   *keyname;
+    int     i = 0;
+
+    cvk = yang_keyword_get(y) == Y_LIST ? yang_cvec_get(y) : NULL;
+    if (cvec_len(cvv) != (cvk ? cvec_len(cvk) : 1))
+        goto fail;
+    if ((x = xml_new(yang_argument_get(y), NULL, CX_ELMNT)) == NULL)
+        goto done;
+    xml_spec_set(x, y);
+    if (cvk == NULL){
+        if (xml_new_body("body", x, cv_string_get(cvec_i(cvv, 0))) == NULL)
+            goto done;
+    }
+    else while ((cvi = cvec_each(cvk, cvi)) != NULL) {
+        keyname = cv_string_get(cvi);
+        if ((xk = xml_new_body(keyname, x, cv_string_get(cvec_i(cvv, i++)))) == NULL)
+            goto done;
+        xml_spec_set(xk, yang_find(y, Y_LEAF, keyname));
+    }
+    *xp = x;
+    x = NULL;
+    retval = 1;
+ done:
+    if (x)
+        xml_free(x);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Get entry k of a page traversal of a list
+ *
+ * @param[in]  childvec  Children of list parent
+ * @param[in]  lo        Index of first list entry in childvec
+ * @param[in]  n         Number of list entries
+ * @param[in]  ivec      Search index vector if sorted by indexed leaf, or NULL for list order
+ * @param[in]  backwards Traverse in reverse order
+ * @param[in]  k         Position in traversal, 0..n-1
+ */
+static cxobj *
+xml_page_entry(cxobj      **childvec,
+               int          lo,
+               int          n,
+               clixon_xvec *ivec,
+               int          backwards,
+               int          k)
+{
+    int p;
+
+    p = backwards ? n-1-k : k;
+    return ivec ? clixon_xvec_i(ivec, p) : childvec[lo+p];
+}
+
+/*! Get a page of a list or leaf-list in a datastore
+ *
+ * The page is selected directly from the sorted children of the list parent in the
+ * datastore cache, or from the search index vector if sorted by an indexed leaf. Only the
+ * entries of the page are copied, and remaining is computed from the list length.
+ * This requires that the xpath identifies a single list parent and has no predicate in
+ * its last step. Otherwise, or if sort_by is not an indexed leaf, 1 is returned and the
+ * caller should paginate the result of xmldb_get0 instead.
+ * @param[in]  h         Clixon handle
+ * @param[in]  db        Name of datastore, eg "running"
+ * @param[in]  nsc       External XML namespace context, or NULL
+ * @param[in]  xpath     XPath of list or leaf-list
+ * @param[in]  sort_by   Name of leaf to sort by, or NULL for list order
+ * @param[in]  backwards If set, traverse list in reverse order
+ * @param[in]  offset    Number of entries to skip
+ * @param[in]  cursor    Key values of first entry, see next and previous, or NULL. Overrides offset
+ * @param[in]  limit     Max number of entries, 0 means unbounded
+ * @param[in]  wdef      With-defaults parameter, see RFC 6243
+ * @param[out] xret      Single return XML tree, entries in page order. Free with xml_free()
+ * @param[out] remaining Number of entries after the page
+ * @param[out] next      Key values of entry after page, or NULL if last. Free with cvec_free()
+ * @param[out] previous  Key values of first entry of previous page, or NULL if first
+ * @retval     2         OK
+ * @retval     1         Not applicable, paginate result of xmldb_get0
+ * @retval     0         Cursor not found
+ * @retval    -1         Error
+ * @see draft-ietf-netconf-list-pagination
+ */
+int
+xmldb_get_page(clixon_handle     h,
+               const char       *db,
+               cvec             *nsc,
+               const char       *xpath,
+               char             *sort_by,
+               int               backwards,
+               uint32_t          offset,
+               cvec             *cursor,
+               uint32_t          limit,
+               withdefaults_type wdef,
+               cxobj           **xret,
+               uint32_t         *remaining,
+               cvec            **next,
+               cvec            **previous)
+{
+    int          retval = -1;
+    yang_stmt   *yspec;
+    yang_stmt   *ylist = NULL;
+    cxobj       *x0t = NULL;
+    cxobj       *xp = NULL;
+    cxobj       *x0;
+    cxobj       *x1;
+    cxobj       *x1t = NULL;
+    cxobj       *x1p = NULL;
+    cxobj       *xc = NULL;
+    cxobj       *xerr = NULL;
+    cxobj      **xvec = NULL;
+    size_t       xlen;
+    cxobj      **childvec = NULL;
+    clixon_xvec *ivec = NULL;
+    const char  *step;
+    const char  *s;
+    char        *pxpath = NULL;
+    int          lo = 0;
+    int          hi = 0;
+    int          n = 0;
+    int          k;
+    int          end;
+    int          i;
+    int          p;
+    int          low;
+    int          upper;
+    int          cmp;
+    int          ret;
+
+    clixon_debug(CLIXON_DBG_DATASTORE, "db %s xpath %s", db, xpath?xpath:"");
+    if (xpath == NULL || xret == NULL){
+        clixon_err(OE_DB, EINVAL, "xpath or xret is NULL");
+        goto done;
+    }
+    *remaining = 0;
+    *next = NULL;
+    *previous = NULL;
+    if ((yspec = clicon_dbspec_yang(h)) == NULL){
+        clixon_err(OE_YANG, ENOENT, "No yang spec");
+        goto done;
+    }
+    if (yang_path_arg(yspec, xpath, &ylist) < 0)
+        goto done;
+    if (ylist == NULL ||
+        (yang_keyword_get(ylist) != Y_LIST && yang_keyword_get(ylist) != Y_LEAF_LIST))
+        goto fallback;
+    if (sort_by && (strchr(sort_by, ':') != NULL || strchr(sort_by, '/') != NULL))
+        goto fallback;
+    /* Last step is a plain node name, the rest identifies the list parent */
+    if ((step = strrchr(xpath, '/')) == NULL || step[1] == '\0' ||
+        (step > xpath && step[-1] == '/'))
+        goto fallback;
+    for (s = step+1; *s; s++)
+        if (!isalnum(*s) && strchr("_-.:", *s) == NULL)
+            goto fallback;
+    if (strcmp(step+1, ".") == 0 || strcmp(step+1, "..") == 0)
+        goto fallback;
+    if ((pxpath = strndup(xpath, step-xpath)) == NULL){
+        clixon_err(OE_UNIX, errno, "strndup");
+        goto done;
+    }
+    if ((ret = xmldb_cache_load(h, db, YB_MODULE, nsc, xpath, &x0t, NULL, &xerr)) < 0)
+        goto done;
+    if (ret == 0) /* Let xmldb_get0 report the error */
+        goto fallback;
+    if (*pxpath == '\0')
+        xp = x0t;
+    else {
+        if (xpath_vec(x0t, nsc, "%s", &xvec, &xlen, pxpath) < 0)
+            goto done;
+        if (xlen > 1)
+            goto fallback;
+        if (xlen == 1)
+            xp = xvec[0];
+    }
+    if (xp != NULL){
+        if (xml_lazy_load(xp) < 0)
+            goto done;
+        if ((ret = xml_child_range_yang(xp, ylist, &lo, &hi)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fallback;
+        childvec = xml_childvec_get(xp);
+        if (lo < hi && xml_spec(childvec[lo]) != ylist) /* eg mount-point */
+            goto fallback;
+        n = hi - lo;
+    }
+    if (sort_by && n > 0){
+        if (xml_search_vector_get(xp, sort_by, &ivec) < 0)
+            goto done;
+        if (ivec == NULL || clixon_xvec_len(ivec) != n)
+            goto fallback;
+    }
+    if (cursor){
+        if (n == 0)
+            goto fail;
+        if ((ret = xml_page_entry_new(ylist, cursor, &xc)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+        p = -1;
+        if (ivec == NULL && yang_find(ylist, Y_ORDERED_BY, "user") == NULL){
+            /* Binary search in key order */
+            low = lo;
+            upper = hi;
+            while (low < upper){
+                i = (low + upper)/2;
+                if ((cmp = xml_cmp(xc, childvec[i], 0, 0, NULL)) == 0){
+                    p = i - lo;
+                    break;
+                }
+                if (cmp < 0)
+                    upper = i;
+                else
+                    low = i + 1;
+            }
+        }
+        else {
+            for (i=0; i<n; i++){
+                x0 = ivec ? clixon_xvec_i(ivec, i) : childvec[lo+i];
+                if (xml_cmp(xc, x0, 0, 0, NULL) == 0){
+                    p = i;
+                    break;
+                }
+            }
+        }
+        if (p < 0)
+            goto fail;
+        k = backwards ? n-1-p : p;
+    }
+    else
+        k = offset < (uint32_t)n ? (int)offset : n;
+    if (limit == 0 || limit >= (uint32_t)(n - k))
+        end = n;
+    else
+        end = k + limit;
+    /* Make new tree by copying top-of-tree from x0t to x1t */
+    if ((x1t = xml_new(xml_name(x0t), NULL, CX_ELMNT)) == NULL)
+        goto done;
+    xml_flag_set(x1t, XML_FLAG_TOP);
+    xml_spec_set(x1t, xml_spec(x0t));
+    if (k < end &&
+        xml_copy_bottom_recurse(x0t, xp, x1t, &x1p) < 0)
+        goto done;
+    for (i=k; i<end; i++){
+        x0 = xml_page_entry(childvec, lo, n, ivec, backwards, i);
+        if (xml_lazy_load_recurse(x0) < 0)
+            goto done;
+        if ((x1 = xml_new(xml_name(x0), x1p, CX_ELMNT)) == NULL)
+            goto done;
+        if (xml_copy(x0, x1) < 0)
+            goto done;
+    }
+    if (clicon_option_bool(h, "CLICON_NACM_DISABLED_ON_EMPTY")){
+        if (disable_nacm_on_empty(x1t, yspec) < 0)
+            goto done;
+    }
+    if (wdef == WITHDEFAULTS_EXPLICIT &&
+        xml_default_nopresence(x1t, 2, 0) < 0)
+        goto done;
+    if (end < n &&
+        xml_key_values(xml_page_entry(childvec, lo, n, ivec, backwards, end), ylist, next) < 0)
+        goto done;
+    if (k > 0 &&
+        xml_key_values(xml_page_entry(childvec, lo, n, ivec, backwards,
+                                     (limit && k > limit) ? k - limit : 0),
+                      ylist, previous) < 0)
+        goto done;
+    *remaining = n - end;
+    *xret = x1t;
+    x1t = NULL;
+    retval = 2;
+ done:
+    clixon_debug(CLIXON_DBG_DATASTORE | CLIXON_DBG_DETAIL, "retval:%d", retval);
+    if (retval < 2 && next && *next){
+        cvec_free(*next);
+        *next = NULL;
+    }
+    if (pxpath)
+        free(pxpath);
+    if (xvec)
+        free(xvec);
+    if (xc)
+        xml_free(xc);
+    if (xerr)
+        xml_free(xerr);
+    if (x1t)
+        xml_free(x1t);
+    return retval;
+ fallback:
+    retval = 1;
+    goto done;
+ fail:
+    retval = 0;
+    goto done;
+}
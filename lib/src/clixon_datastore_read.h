@@ -43,5 +43,6 @@
  */
 int xmldb_readfile(clixon_handle h, const char *db, yang_bind yb, yang_stmt *yspec,
                    cxobj **xp, db_elmnt *de, modstate_diff_t *msd, cxobj **xerr);
+int xmldb_lazy_load1(clixon_handle h, cxobj *x, const char *subdir);
 
 #endif /* _CLIXON_DATASTORE_READ_H */
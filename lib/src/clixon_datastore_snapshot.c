@@ -0,0 +1,406 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Read-only snapshot of the running datastore for local frontends
+ *
+ * The backend publishes running in binary format to CLICON_XMLDB_SNAPSHOT, typically
+ * a file in tmpfs such as /dev/shm, whenever the cache has changed. Frontends on the
+ * same host read get-config of running from the snapshot instead of making an RPC.
+ * A new generation is written to a temporary file and renamed over the old, so
+ * readers always see a complete snapshot. Readers re-parse only when the file
+ * identity (inode, mtime, size) changes.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_map.h"
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_err.h"
+#include "clixon_log.h"
+#include "clixon_debug.h"
+#include "clixon_uid.h"
+#include "clixon_options.h"
+#include "clixon_data.h"
+#include "clixon_xpath_ctx.h"
+#include "clixon_xpath.h"
+#include "clixon_xml_sort.h"
+#include "clixon_xml_bind.h"
+#include "clixon_xml_map.h"
+#include "clixon_xml_nsctx.h"
+#include "clixon_nacm.h"
+#include "clixon_netconf_lib.h"
+#include "clixon_xml_binary.h"
+#include "clixon_yang_module.h"
+#include "clixon_xml_io.h"
+#include "clixon_datastore.h"
+
+#define NACM_NS "urn:ietf:params:xml:ns:yang:ietf-netconf-acm"
+
+/* Backend: cache epoch of last published snapshot */
+static int      _snapshot_written = 0;
+static uint64_t _snapshot_epoch = 0;
+
+/* Frontend: last parsed snapshot and the identity of its file */
+static cxobj   *_snapshot_xt = NULL;
+static ino_t    _snapshot_ino = 0;
+static struct timespec _snapshot_mtim = {0,};
+static off_t    _snapshot_size = 0;
+
+/*! Publish running datastore cache as a binary snapshot, if changed
+ *
+ * Called by the backend after startup and after each client message.
+ * @param[in]  h   Clixon handle
+ * @retval     0   OK, or no snapshot configured
+ * @retval    -1   Error
+ * @see xmldb_snapshot_get  Frontend read of snapshot
+ */
+int
+xmldb_snapshot_write(clixon_handle h)
+{
+    int        retval = -1;
+    char      *filename;
+    cbuf      *cbtmp = NULL;
+    db_elmnt  *de;
+    cxobj     *xt = NULL;
+    yang_stmt *yspec;
+    char      *group;
+    gid_t      gid = 0;
+    int        fd = -1;
+    FILE      *f = NULL;
+
+    if ((filename = clicon_option_str(h, "CLICON_XMLDB_SNAPSHOT")) == NULL)
+        goto ok;
+    if ((de = clicon_db_elmnt_get(h, "running")) == NULL || de->de_xml == NULL){
+        if (xmldb_get0(h, "running", YB_MODULE, NULL, "/", 0, 0, &xt, NULL, NULL) < 0)
+            goto done;
+        if (xt){
+            xml_free(xt);
+            xt = NULL;
+        }
+        if ((de = clicon_db_elmnt_get(h, "running")) == NULL || de->de_xml == NULL)
+            goto ok;
+    }
+    if (_snapshot_written && de->de_epoch == _snapshot_epoch)
+        goto ok;
+    yspec = clicon_dbspec_yang(h);
+    if (xml_lazy_load_recurse(de->de_xml) < 0)
+        goto done;
+    if ((cbtmp = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cbtmp, "%s.tmp", filename);
+    if ((fd = open(cbuf_get(cbtmp), O_WRONLY|O_CREAT|O_TRUNC, 0640)) < 0){
+        clixon_err(OE_UNIX, errno, "open(%s)", cbuf_get(cbtmp));
+        goto done;
+    }
+    if ((group = clicon_sock_group(h)) != NULL){
+        if (group_name2gid(group, &gid) < 0)
+            goto done;
+        if (fchown(fd, -1, gid) < 0){
+            clixon_err(OE_UNIX, errno, "fchown(%s)", cbuf_get(cbtmp));
+            goto done;
+        }
+    }
+    if ((f = fdopen(fd, "w")) == NULL){
+        clixon_err(OE_UNIX, errno, "fdopen(%s)", cbuf_get(cbtmp));
+        goto done;
+    }
+    fd = -1;
+    if (clixon_xml2binary_file(f, de->de_xml, yspec) < 0)
+        goto done;
+    if (fclose(f) < 0){
+        f = NULL;
+        clixon_err(OE_UNIX, errno, "fclose(%s)", cbuf_get(cbtmp));
+        goto done;
+    }
+    f = NULL;
+    if (rename(cbuf_get(cbtmp), filename) < 0){
+        clixon_err(OE_UNIX, errno, "rename(%s)", filename);
+        goto done;
+    }
+    _snapshot_written = 1;
+    _snapshot_epoch = de->de_epoch;
+    clixon_debug(CLIXON_DBG_DATASTORE, "snapshot epoch %" PRIu64 " written", _snapshot_epoch);
+ ok:
+    retval = 0;
+ done:
+    if (f)
+        fclose(f);
+    if (fd != -1)
+        close(fd);
+    if (retval < 0 && cbtmp)
+        unlink(cbuf_get(cbtmp));
+    if (cbtmp)
+        cbuf_free(cbtmp);
+    return retval;
+}
+
+/*! Remove nodes not reported for a with-defaults mode, see RFC 6243
+ *
+ * In-tree variant of the with-defaults filtering made when the backend prints a reply
+ * @param[in]  x     XML tree
+ * @param[in]  wdef  With-defaults parameter
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see xml2output_wdef
+ */
+static int
+snapshot_wdef_purge(cxobj            *x,
+                    withdefaults_type wdef)
+{
+    int    retval = -1;
+    cxobj *xc;
+    cxobj *xprev;
+    int    ret;
+
+    xc = NULL;
+    xprev = NULL;
+    while ((xc = xml_child_each(x, xc, CX_ELMNT)) != NULL) {
+        if ((ret = xml2output_wdef(xc, wdef, NULL)) < 0)
+            goto done;
+        if (ret == 0){
+            if (xml_purge(xc) < 0)
+                goto done;
+            xc = xprev;
+            continue;
+        }
+        if (snapshot_wdef_purge(xc, wdef) < 0)
+            goto done;
+        xprev = xc;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Load the published snapshot if the file has changed since last load
+ *
+ * @param[in]  h     Clixon handle
+ * @param[in]  filename  Snapshot file
+ * @param[out] xtp   Snapshot tree, owned by this module. NULL if no snapshot
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+snapshot_load(clixon_handle h,
+              const char   *filename,
+              cxobj       **xtp)
+{
+    int        retval = -1;
+    struct stat st;
+    FILE      *fp = NULL;
+    yang_stmt *yspec;
+    cxobj     *xt = NULL;
+    cxobj     *xerr = NULL;
+    int        bound = 0;
+    int        ret;
+
+    *xtp = NULL;
+    if (stat(filename, &st) < 0)
+        goto ok; /* Not published (yet) */
+    if (_snapshot_xt != NULL &&
+        st.st_ino == _snapshot_ino &&
+        st.st_size == _snapshot_size &&
+        st.st_mtim.tv_sec == _snapshot_mtim.tv_sec &&
+        st.st_mtim.tv_nsec == _snapshot_mtim.tv_nsec){
+        *xtp = _snapshot_xt;
+        goto ok;
+    }
+    if ((fp = fopen(filename, "r")) == NULL){
+        if (errno == ENOENT || errno == EACCES)
+            goto ok;
+        clixon_err(OE_UNIX, errno, "fopen(%s)", filename);
+        goto done;
+    }
+    /* Identity of the opened generation, it may have been replaced since stat */
+    if (fstat(fileno(fp), &st) < 0){
+        clixon_err(OE_UNIX, errno, "fstat(%s)", filename);
+        goto done;
+    }
+    yspec = clicon_dbspec_yang(h);
+    if (clixon_binary_parse_file(fp, YB_MODULE, yspec, &xt, &bound) < 0)
+        goto done;
+    /* <top><config>...</config></top> -> <config>...</config> */
+    if (xml_child_nr_type(xt, CX_ELMNT) == 1 &&
+        xml_rootchild(xt, 0, &xt) < 0)
+        goto done;
+    xml_flag_set(xt, XML_FLAG_TOP);
+    if (!bound){
+        if ((ret = xml_bind_yang(h, xt, YB_MODULE, yspec, &xerr)) < 0)
+            goto done;
+        if (ret == 0){
+            clixon_debug(CLIXON_DBG_DATASTORE, "snapshot not bound to yang, ignored");
+            goto ok;
+        }
+        if (xml_sort_recurse(xt) < 0)
+            goto done;
+    }
+    if (_snapshot_xt)
+        xml_free(_snapshot_xt);
+    _snapshot_xt = xt;
+    _snapshot_ino = st.st_ino;
+    _snapshot_size = st.st_size;
+    _snapshot_mtim = st.st_mtim;
+    *xtp = xt;
+    xt = NULL;
+ ok:
+    retval = 0;
+ done:
+    if (fp)
+        fclose(fp);
+    if (xt)
+        xml_free(xt);
+    if (xerr)
+        xml_free(xerr);
+    return retval;
+}
+
+/*! Get running config from the published snapshot instead of from the backend
+ *
+ * NACM read rules are enforced locally in internal mode, using the nacm config of
+ * the snapshot and the local user as peer.
+ * @param[in]  h        Clixon handle
+ * @param[in]  username NACM user name of requestor
+ * @param[in]  nsc      Namespace context of xpath
+ * @param[in]  xpath    XPath, or NULL for all
+ * @param[in]  wdef     With-defaults parameter, see RFC 6243
+ * @param[out] xret     Data tree with top label "data". Free with xml_free()
+ * @retval     1        OK, xret set
+ * @retval     0        Snapshot not usable, get running from backend
+ * @retval    -1        Error
+ * @see xmldb_snapshot_write
+ */
+int
+xmldb_snapshot_get(clixon_handle     h,
+                   char             *username,
+                   cvec             *nsc,
+                   char             *xpath,
+                   withdefaults_type wdef,
+                   cxobj           **xret)
+{
+    int        retval = -1;
+    char      *filename;
+    char      *mode;
+    cxobj     *xsnap = NULL;
+    cxobj     *xn0 = NULL;
+    cxobj     *xnacm = NULL;
+    cxobj     *x1t = NULL;
+    cxobj    **xvec = NULL;
+    size_t     xlen;
+    cvec      *nsc0 = NULL;
+    char      *peername = NULL;
+    int        ret;
+
+    if ((filename = clicon_option_str(h, "CLICON_XMLDB_SNAPSHOT")) == NULL)
+        goto fallback;
+    if (wdef == WITHDEFAULTS_REPORT_ALL_TAGGED)
+        goto fallback;
+    mode = clicon_option_str(h, "CLICON_NACM_MODE");
+    if (mode != NULL &&
+        strcmp(mode, "disabled") != 0 &&
+        strcmp(mode, "internal") != 0)
+        goto fallback;
+    if (snapshot_load(h, filename, &xsnap) < 0)
+        goto done;
+    if (xsnap == NULL)
+        goto fallback;
+    if (mode != NULL && strcmp(mode, "internal") == 0){
+        if ((nsc0 = xml_nsctx_init(NULL, NACM_NS)) == NULL)
+            goto done;
+        if (xmldb_get_copy(h, xsnap, nsc0, "nacm", WITHDEFAULTS_REPORT_ALL, &xn0) < 0)
+            goto done;
+        if ((xnacm = xpath_first(xn0, nsc0, "nacm")) != NULL){
+            if (uid2name(getuid(), &peername) < 0)
+                goto done;
+            if ((ret = nacm_access_check(h, xnacm, peername, username)) < 0)
+                goto done;
+            if (ret == 1)
+                xnacm = NULL;
+        }
+    }
+    /* Defaults are not copied unless NACM read rules apply to the full tree */
+    if (xmldb_get_copy(h, xsnap, nsc, xpath, xnacm?WITHDEFAULTS_REPORT_ALL:wdef, &x1t) < 0)
+        goto done;
+    if (xnacm){
+        if (xpath_vec(x1t, nsc, "%s", &xvec, &xlen, xpath?xpath:"/") < 0)
+            goto done;
+        if (nacm_datanode_read(h, x1t, xvec, xlen, username, xnacm) < 0)
+            goto done;
+    }
+    if (wdef != WITHDEFAULTS_REPORT_ALL &&
+        snapshot_wdef_purge(x1t, wdef) < 0)
+        goto done;
+    if (xml_name_set(x1t, NETCONF_OUTPUT_DATA) < 0)
+        goto done;
+    *xret = x1t;
+    x1t = NULL;
+    retval = 1;
+ done:
+    if (x1t)
+        xml_free(x1t);
+    if (xn0)
+        xml_free(xn0);
+    if (xvec)
+        free(xvec);
+    if (nsc0)
+        cvec_free(nsc0);
+    if (peername)
+        free(peername);
+    return retval;
+ fallback:
+    retval = 0;
+    goto done;
+}
@@ -44,6 +44,7 @@
 #include <errno.h>
 #include <string.h>
 #include <limits.h>
+#include <time.h>
 #include <stdint.h>
 #include <unistd.h>
 #include <dirent.h>
@@ -51,6 +52,7 @@
 #include <fcntl.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/wait.h>
 
 /* cligen */
 #include <cligen/cligen.h>
@@ -68,14 +70,18 @@
 #include "clixon_log.h"
 #include "clixon_debug.h"
 #include "clixon_file.h"
+#include "clixon_event.h"
+#include "clixon_uring.h"
 #include "clixon_xml_sort.h"
 #include "clixon_options.h"
+#include "clixon_compress.h"
 #include "clixon_data.h"
 #include "clixon_xpath_ctx.h"
 #include "clixon_xpath.h"
 #include "clixon_json.h"
 #include "clixon_nacm.h"
 #include "clixon_netconf_lib.h"
+#include "clixon_xml_binary.h"
 #include "clixon_yang_type.h"
 #include "clixon_yang_module.h"
 #include "clixon_yang_schema_mount.h"
@@ -87,6 +93,8 @@
 #include "clixon_datastore.h"
 #include "clixon_datastore_write.h"
 #include "clixon_datastore_read.h"
+#include "clixon_latency.h"
+#include "clixon_memstats.h"
 
 /* Local types */
 /* Argument to apply for recursive call to xmldb_multi write calls
@@ -98,6 +106,10 @@ struct xmldb_multi_write_arg {
     int               mw_pretty;
     withdefaults_type mw_wdef;
     enum format_enum  mw_format;
+    int               mw_workers; /* If > 1, collect dirty sub-files and write them in parallel */
+    cxobj           **mw_xvec;    /* Collected sub-trees to write */
+    char            **mw_files;   /* Collected sub-file names */
+    int               mw_len;     /* Length of mw_xvec and mw_files */
 };
 
 /*! Given an attribute name and its expected namespace, find its value
@@ -294,16 +306,17 @@ check_when_condition(cxobj     *x0p,
                      yang_stmt *y0,
                      cbuf      *cbret)
 {
-    int        retval = -1;
-    char      *xpath = NULL;
-    cvec      *nsc = NULL;
-    int        nr;
-    yang_stmt *y = NULL;
-    cbuf      *cberr = NULL;
-    cxobj     *x1p;
-    cvec      *cnsc = NULL;
-    cvec      *nnsc = NULL;
-    char      *cxpath = NULL;
+    int         retval = -1;
+    char       *xpath = NULL;
+    cvec       *nsc = NULL;
+    int         nr;
+    yang_stmt  *y = NULL;
+    cbuf       *cberr = NULL;
+    cxobj      *x1p;
+    cvec       *cnsc = NULL;
+    cvec       *nnsc = NULL;
+    yang_stmt  *ywhen;
+    xpath_tree *cxptree = NULL;
 
     if ((y = y0) != NULL ||
         (y = (yang_stmt*)xml_spec(x1)) != NULL){
@@ -338,20 +351,24 @@ check_when_condition(cxobj     *x0p,
             goto done;
         if (nr != 0)
             goto ok;
-        /* 5. Try yang canonical context for incoming xml */
-        if (yang_when_canonical_xpath_get(y, &cxpath, &cnsc) < 0)
+        /* 5. Try yang canonical context for incoming xml
+         * The canonical xpath is parsed once and cached in the when statement */
+        if ((ywhen = yang_when_get(NULL, y)) != NULL &&
+            yang_xpath_cache_get(ywhen, 1, NULL, &cxptree, &cnsc) < 0)
             goto done;
 #if 0
-        if ((nr = xpath_vec_bool(x1p, cnsc, "%s", cxpath)) < 0)
+        if ((nr = xpath_tree_vec_bool(x1p, cnsc, cxptree)) < 0)
             goto done;
         if (nr != 0)
             goto ok;
 #endif
         /* 6. Try yang canonical context for existing xml */
-        if ((nr = xpath_vec_bool(x0p, cnsc, "%s", cxpath)) < 0)
-            goto done;
-        if (nr != 0)
-            goto ok;
+        if (cxptree){
+            if ((nr = xpath_tree_vec_bool(x0p, cnsc, cxptree)) < 0)
+                goto done;
+            if (nr != 0)
+                goto ok;
+        }
         if ((cberr = cbuf_new()) == NULL){
             clixon_err(OE_UNIX, errno, "cbuf_new");
             goto done;
@@ -368,10 +385,6 @@ check_when_condition(cxobj     *x0p,
  ok:
     retval = 1;
  done:
-    if (cxpath)
-        free(cxpath);
-    if (cnsc)
-        cvec_free(cnsc);
     if (nsc)
         cvec_free(nsc);
     if (cberr)
@@ -384,45 +397,6 @@ check_when_condition(cxobj     *x0p,
     goto done;
 }
 
-/*! Check if x0/y0 is part of other choice/case than y1 recursively , if so purge 
- *
- * @retval 1 yes, y0 is in other case than y1
- * @retval 0 No, y0 it is not in other case than y1
- */
-static int
-choice_is_other(yang_stmt *y0c,
-                yang_stmt *y0case,
-                yang_stmt *y0choice,
-                yang_stmt *y1c,
-                yang_stmt *y1case,
-                yang_stmt *y1choice)
-{
-    yang_stmt *ycase;
-    yang_stmt *ychoice;
-
-    if (y0choice == y1choice){
-        if ((y0case == NULL && y0c != y1c) ||
-            y0case != y1case){
-            return 1;
-        }
-    }
-    else {
-        /* First recurse y0 */
-        if (yang_choice_case_get(y0choice, &ycase, &ychoice)){
-            if (choice_is_other(y0choice, ycase, ychoice,
-                                y1c, y1case, y1choice) == 1)
-                return 1;
-        }
-        /* Second recurse y1 */
-        if (yang_choice_case_get(y1choice, &ycase, &ychoice)){
-            if (choice_is_other(y0choice, y0case, y0choice,
-                                y1choice, ycase, ychoice) == 1)
-                return 1;
-        }
-    }
-    return 0;
-}
-
 /*! Check if choice nodes and if add implicitly remove all other cases, or fail if delete
  *
  * Special case is if yc parent (yp) is choice/case
@@ -449,17 +423,21 @@ choice_other_match(cxobj              *x0,
                    enum operation_type op,
                    cbuf               *cbret)
 {
-    int        retval = -1;
-    cxobj     *x0c;
-    cxobj     *x0prev;
-    yang_stmt *y0c;
-    yang_stmt *y0case;
-    yang_stmt *y0choice;
-    yang_stmt *y1case = NULL;
-    yang_stmt *y1choice = NULL;
-    char      *opstr = NULL;
-    int        ret;
+    int         retval = -1;
+    cxobj      *x0c;
+    yang_stmt  *y;
+    yang_stmt  *ycase = NULL;
+    yang_stmt  *ychoice = NULL;
+    yang_stmt  *ybranch;
+    yang_stmt **nodes;
+    yang_stmt **branches;
+    char       *opstr = NULL;
+    int         len;
+    int         i;
+    int         ret;
 
+    if (yang_choice_case_get(y1c, NULL, &ychoice) == 0)
+        goto ok;
     if ((ret = attr_ns_value(x1c, "operation", NETCONF_BASE_NAMESPACE, 1, cbret, &opstr)) < 0)
         goto done;
     if (ret == 0)
@@ -467,42 +445,29 @@ choice_other_match(cxobj              *x0,
     if (opstr != NULL)
         if (xml_operation(opstr, &op) < 0)
             goto done;
-    if (yang_choice_case_get(y1c, &y1case, &y1choice) == 0)
+    if (op == OP_REMOVE || op == OP_NONE)
         goto ok;
-    x0prev = NULL;
-    x0c = NULL;
-    while ((x0c = xml_child_each(x0, x0c, CX_ELMNT)) != NULL) {
-        if ((y0c = xml_spec(x0c)) == NULL ||
-            yang_parent_get(y0c) == NULL){
-            x0prev = x0c;
-            continue;
-        }
-        if (yang_choice_case_get(y0c, &y0case, &y0choice) == 0){
-            x0prev = x0c;
-            continue;
-        }
-        /* Check if x0/y0 is part of other choice/case than y1 recursively , if so purge */
-        if (choice_is_other(y0c, y0case, y0choice, y1c, y1case, y1choice) == 1){
-            switch (op){
-            case OP_MERGE:
-            case OP_REPLACE:
-            case OP_CREATE:
-                if (xml_purge(x0c) < 0)
-                    goto done;
-                x0c = x0prev;
+    /* For y1c and each choice it is nested in, look up existing nodes of other cases
+     * in the membership table of the choice, instead of searching all children of x0 */
+    y = y1c;
+    while (yang_choice_case_get(y, &ycase, &ychoice) == 1){
+        ybranch = ycase ? ycase : y;
+        if (yang_choice_members(ychoice, &nodes, &branches, &len) < 0)
+            goto done;
+        for (i=0; i<len; i++){
+            if (branches[i] == ybranch)
                 continue;
-                break;
-            case OP_DELETE:
-                if (netconf_data_missing(cbret, "Data does not exist; cannot delete resource") < 0)
+            while ((x0c = xml_child_yang(x0, nodes[i])) != NULL){
+                if (op == OP_DELETE){
+                    if (netconf_data_missing(cbret, "Data does not exist; cannot delete resource") < 0)
+                        goto done;
+                    goto fail;
+                }
+                if (xml_purge(x0c) < 0)
                     goto done;
-                goto fail;
-                break;
-            case OP_REMOVE:
-            case OP_NONE:
-                break;
             }
         }
-        x0prev = x0c;
+        y = ychoice;
     }
  ok:
     retval = 1;
@@ -528,6 +493,7 @@ choice_other_match(cxobj              *x0,
  * @param[in]  username User name of requestor for nacm
  * @param[in]  xnacm    NACM XML tree (only if !permit)
  * @param[in]  permit   If set, no NACM tests using xnacm required
+ * @param[in]  whenok   When condition of y0 is already true in x0p, see check_when_condition
  * @param[out] cbret    Initialized cligen buffer. Contains return XML if retval is 0.
  * @retval     1        OK
  * @retval     0        Failed (cbret set)
@@ -552,6 +518,7 @@ text_modify(clixon_handle       h,
             char               *username,
             cxobj              *xnacm,
             int                 permit,
+            int                 whenok,
             cbuf               *cbret)
 {
     int        retval = -1;
@@ -579,15 +546,21 @@ text_modify(clixon_handle       h,
     char      *restype;
     int        ismount = 0;
     yang_stmt *mount_yspec = NULL;
+    yang_stmt *ywhen = NULL; /* Spec of previous child with true when condition */
 
     if (x1 == NULL){
         clixon_err(OE_XML, EINVAL, "x1 is missing");
         goto done;
     }
-    if ((ret = check_when_condition(x0p, x1, y0, cbret)) < 0)
+    /* Load children of base node if not loaded, see CLICON_XMLDB_MULTI_LAZY */
+    if (x0 && xml_lazy_load(x0) < 0)
         goto done;
-    if (ret == 0)
-        goto fail;
+    if (!whenok){
+        if ((ret = check_when_condition(x0p, x1, y0, cbret)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+    }
     /* Check for operations embedded in tree according to netconf */
     if ((ret = attr_ns_value(x1, "operation", NETCONF_BASE_NAMESPACE, 0,
                              cbret, &opstr)) < 0)
@@ -1008,8 +981,11 @@ text_modify(clixon_handle       h,
             /* Second pass: Loop through children of the x1 modification tree again
              * Now potentially modify x0:s children 
              * Here x0vec contains one-to-one matching nodes of x1:s children.
+             * The when condition is evaluated in x0, once for consecutive children with
+             * same yang spec, eg list entries
              */
             x1c = NULL;
+            ywhen = NULL;
             i = 0;
             while ((x1c = xml_child_each(x1, x1c, CX_ELMNT)) != NULL) {
                 x0c = x0vec[i++];
@@ -1029,14 +1005,20 @@ text_modify(clixon_handle       h,
                     else{
                         if ((ret = text_modify(h, x0c, x0, x0t, x1c, x1t,
                                                yc, op,
-                                               username, xnacm, permit, cbret)) < 0)
+                                               username, xnacm, permit,
+                                               yc && yc == ywhen, cbret)) < 0)
                             goto done;
+                        ywhen = yc;
                     }
                 }
-                else if ((ret = text_modify(h, x0c, x0, x0t, x1c, x1t,
-                                            yc, op,
-                                            username, xnacm, permit, cbret)) < 0)
-                    goto done;
+                else {
+                    if ((ret = text_modify(h, x0c, x0, x0t, x1c, x1t,
+                                           yc, op,
+                                           username, xnacm, permit,
+                                           yc && yc == ywhen, cbret)) < 0)
+                        goto done;
+                    ywhen = yc;
+                }
                 /* If xml return - ie netconf error xml tree, then stop and return OK */
                 if (ret == 0)
                     goto fail;
@@ -1245,7 +1227,7 @@ text_modify_top(clixon_handle       h,
         }
         if ((ret = text_modify(h, x0c, x0t, x0t, x1c, x1t,
                                yc, op,
-                               username, xnacm, permit, cbret)) < 0)
+                               username, xnacm, permit, 0, cbret)) < 0)
             goto done;
         /* If xml return - ie netconf error xml tree, then stop and return OK */
         if (ret == 0)
@@ -1303,103 +1285,78 @@ xml_mark_cache_dirty(cxobj *x,
     return 2;
 }
 
-/*! Modify database given an xml tree and an operation
+/*! Mark non-list descendants of a node with deleted children as edited
  *
- * @param[in]  h      CLICON handle
- * @param[in]  db     running or candidate
- * @param[in]  op     Top-level operation, can be superceded by other op in tree
- * @param[in]  x1     xml-tree. Top-level symbol is dummy
- * @param[in]  username User name for nacm
- * @param[out] cbret  Initialized cligen buffer. On exit contains XML if retval == 0
- * @retval     1      OK
- * @retval     0      Failed, cbret contains error xml message
- * @retval    -1      Error
- * The xml may contain the "operation" attribute which defines the operation.
- * @code
- *   cxobj     *xt;
- *   cxobj     *xret = NULL;
- *   if (clixon_xml_parse_string("<a>17</a>", YB_NONE, NULL, &xt, NULL) < 0)
- *     err;
- *   if ((ret = xmldb_put(h, "running", OP_MERGE, xt, username, cbret)) < 0)
- *     err;
- *   if (ret==0)
- *     cbret contains netconf error message
- * @endcode
- * @note if xret is non-null, it may contain error message
- * @note x1 may change as a side-effect (eg operation attributes are stripped)
+ * Defaults may be re-created below a node where children were deleted, but never
+ * list entries, so list entries (and their subtrees) need not be marked.
+ * @param[in]  x    XML node
+ * @param[in]  arg  General-purpose argument (not used)
+ * @retval     2    Locally abort this subtree, continue with others
+ * @retval     0    OK, continue
  */
-int
-xmldb_put(clixon_handle       h,
-          const char         *db,
-          enum operation_type op,
-          cxobj              *x1,
-          char               *username,
-          cbuf               *cbret)
+static int
+xml_mark_edited_nolist(cxobj *x,
+                       void  *arg)
 {
-    int         retval = -1;
-    yang_stmt  *yspec;
-    cxobj      *x0 = NULL;
-    db_elmnt   *de = NULL;
-    db_elmnt    de0 = {0,};
-    int         ret;
-    cxobj      *xnacm = NULL;
-    int         permit = 0; /* nacm permit all */
-    cvec       *nsc = NULL; /* nacm namespace context */
-    int         firsttime = 0;
-    cxobj      *xerr = NULL;
+    yang_stmt *y;
 
-    clixon_debug(CLIXON_DBG_DATASTORE|CLIXON_DBG_DETAIL, "db %s", db);
-    if (cbret == NULL){
-        clixon_err(OE_XML, EINVAL, "cbret is NULL");
-        goto done;
-    }
-    if ((yspec = clicon_dbspec_yang(h)) == NULL){
-        clixon_err(OE_YANG, ENOENT, "No yang spec");
-        goto done;
-    }
-    if (x1 && strcmp(xml_name(x1), NETCONF_INPUT_CONFIG) != 0){
-        clixon_err(OE_XML, 0, "Top-level symbol of modification tree is %s, expected \"%s\"",
-                   xml_name(x1), NETCONF_INPUT_CONFIG);
-        goto done;
-    }
-    if ((de = clicon_db_elmnt_get(h, db)) != NULL){
-        x0 = de->de_xml; /* XXX flag is not XML_FLAG_TOP */
-    }
-    /* If there is no xml x0 tree (in cache), then read it from file */
-    if (x0 == NULL){
-        firsttime++; /* to avoid leakage on error, see fail from text_modify */
-        /* xml looks like: <top><config><x>... where "x" is a top-level symbol in a module */
-        if ((ret = xmldb_readfile(h, db, YB_MODULE, yspec, &x0, de, NULL, &xerr)) < 0)
-            goto done;
-        if (ret == 0)
-            goto fail;
+    if ((y = xml_spec(x)) != NULL &&
+        (yang_keyword_get(y) == Y_LIST || yang_keyword_get(y) == Y_LEAF_LIST))
+        return 2;
+    xml_flag_set(x, XML_FLAG_EDITED);
+    return 0;
+}
+
+/*! Mark changed nodes and their ancestors as edited for incremental diff
+ *
+ * Marks persist until the datastore is made equal to running, see xmldb_copy
+ * @param[in]  x    XML node
+ * @param[in]  arg  General-purpose argument (not used)
+ * @retval     2    Locally abort this subtree, continue with others
+ * @retval     0    OK, continue
+ * @retval    -1    Error
+ * @see xml_diff_flagged  Where marks are used
+ */
+static int
+xml_mark_edited(cxobj *x,
+                void  *arg)
+{
+    if (xml_flag(x, XML_FLAG_ADD)){
+        if (xml_apply0(x, CX_ELMNT, (xml_applyfn_t*)xml_flag_set, (void*)(XML_FLAG_EDITED)) < 0)
+            return -1;
+        xml_apply_ancestor(x, (xml_applyfn_t*)xml_flag_set, (void*)(XML_FLAG_EDITED));
+        return 2;
     }
-    if (strcmp(xml_name(x0), DATASTORE_TOP_SYMBOL) !=0 ||
-        xml_flag(x0, XML_FLAG_TOP) == 0){
-        clixon_err(OE_XML, 0, "Top-level symbol is %s, expected \"%s\"",
-                   xml_name(x0), DATASTORE_TOP_SYMBOL);
-        goto done;
+    else if (xml_flag(x, XML_FLAG_DEL)){
+        xml_flag_set(x, XML_FLAG_EDITED);
+        xml_apply_ancestor(x, (xml_applyfn_t*)xml_flag_set, (void*)(XML_FLAG_EDITED));
+        if (xml_apply(x, CX_ELMNT, xml_mark_edited_nolist, NULL) < 0)
+            return -1;
+        return 0;
     }
-    /* Here x0 looks like: <config>...</config> */
-    xnacm = clicon_nacm_cache(h);
-    permit = (xnacm==NULL);
-    /* Here assume if xnacm is set and !permit do NACM */
-    clicon_data_del(h, "objectexisted");
-    /*
-     * Modify base tree x with modification x1. This is where the
-     * new tree is made.
-     */
-    if ((ret = text_modify_top(h, x0, x1, yspec, op, username, xnacm, permit, cbret)) < 0)
-        goto done;
-    /* If xml return - ie netconf error xml tree, then stop and return OK */
-    if (ret == 0){
-        /* If first time and quit here, x0 is not written back into cache and leaks */
-        if (firsttime && x0){
-            xml_free(x0);
-            x0 = NULL;
-        }
-        goto fail;
+    else if (xml_flag(x, XML_FLAG_CHANGE)){
+        xml_flag_set(x, XML_FLAG_EDITED);
+        return 0;
     }
+    return 2;
+}
+
+/*! Update flags and defaults of cached tree after one or several modifications
+ *
+ * @param[in]  h        Clixon handle
+ * @param[in]  x0       Top of datastore cache
+ * @param[in]  yspec    Top-level yang spec
+ * @retval     0        OK
+ * @retval    -1        Error
+ * @see xmldb_modify
+ */
+static int
+xmldb_modify_done(clixon_handle h,
+                  cxobj        *x0,
+                  yang_stmt    *yspec)
+{
+    int retval = -1;
+
     /* Remove NONE nodes if all subs recursively are also NONE */
     if (xml_tree_prune_flagged_sub(x0, XML_FLAG_NONE, 0, NULL) <0)
         goto done;
@@ -1415,104 +1372,835 @@ xmldb_put(clixon_handle       h,
         goto done;
     /* Complete defaults in incoming x1
      */
-    if (xml_global_defaults(h, x0, nsc, "/", yspec, 0) < 0)
+    if (xml_global_defaults(h, x0, NULL, "/", yspec, 0) < 0)
         goto done;
     /* Add default recursive values */
     if (xml_default_recurse(x0, 0, XML_FLAG_ADD|XML_FLAG_DEL) < 0)
         goto done;
-    /* Write back to datastore cache if first time */
-    if (de != NULL)
-        de0 = *de;
-    if (de0.de_xml == NULL)
-        de0.de_xml = x0;
-    de0.de_empty = (xml_child_nr(de0.de_xml) == 0);
-    clicon_db_elmnt_set(h, db, &de0);
-    /* Write cache to file unless volatile (ie stop syncing to store) */
-    if (xmldb_volatile_get(h, db) == 0){
-        if (xmldb_write_cache2file(h, db) < 0)
-            goto done;
-        /* Clear flags from previous steps + dirty */
-        if (xml_apply(x0, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset,
-                      (void*)(XML_FLAG_NONE|XML_FLAG_ADD|XML_FLAG_DEL|XML_FLAG_CHANGE|XML_FLAG_CACHE_DIRTY)) < 0)
-            goto done;
-    }
-    else {
-        /* Clear flags from previous steps */
-        if (xml_apply(x0, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset,
-                      (void*)(XML_FLAG_NONE|XML_FLAG_ADD|XML_FLAG_DEL|XML_FLAG_CHANGE)) < 0)
+    /* Mark edited nodes for incremental commit diff (after defaults are added) */
+    if (clicon_option_bool(h, "CLICON_XMLDB_DIFF_INCREMENTAL")){
+        if (xml_apply(x0, CX_ELMNT, xml_mark_edited, NULL) < 0)
             goto done;
     }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Modify cached tree with an xml tree and an operation, and update flags and defaults
+ *
+ * @param[in]  h        Clixon handle
+ * @param[in]  x0       Top of datastore cache
+ * @param[in]  x1       xml-tree. Top-level symbol is dummy
+ * @param[in]  yspec    Top-level yang spec
+ * @param[in]  op       Top-level operation, can be superceded by other op in tree
+ * @param[in]  username User name for nacm
+ * @param[in]  xnacm    NACM XML tree
+ * @param[in]  permit   Set if NACM is passed (or not applicable)
+ * @param[out] cbret    Initialized cligen buffer. On exit contains XML if retval == 0
+ * @retval     1        OK
+ * @retval     0        Failed, cbret contains error xml message
+ * @retval    -1        Error
+ * @see xmldb_put
+ */
+static int
+xmldb_modify(clixon_handle       h,
+             cxobj              *x0,
+             cxobj              *x1,
+             yang_stmt          *yspec,
+             enum operation_type op,
+             char               *username,
+             cxobj              *xnacm,
+             int                 permit,
+             cbuf               *cbret)
+{
+    int retval = -1;
+    int ret;
+
+    clicon_data_del(h, "objectexisted");
+    /*
+     * Modify base tree x with modification x1. This is where the
+     * new tree is made.
+     */
+    if ((ret = text_modify_top(h, x0, x1, yspec, op, username, xnacm, permit, cbret)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
+    if (xmldb_modify_done(h, x0, yspec) < 0)
+        goto done;
     retval = 1;
  done:
-    clixon_debug(CLIXON_DBG_DATASTORE | CLIXON_DBG_DETAIL, "retval:%d", retval);
-    if (xerr)
-        xml_free(xerr);
-    if (nsc)
-        xml_nsctx_free(nsc);
     return retval;
  fail:
     retval = 0;
     goto done;
 }
 
-/*! Callback function for xmldb-multi write
+/*! Encode an edit as a journal entry: the modification tree and operation wrapped in an edit element
  *
- * Look for link attribute in XML, and if found open the linked file for parsing
- * @param[in]  x    XML node
- * @param[in]  arg
- * @retval     2    Locally abort this subtree, continue with others
- * @retval     1    Abort, dont continue with others, return 1 to end user
- * @retval     0    OK, continue
- * @retval    -1    Error, aborted at first error encounter, return -1 to end user
+ * Namespaces declared in ancestors of x1 are declared in the wrapper
+ * @param[in]  x1   xml-tree. Top-level symbol is dummy
+ * @param[in]  op   Top-level operation
+ * @param[out] cb   Journal entry
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see xmldb_journal_replay
  */
 static int
-xmldb_multi_write_applyfn(cxobj *x,
-                          void  *arg)
+xmldb_journal_entry(cxobj              *x1,
+                    enum operation_type op,
+                    cbuf               *cb)
 {
-    struct xmldb_multi_write_arg *mw = (struct xmldb_multi_write_arg *) arg;
-    int           retval = -1;
-    clixon_handle h = mw->mw_h;
-    yang_stmt    *y;
-    int           exist = 0;
-    char         *xpath = NULL;
-    char         *hexstr = NULL;
-    cbuf         *cb = NULL;
-    char         *subdir = NULL;
-    char         *dbfile;
-    struct stat   st = {0,};
-    int           fd = -1;
-    FILE         *fsub = NULL;
+    int   retval = -1;
+    cvec *nsc = NULL;
 
-    if (xml_child_nr_type(x, CX_ELMNT) > 0 &&
-        (y = xml_spec(x)) != NULL){
-        if (yang_extension_value(y, "xmldb-split", CLIXON_LIB_NS, &exist, NULL) < 0)
-            goto done;
-        if (exist){
-            if (xml2xpath(x, NULL, 1, 0, &xpath) < 0)
-                goto done;
-            if (clixon_digest_hex(xpath, &hexstr) < 0)
-                goto done;
-            if (xmldb_db2subdir(h, mw->mw_db, &subdir) < 0)
-                goto done;
-            if ((cb = cbuf_new()) == NULL){
-                clixon_err(OE_XML, errno, "cbuf_new");
-                goto done;
-            }
-            cprintf(cb, "%s/%s.xml", subdir, hexstr);
-            dbfile = cbuf_get(cb);
+    if (xml_nsctx_node(x1, &nsc) < 0)
+        goto done;
+    cprintf(cb, "<edit");
+    if (xml_nsctx_cbuf(cb, nsc) < 0)
+        goto done;
+    cprintf(cb, " operation=\"%s\">", xml_operation2str(op));
+    if (clixon_xml2cbuf(cb, x1, 0, 0, NULL, -1, 0) < 0)
+        goto done;
+    cprintf(cb, "</edit>");
+    retval = 0;
+ done:
+    if (nsc)
+        xml_nsctx_free(nsc);
+    return retval;
+}
+
+/*! Append entry to journal file of datastore
+ *
+ * Each entry is prefixed with its length so that a truncated last entry can be detected.
+ * The entry is flushed to the OS, so it survives a crash of the backend. It only survives
+ * a crash of the OS or a power loss if CLICON_XMLDB_JOURNAL_SYNC is set and the entry is
+ * synced to disk before returning.
+ * @param[in]  h    Clixon handle
+ * @param[in]  db   Symbolic database name
+ * @param[in]  cb   Journal entry
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+xmldb_journal_append(clixon_handle h,
+                     const char   *db,
+                     cbuf         *cb)
+{
+    int   retval = -1;
+    char *filename = NULL;
+    FILE *f = NULL;
+
+    if (xmldb_db2journal(h, db, &filename) < 0)
+        goto done;
+    if ((f = fopen(filename, "a")) == NULL){
+        clixon_err(OE_UNIX, errno, "fopen(%s)", filename);
+        goto done;
+    }
+    if (fprintf(f, "%zu\n", cbuf_len(cb)) < 0 ||
+        fwrite(cbuf_get(cb), 1, cbuf_len(cb), f) != cbuf_len(cb) ||
+        fflush(f) != 0){
+        clixon_err(OE_UNIX, errno, "write(%s)", filename);
+        goto done;
+    }
+    if (clicon_option_bool(h, "CLICON_XMLDB_JOURNAL_SYNC") &&
+        fsync(fileno(f)) < 0){
+        clixon_err(OE_UNIX, errno, "fsync(%s)", filename);
+        goto done;
+    }
+    retval = 0;
+ done:
+    if (f)
+        fclose(f);
+    if (filename)
+        free(filename);
+    return retval;
+}
+
+/*! Replay journal entries of datastore on a tree read from snapshot file
+ *
+ * Entries that cannot be applied are logged and skipped. This may occur if a crash
+ * happened after a snapshot was written but before the journal was removed.
+ * A truncated last entry, eg due to a crash while appending, is ignored.
+ * @param[in]  h      Clixon handle
+ * @param[in]  db     Symbolic database name
+ * @param[in]  yb     How yang is bound to xt
+ * @param[in]  yspec  Top-level yang spec
+ * @param[in]  xt     XML tree read from snapshot file, top-level is "config"
+ * @param[out] de     If set, number of entries replayed is set in de_journal
+ * @param[out] xerr   XML error
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @note If yb is YB_NONE, xt is bound to yang since text_modify requires it
+ * @see CLICON_XMLDB_JOURNAL
+ */
+int
+xmldb_journal_replay(clixon_handle h,
+                     const char   *db,
+                     yang_bind     yb,
+                     yang_stmt    *yspec,
+                     cxobj        *xt,
+                     db_elmnt     *de,
+                     cxobj       **xerr)
+{
+    int                 retval = -1;
+    char               *filename = NULL;
+    FILE               *f = NULL;
+    char               *buf = NULL;
+    size_t              len;
+    cxobj              *xe = NULL;
+    cxobj              *xedit;
+    cxobj              *x1;
+    char               *opstr;
+    enum operation_type op;
+    cbuf               *cbret = NULL;
+    int                 nr = 0;
+    int                 ret;
+
+    if (xmldb_db2journal(h, db, &filename) < 0)
+        goto done;
+    if ((f = fopen(filename, "r")) == NULL){
+        if (errno == ENOENT)
+            goto ok;
+        clixon_err(OE_UNIX, errno, "fopen(%s)", filename);
+        goto done;
+    }
+    if (yb == YB_NONE){
+        if ((ret = xml_bind_yang(h, xt, YB_MODULE, yspec, xerr)) < 0)
+            goto done;
+        if (xml_sort_recurse(xt) < 0)
+            goto done;
+    }
+    if ((cbret = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    clixon_debug(CLIXON_DBG_DATASTORE, "Replaying journal %s", filename);
+    while (fscanf(f, "%zu\n", &len) == 1){
+        if ((buf = malloc(len + 1)) == NULL){
+            clixon_err(OE_UNIX, errno, "malloc");
+            goto done;
+        }
+        if (fread(buf, 1, len, f) != len){
+            clixon_log(h, LOG_WARNING, "%s: truncated journal entry %d in %s, ignored",
+                       __func__, nr, filename);
+            break;
+        }
+        buf[len] = '\0';
+        nr++;
+        if (clixon_xml_parse_string(buf, YB_NONE, NULL, &xe, NULL) < 0)
+            goto done;
+        free(buf);
+        buf = NULL;
+        if ((xedit = xml_find_type(xe, NULL, "edit", CX_ELMNT)) != NULL &&
+            (x1 = xml_find_type(xedit, NULL, NETCONF_INPUT_CONFIG, CX_ELMNT)) != NULL &&
+            (opstr = xml_find_type_value(xedit, NULL, "operation", CX_ATTR)) != NULL &&
+            xml_operation(opstr, &op) == 0 &&
+            (ret = xml_bind_yang(h, x1, YB_MODULE, yspec, NULL)) == 1){
+            cbuf_reset(cbret);
+            if ((ret = xmldb_modify(h, xt, x1, yspec, op, NULL, NULL, 1, cbret)) < 0)
+                goto done;
+            if (xml_apply(xt, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset,
+                          (void*)(XML_FLAG_NONE|XML_FLAG_ADD|XML_FLAG_DEL|XML_FLAG_CHANGE|XML_FLAG_CACHE_DIRTY)) < 0)
+                goto done;
+        }
+        else
+            ret = 0;
+        if (ret == 0)
+            clixon_log(h, LOG_WARNING, "%s: journal entry %d in %s not applied, skipped",
+                       __func__, nr, filename);
+        xml_free(xe);
+        xe = NULL;
+    }
+    if (de)
+        de->de_journal = nr;
+ ok:
+    retval = 0;
+ done:
+    if (cbret)
+        cbuf_free(cbret);
+    if (xe)
+        xml_free(xe);
+    if (buf)
+        free(buf);
+    if (f)
+        fclose(f);
+    if (filename)
+        free(filename);
+    return retval;
+}
+
+/*! Modify an XML tree that is not a datastore cache with an xml tree and an operation
+ *
+ * As xmldb_modify but without NACM, defaults and edit marks, eg for trees of state data
+ * @param[in]  h        Clixon handle
+ * @param[in]  x0       Top of tree, named DATASTORE_TOP_SYMBOL
+ * @param[in]  x1       xml-tree bound to yang, top-level symbol is dummy
+ * @param[in]  op       Top-level operation, can be superceded by other op in tree
+ * @param[out] cbret    Initialized cligen buffer. On exit contains XML if retval == 0
+ * @retval     1        OK
+ * @retval     0        Failed, cbret contains error xml message
+ * @retval    -1        Error
+ * @see xmldb_put
+ */
+int
+xmldb_modify_tree(clixon_handle       h,
+                  cxobj              *x0,
+                  cxobj              *x1,
+                  enum operation_type op,
+                  cbuf               *cbret)
+{
+    int        retval = -1;
+    yang_stmt *yspec;
+    int        ret;
+
+    if ((yspec = clicon_dbspec_yang(h)) == NULL){
+        clixon_err(OE_YANG, ENOENT, "No yang spec");
+        goto done;
+    }
+    clicon_data_del(h, "objectexisted");
+    if ((ret = text_modify_top(h, x0, x1, yspec, op, NULL, NULL, 1, cbret)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
+    if (xml_tree_prune_flagged_sub(x0, XML_FLAG_NONE, 0, NULL) <0)
+        goto done;
+    if (xml_default_nopresence(x0, 3, XML_FLAG_ADD|XML_FLAG_DEL) < 0)
+        goto done;
+    if (xml_apply(x0, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset,
+                  (void*)(XML_FLAG_NONE|XML_FLAG_ADD|XML_FLAG_DEL|XML_FLAG_CHANGE)) < 0)
+        goto done;
+    retval = 1;
+ done:
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Write back modified cache and sync it to file unless volatile
+ *
+ * @param[in]  h      Clixon handle
+ * @param[in]  db     Datastore name
+ * @param[in]  de     Datastore element, or NULL if first time
+ * @param[in]  de0    Datastore element read from file if de is NULL
+ * @param[in]  x0     Modified cache
+ * @param[in]  cbj    Journal entry, or NULL to write a snapshot
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see xmldb_put
+ */
+static int
+xmldb_put_cache(clixon_handle h,
+                const char   *db,
+                db_elmnt     *de,
+                db_elmnt     *de0,
+                cxobj        *x0,
+                cbuf         *cbj)
+{
+    int      retval = -1;
+    db_elmnt de1;
+
+    /* Write back to datastore cache if first time */
+    de1 = de ? *de : *de0;
+    if (de1.de_xml == NULL)
+        de1.de_xml = x0;
+    de1.de_empty = (xml_child_nr(de1.de_xml) == 0);
+    de1.de_epoch++;
+    clicon_db_elmnt_set(h, db, &de1);
+    /* Other datastores can no longer rely on edit marks relative to running */
+    if (strcmp(db, "running") == 0 &&
+        xmldb_edited_invalidate(h, db) < 0)
+        goto done;
+    /* Write cache to file unless volatile (ie stop syncing to store) */
+    if (xmldb_volatile_get(h, db) == 0){
+        /* Append to journal, or write snapshot if journal is full */
+        if (cbj != NULL){
+            if (xmldb_journal_append(h, db, cbj) < 0)
+                goto done;
+            if ((de = clicon_db_elmnt_get(h, db)) != NULL)
+                de->de_journal++;
+        }
+        else if (xmldb_write_cache2file(h, db) < 0)
+            goto done;
+        /* Clear flags from previous steps + dirty */
+        if (xml_apply(x0, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset,
+                      (void*)(XML_FLAG_NONE|XML_FLAG_ADD|XML_FLAG_DEL|XML_FLAG_CHANGE|XML_FLAG_CACHE_DIRTY)) < 0)
+            goto done;
+    }
+    else {
+        /* Clear flags from previous steps */
+        if (xml_apply(x0, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset,
+                      (void*)(XML_FLAG_NONE|XML_FLAG_ADD|XML_FLAG_DEL|XML_FLAG_CHANGE)) < 0)
+            goto done;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Modify database given an xml tree and an operation
+ *
+ * @param[in]  h      CLICON handle
+ * @param[in]  db     running or candidate
+ * @param[in]  op     Top-level operation, can be superceded by other op in tree
+ * @param[in]  x1     xml-tree. Top-level symbol is dummy
+ * @param[in]  username User name for nacm
+ * @param[out] cbret  Initialized cligen buffer. On exit contains XML if retval == 0
+ * @retval     1      OK
+ * @retval     0      Failed, cbret contains error xml message
+ * @retval    -1      Error
+ * The xml may contain the "operation" attribute which defines the operation.
+ * @code
+ *   cxobj     *xt;
+ *   cxobj     *xret = NULL;
+ *   if (clixon_xml_parse_string("<a>17</a>", YB_NONE, NULL, &xt, NULL) < 0)
+ *     err;
+ *   if ((ret = xmldb_put(h, "running", OP_MERGE, xt, username, cbret)) < 0)
+ *     err;
+ *   if (ret==0)
+ *     cbret contains netconf error message
+ * @endcode
+ * @note if xret is non-null, it may contain error message
+ * @note x1 may change as a side-effect (eg operation attributes are stripped)
+ */
+int
+xmldb_put(clixon_handle       h,
+          const char         *db,
+          enum operation_type op,
+          cxobj              *x1,
+          char               *username,
+          cbuf               *cbret)
+{
+    int         retval = -1;
+    yang_stmt  *yspec;
+    cxobj      *x0 = NULL;
+    db_elmnt   *de = NULL;
+    db_elmnt    de0 = {0,};
+    int         ret;
+    cxobj      *xnacm = NULL;
+    int         permit = 0; /* nacm permit all */
+    int         firsttime = 0;
+    cxobj      *xerr = NULL;
+    cbuf       *cbj = NULL; /* journal entry */
+    int         memtag;
+
+    clixon_debug(CLIXON_DBG_DATASTORE|CLIXON_DBG_DETAIL, "db %s", db);
+    memtag = clixon_mem_tag_set(clixon_mem_tag("datastore %s", db));
+    if (cbret == NULL){
+        clixon_err(OE_XML, EINVAL, "cbret is NULL");
+        goto done;
+    }
+    if ((yspec = clicon_dbspec_yang(h)) == NULL){
+        clixon_err(OE_YANG, ENOENT, "No yang spec");
+        goto done;
+    }
+    if (x1 && strcmp(xml_name(x1), NETCONF_INPUT_CONFIG) != 0){
+        clixon_err(OE_XML, 0, "Top-level symbol of modification tree is %s, expected \"%s\"",
+                   xml_name(x1), NETCONF_INPUT_CONFIG);
+        goto done;
+    }
+    /* Cache may be shared with another datastore, see CLICON_XMLDB_COPY_ON_WRITE */
+    if (xmldb_cache_unshare(h, db) < 0)
+        goto done;
+    if ((de = clicon_db_elmnt_get(h, db)) != NULL){
+        x0 = de->de_xml; /* XXX flag is not XML_FLAG_TOP */
+    }
+    /* If there is no xml x0 tree (in cache), then read it from file */
+    if (x0 == NULL){
+        firsttime++; /* to avoid leakage on error, see fail from text_modify */
+        /* xml looks like: <top><config><x>... where "x" is a top-level symbol in a module */
+        if ((ret = xmldb_readfile(h, db, YB_MODULE, yspec, &x0, de?de:&de0, NULL, &xerr)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+    }
+    if (strcmp(xml_name(x0), DATASTORE_TOP_SYMBOL) !=0 ||
+        xml_flag(x0, XML_FLAG_TOP) == 0){
+        clixon_err(OE_XML, 0, "Top-level symbol is %s, expected \"%s\"",
+                   xml_name(x0), DATASTORE_TOP_SYMBOL);
+        goto done;
+    }
+    /* Here x0 looks like: <config>...</config> */
+    xnacm = clicon_nacm_cache(h);
+    permit = (xnacm==NULL);
+    /* Encode journal entry before x1 is changed as a side-effect of modify */
+    if (xmldb_volatile_get(h, db) == 0 &&
+        clicon_option_bool(h, "CLICON_XMLDB_JOURNAL") &&
+        !clicon_option_bool(h, "CLICON_XMLDB_MULTI") &&
+        (de ? de->de_journal : de0.de_journal) < clicon_option_int(h, "CLICON_XMLDB_JOURNAL_COMPACT")){
+        if ((cbj = cbuf_new()) == NULL){
+            clixon_err(OE_XML, errno, "cbuf_new");
+            goto done;
+        }
+        if (xmldb_journal_entry(x1, op, cbj) < 0)
+            goto done;
+    }
+    /* Here assume if xnacm is set and !permit do NACM */
+    if ((ret = xmldb_modify(h, x0, x1, yspec, op, username, xnacm, permit, cbret)) < 0)
+        goto done;
+    /* If xml return - ie netconf error xml tree, then stop and return OK */
+    if (ret == 0){
+        /* If first time and quit here, x0 is not written back into cache and leaks */
+        if (firsttime && x0){
+            xml_free(x0);
+            x0 = NULL;
+        }
+        goto fail;
+    }
+    if (xmldb_put_cache(h, db, de, &de0, x0, cbj) < 0)
+        goto done;
+    retval = 1;
+ done:
+    clixon_debug(CLIXON_DBG_DATASTORE | CLIXON_DBG_DETAIL, "retval:%d", retval);
+    clixon_mem_tag_set(memtag);
+    if (cbj)
+        cbuf_free(cbj);
+    if (xerr)
+        xml_free(xerr);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Entry callback argument of streaming put
+ *
+ * @see xmldb_put_stream
+ */
+typedef struct {
+    clixon_handle       ps_h;
+    cxobj              *ps_x0;       /* Top of datastore cache */
+    yang_stmt          *ps_yspec;
+    enum operation_type ps_op;
+    char               *ps_username;
+    cxobj              *ps_xnacm;
+    int                 ps_permit;
+    cbuf               *ps_cbret;
+} xmldb_put_stream_t;
+
+/*! Streaming put entry callback: modify the cache with one list entry and free it
+ *
+ * The entry is applied together with its ancestors up to the <config> wrapper. Leafs of the
+ * ancestors are applied again with every entry, which is idempotent with merge.
+ * @see clixon_xml_entry_cb
+ */
+static int
+xmldb_put_stream_entry(cxobj *x,
+                       void  *arg)
+{
+    xmldb_put_stream_t *ps = (xmldb_put_stream_t *)arg;
+    cxobj              *x1;
+    int                 ret;
+
+    x1 = x;
+    while (xml_parent(xml_parent(x1)) != NULL)
+        x1 = xml_parent(x1);
+    /* Ensure edit-config "config" statement */
+    if (strcmp(xml_name(x1), NETCONF_INPUT_CONFIG) != 0 &&
+        xml_name_set(x1, NETCONF_INPUT_CONFIG) < 0)
+        return -1;
+    if ((ret = text_modify_top(ps->ps_h, ps->ps_x0, x1, ps->ps_yspec, ps->ps_op,
+                               ps->ps_username, ps->ps_xnacm, ps->ps_permit, ps->ps_cbret)) < 0)
+        return -1;
+    if (ret == 0)
+        return 0;
+    return 2;
+}
+
+/*! Modify database given an XML file, consuming it entry by entry
+ *
+ * Same as xmldb_put with a <config> tree parsed from fp, but the file is parsed as a stream and
+ * each top-most list entry is merged into the datastore cache and freed as soon as it is parsed,
+ * so that a large file is imported without holding it as a parse tree.
+ * Flags and defaults are updated and the datastore is written to file once at the end.
+ * @param[in]  h        Clixon handle
+ * @param[in]  db       Datastore name
+ * @param[in]  op       Top-level operation, only merge
+ * @param[in]  fp       File containing an XML tree with a wrapper, eg <config>
+ * @param[in]  username User name for nacm
+ * @param[out] cbret    Initialized cligen buffer. On exit contains XML if retval == 0
+ * @retval     1        OK
+ * @retval     0        Failed, cbret contains error xml message
+ * @retval    -1        Error
+ * @note Entries applied before a failure remain in the cache, as with a failed edit-config
+ * @note The journal is not used, the datastore file is written as a snapshot
+ * @see xmldb_put
+ * @see clixon_xml_parse_file_stream
+ */
+int
+xmldb_put_stream(clixon_handle       h,
+                 const char         *db,
+                 enum operation_type op,
+                 FILE               *fp,
+                 char               *username,
+                 cbuf               *cbret)
+{
+    int                retval = -1;
+    yang_stmt         *yspec;
+    cxobj             *x0 = NULL;
+    cxobj             *x1t = NULL;
+    cxobj             *x1;
+    db_elmnt          *de = NULL;
+    db_elmnt           de0 = {0,};
+    int                ret;
+    int                firsttime = 0;
+    cxobj             *xerr = NULL;
+    xmldb_put_stream_t ps = {0,};
+
+    clixon_debug(CLIXON_DBG_DATASTORE|CLIXON_DBG_DETAIL, "db %s", db);
+    if (cbret == NULL){
+        clixon_err(OE_XML, EINVAL, "cbret is NULL");
+        goto done;
+    }
+    if (op != OP_MERGE){
+        clixon_err(OE_XML, EINVAL, "Streaming put only supports merge");
+        goto done;
+    }
+    if ((yspec = clicon_dbspec_yang(h)) == NULL){
+        clixon_err(OE_YANG, ENOENT, "No yang spec");
+        goto done;
+    }
+    if (xmldb_cache_unshare(h, db) < 0)
+        goto done;
+    if ((de = clicon_db_elmnt_get(h, db)) != NULL)
+        x0 = de->de_xml;
+    if (x0 == NULL){
+        firsttime++;
+        if ((ret = xmldb_readfile(h, db, YB_MODULE, yspec, &x0, de?de:&de0, NULL, &xerr)) < 0)
+            goto done;
+        if (ret == 0){
+            if (clixon_xml2cbuf(cbret, xerr, 0, 0, NULL, -1, 0) < 0)
+                goto done;
+            goto fail;
+        }
+    }
+    ps.ps_h = h;
+    ps.ps_x0 = x0;
+    ps.ps_yspec = yspec;
+    ps.ps_op = op;
+    ps.ps_username = username;
+    ps.ps_xnacm = clicon_nacm_cache(h);
+    ps.ps_permit = (ps.ps_xnacm == NULL);
+    clicon_data_del(h, "objectexisted");
+    if ((ret = clixon_xml_parse_file_stream(fp, yspec, 0, xmldb_put_stream_entry, &ps,
+                                            &x1t, &xerr)) < 0)
+        goto done;
+    if (ret == 0){
+        if (xerr && clixon_xml2cbuf(cbret, xerr, 0, 0, NULL, -1, 0) < 0)
+            goto done;
+        goto fail;
+    }
+    /* Remaining tree without list entries */
+    if ((x1 = xml_child_i_type(x1t, 0, CX_ELMNT)) != NULL){
+        if (xml_name_set(x1, NETCONF_INPUT_CONFIG) < 0)
+            goto done;
+        if ((ret = text_modify_top(h, x0, x1, yspec, op, username,
+                                   ps.ps_xnacm, ps.ps_permit, cbret)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+    }
+    if (xmldb_modify_done(h, x0, yspec) < 0)
+        goto done;
+    if (xmldb_put_cache(h, db, de, &de0, x0, NULL) < 0)
+        goto done;
+    retval = 1;
+ done:
+    clixon_debug(CLIXON_DBG_DATASTORE | CLIXON_DBG_DETAIL, "retval:%d", retval);
+    if (x1t)
+        xml_free(x1t);
+    if (xerr)
+        xml_free(xerr);
+    return retval;
+ fail:
+    /* If first time, entries may have been applied to x0 which is not in the cache */
+    if (firsttime && x0){
+        xml_free(x0);
+        x0 = NULL;
+    }
+    retval = 0;
+    goto done;
+}
+
+/*! Write sub-tree of xmldb-multi split node to its sub-file
+ *
+ * @param[in]  mw      Multi write argument
+ * @param[in]  x       XML split node
+ * @param[in]  dbfile  Sub-file name
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+xmldb_multi_write_file(struct xmldb_multi_write_arg *mw,
+                       cxobj                        *x,
+                       const char                   *dbfile)
+{
+    int                retval = -1;
+    int                fd = -1;
+    FILE              *fsub = NULL;
+    FILE              *fz = NULL;
+    enum compress_mode compress;
+
+    clixon_debug(CLIXON_DBG_DATASTORE, "Open: %s for writing", dbfile);
+    if ((fd = open(dbfile, O_CREAT|O_WRONLY|O_TRUNC, S_IRWXU)) < 0) {
+        clixon_err(OE_UNIX, errno, "open(%s)", dbfile);
+        goto done;
+    }
+    if ((fsub = fdopen(fd, "w")) == NULL){
+        clixon_err(OE_CFG, errno, "fdopen(%s)", dbfile);
+        close(fd);
+        goto done;
+    }
+    if ((compress = clicon_xmldb_compress(mw->mw_h)) != COMPRESS_NONE &&
+        (fz = clixon_compress_open(fsub, compress, clicon_option_int(mw->mw_h, "CLICON_XMLDB_COMPRESS_LEVEL"))) == NULL)
+        goto done;
+    /* Dont recurse multi-file yet */
+    if (clixon_xml2file1(fz ? fz : fsub, x, 0, mw->mw_pretty, NULL, fprintf, 1, 0, mw->mw_wdef, 0) < 0)
+        goto done;
+    if (fz){
+        if (fclose(fz) != 0){
+            fz = NULL;
+            clixon_err(OE_UNIX, errno, "compress(%s)", dbfile);
+            goto done;
+        }
+        fz = NULL;
+    }
+    retval = 0;
+ done:
+    if (fz)
+        fclose(fz);
+    if (fsub != NULL)
+        fclose(fsub);
+    return retval;
+}
+
+/*! Write collected xmldb-multi sub-files in parallel using forked worker processes
+ *
+ * Worker k writes every mw_workers:th sub-file starting at k. Workers inherit a
+ * copy-on-write image of the tree. Returns when all workers are done.
+ * @param[in]  mw   Multi write argument with collected sub-files
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+xmldb_multi_write_parallel(struct xmldb_multi_write_arg *mw)
+{
+    int    retval = -1;
+    int    nworkers;
+    pid_t *pids = NULL;
+    int    k;
+    int    i;
+    int    status;
+    int    failed = 0;
+
+    if ((nworkers = mw->mw_workers) > mw->mw_len)
+        nworkers = mw->mw_len;
+    if (nworkers <= 1){
+        for (i = 0; i < mw->mw_len; i++)
+            if (xmldb_multi_write_file(mw, mw->mw_xvec[i], mw->mw_files[i]) < 0)
+                goto done;
+        goto ok;
+    }
+    if ((pids = calloc(nworkers, sizeof(pid_t))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    for (k = 0; k < nworkers; k++){
+        if ((pids[k] = fork()) < 0){
+            clixon_err(OE_UNIX, errno, "fork");
+            failed++;
+            break;
+        }
+        if (pids[k] == 0){ /* Worker */
+            for (i = k; i < mw->mw_len; i += nworkers)
+                if (xmldb_multi_write_file(mw, mw->mw_xvec[i], mw->mw_files[i]) < 0)
+                    _exit(1);
+            _exit(0);
+        }
+    }
+    /* Wait for all started workers also on error */
+    for (k = 0; k < nworkers && pids[k] > 0; k++){
+        if (waitpid(pids[k], &status, 0) < 0 ||
+            !WIFEXITED(status) || WEXITSTATUS(status) != 0){
+            if (!failed)
+                clixon_err(OE_DB, 0, "xmldb-multi write worker %d failed", pids[k]);
+            failed++;
+        }
+    }
+    if (failed)
+        goto done;
+ ok:
+    retval = 0;
+ done:
+    if (pids)
+        free(pids);
+    return retval;
+}
+
+/*! Callback function for xmldb-multi write
+ *
+ * Look for link attribute in XML, and if found open the linked file for parsing
+ * @param[in]  x    XML node
+ * @param[in]  arg
+ * @retval     2    Locally abort this subtree, continue with others
+ * @retval     1    Abort, dont continue with others, return 1 to end user
+ * @retval     0    OK, continue
+ * @retval    -1    Error, aborted at first error encounter, return -1 to end user
+ */
+static int
+xmldb_multi_write_applyfn(cxobj *x,
+                          void  *arg)
+{
+    struct xmldb_multi_write_arg *mw = (struct xmldb_multi_write_arg *) arg;
+    int           retval = -1;
+    clixon_handle h = mw->mw_h;
+    yang_stmt    *y;
+    int           exist = 0;
+    char         *xpath = NULL;
+    char         *hexstr = NULL;
+    cbuf         *cb = NULL;
+    char         *subdir = NULL;
+    char         *dbfile;
+    struct stat   st = {0,};
+
+    /* Not loaded, sub-file is unchanged */
+    if (xml_flag(x, XML_FLAG_LAZY))
+        return 2;
+    if (xml_child_nr_type(x, CX_ELMNT) > 0 &&
+        (y = xml_spec(x)) != NULL){
+        if (yang_extension_value(y, "xmldb-split", CLIXON_LIB_NS, &exist, NULL) < 0)
+            goto done;
+        if (exist){
+            if (xml2xpath(x, NULL, 1, 0, &xpath) < 0)
+                goto done;
+            if (clixon_digest_hex(xpath, &hexstr) < 0)
+                goto done;
+            if (xmldb_db2subdir(h, mw->mw_db, &subdir) < 0)
+                goto done;
+            if ((cb = cbuf_new()) == NULL){
+                clixon_err(OE_XML, errno, "cbuf_new");
+                goto done;
+            }
+            cprintf(cb, "%s/%s.xml", subdir, hexstr);
+            dbfile = cbuf_get(cb);
             if (xml_flag(x, XML_FLAG_CACHE_DIRTY) ||
                 lstat(dbfile, &st) < 0){
-                clixon_debug(CLIXON_DBG_DATASTORE, "Open: %s for writing", dbfile);
-                if ((fd = open(dbfile, O_CREAT|O_WRONLY|O_TRUNC, S_IRWXU)) < 0) {
-                    clixon_err(OE_UNIX, errno, "open(%s)", dbfile);
-                    goto done;
-                }
-                if ((fsub = fdopen(fd, "w")) == NULL){
-                    clixon_err(OE_CFG, errno, "fdopen(%s)", dbfile);
-                    goto done;
+                if (mw->mw_workers > 1){
+                    /* Collect and write later, see xmldb_multi_write_parallel */
+                    if ((mw->mw_xvec = realloc(mw->mw_xvec, (mw->mw_len+1)*sizeof(cxobj*))) == NULL ||
+                        (mw->mw_files = realloc(mw->mw_files, (mw->mw_len+1)*sizeof(char*))) == NULL){
+                        clixon_err(OE_UNIX, errno, "realloc");
+                        goto done;
+                    }
+                    mw->mw_xvec[mw->mw_len] = x;
+                    if ((mw->mw_files[mw->mw_len] = strdup(dbfile)) == NULL){
+                        clixon_err(OE_UNIX, errno, "strdup");
+                        goto done;
+                    }
+                    mw->mw_len++;
                 }
-                /* Dont recurse multi-file yet */
-                if (clixon_xml2file1(fsub, x, 0, mw->mw_pretty, NULL, fprintf, 1, 0, mw->mw_wdef, 0) < 0)
+                else if (xmldb_multi_write_file(mw, x, dbfile) < 0)
                     goto done;
             }
             retval = 2; /* Locally abort */
@@ -1521,8 +2209,6 @@ xmldb_multi_write_applyfn(cxobj *x,
     }
     retval = 0;
  done:
-    if (fsub != NULL)
-        fclose(fsub);
     if (cb)
         cbuf_free(cb);
     if (subdir)
@@ -1546,6 +2232,7 @@ xmldb_multi_write_applyfn(cxobj *x,
  * @param[in]  multidb  Database name (only if multi)
  * @retval     0        OK
  * @retval    -1        Error
+ * @note Binary format ignores pretty and wdef, all nodes are written
  */
 int
 xmldb_dump(clixon_handle     h,
@@ -1561,6 +2248,7 @@ xmldb_dump(clixon_handle     h,
     struct xmldb_multi_write_arg mw = {0,};
     cxobj                       *xm;
     cxobj                       *xmodst = NULL;
+    int                          i;
 
     /* Add modstate */
     if ((xm = clicon_modst_cache_get(h, 1)) != NULL){
@@ -1587,8 +2275,11 @@ xmldb_dump(clixon_handle     h,
             mw.mw_pretty = pretty;
             mw.mw_wdef = wdef;
             mw.mw_format = format;
+            mw.mw_workers = clicon_option_int(h, "CLICON_XMLDB_MULTI_WORKERS");
             if (xml_apply(xt, CX_ELMNT, (xml_applyfn_t*)xmldb_multi_write_applyfn, &mw) < 0)
                 goto done;
+            if (mw.mw_len && xmldb_multi_write_parallel(&mw) < 0)
+                goto done;
         }
         break;
     case FORMAT_JSON:
@@ -1599,6 +2290,14 @@ xmldb_dump(clixon_handle     h,
         if (clixon_json2file(f, xt, pretty, fprintf, 0, 0) < 0)
             goto done;
         break;
+    case FORMAT_BINARY:
+        if (multi){
+            clixon_err(OE_CFG, errno, "BINARY+multi not supported");
+            goto done;
+        }
+        if (clixon_xml2binary_file(f, xt, clicon_dbspec_yang(h)) < 0)
+            goto done;
+        break;
     default:
         clixon_err(OE_XML, 0, "Format %s not supported", format_int2str(format));
         goto done;
@@ -1609,35 +2308,47 @@ xmldb_dump(clixon_handle     h,
         goto done;
     retval = 0;
  done:
+    if (mw.mw_files){
+        for (i = 0; i < mw.mw_len; i++)
+            free(mw.mw_files[i]);
+        free(mw.mw_files);
+    }
+    if (mw.mw_xvec)
+        free(mw.mw_xvec);
     return retval;
 }
 
-/*! Given datastore, get cache and format, set wdef, add modstate and print to multiple files
+/*! Write XML tree to file using datastore format options
  *
- * Also add mod-state if applicable
- * @param[in]  h   Clixon handle
- * @param[in]  db  Name of database to search in (filename including dir path
- * @retval     0   OK
- * @retval    -1   Error
+ * @param[in]  h        Clixon handle
+ * @param[in]  db       Symbolic database name
+ * @param[in]  xt       Top of XML tree
+ * @param[in]  filename File to write to, or NULL to write to a malloced buffer
+ * @param[in]  dosync   If set, fsync file before closing
+ * @param[out] bufp     Malloced buffer if filename is NULL, free with free()
+ * @param[out] lenp     Length of buffer if filename is NULL
+ * @retval     0        OK
+ * @retval    -1        Error
  */
-int
-xmldb_write_cache2file(clixon_handle h,
-                       const char   *db)
+static int
+xmldb_write_file(clixon_handle h,
+                 const char   *db,
+                 cxobj        *xt,
+                 const char   *filename,
+                 int           dosync,
+                 char        **bufp,
+                 size_t       *lenp)
 {
     int               retval = -1;
-    cxobj            *xt;
     char             *formatstr;
     enum format_enum  format = FORMAT_XML;
     withdefaults_type wdef = WITHDEFAULTS_EXPLICIT;
     int               pretty;
     int               multi;
     FILE             *f = NULL;
-    char             *dbfile = NULL;
+    FILE             *fz = NULL;
+    enum compress_mode compress;
 
-    if ((xt = xmldb_cache_get(h, db)) == NULL){
-        clixon_err(OE_XML, 0, "XML cache not found");
-        goto done;
-    }
     pretty = clicon_option_bool(h, "CLICON_XMLDB_PRETTY");
     multi = clicon_option_bool(h, "CLICON_XMLDB_MULTI");
     if ((formatstr = clicon_option_str(h, "CLICON_XMLDB_FORMAT")) != NULL){
@@ -1646,19 +2357,434 @@ xmldb_write_cache2file(clixon_handle h,
             goto done;
         }
     }
+    if (filename == NULL)
+        f = open_memstream(bufp, lenp);
+    else
+        f = fopen(filename, "w");
+    if (f == NULL){
+        clixon_err(OE_CFG, errno, "fopen(%s)", filename ? filename : "memory");
+        goto done;
+    }
+    if ((compress = clicon_xmldb_compress(h)) != COMPRESS_NONE &&
+        (fz = clixon_compress_open(f, compress, clicon_option_int(h, "CLICON_XMLDB_COMPRESS_LEVEL"))) == NULL)
+        goto done;
+    if (xmldb_dump(h, fz ? fz : f, xt, format, pretty, wdef, multi, db) < 0)
+        goto done;
+    /* Write end of compressed file */
+    if (fz){
+        if (fclose(fz) != 0){
+            fz = NULL;
+            clixon_err(OE_UNIX, errno, "compress(%s)", filename ? filename : "memory");
+            goto done;
+        }
+        fz = NULL;
+    }
+    if (filename && dosync && (fflush(f) != 0 || fsync(fileno(f)) < 0)){
+        clixon_err(OE_UNIX, errno, "fsync(%s)", filename);
+        goto done;
+    }
+    if (fclose(f) != 0){
+        f = NULL;
+        clixon_err(OE_CFG, errno, "fclose(%s)", filename ? filename : "memory");
+        goto done;
+    }
+    f = NULL;
+    retval = 0;
+ done:
+    if (fz)
+        fclose(fz);
+    if (f)
+        fclose(f);
+    if (retval < 0 && filename == NULL && *bufp){
+        free(*bufp);
+        *bufp = NULL;
+    }
+    return retval;
+}
+
+/*! Check if datastore files are read and written with io_uring
+ *
+ * @param[in]  h   Clixon handle
+ * @retval     1   io_uring
+ * @retval     0   Not built with liburing, or not enabled
+ * @see CLICON_XMLDB_IO_URING
+ */
+int
+xmldb_uring(clixon_handle h)
+{
+#ifdef HAVE_LIBURING
+    return clicon_option_bool(h, "CLICON_XMLDB_IO_URING");
+#else
+    return 0;
+#endif
+}
+
+/*! Check if datastore files are written in the background
+ *
+ * @param[in]  h   Clixon handle
+ * @retval     1   Background flush
+ * @retval     0   Synchronous write
+ * @see CLICON_XMLDB_FLUSH_ASYNC
+ * @see CLICON_XMLDB_IO_URING
+ */
+int
+xmldb_flush_async(clixon_handle h)
+{
+    return (clicon_option_bool(h, "CLICON_XMLDB_FLUSH_ASYNC") || xmldb_uring(h)) &&
+        !clicon_option_bool(h, "CLICON_XMLDB_MULTI") &&
+        !clicon_option_bool(h, "CLICON_XMLDB_JOURNAL");
+}
+
+/* Argument of io_uring flush callback */
+struct xmldb_uring_arg {
+    clixon_handle ua_h;
+    char         *ua_db;
+};
+
+static int xmldb_flush_uring(clixon_handle h, const char *db, db_elmnt *de);
+
+/*! Callback when io_uring write of datastore file is done, start new write if cache changed
+ *
+ * @param[in]  err  errno of write, or 0 if the file is durable
+ * @param[in]  arg  Datastore, struct xmldb_uring_arg
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+xmldb_flush_uring_done(int   err,
+                       void *arg)
+{
+    int                     retval = -1;
+    struct xmldb_uring_arg *ua = (struct xmldb_uring_arg *)arg;
+    db_elmnt               *de;
+
+    if ((de = clicon_db_elmnt_get(ua->ua_h, ua->ua_db)) == NULL)
+        goto ok;
+    de->de_flush_uring = 0;
+    if (err){
+        clixon_log(ua->ua_h, LOG_WARNING, "%s: flush of %s failed, retrying", __func__, ua->ua_db);
+        de->de_flush_pending = 1;
+    }
+    /* Coalesce writes made during flush into one new flush */
+    if (de->de_flush_pending && de->de_xml){
+        de->de_flush_pending = 0;
+        if (xmldb_flush_uring(ua->ua_h, ua->ua_db, de) < 0)
+            goto done;
+    }
+ ok:
+    retval = 0;
+ done:
+    free(ua->ua_db);
+    free(ua);
+    return retval;
+}
+
+/*! Write datastore cache to file with io_uring
+ *
+ * The cache is serialized to a buffer, which is written, synced and renamed to the
+ * datastore file in the background, see clixon_uring_write_file
+ * @param[in]  h   Clixon handle
+ * @param[in]  db  Symbolic database name
+ * @param[in]  de  Datastore element
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+static int
+xmldb_flush_uring(clixon_handle h,
+                  const char   *db,
+                  db_elmnt     *de)
+{
+    int                     retval = -1;
+    char                   *dbfile = NULL;
+    cbuf                   *cb = NULL;
+    char                   *buf = NULL;
+    size_t                  len = 0;
+    struct xmldb_uring_arg *ua = NULL;
+
+    if (xmldb_db2file(h, db, &dbfile) < 0)
+        goto done;
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cb, "%s.tmp", dbfile);
+    if ((ua = calloc(1, sizeof(*ua))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    ua->ua_h = h;
+    if ((ua->ua_db = strdup(db)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    if (xmldb_write_file(h, db, de->de_xml, NULL, 0, &buf, &len) < 0)
+        goto done;
+    /* buf is consumed also on error */
+    if (clixon_uring_write_file(cbuf_get(cb), dbfile, buf, len, xmldb_flush_uring_done, ua) < 0)
+        goto done;
+    clixon_debug(CLIXON_DBG_DATASTORE, "Flush %s with io_uring", db);
+    de->de_flush_uring = 1;
+    ua = NULL;
+    retval = 0;
+ done:
+    if (ua){
+        if (ua->ua_db)
+            free(ua->ua_db);
+        free(ua);
+    }
+    if (cb)
+        cbuf_free(cb);
+    if (dbfile)
+        free(dbfile);
+    return retval;
+}
+
+static int xmldb_flush_done(int fd, void *arg);
+
+/*! Fork a child process that writes a snapshot of the datastore cache to file
+ *
+ * The child inherits a copy-on-write image of the cache. It writes to a temporary file,
+ * syncs it, and renames it to the datastore file. The parent is notified when the
+ * child closes its end of a pipe, see xmldb_flush_done
+ * @param[in]  h   Clixon handle
+ * @param[in]  db  Symbolic database name
+ * @param[in]  de  Datastore element
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+static int
+xmldb_flush_fork(clixon_handle h,
+                 const char   *db,
+                 db_elmnt     *de)
+{
+    int    retval = -1;
+    char  *dbfile = NULL;
+    cbuf  *cb = NULL;
+    int    fds[2] = {-1, -1};
+    pid_t  child;
+
     if (xmldb_db2file(h, db, &dbfile) < 0)
         goto done;
-    if ((f = fopen(dbfile, "w")) == NULL){
-        clixon_err(OE_CFG, errno, "fopen(%s)", dbfile);
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cb, "%s.tmp", dbfile);
+    if (pipe(fds) < 0){
+        clixon_err(OE_UNIX, errno, "pipe");
+        goto done;
+    }
+    if ((child = fork()) < 0){
+        clixon_err(OE_UNIX, errno, "fork");
         goto done;
     }
-    if (xmldb_dump(h, f, xt, format, pretty, wdef, multi, db) < 0)
+    if (child == 0){ /* Child */
+        close(fds[0]);
+        if (xmldb_write_file(h, db, de->de_xml, cbuf_get(cb), 1, NULL, NULL) < 0)
+            _exit(1);
+        if (rename(cbuf_get(cb), dbfile) < 0){
+            clixon_err(OE_UNIX, errno, "rename(%s)", dbfile);
+            _exit(1);
+        }
+        _exit(0);
+    }
+    /* Parent */
+    close(fds[1]);
+    fds[1] = -1;
+    clixon_debug(CLIXON_DBG_DATASTORE, "Flush %s in child %d", db, child);
+    de->de_flush_pid = child;
+    de->de_flush_fd = fds[0];
+    if (clixon_event_reg_fd(fds[0], xmldb_flush_done, h, "datastore flush") < 0)
         goto done;
+    fds[0] = -1;
     retval = 0;
  done:
+    if (fds[0] != -1)
+        close(fds[0]);
+    if (fds[1] != -1)
+        close(fds[1]);
+    if (cb)
+        cbuf_free(cb);
+    if (dbfile)
+        free(dbfile);
+    return retval;
+}
+
+/*! Wait for flush child of datastore to exit
+ *
+ * If the child failed, the datastore is marked to be written again
+ * @param[in]  h   Clixon handle
+ * @param[in]  db  Symbolic database name
+ * @param[in]  de  Datastore element
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+static int
+xmldb_flush_reap(clixon_handle h,
+                 const char   *db,
+                 db_elmnt     *de)
+{
+    int status = 0;
+
+    clixon_event_unreg_fd(de->de_flush_fd, xmldb_flush_done);
+    close(de->de_flush_fd);
+    de->de_flush_fd = 0;
+    if (waitpid(de->de_flush_pid, &status, 0) < 0){
+        clixon_err(OE_UNIX, errno, "waitpid(%d)", de->de_flush_pid);
+        de->de_flush_pid = 0;
+        return -1;
+    }
+    de->de_flush_pid = 0;
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0){
+        clixon_log(h, LOG_WARNING, "%s: flush of %s failed with status %#x, retrying",
+                   __func__, db, status);
+        de->de_flush_pending = 1;
+    }
+    return 0;
+}
+
+/*! Event callback when a flush child has exited, start new flush if cache changed meanwhile
+ *
+ * @param[in]  fd   Read end of pipe to child
+ * @param[in]  arg  Clixon handle
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+xmldb_flush_done(int   fd,
+                 void *arg)
+{
+    int           retval = -1;
+    clixon_handle h = (clixon_handle)arg;
+    char        **keys = NULL;
+    size_t        klen;
+    size_t        i;
+    db_elmnt     *de;
+
+    if (clicon_hash_keys(clicon_db_elmnt(h), &keys, &klen) < 0)
+        goto done;
+    for (i = 0; i < klen; i++){
+        if ((de = clicon_hash_value(clicon_db_elmnt(h), keys[i], NULL)) == NULL ||
+            de->de_flush_pid == 0 || de->de_flush_fd != fd)
+            continue;
+        if (xmldb_flush_reap(h, keys[i], de) < 0)
+            goto done;
+        /* Coalesce writes made during flush into one new flush */
+        if (de->de_flush_pending && de->de_xml){
+            de->de_flush_pending = 0;
+            if (xmldb_flush_fork(h, keys[i], de) < 0)
+                goto done;
+        }
+        break;
+    }
+    retval = 0;
+ done:
+    if (keys)
+        free(keys);
+    return retval;
+}
+
+/*! Wait until datastore file is written by background flush, including coalesced writes
+ *
+ * After return, the datastore file is durable and reflects the cache.
+ * @param[in]  h   Clixon handle
+ * @param[in]  db  Symbolic database name
+ * @retval     0   OK
+ * @retval    -1   Error
+ * @see CLICON_XMLDB_FLUSH_ASYNC
+ */
+int
+xmldb_flush_wait(clixon_handle h,
+                 const char   *db)
+{
+    int       retval = -1;
+    db_elmnt *de;
+    char     *dbfile = NULL;
+
+    if ((de = clicon_db_elmnt_get(h, db)) == NULL)
+        goto ok;
+    if (de->de_flush_pid != 0){
+        if (xmldb_flush_reap(h, db, de) < 0)
+            goto done;
+    }
+    /* Also completes io_uring writes of other datastores */
+    if (de->de_flush_uring){
+        if (clixon_uring_drain() < 0)
+            goto done;
+    }
+    if (de->de_flush_pending){
+        de->de_flush_pending = 0;
+        if (de->de_xml != NULL){
+            if (xmldb_db2file(h, db, &dbfile) < 0)
+                goto done;
+            if (xmldb_write_file(h, db, de->de_xml, dbfile, 1, NULL, NULL) < 0)
+                goto done;
+        }
+    }
+ ok:
+    retval = 0;
+ done:
+    if (dbfile)
+        free(dbfile);
+    return retval;
+}
+
+/*! Given datastore, get cache and format, set wdef, add modstate and print to multiple files
+ *
+ * Also add mod-state if applicable
+ * If CLICON_XMLDB_FLUSH_ASYNC is set, the file is written in the background, and writes
+ * requested while a flush is in progress are coalesced into one flush when it completes.
+ * If CLICON_XMLDB_IO_URING is set, the background write is made with io_uring instead of
+ * a forked child.
+ * @param[in]  h   Clixon handle
+ * @param[in]  db  Name of database to search in (filename including dir path
+ * @retval     0   OK
+ * @retval    -1   Error
+ * @see xmldb_flush_wait  Wait until background flush is durable
+ */
+int
+xmldb_write_cache2file(clixon_handle h,
+                       const char   *db)
+{
+    int             retval = -1;
+    cxobj          *xt;
+    char           *dbfile = NULL;
+    db_elmnt       *de;
+    struct timespec t0;
+
+    clixon_latency_start(&t0);
+    if ((xt = xmldb_cache_get(h, db)) == NULL){
+        clixon_err(OE_XML, 0, "XML cache not found");
+        goto done;
+    }
+    if (xmldb_flush_async(h) &&
+        (de = clicon_db_elmnt_get(h, db)) != NULL){
+        if (de->de_flush_pid != 0 || de->de_flush_uring)
+            de->de_flush_pending = 1;
+        else if (xmldb_uring(h)){
+            if (xmldb_flush_uring(h, db, de) < 0)
+                goto done;
+        }
+        else if (xmldb_flush_fork(h, db, de) < 0)
+            goto done;
+        goto ok;
+    }
+    if (xmldb_db2file(h, db, &dbfile) < 0)
+        goto done;
+    if (xmldb_write_file(h, db, xt, dbfile, 0, NULL, NULL) < 0)
+        goto done;
+    /* Snapshot is complete, journal is obsolete */
+    if (clicon_option_bool(h, "CLICON_XMLDB_JOURNAL")){
+        if (xmldb_journal_remove(h, db) < 0)
+            goto done;
+        if ((de = clicon_db_elmnt_get(h, db)) != NULL)
+            de->de_journal = 0;
+    }
+ ok:
+    retval = 0;
+ done:
+    clixon_latency_stop(&t0, "commit", "write-datastore");
     if (dbfile)
         free(dbfile);
-    if (f)
-        fclose(f);
     return retval;
 }
@@ -47,6 +47,9 @@
  */
 int xmldb_put(clixon_handle h, const char *db, enum operation_type op, cxobj *xt, char *username, cbuf *cbret);
 int xmldb_write_cache2file(clixon_handle h, const char *db);
+int xmldb_uring(clixon_handle h);
+int xmldb_flush_async(clixon_handle h);
+int xmldb_journal_replay(clixon_handle h, const char *db, yang_bind yb, yang_stmt *yspec, cxobj *xt, db_elmnt *de, cxobj **xerr);
 int xmldb_dump(clixon_handle h, FILE *f, cxobj *xt, enum format_enum format, int pretty, withdefaults_type wdef, int multi, const char *multidb);
 
 #endif /* _CLIXON_DATASTORE_WRITE_H */
@@ -50,6 +50,9 @@
 #include <string.h>
 #include <time.h>
 #include <errno.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <pthread.h>
 #include <sys/param.h>
 #include <sys/time.h>
 #include <sys/types.h>
@@ -87,7 +90,29 @@ static clixon_handle _debug_clixon_h    = NULL;
  * A compromise solution is now in place where h can be provided in the function call, but
  * tolerates NULL, in which case a cached handle is used.
  */
-static int _debug_level = 0;
+int _clixon_debug_level = 0;
+
+/*! Ring buffer of debug messages written asynchronously by a writer thread
+ *
+ * Messages are null-terminated strings. The writer thread takes all messages at once
+ * and writes them to the log destination without holding the lock, so that callers
+ * only copy the message. If the ring is full, messages are dropped and counted.
+ * The writer thread is started in each process on first message, eg after fork.
+ * @see CLICON_DEBUG_RING
+ */
+static pthread_mutex_t _ring_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  _ring_cond = PTHREAD_COND_INITIALIZER;   /* Messages or exit */
+static pthread_cond_t  _ring_idle = PTHREAD_COND_INITIALIZER;   /* Writer has written all */
+static pthread_t       _ring_thread;
+static char           *_ring_buf = NULL;      /* Ring, NULL if disabled */
+static char           *_ring_out = NULL;      /* Linear copy of the ring taken by writer */
+static size_t          _ring_size = 0;        /* Size of ring in bytes */
+static size_t          _ring_head = 0;        /* Write offset */
+static size_t          _ring_len = 0;         /* Used bytes */
+static uint64_t        _ring_dropped = 0;     /* Dropped messages since last write */
+static pid_t           _ring_pid = 0;         /* Process of writer thread, 0 if none */
+static int             _ring_busy = 0;        /* Writer is writing */
+static int             _ring_exit = 0;        /* Writer should exit */
 
 /*! Mapping between Clixon debug symbolic names <--> bitfields
  *
@@ -184,7 +209,7 @@ clixon_debug_init(clixon_handle h,
                   int           dbglevel)
 {
     _debug_clixon_h = h;
-    _debug_level = dbglevel; /* Global variable */
+    _clixon_debug_level = dbglevel; /* Global variable */
     return 0;
 }
 
@@ -193,7 +218,220 @@ clixon_debug_init(clixon_handle h,
 int
 clixon_debug_get(void)
 {
-    return _debug_level;
+    return _clixon_debug_level;
+}
+
+/*! Writer thread of debug ring: write messages to log destination until exit
+ */
+static void *
+debug_ring_writer(void *arg)
+{
+    size_t   len;
+    size_t   tail;
+    size_t   i;
+    uint64_t dropped;
+
+    pthread_mutex_lock(&_ring_mutex);
+    while (1){
+        while (_ring_len == 0 && _ring_dropped == 0 && !_ring_exit)
+            pthread_cond_wait(&_ring_cond, &_ring_mutex);
+        if (_ring_len == 0 && _ring_dropped == 0 && _ring_exit)
+            break;
+        /* Take all messages */
+        len = _ring_len;
+        tail = (_ring_head + _ring_size - len) % _ring_size;
+        if (tail + len <= _ring_size)
+            memcpy(_ring_out, &_ring_buf[tail], len);
+        else{
+            memcpy(_ring_out, &_ring_buf[tail], _ring_size - tail);
+            memcpy(&_ring_out[_ring_size - tail], _ring_buf, len - (_ring_size - tail));
+        }
+        dropped = _ring_dropped;
+        _ring_len = 0;
+        _ring_dropped = 0;
+        _ring_busy = 1;
+        pthread_mutex_unlock(&_ring_mutex);
+        for (i = 0; i < len; i += strlen(&_ring_out[i]) + 1)
+            clixon_log_str(LOG_DEBUG, &_ring_out[i]);
+        if (dropped){
+            char msg[64];
+
+            snprintf(msg, sizeof(msg), "%" PRIu64 " debug messages dropped", dropped);
+            clixon_log_str(LOG_DEBUG, msg);
+        }
+        pthread_mutex_lock(&_ring_mutex);
+        _ring_busy = 0;
+        pthread_cond_broadcast(&_ring_idle);
+    }
+    _ring_busy = 0;
+    pthread_cond_broadcast(&_ring_idle);
+    pthread_mutex_unlock(&_ring_mutex);
+    return NULL;
+}
+
+/*! Put a debug message in the ring, start writer thread if not started in this process
+ *
+ * @param[in]  msg  Debug message
+ * @retval     1    Message put in ring, or dropped if ring is full
+ * @retval     0    Ring disabled or no writer thread, write message directly
+ */
+static int
+debug_ring_put(char *msg)
+{
+    size_t len;
+    size_t n;
+    int    retval = 0;
+
+    pthread_mutex_lock(&_ring_mutex);
+    if (_ring_buf == NULL || _ring_exit)
+        goto done;
+    if (_ring_pid == 0){ /* Reset in child after fork */
+        if (pthread_create(&_ring_thread, NULL, debug_ring_writer, NULL) != 0)
+            goto done;
+        _ring_pid = getpid();
+    }
+    len = strlen(msg) + 1;
+    if (len > _ring_size - _ring_len)
+        _ring_dropped++;
+    else {
+        n = _ring_size - _ring_head;
+        if (len <= n)
+            memcpy(&_ring_buf[_ring_head], msg, len);
+        else{
+            memcpy(&_ring_buf[_ring_head], msg, n);
+            memcpy(_ring_buf, &msg[n], len - n);
+        }
+        _ring_head = (_ring_head + len) % _ring_size;
+        _ring_len += len;
+    }
+    pthread_cond_signal(&_ring_cond);
+    retval = 1;
+ done:
+    pthread_mutex_unlock(&_ring_mutex);
+    return retval;
+}
+
+/*! Before fork: hold ring lock so that child gets a consistent ring */
+static void
+debug_ring_prepare(void)
+{
+    pthread_mutex_lock(&_ring_mutex);
+}
+
+/*! After fork in parent */
+static void
+debug_ring_parent(void)
+{
+    pthread_mutex_unlock(&_ring_mutex);
+}
+
+/*! After fork in child: writer thread does not exist, messages of parent are written by it
+ */
+static void
+debug_ring_child(void)
+{
+    _ring_pid = 0;
+    _ring_head = 0;
+    _ring_len = 0;
+    _ring_dropped = 0;
+    _ring_busy = 0;
+    pthread_mutex_unlock(&_ring_mutex);
+}
+
+/*! Write debug messages asynchronously via a ring buffer
+ *
+ * Debug messages are copied to a ring and written by a separate thread to the log
+ * destination, eg syslog, instead of in the calling thread. Messages may then be
+ * written after later non-debug log messages.
+ * Messages are dropped if the ring is full.
+ * @param[in]  size  Size of ring in bytes
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see CLICON_DEBUG_RING
+ */
+int
+clixon_debug_ring_init(size_t size)
+{
+    int        retval = -1;
+    static int atfork = 0;
+
+    clixon_debug_ring_exit();
+    if (size == 0)
+        goto ok;
+    if ((_ring_out = malloc(size)) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    pthread_mutex_lock(&_ring_mutex);
+    if ((_ring_buf = malloc(size)) == NULL){
+        pthread_mutex_unlock(&_ring_mutex);
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    _ring_size = size;
+    _ring_head = _ring_len = 0;
+    _ring_dropped = 0;
+    _ring_exit = 0;
+    pthread_mutex_unlock(&_ring_mutex);
+    if (!atfork){
+        if (pthread_atfork(debug_ring_prepare, debug_ring_parent, debug_ring_child) != 0){
+            clixon_err(OE_UNIX, errno, "pthread_atfork");
+            goto done;
+        }
+        atexit(clixon_debug_ring_exit);
+        atfork++;
+    }
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Wait until the writer thread has written all debug messages
+ *
+ * @retval     0     OK
+ */
+int
+clixon_debug_ring_flush(void)
+{
+    pthread_mutex_lock(&_ring_mutex);
+    if (_ring_pid != 0)
+        while (_ring_len || _ring_dropped || _ring_busy)
+            pthread_cond_wait(&_ring_idle, &_ring_mutex);
+    pthread_mutex_unlock(&_ring_mutex);
+    return 0;
+}
+
+/*! Write remaining debug messages, stop writer thread and free ring
+ */
+void
+clixon_debug_ring_exit(void)
+{
+    int join;
+
+    pthread_mutex_lock(&_ring_mutex);
+    if (_ring_buf == NULL){
+        pthread_mutex_unlock(&_ring_mutex);
+        return;
+    }
+    _ring_exit = 1;
+    join = (_ring_pid != 0);
+    pthread_cond_signal(&_ring_cond);
+    pthread_mutex_unlock(&_ring_mutex);
+    if (join)
+        pthread_join(_ring_thread, NULL);
+    pthread_mutex_lock(&_ring_mutex);
+    free(_ring_buf);
+    _ring_buf = NULL;
+    _ring_size = 0;
+    _ring_head = _ring_len = 0;
+    _ring_dropped = 0;
+    _ring_pid = 0;
+    pthread_mutex_unlock(&_ring_mutex);
+    if (_ring_out){
+        free(_ring_out);
+        _ring_out = NULL;
+    }
 }
 
 /*! Print a debug message with debug-level. Settings determine where msg appears.
@@ -238,7 +476,8 @@ clixon_debug_fn(clixon_handle h,
         goto done;
     va_end(ap);
     if (cb != NULL){ /* Customized: expand clixon_err_args */
-        clixon_log_str(LOG_DEBUG, cbuf_get(cb));
+        if (debug_ring_put(cbuf_get(cb)) == 0)
+            clixon_log_str(LOG_DEBUG, cbuf_get(cb));
         goto ok;
     }
     if ((cb = cbuf_new()) == NULL){
@@ -257,7 +496,8 @@ clixon_debug_fn(clixon_handle h,
     /* Truncate long debug strings */
     if ((trunc = clixon_log_string_limit_get()) && trunc < cbuf_len(cb))
         cbuf_trunc(cb, trunc);
-    clixon_log_str(LOG_DEBUG, cbuf_get(cb));
+    if (debug_ring_put(cbuf_get(cb)) == 0)
+        clixon_log_str(LOG_DEBUG, cbuf_get(cb));
  ok:
     retval = 0;
  done:
@@ -59,19 +59,15 @@
  * for example, if I lookup /a/b I get back a pointer to root_handler()
  * if i lookup /a/d, I get handler_d().
  *
- * if a element has a key (/a/b=c) then the list element is
- * marked with an = sign and without the key
- * so /a/b=c creates multiple entries:
+ * elements are compiled when registered:
+ * - the children of a node are indexed by name in a hash table
+ * - an element with a key (/a/b=c or /a/b[k='c']) is a keyed variant of the
+ *   element without key, b=c is only matched by a lookup of b with key c,
+ *   other keys match b. A key that is empty or * (/a/b= or /a/b=*) is the
+ *   same as no key
+ * - an element * matches any element that has no other match
  *
- *  [/]
- *      [a]
- *          [b=]
- *          [b]
- *
- * NOTE 2: there is no attempt to optimize list searching here, sorry. I
- * do not think that the known use cases will get big enough to make the
- * tree get too large. I do not recommend that you encode every possible
- * path, just top level key handlers.
+ * lookups split the path in place and walk the tree without allocation.
  *
  * there are 2 functions to the API:
  * clixon_register_handler(): build the dispatcher table
@@ -96,245 +92,320 @@
 
 /* ===== utility routines ==== */
 
-#define PATH_CHUNKS 32
+/* Initial size of child hash table, power of 2 */
+#define DISPATCHER_HASH_SIZE 8
 
-/*! Spilt a path into elements
- *
- * given an api-path, break it up into chunks separated by '/'
- * characters. it is expected that api-paths are URI encoded, so no need
- * to deal with unescaped special characters like ', ", and /
- *
- * @param[in]  path      Path string
- * @param[in]  plist     Pointer to split path array
- * @param[out] plist_len Pointer to storage space for path array length
- * @retval     0         OK
- * @retval    -1         Error
- * XXX consider using clixon_strsep
+/* Max depth of path elements saved between lookups of a batch */
+#define DISPATCHER_DEPTH 32
+
+/*! State of previous lookup of a batch, to resume a lookup from the common prefix
  */
-static int
-split_path(char   *path,
-           char ***plist,
-           size_t *plist_len)
+struct dispatcher_walk {
+    const char         *dw_path;                   /* Previous path */
+    int                 dw_len;                    /* Number of saved elements */
+    size_t              dw_end[DISPATCHER_DEPTH];  /* End offset of element in path */
+    dispatcher_entry_t *dw_node[DISPATCHER_DEPTH]; /* Matched node of element */
+    dispatcher_entry_t *dw_best[DISPATCHER_DEPTH]; /* Closest node with handler */
+};
+
+/*! Hash of name, FNV-1a
+ */
+static unsigned int
+dispatcher_hash(const char *name,
+                size_t      len)
 {
-    int    retval = -1;
-    size_t allocated = PATH_CHUNKS;
-    char  *work = NULL;     /* don't modify the original copy */
-    char **list = NULL;
-    size_t len = 0;
-    char  *ptr;
-    char  *new_element;
-
-    if ((work = strdup(path)) == NULL)
-        goto done;
-    if ((list = malloc(allocated * sizeof(char *))) == NULL)
-        goto done;
-    memset(list, 0, allocated * sizeof(char *));
-    ptr = work;
-    if (*ptr == '/') {
-        if ((new_element = strdup("/")) == NULL)
-            goto done;
-        list[len++] = new_element;
-        ptr++;
-    }
-    ptr = strtok(ptr, "/");
-    while (ptr != NULL) {
-        if (len > allocated) {
-            /* we've run out of space, allocate a bigger list */
-            allocated += PATH_CHUNKS;
-            if ((list = realloc(list, allocated * sizeof(char *))) == NULL)
-                goto done;
-        }
-        if ((new_element = strdup(ptr)) == NULL)
-            goto done;
-        list[len++] = new_element;
-        ptr = strtok(NULL, "/");
+    unsigned int h = 2166136261u;
+    size_t       i;
+
+    for (i = 0; i < len; i++){
+        h ^= (unsigned char)name[i];
+        h *= 16777619u;
     }
-    *plist = list;
-    list = NULL;
-    *plist_len = len;
-    retval = 0;
- done:
-    if (list)
-        free(list);
-    if (work)
-        free(work);
-    return retval;
+    return h;
 }
 
-/*! Free a split path structure
+/*! Split a path element into name and key
  *
- * @param[in] list pointer to split path array
- * @param[in] len length of split path array
+ * the key of b=c is c, the key of b[k='c'] is k='c'
+ * @param[in]  elem    Path element, not NUL-terminated
+ * @param[in]  len     Length of element
+ * @param[out] namelen Length of name
+ * @param[out] key     Key, or NULL
+ * @param[out] keylen  Length of key, 0 if no key, or if key is empty or *
  */
 static void
-split_path_free(char **list,
-                size_t len)
+split_element(const char  *elem,
+              size_t       len,
+              size_t      *namelen,
+              const char **key,
+              size_t      *keylen)
 {
-    size_t i;
+    size_t n;
 
-    for (i = 0; i < len; i++) {
-        free(list[i]);
-    }
-    free(list);
+    for (n = 0; n < len; n++)
+        if (elem[n] == '=' || elem[n] == '[')
+            break;
+    *namelen = n;
+    *key = NULL;
+    *keylen = 0;
+    if (n == len)
+        return;
+    *key = elem + n + 1;
+    *keylen = len - n - 1;
+    if (elem[n] == '[' && *keylen && (*key)[*keylen-1] == ']')
+        (*keylen)--;
+    if (*keylen == 1 && **key == '*')
+        *keylen = 0;
 }
 
-/*! Find a peer of this node by name
+/*! Find a child of this node by name
  *
- * search through the list pointed at by peer
- * @param[in] node       Pointer to a node in the peer list
- * @param[in] node_name  Name of node we're looking for
- * @retval    pointer    Pointer to found node or NULL
- * @retval    NULL
+ * @param[in] node  Parent node
+ * @param[in] name  Name of child, not NUL-terminated
+ * @param[in] len   Length of name
+ * @retval    child Found node
+ * @retval    NULL  Not found
  */
 static dispatcher_entry_t *
-find_peer(dispatcher_entry_t *node, char *node_name)
+find_child(dispatcher_entry_t *node,
+           const char         *name,
+           size_t              len)
 {
-    dispatcher_entry_t *i;
+    dispatcher_entry_t *c;
+    size_t              i;
 
-    if ((node == NULL) || (node_name == NULL)) {
-        /*  protect against idiot users */
+    if (node->child_hash == NULL)
         return NULL;
+    i = dispatcher_hash(name, len) & (node->child_size - 1);
+    while ((c = node->child_hash[i]) != NULL){
+        if (c->node_len == len && memcmp(c->node_name, name, len) == 0)
+            return c;
+        i = (i + 1) & (node->child_size - 1);
     }
+    return NULL;
+}
 
-    i = node->peer_head;
-
-    while (i != NULL) {
-        if (strcmp(node_name, i->node_name) == 0) {
-            break;
+/*! Insert a child in the hash table of its parent, grow table if needed
+ *
+ * @param[in]  node  Parent node
+ * @param[in]  child Child node
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+hash_child(dispatcher_entry_t *node,
+           dispatcher_entry_t *child)
+{
+    dispatcher_entry_t **vec;
+    dispatcher_entry_t **old;
+    size_t               size;
+    size_t               i;
+    size_t               j;
+
+    if (2*(node->child_nr + 1) > node->child_size){
+        size = node->child_size ? 2*node->child_size : DISPATCHER_HASH_SIZE;
+        if ((vec = calloc(size, sizeof(*vec))) == NULL)
+            return -1;
+        old = node->child_hash;
+        for (i = 0; i < node->child_size; i++){
+            if (old[i] == NULL)
+                continue;
+            j = dispatcher_hash(old[i]->node_name, old[i]->node_len) & (size - 1);
+            while (vec[j] != NULL)
+                j = (j + 1) & (size - 1);
+            vec[j] = old[i];
         }
-        i = i->peer;
+        if (old)
+            free(old);
+        node->child_hash = vec;
+        node->child_size = size;
     }
-
-    return i;
+    i = dispatcher_hash(child->node_name, child->node_len) & (node->child_size - 1);
+    while (node->child_hash[i] != NULL)
+        i = (i + 1) & (node->child_size - 1);
+    node->child_hash[i] = child;
+    node->child_nr++;
+    return 0;
 }
 
-/*! Add a node as the last node in peer list
+/*! Create a node and add it as the last child of a node
  *
- * @param[in]  node    Pointer to an element of the peer list
- * @param[in]  name    Name of new node
- * @retval     pointer Pointer to added/existing node
+ * @param[in]  node    Parent node, or NULL for root
+ * @param[in]  name    Name of new node, not NUL-terminated
+ * @param[in]  len     Length of name
+ * @param[in]  key     Key of new node, or NULL
+ * @param[in]  keylen  Length of key
+ * @retval     pointer New node
  * @retval     NULL    Error
  */
 static dispatcher_entry_t *
-add_peer_node(dispatcher_entry_t *node,
-              char               *name)
+add_child_node(dispatcher_entry_t *node,
+               const char         *name,
+               size_t              len,
+               const char         *key,
+               size_t              keylen)
 {
-    dispatcher_entry_t *new_node = NULL;
-    dispatcher_entry_t *eptr;
+    dispatcher_entry_t  *new_node;
+    dispatcher_entry_t **eptr;
 
     if ((new_node = malloc(sizeof(dispatcher_entry_t))) == NULL)
         return NULL;
     memset(new_node, 0, sizeof(dispatcher_entry_t));
-    if (node == NULL) {
-        /* this is a new node */
-
-        new_node->node_name = strdup(name);
-        new_node->peer = NULL;
-        new_node->children = NULL;
-        new_node->peer_head = new_node;
-
-        return new_node;
+    if ((new_node->node_name = strndup(name, len)) == NULL){
+        free(new_node);
+        return NULL;
     }
-    else {
-        /* possibly adding to the list */
-
-        /* search for existing, or get tail end of list */
-        eptr = node->peer_head;
-        while (eptr->peer != NULL) {
-            if (strcmp(eptr->node_name, name) == 0) {
-                free(new_node);
-                return eptr;
-            }
-            eptr = eptr->peer;
-        }
-
-        // if eptr->node_name == name, we done
-        if (strcmp(eptr->node_name, name) == 0) {
+    new_node->node_len = len;
+    if (keylen){
+        if ((new_node->node_key = strndup(key, keylen)) == NULL){
+            free(new_node->node_name);
             free(new_node);
-            return eptr;
+            return NULL;
         }
-
-        new_node->node_name = strdup(name);
-        new_node->peer = NULL;
-        new_node->children = NULL;
-        new_node->peer_head = node->peer_head;
-
-        eptr->peer = new_node;
-
-        return new_node;
+        new_node->node_key_len = keylen;
+    }
+    if (node != NULL){
+        eptr = &node->children;
+        while (*eptr != NULL)
+            eptr = &(*eptr)->peer;
+        *eptr = new_node;
     }
+    return new_node;
 }
 
-/*! Add a node as a child of this node
- *
- * this is different from add_peer_node() in that it returns a
- * pointer to the head_peer of the children list where the node was
- * added.
+/*! Find or add a registered path element as child of this node
  *
- * @param[in] node    Pointer to parent node of children list
- * @param[in] name    Name of child node
- * @retval    pointer Pointer to head of children list
+ * @param[in] node    Parent node
+ * @param[in] elem    Path element, not NUL-terminated
+ * @param[in] len     Length of element
+ * @retval    pointer Pointer to added/existing node
  * @retval    NULL    Error
  */
 static dispatcher_entry_t *
-add_child_node(dispatcher_entry_t *node,
-               char               *name)
+add_element(dispatcher_entry_t *node,
+            const char         *elem,
+            size_t              len)
 {
-    dispatcher_entry_t *child_ptr;
-
-    if ((child_ptr = add_peer_node(node->children, name)) == NULL)
-        return NULL;
-    node->children = child_ptr->peer_head;
+    dispatcher_entry_t  *base;
+    dispatcher_entry_t **kptr;
+    const char          *key;
+    size_t               namelen;
+    size_t               keylen;
+
+    split_element(elem, len, &namelen, &key, &keylen);
+    if (namelen == 1 && *elem == '*'){
+        if (node->wildcard == NULL)
+            node->wildcard = add_child_node(node, elem, namelen, NULL, 0);
+        return node->wildcard;
+    }
+    if ((base = find_child(node, elem, namelen)) == NULL){
+        if ((base = add_child_node(node, elem, namelen, NULL, 0)) == NULL)
+            return NULL;
+        if (hash_child(node, base) < 0)
+            return NULL;
+    }
+    if (keylen == 0)
+        return base;
+    for (kptr = &base->keyed; *kptr != NULL; kptr = &(*kptr)->next_key)
+        if ((*kptr)->node_key_len == keylen && memcmp((*kptr)->node_key, key, keylen) == 0)
+            return *kptr;
+    *kptr = add_child_node(node, elem, namelen, key, keylen);
+    return *kptr;
+}
 
-    return child_ptr;
+/*! Match a path element of a lookup among the children of this node
+ *
+ * @param[in] node    Parent node
+ * @param[in] elem    Path element, not NUL-terminated
+ * @param[in] len     Length of element
+ * @retval    pointer Matching child
+ * @retval    NULL    No match
+ */
+static dispatcher_entry_t *
+match_element(dispatcher_entry_t *node,
+              const char         *elem,
+              size_t              len)
+{
+    dispatcher_entry_t *c;
+    const char         *key;
+    size_t              namelen;
+    size_t              keylen;
+
+    split_element(elem, len, &namelen, &key, &keylen);
+    if ((c = find_child(node, elem, namelen)) == NULL)
+        return node->wildcard;
+    if (keylen){
+        for (node = c->keyed; node != NULL; node = node->next_key)
+            if (node->node_key_len == keylen && memcmp(node->node_key, key, keylen) == 0)
+                return node;
+    }
+    return c;
 }
 
-/**
+/*! Find the closest node with a handler of a path
  *
- * @param root
- * @param path
- * @retval
- * @retval NULL Error
+ * @param[in]  root  Root of dispatch tree
+ * @param[in]  path  Path
+ * @param[in]  dw    State of previous lookup of a batch, or NULL
+ * @retval     node  Closest node with handler, or root
+ * @retval     NULL  Error
  */
 static dispatcher_entry_t *
-get_entry(dispatcher_entry_t *root,
-          char               *path)
+get_entry(dispatcher_entry_t     *root,
+          const char             *path,
+          struct dispatcher_walk *dw)
 {
-    char              **split_path_list = NULL;
-    size_t              split_path_len = 0;
     dispatcher_entry_t *ptr = root;
     dispatcher_entry_t *best = root;
+    dispatcher_entry_t *c;
+    size_t              pos = 0;
+    size_t              common = 0;
+    size_t              len;
+    int                 depth = 0;
+    int                 d;
 
-    /* cut the path up into individual elements */
-    if (split_path(path, &split_path_list, &split_path_len) < 0)
+    if (root == NULL)
         return NULL;
-
-    /* some elements may have keys defined, strip them off */
-    for (int i = 0; i < split_path_len; i++) {
-        char *kptr = split_path_list[i];
-        strsep(&kptr, "=[]");
+    /* resume from last element in common with previous path */
+    if (dw != NULL && dw->dw_path != NULL){
+        while (path[common] != '\0' && path[common] == dw->dw_path[common])
+            common++;
+        for (d = dw->dw_len - 1; d >= 0; d--)
+            if (dw->dw_end[d] <= common &&
+                (path[dw->dw_end[d]] == '/' || path[dw->dw_end[d]] == '\0'))
+                break;
+        if (d >= 0){
+            ptr = dw->dw_node[d];
+            best = dw->dw_best[d];
+            pos = dw->dw_end[d];
+            depth = d + 1;
+        }
     }
-
     /* search down the tree */
-    for (int i = 0; i < split_path_len; i++) {
-
-        char *query = split_path_list[i];
-        if ((ptr = find_peer(ptr, query)) == NULL) {
-            split_path_free(split_path_list, split_path_len);
-            /* we ran out of matches, use last found handler */
-            return best;
-        }
-        if (ptr->handler != NULL) {
-            /* if handler is defined, save it */
+    while (1){
+        while (path[pos] == '/')
+            pos++;
+        if (path[pos] == '\0')
+            break;
+        for (len = 0; path[pos+len] != '\0' && path[pos+len] != '/'; len++)
+            ;
+        if ((c = match_element(ptr, path + pos, len)) == NULL)
+            break; /* we ran out of matches, use last found handler */
+        ptr = c;
+        if (ptr->handler != NULL)
             best = ptr;
+        pos += len;
+        if (dw != NULL && depth < DISPATCHER_DEPTH){
+            dw->dw_end[depth] = pos;
+            dw->dw_node[depth] = ptr;
+            dw->dw_best[depth] = best;
+            depth++;
         }
-
-        /* skip to next element */
-        ptr = ptr->children;
     }
-
-    /* clean up */
-    split_path_free(split_path_list, split_path_len);
+    if (dw != NULL){
+        dw->dw_path = path;
+        dw->dw_len = depth;
+    }
     return best;
 }
 
@@ -365,6 +436,25 @@ call_handler_helper(dispatcher_entry_t *entry,
     return 1;
 }
 
+/*! Call the handler of an entry and all its descendant handlers
+ */
+static int
+call_entry(dispatcher_entry_t *best,
+           void               *handle,
+           char               *path,
+           void               *user_args)
+{
+    int ret = 0;
+
+    if (best->children != NULL) {
+        call_handler_helper(best->children, handle, path, user_args);
+    }
+    if (best->handler != NULL) {
+        ret = (*best->handler)(handle, path, user_args, best->arg);
+    }
+    return ret;
+}
+
 /*
  * ===== PUBLIC API FUNCTIONS =====
  */
@@ -383,44 +473,34 @@ dispatcher_register_handler(dispatcher_entry_t   **root,
                             dispatcher_definition *x)
 {
     int                 retval = -1;
-    char              **split_path_list = NULL;
-    size_t              split_path_len = 0;
     dispatcher_entry_t *ptr;
+    char               *path = x->dd_path;
+    size_t              pos = 1;
+    size_t              len;
 
-    if (*x->dd_path != '/') {
+    if (*path != '/') {
         errno = EINVAL;
         goto done;
     }
-
-    /*
-     * get the path from the dispatcher_definition, break it
-     * up to create the elements of the dispatcher table
-     */
-    if (split_path(x->dd_path, &split_path_list, &split_path_len) < 0)
+    /* the first element is always the root */
+    if (*root == NULL &&
+        (*root = add_child_node(NULL, "/", 1, NULL, 0)) == NULL)
         goto done;
-
-    /*
-     * the first element is always a peer to the top level
-     */
     ptr = *root;
-
-    if ((ptr = add_peer_node(ptr, split_path_list[0])) == NULL)
-        return -1;
-    if (*root == NULL) {
-        *root = ptr;
-    }
-
-    for (size_t i = 1; i < split_path_len; i++) {
-        if ((ptr = add_child_node(ptr, split_path_list[i])) == NULL)
+    while (1){
+        while (path[pos] == '/')
+            pos++;
+        if (path[pos] == '\0')
+            break;
+        for (len = 0; path[pos+len] != '\0' && path[pos+len] != '/'; len++)
+            ;
+        if ((ptr = add_element(ptr, path + pos, len)) == NULL)
             goto done;
+        pos += len;
     }
-
     /* when we get here, ptr points at last entry added */
     ptr->handler = x->dd_handler;
     ptr->arg = x->dd_arg;
-
-    /* clean up */
-    split_path_free(split_path_list, split_path_len);
     retval = 0;
  done:
     return retval;
@@ -446,20 +526,54 @@ dispatcher_call_handlers(dispatcher_entry_t *root,
                          char               *path,
                          void               *user_args)
 {
-    int                 ret = 0;
     dispatcher_entry_t *best;
 
-    if ((best = get_entry(root, path)) == NULL){
+    if ((best = get_entry(root, path, NULL)) == NULL){
         errno = ENOENT;
         return -1;
     }
-    if (best->children != NULL) {
-        call_handler_helper(best->children, handle, path, user_args);
-    }
-    if (best->handler != NULL) {
-        ret = (*best->handler)(handle, path, user_args, best->arg);
+    return call_entry(best, handle, path, user_args);
+}
+
+/*! Call the handlers of a vector of paths
+ *
+ * Same as calling dispatcher_call_handlers for every path, but each lookup resumes from
+ * the path elements in common with the previous path, so that sibling nodes of a
+ * sorted vector share the walk of their ancestors.
+ * @param[in]  root
+ * @param[in]  handle
+ * @param[in]  paths     Vector of paths, eg sorted
+ * @param[in]  npaths    Length of paths
+ * @param[in]  user_args
+ * @retval     1         OK
+ * @retval     0         A handler returned 0
+ * @retval    -1         Error, or a handler returned -1, remaining paths are not called
+ * @see dispatcher_call_handlers
+ */
+int
+dispatcher_call_handlers_vec(dispatcher_entry_t *root,
+                             void               *handle,
+                             char              **paths,
+                             size_t              npaths,
+                             void               *user_args)
+{
+    int                    retval = 1;
+    struct dispatcher_walk dw = {0,};
+    dispatcher_entry_t    *best;
+    size_t                 i;
+    int                    ret;
+
+    for (i = 0; i < npaths; i++){
+        if ((best = get_entry(root, paths[i], &dw)) == NULL){
+            errno = ENOENT;
+            return -1;
+        }
+        if ((ret = call_entry(best, handle, paths[i], user_args)) < 0)
+            return -1;
+        if (ret == 0)
+            retval = 0;
     }
-    return ret;
+    return retval;
 }
 
 /*! Free a dispatcher tree
@@ -475,6 +589,10 @@ dispatcher_free(dispatcher_entry_t *root)
         dispatcher_free(root->peer);
     if (root->node_name)
         free(root->node_name);
+    if (root->node_key)
+        free(root->node_key);
+    if (root->child_hash)
+        free(root->child_hash);
     free(root);
     return 0;
 }
@@ -488,6 +606,8 @@ dispatcher_print(FILE               *f,
                  dispatcher_entry_t *de)
 {
     fprintf(f, "%*s%s", level*INDENT, "", de->node_name);
+    if (de->node_key)
+        fprintf(f, "=%s", de->node_key);
     if (de->handler)
         fprintf(f, " %p", de->handler);
     if (de->arg)
@@ -53,6 +53,15 @@
 #include <sys/param.h>
 #include <sys/types.h>
 #include <sys/time.h>
+#include <sys/stat.h>
+#include <poll.h>
+#if defined(HAVE_EPOLL_CREATE1)
+#include <sys/epoll.h>
+#define EVENT_EPOLL
+#elif defined(HAVE_KQUEUE)
+#include <sys/event.h>
+#define EVENT_KQUEUE
+#endif
 
 #include <cligen/cligen.h>
 
@@ -74,15 +83,24 @@
  */
 #define EVENT_STRLEN 32
 
+/* Max number of ready file descriptors returned by one epoll/kqueue wait */
+#define EVENT_POLL_MAX 64
+
 /*
  * Types
  */
 struct event_data{
     struct event_data          *e_next;                 /* Next in list */
+    struct event_data          *e_fdnext;               /* Next with same fd, see _ee_fdvec */
+    struct event_data          *e_hnext;                /* Next in timer hash bucket */
+    int                         e_heapix;               /* Index in timer heap */
+    uint64_t                    e_seq;                  /* Timer registration order for equal times */
     int                       (*e_fn)(int, void*);      /* Callback function */
     enum {EVENT_FD, EVENT_TIME} e_type;                 /* Type of event */
     int                         e_fd;                   /* File descriptor */
     int                         e_prio;                 /* 1: high-prio FD:s only*/
+    int                         e_always;               /* FD can not be polled, always ready */
+    int                         e_write;                /* FD event on writable, not input */
     struct timeval              e_time;                 /* Timeout */
     void                       *e_arg;                  /* Function argument */
     char                        e_string[EVENT_STRLEN]; /* String for debugging */
@@ -93,11 +111,45 @@ struct event_data{
  * XXX consider use handle variables instead of global
  */
 static struct event_data *ee = NULL;
-static struct event_data *ee_timers = NULL;
+
+/* Timers are kept in a binary min-heap on (e_time, e_seq), with a hash on (fn, arg) for unreg */
+static struct event_data **_ee_heap = NULL;
+static int                 _ee_heaplen = 0;
+static int                 _ee_heapmax = 0;
+static uint64_t            _ee_seq = 0;
+static struct event_data **_ee_thash = NULL;
+static size_t              _ee_thashlen = 0; /* Power of two */
 
 /* Set if element in ee is deleted (clixon_event_unreg_fd). Check in ee loops */
 static int _ee_unreg = 0;
 
+/* File descriptor events indexed by fd, chained by e_fdnext */
+static struct event_data **_ee_fdvec = NULL;
+static int                 _ee_fdlen = 0;
+
+/* File descriptor write events indexed by fd, chained by e_fdnext */
+static struct event_data **_ee_wfdvec = NULL;
+static int                 _ee_wfdlen = 0;
+
+/* Number of registered fds that can not be polled, eg regular files */
+static int _ee_always = 0;
+
+/* Ready file descriptors of last wait */
+static int *_ee_ready = NULL;
+static int  _ee_readylen = 0;
+static int  _ee_readymax = 0;
+
+/* Writable file descriptors of last wait */
+static int *_ee_wready = NULL;
+static int  _ee_wreadylen = 0;
+static int  _ee_wreadymax = 0;
+
+#if defined(EVENT_EPOLL) || defined(EVENT_KQUEUE)
+/* epoll or kqueue descriptor, and process that created it */
+static int   _ee_pollfd = -1;
+static pid_t _ee_pollpid = 0;
+#endif
+
 /* If set (eg by signal handler) exit select loop on next run and return 0 */
 static int _clicon_exit = 0;
 
@@ -168,6 +220,316 @@ clicon_sig_ignore_get(void)
     return _clicon_sig_ignore;
 }
 
+/*! Add a file descriptor to the poller
+ *
+ * @param[in]  fd   File descriptor
+ * @retval     1    OK
+ * @retval     0    OK, but fd can not be polled (eg a regular file) and is always ready
+ * @retval    -1    Error
+ */
+static int
+event_poller_add(int fd)
+{
+    struct stat st;
+#if defined(EVENT_EPOLL)
+    struct epoll_event ev = {0,};
+#elif defined(EVENT_KQUEUE)
+    struct kevent      kev;
+#endif
+
+    /* Regular files are always readable but can not be polled, or report no events at EOF */
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode))
+        return 0;
+#if defined(EVENT_EPOLL)
+    ev.events = EPOLLIN;
+    if (fd < _ee_wfdlen && _ee_wfdvec[fd])
+        ev.events |= EPOLLOUT;
+    ev.data.fd = fd;
+    if (epoll_ctl(_ee_pollfd, EPOLL_CTL_ADD, fd, &ev) < 0){
+        if (errno == EEXIST){ /* Another event on same fd, or fd reused without unreg */
+            if ((ev.events & EPOLLOUT) &&
+                epoll_ctl(_ee_pollfd, EPOLL_CTL_MOD, fd, &ev) < 0){
+                clixon_err(OE_EVENTS, errno, "epoll_ctl");
+                return -1;
+            }
+            return 1;
+        }
+        if (errno == EPERM)
+            return 0;
+        clixon_err(OE_EVENTS, errno, "epoll_ctl");
+        return -1;
+    }
+#elif defined(EVENT_KQUEUE)
+    EV_SET(&kev, fd, EVFILT_READ, EV_ADD, 0, 0, NULL);
+    if (kevent(_ee_pollfd, &kev, 1, NULL, 0, NULL) < 0){
+        clixon_err(OE_EVENTS, errno, "kevent");
+        return -1;
+    }
+#endif
+    return 1;
+}
+
+/*! Remove a file descriptor from the poller
+ *
+ * @param[in]  fd   File descriptor
+ * @note Errors are ignored since fd may already be closed, which deletes it implicitly
+ */
+static void
+event_poller_del(int fd)
+{
+#if defined(EVENT_EPOLL)
+    struct epoll_event ev = {0,}; /* Non-NULL for old kernels */
+
+    if (fd < _ee_wfdlen && _ee_wfdvec[fd]){ /* Keep write event */
+        ev.events = EPOLLOUT;
+        ev.data.fd = fd;
+        epoll_ctl(_ee_pollfd, EPOLL_CTL_MOD, fd, &ev);
+    }
+    else
+        epoll_ctl(_ee_pollfd, EPOLL_CTL_DEL, fd, &ev);
+#elif defined(EVENT_KQUEUE)
+    struct kevent      kev;
+
+    EV_SET(&kev, fd, EVFILT_READ, EV_DELETE, 0, 0, NULL);
+    kevent(_ee_pollfd, &kev, 1, NULL, 0, NULL);
+#endif
+}
+
+/*! Add or remove write interest of a file descriptor in the poller
+ *
+ * Read interest of the fd is kept
+ * @param[in]  fd   File descriptor
+ * @param[in]  on   1: Add write interest, 0: Remove it
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+event_poller_write(int fd,
+                   int on)
+{
+#if defined(EVENT_EPOLL)
+    struct epoll_event ev = {0,};
+    struct event_data *e;
+    int                rd = 0;
+
+    if (fd < _ee_fdlen)
+        for (e = _ee_fdvec[fd]; e; e = e->e_fdnext)
+            if (!e->e_always)
+                rd++;
+    ev.events = (rd?EPOLLIN:0) | (on?EPOLLOUT:0);
+    ev.data.fd = fd;
+    if (ev.events == 0){
+        epoll_ctl(_ee_pollfd, EPOLL_CTL_DEL, fd, &ev);
+        return 0;
+    }
+    if (epoll_ctl(_ee_pollfd, EPOLL_CTL_MOD, fd, &ev) < 0){
+        if (errno != ENOENT ||
+            epoll_ctl(_ee_pollfd, EPOLL_CTL_ADD, fd, &ev) < 0){
+            if (on == 0) /* fd may already be closed */
+                return 0;
+            clixon_err(OE_EVENTS, errno, "epoll_ctl");
+            return -1;
+        }
+    }
+#elif defined(EVENT_KQUEUE)
+    struct kevent      kev;
+
+    EV_SET(&kev, fd, EVFILT_WRITE, on?EV_ADD:EV_DELETE, 0, 0, NULL);
+    if (kevent(_ee_pollfd, &kev, 1, NULL, 0, NULL) < 0 && on){
+        clixon_err(OE_EVENTS, errno, "kevent");
+        return -1;
+    }
+#endif
+    return 0;
+}
+
+/*! Create poller if not created, or if created by a parent process
+ *
+ * An epoll descriptor is shared with the parent after fork, and a kqueue is not inherited,
+ * so a child makes a new one and re-adds the registered file descriptors.
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+event_poller_init(void)
+{
+#if defined(EVENT_EPOLL) || defined(EVENT_KQUEUE)
+    int fd;
+
+    if (_ee_pollfd != -1 && _ee_pollpid == getpid())
+        return 0;
+#if defined(EVENT_EPOLL)
+    if (_ee_pollfd != -1)
+        close(_ee_pollfd);
+    if ((_ee_pollfd = epoll_create1(EPOLL_CLOEXEC)) < 0){
+        clixon_err(OE_EVENTS, errno, "epoll_create1");
+        return -1;
+    }
+#else /* kqueue descriptors are not inherited by fork: dont close */
+    if ((_ee_pollfd = kqueue()) < 0){
+        clixon_err(OE_EVENTS, errno, "kqueue");
+        return -1;
+    }
+    fcntl(_ee_pollfd, F_SETFD, FD_CLOEXEC);
+#endif
+    _ee_pollpid = getpid();
+    for (fd=0; fd<_ee_fdlen; fd++)
+        if (_ee_fdvec[fd] && !_ee_fdvec[fd]->e_always &&
+            event_poller_add(fd) < 0)
+            return -1;
+    for (fd=0; fd<_ee_wfdlen; fd++)
+        if (_ee_wfdvec[fd] && event_poller_write(fd, 1) < 0)
+            return -1;
+#endif
+    return 0;
+}
+
+/*! Append a file descriptor to the ready vector
+ *
+ * @param[in]  fd   File descriptor
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+event_ready_add(int fd)
+{
+    if (fd < 0 || fd >= _ee_fdlen || _ee_fdvec[fd] == NULL) /* Stale, eg unregistered */
+        return 0;
+    if (_ee_readylen >= _ee_readymax){
+        _ee_readymax = _ee_readymax ? 2*_ee_readymax : EVENT_POLL_MAX;
+        if ((_ee_ready = realloc(_ee_ready, _ee_readymax*sizeof(int))) == NULL){
+            clixon_err(OE_UNIX, errno, "realloc");
+            return -1;
+        }
+    }
+    _ee_ready[_ee_readylen++] = fd;
+    return 0;
+}
+
+/*! Append a file descriptor to the writable vector
+ *
+ * @param[in]  fd   File descriptor
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+event_wready_add(int fd)
+{
+    if (fd < 0 || fd >= _ee_wfdlen || _ee_wfdvec[fd] == NULL) /* No write event */
+        return 0;
+    if (_ee_wreadylen >= _ee_wreadymax){
+        _ee_wreadymax = _ee_wreadymax ? 2*_ee_wreadymax : EVENT_POLL_MAX;
+        if ((_ee_wready = realloc(_ee_wready, _ee_wreadymax*sizeof(int))) == NULL){
+            clixon_err(OE_UNIX, errno, "realloc");
+            return -1;
+        }
+    }
+    _ee_wready[_ee_wreadylen++] = fd;
+    return 0;
+}
+
+/*! Wait for input on registered file descriptors and collect ready fds in _ee_ready
+ *
+ * Uses epoll or kqueue if available, where the fds are registered persistently, otherwise poll
+ * Fds with write events that are writable are collected in _ee_wready
+ * @param[in]  t    Timeout, or NULL for no timeout
+ * @retval     n    Number of ready fds, 0 on timeout
+ * @retval    -1    Error, errno is set (no clixon_err)
+ */
+static int
+event_poller_wait(struct timeval *t)
+{
+    int                 retval = -1;
+    int                 ms = -1;
+    int                 n;
+    int                 i;
+    struct event_data  *e;
+    struct event_data  *e1;
+#if defined(EVENT_EPOLL)
+    struct epoll_event  evs[EVENT_POLL_MAX];
+#elif defined(EVENT_KQUEUE)
+    struct kevent       evs[EVENT_POLL_MAX];
+    struct timespec     ts;
+#else
+    struct pollfd      *pfds = NULL;
+    int                 npfds = 0;
+    int                 fd;
+#endif
+
+    _ee_readylen = 0;
+    _ee_wreadylen = 0;
+    if (t)
+        ms = t->tv_sec*1000 + (t->tv_usec+999)/1000;
+    if (_ee_always)
+        ms = 0;
+#if defined(EVENT_EPOLL)
+    if ((n = epoll_wait(_ee_pollfd, evs, EVENT_POLL_MAX, ms)) < 0)
+        goto done;
+    for (i=0; i<n; i++){
+        if ((evs[i].events & ~EPOLLOUT) && event_ready_add(evs[i].data.fd) < 0)
+            goto done;
+        if ((evs[i].events & (EPOLLOUT|EPOLLERR|EPOLLHUP)) &&
+            event_wready_add(evs[i].data.fd) < 0)
+            goto done;
+    }
+#elif defined(EVENT_KQUEUE)
+    if (ms >= 0){
+        ts.tv_sec = ms/1000;
+        ts.tv_nsec = (ms%1000)*1000000;
+    }
+    if ((n = kevent(_ee_pollfd, NULL, 0, evs, EVENT_POLL_MAX, ms>=0?&ts:NULL)) < 0)
+        goto done;
+    for (i=0; i<n; i++){
+        if (evs[i].filter == EVFILT_WRITE){
+            if (event_wready_add(evs[i].ident) < 0)
+                goto done;
+        }
+        else if (event_ready_add(evs[i].ident) < 0)
+            goto done;
+    }
+#else
+    if ((pfds = calloc(MAX(_ee_fdlen, _ee_wfdlen)+1, sizeof(*pfds))) == NULL)
+        goto done;
+    for (fd=0; fd<MAX(_ee_fdlen, _ee_wfdlen); fd++){
+        if (fd < _ee_fdlen && _ee_fdvec[fd] && !_ee_fdvec[fd]->e_always)
+            pfds[npfds].events = POLLIN;
+        if (fd < _ee_wfdlen && _ee_wfdvec[fd])
+            pfds[npfds].events |= POLLOUT;
+        if (pfds[npfds].events)
+            pfds[npfds++].fd = fd;
+    }
+    if ((n = poll(pfds, npfds, ms)) < 0)
+        goto done;
+    for (i=0; n && i<npfds; i++)
+        if (pfds[i].revents){
+            if ((pfds[i].revents & ~POLLOUT) && (pfds[i].events & POLLIN) &&
+                event_ready_add(pfds[i].fd) < 0)
+                goto done;
+            if (pfds[i].revents & (POLLOUT|POLLERR|POLLHUP) &&
+                event_wready_add(pfds[i].fd) < 0)
+                goto done;
+            n--;
+        }
+#endif
+    if (_ee_always){
+        for (e=ee; e; e=e->e_next){
+            if (e->e_type != EVENT_FD || !e->e_always)
+                continue;
+            /* Only first in fd chain */
+            for (e1=_ee_fdvec[e->e_fd]; e1 && !e1->e_always; e1=e1->e_fdnext);
+            if (e1 == e && event_ready_add(e->e_fd) < 0)
+                goto done;
+        }
+    }
+    retval = _ee_readylen;
+ done:
+#if !defined(EVENT_EPOLL) && !defined(EVENT_KQUEUE)
+    if (pfds)
+        free(pfds);
+#endif
+    return retval;
+}
+
 /*! Register a callback function to be called on input on a file descriptor.
  *
  * @param[in]  fd   File descriptor
@@ -189,7 +551,9 @@ clixon_event_reg_fd_prio(int   fd,
                          char *str,
                          int   prio)
 {
-    struct event_data *e;
+    struct event_data  *e;
+    struct event_data **fdvec;
+    int                 ret;
 
     if ((e = (struct event_data *)malloc(sizeof(struct event_data))) == NULL){
         clixon_err(OE_EVENTS, errno, "malloc");
@@ -202,6 +566,35 @@ clixon_event_reg_fd_prio(int   fd,
     e->e_arg = arg;
     e->e_type = EVENT_FD;
     e->e_prio = prio;
+    if (fd < 0){
+        clixon_err(OE_EVENTS, EBADF, "%s", str);
+        free(e);
+        return -1;
+    }
+    if (event_poller_init() < 0){
+        free(e);
+        return -1;
+    }
+    if (fd >= _ee_fdlen){
+        if ((fdvec = realloc(_ee_fdvec, (fd+1)*sizeof(*fdvec))) == NULL){
+            clixon_err(OE_EVENTS, errno, "realloc");
+            free(e);
+            return -1;
+        }
+        memset(&fdvec[_ee_fdlen], 0, (fd+1-_ee_fdlen)*sizeof(*fdvec));
+        _ee_fdvec = fdvec;
+        _ee_fdlen = fd+1;
+    }
+    if ((ret = event_poller_add(fd)) < 0){
+        free(e);
+        return -1;
+    }
+    if (ret == 0){
+        e->e_always = 1;
+        _ee_always++;
+    }
+    e->e_fdnext = _ee_fdvec[fd];
+    _ee_fdvec[fd] = e;
     e->e_next = ee;
     ee = e;
     clixon_debug(CLIXON_DBG_EVENT, "registering %s", e->e_string);
@@ -217,6 +610,27 @@ clixon_event_reg_fd(int   fd,
     return clixon_event_reg_fd_prio(fd, fn, arg, str, 0);
 }
 
+/*! Remove a file descriptor event from the fd vector, and from the poller if last on fd
+ *
+ * @param[in]  e   File descriptor event
+ */
+static void
+event_fd_rm(struct event_data *e)
+{
+    struct event_data **ep;
+
+    for (ep = &_ee_fdvec[e->e_fd]; *ep; ep = &(*ep)->e_fdnext)
+        if (*ep == e){
+            *ep = e->e_fdnext;
+            break;
+        }
+    if (e->e_always)
+        _ee_always--;
+    else if (_ee_fdvec[e->e_fd] == NULL &&
+             event_poller_init() == 0) /* Dont touch poller of parent after fork */
+        event_poller_del(e->e_fd);
+}
+
 /*! Deregister a file descriptor callback
  *
  * @param[in]  s   File descriptor
@@ -237,10 +651,11 @@ clixon_event_unreg_fd(int   s,
 
     e_prev = &ee;
     for (e = ee; e; e = e->e_next){
-        if (fn == e->e_fn && s == e->e_fd) {
+        if (fn == e->e_fn && s == e->e_fd && e->e_type == EVENT_FD && !e->e_write) {
             found++;
             *e_prev = e->e_next;
             _ee_unreg++;
+            event_fd_rm(e);
             free(e);
             break;
         }
@@ -249,6 +664,263 @@ clixon_event_unreg_fd(int   s,
     return found?0:-1;
 }
 
+/*! Register a callback function to be called when a file descriptor is writable
+ *
+ * The callback is called as long as the fd is writable, typically it writes pending output
+ * without blocking and unregisters itself when all is written.
+ * @param[in]  fd   File descriptor, eg a non-blocking socket
+ * @param[in]  fn   Function to call when fd is writable
+ * @param[in]  arg  Argument to function fn
+ * @param[in]  str  Describing string for logging
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see clixon_event_unreg_fd_write
+ */
+int
+clixon_event_reg_fd_write(int   fd,
+                          int (*fn)(int, void*),
+                          void *arg,
+                          char *str)
+{
+    struct event_data  *e;
+    struct event_data **fdvec;
+
+    if (fd < 0){
+        clixon_err(OE_EVENTS, EBADF, "%s", str);
+        return -1;
+    }
+    if ((e = (struct event_data *)malloc(sizeof(struct event_data))) == NULL){
+        clixon_err(OE_EVENTS, errno, "malloc");
+        return -1;
+    }
+    memset(e, 0, sizeof(struct event_data));
+    strncpy(e->e_string, str, EVENT_STRLEN-1);
+    e->e_fd = fd;
+    e->e_fn = fn;
+    e->e_arg = arg;
+    e->e_type = EVENT_FD;
+    e->e_write = 1;
+    if (event_poller_init() < 0){
+        free(e);
+        return -1;
+    }
+    if (fd >= _ee_wfdlen){
+        if ((fdvec = realloc(_ee_wfdvec, (fd+1)*sizeof(*fdvec))) == NULL){
+            clixon_err(OE_EVENTS, errno, "realloc");
+            free(e);
+            return -1;
+        }
+        memset(&fdvec[_ee_wfdlen], 0, (fd+1-_ee_wfdlen)*sizeof(*fdvec));
+        _ee_wfdvec = fdvec;
+        _ee_wfdlen = fd+1;
+    }
+    if (_ee_wfdvec[fd] == NULL && event_poller_write(fd, 1) < 0){
+        free(e);
+        return -1;
+    }
+    e->e_fdnext = _ee_wfdvec[fd];
+    _ee_wfdvec[fd] = e;
+    e->e_next = ee;
+    ee = e;
+    clixon_debug(CLIXON_DBG_EVENT, "registering %s", e->e_string);
+    return 0;
+}
+
+/*! Deregister a file descriptor write callback
+ *
+ * @param[in]  s   File descriptor
+ * @param[in]  fn  Function to call when fd is writable
+ * @retval     0   OK
+ * @retval    -1   Not found
+ * @see clixon_event_reg_fd_write
+ */
+int
+clixon_event_unreg_fd_write(int   s,
+                            int (*fn)(int, void*))
+{
+    struct event_data  *e;
+    struct event_data **e_prev;
+    struct event_data **ep;
+
+    e_prev = &ee;
+    for (e = ee; e; e = e->e_next){
+        if (fn == e->e_fn && s == e->e_fd && e->e_type == EVENT_FD && e->e_write){
+            *e_prev = e->e_next;
+            for (ep = &_ee_wfdvec[s]; *ep; ep = &(*ep)->e_fdnext)
+                if (*ep == e){
+                    *ep = e->e_fdnext;
+                    break;
+                }
+            if (_ee_wfdvec[s] == NULL &&
+                event_poller_init() == 0) /* Dont touch poller of parent after fork */
+                event_poller_write(s, 0);
+            free(e);
+            return 0;
+        }
+        e_prev = &e->e_next;
+    }
+    return -1;
+}
+
+/*! Timer order: expiry time, then registration order
+ */
+static int
+event_timer_lt(struct event_data *e1,
+               struct event_data *e2)
+{
+    if (timercmp(&e1->e_time, &e2->e_time, !=))
+        return timercmp(&e1->e_time, &e2->e_time, <);
+    return e1->e_seq < e2->e_seq;
+}
+
+/*! Swap two timers in the heap
+ */
+static void
+event_heap_swap(int i,
+                int j)
+{
+    struct event_data *e;
+
+    e = _ee_heap[i];
+    _ee_heap[i] = _ee_heap[j];
+    _ee_heap[j] = e;
+    _ee_heap[i]->e_heapix = i;
+    _ee_heap[j]->e_heapix = j;
+}
+
+/*! Restore heap order of a timer at index i, moving it up or down
+ */
+static void
+event_heap_fix(int i)
+{
+    int c;
+
+    while (i > 0 && event_timer_lt(_ee_heap[i], _ee_heap[(i-1)/2])){
+        event_heap_swap(i, (i-1)/2);
+        i = (i-1)/2;
+    }
+    while ((c = 2*i+1) < _ee_heaplen){
+        if (c+1 < _ee_heaplen && event_timer_lt(_ee_heap[c+1], _ee_heap[c]))
+            c++;
+        if (!event_timer_lt(_ee_heap[c], _ee_heap[i]))
+            break;
+        event_heap_swap(i, c);
+        i = c;
+    }
+}
+
+/*! Add timer to heap
+ *
+ * @param[in]  e    Timer event
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+event_heap_add(struct event_data *e)
+{
+    struct event_data **heap;
+
+    if (_ee_heaplen >= _ee_heapmax){
+        _ee_heapmax = _ee_heapmax ? 2*_ee_heapmax : EVENT_POLL_MAX;
+        if ((heap = realloc(_ee_heap, _ee_heapmax*sizeof(*heap))) == NULL){
+            clixon_err(OE_EVENTS, errno, "realloc");
+            return -1;
+        }
+        _ee_heap = heap;
+    }
+    e->e_heapix = _ee_heaplen;
+    _ee_heap[_ee_heaplen++] = e;
+    event_heap_fix(e->e_heapix);
+    return 0;
+}
+
+/*! Remove timer from heap
+ *
+ * @param[in]  e    Timer event
+ */
+static void
+event_heap_rm(struct event_data *e)
+{
+    int i = e->e_heapix;
+
+    _ee_heaplen--;
+    if (i != _ee_heaplen){
+        _ee_heap[i] = _ee_heap[_ee_heaplen];
+        _ee_heap[i]->e_heapix = i;
+        event_heap_fix(i);
+    }
+}
+
+/*! Timer hash bucket of (fn, arg)
+ *
+ * @param[in]  len  Number of buckets, power of two
+ */
+static size_t
+event_thash_key(int (*fn)(int, void*),
+                void  *arg,
+                size_t len)
+{
+    uintptr_t k;
+
+    k = (uintptr_t)fn ^ ((uintptr_t)arg * 0x9e3779b1);
+    return (k ^ (k >> 16)) & (len - 1);
+}
+
+/*! Add timer to (fn, arg) hash, grow hash if more timers than buckets
+ *
+ * @param[in]  e    Timer event
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+event_thash_add(struct event_data *e)
+{
+    struct event_data **thash;
+    struct event_data  *e1;
+    size_t              len;
+    size_t              i;
+    size_t              k;
+
+    if (_ee_heaplen > _ee_thashlen){
+        len = _ee_thashlen ? 2*_ee_thashlen : EVENT_POLL_MAX;
+        if ((thash = calloc(len, sizeof(*thash))) == NULL){
+            clixon_err(OE_EVENTS, errno, "calloc");
+            return -1;
+        }
+        for (i=0; i<_ee_thashlen; i++)
+            while ((e1 = _ee_thash[i]) != NULL){
+                _ee_thash[i] = e1->e_hnext;
+                k = event_thash_key(e1->e_fn, e1->e_arg, len);
+                e1->e_hnext = thash[k];
+                thash[k] = e1;
+            }
+        if (_ee_thash)
+            free(_ee_thash);
+        _ee_thash = thash;
+        _ee_thashlen = len;
+    }
+    k = event_thash_key(e->e_fn, e->e_arg, _ee_thashlen);
+    e->e_hnext = _ee_thash[k];
+    _ee_thash[k] = e;
+    return 0;
+}
+
+/*! Remove timer from (fn, arg) hash
+ *
+ * @param[in]  e    Timer event
+ */
+static void
+event_thash_rm(struct event_data *e)
+{
+    struct event_data **ep;
+
+    for (ep = &_ee_thash[event_thash_key(e->e_fn, e->e_arg, _ee_thashlen)]; *ep; ep = &(*ep)->e_hnext)
+        if (*ep == e){
+            *ep = e->e_hnext;
+            break;
+        }
+}
+
 /*! Call a callback function at an absolute time
  *
  * @param[in]  t   Absolute (not relative!) timestamp when callback is called
@@ -281,8 +953,6 @@ clixon_event_reg_timeout(struct timeval t,
 {
     int                 retval = -1;
     struct event_data  *e;
-    struct event_data  *e1;
-    struct event_data **e_prev;
 
     if (str == NULL || fn == NULL){
         clixon_err(OE_CFG, EINVAL, "str or fn is NULL");
@@ -298,15 +968,16 @@ clixon_event_reg_timeout(struct timeval t,
     e->e_arg = arg;
     e->e_type = EVENT_TIME;
     e->e_time = t;
-    /* Sort into right place */
-    e_prev = &ee_timers;
-    for (e1=ee_timers; e1; e1=e1->e_next){
-        if (timercmp(&e->e_time, &e1->e_time, <))
-            break;
-        e_prev = &e1->e_next;
+    e->e_seq = _ee_seq++;
+    if (event_heap_add(e) < 0){
+        free(e);
+        goto done;
+    }
+    if (event_thash_add(e) < 0){
+        event_heap_rm(e);
+        free(e);
+        goto done;
     }
-    e->e_next = e1;
-    *e_prev = e;
     clixon_debug(CLIXON_DBG_EVENT | CLIXON_DBG_DETAIL, "%s", str);
     retval = 0;
  done:
@@ -318,6 +989,7 @@ clixon_event_reg_timeout(struct timeval t,
  * Note: deregister when exactly function and function arguments match, not time. So you
  * cannot have same function and argument callback on different timeouts. This is a little
  * different from clixon_event_unreg_fd.
+ * If there are several, the first to expire is deregistered.
  * @param[in]  fn   Function to call at time t
  * @param[in]  arg  Argument to function fn
  * @retval     0    OK, timeout unregistered
@@ -330,20 +1002,20 @@ clixon_event_unreg_timeout(int (*fn)(int, void*),
                            void *arg)
 {
     struct event_data  *e;
-    int                 found = 0;
-    struct event_data **e_prev;
+    struct event_data  *e1 = NULL;
 
-    e_prev = &ee_timers;
-    for (e = ee_timers; e; e = e->e_next){
-        if (fn == e->e_fn && arg == e->e_arg) {
-            found++;
-            *e_prev = e->e_next;
-            free(e);
-            break;
-        }
-        e_prev = &e->e_next;
-    }
-    return found?0:-1;
+    if (_ee_thashlen == 0)
+        return -1;
+    for (e = _ee_thash[event_thash_key(fn, arg, _ee_thashlen)]; e; e = e->e_hnext)
+        if (fn == e->e_fn && arg == e->e_arg &&
+            (e1 == NULL || event_timer_lt(e, e1)))
+            e1 = e;
+    if (e1 == NULL)
+        return -1;
+    event_thash_rm(e1);
+    event_heap_rm(e1);
+    free(e1);
+    return 0;
 }
 
 /*! Poll to see if there is any data available on this file descriptor.
@@ -357,16 +1029,48 @@ int
 clixon_event_poll(int fd)
 {
     int            retval = -1;
-    fd_set         fdset;
-    struct timeval tnull = {0,};
+    struct pollfd  pfd = {0,};
 
-    FD_ZERO(&fdset);
-    FD_SET(fd, &fdset);
-    if ((retval = select(FD_SETSIZE, &fdset, NULL, NULL, &tnull)) < 0)
-        clixon_err(OE_EVENTS, errno, "select");
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    if ((retval = poll(&pfd, 1, 0)) < 0)
+        clixon_err(OE_EVENTS, errno, "poll");
     return retval;
 }
 
+/*! Call all expired timers
+ *
+ * Timers registered by the callbacks are not called until next time, even if expired
+ * @retval     0    OK
+ * @retval    -1    Error in callback
+ */
+static int
+event_timeout_run(void)
+{
+    struct event_data *e;
+    struct timeval     t0;
+    uint64_t           seq0;
+
+    gettimeofday(&t0, NULL);
+    seq0 = _ee_seq;
+    while (_ee_heaplen != 0 &&
+           !timercmp(&_ee_heap[0]->e_time, &t0, >) &&
+           _ee_heap[0]->e_seq < seq0){
+        e = _ee_heap[0];
+        event_heap_rm(e);
+        event_thash_rm(e);
+        clixon_debug(CLIXON_DBG_EVENT | CLIXON_DBG_DETAIL, "timeout: %s", e->e_string);
+        if ((*e->e_fn)(0, e->e_arg) < 0){
+            free(e);
+            return -1;
+        }
+        free(e);
+        if (clixon_exit_get() == 1)
+            break;
+    }
+    return 0;
+}
+
 /*! Dispatch file descriptor events (and timeouts) by invoking callbacks.
  *
  * @param[in] h  Clixon handle
@@ -381,34 +1085,34 @@ clixon_event_loop(clixon_handle h)
 {
     struct event_data *e;
     int                n;
+    int                i;
     struct timeval     t;
     struct timeval     t0;
     struct timeval     tnull = {0,};
-    fd_set             fdset;
     int                retval = -1;
     struct event_data *e_next;
+    int                prio;
 
+    if (event_poller_init() < 0)
+        goto err;
+    prio = clicon_option_bool(h, "CLICON_SOCK_PRIO");
     while (clixon_exit_get() != 1){
-        FD_ZERO(&fdset);
         if (clicon_sig_child_get()){
             /* Go through processes and wait for child processes */
             if (clixon_process_waitpid(h) < 0)
                 goto err;
             clicon_sig_child_set(0);
         }
-        for (e=ee; e; e=e->e_next)
-            if (e->e_type == EVENT_FD)
-                FD_SET(e->e_fd, &fdset);
-        if (ee_timers != NULL){
+        if (_ee_heaplen != 0){
             gettimeofday(&t0, NULL);
-            timersub(&ee_timers->e_time, &t0, &t);
+            timersub(&_ee_heap[0]->e_time, &t0, &t);
             if (t.tv_sec < 0)
-                n = select(FD_SETSIZE, &fdset, NULL, NULL, &tnull);
+                n = event_poller_wait(&tnull);
             else
-                n = select(FD_SETSIZE, &fdset, NULL, NULL, &t);
+                n = event_poller_wait(&t);
         }
         else
-            n = select(FD_SETSIZE, &fdset, NULL, NULL, NULL);
+            n = event_poller_wait(NULL);
         if (clixon_exit_get() == 1){
             break;
         }
@@ -447,54 +1151,67 @@ clixon_event_loop(clixon_handle h)
                 clixon_err(OE_EVENTS, errno, "select");
             goto err;
         }
-        if (n==0){ /* Timeout */
-            e = ee_timers;
-            ee_timers = ee_timers->e_next;
-            clixon_debug(CLIXON_DBG_EVENT | CLIXON_DBG_DETAIL, "timeout: %s", e->e_string);
-            if ((*e->e_fn)(0, e->e_arg) < 0){
-                free(e);
-                goto err;
+        /* Timeout: all expired timers are called, also if fds are ready.
+         * If a timer unregisters an fd, ready fds are served in next loop, since they may be stale
+         */
+        _ee_unreg = 0;
+        if (_ee_heaplen != 0 && event_timeout_run() < 0)
+            goto err;
+        if (_ee_unreg)
+            _ee_readylen = 0;
+        /* Only ready fds are visited. Events of a fd are looked up in the fd vector at dispatch
+         * since a callback may unregister other events.
+         */
+        _ee_unreg = 0;
+        if (prio){
+            for (i=0; i<_ee_readylen && !_ee_unreg; i++){
+                for (e=_ee_fdvec[_ee_ready[i]]; e; e=e_next) {
+                    if (clixon_exit_get() == 1)
+                        break;
+                    e_next = e->e_fdnext;
+                    if (e->e_prio){
+                        clixon_debug(CLIXON_DBG_EVENT, "FD_ISSET: %s prio:%d", e->e_string, e->e_prio);
+                        if ((*e->e_fn)(e->e_fd, e->e_arg) < 0){
+                            clixon_debug(CLIXON_DBG_EVENT, "Error in: %s", e->e_string);
+                            goto err;
+                        }
+                        if (_ee_unreg)
+                            break;
+                    }
+                }
             }
-            free(e);
+            _ee_unreg = 0;
         }
-        _ee_unreg = 0;
-        if (clicon_option_bool(h, "CLICON_SOCK_PRIO")){
-            for (e=ee; e; e=e_next) {
+        /* Unprio
+         * Note that without prio, round-robin fairness is ensured, not with prio */
+        for (i=0; i<_ee_readylen; i++){
+            for (e=_ee_fdvec[_ee_ready[i]]; e; e=e_next){
                 if (clixon_exit_get() == 1)
                     break;
-                e_next = e->e_next;
-                if (e->e_type == EVENT_FD && FD_ISSET(e->e_fd, &fdset) && e->e_prio){
-                    clixon_debug(CLIXON_DBG_EVENT, "FD_ISSET: %s prio:%d", e->e_string, e->e_prio);
+                e_next = e->e_fdnext;
+                if (e->e_prio==0){
+                    clixon_debug(CLIXON_DBG_EVENT, "FD_ISSET: %s", e->e_string);
                     if ((*e->e_fn)(e->e_fd, e->e_arg) < 0){
                         clixon_debug(CLIXON_DBG_EVENT, "Error in: %s", e->e_string);
                         goto err;
                     }
-                    if (_ee_unreg){
-                        _ee_unreg = 0;
+                    if (_ee_unreg || prio)
                         break;
-                    }
                 }
             }
-        }
-
-        /* Unprio
-         * Note that without prio, round-robin fairness is ensured, not with prio */
-        for (e=ee; e; e=e_next){
-            if (clixon_exit_get() == 1)
+            if (e != NULL) /* break: unregistered, exit or prio */
                 break;
-            e_next = e->e_next;
-            if (e->e_type == EVENT_FD && FD_ISSET(e->e_fd, &fdset) && e->e_prio==0){
-                clixon_debug(CLIXON_DBG_EVENT, "FD_ISSET: %s", e->e_string);
+        }
+        /* Writable fds. Events are looked up at dispatch since read callbacks may have
+         * unregistered them */
+        for (i=0; i<_ee_wreadylen && clixon_exit_get() != 1; i++){
+            for (e=(_ee_wready[i]<_ee_wfdlen)?_ee_wfdvec[_ee_wready[i]]:NULL; e; e=e_next){
+                e_next = e->e_fdnext;
+                clixon_debug(CLIXON_DBG_EVENT, "writable: %s", e->e_string);
                 if ((*e->e_fn)(e->e_fd, e->e_arg) < 0){
                     clixon_debug(CLIXON_DBG_EVENT, "Error in: %s", e->e_string);
                     goto err;
                 }
-                if (_ee_unreg){
-                    _ee_unreg = 0;
-                    break;
-                }
-                if (clicon_option_bool(h, "CLICON_SOCK_PRIO"))
-                    break;
             }
         }
         clixon_exit_decr(); /* If exit is set and > 1, decrement it (and exit when 1) */
@@ -521,11 +1238,37 @@ clixon_event_exit(void)
         free(e);
     }
     ee = NULL;
-    e_next = ee_timers;
-    while ((e = e_next) != NULL){
-        e_next = e->e_next;
-        free(e);
-    }
-    ee_timers = NULL;
+    while (_ee_heaplen)
+        free(_ee_heap[--_ee_heaplen]);
+    if (_ee_heap)
+        free(_ee_heap);
+    _ee_heap = NULL;
+    _ee_heapmax = 0;
+    if (_ee_thash)
+        free(_ee_thash);
+    _ee_thash = NULL;
+    _ee_thashlen = 0;
+    if (_ee_fdvec)
+        free(_ee_fdvec);
+    _ee_fdvec = NULL;
+    _ee_fdlen = 0;
+    if (_ee_wfdvec)
+        free(_ee_wfdvec);
+    _ee_wfdvec = NULL;
+    _ee_wfdlen = 0;
+    _ee_always = 0;
+    if (_ee_ready)
+        free(_ee_ready);
+    _ee_ready = NULL;
+    _ee_readylen = _ee_readymax = 0;
+    if (_ee_wready)
+        free(_ee_wready);
+    _ee_wready = NULL;
+    _ee_wreadylen = _ee_wreadymax = 0;
+#if defined(EVENT_EPOLL) || defined(EVENT_KQUEUE)
+    if (_ee_pollfd != -1 && _ee_pollpid == getpid())
+        close(_ee_pollfd);
+    _ee_pollfd = -1;
+#endif
     return 0;
 }
@@ -47,6 +47,7 @@
 #include <fcntl.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <sys/param.h>
 #include <unistd.h>
 #include <netinet/in.h>
@@ -66,6 +67,10 @@
 #include "clixon_log.h"
 #include "clixon_debug.h"
 #include "clixon_file.h"
+#include "clixon_uring.h"
+
+/* Start size of buffer when reading files that cannot be mapped, eg pipes */
+#define CLIXON_FILE_BLOCK (64*1024)
 
 /*! qsort "compar" for directory alphabetically sorting, see qsort(3)
  */
@@ -391,3 +396,285 @@ clicon_file_cbuf(const char *filename,
         errno = err;
     return retval;
 }
+
+/* Regular files of at least this size are read with io_uring, see clicon_file_uring_set */
+#define CLIXON_FILE_URING_MIN (1024*1024)
+
+/* Read large regular files with io_uring instead of mapping them */
+static int _file_uring = 0;
+
+/*! Read large regular files in clicon_file_buf with io_uring instead of mapping them
+ *
+ * @param[in]  enable  If set, use io_uring
+ * @see CLICON_XMLDB_IO_URING
+ */
+void
+clicon_file_uring_set(int enable)
+{
+    _file_uring = enable;
+}
+
+/*! Get content of an open file in a buffer followed by two null characters
+ *
+ * A regular file is mapped private and writable, so that a lexer can scan it in place, eg with
+ * flex yy_scan_buffer, without reading or copying it. The null characters are in anonymous
+ * pages mapped after the file.
+ * Other files, eg pipes, are read in large blocks into a buffer.
+ * Large regular files are read with io_uring into a buffer if enabled, see clicon_file_uring_set
+ * @param[in]   fp      Open file
+ * @param[out]  bufp    Buffer of len characters followed by two null characters
+ * @param[out]  lenp    Length of content
+ * @param[out]  maplenp Length of mapping, or 0 if the buffer is malloced
+ * @retval      0       OK
+ * @retval     -1       Error
+ * @code
+ *   if (clicon_file_buf(fp, &buf, &len, &maplen) < 0)
+ *      err;
+ *   ...
+ *   clicon_file_buf_free(buf, maplen);
+ * @endcode
+ */
+int
+clicon_file_buf(FILE    *fp,
+                char   **bufp,
+                size_t  *lenp,
+                size_t  *maplenp)
+{
+    int         retval = -1;
+    struct stat st = {0,};
+    char       *buf = NULL;
+    char       *buf1;
+    size_t      buflen;
+    size_t      len = 0;
+    size_t      n;
+
+    if (fp == NULL || bufp == NULL){
+        clixon_err(OE_UNIX, EINVAL, "fp or bufp is NULL");
+        goto done;
+    }
+    /* Only map from start of file and if nothing is buffered by stdio */
+    if (fstat(fileno(fp), &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0 &&
+        ftell(fp) == 0){
+        if (_file_uring && st.st_size >= CLIXON_FILE_URING_MIN){
+            len = st.st_size;
+            if ((buf = malloc(len + 2)) == NULL){
+                clixon_err(OE_UNIX, errno, "malloc");
+                goto done;
+            }
+            if (clixon_uring_read(fileno(fp), buf, len) < 0){
+                free(buf);
+                goto done;
+            }
+            goto ok;
+        }
+        buflen = st.st_size + 2;
+        if ((buf = mmap(NULL, buflen, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0)) == MAP_FAILED){
+            clixon_err(OE_UNIX, errno, "mmap");
+            goto done;
+        }
+        if (mmap(buf, st.st_size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_FIXED, fileno(fp), 0) == MAP_FAILED){
+            clixon_err(OE_UNIX, errno, "mmap");
+            munmap(buf, buflen);
+            goto done;
+        }
+        (void)madvise(buf, st.st_size, MADV_SEQUENTIAL);
+        *bufp = buf;
+        *lenp = st.st_size;
+        *maplenp = buflen;
+        retval = 0;
+        goto done;
+    }
+    buflen = CLIXON_FILE_BLOCK;
+    if ((buf = malloc(buflen)) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    while ((n = fread(buf+len, 1, buflen-len-2, fp)) > 0){
+        len += n;
+        if (len == buflen-2){
+            buflen *= 2;
+            if ((buf1 = realloc(buf, buflen)) == NULL){
+                clixon_err(OE_UNIX, errno, "realloc");
+                free(buf);
+                goto done;
+            }
+            buf = buf1;
+        }
+    }
+    if (ferror(fp)){
+        clixon_err(OE_UNIX, errno, "fread");
+        free(buf);
+        goto done;
+    }
+ ok:
+    buf[len] = '\0';
+    buf[len+1] = '\0';
+    *bufp = buf;
+    *lenp = len;
+    *maplenp = 0;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Free buffer with file content
+ *
+ * @param[in]   buf     Buffer
+ * @param[in]   maplen  Length of mapping, or 0 if the buffer is malloced
+ * @retval      0       OK
+ * @see clicon_file_buf
+ */
+int
+clicon_file_buf_free(char  *buf,
+                     size_t maplen)
+{
+    if (buf == NULL)
+        return 0;
+    if (maplen)
+        munmap(buf, maplen);
+    else
+        free(buf);
+    return 0;
+}
+
+/* Reusable output buffer, see clicon_file_out_init */
+static cbuf *_file_out_cb = NULL;
+static int   _file_out_busy = 0;
+
+/*! Initialize buffered output to a file
+ *
+ * The output buffer is reused between calls unless it is busy, eg in a nested call.
+ * If fn is NULL or fprintf, the buffer is written with write() directly to the file
+ * descriptor, otherwise fn is called once per chunk, eg cligen_output for paging.
+ * @param[out] fo   Buffered output
+ * @param[in]  f    Output file
+ * @param[in]  fn   Output function, or NULL
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @code
+ *   clicon_file_out fo = {0,};
+ *   if (clicon_file_out_init(&fo, f, fn) < 0)
+ *      err;
+ *   cprintf(fo.fo_cb, ...);
+ *   if (clicon_file_out_check(&fo) < 0)
+ *      err;
+ *   if (clicon_file_out_flush(fo.fo_cb, &fo) < 0)
+ *      err;
+ *   clicon_file_out_free(&fo);
+ * @endcode
+ */
+int
+clicon_file_out_init(clicon_file_out  *fo,
+                     FILE             *f,
+                     clicon_output_cb *fn)
+{
+    memset(fo, 0, sizeof(*fo));
+    fo->fo_f = f;
+    if (fn != fprintf)
+        fo->fo_fn = fn;
+    if (_file_out_busy == 0){
+        if (_file_out_cb == NULL &&
+            (_file_out_cb = cbuf_new_alloc(CLICON_FILE_OUT_SIZE)) == NULL){
+            clixon_err(OE_UNIX, errno, "cbuf_new_alloc");
+            return -1;
+        }
+        fo->fo_cb = _file_out_cb;
+        fo->fo_reuse = 1;
+        _file_out_busy = 1;
+    }
+    else if ((fo->fo_cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        return -1;
+    }
+    return 0;
+}
+
+/*! Write buffered output to file and reset buffer
+ *
+ * May be used as the flush callback of streaming serialization, see clixon_xml_flush_cb
+ * @param[in]  cb   Output buffer
+ * @param[in]  arg  Buffered output, clicon_file_out
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+clicon_file_out_flush(cbuf *cb,
+                      void *arg)
+{
+    clicon_file_out *fo = (clicon_file_out *)arg;
+    char            *buf;
+    size_t           len;
+    ssize_t          n;
+    int              fd;
+
+    if ((len = cbuf_len(cb)) == 0)
+        return 0;
+    buf = cbuf_get(cb);
+    if (fo->fo_fn)
+        (*fo->fo_fn)(fo->fo_f, "%s", buf);
+    else if ((fd = fileno(fo->fo_f)) < 0){ /* eg memory stream */
+        if (fwrite(buf, 1, len, fo->fo_f) != len){
+            clixon_err(OE_UNIX, errno, "fwrite");
+            return -1;
+        }
+    }
+    else {
+        /* Earlier stdio output goes first */
+        if (fflush(fo->fo_f) < 0){
+            clixon_err(OE_UNIX, errno, "fflush");
+            return -1;
+        }
+        while (len > 0){
+            if ((n = write(fd, buf, len)) < 0){
+                if (errno == EINTR)
+                    continue;
+                clixon_err(OE_UNIX, errno, "write");
+                return -1;
+            }
+            buf += n;
+            len -= n;
+        }
+    }
+    cbuf_reset(cb);
+    return 0;
+}
+
+/*! Flush buffered output if it exceeds the flush size
+ *
+ * @param[in]  fo   Buffered output
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+clicon_file_out_check(clicon_file_out *fo)
+{
+    if (cbuf_len(fo->fo_cb) < CLICON_FILE_OUT_SIZE)
+        return 0;
+    return clicon_file_out_flush(fo->fo_cb, fo);
+}
+
+/*! Release buffered output, remaining output is discarded
+ *
+ * @param[in]  fo   Buffered output
+ * @retval     0    OK
+ */
+int
+clicon_file_out_free(clicon_file_out *fo)
+{
+    if (fo->fo_cb == NULL)
+        return 0;
+    if (fo->fo_reuse){
+        /* Release a buffer that has grown much beyond flush size, eg a very large body */
+        if (cbuf_buflen(fo->fo_cb) > 4*CLICON_FILE_OUT_SIZE){
+            cbuf_free(fo->fo_cb);
+            _file_out_cb = NULL;
+        }
+        else
+            cbuf_reset(fo->fo_cb);
+        _file_out_busy = 0;
+    }
+    else
+        cbuf_free(fo->fo_cb);
+    fo->fo_cb = NULL;
+    return 0;
+}
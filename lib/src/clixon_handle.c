@@ -61,6 +61,7 @@
 #include "clixon_stream.h"
 #include "clixon_data.h"
 #include "clixon_options.h"
+#include "clixon_string.h"
 
 #define CLIXON_MAGIC 0x99aafabe
 
@@ -168,6 +169,7 @@ clixon_handle_exit(clixon_handle h)
     if ((ha = clicon_db_elmnt(h)) != NULL)
         clicon_hash_free(ha);
     stream_delete_all(h, 1);
+    clixon_cbuf_pool_free();
     free(ch);
     retval = 0;
     return retval;
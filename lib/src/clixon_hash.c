@@ -101,19 +101,185 @@
 #include "clixon_xml.h"
 #include "clixon_err.h"
 
-#define HASH_SIZE       1031    /* Number of hash buckets. Should be a prime */
+/*
+ * Constants
+ */
+#define HASH_SIZE_MIN   8       /* Initial number of slots, power of two */
 #define align4(s) (((s)/4)*4 + 4)
 
-/*! A very simplistic algorithm to calculate a hash bucket index
+/* Secrets of the hash function, from wyhash */
+#define HASH_S0 0xa0761d6478bd642fULL
+#define HASH_S1 0xe7037ed1a0b428dbULL
+#define HASH_S2 0x8ebc6af09c88c6e3ULL
+
+/*
+ * Types
+ */
+/* Slot of open addressing table */
+struct hash_slot {
+    uint64_t      hs_hash;   /* Hash value of key */
+    clicon_hash_t hs_entry;  /* Entry, NULL if empty */
+};
+
+/*! Hash table
+ *
+ * Open addressing with linear probing in a power of two number of slots. The table
+ * grows when more than 3/4 of the slots are used, and shrinks when less than 1/8 are.
+ * On delete the following entries of the probe sequence are shifted back, so there
+ * are no deleted markers.
+ * Entries are also in a circular list in insertion order, used for iteration. Entries
+ * are allocated separately and do not move on resize.
+ * The table is returned as clicon_hash_t * in the API, for compatibility with the
+ * earlier table of bucket lists.
+ */
+struct hash_table {
+    struct hash_slot *ht_slots;  /* Slot vector */
+    size_t            ht_size;   /* Number of slots, power of two */
+    size_t            ht_nr;     /* Number of entries */
+    clicon_hash_t     ht_list;   /* Entries in insertion order */
+};
+
+#define hash_table(hash) ((struct hash_table *)(hash))
+
+/*! Multiply to 128 bits and fold, mixing of hash function
+ */
+static inline uint64_t
+hash_mix(uint64_t a,
+         uint64_t b)
+{
+#ifdef __SIZEOF_INT128__
+    __uint128_t r = (__uint128_t)a * b;
+
+    return (uint64_t)r ^ (uint64_t)(r >> 64);
+#else
+    uint64_t ha = a >> 32, la = (uint32_t)a;
+    uint64_t hb = b >> 32, lb = (uint32_t)b;
+    uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    uint64_t t = rl + (rm0 << 32);
+    uint64_t c = t < rl;
+    uint64_t lo = t + (rm1 << 32);
+
+    c += lo < t;
+    return lo ^ (rh + (rm0 >> 32) + (rm1 >> 32) + c);
+#endif
+}
+
+static inline uint64_t
+hash_read8(const uint8_t *p)
+{
+    uint64_t v;
+
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t
+hash_read4(const uint8_t *p)
+{
+    uint32_t v;
+
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+/*! Hash value of a string, in the style of wyhash
+ *
+ * All bytes of the key affect all bits of the result, unlike a sum of characters
+ * where eg "interface1" and "1interface" collide.
+ * @param[in]  str  Null-terminated string
+ * @retval     h    Hash value
+ */
+static uint64_t
+hash_string(const char *str)
+{
+    const uint8_t *p = (const uint8_t *)str;
+    size_t         len = strlen(str);
+    size_t         i = len;
+    uint64_t       seed = HASH_S0 ^ hash_mix(HASH_S0 ^ HASH_S1, HASH_S2);
+    uint64_t       a;
+    uint64_t       b;
+
+    if (len <= 16){
+        if (len >= 4){
+            a = (hash_read4(p) << 32) | hash_read4(p + ((len >> 3) << 2));
+            b = (hash_read4(p + len - 4) << 32) | hash_read4(p + len - 4 - ((len >> 3) << 2));
+        }
+        else if (len > 0){
+            a = ((uint64_t)p[0] << 16) | ((uint64_t)p[len >> 1] << 8) | p[len - 1];
+            b = 0;
+        }
+        else
+            a = b = 0;
+    }
+    else {
+        while (i > 16){
+            seed = hash_mix(hash_read8(p) ^ HASH_S1, hash_read8(p + 8) ^ seed);
+            p += 16;
+            i -= 16;
+        }
+        a = hash_read8(p + i - 16);
+        b = hash_read8(p + i - 8);
+    }
+    return hash_mix(HASH_S1 ^ len, hash_mix(a ^ HASH_S1, b ^ seed));
+}
+
+/*! Find slot of key, or the empty slot where it would be inserted
+ *
+ * @param[in]  ht    Hash table
+ * @param[in]  key   Key
+ * @param[in]  hv    Hash value of key
+ * @retval     i     Slot index
  */
-static uint32_t
-hash_bucket(const char *str)
+static size_t
+hash_slot_find(struct hash_table *ht,
+               const char        *key,
+               uint64_t           hv)
 {
-    uint32_t n = 0;
+    size_t            mask = ht->ht_size - 1;
+    size_t            i;
+    struct hash_slot *hs;
+
+    for (i = hv & mask; ; i = (i + 1) & mask){
+        hs = &ht->ht_slots[i];
+        if (hs->hs_entry == NULL)
+            break;
+        if (hs->hs_hash == hv && strcmp(hs->hs_entry->h_key, key) == 0)
+            break;
+    }
+    return i;
+}
 
-    while(*str)
-        n += (uint32_t)*str++;
-    return n % HASH_SIZE;
+/*! Rehash all entries to a new number of slots
+ *
+ * @param[in]  ht    Hash table
+ * @param[in]  size  New number of slots, power of two, larger than number of entries
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+hash_resize(struct hash_table *ht,
+            size_t             size)
+{
+    struct hash_slot *old = ht->ht_slots;
+    size_t            oldsize = ht->ht_size;
+    size_t            mask = size - 1;
+    size_t            i;
+    size_t            j;
+
+    if ((ht->ht_slots = calloc(size, sizeof(*ht->ht_slots))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        ht->ht_slots = old;
+        return -1;
+    }
+    ht->ht_size = size;
+    for (i = 0; i < oldsize; i++){
+        if (old[i].hs_entry == NULL)
+            continue;
+        for (j = old[i].hs_hash & mask; ht->ht_slots[j].hs_entry; j = (j + 1) & mask);
+        ht->ht_slots[j] = old[i];
+    }
+    free(old);
+    return 0;
 }
 
 /*! Initialize hash table.
@@ -125,14 +291,20 @@ hash_bucket(const char *str)
 clicon_hash_t *
 clicon_hash_init(void)
 {
-  clicon_hash_t *hash;
-
-  if ((hash = (clicon_hash_t *)malloc(sizeof(clicon_hash_t) * HASH_SIZE)) == NULL){
-      clixon_err(OE_UNIX, errno, "malloc");
-      return NULL;
-  }
-  memset(hash, 0, sizeof(clicon_hash_t)*HASH_SIZE);
-  return hash;
+    struct hash_table *ht;
+
+    if ((ht = malloc(sizeof(*ht))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        return NULL;
+    }
+    memset(ht, 0, sizeof(*ht));
+    if ((ht->ht_slots = calloc(HASH_SIZE_MIN, sizeof(*ht->ht_slots))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        free(ht);
+        return NULL;
+    }
+    ht->ht_size = HASH_SIZE_MIN;
+    return (clicon_hash_t *)ht;
 }
 
 /*! Free hash table.
@@ -144,18 +316,17 @@ clicon_hash_init(void)
 int
 clicon_hash_free(clicon_hash_t *hash)
 {
-    int i;
-    clicon_hash_t tmp;
-    for (i = 0; i < HASH_SIZE; i++) {
-        while (hash[i]) {
-            tmp = hash[i];
-            DELQ(tmp, hash[i], clicon_hash_t);
-            free(tmp->h_key);
-            free(tmp->h_val);
-            free(tmp);
-        }
+    struct hash_table *ht = hash_table(hash);
+    clicon_hash_t      h;
+
+    while ((h = ht->ht_list) != NULL) {
+        DELQ(h, ht->ht_list, clicon_hash_t);
+        free(h->h_key);
+        free(h->h_val);
+        free(h);
     }
-    free(hash);
+    free(ht->ht_slots);
+    free(ht);
     return 0;
 }
 
@@ -170,19 +341,9 @@ clicon_hash_t
 clicon_hash_lookup(clicon_hash_t *hash,
                    const char    *key)
 {
-    uint32_t      bkt;
-    clicon_hash_t h;
+    struct hash_table *ht = hash_table(hash);
 
-    bkt = hash_bucket(key);
-    h = hash[bkt];
-    if (h) {
-        do {
-            if (!strcmp(h->h_key, key))
-                return h;
-            h = NEXTQ(clicon_hash_t, h);
-        } while (h != hash[bkt]);
-    }
-    return NULL;
+    return ht->ht_slots[hash_slot_find(ht, key, hash_string(key))].hs_entry;
 }
 
 /*! Get value of hash
@@ -229,14 +390,18 @@ clicon_hash_add(clicon_hash_t *hash,
                 void          *val,
                 size_t         vlen)
 {
-    void         *newval = NULL;
-    clicon_hash_t h;
-    clicon_hash_t new = NULL;
+    struct hash_table *ht;
+    void              *newval = NULL;
+    clicon_hash_t      h;
+    clicon_hash_t      new = NULL;
+    uint64_t           hv;
+    size_t             i;
 
     if (hash == NULL){
         clixon_err(OE_UNIX, EINVAL, "hash is NULL");
         return NULL;
     }
+    ht = hash_table(hash);
     /* Check NULL case */
     if ((val == NULL && vlen != 0) ||
         (val != NULL && vlen == 0)){
@@ -244,8 +409,16 @@ clicon_hash_add(clicon_hash_t *hash,
         goto catch;
     }
     /* If variable exist, don't allocate a new. just replace value */
-    h = clicon_hash_lookup(hash, key);
+    hv = hash_string(key);
+    i = hash_slot_find(ht, key, hv);
+    h = ht->ht_slots[i].hs_entry;
     if (h == NULL) {
+        /* Grow before inserting, max 3/4 used */
+        if ((ht->ht_nr + 1) * 4 > ht->ht_size * 3){
+            if (hash_resize(ht, ht->ht_size * 2) < 0)
+                goto catch;
+            i = hash_slot_find(ht, key, hv);
+        }
         if ((new = (clicon_hash_t)malloc(sizeof(*new))) == NULL){
             clixon_err(OE_UNIX, errno, "malloc");
             goto catch;
@@ -273,10 +446,13 @@ clicon_hash_add(clicon_hash_t *hash,
     h->h_val = newval;
     h->h_vlen =  vlen;
 
-    /* Add to list only if new variable */
-    if (new)
-        INSQ(h, hash[hash_bucket(key)]);
-
+    /* Add to table and last in list only if new variable */
+    if (new){
+        ht->ht_slots[i].hs_hash = hv;
+        ht->ht_slots[i].hs_entry = h;
+        ht->ht_nr++;
+        ADDQ(h, ht->ht_list);
+    }
     return h;
 
 catch:
@@ -300,24 +476,43 @@ int
 clicon_hash_del(clicon_hash_t *hash,
                 const char    *key)
 {
-    clicon_hash_t h;
+    struct hash_table *ht;
+    clicon_hash_t      h;
+    size_t             mask;
+    size_t             i;
+    size_t             j;
+    size_t             k;
 
     if (hash == NULL){
         clixon_err(OE_UNIX, EINVAL, "hash is NULL");
         return -1;
     }
-    h = clicon_hash_lookup(hash, key);
-    if (h == NULL)
+    ht = hash_table(hash);
+    mask = ht->ht_size - 1;
+    i = hash_slot_find(ht, key, hash_string(key));
+    if ((h = ht->ht_slots[i].hs_entry) == NULL)
         return -1;
-    DELQ(h, hash[hash_bucket(key)], clicon_hash_t);
+    /* Shift back following entries whose home slot is not in (i, j] */
+    for (j = (i + 1) & mask; ht->ht_slots[j].hs_entry != NULL; j = (j + 1) & mask){
+        k = ht->ht_slots[j].hs_hash & mask;
+        if (i <= j ? (i < k && k <= j) : (i < k || k <= j))
+            continue;
+        ht->ht_slots[i] = ht->ht_slots[j];
+        i = j;
+    }
+    ht->ht_slots[i].hs_entry = NULL;
+    ht->ht_nr--;
+    DELQ(h, ht->ht_list, clicon_hash_t);
     free(h->h_key);
     free(h->h_val);
     free(h);
-
+    /* Shrink, min 1/8 used. Not an error if it fails */
+    if (ht->ht_size > HASH_SIZE_MIN && ht->ht_nr * 8 < ht->ht_size)
+        (void)hash_resize(ht, ht->ht_size / 2);
     return 0;
 }
 
-/*! Return vector of keys in hash table
+/*! Return vector of keys in hash table, in insertion order
  *
  * @param[in]   hash    Hash table
  * @param[out]  vector  Vector of keys, NULL if not found
@@ -331,33 +526,27 @@ clicon_hash_keys(clicon_hash_t *hash,
                  char        ***vector,
                  size_t        *nkeys)
 {
-    int           retval = -1;
-    int           bkt;
-    clicon_hash_t h;
-    char        **tmp;
-    char        **keys = NULL;
+    int                retval = -1;
+    struct hash_table *ht;
+    clicon_hash_t      h;
+    char             **keys = NULL;
 
     if (hash == NULL){
         clixon_err(OE_UNIX, EINVAL, "hash is NULL");
         return -1;
     }
+    ht = hash_table(hash);
     *nkeys = 0;
-    for (bkt = 0; bkt < HASH_SIZE; bkt++) {
-        h = hash[bkt];
+    if (ht->ht_nr &&
+        (keys = malloc(ht->ht_nr * sizeof(char *))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto catch;
+    }
+    if ((h = ht->ht_list) != NULL)
         do {
-            if (h == NULL)
-                break;
-            tmp = realloc(keys, ((*nkeys)+1) * sizeof(char *));
-            if (tmp == NULL){
-                clixon_err(OE_UNIX, errno, "realloc");
-                goto catch;
-            }
-            keys = tmp;
-            keys[*nkeys] = h->h_key;
-            (*nkeys)++;
+            keys[(*nkeys)++] = h->h_key;
             h = NEXTQ(clicon_hash_t, h);
-        } while (h != hash[bkt]);
-    }
+        } while (h != ht->ht_list);
     if (vector){
         *vector = keys;
         keys = NULL;
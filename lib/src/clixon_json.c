@@ -53,6 +53,8 @@
 #include <limits.h>
 #include <stdint.h>
 #include <syslog.h>
+#include <dirent.h>
+#include <sys/types.h>
 
 /* cligen */
 #include <cligen/cligen.h>
@@ -66,6 +68,7 @@
 #include "clixon_xml.h"
 #include "clixon_err.h"
 #include "clixon_log.h"
+#include "clixon_file.h"
 #include "clixon_debug.h"
 #include "clixon_options.h"
 #include "clixon_yang_type.h"
@@ -75,6 +78,7 @@
 #include "clixon_xml_map.h"
 #include "clixon_xml_nsctx.h" /* namespace context */
 #include "clixon_netconf_lib.h"
+#include "clixon_xml_io.h"
 #include "clixon_json.h"
 #include "clixon_json_parse.h"
 
@@ -83,9 +87,6 @@
 */
 #define VEC_ARRAY 1
 
-/* Size of json read buffer when reading from file*/
-#define BUFLEN 1024
-
 /* Name of xml top object created by parse functions */
 #define JSON_TOP_SYMBOL "top"
 
@@ -107,6 +108,30 @@ enum childtype{
     ANY_CHILD,    /* eg <a><b/></a> or <a><b/><c/></a> */
 };
 
+/* Current JSON parser, see CLICON_JSON_PARSER */
+static int _json_parser_mode = XML_PARSER_BISON;
+
+/*! Set JSON parser
+ *
+ * Cant use option since there is no handle in json parse functions
+ * @param[in]  mode   JSON parser, see enum xml_parser_mode
+ * @retval     0      OK
+ */
+int
+json_parser_mode_set(int mode)
+{
+    _json_parser_mode = mode;
+    return 0;
+}
+
+/*! Get JSON parser
+ */
+int
+json_parser_mode_get(void)
+{
+    return _json_parser_mode;
+}
+
 /*! x is element and has exactly one child which in turn has none 
  *
  * remove attributes from x
@@ -253,39 +278,48 @@ json_str_escape_cdata(cbuf *cb,
                       char *str)
 {
     int    retval = -1;
-    size_t len;
-    int    i;
+    char  *p;
+    size_t n;
 
-    len = strlen(str);
-    for (i=0; i<len; i++)
-        switch (str[i]){
+    /* Copy runs of characters that need no escaping in one go */
+    p = str;
+    while (1){
+        if ((n = strcspn(p, "\"\\\b\f\n\r\t")) > 0){
+            if (cbuf_append_buf(cb, p, n) < 0){
+                clixon_err(OE_UNIX, errno, "cbuf_append_buf");
+                goto done;
+            }
+            p += n;
+        }
+        if (*p == '\0')
+            break;
+        switch (*p){
         case '\"':
-            cprintf(cb, "\\\"");
+            cbuf_append_str(cb, "\\\"");
             break;
         case '\\':
-            cprintf(cb, "\\\\");
+            cbuf_append_str(cb, "\\\\");
             break;
         case '\b':
-            cprintf(cb, "\\b");
+            cbuf_append_str(cb, "\\b");
             break;
         case '\f':
-            cprintf(cb, "\\f");
+            cbuf_append_str(cb, "\\f");
             break;
         case '\n':
-            cprintf(cb, "\\n");
+            cbuf_append_str(cb, "\\n");
             break;
         case '\r':
-            cprintf(cb, "\\r");
+            cbuf_append_str(cb, "\\r");
             break;
         case '\t':
-            cprintf(cb, "\\t");
-            break;
-        default: /* fall thru */
-            cprintf(cb, "%c", str[i]);
+            cbuf_append_str(cb, "\\t");
             break;
         }
+        p++;
+    }
     retval = 0;
-    // done:
+ done:
     return retval;
 }
 
@@ -781,6 +815,16 @@ xml2json_encode_attr(cxobj     *xa,
     return retval;
 }
 
+/*! Flush state of streaming JSON serialization
+ *
+ * @see clixon_json2cbuf_stream
+ */
+struct json_flush {
+    size_t               jf_size; /* Flush when output exceeds this size */
+    clixon_xml_flush_cb *jf_fn;   /* Flush callback */
+    void                *jf_arg;  /* Flush callback argument */
+};
+
 /*! Do the actual work of translating XML to JSON 
  *
  * @param[out]  cb        Cligen text buffer containing json on exit
@@ -830,7 +874,8 @@ xml2json1_cbuf(cbuf                   *cb,
                int                     pretty,
                int                     flat,
                char                   *modname0,
-               cbuf                   *metacbp)
+               cbuf                   *metacbp,
+               struct json_flush      *fl)
 {
     int              retval = -1;
     int              i;
@@ -843,7 +888,21 @@ xml2json1_cbuf(cbuf                   *cb,
     int              commas;
     char            *modname = NULL;
     cbuf            *metacbc = NULL;
+    cxobj           *xd;
 
+    /* Raw anydata content: print a parsed copy */
+    if (xml_flag(x, XML_FLAG_OPAQUE)){
+        if ((xd = xml_dup(x)) == NULL)
+            goto done;
+        if (xml_opaque_expand(xd) < 0 ||
+            xml2json1_cbuf(cb, xd, arraytype, level, pretty, flat, modname0, metacbp, fl) < 0){
+            xml_free(xd);
+            goto done;
+        }
+        xml_free(xd);
+        retval = 0;
+        goto done;
+    }
     if ((ys = xml_spec(x)) != NULL){
         if (ys_real_module(ys, &ymod) < 0)
             goto done;
@@ -872,7 +931,9 @@ xml2json1_cbuf(cbuf                   *cb,
         break;
     case NO_ARRAY:
         if (!flat){
-            cprintf(cb, "%*s\"", pretty?(level*PRETTYPRINT_INDENT):0, "");
+            if (pretty && clixon_cbuf_indent(cb, level*PRETTYPRINT_INDENT) < 0)
+                goto done;
+            cbuf_append(cb, '"');
             if (modname)
                 cprintf(cb, "%s:", modname);
             cprintf(cb, "%s\":%s", xml_name(x), pretty?" ":"");
@@ -893,14 +954,19 @@ xml2json1_cbuf(cbuf                   *cb,
         break;
     case FIRST_ARRAY:
     case SINGLE_ARRAY:
-        cprintf(cb, "%*s\"", pretty?(level*PRETTYPRINT_INDENT):0, "");
+        if (pretty && clixon_cbuf_indent(cb, level*PRETTYPRINT_INDENT) < 0)
+            goto done;
+        cbuf_append(cb, '"');
         if (modname)
             cprintf(cb, "%s:", modname);
         cprintf(cb, "%s\":%s", xml_name(x), pretty?" ":"");
         level++;
-        cprintf(cb, "[%s%*s",
-                pretty?"\n":"",
-                pretty?(level*PRETTYPRINT_INDENT):0, "");
+        cbuf_append(cb, '[');
+        if (pretty){
+            cbuf_append(cb, '\n');
+            if (clixon_cbuf_indent(cb, level*PRETTYPRINT_INDENT) < 0)
+                goto done;
+        }
         switch (childt){
         case NULL_CHILD:
             if (nullchild(cb, x, ys) < 0)
@@ -918,8 +984,8 @@ xml2json1_cbuf(cbuf                   *cb,
     case MIDDLE_ARRAY:
     case LAST_ARRAY:
         level++;
-        cprintf(cb, "%*s",
-                pretty?(level*PRETTYPRINT_INDENT):0, "");
+        if (pretty && clixon_cbuf_indent(cb, level*PRETTYPRINT_INDENT) < 0)
+            goto done;
         switch (childt){
         case NULL_CHILD:
             if (nullchild(cb, x, ys) < 0)
@@ -961,12 +1027,17 @@ xml2json1_cbuf(cbuf                   *cb,
                            xc,
                            xc_arraytype,
                            level+1, pretty, 0, modname0,
-                           metacbc) < 0)
+                           metacbc, fl) < 0)
             goto done;
         if (commas > 0) {
             cprintf(cb, ",%s", pretty?"\n":"");
             --commas;
         }
+        if (fl && cbuf_len(cb) >= fl->jf_size){
+            if (fl->jf_fn(cb, fl->jf_arg) < 0)
+                goto done;
+            cbuf_reset(cb);
+        }
     }
     if (cbuf_len(metacbc)){
         cprintf(cb, "%s", cbuf_get(metacbc));
@@ -981,9 +1052,12 @@ xml2json1_cbuf(cbuf                   *cb,
         case BODY_CHILD:
             break;
         case ANY_CHILD:
-            cprintf(cb, "%s%*s}",
-                    pretty?"\n":"",
-                    pretty?(level*PRETTYPRINT_INDENT):0, "");
+            if (pretty){
+                cbuf_append(cb, '\n');
+                if (clixon_cbuf_indent(cb, level*PRETTYPRINT_INDENT) < 0)
+                    goto done;
+            }
+            cbuf_append(cb, '}');
             break;
         default:
             break;
@@ -997,9 +1071,12 @@ xml2json1_cbuf(cbuf                   *cb,
         case BODY_CHILD:
             break;
         case ANY_CHILD:
-            cprintf(cb, "%s%*s}",
-                    pretty?"\n":"",
-                    pretty?(level*PRETTYPRINT_INDENT):0, "");
+            if (pretty){
+                cbuf_append(cb, '\n');
+                if (clixon_cbuf_indent(cb, level*PRETTYPRINT_INDENT) < 0)
+                    goto done;
+            }
+            cbuf_append(cb, '}');
             level--;
             break;
         default:
@@ -1014,17 +1091,21 @@ xml2json1_cbuf(cbuf                   *cb,
             cprintf(cb, "%s",pretty?"\n":"");
             break;
         case ANY_CHILD:
-            cprintf(cb, "%s%*s}",
-                    pretty?"\n":"",
-                    pretty?(level*PRETTYPRINT_INDENT):0, "");
+            if (pretty){
+                cbuf_append(cb, '\n');
+                if (clixon_cbuf_indent(cb, level*PRETTYPRINT_INDENT) < 0)
+                    goto done;
+            }
+            cbuf_append(cb, '}');
             cprintf(cb, "%s",pretty?"\n":"");
             level--;
             break;
         default:
             break;
         }
-        cprintf(cb, "%*s]",
-                pretty?(level*PRETTYPRINT_INDENT):0,"");
+        if (pretty && clixon_cbuf_indent(cb, level*PRETTYPRINT_INDENT) < 0)
+            goto done;
+        cbuf_append(cb, ']');
         break;
     default:
         break;
@@ -1045,6 +1126,7 @@ xml2json1_cbuf(cbuf                   *cb,
  * @param[in]     x      XML tree to translate from
  * @param[in]     pretty Set if output is pretty-printed
  * @param[in]     autocliext How to handle autocli extensions: 0: ignore 1: follow
+ * @param[in]     fl     Flush state if streaming, or NULL
  * @retval        0      OK
  * @retval       -1      Error
  *
@@ -1052,10 +1134,11 @@ xml2json1_cbuf(cbuf                   *cb,
  * @see xml2json_cbuf_vec   Top symbol is list
  */
 static int
-xml2json_cbuf1(cbuf   *cb,
-               cxobj  *x,
-               int     pretty,
-               int     autocliext)
+xml2json_cbuf1(cbuf              *cb,
+               cxobj             *x,
+               int                pretty,
+               int                autocliext,
+               struct json_flush *fl)
 {
     int                     retval = 1;
     int                     level = 0;
@@ -1091,7 +1174,8 @@ xml2json_cbuf1(cbuf   *cb,
                        pretty,
                        0,
                        NULL, /* ancestor modname / namespace */
-                       NULL) < 0)
+                       NULL,
+                       fl) < 0)
         goto done;
     cprintf(cb, "%s%*s}%s",
             pretty?"\n":"",
@@ -1139,12 +1223,12 @@ clixon_json2cbuf(cbuf  *cb,
         while ((xc = xml_child_each(xt, xc, CX_ELMNT)) != NULL){
             if (i++)
                 cprintf(cb, ",");
-            if (xml2json_cbuf1(cb, xc, pretty, autocliext) < 0)
+            if (xml2json_cbuf1(cb, xc, pretty, autocliext, NULL) < 0)
                 goto done;
         }
     }
     else {
-        if (xml2json_cbuf1(cb, xt, pretty, autocliext) < 0)
+        if (xml2json_cbuf1(cb, xt, pretty, autocliext, NULL) < 0)
             goto done;
     }
     retval = 0;
@@ -1161,18 +1245,20 @@ clixon_json2cbuf(cbuf  *cb,
  * @param[in]  veclen Length of vector
  * @param[in]  pretty Set if output is pretty-printed (2 for debug)
  * @param[in]  skiptop 0: Include top object 1: Skip top-object, only children, 
+ * @param[in]  fl     Flush state if streaming, or NULL
  * @retval     0      OK
  * @retval    -1      Error
  * @note This only works if the vector is uniform, ie same object name.
  * Example: <b/><c/> --> <a><b/><c/></a> --> {"b" : null,"c" : null}
  * @see clixon_json2cbuf
  */
-int
-xml2json_cbuf_vec(cbuf      *cb,
-                  cxobj    **vec,
-                  size_t     veclen,
-                  int        pretty,
-                  int        skiptop)
+static int
+xml2json_cbuf_vec1(cbuf              *cb,
+                   cxobj            **vec,
+                   size_t             veclen,
+                   int                pretty,
+                   int                skiptop,
+                   struct json_flush *fl)
 {
     int    retval = -1;
     int    level = 0;
@@ -1217,7 +1303,7 @@ xml2json_cbuf_vec(cbuf      *cb,
                        NO_ARRAY,
                        level,
                        pretty,
-                       1, NULL, NULL) < 0)
+                       1, NULL, NULL, fl) < 0)
         goto done;
 
     if (0){
@@ -1235,6 +1321,82 @@ xml2json_cbuf_vec(cbuf      *cb,
     return retval;
 }
 
+/*! Translate a vector of xml objects to JSON Cligen buffer.
+ *
+ * @param[out] cb     Cligen buffer to write to
+ * @param[in]  vec    Vector of xml objecst
+ * @param[in]  veclen Length of vector
+ * @param[in]  pretty Set if output is pretty-printed (2 for debug)
+ * @param[in]  skiptop 0: Include top object 1: Skip top-object, only children, 
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see xml2json_cbuf_vec1
+ */
+int
+xml2json_cbuf_vec(cbuf      *cb,
+                  cxobj    **vec,
+                  size_t     veclen,
+                  int        pretty,
+                  int        skiptop)
+{
+    return xml2json_cbuf_vec1(cb, vec, veclen, pretty, skiptop, NULL);
+}
+
+/*! Translate an XML tree to JSON in a cligen buffer and flush the buffer while serializing
+ *
+ * Same output as clixon_json2cbuf without skiptop, but whenever the buffer exceeds size
+ * after a child element, the flush callback is called and the buffer is reset.
+ * Output remaining after the tree is left in cb.
+ * @param[in,out] cb     Cligen buffer to write to
+ * @param[in]     xt     Top-level xml object
+ * @param[in]     pretty Set if output is pretty-printed
+ * @param[in]     size   Flush when buffer exceeds this size
+ * @param[in]     fn     Flush callback, see clixon_xml_flush_cb
+ * @param[in]     arg    Flush callback argument
+ * @retval        0      OK
+ * @retval       -1      Error
+ * @see clixon_xml2cbuf_stream  XML corresponding function
+ */
+int
+clixon_json2cbuf_stream(cbuf                *cb,
+                        cxobj               *xt,
+                        int                  pretty,
+                        size_t               size,
+                        clixon_xml_flush_cb *fn,
+                        void                *arg)
+{
+    struct json_flush fl = {size, fn, arg};
+
+    return xml2json_cbuf1(cb, xt, pretty, 0, &fl);
+}
+
+/*! Translate a vector of xml objects to JSON in a cligen buffer and flush while serializing
+ *
+ * Same output as xml2json_cbuf_vec without skiptop, flushed as clixon_json2cbuf_stream
+ * @param[out] cb     Cligen buffer to write to
+ * @param[in]  vec    Vector of xml objecst
+ * @param[in]  veclen Length of vector
+ * @param[in]  pretty Set if output is pretty-printed
+ * @param[in]  size   Flush when buffer exceeds this size
+ * @param[in]  fn     Flush callback, see clixon_xml_flush_cb
+ * @param[in]  arg    Flush callback argument
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+int
+xml2json_cbuf_vec_stream(cbuf                *cb,
+                         cxobj              **vec,
+                         size_t               veclen,
+                         int                  pretty,
+                         size_t               size,
+                         clixon_xml_flush_cb *fn,
+                         void                *arg)
+{
+    struct json_flush fl = {size, fn, arg};
+
+    return xml2json_cbuf_vec1(cb, vec, veclen, pretty, 0, &fl);
+}
+
 /*! Translate from xml tree to JSON and print to file using a callback
  *
  * @param[in]  f       File to print to
@@ -1261,22 +1423,32 @@ clixon_json2file(FILE             *f,
                  int               skiptop,
                  int               autocliext)
 {
-    int   retval = 1;
-    cbuf *cb = NULL;
+    int               retval = 1;
+    clicon_file_out   fo = {0,};
+    struct json_flush fl = {CLICON_FILE_OUT_SIZE, clicon_file_out_flush, &fo};
+    cxobj            *xc;
+    int               i = 0;
 
-    if (fn == NULL)
-        fn = fprintf;
-    if ((cb = cbuf_new()) ==NULL){
-        clixon_err(OE_XML, errno, "cbuf_new");
+    if (clicon_file_out_init(&fo, f, fn) < 0)
         goto done;
+    if (skiptop){
+        xc = NULL;
+        while ((xc = xml_child_each(xn, xc, CX_ELMNT)) != NULL){
+            if (i++)
+                cbuf_append(fo.fo_cb, ',');
+            if (xml2json_cbuf1(fo.fo_cb, xc, pretty, autocliext, &fl) < 0)
+                goto done;
+        }
+    }
+    else {
+        if (xml2json_cbuf1(fo.fo_cb, xn, pretty, autocliext, &fl) < 0)
+            goto done;
     }
-    if (clixon_json2cbuf(cb, xn, pretty, skiptop, autocliext) < 0)
+    if (clicon_file_out_flush(fo.fo_cb, &fo) < 0)
         goto done;
-    (*fn)(f, "%s", cbuf_get(cb));
     retval = 0;
  done:
-    if (cb)
-        cbuf_free(cb);
+    clicon_file_out_free(&fo);
     return retval;
 }
 
@@ -1316,20 +1488,20 @@ xml2json_vec(FILE             *f,
              clicon_output_cb *fn,
              int               skiptop)
 {
-    int   retval = 1;
-    cbuf *cb = NULL;
+    int               retval = 1;
+    clicon_file_out   fo = {0,};
+    struct json_flush fl = {CLICON_FILE_OUT_SIZE, clicon_file_out_flush, &fo};
 
-    if ((cb = cbuf_new()) == NULL){
-        clixon_err(OE_XML, errno, "cbuf_new");
+    if (clicon_file_out_init(&fo, f, fn) < 0)
         goto done;
-    }
-    if (xml2json_cbuf_vec(cb, vec, veclen, pretty, skiptop) < 0)
+    if (xml2json_cbuf_vec1(fo.fo_cb, vec, veclen, pretty, skiptop, &fl) < 0)
+        goto done;
+    cbuf_append(fo.fo_cb, '\n');
+    if (clicon_file_out_flush(fo.fo_cb, &fo) < 0)
         goto done;
-    (*fn)(f, "%s\n", cbuf_get(cb));
     retval = 0;
  done:
-    if (cb)
-        cbuf_free(cb);
+    clicon_file_out_free(&fo);
     return retval;
 }
 
@@ -1406,6 +1578,8 @@ json_xmlns_translate(yang_stmt *yspec,
  * are split and interpreted as in RFC7951
  *
  * @param[in]  str    Input string containing JSON
+ * @param[in]  len    If > 0, str is a writable buffer of len characters followed by two null
+ *                    characters that is scanned in place, see clicon_file_buf
  * @param[in]  rfc7951 Do sanity checks according to RFC 7951 JSON Encoding of Data Modeled with YANG
  * @param[in]  yb     How to bind yang to XML top-level when parsing (if rfc7951)
  * @param[in]  yspec  Yang specification (if rfc 7951)
@@ -1416,11 +1590,13 @@ json_xmlns_translate(yang_stmt *yspec,
  * @retval    -1      Error
  * 
  * @see _xml_parse for XML variant
+ * @see clixon_json_scan  used instead of the bison parser if CLICON_JSON_PARSER is fast
  * @see http://www.ecma-international.org/publications/files/ECMA-ST/ECMA-404.pdf
  * @see RFC 7951
  */
 static int
 _json_parse(char      *str,
+            size_t     len,
             int        rfc7951,
             yang_bind  yb,
             yang_stmt *yspec,
@@ -1437,43 +1613,57 @@ _json_parse(char      *str,
 
     clixon_debug(CLIXON_DBG_PARSE, "%s", str);
     jy.jy_parse_string = str;
+    jy.jy_parse_len = len;
     jy.jy_linenum = 1;
     jy.jy_current = xt;
     jy.jy_xtop = xt;
-    if (json_scan_init(&jy) < 0)
-        goto done;
-    if (json_parse_init(&jy) < 0)
-        goto done;
-    if (clixon_json_parseparse(&jy) != 0) { /* yacc returns 1 on error */
-        clixon_log(NULL, LOG_NOTICE, "JSON error: line %d", jy.jy_linenum);
-        if (clixon_err_category() == 0)
-            clixon_err(OE_JSON, 0, "JSON parser error with no error code (should not happen)");
-        goto done;
+    if (_json_parser_mode == XML_PARSER_FAST){
+        /* The scanner checks and translates namespaces while parsing */
+        if ((ret = clixon_json_scan(&jy, rfc7951, yb, yspec, xerr)) < 0){
+            clixon_log(NULL, LOG_NOTICE, "JSON error: line %d", jy.jy_linenum);
+            goto done;
+        }
+        if (ret == 0)
+            goto fail;
+    }
+    else {
+        if (json_scan_init(&jy) < 0)
+            goto done;
+        if (json_parse_init(&jy) < 0)
+            goto done;
+        if (clixon_json_parseparse(&jy) != 0) { /* yacc returns 1 on error */
+            clixon_log(NULL, LOG_NOTICE, "JSON error: line %d", jy.jy_linenum);
+            if (clixon_err_category() == 0)
+                clixon_err(OE_JSON, 0, "JSON parser error with no error code (should not happen)");
+            goto done;
+        }
     }
     /* Traverse new objects */
     for (i = 0; i < jy.jy_xlen; i++) {
         x = jy.jy_xvec[i];
-        /* RFC 7951 Section 4: A namespace-qualified member name MUST be used for all 
-         * members of a top-level JSON object 
-         */
-        if (rfc7951 && xml_prefix(x) == NULL){
-            /* XXX: For top-level config file: */
-            if (yb != YB_NONE || strcmp(xml_name(x),DATASTORE_TOP_SYMBOL)!=0){
-                if ((cberr = cbuf_new()) == NULL){
-                    clixon_err(OE_UNIX, errno, "cbuf_new");
-                    goto done;
+        if (_json_parser_mode != XML_PARSER_FAST){
+            /* RFC 7951 Section 4: A namespace-qualified member name MUST be used for all
+             * members of a top-level JSON object
+             */
+            if (rfc7951 && xml_prefix(x) == NULL){
+                /* XXX: For top-level config file: */
+                if (yb != YB_NONE || strcmp(xml_name(x),DATASTORE_TOP_SYMBOL)!=0){
+                    if ((cberr = cbuf_new()) == NULL){
+                        clixon_err(OE_UNIX, errno, "cbuf_new");
+                        goto done;
+                    }
+                    cprintf(cberr, "Top-level JSON object %s is not qualified with namespace which is a MUST according to RFC 7951", xml_name(x));
+                    if (xerr && netconf_malformed_message_xml(xerr, cbuf_get(cberr)) < 0)
+                        goto done;
+                    goto fail;
                 }
-                cprintf(cberr, "Top-level JSON object %s is not qualified with namespace which is a MUST according to RFC 7951", xml_name(x));
-                if (xerr && netconf_malformed_message_xml(xerr, cbuf_get(cberr)) < 0)
-                    goto done;
-                goto fail;
             }
+            /* Names are split into name/prefix, but now add namespace info */
+            if ((ret = json_xmlns_translate(yspec, x, xerr)) < 0)
+                goto done;
+            if (ret == 0)
+                goto fail;
         }
-        /* Names are split into name/prefix, but now add namespace info */
-        if ((ret = json_xmlns_translate(yspec, x, xerr)) < 0)
-            goto done;
-        if (ret == 0)
-            goto fail;
         /* Now assign yang stmts to each XML node 
          * XXX should be xml_bind_yang0_parent() sometimes.
          */
@@ -1524,8 +1714,10 @@ _json_parse(char      *str,
     clixon_debug(CLIXON_DBG_PARSE, "retval:%d", retval);
     if (cberr)
         cbuf_free(cberr);
-    json_parse_exit(&jy);
-    json_scan_exit(&jy);
+    if (jy.jy_lexbuf){
+        json_parse_exit(&jy);
+        json_scan_exit(&jy);
+    }
     if (jy.jy_xvec)
         free(jy.jy_xvec);
     return retval;
@@ -1573,7 +1765,7 @@ clixon_json_parse_string(char      *str,
         if ((*xt = xml_new("top", NULL, CX_ELMNT)) == NULL)
             return -1;
     }
-    return _json_parse(str, rfc7951, yb, yspec, *xt, xerr);
+    return _json_parse(str, 0, rfc7951, yb, yspec, *xt, xerr);
 }
 
 /*! Read a JSON definition from file and parse it into a parse-tree. 
@@ -1607,6 +1799,7 @@ clixon_json_parse_string(char      *str,
  * @note  you need to free the xml parse tree after use, using xml_free()
  * @note, If xt empty, a top-level symbol will be added so that <tree../> will be:  <top><tree.../></tree></top>
  * @note May block on file I/O
+ * @note Tree is allocated from XML arena if enabled, see xml_arena_enable
  * @see clixon_json_parse_string
  * @see RFC7951
  */
@@ -1621,60 +1814,34 @@ clixon_json_parse_file(FILE      *fp,
     int       retval = -1;
     int       ret;
     char     *jsonbuf = NULL;
-    int       jsonbuflen = BUFLEN; /* start size */
-    int       oldjsonbuflen;
-    char     *ptr;
-    char      ch;
-    int       len = 0;
+    size_t    len = 0;
+    size_t    maplen = 0;
 
     if (xt==NULL){
         clixon_err(OE_JSON, EINVAL, "xt is NULL");
         return -1;
     }
-    if ((jsonbuf = malloc(jsonbuflen)) == NULL){
-        clixon_err(OE_JSON, errno, "malloc");
+    xml_arena_push();
+    /* Map or read file in one go and scan it in place */
+    if (clicon_file_buf(fp, &jsonbuf, &len, &maplen) < 0)
         goto done;
-    }
-    memset(jsonbuf, 0, jsonbuflen);
-    ptr = jsonbuf;
-    while (1){
-        if ((ret = fread(&ch, 1, 1, fp)) < 0){
-            clixon_err(OE_JSON, errno, "read");
-            break;
-        }
-        if (ret != 0)
-            jsonbuf[len++] = ch;
-        if (ret == 0){
-            if (*xt == NULL)
-                if ((*xt = xml_new(JSON_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
-                    goto done;
-            if (len){
-                if ((ret = _json_parse(ptr, rfc7951, yb, yspec, *xt, xerr)) < 0)
-                    goto done;
-                if (ret == 0)
-                    goto fail;
-            }
-            break;
-        }
-        if (len >= jsonbuflen-1){ /* Space: one for the null character */
-            oldjsonbuflen = jsonbuflen;
-            jsonbuflen *= 2;
-            if ((jsonbuf = realloc(jsonbuf, jsonbuflen)) == NULL){
-                clixon_err(OE_JSON, errno, "realloc");
-                goto done;
-            }
-            memset(jsonbuf+oldjsonbuflen, 0, jsonbuflen-oldjsonbuflen);
-            ptr = jsonbuf;
-        }
+    if (*xt == NULL)
+        if ((*xt = xml_new(JSON_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
+            goto done;
+    if (len){
+        if ((ret = _json_parse(jsonbuf, len, rfc7951, yb, yspec, *xt, xerr)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
     }
     retval = 1;
  done:
     if (retval < 0 && *xt){
-        free(*xt);
+        xml_free(*xt);
         *xt = NULL;
     }
-    if (jsonbuf)
-        free(jsonbuf);
+    xml_arena_pop();
+    clicon_file_buf_free(jsonbuf, maplen);
     return retval;
  fail:
     retval = 0;
@@ -43,6 +43,7 @@
 struct clixon_json_yacc {
     int        jy_linenum;      /* Number of \n in parsed buffer */
     char      *jy_parse_string; /* original (copy of) parse string */
+    size_t     jy_parse_len;    /* If set, scan parse string of this length in place */
     void      *jy_lexbuf;       /* internal parse buffer from lex */
     cxobj     *jy_xtop;         /* cxobj top element (fixed) */
     cxobj     *jy_current;      /* cxobj active element (changes with parse context) */
@@ -70,4 +71,6 @@ int clixon_json_parselex(void *);
 int clixon_json_parseparse(void *);
 void clixon_json_parseerror(void *, char*);
 
+int clixon_json_scan(clixon_json_yacc *jy, int rfc7951, yang_bind yb, yang_stmt *yspec, cxobj **xerr);
+
 #endif  /* _CLIXON_JSON_PARSE_H_ */
@@ -0,0 +1,581 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, indicate
+  your decision by deleting the provisions above and replace them with the
+  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Hand-written JSON scanner
+ * An alternative to the flex/bison JSON parser in clixon_json_parse.[ly] that scans the
+ * input in a single pass and creates the XML tree directly.
+ * Strings are located with strcspn which libc implements with vector instructions, and
+ * are decoded once into a scratch buffer.
+ * RFC 7951 module names are resolved to XML namespaces when an element is created, with
+ * the last module cached, instead of in a separate pass over the tree.
+ * The resulting tree is the same as the bison parser, which is the reference.
+ * @see CLICON_JSON_PARSER
+ * @see clixon_json_parse.y
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <string.h>
+#include <stdint.h>
+#include <ctype.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_string.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_err.h"
+#include "clixon_log.h"
+#include "clixon_debug.h"
+#include "clixon_yang_module.h"
+#include "clixon_xml_vec.h"
+#include "clixon_xml_map.h"
+#include "clixon_netconf_lib.h"
+#include "clixon_json_parse.h"
+
+/* Max nesting of objects and arrays */
+#define JSON_SCAN_DEPTH_MAX 10000
+
+#define JSON_SCAN_WHITE(c) ((c) == ' ' || (c) == '\t' || (c) == '\n' || (c) == '\r')
+
+/*! Scanner state
+ */
+typedef struct {
+    clixon_json_yacc *js_jy;     /* Parser struct shared with the bison parser */
+    int               js_rfc7951; /* Check top-level names according to RFC 7951 */
+    yang_bind         js_yb;     /* Yang binding, for top-level check */
+    yang_stmt        *js_yspec;  /* Yang spec for module name to namespace translation */
+    cxobj           **js_xerr;   /* Reason for invalid namespace */
+    yang_stmt        *js_ymod;   /* Last module, cache for namespace translation */
+    cbuf             *js_str;    /* Scratch for decoded strings */
+    int               js_depth;  /* Current nesting */
+} json_scan_t;
+
+static int json_scan_value(json_scan_t *js, char **pp, char *modname);
+
+/*! Report syntax error in the same format as the bison parser
+ *
+ * Line numbers are counted only on error
+ * @param[in]  js  Scanner state
+ * @param[in]  p   Position of error
+ * @retval    -1   Always
+ * @see clixon_json_parseerror
+ */
+static int
+json_scan_error(json_scan_t *js,
+                char        *p)
+{
+    clixon_json_yacc *jy = js->js_jy;
+    char             *q;
+
+    jy->jy_linenum = 1;
+    for (q = jy->jy_parse_string; (q = memchr(q, '\n', p - q)) != NULL; q++)
+        jy->jy_linenum++;
+    clixon_err(OE_JSON, 0, "json_parse: line %d: syntax error at or before: '%.*s'",
+               jy->jy_linenum, *p ? 1 : 0, p);
+    return -1;
+}
+
+static char *
+json_scan_white(char *p)
+{
+    while (JSON_SCAN_WHITE(*p))
+        p++;
+    return p;
+}
+
+/*! Scan and decode double quoted string into scratch buffer
+ *
+ * @param[in]     js   Scanner state
+ * @param[in,out] pp   Position at '"', moved past end quote
+ * @retval        0    OK, decoded string in js_str
+ * @retval       -1    Error
+ */
+static int
+json_scan_string(json_scan_t *js,
+                 char       **pp)
+{
+    cbuf  *cb = js->js_str;
+    char  *p = *pp + 1;
+    size_t n;
+    char   hex[5];
+    char   utf[5];
+    int    i;
+
+    cbuf_reset(cb);
+    while (1){
+        n = strcspn(p, "\"\\\b\f\n\r\t");
+        if (n && cbuf_append_buf(cb, p, n) < 0){
+            clixon_err(OE_JSON, errno, "cbuf_append_buf");
+            return -1;
+        }
+        p += n;
+        if (*p == '"')
+            break;
+        if (*p != '\\') /* Control character or end of input */
+            return json_scan_error(js, p);
+        p++;
+        switch (*p){
+        case '"':
+        case '\\':
+        case '/':
+            cbuf_append(cb, *p);
+            break;
+        case 'b':
+            cbuf_append(cb, '\b');
+            break;
+        case 'f':
+            cbuf_append(cb, '\f');
+            break;
+        case 'n':
+            cbuf_append(cb, '\n');
+            break;
+        case 'r':
+            cbuf_append(cb, '\r');
+            break;
+        case 't':
+            cbuf_append(cb, '\t');
+            break;
+        case 'u':
+            for (i = 0; i < 4; i++){
+                if (!isxdigit((unsigned char)p[i+1]))
+                    return json_scan_error(js, p+i+1);
+                hex[i] = p[i+1];
+            }
+            hex[4] = '\0';
+            if (clixon_unicode2utf8(hex, utf, sizeof(utf)) < 0)
+                return -1;
+            cbuf_append_str(cb, utf);
+            p += 4;
+            break;
+        default:
+            return json_scan_error(js, p);
+        }
+        p++;
+    }
+    *pp = p + 1;
+    return 0;
+}
+
+/*! Translate RFC 7951 module name of element to XML default namespace
+ *
+ * @param[in]  js      Scanner state
+ * @param[in]  x       XML element
+ * @param[in]  modname Module name
+ * @retval     1       OK
+ * @retval     0       Invalid, unknown module, js_xerr set
+ * @retval    -1       Error
+ * @see json_xmlns_translate  The same translation as a separate pass
+ */
+static int
+json_scan_namespace(json_scan_t *js,
+                    cxobj       *x,
+                    char        *modname)
+{
+    yang_stmt *ymod;
+
+    /* Special case for ietf-netconf -> ietf-restconf translation, see json_xmlns_translate */
+    if (strcmp(modname, "ietf-restconf") == 0)
+        modname = "ietf-netconf";
+    if ((ymod = js->js_ymod) == NULL ||
+        strcmp(yang_argument_get(ymod), modname) != 0){
+        if ((ymod = yang_find_module_by_name(js->js_yspec, modname)) == NULL){
+            if (js->js_xerr &&
+                netconf_unknown_namespace_xml(js->js_xerr, "application",
+                                              modname,
+                                              "No yang module found corresponding to prefix") < 0)
+                return -1;
+            return 0;
+        }
+        js->js_ymod = ymod;
+    }
+    if (xml_namespace_change(x, yang_find_mynamespace(ymod), NULL) < 0)
+        return -1;
+    return 1;
+}
+
+/*! Create element as child of current element and make it current
+ *
+ * @param[in]  js      Scanner state
+ * @param[in]  name    Local name
+ * @param[in]  modname RFC 7951 module name or NULL
+ * @retval     1       OK
+ * @retval     0       Invalid, js_xerr set
+ * @retval    -1       Error
+ * @see json_current_new
+ */
+static int
+json_scan_element(json_scan_t *js,
+                  char        *name,
+                  char        *modname)
+{
+    clixon_json_yacc *jy = js->js_jy;
+    cxobj            *xp = jy->jy_current;
+    cxobj            *x;
+    cbuf             *cberr = NULL;
+    int               retval = -1;
+    int               ret;
+
+    if ((x = xml_new(name, xp, CX_ELMNT)) == NULL)
+        goto done;
+    jy->jy_current = x;
+    if (xp == jy->jy_xtop){
+        if (cxvec_append(x, &jy->jy_xvec, &jy->jy_xlen) < 0)
+            goto done;
+        /* RFC 7951 Section 4: A namespace-qualified member name MUST be used for all
+         * members of a top-level JSON object, except top-level config file
+         */
+        if (js->js_rfc7951 && modname == NULL &&
+            (js->js_yb != YB_NONE || strcmp(name, DATASTORE_TOP_SYMBOL) != 0)){
+            if ((cberr = cbuf_new()) == NULL){
+                clixon_err(OE_UNIX, errno, "cbuf_new");
+                goto done;
+            }
+            cprintf(cberr, "Top-level JSON object %s is not qualified with namespace which is a MUST according to RFC 7951", name);
+            if (js->js_xerr && netconf_malformed_message_xml(js->js_xerr, cbuf_get(cberr)) < 0)
+                goto done;
+            goto fail;
+        }
+    }
+    if (modname){
+        if ((ret = json_scan_namespace(js, x, modname)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+    }
+    retval = 1;
+ done:
+    if (cberr)
+        cbuf_free(cberr);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Add body to current element
+ *
+ * @param[in]  js      Scanner state
+ * @param[in]  val     Value, or NULL for JSON null
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @see json_current_body
+ */
+static int
+json_scan_body(json_scan_t *js,
+               char        *val)
+{
+    cxobj *xb;
+
+    if ((xb = xml_new("body", js->js_jy->jy_current, CX_BODY)) == NULL)
+        return -1;
+    if (val && xml_value_set(xb, val) < 0)
+        return -1;
+    return 0;
+}
+
+/*! Scan object: { "[module:]name": value, ... } into current element
+ *
+ * @param[in]     js   Scanner state
+ * @param[in,out] pp   Position at '{', moved past '}'
+ * @retval        1    OK
+ * @retval        0    Invalid, js_xerr set
+ * @retval       -1    Error
+ */
+static int
+json_scan_object(json_scan_t *js,
+                 char       **pp)
+{
+    clixon_json_yacc *jy = js->js_jy;
+    char             *p = json_scan_white(*pp + 1);
+    char             *str;
+    char             *name;
+    char             *modname;
+    int               ret;
+
+    if (*p == '}')
+        goto ok;
+    while (1){
+        if (*p != '"')
+            return json_scan_error(js, p);
+        if (json_scan_string(js, &p) < 0)
+            return -1;
+        p = json_scan_white(p);
+        if (*p != ':')
+            return json_scan_error(js, p);
+        p++;
+        /* Split into module:name at first colon */
+        str = cbuf_get(js->js_str);
+        if ((name = strchr(str, ':')) != NULL){
+            *name++ = '\0';
+            modname = str;
+        }
+        else{
+            name = str;
+            modname = NULL;
+        }
+        if ((ret = json_scan_element(js, name, modname)) <= 0)
+            return ret;
+        /* Module name is kept for array members, the scratch buffer is reused */
+        if (modname && (modname = strdup(modname)) == NULL){
+            clixon_err(OE_UNIX, errno, "strdup");
+            return -1;
+        }
+        ret = json_scan_value(js, &p, modname);
+        if (modname)
+            free(modname);
+        if (ret <= 0)
+            return ret;
+        if (jy->jy_current)
+            jy->jy_current = xml_parent(jy->jy_current);
+        p = json_scan_white(p);
+        if (*p == '}')
+            break;
+        if (*p != ',')
+            return json_scan_error(js, p);
+        p = json_scan_white(p + 1);
+    }
+ ok:
+    *pp = p + 1;
+    return 1;
+}
+
+/*! Scan array: [ value, ... ]
+ *
+ * Each value after the first is added to a new sibling element with the same name
+ * @param[in]     js      Scanner state
+ * @param[in,out] pp      Position at '[', moved past ']'
+ * @param[in]     modname RFC 7951 module name of the element, or NULL
+ * @retval        1       OK
+ * @retval        0       Invalid, js_xerr set
+ * @retval       -1       Error
+ * @see json_current_clone
+ */
+static int
+json_scan_array(json_scan_t *js,
+                char       **pp,
+                char        *modname)
+{
+    clixon_json_yacc *jy = js->js_jy;
+    char             *p = json_scan_white(*pp + 1);
+    cxobj            *x;
+    int               ret;
+
+    if (*p == ']')
+        goto ok;
+    while (1){
+        if ((ret = json_scan_value(js, &p, modname)) <= 0)
+            return ret;
+        p = json_scan_white(p);
+        if (*p == ']')
+            break;
+        if (*p != ',')
+            return json_scan_error(js, p);
+        p++;
+        /* Clone current element */
+        x = jy->jy_current;
+        if (x == jy->jy_xtop) /* Top-level array */
+            return json_scan_error(js, p);
+        jy->jy_current = xml_parent(x);
+        if ((ret = json_scan_element(js, xml_name(x), modname)) <= 0)
+            return ret;
+    }
+ ok:
+    *pp = p + 1;
+    return 1;
+}
+
+/*! Scan JSON value into current element
+ *
+ * @param[in]     js      Scanner state
+ * @param[in,out] pp      Position, moved past value
+ * @param[in]     modname RFC 7951 module name of current element, for arrays
+ * @retval        1       OK
+ * @retval        0       Invalid, js_xerr set
+ * @retval       -1       Error
+ */
+static int
+json_scan_value(json_scan_t *js,
+                char       **pp,
+                char        *modname)
+{
+    int   retval = -1;
+    char *p = json_scan_white(*pp);
+    char *q;
+
+    if (++js->js_depth > JSON_SCAN_DEPTH_MAX){
+        clixon_err(OE_JSON, 0, "json_parse: nesting deeper than %d", JSON_SCAN_DEPTH_MAX);
+        goto done;
+    }
+    switch (*p){
+    case '{':
+        if ((retval = json_scan_object(js, &p)) <= 0)
+            goto done;
+        break;
+    case '[':
+        if ((retval = json_scan_array(js, &p, modname)) <= 0)
+            goto done;
+        break;
+    case '"':
+        if (json_scan_string(js, &p) < 0)
+            goto done;
+        if (json_scan_body(js, cbuf_get(js->js_str)) < 0)
+            goto done;
+        break;
+    case 't':
+        if (strncmp(p, "true", 4) != 0){
+            json_scan_error(js, p);
+            goto done;
+        }
+        if (json_scan_body(js, "true") < 0)
+            goto done;
+        p += 4;
+        break;
+    case 'f':
+        if (strncmp(p, "false", 5) != 0){
+            json_scan_error(js, p);
+            goto done;
+        }
+        if (json_scan_body(js, "false") < 0)
+            goto done;
+        p += 5;
+        break;
+    case 'n':
+        if (strncmp(p, "null", 4) != 0){
+            json_scan_error(js, p);
+            goto done;
+        }
+        if (json_scan_body(js, NULL) < 0)
+            goto done;
+        p += 4;
+        break;
+    default: /* Number: -?(integer|real|exp) */
+        q = p;
+        if (*q == '-')
+            q++;
+        while (isdigit((unsigned char)*q))
+            q++;
+        if (*q == '.')
+            for (q++; isdigit((unsigned char)*q); q++)
+                ;
+        if (q == p || (q == p + 1 && (*p == '-' || *p == '.')) ||
+            (q == p + 2 && *p == '-' && p[1] == '.')){
+            json_scan_error(js, p);
+            goto done;
+        }
+        if ((*q == 'e' || *q == 'E') &&
+            (q[1] == '+' || q[1] == '-') && isdigit((unsigned char)q[2]))
+            for (q += 2; isdigit((unsigned char)*q); q++)
+                ;
+        cbuf_reset(js->js_str);
+        if (cbuf_append_buf(js->js_str, p, q - p) < 0){
+            clixon_err(OE_JSON, errno, "cbuf_append_buf");
+            goto done;
+        }
+        if (json_scan_body(js, cbuf_get(js->js_str)) < 0)
+            goto done;
+        p = q;
+        break;
+    }
+    *pp = p;
+    retval = 1;
+ done:
+    js->js_depth--;
+    return retval;
+}
+
+/*! Scan JSON string and create XML tree
+ *
+ * Same input and output as the bison parser and the namespace translation in _json_parse:
+ * elements are created under jy_xtop and top-level elements are added to jy_xvec.
+ * @param[in]  jy       JSON parser struct, jy_parse_string is null-terminated
+ * @param[in]  rfc7951  Check that top-level names are namespace-qualified
+ * @param[in]  yb       How yang is bound after parsing, for the top-level check
+ * @param[in]  yspec    Yang spec, for module name to namespace translation
+ * @param[out] xerr     Reason for invalid returned as netconf err msg
+ * @retval     1        OK
+ * @retval     0        Invalid, xerr set
+ * @retval    -1        Error
+ * @see clixon_json_parseparse  The bison parser
+ */
+int
+clixon_json_scan(clixon_json_yacc *jy,
+                 int               rfc7951,
+                 yang_bind         yb,
+                 yang_stmt        *yspec,
+                 cxobj           **xerr)
+{
+    int         retval = -1;
+    json_scan_t js = {0,};
+    char       *p;
+    int         ret;
+
+    js.js_jy = jy;
+    js.js_rfc7951 = rfc7951;
+    js.js_yb = yb;
+    js.js_yspec = yspec;
+    js.js_xerr = xerr;
+    if ((js.js_str = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    p = jy->jy_parse_string;
+    if ((ret = json_scan_value(&js, &p, NULL)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
+    p = json_scan_white(p);
+    if (*p != '\0'){
+        json_scan_error(&js, p);
+        goto done;
+    }
+    retval = 1;
+ done:
+    if (js.js_str)
+        cbuf_free(js.js_str);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
@@ -0,0 +1,269 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2024 Olof Hagsand
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Latency histograms of operations, such as backend RPCs and commit phases
+ * Samples are recorded with atomic operations without locks, since some operations, eg
+ * plugin callbacks, may run in concurrent threads.
+ * @see CLICON_LATENCY_STATS
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_err.h"
+#include "clixon_latency.h"
+
+/* Number of buckets of a histogram. Bucket i>0 has latencies in [2^(i-1), 2^i) usec,
+ * bucket 0 has latencies below 1 usec and the last bucket all larger latencies.
+ */
+#define LATENCY_BUCKETS 28
+
+/*! Latency histogram of one kind of operation
+ *
+ * Histograms are never removed, the list only grows, and counters are only incremented
+ */
+struct clixon_latency {
+    struct clixon_latency *lt_next;
+    char                  *lt_type;     /* Kind of operation, eg rpc, commit */
+    char                  *lt_name;     /* Name of operation, eg RPC name */
+    uint64_t               lt_count;    /* Number of samples */
+    uint64_t               lt_sum;      /* Sum of latencies in usec */
+    uint64_t               lt_max;      /* Max latency in usec */
+    uint64_t               lt_bucket[LATENCY_BUCKETS];
+};
+
+static struct clixon_latency *_latency_list = NULL;
+static int                    _latency_enabled = 0;
+
+/*! Enable or disable recording of latencies
+ *
+ * @param[in]  enable  If 0 samples are not recorded
+ * @retval     0       OK
+ * @see CLICON_LATENCY_STATS
+ */
+int
+clixon_latency_enable(int enable)
+{
+    _latency_enabled = enable;
+    return 0;
+}
+
+/*! Check if recording of latencies is enabled
+ *
+ * @retval     1       Enabled
+ * @retval     0       Disabled
+ */
+int
+clixon_latency_enabled(void)
+{
+    return _latency_enabled;
+}
+
+/*! Find or add a histogram
+ *
+ * A new histogram is added first in the list with compare-and-swap. If another
+ * thread adds a histogram meanwhile, the list is searched again.
+ * @param[in]  type  Kind of operation
+ * @param[in]  name  Name of operation
+ * @retval     lt    Histogram
+ * @retval     NULL  Out of memory
+ */
+static struct clixon_latency *
+clixon_latency_find(const char *type,
+                    const char *name)
+{
+    struct clixon_latency *head;
+    struct clixon_latency *lt;
+    struct clixon_latency *ltnew = NULL;
+    struct clixon_latency *stop = NULL;
+
+    head = __atomic_load_n(&_latency_list, __ATOMIC_ACQUIRE);
+    while (1){
+        for (lt = head; lt != stop; lt = lt->lt_next)
+            if (strcmp(lt->lt_name, name) == 0 && strcmp(lt->lt_type, type) == 0)
+                goto found;
+        if (ltnew == NULL){
+            if ((ltnew = calloc(1, sizeof(*ltnew))) == NULL)
+                return NULL;
+            if ((ltnew->lt_type = strdup(type)) == NULL ||
+                (ltnew->lt_name = strdup(name)) == NULL){
+                lt = NULL;
+                goto found;
+            }
+        }
+        ltnew->lt_next = head;
+        stop = head; /* On failure, only entries added before head need be searched */
+        if (__atomic_compare_exchange_n(&_latency_list, &head, ltnew, 0,
+                                        __ATOMIC_RELEASE, __ATOMIC_ACQUIRE))
+            return ltnew;
+    }
+ found:
+    if (ltnew){
+        if (ltnew->lt_type)
+            free(ltnew->lt_type);
+        if (ltnew->lt_name)
+            free(ltnew->lt_name);
+        free(ltnew);
+    }
+    return lt;
+}
+
+/*! Start timing an operation
+ *
+ * @param[out] t0   Start time, zero if recording is disabled
+ * @see clixon_latency_stop
+ */
+void
+clixon_latency_start(struct timespec *t0)
+{
+    if (_latency_enabled)
+        clock_gettime(CLOCK_MONOTONIC, t0);
+    else
+        memset(t0, 0, sizeof(*t0));
+}
+
+/*! Stop timing an operation and record its latency
+ *
+ * May be called concurrently from several threads. The sample is not recorded if
+ * recording was disabled at start or if out of memory.
+ * @param[in]  t0   Start time from clixon_latency_start
+ * @param[in]  type Kind of operation, eg "rpc", "commit"
+ * @param[in]  name Name of operation, eg RPC name or commit phase
+ * @code
+ *   struct timespec t0;
+ *   clixon_latency_start(&t0);
+ *   ...
+ *   clixon_latency_stop(&t0, "commit", "diff");
+ * @endcode
+ */
+void
+clixon_latency_stop(struct timespec *t0,
+                    const char      *type,
+                    const char      *name)
+{
+    struct clixon_latency *lt;
+    struct timespec        t1;
+    uint64_t               usec;
+    uint64_t               max;
+    int                    i;
+
+    if (t0->tv_sec == 0 && t0->tv_nsec == 0)
+        return;
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    usec = (t1.tv_sec - t0->tv_sec)*1000000LL + (t1.tv_nsec - t0->tv_nsec)/1000;
+    if ((lt = clixon_latency_find(type, name)) == NULL)
+        return;
+    for (i=0; i<LATENCY_BUCKETS-1 && (usec >> i) != 0; i++)
+        ;
+    __atomic_fetch_add(&lt->lt_bucket[i], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&lt->lt_sum, usec, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&lt->lt_count, 1, __ATOMIC_RELAXED);
+    max = __atomic_load_n(&lt->lt_max, __ATOMIC_RELAXED);
+    while (usec > max &&
+           !__atomic_compare_exchange_n(&lt->lt_max, &max, usec, 1,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        ;
+}
+
+/*! Print all latency histograms as XML
+ *
+ * One histogram element per operation, in clixon-lib latency format, without
+ * enclosing element. Only non-empty buckets are printed.
+ * @param[in]  cb   CLIgen buffer
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+clixon_latency2cbuf(cbuf *cb)
+{
+    struct clixon_latency *lt;
+    uint64_t               nr;
+    int                    i;
+
+    for (lt = __atomic_load_n(&_latency_list, __ATOMIC_ACQUIRE); lt; lt = lt->lt_next){
+        cprintf(cb, "<histogram>");
+        cprintf(cb, "<type>%s</type>", lt->lt_type);
+        cprintf(cb, "<name>%s</name>", lt->lt_name);
+        cprintf(cb, "<count>%" PRIu64 "</count>", __atomic_load_n(&lt->lt_count, __ATOMIC_RELAXED));
+        cprintf(cb, "<total-usec>%" PRIu64 "</total-usec>", __atomic_load_n(&lt->lt_sum, __ATOMIC_RELAXED));
+        cprintf(cb, "<max-usec>%" PRIu64 "</max-usec>", __atomic_load_n(&lt->lt_max, __ATOMIC_RELAXED));
+        for (i=0; i<LATENCY_BUCKETS; i++){
+            if ((nr = __atomic_load_n(&lt->lt_bucket[i], __ATOMIC_RELAXED)) == 0)
+                continue;
+            cprintf(cb, "<bucket>");
+            if (i < LATENCY_BUCKETS-1)
+                cprintf(cb, "<lt-usec>%" PRIu64 "</lt-usec>", (uint64_t)1 << i);
+            else
+                cprintf(cb, "<lt-usec>inf</lt-usec>");
+            cprintf(cb, "<count>%" PRIu64 "</count>", nr);
+            cprintf(cb, "</bucket>");
+        }
+        cprintf(cb, "</histogram>");
+    }
+    return 0;
+}
+
+/*! Free all latency histograms
+ *
+ * Not thread-safe, call when no operations are timed
+ */
+void
+clixon_latency_exit(void)
+{
+    struct clixon_latency *lt;
+
+    while ((lt = _latency_list) != NULL){
+        _latency_list = lt->lt_next;
+        free(lt->lt_type);
+        free(lt->lt_name);
+        free(lt);
+    }
+}
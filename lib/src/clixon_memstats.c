@@ -0,0 +1,252 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2024 Olof Hagsand
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Memory accounting per tag.
+ * A tag names an owner of memory, such as a datastore, a client session or a plugin.
+ * Operations set the current tag, eg while loading a datastore or calling a plugin, and
+ * XML nodes allocated meanwhile are charged to the tag. The tag is stored in the node so
+ * that the node is credited to the same tag when freed, also if it has been moved to
+ * another tree. XML nodes include children vectors and values.
+ * YANG statements and serialized notifications have predefined tags and are always
+ * accounted.
+ * Each tag has the current number of bytes and a high-water mark.
+ * Counters are updated atomically, tags are created and set by the main thread only.
+ * @see CLICON_MEMORY_STATS
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <string.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_err.h"
+#include "clixon_string.h"
+#include "clixon_memstats.h"
+
+/*! Memory accounting of one tag
+ */
+struct clixon_mem {
+    char     mt_name[64];  /* Name of tag, empty if slot is unused */
+    int64_t  mt_bytes;     /* Current number of bytes */
+    int64_t  mt_high;      /* High-water mark of mt_bytes */
+    int      mt_released;  /* Owner is gone, slot may be reused when mt_bytes is zero */
+};
+
+static struct clixon_mem _mem_vec[CLIXON_MEM_TAG_MAX] = {
+    [CLIXON_MEM_TAG_OTHER]  = {"other",},
+    [CLIXON_MEM_TAG_YANG]   = {"yang",},
+    [CLIXON_MEM_TAG_NOTIFY] = {"notifications",},
+};
+
+int _clixon_mem_enabled = 0;
+int _clixon_mem_tag = CLIXON_MEM_TAG_OTHER;
+
+/*! Enable or disable tagged accounting of XML nodes
+ *
+ * @param[in]  enable  If 0 XML nodes are not accounted
+ * @retval     0       OK
+ * @see CLICON_MEMORY_STATS
+ */
+int
+clixon_mem_enable(int enable)
+{
+    _clixon_mem_enabled = enable;
+    return 0;
+}
+
+/*! Check if tagged accounting of XML nodes is enabled
+ *
+ * @retval     1       Enabled
+ * @retval     0       Disabled
+ */
+int
+clixon_mem_enabled(void)
+{
+    return _clixon_mem_enabled;
+}
+
+/*! Find or create a tag given its name
+ *
+ * A slot of a released tag whose memory has been freed is reused.
+ * @param[in]  format  Name of tag, format string, eg "session %u"
+ * @retval     tag     Tag, CLIXON_MEM_TAG_OTHER if disabled or if all tags are in use
+ */
+int
+clixon_mem_tag(const char *format, ...)
+{
+    va_list ap;
+    char    name[64];
+    int     i;
+    int     free = -1;
+
+    if (!_clixon_mem_enabled)
+        return CLIXON_MEM_TAG_OTHER;
+    va_start(ap, format);
+    vsnprintf(name, sizeof(name), format, ap);
+    va_end(ap);
+    for (i=CLIXON_MEM_TAG_OTHER; i<CLIXON_MEM_TAG_MAX; i++){
+        if (_mem_vec[i].mt_name[0] == '\0' ||
+            (_mem_vec[i].mt_released &&
+             __atomic_load_n(&_mem_vec[i].mt_bytes, __ATOMIC_RELAXED) == 0)){
+            if (free == -1)
+                free = i;
+        }
+        else if (strcmp(_mem_vec[i].mt_name, name) == 0){
+            _mem_vec[i].mt_released = 0;
+            return i;
+        }
+    }
+    if (free == -1)
+        return CLIXON_MEM_TAG_OTHER;
+    strcpy(_mem_vec[free].mt_name, name);
+    _mem_vec[free].mt_released = 0;
+    _mem_vec[free].mt_high = __atomic_load_n(&_mem_vec[free].mt_bytes, __ATOMIC_RELAXED);
+    return free;
+}
+
+/*! Set current tag
+ *
+ * @param[in]  tag   Tag from clixon_mem_tag
+ * @retval     tag   Previous tag, restore with clixon_mem_tag_set
+ * @code
+ *   prev = clixon_mem_tag_set(clixon_mem_tag("datastore %s", db));
+ *   ...
+ *   clixon_mem_tag_set(prev);
+ * @endcode
+ */
+int
+clixon_mem_tag_set(int tag)
+{
+    int prev = _clixon_mem_tag;
+
+    _clixon_mem_tag = tag;
+    return prev;
+}
+
+/*! Release a tag whose owner is gone, eg closed session
+ *
+ * The tag is still reported while it has memory, which may indicate a leak.
+ * @param[in]  tag   Tag
+ */
+void
+clixon_mem_tag_release(int tag)
+{
+    if (tag > CLIXON_MEM_TAG_NOTIFY && tag < CLIXON_MEM_TAG_MAX)
+        _mem_vec[tag].mt_released = 1;
+}
+
+/*! Charge allocated bytes to a tag, or credit freed bytes if negative
+ *
+ * May be called concurrently from several threads
+ * @param[in]  tag    Tag, no-op if CLIXON_MEM_TAG_NONE
+ * @param[in]  bytes  Allocated bytes, negative if freed
+ */
+void
+clixon_mem_charge(int     tag,
+                  int64_t bytes)
+{
+    struct clixon_mem *mt;
+    int64_t            cur;
+    int64_t            high;
+
+    if (tag <= CLIXON_MEM_TAG_NONE || tag >= CLIXON_MEM_TAG_MAX)
+        return;
+    mt = &_mem_vec[tag];
+    cur = __atomic_add_fetch(&mt->mt_bytes, bytes, __ATOMIC_RELAXED);
+    high = __atomic_load_n(&mt->mt_high, __ATOMIC_RELAXED);
+    while (cur > high &&
+           !__atomic_compare_exchange_n(&mt->mt_high, &high, cur, 1,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        ;
+}
+
+/*! Print memory accounting of all tags as XML
+ *
+ * @param[in]  cb   CLIgen buffer
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+clixon_mem2cbuf(cbuf *cb)
+{
+    int                retval = -1;
+    struct clixon_mem *mt;
+    int                i;
+
+    for (i=CLIXON_MEM_TAG_OTHER; i<CLIXON_MEM_TAG_MAX; i++){
+        mt = &_mem_vec[i];
+        if (mt->mt_name[0] == '\0')
+            continue;
+        cprintf(cb, "<tag><name>");
+        if (xml_chardata_cbuf_append(cb, 0, mt->mt_name) < 0)
+            goto done;
+        cprintf(cb, "</name>");
+        cprintf(cb, "<bytes>%" PRId64 "</bytes>", __atomic_load_n(&mt->mt_bytes, __ATOMIC_RELAXED));
+        cprintf(cb, "<high-water>%" PRId64 "</high-water>", __atomic_load_n(&mt->mt_high, __ATOMIC_RELAXED));
+        if (mt->mt_released)
+            cprintf(cb, "<released/>");
+        cprintf(cb, "</tag>");
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Disable accounting and reset tags, except predefined tags
+ */
+void
+clixon_mem_exit(void)
+{
+    int i;
+
+    _clixon_mem_enabled = 0;
+    _clixon_mem_tag = CLIXON_MEM_TAG_OTHER;
+    for (i=CLIXON_MEM_TAG_NOTIFY+1; i<CLIXON_MEM_TAG_MAX; i++)
+        memset(&_mem_vec[i], 0, sizeof(_mem_vec[i]));
+}
@@ -170,26 +170,29 @@ nacm_rule_rpc(char         *rpc,
     goto done;
 }
 
-/*! Process nacm incoming RPC message validation steps
+/* Decisions of RPC validation, see nacm_rpc_decide */
+#define NACM_RPC_PERMIT       1 /* Permit */
+#define NACM_RPC_DENY         2 /* Rule matches and denies */
+#define NACM_RPC_DEFAULT_DENY 3 /* No rule matches, default deny */
+
+/*! Evaluate nacm incoming RPC message validation steps 4-12
  *
- * @param[in]  module   Yang module name
  * @param[in]  rpc      rpc name
+ * @param[in]  module   Yang module name
  * @param[in]  username User name of requestor
  * @param[in]  xnacm    NACM xml tree
- * @param[out] cbret    Cligen buffer result. Set to an error msg if retval=0.
- * @retval     1        Access
- * @retval     0        Not access and cbret set
+ * @param[in]  nsc      Namespace context with NACM as default namespace
+ * @retval     d        Decision, NACM_RPC_*
  * @retval    -1        Error
  * @see RFC8341 3.4.4.  Incoming RPC Message Validation
- * @see nacm_datanode_write
- * @see nacm_datanode_read
+ * @see nacm_rpc
  */
-int
-nacm_rpc(char         *rpc,
-         char         *module,
-         char         *username,
-         cxobj        *xnacm,
-         cbuf         *cbret)
+static int
+nacm_rpc_decide(char  *rpc,
+                char  *module,
+                char  *username,
+                cxobj *xnacm,
+                cvec  *nsc)
 {
     int     retval = -1;
     cxobj  *xrule;
@@ -205,16 +208,7 @@ nacm_rpc(char         *rpc,
     char   *gname;
     char   *action;
     int     match= 0;
-    cvec   *nsc = NULL;
 
-    /* Create namespace context for with nacm namespace as default */
-    if ((nsc = xml_nsctx_init(NULL, NACM_NS)) == NULL)
-        goto done;
-    /* 3.   If the requested operation is the NETCONF <close-session>
-       protocol operation, then the protocol operation is permitted.
-    */
-    if (strcmp(rpc, "close-session") == 0)
-        goto permit;
     /* 4.   Check all the "group" entries to see if any of them contain a
        "user-name" entry that equals the username for the session
        making the request.  (If the "enable-external-groups" leaf is
@@ -269,9 +263,8 @@ nacm_rpc(char         *rpc,
         if ((action = xml_find_body(xrule, "action")) == NULL)
             goto step10;
         if (strcmp(action, "deny")==0){
-            if (netconf_access_denied(cbret, "application", "access denied") < 0)
-                goto done;
-            goto deny;
+            retval = NACM_RPC_DENY;
+            goto done;
         }
         else if (strcmp(action, "permit")==0)
             goto permit;
@@ -286,24 +279,19 @@ nacm_rpc(char         *rpc,
         <kill-session> or <delete-config>, then the protocol operation
         is denied. */
     if (strcmp(rpc, "kill-session")==0 || strcmp(rpc, "delete-config")==0){
-        if (netconf_access_denied(cbret, "application", "default deny") < 0)
-            goto done;
-        goto deny;
+        retval = NACM_RPC_DEFAULT_DENY;
+        goto done;
     }
     /*   12.  If the "exec-default" leaf is set to "permit", then permit the
          protocol operation; otherwise, deny the request. */
     exec_default = xml_find_body(xnacm, "exec-default");
     if (exec_default ==NULL || strcmp(exec_default, "permit")==0)
         goto permit;
-    if (netconf_access_denied(cbret, "application", "default deny") < 0)
-        goto done;
-    goto deny;
+    retval = NACM_RPC_DEFAULT_DENY;
+    goto done;
  permit:
-    retval = 1;
+    retval = NACM_RPC_PERMIT;
  done:
-    clixon_debug(CLIXON_DBG_NACM, "retval:%d (0:deny 1:permit)", retval);
-    if (nsc)
-        xml_nsctx_free(nsc);
     if (gvec)
         free(gvec);
     if (rlistvec)
@@ -311,6 +299,572 @@ nacm_rpc(char         *rpc,
     if (rvec)
         free(rvec);
     return retval;
+}
+
+/* Access bits of a compiled NACM rule, see match_access */
+#define NACM_RULE_READ   0x01
+#define NACM_RULE_CREATE 0x02
+#define NACM_RULE_UPDATE 0x04
+#define NACM_RULE_DELETE 0x08
+
+/*! Compiled NACM data node rule
+ *
+ * Everything of a rule needed to match a data node, independent of the NACM XML tree
+ * @see nacm_policy_user
+ */
+struct nacm_rule{
+    char    *nr_module;  /* module-name or NULL */
+    char    *nr_action;  /* action: permit or deny, or NULL */
+    char    *nr_path;    /* Trimmed path, or NULL if rule has no path */
+    uint32_t nr_access;  /* Access bits, NACM_RULE_* */
+};
+
+/*! Compiled NACM data node rules of a user
+ *
+ * The rules of all rule-lists whose groups match the groups of the user, in order
+ */
+struct nacm_user{
+    struct nacm_user *nu_next;
+    char             *nu_name;  /* User name */
+    struct nacm_rule *nu_rules; /* Vector of rules */
+    int               nu_len;   /* Length of rule vector */
+};
+
+/*! Cached RPC validation decision
+ *
+ * Entries are in a bucket list and in an LRU list, most recently used first.
+ * Key is user, module, rpc-name and access-operation
+ * @see nacm_rpc
+ */
+struct nacm_decision{
+    struct nacm_decision *nd_next;    /* Next in bucket */
+    struct nacm_decision *nd_lru_prev;
+    struct nacm_decision *nd_lru_next;
+    uint32_t              nd_hash;
+    char                 *nd_key;
+    int                   nd_decision; /* NACM_RPC_* */
+};
+
+#define NACM_DECISION_BUCKETS 256
+
+/*! Compiled NACM policy
+ *
+ * Built for one NACM configuration, and replaced when the configuration changes.
+ * Per-user rule sets are compiled on first access by a user.
+ * @see nacm_policy_user
+ */
+struct nacm_policy{
+    char                 *np_config; /* Serialized NACM config the policy is compiled from */
+    struct nacm_user     *np_users;  /* Compiled users */
+    struct nacm_decision *np_dvec[NACM_DECISION_BUCKETS]; /* RPC decisions by key */
+    struct nacm_decision *np_lru;      /* Most recently used decision */
+    struct nacm_decision *np_lru_tail; /* Least recently used decision */
+    uint32_t              np_dnr;      /* Number of decisions */
+};
+
+/* RPC decision cache statistics, see nacm_decision_stats */
+static uint64_t _nacm_decision_hits = 0;
+static uint64_t _nacm_decision_misses = 0;
+
+/*! Free compiled rules of a user
+ */
+static int
+nacm_user_free(struct nacm_user *nu)
+{
+    struct nacm_rule *nr;
+    int               i;
+
+    for (i=0; i<nu->nu_len; i++){
+        nr = &nu->nu_rules[i];
+        if (nr->nr_module)
+            free(nr->nr_module);
+        if (nr->nr_action)
+            free(nr->nr_action);
+        if (nr->nr_path)
+            free(nr->nr_path);
+    }
+    if (nu->nu_rules)
+        free(nu->nu_rules);
+    if (nu->nu_name)
+        free(nu->nu_name);
+    free(nu);
+    return 0;
+}
+
+/*! Free compiled NACM policy
+ *
+ * @param[in]  h    Clixon handle
+ * @retval     0    OK
+ */
+int
+nacm_policy_free(clixon_handle h)
+{
+    struct nacm_policy   *np = NULL;
+    struct nacm_user     *nu;
+    struct nacm_decision *nd;
+
+    if (clicon_ptr_get(h, "nacm-policy", (void**)&np) == 0 && np != NULL){
+        while ((nu = np->np_users) != NULL){
+            np->np_users = nu->nu_next;
+            nacm_user_free(nu);
+        }
+        while ((nd = np->np_lru) != NULL){
+            np->np_lru = nd->nd_lru_next;
+            free(nd->nd_key);
+            free(nd);
+        }
+        if (np->np_config)
+            free(np->np_config);
+        free(np);
+        clicon_ptr_del(h, "nacm-policy");
+    }
+    return 0;
+}
+
+/*! Copy body of child to a malloced string
+ *
+ * @param[in]  xn    XML node
+ * @param[in]  name  Name of child
+ * @param[out] strp  Malloced body, or NULL if no child
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+nacm_body_dup(cxobj  *xn,
+              char   *name,
+              char  **strp)
+{
+    char *str;
+
+    if ((str = xml_find_body(xn, name)) != NULL &&
+        (*strp = strdup(str)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        return -1;
+    }
+    return 0;
+}
+
+/*! Compile data node rules of a user
+ *
+ * Rules that only apply to rpc or notifications are skipped
+ * @param[in]  xnacm    NACM xml tree
+ * @param[in]  username User name
+ * @param[in]  nsc      Namespace context with NACM as default namespace
+ * @param[out] nup      Compiled rules of user, malloced
+ * @retval     0        OK
+ * @retval    -1        Error
+ */
+static int
+nacm_user_compile(cxobj             *xnacm,
+                  char              *username,
+                  cvec              *nsc,
+                  struct nacm_user **nup)
+{
+    int               retval = -1;
+    struct nacm_user *nu = NULL;
+    struct nacm_rule *nr;
+    cxobj           **gvec = NULL; /* groups */
+    size_t            glen;
+    cxobj            *rlist;
+    cxobj            *xg;
+    cxobj            *xrule;
+    cxobj            *pathobj;
+    char             *access_operations;
+    char             *gname;
+    int               j;
+
+    if ((nu = malloc(sizeof(*nu))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    memset(nu, 0, sizeof(*nu));
+    if ((nu->nu_name = strdup(username)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    /* User's group */
+    if (xpath_vec(xnacm, nsc, "groups/group[user-name='%s']", &gvec, &glen, username) < 0)
+        goto done;
+    rlist = NULL;
+    while (glen && (rlist = xml_child_each(xnacm, rlist, CX_ELMNT)) != NULL) {
+        if (strcmp(xml_name(rlist), "rule-list") != 0)
+            continue;
+        /* Loop through user's group to find match in this rule-list */
+        xg = NULL;
+        while ((xg = xml_child_each(rlist, xg, CX_ELMNT)) != NULL) {
+            if (strcmp(xml_name(xg), "group") != 0 || (gname = xml_body(xg)) == NULL)
+                continue;
+            for (j=0; j<glen; j++)
+                if (clicon_strcmp(gname, xml_find_body(gvec[j], "name")) == 0)
+                    break;
+            if (j<glen)
+                break; /* found */
+        }
+        if (xg == NULL) /* not found */
+            continue;
+        xrule = NULL;
+        while ((xrule = xml_child_each(rlist, xrule, CX_ELMNT)) != NULL) {
+            if (strcmp(xml_name(xrule), "rule") != 0)
+                continue;
+            if ((pathobj = xml_find_type(xrule, NULL, "path", CX_ELMNT)) == NULL &&
+                (xml_find_body(xrule, "rpc-name") || xml_find_body(xrule, "notification-name")))
+                continue;
+            if ((nu->nu_rules = realloc(nu->nu_rules, (nu->nu_len+1)*sizeof(*nr))) == NULL){
+                clixon_err(OE_UNIX, errno, "realloc");
+                goto done;
+            }
+            nr = &nu->nu_rules[nu->nu_len++];
+            memset(nr, 0, sizeof(*nr));
+            access_operations = xml_find_body(xrule, "access-operations");
+            if (match_access(access_operations, "read", NULL))
+                nr->nr_access |= NACM_RULE_READ;
+            if (match_access(access_operations, "create", "write"))
+                nr->nr_access |= NACM_RULE_CREATE;
+            if (match_access(access_operations, "update", "write"))
+                nr->nr_access |= NACM_RULE_UPDATE;
+            if (match_access(access_operations, "delete", "write"))
+                nr->nr_access |= NACM_RULE_DELETE;
+            if (nacm_body_dup(xrule, "module-name", &nr->nr_module) < 0)
+                goto done;
+            if (nacm_body_dup(xrule, "action", &nr->nr_action) < 0)
+                goto done;
+            if (pathobj &&
+                (nr->nr_path = strdup(clixon_trim2(xml_body(pathobj), " \t\n"))) == NULL){
+                clixon_err(OE_UNIX, errno, "strdup");
+                goto done;
+            }
+        }
+    }
+    *nup = nu;
+    nu = NULL;
+    retval = 0;
+ done:
+    if (nu)
+        nacm_user_free(nu);
+    if (gvec)
+        free(gvec);
+    return retval;
+}
+
+/*! Get compiled NACM policy of a NACM config
+ *
+ * The compiled policy is kept in the handle. It is rebuilt if the NACM config differs from
+ * the config it was compiled from.
+ * @param[in]  h        Clixon handle
+ * @param[in]  xnacm    NACM xml tree
+ * @param[out] npp      Compiled policy (do not free)
+ * @retval     0        OK
+ * @retval    -1        Error
+ */
+static int
+nacm_policy_get(clixon_handle        h,
+                cxobj               *xnacm,
+                struct nacm_policy **npp)
+{
+    int                 retval = -1;
+    struct nacm_policy *np = NULL;
+    cbuf               *cb = NULL;
+
+    if ((cb = clixon_cbuf_borrow(0)) == NULL)
+        goto done;
+    if (clixon_xml2cbuf(cb, xnacm, 0, 0, NULL, -1, 0) < 0)
+        goto done;
+    clicon_ptr_get(h, "nacm-policy", (void**)&np);
+    if (np && strcmp(np->np_config, cbuf_get(cb)) != 0){
+        clixon_debug(CLIXON_DBG_NACM, "NACM config changed, recompile policy");
+        nacm_policy_free(h);
+        np = NULL;
+    }
+    if (np == NULL){
+        if ((np = malloc(sizeof(*np))) == NULL){
+            clixon_err(OE_UNIX, errno, "malloc");
+            goto done;
+        }
+        memset(np, 0, sizeof(*np));
+        if ((np->np_config = strdup(cbuf_get(cb))) == NULL){
+            clixon_err(OE_UNIX, errno, "strdup");
+            free(np);
+            goto done;
+        }
+        if (clicon_ptr_set(h, "nacm-policy", np) < 0)
+            goto done;
+    }
+    *npp = np;
+    retval = 0;
+ done:
+    if (cb)
+        clixon_cbuf_release(cb);
+    return retval;
+}
+
+/*! Get compiled data node rules of a user
+ *
+ * The rules of a user are compiled on first use, see nacm_policy_get
+ * @param[in]  h        Clixon handle
+ * @param[in]  xnacm    NACM xml tree
+ * @param[in]  username User name
+ * @param[in]  nsc      Namespace context with NACM as default namespace
+ * @param[out] nup      Compiled rules of user (do not free)
+ * @retval     0        OK
+ * @retval    -1        Error
+ */
+static int
+nacm_policy_user(clixon_handle      h,
+                 cxobj             *xnacm,
+                 char              *username,
+                 cvec              *nsc,
+                 struct nacm_user **nup)
+{
+    int                 retval = -1;
+    struct nacm_policy *np = NULL;
+    struct nacm_user   *nu;
+
+    if (nacm_policy_get(h, xnacm, &np) < 0)
+        goto done;
+    for (nu = np->np_users; nu; nu = nu->nu_next)
+        if (strcmp(nu->nu_name, username) == 0)
+            break;
+    if (nu == NULL){
+        if (nacm_user_compile(xnacm, username, nsc, &nu) < 0)
+            goto done;
+        nu->nu_next = np->np_users;
+        np->np_users = nu;
+    }
+    *nup = nu;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! FNV-1a hash of a decision key
+ */
+static uint32_t
+nacm_decision_hash(const char *str)
+{
+    uint32_t h = 2166136261u;
+
+    while (*str){
+        h ^= (uint8_t)*str++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/*! Unlink decision from LRU list
+ */
+static void
+nacm_decision_lru_rm(struct nacm_policy   *np,
+                     struct nacm_decision *nd)
+{
+    if (nd->nd_lru_prev)
+        nd->nd_lru_prev->nd_lru_next = nd->nd_lru_next;
+    else
+        np->np_lru = nd->nd_lru_next;
+    if (nd->nd_lru_next)
+        nd->nd_lru_next->nd_lru_prev = nd->nd_lru_prev;
+    else
+        np->np_lru_tail = nd->nd_lru_prev;
+    nd->nd_lru_prev = nd->nd_lru_next = NULL;
+}
+
+/*! Insert decision first in LRU list
+ */
+static void
+nacm_decision_lru_add(struct nacm_policy   *np,
+                      struct nacm_decision *nd)
+{
+    nd->nd_lru_prev = NULL;
+    nd->nd_lru_next = np->np_lru;
+    if (np->np_lru)
+        np->np_lru->nd_lru_prev = nd;
+    else
+        np->np_lru_tail = nd;
+    np->np_lru = nd;
+}
+
+/*! Find cached decision and make it most recently used
+ *
+ * @param[in]  np    Compiled policy
+ * @param[in]  key   Decision key
+ * @param[in]  hash  Hash of key
+ * @retval     d     Decision, NACM_RPC_*
+ * @retval     0     Not found
+ */
+static int
+nacm_decision_get(struct nacm_policy *np,
+                  const char         *key,
+                  uint32_t            hash)
+{
+    struct nacm_decision *nd;
+
+    for (nd = np->np_dvec[hash % NACM_DECISION_BUCKETS]; nd; nd = nd->nd_next)
+        if (nd->nd_hash == hash && strcmp(nd->nd_key, key) == 0)
+            break;
+    if (nd == NULL)
+        return 0;
+    nacm_decision_lru_rm(np, nd);
+    nacm_decision_lru_add(np, nd);
+    return nd->nd_decision;
+}
+
+/*! Add decision to cache, evict least recently used decisions beyond size
+ *
+ * @param[in]  np       Compiled policy
+ * @param[in]  key      Decision key
+ * @param[in]  hash     Hash of key
+ * @param[in]  decision Decision, NACM_RPC_*
+ * @param[in]  size     Max number of decisions
+ * @retval     0        OK
+ * @retval    -1        Error
+ */
+static int
+nacm_decision_add(struct nacm_policy *np,
+                  const char         *key,
+                  uint32_t            hash,
+                  int                 decision,
+                  uint32_t            size)
+{
+    struct nacm_decision  *nd;
+    struct nacm_decision **ndp;
+
+    while (np->np_dnr >= size && (nd = np->np_lru_tail) != NULL){
+        for (ndp = &np->np_dvec[nd->nd_hash % NACM_DECISION_BUCKETS]; *ndp; ndp = &(*ndp)->nd_next)
+            if (*ndp == nd){
+                *ndp = nd->nd_next;
+                break;
+            }
+        nacm_decision_lru_rm(np, nd);
+        np->np_dnr--;
+        free(nd->nd_key);
+        free(nd);
+    }
+    if ((nd = malloc(sizeof(*nd))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        return -1;
+    }
+    memset(nd, 0, sizeof(*nd));
+    if ((nd->nd_key = strdup(key)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        free(nd);
+        return -1;
+    }
+    nd->nd_hash = hash;
+    nd->nd_decision = decision;
+    nd->nd_next = np->np_dvec[hash % NACM_DECISION_BUCKETS];
+    np->np_dvec[hash % NACM_DECISION_BUCKETS] = nd;
+    nacm_decision_lru_add(np, nd);
+    np->np_dnr++;
+    return 0;
+}
+
+/*! Get statistics of the NACM RPC decision cache
+ *
+ * @param[in]  h       Clixon handle
+ * @param[out] nr      Number of cached decisions
+ * @param[out] hits    Number of RPC validations that found a cached decision
+ * @param[out] misses  Number of RPC validations that evaluated the rules
+ * @retval     0       OK
+ * @see option CLICON_NACM_DECISION_CACHE_SIZE
+ */
+int
+nacm_decision_stats(clixon_handle h,
+                    uint64_t     *nr,
+                    uint64_t     *hits,
+                    uint64_t     *misses)
+{
+    struct nacm_policy *np = NULL;
+
+    clicon_ptr_get(h, "nacm-policy", (void**)&np);
+    *nr = np ? np->np_dnr : 0;
+    *hits = _nacm_decision_hits;
+    *misses = _nacm_decision_misses;
+    return 0;
+}
+
+/*! Process nacm incoming RPC message validation steps
+ *
+ * Decisions are cached per user, module and rpc in the compiled policy of the NACM config,
+ * see CLICON_NACM_DECISION_CACHE_SIZE
+ * @param[in]  h        Clixon handle
+ * @param[in]  rpc      rpc name
+ * @param[in]  module   Yang module name
+ * @param[in]  username User name of requestor
+ * @param[in]  xnacm    NACM xml tree
+ * @param[out] cbret    Cligen buffer result. Set to an error msg if retval=0.
+ * @retval     1        Access
+ * @retval     0        Not access and cbret set
+ * @retval    -1        Error
+ * @see RFC8341 3.4.4.  Incoming RPC Message Validation
+ * @see nacm_datanode_write
+ * @see nacm_datanode_read
+ */
+int
+nacm_rpc(clixon_handle h,
+         char         *rpc,
+         char         *module,
+         char         *username,
+         cxobj        *xnacm,
+         cbuf         *cbret)
+{
+    int                 retval = -1;
+    cvec               *nsc = NULL;
+    struct nacm_policy *np = NULL;
+    uint32_t            size;
+    uint32_t            hash = 0;
+    cbuf               *cbkey = NULL;
+    int                 decision = 0;
+
+    /* 3.   If the requested operation is the NETCONF <close-session>
+       protocol operation, then the protocol operation is permitted.
+    */
+    if (strcmp(rpc, "close-session") == 0)
+        goto permit;
+    /* Create namespace context for with nacm namespace as default */
+    if ((nsc = xml_nsctx_init(NULL, NACM_NS)) == NULL)
+        goto done;
+    size = clicon_option_int(h, "CLICON_NACM_DECISION_CACHE_SIZE");
+    if (size && username){
+        if (nacm_policy_get(h, xnacm, &np) < 0)
+            goto done;
+        if ((cbkey = clixon_cbuf_borrow(0)) == NULL)
+            goto done;
+        cprintf(cbkey, "%s %s %s exec", username, module, rpc);
+        hash = nacm_decision_hash(cbuf_get(cbkey));
+        if ((decision = nacm_decision_get(np, cbuf_get(cbkey), hash)) != 0)
+            _nacm_decision_hits++;
+        else
+            _nacm_decision_misses++;
+    }
+    if (decision == 0){
+        if ((decision = nacm_rpc_decide(rpc, module, username, xnacm, nsc)) < 0)
+            goto done;
+        if (np && nacm_decision_add(np, cbuf_get(cbkey), hash, decision, size) < 0)
+            goto done;
+    }
+    switch (decision){
+    case NACM_RPC_PERMIT:
+        goto permit;
+        break;
+    case NACM_RPC_DENY:
+        if (netconf_access_denied(cbret, "application", "access denied") < 0)
+            goto done;
+        goto deny;
+        break;
+    default:
+        if (netconf_access_denied(cbret, "application", "default deny") < 0)
+            goto done;
+        goto deny;
+        break;
+    }
+ permit:
+    retval = 1;
+ done:
+    clixon_debug(CLIXON_DBG_NACM, "retval:%d (0:deny 1:permit)", retval);
+    if (cbkey)
+        clixon_cbuf_release(cbkey);
+    if (nsc)
+        xml_nsctx_free(nsc);
+    return retval;
  deny: /* Here, cbret must contain a netconf error msg */
     assert(cbuf_len(cbret));
     retval = 0;
@@ -319,9 +873,9 @@ nacm_rpc(char         *rpc,
 
 /* Local struct for keeping preparation/compiled data in NACM data path code */
 struct prepvec{
-    qelem_t       pv_q;
-    cxobj        *pv_xrule;
-    clixon_xvec  *pv_xpathvec;
+    qelem_t           pv_q;
+    struct nacm_rule *pv_rule;
+    clixon_xvec      *pv_xpathvec;
 };
 typedef struct prepvec prepvec;
 
@@ -342,8 +896,8 @@ prepvec_free(prepvec *pv_list)
 }
 
 prepvec *
-prepvec_add(prepvec  **pv_listp,
-            cxobj     *xrule)
+prepvec_add(prepvec         **pv_listp,
+            struct nacm_rule *nr)
 {
     prepvec *pv;
 
@@ -353,7 +907,7 @@ prepvec_add(prepvec  **pv_listp,
     }
     memset(pv, 0, sizeof(*pv));
     ADDQ(pv, *pv_listp);
-    pv->pv_xrule = xrule;
+    pv->pv_rule = nr;
     if ((pv->pv_xpathvec = clixon_xvec_new()) == NULL)
         return NULL;
     return pv;
@@ -363,10 +917,14 @@ prepvec_add(prepvec  **pv_listp,
  *
  * Save rules in a "cache"
  * These rules match:
- *  - user/group
+ *  - user/group, see nacm_policy_user
  *  - have read access-op, etc
  * Also make instance-id lookups on top object for each rule. Assume at most one result
  * @param[in] h      Clixon handle
+ * @param[in] xt     XML data tree
+ * @param[in] access Requested access
+ * @param[in] nu     Compiled rules of user
+ * @param[out] pv_listp Rules and instance-id lookups that apply, free with prepvec_free
  * @retval    0      OK
  * @retval   -1      Error
  */
@@ -374,295 +932,379 @@ static int
 nacm_datanode_prepare(clixon_handle     h,
                       cxobj            *xt,
                       enum nacm_access  access,
-                      cxobj           **gvec,
-                      size_t            glen,
-                      cxobj           **rlistvec,
-                      size_t            rlistlen,
-                      cvec             *nsc,
+                      struct nacm_user *nu,
                       prepvec         **pv_listp)
 {
-    int        retval = -1;
-    cxobj     *rlist;
-    int        i;
-    int        j;
-    int        k;
-    char      *gname;
-    cxobj    **rvec = NULL; /* rules */
-    size_t     rlen;
-    cxobj     *xrule;
-    cxobj     *pathobj;
-    char      *access_operations;
-    char      *path0;         /* Non-canonical path */
-    char      *path=NULL;     /* Canonical path */
-    cvec      *nsc0 = NULL;   /* Non-canonical namespace context */
-    yang_stmt *yspec;
-    cxobj   **xvec = NULL;
-    int       xlen = 0;
-    int       ret;
-    prepvec *pv;
+    int               retval = -1;
+    int               i;
+    int               k;
+    uint32_t          bit;
+    struct nacm_rule *nr;
+    yang_stmt        *yspec;
+    cxobj           **xvec = NULL;
+    int               xlen = 0;
+    int               ret;
+    prepvec          *pv;
 
+    switch (access){
+    case NACM_READ:
+        /* 6c) For a "read" access operation, the rule's "access-operations"
+           leaf has the "read" bit set or has the special value "*" */
+        bit = NACM_RULE_READ;
+        break;
+    case NACM_CREATE:
+        /* 6d) For a "create" access operation, the rule's "access-operations"
+           leaf has the "create" bit set or has the special value "*". */
+        bit = NACM_RULE_CREATE;
+        break;
+    case NACM_DELETE:
+        /* 6e) For a "delete" access operation, the rule's "access-operations" 
+           leaf has the "delete" bit set or has the  special value "*". */
+        bit = NACM_RULE_DELETE;
+        break;
+    case NACM_UPDATE:
+        /* 6f) For an "update" access operation, the rule's "access-operations"
+           leaf has the "update" bit set or has the special value "*". */ 
+        bit = NACM_RULE_UPDATE;
+        break;
+    default:
+        clixon_err(OE_XML, EINVAL, "Access %d unupported (shouldnt happen)", access);
+        goto done;
+        break;
+    }
     yspec = clicon_dbspec_yang(h);
-    for (i=0; i<rlistlen; i++){         /* Loop through rule list */
-        rlist = rlistvec[i];
-        /* Loop through user's group to find match in this rule-list */
-        for (j=0; j<glen; j++){
-            gname = xml_find_body(gvec[j], "name");
-            if (xpath_first(rlist, nsc, ".[group='%s']", gname)!=NULL)
-                break; /* found */
+    /* 6. For each rule-list entry found, process all rules, in order,
+       until a rule that matches the requested access operation is
+       found. (see 6 sub rules in nacm_rule_datanode
+    */
+    for (i=0; i<nu->nu_len; i++){ /* Loop through rules */
+        nr = &nu->nu_rules[i];
+        if ((nr->nr_access & bit) == 0)
+            continue;
+        /*  6b) Either (1) the rule does not have a "rule-type" defined or
+            (2) the "rule-type" is "data-node" and the "path" matches the
+            requested data node, action node, or notification node. */    
+        if (nr->nr_path == NULL){
+            /* Here a new rule is found, add it */
+            if (prepvec_add(pv_listp, nr) == NULL)
+                goto done;
+            continue;
         }
-        if (j==glen) /* not found */
+        /* See https://github.com/clicon/clixon/issues/129:
+         * Paths are not made canonical, you are then back to the problem of JSON encodings
+         */
+        if ((ret = clixon_xml_find_instance_id(xt, yspec, &xvec, &xlen, "%s", nr->nr_path)) < 0)
+            goto done;
+        if (ret == 0)
             continue;
-        /* 6. For each rule-list entry found, process all rules, in order,
-           until a rule that matches the requested access operation is
-           found. (see 6 sub rules in nacm_rule_datanode
-        */
-        if (xpath_vec(rlist, nsc, "rule", &rvec, &rlen) < 0)
+        /* Here a new rule is found, add it */
+        if ((pv = prepvec_add(pv_listp, nr)) == NULL)
             goto done;
-        for (j=0; j<rlen; j++){ /* Loop through rules */
-            xrule = rvec[j];
-            /* 6c) For a "read" access operation, the rule's "access-operations"
-               leaf has the "read" bit set or has the special value "*" */
-            access_operations = xml_find_body(xrule, "access-operations");
-            switch (access){
-            case NACM_READ:
-                /* 6c) For a "read" access operation, the rule's "access-operations"
-                   leaf has the "read" bit set or has the special value "*" */
-                if (!match_access(access_operations, "read", NULL))
-                    continue;
-                break;
-            case NACM_CREATE:
-                /* 6d) For a "create" access operation, the rule's "access-operations"
-                   leaf has the "create" bit set or has the special value "*". */
-                if (!match_access(access_operations, "create", "write"))
-                    continue;
-                break;
-            case NACM_DELETE:
-                /* 6e) For a "delete" access operation, the rule's "access-operations" 
-                   leaf has the "delete" bit set or has the  special value "*". */
-                if (!match_access(access_operations, "delete", "write"))
-                    continue;
-                break;
-            case NACM_UPDATE:
-                /* 6f) For an "update" access operation, the rule's "access-operations"
-                   leaf has the "update" bit set or has the special value "*". */ 
-                if (!match_access(access_operations, "update", "write"))
-                    continue;
-                break;
-            default:
-                clixon_err(OE_XML, EINVAL, "Access %d unupported (shouldnt happen)", access);
+        for (k=0; k<xlen; k++){
+            if (clixon_xvec_append(pv->pv_xpathvec, xvec[k]) < 0)
                 goto done;
-                break;
-            }
-            /*  6b) Either (1) the rule does not have a "rule-type" defined or
-                (2) the "rule-type" is "data-node" and the "path" matches the
-                requested data node, action node, or notification node. */    
-            if ((pathobj = xml_find_type(xrule, NULL, "path", CX_ELMNT)) == NULL){
-                if (xml_find_body(xrule, "rpc-name") || xml_find_body(xrule, "notification-name"))
-                    continue;
-                /* Here a new xrule is found, add it */
-                if (prepvec_add(pv_listp, xrule) == NULL)
-                    goto done;
-            }
-            else{
-                path0 = clixon_trim2(xml_body(pathobj), " \t\n");
-                /* Get canonical namespace context for nacm paths */
-                if ((path = strdup(path0)) == NULL){
-                    clixon_err(OE_UNIX, errno, "strdup");
-                    goto done;
-                }
-#if 0
-                /* See https://github.com/clicon/clixon/issues/129:
-                 * If this is enabled, you are back to the problem of JSON encodings
-                 */
-                /* Create namespace context for with nacm namespace as default */
-                if (xml_nsctx_node(pathobj, &nsc0) < 0)
-                    goto done;
-                /* instance-id requires canonical paths */
-                if (xpath2canonical(path0, nsc0, yspec, &path, NULL) < 0)
-                    goto done;
-#endif
-                if ((ret = clixon_xml_find_instance_id(xt, yspec, &xvec, &xlen, "%s", path)) < 0)
-                    goto done;
-                if (ret == 0)
-                    continue;
-                /* Here a new xrule is found, add it */
-                if ((pv = prepvec_add(pv_listp, xrule)) == NULL)
-                    goto done;
-                for (k=0; k<xlen; k++){
-                    if (clixon_xvec_append(pv->pv_xpathvec, xvec[k]) < 0)
-                        goto done;
-                }
-                if (xvec){
-                    free(xvec);
-                    xvec = NULL;
-                }
-                if (nsc0){
-                    cvec_free(nsc0);
-                    nsc0 = NULL;
-                }
-                if (path){
-                    free(path);
-                    path = NULL;
-                }
-            }
         }
-        if (rvec){
-            free(rvec);
-            rvec=NULL;
+        if (xvec){
+            free(xvec);
+            xvec = NULL;
         }
     }
     retval = 0;
  done:
     if (xvec)
         free(xvec);
-    if (path)
-        free(path);
-    if (nsc0)
-        cvec_free(nsc0);
     return retval;
 }
 
 /*---------------------------------------------------------------
- * Datanode write
+ * Datanode walk
+ */
+
+/*! Data node where the path of a rule matches, see nacm_walk
  */
+struct nacm_start{
+    cxobj *ns_x;    /* Data node matching rule path */
+    int    ns_rule; /* Index of rule */
+};
 
-/*! Match specific rule to specific requested node
+/*! Rules and rule path matches of one NACM data node walk
  *
- * @param[in]  xn       XML node (requested node)
- * @param[in]  xrule    NACM rule
- * @param[in]  xp       Xpath match
- * @param[in]  yspec    YANG spec
- * @retval  2  OK and rule matches permit
- * @retval  1  OK and rule matches deny
- * @retval  0  OK and rule does not match
- * @retval -1  Error
+ * The walk descends the data tree and keeps, per rule, the number of matching data nodes
+ * that are ancestors-or-self of the current node (active rules).
+ * Matching nodes and their ancestors are sorted by pointer so that entering a node is a
+ * binary search instead of an ancestor test per rule and matching node.
+ * A subtree where no rule path starts and where the first matching rule (if any) cannot be
+ * preempted by a module-specific rule has the same decision in all nodes, and is skipped.
  */
+struct nacm_walk{
+    struct nacm_rule **nw_rules;  /* Rules in order */
+    int               *nw_active; /* Per rule: number of matches ancestor-or-self (path rules) */
+    int                nw_len;    /* Number of rules */
+    struct nacm_start *nw_starts; /* Rule path matches sorted by node */
+    int                nw_nstarts;
+    cxobj            **nw_anc;    /* Strict ancestors of rule path matches, sorted */
+    int                nw_nanc;
+};
+
 static int
-nacm_data_write_xrule_xml(cxobj       *xn,
-                          cxobj       *xrule,
-                          clixon_xvec *xpathvec,
-                          yang_stmt   *yspec)
+nacm_start_cmp(const void *a,
+               const void *b)
 {
-    int        retval = -1;
-    yang_stmt *ymod;
-    char      *module_pattern; /* rule module name */
-    char      *action;
-    cxobj     *xp;
-    int        i;
-
-    if ((module_pattern = xml_find_body(xrule, "module-name")) == NULL)
-        goto nomatch;
-    /* 6a) The rule's "module-name" leaf is "*" or equals the name of
-     * the YANG module where the requested data node is defined. 
-     */
-    if (strcmp(module_pattern, "*") != 0){
-        if (ys_module_by_xml(yspec, xn, &ymod) < 0)
-            goto done;
-        /* ymod is NULL (xn is "config") Can this breach the NACM rule? */
-        if (ymod && strcmp(yang_argument_get(ymod), module_pattern) != 0)
-            goto nomatch;
+    const struct nacm_start *s1 = a;
+    const struct nacm_start *s2 = b;
+
+    if (s1->ns_x < s2->ns_x)
+        return -1;
+    return s1->ns_x > s2->ns_x;
+}
+
+static int
+nacm_ptr_cmp(const void *a,
+             const void *b)
+{
+    cxobj *x1 = *(cxobj **)a;
+    cxobj *x2 = *(cxobj **)b;
+
+    if (x1 < x2)
+        return -1;
+    return x1 > x2;
+}
+
+/*! Free NACM walk
+ */
+static int
+nacm_walk_free(struct nacm_walk *nw)
+{
+    if (nw->nw_rules)
+        free(nw->nw_rules);
+    if (nw->nw_active)
+        free(nw->nw_active);
+    if (nw->nw_starts)
+        free(nw->nw_starts);
+    if (nw->nw_anc)
+        free(nw->nw_anc);
+    return 0;
+}
+
+/*! Enter or leave a data node: update active rules with rule paths matching the node
+ *
+ * @param[in]  nw    NACM walk
+ * @param[in]  xn    XML node
+ * @param[in]  inc   1: enter, -1: leave
+ */
+static void
+nacm_walk_enter(struct nacm_walk *nw,
+                cxobj            *xn,
+                int               inc)
+{
+    struct nacm_start  key = {xn, 0};
+    struct nacm_start *ns;
+
+    if (nw->nw_nstarts == 0)
+        return;
+    if ((ns = bsearch(&key, nw->nw_starts, nw->nw_nstarts, sizeof(key), nacm_start_cmp)) == NULL)
+        return;
+    while (ns > nw->nw_starts && (ns-1)->ns_x == xn)
+        ns--;
+    for (; ns < nw->nw_starts + nw->nw_nstarts && ns->ns_x == xn; ns++)
+        nw->nw_active[ns->ns_rule] += inc;
+}
+
+/*! Initialize a NACM walk from prepared rules, starting at a data node
+ *
+ * Rule paths matching ancestors of the start node are active from the start
+ * @param[in]  pv_list  Precomputed rules + paths that apply to this user group
+ * @param[in]  xn       Start node of walk
+ * @param[out] nw       NACM walk, free with nacm_walk_free
+ * @retval     0        OK
+ * @retval    -1        Error
+ */
+static int
+nacm_walk_init(prepvec          *pv_list,
+               cxobj            *xn,
+               struct nacm_walk *nw)
+{
+    int      retval = -1;
+    prepvec *pv;
+    cxobj   *xp;
+    int      i;
+    int      j;
+    int      n = 0;
+
+    memset(nw, 0, sizeof(*nw));
+    if ((pv = pv_list) != NULL){
+        do {
+            nw->nw_len++;
+            n += clixon_xvec_len(pv->pv_xpathvec);
+            pv = NEXTQ(prepvec *, pv);
+        } while (pv && pv != pv_list);
     }
-    action = xml_find_body(xrule, "action"); /* mandatory */
-    /*  6b) Either (1) the rule does not have a "rule-type" defined or
-        (2) the "rule-type" is "data-node" and the "path" matches the
-        Requested data node, action node, or notification node. */    
-    if (xml_find_type(xrule, NULL, "path", CX_ELMNT) == NULL){
-        if (strcmp(action, "deny")==0)
-            goto deny;
-        goto permit;
+    if (nw->nw_len == 0)
+        goto ok;
+    if ((nw->nw_rules = calloc(nw->nw_len, sizeof(struct nacm_rule *))) == NULL ||
+        (nw->nw_active = calloc(nw->nw_len, sizeof(int))) == NULL ||
+        (n && (nw->nw_starts = calloc(n, sizeof(struct nacm_start))) == NULL)){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
     }
-    for (i=0; i<clixon_xvec_len(xpathvec); i++){
-        xp = clixon_xvec_i(xpathvec, i);
-        /* Check if ancestor is xp (for every xpathvec?) */
-        if (xn == xp || xml_isancestor(xn, xp)){
-            if (strcmp(action, "deny")==0)
-                goto deny;
-            goto permit;
+    pv = pv_list;
+    i = 0;
+    do {
+        nw->nw_rules[i] = pv->pv_rule;
+        for (j=0; j<clixon_xvec_len(pv->pv_xpathvec); j++){
+            nw->nw_starts[nw->nw_nstarts].ns_x = clixon_xvec_i(pv->pv_xpathvec, j);
+            nw->nw_starts[nw->nw_nstarts].ns_rule = i;
+            nw->nw_nstarts++;
         }
+        i++;
+        pv = NEXTQ(prepvec *, pv);
+    } while (pv && pv != pv_list);
+    if (nw->nw_nstarts){
+        qsort(nw->nw_starts, nw->nw_nstarts, sizeof(struct nacm_start), nacm_start_cmp);
+        /* Ancestors of matches */
+        for (i=0; i<nw->nw_nstarts; i++){
+            if (i && nw->nw_starts[i].ns_x == nw->nw_starts[i-1].ns_x)
+                continue;
+            xp = nw->nw_starts[i].ns_x;
+            while ((xp = xml_parent(xp)) != NULL){
+                if ((nw->nw_anc = realloc(nw->nw_anc, (nw->nw_nanc+1)*sizeof(cxobj *))) == NULL){
+                    clixon_err(OE_UNIX, errno, "realloc");
+                    goto done;
+                }
+                nw->nw_anc[nw->nw_nanc++] = xp;
+            }
+        }
+        if (nw->nw_nanc)
+            qsort(nw->nw_anc, nw->nw_nanc, sizeof(cxobj *), nacm_ptr_cmp);
     }
-    goto nomatch;
- permit:
-    retval = 2;       /* rule match and permit */
+    /* Rule paths matching ancestors of the start node */
+    xp = xn;
+    while ((xp = xml_parent(xp)) != NULL)
+        nacm_walk_enter(nw, xp, 1);
+ ok:
+    retval = 0;
  done:
     return retval;
- nomatch :  /* rule does not match */
-    retval = 0;
-    goto done;
- deny:      /* rule match and deny */
-    retval = 1;
-    goto done;
 }
 
+/*! Find first rule matching a data node
+ *
+ * @param[in]  nw      NACM walk, active rules of xn
+ * @param[in]  xn      XML node
+ * @param[in]  yspec   YANG spec
+ * @param[out] uniform 1 if all descendants of xn have the same first matching rule (or none)
+ * @retval     i       Index of first matching rule
+ * @retval     nw_len  No rule matches
+ * @retval    -1       Error
+ */
+static int
+nacm_walk_match(struct nacm_walk *nw,
+                cxobj            *xn,
+                yang_stmt        *yspec,
+                int              *uniform)
+{
+    struct nacm_rule *nr;
+    yang_stmt        *ymod = NULL;
+    int               ymodset = 0;
+    int               i;
+
+    /* Rule paths match below this node */
+    *uniform = (nw->nw_nanc == 0 ||
+                bsearch(&xn, nw->nw_anc, nw->nw_nanc, sizeof(cxobj *), nacm_ptr_cmp) == NULL);
+    for (i=0; i<nw->nw_len; i++){
+        nr = nw->nw_rules[i];
+        if (nr->nr_module == NULL)
+            continue;
+        /*  6b) Either (1) the rule does not have a "rule-type" defined or
+            (2) the "rule-type" is "data-node" and the "path" matches the
+            requested data node, action node, or notification node. */    
+        if (nr->nr_path && nw->nw_active[i] == 0)
+            continue;
+        /* 6a) The rule's "module-name" leaf is "*" or equals the name of
+         * the YANG module where the requested data node is defined. 
+         */
+        if (strcmp(nr->nr_module, "*") == 0)
+            break;
+        /* Descendants may be defined in another module (augment) */
+        *uniform = 0;
+        if (!ymodset){
+            if (ys_module_by_xml(yspec, xn, &ymod) < 0)
+                return -1;
+            ymodset++;
+        }
+        /* ymod is NULL (xn is "config") Can this breach the NACM rule? */
+        if (ymod == NULL || strcmp(yang_argument_get(ymod), nr->nr_module) == 0)
+            break;
+    }
+    return i;
+}
+
+/*---------------------------------------------------------------
+ * Datanode write
+ */
+
 /*! Recursive check for NACM write rules among all XML nodes
  *
  * @param[in]  h         Clixon handle
  * @param[in]  xn        XML node (requested node)
- * @param[in]  rulevec   Precomputed rules that apply to this user group
- * @param[in]  xpathvec  Precomputed xpath results that apply to this XML tree
+ * @param[in]  nw        NACM walk with rules and matches that apply to this user group
  * @param[in]  defpermit 0 if default deny, 1 is default permit
  * @param[in]  yspec     YANG spec
  * @param[out] cbret     Error message if retval = 0
  * @retval     1         OK and accept
  * @retval     0         Deny and cbret set
  * @retval    -1         Error
- * XXX differentiate between nomatch: default. or match deny, match accept 
  * nomatch: check write-default rules, next v
  * accept:  Hunky dory
  * deny:    Send error message
  */
 static int
-nacm_datanode_write_recurse(clixon_handle h,
-                            cxobj        *xn,
-                            prepvec      *pv_list,
-                            int           defpermit,
-                            yang_stmt    *yspec,
-                            cbuf         *cbret)
+nacm_datanode_write_recurse(clixon_handle     h,
+                            cxobj            *xn,
+                            struct nacm_walk *nw,
+                            int               defpermit,
+                            yang_stmt        *yspec,
+                            cbuf             *cbret)
 {
     int       retval = -1;
-    cxobj   *x;
-    int      ret = 0;
-    prepvec *pv;
+    cxobj    *x;
+    int       ret = 0;
+    int       i;
+    int       uniform;
 
-    pv = pv_list;
-    if (pv){
-        do {
-            /* return values: -1:Error /0:no match /1: deny /2: permit
-             */
-            if ((ret = nacm_data_write_xrule_xml(xn, pv->pv_xrule, pv->pv_xpathvec, yspec)) < 0)
+    nacm_walk_enter(nw, xn, 1);
+    if ((i = nacm_walk_match(nw, xn, yspec, &uniform)) < 0)
+        goto done;
+    if (i < nw->nw_len){
+        /* Match and deny: break all traversal and send error back to client */
+        if (clicon_strcmp(nw->nw_rules[i]->nr_action, "deny") == 0){
+            if (netconf_access_denied(cbret, "application", "access denied") < 0)
                 goto done;
-            switch(ret){
-            case 0: /* No match, continue with next rule */
-                break;
-            case 1: /* Match and deny: break all traversal and send error back to client */
-                if (netconf_access_denied(cbret, "application", "access denied") < 0)
-                    goto done;
-                goto deny;
-                break;
-            case 2: /* Match and permit: break rule processing but continue recursion */
-                break;
-            }
-            if (ret == 2)
-                break;
-            pv = NEXTQ(prepvec *, pv);
-        } while (pv && pv != pv_list);
+            goto deny;
+        }
+        /* Match and permit: break rule processing but continue recursion */
     }
     /* If no rule match, check default rule: if deny then break traversal and send error */
-    if (ret == 0 && !defpermit){
+    else if (!defpermit){
         if (netconf_access_denied(cbret, "application", "default deny") < 0)
             goto done;
         goto deny;
     }
-    /* If node should be purged, dont recurse and defer removal to caller */
+    /* All descendants are permitted as this node */
+    if (uniform)
+        goto accept;
     x = NULL;   /* Recursively check XML */
     while ((x = xml_child_each(xn, x, CX_ELMNT)) != NULL) {
-        if ((ret = nacm_datanode_write_recurse(h, x, pv_list,
+        if ((ret = nacm_datanode_write_recurse(h, x, nw,
                                                defpermit, yspec, cbret)) < 0)
             goto done;
         if (ret == 0)
             goto deny;
     }
+ accept:
     retval = 1; /* accept */
  done:
+    nacm_walk_enter(nw, xn, -1);
     return retval;
  deny:
     retval = 0; /* deny */
@@ -696,16 +1338,13 @@ nacm_datanode_write(clixon_handle    h,
                     cxobj           *xnacm,
                     cbuf            *cbret)
 {
-    int      retval = -1;
-    cxobj  **gvec = NULL; /* groups */
-    size_t   glen;
-    cxobj  **rlistvec = NULL; /* rule-list */
-    size_t   rlistlen;
-    cxobj  **rvec = NULL; /* rules */
-    char    *write_default = NULL;
-    cvec    *nsc = NULL;
-    int      ret;
-    prepvec *pv_list = NULL;
+    int               retval = -1;
+    char             *write_default = NULL;
+    cvec             *nsc = NULL;
+    int               ret;
+    prepvec          *pv_list = NULL;
+    struct nacm_user *nu = NULL;
+    struct nacm_walk  nw = {0,};
 
     /* Create namespace context for with nacm namespace as default */
     if ((nsc = xml_nsctx_init(NULL, NACM_NS)) == NULL)
@@ -724,24 +1363,24 @@ nacm_datanode_write(clixon_handle    h,
        transport layer.)               */
     if (username == NULL)
         goto step9;
-    /* User's group */
-    if (xpath_vec(xnacm, nsc, "groups/group[user-name='%s']", &gvec, &glen, username) < 0)
-        goto done;
-    /* 4. If no groups are found, continue with step 9. */
-    if (glen == 0)
-        goto step9;
     /* 5. Process all rule-list entries, in the order they appear in the
         configuration.  If a rule-list's "group" leaf-list does not
         match any of the user's groups, proceed to the next rule-list
-        entry. */
-    if (xpath_vec(xnacm, nsc, "rule-list", &rlistvec, &rlistlen) < 0)
+        entry. 
+       Groups and rule-lists of the user are compiled, see nacm_policy_user */
+    if (nacm_policy_user(h, xnacm, username, nsc, &nu) < 0)
         goto done;
+    /* 4. If no groups are found, continue with step 9. */
+    if (nu->nu_len == 0)
+        goto step9;
     /* First run through rules and cache rules as well as lookup objects in xt. 
      */
-    if (nacm_datanode_prepare(h, xt, access, gvec, glen, rlistvec, rlistlen, nsc, &pv_list) < 0)
+    if (nacm_datanode_prepare(h, xt, access, nu, &pv_list) < 0)
+        goto done;
+    if (nacm_walk_init(pv_list, xreq, &nw) < 0)
         goto done;
     /* Then recursivelyy traverse all requested nodes */
-    if ((ret = nacm_datanode_write_recurse(h, xreq, pv_list,
+    if ((ret = nacm_datanode_write_recurse(h, xreq, &nw,
                                            strcmp(write_default, "deny"),
                                            clicon_dbspec_yang(h),
                                            cbret)) < 0)
@@ -773,16 +1412,11 @@ nacm_datanode_write(clixon_handle    h,
     retval = 1;
  done:
     clixon_debug(CLIXON_DBG_NACM, "retval:%d (0:deny 1:permit)", retval);
+    nacm_walk_free(&nw);
     if (pv_list)
         prepvec_free(pv_list);
     if (nsc)
         xml_nsctx_free(nsc);
-    if (gvec)
-        free(gvec);
-    if (rlistvec)
-        free(rlistvec);
-    if (rvec)
-        free(rvec);
     return retval;
  deny: /* Here, cbret must contain a netconf error msg */
     assert(cbuf_len(cbret));
@@ -796,20 +1430,20 @@ nacm_datanode_write(clixon_handle    h,
 
 /*! Perform NACM action: mark if permit, del if deny
  *
- * @param[in] xrule    NACM rule
+ * @param[in] nr       Compiled NACM rule
  * @param[in] xn       XML node (requested node)
  * @retval    0        OK
  * @retval   -1        Error
 
  */
 static int
-nacm_data_read_action(cxobj *xrule,
-                      cxobj *xn)
+nacm_data_read_action(struct nacm_rule *nr,
+                      cxobj            *xn)
 {
     int   retval = -1;
     char *action;
 
-    if ((action = xml_find_body(xrule, "action")) != NULL){
+    if ((action = nr->nr_action) != NULL){
         if (strcmp(action, "deny")==0)
             xml_flag_set(xn, XML_FLAG_DEL);
         else if (strcmp(action, "permit")==0)
@@ -820,105 +1454,39 @@ nacm_data_read_action(cxobj *xrule,
     return retval;
 }
 
-/*! Match specific rule to specific requested node
+/*! Recursive check for NACM read rules among all XML nodes
  *
- * @param[in]  xn       XML node (requested node)
- * @param[in]  xrule    NACM rule
- * @param[in]  yspec    YANG spec
- * @retval     1        OK and rule matches
- * @retval     0        OK and rule does not match
- * @retval    -1        Error
  * Two distinct cases:
  * (1) read_default is permit
  *     mark all deny rules and remove them
  * (2) read_default is deny:
  *     mark all permit rules and ancestors, remove everything else
- */
-static int
-nacm_data_read_xrule_xml(cxobj        *xn,
-                         cxobj        *xrule,
-                         clixon_xvec  *xpathvec,
-                         yang_stmt    *yspec)
-{
-    int        retval = -1;
-    yang_stmt *ymod;
-    char      *module_pattern; /* rule module name */
-    cxobj     *xp;
-    int        i;
-
-    if ((module_pattern = xml_find_body(xrule, "module-name")) == NULL)
-        goto nomatch;
-    /* 6a) The rule's "module-name" leaf is "*" or equals the name of
-     * the YANG module where the requested data node is defined. 
-     */
-    if (strcmp(module_pattern, "*") != 0){
-        if (ys_module_by_xml(yspec, xn, &ymod) < 0)
-            goto done;
-        if (strcmp(yang_argument_get(ymod), module_pattern) != 0)
-            goto nomatch;
-    }
-    /*  6b) Either (1) the rule does not have a "rule-type" defined or
-        (2) the "rule-type" is "data-node" and the "path" matches the
-        requested data node, action node, or notification node. */    
-    if (xml_find_type(xrule, NULL, "path", CX_ELMNT) == NULL){
-        if (nacm_data_read_action(xrule, xn) < 0)
-            goto done;
-        goto match;
-    }
-    for (i=0; i<clixon_xvec_len(xpathvec); i++){
-        xp = clixon_xvec_i(xpathvec, i);
-        /* Check if ancestor is xp (for every xpathvec?) */
-        if (xn == xp || xml_isancestor(xn, xp)){
-            if (nacm_data_read_action(xrule, xn) < 0)
-                goto done;
-            goto match;
-        }
-    }
- nomatch:
-    retval = 0;
- done:
-    return retval;
- match:
-    retval = 1; /* match */
-    goto done;
-}
-
-/*! Recursive check for NACM read rules among all XML nodes
- *
  * @param[in]  h        Clixon handle
  * @param[in]  xn       XML node (requested node)
- * @param[in]  pv_list  Precomputed rules + paths that apply to this user group
+ * @param[in]  nw       NACM walk with rules and matches that apply to this user group
  * @param[in]  yspec    YANG spec
  * @retval     0        OK
  * @retval    -1        Error
  */
 static int
-nacm_datanode_read_recurse(clixon_handle h,
-                           cxobj        *xn,
-                           prepvec      *pv_list,
-                           yang_stmt    *yspec)
+nacm_datanode_read_recurse(clixon_handle     h,
+                           cxobj            *xn,
+                           struct nacm_walk *nw,
+                           yang_stmt        *yspec)
 {
     int      retval = -1;
     cxobj   *x;
     cxobj   *xprev;
-    int      ret;
-    prepvec *pv;
+    int      i;
+    int      uniform = 0;
 
+    nacm_walk_enter(nw, xn, 1);
     if (xml_spec(xn)){ /* Check this node */
-        pv = pv_list;
-        if (pv){
-            do {
-                if ((ret = nacm_data_read_xrule_xml(xn,
-                                                    pv->pv_xrule,
-                                                    pv->pv_xpathvec,
-                                                    yspec)) < 0)
-                    goto done;
-                if (ret == 1)
-                    break; /* stop at first match */
-                pv = NEXTQ(prepvec *, pv);
-            } while (pv && pv != pv_list);
-        }
-
+        if ((i = nacm_walk_match(nw, xn, yspec, &uniform)) < 0)
+            goto done;
+        if (i < nw->nw_len && /* stop at first match */
+            nacm_data_read_action(nw->nw_rules[i], xn) < 0)
+            goto done;
 #if 0 /* 6(A) in algorithm
        * If N did not match any rule R, and default rule is deny, remove that subtree */
         if (strcmp(read_default, "deny") == 0)
@@ -926,13 +1494,13 @@ nacm_datanode_read_recurse(clixon_handle h,
                 goto done;
 #endif
     }
-
-    /* If node should be purged, dont recurse and defer removal to caller */
-    if (xml_flag(xn, XML_FLAG_DEL) == 0){
+    /* If node should be purged, dont recurse and defer removal to caller
+     * If all descendants have the same rule as this node, the subtree is kept as is */
+    if (xml_flag(xn, XML_FLAG_DEL) == 0 && !uniform){
         x = NULL;       /* Recursively check XML */
         xprev = NULL;
         while ((x = xml_child_each(xn, x, CX_ELMNT)) != NULL) {
-            if (nacm_datanode_read_recurse(h, x, pv_list, yspec) < 0)
+            if (nacm_datanode_read_recurse(h, x, nw, yspec) < 0)
                 goto done;
             /* check for delayed remove */
             if (xml_flag(x, XML_FLAG_DEL)){
@@ -944,6 +1512,7 @@ nacm_datanode_read_recurse(clixon_handle h,
     }
     retval = 0;
  done:
+    nacm_walk_enter(nw, xn, -1);
     return retval;
 }
 
@@ -1004,15 +1573,13 @@ nacm_datanode_read(clixon_handle h,
                    char         *username,
                    cxobj        *xnacm)
 {
-    int             retval = -1;
-    cxobj         **gvec = NULL; /* groups */
-    size_t          glen;
-    cxobj         **rlistvec = NULL; /* rule-list */
-    size_t          rlistlen;
-    int             i;
-    char           *read_default = NULL;
-    cvec           *nsc = NULL;
-    prepvec        *pv_list = NULL;
+    int               retval = -1;
+    int               i;
+    char             *read_default = NULL;
+    cvec             *nsc = NULL;
+    prepvec          *pv_list = NULL;
+    struct nacm_user *nu = NULL;
+    struct nacm_walk  nw = {0,};
 
     /* Create namespace context for with nacm namespace as default */
     if ((nsc = xml_nsctx_init(NULL, NACM_NS)) == NULL)
@@ -1024,16 +1591,14 @@ nacm_datanode_read(clixon_handle h,
        transport layer.)               */
     if (username == NULL)
         goto step9;
-    /* User's group */
-    if (xpath_vec(xnacm, nsc, "groups/group[user-name='%s']", &gvec, &glen, username) < 0)
-        goto done;
-    /* 4. If no groups are found (glen=0), continue and check read-default 
+    /* 4. If no groups are found (no rules), continue and check read-default 
           in step 11. */
     /* 5. Process all rule-list entries, in the order they appear in the
         configuration.  If a rule-list's "group" leaf-list does not
         match any of the user's groups, proceed to the next rule-list
-        entry. */
-    if (xpath_vec(xnacm, nsc, "rule-list", &rlistvec, &rlistlen) < 0)
+        entry. 
+       Groups and rule-lists of the user are compiled, see nacm_policy_user */
+    if (nacm_policy_user(h, xnacm, username, nsc, &nu) < 0)
         goto done;
     /* read-default has default permit so should never be NULL */
     if ((read_default = xml_find_body(xnacm, "read-default")) == NULL){
@@ -1043,10 +1608,12 @@ nacm_datanode_read(clixon_handle h,
     /* First run through rules and cache rules as well as lookup objects in xt. 
      * DANGER: objects could be stale if they are removed?
      */
-    if (nacm_datanode_prepare(h, xt, NACM_READ, gvec, glen, rlistvec, rlistlen, nsc, &pv_list) < 0)
+    if (nacm_datanode_prepare(h, xt, NACM_READ, nu, &pv_list) < 0)
+        goto done;
+    if (nacm_walk_init(pv_list, xt, &nw) < 0)
         goto done;
     /* Then recursivelyy traverse all nodes */
-    if (nacm_datanode_read_recurse(h, xt, pv_list, clicon_dbspec_yang(h)) < 0)
+    if (nacm_datanode_read_recurse(h, xt, &nw, clicon_dbspec_yang(h)) < 0)
         goto done;
 #if 1
     /* Step 8(B) above:
@@ -1077,14 +1644,11 @@ nacm_datanode_read(clixon_handle h,
     retval = 0;
  done:
     clixon_debug(CLIXON_DBG_NACM, "retval:%d", retval);
+    nacm_walk_free(&nw);
     if (pv_list)
         prepvec_free(pv_list);
     if (nsc)
         xml_nsctx_free(nsc);
-    if (gvec)
-        free(gvec);
-    if (rlistvec)
-        free(rlistvec);
     return retval;
 }
 
@@ -1115,7 +1679,7 @@ nacm_datanode_read(clixon_handle h,
  * @endcode
  * @see RFC8341 3.4 Access Control Enforcement Procedures
  */
-static int
+int
 nacm_access_check(clixon_handle h,
                   cxobj        *xnacm,
                   char         *peername,
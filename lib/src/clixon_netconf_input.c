@@ -133,7 +133,6 @@ netconf_input_read2(int            s,
     int     restarts = 0;
     int     maxrestarts = 5;
 
-    memset(buf, 0, buflen);
     while ((len = read(s, buf, buflen)) < 0) {
         switch (errno){
         case EINTR:
@@ -182,6 +181,8 @@ netconf_input_read2(int            s,
  * - bufp/lenp
  * - cbmsg
  * - frame_state/frame_size
+ * Chunk-data and EOM data up to a possible trailer are located with memchr and appended
+ * in bulk, only framing characters are examined one at a time.
  */
 int
 netconf_input_msg2(unsigned char      **bufp,
@@ -192,17 +193,51 @@ netconf_input_msg2(unsigned char      **bufp,
                    size_t              *frame_size,
                    int                 *eom)
 {
-    int       retval = -1;
-    int       i;
-    int       ret;
-    int       found = 0;
-    size_t    len;
-    char      ch;
+    int            retval = -1;
+    unsigned char *buf;
+    unsigned char *q;
+    unsigned char *nul = NULL; /* Next NULL char, or end of input */
+    size_t         i;
+    int            ret;
+    int            found = 0;
+    size_t         len;
+    size_t         n;
+    char           ch;
 
     clixon_debug(CLIXON_DBG_DEFAULT | CLIXON_DBG_DETAIL, "");
+    buf = *bufp;
     len = *lenp;
-    for (i=0; i<len; i++){
-        if ((ch = (*bufp)[i]) == 0)
+    i = 0;
+    while (i < len && !found){
+        /* Append data in bulk up to next framing char or NULL char */
+        n = 0;
+        if (framing_type == NETCONF_SSH_CHUNKED){
+            if (*frame_state == 4 && *frame_size > 0){
+                n = len - i;
+                if (n > *frame_size)
+                    n = *frame_size;
+                if ((q = memchr(buf + i, 0, n)) != NULL)
+                    n = q - (buf + i);
+                *frame_size -= n;
+            }
+        }
+        else if (*frame_state == 0){
+            if (nul == NULL || nul < buf + i)
+                if ((nul = memchr(buf + i, 0, len - i)) == NULL)
+                    nul = buf + len;
+            if ((q = memchr(buf + i, ']', nul - (buf + i))) == NULL)
+                q = nul;
+            n = q - (buf + i);
+        }
+        if (n > 0){
+            if (cbuf_append_buf(cbmsg, buf + i, n) < 0){
+                clixon_err(OE_UNIX, errno, "cbuf_append_buf");
+                goto done;
+            }
+            i += n;
+            continue;
+        }
+        if ((ch = buf[i++]) == 0)
             continue; /* Skip NULL chars (eg from terminals) */
         if (framing_type == NETCONF_SSH_CHUNKED){
             /* Track chunked framing defined in RFC6242 */
@@ -232,11 +267,7 @@ netconf_input_msg2(unsigned char      **bufp,
                 found++;
             }
         }
-        if (found){
-            i++;
-            break;
-        }
-    } /* for */
+    } /* while */
     *bufp += i;
     *lenp -= i;
     *eom = found;
@@ -49,6 +49,7 @@
 #include <string.h>
 #include <limits.h>
 #include <stdint.h>
+#include <inttypes.h>
 #include <syslog.h>
 #include <sys/param.h>
 
@@ -1838,9 +1839,9 @@ netconf_content_int2str(netconf_content nr)
  *   urn:ietf:params:netconf:capability:xpath:1.0 (8.9)
  *   urn:ietf:params:netconf:capability:notification:1.0 (RFC5277)
  */
-int
-netconf_capabilites(clixon_handle h,
-                    cbuf         *cb)
+static int
+netconf_capabilities_build(clixon_handle h,
+                           cbuf         *cb)
 {
     int        retval = -1;
     char      *encstr = NULL;
@@ -1905,6 +1906,63 @@ netconf_capabilites(clixon_handle h,
     return retval;
 }
 
+/*! Create capabilities of the server hello message, cached
+ *
+ * The capabilities are built once and reused as long as YANG, including features, and the
+ * options they depend on are unchanged, see yang_stats_generation
+ * @param[in]  h   Clixon handle
+ * @param[out] cb  Msg buffer
+ * @retval     0   OK
+ * @retval    -1   Error
+ * @see netconf_capabilities_build
+ */
+int
+netconf_capabilites(clixon_handle h,
+                    cbuf         *cb)
+{
+    int   retval = -1;
+    cbuf *cbkey = NULL;
+    cbuf *cbcap = NULL;
+    char *key;
+    char *caps;
+    char *module_set_id;
+
+    if ((cbkey = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    module_set_id = clicon_option_str(h, "CLICON_MODULE_SET_ID");
+    cprintf(cbkey, "%" PRIu64 " %d %d %s",
+            yang_stats_generation(),
+            clicon_option_int(h, "CLICON_NETCONF_BASE_CAPABILITY"),
+            clicon_option_bool(h, "CLICON_NETCONF_MONITORING"),
+            module_set_id?module_set_id:"");
+    if (clicon_data_get(h, "netconf-capabilities-key", &key) == 0 &&
+        strcmp(key, cbuf_get(cbkey)) == 0 &&
+        clicon_data_get(h, "netconf-capabilities", &caps) == 0){
+        cbuf_append_str(cb, caps);
+        goto ok;
+    }
+    if ((cbcap = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if (netconf_capabilities_build(h, cbcap) < 0)
+        goto done;
+    if (clicon_data_set(h, "netconf-capabilities", cbuf_get(cbcap)) < 0 ||
+        clicon_data_set(h, "netconf-capabilities-key", cbuf_get(cbkey)) < 0)
+        goto done;
+    cbuf_append_str(cb, cbuf_get(cbcap));
+ ok:
+    retval = 0;
+ done:
+    if (cbkey)
+        cbuf_free(cbkey);
+    if (cbcap)
+        cbuf_free(cbcap);
+    return retval;
+}
+
 /*! Create Netconf server hello. Single cap and defer individual to querying modules
  *
  * @param[in]  h           Clixon handle
@@ -222,6 +222,9 @@ netconf_monitoring_statistics(clixon_handle h,
         cprintf(cb, "<out-rpc-errors>%u</out-rpc-errors>", cv_uint32_get(cv));
     if ((cv = cvec_find(cvv, "out-notifications")) != NULL)
         cprintf(cb, "<out-notifications>%u</out-notifications>", cv_uint32_get(cv));
+    if ((cv = cvec_find(cvv, "dropped-notifications")) != NULL && cv_uint32_get(cv))
+        cprintf(cb, "<dropped-notifications xmlns=\"%s\">%u</dropped-notifications>",
+                CLIXON_LIB_NS, cv_uint32_get(cv));
     cprintf(cb, "</statistics>");
  ok:
     retval = 0;
@@ -351,6 +354,8 @@ netconf_monitoring_statistics_init(clixon_handle h)
         goto done;
     if (stat_counter_add(cvv, "out-notifications") < 0)
         goto done;
+    if (stat_counter_add(cvv, "dropped-notifications") < 0)
+        goto done;
     retval = 0;
  done:
     return retval;
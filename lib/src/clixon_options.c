@@ -80,6 +80,9 @@
 #include "clixon_data.h"
 #include "clixon_xpath_ctx.h"
 #include "clixon_xpath.h"
+#include "clixon_path.h"
+#include "clixon_latency.h"
+#include "clixon_memstats.h"
 #include "clixon_yang_parse_lib.h"
 #include "clixon_netconf_lib.h"
 #include "clixon_xml_sort.h"
@@ -88,6 +91,7 @@
 #include "clixon_xml_map.h"
 #include "clixon_validate.h"
 #include "clixon_xml_default.h"
+#include "clixon_proc.h"
 
 /* Mapping between Clicon startup modes string <--> constants, 
    see clixon-config.yang type startup_mode */
@@ -123,6 +127,60 @@ static const map_str2int nacm_credentials_map[] = {
 static const map_str2int yang_regexp_map[] = {
     {"posix",               REGEXP_POSIX},
     {"libxml2",             REGEXP_LIBXML2},
+    {"pcre2",               REGEXP_PCRE2},
+    {NULL,                 -1}
+};
+
+/*! Translate between int and string of datastore compression
+ *
+ * @see enum compress_mode
+ */
+static const map_str2int xmldb_compress_map[] = {
+    {"none",                COMPRESS_NONE},
+    {"zstd",                COMPRESS_ZSTD},
+    {NULL,                 -1}
+};
+
+/*! Translate between int and string of xpath evaluation mode
+ *
+ * @see enum xpath_eval_mode
+ */
+static const map_str2int xpath_eval_map[] = {
+    {"interpret",           XPATH_EVAL_INTERPRET},
+    {"compile",             XPATH_EVAL_COMPILE},
+    {"differential",        XPATH_EVAL_DIFFERENTIAL},
+    {NULL,                 -1}
+};
+
+/*! Translate between int and string of xml and json parser mode
+ *
+ * @see enum xml_parser_mode
+ */
+static const map_str2int xml_parser_map[] = {
+    {"bison",               XML_PARSER_BISON},
+    {"fast",                XML_PARSER_FAST},
+    {NULL,                 -1}
+};
+
+/*! Translate between int and string of XML arena huge page mode
+ *
+ * @see enum xml_arena_pages
+ */
+static const map_str2int xml_arena_pages_map[] = {
+    {"none",                XML_ARENA_PAGES_NONE},
+    {"transparent",         XML_ARENA_PAGES_TRANSPARENT},
+    {"explicit",            XML_ARENA_PAGES_EXPLICIT},
+    {NULL,                 -1}
+};
+
+/*! Translate between int and string of memory trim policy
+ *
+ * @see enum memory_trim_mode
+ */
+static const map_str2int memory_trim_map[] = {
+    {"none",                MEMORY_TRIM_NONE},
+    {"arena",               MEMORY_TRIM_ARENA},
+    {"heap",                MEMORY_TRIM_HEAP},
     {NULL,                 -1}
 };
 
@@ -136,6 +194,7 @@ static const map_str2int _FORMATS[] = {
     {"json",    FORMAT_JSON},
     {"cli",     FORMAT_CLI},
     {"netconf", FORMAT_NETCONF},
+    {"binary",  FORMAT_BINARY},
     {"default", FORMAT_DEFAULT},
     {NULL,      -1}
 };
@@ -220,6 +279,12 @@ clicon_option_dump(clixon_handle h,
             continue;
         clixon_debug(dbglevel, "%s =\t \"%s\"", xml_name(x), xml_body(x));
     }
+    x = NULL;
+    while ((x = xml_child_each(clicon_conf_xml(h), x, CX_ELMNT)) != NULL) {
+        if (strcmp(xml_name(x), "CLICON_XML_SEARCH_INDEX") != 0)
+            continue;
+        clixon_debug(dbglevel, "%s =\t \"%s\"", xml_name(x), xml_body(x));
+    }
    retval = 0;
  done:
     if (keys)
@@ -380,7 +445,8 @@ merge_control_xml(clixon_handle h,
         /* List options for configure options that are lists or leaf-lists: append to main */
         if (strcmp(name,"CLICON_FEATURE") == 0 ||
             strcmp(name,"CLICON_YANG_DIR") == 0 ||
-            strcmp(name,"CLICON_SNMP_MIB") == 0){
+            strcmp(name,"CLICON_SNMP_MIB") == 0 ||
+            strcmp(name,"CLICON_XML_SEARCH_INDEX") == 0){
             if ((x = xml_dup(xec)) == NULL)
                 goto done;
             if (xml_addsub(xt, x) < 0)
@@ -535,6 +601,8 @@ parse_configfile(clixon_handle  h,
             continue;
         if (strcmp(name,"CLICON_SNMP_MIB")==0)
             continue;
+        if (strcmp(name,"CLICON_XML_SEARCH_INDEX")==0)
+            continue;
         if (clicon_hash_add(copt,
                             name,
                             body,
@@ -587,7 +655,8 @@ clicon_option_add(clixon_handle h,
     }
     if (strcmp(name, "CLICON_FEATURE")==0 ||
         strcmp(name, "CLICON_YANG_DIR")==0 ||
-        strcmp(name, "CLICON_SNMP_MIB")==0){
+        strcmp(name, "CLICON_SNMP_MIB")==0 ||
+        strcmp(name, "CLICON_XML_SEARCH_INDEX")==0){
         if (clixon_xml_parse_va(YB_NONE, NULL, &xconfig, NULL, "<%s>%s</%s>",
                                 name, value, name) < 0)
             goto done;
@@ -713,6 +782,15 @@ clicon_options_main(clixon_handle h)
     xml_sort(xconfig);
     if (clicon_conf_xml_set(h, xconfig) < 0)
         goto done;
+    xpath_cache_size_set(clicon_option_int(h, "CLICON_XPATH_CACHE_SIZE"));
+    api_path_cache_size_set(clicon_option_int(h, "CLICON_API_PATH_CACHE_SIZE"));
+    xpath_eval_mode_set(clicon_xpath_eval(h));
+    clixon_latency_enable(clicon_option_bool(h, "CLICON_LATENCY_STATS"));
+    clixon_mem_enable(clicon_option_bool(h, "CLICON_MEMORY_STATS"));
+    clixon_resource_check_mode_set(clicon_option_int(h, "CLICON_PLUGIN_CALLBACK_CHECK"));
+    xml_parser_mode_set(clicon_xml_parser(h));
+    json_parser_mode_set(clicon_json_parser(h));
+    text_syntax_parser_mode_set(clicon_text_syntax_parser(h));
     retval = 0;
  done:
     if (extraconfdir)
@@ -741,6 +819,7 @@ clixon_options_main_helper(clixon_handle h,
     int   retval = -1;
     int   relog = 0;
     char *dstr;
+    int   ring;
 
     relog = 0;
     dstr = clicon_option_str(h, "CLICON_DEBUG");
@@ -768,6 +847,9 @@ clixon_options_main_helper(clixon_handle h,
     }
     if ((dstr = clicon_option_str(h, "CLICON_LOG_FILE")) != NULL)
         clixon_log_file(dstr);
+    if ((ring = clicon_option_int(h, "CLICON_DEBUG_RING")) > 0 &&
+        clixon_debug_ring_init(ring) < 0)
+        goto done;
     retval = 0;
  done:
     return retval;
@@ -1103,6 +1185,142 @@ clicon_yang_regexp(clixon_handle h)
         return clicon_str2int(yang_regexp_map, str);
 }
 
+/*! Which compression to use for datastore files
+ *
+ * @param[in] h     Clixon handle
+ * @retval    mode  Compression, see enum compress_mode
+ */
+enum compress_mode
+clicon_xmldb_compress(clixon_handle h)
+{
+    char *str;
+    int   mode;
+
+    if ((str = clicon_option_str(h, "CLICON_XMLDB_COMPRESS")) == NULL ||
+        (mode = clicon_str2int(xmldb_compress_map, str)) < 0)
+        return COMPRESS_NONE;
+    return mode;
+}
+
+/*! Which XPath evaluation method to use
+ *
+ * @param[in] h     Clixon handle
+ * @retval    mode  XPath evaluation mode, see enum xpath_eval_mode
+ */
+int
+clicon_xpath_eval(clixon_handle h)
+{
+    char *str;
+    int   mode;
+
+    if ((str = clicon_option_str(h, "CLICON_XPATH_EVAL")) == NULL ||
+        (mode = clicon_str2int(xpath_eval_map, str)) < 0)
+        return XPATH_EVAL_INTERPRET;
+    return mode;
+}
+
+/*! Which XML parser to use
+ *
+ * @param[in] h     Clixon handle
+ * @retval    mode  XML parser mode, see enum xml_parser_mode
+ */
+int
+clicon_xml_parser(clixon_handle h)
+{
+    char *str;
+    int   mode;
+
+    if ((str = clicon_option_str(h, "CLICON_XML_PARSER")) == NULL ||
+        (mode = clicon_str2int(xml_parser_map, str)) < 0)
+        return XML_PARSER_BISON;
+    return mode;
+}
+
+/*! Which JSON parser to use
+ *
+ * @param[in] h     Clixon handle
+ * @retval    mode  JSON parser mode, see enum xml_parser_mode
+ */
+int
+clicon_json_parser(clixon_handle h)
+{
+    char *str;
+    int   mode;
+
+    if ((str = clicon_option_str(h, "CLICON_JSON_PARSER")) == NULL ||
+        (mode = clicon_str2int(xml_parser_map, str)) < 0)
+        return XML_PARSER_BISON;
+    return mode;
+}
+
+/*! Which TEXT syntax parser to use
+ *
+ * @param[in] h     Clixon handle
+ * @retval    mode  TEXT syntax parser mode, see enum xml_parser_mode
+ */
+int
+clicon_text_syntax_parser(clixon_handle h)
+{
+    char *str;
+    int   mode;
+
+    if ((str = clicon_option_str(h, "CLICON_TEXT_SYNTAX_PARSER")) == NULL ||
+        (mode = clicon_str2int(xml_parser_map, str)) < 0)
+        return XML_PARSER_BISON;
+    return mode;
+}
+
+/*! Which HTTP/1 request parser native restconf uses
+ *
+ * @param[in] h     Clixon handle
+ * @retval    mode  HTTP/1 parser mode, see enum xml_parser_mode
+ */
+int
+clicon_restconf_http1_parser(clixon_handle h)
+{
+    char *str;
+    int   mode;
+
+    if ((str = clicon_option_str(h, "CLICON_RESTCONF_HTTP1_PARSER")) == NULL ||
+        (mode = clicon_str2int(xml_parser_map, str)) < 0)
+        return XML_PARSER_BISON;
+    return mode;
+}
+
+/*! Which huge pages XML arena regions use
+ *
+ * @param[in] h     Clixon handle
+ * @retval    mode  Huge page mode, see enum xml_arena_pages
+ */
+int
+clicon_xml_arena_hugepages(clixon_handle h)
+{
+    char *str;
+    int   mode;
+
+    if ((str = clicon_option_str(h, "CLICON_XML_ARENA_HUGEPAGES")) == NULL ||
+        (mode = clicon_str2int(xml_arena_pages_map, str)) < 0)
+        return XML_ARENA_PAGES_NONE;
+    return mode;
+}
+
+/*! Which memory trim policy the backend uses after operations
+ *
+ * @param[in] h     Clixon handle
+ * @retval    mode  Trim policy, see enum memory_trim_mode
+ */
+enum memory_trim_mode
+clicon_memory_trim(clixon_handle h)
+{
+    char *str;
+    int   mode;
+
+    if ((str = clicon_option_str(h, "CLICON_MEMORY_TRIM")) == NULL ||
+        (mode = clicon_str2int(memory_trim_map, str)) < 0)
+        return MEMORY_TRIM_NONE;
+    return mode;
+}
+
 /*---------------------------------------------------------------------
  * Specific option access functions for non-yang options
  * Typically dynamic values and more complex datatypes,
@@ -78,6 +78,10 @@
 #include <arpa/inet.h>
 #include <sys/param.h>
 #include <netinet/in.h>
+#include <stdint.h>
+#ifdef HAVE_LIBPTHREAD
+#include <pthread.h>
+#endif
 
 /* cligen */
 #include <cligen/cligen.h>
@@ -107,8 +111,485 @@
 #include "clixon_api_path_parse.h"
 #include "clixon_instance_id_parse.h"
 
+/* Parsed api-paths and instance-identifiers cached by string, see path_parse_cache_get */
+#define PATH_PARSE_CACHE_SIZE 256
+
+/* Kind of path string */
+enum path_kind {
+    PATH_API_PATH,
+    PATH_INSTANCE_ID
+};
+
+/*! Parsed path, not resolved to yang
+ */
+struct path_parse_cache {
+    uint32_t        ppc_hash;
+    enum path_kind  ppc_kind;
+    char           *ppc_str;    /* Path string, or NULL if slot is free */
+    clixon_path    *ppc_list;   /* Parsed path */
+};
+
+static struct path_parse_cache _path_parse_cache[PATH_PARSE_CACHE_SIZE] = {{0,},};
+static int                     _path_parse_cache_enabled = 1; /* See api_path_cache_size_set */
+#ifdef HAVE_LIBPTHREAD
+static pthread_mutex_t         _path_parse_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+#define PATH_PARSE_CACHE_LOCK()   pthread_mutex_lock(&_path_parse_cache_mutex)
+#define PATH_PARSE_CACHE_UNLOCK() pthread_mutex_unlock(&_path_parse_cache_mutex)
+#else
+#define PATH_PARSE_CACHE_LOCK()
+#define PATH_PARSE_CACHE_UNLOCK()
+#endif
+
+/*! Copy a parsed clixon-path list, without yang resolution
+ *
+ * @param[in]  cplist  Clixon-path list
+ * @param[out] cplistp Copy, free with clixon_path_free
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+clixon_path_dup(clixon_path  *cplist,
+                clixon_path **cplistp)
+{
+    clixon_path *cp;
+    clixon_path *cp1;
+    clixon_path *list = NULL;
+
+    if ((cp = cplist) != NULL){
+        do {
+            if ((cp1 = calloc(1, sizeof(*cp1))) == NULL){
+                clixon_err(OE_UNIX, errno, "calloc");
+                goto err;
+            }
+            ADDQ(cp1, list);
+            if ((cp->cp_prefix && (cp1->cp_prefix = strdup(cp->cp_prefix)) == NULL) ||
+                (cp1->cp_id = strdup(cp->cp_id)) == NULL){
+                clixon_err(OE_UNIX, errno, "strdup");
+                goto err;
+            }
+            if (cp->cp_cvk && (cp1->cp_cvk = cvec_dup(cp->cp_cvk)) == NULL){
+                clixon_err(OE_UNIX, errno, "cvec_dup");
+                goto err;
+            }
+            cp = NEXTQ(clixon_path *, cp);
+        } while (cp && cp != cplist);
+    }
+    *cplistp = list;
+    return 0;
+ err:
+    clixon_path_free(list);
+    return -1;
+}
+
+/*! FNV-1a hash of a path string and its kind
+ */
+static uint32_t
+path_parse_cache_hash(const char    *str,
+                      enum path_kind kind)
+{
+    uint32_t h = 2166136261u;
+
+    while (*str){
+        h ^= (uint8_t)*str++;
+        h *= 16777619u;
+    }
+    h ^= (uint32_t)kind;
+    h *= 16777619u;
+    return h;
+}
+
+/*! Get a copy of a cached parsed path
+ *
+ * The cache is a table where an entry replaces an earlier entry with the same slot. Paths
+ * are cached by string, so that eg a changed leaf value is a different entry
+ * @param[in]  kind    Api-path or instance-id
+ * @param[in]  str     Path string
+ * @param[out] cplistp Copy of parsed path, free with clixon_path_free
+ * @retval     1       Found
+ * @retval     0       Not found
+ * @retval    -1       Error
+ */
+static int
+path_parse_cache_get(enum path_kind kind,
+                     const char    *str,
+                     clixon_path  **cplistp)
+{
+    int                      retval = 0;
+    uint32_t                 hash;
+    struct path_parse_cache *ppc;
+
+    if (!_path_parse_cache_enabled)
+        return 0;
+    hash = path_parse_cache_hash(str, kind);
+    ppc = &_path_parse_cache[hash % PATH_PARSE_CACHE_SIZE];
+    PATH_PARSE_CACHE_LOCK();
+    if (ppc->ppc_str && ppc->ppc_hash == hash && ppc->ppc_kind == kind &&
+        strcmp(ppc->ppc_str, str) == 0){
+        if (clixon_path_dup(ppc->ppc_list, cplistp) < 0)
+            retval = -1;
+        else
+            retval = 1;
+    }
+    PATH_PARSE_CACHE_UNLOCK();
+    return retval;
+}
+
+/*! Add a copy of a parsed path to the cache
+ *
+ * @param[in]  kind    Api-path or instance-id
+ * @param[in]  str     Path string
+ * @param[in]  cplist  Parsed path, not resolved
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+path_parse_cache_set(enum path_kind kind,
+                     const char    *str,
+                     clixon_path   *cplist)
+{
+    uint32_t                 hash;
+    struct path_parse_cache *ppc;
+    clixon_path             *list = NULL;
+    char                    *str1;
+
+    if (!_path_parse_cache_enabled || cplist == NULL)
+        return 0;
+    if (clixon_path_dup(cplist, &list) < 0)
+        return -1;
+    if ((str1 = strdup(str)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        clixon_path_free(list);
+        return -1;
+    }
+    hash = path_parse_cache_hash(str, kind);
+    ppc = &_path_parse_cache[hash % PATH_PARSE_CACHE_SIZE];
+    PATH_PARSE_CACHE_LOCK();
+    if (ppc->ppc_str){
+        free(ppc->ppc_str);
+        clixon_path_free(ppc->ppc_list);
+    }
+    ppc->ppc_hash = hash;
+    ppc->ppc_kind = kind;
+    ppc->ppc_str = str1;
+    ppc->ppc_list = list;
+    PATH_PARSE_CACHE_UNLOCK();
+    return 0;
+}
+
+/*! Enable or disable the parsed path cache, disabling frees all entries
+ */
+static void
+path_parse_cache_enable(int enable)
+{
+    struct path_parse_cache *ppc;
+    int                      i;
+
+    PATH_PARSE_CACHE_LOCK();
+    _path_parse_cache_enabled = enable;
+    if (!enable)
+        for (i = 0; i < PATH_PARSE_CACHE_SIZE; i++){
+            ppc = &_path_parse_cache[i];
+            if (ppc->ppc_str){
+                free(ppc->ppc_str);
+                ppc->ppc_str = NULL;
+                clixon_path_free(ppc->ppc_list);
+                ppc->ppc_list = NULL;
+            }
+        }
+    PATH_PARSE_CACHE_UNLOCK();
+}
+
+/*! Scan identifier as in the api-path and instance-id lexers
+ *
+ * @param[in]  p    Start of identifier
+ * @retval     end  End of identifier, equal to p if none
+ */
+static const char *
+path_scan_identifier(const char *p)
+{
+    if (!isalpha((unsigned char)*p) && *p != '_')
+        return p;
+    p++;
+    while (isalnum((unsigned char)*p) || *p == '_' || *p == '-' || *p == '.')
+        p++;
+    return p;
+}
+
+/*! Scan [prefix:]identifier and append a new clixon-path element
+ *
+ * @param[in,out] pp     Start of node identifier, set to its end
+ * @param[in,out] cplist Clixon-path list
+ * @param[out]    cpp    New element
+ * @retval        1      OK
+ * @retval        0      Not a node identifier
+ * @retval       -1      Error
+ */
+static int
+path_scan_node(const char  **pp,
+               clixon_path **cplist,
+               clixon_path **cpp)
+{
+    const char  *s = *pp;
+    const char  *e;
+    const char  *prefix = NULL;
+    size_t       plen = 0;
+    clixon_path *cp;
+
+    if ((e = path_scan_identifier(s)) == s)
+        return 0;
+    if (*e == ':'){
+        prefix = s;
+        plen = e - s;
+        s = e + 1;
+        if ((e = path_scan_identifier(s)) == s)
+            return 0;
+    }
+    if ((cp = calloc(1, sizeof(*cp))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        return -1;
+    }
+    ADDQ(cp, *cplist);
+    if ((prefix && (cp->cp_prefix = strndup(prefix, plen)) == NULL) ||
+        (cp->cp_id = strndup(s, e - s)) == NULL){
+        clixon_err(OE_UNIX, errno, "strndup");
+        return -1;
+    }
+    *cpp = cp;
+    *pp = e;
+    return 1;
+}
+
+/*! Add key value to clixon-path element
+ *
+ * @param[in]  cp    Clixon-path element
+ * @param[in]  name  Key name, or NULL
+ * @param[in]  val   Start of value, not null-terminated
+ * @param[in]  len   Length of value
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+path_add_key(clixon_path *cp,
+             const char  *name,
+             const char  *val,
+             size_t       len)
+{
+    cg_var *cv;
+
+    if (cp->cp_cvk == NULL &&
+        (cp->cp_cvk = cvec_new(0)) == NULL){
+        clixon_err(OE_UNIX, errno, "cvec_new");
+        return -1;
+    }
+    if ((cv = cvec_add(cp->cp_cvk, CGV_STRING)) == NULL){
+        clixon_err(OE_UNIX, errno, "cvec_add");
+        return -1;
+    }
+    if (name && cv_name_set(cv, name) == NULL){
+        clixon_err(OE_UNIX, errno, "cv_name_set");
+        return -1;
+    }
+    if (cv_strncpy(cv, (char *)val, len) == NULL){
+        clixon_err(OE_UNIX, errno, "cv_strncpy");
+        return -1;
+    }
+    return 0;
+}
+
+/*! Parse common api-paths without the generated parser: /[module:]id[=value*(,value)]
+ *
+ * @param[in]  api_path  Api-path
+ * @param[out] cplistp   Clixon-path list, same as api_path_parse would create
+ * @retval     1         OK
+ * @retval     0         Not handled, use the generated parser
+ * @retval    -1         Error
+ */
+static int
+api_path_parse_fast(const char   *api_path,
+                    clixon_path **cplistp)
+{
+    int          retval = -1;
+    clixon_path *cplist = NULL;
+    clixon_path *cp = NULL;
+    const char  *p = api_path;
+    const char  *s;
+    int          ret;
+
+    /* White space and empty paths are handled by the parser */
+    if (*p != '/' || strpbrk(p, " \t\r\n") != NULL)
+        goto skip;
+    while (*p == '/'){
+        p++;
+        if ((ret = path_scan_node(&p, &cplist, &cp)) < 0)
+            goto done;
+        if (ret == 0)
+            goto skip;
+        if (*p == '='){
+            do {
+                s = ++p;
+                while (*p && strchr(":/?#[]@,", *p) == NULL)
+                    p++;
+                if (path_add_key(cp, NULL, s, p - s) < 0)
+                    goto done;
+            } while (*p == ',');
+        }
+        if (*p != '/' && *p != '\0')
+            goto skip;
+    }
+    *cplistp = cplist;
+    cplist = NULL;
+    retval = 1;
+ done:
+    if (cplist)
+        clixon_path_free(cplist);
+    return retval;
+ skip:
+    retval = 0;
+    goto done;
+}
+
+/*! Scan quoted string of instance-id predicate
+ *
+ * @param[in,out] pp   Start of quote, set to after end quote
+ * @param[out]    sp   Start of string
+ * @param[out]    lenp Length of string
+ * @retval        1    OK
+ * @retval        0    Not a quoted string
+ */
+static int
+path_scan_qstring(const char **pp,
+                  const char **sp,
+                  size_t      *lenp)
+{
+    const char *p = *pp;
+    const char *e;
+
+    if (*p != '\'' && *p != '"')
+        return 0;
+    if ((e = strchr(p + 1, *p)) == NULL)
+        return 0;
+    *sp = p + 1;
+    *lenp = e - (p + 1);
+    *pp = e + 1;
+    return 1;
+}
+
+/*! Parse common instance-ids without the generated parser
+ *
+ * Handles /[prefix:]id with key predicates [[prefix:]name='value'], a leaf-list
+ * predicate [.='value'] or a position [n]
+ * @param[in]  path      Instance-id
+ * @param[out] cplistp   Clixon-path list, same as instance_id_parse would create
+ * @retval     1         OK
+ * @retval     0         Not handled, use the generated parser
+ * @retval    -1         Error
+ */
+static int
+instance_id_parse_fast(const char   *path,
+                       clixon_path **cplistp)
+{
+    int           retval = -1;
+    clixon_path  *cplist = NULL;
+    clixon_path  *cp = NULL;
+    const char   *p = path;
+    const char   *s;
+    const char   *e;
+    const char   *v;
+    size_t        vlen;
+    char         *name = NULL;
+    unsigned long pos;
+    int           single;  /* Leaf-list or position predicate, only one allowed */
+    cg_var       *cv;
+    int           ret;
+
+    /* White space is handled by the parser */
+    if (*p != '/' || strpbrk(p, " \t\r\n") != NULL)
+        goto skip;
+    while (*p == '/'){
+        p++;
+        if ((ret = path_scan_node(&p, &cplist, &cp)) < 0)
+            goto done;
+        if (ret == 0)
+            goto skip;
+        single = 0;
+        while (*p == '['){
+            if (single)
+                goto skip;
+            p++;
+            if (*p >= '1' && *p <= '9'){ /* [n] */
+                if (cp->cp_cvk)
+                    goto skip;
+                errno = 0;
+                pos = strtoul(p, (char **)&e, 10);
+                if (errno || pos > UINT32_MAX || *e != ']')
+                    goto skip;
+                if ((cp->cp_cvk = cvec_new(1)) == NULL){
+                    clixon_err(OE_UNIX, errno, "cvec_new");
+                    goto done;
+                }
+                cv = cvec_i(cp->cp_cvk, 0);
+                cv_type_set(cv, CGV_UINT32);
+                cv_uint32_set(cv, (uint32_t)pos);
+                p = e;
+                single++;
+            }
+            else if (*p == '.'){ /* [.='value'] */
+                if (cp->cp_cvk || *++p != '=')
+                    goto skip;
+                p++;
+                if (path_scan_qstring(&p, &v, &vlen) == 0)
+                    goto skip;
+                if (path_add_key(cp, ".", v, vlen) < 0)
+                    goto done;
+                single++;
+            }
+            else { /* [[prefix:]name='value'], prefix is ignored */
+                s = p;
+                if ((e = path_scan_identifier(s)) == s)
+                    goto skip;
+                if (*e == ':'){
+                    s = e + 1;
+                    if ((e = path_scan_identifier(s)) == s)
+                        goto skip;
+                }
+                p = e;
+                if (*p++ != '=')
+                    goto skip;
+                if (path_scan_qstring(&p, &v, &vlen) == 0)
+                    goto skip;
+                if ((name = strndup(s, e - s)) == NULL){
+                    clixon_err(OE_UNIX, errno, "strndup");
+                    goto done;
+                }
+                if (path_add_key(cp, name, v, vlen) < 0)
+                    goto done;
+                free(name);
+                name = NULL;
+            }
+            if (*p++ != ']')
+                goto skip;
+        }
+        if (*p != '/' && *p != '\0')
+            goto skip;
+    }
+    *cplistp = cplist;
+    cplist = NULL;
+    retval = 1;
+ done:
+    if (name)
+        free(name);
+    if (cplist)
+        clixon_path_free(cplist);
+    return retval;
+ skip:
+    retval = 0;
+    goto done;
+}
+
 /*! Given api-path, parse it, and return a clixon-path struct
  *
+ * Common api-paths are parsed without the generated parser, and parsed api-paths are
+ * cached by string
  * @param[in]  api_path  String with api-path syntax according to RESTCONF RFC8040
  * @param[out] cplist    Structured internal clixon-path
  * @retval     0         OK
@@ -131,8 +612,17 @@ api_path_parse(char         *api_path,
 {
     int                  retval = -1;
     clixon_api_path_yacc ay = {0,};
+    int                  ret;
 
     clixon_debug(CLIXON_DBG_PARSE, "%s", api_path);
+    if ((ret = path_parse_cache_get(PATH_API_PATH, api_path, cplist)) < 0)
+        goto done;
+    if (ret == 1)
+        goto ok;
+    if ((ret = api_path_parse_fast(api_path, cplist)) < 0)
+        goto done;
+    if (ret == 1)
+        goto cache;
     ay.ay_parse_string = api_path;
     ay.ay_name = "api-path parser";
     ay.ay_linenum = 1;
@@ -149,6 +639,10 @@ api_path_parse(char         *api_path,
     api_path_parse_exit(&ay);
     api_path_scan_exit(&ay);
     *cplist = ay.ay_top;
+ cache:
+    if (path_parse_cache_set(PATH_API_PATH, api_path, *cplist) < 0)
+        goto done;
+ ok:
     retval = 0;
  done:
     clixon_debug(CLIXON_DBG_PARSE, "retval: %d", retval);
@@ -157,6 +651,8 @@ api_path_parse(char         *api_path,
 
 /*! Given instance-id path, parse it, and return an clixon-path struct
  *
+ * Common instance-ids are parsed without the generated parser, and parsed instance-ids are
+ * cached by string
  * @param[in]  api_path  String with syntax according to YANG RFC7980
  * @param[out] cplist    Structured internal clixon-path
  * @retval     0         OK
@@ -177,8 +673,17 @@ instance_id_parse(char         *path,
 {
     int                     retval = -1;
     clixon_instance_id_yacc iy = {0,};
+    int                     ret;
 
     clixon_debug(CLIXON_DBG_PARSE, "%s", path);
+    if ((ret = path_parse_cache_get(PATH_INSTANCE_ID, path, cplist)) < 0)
+        goto done;
+    if (ret == 1)
+        goto ok;
+    if ((ret = instance_id_parse_fast(path, cplist)) < 0)
+        goto done;
+    if (ret == 1)
+        goto cache;
     iy.iy_parse_string = path;
     iy.iy_name = "instance-id parser";
     iy.iy_linenum = 1;
@@ -195,6 +700,10 @@ instance_id_parse(char         *path,
     instance_id_parse_exit(&iy);
     instance_id_scan_exit(&iy);
     *cplist = iy.iy_top;
+ cache:
+    if (path_parse_cache_set(PATH_INSTANCE_ID, path, *cplist) < 0)
+        goto done;
+ ok:
     retval = 0;
  done:
     clixon_debug(CLIXON_DBG_PARSE, "retval: %d", retval);
@@ -532,7 +1041,6 @@ api_path_fmt2api_path(const char *api_path_fmt,
     int     i;
     int     j;
     char   *str;
-    char   *strenc=NULL;
     cg_var *cv;
     size_t  len;
 
@@ -560,13 +1068,8 @@ api_path_fmt2api_path(const char *api_path_fmt,
                 }
                 if (uri_encode){
                     /* Only if restval, ie =%s, not if eg /%s/ */
-                    if (uri_percent_encode(&strenc, "%s", str) < 0)
+                    if (uri_percent_cbuf_append(cb, str) < 0)
                         goto done;
-                    cprintf(cb, "%s", strenc);
-                    if (strenc){
-                        free(strenc);
-                        strenc = NULL;
-                    }
                 }
                 else
                     cprintf(cb, "%s", str);
@@ -697,6 +1200,309 @@ api_path_fmt2xpath(char  *api_path_fmt,
     return retval;
 }
 
+/*! Cached schema resolution of an api-path
+ *
+ * The key is the api-path without key values, eg /ex:a/b/c for /ex:a/b=1,2/c, and the
+ * value is the yang node and prefix module of each segment. Only key values are then
+ * handled per call.
+ * Entries are in a bucket list and in an LRU list, most recently used first.
+ * Api-paths with mount-points are not cached.
+ * All entries are removed when YANG statements are created or freed, since entries point
+ * to yang nodes, see yang_stats_generation
+ * @see api_path_cache_get
+ */
+struct api_path_cache {
+    struct api_path_cache *apc_next;    /* Next in bucket */
+    struct api_path_cache *apc_lru_prev;
+    struct api_path_cache *apc_lru_next;
+    uint32_t               apc_hash;
+    yang_stmt             *apc_yspec;   /* Top-level yang spec */
+    yang_class             apc_class;   /* Schema or data nodes */
+    char                  *apc_str;     /* Api-path without key values */
+    int                    apc_len;     /* Number of segments */
+    yang_stmt            **apc_y;       /* Yang node of each segment */
+    yang_stmt            **apc_ymod;    /* Module of prefix of each segment, or NULL */
+};
+
+/*! Schema resolution of the segments of one api-path, filled in from cache or when resolved
+ */
+struct api_path_resolve {
+    yang_stmt **apr_y;      /* Yang node of each segment */
+    yang_stmt **apr_ymod;   /* Module of prefix of each segment, or NULL */
+    int         apr_i;      /* Current segment */
+    int         apr_hit;    /* Vectors are from cache */
+    int         apr_mount;  /* Api-path has a mount-point, do not cache */
+};
+
+/* Api-path schema cache, see CLICON_API_PATH_CACHE_SIZE */
+#define API_PATH_CACHE_BUCKETS 1024
+static struct api_path_cache *_api_path_cache_vec[API_PATH_CACHE_BUCKETS] = {NULL,};
+static struct api_path_cache *_api_path_cache_lru = NULL;      /* Most recently used */
+static struct api_path_cache *_api_path_cache_lru_tail = NULL; /* Least recently used */
+static uint32_t               _api_path_cache_size = 0;        /* Max number of entries, 0: disabled */
+static uint32_t               _api_path_cache_nr = 0;
+static uint64_t               _api_path_cache_gen = 0;         /* YANG generation of entries */
+#ifdef HAVE_LIBPTHREAD
+/* The library may be used by multi-threaded applications, eg clients using the client API */
+static pthread_mutex_t        _api_path_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+#define API_PATH_CACHE_LOCK()   pthread_mutex_lock(&_api_path_cache_mutex)
+#define API_PATH_CACHE_UNLOCK() pthread_mutex_unlock(&_api_path_cache_mutex)
+#else
+#define API_PATH_CACHE_LOCK()
+#define API_PATH_CACHE_UNLOCK()
+#endif
+
+/*! FNV-1a hash of an api-path without key values, yang spec and node class
+ */
+static uint32_t
+api_path_cache_hash(const char *str,
+                    yang_stmt  *yspec,
+                    yang_class  nodeclass)
+{
+    uint32_t h = 2166136261u;
+
+    while (*str){
+        h ^= (uint8_t)*str++;
+        h *= 16777619u;
+    }
+    h ^= (uint32_t)((uintptr_t)yspec >> 4);
+    h *= 16777619u;
+    h ^= (uint32_t)nodeclass;
+    return h;
+}
+
+/*! Unlink entry from LRU list
+ */
+static void
+api_path_cache_lru_rm(struct api_path_cache *apc)
+{
+    if (apc->apc_lru_prev)
+        apc->apc_lru_prev->apc_lru_next = apc->apc_lru_next;
+    else
+        _api_path_cache_lru = apc->apc_lru_next;
+    if (apc->apc_lru_next)
+        apc->apc_lru_next->apc_lru_prev = apc->apc_lru_prev;
+    else
+        _api_path_cache_lru_tail = apc->apc_lru_prev;
+    apc->apc_lru_prev = apc->apc_lru_next = NULL;
+}
+
+/*! Insert entry first in LRU list
+ */
+static void
+api_path_cache_lru_add(struct api_path_cache *apc)
+{
+    apc->apc_lru_prev = NULL;
+    apc->apc_lru_next = _api_path_cache_lru;
+    if (_api_path_cache_lru)
+        _api_path_cache_lru->apc_lru_prev = apc;
+    else
+        _api_path_cache_lru_tail = apc;
+    _api_path_cache_lru = apc;
+}
+
+/*! Remove and free a cache entry
+ */
+static void
+api_path_cache_free1(struct api_path_cache *apc)
+{
+    struct api_path_cache **app;
+
+    for (app = &_api_path_cache_vec[apc->apc_hash % API_PATH_CACHE_BUCKETS]; *app; app = &(*app)->apc_next)
+        if (*app == apc){
+            *app = apc->apc_next;
+            break;
+        }
+    api_path_cache_lru_rm(apc);
+    _api_path_cache_nr--;
+    free(apc->apc_y);
+    free(apc->apc_ymod);
+    free(apc->apc_str);
+    free(apc);
+}
+
+/*! Evict least recently used entries until the cache is within its size
+ */
+static void
+api_path_cache_evict(void)
+{
+    while (_api_path_cache_lru_tail && _api_path_cache_nr > _api_path_cache_size)
+        api_path_cache_free1(_api_path_cache_lru_tail);
+}
+
+/*! Remove all entries if YANG statements have been created or freed since they were added
+ */
+static void
+api_path_cache_validate(void)
+{
+    uint64_t gen;
+
+    if ((gen = yang_stats_generation()) != _api_path_cache_gen){
+        while (_api_path_cache_lru)
+            api_path_cache_free1(_api_path_cache_lru);
+        _api_path_cache_gen = gen;
+    }
+}
+
+/*! Set max number of entries of the api-path schema cache
+ *
+ * 0 also disables the cache of parsed api-paths and instance-ids
+ * @param[in]  size  Max number of cached api-paths, 0 disables the cache
+ * @retval     0     OK
+ * @see option CLICON_API_PATH_CACHE_SIZE
+ */
+int
+api_path_cache_size_set(uint32_t size)
+{
+    API_PATH_CACHE_LOCK();
+    _api_path_cache_size = size;
+    api_path_cache_evict();
+    API_PATH_CACHE_UNLOCK();
+    path_parse_cache_enable(size != 0);
+    return 0;
+}
+
+/*! Get schema resolution of an api-path from the cache
+ *
+ * @param[in]  yspec     Yang spec
+ * @param[in]  nodeclass Schema nodes or data nodes
+ * @param[in]  str       Api-path without key values
+ * @param[in]  len       Number of segments
+ * @param[out] apr       Resolution, apr_y and apr_ymod are filled in if found
+ * @retval     1         Found
+ * @retval     0         Not found or cache disabled
+ */
+static int
+api_path_cache_get(yang_stmt               *yspec,
+                   yang_class               nodeclass,
+                   const char              *str,
+                   int                      len,
+                   struct api_path_resolve *apr)
+{
+    struct api_path_cache *apc;
+    uint32_t               hash;
+
+    if (_api_path_cache_size == 0)
+        return 0;
+    hash = api_path_cache_hash(str, yspec, nodeclass);
+    API_PATH_CACHE_LOCK();
+    api_path_cache_validate();
+    for (apc = _api_path_cache_vec[hash % API_PATH_CACHE_BUCKETS]; apc; apc = apc->apc_next)
+        if (apc->apc_hash == hash && apc->apc_yspec == yspec && apc->apc_class == nodeclass &&
+            apc->apc_len == len && strcmp(apc->apc_str, str) == 0)
+            break;
+    if (apc != NULL){
+        api_path_cache_lru_rm(apc);
+        api_path_cache_lru_add(apc);
+        memcpy(apr->apr_y, apc->apc_y, len*sizeof(yang_stmt *));
+        memcpy(apr->apr_ymod, apc->apc_ymod, len*sizeof(yang_stmt *));
+        apr->apr_hit = 1;
+    }
+    API_PATH_CACHE_UNLOCK();
+    return apr->apr_hit;
+}
+
+/*! Add schema resolution of an api-path to the cache
+ *
+ * Not added if the api-path has a mount-point or is not fully resolved
+ * @param[in]  yspec     Yang spec
+ * @param[in]  nodeclass Schema nodes or data nodes
+ * @param[in]  str       Api-path without key values
+ * @param[in]  len       Number of segments
+ * @param[in]  apr       Resolution
+ * @retval     0         OK
+ * @retval    -1         Error
+ */
+static int
+api_path_cache_set(yang_stmt               *yspec,
+                   yang_class               nodeclass,
+                   const char              *str,
+                   int                      len,
+                   struct api_path_resolve *apr)
+{
+    int                    retval = -1;
+    struct api_path_cache *apc = NULL;
+    int                    i;
+
+    if (_api_path_cache_size == 0 || apr->apr_hit || apr->apr_mount || len == 0)
+        return 0;
+    for (i=0; i<len; i++)
+        if (apr->apr_y[i] == NULL)
+            return 0;
+    if ((apc = calloc(1, sizeof(*apc))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    if ((apc->apc_str = strdup(str)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    if ((apc->apc_y = malloc(len*sizeof(yang_stmt *))) == NULL ||
+        (apc->apc_ymod = malloc(len*sizeof(yang_stmt *))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    memcpy(apc->apc_y, apr->apr_y, len*sizeof(yang_stmt *));
+    memcpy(apc->apc_ymod, apr->apr_ymod, len*sizeof(yang_stmt *));
+    apc->apc_hash = api_path_cache_hash(str, yspec, nodeclass);
+    apc->apc_yspec = yspec;
+    apc->apc_class = nodeclass;
+    apc->apc_len = len;
+    /* Another thread may have added the same api-path meanwhile, a duplicate is evicted eventually */
+    API_PATH_CACHE_LOCK();
+    api_path_cache_validate();
+    apc->apc_next = _api_path_cache_vec[apc->apc_hash % API_PATH_CACHE_BUCKETS];
+    _api_path_cache_vec[apc->apc_hash % API_PATH_CACHE_BUCKETS] = apc;
+    api_path_cache_lru_add(apc);
+    _api_path_cache_nr++;
+    api_path_cache_evict();
+    API_PATH_CACHE_UNLOCK();
+    apc = NULL;
+    retval = 0;
+ done:
+    if (apc){
+        if (apc->apc_str)
+            free(apc->apc_str);
+        if (apc->apc_y)
+            free(apc->apc_y);
+        if (apc->apc_ymod)
+            free(apc->apc_ymod);
+        free(apc);
+    }
+    return retval;
+}
+
+/*! Allocate resolution vectors of an api-path with len segments
+ *
+ * @param[out] apr  Resolution, free vectors with api_path_resolve_free
+ * @param[in]  len  Number of segments
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+api_path_resolve_init(struct api_path_resolve *apr,
+                      int                      len)
+{
+    memset(apr, 0, sizeof(*apr));
+    if ((apr->apr_y = calloc(len+1, sizeof(yang_stmt *))) == NULL ||
+        (apr->apr_ymod = calloc(len+1, sizeof(yang_stmt *))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        return -1;
+    }
+    return 0;
+}
+
+/*! Free resolution vectors of an api-path
+ */
+static void
+api_path_resolve_free(struct api_path_resolve *apr)
+{
+    if (apr->apr_y)
+        free(apr->apr_y);
+    if (apr->apr_ymod)
+        free(apr->apr_ymod);
+}
+
 /*! Translate from restconf api-path(cvv) to xml xpath(cbuf) and namespace context
  * 
  * @param[in]     api_path URI-encoded path expression" (RFC8040 3.5.3) as cvec
@@ -763,15 +1569,25 @@ api_path2xpath_cvv(cvec      *api_path,
     int        ret;
     int        root;
     int        ymtpoint; /* y is potential mount-point */
+    yang_stmt *yspec0 = yspec;
+    cbuf      *cbt = NULL; /* api-path without key values */
+    struct api_path_resolve apr = {NULL,};
 
     cprintf(xpath, "/");
     /* Initialize namespace context */
     if ((nsc = xml_nsctx_init(NULL, NULL)) == NULL)
         goto done;
-    if ((cberr = cbuf_new()) == NULL){
-        clixon_err(OE_UNIX, errno, "cbuf_new");
+    if ((cberr = clixon_cbuf_borrow(0)) == NULL)
         goto done;
-    }
+    /* Get yang nodes of the segments from cache, see CLICON_API_PATH_CACHE_SIZE */
+    if ((cbt = clixon_cbuf_borrow(0)) == NULL)
+        goto done;
+    cv = NULL;
+    while ((cv = cvec_each(api_path, cv)) != NULL)
+        cprintf(cbt, "/%s", cv_name_get(cv));
+    if (api_path_resolve_init(&apr, cvec_len(api_path)) < 0)
+        goto done;
+    api_path_cache_get(yspec0, YC_DATANODE, cbuf_get(cbt), cvec_len(api_path), &apr);
     ymtpoint = 0;
     root = 1; /* root or mountpoint */
     for (i=0; i<cvec_len(api_path); i++){
@@ -789,38 +1605,50 @@ api_path2xpath_cvv(cvec      *api_path,
                 goto done;
             goto fail;
         }
-        ymod = NULL;
-        if (prefix){ /* if prefix -> get module + change namespace */
-            if ((ymod = yang_find_module_by_name(yspec, prefix)) == NULL){
-                cprintf(cberr, "No such yang module: %s", prefix);
-                if (xerr && netconf_invalid_value_xml(xerr, "application", cbuf_get(cberr)) < 0)
-                    goto done;
-                goto fail;
-            }
-            namespace = yang_find_mynamespace(ymod); /* change namespace */
+        if (apr.apr_hit){
+            y = apr.apr_y[i];
+            if ((ymod = apr.apr_ymod[i]) != NULL)
+                namespace = yang_find_mynamespace(ymod);
         }
-        if (i == 0 || root || ymtpoint){
-            if (ymod == NULL){
-                cprintf(cberr, "'%s': Expected mountpoint prefix:name", nodeid);
-                if (xerr && netconf_invalid_value_xml(xerr, "application", cbuf_get(cberr)) < 0)
+        else {
+            ymod = NULL;
+            if (prefix){ /* if prefix -> get module + change namespace */
+                if ((ymod = yang_find_module_by_name(yspec, prefix)) == NULL){
+                    cprintf(cberr, "No such yang module: %s", prefix);
+                    if (xerr && netconf_invalid_value_xml(xerr, "application", cbuf_get(cberr)) < 0)
+                        goto done;
+                    goto fail;
+                }
+                namespace = yang_find_mynamespace(ymod); /* change namespace */
+            }
+            if (i == 0 || root || ymtpoint){
+                if (ymod == NULL){
+                    cprintf(cberr, "'%s': Expected mountpoint prefix:name", nodeid);
+                    if (xerr && netconf_invalid_value_xml(xerr, "application", cbuf_get(cberr)) < 0)
+                        goto done;
+                    goto fail;
+                }
+                y = yang_find_datanode(ymod, name);
+            }
+            else{
+                y = yang_find_datanode(y, name);
+            }
+            if (y == NULL){
+                if (xerr && netconf_unknown_element_xml(xerr, "application", name, "Unknown element") < 0)
                     goto done;
                 goto fail;
             }
-            y = yang_find_datanode(ymod, name);
-        }
-        else{
-            y = yang_find_datanode(y, name);
-        }
-        if (y == NULL){
-            if (xerr && netconf_unknown_element_xml(xerr, "application", name, "Unknown element") < 0)
-                goto done;
-            goto fail;
+            apr.apr_y[i] = y;
+            apr.apr_ymod[i] = ymod;
         }
         root = 0;
-        /* If x/y is mountpoint, change y to new yspec */
-        if ((ret = yang_schema_mount_point(y)) < 0)
+        /* If x/y is mountpoint, change y to new yspec. Not if from cache */
+        if (apr.apr_hit)
+            ret = 0;
+        else if ((ret = yang_schema_mount_point(y)) < 0)
             goto done;
         if (ret == 1){
+            apr.apr_mount++;
             y1 = NULL;
             if (nsc){
                 cvec_free(nsc);
@@ -858,9 +1686,12 @@ api_path2xpath_cvv(cvec      *api_path,
             }
         }
         /* y may have changed to new */
-        if ((ymtpoint = yang_schema_mount_point(y)) < 0)
+        if (apr.apr_hit)
+            ymtpoint = 0;
+        else if ((ymtpoint = yang_schema_mount_point(y)) < 0)
             goto done;
         if (ymtpoint){
+            apr.apr_mount++;
             /* If we cant find a specific mountpoint, we just assign the first.
              * XXX: Ignore return value: if none are mounted, no change of yspec is made here
              */
@@ -923,6 +1754,8 @@ api_path2xpath_cvv(cvec      *api_path,
             name = NULL;
         }
     } /* for */
+    if (api_path_cache_set(yspec0, YC_DATANODE, cbuf_get(cbt), cvec_len(api_path), &apr) < 0)
+        goto done;
     retval = 1; /* OK */
     if (nscp){
         *nscp = nsc;
@@ -930,8 +1763,11 @@ api_path2xpath_cvv(cvec      *api_path,
     }
  done:
     clixon_debug(CLIXON_DBG_XPATH | CLIXON_DBG_DETAIL, "retval:%d", retval);
+    api_path_resolve_free(&apr);
+    if (cbt)
+        clixon_cbuf_release(cbt);
     if (cberr)
-        cbuf_free(cberr);
+        clixon_cbuf_release(cberr);
     if (valvec)
         free(valvec);
     if (prefix)
@@ -1029,6 +1865,7 @@ api_path2xpath(char      *api_path,
  * @param[in]   y0        Yang spec for x0
  * @param[in]   nodeclass Set to schema nodes, data nodes, etc
  * @param[in]   strict    Break if api-path is not "complete" otherwise ignore and continue
+ * @param[in]   apr       Yang nodes of segments, from cache or set here
  * @param[out]  xbotp     Resulting xml tree 
  * @param[out]  ybotp     Yang spec matching xpathp
  * @param[out]  xerr      Netconf error message (if retval=0)
@@ -1047,6 +1884,7 @@ api_path2xml_vec(char      **vec,
                  yang_stmt  *y0,
                  yang_class  nodeclass,
                  int         strict,
+                 struct api_path_resolve *apr,
                  cxobj     **xbotp,
                  yang_stmt **ybotp,
                  cxobj     **xerr)
@@ -1067,7 +1905,7 @@ api_path2xml_vec(char      **vec,
     cxobj     *x = NULL;
     yang_stmt *y = NULL;
     yang_stmt *y1;
-    yang_stmt *ymod;
+    yang_stmt *ymod = NULL;
     yang_stmt *ykey;
     char      *namespace = NULL;
     cbuf      *cberr = NULL;
@@ -1083,10 +1921,8 @@ api_path2xml_vec(char      **vec,
             *ybotp = y0;
         goto ok;
     } /* E.g "x=1,2" -> nodeid:x restval=1,2 */
-    if ((cberr = cbuf_new()) == NULL){
-        clixon_err(OE_UNIX, errno, "cbuf_new");
+    if ((cberr = clixon_cbuf_borrow(0)) == NULL)
         goto done;
-    }
     /* restval is RFC 3896 encoded */
     if ((restval = index(nodeid, '=')) != NULL){
         *restval = '\0';
@@ -1095,6 +1931,12 @@ api_path2xml_vec(char      **vec,
     /* Split into prefix and localname */
     if (nodeid_split(nodeid, &prefix, &name) < 0)
         goto done;
+    if (apr->apr_hit){
+        y = apr->apr_y[apr->apr_i];
+        if ((ymod = apr->apr_ymod[apr->apr_i]) != NULL)
+            namespace = yang_find_mynamespace(ymod);
+        goto resolved;
+    }
     if ((ymtpoint = yang_schema_mount_point(y0)) < 0)
         goto done;
     if (yang_keyword_get(y0) == Y_SPEC || ymtpoint){
@@ -1106,6 +1948,7 @@ api_path2xml_vec(char      **vec,
             goto fail;
         }
         if (ymtpoint){
+            apr->apr_mount++;
             /* XXX: Ignore return value: if none are mounted, no change of yspec is made here */
             if (yang_mount_get_yspec_any(y0, &y0) < 0)
                 goto done;
@@ -1139,6 +1982,9 @@ api_path2xml_vec(char      **vec,
         }
         namespace = yang_find_mynamespace(ymod);
     }
+    apr->apr_y[apr->apr_i] = y;
+    apr->apr_ymod[apr->apr_i] = prefix ? ymod : NULL;
+ resolved:
     switch (yang_keyword_get(y)){
     case Y_LEAF_LIST:
 #if 0
@@ -1249,10 +2095,13 @@ api_path2xml_vec(char      **vec,
         if (xmlns_set(x, NULL, namespace) < 0)
             goto done;
     }
-    /* If x/y is mountpoint, pass mount yspec to children */
-    if ((ymtpoint = yang_schema_mount_point(y)) < 0)
+    /* If x/y is mountpoint, pass mount yspec to children. Not if from cache */
+    if (apr->apr_hit)
+        ymtpoint = 0;
+    else if ((ymtpoint = yang_schema_mount_point(y)) < 0)
         goto done;
     if (ymtpoint){
+        apr->apr_mount++;
         y1 = NULL;
         if (xml_nsctx_yangspec(ys_spec(y), &nsc) < 0)
             goto done;
@@ -1268,9 +2117,10 @@ api_path2xml_vec(char      **vec,
         if (y1 != NULL)
             y = y1;
     }
+    apr->apr_i++;
     if ((retval = api_path2xml_vec(vec+1, nvec-1,
                                    x, y,
-                                   nodeclass, strict,
+                                   nodeclass, strict, apr,
                                    xbotp, ybotp, xerr)) < 1)
         goto done;
  ok:
@@ -1282,7 +2132,7 @@ api_path2xml_vec(char      **vec,
     if (nsc)
         cvec_free(nsc);
     if (cberr)
-        cbuf_free(cberr);
+        clixon_cbuf_release(cberr);
     if (prefix)
         free(prefix);
     if (name)
@@ -1344,12 +2194,13 @@ api_path2xml(char       *api_path,
     int    nvec;
     cxobj *xroot;
     cbuf  *cberr = NULL;
+    cbuf  *cbt = NULL; /* api-path without key values */
+    struct api_path_resolve apr = {NULL,};
+    int    i;
 
     clixon_debug(CLIXON_DBG_XML | CLIXON_DBG_DETAIL, "api_path:%s", api_path);
-    if ((cberr = cbuf_new()) == NULL){
-        clixon_err(OE_UNIX, errno, "cbuf_new");
+    if ((cberr = clixon_cbuf_borrow(0)) == NULL)
         goto done;
-    }
     if (*api_path != '/'){
         cprintf(cberr, "Invalid api-path: %s (must start with '/')", api_path);
         if (xerr && netconf_invalid_value_xml(xerr, "application", cbuf_get(cberr)) < 0)
@@ -1368,10 +2219,20 @@ api_path2xml(char       *api_path,
         goto fail;
     }
     nvec--; /* NULL-terminated */
+    /* Get yang nodes of the segments from cache, see CLICON_API_PATH_CACHE_SIZE */
+    if ((cbt = clixon_cbuf_borrow(0)) == NULL)
+        goto done;
+    for (i=1; i<=nvec; i++)
+        cprintf(cbt, "/%.*s", (int)strcspn(vec[i], "="), vec[i]);
+    if (api_path_resolve_init(&apr, nvec) < 0)
+        goto done;
+    api_path_cache_get(yspec, nodeclass, cbuf_get(cbt), nvec, &apr);
     if ((retval = api_path2xml_vec(vec+1, nvec,
-                                   xtop, yspec, nodeclass, strict,
+                                   xtop, yspec, nodeclass, strict, &apr,
                                    xbotp, ybotp, xerr)) < 1)
         goto done;
+    if (api_path_cache_set(yspec, nodeclass, cbuf_get(cbt), nvec, &apr) < 0)
+        goto done;
     /* Fix namespace */
     if (xbotp){
         xml_yang_root(*xbotp, &xroot);
@@ -1380,8 +2241,11 @@ api_path2xml(char       *api_path,
     }
     retval = 1;
  done:
+    api_path_resolve_free(&apr);
+    if (cbt)
+        clixon_cbuf_release(cbt);
     if (cberr)
-        cbuf_free(cberr);
+        clixon_cbuf_release(cberr);
     if (vec)
         free(vec);
     return retval;
@@ -1413,7 +2277,6 @@ xml2api_path_1(cxobj *x,
     cxobj        *xkey;
     cxobj        *xb;
     char         *b;
-    char         *enc;
     yang_stmt    *ymod;
     cxobj        *xp;
 
@@ -1431,12 +2294,9 @@ xml2api_path_1(cxobj *x,
     switch (keyword){
     case Y_LEAF_LIST:
         b = xml_body(x);
-        enc = NULL;
-        if (uri_percent_encode(&enc, "%s", b) < 0)
+        cprintf(cb, "=");
+        if (uri_percent_cbuf_append(cb, b?b:"") < 0)
             goto done;
-        cprintf(cb, "=%s", enc?enc:"");
-        if (enc)
-            free(enc);
         break;
     case Y_LIST:
         cvk = yang_cvec_get(y); /* Use Y_LIST cache, see ys_populate_list() */
@@ -1454,12 +2314,8 @@ xml2api_path_1(cxobj *x,
             if (i++)
                 cprintf(cb, ",");
             b = xml_body(xb);
-            enc = NULL;
-            if (uri_percent_encode(&enc, "%s", b) < 0)
+            if (uri_percent_cbuf_append(cb, b?b:"") < 0)
                 goto done;
-            cprintf(cb, "%s", enc?enc:"");
-            if (enc)
-                free(enc);
         }
         break;
     default:
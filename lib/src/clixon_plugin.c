@@ -41,6 +41,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <stddef.h>
 #include <string.h>
 #include <errno.h>
 #include <signal.h>
@@ -102,6 +103,9 @@ typedef struct {
     char             *uc_namespace; /* Module namespace */
 } upgrade_callback_t;
 
+/* Number of callback pointers in clixon_plugin_api, ca_init and following fields */
+#define PLUGIN_HOOKS ((sizeof(clixon_plugin_api) - offsetof(clixon_plugin_api, ca_init)) / sizeof(void*))
+
 /* Internal struct for accessing plugin list and rpc list. This handle is accessed
  * via clixon-handle "cdata" structure (see clixon_data.h) using the key "clixon-plugin-handle"."
  * It is just a way to avoid using global variables
@@ -109,7 +113,9 @@ typedef struct {
 struct plugin_module_struct {
     clixon_plugin_t    *ms_plugin_list;
     rpc_callback_t     *ms_rpc_callbacks;
+    clicon_hash_t      *ms_rpc_hash;    /* RPC callbacks indexed by namespace and name */
     upgrade_callback_t *ms_upgrade_callbacks;
+    clixon_plugin_t   **ms_hooks[PLUGIN_HOOKS]; /* Per callback: plugins implementing it, see clixon_plugin_hook */
 };
 typedef struct plugin_module_struct plugin_module_struct;
 
@@ -150,6 +156,23 @@ plugin_module_struct_set(clixon_handle         h,
     return 0;
 }
 
+/*! Free all per-callback plugin vectors, they are rebuilt on next use
+ *
+ * @param[in]  ms   Plugin module struct
+ * @see clixon_plugin_hook
+ */
+static void
+plugin_hooks_reset(plugin_module_struct *ms)
+{
+    int i;
+
+    for (i=0; i<PLUGIN_HOOKS; i++)
+        if (ms->ms_hooks[i]){
+            free(ms->ms_hooks[i]);
+            ms->ms_hooks[i] = NULL;
+        }
+}
+
 /* Access functions */
 
 /*! Get plugin api 
@@ -217,6 +240,70 @@ clixon_plugin_each(clixon_handle    h,
     return cpnext;
 }
 
+/*! Get plugins implementing a callback, in load order
+ *
+ * The vector of each callback is built on first use, and rebuilt after a plugin is added.
+ * This avoids visiting plugins without the callback on every call.
+ * @param[in]  h       Clixon handle
+ * @param[in]  offset  Offset of callback in clixon_plugin_api, eg
+ *                     offsetof(clixon_plugin_api, ca_extension)
+ * @retval     vec     NULL-terminated vector of plugins. Do not free or modify
+ * @retval     NULL    Error
+ * @code
+ *   clixon_plugin_t **vec;
+ *   int               i;
+ *   if ((vec = clixon_plugin_hook(h, offsetof(clixon_plugin_api, ca_extension))) == NULL)
+ *     err;
+ *   for (i=0; vec[i]; i++)
+ *     ...
+ * @endcode
+ * @note A callback set in an API after the plugin is added, eg of a pseudo plugin, must be
+ *       set before the next plugin callback is made
+ * @note Plugins may not be added by a callback
+ */
+clixon_plugin_t **
+clixon_plugin_hook(clixon_handle h,
+                   size_t        offset)
+{
+    static clixon_plugin_t *empty[1] = {NULL};
+    plugin_module_struct   *ms = plugin_module_struct_get(h);
+    clixon_plugin_t        *cp;
+    clixon_plugin_t       **vec;
+    size_t                  i;
+    int                     n;
+
+    /* ms == NULL means plugins are not yet initialized */
+    if (ms == NULL || ms->ms_plugin_list == NULL)
+        return empty;
+    if (offset < offsetof(clixon_plugin_api, ca_init) ||
+        (offset - offsetof(clixon_plugin_api, ca_init)) % sizeof(void*) != 0 ||
+        (i = (offset - offsetof(clixon_plugin_api, ca_init)) / sizeof(void*)) >= PLUGIN_HOOKS){
+        clixon_err(OE_PLUGIN, EINVAL, "Invalid callback offset: %zu", offset);
+        return NULL;
+    }
+    if ((vec = ms->ms_hooks[i]) != NULL)
+        return vec;
+    n = 0;
+    cp = ms->ms_plugin_list;
+    do {
+        n++;
+        cp = NEXTQ(clixon_plugin_t *, cp);
+    } while (cp != ms->ms_plugin_list);
+    if ((vec = calloc(n+1, sizeof(*vec))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        return NULL;
+    }
+    n = 0;
+    cp = ms->ms_plugin_list;
+    do {
+        if (*(void**)((char*)&cp->cp_api + offset) != NULL)
+            vec[n++] = cp;
+        cp = NEXTQ(clixon_plugin_t *, cp);
+    } while (cp != ms->ms_plugin_list);
+    ms->ms_hooks[i] = vec;
+    return vec;
+}
+
 /*! Reverse iterator over clixon plugins, iterater from nr to 0
  *
  * @note Never manipulate the plugin during operation or using the
@@ -338,6 +425,9 @@ plugin_add_one(clixon_handle       h,
     if (api)
         cp->cp_api = *api;
     ADDQ(cp, ms->ms_plugin_list);
+    plugin_hooks_reset(ms);
+    /* Options may have been changed on the command line since they were read */
+    clixon_resource_check_mode_set(clicon_option_int(h, "CLICON_PLUGIN_CALLBACK_CHECK"));
     if (cpp)
         *cpp = cp;
     retval = 0;
@@ -608,6 +698,7 @@ clixon_plugin_exit_all(clixon_handle h)
     plugin_module_struct *ms = plugin_module_struct_get(h);
 
     if (ms != NULL){
+        plugin_hooks_reset(ms);
         while ((cp = ms->ms_plugin_list) != NULL){
             DELQ(cp, ms->ms_plugin_list, clixon_plugin_t *);
             if (clixon_plugin_exit_one(cp, h) < 0)
@@ -689,9 +780,10 @@ clixon_plugin_auth_all(clixon_handle      h,
                        clixon_auth_type_t auth_type,
                        char             **authp)
 {
-    int              retval = -1;
-    clixon_plugin_t *cp = NULL;
-    int              ret = 0;
+    int               retval = -1;
+    clixon_plugin_t **vec;
+    int               i;
+    int               ret = 0;
 
     clixon_debug(CLIXON_DBG_DEFAULT, "");
     if (authp == NULL){
@@ -700,8 +792,10 @@ clixon_plugin_auth_all(clixon_handle      h,
     }
     *authp = NULL;
     ret = 0; /* ignore */
-    while ((cp = clixon_plugin_each(h, cp)) != NULL) {
-        if ((ret = clixon_plugin_auth_one(cp, h, req, auth_type, authp)) < 0)
+    if ((vec = clixon_plugin_hook(h, offsetof(clixon_plugin_api, ca_auth))) == NULL)
+        goto done;
+    for (i=0; vec[i]; i++) {
+        if ((ret = clixon_plugin_auth_one(vec[i], h, req, auth_type, authp)) < 0)
             goto done;
         if (ret == 1)
             break; /* result, not ignored */
@@ -770,11 +864,14 @@ clixon_plugin_extension_all(clixon_handle h,
                             yang_stmt    *yext,
                             yang_stmt    *ys)
 {
-    int            retval = -1;
-    clixon_plugin_t *cp = NULL;
+    int               retval = -1;
+    clixon_plugin_t **vec;
+    int               i;
 
-    while ((cp = clixon_plugin_each(h, cp)) != NULL) {
-        if (clixon_plugin_extension_one(cp, h, yext, ys) < 0)
+    if ((vec = clixon_plugin_hook(h, offsetof(clixon_plugin_api, ca_extension))) == NULL)
+        goto done;
+    for (i=0; vec[i]; i++) {
+        if (clixon_plugin_extension_one(vec[i], h, yext, ys) < 0)
             goto done;
     }
     retval = 0;
@@ -1066,13 +1163,16 @@ clixon_plugin_errmsg_all(clixon_handle        h,
                          va_list              ap,
                          cbuf               **cbmsg)
 {
-    int              retval = -1;
-    clixon_plugin_t *cp = NULL;
+    int               retval = -1;
+    clixon_plugin_t **vec;
+    int               i;
 
     if (h != NULL){ /* Silently ignore if not properly init:d */
         *cbmsg = NULL;
-        while ((cp = clixon_plugin_each(h, cp)) != NULL) {
-            if (clixon_plugin_errmsg_one(cp, h, fn, line, type, category, suberr, xerr, format, ap, cbmsg) < 0)
+        if ((vec = clixon_plugin_hook(h, offsetof(clixon_plugin_api, ca_errmsg))) == NULL)
+            goto done;
+        for (i=0; vec[i]; i++) {
+            if (clixon_plugin_errmsg_one(vec[i], h, fn, line, type, category, suberr, xerr, format, ap, cbmsg) < 0)
                 goto done;
             if (*cbmsg != NULL)
                 break;
@@ -1163,6 +1263,22 @@ rpc_callback_dump(clixon_handle h)
 }
 #endif
 
+/*! Make RPC callback hash key of namespace and name
+ *
+ * @param[in]  cb    Buffer to write key to
+ * @param[in]  ns    Namespace of rpc
+ * @param[in]  name  RPC name
+ */
+static void
+rpc_callback_key(cbuf       *cb,
+                 const char *ns,
+                 const char *name)
+{
+    cbuf_reset(cb);
+    /* A space may not occur in a namespace URI */
+    cprintf(cb, "%s %s", ns, name);
+}
+
 /*! Register a RPC callback by appending a new RPC to a global list
  *
  * @param[in]  h         clicon handle
@@ -1182,7 +1298,10 @@ rpc_callback_register(clixon_handle  h,
                       const char    *name)
 {
     rpc_callback_t *rc = NULL;
+    rpc_callback_t *rc1;
     plugin_module_struct *ms = plugin_module_struct_get(h);
+    cbuf           *cbkey = NULL;
+    void           *p;
 
     clixon_debug(CLIXON_DBG_RPC, "%s", name);
     if (ms == NULL){
@@ -1202,9 +1321,29 @@ rpc_callback_register(clixon_handle  h,
     rc->rc_arg  = arg;
     rc->rc_namespace  = strdup(ns);
     rc->rc_name  = strdup(name);
+    /* Index by namespace and name, several callbacks of one key in registration order */
+    if (ms->ms_rpc_hash == NULL &&
+        (ms->ms_rpc_hash = clicon_hash_init()) == NULL)
+        goto done;
+    if ((cbkey = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    rpc_callback_key(cbkey, ns, name);
+    if ((p = clicon_hash_value(ms->ms_rpc_hash, cbuf_get(cbkey), NULL)) != NULL){
+        rc1 = *(rpc_callback_t **)p;
+        while (rc1->rc_next != NULL)
+            rc1 = rc1->rc_next;
+        rc1->rc_next = rc;
+    }
+    else if (clicon_hash_add(ms->ms_rpc_hash, cbuf_get(cbkey), &rc, sizeof(rc)) == NULL)
+        goto done;
+    cbuf_free(cbkey);
     ADDQ(rc, ms->ms_rpc_callbacks);
     return 0;
  done:
+    if (cbkey)
+        cbuf_free(cbkey);
     if (rc){
         if (rc->rc_namespace)
             free(rc->rc_namespace);
@@ -1232,6 +1371,10 @@ rpc_callback_delete_all(clixon_handle h)
                 free(rc->rc_name);
             free(rc);
         }
+    if (ms != NULL && ms->ms_rpc_hash){
+        clicon_hash_free(ms->ms_rpc_hash);
+        ms->ms_rpc_hash = NULL;
+    }
     return 0;
 }
 
@@ -1258,13 +1401,15 @@ rpc_callback_call(clixon_handle h,
                   cbuf         *cbret)
 {
     int                   retval = -1;
-    rpc_callback_t       *rc;
+    rpc_callback_t       *rc = NULL;
     char                 *name;
     char                 *prefix;
     char                 *ns;
     int                   nr = 0; /* How many callbacks */
     plugin_module_struct *ms = plugin_module_struct_get(h);
     void                 *wh;
+    cbuf                 *cb = NULL;
+    void                 *p;
     int                   ret;
 
     if (ms == NULL){
@@ -1274,28 +1419,31 @@ rpc_callback_call(clixon_handle h,
     name = xml_name(xe);
     prefix = xml_prefix(xe);
     xml2ns(xe, prefix, &ns);
-    if ((rc = ms->ms_rpc_callbacks) != NULL)
-        do {
-            if (strcmp(rc->rc_name, name) == 0 &&
-                ns && rc->rc_namespace &&
-                strcmp(rc->rc_namespace, ns) == 0){
-                wh = NULL;
-                if (clixon_resource_check(h, &wh, rc->rc_name, __FUNCTION__) < 0)
-                    goto done;
-                if (rc->rc_callback(h, xe, cbret, arg, rc->rc_arg) < 0){
-                    clixon_debug(CLIXON_DBG_RPC, "Error in: %s", rc->rc_name);
-                    clixon_resource_check(h, &wh, rc->rc_name, __FUNCTION__);
-                    goto done;
-                }
-                nr++;
-                if (clixon_resource_check(h, &wh, rc->rc_name, __FUNCTION__) < 0)
-                    goto done;
-                /* Ensure only one reply: first wins */
-                if (cbuf_len(cbret) > 0)
-                    break;
-            }
-            rc = NEXTQ(rpc_callback_t *, rc);
-        } while (rc != ms->ms_rpc_callbacks);
+    if (ns && ms->ms_rpc_hash){
+        if ((cb = cbuf_new()) == NULL){
+            clixon_err(OE_UNIX, errno, "cbuf_new");
+            goto done;
+        }
+        rpc_callback_key(cb, ns, name);
+        if ((p = clicon_hash_value(ms->ms_rpc_hash, cbuf_get(cb), NULL)) != NULL)
+            rc = *(rpc_callback_t **)p;
+    }
+    for (; rc != NULL; rc = rc->rc_next){
+        wh = NULL;
+        if (clixon_resource_check(h, &wh, rc->rc_name, __FUNCTION__) < 0)
+            goto done;
+        if (rc->rc_callback(h, xe, cbret, arg, rc->rc_arg) < 0){
+            clixon_debug(CLIXON_DBG_RPC, "Error in: %s", rc->rc_name);
+            clixon_resource_check(h, &wh, rc->rc_name, __FUNCTION__);
+            goto done;
+        }
+        nr++;
+        if (clixon_resource_check(h, &wh, rc->rc_name, __FUNCTION__) < 0)
+            goto done;
+        /* Ensure only one reply: first wins */
+        if (cbuf_len(cbret) > 0)
+            break;
+    }
     /* action reply checked in action_callback_call */
     if (nr &&
         clicon_option_bool(h, "CLICON_VALIDATE_STATE_XML") &&
@@ -1310,6 +1458,8 @@ rpc_callback_call(clixon_handle h,
     retval = 1; /* 0: none found, >0 nr of handlers called */
  done:
     clixon_debug(CLIXON_DBG_RPC | CLIXON_DBG_DETAIL, "retval:%d", retval);
+    if (cb)
+        cbuf_free(cb);
     return retval;
  fail:
     retval = 0;
@@ -1653,6 +1803,7 @@ clixon_plugin_module_exit(clixon_handle h)
     upgrade_callback_delete_all(h);
     /* Delete plugin_module itself */
     if ((ph = plugin_module_struct_get(h)) != NULL){
+        plugin_hooks_reset(ph);
         free(ph);
         plugin_module_struct_set(h, NULL);
     }
@@ -108,6 +108,9 @@
 #include <sys/user.h>
 #include <sys/time.h>
 #include <sys/resource.h>
+#ifdef __linux__
+#include <sys/syscall.h> /* pidfd_open */
+#endif
 
 #include <cligen/cligen.h>
 
@@ -159,6 +162,9 @@ struct process_entry_t {
     pid_t          pe_exit_status;/* Status on exit as defined in waitpid */
     struct timeval pe_starttime; /* Start time */
     proc_cb_t     *pe_callback;  /* Wrapper function, may be called from process_operation  */
+    clixon_handle  pe_h;         /* Clixon handle, for exit notification callback */
+    int            pe_pidfd;     /* Process fd for exit notification, or -1 */
+    struct timeval pe_killtime;  /* Time of last kill when exiting */
 };
 
 /*! Structure for checking resources before and after a call
@@ -175,6 +181,7 @@ struct resource_context {
 /* Forward declaration */
 static int clixon_process_sched_register(clixon_handle h, int delay);
 static int clixon_process_delete_only(process_entry_t *pe);
+static int clixon_process_reaped(clixon_handle h, process_entry_t *pe, int status);
 
 static void
 clixon_proc_sigint(int sig)
@@ -477,6 +484,12 @@ static const map_str2int proc_operation_map[] = {
 /* List of process callback entries XXX move to handle */
 static process_entry_t *_proc_entry_list = NULL;
 
+/* CLICON_PLUGIN_CALLBACK_CHECK, -1 if not set, see clixon_resource_check_mode_set */
+static int _resource_check_mode = -1;
+
+/* Expire time of registered process scheduling timeout, cleared if none */
+static struct timeval _proc_sched_time = {0,};
+
 proc_operation
 clixon_process_op_str2int(char *opstr)
 {
@@ -593,6 +606,8 @@ clixon_process_register(clixon_handle h,
         }
     }
     pe->pe_callback = callback;
+    pe->pe_h = h;
+    pe->pe_pidfd = -1;
     clixon_debug(CLIXON_DBG_PROC | CLIXON_DBG_DETAIL, "%s ----> %s",
                  pe->pe_name,
                  clicon_int2str(proc_state_map, PROC_STATE_STOPPED)
@@ -605,11 +620,109 @@ clixon_process_register(clixon_handle h,
     return retval;
 }
 
+/*! Exit notification of a process via its process fd
+ *
+ * The fd is readable when the process has terminated, reap it
+ * @param[in]  fd   Process fd
+ * @param[in]  arg  Process entry
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see clixon_process_start
+ */
+static int
+clixon_process_pidfd_cb(int   fd,
+                        void *arg)
+{
+    int              retval = -1;
+    process_entry_t *pe = (process_entry_t *)arg;
+    int              status = 0;
+    pid_t            wpid;
+
+    clixon_debug(CLIXON_DBG_PROC | CLIXON_DBG_DETAIL, "%s(%d)", pe->pe_name, pe->pe_pid);
+    if ((wpid = waitpid(pe->pe_pid, &status, WNOHANG)) == pe->pe_pid){
+        if (clixon_process_reaped(pe->pe_h, pe, status) < 0)
+            goto done;
+    }
+    else if (wpid < 0){ /* Reaped elsewhere */
+        clixon_event_unreg_fd(pe->pe_pidfd, clixon_process_pidfd_cb);
+        close(pe->pe_pidfd);
+        pe->pe_pidfd = -1;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Start a registered process in the background and register exit notification
+ *
+ * If process fds are supported (linux pidfd_open), the exit is notified via the event loop.
+ * Otherwise the process is reaped by clixon_process_waitpid on SIGCHLD.
+ * @param[in]  h   Clixon handle
+ * @param[in]  pe  Process entry
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+static int
+clixon_process_start(clixon_handle    h,
+                     process_entry_t *pe)
+{
+    int retval = -1;
+#if defined(__linux__) && defined(SYS_pidfd_open)
+    int fd;
+#endif
+
+    if (clixon_proc_background(h, pe->pe_argv, pe->pe_netns,
+                               pe->pe_uid, pe->pe_gid, pe->pe_fdkeep,
+                               &pe->pe_pid) < 0)
+        goto done;
+#if defined(__linux__) && defined(SYS_pidfd_open)
+    if (pe->pe_pid > 0 && pe->pe_pidfd == -1 &&
+        (fd = syscall(SYS_pidfd_open, pe->pe_pid, 0)) >= 0){ /* On failure fall back to SIGCHLD */
+        if (clixon_event_reg_fd(fd, clixon_process_pidfd_cb, pe, "process exit") < 0){
+            close(fd);
+            goto done;
+        }
+        pe->pe_pidfd = fd;
+    }
+#endif
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Kill a process being stopped or restarted, at most once per scheduling delay
+ *
+ * @param[in]  h   Clixon handle
+ * @param[in]  pe  Process entry
+ */
+static void
+clixon_process_kill(clixon_handle    h,
+                    process_entry_t *pe)
+{
+    struct timeval t;
+    struct timeval t1 = {0, 100000}; /* 100ms, see clixon_process_sched_register */
+
+    gettimeofday(&t, NULL);
+    if (timerisset(&pe->pe_killtime)){
+        timeradd(&pe->pe_killtime, &t1, &t1);
+        if (timercmp(&t, &t1, <))
+            return;
+    }
+    clixon_log(h, LOG_NOTICE, "Killing old process %s with pid: %d",
+               pe->pe_name, pe->pe_pid); /* XXX pid may be 0 */
+    kill(pe->pe_pid, SIGTERM);
+    pe->pe_killtime = t;
+}
+
 static int
 clixon_process_delete_only(process_entry_t *pe)
 {
     char           **pa;
 
+    if (pe->pe_pidfd != -1){
+        clixon_event_unreg_fd(pe->pe_pidfd, clixon_process_pidfd_cb);
+        close(pe->pe_pidfd);
+    }
     if (pe->pe_name)
         free(pe->pe_name);
     if (pe->pe_description)
@@ -705,6 +818,67 @@ done:
     return retval;
 }
 
+/*! Schedule an operation of one process entry
+ *
+ * @param[in]  h       Clixon handle
+ * @param[in]  pe      Process entry
+ * @param[in]  op0     start, stop, restart, status
+ * @param[in]  wrapit  If set, call potential callback, if false, dont call it
+ * @param[out] sched   Incremented if the operation should be scheduled
+ * @param[out] delay   Set if the scheduling should be delayed
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+clixon_process_operation_one(clixon_handle    h,
+                             process_entry_t *pe,
+                             proc_operation   op0,
+                             int              wrapit,
+                             int             *sched,
+                             int             *delay)
+{
+    int            retval = -1;
+    proc_operation op;
+    int            isrunning = 0;
+
+    /* Call wrapper function that eg changes op1 based on config */
+    op = op0;
+    if (wrapit && pe->pe_callback != NULL)
+        if (pe->pe_callback(h, pe, &op) < 0)
+            goto done;
+    if (op == PROC_OP_START || op == PROC_OP_STOP || op == PROC_OP_RESTART){
+        pe->pe_operation = op;
+        clixon_debug(CLIXON_DBG_PROC | CLIXON_DBG_DETAIL, "scheduling name: %s pid:%d op: %s",
+                     pe->pe_name, pe->pe_pid,
+                     clicon_int2str(proc_operation_map, pe->pe_operation));
+        if (pe->pe_state==PROC_STATE_RUNNING &&
+            (op == PROC_OP_STOP || op == PROC_OP_RESTART)){
+            isrunning = 0;
+            if (proc_op_run(pe->pe_pid, &isrunning) < 0)
+                goto done;
+            if (isrunning) {
+                timerclear(&pe->pe_killtime);
+                clixon_process_kill(h, pe);
+                *delay = 1;
+            }
+            clixon_debug(CLIXON_DBG_PROC | CLIXON_DBG_DETAIL, "%s(%d) %s --%s--> %s",
+                         pe->pe_name, pe->pe_pid,
+                         clicon_int2str(proc_state_map, pe->pe_state),
+                         clicon_int2str(proc_operation_map, pe->pe_operation),
+                         clicon_int2str(proc_state_map, PROC_STATE_EXITING)
+                         );
+            pe->pe_state = PROC_STATE_EXITING; /* Keep operation stop/restart */
+        }
+        (*sched)++;/* start: immediate stop/restart: not immediate: wait timeout */
+    }
+    else{
+        clixon_debug(CLIXON_DBG_PROC | CLIXON_DBG_DETAIL, "name:%s op %s cancelled by wrap", pe->pe_name, clicon_int2str(proc_operation_map, op0));
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Find process entry given name and schedule operation
  *
  * @param[in]  h       clicon handle
@@ -719,6 +893,7 @@ done:
  *       This is not really necessary for all operations (like start) but made for all
  *       for reducing complexity of code.
  * @see clixon_process_sched where operations are actually executed
+ * @see clixon_process_operation_batch  for operations on several processes
  */
 int
 clixon_process_operation(clixon_handle  h,
@@ -728,9 +903,7 @@ clixon_process_operation(clixon_handle  h,
 {
     int              retval = -1;
     process_entry_t *pe;
-    proc_operation   op;
     int              sched = 0; /* If set, process action should be scheduled, register a timeout */
-    int              isrunning = 0;
     int              delay = 0;
 
     clixon_debug(CLIXON_DBG_PROC, "name:%s op:%s", name, clicon_int2str(proc_operation_map, op0));
@@ -739,40 +912,8 @@ clixon_process_operation(clixon_handle  h,
     if ((pe = _proc_entry_list) != NULL)
         do {
             if (strcmp(pe->pe_name, name) == 0){
-                /* Call wrapper function that eg changes op1 based on config */
-                op = op0;
-                if (wrapit && pe->pe_callback != NULL)
-                    if (pe->pe_callback(h, pe, &op) < 0)
-                        goto done;
-                if (op == PROC_OP_START || op == PROC_OP_STOP || op == PROC_OP_RESTART){
-                    pe->pe_operation = op;
-                    clixon_debug(CLIXON_DBG_PROC | CLIXON_DBG_DETAIL, "scheduling name: %s pid:%d op: %s",
-                                 name, pe->pe_pid,
-                                 clicon_int2str(proc_operation_map, pe->pe_operation));
-                    if (pe->pe_state==PROC_STATE_RUNNING &&
-                        (op == PROC_OP_STOP || op == PROC_OP_RESTART)){
-                        isrunning = 0;
-                        if (proc_op_run(pe->pe_pid, &isrunning) < 0)
-                            goto done;
-                        if (isrunning) {
-                            clixon_log(h, LOG_NOTICE, "Killing old process %s with pid: %d",
-                                       pe->pe_name, pe->pe_pid); /* XXX pid may be 0 */
-                            kill(pe->pe_pid, SIGTERM);
-                            delay = 1;
-                        }
-                        clixon_debug(CLIXON_DBG_PROC | CLIXON_DBG_DETAIL, "%s(%d) %s --%s--> %s",
-                                     pe->pe_name, pe->pe_pid,
-                                     clicon_int2str(proc_state_map, pe->pe_state),
-                                     clicon_int2str(proc_operation_map, pe->pe_operation),
-                                     clicon_int2str(proc_state_map, PROC_STATE_EXITING)
-                                     );
-                        pe->pe_state = PROC_STATE_EXITING; /* Keep operation stop/restart */
-                    }
-                    sched++;/* start: immediate stop/restart: not immediate: wait timeout */
-                }
-                else{
-                    clixon_debug(CLIXON_DBG_PROC | CLIXON_DBG_DETAIL, "name:%s op %s cancelled by wrap", name, clicon_int2str(proc_operation_map, op0));
-                }
+                if (clixon_process_operation_one(h, pe, op0, wrapit, &sched, &delay) < 0)
+                    goto done;
                 break;          /* hit break here */
             }
             pe = NEXTQ(process_entry_t *, pe);
@@ -786,6 +927,55 @@ clixon_process_operation(clixon_handle  h,
     return retval;
 }
 
+/*! Schedule the same operation on several processes
+ *
+ * All operations are scheduled in one traversal of the process list and executed in the
+ * same scheduling rounds, instead of one at a time
+ * @param[in]  h       clicon handle
+ * @param[in]  names   Vector of process names, or NULL for all registered processes
+ * @param[in]  nnames  Length of names vector
+ * @param[in]  op0     start, stop, restart
+ * @param[in]  wrapit  If set, call potential callback, if false, dont call it
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @see clixon_process_operation  for a single process
+ */
+int
+clixon_process_operation_batch(clixon_handle  h,
+                               char         **names,
+                               int            nnames,
+                               proc_operation op0,
+                               int            wrapit)
+{
+    int              retval = -1;
+    process_entry_t *pe;
+    int              sched = 0;
+    int              delay = 0;
+    int              i;
+
+    clixon_debug(CLIXON_DBG_PROC, "n:%d op:%s", names?nnames:-1, clicon_int2str(proc_operation_map, op0));
+    if (_proc_entry_list == NULL)
+        goto ok;
+    pe = _proc_entry_list;
+    do {
+        for (i=0; names && i<nnames; i++)
+            if (strcmp(pe->pe_name, names[i]) == 0)
+                break;
+        if (names == NULL || i < nnames){
+            if (clixon_process_operation_one(h, pe, op0, wrapit, &sched, &delay) < 0)
+                goto done;
+        }
+        pe = NEXTQ(process_entry_t *, pe);
+    } while (pe != _proc_entry_list);
+    if (sched && clixon_process_sched_register(h, delay) < 0)
+        goto done;
+ ok:
+    retval = 0;
+ done:
+    clixon_debug(CLIXON_DBG_PROC, "retval:%d", retval);
+    return retval;
+}
+
 /*! Get process status according to clixon-lib.yang
  *
  * @param[in]  h       clicon handle
@@ -913,6 +1103,8 @@ clixon_process_start_all(clixon_handle h)
  * (2) edit changes or rpc restart especially of restconf where you may saw of your arm and terminate
  *     return socket.
  * A special complexity is restarting processes, where the old is killed, but state must be kept until it is reaped
+ * At most PROCESS_SCHED_START_MAX processes are started in one round, remaining are started in
+ * immediately following rounds.
  * @see clixon_process_waitpid where killed/restarted processes are "reaped"
  */
 static int
@@ -923,8 +1115,11 @@ clixon_process_sched(int           fd,
     process_entry_t *pe;
     int              isrunning; /* Process is actually running */
     int              sched = 0;
+    int              started = 0;
+    int              more = 0;  /* Start limit reached, more to start in next round */
 
     clixon_debug(CLIXON_DBG_PROC, "");
+    timerclear(&_proc_sched_time);
     if (_proc_entry_list == NULL)
         goto ok;
     pe = _proc_entry_list;
@@ -942,9 +1137,7 @@ clixon_process_sched(int           fd,
                     if (proc_op_run(pe->pe_pid, &isrunning) < 0)
                         goto done;
                     if (isrunning) {
-                        clixon_log(h, LOG_NOTICE, "Killing old process %s with pid: %d",
-                                   pe->pe_name, pe->pe_pid); /* XXX pid may be 0 */
-                        kill(pe->pe_pid, SIGTERM);
+                        clixon_process_kill(h, pe);
                         sched++; /* Not immediate: wait timeout */
                     }
                 default:
@@ -955,15 +1148,19 @@ clixon_process_sched(int           fd,
                 switch (pe->pe_operation){
                 case PROC_OP_RESTART: /* stopped -> restart can happen if its externall stopped */
                 case PROC_OP_START:
+                    if (PROCESS_SCHED_START_MAX && started >= PROCESS_SCHED_START_MAX){
+                        more++;
+                        break;
+                    }
                     /* Check if actual running using kill(0) */
                     isrunning = 0;
                     if (proc_op_run(pe->pe_pid, &isrunning) < 0)
                         goto done;
-                    if (!isrunning)
-                        if (clixon_proc_background(h, pe->pe_argv, pe->pe_netns,
-                                                   pe->pe_uid, pe->pe_gid, pe->pe_fdkeep,
-                                                   &pe->pe_pid) < 0)
+                    if (!isrunning){
+                        if (clixon_process_start(h, pe) < 0)
                             goto done;
+                        started++;
+                    }
                     clixon_debug(CLIXON_DBG_PROC | CLIXON_DBG_DETAIL,
                                  "%s(%d) %s --%s--> %s",
                                  pe->pe_name, pe->pe_pid,
@@ -988,10 +1185,13 @@ clixon_process_sched(int           fd,
                 case PROC_OP_START:
                     if (isrunning) /* Already runs */
                         break;
-                    if (clixon_proc_background(h, pe->pe_argv, pe->pe_netns,
-                                               pe->pe_uid, pe->pe_gid, pe->pe_fdkeep,
-                                               &pe->pe_pid) < 0)
+                    if (PROCESS_SCHED_START_MAX && started >= PROCESS_SCHED_START_MAX){
+                        more++;
+                        break;
+                    }
+                    if (clixon_process_start(h, pe) < 0)
                         goto done;
+                    started++;
                     clixon_debug(CLIXON_DBG_PROC | CLIXON_DBG_DETAIL,
                                  "%s(%d) %s --%s--> %s",
                                  pe->pe_name, pe->pe_pid,
@@ -1011,7 +1211,11 @@ clixon_process_sched(int           fd,
         }
         pe = NEXTQ(process_entry_t *, pe);
     } while (pe != _proc_entry_list);
-    if (sched && clixon_process_sched_register(h, 1) < 0)
+    if (more){
+        if (clixon_process_sched_register(h, 0) < 0)
+            goto done;
+    }
+    else if (sched && clixon_process_sched_register(h, 1) < 0)
         goto done;
  ok:
     retval = 0;
@@ -1025,6 +1229,8 @@ clixon_process_sched(int           fd,
  * Schedule a process event. There are two cases:
  * 1) A process has been killed and is in EXITING, after a delay kill again. 
  * 2) A process is started, dont delay
+ * Only one scheduling timeout is registered: if an earlier or equal timeout is already
+ * registered, it is kept, since every round traverses all processes.
  * @param[in]  h     Clixon handle
  * @param[in]  delay If 0 dont add a delay, if 1 add a delay
  * @retval     0     OK
@@ -1042,22 +1248,91 @@ clixon_process_sched_register(clixon_handle h,
     gettimeofday(&t, NULL);
     if (delay)
         timeradd(&t, &t1, &t);
+    if (timerisset(&_proc_sched_time)){
+        if (!timercmp(&t, &_proc_sched_time, <))
+            goto ok;
+        clixon_event_unreg_timeout(clixon_process_sched, h);
+    }
     if (clixon_event_reg_timeout(t, clixon_process_sched, h, "process") < 0)
         goto done;
+    _proc_sched_time = t;
+ ok:
     retval = 0;
  done:
     clixon_debug(CLIXON_DBG_PROC | CLIXON_DBG_DETAIL, "retval:%d", retval);
     return retval;
 }
 
+/*! A process has terminated and been reaped, change state and restart if requested
+ *
+ * @param[in]  h       Clixon handle
+ * @param[in]  pe      Process entry
+ * @param[in]  status  Exit status as given by waitpid
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+clixon_process_reaped(clixon_handle    h,
+                      process_entry_t *pe,
+                      int              status)
+{
+    int retval = -1;
+
+    clixon_debug(CLIXON_DBG_PROC | CLIXON_DBG_DETAIL, "waitpid(%d) waited", pe->pe_pid);
+    if (pe->pe_pidfd != -1){
+        clixon_event_unreg_fd(pe->pe_pidfd, clixon_process_pidfd_cb);
+        close(pe->pe_pidfd);
+        pe->pe_pidfd = -1;
+    }
+    pe->pe_exit_status = status;
+    timerclear(&pe->pe_killtime);
+    switch (pe->pe_operation){
+    case PROC_OP_NONE: /* Spontaneous / External termination */
+    case PROC_OP_STOP:
+        clixon_debug(CLIXON_DBG_PROC | CLIXON_DBG_DETAIL,
+                     "%s(%d) %s --%s--> %s",
+                     pe->pe_name, pe->pe_pid,
+                     clicon_int2str(proc_state_map, pe->pe_state),
+                     clicon_int2str(proc_operation_map, pe->pe_operation),
+                     clicon_int2str(proc_state_map, PROC_STATE_STOPPED)
+                     );
+        pe->pe_state = PROC_STATE_STOPPED;
+        pe->pe_pid = 0;
+        timerclear(&pe->pe_starttime);
+        break;
+    case PROC_OP_RESTART:
+        /* This is the case where there is an existing process running.
+         * it was killed above but still runs and needs to be reaped */
+        if (clixon_process_start(h, pe) < 0)
+            goto done;
+        gettimeofday(&pe->pe_starttime, NULL);
+        clixon_debug(CLIXON_DBG_PROC | CLIXON_DBG_DETAIL, "%s(%d) %s --%s--> %s",
+                     pe->pe_name, pe->pe_pid,
+                     clicon_int2str(proc_state_map, pe->pe_state),
+                     clicon_int2str(proc_operation_map, pe->pe_operation),
+                     clicon_int2str(proc_state_map, PROC_STATE_RUNNING)
+                     );
+        pe->pe_state = PROC_STATE_RUNNING;
+        break;
+    default:
+        break;
+    }
+    pe->pe_operation = PROC_OP_NONE;
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Go through processes and wait for child processes
  *
  * Typically we know a child has been killed by SIGCHLD, but we do not know which process it is
  * Traverse all known processes and reap them, eg call waitpid() to avoid zombies.
+ * All terminated processes are reaped, since several SIGCHLD may be merged into one.
+ * Processes with exit notification via a process fd are skipped, they are reaped by
+ * clixon_process_pidfd_cb
  * @param[in]  h  Clixon handle
  * @retval     0  OK
  * @retval    -1  Error
-
  */
 int
 clixon_process_waitpid(clixon_handle h)
@@ -1076,51 +1351,15 @@ clixon_process_waitpid(clixon_handle h)
                          pe->pe_name, pe->pe_pid,
                          clicon_int2str(proc_state_map, pe->pe_state),
                          clicon_int2str(proc_operation_map, pe->pe_operation));
-            if (pe->pe_pid != 0
+            if (pe->pe_pid != 0 && pe->pe_pidfd == -1
                 && (pe->pe_state == PROC_STATE_RUNNING || pe->pe_state == PROC_STATE_EXITING)
                 //      && (pe->pe_operation == PROC_OP_STOP || pe->pe_operation == PROC_OP_RESTART)
                 ){
                 clixon_debug(CLIXON_DBG_PROC | CLIXON_DBG_DETAIL, "%s waitpid(%d)",
                              pe->pe_name, pe->pe_pid);
                 if ((wpid = waitpid(pe->pe_pid, &status, WNOHANG)) == pe->pe_pid){
-                    clixon_debug(CLIXON_DBG_PROC | CLIXON_DBG_DETAIL, "waitpid(%d) waited", pe->pe_pid);
-                    pe->pe_exit_status = status;
-                    switch (pe->pe_operation){
-                    case PROC_OP_NONE: /* Spontaneous / External termination */
-                    case PROC_OP_STOP:
-                        clixon_debug(CLIXON_DBG_PROC | CLIXON_DBG_DETAIL,
-                                     "%s(%d) %s --%s--> %s",
-                                     pe->pe_name, pe->pe_pid,
-                                     clicon_int2str(proc_state_map, pe->pe_state),
-                                     clicon_int2str(proc_operation_map, pe->pe_operation),
-                                     clicon_int2str(proc_state_map, PROC_STATE_STOPPED)
-                                     );
-                        pe->pe_state = PROC_STATE_STOPPED;
-                        pe->pe_pid = 0;
-                        timerclear(&pe->pe_starttime);
-                        break;
-                    case PROC_OP_RESTART:
-                        /* This is the case where there is an existing process running.
-                         * it was killed above but still runs and needs to be reaped */
-                        if (clixon_proc_background(h, pe->pe_argv, pe->pe_netns,
-                                                   pe->pe_uid, pe->pe_gid, pe->pe_fdkeep,
-                                                   &pe->pe_pid) < 0)
-                            goto done;
-                        gettimeofday(&pe->pe_starttime, NULL);
-                        clixon_debug(CLIXON_DBG_PROC | CLIXON_DBG_DETAIL, "%s(%d) %s --%s--> %s",
-                                     pe->pe_name, pe->pe_pid,
-                                     clicon_int2str(proc_state_map, pe->pe_state),
-                                     clicon_int2str(proc_operation_map, pe->pe_operation),
-                                     clicon_int2str(proc_state_map, PROC_STATE_RUNNING)
-                                     );
-                        pe->pe_state = PROC_STATE_RUNNING;
-                        gettimeofday(&pe->pe_starttime, NULL);
-                        break;
-                    default:
-                        break;
-                    }
-                    pe->pe_operation = PROC_OP_NONE;
-                    break; /* pid is unique */
+                    if (clixon_process_reaped(h, pe, status) < 0)
+                        goto done;
                 }
                 else
                     clixon_debug(CLIXON_DBG_PROC | CLIXON_DBG_DETAIL, "waitpid(%d) nomatch:%d",
@@ -1181,6 +1420,19 @@ resource_context_get(void)
     return NULL;
 }
 
+/*! Set resource check mode so that it is not looked up in every check
+ *
+ * @param[in]  mode  Value of CLICON_PLUGIN_CALLBACK_CHECK, or -1 to look up the option
+ * @retval     0     OK
+ * @see clixon_resource_check
+ */
+int
+clixon_resource_check_mode_set(int mode)
+{
+    _resource_check_mode = mode;
+    return 0;
+}
+
 /*! Check terminal+signal context, check if anything has changed
  *
  * Called twice:
@@ -1221,7 +1473,8 @@ clixon_resource_check(clixon_handle h,
         errno = EINVAL;
         return -1;
     }
-    option = clicon_option_int(h, "CLICON_PLUGIN_CALLBACK_CHECK");
+    if ((option = _resource_check_mode) < 0)
+        option = clicon_option_int(h, "CLICON_PLUGIN_CALLBACK_CHECK");
     /* Check if plugion checks are enabled */
     if (option == 0)
         return 1;
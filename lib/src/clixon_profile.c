@@ -0,0 +1,518 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2024 Olof Hagsand
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Sampling CPU profiler of daemons, started on demand by the clixon-lib profile RPC.
+ * A profiling timer (ITIMER_PROF) sends SIGPROF at a given frequency of consumed CPU
+ * time, and the signal handler records the stack of the interrupted code in a
+ * preallocated buffer. No memory is allocated and nothing is written in the handler.
+ * When the duration has passed, the stacks are symbolized and written in the collapsed
+ * (folded) format of flamegraph tools, one line per unique stack:
+ *   main;clixon_event_loop;from_client;...;xml_cmp 17
+ * Functions not in the dynamic symbol table, eg static functions, are written as
+ * <module>+0x<offset> and can be translated with addr2line.
+ * The profiler only records the thread that received the signal, which is normally the
+ * main thread since other threads are blocked or short-lived.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE /* dladdr */
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <syslog.h>
+#include <dlfcn.h>
+#include <sys/types.h>
+#include <sys/time.h>
+#ifdef HAVE_EXECINFO_H
+#include <execinfo.h>
+#endif
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_err.h"
+#include "clixon_log.h"
+#include "clixon_debug.h"
+#include "clixon_sig.h"
+#include "clixon_event.h"
+#include "clixon_options.h"
+#include "clixon_netconf_lib.h"
+#include "clixon_profile.h"
+
+/*
+ * Constants
+ */
+#define PROFILE_DEPTH       32    /* Max stack frames of a sample */
+#define PROFILE_SKIP        2     /* Frames of signal handler and trampoline */
+#define PROFILE_SAMPLES_MAX 32768 /* Max samples of one profile */
+
+/*
+ * Types
+ */
+/* One recorded stack, leaf frame first */
+struct profile_sample {
+    int   ps_n;                   /* Number of frames */
+    void *ps_pc[PROFILE_DEPTH];   /* Return addresses */
+};
+
+/* One unique stack after symbolization */
+struct profile_stack {
+    char    *pk_str;              /* Folded stack: frames from root separated with ';' */
+    uint32_t pk_count;            /* Number of samples */
+};
+
+static struct profile_sample *_prof_samples = NULL; /* Sample buffer, NULL if not running */
+static uint32_t               _prof_max = 0;        /* Size of sample buffer */
+static uint32_t               _prof_next = 0;       /* Next sample, may exceed _prof_max */
+static struct timeval         _prof_deadline;       /* When to stop */
+static char                  *_prof_file = NULL;    /* Output file */
+static pid_t                  _prof_pid = 0;        /* Profiled process, not forked children */
+static void                 (*_prof_oldhandler)(int) = NULL;
+
+#ifdef HAVE_EXECINFO_H
+/*! SIGPROF handler: record the stack of the interrupted code
+ *
+ * Only reserves a slot and calls backtrace(), which has been called before the timer
+ * was started so that its library is already loaded.
+ * Interrupted system calls are restarted (SA_RESTART), except select in the event loop.
+ */
+static void
+profile_sigprof(int arg)
+{
+    int                    save = errno;
+    uint32_t               i;
+    struct profile_sample *ps;
+
+    i = __atomic_fetch_add(&_prof_next, 1, __ATOMIC_RELAXED);
+    if (_prof_samples != NULL && i < _prof_max){
+        ps = &_prof_samples[i];
+        ps->ps_n = backtrace(ps->ps_pc, PROFILE_DEPTH);
+    }
+    /* Interrupted select in event loop is not an error */
+    clicon_sig_ignore_set(1);
+    errno = save;
+}
+#endif
+
+/*! Timeout callback: stop profiling and write the profile
+ */
+static int
+profile_timeout(int   s,
+                void *arg)
+{
+    return clixon_profile_stop();
+}
+
+/*! Compare samples by stacks, for sorting equal stacks together
+ */
+static int
+profile_sample_cmp(const void *a,
+                   const void *b)
+{
+    const struct profile_sample *pa = a;
+    const struct profile_sample *pb = b;
+
+    if (pa->ps_n != pb->ps_n)
+        return pa->ps_n < pb->ps_n ? -1 : 1;
+    return memcmp(pa->ps_pc, pb->ps_pc, pa->ps_n*sizeof(void*));
+}
+
+/*! Compare folded stacks by strings
+ */
+static int
+profile_stack_cmp(const void *a,
+                  const void *b)
+{
+    return strcmp(((const struct profile_stack *)a)->pk_str,
+                  ((const struct profile_stack *)b)->pk_str);
+}
+
+/*! Append the symbol of an address to a folded stack
+ *
+ * @param[in]  cb  Folded stack
+ * @param[in]  pc  Return address
+ */
+static void
+profile_symbol(cbuf *cb,
+               void *pc)
+{
+    Dl_info info;
+    char   *f;
+
+    memset(&info, 0, sizeof(info));
+    if (dladdr(pc, &info) == 0)
+        cprintf(cb, "0x%" PRIxPTR, (uintptr_t)pc);
+    else if (info.dli_sname != NULL)
+        cprintf(cb, "%s", info.dli_sname);
+    else if (info.dli_fname != NULL){
+        f = strrchr(info.dli_fname, '/');
+        cprintf(cb, "%s+0x%" PRIxPTR, f ? f+1 : info.dli_fname,
+                (uintptr_t)pc - (uintptr_t)info.dli_fbase);
+    }
+    else
+        cprintf(cb, "0x%" PRIxPTR, (uintptr_t)pc);
+}
+
+/*! Symbolize recorded samples and write them as folded stacks
+ *
+ * Equal address stacks are first counted, so that each is only symbolized once. Different
+ * address stacks may give the same folded stack and are merged.
+ * @param[in]  f    Open output file
+ * @param[in]  nr   Number of recorded samples
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+profile_write(FILE    *f,
+              uint32_t nr)
+{
+    int                    retval = -1;
+    struct profile_stack  *pk = NULL;
+    struct profile_sample *ps;
+    uint32_t               npk = 0;
+    uint32_t               i;
+    uint32_t               j;
+    int                    k;
+    cbuf                  *cb = NULL;
+
+    qsort(_prof_samples, nr, sizeof(*_prof_samples), profile_sample_cmp);
+    if ((pk = calloc(nr+1, sizeof(*pk))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    for (i=0; i<nr; i=j){
+        ps = &_prof_samples[i];
+        for (j=i+1; j<nr && profile_sample_cmp(ps, &_prof_samples[j]) == 0; j++);
+        if (ps->ps_n <= PROFILE_SKIP)
+            continue;
+        cbuf_reset(cb);
+        /* Root first */
+        for (k=ps->ps_n-1; k>=PROFILE_SKIP; k--){
+            if (k < ps->ps_n-1)
+                cprintf(cb, ";");
+            profile_symbol(cb, ps->ps_pc[k]);
+        }
+        if ((pk[npk].pk_str = strdup(cbuf_get(cb))) == NULL){
+            clixon_err(OE_UNIX, errno, "strdup");
+            goto done;
+        }
+        pk[npk++].pk_count = j-i;
+    }
+    qsort(pk, npk, sizeof(*pk), profile_stack_cmp);
+    for (i=0; i<npk; i=j){
+        nr = pk[i].pk_count;
+        for (j=i+1; j<npk && strcmp(pk[i].pk_str, pk[j].pk_str) == 0; j++)
+            nr += pk[j].pk_count;
+        fprintf(f, "%s %" PRIu32 "\n", pk[i].pk_str, nr);
+    }
+    retval = 0;
+ done:
+    if (pk){
+        for (i=0; i<npk; i++)
+            free(pk[i].pk_str);
+        free(pk);
+    }
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Start sampling CPU profiler
+ *
+ * Profiling is stopped after the duration by a timeout in the event loop, or by
+ * clixon_profile_poll in daemons without event loop.
+ * The output file is created in CLICON_PROFILE_DIR, it is not overwritten if it exists.
+ * @param[in]  h       Clixon handle
+ * @param[in]  name    Name of daemon, prefix of the output file, eg clixon_backend
+ * @param[in]  seconds Duration of profiling
+ * @param[in]  hz      Sampling frequency in samples per second of CPU time
+ * @param[out] file    Name of output file
+ * @retval     0       OK
+ * @retval    -1       Error, eg already running
+ * @see clixon_profile_stop
+ */
+int
+clixon_profile_start(clixon_handle h,
+                     const char   *name,
+                     uint32_t      seconds,
+                     uint32_t      hz,
+                     cbuf         *file)
+{
+    int              retval = -1;
+#ifdef HAVE_EXECINFO_H
+    char            *dir;
+    void            *pc[PROFILE_DEPTH];
+    struct itimerval it = {{0,},};
+    struct timeval   t;
+    uint64_t         max;
+    int              fd;
+
+    if (_prof_samples != NULL){
+        clixon_err(OE_UNIX, EBUSY, "Profiler already running, output: %s", _prof_file);
+        goto done;
+    }
+    if (seconds == 0 || hz == 0 || hz > 1000000){
+        clixon_err(OE_UNIX, EINVAL, "Invalid profile duration or frequency");
+        goto done;
+    }
+    if ((dir = clicon_option_str(h, "CLICON_PROFILE_DIR")) == NULL)
+        dir = "/tmp";
+    gettimeofday(&t, NULL);
+    cprintf(file, "%s/%s.%d.%lu.folded", dir, name, (int)getpid(), (unsigned long)t.tv_sec);
+    /* Create now to report errors in the reply */
+    if ((fd = open(cbuf_get(file), O_WRONLY|O_CREAT|O_EXCL|O_NOFOLLOW, S_IRUSR|S_IWUSR)) < 0){
+        clixon_err(OE_UNIX, errno, "open(%s)", cbuf_get(file));
+        goto done;
+    }
+    close(fd);
+    if ((_prof_file = strdup(cbuf_get(file))) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    max = (uint64_t)seconds*hz;
+    _prof_max = max < PROFILE_SAMPLES_MAX ? max : PROFILE_SAMPLES_MAX;
+    _prof_next = 0;
+    _prof_pid = getpid();
+    if ((_prof_samples = calloc(_prof_max, sizeof(*_prof_samples))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    /* Load unwinder before it is called in the handler */
+    (void)backtrace(pc, PROFILE_DEPTH);
+    if (set_signal(SIGPROF, profile_sigprof, &_prof_oldhandler) < 0)
+        goto done;
+    it.it_interval.tv_sec = 0;
+    it.it_interval.tv_usec = hz > 1000000 ? 1 : 1000000/hz;
+    it.it_value = it.it_interval;
+    if (setitimer(ITIMER_PROF, &it, NULL) < 0){
+        clixon_err(OE_UNIX, errno, "setitimer");
+        goto done;
+    }
+    _prof_deadline = t;
+    _prof_deadline.tv_sec += seconds;
+    if (clixon_event_reg_timeout(_prof_deadline, profile_timeout, NULL, "profile") < 0)
+        goto done;
+    clixon_debug(CLIXON_DBG_DEFAULT, "profiling %us at %uHz to %s", seconds, hz, _prof_file);
+    retval = 0;
+ done:
+    if (retval < 0 && _prof_file != NULL){
+        /* Not running */
+        memset(&it, 0, sizeof(it));
+        setitimer(ITIMER_PROF, &it, NULL);
+        if (_prof_samples){
+            set_signal(SIGPROF, _prof_oldhandler, NULL);
+            free(_prof_samples);
+            _prof_samples = NULL;
+        }
+        unlink(_prof_file);
+        free(_prof_file);
+        _prof_file = NULL;
+    }
+    return retval;
+#else
+    clixon_err(OE_UNIX, ENOTSUP, "Profiling not supported on this platform (no execinfo.h)");
+    return retval;
+#endif /* HAVE_EXECINFO_H */
+}
+
+/*! Stop sampling CPU profiler and write the profile
+ *
+ * @retval     0       OK, or not running
+ * @retval    -1       Error
+ */
+int
+clixon_profile_stop(void)
+{
+    int              retval = -1;
+    struct itimerval it = {{0,},};
+    FILE            *f = NULL;
+    uint32_t         nr;
+    uint32_t         lost;
+
+    if (_prof_samples == NULL)
+        return 0;
+    if (getpid() != _prof_pid) /* Forked child: timers are not inherited */
+        goto ok;
+    setitimer(ITIMER_PROF, &it, NULL);
+    set_signal(SIGPROF, _prof_oldhandler, NULL);
+    clixon_event_unreg_timeout(profile_timeout, NULL);
+    nr = __atomic_load_n(&_prof_next, __ATOMIC_RELAXED);
+    lost = nr > _prof_max ? nr - _prof_max : 0;
+    nr -= lost;
+    if ((f = fopen(_prof_file, "w")) == NULL){
+        clixon_err(OE_UNIX, errno, "fopen(%s)", _prof_file);
+        goto done;
+    }
+    if (profile_write(f, nr) < 0)
+        goto done;
+    clixon_log(NULL, LOG_NOTICE, "Profile written to %s: %" PRIu32 " samples, %" PRIu32 " lost",
+               _prof_file, nr, lost);
+ ok:
+    retval = 0;
+ done:
+    if (f)
+        fclose(f);
+    free(_prof_samples);
+    _prof_samples = NULL;
+    free(_prof_file);
+    _prof_file = NULL;
+    return retval;
+}
+
+/*! Check if the profiler is running
+ *
+ * @retval     1       Running
+ * @retval     0       Not running
+ */
+int
+clixon_profile_running(void)
+{
+    return _prof_samples != NULL;
+}
+
+/*! Stop the profiler if its duration has passed, for daemons without event loop
+ *
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+int
+clixon_profile_poll(void)
+{
+    struct timeval t;
+
+    if (_prof_samples == NULL)
+        return 0;
+    gettimeofday(&t, NULL);
+    if (timercmp(&t, &_prof_deadline, <))
+        return 0;
+    return clixon_profile_stop();
+}
+
+/*! Start profiling of this daemon, clixon-lib profile RPC
+ *
+ * The RPC returns when profiling has started, with the output file in the reply.
+ * @param[in]  h       Clixon handle
+ * @param[in]  xe      Request: <rpc><xn></rpc>
+ * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error..
+ * @param[in]  arg     Domain specific arg, eg client-entry
+ * @param[in]  regarg  Daemon name: backend or restconf, matched with the daemon leaf
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+int
+clixon_profile_rpc(clixon_handle h,
+                   cxobj        *xe,
+                   cbuf         *cbret,
+                   void         *arg,
+                   void         *regarg)
+{
+    int       retval = -1;
+    char     *daemon = (char*)regarg;
+    char     *str;
+    uint32_t  seconds = 10;
+    uint32_t  hz = 99;
+    cbuf     *file = NULL;
+    cbuf     *cbname = NULL;
+
+    if ((str = xml_find_body(xe, "daemon")) == NULL)
+        str = "backend";
+    if (strcmp(str, daemon) != 0){
+        if (netconf_operation_not_supported(cbret, "application", "Daemon can not be profiled from here") < 0)
+            goto done;
+        goto ok;
+    }
+    if ((str = xml_find_body(xe, "duration")) != NULL &&
+        parse_uint32(str, &seconds, NULL) <= 0){
+        if (netconf_bad_element(cbret, "application", "duration", "Invalid duration") < 0)
+            goto done;
+        goto ok;
+    }
+    if ((str = xml_find_body(xe, "frequency")) != NULL &&
+        parse_uint32(str, &hz, NULL) <= 0){
+        if (netconf_bad_element(cbret, "application", "frequency", "Invalid frequency") < 0)
+            goto done;
+        goto ok;
+    }
+    if ((file = cbuf_new()) == NULL ||
+        (cbname = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cbname, "clixon_%s", daemon);
+    if (clixon_profile_start(h, cbuf_get(cbname), seconds, hz, file) < 0){
+        if (netconf_operation_failed(cbret, "application", clixon_err_reason()) < 0)
+            goto done;
+        clixon_err_reset();
+        goto ok;
+    }
+    cprintf(cbret, "<rpc-reply xmlns=\"%s\">", NETCONF_BASE_NAMESPACE);
+    cprintf(cbret, "<file xmlns=\"%s\">%s</file>", CLIXON_LIB_NS, cbuf_get(file));
+    cprintf(cbret, "</rpc-reply>");
+ ok:
+    retval = 0;
+ done:
+    if (file)
+        cbuf_free(file);
+    if (cbname)
+        cbuf_free(cbname);
+    return retval;
+}
+
+/*! Stop profiling on exit, the profile of the elapsed time is written
+ */
+void
+clixon_profile_exit(void)
+{
+    (void)clixon_profile_stop();
+}
@@ -57,6 +57,7 @@
 #include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/param.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
 #include <sys/un.h>
 #include <arpa/inet.h>
@@ -81,6 +82,7 @@
 #include "clixon_netconf_input.h"
 #include "clixon_options.h"
 #include "clixon_proto.h"
+#include "clixon_trace.h"
 
 static int _atomicio_sig = 0;
 
@@ -131,6 +133,54 @@ clixon_inet2sin(const char       *addrtype,
     return 0;
 }
 
+/*! Add trace context of active span as cl:traceparent attribute to an internal rpc
+ *
+ * The attribute is inserted in the rpc start tag, with a namespace declaration unless
+ * the tag already has one.
+ * @param[in,out] msgp  Clicon message, may be reallocated
+ * @retval        0     OK, or not an rpc
+ * @retval       -1     Error
+ * @see clixon_trace_parent_set  Backend reads the attribute
+ */
+static int
+clicon_msg_traceparent(struct clicon_msg **msgp)
+{
+    struct clicon_msg *msg = *msgp;
+    char               tp[CLIXON_TRACEPARENT_LEN+1];
+    char               attr[CLIXON_TRACEPARENT_LEN+128];
+    char              *body;
+    char              *end;
+    size_t             alen;
+    uint32_t           len;
+
+    body = msg->op_body;
+    if (strncmp(body, "<rpc", 4) != 0 || (body[4] != ' ' && body[4] != '>'))
+        return 0;
+    if (clixon_trace_traceparent(tp, sizeof(tp)) == 0)
+        return 0;
+    if ((end = strchr(body, '>')) == NULL)
+        return 0;
+    *end = '\0'; /* Limit search to start tag */
+    if (strstr(body, " xmlns:" CLIXON_LIB_PREFIX "=") == NULL)
+        snprintf(attr, sizeof(attr), " %s:traceparent=\"%s\" xmlns:%s=\"%s\"",
+                 CLIXON_LIB_PREFIX, tp, CLIXON_LIB_PREFIX, CLIXON_LIB_NS);
+    else
+        snprintf(attr, sizeof(attr), " %s:traceparent=\"%s\"", CLIXON_LIB_PREFIX, tp);
+    *end = '>';
+    alen = strlen(attr);
+    len = ntohl(msg->op_len) + alen;
+    if ((msg = realloc(msg, len)) == NULL){
+        clixon_err(OE_PROTO, errno, "realloc");
+        return -1;
+    }
+    *msgp = msg;
+    msg->op_len = htonl(len);
+    body = msg->op_body;
+    memmove(&body[4+alen], &body[4], strlen(&body[4])+1);
+    memcpy(&body[4], attr, alen);
+    return 0;
+}
+
 /*! Encode a clicon netconf message using variable argument lists
  *
  * @param[in] id      Session id of client
@@ -168,7 +218,10 @@ clicon_msg_encode(uint32_t    id,
     va_start(args, format);
     vsnprintf(msg->op_body, xmllen, format, args);
     va_end(args);
-
+    if (clixon_trace_enabled() && clicon_msg_traceparent(&msg) < 0){
+        free(msg);
+        return NULL;
+    }
     return msg;
 }
 
@@ -392,32 +445,28 @@ clixon_msg_rcv10(int         s,
                  cbuf       *cb,
                  int        *eof)
 {
-    int           retval = -1;
-    unsigned char buf[BUFSIZ];
-    int           i;
-    int           len;
-    int           xml_state = 0;
-    int           poll;
+    int            retval = -1;
+    unsigned char  buf[NETCONF_INPUT_BUFLEN];
+    unsigned char *p;
+    size_t         plen;
+    ssize_t        len;
+    int            xml_state = 0;
+    size_t         xml_size = 0;
+    int            eom = 0;
+    int            poll;
 
     clixon_debug(CLIXON_DBG_MSG | CLIXON_DBG_DETAIL, "");
     *eof = 0;
-    memset(buf, 0, sizeof(buf));
     while (1){
         if ((len = netconf_input_read2(s, buf, sizeof(buf), eof)) < 0)
             goto done;
-        for (i=0; i<len; i++){
-            if (buf[i] == 0)
-                continue; /* Skip NULL chars (eg from terminals) */
-            cprintf(cb, "%c", buf[i]);
-            if (detect_endtag("]]>]]>",
-                              buf[i],
-                              &xml_state)) {
-                /* OK, we have an xml string from a client */
-                /* Remove trailer */
-                *(((char*)cbuf_get(cb)) + cbuf_len(cb) - strlen("]]>]]>")) = '\0';
-                goto ok;
-            }
-        }
+        p = buf;
+        plen = len;
+        if (netconf_input_msg2(&p, &plen, cb, NETCONF_SSH_EOM,
+                               &xml_state, &xml_size, &eom) < 0)
+            goto done;
+        if (eom)
+            goto ok;
         /* poll==1 if more, poll==0 if none */
         if ((poll = clixon_event_poll(s)) < 0)
             goto done;
@@ -503,27 +552,102 @@ clixon_rpc10(int         sock,
 
 /*================= NETCONF 1.1 Chunked framing ================*/
 
+/*! Send a chunk of a message from a buffer using NETCONF 1.1 w chunked framing
+ *
+ * Chunk header, data and end-of-chunks are written with writev(2), ie the data is
+ * not copied. A message may be sent as several chunks, where the last chunk has eom set.
+ * Writes block until the peer has read enough, which gives backpressure for large
+ * messages.
+ * As atomicio, a closed socket is not an error.
+ * @param[in]   s      socket (unix or inet) to communicate with backend
+ * @param[in]   descr  Description of peer for logging
+ * @param[in]   data   Chunk data
+ * @param[in]   len    Length of chunk data, if 0 no chunk is sent
+ * @param[in]   eom    Last chunk: send end-of-chunks after data
+ * @retval      0      OK
+ * @retval     -1      Error
+ */
+int
+clixon_msg_send11_chunk(int         s,
+                        const char *descr,
+                        const char *data,
+                        size_t      len,
+                        int         eom)
+{
+    int          retval = -1;
+    char         hdr[32];
+    char         trl[] = "\n##\n";
+    struct iovec iov[3];
+    struct iovec *v = iov;
+    int          iovcnt = 0;
+    ssize_t      n;
+
+    clixon_debug(CLIXON_DBG_MSG, "Send [%s] len: %zu%s", descr?descr:"", len, eom?"":" (chunk)");
+    clixon_debug(CLIXON_DBG_MSG | CLIXON_DBG_DETAIL, "Send [%s] %.*s", descr?descr:"", (int)len, data);
+    if (len > 0){
+        snprintf(hdr, sizeof(hdr), "\n#%zu\n", len);
+        iov[iovcnt].iov_base = hdr;
+        iov[iovcnt++].iov_len = strlen(hdr);
+        iov[iovcnt].iov_base = (void*)data;
+        iov[iovcnt++].iov_len = len;
+    }
+    if (eom){
+        iov[iovcnt].iov_base = trl;
+        iov[iovcnt++].iov_len = strlen(trl);
+    }
+    while (iovcnt > 0){
+        _atomicio_sig = 0;
+        if ((n = writev(s, v, iovcnt)) < 0){
+            if ((errno == EINTR && _atomicio_sig == 0) || errno == EAGAIN)
+                continue;
+            if (errno == ECONNRESET || errno == EPIPE || errno == EBADF)
+                break; /* Client shutdown */
+            clixon_err(OE_CFG, errno, "writev");
+            clixon_log(NULL, LOG_WARNING, "%s: writev: %s", __FUNCTION__, strerror(errno));
+            goto done;
+        }
+        /* Skip written data */
+        while (iovcnt > 0 && n >= (ssize_t)v->iov_len){
+            n -= v->iov_len;
+            v++;
+            iovcnt--;
+        }
+        if (iovcnt > 0){
+            v->iov_base = (char*)v->iov_base + n;
+            v->iov_len -= n;
+        }
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Send a message from a buffer as one chunk using NETCONF 1.1 w chunked framing
+ */
+static int
+clixon_msg_send11_buf(int         s,
+                      const char *descr,
+                      const char *data,
+                      size_t      len)
+{
+    return clixon_msg_send11_chunk(s, descr, data, len, 1);
+}
+
 /*! Send a message using NETCONF 1.1 w chunked framing
  *
  * @param[in]   s      socket (unix or inet) to communicate with backend
  * @param[in]   descr  Description of peer for logging
- * @param[out]  msg    CLICON msg data reply structure. Free with free()
+ * @param[in]   cb     Message, not modified
+ * @retval      0      OK
+ * @retval     -1      Error
  * @see clixon_msg_send10  1.0 EOM
  */
-static int
+int
 clixon_msg_send11(int         s,
                   const char *descr,
                   cbuf       *cb)
 {
-    int retval = -1;
-
-    if (netconf_output_encap(NETCONF_SSH_CHUNKED, cb) < 0)
-        goto done;
-    if (clixon_msg_send(s, descr, cb) < 0)
-        goto done;
-    retval = 0;
-  done:
-    return retval;
+    return clixon_msg_send11_buf(s, descr, cbuf_get(cb), strlen(cbuf_get(cb)));
 }
 
 static void
@@ -552,7 +676,7 @@ clixon_msg_rcv11(int         s,
                  int        *eof)
 {
     int              retval = -1;
-    unsigned char    buf[BUFSIZ];
+    unsigned char    buf[NETCONF_INPUT_BUFLEN];
     ssize_t          buflen = sizeof(buf);
     int              frame_state = 0;
     size_t           frame_size = 0;
@@ -641,6 +765,209 @@ clixon_msg_rcv11(int         s,
     return retval;
 }
 
+/*! Receive a message using NETCONF 1.1 chunked framing and hand it over in pieces
+ *
+ * The message is not collected: the chunk-data of each read from the socket is passed to
+ * the callback as it arrives, so that a large reply can be forwarded with flat memory.
+ * @param[in]   s      socket (unix or inet) to communicate with backend
+ * @param[in]   descr  Description of peer for logging
+ * @param[in]   fn     Callback called with data of each read, eom is set on last call
+ * @param[in]   arg    Argument to callback
+ * @param[out]  eof    Set if eof or framing error encountered
+ * @retval      0      OK (check eof)
+ * @retval     -1      Error
+ * @see clixon_msg_rcv11  Receive the whole message
+ */
+int
+clixon_msg_rcv11_stream(int                  s,
+                        const char          *descr,
+                        clixon_msg_stream_cb *fn,
+                        void                *arg,
+                        int                 *eof)
+{
+    int            retval = -1;
+    unsigned char  buf[NETCONF_INPUT_BUFLEN];
+    int            frame_state = 0;
+    size_t         frame_size = 0;
+    unsigned char *p;
+    size_t         plen;
+    cbuf          *cbmsg = NULL;
+    ssize_t        len;
+    size_t         total = 0;
+    int            eom = 0;
+
+    *eof = 0;
+    if ((cbmsg = cbuf_new_alloc(NETCONF_INPUT_BUFLEN)) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new_alloc");
+        goto done;
+    }
+    while (*eof == 0 && eom == 0) {
+        if ((len = netconf_input_read2(s, buf, sizeof(buf), eof)) < 0)
+            goto done;
+        if (*eof)
+            break;
+        p = buf;
+        plen = len;
+        if (netconf_input_msg2(&p, &plen, cbmsg, NETCONF_SSH_CHUNKED,
+                               &frame_state, &frame_size, &eom) < 0){
+            /* Errors from input are only framing errors, non-fatal, return eof */
+            *eof = 1;
+            break;
+        }
+        if (cbuf_len(cbmsg) > 0 || eom){
+            total += cbuf_len(cbmsg);
+            if (fn(cbuf_get(cbmsg), cbuf_len(cbmsg), eom, arg) < 0)
+                goto done;
+            cbuf_reset(cbmsg);
+        }
+    }
+    if (*eof)
+        clixon_debug(CLIXON_DBG_MSG, "Recv [%s]: EOF", descr?descr:"");
+    else
+        clixon_debug(CLIXON_DBG_MSG, "Recv [%s] len: %zu (stream)", descr?descr:"", total);
+    retval = 0;
+ done:
+    if (cbmsg)
+        cbuf_free(cbmsg);
+    return retval;
+}
+
+/* Size of input buffer of pipelined receive, larger reads for large messages */
+#define CLIXON_MSG_RCV_BUFLEN NETCONF_INPUT_BUFLEN
+
+/*! Receive state of a socket where NETCONF 1.1 messages may be pipelined
+ *
+ * Input is read in blocks which may contain several messages, or only part of one.
+ * Input following a complete message is kept for the next message.
+ */
+struct clixon_msg_rcv {
+    unsigned char mr_buf[CLIXON_MSG_RCV_BUFLEN]; /* Input read from socket */
+    size_t        mr_off;         /* Start of unconsumed input in mr_buf */
+    size_t        mr_len;         /* End of input in mr_buf */
+    cbuf         *mr_msg;         /* Message being assembled */
+    int           mr_state;       /* Chunked framing state */
+    size_t        mr_size;        /* Chunked framing size */
+};
+
+/*! Create receive state of a socket with pipelined messages
+ *
+ * @retval  mr    Receive state, free with clixon_msg_rcv_free
+ * @retval  NULL  Error
+ */
+clixon_msg_rcv *
+clixon_msg_rcv_new(void)
+{
+    clixon_msg_rcv *mr;
+
+    if ((mr = malloc(sizeof(*mr))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        return NULL;
+    }
+    memset(mr, 0, sizeof(*mr));
+    if ((mr->mr_msg = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        free(mr);
+        return NULL;
+    }
+    return mr;
+}
+
+/*! Free receive state of a socket
+ *
+ * @param[in]  mr  Receive state
+ */
+int
+clixon_msg_rcv_free(clixon_msg_rcv *mr)
+{
+    if (mr->mr_msg)
+        cbuf_free(mr->mr_msg);
+    free(mr);
+    return 0;
+}
+
+/*! Check if there is unconsumed input, ie input not yet read by clixon_msg_rcv11_next
+ *
+ * @param[in]  mr  Receive state
+ * @retval     1   Yes, there is input that may contain more messages
+ * @retval     0   No, all input has been consumed
+ */
+int
+clixon_msg_rcv_pending(clixon_msg_rcv *mr)
+{
+    return mr->mr_off < mr->mr_len;
+}
+
+/*! Receive next message from a socket where messages may be pipelined
+ *
+ * Parses at most one message from buffered input. If there is no buffered input
+ * and rd is set, read once from the socket, which should be readable.
+ * Unlike clixon_msg_rcv11, does not block waiting for the rest of a message.
+ * @param[in]   s      Socket where input arrives
+ * @param[in]   descr  Description of peer for logging
+ * @param[in]   mr     Receive state of socket
+ * @param[in]   rd     Read from socket if there is no buffered input
+ * @param[out]  cb     Complete message, or NULL if more input is needed. Free with cbuf_free
+ * @param[out]  eof    Set if eof or framing error encountered
+ * @retval      0      OK (check eof and cb)
+ * @retval     -1      Error
+ * @see clixon_msg_rcv11  Blocking receive of one message
+ */
+int
+clixon_msg_rcv11_next(int             s,
+                      const char     *descr,
+                      clixon_msg_rcv *mr,
+                      int             rd,
+                      cbuf          **cb,
+                      int            *eof)
+{
+    int            retval = -1;
+    ssize_t        len;
+    unsigned char *p;
+    size_t         plen;
+    int            eom = 0;
+    cbuf          *cbmsg;
+
+    *cb = NULL;
+    *eof = 0;
+    if (mr->mr_off == mr->mr_len){
+        if (!rd)
+            goto ok;
+        if ((len = netconf_input_read2(s, mr->mr_buf, sizeof(mr->mr_buf), eof)) < 0)
+            goto done;
+        mr->mr_off = 0;
+        mr->mr_len = len;
+        if (*eof){
+            clixon_debug(CLIXON_DBG_MSG, "Recv [%s]: EOF", descr?descr:"");
+            goto ok;
+        }
+    }
+    p = mr->mr_buf + mr->mr_off;
+    plen = mr->mr_len - mr->mr_off;
+    if (netconf_input_msg2(&p, &plen, mr->mr_msg, NETCONF_SSH_CHUNKED,
+                           &mr->mr_state, &mr->mr_size, &eom) < 0){
+        /* Errors from input are only framing errors, non-fatal, return eof */
+        *eof = 1;
+        cbuf_reset(mr->mr_msg);
+        mr->mr_off = mr->mr_len = 0;
+        goto ok;
+    }
+    mr->mr_off = mr->mr_len - plen;
+    if (eom){
+        if ((cbmsg = cbuf_new()) == NULL){
+            clixon_err(OE_UNIX, errno, "cbuf_new");
+            goto done;
+        }
+        *cb = mr->mr_msg;
+        mr->mr_msg = cbmsg;
+        clixon_debug(CLIXON_DBG_MSG, "Recv [%s] len: %lu", descr?descr:"", cbuf_len(*cb));
+        clixon_debug(CLIXON_DBG_MSG | CLIXON_DBG_DETAIL, "Recv [%s]: %s", descr?descr:"", cbuf_get(*cb));
+    }
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Send a NETCONF message and wait for result.
  *
  * TBD: timeout, interrupt?
@@ -665,19 +992,11 @@ clicon_rpc(int                sock,
 {
     int                retval = -1;
     struct clicon_msg *reply = NULL;
-    cbuf              *cbsend = NULL;
     cbuf              *cbrcv = NULL;
 
     clixon_debug(CLIXON_DBG_MSG | CLIXON_DBG_DETAIL, "");
-    if ((cbsend = cbuf_new()) == NULL){
-        clixon_err(OE_UNIX, errno, "cbuf_new");
-        goto done;
-    }
-    cprintf(cbsend, "%s", msg->op_body);
-    if (clixon_msg_send11(sock, descr, cbsend) < 0)
+    if (clixon_msg_send11_buf(sock, descr, msg->op_body, strlen(msg->op_body)) < 0)
         goto done;
-    if (cbsend)
-        cbuf_free(cbsend);
     if (clixon_msg_rcv11(sock, descr, 0, &cbrcv, eof) < 0)
         goto done;
     if (*eof)
@@ -700,10 +1019,11 @@ clicon_rpc(int                sock,
 
 /*! Send a clicon_msg message as reply to a clicon rpc request
  *
+ * The data is sent directly from the caller's buffer
  * @param[in]  s       Socket to communicate with client
  * @param[in]  descr   Description of peer for logging
  * @param[in]  data    Returned data as byte-string.
- * @param[in]  datalen Length of returned data XXX  may be unecessary if always string?
+ * @param[in]  datalen Length of returned data, a terminating null is not sent
  * @retval     0       OK
  * @retval    -1       Error
  */
@@ -713,24 +1033,7 @@ send_msg_reply(int         s,
                char       *data,
                uint32_t    datalen)
 {
-    int                retval = -1;
-    cbuf          *cb = NULL;
-
-    if ((cb = cbuf_new()) == NULL){
-        clixon_err(OE_UNIX, errno, "cbuf_new");
-        goto done;
-    }
-    if (cbuf_append_buf(cb, data, datalen) < 0){
-        clixon_err(OE_UNIX, errno, "cbuf_append_buf");
-        goto done;
-    }
-    if (clixon_msg_send11(s, descr, cb) < 0)
-        goto done;
-    retval = 0;
- done:
-    if (cb)
-        cbuf_free(cb);
-    return retval;
+    return clixon_msg_send11_buf(s, descr, data, strnlen(data, datalen));
 }
 
 /*! Send a clicon_msg NOTIFY message asynchronously to client
@@ -747,21 +1050,7 @@ send_msg_notify(int         s,
                 const char *descr,
                 char       *msg)
 {
-    int   retval = -1;
-    cbuf *cb = NULL;
-
-    if ((cb = cbuf_new()) == NULL){
-        clixon_err(OE_UNIX, errno, "cbuf_new");
-        goto done;
-    }
-    cprintf(cb, "%s", msg);
-    if (clixon_msg_send11(s, descr, cb) < 0)
-        goto done;
-    retval = 0;
- done:
-    if (cb)
-        cbuf_free(cb);
-    return retval;
+    return clixon_msg_send11_buf(s, descr, msg, strlen(msg));
 }
 
 /*! Send a clicon_msg NOTIFY message asynchronously to client
@@ -83,12 +83,56 @@
 #include "clixon_xml_sort.h"
 #include "clixon_netconf_lib.h"
 #include "clixon_xml_io.h"
+#include "clixon_xml_binary.h"
+#include "clixon_datastore.h"
 #include "clixon_proto_client.h"
 
 #define PERSIST_ID_XML_FMT "<persist-id>%s</persist-id>"
 #define PERSIST_XML_FMT "<persist>%s</persist>"
 #define TIMEOUT_XML_FMT "<confirm-timeout>%u</confirm-timeout>"
 
+/*! Outstanding asynchronous rpc
+ *
+ * @see clicon_rpc_netconf_xml_async
+ */
+struct rpc_async {
+    qelem_t              ra_qelem;   /* List of outstanding rpcs of socket, in send order */
+    char                *ra_msgid;   /* message-id of request */
+    char                *ra_rpcname; /* Name of rpc, for yang binding of reply */
+    clicon_rpc_async_cb *ra_fn;      /* Completion callback */
+    void                *ra_arg;     /* Completion callback argument */
+};
+
+/*! Backend socket with outstanding asynchronous rpcs
+ */
+struct rpc_async_sock {
+    qelem_t           as_qelem;   /* List of sockets */
+    int               as_s;       /* Socket to backend */
+    clixon_handle     as_h;       /* Clixon handle */
+    clixon_msg_rcv   *as_rcv;     /* Receive state of replies */
+    struct rpc_async *as_pending; /* Outstanding rpcs */
+};
+
+/* Sockets with asynchronous rpcs */
+static struct rpc_async_sock *_rpc_async_socks = NULL;
+
+/*! Backend session of a session pool, bound to the user who made the hello
+ *
+ * @see clicon_rpc_session_select
+ */
+struct rpc_session {
+    int       rs_s;        /* Socket to backend, or -1 */
+    uint32_t  rs_id;       /* Session-id, or 0 if no hello made */
+    char     *rs_username; /* User of hello, or NULL if unbound */
+    uint64_t  rs_used;     /* Sequence number of last use, for LRU */
+};
+
+/* Session pool, see CLICON_SOCK_SESSIONS */
+static struct rpc_session *_rpc_sessions = NULL;
+static int                 _rpc_sessions_len = 0;
+static int                 _rpc_sessions_cur = 0;  /* Session in use by handle */
+static uint64_t            _rpc_sessions_seq = 0;
+
 /*! Connect to internal netconf socket
  *
  * @param[in]  h     Clixon handle
@@ -184,6 +228,44 @@ clicon_rpc_msg_once(clixon_handle      h,
     return retval;
 }
 
+/*! Parse reply from backend, in XML or binary format
+ *
+ * @param[in]  h       Clixon handle
+ * @param[in]  retdata Reply message
+ * @param[out] xret    XML tree. Binary replies are bound if yang specs are equal
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @see CLICON_SOCK_BINARY
+ */
+static int
+clicon_rpc_parse_reply(clixon_handle h,
+                       char         *retdata,
+                       cxobj       **xret)
+{
+    int bound;
+
+    if (clixon_binary_msg(retdata))
+        return clixon_binary_parse_string(retdata, clicon_dbspec_yang(h), xret, &bound);
+    return clixon_xml_parse_string(retdata, YB_NONE, NULL, xret, NULL);
+}
+
+/*! Check if data of reply is already bound, ie received in binary format
+ *
+ * @param[in]  xd  Data node of reply
+ * @retval     1   Bound, no need to call xml_bind_yang
+ * @retval     0   Not bound
+ * @see clixon_binary_parse_string  where a tree is either bound or not at all
+ */
+static int
+clicon_rpc_data_bound(cxobj *xd)
+{
+    cxobj *xc;
+
+    if ((xc = xml_child_i_type(xd, 0, CX_ELMNT)) == NULL)
+        return 0;
+    return xml_spec(xc) != NULL;
+}
+
 /*! Send internal netconf rpc from client to backend
  *
  * @param[in]    h      Clixon handle
@@ -245,7 +327,7 @@ clicon_rpc_msg(clixon_handle      h,
         /* Cannot populate xret here because need to know RPC name (eg "lock") in order to associate yang
          * to reply.
          */
-        if (clixon_xml_parse_string(retdata, YB_NONE, NULL, &xret, NULL) < 0)
+        if (clicon_rpc_parse_reply(h, retdata, &xret) < 0)
             goto done;
     }
     if (xret0){
@@ -313,7 +395,7 @@ clicon_rpc_msg_persistent(clixon_handle      h,
         /* Cannot populate xret here because need to know RPC name (eg "lock") in order to associate yang
          * to reply.
          */
-        if (clixon_xml_parse_string(retdata, YB_NONE, NULL, &xret, NULL) < 0)
+        if (clicon_rpc_parse_reply(h, retdata, &xret) < 0)
             goto done;
     }
     if (xret0){
@@ -364,6 +446,145 @@ session_id_check(clixon_handle h,
     return retval;
 }
 
+/*! Check a pooled session socket for close by the backend
+ *
+ * @param[in]  s   Socket to backend
+ * @retval     1   Socket is alive
+ * @retval     0   Socket closed or in error, do not use
+ */
+static int
+session_pool_alive(int s)
+{
+    char c;
+    int  n;
+
+    if ((n = recv(s, &c, 1, MSG_PEEK | MSG_DONTWAIT)) == 0)
+        return 0;
+    if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+        return 0;
+    return 1;
+}
+
+/*! Select a backend session of the pool for the next requests of a user
+ *
+ * Each pooled session makes its hello with the user it is bound to, so that the backend
+ * sees one session per user. A session already bound to the user is preferred, then an
+ * unbound session, and otherwise the least recently used session is re-bound.
+ * Re-binding and closed sockets give a new session lazily, on the next request.
+ * The socket and session-id of the selected session are set in the handle, so all
+ * clicon_rpc_* functions use it transparently.
+ * @param[in]  h        Clixon handle
+ * @param[in]  username User name of next requests, or NULL
+ * @retval     0        OK
+ * @retval    -1        Error
+ * @note No-op unless CLICON_SOCK_SESSIONS is larger than 1
+ * @see clicon_rpc_session_pool_close
+ */
+int
+clicon_rpc_session_select(clixon_handle h,
+                          char         *username)
+{
+    int                 retval = -1;
+    int                 n;
+    int                 i;
+    int                 j;
+    struct rpc_session *rs;
+    uint32_t            id;
+
+    if ((n = clicon_option_int(h, "CLICON_SOCK_SESSIONS")) <= 1 || username == NULL)
+        goto ok;
+    if (_rpc_sessions == NULL){
+        if ((_rpc_sessions = calloc(n, sizeof(*_rpc_sessions))) == NULL){
+            clixon_err(OE_UNIX, errno, "calloc");
+            goto done;
+        }
+        _rpc_sessions_len = n;
+        for (i=0; i<n; i++)
+            _rpc_sessions[i].rs_s = -1;
+        _rpc_sessions_cur = 0; /* Existing session of handle, unbound */
+    }
+    /* Save state of current session */
+    rs = &_rpc_sessions[_rpc_sessions_cur];
+    rs->rs_s = clicon_client_socket_get(h);
+    if (clicon_session_id_get(h, &id) < 0)
+        id = 0;
+    rs->rs_id = id;
+    /* Select: bound to user, unbound, or least recently used */
+    j = -1;
+    for (i=0; i<_rpc_sessions_len; i++){
+        rs = &_rpc_sessions[i];
+        if (rs->rs_username && strcmp(rs->rs_username, username) == 0){
+            j = i;
+            break;
+        }
+        if (j == -1 ||
+            (rs->rs_username == NULL && _rpc_sessions[j].rs_username != NULL) ||
+            ((rs->rs_username == NULL) == (_rpc_sessions[j].rs_username == NULL) &&
+             rs->rs_used < _rpc_sessions[j].rs_used))
+            j = i;
+    }
+    rs = &_rpc_sessions[j];
+    if (rs->rs_username == NULL || strcmp(rs->rs_username, username) != 0){
+        /* Re-bind: drop old session, the backend closes it on socket close */
+        if (rs->rs_s != -1){
+            close(rs->rs_s);
+            rs->rs_s = -1;
+        }
+        rs->rs_id = 0;
+        if (rs->rs_username)
+            free(rs->rs_username);
+        if ((rs->rs_username = strdup(username)) == NULL){
+            clixon_err(OE_UNIX, errno, "strdup");
+            goto done;
+        }
+    }
+    else if (rs->rs_s != -1 && !session_pool_alive(rs->rs_s)){
+        clixon_debug(CLIXON_DBG_DEFAULT, "pooled session %u closed by backend", rs->rs_id);
+        close(rs->rs_s);
+        rs->rs_s = -1;
+        rs->rs_id = 0;
+    }
+    rs->rs_used = ++_rpc_sessions_seq;
+    _rpc_sessions_cur = j;
+    clicon_client_socket_set(h, rs->rs_s);
+    if (rs->rs_id)
+        clicon_session_id_set(h, rs->rs_id);
+    else
+        clicon_session_id_del(h);
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Close all sessions of the pool except the one in use by the handle
+ *
+ * @param[in]  h   Clixon handle
+ * @retval     0   OK
+ * @see clicon_rpc_session_select
+ * @note Close the session of the handle with clicon_rpc_close_session
+ */
+int
+clicon_rpc_session_pool_close(clixon_handle h)
+{
+    int                 i;
+    struct rpc_session *rs;
+
+    for (i=0; i<_rpc_sessions_len; i++){
+        rs = &_rpc_sessions[i];
+        if (i != _rpc_sessions_cur && rs->rs_s != -1)
+            close(rs->rs_s);
+        if (rs->rs_username)
+            free(rs->rs_username);
+    }
+    if (_rpc_sessions)
+        free(_rpc_sessions);
+    _rpc_sessions = NULL;
+    _rpc_sessions_len = 0;
+    _rpc_sessions_cur = 0;
+    return 0;
+}
+
 /*! Generic xml netconf clicon rpc for persistent
  *
  * Want to go over to use netconf directly between client and server,...
@@ -410,6 +631,50 @@ clicon_rpc_netconf(clixon_handle  h,
     return retval;
 }
 
+/*! Bind rpc-reply to yang, replace reply with error if binding fails
+ *
+ * @param[in]     h        Clixon handle
+ * @param[in,out] xret     Reply as xml tree
+ * @param[in]     rpcname  Name of rpc, used to find yang of reply
+ * @retval        0        OK
+ * @retval       -1        Error
+ */
+static int
+clicon_rpc_reply_bind(clixon_handle h,
+                      cxobj        *xret,
+                      char         *rpcname)
+{
+    int        retval = -1;
+    cxobj     *xreply;
+    yang_stmt *yspec;
+    cxobj     *xerr = NULL;
+    cxobj     *xc;
+    int        ret;
+
+    if ((xreply = xml_find_type(xret, NULL, "rpc-reply", CX_ELMNT)) != NULL &&
+        xml_find_type(xreply, NULL, "rpc-error", CX_ELMNT) == NULL){
+        yspec = clicon_dbspec_yang(h);
+        /* Here use rpc name to bind to yang */
+        if ((ret = xml_bind_yang_rpc_reply(h, xreply, rpcname, yspec, &xerr)) < 0)
+            goto done;
+        if (ret == 0){
+            /* Replace reply with error */
+            if (xret) {
+                if ((xc = xml_child_i(xret, 0)) != NULL)
+                    xml_purge(xc);
+                if (xml_addsub(xret, xerr) < 0)
+                    goto done;
+                xerr = NULL;
+            }
+        }
+    }
+    retval = 0;
+ done:
+    if (xerr)
+        xml_free(xerr);
+    return retval;
+}
+
 /*! Generic xml netconf clicon rpc
  *
  * Want to go over to use netconf directly between client and server,...
@@ -438,10 +703,6 @@ clicon_rpc_netconf_xml(clixon_handle  h,
     cbuf      *cb = NULL;
     cxobj     *xname;
     char      *rpcname;
-    cxobj     *xreply;
-    yang_stmt *yspec;
-    cxobj     *xerr = NULL;
-    int        ret;
 
     if ((cb = cbuf_new()) == NULL){
         clixon_err(OE_XML, errno, "cbuf_new");
@@ -456,33 +717,383 @@ clicon_rpc_netconf_xml(clixon_handle  h,
         goto done;
     if (clicon_rpc_netconf(h, cbuf_get(cb), xret, sp) < 0)
         goto done;
-    if ((xreply = xml_find_type(*xret, NULL, "rpc-reply", CX_ELMNT)) != NULL &&
-        xml_find_type(xreply, NULL, "rpc-error", CX_ELMNT) == NULL){
-        yspec = clicon_dbspec_yang(h);
-        /* Here use rpc name to bind to yang */
-        if ((ret = xml_bind_yang_rpc_reply(h, xreply, rpcname, yspec, &xerr)) < 0)
+    if (clicon_rpc_reply_bind(h, *xret, rpcname) < 0)
+        goto done;
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Send internal netconf rpc tree to backend, in binary format if enabled
+ *
+ * With CLICON_SOCK_BINARY the tree is sent in binary format keeping its yang binding,
+ * so that the backend neither parses nor binds it again if the yang specs are equal.
+ * Otherwise it is sent as XML. The reply is not bound to yang.
+ * @param[in]  h       Clixon handle
+ * @param[in]  xrpc    XML rpc tree, eg rpc/edit-config/config where config content is bound
+ * @param[in]  env     Levels of envelope which may not be bound, eg 3 for rpc/edit-config/config
+ * @param[out] xret    Return XML netconf tree, error or OK
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @see clicon_rpc_netconf_xml
+ */
+int
+clicon_rpc_netconf_bound(clixon_handle  h,
+                         cxobj         *xrpc,
+                         int            env,
+                         cxobj        **xret)
+{
+    int   retval = -1;
+    cbuf *cb = NULL;
+
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    if (clicon_option_bool(h, "CLICON_SOCK_BINARY")){
+        if (clixon_xml2binary_cbuf(cb, xrpc, clicon_dbspec_yang(h), env, -1,
+                                   WITHDEFAULTS_REPORT_ALL) < 0)
             goto done;
-        if (ret == 0){
-            /* Replace reply with error */
-            if (*xret) {
-                cxobj *xc;
-                if ((xc = xml_child_i(*xret, 0)) != NULL)
-                    xml_purge(xc);
-                if (xml_addsub(*xret, xerr) < 0)
-                    goto done;
-                xerr = NULL;
+    }
+    else if (clixon_xml2cbuf(cb, xrpc, 0, 0, NULL, -1, 0) < 0)
+        goto done;
+    if (clicon_rpc_netconf(h, cbuf_get(cb), xret, NULL) < 0)
+        goto done;
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Send netconf rpc tree to backend and stream the reply to a callback as it arrives
+ *
+ * The reply is not collected or parsed, instead the data of each read from the backend
+ * socket is given to the callback, which is called a last time with eom set.
+ * The cached client socket is used.
+ * @param[in]  h       Clixon handle
+ * @param[in]  xml     XML netconf tree
+ * @param[in]  fn      Callback called with reply data
+ * @param[in]  arg     Argument to callback
+ * @retval     0       OK
+ * @retval    -1       Error, also if the backend closes the socket
+ * @see clicon_rpc_netconf_xml  where the reply is returned as a tree
+ */
+int
+clicon_rpc_netconf_stream(clixon_handle         h,
+                          cxobj                *xml,
+                          clixon_msg_stream_cb *fn,
+                          void                 *arg)
+{
+    int                retval = -1;
+    uint32_t           session_id;
+    struct clicon_msg *msg = NULL;
+    cbuf              *cb = NULL;
+    int                s;
+    int                eof = 0;
+
+    if (session_id_check(h, &session_id) < 0)
+        goto done;
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    if (clixon_xml2cbuf(cb, xml, 0, 0, NULL, -1, 0) < 0)
+        goto done;
+    if ((msg = clicon_msg_encode(session_id, "%s", cbuf_get(cb))) == NULL)
+        goto done;
+    if ((s = clicon_client_socket_get(h)) < 0){
+        if (clicon_rpc_connect(h, &s) < 0)
+            goto done;
+        clicon_client_socket_set(h, s);
+    }
+    if (clixon_msg_send11_chunk(s, clicon_sock_str(h), msg->op_body, strlen(msg->op_body), 1) < 0 ||
+        clixon_msg_rcv11_stream(s, clicon_sock_str(h), fn, arg, &eof) < 0){
+        close(s);
+        clicon_client_socket_set(h, -1);
+        goto done;
+    }
+    if (eof){
+        close(s);
+        clicon_client_socket_set(h, -1);
+        clixon_err(OE_PROTO, ESHUTDOWN, "Unexpected close of CLICON_SOCK. Clixon backend daemon may have crashed.");
+        goto done;
+    }
+    retval = 0;
+ done:
+    if (msg)
+        free(msg);
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Find socket with asynchronous rpcs
+ *
+ * @param[in]  s   Socket to backend
+ * @retval     as  Socket entry
+ * @retval     NULL Not found
+ */
+static struct rpc_async_sock *
+rpc_async_sock_find(int s)
+{
+    struct rpc_async_sock *as;
+
+    if ((as = _rpc_async_socks) != NULL)
+        do {
+            if (as->as_s == s)
+                return as;
+            as = NEXTQ(struct rpc_async_sock *, as);
+        } while (as && as != _rpc_async_socks);
+    return NULL;
+}
+
+/*! Free an outstanding asynchronous rpc
+ */
+static int
+rpc_async_free(struct rpc_async *ra)
+{
+    if (ra->ra_msgid)
+        free(ra->ra_msgid);
+    if (ra->ra_rpcname)
+        free(ra->ra_rpcname);
+    free(ra);
+    return 0;
+}
+
+/*! Handle a reply of an asynchronous rpc and call its completion callback
+ *
+ * The reply is matched to an outstanding rpc by message-id. A reply without
+ * message-id, eg a framing error, is matched to the oldest outstanding rpc.
+ * @param[in]  as   Socket entry
+ * @param[in]  str  Reply message
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+rpc_async_reply(struct rpc_async_sock *as,
+                char                  *str)
+{
+    int               retval = -1;
+    clixon_handle     h = as->as_h;
+    cxobj            *xret = NULL;
+    cxobj            *xreply;
+    char             *msgid = NULL;
+    struct rpc_async *ra;
+
+    if (clixon_xml_parse_string(str, YB_NONE, NULL, &xret, NULL) < 0)
+        goto done;
+    if ((xreply = xml_find_type(xret, NULL, "rpc-reply", CX_ELMNT)) != NULL)
+        msgid = xml_find_type_value(xreply, NULL, "message-id", CX_ATTR);
+    if ((ra = as->as_pending) != NULL && msgid != NULL)
+        do {
+            if (strcmp(ra->ra_msgid, msgid) == 0)
+                break;
+            ra = NEXTQ(struct rpc_async *, ra);
+        } while (ra && ra != as->as_pending);
+    if (ra == NULL || (msgid != NULL && strcmp(ra->ra_msgid, msgid) != 0)){
+        clixon_log(h, LOG_WARNING, "%s: reply with unknown message-id %s dropped",
+                   __FUNCTION__, msgid?msgid:"");
+        goto ok;
+    }
+    DELQ(ra, as->as_pending, struct rpc_async *);
+    if (clicon_rpc_reply_bind(h, xret, ra->ra_rpcname) < 0)
+        goto done;
+    if (ra->ra_fn(h, xret, ra->ra_arg) < 0){
+        rpc_async_free(ra);
+        goto done;
+    }
+    rpc_async_free(ra);
+ ok:
+    retval = 0;
+ done:
+    if (xret)
+        xml_free(xret);
+    return retval;
+}
+
+/*! Event callback when replies to asynchronous rpcs arrive from backend
+ *
+ * If backend closes the socket, all outstanding callbacks are called with no reply
+ * @param[in]  s    Socket to backend
+ * @param[in]  arg  Socket entry
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+rpc_async_input(int   s,
+                void *arg)
+{
+    int                    retval = -1;
+    struct rpc_async_sock *as = (struct rpc_async_sock *)arg;
+    clixon_handle          h = as->as_h;
+    struct rpc_async      *ra;
+    cbuf                  *cb = NULL;
+    int                    eof = 0;
+    int                    rd = 1;
+
+    do {
+        if (clixon_msg_rcv11_next(s, clicon_sock_str(h), as->as_rcv, rd, &cb, &eof) < 0)
+            goto done;
+        rd = 0;
+        if (eof){
+            clixon_err(OE_PROTO, ESHUTDOWN, "Unexpected close of CLICON_SOCK. Clixon backend daemon may have crashed.");
+            while ((ra = as->as_pending) != NULL){
+                DELQ(ra, as->as_pending, struct rpc_async *);
+                ra->ra_fn(h, NULL, ra->ra_arg);
+                rpc_async_free(ra);
             }
+            clicon_rpc_async_close(h, s);
+            break;
+        }
+        if (cb == NULL)
+            break;
+        if (rpc_async_reply(as, cbuf_get(cb)) < 0)
+            goto done;
+        cbuf_free(cb);
+        cb = NULL;
+        /* Callback may have closed the socket */
+    } while (rpc_async_sock_find(s) == as);
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Send netconf rpc to backend without waiting for the reply
+ *
+ * Several rpcs may be outstanding on the same socket. The backend may reply out of
+ * order, eg a get handled by a read worker, and replies are matched to requests
+ * by message-id. Replies arrive via the event loop.
+ * A message-id and the clixon-lib pipeline attribute are added to the rpc, if not
+ * already present.
+ * @param[in]  h    Clixon handle
+ * @param[in]  s    Socket to backend, eg from clicon_rpc_connect. Not closed here
+ * @param[in]  xml  XML netconf tree on the form <rpc>...
+ * @param[in]  fn   Completion callback, called with the reply
+ * @param[in]  arg  Completion callback argument
+ * @retval     0    OK, rpc sent
+ * @retval    -1    Error
+ * @code
+ *   if (clicon_rpc_connect(h, &s) < 0)
+ *      err;
+ *   if (clicon_rpc_netconf_xml_async(h, s, xrpc, my_reply_cb, myarg) < 0)
+ *      err;
+ *   ...
+ *   clicon_rpc_async_close(h, s);
+ *   close(s);
+ * @endcode
+ * @see clicon_rpc_netconf_xml  Synchronous version
+ */
+int
+clicon_rpc_netconf_xml_async(clixon_handle        h,
+                             int                  s,
+                             cxobj               *xml,
+                             clicon_rpc_async_cb *fn,
+                             void                *arg)
+{
+    int                    retval = -1;
+    struct rpc_async_sock *as = NULL;
+    struct rpc_async      *ra = NULL;
+    cxobj                 *xname;
+    char                  *msgid;
+    cbuf                  *cb = NULL;
+    char                   idstr[16];
+
+    if ((xname = xml_child_i_type(xml, 0, CX_ELMNT)) == NULL){
+        clixon_err(OE_NETCONF, EINVAL, "Missing rpc name");
+        goto done;
+    }
+    if ((msgid = xml_find_type_value(xml, NULL, "message-id", CX_ATTR)) == NULL){
+        snprintf(idstr, sizeof(idstr), "%d", netconf_message_id_next(h));
+        if (xml_add_attr(xml, "message-id", idstr, NULL, NULL) == NULL)
+            goto done;
+        msgid = idstr;
+    }
+    if (xml_find_type(xml, CLIXON_LIB_PREFIX, "pipeline", CX_ATTR) == NULL &&
+        xml_add_attr(xml, "pipeline", "true", CLIXON_LIB_PREFIX, CLIXON_LIB_NS) == NULL)
+        goto done;
+    if ((ra = malloc(sizeof(*ra))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    memset(ra, 0, sizeof(*ra));
+    if ((ra->ra_msgid = strdup(msgid)) == NULL ||
+        (ra->ra_rpcname = strdup(xml_name(xname))) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    ra->ra_fn = fn;
+    ra->ra_arg = arg;
+    if ((as = rpc_async_sock_find(s)) == NULL){
+        if ((as = malloc(sizeof(*as))) == NULL){
+            clixon_err(OE_UNIX, errno, "malloc");
+            goto done;
+        }
+        memset(as, 0, sizeof(*as));
+        as->as_s = s;
+        as->as_h = h;
+        if ((as->as_rcv = clixon_msg_rcv_new()) == NULL){
+            free(as);
+            goto done;
+        }
+        if (clixon_event_reg_fd(s, rpc_async_input, as, "backend async rpc socket") < 0){
+            clixon_msg_rcv_free(as->as_rcv);
+            free(as);
+            goto done;
         }
+        ADDQ(as, _rpc_async_socks);
+    }
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
     }
+    if (clixon_xml2cbuf(cb, xml, 0, 0, NULL, -1, 0) < 0)
+        goto done;
+    if (clixon_msg_send11(s, clicon_sock_str(h), cb) < 0)
+        goto done;
+    ADDQ(ra, as->as_pending);
+    ra = NULL;
     retval = 0;
  done:
-    if (xerr)
-        xml_free(xerr);
+    if (ra)
+        rpc_async_free(ra);
     if (cb)
         cbuf_free(cb);
     return retval;
 }
 
+/*! Stop handling asynchronous rpcs on a socket
+ *
+ * Outstanding rpcs are dropped without calling their callbacks. The socket is not closed.
+ * @param[in]  h    Clixon handle
+ * @param[in]  s    Socket to backend
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+clicon_rpc_async_close(clixon_handle h,
+                       int           s)
+{
+    struct rpc_async_sock *as;
+    struct rpc_async      *ra;
+
+    if ((as = rpc_async_sock_find(s)) == NULL)
+        return 0;
+    clixon_event_unreg_fd(s, rpc_async_input);
+    while ((ra = as->as_pending) != NULL){
+        DELQ(ra, as->as_pending, struct rpc_async *);
+        rpc_async_free(ra);
+    }
+    DELQ(as, _rpc_async_socks, struct rpc_async_sock *);
+    clixon_msg_rcv_free(as->as_rcv);
+    free(as);
+    return 0;
+}
+
 /*! Get database configuration
  *
  * Same as clicon_proto_change just with a cvec instead of lvec
@@ -532,6 +1143,20 @@ clicon_rpc_get_config(clixon_handle h,
     yang_stmt         *yspec;
     cvec              *nscd = NULL;
 
+    if (username == NULL)
+        username = clicon_username_get(h);
+    /* Read running from local snapshot if published by backend */
+    if (strcmp(db, "running") == 0){
+        if ((ret = xmldb_snapshot_get(h, username, nsc, xpath,
+                                      defaults?withdefaults_str2int(defaults):WITHDEFAULTS_EXPLICIT,
+                                      &xd)) < 0)
+            goto done;
+        if (ret == 1){
+            if (xml_bind_special(xd, clicon_dbspec_yang(h), "/nc:get-config/output/data") < 0)
+                goto done;
+            goto reply;
+        }
+    }
     if (session_id_check(h, &session_id) < 0)
         goto done;
     if ((cb = cbuf_new()) == NULL){
@@ -539,8 +1164,6 @@ clicon_rpc_get_config(clixon_handle h,
         goto done;
     }
     cprintf(cb, "<rpc xmlns=\"%s\"", NETCONF_BASE_NAMESPACE);
-    if (username == NULL)
-        username = clicon_username_get(h);
     if (username != NULL){
         cprintf(cb, " %s:username=\"%s\"", CLIXON_LIB_PREFIX, username);
         cprintf(cb, " xmlns:%s=\"%s\"", CLIXON_LIB_PREFIX, CLIXON_LIB_NS);
@@ -581,7 +1204,9 @@ clicon_rpc_get_config(clixon_handle h,
     else{
         if (xml_bind_special(xd, yspec, "/nc:get-config/output/data") < 0)
             goto done;
-        if ((ret = xml_bind_yang(h, xd, YB_MODULE, yspec, &xerr)) < 0)
+        if (clicon_rpc_data_bound(xd))
+            ret = 1;
+        else if ((ret = xml_bind_yang(h, xd, YB_MODULE, yspec, &xerr)) < 0)
             goto done;
         if (ret == 0){
             if (clixon_netconf_internal_error(xerr,
@@ -594,6 +1219,7 @@ clicon_rpc_get_config(clixon_handle h,
             }
         }
     }
+ reply:
     if (xt && xd){
         /* Sync namespaces, ie explicitly set all xmlns attributes to xd */
         if (xml_nsctx_node(xd, &nscd) < 0)
@@ -1087,7 +1713,9 @@ clicon_rpc_get2(clixon_handle   h,
         if (xml_bind_special(xd, yspec, "/nc:get/output/data") < 0)
             goto done;
         if (bind){
-            if ((ret = xml_bind_yang(h, xd, YB_MODULE, yspec, &xerr)) < 0)
+            if (clicon_rpc_data_bound(xd))
+                ret = 1;
+            else if ((ret = xml_bind_yang(h, xd, YB_MODULE, yspec, &xerr)) < 0)
                 goto done;
             if (ret == 0){
                 if (clixon_netconf_internal_error(xerr,
@@ -1258,7 +1886,9 @@ clicon_rpc_get_pageable_list(clixon_handle   h,
     else{
         if (xml_bind_special(xd, yspec, "/nc:get/output/data") < 0)
             goto done;
-        if ((ret = xml_bind_yang(h, xd, YB_MODULE, yspec, &xerr)) < 0)
+        if (clicon_rpc_data_bound(xd))
+            ret = 1;
+        else if ((ret = xml_bind_yang(h, xd, YB_MODULE, yspec, &xerr)) < 0)
             goto done;
         if (ret == 0){
             if (clixon_netconf_internal_error(xerr,
@@ -1890,8 +2520,10 @@ clicon_hello_req(clixon_handle h,
     if (clixon_lib)
         cprintf(cb, " xmlns:%s=\"%s\"", CLIXON_LIB_PREFIX, CLIXON_LIB_NS);
     cprintf(cb, ">");
-    cprintf(cb, "<capabilities><capability>%s</capability></capabilities>",
-            NETCONF_BASE_CAPABILITY_1_1);
+    cprintf(cb, "<capabilities><capability>%s</capability>", NETCONF_BASE_CAPABILITY_1_1);
+    if (clicon_option_bool(h, "CLICON_SOCK_BINARY"))
+        cprintf(cb, "<capability>%s</capability>", CLIXON_BINARY_CAPABILITY);
+    cprintf(cb, "</capabilities>");
     cprintf(cb, "</hello>");
 
     if ((msg = clicon_msg_encode(0, "%s", cbuf_get(cb))) == NULL)
@@ -1922,6 +2554,256 @@ clicon_hello_req(clixon_handle h,
     return retval;
 }
 
+/*! Send several operations to the backend in one batch message
+ *
+ * @param[in]  h       Clixon handle
+ * @param[in]  atomic  If set, restore candidate and skip the rest on first error
+ * @param[in]  ops     Operations as NETCONF rpc elements, eg <rpc><get-config>...</rpc><rpc>...
+ * @param[out] xret    <replies> with one rpc-reply per operation, in order, or
+ *                     <rpc-reply> with rpc-error if the batch failed. Free with xml_free
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @code
+ *   cxobj *xr = NULL;
+ *   if (clicon_rpc_batch(h, 0, "<rpc xmlns=\"...\"><get-config>...</rpc>...", &xr) < 0)
+ *      err;
+ *   while ((x = xml_child_each(xr, x, CX_ELMNT)) != NULL)
+ *      ... x is <rpc-reply> of each operation
+ *   xml_free(xr);
+ * @endcode
+ * @note Replies are not bound to yang
+ */
+int
+clicon_rpc_batch(clixon_handle h,
+                 int           atomic,
+                 const char   *ops,
+                 cxobj       **xret)
+{
+    int                retval = -1;
+    struct clicon_msg *msg = NULL;
+    cxobj             *xt = NULL;
+    cxobj             *xd;
+    char              *username;
+    uint32_t           session_id;
+    cbuf              *cb = NULL;
+
+    if (session_id_check(h, &session_id) < 0)
+        goto done;
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cb, "<rpc xmlns=\"%s\"", NETCONF_BASE_NAMESPACE);
+    cprintf(cb, " xmlns:%s=\"%s\"", NETCONF_BASE_PREFIX, NETCONF_BASE_NAMESPACE);
+    if ((username = clicon_username_get(h)) != NULL){
+        cprintf(cb, " %s:username=\"%s\"", CLIXON_LIB_PREFIX, username);
+        cprintf(cb, " xmlns:%s=\"%s\"", CLIXON_LIB_PREFIX, CLIXON_LIB_NS);
+    }
+    cprintf(cb, " %s", NETCONF_MESSAGE_ID_ATTR);
+    cprintf(cb, ">");
+    cprintf(cb, "<batch xmlns=\"%s\">", CLIXON_LIB_NS);
+    if (atomic)
+        cprintf(cb, "<atomic>true</atomic>");
+    cprintf(cb, "<operations>%s</operations></batch>", ops?ops:"");
+    cprintf(cb, "</rpc>");
+    if ((msg = clicon_msg_encode(session_id, "%s", cbuf_get(cb))) == NULL)
+        goto done;
+    if (clicon_rpc_msg(h, msg, &xt) < 0)
+        goto done;
+    if ((xd = xpath_first(xt, NULL, "/rpc-reply/replies")) == NULL &&
+        (xd = xpath_first(xt, NULL, "/rpc-reply")) == NULL){
+        clixon_err(OE_XML, 0, "batch: no rpc-reply");
+        goto done;
+    }
+    if (xml_rm(xd) < 0)
+        goto done;
+    *xret = xd;
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    if (msg)
+        free(msg);
+    if (xt)
+        xml_free(xt);
+    return retval;
+}
+
+/*! Get entity tag and last modified time of a datastore from the backend
+ *
+ * @param[in]  h       Clixon handle
+ * @param[in]  db      Name of datastore, or NULL for running
+ * @param[in]  node    Top-level data node as <module>:<name>, or NULL for whole running
+ * @param[out] etag    Entity tag, malloced, free with free()
+ * @param[out] tv      Last modified time
+ * @retval     1       OK
+ * @retval     0       Not supported by backend, or error reply
+ * @retval    -1       Error
+ */
+int
+clicon_rpc_datastore_stamp(clixon_handle   h,
+                           const char     *db,
+                           const char     *node,
+                           char          **etag,
+                           struct timeval *tv)
+{
+    int                retval = -1;
+    struct clicon_msg *msg = NULL;
+    cxobj             *xt = NULL;
+    uint32_t           session_id;
+    cbuf              *cb = NULL;
+    char              *etagstr;
+    char              *timestr;
+
+    if (session_id_check(h, &session_id) < 0)
+        goto done;
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cb, "<rpc xmlns=\"%s\" %s>", NETCONF_BASE_NAMESPACE, NETCONF_MESSAGE_ID_ATTR);
+    cprintf(cb, "<datastore-stamp xmlns=\"%s\">", CLIXON_LIB_NS);
+    if (db)
+        cprintf(cb, "<datastore>%s</datastore>", db);
+    if (node)
+        cprintf(cb, "<node>%s</node>", node);
+    cprintf(cb, "</datastore-stamp></rpc>");
+    if ((msg = clicon_msg_encode(session_id, "%s", cbuf_get(cb))) == NULL)
+        goto done;
+    if (clicon_rpc_msg(h, msg, &xt) < 0)
+        goto done;
+    if ((etagstr = xml_find_body(xpath_first(xt, NULL, "rpc-reply"), "etag")) == NULL ||
+        (timestr = xml_find_body(xpath_first(xt, NULL, "rpc-reply"), "last-modified")) == NULL ||
+        str2time(timestr, tv) < 0){
+        retval = 0;
+        goto done;
+    }
+    if ((*etag = strdup(etagstr)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    retval = 1;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    if (msg)
+        free(msg);
+    if (xt)
+        xml_free(xt);
+    return retval;
+}
+
+/*! Get the differences between two datastores from the backend as changed subtrees
+ *
+ * @param[in]  h       Clixon handle
+ * @param[in]  db1     Name of first datastore
+ * @param[in]  db2     Name of second datastore
+ * @param[out] xt1     Nodes deleted or changed in db1 with ancestors, as <data>. Free with xml_free
+ * @param[out] xt2     Nodes added or changed in db2 with ancestors, as <data>. Free with xml_free
+ * @retval     0       OK
+ * @retval    -1       Error, also error reply from backend
+ * @code
+ *   cxobj *xt1 = NULL;
+ *   cxobj *xt2 = NULL;
+ *   if (clicon_rpc_datastore_diff(h, "running", "candidate", &xt1, &xt2) < 0)
+ *      err;
+ *   if (clixon_xml_diff2cbuf(cb, xt1, xt2) < 0)
+ *      err;
+ * @endcode
+ */
+int
+clicon_rpc_datastore_diff(clixon_handle h,
+                          const char   *db1,
+                          const char   *db2,
+                          cxobj       **xt1,
+                          cxobj       **xt2)
+{
+    int                retval = -1;
+    struct clicon_msg *msg = NULL;
+    cxobj             *xret = NULL;
+    cxobj             *xerr = NULL;
+    cxobj             *xd[2] = {NULL, NULL};
+    cvec              *nscd = NULL;
+    uint32_t           session_id;
+    cbuf              *cb = NULL;
+    yang_stmt         *yspec;
+    char              *username;
+    int                ret;
+    int                i;
+
+    if (session_id_check(h, &session_id) < 0)
+        goto done;
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cb, "<rpc xmlns=\"%s\"", NETCONF_BASE_NAMESPACE);
+    if ((username = clicon_username_get(h)) != NULL){
+        cprintf(cb, " %s:username=\"%s\"", CLIXON_LIB_PREFIX, username);
+        cprintf(cb, " xmlns:%s=\"%s\"", CLIXON_LIB_PREFIX, CLIXON_LIB_NS);
+    }
+    cprintf(cb, " %s>", NETCONF_MESSAGE_ID_ATTR);
+    cprintf(cb, "<datastore-diff xmlns=\"%s\">", CLIXON_LIB_NS);
+    cprintf(cb, "<source>%s</source>", db1);
+    cprintf(cb, "<target>%s</target>", db2);
+    cprintf(cb, "</datastore-diff></rpc>");
+    if ((msg = clicon_msg_encode(session_id, "%s", cbuf_get(cb))) == NULL)
+        goto done;
+    if (clicon_rpc_msg(h, msg, &xret) < 0)
+        goto done;
+    if ((xerr = xpath_first(xret, NULL, "/rpc-reply/rpc-error")) != NULL){
+        clixon_err_netconf(h, OE_NETCONF, 0, xerr, "Datastore diff");
+        goto done;
+    }
+    yspec = clicon_dbspec_yang(h);
+    for (i=0; i<2; i++){
+        if ((xd[i] = xpath_first(xret, NULL, "/rpc-reply/%s", i==0?"source":"target")) == NULL){
+            if ((xd[i] = xml_new(NETCONF_OUTPUT_DATA, NULL, CX_ELMNT)) == NULL)
+                goto done;
+        }
+        else {
+            /* Sync namespaces, ie explicitly set all xmlns attributes to xd */
+            if (xml_nsctx_node(xd[i], &nscd) < 0)
+                goto done;
+            if (xml_rm(xd[i]) < 0)
+                goto done;
+            if (xmlns_set_all(xd[i], nscd) < 0)
+                goto done;
+            cvec_free(nscd);
+            nscd = NULL;
+            if (xml_name_set(xd[i], NETCONF_OUTPUT_DATA) < 0)
+                goto done;
+        }
+        if (xml_bind_special(xd[i], yspec, "/nc:get-config/output/data") < 0)
+            goto done;
+        if ((ret = xml_bind_yang(h, xd[i], YB_MODULE, yspec, &xerr)) < 0)
+            goto done;
+        if (ret == 0){
+            clixon_err_netconf(h, OE_NETCONF, 0, xerr, "Datastore diff, backend returned invalid XML");
+            xml_free(xerr);
+            goto done;
+        }
+        xml_sort(xd[i]);
+    }
+    *xt1 = xd[0];
+    *xt2 = xd[1];
+    xd[0] = xd[1] = NULL;
+    retval = 0;
+ done:
+    for (i=0; i<2; i++)
+        if (xd[i] && xml_parent(xd[i]) == NULL)
+            xml_free(xd[i]);
+    if (nscd)
+        cvec_free(nscd);
+    if (cb)
+        cbuf_free(cb);
+    if (msg)
+        free(msg);
+    if (xret)
+        xml_free(xret);
+    return retval;
+}
+
 /*! Send a restart plugin request to backend server
  *
  * @param[in] h        Clixon handle
@@ -37,7 +37,7 @@
   *
   * Clixon regular expression code for Yang type patterns following XML Schema
   * regex. 
-  * Two modes: libxml2 and posix-translation
+  * Three modes: libxml2, posix-translation and pcre2-translation
  * @see http://www.w3.org/TR/2004/REC-xmlschema-2-20041028
  */
 
@@ -52,6 +52,10 @@
 #include <errno.h>
 #include <regex.h>
 #include <ctype.h>
+#ifdef HAVE_LIBPCRE2_8
+#define PCRE2_CODE_UNIT_WIDTH 8
+#include <pcre2.h>
+#endif
 
 #include <cligen/cligen.h>
 
@@ -369,6 +373,237 @@ regexp_xsd2posix(char  *xsd,
     return retval;
 }
 
+/*-------------------------- PCRE2 translation -------------------------*/
+
+/*! Transform from XSD regex to PCRE2
+ *
+ * Most of XSD regex syntax is also PCRE2 syntax, given that unicode properties are enabled
+ * (PCRE2_UTF|PCRE2_UCP). The differences translated are:
+ * - XSD regexps are implicitly anchored at both ends
+ * - ^ and $ are not anchors in XSD, but as in the posix translation a leading ^ and trailing $
+ *   are accepted as (redundant) anchors
+ * - . does not match \n or \r in XSD
+ * - \s and \S are only space, tab, newline and carriage return in XSD
+ * - \i, \I, \c and \C (XML name chars) do not exist in PCRE2
+ * - \uXXXX is translated to \x{XXXX}
+ * Character class subtraction, eg [a-z-[aeiou]], is not translated.
+ * @param[in]  xsd    Input regex string according XSD
+ * @param[out] pcre   Output (malloced) string according to PCRE2
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see regexp_xsd2posix
+ */
+int
+regexp_xsd2pcre2(char  *xsd,
+                 char **pcre)
+{
+    int    retval = -1;
+    cbuf  *cb = NULL;
+    char   x;
+    size_t i;
+    size_t len;
+    int    bracket = 0; /* Inside character class */
+
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    len = strlen(xsd);
+    cprintf(cb, "\\A(?:");
+    for (i=0; i<len; i++){
+        x = xsd[i];
+        if (x == '\\' && i+1 < len){
+            x = xsd[++i];
+            switch (x){
+            case 'i': /* initial */
+                cprintf(cb, bracket?"\\p{L}_:":"[\\p{L}_:]");
+                break;
+            case 'I':
+                cprintf(cb, bracket?"\\I":"[^\\p{L}_:]");
+                break;
+            case 'c': /* xml namechar */
+                cprintf(cb, bracket?"\\p{L}\\p{Nd}._:\\-\\x{B7}":"[\\p{L}\\p{Nd}._:\\-\\x{B7}]");
+                break;
+            case 'C':
+                cprintf(cb, bracket?"\\C":"[^\\p{L}\\p{Nd}._:\\-\\x{B7}]");
+                break;
+            case 's':
+                cprintf(cb, bracket?" \\t\\n\\r":"[ \\t\\n\\r]");
+                break;
+            case 'S':
+                cprintf(cb, bracket?"\\S":"[^ \\t\\n\\r]");
+                break;
+            case 'u':
+                if (i+4 < len &&
+                    isxdigit((unsigned char)xsd[i+1]) && isxdigit((unsigned char)xsd[i+2]) &&
+                    isxdigit((unsigned char)xsd[i+3]) && isxdigit((unsigned char)xsd[i+4])){
+                    cprintf(cb, "\\x{%.4s}", &xsd[i+1]);
+                    i += 4;
+                }
+                else
+                    cprintf(cb, "\\u");
+                break;
+            default:
+                cprintf(cb, "\\%c", x);
+                break;
+            }
+        }
+        else if (bracket){
+            if (x == '[') /* Subtraction or posix class: leave as is */
+                bracket++;
+            else if (x == ']')
+                bracket--;
+            cprintf(cb, "%c", x);
+        }
+        else {
+            switch (x){
+            case '[':
+                bracket++;
+                cprintf(cb, "%c", x);
+                if (i+1 < len && xsd[i+1] == '^')
+                    cprintf(cb, "%c", xsd[++i]);
+                break;
+            case '^': /* Not anchors in XSD, except first/last as in posix translation */
+                if (i != 0)
+                    cprintf(cb, "\\%c", x);
+                break;
+            case '$':
+                if (i != len-1)
+                    cprintf(cb, "\\%c", x);
+                break;
+            case '.':
+                cprintf(cb, "[^\\n\\r]");
+                break;
+            default:
+                cprintf(cb, "%c", x);
+                break;
+            }
+        }
+    }
+    cprintf(cb, ")\\z");
+    if ((*pcre = strdup(cbuf_get(cb))) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+#ifdef HAVE_LIBPCRE2_8
+/*! Compiled PCRE2 regexp with its match data, reused by all matches
+ */
+struct clixon_pcre2 {
+    pcre2_code       *cp_code;
+    pcre2_match_data *cp_md;
+};
+
+/*! Compile PCRE2 regexp translated from XSD regexp, and JIT-compile it if supported
+ *
+ * @param[in]   regexp  Regular expression string in XSD regex format
+ * @param[out]  recomp  Compiled regular expression (malloc:d, free with regex_pcre2_free)
+ * @retval      1       OK
+ * @retval      0       Invalid regular expression
+ * @retval     -1       Error
+ */
+static int
+regex_pcre2_compile(char  *regexp,
+                    void **recomp)
+{
+    int                  retval = -1;
+    char                *pcre = NULL;
+    struct clixon_pcre2 *cp = NULL;
+    int                  errcode;
+    PCRE2_SIZE           erroffset;
+
+    if (regexp_xsd2pcre2(regexp, &pcre) < 0)
+        goto done;
+    if ((cp = calloc(1, sizeof(*cp))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    if ((cp->cp_code = pcre2_compile((PCRE2_SPTR)pcre, PCRE2_ZERO_TERMINATED,
+                                     PCRE2_UTF|PCRE2_UCP,
+                                     &errcode, &erroffset, NULL)) == NULL){
+        clixon_debug(CLIXON_DBG_DEFAULT, "pcre2_compile %s: error %d at %zu",
+                     pcre, errcode, (size_t)erroffset);
+        retval = 0;
+        goto done;
+    }
+    /* JIT is optional, if not supported the interpreter is used by pcre2_match */
+    (void)pcre2_jit_compile(cp->cp_code, PCRE2_JIT_COMPLETE);
+    if ((cp->cp_md = pcre2_match_data_create_from_pattern(cp->cp_code, NULL)) == NULL){
+        clixon_err(OE_UNIX, errno, "pcre2_match_data_create_from_pattern");
+        goto done;
+    }
+    *recomp = cp;
+    cp = NULL;
+    retval = 1;
+ done:
+    if (cp)
+        regex_pcre2_free(cp);
+    if (pcre)
+        free(pcre);
+    return retval;
+}
+
+/*! Execute compiled PCRE2 regexp
+ *
+ * @param[in]  recomp  Compiled regular expression
+ * @param[in]  string  Content string to match
+ * @retval     1       Match
+ * @retval     0       No match, also if string is not valid UTF-8
+ * @retval    -1       Error
+ */
+static int
+regex_pcre2_exec(void *recomp,
+                 char *string)
+{
+    struct clixon_pcre2 *cp = (struct clixon_pcre2 *)recomp;
+    int                  rc;
+
+    if (cp == NULL){
+        clixon_err(OE_REGEX, EINVAL, "No compiled regexp");
+        return -1;
+    }
+    rc = pcre2_match(cp->cp_code, (PCRE2_SPTR)string, PCRE2_ZERO_TERMINATED,
+                     0, 0, cp->cp_md, NULL);
+    if (rc >= 0)
+        return 1;
+    if (rc == PCRE2_ERROR_NOMATCH ||
+        (rc <= PCRE2_ERROR_UTF8_ERR1 && rc >= PCRE2_ERROR_UTF8_ERR21))
+        return 0;
+    clixon_err(OE_REGEX, 0, "pcre2_match error %d", rc);
+    return -1;
+}
+#endif /* HAVE_LIBPCRE2_8 */
+
+/*! Free compiled PCRE2 regexp
+ *
+ * Separate from regex_free since it is called from yang type cache where handle is not
+ * available
+ * @param[in]  recomp  Compiled regular expression, may be NULL
+ * @retval     0       OK
+ */
+int
+regex_pcre2_free(void *recomp)
+{
+#ifdef HAVE_LIBPCRE2_8
+    struct clixon_pcre2 *cp = (struct clixon_pcre2 *)recomp;
+
+    if (cp == NULL)
+        return 0;
+    if (cp->cp_md)
+        pcre2_match_data_free(cp->cp_md);
+    if (cp->cp_code)
+        pcre2_code_free(cp->cp_code);
+    free(cp);
+#endif
+    return 0;
+}
+
 /*-------------------------- Generic API functions ------------------------*/
 
 /*! Compilation of regular expression / pattern
@@ -400,6 +635,13 @@ regex_compile(clixon_handle h,
     case REGEXP_LIBXML2:
         retval = cligen_regex_libxml2_compile(regexp, recomp);
         break;
+    case REGEXP_PCRE2:
+#ifdef HAVE_LIBPCRE2_8
+        retval = regex_pcre2_compile(regexp, recomp);
+#else
+        clixon_err(OE_CFG, 0, "CLICON_YANG_REGEXP set to pcre2, but HAVE_LIBPCRE2_8 not set (Either change CLICON_YANG_REGEXP to posix, or run: configure --with-pcre2)");
+#endif
+        break;
     default:
         clixon_err(OE_CFG, 0, "clicon_yang_regexp invalid value: %d", clicon_yang_regexp(h));
         break;
@@ -433,6 +675,11 @@ regex_exec(clixon_handle h,
     case REGEXP_LIBXML2:
         retval = cligen_regex_libxml2_exec(recomp, string);
         break;
+#ifdef HAVE_LIBPCRE2_8
+    case REGEXP_PCRE2:
+        retval = regex_pcre2_exec(recomp, string);
+        break;
+#endif
     default:
         clixon_err(OE_CFG, 0, "clicon_yang_regexp invalid value: %d",
                    clicon_yang_regexp(h));
@@ -463,6 +710,9 @@ regex_free(clixon_handle h,
     case REGEXP_LIBXML2:
         retval = cligen_regex_libxml2_free(recomp);
         break;
+    case REGEXP_PCRE2:
+        retval = regex_pcre2_free(recomp);
+        break;
     default:
         clixon_err(OE_CFG, 0, "clicon_yang_regexp invalid value: %d", clicon_yang_regexp(h));
         goto done;
@@ -64,7 +64,12 @@
 #include <errno.h>
 #include <inttypes.h>
 #include <syslog.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <sys/time.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
 
 /* cligen */
 #include <cligen/cligen.h>
@@ -87,10 +92,32 @@
 #include "clixon_xpath_ctx.h"
 #include "clixon_xpath.h"
 #include "clixon_stream.h"
+#include "clixon_memstats.h"
 
 /* Go through and timeout subscription timers [s] */
 #define STREAM_TIMER_TIMEOUT_S 5
 
+/* Initial number of records in a replay ring */
+#define STREAM_REPLAY_INIT 64
+
+/* Compact a replay file when it is this much larger than twice its live records */
+#define STREAM_REPLAY_COMPACT_MIN (1024*1024)
+
+/* Record header in replay file, followed by rh_len bytes of serialized event */
+struct stream_replay_hdr{
+    uint64_t rh_sec;
+    uint32_t rh_usec;
+    uint32_t rh_len;
+};
+
+/* Event being distributed by stream_notify1 and its serialized message, if any
+ * A subscriber callback getting the message of this event shares it, see stream_msg_get */
+static cxobj      *_stream_xevent = NULL;
+static stream_msg *_stream_msg = NULL;
+
+/* Sequence number of events distributed by stream_notify1, see sf_seq */
+static uint64_t    _stream_event_seq = 0;
+
 /*! Find an event notification stream given name
  *
  * @param[in]  h    Clixon handle
@@ -115,6 +142,365 @@ stream_find(clixon_handle h,
     return NULL;
 }
 
+/*! Get replay record with index i from oldest
+ */
+static struct stream_replay *
+stream_replay_ix(event_stream_t *es,
+                 int             i)
+{
+    return &es->es_replay[(es->es_replay_head + i) % es->es_replay_max];
+}
+
+/*! Remove oldest replay record
+ */
+static void
+stream_replay_pop(event_stream_t *es)
+{
+    struct stream_replay *r;
+
+    r = stream_replay_ix(es, 0);
+    es->es_replay_size -= r->r_msg->sm_len;
+    stream_msg_free(r->r_msg);
+    r->r_msg = NULL;
+    es->es_replay_head = (es->es_replay_head + 1) % es->es_replay_max;
+    es->es_replay_len--;
+}
+
+/*! Write replay record to replay file
+ *
+ * @param[in] fd   Open replay file
+ * @param[in] tv   Timestamp
+ * @param[in] sm   Serialized event
+ * @retval    0    OK
+ * @retval   -1    Error
+ */
+static int
+stream_replay_write(int             fd,
+                    struct timeval *tv,
+                    stream_msg     *sm)
+{
+    struct stream_replay_hdr rh;
+    struct iovec             iov[2];
+
+    rh.rh_sec = tv->tv_sec;
+    rh.rh_usec = tv->tv_usec;
+    rh.rh_len = sm->sm_len;
+    iov[0].iov_base = &rh;
+    iov[0].iov_len = sizeof(rh);
+    iov[1].iov_base = sm->sm_buf;
+    iov[1].iov_len = sm->sm_len;
+    if (writev(fd, iov, 2) != (ssize_t)(sizeof(rh) + sm->sm_len)){
+        clixon_err(OE_UNIX, errno, "writev");
+        return -1;
+    }
+    return 0;
+}
+
+/*! Append replay record to ring and replay file, apply size retention
+ *
+ * @param[in] es    Stream
+ * @param[in] tv    Timestamp
+ * @param[in] sm    Serialized event, reference is taken over
+ * @param[in] save  Write to replay file, if open
+ * @retval    0     OK
+ * @retval   -1     Error
+ */
+static int
+stream_replay_append(event_stream_t *es,
+                     struct timeval *tv,
+                     stream_msg     *sm,
+                     int             save)
+{
+    int                   retval = -1;
+    struct stream_replay *ring;
+    struct stream_replay *r;
+    int                   max;
+    int                   i;
+
+    if (es->es_replay_len == es->es_replay_max){
+        max = es->es_replay_max ? 2*es->es_replay_max : STREAM_REPLAY_INIT;
+        if ((ring = calloc(max, sizeof(*ring))) == NULL){
+            clixon_err(OE_UNIX, errno, "calloc");
+            stream_msg_free(sm);
+            goto done;
+        }
+        for (i=0; i<es->es_replay_len; i++)
+            ring[i] = *stream_replay_ix(es, i);
+        if (es->es_replay)
+            free(es->es_replay);
+        es->es_replay = ring;
+        es->es_replay_max = max;
+        es->es_replay_head = 0;
+    }
+    r = &es->es_replay[(es->es_replay_head + es->es_replay_len) % es->es_replay_max];
+    r->r_tv = *tv;
+    r->r_msg = sm;
+    es->es_replay_len++;
+    es->es_replay_size += sm->sm_len;
+    if (save && es->es_replay_fd != -1){
+        if (stream_replay_write(es->es_replay_fd, tv, sm) < 0)
+            goto done;
+        es->es_replay_fsize += sizeof(struct stream_replay_hdr) + sm->sm_len;
+    }
+    while (es->es_retention_size && es->es_replay_len > 1 &&
+           es->es_replay_size > es->es_retention_size)
+        stream_replay_pop(es);
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Open replay file of stream and load records into replay ring
+ *
+ * A truncated record at the end, eg after a crash, is removed.
+ * @param[in] es    Stream
+ * @param[in] file  Replay file
+ * @retval    0     OK
+ * @retval   -1     Error
+ */
+static int
+stream_replay_load(event_stream_t *es,
+                   const char     *file)
+{
+    int                      retval = -1;
+    struct stat              st;
+    char                    *p = MAP_FAILED;
+    size_t                   off = 0;
+    struct stream_replay_hdr rh;
+    struct timeval           tv;
+    stream_msg              *sm;
+
+    if ((es->es_replay_file = strdup(file)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    if ((es->es_replay_fd = open(file, O_RDWR|O_CREAT|O_CLOEXEC, 0600)) < 0){
+        clixon_err(OE_UNIX, errno, "open(%s)", file);
+        goto done;
+    }
+    if (fstat(es->es_replay_fd, &st) < 0){
+        clixon_err(OE_UNIX, errno, "fstat(%s)", file);
+        goto done;
+    }
+    if (st.st_size > 0){
+        if ((p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, es->es_replay_fd, 0)) == MAP_FAILED){
+            clixon_err(OE_UNIX, errno, "mmap(%s)", file);
+            goto done;
+        }
+        while (off + sizeof(rh) <= (size_t)st.st_size){
+            memcpy(&rh, p + off, sizeof(rh));
+            if (rh.rh_len == 0 || off + sizeof(rh) + rh.rh_len > (size_t)st.st_size)
+                break;
+            if ((sm = malloc(sizeof(*sm))) == NULL){
+                clixon_err(OE_UNIX, errno, "malloc");
+                goto done;
+            }
+            memset(sm, 0, sizeof(*sm));
+            if ((sm->sm_buf = malloc(rh.rh_len)) == NULL){
+                clixon_err(OE_UNIX, errno, "malloc");
+                free(sm);
+                goto done;
+            }
+            memcpy(sm->sm_buf, p + off + sizeof(rh), rh.rh_len);
+            sm->sm_len = rh.rh_len;
+            sm->sm_refcnt = 1;
+            clixon_mem_charge(CLIXON_MEM_TAG_NOTIFY, sizeof(*sm) + sm->sm_len);
+            tv.tv_sec = rh.rh_sec;
+            tv.tv_usec = rh.rh_usec;
+            if (stream_replay_append(es, &tv, sm, 0) < 0)
+                goto done;
+            off += sizeof(rh) + rh.rh_len;
+        }
+        if (off < (size_t)st.st_size){
+            clixon_log(NULL, LOG_WARNING, "%s: %s: truncated at %zu", __FUNCTION__, file, off);
+            if (ftruncate(es->es_replay_fd, off) < 0){
+                clixon_err(OE_UNIX, errno, "ftruncate(%s)", file);
+                goto done;
+            }
+        }
+    }
+    if (lseek(es->es_replay_fd, off, SEEK_SET) < 0){
+        clixon_err(OE_UNIX, errno, "lseek(%s)", file);
+        goto done;
+    }
+    es->es_replay_fsize = off;
+    retval = 0;
+ done:
+    if (p != MAP_FAILED)
+        munmap(p, st.st_size);
+    return retval;
+}
+
+/*! Rewrite replay file with the records in the replay ring if records have been dropped
+ *
+ * @param[in] es    Stream
+ * @retval    0     OK
+ * @retval   -1     Error
+ */
+static int
+stream_replay_compact(event_stream_t *es)
+{
+    int                   retval = -1;
+    cbuf                 *cb = NULL;
+    int                   fd = -1;
+    struct stream_replay *r;
+    size_t                fsize = 0;
+    int                   i;
+
+    if (es->es_replay_fd == -1 ||
+        es->es_replay_fsize <= 2*es->es_replay_size + STREAM_REPLAY_COMPACT_MIN)
+        goto ok;
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cb, "%s.tmp", es->es_replay_file);
+    if ((fd = open(cbuf_get(cb), O_WRONLY|O_CREAT|O_TRUNC|O_CLOEXEC, 0600)) < 0){
+        clixon_err(OE_UNIX, errno, "open(%s)", cbuf_get(cb));
+        goto done;
+    }
+    for (i=0; i<es->es_replay_len; i++){
+        r = stream_replay_ix(es, i);
+        if (stream_replay_write(fd, &r->r_tv, r->r_msg) < 0)
+            goto done;
+        fsize += sizeof(struct stream_replay_hdr) + r->r_msg->sm_len;
+    }
+    if (rename(cbuf_get(cb), es->es_replay_file) < 0){
+        clixon_err(OE_UNIX, errno, "rename(%s)", es->es_replay_file);
+        goto done;
+    }
+    close(es->es_replay_fd);
+    es->es_replay_fd = fd;
+    es->es_replay_fsize = fsize;
+    fd = -1;
+ ok:
+    retval = 0;
+ done:
+    if (fd != -1){
+        close(fd);
+        unlink(cbuf_get(cb));
+    }
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Get filter of stream with same canonical xpath, or create a new
+ *
+ * @param[in]  es     Stream
+ * @param[in]  xpath  Filter as xpath
+ * @param[out] sfp    Filter with a new reference
+ * @retval     0      OK
+ * @retval    -1      Error, eg xpath parse error
+ */
+static int
+stream_filter_get(event_stream_t        *es,
+                  const char            *xpath,
+                  struct stream_filter **sfp)
+{
+    int                   retval = -1;
+    xpath_tree           *xptree = NULL;
+    cbuf                 *cb = NULL;
+    struct stream_filter *sf;
+
+    if (xpath_parse(xpath, &xptree) < 0)
+        goto done;
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if (xpath_tree2cbuf(xptree, cb) < 0)
+        goto done;
+    for (sf = es->es_filter; sf; sf = sf->sf_next)
+        if (strcmp(sf->sf_xpath, cbuf_get(cb)) == 0)
+            break;
+    if (sf == NULL){
+        if ((sf = malloc(sizeof(*sf))) == NULL){
+            clixon_err(OE_UNIX, errno, "malloc");
+            goto done;
+        }
+        memset(sf, 0, sizeof(*sf));
+        if ((sf->sf_xpath = strdup(cbuf_get(cb))) == NULL){
+            clixon_err(OE_UNIX, errno, "strdup");
+            free(sf);
+            goto done;
+        }
+        sf->sf_xptree = xptree;
+        xptree = NULL;
+        sf->sf_next = es->es_filter;
+        es->es_filter = sf;
+    }
+    sf->sf_refcnt++;
+    *sfp = sf;
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    if (xptree)
+        xpath_tree_free(xptree);
+    return retval;
+}
+
+/*! Free filter
+ */
+static void
+stream_filter_free(struct stream_filter *sf)
+{
+    if (sf->sf_xpath)
+        free(sf->sf_xpath);
+    if (sf->sf_xptree)
+        xpath_tree_free(sf->sf_xptree);
+    free(sf);
+}
+
+/*! Release a reference of a stream filter, remove it if last
+ *
+ * @param[in]  es   Stream
+ * @param[in]  sf   Filter
+ */
+static void
+stream_filter_release(event_stream_t       *es,
+                      struct stream_filter *sf)
+{
+    struct stream_filter **sfp;
+
+    if (--sf->sf_refcnt > 0)
+        return;
+    for (sfp = &es->es_filter; *sfp; sfp = &(*sfp)->sf_next)
+        if (*sfp == sf){
+            *sfp = sf->sf_next;
+            break;
+        }
+    stream_filter_free(sf);
+}
+
+/*! Evaluate filter on event, only the first time for each event
+ *
+ * @param[in]  sf      Filter
+ * @param[in]  xevent  Notification as xml tree
+ * @param[in]  seq     Event sequence number
+ * @retval     1       Match
+ * @retval     0       No match, or error as xpath_first
+ */
+static int
+stream_filter_match(struct stream_filter *sf,
+                    cxobj                *xevent,
+                    uint64_t              seq)
+{
+    xp_ctx *xr = NULL;
+
+    if (sf->sf_seq != seq){
+        sf->sf_seq = seq;
+        sf->sf_match = 0;
+        if (xpath_tree_vec_ctx(xevent, NULL, sf->sf_xptree, 0, &xr) == 0 &&
+            xr && xr->xc_type == XT_NODESET && xr->xc_size)
+            sf->sf_match = 1;
+        if (xr)
+            ctx_free(xr);
+    }
+    return sf->sf_match;
+}
+
 /*! Delete event stream core components 
  *
  * @param[in]     es   Event notification stream structure
@@ -122,6 +508,20 @@ stream_find(clixon_handle h,
 static int
 stream_delete(event_stream_t *es)
 {
+    struct stream_filter *sf;
+
+    while ((sf = es->es_filter) != NULL){
+        es->es_filter = sf->sf_next;
+        stream_filter_free(sf);
+    }
+    while (es->es_replay_len > 0)
+        stream_replay_pop(es);
+    if (es->es_replay)
+        free(es->es_replay);
+    if (es->es_replay_fd != -1)
+        close(es->es_replay_fd);
+    if (es->es_replay_file)
+        free(es->es_replay_file);
     if (es->es_name)
         free(es->es_name);
     if (es->es_description)
@@ -149,6 +549,8 @@ stream_add(clixon_handle   h,
 {
     int             retval = -1;
     event_stream_t *es = NULL;
+    char           *dir;
+    cbuf           *cb = NULL;
 
     if ((es = stream_find(h, name)) != NULL)
         goto ok;
@@ -157,6 +559,7 @@ stream_add(clixon_handle   h,
         goto done;
     }
     memset(es, 0, sizeof(event_stream_t));
+    es->es_replay_fd = -1;
     if ((es->es_name = strdup(name)) == NULL){
         clixon_err(OE_XML, errno, "strdup");
         goto done;
@@ -168,11 +571,25 @@ stream_add(clixon_handle   h,
     es->es_replay_enabled = replay_enabled;
     if (retention)
         es->es_retention = *retention;
+    if (replay_enabled){
+        es->es_retention_size = clicon_option_int(h, "CLICON_STREAM_RETENTION_SIZE");
+        if ((dir = clicon_option_str(h, "CLICON_STREAM_REPLAY_DIR")) != NULL){
+            if ((cb = cbuf_new()) == NULL){
+                clixon_err(OE_UNIX, errno, "cbuf_new");
+                goto done;
+            }
+            cprintf(cb, "%s/%s.replay", dir, name);
+            if (stream_replay_load(es, cbuf_get(cb)) < 0)
+                goto done;
+        }
+    }
     clicon_stream_append(h, es);
     es = NULL;
  ok:
     retval = 0;
  done:
+    if (cb)
+        cbuf_free(cb);
     if (es)
         stream_delete(es);
     return retval;
@@ -189,7 +606,6 @@ stream_delete_all(clixon_handle h,
                   int           force)
 {
     int                   retval = -1;
-    struct stream_replay *r;
     struct stream_subscription *ss;
     event_stream_t       *es;
     event_stream_t       *head = clicon_stream(h);
@@ -201,12 +617,6 @@ stream_delete_all(clixon_handle h,
             if (stream_ss_rm(h, es, ss, force) < 0)
                 goto done;
         }
-        while ((r = es->es_replay) != NULL){
-            DELQ(r, es->es_replay, struct stream_replay *);
-            if (r->r_xml)
-                xml_free(r->r_xml);
-            free(r);
-        }
         if (stream_delete(es) < 0)
             goto done;
     }
@@ -279,8 +689,6 @@ stream_timer_setup(int   fd,
     event_stream_t              *es;
     struct stream_subscription  *ss;
     struct stream_subscription  *ss1;
-    struct stream_replay        *r;
-    struct stream_replay        *r1;
 
     clixon_debug(CLIXON_DBG_STREAM|CLIXON_DBG_DETAIL, "");
     /* Go thru callbacks and see if any have timed out, if so remove them 
@@ -308,22 +716,15 @@ stream_timer_setup(int   fd,
                         ss = NEXTQ(struct stream_subscription *, ss);
                 } while (ss && ss != es->es_subscription);
   /* 2) Go throughreplay buffer and remove entries with passed retention time */
-            if (timerisset(&es->es_retention) &&
-                (r = es->es_replay) != NULL){
+            if (timerisset(&es->es_retention)){
                 timersub(&now, &es->es_retention, &tret);
-                do {
-                    if (timercmp(&r->r_tv, &tret, <)){
-                        r1 = NEXTQ(struct stream_replay *, r);
-                        DELQ(r, es->es_replay, struct stream_replay *);
-                        if (r->r_xml)
-                            xml_free(r->r_xml);
-                        free(r);
-                        r = r1;
-                    }
-                    else
-                        r = NEXTQ(struct stream_replay *, r);
-                } while (r && r!=es->es_replay);
+                /* Records are ordered by time, oldest first */
+                while (es->es_replay_len > 0 &&
+                       timercmp(&stream_replay_ix(es, 0)->r_tv, &tret, <))
+                    stream_replay_pop(es);
             }
+            if (stream_replay_compact(es) < 0)
+                goto done;
             es = NEXTQ(struct event_stream *, es);
         } while (es && es != clicon_stream(h));
     }
@@ -385,13 +786,22 @@ stream_ss_add(clixon_handle     h,
         clixon_err(OE_CFG, errno, "strdup");
         goto done;
     }
+    /* Compile filter once, shared with other subscriptions with same filter */
+    if (xpath && strlen(xpath) &&
+        stream_filter_get(es, xpath, &ss->ss_filter) < 0)
+        goto done;
     ss->ss_fn     = fn;
     ss->ss_arg    = arg;
     ADDQ(ss, es->es_subscription);
     return ss;
   done:
-    if (ss)
+    if (ss){
+        if (ss->ss_stream)
+            free(ss->ss_stream);
+        if (ss->ss_xpath)
+            free(ss->ss_xpath);
         free(ss);
+    }
     return NULL;
 }
 
@@ -419,6 +829,8 @@ stream_ss_rm(clixon_handle                h,
             free(ss->ss_stream);
         if (ss->ss_xpath)
             free(ss->ss_xpath);
+        if (ss->ss_filter)
+            stream_filter_release(es, ss->ss_filter);
         free(ss);
     }
     clixon_debug(CLIXON_DBG_STREAM, "retval: 0");
@@ -514,12 +926,137 @@ stream_ss_delete(clixon_handle     h,
     return retval;
 }
 
+/*! Get serialized notification message of an event, with a new reference
+ *
+ * If called by subscription callbacks while the event is distributed by stream_notify, the
+ * event is only serialized once and the message is shared by all callbacks.
+ * @param[in]  xevent  Notification as xml tree
+ * @retval     sm      Message, release with stream_msg_free
+ * @retval     NULL    Error
+ * @code
+ *   stream_msg *sm;
+ *   if ((sm = stream_msg_get(xevent)) == NULL)
+ *      err;
+ *   write(s, sm->sm_buf, sm->sm_len);
+ *   stream_msg_free(sm);
+ * @endcode
+ */
+stream_msg *
+stream_msg_get(cxobj *xevent)
+{
+    stream_msg *sm = NULL;
+    cbuf       *cb = NULL;
+    size_t      len;
+
+    if (xevent == _stream_xevent && _stream_msg != NULL){
+        _stream_msg->sm_refcnt++;
+        return _stream_msg;
+    }
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if (clixon_xml2cbuf(cb, xevent, 0, 0, NULL, -1, 0) < 0)
+        goto done;
+    if ((sm = malloc(sizeof(*sm))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    memset(sm, 0, sizeof(*sm));
+    len = cbuf_len(cb);
+    /* Chunk header, data and end-of-chunks */
+    if ((sm->sm_buf = malloc(len + 32)) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        free(sm);
+        sm = NULL;
+        goto done;
+    }
+    sm->sm_len = snprintf(sm->sm_buf, 32, "\n#%zu\n", len);
+    memcpy(sm->sm_buf + sm->sm_len, cbuf_get(cb), len);
+    sm->sm_len += len;
+    memcpy(sm->sm_buf + sm->sm_len, "\n##\n", 4);
+    sm->sm_len += 4;
+    sm->sm_refcnt = 1;
+    clixon_mem_charge(CLIXON_MEM_TAG_NOTIFY, sizeof(*sm) + sm->sm_len);
+    if (xevent == _stream_xevent){ /* Keep a reference for other subscribers */
+        sm->sm_refcnt++;
+        _stream_msg = sm;
+    }
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return sm;
+}
+
+/*! Release a reference of a notification message, free it if last
+ *
+ * @param[in]  sm   Message
+ * @retval     0    OK
+ * @see stream_msg_get
+ */
+int
+stream_msg_free(stream_msg *sm)
+{
+    if (--sm->sm_refcnt > 0)
+        return 0;
+    clixon_mem_charge(CLIXON_MEM_TAG_NOTIFY, -(int64_t)(sizeof(*sm) + sm->sm_len));
+    if (sm->sm_buf)
+        free(sm->sm_buf);
+    free(sm);
+    return 0;
+}
+
+/*! Parse serialized notification message to xml
+ *
+ * @param[in]  sm   Message
+ * @param[out] xp   Notification as xml tree, free with xml_free
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+stream_msg_xml(stream_msg *sm,
+               cxobj     **xp)
+{
+    int    retval = -1;
+    char  *p;
+    char  *str = NULL;
+    size_t len;
+    cxobj *xt = NULL;
+
+    /* Skip chunk header and end-of-chunks */
+    if (sm->sm_len < 8 ||
+        (p = memchr(sm->sm_buf + 2, '\n', sm->sm_len - 2)) == NULL){
+        clixon_err(OE_XML, EINVAL, "Malformed notification message");
+        goto done;
+    }
+    p++;
+    len = sm->sm_len - (p - sm->sm_buf) - 4;
+    if ((str = strndup(p, len)) == NULL){
+        clixon_err(OE_UNIX, errno, "strndup");
+        goto done;
+    }
+    if (clixon_xml_parse_string(str, YB_NONE, NULL, &xt, NULL) < 0)
+        goto done;
+    if (xml_rootchild(xt, 0, &xt) < 0)
+        goto done;
+    *xp = xt;
+    xt = NULL;
+    retval = 0;
+ done:
+    if (xt)
+        xml_free(xt);
+    if (str)
+        free(str);
+    return retval;
+}
+
 /*! Stream notify event and distribute to all registered callbacks
  *
  * @param[in]  h       Clixon handle
  * @param[in]  stream  Name of event stream. CLICON is predefined as LOG stream
  * @param[in]  tv      Timestamp. Dont notify if subscription has stoptime<tv
  * @param[in]  event   Notification as xml tree
+ * @param[out] smp     If given, serialized event if serialized by a callback, or NULL
  * @retval     0       OK
  * @retval    -1       Error
  * @see stream_notify
@@ -529,12 +1066,23 @@ static int
 stream_notify1(clixon_handle   h,
                event_stream_t *es,
                struct timeval *tv,
-               cxobj          *xevent)
+               cxobj          *xevent,
+               stream_msg    **smp)
 {
     int                         retval = -1;
     struct stream_subscription *ss;
+    cxobj                      *xevent0;
+    stream_msg                 *sm0;
+    uint64_t                    seq;
 
     clixon_debug(CLIXON_DBG_STREAM, "");
+    /* Each filter is evaluated once for this event */
+    seq = ++_stream_event_seq;
+    /* Callbacks may notify other events, save and restore */
+    xevent0 = _stream_xevent;
+    sm0 = _stream_msg;
+    _stream_xevent = xevent;
+    _stream_msg = NULL;
     /* Go thru all subscriptions and find matches */
     if ((ss = es->es_subscription) != NULL)
         do {
@@ -548,9 +1096,8 @@ stream_notify1(clixon_handle   h,
                 ss = ss1;
             }
             else{  /* xpath match */
-                if (ss->ss_xpath == NULL ||
-                    strlen(ss->ss_xpath)==0 ||
-                    xpath_first(xevent, NULL, "%s", ss->ss_xpath) != NULL)
+                if (ss->ss_filter == NULL ||
+                    stream_filter_match(ss->ss_filter, xevent, seq))
                     if ((*ss->ss_fn)(h, 0, xevent, ss->ss_arg) < 0)
                         goto done;
                 ss = NEXTQ(struct stream_subscription *, ss);
@@ -558,6 +1105,14 @@ stream_notify1(clixon_handle   h,
         } while (es->es_subscription && ss != es->es_subscription);
     retval = 0;
   done:
+    if (_stream_msg){
+        if (retval == 0 && smp)
+            *smp = _stream_msg;
+        else
+            stream_msg_free(_stream_msg);
+    }
+    _stream_xevent = xevent0;
+    _stream_msg = sm0;
     return retval;
 }
 
@@ -589,6 +1144,7 @@ stream_notify(clixon_handle h,
     char            timestr[28];
     struct timeval  tv;
     event_stream_t *es;
+    stream_msg     *sm = NULL;
 
     clixon_debug(CLIXON_DBG_STREAM, "");
     if ((es = stream_find(h, stream)) == NULL)
@@ -624,13 +1180,17 @@ stream_notify(clixon_handle h,
         goto done;
     if (xml_rootchild(xev, 0, &xev) < 0)
         goto done;
-    if (stream_notify1(h, es, &tv, xev) < 0)
+    if (stream_notify1(h, es, &tv, xev, &sm) < 0)
         goto done;
     if (es->es_replay_enabled){
-        if (stream_replay_add(es, &tv, xev) < 0)
+        /* Replay record shares the serialized event of the notification */
+        if (sm == NULL && (sm = stream_msg_get(xev)) == NULL)
+            goto done;
+        if (stream_replay_append(es, &tv, sm, 1) < 0)
             goto done;
-        xev = NULL; /* xml stored in replay_add and should not be freed */
     }
+    else if (sm)
+        stream_msg_free(sm);
  ok:
     retval = 0;
   done:
@@ -666,6 +1226,7 @@ stream_notify_xml(clixon_handle h,
     char       timestr[28];
     struct timeval tv;
     event_stream_t *es;
+    stream_msg     *sm = NULL;
 
     clixon_debug(CLIXON_DBG_STREAM, "");
     if ((es = stream_find(h, stream)) == NULL)
@@ -694,13 +1255,17 @@ stream_notify_xml(clixon_handle h,
         goto done;
     if (xml_addsub(xev, xml2) < 0)
         goto done;
-    if (stream_notify1(h, es, &tv, xev) < 0)
+    if (stream_notify1(h, es, &tv, xev, &sm) < 0)
         goto done;
     if (es->es_replay_enabled){
-        if (stream_replay_add(es, &tv, xev) < 0)
+        /* Replay record shares the serialized event of the notification */
+        if (sm == NULL && (sm = stream_msg_get(xev)) == NULL)
+            goto done;
+        if (stream_replay_append(es, &tv, sm, 1) < 0)
             goto done;
-        xev = NULL; /* xml stored in replay_add and should not be freed */
     }
+    else if (sm)
+        stream_msg_free(sm);
  ok:
     retval = 0;
   done:
@@ -747,32 +1312,56 @@ stream_replay_notify(clixon_handle               h,
 {
     int                   retval = -1;
     struct stream_replay *r;
+    stream_msg           *sm;
+    cxobj                *xr = NULL;
+    cxobj                *xevent0;
+    stream_msg           *sm0;
+    int                   lo;
+    int                   hi;
+    int                   i;
+    int                   ret;
 
     /* If <startTime> is not present, this is not a replay */
     if (!timerisset(&ss->ss_starttime))
         goto ok;
     if (!es->es_replay_enabled)
         goto ok;
-    /* Get replay linked list */
-    if ((r = es->es_replay) == NULL)
-        goto ok;
-    /* First loop to skip until start */
-    do {
-        if (timercmp(&r->r_tv, &ss->ss_starttime, >=))
-            break;
-        r = NEXTQ(struct stream_replay *, r);
-    } while (r && r!=es->es_replay);
-    if (r == NULL)
-        goto ok; /* No samples to replay */
+    /* Binary search for first record not before start */
+    lo = 0;
+    hi = es->es_replay_len;
+    while (lo < hi){
+        i = (lo + hi)/2;
+        if (timercmp(&stream_replay_ix(es, i)->r_tv, &ss->ss_starttime, <))
+            lo = i + 1;
+        else
+            hi = i;
+    }
     /* Then notify until stop */
-    do {
+    for (i = lo; i < es->es_replay_len; i++){
+        r = stream_replay_ix(es, i);
         if (timerisset(&ss->ss_stoptime) &&
             timercmp(&r->r_tv, &ss->ss_stoptime, >))
             break;
-        if ((*ss->ss_fn)(h, 0, r->r_xml, ss->ss_arg) < 0)
+        sm = r->r_msg;
+        sm->sm_refcnt++;
+        if (stream_msg_xml(sm, &xr) < 0){
+            stream_msg_free(sm);
             goto done;
-        r = NEXTQ(struct stream_replay *, r);
-    } while (r && r!=es->es_replay);
+        }
+        /* Callback gets the stored message with stream_msg_get */
+        xevent0 = _stream_xevent;
+        sm0 = _stream_msg;
+        _stream_xevent = xr;
+        _stream_msg = sm;
+        ret = (*ss->ss_fn)(h, 0, xr, ss->ss_arg);
+        _stream_xevent = xevent0;
+        _stream_msg = sm0;
+        stream_msg_free(sm);
+        xml_free(xr);
+        xr = NULL;
+        if (ret < 0)
+            goto done;
+    }
  ok:
     retval = 0;
  done:
@@ -783,7 +1372,7 @@ stream_replay_notify(clixon_handle               h,
  *
  * @param[in] es   Stream
  * @param[in] tv   Timestamp
- * @param[in] xv   XML
+ * @param[in] xv   XML, is consumed
  * @retval    0    OK
  * @retval   -1    Error
  */
@@ -792,19 +1381,16 @@ stream_replay_add(event_stream_t *es,
                   struct timeval *tv,
                   cxobj          *xv)
 {
-    int                   retval = -1;
-    struct stream_replay *new;
+    int         retval = -1;
+    stream_msg *sm;
 
-    if ((new = malloc(sizeof *new)) == NULL){
-        clixon_err(OE_UNIX, errno, "malloc");
+    if ((sm = stream_msg_get(xv)) == NULL)
+        goto done;
+    if (stream_replay_append(es, tv, sm, 1) < 0)
         goto done;
-    }
-    memset(new, 0, (sizeof *new));
-    new->r_tv = *tv;
-    new->r_xml = xv;
-    ADDQ(new, es->es_replay);
     retval = 0;
  done:
+    xml_free(xv);
     return retval;
 }
 
@@ -56,6 +56,24 @@
 #include "clixon_xml.h"
 #include "clixon_err.h"
 
+/* XML chardata characters that need encoding, without and with attribute quotes
+ * @see xml_chardata_encode
+ */
+#define XML_CHARDATA_NOQUOTE "&<>"
+#define XML_CHARDATA_QUOTE   "&<>'\""
+
+/* Size classes of pooled cbufs by allocated length, and max pooled cbufs per class
+ * Larger cbufs are freed when released
+ * The pool is thread-local since the library may be called from several threads, eg
+ * by clients of the client API
+ * @see clixon_cbuf_borrow
+ */
+#define CBUF_POOL_CLASSES 3
+#define CBUF_POOL_SLOTS   16
+static const size_t        _cbuf_pool_size[CBUF_POOL_CLASSES] = {1024, 16384, 262144};
+static _Thread_local cbuf *_cbuf_pool[CBUF_POOL_CLASSES][CBUF_POOL_SLOTS];
+static _Thread_local int   _cbuf_pool_len[CBUF_POOL_CLASSES] = {0,};
+
 /*! Split string into a vector based on character delimiters. Using malloc
  *
  * The given string is split into a vector where the delimiter can be
@@ -308,28 +326,91 @@ clixon_strsplit(char     *string,
     return retval;
 }
 
-static int
-uri_unreserved(unsigned char in)
+/* Unreserved characters of RFC 3986: ALPHA / DIGIT / "-" / "." / "_" / "~"
+ * @see uri_percent_encode
+ */
+static const uint8_t _uri_unreserved[256] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 0,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0,
+    0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 1,
+    0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 1, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+};
+
+/* Value of hex digits, 0xff if not hex digit
+ * @see uri_percent_decode
+ */
+static const uint8_t _uri_hexval[256] = {
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+};
+
+/*! Percent-encode string into buffer, the buffer must have uri_percent_len() bytes
+ *
+ * @param[in]   str    Not-encoded string
+ * @param[out]  enc    Encoded string, NULL-terminated
+ * @retval      len    Length of encoded string
+ */
+static size_t
+uri_percent_encode1(const char *str,
+                    char       *enc)
 {
-    switch(in) {
-    case '0': case '1': case '2': case '3': case '4':
-    case '5': case '6': case '7': case '8': case '9':
-    case 'a': case 'b': case 'c': case 'd': case 'e':
-    case 'f': case 'g': case 'h': case 'i': case 'j':
-    case 'k': case 'l': case 'm': case 'n': case 'o':
-    case 'p': case 'q': case 'r': case 's': case 't':
-    case 'u': case 'v': case 'w': case 'x': case 'y': case 'z':
-    case 'A': case 'B': case 'C': case 'D': case 'E':
-    case 'F': case 'G': case 'H': case 'I': case 'J':
-    case 'K': case 'L': case 'M': case 'N': case 'O':
-    case 'P': case 'Q': case 'R': case 'S': case 'T':
-    case 'U': case 'V': case 'W': case 'X': case 'Y': case 'Z':
-    case '-': case '.': case '_': case '~':
-        return 1;
-    default:
-        break;
+    const char          *hex = "0123456789ABCDEF";
+    const unsigned char *u;
+    char                *e = enc;
+
+    for (u = (const unsigned char *)str; *u; u++){
+        if (_uri_unreserved[*u])
+            *e++ = *u;
+        else{
+            *e++ = '%';
+            *e++ = hex[*u >> 4];
+            *e++ = hex[*u & 0xf];
+        }
     }
-    return 0;
+    *e = '\0';
+    return e - enc;
+}
+
+/*! Length of percent-encoded string including NULL termination
+ *
+ * @param[in]   str    Not-encoded string
+ * @retval      len    Length of encoded string + 1
+ */
+static size_t
+uri_percent_len(const char *str)
+{
+    const unsigned char *u;
+    size_t               len = 1;
+
+    for (u = (const unsigned char *)str; *u; u++)
+        len += _uri_unreserved[*u] ? 1 : 3;
+    return len;
 }
 
 /*! Percent encoding according to RFC 3986 URI Syntax
@@ -354,55 +435,113 @@ int
 uri_percent_encode(char **encp,
                    const char *fmt, ...)
 {
-    int     retval = -1;
-    char   *str = NULL;  /* Expanded format string w stdarg */
-    char   *enc = NULL;
-    int     fmtlen;
-    size_t  len;
-    int     i, j;
-    va_list args;
+    int         retval = -1;
+    char       *str0 = NULL;  /* Expanded format string w stdarg */
+    const char *str;
+    char       *enc = NULL;
+    int         fmtlen;
+    va_list     args;
 
-    /* Two steps: (1) read in the complete format string */
-    va_start(args, fmt); /* dryrun */
-    fmtlen = vsnprintf(NULL, 0, fmt, args) + 1;
-    va_end(args);
-    if ((str = malloc(fmtlen)) == NULL){
-        clixon_err(OE_UNIX, errno, "malloc");
-        goto done;
+    str = NULL;
+    if (strcmp(fmt, "%s") == 0){ /* Common case, no format expansion */
+        va_start(args, fmt);
+        str = va_arg(args, const char *);
+        va_end(args);
     }
-    memset(str, 0, fmtlen);
-    va_start(args, fmt); /* real */
-    fmtlen = vsnprintf(str, fmtlen, fmt, args) + 1;
-    va_end(args);
-    /* Now str is the combined fmt + ...
-     * Step (2) encode and expand str --> enc
-     * This is max */
-    len = strlen(str)*3+1;
-    if ((enc = malloc(len)) == NULL){
+    if (str == NULL){
+        /* Two steps: (1) read in the complete format string */
+        va_start(args, fmt); /* dryrun */
+        fmtlen = vsnprintf(NULL, 0, fmt, args) + 1;
+        va_end(args);
+        if ((str0 = malloc(fmtlen)) == NULL){
+            clixon_err(OE_UNIX, errno, "malloc");
+            goto done;
+        }
+        va_start(args, fmt); /* real */
+        vsnprintf(str0, fmtlen, fmt, args);
+        va_end(args);
+        str = str0;
+    }
+    /* Step (2) encode str --> enc with exact length */
+    if ((enc = malloc(uri_percent_len(str))) == NULL){
         clixon_err(OE_UNIX, errno, "malloc");
         goto done;
     }
-    memset(enc, 0, len);
-    len = strlen(str);
-    j = 0;
-    for (i=0; i<len; i++){
-        if (uri_unreserved(str[i]))
-            enc[j++] = str[i];
-        else{
-            snprintf(&enc[j], 4, "%%%02X", str[i]&0xff);
-            j += 3;
-        }
-    }
+    uri_percent_encode1(str, enc);
     *encp = enc;
     retval = 0;
  done:
-    if (str)
-        free(str);
-    if (retval < 0 && enc)
-        free(enc);
+    if (str0)
+        free(str0);
     return retval;
 }
 
+/*! Percent-encode and append string to cbuf
+ *
+ * Same as uri_percent_encode but without intermediate allocation
+ * @param[in]   cb     CLIgen buffer
+ * @param[in]   str    Not-encoded string
+ * @retval      0      OK
+ * @retval     -1      Error
+ * @see uri_percent_encode
+ */
+int
+uri_percent_cbuf_append(cbuf       *cb,
+                        const char *str)
+{
+    const unsigned char *u;
+    const unsigned char *u0;
+    const char          *hex = "0123456789ABCDEF";
+    char                 esc[3];
+
+    u0 = (const unsigned char *)str;
+    for (u = u0; *u; u++){
+        if (_uri_unreserved[*u])
+            continue;
+        /* Append unreserved run, then escape */
+        if (u > u0 && cbuf_append_buf(cb, (void*)u0, u - u0) < 0)
+            goto err;
+        esc[0] = '%';
+        esc[1] = hex[*u >> 4];
+        esc[2] = hex[*u & 0xf];
+        if (cbuf_append_buf(cb, esc, 3) < 0)
+            goto err;
+        u0 = u + 1;
+    }
+    if (u > u0 && cbuf_append_buf(cb, (void*)u0, u - u0) < 0)
+        goto err;
+    return 0;
+ err:
+    clixon_err(OE_UNIX, errno, "cbuf_append_buf");
+    return -1;
+}
+
+/*! Percent decoding in place according to RFC 3986 URI Syntax
+ *
+ * The decoded string is never longer than the encoded
+ * @param[in,out] str  Encoded string, decoded on return
+ * @retval        len  Length of decoded string
+ * @see uri_percent_decode
+ */
+size_t
+uri_percent_decode_inplace(char *str)
+{
+    unsigned char *r = (unsigned char *)str;
+    unsigned char *w = r;
+
+    while (*r){
+        /* If r[1] is NULL, r[2] is not read */
+        if (*r == '%' && _uri_hexval[r[1]] != 0xff && _uri_hexval[r[2]] != 0xff){
+            *w++ = (_uri_hexval[r[1]] << 4) | _uri_hexval[r[2]];
+            r += 3;
+        }
+        else
+            *w++ = *r++;
+    }
+    *w = '\0';
+    return (char*)w - str;
+}
+
 /*! Percent decoding according to RFC 3986 URI Syntax
  *
  * @param[in]   enc    Encoded input string     
@@ -411,6 +550,7 @@ uri_percent_encode(char **encp,
  * @retval     -1      Error
  * @see RFC 3986 Uniform Resource Identifier (URI): Generic Syntax
  * @see uri_percent_encode
+ * @see uri_percent_decode_inplace  Without allocation
  */
 int
 uri_percent_decode(char  *enc,
@@ -418,44 +558,147 @@ uri_percent_decode(char  *enc,
 {
     int   retval = -1;
     char *str = NULL;
-    int   i, j;
-    char  hstr[3];
-    size_t len;
-    char *ptr;
 
     if (enc == NULL){
         clixon_err(OE_UNIX, EINVAL, "enc is NULL");
         goto done;
     }
-    /* This is max */
-    len = strlen(enc)+1;
-    if ((str = malloc(len)) == NULL){
+    if ((str = strdup(enc)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    uri_percent_decode_inplace(str);
+    *strp = str;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Base64 encoding according to RFC 4648
+ *
+ * @param[in]   str    Not-encoded input string
+ * @param[out]  encp   Encoded malloced output string. Deallocate with free()
+ * @retval      0      OK
+ * @retval     -1      Error
+ * @see base64_decode
+ */
+int
+base64_encode(const char *str,
+              char      **encp)
+{
+    int            retval = -1;
+    const char    *b64 = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    const uint8_t *u = (const uint8_t *)str;
+    char          *enc = NULL;
+    size_t         len;
+    size_t         i;
+    size_t         j;
+    uint32_t       v;
+
+    if (str == NULL){
+        clixon_err(OE_UNIX, EINVAL, "str is NULL");
+        goto done;
+    }
+    len = strlen(str);
+    if ((enc = malloc(4*((len+2)/3)+1)) == NULL){
         clixon_err(OE_UNIX, errno, "malloc");
         goto done;
     }
-    memset(str, 0, len);
+    j = 0;
+    for (i=0; i<len; i+=3){
+        v = u[i] << 16;
+        if (i+1 < len)
+            v |= u[i+1] << 8;
+        if (i+2 < len)
+            v |= u[i+2];
+        enc[j++] = b64[(v >> 18) & 0x3f];
+        enc[j++] = b64[(v >> 12) & 0x3f];
+        enc[j++] = i+1 < len ? b64[(v >> 6) & 0x3f] : '=';
+        enc[j++] = i+2 < len ? b64[v & 0x3f] : '=';
+    }
+    enc[j] = '\0';
+    *encp = enc;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Base64 decoding according to RFC 4648
+ *
+ * @param[in]   enc    Encoded input string
+ * @param[out]  strp   Decoded malloced output string. Deallocate with free()
+ * @retval      1      OK
+ * @retval      0      Invalid encoding
+ * @retval     -1      Error
+ * @see base64_encode
+ */
+int
+base64_decode(const char *enc,
+              char      **strp)
+{
+    int      retval = -1;
+    char    *str = NULL;
+    size_t   len;
+    size_t   i;
+    size_t   j;
+    int      pad = 0;
+    int      d;
+    uint32_t v = 0;
+    char     c;
+
+    if (enc == NULL){
+        clixon_err(OE_UNIX, EINVAL, "enc is NULL");
+        goto done;
+    }
     len = strlen(enc);
+    if (len % 4 != 0)
+        goto fail;
+    if ((str = malloc(3*(len/4)+1)) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
     j = 0;
     for (i=0; i<len; i++){
-        if (enc[i] == '%' && strlen(enc)-i > 2 &&
-            isxdigit(enc[i+1]) && isxdigit(enc[i+2])){
-            hstr[0] = enc[i+1];
-            hstr[1] = enc[i+2];
-            hstr[2] = 0;
-            str[j] = strtoul(hstr, &ptr, 16);
-            i += 2;
+        c = enc[i];
+        if (c >= 'A' && c <= 'Z')
+            d = c - 'A';
+        else if (c >= 'a' && c <= 'z')
+            d = c - 'a' + 26;
+        else if (c >= '0' && c <= '9')
+            d = c - '0' + 52;
+        else if (c == '+')
+            d = 62;
+        else if (c == '/')
+            d = 63;
+        else if (c == '=' && i >= len-2){
+            pad++;
+            d = 0;
         }
         else
-            str[j] = enc[i];
-        j++;
+            goto fail;
+        if (pad && c != '=')
+            goto fail;
+        v = (v << 6) | d;
+        if (i % 4 == 3){
+            str[j++] = (v >> 16) & 0xff;
+            if (pad < 2)
+                str[j++] = (v >> 8) & 0xff;
+            if (pad < 1)
+                str[j++] = v & 0xff;
+            v = 0;
+        }
     }
-    str[j++] = '\0';
+    str[j] = '\0';
     *strp = str;
-    retval = 0;
+    str = NULL;
+    retval = 1;
  done:
-    if (retval < 0 && str)
+    if (str)
         free(str);
     return retval;
+ fail:
+    retval = 0;
+    goto done;
 }
 
 /*! Encode escape characters according to XML definition
@@ -514,10 +757,17 @@ xml_chardata_encode(char      **escp,
     fmtlen = vsnprintf(str, fmtlen, fmt, args) + 1;
     va_end(args);
     /* Now str is the combined fmt + ... 
-     * Step (2) encode and expand str --> enc
+     * Fast path: nothing to encode, return str itself */
+    slen = strlen(str);
+    if (strcspn(str, quote?XML_CHARDATA_QUOTE:XML_CHARDATA_NOQUOTE) == slen){
+        *escp = str;
+        str = NULL;
+        retval = 0;
+        goto done;
+    }
+    /* Step (2) encode and expand str --> enc
      * First compute length (do nothing) */
     len = 0; cdata = 0;
-    slen = strlen(str);
     for (i=0; i<slen; i++){
         if (cdata){
             if (strncmp(&str[i], "]]>", strlen("]]>")) == 0)
@@ -652,58 +902,61 @@ xml_chardata_cbuf_append(cbuf *cb,
                          int   quote,
                          char *str)
 {
-    int    retval = -1;
-    int    i;
-    int    cdata; /* when set, skip encoding */
-    size_t len;
+    int         retval = -1;
+    const char *reject;
+    char       *p;
+    char       *q;
+    size_t      n;
 
-    /* The orignal of this code is in xml_chardata_encode */
-    /* Step: encode and expand str --> enc */
-    /* Same code again, but now actually encode into output buffer */
-    cdata = 0;
-    len = strlen(str);
-    for (i=0; i<len; i++){
-        if (cdata){
-            if (strncmp(&str[i], "]]>", strlen("]]>")) == 0){
-                cdata = 0;
-                cbuf_append(cb, str[i++]);
-                cbuf_append(cb, str[i++]);
+    /* The orignal of this code is in xml_chardata_encode
+     * Runs of characters that need no encoding are located with strcspn, which libc
+     * implements with vector instructions, and appended with one copy */
+    reject = quote?XML_CHARDATA_QUOTE:XML_CHARDATA_NOQUOTE;
+    p = str;
+    while (1){
+        if ((n = strcspn(p, reject)) > 0){
+            if (cbuf_append_buf(cb, p, n) < 0){
+                clixon_err(OE_UNIX, errno, "cbuf_append_buf");
+                goto done;
             }
-            cbuf_append(cb, str[i]);
+            p += n;
         }
-        else
-            switch (str[i]){
-            case '&':
-                cbuf_append_str(cb, "&amp;");
-                break;
-            case '<':
-                if (strncmp(&str[i], "<![CDATA[", strlen("<![CDATA[")) == 0){
-                    cbuf_append(cb, str[i]);
-                    cdata++;
-                    break;
-                }
-                cbuf_append_str(cb, "&lt;");
-                break;
-            case '>':
-                cbuf_append_str(cb, "&gt;");
-                break;
-            case '\'':
-                if (quote)
-                    cbuf_append_str(cb, "&apos;");
-                else
-                    cbuf_append(cb, str[i]);
-                break;
-            case '"':
-                if (quote)
-                    cbuf_append_str(cb, "&quot;");
+        if (*p == '\0')
+            break;
+        switch (*p){
+        case '&':
+            cbuf_append_str(cb, "&amp;");
+            break;
+        case '<':
+            if (strncmp(p, "<![CDATA[", strlen("<![CDATA[")) == 0){
+                /* CDATA is copied verbatim including delimiters, or to end if unterminated */
+                if ((q = strstr(p, "]]>")) != NULL)
+                    n = q + strlen("]]>") - p;
                 else
-                    cbuf_append(cb, str[i]);
-                break;
-            default:
-                cbuf_append(cb, str[i]);
+                    n = strlen(p);
+                if (cbuf_append_buf(cb, p, n) < 0){
+                    clixon_err(OE_UNIX, errno, "cbuf_append_buf");
+                    goto done;
+                }
+                p += n;
+                continue;
             }
+            cbuf_append_str(cb, "&lt;");
+            break;
+        case '>':
+            cbuf_append_str(cb, "&gt;");
+            break;
+        case '\'':
+            cbuf_append_str(cb, "&apos;");
+            break;
+        case '"':
+            cbuf_append_str(cb, "&quot;");
+            break;
+        }
+        p++;
     }
     retval = 0;
+ done:
     return retval;
 }
 
@@ -851,6 +1104,62 @@ xml_chardata_decode(char      **decp,
 }
 
 
+/*! Split next element of a mutable string in place, optionally URI-decode its value
+ * 
+ * Zero-allocation variant of uri_str2cvec: name and value point into the string, which
+ * is modified.
+ * @param[in,out] sp      String, set to next element, NULL after last element
+ * @param[in]     delim1  First delimiter char that delimits between elements
+ * @param[in]     delim2  Second delimiter char for pairs within an element
+ * @param[in]     decode  If set, URI decode value in place
+ * @param[out]    name    Name of element
+ * @param[out]    value   Value of element, NULL if element has no delim2
+ * @retval        1       Element returned
+ * @retval        0       No more elements
+ * @code
+ * char *s = query; // mutable
+ * char *name;
+ * char *val;
+ * while (uri_str_next(&s, '&', '=', 1, &name, &val) == 1)
+ *   ...
+ * @endcode
+ * @see uri_str2cvec
+ */
+int
+uri_str_next(char **sp,
+             char   delim1,
+             char   delim2,
+             int    decode,
+             char **name,
+             char **value)
+{
+    char *s;
+    char *val;
+    char *snext;
+
+    if ((s = *sp) == NULL)
+        return 0;
+    /*
+     * name1=val1;  name2=val2;
+     * ^     ^      ^
+     * |     |      |
+     * s     val    snext
+     */
+    if ((snext = strchr(s, delim1)) != NULL)
+        *(snext++) = '\0';
+    if ((val = strchr(s, delim2)) != NULL){
+        *(val++) = '\0';
+        if (decode)
+            uri_percent_decode_inplace(val);
+        while (isblank(*s))
+            s++;
+    }
+    *sp = snext;
+    *name = s;
+    *value = val;
+    return 1;
+}
+
 /*! Split a string into a cligen variable vector using 1st and 2nd delimiter
  * 
  * (1) Split a string into elements delimited by delim1, 
@@ -873,6 +1182,7 @@ xml_chardata_decode(char      **decp,
  * a&b=       ->  [[a,null][b,""]]  
  * Note difference between empty (CGV_EMPTY) and empty string (CGV_STRING)
  * XXX differentiate between error and null cvec.
+ * @see uri_str_next  Without allocation
  */
 int
 uri_str2cvec(char  *string,
@@ -883,10 +1193,9 @@ uri_str2cvec(char  *string,
 {
     int     retval = -1;
     char   *s;
-    char   *s0 = NULL;;
+    char   *s0 = NULL;
+    char   *name;
     char   *val;     /* value */
-    char   *valu = NULL;    /* unescaped value */
-    char   *snext; /* next element in string */
     cvec   *cvv = NULL;
     cg_var *cv;
 
@@ -899,58 +1208,28 @@ uri_str2cvec(char  *string,
         clixon_err(OE_UNIX, errno, "cvec_new");
         goto err;
     }
-    while (s != NULL) {
-        /*
-         * In the pointer algorithm below:
-         * name1=val1;  name2=val2;
-         * ^     ^      ^
-         * |     |      |
-         * s     val    snext
-         */
-        if ((snext = index(s, delim1)) != NULL)
-            *(snext++) = '\0';
-        if ((val = index(s, delim2)) != NULL){
-            *(val++) = '\0';
-            if (decode){
-                if (uri_percent_decode(val, &valu) < 0)
-                    goto err;
-            }
-            else
-                if ((valu = strdup(val)) == NULL){
-                    clixon_err(OE_UNIX, errno, "strdup");
-                    goto err;
-                }
+    while (uri_str_next(&s, delim1, delim2, decode, &name, &val) == 1){
+        if (val != NULL){
             if ((cv = cvec_add(cvv, CGV_STRING)) == NULL){
                 clixon_err(OE_UNIX, errno, "cvec_add");
                 goto err;
             }
-            while ((strlen(s) > 0) && isblank(*s))
-                s++;
-            cv_name_set(cv, s);
-            cv_string_set(cv, valu);
-            if (valu) {
-                free(valu);
-                valu = NULL;
-            }
+            cv_name_set(cv, name);
+            cv_string_set(cv, val);
         }
-        else{
-            if (strlen(s)){
-                if ((cv = cvec_add(cvv, CGV_EMPTY)) == NULL){
-                    clixon_err(OE_UNIX, errno, "cvec_add");
-                    goto err;
-                }
-                cv_name_set(cv, s);
+        else if (*name != '\0'){
+            if ((cv = cvec_add(cvv, CGV_EMPTY)) == NULL){
+                clixon_err(OE_UNIX, errno, "cvec_add");
+                goto err;
             }
+            cv_name_set(cv, name);
         }
-        s = snext;
     }
     retval = 0;
  done:
     *cvp = cvv;
     if (s0)
         free(s0);
-    if (valu)
-        free(valu);
     return retval;
  err:
     if (cvv){
@@ -1199,6 +1478,120 @@ clixon_str_subst(char *str,
     return retval;
 }
 
+/*! Append n spaces of indentation to a cligen buffer
+ *
+ * Copies from a precomputed string of spaces instead of formatting with "%*s"
+ * @param[in]  cb   Cligen buffer
+ * @param[in]  n    Number of spaces, nothing is appended if n <= 0
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+clixon_cbuf_indent(cbuf *cb,
+                   int   n)
+{
+    static const char spaces[] =
+        "                                                                "
+        "                                                                ";
+    int len;
+
+    while (n > 0){
+        len = n < (int)sizeof(spaces) - 1 ? n : (int)sizeof(spaces) - 1;
+        if (cbuf_append_buf(cb, (void*)spaces, len) < 0){
+            clixon_err(OE_UNIX, errno, "cbuf_append_buf");
+            return -1;
+        }
+        n -= len;
+    }
+    return 0;
+}
+
+/*! Borrow an empty scratch cligen buffer from the cbuf pool
+ *
+ * Use instead of cbuf_new in hot paths for buffers that are local to a call, to avoid an
+ * allocation per call. A pooled buffer of the smallest size class that fits size is
+ * returned, or a new buffer if there is none.
+ * @param[in]  size  Expected length, or 0 if not known
+ * @retval     cb    Empty cligen buffer, release with clixon_cbuf_release
+ * @retval     NULL  Error
+ * @code
+ *   cbuf *cb;
+ *   if ((cb = clixon_cbuf_borrow(0)) == NULL)
+ *      err;
+ *   cprintf(cb, ...);
+ *   clixon_cbuf_release(cb);
+ * @endcode
+ * @note A borrowed buffer must not be kept or returned to a caller
+ * @note The pool is per thread, a buffer must be released by the thread that borrowed it
+ */
+cbuf *
+clixon_cbuf_borrow(size_t size)
+{
+    cbuf *cb;
+    int   i;
+
+    for (i = 0; i < CBUF_POOL_CLASSES; i++){
+        if (size > _cbuf_pool_size[i])
+            continue;
+        if (_cbuf_pool_len[i] > 0)
+            return _cbuf_pool[i][--_cbuf_pool_len[i]];
+    }
+    if (size)
+        cb = cbuf_new_alloc(size);
+    else
+        cb = cbuf_new();
+    if (cb == NULL)
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+    return cb;
+}
+
+/*! Release a cligen buffer borrowed with clixon_cbuf_borrow
+ *
+ * The buffer is reset and kept in the pool, or freed if the pool is full or the buffer
+ * has grown larger than the largest size class
+ * @param[in]  cb    Cligen buffer
+ * @retval     0     OK
+ */
+int
+clixon_cbuf_release(cbuf *cb)
+{
+    size_t len;
+    int    i;
+
+    if (cb == NULL)
+        return 0;
+    len = cbuf_buflen(cb);
+    for (i = 0; i < CBUF_POOL_CLASSES; i++){
+        if (len > _cbuf_pool_size[i])
+            continue;
+        if (_cbuf_pool_len[i] < CBUF_POOL_SLOTS){
+            cbuf_reset(cb);
+            _cbuf_pool[i][_cbuf_pool_len[i]++] = cb;
+            return 0;
+        }
+        break;
+    }
+    cbuf_free(cb);
+    return 0;
+}
+
+/*! Free all pooled cligen buffers of the calling thread
+ *
+ * Call before a thread that has borrowed buffers exits
+ * @retval     0     OK
+ * @see clixon_cbuf_borrow
+ */
+int
+clixon_cbuf_pool_free(void)
+{
+    int i;
+
+    for (i = 0; i < CBUF_POOL_CLASSES; i++)
+        while (_cbuf_pool_len[i] > 0)
+            cbuf_free(_cbuf_pool[i][--_cbuf_pool_len[i]]);
+    return 0;
+}
+
 /*! strndup() for systems without it, such as xBSD
  */
 #ifndef HAVE_STRNDUP
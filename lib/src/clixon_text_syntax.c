@@ -47,6 +47,8 @@
 #include <limits.h>
 #include <stdint.h>
 #include <syslog.h>
+#include <dirent.h>
+#include <sys/types.h>
 
 /* cligen */
 #include <cligen/cligen.h>
@@ -61,6 +63,7 @@
 #include "clixon_err.h"
 #include "clixon_log.h"
 #include "clixon_debug.h"
+#include "clixon_file.h"
 #include "clixon_options.h"
 #include "clixon_netconf_lib.h"
 #include "clixon_xml_io.h"
@@ -70,9 +73,6 @@
 #include "clixon_text_syntax.h"
 #include "clixon_text_syntax_parse.h"
 
-/* Size of json read buffer when reading from file*/
-#define BUFLEN 1024
-
 /* Name of xml top object created by parse functions
  * See also DATASTORE_TOP_SYMBOL which is the clixon datastore top symbol. By default also config
  */
@@ -82,6 +82,30 @@
 /* Forward */
 static int text_diff2cbuf(cbuf *cb, cxobj *x0, cxobj *x1, int level, int skiptop);
 
+/* Current TEXT syntax parser, see CLICON_TEXT_SYNTAX_PARSER */
+static int _text_syntax_parser_mode = XML_PARSER_BISON;
+
+/*! Set TEXT syntax parser
+ *
+ * Cant use option since there is no handle in text syntax parse functions
+ * @param[in]  mode   TEXT syntax parser, see enum xml_parser_mode
+ * @retval     0      OK
+ */
+int
+text_syntax_parser_mode_set(int mode)
+{
+    _text_syntax_parser_mode = mode;
+    return 0;
+}
+
+/*! Get TEXT syntax parser
+ */
+int
+text_syntax_parser_mode_get(void)
+{
+    return _text_syntax_parser_mode;
+}
+
 /*! x is element and has eactly one child which in turn has none 
  *
  * @see child_type in clixon_json.c
@@ -105,173 +129,6 @@ tleaf(cxobj *x)
     return (xml_child_nr_notype(xc, CX_ATTR) == 0);
 }
 
-/*! Translate XML to a "pseudo-code" textual format using a callback - internal function
- *
- * @param[in]     xn       XML object to print
- * @param[in]     fn       Callback to make print function
- * @param[in]     f        File to print to
- * @param[in]     level    Print PRETTYPRINT_INDENT spaces per level in front of each line
- * @param[in]     autocliext How to handle autocli extensions: 0: ignore 1: follow
- * @param[in,out] leafl    Leaflist state for keeping track of when [] ends
- * @param[in,out] leaflname Leaflist state for [] 
- * @retval        0        OK
- * @retval       -1        Error
- * leaflist state:
- * 0: No leaflist
- * 1: In leaflist
- * @see text2cbuf to buffer (slower)
- */
-static int
-text2file(cxobj            *xn,
-          clicon_output_cb *fn,
-          FILE             *f,
-          int               level,
-          int               autocliext,
-          int              *leafl,
-          char            **leaflname)
-
-{
-    int        retval = -1;
-    cxobj     *xc = NULL;
-    int        children=0;
-    int        exist = 0;
-    yang_stmt *yn;
-    char      *value;
-    cg_var    *cvi;
-    cvec      *cvk = NULL; /* vector of index keys */
-    cbuf      *cbb = NULL;
-#ifndef TEXT_SYNTAX_NOPREFIX
-    yang_stmt *yp = NULL;
-    yang_stmt *ymod;
-    yang_stmt *ypmod;
-    char      *prefix = NULL;
-#endif
-    if (xn == NULL || fn == NULL){
-        clixon_err(OE_XML, EINVAL, "xn or fn is NULL");
-        goto done;
-    }
-    if ((yn = xml_spec(xn)) != NULL){
-        if (autocliext){
-            if (yang_extension_value(yn, "hide-show", CLIXON_AUTOCLI_NS, &exist, NULL) < 0)
-                goto done;
-            if (exist)
-                goto ok;
-        }
-#ifndef TEXT_SYNTAX_NOPREFIX
-        /* Find out prefix if needed: topmost or new module a la API-PATH */
-        if (ys_real_module(yn, &ymod) < 0)
-            goto done;
-        if ((yp = yang_parent_get(yn)) != NULL &&
-            yp != ymod){
-            if (ys_real_module(yp, &ypmod) < 0)
-                goto done;
-            if (ypmod != ymod)
-                prefix = yang_argument_get(ymod);
-        }
-        else
-            prefix = yang_argument_get(ymod);
-#endif
-        if (yang_keyword_get(yn) == Y_LIST){
-            if ((cvk = yang_cvec_get(yn)) == NULL){
-                clixon_err(OE_YANG, 0, "No keys");
-                goto done;
-            }
-        }
-    }
-    if (*leafl && yn){
-        if (yang_keyword_get(yn) == Y_LEAF_LIST && strcmp(*leaflname, yang_argument_get(yn)) == 0)
-            ;
-        else{
-            *leafl = 0;
-            *leaflname = NULL;
-            (*fn)(f, "%*s\n", PRETTYPRINT_INDENT*(level), "]");
-        }
-    }
-    xc = NULL;     /* count children (elements and bodies, not attributes) */
-    while ((xc = xml_child_each(xn, xc, -1)) != NULL)
-        if (xml_type(xc) == CX_ELMNT || xml_type(xc) == CX_BODY)
-            children++;
-    if (children == 0){ /* If no children print line */
-        switch (xml_type(xn)){
-        case CX_BODY:{
-            if ((cbb = cbuf_new()) == NULL){
-                clixon_err(OE_UNIX, errno, "cbuf_new");
-                goto done;
-            }
-            value = xml_value(xn);
-            if (index(value, ' ') != NULL)
-                cprintf(cbb, "\"%s\"", value);
-            else
-                cprintf(cbb, "%s", value);
-            if (*leafl)                            /* Skip keyword if leaflist */
-                (*fn)(f, "%*s%s\n", PRETTYPRINT_INDENT*level, "", cbuf_get(cbb));
-            else
-                (*fn)(f, "%s;\n", cbuf_get(cbb));
-            break;
-        }
-        case CX_ELMNT:
-            (*fn)(f, "%*s%s", PRETTYPRINT_INDENT*level, "", xml_name(xn));
-            cvi = NULL;             /* Lists only */
-            while ((cvi = cvec_each(cvk, cvi)) != NULL) {
-                if ((xc = xml_find_type(xn, NULL, cv_string_get(cvi), CX_ELMNT)) != NULL)
-                    (*fn)(f, " %s", xml_body(xc));
-            }
-            (*fn)(f, ";\n");
-            break;
-        default:
-            break;
-        }
-        goto ok;
-    }
-    if (*leafl == 0){
-        (*fn)(f, "%*s", PRETTYPRINT_INDENT*level, "");
-#ifndef TEXT_SYNTAX_NOPREFIX
-        if (prefix)
-            (*fn)(f, "%s:", prefix);
-#endif
-        (*fn)(f, "%s", xml_name(xn));
-    }
-    cvi = NULL;         /* Lists only */
-    while ((cvi = cvec_each(cvk, cvi)) != NULL) {
-        if ((xc = xml_find_type(xn, NULL, cv_string_get(cvi), CX_ELMNT)) != NULL)
-            (*fn)(f, " %s", xml_body(xc));
-    }
-    if (yn && yang_keyword_get(yn) == Y_LEAF_LIST && *leafl){
-        ;
-    }
-    else if (yn && yang_keyword_get(yn) == Y_LEAF_LIST && *leafl == 0){
-        *leafl = 1;
-        *leaflname = yang_argument_get(yn);
-        (*fn)(f, " [\n");
-    }
-    else if (!tleaf(xn))
-        (*fn)(f, " {\n");
-    else
-        (*fn)(f, " ");
-    xc = NULL;
-    while ((xc = xml_child_each(xn, xc, -1)) != NULL){
-        if (xml_type(xc) == CX_ELMNT || xml_type(xc) == CX_BODY){
-            if (yn && yang_key_match(yn, xml_name(xc), NULL))
-                continue; /* Skip keys, already printed */
-            if (text2file(xc, fn, f, level+1, autocliext, leafl, leaflname) < 0)
-                break;
-        }
-    }
-    /* Stop leaf-list printing (ie []) if no longer leaflist and same name */
-    if (yn && yang_keyword_get(yn) != Y_LEAF_LIST && *leafl != 0){
-        *leafl = 0;
-        (*fn)(f, "%*s\n", PRETTYPRINT_INDENT*(level+1), "]");
-    }
-    if (!tleaf(xn))
-        (*fn)(f, "%*s}\n", PRETTYPRINT_INDENT*level, "");
- ok:
-    retval = 0;
- done:
-    if (cbb)
-        cbuf_free(cbb);
-    return retval;
-}
-
 #ifndef TEXT_SYNTAX_NOPREFIX
 static char *
 get_prefix(yang_stmt *yn)
@@ -299,20 +156,19 @@ get_prefix(yang_stmt *yn)
 
 /*! Translate XML to a "pseudo-code" textual format using a callback - internal function
  *
+ * @param[out]    cb       Cligen buffer to write to
  * @param[in]     xn       XML object to print
- * @param[in]     fn       Callback to make print function
- * @param[in]     f        File to print to
  * @param[in]     level    Print PRETTYPRINT_INDENT spaces per level in front of each line
  * @param[in]     prefix   Add string to beginning of each line (or NULL)
  * @param[in]     autocliext How to handle autocli extensions: 0: ignore 1: follow
  * @param[in,out] leafl    Leaflist state for keeping track of when [] ends
  * @param[in,out] leaflname Leaflist state for [] 
+ * @param[in]     fo       Buffered output to flush after children, or NULL
  * @retval        0        OK
  * @retval       -1        Error
  * leaflist state:
  * 0: No leaflist
  * 1: In leaflist
- * @see text2file but to file (faster)
  */
 static int
 text2cbuf(cbuf  *cb,
@@ -321,7 +177,8 @@ text2cbuf(cbuf  *cb,
           char   *prepend,
           int    autocliext,
           int   *leafl,
-          char **leaflname)
+          char **leaflname,
+          clicon_file_out *fo)
 {
     int        retval = -1;
     cxobj     *xc = NULL;
@@ -331,7 +188,6 @@ text2cbuf(cbuf  *cb,
     char      *value;
     cg_var    *cvi;
     cvec      *cvk = NULL; /* vector of index keys */
-    cbuf      *cbb = NULL;
     int        level1;
     char      *prefix = NULL;
 
@@ -376,29 +232,30 @@ text2cbuf(cbuf  *cb,
             children++;
     if (children == 0){ /* If no children print line */
         switch (xml_type(xn)){
-        case CX_BODY:{
-            if ((cbb = cbuf_new()) == NULL){
-                clixon_err(OE_UNIX, errno, "cbuf_new");
-                goto done;
-            }
+        case CX_BODY:
             value = xml_value(xn);
-            if (index(value, ' ') != NULL)
-                cprintf(cbb, "\"%s\"", value);
-            else
-                cprintf(cbb, "%s", value);
             if (*leafl){                            /* Skip keyword if leaflist */
                 if (prepend)
-                    cprintf(cb, "%s", prepend);
-                cprintf(cb, "%*s%s\n", level1, "", cbuf_get(cbb));
+                    cbuf_append_str(cb, prepend);
+                if (clixon_cbuf_indent(cb, abs(level1)) < 0) /* As "%*s" */
+                    goto done;
+            }
+            /* Appended directly, not via a formatted scratch buffer per body */
+            if (strchr(value, ' ') != NULL){
+                cbuf_append(cb, '"');
+                cbuf_append_str(cb, value);
+                cbuf_append(cb, '"');
             }
             else
-                cprintf(cb, "%s;\n", cbuf_get(cbb));
+                cbuf_append_str(cb, value);
+            cbuf_append_str(cb, *leafl ? "\n" : ";\n");
             break;
-        }
         case CX_ELMNT:
             if (prepend)
                 cprintf(cb, "%s", prepend);
-            cprintf(cb, "%*s%s", level1, "", xml_name(xn));
+            if (clixon_cbuf_indent(cb, abs(level1)) < 0)
+                goto done;
+            cbuf_append_str(cb, xml_name(xn));
             cvi = NULL;             /* Lists only */
             while ((cvi = cvec_each(cvk, cvi)) != NULL) {
                 if ((xc = xml_find_type(xn, NULL, cv_string_get(cvi), CX_ELMNT)) != NULL)
@@ -414,15 +271,21 @@ text2cbuf(cbuf  *cb,
     if (*leafl == 0){
         if (prepend)
             cprintf(cb, "%s", prepend);
-        cprintf(cb, "%*s", level1, "");
-        if (prefix)
-            cprintf(cb, "%s:", prefix);
-        cprintf(cb, "%s", xml_name(xn));
+        if (clixon_cbuf_indent(cb, abs(level1)) < 0)
+            goto done;
+        if (prefix){
+            cbuf_append_str(cb, prefix);
+            cbuf_append(cb, ':');
+        }
+        cbuf_append_str(cb, xml_name(xn));
     }
     cvi = NULL;         /* Lists only */
     while ((cvi = cvec_each(cvk, cvi)) != NULL) {
-        if ((xc = xml_find_type(xn, NULL, cv_string_get(cvi), CX_ELMNT)) != NULL)
-            cprintf(cb, " %s", xml_body(xc));
+        if ((xc = xml_find_type(xn, NULL, cv_string_get(cvi), CX_ELMNT)) != NULL &&
+            (value = xml_body(xc)) != NULL){
+            cbuf_append(cb, ' ');
+            cbuf_append_str(cb, value);
+        }
     }
     if (yn && yang_keyword_get(yn) == Y_LEAF_LIST && *leafl){
         ;
@@ -433,16 +296,18 @@ text2cbuf(cbuf  *cb,
         cprintf(cb, " [\n");
     }
     else if (!tleaf(xn))
-        cprintf(cb, " {\n");
+        cbuf_append_str(cb, " {\n");
     else
-        cprintf(cb, " ");
+        cbuf_append(cb, ' ');
     xc = NULL;
     while ((xc = xml_child_each(xn, xc, -1)) != NULL){
         if (xml_type(xc) == CX_ELMNT || xml_type(xc) == CX_BODY){
             if (yn && yang_key_match(yn, xml_name(xc), NULL))
                 continue; /* Skip keys, already printed */
-            if (text2cbuf(cb, xc, level+1, prepend, autocliext, leafl, leaflname) < 0)
+            if (text2cbuf(cb, xc, level+1, prepend, autocliext, leafl, leaflname, fo) < 0)
                 break;
+            if (fo && clicon_file_out_check(fo) < 0)
+                goto done;
         }
     }
     /* Stop leaf-list printing (ie []) if no longer leaflist and same name */
@@ -455,13 +320,13 @@ text2cbuf(cbuf  *cb,
     if (!tleaf(xn)){
         if (prepend)
             cprintf(cb, "%s", prepend);
-        cprintf(cb, "%*s}\n", level1, "");
+        if (clixon_cbuf_indent(cb, abs(level1)) < 0)
+            goto done;
+        cbuf_append_str(cb, "}\n");
     }
  ok:
     retval = 0;
  done:
-    if (cbb)
-        cbuf_free(cbb);
     return retval;
 }
 
@@ -484,25 +349,32 @@ clixon_text2file(FILE             *f,
                  int               skiptop,
                  int               autocliext)
 {
-    int    retval = 1;
-    cxobj *xc;
-    int    leafl = 0;
-    char  *leaflname = NULL;
+    int             retval = 1;
+    cxobj          *xc;
+    int             leafl = 0;
+    char           *leaflname = NULL;
+    clicon_file_out fo = {0,};
 
-    if (fn == NULL)
-        fn = fprintf;
+    if (clicon_file_out_init(&fo, f, fn) < 0)
+        goto done;
     if (skiptop){
         xc = NULL;
-        while ((xc = xml_child_each(xn, xc, CX_ELMNT)) != NULL)
-            if (text2file(xc, fn, f, level, autocliext, &leafl, &leaflname) < 0)
+        while ((xc = xml_child_each(xn, xc, CX_ELMNT)) != NULL){
+            if (text2cbuf(fo.fo_cb, xc, level, NULL, autocliext, &leafl, &leaflname, &fo) < 0)
+                goto done;
+            if (clicon_file_out_check(&fo) < 0)
                 goto done;
+        }
     }
     else {
-        if (text2file(xn, fn, f, level, autocliext, &leafl, &leaflname) < 0)
+        if (text2cbuf(fo.fo_cb, xn, level, NULL, autocliext, &leafl, &leaflname, &fo) < 0)
             goto done;
     }
+    if (clicon_file_out_flush(fo.fo_cb, &fo) < 0)
+        goto done;
     retval = 0;
  done:
+    clicon_file_out_free(&fo);
     return retval;
 }
 
@@ -531,11 +403,11 @@ clixon_text2cbuf(cbuf             *cb,
     if (skiptop){
         xc = NULL;
         while ((xc = xml_child_each(xn, xc, CX_ELMNT)) != NULL)
-            if (text2cbuf(cb, xc, level, NULL, autocliext, &leafl, &leaflname) < 0)
+            if (text2cbuf(cb, xc, level, NULL, autocliext, &leafl, &leaflname, NULL) < 0)
                 goto done;
     }
     else {
-        if (text2cbuf(cb, xn, level, NULL, autocliext, &leafl, &leaflname) < 0)
+        if (text2cbuf(cb, xn, level, NULL, autocliext, &leafl, &leaflname, NULL) < 0)
             goto done;
     }
     retval = 0;
@@ -727,7 +599,7 @@ text_diff2cbuf(cbuf  *cb,
                 cprintf(cb, " {\n");
                 nr++;
             }
-            if (text2cbuf(cb, x1c, level+1, "+", 0, &leafl, &leaflname) < 0)
+            if (text2cbuf(cb, x1c, level+1, "+", 0, &leafl, &leaflname, NULL) < 0)
                 goto done;
             x1c = xml_child_each(x1, x1c, CX_ELMNT);
             continue;
@@ -742,7 +614,7 @@ text_diff2cbuf(cbuf  *cb,
                 cprintf(cb, "{\n");
                 nr++;
             }
-            if (text2cbuf(cb, x0c, level+1, "-", 0, &leafl, &leaflname) < 0)
+            if (text2cbuf(cb, x0c, level+1, "-", 0, &leafl, &leaflname, NULL) < 0)
                 goto done;
             x0c = xml_child_each(x0, x0c, CX_ELMNT);
             continue;
@@ -771,7 +643,7 @@ text_diff2cbuf(cbuf  *cb,
                         cprintf(cb, " {\n");
                         nr++;
                     }
-                    if (text2cbuf(cb, xi, level+1, "-", 0, &leafl, &leaflname) < 0)
+                    if (text2cbuf(cb, xi, level+1, "-", 0, &leafl, &leaflname, NULL) < 0)
                         goto done;
                 }
             }
@@ -793,7 +665,7 @@ text_diff2cbuf(cbuf  *cb,
                         cprintf(cb, " {\n");
                         nr++;
                     }
-                    if (text2cbuf(cb, xj, level+1, "+", 0, &leafl, &leaflname) < 0)
+                    if (text2cbuf(cb, xj, level+1, "+", 0, &leafl, &leaflname, NULL) < 0)
                         goto done;
                 }
             }
@@ -812,7 +684,7 @@ text_diff2cbuf(cbuf  *cb,
                 cprintf(cb, " {\n");
                 nr++;
             }
-            if (text2cbuf(cb, x0c, level+1, "-", 0, &leafl, &leaflname) < 0)
+            if (text2cbuf(cb, x0c, level+1, "-", 0, &leafl, &leaflname, NULL) < 0)
                 goto done;
             x0c = xml_child_each(x0, x0c, CX_ELMNT);
             continue;
@@ -827,7 +699,7 @@ text_diff2cbuf(cbuf  *cb,
                 cprintf(cb, " {\n");
                 nr++;
             }
-            if (text2cbuf(cb, x1c, level+1, "+", 0, &leafl, &leaflname) < 0)
+            if (text2cbuf(cb, x1c, level+1, "+", 0, &leafl, &leaflname, NULL) < 0)
                 goto done;
             x1c = xml_child_each(x1, x1c, CX_ELMNT);
             continue;
@@ -841,9 +713,9 @@ text_diff2cbuf(cbuf  *cb,
                     cprintf(cb, "%s {\n", xml_name(x0));
                     nr++;
                 }
-                if (text2cbuf(cb, x0c, level+1, "-", 0, &leafl, &leaflname) < 0)
+                if (text2cbuf(cb, x0c, level+1, "-", 0, &leafl, &leaflname, NULL) < 0)
                     goto done;
-                if (text2cbuf(cb, x1c, level+1, "+", 0, &leafl, &leaflname) < 0)
+                if (text2cbuf(cb, x1c, level+1, "+", 0, &leafl, &leaflname, NULL) < 0)
                     goto done;
             }
             else if (y0c && yang_keyword_get(y0c) == Y_LEAF){
@@ -1009,6 +881,7 @@ _text_syntax_parse(char      *str,
     cbuf                   *cberr = NULL;
     int                     failed = 0; /* yang assignment */
     cxobj                  *xc;
+    int                     bison = 0;
 
     clixon_debug(CLIXON_DBG_PARSE, "%s", str);
     if (yb != YB_MODULE && yb != YB_MODULE_NEXT){
@@ -1019,6 +892,17 @@ _text_syntax_parse(char      *str,
     ts.ts_linenum = 1;
     ts.ts_xtop = xt;
     ts.ts_yspec = yspec;
+    if (_text_syntax_parser_mode == XML_PARSER_FAST){
+        /* Yang is bound and list keys are created while scanning */
+        if ((ret = clixon_text_syntax_scan(&ts, yb, xerr)) < 0){
+            clixon_log(NULL, LOG_NOTICE, "TEXT SYNTAX error: line %d", ts.ts_linenum);
+            goto done;
+        }
+        if (ret == 0)
+            goto fail;
+        goto sort;
+    }
+    bison++;
     if (clixon_text_syntax_parsel_init(&ts) < 0)
         goto done;
     if (clixon_text_syntax_parseparse(&ts) != 0) { /* yacc returns 1 on error */
@@ -1059,7 +943,7 @@ _text_syntax_parse(char      *str,
     }
     if (failed)
         goto fail;
-
+ sort:
     /* Sort the complete tree after parsing. Sorting is not really meaningful if Yang 
        not bound */
     if (yb != YB_NONE)
@@ -1070,7 +954,8 @@ _text_syntax_parse(char      *str,
     clixon_debug(CLIXON_DBG_PARSE, "retval:%d", retval);
     if (cberr)
         cbuf_free(cberr);
-    clixon_text_syntax_parsel_exit(&ts);
+    if (bison)
+        clixon_text_syntax_parsel_exit(&ts);
     return retval;
  fail: /* invalid */
     retval = 0;
@@ -1154,60 +1039,34 @@ clixon_text_syntax_parse_file(FILE      *fp,
     int       retval = -1;
     int       ret;
     char     *textbuf = NULL;
-    int       textbuflen = BUFLEN; /* start size */
-    int       oldtextbuflen;
-    char     *ptr;
-    char      ch;
-    int       len = 0;
+    size_t    len = 0;
+    size_t    maplen = 0;
 
     if (xt == NULL){
         clixon_err(OE_XML, EINVAL, "xt is NULL");
         return -1;
     }
-    if ((textbuf = malloc(textbuflen)) == NULL){
-        clixon_err(OE_XML, errno, "malloc");
+    xml_arena_push();
+    /* Map or read file in one go instead of character by character */
+    if (clicon_file_buf(fp, &textbuf, &len, &maplen) < 0)
         goto done;
-    }
-    memset(textbuf, 0, textbuflen);
-    ptr = textbuf;
-    while (1){
-        if ((ret = fread(&ch, 1, 1, fp)) < 0){
-            clixon_err(OE_XML, errno, "read");
-            break;
-        }
-        if (ret != 0)
-            textbuf[len++] = ch;
-        if (ret == 0){
-            if (*xt == NULL)
-                if ((*xt = xml_new(TEXT_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
-                    goto done;
-            if (len){
-                if ((ret = _text_syntax_parse(ptr, yb, yspec, *xt, xerr)) < 0)
-                    goto done;
-                if (ret == 0)
-                    goto fail;
-            }
-            break;
-        }
-        if (len >= textbuflen-1){ /* Space: one for the null character */
-            oldtextbuflen = textbuflen;
-            textbuflen *= 2;
-            if ((textbuf = realloc(textbuf, textbuflen)) == NULL){
-                clixon_err(OE_XML, errno, "realloc");
-                goto done;
-            }
-            memset(textbuf+oldtextbuflen, 0, textbuflen-oldtextbuflen);
-            ptr = textbuf;
-        }
+    if (*xt == NULL)
+        if ((*xt = xml_new(TEXT_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
+            goto done;
+    if (len){
+        if ((ret = _text_syntax_parse(textbuf, yb, yspec, *xt, xerr)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
     }
     retval = 1;
  done:
     if (retval < 0 && *xt){
-        free(*xt);
+        xml_free(*xt);
         *xt = NULL;
     }
-    if (textbuf)
-        free(textbuf);
+    xml_arena_pop();
+    clicon_file_buf_free(textbuf, maplen);
     return retval;
  fail:
     retval = 0;
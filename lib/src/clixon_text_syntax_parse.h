@@ -66,5 +66,6 @@ int clixon_text_syntax_parsel_exit(clixon_text_syntax_yacc *ya);
 int clixon_text_syntax_parsel_linenr(void);
 int clixon_text_syntax_parselex(void *);
 int clixon_text_syntax_parseparse(void *);
+int clixon_text_syntax_scan(clixon_text_syntax_yacc *ts, yang_bind yb, cxobj **xerr);
 
 #endif  /* _CLIXON_TEXT_SYNTAX_PARSE_H_ */
@@ -0,0 +1,560 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+
+  Copyright (C) 2022 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, indicate
+  your decision by deleting the provisions above and replace them with the
+  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Hand-written TEXT / curly-brace syntax scanner
+ * An alternative to the flex/bison parser in clixon_text_syntax_parse.[ly] that scans the
+ * input in a single pass and creates the XML tree directly.
+ * Tokens and quoted strings are located with strcspn/strchr and referenced in place, they
+ * are only copied when an element or body is created.
+ * YANG is bound to each element when it is created, so that list keys are created as key
+ * leafs directly instead of in a separate pass after binding, see text_populate_list.
+ * Consecutive siblings with the same name reuse the yang spec of the previous one.
+ * @see CLICON_TEXT_SYNTAX_PARSER
+ * @see clixon_text_syntax_parse.y
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <string.h>
+#include <stdint.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_err.h"
+#include "clixon_log.h"
+#include "clixon_debug.h"
+#include "clixon_xml_nsctx.h"
+#include "clixon_xml_bind.h"
+#include "clixon_text_syntax_parse.h"
+
+/* Max nesting of { } statements */
+#define TEXT_SCAN_DEPTH_MAX 10000
+
+/* Characters that end a token, see TOKEN in clixon_text_syntax_parse.l */
+#define TEXT_SCAN_DELIM " \t\n\r[]{};\""
+
+#define TEXT_SCAN_WHITE(c) ((c) == ' ' || (c) == '\t' || (c) == '\n' || (c) == '\r')
+
+/*! Value of a statement, a token or the contents of a quoted string, in the input
+ */
+typedef struct {
+    char   *tv_str;
+    size_t  tv_len;
+} text_scan_val;
+
+/*! Scanner state
+ */
+typedef struct {
+    clixon_text_syntax_yacc *tx_ts;      /* Parser struct shared with the bison parser */
+    cxobj                  **tx_xerr;    /* Reason for invalid binding */
+    cbuf                    *tx_str;     /* Scratch for names and values */
+    cbuf                    *tx_prefix;  /* Last module prefix, cache for namespace lookup */
+    char                    *tx_ns;      /* Namespace of last prefix, or NULL if unknown */
+    int                      tx_cached;  /* tx_prefix and tx_ns are valid */
+    text_scan_val           *tx_vals;    /* Values of current statement */
+    int                      tx_nvals;
+    int                      tx_maxvals;
+    int                      tx_depth;   /* Current nesting */
+} text_scan_t;
+
+/*! Report syntax error in the same format as the bison parser
+ *
+ * Line numbers are counted only on error
+ * @param[in]  tx  Scanner state
+ * @param[in]  p   Position of error
+ * @retval    -1   Always
+ * @see clixon_text_syntax_parseerror
+ */
+static int
+text_scan_error(text_scan_t *tx,
+                char        *p)
+{
+    clixon_text_syntax_yacc *ts = tx->tx_ts;
+    char                    *q;
+    size_t                   n;
+
+    ts->ts_linenum = 1;
+    for (q = ts->ts_parse_string; (q = memchr(q, '\n', p - q)) != NULL; q++)
+        ts->ts_linenum++;
+    if ((n = strcspn(p, TEXT_SCAN_DELIM)) == 0 && *p)
+        n = 1;
+    clixon_err(OE_XML, XMLPARSE_ERRNO, "text_syntax_parse: line %d: syntax error: at or before: %.*s",
+               ts->ts_linenum, (int)n, p);
+    return -1;
+}
+
+/*! Skip whitespace and comments
+ *
+ * As in the lexer, # starts a comment only if it is not the start of a longer token
+ */
+static char *
+text_scan_white(char *p)
+{
+    while (1){
+        while (TEXT_SCAN_WHITE(*p))
+            p++;
+        if (*p != '#' || (p[1] != '\0' && strchr(TEXT_SCAN_DELIM, p[1]) == NULL))
+            break;
+        if ((p = strchr(p, '\n')) == NULL)
+            return "";
+    }
+    return p;
+}
+
+/*! Scan values of a statement, tokens or quoted strings, until a delimiter
+ *
+ * @param[in]     tx   Scanner state
+ * @param[in,out] pp   Position after statement identifier, moved to delimiter
+ * @retval        0    OK, values in tx_vals
+ * @retval       -1    Error
+ */
+static int
+text_scan_values(text_scan_t *tx,
+                 char       **pp)
+{
+    char          *p = *pp;
+    char          *q;
+    size_t         n;
+    text_scan_val *tv;
+
+    tx->tx_nvals = 0;
+    while (1){
+        p = text_scan_white(p);
+        if (*p == '"'){
+            /* Quoted string has no escapes and may span lines */
+            if ((q = strchr(p+1, '"')) == NULL)
+                return text_scan_error(tx, p);
+            p++;
+            n = q - p;
+            q++;
+        }
+        else if ((n = strcspn(p, TEXT_SCAN_DELIM)) > 0)
+            q = p + n;
+        else
+            break;
+        if (tx->tx_nvals >= tx->tx_maxvals){
+            tx->tx_maxvals = tx->tx_maxvals ? 2*tx->tx_maxvals : 8;
+            if ((tv = realloc(tx->tx_vals, tx->tx_maxvals*sizeof(*tv))) == NULL){
+                clixon_err(OE_UNIX, errno, "realloc");
+                return -1;
+            }
+            tx->tx_vals = tv;
+        }
+        tv = &tx->tx_vals[tx->tx_nvals++];
+        tv->tv_str = p;
+        tv->tv_len = n;
+        p = q;
+    }
+    *pp = p;
+    return 0;
+}
+
+/*! Create element [prefix:]id as last child of xp
+ *
+ * A module name prefix is translated to a default namespace, unknown modules are silently
+ * ignored as in the bison parser
+ * @param[in]  tx     Scanner state
+ * @param[in]  xp     XML parent
+ * @param[in]  id     Identifier in input, not null-terminated
+ * @param[in]  idlen  Length of id
+ * @param[out] xcp    Created element
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see text_create_node
+ */
+static int
+text_scan_element(text_scan_t *tx,
+                  cxobj       *xp,
+                  char        *id,
+                  size_t       idlen,
+                  cxobj      **xcp)
+{
+    yang_stmt *yspec = tx->tx_ts->ts_yspec;
+    yang_stmt *ymod;
+    cxobj     *x;
+    char      *colon;
+    size_t     plen = 0;
+
+    if ((colon = memchr(id, ':', idlen)) != NULL){
+        plen = colon - id;
+        id = colon + 1;
+        idlen -= plen + 1;
+    }
+    cbuf_reset(tx->tx_str);
+    if (cbuf_append_buf(tx->tx_str, id, idlen) < 0){
+        clixon_err(OE_UNIX, errno, "cbuf_append_buf");
+        return -1;
+    }
+    if ((x = xml_new(cbuf_get(tx->tx_str), xp, CX_ELMNT)) == NULL)
+        return -1;
+    if (colon && yspec){
+        if (!tx->tx_cached ||
+            cbuf_len(tx->tx_prefix) != plen ||
+            strncmp(cbuf_get(tx->tx_prefix), colon - plen, plen) != 0){
+            cbuf_reset(tx->tx_prefix);
+            if (cbuf_append_buf(tx->tx_prefix, colon - plen, plen) < 0){
+                clixon_err(OE_UNIX, errno, "cbuf_append_buf");
+                return -1;
+            }
+            tx->tx_ns = NULL;
+            if ((ymod = yang_find(yspec, Y_MODULE, cbuf_get(tx->tx_prefix))) != NULL &&
+                (tx->tx_ns = yang_find_mynamespace(ymod)) == NULL){
+                clixon_err(OE_YANG, 0, "No namespace");
+                return -1;
+            }
+            tx->tx_cached = 1;
+        }
+        if (tx->tx_ns && xmlns_set(x, NULL, tx->tx_ns) < 0)
+            return -1;
+    }
+    *xcp = x;
+    return 0;
+}
+
+/*! Add body with value to element
+ *
+ * @param[in]  tx    Scanner state
+ * @param[in]  x     XML element
+ * @param[in]  tv    Value
+ * @param[in]  flag  Mark body with XML_FLAG_BODYKEY, see text_mark_bodies
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+text_scan_body(text_scan_t   *tx,
+               cxobj         *x,
+               text_scan_val *tv,
+               int            flag)
+{
+    cxobj *xb;
+
+    cbuf_reset(tx->tx_str);
+    if (cbuf_append_buf(tx->tx_str, tv->tv_str, tv->tv_len) < 0){
+        clixon_err(OE_UNIX, errno, "cbuf_append_buf");
+        return -1;
+    }
+    if ((xb = xml_new("body", x, CX_BODY)) == NULL)
+        return -1;
+    if (flag)
+        xml_flag_set(xb, XML_FLAG_BODYKEY);
+    if (xml_value_set(xb, cbuf_get(tx->tx_str)) < 0)
+        return -1;
+    return 0;
+}
+
+/*! Bind yang to element when it is created, before its contents
+ *
+ * @param[in]  tx     Scanner state
+ * @param[in]  x      XML element, last child of its parent
+ * @param[in]  ybc    YB_MODULE, YB_PARENT or YB_NONE
+ * @param[in]  xprev  Previous sibling, or NULL
+ * @retval     2      OK, under anyxml or anydata, children are not bound
+ * @retval     1      OK
+ * @retval     0      Invalid, tx_xerr set
+ * @retval    -1      Error
+ * @see populate_self_parent  Same sibling optimization
+ */
+static int
+text_scan_bind(text_scan_t *tx,
+               cxobj       *x,
+               yang_bind    ybc,
+               cxobj       *xprev)
+{
+    if (ybc == YB_NONE)
+        return 1;
+    if (ybc == YB_PARENT &&
+        xprev && xml_spec(xprev) &&
+        xml_child_nr_type(x, CX_ATTR) == 0 &&
+        strcmp(xml_name(xprev), xml_name(x)) == 0){
+        xml_spec_set(x, xml_spec(xprev));
+        if (xml_flag(xprev, XML_FLAG_NS_SPEC))
+            xml_flag_set(x, XML_FLAG_NS_SPEC);
+        return 1;
+    }
+    return xml_bind_yang_node(NULL, x, ybc, tx->tx_ts->ts_yspec, tx->tx_xerr);
+}
+
+/*! Create key leafs of list entry from the values of the statement
+ *
+ * @param[in]  tx    Scanner state
+ * @param[in]  x     XML list entry
+ * @param[in]  y     Yang list
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see text_populate_list
+ */
+static int
+text_scan_keys(text_scan_t *tx,
+               cxobj       *x,
+               yang_stmt   *y)
+{
+    cvec   *cvk;
+    cg_var *cvi = NULL;
+    cxobj  *xc;
+    char   *namei;
+    int     i;
+
+    cvk = yang_cvec_get(y);
+    for (i=0; i<tx->tx_nvals; i++){
+        if ((cvi = cvec_next(cvk, cvi)) == NULL){
+            clixon_err(OE_XML, 0, "text parser, key and body mismatch");
+            return -1;
+        }
+        namei = cv_string_get(cvi);
+        if ((xc = xml_new(namei, x, CX_ELMNT)) == NULL)
+            return -1;
+        xml_spec_set(xc, yang_find(y, Y_LEAF, namei));
+        if (text_scan_body(tx, xc, &tx->tx_vals[i], 0) < 0)
+            return -1;
+    }
+    return 0;
+}
+
+/*! Scan statement: id values ; | id values { stmts } | id [ values ]
+ *
+ * @param[in]     tx      Scanner state
+ * @param[in,out] pp      Position at start of statement, moved past it
+ * @param[in]     xp      XML parent
+ * @param[in]     ybc     How to bind the created elements: YB_MODULE, YB_PARENT or YB_NONE
+ * @param[in]     wrapper Top-level element of YB_MODULE_NEXT, bind children as modules
+ * @param[in,out] xprev   Last created sibling in xp, for binding
+ * @retval        1       OK
+ * @retval        0       Invalid, tx_xerr set
+ * @retval       -1       Error
+ */
+static int
+text_scan_stmt(text_scan_t *tx,
+               char       **pp,
+               cxobj       *xp,
+               yang_bind    ybc,
+               int          wrapper,
+               cxobj      **xprev)
+{
+    int        retval = -1;
+    char      *p;
+    char      *id;
+    size_t     idlen;
+    cxobj     *x = NULL;
+    cxobj     *xc = NULL;
+    yang_stmt *y;
+    yang_bind  ybc1;
+    int        nvals;
+    int        ret;
+    int        i;
+
+    p = text_scan_white(*pp);
+    if ((idlen = strcspn(p, TEXT_SCAN_DELIM)) == 0){
+        text_scan_error(tx, p);
+        goto done;
+    }
+    id = p;
+    p += idlen;
+    if (text_scan_values(tx, &p) < 0)
+        goto done;
+    switch (*p){
+    case ';':
+        p++;
+        if (text_scan_element(tx, xp, id, idlen, &x) < 0)
+            goto done;
+        if ((ret = text_scan_bind(tx, x, ybc, *xprev)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+        *xprev = x;
+        if (tx->tx_nvals == 0)
+            break;
+        if ((y = xml_spec(x)) != NULL && yang_keyword_get(y) == Y_LIST){
+            if (text_scan_keys(tx, x, y) < 0)
+                goto done;
+            break;
+        }
+        /* One element per value */
+        if (text_scan_body(tx, x, &tx->tx_vals[0], 1) < 0)
+            goto done;
+        for (i=1; i<tx->tx_nvals; i++){
+            if (text_scan_element(tx, xp, id, idlen, &x) < 0)
+                goto done;
+            if ((ret = text_scan_bind(tx, x, ybc, *xprev)) < 0)
+                goto done;
+            if (ret == 0)
+                goto fail;
+            *xprev = x;
+            if (text_scan_body(tx, x, &tx->tx_vals[i], 1) < 0)
+                goto done;
+        }
+        break;
+    case '{':
+        p++;
+        if (++tx->tx_depth > TEXT_SCAN_DEPTH_MAX){
+            clixon_err(OE_XML, 0, "text_syntax_parse: nesting deeper than %d", TEXT_SCAN_DEPTH_MAX);
+            goto done;
+        }
+        if (text_scan_element(tx, xp, id, idlen, &x) < 0)
+            goto done;
+        if ((ret = text_scan_bind(tx, x, ybc, *xprev)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+        *xprev = x;
+        if (wrapper)
+            ybc1 = YB_MODULE;
+        else if (ret == 2 || ybc == YB_NONE)
+            ybc1 = YB_NONE;
+        else
+            ybc1 = YB_PARENT;
+        if ((y = xml_spec(x)) != NULL && yang_keyword_get(y) == Y_LIST){
+            if (text_scan_keys(tx, x, y) < 0)
+                goto done;
+        }
+        else
+            for (i=0; i<tx->tx_nvals; i++)
+                if (text_scan_body(tx, x, &tx->tx_vals[i], 1) < 0)
+                    goto done;
+        while (*(p = text_scan_white(p)) != '}'){
+            if ((ret = text_scan_stmt(tx, &p, x, ybc1, 0, &xc)) < 0)
+                goto done;
+            if (ret == 0)
+                goto fail;
+        }
+        p++;
+        tx->tx_depth--;
+        break;
+    case '[':
+        if (tx->tx_nvals != 0){
+            text_scan_error(tx, p);
+            goto done;
+        }
+        p++;
+        if (text_scan_values(tx, &p) < 0)
+            goto done;
+        if (*p != ']'){
+            text_scan_error(tx, p);
+            goto done;
+        }
+        p++;
+        nvals = tx->tx_nvals;
+        for (i=0; i<nvals; i++){
+            if (text_scan_element(tx, xp, id, idlen, &x) < 0)
+                goto done;
+            if ((ret = text_scan_bind(tx, x, ybc, *xprev)) < 0)
+                goto done;
+            if (ret == 0)
+                goto fail;
+            *xprev = x;
+            if (text_scan_body(tx, x, &tx->tx_vals[i], 0) < 0)
+                goto done;
+        }
+        break;
+    default:
+        text_scan_error(tx, p);
+        goto done;
+    }
+    *pp = p;
+    retval = 1;
+ done:
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Scan TEXT syntax string, create XML tree and bind yang
+ *
+ * Same input as the bison parser: a single top-level statement is created under ts_xtop.
+ * Yang is bound while scanning, as xml_bind_yang0 or xml_bind_yang with the top-level
+ * node as wrapper does after the bison parser, and list keys are created.
+ * The tree is not sorted.
+ * @param[in]  ts     Parser struct, ts_parse_string is null-terminated
+ * @param[in]  yb     YB_MODULE or YB_MODULE_NEXT
+ * @param[out] xerr   Reason for invalid returned as netconf err msg
+ * @retval     1      OK
+ * @retval     0      Invalid, xerr set
+ * @retval    -1      Error
+ * @see clixon_text_syntax_parseparse  The bison parser
+ */
+int
+clixon_text_syntax_scan(clixon_text_syntax_yacc *ts,
+                        yang_bind                yb,
+                        cxobj                  **xerr)
+{
+    int         retval = -1;
+    text_scan_t tx = {0,};
+    char       *p;
+    cxobj      *xprev = NULL;
+    int         ret;
+
+    tx.tx_ts = ts;
+    tx.tx_xerr = xerr;
+    if ((tx.tx_str = cbuf_new()) == NULL ||
+        (tx.tx_prefix = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    p = ts->ts_parse_string;
+    if ((ret = text_scan_stmt(&tx, &p, ts->ts_xtop,
+                              yb == YB_MODULE ? YB_MODULE : YB_NONE,
+                              yb == YB_MODULE_NEXT,
+                              &xprev)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
+    p = text_scan_white(p);
+    if (*p != '\0'){
+        text_scan_error(&tx, p);
+        goto done;
+    }
+    retval = 1;
+ done:
+    if (tx.tx_str)
+        cbuf_free(tx.tx_str);
+    if (tx.tx_prefix)
+        cbuf_free(tx.tx_prefix);
+    if (tx.tx_vals)
+        free(tx.tx_vals);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
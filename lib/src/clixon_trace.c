@@ -0,0 +1,342 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2024 Olof Hagsand
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Tracing spans of operations, in the style of OpenTelemetry.
+ * A span is the start and end time of an operation, such as a restconf request, a backend
+ * RPC or a plugin callback, identified by a trace id and a span id.
+ * The trace context is propagated between processes as a W3C traceparent: from the HTTP
+ * header of a restconf request, via the cl:traceparent attribute of internal RPCs to
+ * the backend.
+ * Ended spans are appended as JSON lines to the file of CLICON_TRACE_FILE, eg for a
+ * collector to export. If not set, tracing is disabled and spans only cost a test.
+ * Spans are nested in a single thread and should not be used in concurrent threads.
+ * @see https://www.w3.org/TR/trace-context
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/types.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_err.h"
+#include "clixon_options.h"
+#include "clixon_trace.h"
+
+static FILE        *_trace_f = NULL;         /* Trace file, NULL if disabled */
+static char        *_trace_service = NULL;   /* Service name, eg clixon_backend */
+static clixon_span *_trace_current = NULL;   /* Innermost active span */
+static char         _trace_remote[CLIXON_TRACEPARENT_LEN+1] = {0,}; /* Parent of next root span */
+static uint64_t     _trace_rand = 0;         /* Random state of ids */
+static pid_t        _trace_pid = 0;          /* Process of random state */
+
+/*! Open trace file and enable tracing if CLICON_TRACE_FILE is set
+ *
+ * @param[in]  h        Clixon handle
+ * @param[in]  service  Name of process in spans, eg __PROGRAM__
+ * @retval     0        OK
+ * @retval    -1        Error
+ * @see CLICON_TRACE_FILE
+ */
+int
+clixon_trace_init(clixon_handle h,
+                  const char   *service)
+{
+    int   retval = -1;
+    char *filename;
+
+    clixon_trace_exit();
+    if ((filename = clicon_option_str(h, "CLICON_TRACE_FILE")) == NULL)
+        goto ok;
+    if ((_trace_service = strdup(service)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    if ((_trace_f = fopen(filename, "a")) == NULL){
+        clixon_err(OE_UNIX, errno, "fopen(%s)", filename);
+        goto done;
+    }
+    /* Line buffered: nothing is left in the buffer to be duplicated by fork */
+    setvbuf(_trace_f, NULL, _IOLBF, 0);
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Check if tracing is enabled
+ *
+ * @retval     1       Enabled
+ * @retval     0       Disabled
+ */
+int
+clixon_trace_enabled(void)
+{
+    return _trace_f != NULL;
+}
+
+/*! Check that a string is a number of lowercase hex digits
+ *
+ * @param[in]  s        String
+ * @param[in]  len      Number of digits
+ * @param[in]  nonzero  If set, all digits may not be zero
+ * @retval     1        OK
+ * @retval     0        Not hex, or zero
+ */
+static int
+trace_hex_check(const char *s,
+                int         len,
+                int         nonzero)
+{
+    int i;
+    int zero = 1;
+
+    for (i=0; i<len; i++){
+        if (!((s[i] >= '0' && s[i] <= '9') || (s[i] >= 'a' && s[i] <= 'f')))
+            return 0;
+        if (s[i] != '0')
+            zero = 0;
+    }
+    return !(nonzero && zero);
+}
+
+/*! Set trace context of incoming request, from W3C traceparent
+ *
+ * The next span started when no span is active becomes a child of the remote span
+ * Format: "<version>-<trace-id>-<parent-id>-<flags>", eg:
+ *   00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01
+ * @param[in]  traceparent  W3C traceparent string, or NULL to clear
+ * @retval     1            OK, context set
+ * @retval     0            Invalid traceparent or tracing disabled, context cleared
+ */
+int
+clixon_trace_parent_set(const char *traceparent)
+{
+    _trace_remote[0] = '\0';
+    if (_trace_f == NULL || traceparent == NULL)
+        return 0;
+    /* Later versions may append fields, see W3C trace context 4.3 */
+    if (strlen(traceparent) < CLIXON_TRACEPARENT_LEN ||
+        (traceparent[0] == '0' && traceparent[1] == '0' &&
+         traceparent[CLIXON_TRACEPARENT_LEN] != '\0'))
+        return 0;
+    if (traceparent[2] != '-' || traceparent[35] != '-' || traceparent[52] != '-')
+        return 0;
+    if (!trace_hex_check(traceparent, 2, 0) || strncmp(traceparent, "ff", 2) == 0)
+        return 0;
+    if (!trace_hex_check(&traceparent[3], 32, 1) ||
+        !trace_hex_check(&traceparent[36], 16, 1) ||
+        !trace_hex_check(&traceparent[53], 2, 0))
+        return 0;
+    memcpy(_trace_remote, traceparent, CLIXON_TRACEPARENT_LEN);
+    _trace_remote[CLIXON_TRACEPARENT_LEN] = '\0';
+    return 1;
+}
+
+/*! Get W3C traceparent of active span, for propagation to another process
+ *
+ * @param[out] buf   Buffer of at least CLIXON_TRACEPARENT_LEN+1 bytes
+ * @param[in]  len   Length of buf
+ * @retval     1     OK, traceparent in buf
+ * @retval     0     No active span
+ */
+int
+clixon_trace_traceparent(char  *buf,
+                         size_t len)
+{
+    clixon_span *sp;
+
+    if ((sp = _trace_current) == NULL || len < CLIXON_TRACEPARENT_LEN+1)
+        return 0;
+    snprintf(buf, len, "00-%s-%s-01", sp->sp_trace, sp->sp_id);
+    return 1;
+}
+
+/*! Generate random hex id, reseeded in forked processes
+ *
+ * Ids are unique, not secret, therefore a xorshift generator is sufficient
+ */
+static void
+trace_id_new(char *buf,
+             int   len)
+{
+    struct timespec ts;
+    uint64_t        x;
+    int             fd;
+    int             i;
+
+    if (_trace_pid != getpid()){
+        _trace_pid = getpid();
+        clock_gettime(CLOCK_REALTIME, &ts);
+        _trace_rand = ((uint64_t)ts.tv_sec << 32) ^ ts.tv_nsec ^ ((uint64_t)_trace_pid << 16);
+        if ((fd = open("/dev/urandom", O_RDONLY)) >= 0){
+            if (read(fd, &x, sizeof(x)) == sizeof(x))
+                _trace_rand ^= x;
+            close(fd);
+        }
+        if (_trace_rand == 0)
+            _trace_rand = 1;
+    }
+    for (i=0; i<len; i+=16){
+        x = _trace_rand;
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        _trace_rand = x;
+        snprintf(&buf[i], 17, "%016" PRIx64, x);
+    }
+    buf[len] = '\0';
+}
+
+/*! Start a span of an operation
+ *
+ * The span becomes a child of the active span, if any, or else of the remote span set
+ * by clixon_trace_parent_set. Otherwise it starts a new trace.
+ * @param[in]  sp      Span, on the stack of the caller
+ * @param[in]  format  Name of operation, format string
+ * @code
+ *   clixon_span sp = {0,};
+ *   clixon_trace_span_start(&sp, "rpc %s", name);
+ *   ...
+ *   clixon_trace_span_end(&sp);
+ * @endcode
+ * @see clixon_trace_span_end  Must be called also on error
+ */
+void
+clixon_trace_span_start(clixon_span *sp,
+                        const char  *format, ...)
+{
+    va_list         ap;
+    struct timespec ts;
+
+    sp->sp_start = 0;
+    if (_trace_f == NULL)
+        return;
+    if (_trace_current){
+        strcpy(sp->sp_trace, _trace_current->sp_trace);
+        strcpy(sp->sp_parent, _trace_current->sp_id);
+    }
+    else if (_trace_remote[0]){
+        memcpy(sp->sp_trace, &_trace_remote[3], 32);
+        sp->sp_trace[32] = '\0';
+        memcpy(sp->sp_parent, &_trace_remote[36], 16);
+        sp->sp_parent[16] = '\0';
+        _trace_remote[0] = '\0';
+    }
+    else{
+        trace_id_new(sp->sp_trace, 32);
+        sp->sp_parent[0] = '\0';
+    }
+    trace_id_new(sp->sp_id, 16);
+    va_start(ap, format);
+    vsnprintf(sp->sp_name, sizeof(sp->sp_name), format, ap);
+    va_end(ap);
+    clock_gettime(CLOCK_REALTIME, &ts);
+    sp->sp_start = (uint64_t)ts.tv_sec*1000000000 + ts.tv_nsec;
+    sp->sp_prev = _trace_current;
+    _trace_current = sp;
+}
+
+/*! End a span and write it to the trace file
+ *
+ * No-op if the span was not started, eg if tracing is disabled
+ * @param[in]  sp      Span
+ * @see clixon_trace_span_start
+ */
+void
+clixon_trace_span_end(clixon_span *sp)
+{
+    struct timespec ts;
+    uint64_t        end;
+    char           *s;
+
+    if (sp->sp_start == 0)
+        return;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    end = (uint64_t)ts.tv_sec*1000000000 + ts.tv_nsec;
+    if (_trace_f){
+        fprintf(_trace_f, "{\"traceId\":\"%s\",\"spanId\":\"%s\",", sp->sp_trace, sp->sp_id);
+        if (sp->sp_parent[0])
+            fprintf(_trace_f, "\"parentSpanId\":\"%s\",", sp->sp_parent);
+        fprintf(_trace_f, "\"name\":\"");
+        for (s = sp->sp_name; *s; s++){
+            if (*s == '"' || *s == '\\')
+                fputc('\\', _trace_f);
+            if ((unsigned char)*s < 0x20)
+                fputc(' ', _trace_f);
+            else
+                fputc(*s, _trace_f);
+        }
+        fprintf(_trace_f, "\",\"service\":\"%s\",\"startTimeUnixNano\":%" PRIu64 ","
+                "\"endTimeUnixNano\":%" PRIu64 "}\n",
+                _trace_service, sp->sp_start, end);
+    }
+    sp->sp_start = 0;
+    _trace_current = sp->sp_prev;
+}
+
+/*! Close trace file and disable tracing
+ */
+void
+clixon_trace_exit(void)
+{
+    if (_trace_f){
+        fclose(_trace_f);
+        _trace_f = NULL;
+    }
+    if (_trace_service){
+        free(_trace_service);
+        _trace_service = NULL;
+    }
+    _trace_current = NULL;
+    _trace_remote[0] = '\0';
+}
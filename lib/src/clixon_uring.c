@@ -0,0 +1,526 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2016 Olof Hagsand and Benny Holmgren
+  Copyright (C) 2017-2019 Olof Hagsand
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC (Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+  * File I/O with io_uring, see CLICON_XMLDB_IO_URING
+  * Datastore files are written as one chain of linked write, fsync and rename requests
+  * of a serialized buffer. Completions are signalled via an eventfd in the event loop so
+  * that the backend continues with other clients meanwhile.
+  * Large files are read with several reads in flight.
+ */
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <syslog.h>
+#ifdef HAVE_LIBURING
+#include <sys/eventfd.h>
+#include <liburing.h>
+#endif
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_err.h"
+#include "clixon_log.h"
+#include "clixon_debug.h"
+#include "clixon_event.h"
+#include "clixon_uring.h"
+
+#ifdef HAVE_LIBURING
+
+/* Number of entries of the rings */
+#define URING_ENTRIES 64
+
+/* Min size of a write request of a file */
+#define URING_WRITE_CHUNK (8*1024*1024)
+
+/* Size of a read request and number of reads in flight */
+#define URING_READ_CHUNK (1024*1024)
+#define URING_READ_DEPTH 32
+
+/* A file write: chain of writes, fsync and rename */
+struct uring_write {
+    int              uw_fd;       /* Temporary file */
+    char            *uw_buf;      /* Serialized file, malloced, freed on completion */
+    char            *uw_tmpfile;  /* Temporary file name */
+    char            *uw_filename; /* File name after rename */
+    int              uw_nsqe;     /* Requests not completed */
+    int              uw_err;      /* First errno of requests, or 0 */
+    clixon_uring_cb *uw_fn;       /* Completion callback */
+    void            *uw_arg;      /* Argument of callback */
+};
+
+/* A part of a file read */
+struct uring_read {
+    size_t rs_off;   /* Offset of next byte to read */
+    size_t rs_end;   /* End offset of part */
+};
+
+static struct io_uring _uring_wr;       /* Ring of writes, completions in event loop */
+static int             _uring_wr_fd = -1; /* eventfd of write completions */
+static int             _uring_wr_nr = 0;  /* Writes in flight */
+static struct io_uring _uring_rd;       /* Ring of synchronous reads */
+static int             _uring_rd_init = 0;
+
+static int uring_event(int fd, void *arg);
+
+/*! Create write ring and register its eventfd in the event loop
+ *
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+uring_wr_init(void)
+{
+    int ret;
+
+    if (_uring_wr_fd != -1)
+        return 0;
+    if ((ret = io_uring_queue_init(URING_ENTRIES, &_uring_wr, 0)) < 0){
+        clixon_err(OE_UNIX, -ret, "io_uring_queue_init");
+        return -1;
+    }
+    if ((_uring_wr_fd = eventfd(0, EFD_NONBLOCK|EFD_CLOEXEC)) < 0){
+        clixon_err(OE_UNIX, errno, "eventfd");
+        io_uring_queue_exit(&_uring_wr);
+        return -1;
+    }
+    if ((ret = io_uring_register_eventfd(&_uring_wr, _uring_wr_fd)) < 0){
+        clixon_err(OE_UNIX, -ret, "io_uring_register_eventfd");
+        goto fail;
+    }
+    if (clixon_event_reg_fd(_uring_wr_fd, uring_event, NULL, "io_uring") < 0)
+        goto fail;
+    return 0;
+ fail:
+    close(_uring_wr_fd);
+    _uring_wr_fd = -1;
+    io_uring_queue_exit(&_uring_wr);
+    return -1;
+}
+
+/*! Free write and call its callback
+ *
+ * If any request failed, the temporary file is removed and the file is unchanged
+ * @param[in]  uw   File write
+ * @retval     0    OK
+ * @retval    -1    Error in callback
+ */
+static int
+uring_write_done(struct uring_write *uw)
+{
+    int retval;
+
+    close(uw->uw_fd);
+    if (uw->uw_err){
+        clixon_log(NULL, LOG_WARNING, "%s: write of %s failed: %s",
+                   __func__, uw->uw_filename, strerror(uw->uw_err));
+        unlink(uw->uw_tmpfile);
+    }
+    else
+        clixon_debug(CLIXON_DBG_DATASTORE, "Wrote %s", uw->uw_filename);
+    _uring_wr_nr--;
+    retval = uw->uw_fn ? (*uw->uw_fn)(uw->uw_err, uw->uw_arg) : 0;
+    free(uw->uw_buf);
+    free(uw->uw_tmpfile);
+    free(uw->uw_filename);
+    free(uw);
+    return retval;
+}
+
+/*! Handle one write completion
+ *
+ * Requests after a failed or short write in the chain are canceled, the failed
+ * request gives the error
+ * @param[in]  cqe  Completion
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+uring_write_cqe(struct io_uring_cqe *cqe)
+{
+    struct uring_write *uw;
+
+    uw = (struct uring_write *)io_uring_cqe_get_data(cqe);
+    if (cqe->res < 0 &&
+        (uw->uw_err == 0 || uw->uw_err == ECANCELED))
+        uw->uw_err = -cqe->res;
+    if (--uw->uw_nsqe > 0)
+        return 0;
+    return uring_write_done(uw);
+}
+
+/*! Event loop callback of write completions
+ *
+ * @param[in]  fd   eventfd of write ring
+ * @param[in]  arg  Not used
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+uring_event(int   fd,
+            void *arg)
+{
+    int                  retval = -1;
+    uint64_t             v;
+    struct io_uring_cqe *cqe;
+
+    if (read(fd, &v, sizeof(v)) < 0 && errno != EAGAIN){
+        clixon_err(OE_UNIX, errno, "read");
+        goto done;
+    }
+    while (io_uring_peek_cqe(&_uring_wr, &cqe) == 0){
+        io_uring_cqe_seen(&_uring_wr, cqe);
+        if (uring_write_cqe(cqe) < 0)
+            goto done;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Write buffer to file in the background: write temporary file, sync and rename
+ *
+ * Requests are linked, so that the file is renamed only if all writes and the sync
+ * succeeded. The callback is called from the event loop when all are done, or from
+ * clixon_uring_drain.
+ * @param[in]  tmpfile   Temporary file, in the same file system as filename
+ * @param[in]  filename  File to replace
+ * @param[in]  buf       Malloced buffer, freed when done, also on error
+ * @param[in]  len       Length of buffer
+ * @param[in]  fn        Completion callback, or NULL
+ * @param[in]  arg       Argument of callback
+ * @retval     0         OK, writing
+ * @retval    -1         Error, nothing submitted
+ */
+int
+clixon_uring_write_file(const char      *tmpfile,
+                        const char      *filename,
+                        char            *buf,
+                        size_t           len,
+                        clixon_uring_cb *fn,
+                        void            *arg)
+{
+    int                 retval = -1;
+    struct uring_write *uw = NULL;
+    struct io_uring_sqe *sqe;
+    size_t              chunk;
+    size_t              off;
+    size_t              n;
+    int                 ret;
+
+    if (uring_wr_init() < 0)
+        goto done;
+    if ((uw = calloc(1, sizeof(*uw))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    uw->uw_fd = -1;
+    uw->uw_buf = buf;
+    buf = NULL;
+    uw->uw_fn = fn;
+    uw->uw_arg = arg;
+    if ((uw->uw_tmpfile = strdup(tmpfile)) == NULL ||
+        (uw->uw_filename = strdup(filename)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    if ((uw->uw_fd = open(tmpfile, O_WRONLY|O_CREAT|O_TRUNC|O_CLOEXEC, 0666)) < 0){
+        clixon_err(OE_UNIX, errno, "open(%s)", tmpfile);
+        goto done;
+    }
+    /* Writes, fsync and rename must fit in the submission queue */
+    chunk = len / (URING_ENTRIES - 2) + 1;
+    if (chunk < URING_WRITE_CHUNK)
+        chunk = URING_WRITE_CHUNK;
+    for (off = 0; off < len; off += n){
+        n = len - off < chunk ? len - off : chunk;
+        sqe = io_uring_get_sqe(&_uring_wr);
+        io_uring_prep_write(sqe, uw->uw_fd, uw->uw_buf + off, n, off);
+        sqe->flags |= IOSQE_IO_LINK;
+        io_uring_sqe_set_data(sqe, uw);
+        uw->uw_nsqe++;
+    }
+    sqe = io_uring_get_sqe(&_uring_wr);
+    io_uring_prep_fsync(sqe, uw->uw_fd, 0);
+    sqe->flags |= IOSQE_IO_LINK;
+    io_uring_sqe_set_data(sqe, uw);
+    uw->uw_nsqe++;
+    sqe = io_uring_get_sqe(&_uring_wr);
+    io_uring_prep_renameat(sqe, AT_FDCWD, uw->uw_tmpfile, AT_FDCWD, uw->uw_filename, 0);
+    io_uring_sqe_set_data(sqe, uw);
+    uw->uw_nsqe++;
+    if ((ret = io_uring_submit(&_uring_wr)) < 0){
+        clixon_err(OE_UNIX, -ret, "io_uring_submit");
+        goto done;
+    }
+    _uring_wr_nr++;
+    clixon_debug(CLIXON_DBG_DATASTORE, "Writing %s %zu bytes in %d requests",
+                 filename, len, uw->uw_nsqe);
+    uw = NULL;
+    retval = 0;
+ done:
+    if (buf)
+        free(buf);
+    if (uw){
+        if (uw->uw_fd != -1){
+            close(uw->uw_fd);
+            unlink(tmpfile);
+        }
+        if (uw->uw_buf)
+            free(uw->uw_buf);
+        if (uw->uw_tmpfile)
+            free(uw->uw_tmpfile);
+        if (uw->uw_filename)
+            free(uw->uw_filename);
+        free(uw);
+    }
+    return retval;
+}
+
+/*! Wait until all file writes are done, including writes started by callbacks
+ *
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+clixon_uring_drain(void)
+{
+    int                  retval = -1;
+    struct io_uring_cqe *cqe;
+    int                  ret;
+
+    while (_uring_wr_nr > 0){
+        if ((ret = io_uring_wait_cqe(&_uring_wr, &cqe)) < 0){
+            if (ret == -EINTR)
+                continue;
+            clixon_err(OE_UNIX, -ret, "io_uring_wait_cqe");
+            goto done;
+        }
+        io_uring_cqe_seen(&_uring_wr, cqe);
+        if (uring_write_cqe(cqe) < 0)
+            goto done;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Submit read of a part of a file
+ *
+ * @param[in]  fd   Open file
+ * @param[in]  buf  Buffer of file
+ * @param[in]  rs   Part of file, rs_off to rs_end
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+uring_read_prep(int                fd,
+                char              *buf,
+                struct uring_read *rs)
+{
+    struct io_uring_sqe *sqe;
+
+    if ((sqe = io_uring_get_sqe(&_uring_rd)) == NULL){
+        clixon_err(OE_UNIX, EAGAIN, "io_uring_get_sqe");
+        return -1;
+    }
+    io_uring_prep_read(sqe, fd, buf + rs->rs_off, rs->rs_end - rs->rs_off, rs->rs_off);
+    io_uring_sqe_set_data(sqe, rs);
+    return 0;
+}
+
+/*! Read file into buffer with several reads in flight
+ *
+ * Blocks until the whole file is read
+ * @param[in]  fd   Open regular file
+ * @param[out] buf  Buffer of at least len bytes
+ * @param[in]  len  Length of file
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+clixon_uring_read(int    fd,
+                  char  *buf,
+                  size_t len)
+{
+    int                  retval = -1;
+    struct uring_read    slots[URING_READ_DEPTH];
+    struct uring_read   *rs;
+    struct io_uring_cqe *cqe;
+    size_t               next = 0;  /* Offset of next part */
+    int                  inflight = 0;
+    int                  i;
+    int                  ret;
+
+    if (!_uring_rd_init){
+        if ((ret = io_uring_queue_init(URING_READ_DEPTH, &_uring_rd, 0)) < 0){
+            clixon_err(OE_UNIX, -ret, "io_uring_queue_init");
+            goto done;
+        }
+        _uring_rd_init = 1;
+    }
+    for (i = 0; i < URING_READ_DEPTH && next < len; i++){
+        rs = &slots[i];
+        rs->rs_off = next;
+        next += len - next < URING_READ_CHUNK ? len - next : URING_READ_CHUNK;
+        rs->rs_end = next;
+        if (uring_read_prep(fd, buf, rs) < 0)
+            goto done;
+        inflight++;
+    }
+    while (inflight > 0){
+        if ((ret = io_uring_submit_and_wait(&_uring_rd, 1)) < 0){
+            if (ret == -EINTR)
+                continue;
+            clixon_err(OE_UNIX, -ret, "io_uring_submit_and_wait");
+            goto done;
+        }
+        while (io_uring_peek_cqe(&_uring_rd, &cqe) == 0){
+            rs = (struct uring_read *)io_uring_cqe_get_data(cqe);
+            ret = cqe->res;
+            io_uring_cqe_seen(&_uring_rd, cqe);
+            inflight--;
+            if (ret < 0){
+                clixon_err(OE_UNIX, -ret, "read");
+                goto done;
+            }
+            if (ret == 0){
+                clixon_err(OE_UNIX, EIO, "read: file truncated");
+                goto done;
+            }
+            rs->rs_off += ret;
+            if (rs->rs_off == rs->rs_end){ /* Part done, reuse slot for next part */
+                if (next == len)
+                    continue;
+                rs->rs_off = next;
+                next += len - next < URING_READ_CHUNK ? len - next : URING_READ_CHUNK;
+                rs->rs_end = next;
+            }
+            /* Next part or rest of a short read */
+            if (uring_read_prep(fd, buf, rs) < 0)
+                goto done;
+            inflight++;
+        }
+    }
+    retval = 0;
+ done:
+    /* Wait for reads in flight before the buffer may be freed */
+    if (inflight > 0)
+        io_uring_submit(&_uring_rd);
+    while (inflight > 0 && io_uring_wait_cqe(&_uring_rd, &cqe) == 0){
+        io_uring_cqe_seen(&_uring_rd, cqe);
+        inflight--;
+    }
+    return retval;
+}
+
+/*! Tear down rings
+ *
+ * Writes in flight are completed first
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+clixon_uring_exit(void)
+{
+    int retval = -1;
+
+    if (_uring_wr_fd != -1){
+        if (clixon_uring_drain() < 0)
+            goto done;
+        clixon_event_unreg_fd(_uring_wr_fd, uring_event);
+        io_uring_unregister_eventfd(&_uring_wr);
+        close(_uring_wr_fd);
+        _uring_wr_fd = -1;
+        io_uring_queue_exit(&_uring_wr);
+    }
+    if (_uring_rd_init){
+        io_uring_queue_exit(&_uring_rd);
+        _uring_rd_init = 0;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+#else /* HAVE_LIBURING */
+
+int
+clixon_uring_write_file(const char      *tmpfile,
+                        const char      *filename,
+                        char            *buf,
+                        size_t           len,
+                        clixon_uring_cb *fn,
+                        void            *arg)
+{
+    free(buf);
+    clixon_err(OE_UNIX, ENOTSUP, "Not built with io_uring, see configure --with-liburing");
+    return -1;
+}
+
+int
+clixon_uring_drain(void)
+{
+    return 0;
+}
+
+int
+clixon_uring_read(int    fd,
+                  char  *buf,
+                  size_t len)
+{
+    clixon_err(OE_UNIX, ENOTSUP, "Not built with io_uring, see configure --with-liburing");
+    return -1;
+}
+
+int
+clixon_uring_exit(void)
+{
+    return 0;
+}
+
+#endif /* HAVE_LIBURING */
@@ -51,6 +51,9 @@
 #include <arpa/inet.h>
 #include <sys/param.h>
 #include <netinet/in.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
 
 /* cligen */
 #include <cligen/cligen.h>
@@ -79,9 +82,309 @@
 #include "clixon_xml_default.h"
 #include "clixon_xml_map.h"
 #include "clixon_xml_bind.h"
+#include "clixon_xml_sort.h"
 #include "clixon_validate_minmax.h"
 #include "clixon_validate.h"
 
+/* Name of dependency map in clixon handle, see xml_yang_validate_diff */
+#define VALIDATE_DEPMAP "validate-depmap"
+
+/*! Dependency of one yang data node on other nodes via its must, when and leafref xpaths
+ */
+struct validate_dep {
+    yang_stmt *vd_ys;      /* Yang data node with must, when or leafref path */
+    int        vd_nxpath;  /* Number of xpaths of vd_ys */
+    int        vd_any;     /* Depends on any node, eg wildcard or deref() */
+    char     **vd_names;   /* Node names referenced by the xpaths */
+    int        vd_len;     /* Length of vd_names */
+};
+
+/*! Dependency map of a yang spec, built on first use and cached in the clixon handle
+ */
+struct validate_depmap {
+    yang_stmt           *dm_yspec;  /* Top-level yang spec the map is built from */
+    struct validate_dep *dm_vec;    /* Vector of dependencies */
+    int                  dm_len;    /* Length of dm_vec */
+};
+
+/*! Index of referred nodes of an absolute leafref path in one data tree
+ *
+ * Built on first lookup during a validation of a whole tree, which then does not change,
+ * or on a tree kept with xml_leafref_index_keep
+ * @see leafref_index_begin
+ */
+struct leafref_index {
+    struct leafref_index *li_next;
+    yang_stmt            *li_ypath;  /* Leafref path statement */
+    yang_stmt            *li_ymod;   /* Module of referring leaf, gives namespace context */
+    cxobj                *li_xtop;   /* Top of data tree */
+    cxobj               **li_vec;    /* Referred nodes sorted by body value */
+    size_t                li_len;    /* Length of li_vec */
+};
+
+/*! Data tree whose leafref indexes are kept after validation, see xml_leafref_index_keep
+ */
+struct leafref_keep {
+    struct leafref_keep *lk_next;
+    cxobj               *lk_xtop;    /* Top of data tree */
+};
+
+/* Leafref indexes of an ongoing validation or of kept trees, and validation nesting level */
+static struct leafref_index *_leafref_index = NULL;
+static int                   _leafref_index_level = 0;
+static struct leafref_keep  *_leafref_keep = NULL;
+
+/*! Check if leafref indexes of a data tree are kept
+ */
+static int
+leafref_index_kept(cxobj *xtop)
+{
+    struct leafref_keep *lk;
+
+    for (lk = _leafref_keep; lk != NULL; lk = lk->lk_next)
+        if (lk->lk_xtop == xtop)
+            return 1;
+    return 0;
+}
+
+/*! Free leafref indexes, of one data tree or of all trees not kept
+ *
+ * @param[in]  xtop  Top of data tree, or NULL for all trees that are not kept
+ */
+static void
+leafref_index_free(cxobj *xtop)
+{
+    struct leafref_index **lip;
+    struct leafref_index  *li;
+
+    lip = &_leafref_index;
+    while ((li = *lip) != NULL){
+        if (xtop ? li->li_xtop != xtop : leafref_index_kept(li->li_xtop)){
+            lip = &li->li_next;
+            continue;
+        }
+        *lip = li->li_next;
+        if (li->li_vec)
+            free(li->li_vec);
+        free(li);
+    }
+}
+
+/*! Start using leafref indexes, the data tree must not change until leafref_index_end
+ */
+static void
+leafref_index_begin(void)
+{
+    _leafref_index_level++;
+}
+
+/*! Stop using leafref indexes, free them at outermost level unless the tree is kept
+ */
+static void
+leafref_index_end(void)
+{
+    if (--_leafref_index_level > 0)
+        return;
+    leafref_index_free(NULL);
+}
+
+/*! Check if leafref path refers to the same nodes regardless of the context node
+ *
+ * That is, an absolute path without predicates (which may use current())
+ */
+static int
+leafref_index_path(const char *path_arg)
+{
+    return path_arg[0] == '/' && strchr(path_arg, '[') == NULL;
+}
+
+/*! Top of data tree, same as XP_ABSPATH in xpath evaluation
+ */
+static cxobj *
+leafref_index_top(cxobj *xt)
+{
+    cxobj *xtop = xt;
+
+#ifdef XML_PARENT_CANDIDATE
+    while (xml_parent(xtop) != NULL || xml_parent_candidate(xtop) != NULL)
+        xtop = xml_parent(xtop)?xml_parent(xtop):xml_parent_candidate(xtop);
+#else
+    while (xml_parent(xtop) != NULL)
+        xtop = xml_parent(xtop);
+#endif
+    return xtop;
+}
+
+/*! Qsort function of referred nodes on body value
+ */
+static int
+leafref_index_cmp(const void *a,
+                  const void *b)
+{
+    return strcmp(xml_body(*(cxobj **)a), xml_body(*(cxobj **)b));
+}
+
+/*! Find referred node of an absolute leafref path using an index of the data tree
+ *
+ * @param[in]  xt       XML leaf node of type leafref
+ * @param[in]  ys       Yang spec of leaf
+ * @param[in]  ypath    Leafref path statement
+ * @param[in]  body     Value of xt
+ * @param[out] xrefp    Referred node, or NULL
+ * @retval     1        Found
+ * @retval     0        Not found
+ * @retval    -1        Error
+ */
+static int
+leafref_index_lookup(cxobj      *xt,
+                     yang_stmt  *ys,
+                     yang_stmt  *ypath,
+                     const char *body,
+                     cxobj     **xrefp)
+{
+    int                   retval = -1;
+    struct leafref_index *li;
+    yang_stmt            *ymod;
+    cxobj                *xtop;
+    cxobj               **xvec = NULL;
+    size_t                xlen = 0;
+    cvec                 *nsc = NULL;
+    size_t                i;
+    size_t                lo;
+    size_t                hi;
+    size_t                mid;
+    int                   cmp;
+
+    *xrefp = NULL;
+    ymod = ys_module(ys);
+    xtop = leafref_index_top(xt);
+    for (li = _leafref_index; li != NULL; li = li->li_next)
+        if (li->li_ypath == ypath && li->li_ymod == ymod && li->li_xtop == xtop)
+            break;
+    if (li == NULL){
+        if ((li = malloc(sizeof(*li))) == NULL){
+            clixon_err(OE_UNIX, errno, "malloc");
+            goto done;
+        }
+        memset(li, 0, sizeof(*li));
+        li->li_ypath = ypath;
+        li->li_ymod = ymod;
+        li->li_xtop = xtop;
+        li->li_next = _leafref_index;
+        _leafref_index = li;
+        if ((nsc = xml_nsctx_yang_shared(ys)) == NULL)
+            goto done;
+        if (xpath_vec(xt, nsc, "%s", &xvec, &xlen, yang_argument_get(ypath)) < 0)
+            goto done;
+        /* Keep nodes with body only, sorted on body */
+        for (i = 0; i < xlen; i++)
+            if (xml_body(xvec[i]) != NULL)
+                xvec[li->li_len++] = xvec[i];
+        qsort(xvec, li->li_len, sizeof(*xvec), leafref_index_cmp);
+        li->li_vec = xvec;
+        xvec = NULL;
+    }
+    lo = 0;
+    hi = li->li_len;
+    while (lo < hi){
+        mid = (lo + hi) / 2;
+        if ((cmp = strcmp(xml_body(li->li_vec[mid]), body)) == 0){
+            *xrefp = li->li_vec[mid];
+            break;
+        }
+        if (cmp < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    retval = *xrefp != NULL;
+ done:
+    if (xvec)
+        free(xvec);
+    return retval;
+}
+
+/*! Keep leafref indexes of a data tree after validation and use them in deref()
+ *
+ * Indexes of referred nodes are then built on first use and reused until
+ * xml_leafref_index_drop is called. The tree must not be changed until then.
+ * @param[in]  xtop   Top of data tree
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see xml_leafref_index_drop
+ */
+int
+xml_leafref_index_keep(cxobj *xtop)
+{
+    struct leafref_keep *lk;
+
+    if (leafref_index_kept(xtop))
+        return 0;
+    if ((lk = malloc(sizeof(*lk))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        return -1;
+    }
+    lk->lk_xtop = xtop;
+    lk->lk_next = _leafref_keep;
+    _leafref_keep = lk;
+    return 0;
+}
+
+/*! Free leafref indexes of a data tree and stop keeping them
+ *
+ * Must be called before a kept tree is modified or freed
+ * @param[in]  xtop   Top of data tree, or NULL
+ * @see xml_leafref_index_keep
+ */
+void
+xml_leafref_index_drop(cxobj *xtop)
+{
+    struct leafref_keep **lkp;
+    struct leafref_keep  *lk;
+
+    for (lkp = &_leafref_keep; (lk = *lkp) != NULL; lkp = &lk->lk_next)
+        if (lk->lk_xtop == xtop)
+            break;
+    if (lk == NULL)
+        return;
+    *lkp = lk->lk_next;
+    free(lk);
+    if (_leafref_index_level == 0)
+        leafref_index_free(xtop);
+}
+
+/*! Find the node referred by a leafref value using a leafref index, if possible
+ *
+ * An index is used for absolute leafref paths without predicates during validation
+ * and in trees kept with xml_leafref_index_keep.
+ * @param[in]  xt       XML leaf node of type leafref
+ * @param[in]  ys       Yang spec of leaf
+ * @param[in]  ypath    Leafref path statement
+ * @param[out] xrefp    Referred node with the same value as xt, or NULL if not found
+ * @retval     1        Index used, xrefp is set
+ * @retval     0        No index, evaluate the path instead
+ * @retval    -1        Error
+ */
+int
+xml_leafref_index_lookup(cxobj      *xt,
+                         yang_stmt  *ys,
+                         yang_stmt  *ypath,
+                         cxobj     **xrefp)
+{
+    char *body;
+
+    *xrefp = NULL;
+    if (!leafref_index_path(yang_argument_get(ypath)))
+        return 0;
+    if (_leafref_index_level == 0 && !leafref_index_kept(leafref_index_top(xt)))
+        return 0;
+    if ((body = xml_body(xt)) == NULL)
+        return 1;
+    if (leafref_index_lookup(xt, ys, ypath, body, xrefp) < 0)
+        return -1;
+    return 1;
+}
+
 /*! Validate xml node of type leafref, ensure the value is one of that path's reference
  *
  * @param[in]  xt    XML leaf node of type leafref
@@ -135,6 +438,7 @@ validate_leafref(cxobj     *xt,
     char        *path_arg;
     cg_var      *cv;
     int          require_instance = 1;
+    int          found;
 
     /* require instance */
     if ((yreqi = yang_find(ytype, Y_REQUIRE_INSTANCE, NULL)) != NULL){
@@ -162,18 +466,25 @@ validate_leafref(cxobj     *xt,
     }
     if ((leafrefbody = xml_body(xt)) == NULL)
         goto ok;
-    if (xml_nsctx_yang(ys, &nsc) < 0)
-        goto done;
-    if (xpath_vec(xt, nsc, "%s", &xvec, &xlen, path_arg) < 0)
-        goto done;
-    for (i = 0; i < xlen; i++) {
-        x = xvec[i];
-        if ((leafbody = xml_body(x)) == NULL)
-            continue;
-        if (strcmp(leafbody, leafrefbody) == 0)
-            break;
+    if (_leafref_index_level > 0 && leafref_index_path(path_arg)){
+        if ((found = leafref_index_lookup(xt, ys, ypath, leafrefbody, &x)) < 0)
+            goto done;
+    }
+    else {
+        if ((nsc = xml_nsctx_yang_shared(ys)) == NULL)
+            goto done;
+        if (xpath_vec(xt, nsc, "%s", &xvec, &xlen, path_arg) < 0)
+            goto done;
+        for (i = 0; i < xlen; i++) {
+            x = xvec[i];
+            if ((leafbody = xml_body(x)) == NULL)
+                continue;
+            if (strcmp(leafbody, leafrefbody) == 0)
+                break;
+        }
+        found = (i < xlen);
     }
-    if (i==xlen){
+    if (!found){
         if ((cberr = cbuf_new()) == NULL){
             clixon_err(OE_UNIX, errno, "cbuf_new");
             goto done;
@@ -192,8 +503,6 @@ validate_leafref(cxobj     *xt,
  done:
     if (cberr)
         cbuf_free(cberr);
-    if (nsc)
-        xml_nsctx_free(nsc);
     if (xvec)
         free(xvec);
     return retval;
@@ -240,17 +549,10 @@ validate_identityref(cxobj     *xt,
     char       *id = NULL;
     cbuf       *cberr = NULL;
     cbuf       *cb = NULL;
-    cvec       *idrefvec; /* Derived identityref list: (module:id)**/
     yang_stmt  *ymod;
 
-    if ((cb = cbuf_new()) == NULL){
-        clixon_err(OE_UNIX, errno, "cbuf_new");
-        goto done;
-    }
-    if ((cberr = cbuf_new()) == NULL){
-        clixon_err(OE_UNIX, errno, "cbuf_new");
+    if ((cb = clixon_cbuf_borrow(0)) == NULL)
         goto done;
-    }
     /* Get idref value. Then see if this value is derived from ytype.
      */
     if ((node = xml_body(xt)) == NULL){ /* It may not be empty */
@@ -280,6 +582,10 @@ validate_identityref(cxobj     *xt,
         ymod = yang_find_module_by_prefix_yspec(ys_spec(ys), prefix);
     }
     if (ymod == NULL){
+        if ((cberr = cbuf_new()) == NULL){
+            clixon_err(OE_UNIX, errno, "cbuf_new");
+            goto done;
+        }
         cprintf(cberr, "Identityref validation failed, %s not derived from %s in %s.yang",
                 node,
                 yang_argument_get(ybaseid),
@@ -293,12 +599,14 @@ validate_identityref(cxobj     *xt,
     }
     cprintf(cb, "%s:%s", yang_argument_get(ymod), id);
     idref = cbuf_get(cb);
-    /* Here check if node is in the derived node list of the base identity
-     * The derived node list is a cvec computed XXX
+    /* Here check if node is in the derived node set of the base identity
+     * The derived node set is computed in ys_populate_identity
      */
-    idrefvec = yang_cvec_get(ybaseid);
-    if (cvec_find(idrefvec, idref) == NULL){
-
+    if (!yang_identity_derived(ybaseid, idref)){
+        if ((cberr = cbuf_new()) == NULL){
+            clixon_err(OE_UNIX, errno, "cbuf_new");
+            goto done;
+        }
         cprintf(cberr, "Identityref validation failed, %s not derived from %s in %s.yang",
                 node,
                 yang_argument_get(ybaseid),
@@ -315,7 +623,7 @@ validate_identityref(cxobj     *xt,
     if (cberr)
         cbuf_free(cberr);
     if (cb)
-        cbuf_free(cb);
+        clixon_cbuf_release(cb);
     if (id)
         free(id);
     if (prefix)
@@ -1025,6 +1333,7 @@ xml_yang_validate_add(clixon_handle h,
     cg_var      *cv0;
     enum cv_type cvtype;
     validate_level vl = VL_NONE;
+    yang_stmt   *ysub = NULL;
 
     if (clicon_option_bool(h, "CLICON_YANG_SCHEMA_MOUNT")){
         if ((ret = xml_yang_mount_get(h, xt, &vl, NULL, NULL)) < 0)
@@ -1045,6 +1354,9 @@ xml_yang_validate_add(clixon_handle h,
         case Y_LEAF:
             /* fall thru */
         case Y_LEAF_LIST:
+            /* Unchanged union value already validated, see xml_union_type */
+            if (xml_union_type(xt) != NULL)
+                break;
             /* validate value against ranges, etc */
             if ((cv0 = yang_cv_get(yt)) == NULL)
                 break;
@@ -1073,13 +1385,16 @@ xml_yang_validate_add(clixon_handle h,
                     goto fail;
                 }
             }
-            if ((ret = ys_cv_validate(h, cv, yt, NULL, &reason)) < 0)
+            if ((ret = ys_cv_validate(h, cv, yt, &ysub, &reason)) < 0)
                 goto done;
             if (ret == 0){
                 if (xret && netconf_bad_element_xml(xret, "application",  yang_argument_get(yt), reason) < 0)
                     goto done;
                 goto fail;
             }
+            /* Sub-type is a union member type if union */
+            if (ysub && yang_keyword_get(ysub) == Y_TYPE)
+                xml_union_type_set(xt, ysub);
             break;
         default:
             break;
@@ -1105,6 +1420,30 @@ xml_yang_validate_add(clixon_handle h,
     goto done;
 }
 
+/*! Check keys of a list entry, no recursion
+ *
+ * @param[in]  xt     XML node
+ * @param[out] xret   Error XML tree. Free with xml_free after use
+ * @retval     1      OK
+ * @retval     0      Validation failed (xret set)
+ * @retval    -1      Error
+ * @see xml_yang_validate_list_key_only  Recursive
+ */
+int
+xml_yang_validate_list_key(cxobj  *xt,
+                           cxobj **xret)
+{
+    yang_stmt *yt;   /* yang spec of xt going in */
+
+    /* if not given by argument (override) use default link 
+       and !Node has a config sub-statement and it is false */
+    if ((yt = xml_spec(xt)) != NULL &&
+        yang_config(yt) != 0 &&
+        yang_keyword_get(yt) == Y_LIST)
+        return check_list_key(xt, yt, xret);
+    return 1;
+}
+
 /*! Some checks done only at edit_config, eg keys in lists
  *
  * @param[in]  xt     XML tree
@@ -1117,20 +1456,13 @@ xml_yang_validate_list_key_only(cxobj        *xt,
                                 cxobj       **xret)
 {
     int        retval = -1;
-    yang_stmt *yt;   /* yang spec of xt going in */
     int        ret;
     cxobj     *x;
 
-    /* if not given by argument (override) use default link 
-       and !Node has a config sub-statement and it is false */
-    if ((yt = xml_spec(xt)) != NULL &&
-        yang_config(yt) != 0 &&
-        yang_keyword_get(yt) == Y_LIST){
-        if ((ret = check_list_key(xt, yt, xret)) < 0)
-            goto done;
-        if (ret == 0)
-            goto fail;
-    }
+    if ((ret = xml_yang_validate_list_key(xt, xret)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
     x = NULL;
     while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL) {
         if ((ret = xml_yang_validate_list_key_only(x, xret)) < 0)
@@ -1209,30 +1541,22 @@ xml_yang_validate_leaf_union(clixon_handle h,
     goto done;
 }
 
-/*! Validate a single XML node with yang specification for all (not only added) entries
+/*! Validate a single XML node with yang specification for all entries, optionally recursive
  *
- * 1. Check leafrefs. Eg you delete a leaf and a leafref references it.
- * @param[in]  xt  XML node to be validated
- * @param[out] xret  Error XML tree (if retval=0). Free with xml_free after use
- * @retval     1     Validation OK
- * @retval     0     Validation failed (cbret set)
- * @retval    -1     Error
- * @code
- *   cxobj *x;
- *   cbuf *xret = NULL;
- *   if ((ret = xml_yang_validate_all(h, x, &xret)) < 0)
- *      err;
- *   if (ret == 0)
- *      fail;
- *   xml_free(xret);
- * @endcode
- * @see xml_yang_validate_add
- * @see xml_yang_validate_rpc
+ * @param[in]  h       Clixon handle
+ * @param[in]  xt      XML node to be validated
+ * @param[in]  recurse If set, also validate all children recursively
+ * @param[out] xret    Error XML tree (if retval=0). Free with xml_free after use
+ * @retval     1       Validation OK
+ * @retval     0       Validation failed (cbret set)
+ * @retval    -1       Error
+ * @see xml_yang_validate_all
  */
-int
-xml_yang_validate_all(clixon_handle h,
-                      cxobj        *xt,
-                      cxobj       **xret)
+static int
+xml_yang_validate_all0(clixon_handle h,
+                       cxobj        *xt,
+                       int           recurse,
+                       cxobj       **xret)
 {
     int        retval = -1;
     yang_stmt *yt;  /* yang node associated with xt */
@@ -1246,11 +1570,12 @@ xml_yang_validate_all(clixon_handle h,
     cxobj     *xp;
     char      *ns = NULL;
     cbuf      *cb = NULL;
-    cvec      *nsc = NULL;
     int        hit = 0;
     validate_level vl = VL_NONE;
     int        saw_node = 0;
     int        inext;
+    xpath_tree *xptree;
+    cvec      *nsc;        /* must namespace context, cached */
 
     if (clicon_option_bool(h, "CLICON_YANG_SCHEMA_MOUNT")){
         if ((ret = xml_yang_mount_get(h, xt, &vl, NULL, NULL)) < 0)
@@ -1359,11 +1684,14 @@ xml_yang_validate_all(clixon_handle h,
             /* the context node is the node in the accessible tree for
              * which the "must" statement is defined. 
              * The set of namespace declarations is the set of all "import" statements' 
+             * The xpath is parsed once and cached in the must statement
              */
-            if (xml_nsctx_yang(yc, &nsc) < 0)
+            if (yang_xpath_cache_get(yc, 0, NULL, &xptree, &nsc) < 0)
                 goto done;
+            if (xptree == NULL)
+                continue;
             clixon_debug(CLIXON_DBG_XPATH, "namespace '%s'", xml_nsctx_get(nsc, NULL));
-            nr = xpath_vec_bool(xt, nsc, "%s", xpath);
+            nr = xpath_tree_vec_bool(xt, nsc, xptree);
             clixon_debug(CLIXON_DBG_XPATH, "result %s", (nr < 0 ? "error" : (nr != 0 ? "true" : "false")));
             if (nr < 0)
                 goto done;
@@ -1380,18 +1708,16 @@ xml_yang_validate_all(clixon_handle h,
                     goto done;
                 goto fail;
             }
-            if (nsc){
-                xml_nsctx_free(nsc);
-                nsc = NULL;
-            }
         }
     }
-    x = NULL;
-    while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL) {
-        if ((ret = xml_yang_validate_all(h, x, xret)) < 0)
-            goto done;
-        if (ret == 0)
-            goto fail;
+    if (recurse){
+        x = NULL;
+        while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL) {
+            if ((ret = xml_yang_validate_all(h, x, xret)) < 0)
+                goto done;
+            if (ret == 0)
+                goto fail;
+        }
     }
     /* Check unique and min-max after choice test for example*/
     if (yang_config(yt) != 0){
@@ -1408,38 +1734,930 @@ xml_yang_validate_all(clixon_handle h,
         free(xpath1);
     if (cb)
         cbuf_free(cb);
-    if (nsc)
-        xml_nsctx_free(nsc);
     return retval;
  fail:
     retval = 0;
     goto done;
 }
 
-/*! Validate a single XML node with yang specification
+/*! Validate a single XML node with yang specification for all (not only added) entries
  *
- * @param[in]  h     Clixon handle
- * @param[out] xret   Error XML tree (if ret == 0). Free with xml_free after use
- * @retval     1      Validation OK
- * @retval     0      Validation failed (xret set)
- * @retval    -1      Error
+ * 1. Check leafrefs. Eg you delete a leaf and a leafref references it.
+ * @param[in]  xt  XML node to be validated
+ * @param[out] xret  Error XML tree (if retval=0). Free with xml_free after use
+ * @retval     1     Validation OK
+ * @retval     0     Validation failed (cbret set)
+ * @retval    -1     Error
+ * @code
+ *   cxobj *x;
+ *   cbuf *xret = NULL;
+ *   if ((ret = xml_yang_validate_all(h, x, &xret)) < 0)
+ *      err;
+ *   if (ret == 0)
+ *      fail;
+ *   xml_free(xret);
+ * @endcode
+ * @see xml_yang_validate_add
+ * @see xml_yang_validate_rpc
  */
 int
-xml_yang_validate_all_top(clixon_handle h,
-                          cxobj        *xt,
-                          cxobj       **xret)
+xml_yang_validate_all(clixon_handle h,
+                      cxobj        *xt,
+                      cxobj       **xret)
 {
-    int    ret;
-    cxobj *x;
+    return xml_yang_validate_all0(h, xt, 1, xret);
+}
 
-    x = NULL;
-    while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL) {
-        if ((ret = xml_yang_validate_all(h, x, xret)) < 1)
-            return ret;
+/*! Move rpc-errors of an error tree into an existing error tree
+ *
+ * @param[in,out] xret  Error tree, set to xerr if NULL
+ * @param[in]     xerr  Error tree (rpc-reply), consumed
+ * @retval        0     OK
+ * @retval       -1     Error
+ */
+static int
+validate_error_merge(cxobj **xret,
+                     cxobj  *xerr)
+{
+    int    retval = -1;
+    cxobj *xc;
+
+    if (*xret == NULL){
+        *xret = xerr;
+        goto ok;
     }
-    if ((ret = xml_yang_validate_minmax(xt, 0, xret)) < 1)
-        return ret;
-    return 1;
+    while ((xc = xml_find_type(xerr, NULL, "rpc-error", CX_ELMNT)) != NULL)
+        if (xml_addsub(*xret, xc) < 0)
+            goto done;
+    xml_free(xerr);
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Validate one top-level subtree in a forked worker and write result to a pipe
+ *
+ * The result is a status character, '1' ok, '0' failed followed by the error tree,
+ * or '-' error followed by the error reason.
+ * @param[in]  h   Clixon handle
+ * @param[in]  x   Top-level subtree
+ * @param[in]  fd  Write end of pipe
+ * @note Does not return
+ */
+static void
+validate_worker(clixon_handle h,
+                cxobj        *x,
+                int           fd)
+{
+    cxobj  *xerr = NULL;
+    cbuf   *cb = NULL;
+    int     ret;
+    char   *p;
+    size_t  len;
+    ssize_t n;
+
+    if ((cb = cbuf_new()) == NULL)
+        _exit(1);
+    if ((ret = xml_yang_validate_all(h, x, &xerr)) < 0)
+        cprintf(cb, "-%s", clixon_err_reason()?clixon_err_reason():"");
+    else if (ret == 0){
+        cprintf(cb, "0");
+        if (xerr && clixon_xml2cbuf(cb, xerr, 0, 0, NULL, -1, 0) < 0)
+            _exit(1);
+    }
+    else
+        cprintf(cb, "1");
+    p = cbuf_get(cb);
+    len = cbuf_len(cb);
+    while (len > 0){
+        if ((n = write(fd, p, len)) < 0){
+            if (errno == EINTR)
+                continue;
+            _exit(1);
+        }
+        p += n;
+        len -= n;
+    }
+    close(fd);
+    _exit(0);
+}
+
+/*! Read result of validation worker and reap it
+ *
+ * @param[in]  pid   Worker process
+ * @param[in]  fd    Read end of pipe, closed on return
+ * @param[out] xerr  Error tree if validation failed
+ * @retval     1     Validation OK
+ * @retval     0     Validation failed (xerr set)
+ * @retval    -1     Error
+ */
+static int
+validate_worker_result(pid_t   pid,
+                       int     fd,
+                       cxobj **xerr)
+{
+    int     retval = -1;
+    cbuf   *cb = NULL;
+    char    buf[4096];
+    ssize_t n;
+    int     status;
+    int     reaped = 0;
+    char   *str;
+    cxobj  *xt = NULL;
+
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    while ((n = read(fd, buf, sizeof(buf))) != 0){
+        if (n < 0){
+            if (errno == EINTR)
+                continue;
+            clixon_err(OE_UNIX, errno, "read");
+            goto done;
+        }
+        if (cbuf_append_buf(cb, buf, n) < 0){
+            clixon_err(OE_UNIX, errno, "cbuf_append_buf");
+            goto done;
+        }
+    }
+    reaped++;
+    if (waitpid(pid, &status, 0) < 0){
+        clixon_err(OE_UNIX, errno, "waitpid");
+        goto done;
+    }
+    str = cbuf_get(cb);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0 || cbuf_len(cb) == 0){
+        clixon_err(OE_XML, 0, "Validation worker %d failed", pid);
+        goto done;
+    }
+    switch (str[0]){
+    case '1':
+        retval = 1;
+        break;
+    case '0':
+        if (cbuf_len(cb) > 1){
+            if (clixon_xml_parse_string(str+1, YB_NONE, NULL, &xt, NULL) < 0)
+                goto done;
+            if ((*xerr = xml_child_i_type(xt, 0, CX_ELMNT)) != NULL)
+                xml_rm(*xerr);
+        }
+        retval = 0;
+        break;
+    default:
+        clixon_err(OE_XML, 0, "Validation worker: %s", str+1);
+        break;
+    }
+ done:
+    if (!reaped)
+        waitpid(pid, &status, 0);
+    close(fd);
+    if (xt)
+        xml_free(xt);
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Validate top-level subtrees in parallel using forked worker processes
+ *
+ * Each top-level subtree is validated by a worker with a copy-on-write image of the tree,
+ * and at most nworkers at a time. Results are read in document order so the
+ * outcome is the same as a sequential validation.
+ * @param[in]  h        Clixon handle
+ * @param[in]  xt       Top-level XML tree
+ * @param[in]  nworkers Max number of concurrent workers
+ * @param[in]  all      Collect errors of all subtrees, not only the first
+ * @param[out] xret     Error XML tree (if retval=0). Free with xml_free after use
+ * @retval     1        Validation OK
+ * @retval     0        Validation failed (xret set)
+ * @retval    -1        Error
+ */
+static int
+validate_all_top_parallel(clixon_handle h,
+                          cxobj        *xt,
+                          int           nworkers,
+                          int           all,
+                          cxobj       **xret)
+{
+    int     retval = -1;
+    int     len;
+    pid_t  *pids = NULL;
+    int    *fds = NULL;
+    int     fd[2];
+    int     nstarted = 0;
+    int     i;
+    int     ret;
+    int     failed = 0;
+    int     nfail = 0;
+    cxobj  *xerr;
+
+    len = xml_child_nr_type(xt, CX_ELMNT);
+    if ((pids = calloc(len, sizeof(pid_t))) == NULL ||
+        (fds = calloc(len, sizeof(int))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    for (i = 0; i < len; i++){
+        /* Start workers up to nworkers ahead of the one being read */
+        while (nstarted < len && nstarted < i + nworkers && !failed){
+            if (pipe(fd) < 0){
+                clixon_err(OE_UNIX, errno, "pipe");
+                goto done;
+            }
+            if ((pids[nstarted] = fork()) < 0){
+                clixon_err(OE_UNIX, errno, "fork");
+                close(fd[0]);
+                close(fd[1]);
+                goto done;
+            }
+            if (pids[nstarted] == 0){ /* Worker */
+                close(fd[0]);
+                validate_worker(h, xml_child_i_type(xt, nstarted, CX_ELMNT), fd[1]);
+            }
+            close(fd[1]);
+            fds[nstarted++] = fd[0];
+        }
+        if (i >= nstarted)
+            break;
+        xerr = NULL;
+        ret = validate_worker_result(pids[i], fds[i], &xerr);
+        pids[i] = 0;
+        if (ret < 0)
+            goto done;
+        if (ret == 0){
+            nfail++;
+            if (xerr && xret && validate_error_merge(xret, xerr) < 0)
+                goto done;
+            else if (xerr && xret == NULL)
+                xml_free(xerr);
+            if (!all)
+                failed++;
+        }
+        if (failed)
+            break;
+    }
+    retval = nfail ? 0 : 1;
+ done:
+    /* Stop and reap workers not read, eg after first error */
+    for (i = 0; i < nstarted; i++){
+        if (pids[i] > 0){
+            kill(pids[i], SIGKILL);
+            waitpid(pids[i], NULL, 0);
+            close(fds[i]);
+        }
+    }
+    if (pids)
+        free(pids);
+    if (fds)
+        free(fds);
+    return retval;
+}
+
+/*! Validate a single XML node with yang specification
+ *
+ * @param[in]  h     Clixon handle
+ * @param[out] xret   Error XML tree (if ret == 0). Free with xml_free after use
+ * @retval     1      Validation OK
+ * @retval     0      Validation failed (xret set)
+ * @retval    -1      Error
+ * @note Leafrefs with absolute paths are checked against an index of referred values
+ * @note If CLICON_VALIDATE_WORKERS > 1, top-level subtrees are validated in parallel
+ * @note If CLICON_VALIDATE_ALL_ERRORS is set, errors of all top-level subtrees are returned
+ */
+int
+xml_yang_validate_all_top(clixon_handle h,
+                          cxobj        *xt,
+                          cxobj       **xret)
+{
+    int    ret = 1;
+    cxobj *x;
+    cxobj *xerr = NULL;
+    int    nworkers;
+    int    all;
+    int    failed = 0;
+
+    nworkers = clicon_option_int(h, "CLICON_VALIDATE_WORKERS");
+    all = clicon_option_bool(h, "CLICON_VALIDATE_ALL_ERRORS");
+    leafref_index_begin();
+    if (nworkers > 1 && xml_child_nr_type(xt, CX_ELMNT) > 1){
+        if ((ret = validate_all_top_parallel(h, xt, nworkers, all, xret)) < 0)
+            goto done;
+        if (ret == 0){
+            if (!all)
+                goto done;
+            failed++;
+        }
+    }
+    else {
+        x = NULL;
+        while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL) {
+            if (!all){
+                if ((ret = xml_yang_validate_all(h, x, xret)) < 1)
+                    goto done;
+                continue;
+            }
+            xerr = NULL;
+            if ((ret = xml_yang_validate_all(h, x, &xerr)) < 0)
+                goto done;
+            if (ret == 0){
+                failed++;
+                if (xerr && xret && validate_error_merge(xret, xerr) < 0){
+                    ret = -1;
+                    goto done;
+                }
+                else if (xerr && xret == NULL)
+                    xml_free(xerr);
+            }
+        }
+    }
+    if (!all)
+        ret = xml_yang_validate_minmax(xt, 0, xret);
+    else {
+        xerr = NULL;
+        if ((ret = xml_yang_validate_minmax(xt, 0, &xerr)) < 0)
+            goto done;
+        if (ret == 0){
+            failed++;
+            if (xerr && xret && validate_error_merge(xret, xerr) < 0){
+                ret = -1;
+                goto done;
+            }
+            else if (xerr && xret == NULL)
+                xml_free(xerr);
+        }
+        ret = failed ? 0 : 1;
+    }
+ done:
+    leafref_index_end();
+    return ret;
+}
+
+/*! Add node name to dependency, unless already there
+ *
+ * @param[in]  vd    Dependency
+ * @param[in]  name  Node name
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+validate_dep_name_add(struct validate_dep *vd,
+                      const char          *name)
+{
+    int    i;
+    char **names;
+
+    for (i=0; i<vd->vd_len; i++)
+        if (strcmp(vd->vd_names[i], name) == 0)
+            return 0;
+    if ((names = realloc(vd->vd_names, (vd->vd_len+1)*sizeof(char*))) == NULL){
+        clixon_err(OE_UNIX, errno, "realloc");
+        return -1;
+    }
+    vd->vd_names = names;
+    if ((vd->vd_names[vd->vd_len] = strdup(name)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        return -1;
+    }
+    vd->vd_len++;
+    return 0;
+}
+
+/*! Collect node names from a parsed xpath
+ *
+ * Wildcards, node-tests such as node() and the deref() function may reach any node,
+ * and then the dependency is marked as "any".
+ * @param[in]  xs    Parsed xpath tree
+ * @param[in]  vd    Dependency
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+validate_dep_xpath_tree(xpath_tree          *xs,
+                        struct validate_dep *vd)
+{
+    if (xs == NULL)
+        return 0;
+    switch (xs->xs_type){
+    case XP_NODE:
+        if (xs->xs_s1 == NULL || strcmp(xs->xs_s1, "*") == 0)
+            vd->vd_any = 1;
+        else if (validate_dep_name_add(vd, xs->xs_s1) < 0)
+            return -1;
+        break;
+    case XP_NODE_FN:
+        vd->vd_any = 1;
+        break;
+    case XP_PRIME_FN:
+        if (xs->xs_s0 && strcmp(xs->xs_s0, "deref") == 0)
+            vd->vd_any = 1;
+        break;
+    default:
+        break;
+    }
+    if (validate_dep_xpath_tree(xs->xs_c0, vd) < 0)
+        return -1;
+    if (validate_dep_xpath_tree(xs->xs_c1, vd) < 0)
+        return -1;
+    return 0;
+}
+
+/*! Parse an xpath of a must, when or leafref path statement and add it to dependency
+ *
+ * @param[in]  xpath  XPath string
+ * @param[in]  vd     Dependency
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+validate_dep_xpath(char                *xpath,
+                   struct validate_dep *vd)
+{
+    int         retval = -1;
+    xpath_tree *xs = NULL;
+
+    if (xpath == NULL)
+        goto ok;
+    vd->vd_nxpath++;
+    if (xpath_parse(xpath, &xs) < 0)
+        goto done;
+    if (validate_dep_xpath_tree(xs, vd) < 0)
+        goto done;
+ ok:
+    retval = 0;
+ done:
+    if (xs)
+        xpath_tree_free(xs);
+    return retval;
+}
+
+/*! Add leafref paths of a resolved type to dependency, including union members
+ *
+ * @param[in]  ys     Yang leaf or leaf-list
+ * @param[in]  ytype  Resolved yang type statement
+ * @param[in]  vd     Dependency
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+validate_dep_type(yang_stmt           *ys,
+                  yang_stmt           *ytype,
+                  struct validate_dep *vd)
+{
+    int        retval = -1;
+    char      *restype;
+    yang_stmt *ypath;
+    yang_stmt *ytsub;
+    yang_stmt *yrestype;
+    int        inext;
+
+    restype = yang_argument_get(ytype);
+    if (strcmp(restype, "leafref") == 0){
+        if ((ypath = yang_find(ytype, Y_PATH, NULL)) != NULL &&
+            validate_dep_xpath(yang_argument_get(ypath), vd) < 0)
+            goto done;
+    }
+    else if (strcmp(restype, "union") == 0){
+        inext = 0;
+        while ((ytsub = yn_iter(ytype, &inext)) != NULL){
+            if (yang_keyword_get(ytsub) != Y_TYPE)
+                continue;
+            if (yang_type_resolve(ys, ys, ytsub, &yrestype,
+                                  NULL, NULL, NULL, NULL, NULL) < 0)
+                goto done;
+            if (yrestype && validate_dep_type(ys, yrestype, vd) < 0)
+                goto done;
+        }
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Free dependency map
+ */
+static int
+validate_depmap_free(struct validate_depmap *dm)
+{
+    struct validate_dep *vd;
+    int                  i;
+    int                  j;
+
+    for (i=0; i<dm->dm_len; i++){
+        vd = &dm->dm_vec[i];
+        for (j=0; j<vd->vd_len; j++)
+            free(vd->vd_names[j]);
+        if (vd->vd_names)
+            free(vd->vd_names);
+    }
+    if (dm->dm_vec)
+        free(dm->dm_vec);
+    free(dm);
+    return 0;
+}
+
+/*! Yang apply callback: add data nodes with must, when or leafref to dependency map
+ *
+ * @param[in]  ys   Yang statement
+ * @param[in]  arg  Dependency map
+ * @retval     2    Skip children, not part of data tree
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+validate_depmap_fn(yang_stmt *ys,
+                   void      *arg)
+{
+    int                     retval = -1;
+    struct validate_depmap *dm = (struct validate_depmap *)arg;
+    struct validate_dep     vd = {0,};
+    struct validate_dep    *vec;
+    yang_stmt              *yc;
+    yang_stmt              *yrestype = NULL;
+    int                     inext;
+    int                     i;
+
+    switch (yang_keyword_get(ys)){
+    case Y_GROUPING:
+    case Y_TYPEDEF:
+    case Y_RPC:
+    case Y_ACTION:
+    case Y_NOTIFICATION:
+    case Y_AUGMENT:
+    case Y_DEVIATION:
+    case Y_EXTENSION:
+        retval = 2;
+        goto done;
+    default:
+        break;
+    }
+    if (!yang_datanode(ys))
+        goto ok;
+    vd.vd_ys = ys;
+    inext = 0;
+    while ((yc = yn_iter(ys, &inext)) != NULL) {
+        if (yang_keyword_get(yc) != Y_MUST && yang_keyword_get(yc) != Y_WHEN)
+            continue;
+        if (validate_dep_xpath(yang_argument_get(yc), &vd) < 0)
+            goto done;
+    }
+    /* "when"-associated augment or uses, see yang_check_when_xpath */
+    if ((yc = yang_when_get(NULL, ys)) != NULL &&
+        validate_dep_xpath(yang_argument_get(yc), &vd) < 0)
+        goto done;
+    if (yang_keyword_get(ys) == Y_LEAF || yang_keyword_get(ys) == Y_LEAF_LIST){
+        if (yang_type_get(ys, NULL, &yrestype, NULL, NULL, NULL, NULL, NULL) < 0)
+            goto done;
+        if (yrestype && validate_dep_type(ys, yrestype, &vd) < 0)
+            goto done;
+    }
+    if (vd.vd_nxpath == 0)
+        goto ok;
+    if ((vec = realloc(dm->dm_vec, (dm->dm_len+1)*sizeof(*vec))) == NULL){
+        clixon_err(OE_UNIX, errno, "realloc");
+        goto done;
+    }
+    dm->dm_vec = vec;
+    dm->dm_vec[dm->dm_len++] = vd;
+    vd.vd_names = NULL;
+    vd.vd_len = 0;
+ ok:
+    retval = 0;
+ done:
+    for (i=0; i<vd.vd_len; i++)
+        free(vd.vd_names[i]);
+    if (vd.vd_names)
+        free(vd.vd_names);
+    return retval;
+}
+
+/*! Get dependency map of yang spec, build it if not cached
+ *
+ * @param[in]  h      Clixon handle
+ * @param[in]  yspec  Top-level yang spec
+ * @param[out] dmp    Dependency map, cached in handle, do not free
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+validate_depmap_get(clixon_handle            h,
+                    yang_stmt               *yspec,
+                    struct validate_depmap **dmp)
+{
+    int                     retval = -1;
+    struct validate_depmap *dm = NULL;
+
+    if (clicon_ptr_get(h, VALIDATE_DEPMAP, (void**)&dm) == 0 && dm != NULL){
+        if (dm->dm_yspec == yspec)
+            goto ok;
+        if (xml_yang_validate_depmap_free(h) < 0)
+            goto done;
+    }
+    if ((dm = malloc(sizeof(*dm))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    memset(dm, 0, sizeof(*dm));
+    dm->dm_yspec = yspec;
+    if (yang_apply(yspec, -1, validate_depmap_fn, 1, dm) < 0){
+        validate_depmap_free(dm);
+        goto done;
+    }
+    if (clicon_ptr_set(h, VALIDATE_DEPMAP, dm) < 0){
+        validate_depmap_free(dm);
+        goto done;
+    }
+    clixon_debug(CLIXON_DBG_DEFAULT, "%d dependencies", dm->dm_len);
+ ok:
+    *dmp = dm;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Free the cached dependency map used by incremental validation
+ *
+ * Call when the yang spec changes or on exit
+ * @param[in]  h  Clixon handle
+ * @retval     0  OK
+ * @retval    -1  Error
+ * @see xml_yang_validate_diff
+ */
+int
+xml_yang_validate_depmap_free(clixon_handle h)
+{
+    struct validate_depmap *dm = NULL;
+
+    if (clicon_ptr_get(h, VALIDATE_DEPMAP, (void**)&dm) < 0 || dm == NULL)
+        return 0;
+    validate_depmap_free(dm);
+    return clicon_ptr_del(h, VALIDATE_DEPMAP);
+}
+
+/*! XML apply callback: add name of xml node to hash
+ */
+static int
+validate_diff_name_fn(cxobj *x,
+                      void  *arg)
+{
+    clicon_hash_t *hash = (clicon_hash_t *)arg;
+
+    if (clicon_hash_add(hash, xml_name(x), NULL, 0) == NULL)
+        return -1;
+    return 0;
+}
+
+/*! Compare yang pointers for qsort and bsearch
+ */
+static int
+validate_diff_ptrcmp(const void *a,
+                     const void *b)
+{
+    const yang_stmt *ya = *(yang_stmt **)a;
+    const yang_stmt *yb = *(yang_stmt **)b;
+
+    return (ya > yb) - (ya < yb);
+}
+
+/*! Check if yang statement is in sorted vector
+ */
+static int
+validate_diff_ysin(yang_stmt  *ys,
+                   yang_stmt **vec,
+                   size_t      len)
+{
+    if (ys == NULL || len == 0)
+        return 0;
+    return bsearch(&ys, vec, len, sizeof(*vec), validate_diff_ptrcmp) != NULL;
+}
+
+/*! Mark the node in target tree where a node was deleted from, and its ancestors
+ *
+ * Find the parent of the deleted source node in the target tree by matching the
+ * source ancestors one level at a time from the top.
+ * @param[in]  xt  Target top-level tree
+ * @param[in]  xd  Deleted node in source tree
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+static int
+validate_diff_mark_del(cxobj *xt,
+                       cxobj *xd)
+{
+    int     retval = -1;
+    cxobj **vec = NULL;
+    int     len = 0;
+    cxobj  *xp;
+    cxobj  *x0;
+    cxobj  *x0c;
+    int     i;
+
+    for (xp = xml_parent(xd); xml_parent(xp) != NULL; xp = xml_parent(xp))
+        len++;
+    if (len && (vec = calloc(len, sizeof(cxobj*))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    i = len;
+    for (xp = xml_parent(xd); xml_parent(xp) != NULL; xp = xml_parent(xp))
+        vec[--i] = xp;
+    x0 = xt;
+    for (i=0; i<len; i++){
+        x0c = NULL;
+        if (match_base_child(x0, vec[i], xml_spec(vec[i]), &x0c) < 0)
+            goto done;
+        if (x0c == NULL)
+            break;
+        x0 = x0c;
+    }
+    for (; x0 != NULL; x0 = xml_parent(x0))
+        xml_flag_set(x0, XML_FLAG_TRANSIENT);
+    retval = 0;
+ done:
+    if (vec)
+        free(vec);
+    return retval;
+}
+
+/*! Traverse target tree and validate nodes affected by the diff
+ *
+ * @param[in]  h     Clixon handle
+ * @param[in]  xt    XML node whose children are traversed
+ * @param[in]  dvec  Sorted vector of yang nodes depending on a changed node
+ * @param[in]  dlen  Length of dvec
+ * @param[in]  avec  Sorted vector of dvec and their yang ancestors
+ * @param[in]  alen  Length of avec
+ * @param[out] xret  Error XML tree (if retval=0). Free with xml_free after use
+ * @retval     1     Validation OK
+ * @retval     0     Validation failed
+ * @retval    -1     Error
+ */
+static int
+validate_diff_traverse(clixon_handle h,
+                       cxobj        *xt,
+                       yang_stmt   **dvec,
+                       size_t        dlen,
+                       yang_stmt   **avec,
+                       size_t        alen,
+                       cxobj       **xret)
+{
+    int        ret;
+    cxobj     *x;
+    yang_stmt *ys;
+    int        changed;
+
+    x = NULL;
+    while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL) {
+        if (xml_flag(x, XML_FLAG_ADD)){
+            if ((ret = xml_yang_validate_all(h, x, xret)) < 1)
+                return ret;
+            continue;
+        }
+        ys = xml_spec(x);
+        changed = xml_flag(x, XML_FLAG_CHANGE|XML_FLAG_TRANSIENT) != 0;
+        if (changed || validate_diff_ysin(ys, dvec, dlen)){
+            if ((ret = xml_yang_validate_all0(h, x, 0, xret)) < 1)
+                return ret;
+        }
+        if (changed || validate_diff_ysin(ys, avec, alen)){
+            if ((ret = validate_diff_traverse(h, x, dvec, dlen, avec, alen, xret)) < 1)
+                return ret;
+        }
+    }
+    return 1;
+}
+
+/*! Validate a target tree incrementally, given the diff from a valid source tree
+ *
+ * Instead of validating the whole tree as xml_yang_validate_all_top, only validate:
+ * - added subtrees, fully
+ * - changed nodes, their ancestors and the parents of deleted nodes, as single nodes,
+ *   which includes mandatory and min/max-elements of their children
+ * - nodes whose must, when or leafref path xpaths refer to the name of any added,
+ *   deleted or changed node, as single nodes
+ * The latter uses a dependency map of the yang spec which is built on first call.
+ * The dependency is by node name only, and wildcards or deref() depend on all nodes.
+ * @param[in]  h     Clixon handle
+ * @param[in]  xt    Target top-level XML tree
+ * @param[in]  avec  Added nodes in target, their subtrees are flagged with XML_FLAG_ADD
+ * @param[in]  alen  Length of avec
+ * @param[in]  dvec  Deleted nodes in source
+ * @param[in]  dlen  Length of dvec
+ * @param[in]  tcvec Changed nodes in target, flagged with XML_FLAG_CHANGE
+ * @param[in]  clen  Length of tcvec
+ * @param[out] xret  Error XML tree (if retval=0). Free with xml_free after use
+ * @retval     1     Validation OK
+ * @retval     0     Validation failed (xret set)
+ * @retval    -1     Error
+ * @note The source tree is assumed to be valid
+ * @note The ancestors of added and changed nodes are assumed to be flagged with XML_FLAG_CHANGE
+ * @note Mount-points are not handled, validates the whole tree if CLICON_YANG_SCHEMA_MOUNT is set
+ * @see xml_diff
+ */
+int
+xml_yang_validate_diff(clixon_handle h,
+                       cxobj        *xt,
+                       cxobj       **avec,
+                       int           alen,
+                       cxobj       **dvec,
+                       int           dlen,
+                       cxobj       **tcvec,
+                       int           clen,
+                       cxobj       **xret)
+{
+    int                     retval = -1;
+    int                     ret;
+    yang_stmt              *yspec;
+    struct validate_depmap *dm = NULL;
+    struct validate_dep    *vd;
+    clicon_hash_t          *hash = NULL;
+    yang_stmt             **ydvec = NULL;
+    size_t                  ydlen = 0;
+    yang_stmt             **yavec = NULL;
+    size_t                  yalen = 0;
+    yang_stmt             **yv;
+    yang_stmt              *ys;
+    int                     marked = 0;
+    int                     i;
+    int                     j;
+
+    if (clicon_option_bool(h, "CLICON_YANG_SCHEMA_MOUNT") ||
+        (yspec = clicon_dbspec_yang(h)) == NULL){
+        retval = xml_yang_validate_all_top(h, xt, xret);
+        goto done;
+    }
+    if (validate_depmap_get(h, yspec, &dm) < 0)
+        goto done;
+    /* Names of all added, deleted and changed nodes */
+    if ((hash = clicon_hash_init()) == NULL)
+        goto done;
+    for (i=0; i<alen; i++)
+        if (xml_apply0(avec[i], CX_ELMNT, validate_diff_name_fn, hash) < 0)
+            goto done;
+    for (i=0; i<dlen; i++)
+        if (xml_apply0(dvec[i], CX_ELMNT, validate_diff_name_fn, hash) < 0)
+            goto done;
+    for (i=0; i<clen; i++)
+        if (validate_diff_name_fn(tcvec[i], hash) < 0)
+            goto done;
+    /* Yang nodes depending on the changes, and their ancestors */
+    if (dm->dm_len){
+        if ((ydvec = calloc(dm->dm_len, sizeof(yang_stmt*))) == NULL){
+            clixon_err(OE_UNIX, errno, "calloc");
+            goto done;
+        }
+    }
+    for (i=0; i<dm->dm_len; i++){
+        vd = &dm->dm_vec[i];
+        for (j=0; j<vd->vd_len && !vd->vd_any; j++)
+            if (clicon_hash_lookup(hash, vd->vd_names[j]) != NULL)
+                break;
+        if (vd->vd_any || j < vd->vd_len)
+            ydvec[ydlen++] = vd->vd_ys;
+    }
+    for (i=0; i<ydlen; i++){
+        for (ys = ydvec[i]; ys != NULL; ys = yang_parent_get(ys)){
+            if (yang_keyword_get(ys) == Y_MODULE || yang_keyword_get(ys) == Y_SUBMODULE)
+                break;
+            if ((yalen % 64) == 0){
+                if ((yv = realloc(yavec, (yalen+64)*sizeof(yang_stmt*))) == NULL){
+                    clixon_err(OE_UNIX, errno, "realloc");
+                    goto done;
+                }
+                yavec = yv;
+            }
+            yavec[yalen++] = ys;
+        }
+    }
+    if (ydlen)
+        qsort(ydvec, ydlen, sizeof(*ydvec), validate_diff_ptrcmp);
+    if (yalen)
+        qsort(yavec, yalen, sizeof(*yavec), validate_diff_ptrcmp);
+    clixon_debug(CLIXON_DBG_DEFAULT, "%zu dependent nodes", ydlen);
+    /* Parents of deleted nodes */
+    marked = 1;
+    for (i=0; i<dlen; i++)
+        if (validate_diff_mark_del(xt, dvec[i]) < 0)
+            goto done;
+    leafref_index_begin();
+    ret = validate_diff_traverse(h, xt, ydvec, ydlen, yavec, yalen, xret);
+    leafref_index_end();
+    if (ret == 1)
+        ret = xml_yang_validate_minmax(xt, 0, xret);
+    if (ret < 0)
+        goto done;
+    retval = ret;
+ done:
+    if (marked && dlen)
+        xml_apply0(xt, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset, (void*)XML_FLAG_TRANSIENT);
+    if (yavec)
+        free(yavec);
+    if (ydvec)
+        free(ydvec);
+    if (hash)
+        clicon_hash_free(hash);
+    return retval;
 }
 
 /*! Check validity of outgoing RPC
@@ -79,29 +79,26 @@
 #include "clixon_xml_bind.h"
 #include "clixon_validate_minmax.h"
 
-/*! New element last in list, check if already exists if sp return -1
+/*! Collect values of a descendant schema node of one list entry, fail if any already exists
  *
- * @param[in]  vec   Vector of existing entries (new is last)
- * @param[in]  i1    The new entry is placed at vec[i1]
- * @param[in]  vlen  Length of entry
- * @param[in]  sorted Sorted by system, ie sorted by key, otherwise no assumption
+ * @param[in]  x     List entry
+ * @param[in]  xpath Descendant schema node id as canonical xpath
+ * @param[in]  nsc   Namespace context of xpath
+ * @param[in]  hash  Values of previous entries, new values are added
  * @retval     1     Validation OK
- * @retval     0     Validation failed (cbret set)
+ * @retval     0     Validation failed, duplicate value
  * @retval    -1     Error
- * @note This is currently quadratic complexity. It could be improved by inserting new element sorted and binary search.
  */
 static int
-unique_search_xpath(cxobj  *x,
-                    char   *xpath,
-                    cvec   *nsc,
-                    char ***svec,
-                    size_t *slen)
+unique_search_xpath(cxobj         *x,
+                    char          *xpath,
+                    cvec          *nsc,
+                    clicon_hash_t *hash)
 {
     int     retval = -1;
     cxobj **xvec = NULL;
     size_t  xveclen;
     int     i;
-    int     s;
     cxobj  *xi;
     char   *bi;
 
@@ -112,20 +109,10 @@ unique_search_xpath(cxobj  *x,
         xi = xvec[i];
         if ((bi = xml_body(xi)) == NULL)
             break;
-        /* Check if bi is duplicate? 
-         * XXX: sort svec?
-         */
-        for (s=0; s<(*slen); s++){
-            if (strcmp(bi, (*svec)[s]) == 0){
-                goto fail;
-            }
-        }
-        (*slen) ++;
-        if (((*svec) = realloc((*svec), (*slen)*sizeof(char*))) == NULL){
-            clixon_err(OE_UNIX, errno, "realloc");
+        if (clicon_hash_lookup(hash, bi) != NULL)
+            goto fail;
+        if (clicon_hash_add(hash, bi, NULL, 0) == NULL)
             goto done;
-        }
-        (*svec)[(*slen)-1] = bi;
     } /* i search results */
     retval = 1;
  done:
@@ -137,51 +124,70 @@ unique_search_xpath(cxobj  *x,
     goto done;
 }
 
-/*! New element last in list, return error if already exists 
+/*! New element last in list sorted by system, return error if already exists
  *
  * @param[in]  vec   Vector of existing entries (new is last)
  * @param[in]  i1    The new entry is placed at vec[i1]
- * @param[in]  vlen  Length of vec
- * @param[in]  sorted Sorted by system, ie sorted by key, otherwise no assumption
+ * @param[in]  vlen  Length of entry
  * @retval     0     OK, entry is unique
  * @retval    -1     Duplicate detected
- * @note This is currently quadratic complexity. It could be improved by inserting new element sorted and binary search.
+ * @note Entries are assumed sorted by key, so only previous entry is compared
+ * @see check_insert_duplicate_hash  for other lists and unique constraints
  */
 static int
 check_insert_duplicate(char **vec,
                        int    i1,
-                       int    vlen,
-                       int    sorted)
+                       int    vlen)
 {
     int i;
     int v;
     char *b;
 
-    if (sorted){
-        /* Just go look at previous element to see if it is duplicate (sorted by system) */
-        if (i1 == 0)
+    /* Just go look at previous element to see if it is duplicate (sorted by system) */
+    if (i1 == 0)
+        return 0;
+    i = i1-1;
+    for (v=0; v<vlen; v++){
+        b = vec[i*vlen+v];
+        if (b == NULL || strcmp(b, vec[i1*vlen+v]))
             return 0;
-        i = i1-1;
-        for (v=0; v<vlen; v++){
-            b = vec[i*vlen+v];
-            if (b == NULL || strcmp(b, vec[i1*vlen+v]))
-                return 0;
-        }
-        /* here we have passed thru all keys of previous element and they are all equal */
-        return -1;
     }
-    else{
-        for (i=0; i<i1; i++){
-            for (v=0; v<vlen; v++){
-                b = vec[i*vlen+v];
-                if (b == NULL || strcmp(b, vec[i1*vlen+v]))
-                    break;
-            }
-            if (v==vlen) /* duplicate */
-                break;
-        }
-        return i==i1?0:-1;
+    /* here we have passed thru all keys of previous element and they are all equal */
+    return -1;
+}
+
+/*! New element last in list, return error if its tuple already exists in hash
+ *
+ * The tuple values are length-prefixed into a single hash key.
+ * @param[in]  vec   Vector of entries (new is last)
+ * @param[in]  i1    The new entry is placed at vec[i1]
+ * @param[in]  vlen  Length of entry
+ * @param[in]  hash  Tuples of previous entries, new tuple is added
+ * @param[in]  cb    Buffer for hash key
+ * @retval     1     OK, entry is unique
+ * @retval     0     Duplicate detected
+ * @retval    -1     Error
+ */
+static int
+check_insert_duplicate_hash(char          **vec,
+                            int             i1,
+                            int             vlen,
+                            clicon_hash_t  *hash,
+                            cbuf           *cb)
+{
+    int   v;
+    char *b;
+
+    cbuf_reset(cb);
+    for (v=0; v<vlen; v++){
+        b = vec[i1*vlen+v];
+        cprintf(cb, "%zu:%s", strlen(b), b);
     }
+    if (clicon_hash_lookup(hash, cbuf_get(cb)) != NULL)
+        return 0;
+    if (clicon_hash_add(hash, cbuf_get(cb), NULL, 0) == NULL)
+        return -1;
+    return 1;
 }
 
 /*! Given a list with unique constraint, detect duplicates
@@ -226,10 +232,12 @@ check_unique_list_direct(cxobj     *x,
     int       sorted;
     char     *str;
     cvec     *cvk;
+    clicon_hash_t *hash = NULL;
+    cbuf     *cb = NULL;
+    int       ret;
 
     /* If list and is sorted by system, then it is assumed elements are in key-order which is optimized
-     * Other cases are "unique" constraint or list sorted by user which is quadratic in complexity
-     * This second case COULD be optimized if binary insert is made on the vec vector.
+     * Other cases are "unique" constraint or list sorted by user which use a hash of the tuples
      */
     sorted = (yang_keyword_get(yu) == Y_LIST &&
               yang_find(y, Y_ORDERED_BY, "user") == NULL);
@@ -239,6 +247,14 @@ check_unique_list_direct(cxobj     *x,
         /* No keys: no checks necessary */
         goto ok;
     }
+    if (!sorted){
+        if ((hash = clicon_hash_init()) == NULL)
+            goto done;
+        if ((cb = cbuf_new()) == NULL){
+            clixon_err(OE_UNIX, errno, "cbuf_new");
+            goto done;
+        }
+    }
     if ((vec = calloc(clen*xml_child_nr(xt), sizeof(char*))) == NULL){
         clixon_err(OE_UNIX, errno, "calloc");
         goto done;
@@ -267,7 +283,11 @@ check_unique_list_direct(cxobj     *x,
         }
         if (cvi==NULL){
             /* Last element (i) is newly inserted, see if it is already there */
-            if (check_insert_duplicate(vec, i, clen, sorted) < 0){
+            if (sorted)
+                ret = check_insert_duplicate(vec, i, clen) < 0 ? 0 : 1;
+            else if ((ret = check_insert_duplicate_hash(vec, i, clen, hash, cb)) < 0)
+                goto done;
+            if (ret == 0){
                 if (xret && netconf_data_not_unique_xml(xret, x, cvk) < 0)
                     goto done;
                 goto fail;
@@ -280,6 +300,10 @@ check_unique_list_direct(cxobj     *x,
     /* It would be possible to cache vec here as an optimization */
     retval = 1;
  done:
+    if (cb)
+        cbuf_free(cb);
+    if (hash)
+        clicon_hash_free(hash);
     if (vec)
         free(vec);
     return retval;
@@ -321,8 +345,7 @@ check_unique_list(cxobj     *x,
 {
     int       retval = -1;
     cg_var    *cvi; /* unique node name */
-    char     **svec = NULL; /* vector of search results */
-    size_t     slen = 0;
+    clicon_hash_t *hash = NULL; /* search results */
     char      *xpath0 = NULL;
     char      *xpath1 = NULL;
     int        ret;
@@ -347,16 +370,18 @@ check_unique_list(cxobj     *x,
         goto done;
     }
     /* Here proper xpath with at least one slash (can there be a descendant schemanodeid w/o slash?) */
-    if (xml_nsctx_yang(yu, &nsc0) < 0)
+    if ((nsc0 = xml_nsctx_yang_shared(yu)) == NULL)
         goto done;
     if ((ret = xpath2canonical(xpath0, nsc0, ys_spec(y),
                                &xpath1, &nsc1, NULL)) < 0)
         goto done;
     if (ret == 0)
         goto fail; // XXX set xret
+    if ((hash = clicon_hash_init()) == NULL)
+        goto done;
     do {
         /* Collect search results from one */
-        if ((ret = unique_search_xpath(x, xpath1, nsc1, &svec, &slen)) < 0)
+        if ((ret = unique_search_xpath(x, xpath1, nsc1, hash)) < 0)
             goto done;
         if (ret == 0){
             if (xret && netconf_data_not_unique_xml(xret, x, cvk) < 0)
@@ -369,14 +394,12 @@ check_unique_list(cxobj     *x,
     /* It would be possible to cache vec here as an optimization */
     retval = 1;
  done:
-    if (nsc0)
-        cvec_free(nsc0);
     if (nsc1)
         cvec_free(nsc1);
     if (xpath1)
         free(xpath1);
-    if (svec)
-        free(svec);
+    if (hash)
+        clicon_hash_free(hash);
     return retval;
  fail:
     retval = 0;
@@ -46,6 +46,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <inttypes.h>
 #include <unistd.h>
@@ -53,6 +54,10 @@
 #include <string.h>
 #include <limits.h>
 #include <assert.h>
+#include <sys/mman.h>
+#ifdef __linux__
+#include <sys/syscall.h> /* mbind */
+#endif
 
 /* cligen */
 #include <cligen/cligen.h>
@@ -76,6 +81,7 @@
 #include "clixon_xml_io.h"
 #include "clixon_xml_parse.h"
 #include "clixon_xml_nsctx.h"
+#include "clixon_memstats.h"
 
 /*
  * Constants
@@ -89,6 +95,58 @@
 #define XML_CHILDVEC_SIZE_START_ELMNT 16
 #define XML_CHILDVEC_SIZE_THRESHOLD 65536
 
+/* Child vectors of at least this length keep their unused entries as a gap at the position
+ * of the last insert or removal, so that sequences of nearby inserts move few children
+ * @see xml_childvec_gap_move
+ */
+#define XML_CHILDVEC_GAP_MIN 1024
+
+/* Values of body and attribute nodes up to this size including null are stored in the
+ * node itself, longer values are malloced, see xml_value_put
+ */
+#define XML_VALUE_INLINE 16
+
+/* Size of XML arena chunks. Must be a power of two since chunks are aligned on their size
+ * so that the chunk header of an object can be found by masking its address
+ * @see xml_arena_alloc
+ */
+#define XML_ARENA_CHUNK_SIZE 65536
+
+/* Objects larger than this are always allocated with malloc */
+#define XML_ARENA_OBJ_MAX 1024
+
+/* Size of regions that arena chunks are carved from if huge pages or a NUMA node is set,
+ * the size of a huge page. Chunks of a region are marked in a 32-bit mask
+ * @see xml_arena_layout
+ */
+#define XML_ARENA_REGION_SIZE   (2*1024*1024)
+#define XML_ARENA_REGION_CHUNKS (XML_ARENA_REGION_SIZE/XML_ARENA_CHUNK_SIZE) /* 32 */
+
+/* mbind(2) policy, numaif.h is part of libnuma */
+#define XML_ARENA_MPOL_PREFERRED 1
+
+/* x_alloc flags: which parts of an XML node are allocated from an arena chunk */
+#define XML_ALLOC_NODE   0x01 /* The node itself */
+#define XML_ALLOC_NAME   0x02 /* x_name */
+#define XML_ALLOC_PREFIX 0x04 /* x_prefix */
+#define XML_ALLOC_NAME_INTERN   0x08 /* x_name is interned */
+#define XML_ALLOC_PREFIX_INTERN 0x10 /* x_prefix is interned */
+#ifdef XML_NUM_CACHE
+/* Not allocation flags, but use free bits for validity of x_num integer value cache */
+#define XML_ALLOC_NUM    0x20 /* x_num is set */
+#define XML_ALLOC_NUMNEG 0x40 /* x_num is negative, ie int64, otherwise uint64 */
+#endif
+/* Not allocation flags, the high byte of x_alloc is the memory tag, see clixon_memstats.c */
+#define XML_ALLOC_TAG_SHIFT 8
+#define xml_mem_tag(x) ((x)->x_alloc >> XML_ALLOC_TAG_SHIFT)
+
+/* Initial number of buckets of name intern table, must be power of two */
+#define XML_INTERN_SIZE_START 256
+
+/* Min number of children where xml_find looks up the name in the intern table once and
+ * then compares pointers, instead of strcmp for each child */
+#define XML_FIND_INTERN_MIN 8
+
 /* Intention of these macros is to guard against access of type-specific fields 
  * As debug they can contain an assert.
  */
@@ -101,6 +159,9 @@
 
 #ifdef XML_EXPLICIT_INDEX
 static int xml_search_index_free(cxobj *x);
+static int xml_search_list_p(cxobj *x);
+static int xml_search_list_update(cxobj *xp, int add);
+static int xml_search_value_update(cxobj *xi, int add);
 
 /* A search index pair consisting of a name of an (index) variable and a vector of xml children
  * the variable should be a potential child of the XML node
@@ -168,6 +229,7 @@ struct xml{
     char             *x_name;       /* name of node */
     char             *x_prefix;     /* namespace localname N, called prefix */
     uint16_t          x_flags;      /* Flags according to XML_FLAG_* */
+    uint16_t          x_alloc;      /* Arena allocation flags according to XML_ALLOC_* */
     struct xml       *x_up;         /* parent node in hierarchy if any */
 #ifdef XML_PARENT_CANDIDATE
     struct xml       *x_up_candidate; /* Candidate parent node for special cases (when+xpath) */
@@ -175,21 +237,36 @@ struct xml{
     int              _x_vector_i;   /* internal use: xml_child_each */
     int              _x_i;          /* internal use for stable sorting:
                                        see xml_enumerate and xml_cmp */
-    /*----- next is body/attribute only */
-    cbuf             *x_value_cb;  /* attribute and body nodes have values (XXX: this consumes 
-                                       memory) cv? */
-    /*----- up to here is common to all next is element only */
+    /*----- up to here is common to all next is element only, see struct xmlbody */
     struct xml      **x_childvec;   /* vector of children nodes (XXX: use clixon_vec ) */
     int               x_childvec_len;/* Number of children */
     int               x_childvec_max;/* Length of allocated vector */
-
+    int               x_childvec_nattr;/* Number of attributes, first in vector */
+    int               x_childvec_gap;/* Start of gap of unused entries + 1, 0 if at end */
+    struct xml       *x_child1;     /* Inline vector if single child, eg leaf body,
+                                       see xml_childvec_grow */
     cvec             *x_ns_cache;   /* Cached vector of namespaces (set by bind-yang) */
     yang_stmt        *x_spec;       /* Pointer to specification, eg yang, 
                                        by reference, dont free */
     cg_var           *x_cv;         /* Cached value as cligen variable (set by xml_cmp) */
+    yang_stmt        *x_union_type; /* Cached matching union member type of value (set by
+                                       validation, reset when value changes) */
 #ifdef XML_EXPLICIT_INDEX
     struct search_index *x_search_index; /* explicit search index vectors */
 #endif
+#ifdef XML_NUM_CACHE
+    uint64_t          x_num;        /* Cached integer value of body, see xml_num_get */
+#endif
+#ifdef XML_PATH_CACHE
+    char             *x_path;       /* Cached xpath to root, see xml_path_cache_get */
+    uint32_t          x_path_gen;   /* Generation of x_path shifted one bit, lowest bit is spec */
+#endif
+#ifdef XML_HASH_CACHE
+    uint64_t          x_hash;       /* Cached hash of subtree, 0 if not computed,
+                                       see xml_tree_hash */
+#endif
+    uint32_t          x_refcnt;     /* References to frozen tree root, 0 if not frozen,
+                                       see xml_freeze */
 };
 
 /* Variant of struct xml for use by non-elements to save space
@@ -200,6 +277,7 @@ struct xmlbody{
     char             *xb_name;       /* name of node */
     char             *xb_prefix;     /* namespace localname N, called prefix */
     uint16_t          xb_flags;      /* Flags according to XML_FLAG_* */
+    uint16_t          xb_alloc;      /* Arena allocation flags according to XML_ALLOC_* */
     struct xml       *xb_up;         /* parent node in hierarchy if any */
 #ifdef XML_PARENT_CANDIDATE
     struct xml       *xb_up_candidate; /* Candidate parent node for special cases (when+xpath) */
@@ -207,13 +285,103 @@ struct xmlbody{
     int              _xb_vector_i;   /* internal use: xml_child_each */
     int              _xb_i;          /* internal use for sorting: 
                                        see xml_enumerate and xml_cmp */
-    cbuf             *xb_value_cb;  /* attribute and body nodes have values */
+    char             *xb_value;      /* Value, xb_inline or malloced, see xml_value_put */
+    uint32_t          xb_value_len;  /* Length of value */
+    uint32_t          xb_value_max;  /* Size of malloced value, 0 if inline */
+    char              xb_inline[XML_VALUE_INLINE]; /* Short values */
+};
+
+/* Body or attribute part of XML node */
+#define xml_xb(x) ((struct xmlbody *)(x))
+
+/* Index in x_childvec of child i, after the gap if i is at or beyond its start
+ * @see XML_CHILDVEC_GAP_MIN */
+#define xml_childvec_pos(x, i) ((x)->x_childvec_gap && (i) >= (x)->x_childvec_gap - 1 ? \
+                                (i) + (x)->x_childvec_max - (x)->x_childvec_len : (i))
+
+/* Number of children in malloced x_childvec, not x_child1 */
+#define xml_childvec_heap(x) ((x)->x_childvec == &(x)->x_child1 ? 0 : (x)->x_childvec_max)
+
+/* Header of an XML arena chunk, the allocated objects follow the header
+ *
+ * A chunk is freed when it is not the active chunk and all objects allocated from it
+ * have been freed. This means that subtrees allocated from an arena may be moved to
+ * other trees and freed in any order.
+ */
+struct xml_arena_chunk{
+    uint32_t          xac_live;     /* Number of live objects allocated from this chunk */
+    uint32_t          xac_open;     /* Set if this is the active chunk of the arena */
+    uint32_t          xac_region;   /* Set if chunk is part of a region */
+    size_t            xac_used;     /* Bytes used in chunk, including header */
 };
 
+/* Size of chunk header, objects are allocated after it */
+#define XML_ARENA_CHUNK_HDR ((sizeof(struct xml_arena_chunk) + sizeof(void*) - 1) & ~(sizeof(void*) - 1))
+
+/* Header of a region of arena chunks, placed after the chunk header of its first chunk
+ * Regions with free chunks are kept in a list, a region is unmapped when all its chunks
+ * are free.
+ */
+struct xml_arena_region{
+    struct xml_arena_region *xar_next;  /* Next region with free chunks */
+    struct xml_arena_region *xar_prev;  /* Previous region with free chunks */
+    uint32_t                 xar_free;  /* Mask of free chunks */
+    uint32_t                 xar_trimmed; /* Mask of chunks not resident, see xml_arena_trim */
+    uint32_t                 xar_huge;  /* Mapped with explicit huge pages */
+};
+
+#ifdef XML_NAME_INTERN
+/* Interned XML name or prefix, shared by all XML nodes with the same name
+ * The string follows the header
+ */
+struct xml_intern{
+    struct xml_intern *xi_next;     /* Next in hash bucket */
+    uint32_t           xi_hash;     /* Hash value of string */
+    uint32_t           xi_refcnt;   /* Number of XML nodes referencing the string */
+    char               xi_str[];    /* Null-terminated string */
+};
+#endif
+
 /*
  * Variables
  */
 
+#ifdef XML_NAME_INTERN
+/* Intern table of XML names and prefixes */
+static struct xml_intern **_xml_intern_vec = NULL;
+static size_t              _xml_intern_size = 0; /* Number of buckets */
+static size_t              _xml_intern_nr = 0;   /* Number of interned strings */
+#endif
+
+/* See option CLICON_XML_ARENA */
+static int _xml_arena_enable = 0;
+
+/* Nesting depth of xml_arena_push/pop calls, allocate from arena if > 0 */
+static int _xml_arena_depth = 0;
+
+/* Active arena chunk, or NULL */
+static struct xml_arena_chunk *_xml_arena_chunk = NULL;
+
+/* Huge pages and NUMA node of arena regions, see xml_arena_layout */
+static int _xml_arena_pages = XML_ARENA_PAGES_NONE;
+static int _xml_arena_numa = -1;
+
+/* Chunks are always carved from regions, so that they can be returned to the OS,
+ * see xml_arena_release */
+static int _xml_arena_release = 0;
+
+/* Bytes of regions unmapped since last xml_arena_trim */
+static uint64_t _xml_arena_unmapped = 0;
+
+/* Regions with free chunks */
+static struct xml_arena_region *_xml_arena_regions = NULL;
+
+/* Arena stats, see xml_arena_stats */
+static uint64_t _xml_arena_objects = 0;
+static uint64_t _xml_arena_chunks = 0;
+static uint64_t _xml_arena_region_nr = 0;
+static uint64_t _xml_arena_huge_nr = 0;
+
 /* Mapping between xml type <--> string */
 static const map_str2int xsmap[] = {
     {"error",         CX_ERROR},
@@ -237,6 +405,602 @@ xml_type2str(enum cxobj_type type)
 /* Stats (too low-level to hang it on handle) */
 static uint64_t _stats_xml_nr = 0;
 
+#ifdef XML_PATH_CACHE
+/* Generation of cached xpaths. Increment to invalidate all cached paths */
+static uint32_t _xml_path_gen = 1;
+
+static void xml_path_cache_value(cxobj *xl);
+#endif
+
+/* Loader of children of nodes with XML_FLAG_LAZY, see xml_lazy_register */
+static xml_lazyfn_t *_xml_lazy_fn = NULL;
+static void         *_xml_lazy_arg = NULL;
+
+/*! Enable or disable arena allocation of XML trees created by the parsers and xml_dup
+ *
+ * @param[in]  enable  Set to 1 to enable arena allocation, 0 to disable
+ * @retval     0       OK
+ * @see option CLICON_XML_ARENA
+ */
+int
+xml_arena_enable(int enable)
+{
+    _xml_arena_enable = enable;
+    return 0;
+}
+
+/*! Set memory layout of arena chunks
+ *
+ * Should be called before any arena allocation, eg at startup
+ * @param[in]  pages  Huge pages of arena regions, see enum xml_arena_pages
+ * @param[in]  numa   NUMA node of arena regions, or -1
+ * @retval     0      OK
+ * @see option CLICON_XML_ARENA_HUGEPAGES
+ * @see option CLICON_XML_ARENA_NUMA_NODE
+ */
+int
+xml_arena_layout(int pages,
+                 int numa)
+{
+    _xml_arena_pages = pages;
+    _xml_arena_numa = numa;
+    return 0;
+}
+
+/*! Carve arena chunks from mapped regions also without huge pages or NUMA node
+ *
+ * Free chunks of regions may then be returned to the OS with xml_arena_trim, instead
+ * of being kept by the system allocator.
+ * Should be called before any arena allocation, eg at startup
+ * @param[in]  enable  Set to 1 to use regions
+ * @retval     0       OK
+ * @see option CLICON_MEMORY_TRIM
+ */
+int
+xml_arena_release(int enable)
+{
+    _xml_arena_release = enable;
+    return 0;
+}
+
+/*! Return memory of free arena chunks to the OS
+ *
+ * Free chunks of regions that are partially used are released with
+ * madvise(MADV_DONTNEED), regions where all chunks are free are already unmapped.
+ * Chunks of huge page regions are only released when the region is unmapped.
+ * Typically called after an operation that allocated large transient trees
+ * @retval     bytes  Bytes returned to the OS since last call
+ * @see xml_arena_release
+ */
+uint64_t
+xml_arena_trim(void)
+{
+    uint64_t                 bytes;
+#ifdef MADV_DONTNEED
+    struct xml_arena_region *xar;
+    char                    *base;
+    size_t                   off;
+    long                     pagesz;
+    uint32_t                 mask;
+    int                      i;
+#endif
+
+    bytes = _xml_arena_unmapped;
+    _xml_arena_unmapped = 0;
+#ifdef MADV_DONTNEED
+    if (_xml_arena_pages != XML_ARENA_PAGES_NONE ||
+        (pagesz = sysconf(_SC_PAGESIZE)) <= 0 || pagesz >= XML_ARENA_CHUNK_SIZE)
+        return bytes;
+    for (xar = _xml_arena_regions; xar != NULL; xar = xar->xar_next){
+        if ((mask = xar->xar_free & ~xar->xar_trimmed) == 0)
+            continue;
+        base = (char*)xar - XML_ARENA_CHUNK_HDR;
+        for (i = 0; i < XML_ARENA_REGION_CHUNKS; i++){
+            if ((mask & (1U << i)) == 0)
+                continue;
+            /* First page of first chunk has the region header */
+            off = i ? 0 : pagesz;
+            if (madvise(base + i*XML_ARENA_CHUNK_SIZE + off, XML_ARENA_CHUNK_SIZE - off,
+                        MADV_DONTNEED) < 0)
+                continue;
+            xar->xar_trimmed |= 1U << i;
+            bytes += XML_ARENA_CHUNK_SIZE - off;
+        }
+    }
+#endif
+    return bytes;
+}
+
+/*! Get arena statistics
+ *
+ * Objects per chunk, and chunks per region, is the density of XML trees in memory
+ * @param[out]  objects  Number of live objects allocated from arena chunks
+ * @param[out]  chunks   Number of arena chunks
+ * @param[out]  regions  Number of mapped regions of chunks
+ * @param[out]  huge     Number of regions mapped with explicit huge pages
+ * @retval      0        OK
+ */
+int
+xml_arena_stats(uint64_t *objects,
+                uint64_t *chunks,
+                uint64_t *regions,
+                uint64_t *huge)
+{
+    if (objects)
+        *objects = _xml_arena_objects;
+    if (chunks)
+        *chunks = _xml_arena_chunks;
+    if (regions)
+        *regions = _xml_arena_region_nr;
+    if (huge)
+        *huge = _xml_arena_huge_nr;
+    return 0;
+}
+
+/*! Link region first in list of regions with free chunks
+ */
+static void
+xml_arena_region_link(struct xml_arena_region *xar)
+{
+    xar->xar_prev = NULL;
+    if ((xar->xar_next = _xml_arena_regions) != NULL)
+        xar->xar_next->xar_prev = xar;
+    _xml_arena_regions = xar;
+}
+
+/*! Unlink region from list of regions with free chunks
+ */
+static void
+xml_arena_region_unlink(struct xml_arena_region *xar)
+{
+    if (xar->xar_prev)
+        xar->xar_prev->xar_next = xar->xar_next;
+    else
+        _xml_arena_regions = xar->xar_next;
+    if (xar->xar_next)
+        xar->xar_next->xar_prev = xar->xar_prev;
+}
+
+/*! Map a new region of arena chunks, aligned on its size
+ *
+ * With explicit huge pages, MAP_HUGETLB is tried first. Otherwise or if no huge pages are
+ * reserved, transparent huge pages are requested with madvise.
+ * @retval     xar   Region, all chunks free
+ * @retval     NULL  Out of memory
+ */
+static struct xml_arena_region *
+xml_arena_region_new(void)
+{
+    struct xml_arena_region *xar;
+    char                    *p = MAP_FAILED;
+    char                    *a;
+    size_t                   sz = XML_ARENA_REGION_SIZE;
+    int                      huge = 0;
+#if defined(__linux__) && defined(SYS_mbind)
+    unsigned long            mask;
+#endif
+
+#ifdef MAP_HUGETLB
+#ifndef MAP_HUGE_2MB
+#define MAP_HUGE_2MB 0 /* Default huge page size */
+#endif
+    if (_xml_arena_pages == XML_ARENA_PAGES_EXPLICIT &&
+        (p = mmap(NULL, sz, PROT_READ|PROT_WRITE,
+                  MAP_PRIVATE|MAP_ANONYMOUS|MAP_HUGETLB|MAP_HUGE_2MB, -1, 0)) != MAP_FAILED)
+        huge = 1;
+#endif
+    if (p == MAP_FAILED){
+        /* Map twice the size and unmap the unaligned head and tail */
+        if ((p = mmap(NULL, 2*sz, PROT_READ|PROT_WRITE,
+                      MAP_PRIVATE|MAP_ANONYMOUS, -1, 0)) == MAP_FAILED)
+            return NULL;
+        a = (char*)(((uintptr_t)p + sz - 1) & ~((uintptr_t)sz - 1));
+        if (a > p)
+            munmap(p, a - p);
+        if (a + sz < p + 2*sz)
+            munmap(a + sz, p + 2*sz - (a + sz));
+        p = a;
+#ifdef MADV_HUGEPAGE
+        if (_xml_arena_pages != XML_ARENA_PAGES_NONE)
+            (void)madvise(p, sz, MADV_HUGEPAGE);
+#endif
+    }
+#if defined(__linux__) && defined(SYS_mbind)
+    /* Before the pages are touched */
+    if (_xml_arena_numa >= 0 && _xml_arena_numa < 8*(int)sizeof(mask) - 1){
+        mask = 1UL << _xml_arena_numa;
+        (void)syscall(SYS_mbind, p, sz, XML_ARENA_MPOL_PREFERRED, &mask, 8*sizeof(mask), 0);
+    }
+#endif
+    xar = (struct xml_arena_region *)(p + XML_ARENA_CHUNK_HDR);
+    xar->xar_free = 0xffffffff;
+    xar->xar_trimmed = 0xffffffff; /* Not touched */
+    xar->xar_huge = huge;
+    xml_arena_region_link(xar);
+    _xml_arena_region_nr++;
+    if (huge)
+        _xml_arena_huge_nr++;
+    return xar;
+}
+
+/*! Allocate a new arena chunk, from a region if huge pages or a NUMA node is set
+ *
+ * @retval     xac   Chunk
+ * @retval     NULL  Out of memory
+ */
+static struct xml_arena_chunk *
+xml_arena_chunk_new(void)
+{
+    struct xml_arena_chunk  *xac;
+    struct xml_arena_region *xar;
+    int                      i;
+
+    if (_xml_arena_pages == XML_ARENA_PAGES_NONE && _xml_arena_numa < 0 &&
+        !_xml_arena_release){
+        if (posix_memalign((void**)&xac, XML_ARENA_CHUNK_SIZE, XML_ARENA_CHUNK_SIZE) != 0)
+            return NULL;
+        xac->xac_region = 0;
+        xac->xac_used = XML_ARENA_CHUNK_HDR;
+    }
+    else {
+        if ((xar = _xml_arena_regions) == NULL &&
+            (xar = xml_arena_region_new()) == NULL)
+            return NULL;
+        for (i = 0; (xar->xar_free & (1U << i)) == 0; i++)
+            ;
+        xar->xar_trimmed &= ~(1U << i);
+        if ((xar->xar_free &= ~(1U << i)) == 0)
+            xml_arena_region_unlink(xar);
+        xac = (struct xml_arena_chunk *)((char*)xar - XML_ARENA_CHUNK_HDR + i*XML_ARENA_CHUNK_SIZE);
+        xac->xac_region = 1;
+        xac->xac_used = XML_ARENA_CHUNK_HDR;
+        if (i == 0) /* Region header follows chunk header */
+            xac->xac_used += (sizeof(struct xml_arena_region) + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+    }
+    xac->xac_live = 0;
+    xac->xac_open = 1;
+    _xml_arena_chunks++;
+    return xac;
+}
+
+/*! Free an arena chunk, unmap its region if all chunks of the region are free
+ *
+ * @param[in]  xac   Chunk
+ */
+static void
+xml_arena_chunk_free(struct xml_arena_chunk *xac)
+{
+    struct xml_arena_region *xar;
+    char                    *base;
+    int                      i;
+
+    _xml_arena_chunks--;
+    if (!xac->xac_region){
+        free(xac);
+        return;
+    }
+    base = (char*)((uintptr_t)xac & ~((uintptr_t)XML_ARENA_REGION_SIZE - 1));
+    xar = (struct xml_arena_region *)(base + XML_ARENA_CHUNK_HDR);
+    i = ((char*)xac - base)/XML_ARENA_CHUNK_SIZE;
+    if (xar->xar_free == 0)
+        xml_arena_region_link(xar);
+    xar->xar_free |= 1U << i;
+    if (xar->xar_free == 0xffffffff){
+        for (i = 0; i < XML_ARENA_REGION_CHUNKS; i++)
+            if ((xar->xar_trimmed & (1U << i)) == 0)
+                _xml_arena_unmapped += XML_ARENA_CHUNK_SIZE;
+        xml_arena_region_unlink(xar);
+        _xml_arena_region_nr--;
+        if (xar->xar_huge)
+            _xml_arena_huge_nr--;
+        munmap(base, XML_ARENA_REGION_SIZE);
+    }
+}
+
+/*! Close the active arena chunk, free it if no object uses it
+ */
+static void
+xml_arena_chunk_close(void)
+{
+    struct xml_arena_chunk *xac;
+
+    if ((xac = _xml_arena_chunk) != NULL){
+        xac->xac_open = 0;
+        if (xac->xac_live == 0)
+            xml_arena_chunk_free(xac);
+        _xml_arena_chunk = NULL;
+    }
+}
+
+/*! Start allocating new XML nodes and names from an arena
+ *
+ * Calls may be nested, only the outermost pop closes the arena.
+ * No-op unless arena is enabled with xml_arena_enable()
+ * @retval  0   OK
+ * @code
+ *   xml_arena_push();
+ *   ... build xml tree with xml_new() ...
+ *   xml_arena_pop();
+ * @endcode
+ * @see xml_arena_pop
+ */
+int
+xml_arena_push(void)
+{
+    if (_xml_arena_enable)
+        _xml_arena_depth++;
+    return 0;
+}
+
+/*! Stop allocating XML nodes and names from an arena
+ *
+ * @retval  0   OK
+ * @see xml_arena_push
+ */
+int
+xml_arena_pop(void)
+{
+    if (_xml_arena_depth > 0 && --_xml_arena_depth == 0)
+        xml_arena_chunk_close();
+    return 0;
+}
+
+/*! Allocate an object from the active XML arena
+ *
+ * @param[in]  sz    Size of object
+ * @retval     ptr   Allocated (uninitialized) memory
+ * @retval     NULL  No arena active, object too large or out of memory: use malloc
+ */
+static void *
+xml_arena_alloc(size_t sz)
+{
+    struct xml_arena_chunk *xac;
+    void                   *ptr;
+
+    if (_xml_arena_depth == 0 || sz > XML_ARENA_OBJ_MAX)
+        return NULL;
+    sz = (sz + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+    xac = _xml_arena_chunk;
+    if (xac == NULL || xac->xac_used + sz > XML_ARENA_CHUNK_SIZE){
+        xml_arena_chunk_close();
+        if ((xac = xml_arena_chunk_new()) == NULL)
+            return NULL;
+        _xml_arena_chunk = xac;
+    }
+    ptr = (char*)xac + xac->xac_used;
+    xac->xac_used += sz;
+    xac->xac_live++;
+    _xml_arena_objects++;
+    return ptr;
+}
+
+/*! Release an object allocated by xml_arena_alloc
+ *
+ * The chunk is freed when its last object is released, unless it is the active chunk
+ * @param[in]  ptr  Object allocated by xml_arena_alloc
+ */
+static void
+xml_arena_free(void *ptr)
+{
+    struct xml_arena_chunk *xac;
+
+    xac = (struct xml_arena_chunk *)((uintptr_t)ptr & ~((uintptr_t)XML_ARENA_CHUNK_SIZE - 1));
+    _xml_arena_objects--;
+    if (--xac->xac_live == 0 && !xac->xac_open)
+        xml_arena_chunk_free(xac);
+}
+
+#ifdef XML_NAME_INTERN
+/*! FNV-1a hash of a string used by the intern table
+ */
+static uint32_t
+xml_intern_hash(const char *str)
+{
+    uint32_t h = 2166136261u;
+
+    while (*str){
+        h ^= (uint8_t)*str++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/*! Get interned copy of a string, increment its reference count
+ *
+ * @param[in]  str   String
+ * @retval     istr  Interned string, release with xml_intern_put
+ * @retval     NULL  Error
+ */
+static char *
+xml_intern_get(const char *str)
+{
+    struct xml_intern  *xi;
+    struct xml_intern **vec;
+    struct xml_intern  *xn;
+    uint32_t            h;
+    size_t              len;
+    size_t              sz;
+    size_t              i;
+
+    h = xml_intern_hash(str);
+    if (_xml_intern_vec != NULL){
+        for (xi = _xml_intern_vec[h & (_xml_intern_size-1)]; xi; xi = xi->xi_next)
+            if (xi->xi_hash == h && strcmp(xi->xi_str, str) == 0){
+                xi->xi_refcnt++;
+                return xi->xi_str;
+            }
+    }
+    /* Grow bucket vector, keep at most one entry per bucket on average */
+    if (_xml_intern_nr >= _xml_intern_size){
+        sz = _xml_intern_size ? 2*_xml_intern_size : XML_INTERN_SIZE_START;
+        if ((vec = calloc(sz, sizeof(struct xml_intern *))) == NULL)
+            return NULL;
+        for (i=0; i<_xml_intern_size; i++){
+            while ((xi = _xml_intern_vec[i]) != NULL){
+                _xml_intern_vec[i] = xi->xi_next;
+                xi->xi_next = vec[xi->xi_hash & (sz-1)];
+                vec[xi->xi_hash & (sz-1)] = xi;
+            }
+        }
+        if (_xml_intern_vec)
+            free(_xml_intern_vec);
+        _xml_intern_vec = vec;
+        _xml_intern_size = sz;
+    }
+    len = strlen(str) + 1;
+    if ((xn = malloc(sizeof(struct xml_intern) + len)) == NULL)
+        return NULL;
+    memcpy(xn->xi_str, str, len);
+    xn->xi_hash = h;
+    xn->xi_refcnt = 1;
+    xn->xi_next = _xml_intern_vec[h & (_xml_intern_size-1)];
+    _xml_intern_vec[h & (_xml_intern_size-1)] = xn;
+    _xml_intern_nr++;
+    return xn->xi_str;
+}
+
+/*! Release an interned string, free it when last reference is released
+ *
+ * @param[in]  str  Interned string, returned by xml_intern_get
+ */
+static void
+xml_intern_put(char *str)
+{
+    struct xml_intern  *xi;
+    struct xml_intern **xp;
+
+    xi = (struct xml_intern *)(str - offsetof(struct xml_intern, xi_str));
+    if (--xi->xi_refcnt > 0)
+        return;
+    for (xp = &_xml_intern_vec[xi->xi_hash & (_xml_intern_size-1)]; *xp; xp = &(*xp)->xi_next)
+        if (*xp == xi){
+            *xp = xi->xi_next;
+            break;
+        }
+    _xml_intern_nr--;
+    free(xi);
+}
+
+/*! Find interned string without incrementing its reference count
+ *
+ * @param[in]  str   String
+ * @retval     istr  Interned string, only valid as long as some XML node references it
+ * @retval     NULL  Not interned, ie no XML node has str as interned name or prefix
+ */
+static char *
+xml_intern_find(const char *str)
+{
+    struct xml_intern *xi;
+    uint32_t           h;
+
+    if (_xml_intern_vec == NULL)
+        return NULL;
+    h = xml_intern_hash(str);
+    for (xi = _xml_intern_vec[h & (_xml_intern_size-1)]; xi; xi = xi->xi_next)
+        if (xi->xi_hash == h && strcmp(xi->xi_str, str) == 0)
+            return xi->xi_str;
+    return NULL;
+}
+
+/*! Get a reference to an interned name, for fast name comparisons with XML nodes
+ *
+ * If both the XML node name and the given name are interned, they are equal only if the
+ * pointers are equal, see xml_name_interned.
+ * @param[in]  name  Name
+ * @retval     iname Interned name, release with xml_name_intern_free
+ * @retval     NULL  Error
+ * @see xpath_parse where XPath nodetest names are interned
+ */
+char *
+xml_name_intern(const char *name)
+{
+    return xml_intern_get(name);
+}
+
+/*! Release a reference to an interned name
+ *
+ * @param[in]  iname Interned name, returned by xml_name_intern
+ */
+void
+xml_name_intern_free(char *iname)
+{
+    if (iname)
+        xml_intern_put(iname);
+}
+
+/*! Is name of XML node interned
+ *
+ * @param[in]  x   XML node
+ * @retval     1   Yes, xml_name(x) can be compared with other interned names by pointer
+ * @retval     0   No
+ */
+int
+xml_name_interned(cxobj *x)
+{
+    return (x->x_alloc & XML_ALLOC_NAME_INTERN) != 0;
+}
+#endif /* XML_NAME_INTERN */
+
+/*! Duplicate a name or prefix string
+ *
+ * The string is interned if XML_NAME_INTERN is set, or allocated from the active arena
+ * if possible, otherwise malloced.
+ * @param[in]     str        String to copy
+ * @param[in,out] alloc      Allocation flags of XML node, see XML_ALLOC_*
+ * @param[in]     arenaflag  Flag to set if allocated from arena
+ * @param[in]     internflag Flag to set if interned
+ * @retval        dup        Copied string, free with xml_str_free
+ * @retval        NULL       Error
+ */
+static char *
+xml_str_dup(char     *str,
+            uint16_t *alloc,
+            uint16_t  arenaflag,
+            uint16_t  internflag)
+{
+    char  *dup;
+    size_t len;
+
+#ifdef XML_NAME_INTERN
+    if ((dup = xml_intern_get(str)) != NULL){
+        *alloc |= internflag;
+        return dup;
+    }
+#endif
+    len = strlen(str) + 1;
+    if ((dup = xml_arena_alloc(len)) != NULL){
+        memcpy(dup, str, len);
+        *alloc |= arenaflag;
+        return dup;
+    }
+    return strdup(str);
+}
+
+/*! Free a name or prefix string allocated by xml_str_dup
+ *
+ * @param[in]     str        String to free
+ * @param[in,out] alloc      Allocation flags of XML node, see XML_ALLOC_*
+ * @param[in]     arenaflag  Flag set if allocated from arena
+ * @param[in]     internflag Flag set if interned
+ */
+static void
+xml_str_free(char     *str,
+             uint16_t *alloc,
+             uint16_t  arenaflag,
+             uint16_t  internflag)
+{
+#ifdef XML_NAME_INTERN
+    if (*alloc & internflag)
+        xml_intern_put(str);
+    else
+#endif
+    if (*alloc & arenaflag)
+        xml_arena_free(str);
+    else
+        free(str);
+    *alloc &= ~(arenaflag|internflag);
+}
+
 /*! Get global statistics about XML objects
  *
  * @param[out]  nr  Number of existing XML objects (created - freed)
@@ -262,18 +1026,23 @@ xml_stats_one(cxobj    *x,
 {
     size_t sz = 0;
 
-    if (x->x_name)
+    /* Interned names are shared and not counted */
+    if (x->x_name && (x->x_alloc & XML_ALLOC_NAME_INTERN) == 0)
         sz += strlen(x->x_name) + 1;
-    if (x->x_prefix)
+    if (x->x_prefix && (x->x_alloc & XML_ALLOC_PREFIX_INTERN) == 0)
         sz += strlen(x->x_prefix) + 1;
     switch (xml_type(x)){
     case CX_ELMNT:
         sz += sizeof(struct xml);
-        sz += x->x_childvec_max*sizeof(struct xml*);
+        sz += xml_childvec_heap(x)*sizeof(struct xml*);
         if (x->x_ns_cache)
             sz += cvec_size(x->x_ns_cache);
         if (x->x_cv)
             sz += cv_size(x->x_cv);
+#ifdef XML_PATH_CACHE
+        if (x->x_path)
+            sz += strlen(x->x_path) + 1;
+#endif
 #ifdef XML_EXPLICIT_INDEX
         if (x->x_search_index){
             /* XXX: only one */
@@ -288,8 +1057,7 @@ xml_stats_one(cxobj    *x,
     case CX_BODY:
     case CX_ATTR:
         sz += sizeof(struct xmlbody);
-        if (x->x_value_cb)
-            sz += cbuf_buflen(x->x_value_cb);
+        sz += xml_xb(x)->xb_value_max;
         break;
     default:
         break;
@@ -312,9 +1080,10 @@ xml_stats(cxobj    *xt,
           uint64_t *nrp,
           size_t   *szp)
 {
-    int    retval = -1;
-    size_t sz = 0;
-    cxobj *xc;
+    int        retval = -1;
+    size_t     sz = 0;
+    xml_iter_t it;
+    cxobj     *xc;
 
     if (xt == NULL){
         clixon_err(OE_XML, EINVAL, "xml node is NULL");
@@ -324,8 +1093,8 @@ xml_stats(cxobj    *xt,
     xml_stats_one(xt, &sz);
     if (szp)
         *szp += sz;
-    xc = NULL;
-    while ((xc = xml_child_each(xt, xc, -1)) != NULL) {
+    xml_iter_init(&it, xt, CX_ERROR);
+    while ((xc = xml_iter_next(&it)) != NULL) {
         sz=0;
         xml_stats(xc, nrp, &sz);
         if (szp)
@@ -339,6 +1108,26 @@ xml_stats(cxobj    *xt,
 /*
  * Access functions
  */
+#ifdef XML_HASH_CACHE
+/*! Clear cached subtree hash of XML node and its ancestors
+ *
+ * If a node has no cached hash, neither have its ancestors, since a hash is only computed
+ * after the hashes of all descendants.
+ * @param[in]  x   XML node, non-elements are skipped
+ * @see xml_tree_hash
+ */
+static void
+xml_hash_invalidate(cxobj *x)
+{
+    if (x != NULL && !is_element(x))
+        x = x->x_up;
+    while (x != NULL && x->x_hash != 0){
+        x->x_hash = 0;
+        x = x->x_up;
+    }
+}
+#endif
+
 /*! Get name of xnode
  *
  * @param[in]  xn    xml node
@@ -364,16 +1153,26 @@ int
 xml_name_set(cxobj *xn,
              char  *name)
 {
-    if (xn->x_name){
-        free(xn->x_name);
-        xn->x_name = NULL;
-    }
+    char    *str = NULL;
+    uint16_t alloc = 0;
+
+    /* Copy new before freeing old, in case they are the same */
     if (name){
-        if ((xn->x_name = strdup(name)) == NULL){
+        if ((str = xml_str_dup(name, &alloc, XML_ALLOC_NAME, XML_ALLOC_NAME_INTERN)) == NULL){
             clixon_err(OE_XML, errno, "strdup");
             return -1;
         }
     }
+    if (xn->x_name)
+        xml_str_free(xn->x_name, &xn->x_alloc, XML_ALLOC_NAME, XML_ALLOC_NAME_INTERN);
+#ifdef XML_PATH_CACHE
+    xml_path_cache_invalidate(xn);
+#endif
+#ifdef XML_HASH_CACHE
+    xml_hash_invalidate(xn);
+#endif
+    xn->x_name = str;
+    xn->x_alloc |= alloc;
     return 0;
 }
 
@@ -399,16 +1198,27 @@ int
 xml_prefix_set(cxobj *xn,
                char  *prefix)
 {
-    if (xn->x_prefix){
-        free(xn->x_prefix);
-        xn->x_prefix = NULL;
-    }
+    char    *str = NULL;
+    uint16_t alloc = 0;
+
+    /* Copy new before freeing old, in case they are the same */
     if (prefix){
-        if ((xn->x_prefix = strdup(prefix)) == NULL){
+        if ((str = xml_str_dup(prefix, &alloc, XML_ALLOC_PREFIX, XML_ALLOC_PREFIX_INTERN)) == NULL){
             clixon_err(OE_XML, errno, "strdup");
             return -1;
         }
     }
+    if (xn->x_prefix)
+        xml_str_free(xn->x_prefix, &xn->x_alloc, XML_ALLOC_PREFIX, XML_ALLOC_PREFIX_INTERN);
+#ifdef XML_PATH_CACHE
+    xml_path_cache_invalidate(xn);
+#endif
+#ifdef XML_HASH_CACHE
+    xml_hash_invalidate(xn);
+#endif
+    xn->x_prefix = str;
+    xn->x_alloc |= alloc;
+    xn->x_flags &= ~XML_FLAG_NS_SPEC;
     return 0;
 }
 
@@ -484,6 +1294,9 @@ nscache_set(cxobj *x,
 
     if (!is_element(x))
         return 0;
+    /* Own namespace is set explicitly */
+    if (prefix == NULL ? x->x_prefix == NULL : (x->x_prefix && strcmp(prefix, x->x_prefix) == 0))
+        x->x_flags &= ~XML_FLAG_NS_SPEC;
     if (x->x_ns_cache == NULL){
         if ((x->x_ns_cache = xml_nsctx_init(prefix, namespace)) == NULL)
             goto done;
@@ -516,6 +1329,7 @@ nscache_replace(cxobj *x,
         x->x_ns_cache = NULL;
     }
     x->x_ns_cache = nsc;
+    x->x_flags &= ~XML_FLAG_NS_SPEC;
     retval = 0;
     // done:
     return retval;
@@ -539,6 +1353,7 @@ nscache_clear(cxobj *x)
         xml_nsctx_free(x->x_ns_cache);
         x->x_ns_cache = NULL;
     }
+    x->x_flags &= ~XML_FLAG_NS_SPEC;
     return 0;
 }
 
@@ -567,6 +1382,10 @@ int
 xml_parent_set(cxobj *xn,
                cxobj *parent)
 {
+#ifdef XML_PATH_CACHE
+    if (xn->x_up != parent)
+        xml_path_cache_invalidate(xn);
+#endif
     xn->x_up = parent;
     return 0;
 }
@@ -649,10 +1468,70 @@ xml_value(cxobj *xn)
 {
     if (!is_bodyattr(xn))
         return NULL;
-    return xn->x_value_cb?cbuf_get(xn->x_value_cb):NULL;
+    return xml_xb(xn)->xb_value;
 }
 
-/*! Set value of xml node, value is copied
+/*! Store value of body or attribute node
+ *
+ * Short values are stored inline in the node. Longer values are malloced, and appended
+ * values grow exponentially, eg text parsed in several parts.
+ * @param[in]  xn     XML body or attribute node
+ * @param[in]  val    Null-terminated string, copied
+ * @param[in]  append If set, append val to existing value, otherwise replace it
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+xml_value_put(cxobj *xn,
+              char  *val,
+              int    append)
+{
+    struct xmlbody *xb = xml_xb(xn);
+    size_t          pos;
+    size_t          len;
+    size_t          max;
+    char           *buf;
+
+    pos = (append && xb->xb_value) ? xb->xb_value_len : 0;
+    len = strlen(val);
+    if (pos + len + 1 > UINT32_MAX){
+        clixon_err(OE_XML, EINVAL, "value too long");
+        return -1;
+    }
+    if (pos + len + 1 > XML_VALUE_INLINE && pos + len + 1 > xb->xb_value_max){
+        max = pos + len + 1;
+        if (append && xb->xb_value_max && max < 2*(size_t)xb->xb_value_max)
+            max = 2*(size_t)xb->xb_value_max;
+        if (xb->xb_value_max){
+            if ((buf = realloc(xb->xb_value, max)) == NULL){
+                clixon_err(OE_XML, errno, "realloc");
+                return -1;
+            }
+        }
+        else {
+            if ((buf = malloc(max)) == NULL){
+                clixon_err(OE_XML, errno, "malloc");
+                return -1;
+            }
+            if (pos)
+                memcpy(buf, xb->xb_inline, pos);
+        }
+        clixon_mem_charge(xml_mem_tag(xn), (int64_t)max - xb->xb_value_max);
+        xb->xb_value = buf;
+        xb->xb_value_max = max;
+    }
+    else if (xb->xb_value == NULL)
+        xb->xb_value = xb->xb_inline;
+    memmove(xb->xb_value + pos, val, len);
+    xb->xb_value[pos + len] = '\0';
+    xb->xb_value_len = pos + len;
+#ifdef XML_HASH_CACHE
+    xml_hash_invalidate(xn);
+#endif
+    return 0;
+}
+
+/*! Set value of xml node, value is copied
  *
  * @param[in]  xn    xml node
  * @param[in]  val   new value, null-terminated string, copied by function
@@ -664,7 +1543,9 @@ xml_value_set(cxobj *xn,
               char  *val)
 {
     int    retval = -1;
-    size_t sz;
+#ifdef XML_EXPLICIT_INDEX
+    cxobj *xi = NULL;
+#endif
 
     if (!is_bodyattr(xn))
         return 0;
@@ -672,16 +1553,30 @@ xml_value_set(cxobj *xn,
         clixon_err(OE_XML, EINVAL, "value is NULL");
         goto done;
     }
-    sz = strlen(val)+1;
-    if (xn->x_value_cb == NULL){
-        if ((xn->x_value_cb = cbuf_new_alloc(sz)) == NULL){
-            clixon_err(OE_XML, errno, "cbuf_new");
+#ifdef XML_EXPLICIT_INDEX
+    /* Body of a search index changes: remove from search vector before changing value */
+    if (xml_type(xn) == CX_BODY &&
+        xn->x_up && xml_search_index_p(xn->x_up)){
+        xi = xn->x_up;
+        if (xml_search_value_update(xi, 0) < 0)
             goto done;
-        }
     }
-    else
-        cbuf_reset(xn->x_value_cb);
-    cbuf_append_str(xn->x_value_cb, val);
+#endif
+    if (xml_value_put(xn, val, 0) < 0)
+        goto done;
+    if (xn->x_up){
+        xn->x_up->x_union_type = NULL;
+#ifdef XML_PATH_CACHE
+        xml_path_cache_value(xn->x_up);
+#endif
+        /* Cached value of parent is stale */
+        if (xml_type(xn) == CX_BODY)
+            xml_cv_set(xn->x_up, NULL);
+    }
+#ifdef XML_EXPLICIT_INDEX
+    if (xi && xml_search_value_update(xi, 1) < 0)
+        goto done;
+#endif
     retval = 0;
  done:
     return retval;
@@ -699,7 +1594,6 @@ xml_value_append(cxobj *xn,
                  char  *val)
 {
     int    retval = -1;
-    size_t sz;
 
     if (!is_bodyattr(xn))
         return 0;
@@ -707,16 +1601,16 @@ xml_value_append(cxobj *xn,
         clixon_err(OE_XML, EINVAL, "value is NULL");
         goto done;
     }
-    sz = strlen(val)+1;
-    if (xn->x_value_cb == NULL){
-        if ((xn->x_value_cb = cbuf_new_alloc(sz)) == NULL){
-            clixon_err(OE_XML, errno, "cbuf_new");
-            goto done;
-        }
-    }
-    if (cbuf_append_str(xn->x_value_cb, val) < 0){
-        clixon_err(OE_XML, errno, "cprintf");
+    if (xml_value_put(xn, val, 1) < 0)
         goto done;
+    if (xn->x_up){
+        xn->x_up->x_union_type = NULL;
+#ifdef XML_PATH_CACHE
+        xml_path_cache_value(xn->x_up);
+#endif
+        /* Cached value of parent is stale */
+        if (xml_type(xn) == CX_BODY)
+            xml_cv_set(xn->x_up, NULL);
     }
     retval = 0;
  done:
@@ -783,18 +1677,35 @@ int
 xml_child_nr_notype(cxobj          *xn,
                     enum cxobj_type type)
 {
-    cxobj *x = NULL;
-    int    nr = 0;
+    xml_iter_t it;
+    cxobj     *x;
+    int        nr = 0;
 
     if (!is_element(xn))
         return 0;
-    while ((x = xml_child_each(xn, x, -1)) != NULL) {
+    xml_iter_init(&it, xn, CX_ERROR);
+    while ((x = xml_iter_next(&it)) != NULL) {
         if (xml_type(x) != type)
             nr++;
     }
     return nr;
 }
 
+/*! Get number of attributes of XML node
+ *
+ * Attributes are kept first among the children, so that other children, eg sorted
+ * elements, are in the range from this number to xml_child_nr
+ * @param[in]  xn    xml node
+ * @retval     number of attributes
+ */
+int
+xml_child_nr_attr(cxobj *xn)
+{
+    if (!is_element(xn))
+        return 0;
+    return xn->x_childvec_nattr;
+}
+
 /*! Get number of children of specific type
  *
  * @param[in]  xn    xml node
@@ -807,12 +1718,15 @@ int
 xml_child_nr_type(cxobj          *xn,
                   enum cxobj_type type)
 {
-    cxobj *x = NULL;
-    int    len = 0;
+    xml_iter_t it;
+    int        len = 0;
 
     if (!is_element(xn))
         return 0;
-    while ((x = xml_child_each(xn, x, type)) != NULL)
+    if (type == CX_ATTR)
+        return xn->x_childvec_nattr;
+    xml_iter_init(&it, xn, type);
+    while (xml_iter_next(&it) != NULL)
         len++;
     return len;
 }
@@ -836,7 +1750,7 @@ xml_child_i(cxobj *xn,
     if (!is_element(xn))
         return NULL;
     if (i < xn->x_childvec_len)
-        return xn->x_childvec[i];
+        return xn->x_childvec[xml_childvec_pos(xn, i)];
     return NULL;
 }
 
@@ -853,13 +1767,15 @@ xml_child_i_type(cxobj          *xn,
                  int             i,
                  enum cxobj_type type)
 {
-    cxobj *x = NULL;
-    int    it = 0;
+    xml_iter_t it;
+    cxobj     *x;
+    int        j = 0;
 
     if (!is_element(xn))
         return NULL;
-    while ((x = xml_child_each(xn, x, type)) != NULL) {
-        if (x->x_type == type && (i == it++))
+    xml_iter_init(&it, xn, type);
+    while ((x = xml_iter_next(&it)) != NULL) {
+        if (x->x_type == type && (i == j++))
             return x;
     }
     return NULL;
@@ -879,8 +1795,18 @@ xml_child_i_set(cxobj *xt,
 {
     if (!is_element(xt))
         return NULL;
-    if (i < xt->x_childvec_len)
-        xt->x_childvec[i] = xc;
+    if (i < xt->x_childvec_len){
+        /* Keep attributes first, see xml_child_nr_attr */
+        if (i < xt->x_childvec_nattr && (xc == NULL || xml_type(xc) != CX_ATTR))
+            xt->x_childvec_nattr = i;
+        else if (i == xt->x_childvec_nattr && xc && xml_type(xc) == CX_ATTR)
+            xt->x_childvec_nattr++;
+        xt->x_childvec[xml_childvec_pos(xt, i)] = xc;
+    }
+    xt->x_union_type = NULL;
+#ifdef XML_HASH_CACHE
+    xml_hash_invalidate(xt);
+#endif
     return 0;
 }
 
@@ -942,6 +1868,7 @@ xml_child_order(cxobj *xp,
  * @endcode
  * @see xml_child_index_each
  * @see xml_child_each_attr  hardcoded for sorted list and attributes
+ * @see xml_iter_init        Iterator with state in the caller, for nested loops and readers
  */
 cxobj *
 xml_child_each(cxobj           *xparent,
@@ -956,7 +1883,7 @@ xml_child_each(cxobj           *xparent,
     if (!is_element(xparent))
         return NULL;
     for (i=xprev?xprev->_x_vector_i+1:0; i<xparent->x_childvec_len; i++){
-        xn = xparent->x_childvec[i];
+        xn = xparent->x_childvec[xml_childvec_pos(xparent, i)];
         if (xn == NULL)
             continue;
         if (type != CX_ERROR && xml_type(xn) != type)
@@ -970,6 +1897,138 @@ xml_child_each(cxobj           *xparent,
     return xn;
 }
 
+/*! Find first child with a given yang spec
+ *
+ * Children of a node bound to yang are sorted on yang order, and are found with binary
+ * search, otherwise linearly. The child can be given as previous to xml_child_yang_next
+ * or xml_child_each to continue iterating.
+ * @param[in]  xp    XML parent
+ * @param[in]  yc    Yang spec of child
+ * @retval     x     First child with spec yc
+ * @retval     NULL  Not found
+ * @see xml_child_range_yang
+ */
+cxobj *
+xml_child_yang(cxobj     *xp,
+               yang_stmt *yc)
+{
+    cxobj *x;
+    int    lo;
+    int    hi;
+    int    i;
+
+    if (xp == NULL || yc == NULL || !is_element(xp))
+        return NULL;
+    if (xml_child_range_yang(xp, yc, &lo, &hi) == 1){
+        if (lo == hi)
+            return NULL;
+        if ((x = xml_child_i(xp, lo)) != NULL && x->x_spec == yc){
+            x->_x_vector_i = lo;
+            return x;
+        }
+    }
+    /* Not bound or sorted */
+    for (i=0; i<xp->x_childvec_len; i++){
+        if ((x = xp->x_childvec[xml_childvec_pos(xp, i)]) == NULL)
+            continue;
+        if (xml_type(x) == CX_ELMNT && x->x_spec == yc){
+            x->_x_vector_i = i;
+            return x;
+        }
+    }
+    return NULL;
+}
+
+/*! Next child with same yang spec as previous, eg next list entry
+ *
+ * Children with the same yang spec are adjacent if the parent is bound and sorted,
+ * the iteration ends at the first child with another yang spec
+ * @param[in]  xp     XML parent
+ * @param[in]  xprev  Previous child, as returned by xml_child_yang or this function
+ * @retval     x      Next child with spec of xprev
+ * @retval     NULL   No more
+ * @code
+ *   for (x = xml_child_yang(xp, ylist); x; x = xml_child_yang_next(xp, x))
+ *      ...
+ * @endcode
+ * @note uses _x_vector_i as xml_child_each
+ */
+cxobj *
+xml_child_yang_next(cxobj *xp,
+                    cxobj *xprev)
+{
+    cxobj     *x = xprev;
+    yang_stmt *y;
+
+    if (xprev == NULL)
+        return NULL;
+    y = xprev->x_spec;
+    while ((x = xml_child_each(xp, x, CX_ELMNT)) != NULL){
+        if (x->x_spec == y)
+            return x;
+        if (x->x_spec != NULL && y != NULL)
+            break;
+    }
+    return NULL;
+}
+
+/*! Find list entry child with a given single key value
+ *
+ * If sorted, the entries are found with binary search on the key value. This requires
+ * that the list is ordered-by system and that the key is compared as a string, ie is not
+ * of a numeric type. Otherwise entries are searched linearly.
+ * @param[in]  xp      XML parent
+ * @param[in]  yc      Yang spec of list
+ * @param[in]  ykey    Yang spec of key leaf
+ * @param[in]  val     Key value
+ * @param[in]  sorted  Entries are sorted on key value as strings
+ * @retval     x       List entry
+ * @retval     NULL    Not found
+ */
+cxobj *
+xml_child_yang_key(cxobj      *xp,
+                   yang_stmt  *yc,
+                   yang_stmt  *ykey,
+                   const char *val,
+                   int         sorted)
+{
+    cxobj *x;
+    cxobj *xk;
+    char  *b;
+    int    lo;
+    int    hi;
+    int    mid;
+    int    eq;
+
+    if (sorted && xp != NULL && yc != NULL &&
+        xml_child_range_yang(xp, yc, &lo, &hi) == 1){
+        while (lo < hi){
+            mid = (lo + hi) / 2;
+            x = xml_child_i(xp, mid);
+            if (x->x_spec != yc)
+                goto linear;
+            if ((xk = xml_child_yang(x, ykey)) == NULL || (b = xml_body(xk)) == NULL)
+                goto linear;
+            if ((eq = strcmp(val, b)) == 0){
+                x->_x_vector_i = mid;
+                return x;
+            }
+            if (eq < 0)
+                hi = mid;
+            else
+                lo = mid + 1;
+        }
+        return NULL;
+    }
+ linear:
+    for (x = xml_child_yang(xp, yc); x != NULL; x = xml_child_yang_next(xp, x))
+        if ((xk = xml_child_yang(x, ykey)) != NULL &&
+            (b = xml_body(xk)) != NULL &&
+            strcmp(val, b) == 0)
+            return x;
+    return NULL;
+}
+
 /*! Same as xml_child_each but hard-coded for attributes
  *
  * Assumes attributes are first in list, which they are if they are sorted, but there are
@@ -992,22 +2051,207 @@ xml_child_each_attr(cxobj  *xparent,
         return NULL;
     if (!is_element(xparent))
         return NULL;
-    for (i=xprev?xprev->_x_vector_i+1:0; i<xparent->x_childvec_len; i++){
-        xn = xparent->x_childvec[i];
+    for (i=xprev?xprev->_x_vector_i+1:0; i<xparent->x_childvec_nattr; i++){
+        xn = xparent->x_childvec[xml_childvec_pos(xparent, i)];
         if (xn == NULL)
             continue;
-        if (xml_type(xn) != CX_ATTR){
-            return NULL;
-        }
         break; /* this is next object after previous */
     }
-    if (i < xparent->x_childvec_len) /* found */
+    if (i < xparent->x_childvec_nattr) /* found */
         xn->_x_vector_i = i;
     else
         xn = NULL;
     return xn;
 }
 
+/*! Grow child vector of XML node to fit x_childvec_len children
+ *
+ * A single child, typically the body of a leaf, is stored in x_child1 of the node
+ * itself, larger vectors are malloced.
+ * @param[in]  xp    XML element
+ * @param[in]  start Size of a new vector
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+xml_childvec_grow(cxobj *xp,
+                  size_t start)
+{
+    struct xml **vec;
+    int          max;
+    int          heap;
+
+    if (xp->x_childvec_max == 0 && start == 1){
+        xp->x_childvec = &xp->x_child1;
+        xp->x_childvec_max = 1;
+        return 0;
+    }
+    heap = xml_childvec_heap(xp);
+    if (xp->x_childvec_len < XML_CHILDVEC_SIZE_THRESHOLD)
+        max = xp->x_childvec_max?2*xp->x_childvec_max:start;
+    else
+        max = xp->x_childvec_max + XML_CHILDVEC_SIZE_THRESHOLD;
+    if (heap)
+        vec = realloc(xp->x_childvec, max*sizeof(cxobj*));
+    else if ((vec = malloc(max*sizeof(cxobj*))) != NULL && xp->x_childvec_max)
+        vec[0] = xp->x_child1;
+    if (vec == NULL){
+        clixon_err(OE_XML, errno, "realloc");
+        return -1;
+    }
+    clixon_mem_charge(xml_mem_tag(xp), (max - heap)*(int64_t)sizeof(cxobj*));
+    xp->x_childvec = vec;
+    xp->x_childvec_max = max;
+    xp->x_child1 = NULL;
+    return 0;
+}
+
+/*! Initialize iterator over children of an XML node
+ *
+ * @param[out] it      Iterator, eg on the stack
+ * @param[in]  xparent XML node whose children are iterated
+ * @param[in]  type    Matching type, or CX_ERROR (-1) for any
+ * @code
+ *   xml_iter_t it;
+ *   cxobj     *x;
+ *   xml_iter_init(&it, xt, CX_ELMNT);
+ *   while ((x = xml_iter_next(&it)) != NULL) {
+ *     ...
+ *   }
+ * @endcode
+ * Iterators do not modify the XML nodes, so loops over the same parent may be nested or
+ * run by concurrent readers.
+ * The last returned child may be removed, eg with xml_purge, during iteration and the
+ * iteration continues with the next child.
+ * @see xml_child_each  Earlier iterator, with state in the XML nodes
+ */
+void
+xml_iter_init(xml_iter_t     *it,
+              cxobj          *xparent,
+              enum cxobj_type type)
+{
+    it->xi_parent = (xparent && is_element(xparent)) ? xparent : NULL;
+    it->xi_last = NULL;
+    it->xi_i = 0;
+    it->xi_type = type;
+}
+
+/*! Get next child of XML iterator
+ *
+ * @param[in]  it   Iterator, see xml_iter_init
+ * @retval     xn   Next XML child
+ * @retval     NULL End of children
+ */
+cxobj *
+xml_iter_next(xml_iter_t *it)
+{
+    cxobj  *xp;
+    cxobj **vec;
+    cxobj  *xn;
+    int     len;
+    int     i;
+
+    if ((xp = it->xi_parent) == NULL)
+        return NULL;
+    vec = xp->x_childvec;
+    len = xp->x_childvec_len;
+    i = it->xi_i;
+    /* Children of parent changed since last child was returned: find it again, or if it
+     * was removed, continue with the child that took its place */
+    if (it->xi_last && (i > len || vec[xml_childvec_pos(xp, i-1)] != it->xi_last)){
+        for (i = 0; i < len; i++)
+            if (vec[xml_childvec_pos(xp, i)] == it->xi_last)
+                break;
+        if (i < len)
+            i++;
+        else if ((i = it->xi_i - 1) > len)
+            i = len;
+    }
+    /* Attributes are first: skip them for elements and stop after them for attributes */
+    if (it->xi_type == CX_ELMNT && i < xp->x_childvec_nattr)
+        i = xp->x_childvec_nattr;
+    else if (it->xi_type == CX_ATTR && len > xp->x_childvec_nattr)
+        len = xp->x_childvec_nattr;
+    for (; i < len; i++){
+        if ((xn = vec[xml_childvec_pos(xp, i)]) == NULL)
+            continue;
+        if (it->xi_type == CX_ERROR || xml_type(xn) == it->xi_type){
+            it->xi_i = i + 1;
+            it->xi_last = xn;
+            return xn;
+        }
+    }
+    it->xi_i = len;
+    it->xi_last = NULL;
+    return NULL;
+}
+
+/*! Move gap of unused entries of child vector to a position
+ *
+ * Children before pos are first in x_childvec, children from pos are last, and the
+ * unused entries are between them. A gap at the end is a plain vector.
+ * @param[in]  xp    XML element
+ * @param[in]  pos   Position of gap in 0..x_childvec_len
+ * @see XML_CHILDVEC_GAP_MIN
+ */
+static void
+xml_childvec_gap_move(cxobj *xp,
+                      int    pos)
+{
+    struct xml **vec = xp->x_childvec;
+    int          len = xp->x_childvec_len;
+    int          glen = xp->x_childvec_max - len;
+    int          gap;
+
+    gap = xp->x_childvec_gap ? xp->x_childvec_gap - 1 : len;
+    if (glen > 0){
+        if (pos < gap)
+            memmove(&vec[pos+glen], &vec[pos], (gap-pos)*sizeof(cxobj *));
+        else if (pos > gap)
+            memmove(&vec[gap], &vec[gap+glen], (pos-gap)*sizeof(cxobj *));
+    }
+    xp->x_childvec_gap = (pos == len || glen == 0) ? 0 : pos + 1;
+}
+
+/*! Insert child in child vector at position, growing it if needed
+ *
+ * Large vectors leave the gap after the inserted child, see XML_CHILDVEC_GAP_MIN. Then
+ * a sequence of inserts in order, eg list entries, moves no children after the first.
+ * @param[in]  xp    XML element
+ * @param[in]  xc    Child
+ * @param[in]  pos   Position in 0..x_childvec_len
+ * @param[in]  start Size of a new vector
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+xml_childvec_insert(cxobj *xp,
+                    cxobj *xc,
+                    int    pos,
+                    size_t start)
+{
+    int len = xp->x_childvec_len;
+
+    if (len == xp->x_childvec_max){
+        xp->x_childvec_gap = 0; /* Full, no gap */
+        if (xml_childvec_grow(xp, start) < 0)
+            return -1;
+    }
+    if (len >= XML_CHILDVEC_GAP_MIN || xp->x_childvec_gap){
+        xml_childvec_gap_move(xp, pos);
+        xp->x_childvec[pos] = xc;
+        xp->x_childvec_len++;
+        xp->x_childvec_gap = (pos + 1 == xp->x_childvec_len) ? 0 : pos + 2;
+    }
+    else {
+        if (pos < len)
+            memmove(&xp->x_childvec[pos+1], &xp->x_childvec[pos], (len-pos)*sizeof(cxobj *));
+        xp->x_childvec[pos] = xc;
+        xp->x_childvec_len++;
+    }
+    return 0;
+}
+
 /*! Extend child vector with one and insert xml node there
  *
  * @note does not do anything with child, you may need to set its parent, etc
@@ -1019,6 +2263,7 @@ xml_child_append(cxobj *xp,
                  cxobj *xc)
 {
     size_t start;
+    int    pos;
 
     if (!is_element(xp))
         return 0;
@@ -1028,19 +2273,17 @@ xml_child_append(cxobj *xp,
      */
     if (xml_type(xc) == CX_ELMNT)
         start = XML_CHILDVEC_SIZE_START_ELMNT;
-    xp->x_childvec_len++;
-    if (xp->x_childvec_len > xp->x_childvec_max){
-        if (xp->x_childvec_len < XML_CHILDVEC_SIZE_THRESHOLD)
-            xp->x_childvec_max = xp->x_childvec_max?2*xp->x_childvec_max:start;
-        else
-            xp->x_childvec_max += XML_CHILDVEC_SIZE_THRESHOLD;
-        xp->x_childvec = realloc(xp->x_childvec, xp->x_childvec_max*sizeof(cxobj*));
-        if (xp->x_childvec == NULL){
-            clixon_err(OE_XML, errno, "realloc");
-            return -1;
-        }
-    }
-    xp->x_childvec[xp->x_childvec_len-1] = xc;
+    /* Attributes are kept first, after existing attributes */
+    if (xml_type(xc) == CX_ATTR)
+        pos = xp->x_childvec_nattr++;
+    else
+        pos = xp->x_childvec_len;
+    if (xml_childvec_insert(xp, xc, pos, start) < 0)
+        return -1;
+    xp->x_union_type = NULL;
+#ifdef XML_HASH_CACHE
+    xml_hash_invalidate(xp);
+#endif
     return 0;
 }
 
@@ -1059,25 +2302,22 @@ xml_child_insert_pos(cxobj *xp,
                      cxobj *xc,
                      int    pos)
 {
-    size_t size;
-
     if (!is_element(xp))
         return 0;
-    xp->x_childvec_len++;
-    if (xp->x_childvec_len > xp->x_childvec_max){
-        if (xp->x_childvec_len < XML_CHILDVEC_SIZE_THRESHOLD)
-            xp->x_childvec_max = xp->x_childvec_max?2*xp->x_childvec_max:XML_CHILDVEC_SIZE_START;
-        else
-            xp->x_childvec_max += XML_CHILDVEC_SIZE_THRESHOLD;
-        xp->x_childvec = realloc(xp->x_childvec, xp->x_childvec_max*sizeof(cxobj*));
-        if (xp->x_childvec == NULL){
-            clixon_err(OE_XML, errno, "realloc");
-            return -1;
-        }
+    /* Attributes are kept first, see xml_child_nr_attr */
+    if (xml_type(xc) == CX_ATTR){
+        if (pos > xp->x_childvec_nattr)
+            pos = xp->x_childvec_nattr;
+        xp->x_childvec_nattr++;
     }
-    size = (xml_child_nr(xp) - pos - 1)*sizeof(cxobj *);
-    memmove(&xp->x_childvec[pos+1], &xp->x_childvec[pos], size);
-    xp->x_childvec[pos] = xc;
+    else if (pos < xp->x_childvec_nattr)
+        pos = xp->x_childvec_nattr;
+    if (xml_childvec_insert(xp, xc, pos, XML_CHILDVEC_SIZE_START) < 0)
+        return -1;
+    xp->x_union_type = NULL;
+#ifdef XML_HASH_CACHE
+    xml_hash_invalidate(xp);
+#endif
     return 0;
 }
 
@@ -1095,11 +2335,21 @@ xml_childvec_set(cxobj *x,
 {
     if (!is_element(x))
         return 0;
+    clixon_mem_charge(xml_mem_tag(x), ((len>1?len:0) - xml_childvec_heap(x))*(int64_t)sizeof(cxobj*));
+    if (xml_childvec_heap(x))
+        free(x->x_childvec);
     x->x_childvec_len = len;
     x->x_childvec_max = len;
-    if (x->x_childvec)
-        free(x->x_childvec);
-    if ((x->x_childvec = calloc(len, sizeof(cxobj*))) == NULL){
+    x->x_childvec_nattr = 0;
+    x->x_childvec_gap = 0;
+    x->x_union_type = NULL;
+#ifdef XML_HASH_CACHE
+    xml_hash_invalidate(x);
+#endif
+    x->x_child1 = NULL;
+    if (len <= 1)
+        x->x_childvec = len ? &x->x_child1 : NULL;
+    else if ((x->x_childvec = calloc(len, sizeof(cxobj*))) == NULL){
         clixon_err(OE_XML, errno, "calloc");
         return -1;
     }
@@ -1107,15 +2357,34 @@ xml_childvec_set(cxobj *x,
 }
 
 /*! Get the children of an XML node as an XML vector
+ *
+ * @note A caller that reorders the vector must call xml_childvec_reordered
  */
 cxobj **
 xml_childvec_get(cxobj *x)
 {
     if (!is_element(x))
         return NULL;
+    if (x->x_childvec_gap) /* Callers expect children first in vector */
+        xml_childvec_gap_move(x, x->x_childvec_len);
     return x->x_childvec;
 }
 
+/*! Children of an XML node are reordered in the vector of xml_childvec_get
+ *
+ * Clears the cached subtree hashes of the node and its ancestors, which depend on child order
+ * @param[in]  x   XML node
+ * @see xml_tree_hash
+ */
+void
+xml_childvec_reordered(cxobj *x)
+{
+#ifdef XML_HASH_CACHE
+    if (is_element(x))
+        xml_hash_invalidate(x);
+#endif
+}
+
 /*! Given an XML object and a vector of children xvec, append the children to the object
  *
  * @param[in]  x   XML node
@@ -1157,6 +2426,7 @@ clixon_child_xvec_append(cxobj       *xn,
  *   xml_free(x);
  * @endcode
  * @note Differentiates between body/attribute vs element to reduce mem allocation
+ * @note Allocated from XML arena if enabled and active, see xml_arena_push
  * @see xml_insert
  */
 cxobj *
@@ -1166,6 +2436,7 @@ xml_new(char           *name,
 {
     struct xml *x = NULL;
     size_t      sz;
+    int         tag;
 
     switch (type){
     case CX_ELMNT:
@@ -1180,12 +2451,22 @@ xml_new(char           *name,
         return NULL;
         break;
     }
-    if ((x = malloc(sz)) == NULL){
-        clixon_err(OE_XML, errno, "malloc");
-        return NULL;
+    if ((x = xml_arena_alloc(sz)) != NULL){
+        memset(x, 0, sz);
+        x->x_alloc = XML_ALLOC_NODE;
+    }
+    else {
+        if ((x = malloc(sz)) == NULL){
+            clixon_err(OE_XML, errno, "malloc");
+            return NULL;
+        }
+        memset(x, 0, sz);
     }
-    memset(x, 0, sz);
     xml_type_set(x, type);
+    if ((tag = clixon_mem_tag_current()) != CLIXON_MEM_TAG_NONE){
+        x->x_alloc |= tag << XML_ALLOC_TAG_SHIFT;
+        clixon_mem_charge(tag, sz);
+    }
     if (name && (xml_name_set(x, name)) < 0)
         return NULL;
     if (xp){
@@ -1252,10 +2533,119 @@ xml_spec_set(cxobj     *x,
 {
     if (!is_element(x))
         return 0;
+#ifdef XML_PATH_CACHE
+    if (x->x_spec != spec)
+        xml_path_cache_invalidate(x);
+#endif
     x->x_spec = spec;
+    x->x_union_type = NULL;
+    x->x_flags &= ~XML_FLAG_NS_SPEC;
+    return 0;
+}
+
+#ifdef XML_PATH_CACHE
+/*! Get cached xpath of XML node to root
+ *
+ * The cache is valid until a cached node is renamed, moved or one of its keys are
+ * changed. Then all cached paths are invalidated by stepping the generation.
+ * This means that a node with a valid cached path also has ancestors with valid cached
+ * paths, and it suffices to check the node itself when the tree is changed.
+ * @param[in]  x     XML node
+ * @param[in]  spec  Path variant, see spec argument of xml2xpath
+ * @retval     path  Cached path, do not free
+ * @retval     NULL  Not cached or not valid
+ * @see xml2xpath
+ */
+char *
+xml_path_cache_get(cxobj *x,
+                   int    spec)
+{
+    if (!is_element(x))
+        return NULL;
+    if (x->x_path == NULL ||
+        x->x_path_gen != ((_xml_path_gen << 1) | (spec?1:0)))
+        return NULL;
+    return x->x_path;
+}
+
+/*! Set cached xpath of XML node to root
+ *
+ * @param[in]  x     XML node
+ * @param[in]  spec  Path variant, see spec argument of xml2xpath
+ * @param[in]  path  Path, copied
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+int
+xml_path_cache_set(cxobj *x,
+                   int    spec,
+                   char  *path)
+{
+    char *str;
+
+    if (!is_element(x))
+        return 0;
+    if ((str = strdup(path)) == NULL){
+        clixon_err(OE_XML, errno, "strdup");
+        return -1;
+    }
+    if (x->x_path)
+        free(x->x_path);
+    x->x_path = str;
+    x->x_path_gen = (_xml_path_gen << 1) | (spec?1:0);
     return 0;
 }
 
+/*! Value of a leaf or leaf-list is changed, invalidate cache if value is part of path
+ *
+ * Leaf-list values and list keys are part of the path
+ * @param[in]  xl    XML leaf or leaf-list node whose body is changed
+ */
+static void
+xml_path_cache_value(cxobj *xl)
+{
+    yang_stmt *y;
+    yang_stmt *yp;
+    cxobj     *xp;
+    cg_var    *cvi;
+
+    xp = xl->x_up;
+    if ((y = xml_spec(xl)) == NULL){
+        xml_path_cache_invalidate(xl);
+        if (xp)
+            xml_path_cache_invalidate(xp);
+    }
+    else if (yang_keyword_get(y) == Y_LEAF_LIST)
+        xml_path_cache_invalidate(xl);
+    else if (xp && xp->x_path && (xp->x_path_gen >> 1) == _xml_path_gen &&
+             (yp = xml_spec(xp)) != NULL &&
+             yang_keyword_get(yp) == Y_LIST){
+        /* Use Y_LIST cache, see ys_populate_list() */
+        cvi = NULL;
+        while ((cvi = cvec_each(yang_cvec_get(yp), cvi)) != NULL)
+            if (strcmp(xml_name(xl), cv_string_get(cvi)) == 0){
+                xml_path_cache_invalidate(xp);
+                break;
+            }
+    }
+}
+
+/*! XML node that may have a valid cached path is changed, invalidate cache
+ *
+ * Only if the node itself has a valid cached path, then the generation is stepped
+ * and all cached paths are invalid. Otherwise no descendant has a valid cached path either.
+ * @param[in]  x     XML node
+ */
+void
+xml_path_cache_invalidate(cxobj *x)
+{
+    if (!is_element(x) || x->x_path == NULL)
+        return;
+    if ((x->x_path_gen >> 1) == _xml_path_gen)
+        _xml_path_gen++;
+}
+#endif /* XML_PATH_CACHE */
+
 /*! Return (cached)  cligen variable value of xml node
  *
  * @param[in]  x    XML node (body and leaf/leaf-list)
@@ -1283,17 +2673,138 @@ xml_cv(cxobj *x)
  * @see xml_cv_cache
  */
 int
-xml_cv_set(cxobj  *x,
-           cg_var *cv)
+xml_cv_set(cxobj  *x,
+           cg_var *cv)
+{
+    if (!is_element(x))
+        return 0;
+    if (x->x_cv)
+        cv_free(x->x_cv);
+    x->x_cv = cv;
+#ifdef XML_NUM_CACHE
+    x->x_alloc &= ~(XML_ALLOC_NUM|XML_ALLOC_NUMNEG);
+#endif
+    return 0;
+}
+
+#ifdef XML_NUM_CACHE
+/*! Get cached integer value of XML leaf or leaf-list node
+ *
+ * @param[in]  x    XML node
+ * @param[out] neg  1 if negative, ie val is an int64, otherwise val is an uint64
+ * @param[out] val  Integer value
+ * @retval     1    Cache is set
+ * @retval     0    Cache is not set
+ * @see xml_num_set
+ */
+int
+xml_num_get(cxobj    *x,
+            int      *neg,
+            uint64_t *val)
+{
+    if (!is_element(x) || (x->x_alloc & XML_ALLOC_NUM) == 0)
+        return 0;
+    *neg = (x->x_alloc & XML_ALLOC_NUMNEG) != 0;
+    *val = x->x_num;
+    return 1;
+}
+
+/*! Set cached integer value of XML leaf or leaf-list node
+ *
+ * The cache is reset when the value of the node is changed, or when xml_cv_set is called
+ * @param[in]  x    XML node
+ * @param[in]  neg  1 if negative, ie val is an int64, otherwise val is an uint64
+ * @param[in]  val  Integer value
+ * @retval     0    OK
+ */
+int
+xml_num_set(cxobj   *x,
+            int      neg,
+            uint64_t val)
+{
+    if (!is_element(x))
+        return 0;
+    x->x_num = val;
+    x->x_alloc |= XML_ALLOC_NUM;
+    if (neg)
+        x->x_alloc |= XML_ALLOC_NUMNEG;
+    else
+        x->x_alloc &= ~XML_ALLOC_NUMNEG;
+    return 0;
+}
+#endif /* XML_NUM_CACHE */
+
+/*! Return cached matching union member type of the value of xml node
+ *
+ * @param[in]  x      XML node (leaf/leaf-list of union type)
+ * @retval     ytype  Member type statement that the value was validated with
+ * @retval     NULL   Not cached
+ * Set by validation and reset when the body, children or yang spec of x changes
+ * @see xml_yang_validate_add
+ */
+yang_stmt *
+xml_union_type(cxobj *x)
+{
+    if (!is_element(x))
+        return NULL;
+    return x->x_union_type;
+}
+
+/*! Set cached matching union member type of the value of xml node
+ *
+ * @param[in]  x      XML node (leaf/leaf-list of union type)
+ * @param[in]  ytype  Member type statement that the value was validated with
+ * @retval     0      OK
+ */
+int
+xml_union_type_set(cxobj     *x,
+                   yang_stmt *ytype)
 {
     if (!is_element(x))
         return 0;
-    if (x->x_cv)
-        cv_free(x->x_cv);
-    x->x_cv = cv;
+    x->x_union_type = ytype;
     return 0;
 }
 
+#ifdef XML_NAME_INTERN
+/*! Find first child with name using interned name comparison
+ *
+ * Children with interned names match only if pointers are equal, so no strcmp is made.
+ * If the name is not interned, no child with interned name can match.
+ * @param[in]  xp     XML parent
+ * @param[in]  iname  Interned name as returned by xml_intern_find, or NULL
+ * @param[in]  name   Name, used for children without interned names
+ * @param[in]  type   Matching type or -1 for any
+ * @retval     x      Found child
+ * @retval     NULL   Not found
+ */
+static cxobj *
+xml_find_interned(cxobj          *xp,
+                  const char     *iname,
+                  const char     *name,
+                  enum cxobj_type type)
+{
+    cxobj *x;
+    int    i;
+
+    for (i=0; i<xp->x_childvec_len; i++){
+        if ((x = xp->x_childvec[xml_childvec_pos(xp, i)]) == NULL)
+            continue;
+        if (type != CX_ERROR && xml_type(x) != type)
+            continue;
+        if (x->x_alloc & XML_ALLOC_NAME_INTERN){
+            if (x->x_name != iname)
+                continue;
+        }
+        else if (strcmp(name, x->x_name) != 0)
+            continue;
+        x->_x_vector_i = i; /* As xml_child_each, if caller continues iterating */
+        return x;
+    }
+    return NULL;
+}
+#endif
+
 /*! Find an XML node matching name among a parent's children.
  *
  * Get first XML node directly under x_up in the xml hierarchy with
@@ -1308,6 +2819,7 @@ xml_cv_set(cxobj  *x,
  * @note (1) Ignores prefix which means namespaces are ignored
  * @note (2) Does not differentiate between element,attributes and body. You usually want elements.
  * @note (3) Linear scalability and relies on strcmp, does not use search/key indexes
+ *           (pointer comparison first for interned names, eg name taken from xml_name())
  * @note (4) Only returns first match, eg a list/leaf-list may have several children with same name
  * @see xml_find_type  A more generic function fixes (1) and (2) above
  */
@@ -1322,8 +2834,12 @@ xml_find(cxobj *xp,
     }
     if (!is_element(xp))
         return NULL;
+#ifdef XML_NAME_INTERN
+    if (xp->x_childvec_len >= XML_FIND_INTERN_MIN)
+        return xml_find_interned(xp, xml_intern_find(name), name, -1);
+#endif
     while ((x = xml_child_each(xp, x, -1)) != NULL)
-        if (strcmp(name, xml_name(x)) == 0)
+        if (name == xml_name(x) || strcmp(name, xml_name(x)) == 0)
             break; /* x is set */
     return x;
 }
@@ -1382,8 +2898,13 @@ xml_addsub(cxobj *xp,
         /* clear namespace context cache of child */
         nscache_clear(xc);
 #ifdef XML_EXPLICIT_INDEX
-    if (xml_search_index_p(xc))
-            xml_search_child_insert(xp, xc);
+        if (xml_search_index_p(xc)){
+            if (xml_search_child_insert(xp, xc) < 0)
+                goto done;
+        }
+        else if (xml_search_list_p(xc) &&
+                 xml_search_list_update(xc, 1) < 0)
+            goto done;
 #endif
     }
     retval = 0;
@@ -1504,18 +3025,38 @@ xml_child_rm(cxobj *xp,
         clixon_err(OE_XML, 0, "Child not found");
         goto done;
     }
-    xml_parent_set(xc, NULL);
-    xp->x_childvec[i] = NULL;
-    xp->x_childvec_len--;
-    if (i<xp->x_childvec_len)
-        memmove(&xp->x_childvec[i], &xp->x_childvec[i+1], (xp->x_childvec_len-i)*sizeof(cxobj*));
 #ifdef XML_EXPLICIT_INDEX
+    /* Remove from search vectors while child is still linked to its parent */
     if (xml_type(xc) == CX_ELMNT){
-        if (xml_search_index_p(xc))
-            xml_search_child_rm(xp, xc);
-
+        if (xml_search_index_p(xc)){
+            if (xml_search_child_rm(xp, xc) < 0)
+                goto done;
+        }
+        else if (xp->x_search_index && xml_search_list_p(xc) &&
+                 xml_search_list_update(xc, 0) < 0)
+            goto done;
     }
 #endif
+    xml_parent_set(xc, NULL);
+    if (i < xp->x_childvec_nattr)
+        xp->x_childvec_nattr--;
+    xp->x_union_type = NULL;
+#ifdef XML_HASH_CACHE
+    xml_hash_invalidate(xp);
+#endif
+    if (xp->x_childvec_len >= XML_CHILDVEC_GAP_MIN || xp->x_childvec_gap){
+        /* Removed child becomes first entry of the gap */
+        xml_childvec_gap_move(xp, i+1);
+        xp->x_childvec[i] = NULL;
+        xp->x_childvec_len--;
+        xp->x_childvec_gap = (i == xp->x_childvec_len) ? 0 : i + 1;
+    }
+    else {
+        xp->x_childvec[i] = NULL;
+        xp->x_childvec_len--;
+        if (i<xp->x_childvec_len)
+            memmove(&xp->x_childvec[i], &xp->x_childvec[i+1], (xp->x_childvec_len-i)*sizeof(cxobj*));
+    }
     retval = 0;
  done:
     return retval;
@@ -1747,11 +3288,13 @@ xml_enumerate_get(cxobj *x)
 char *
 xml_body(cxobj *xn)
 {
-    cxobj *xb = NULL;
+    xml_iter_t it;
+    cxobj     *xb;
 
     if (!is_element(xn))
         return NULL;
-    while ((xb = xml_child_each(xn, xb, CX_BODY)) != NULL)
+    xml_iter_init(&it, xn, CX_BODY);
+    if ((xb = xml_iter_next(&it)) != NULL)
         return xml_value(xb);
     return NULL;
 }
@@ -1766,13 +3309,12 @@ xml_body(cxobj *xn)
 cxobj *
 xml_body_get(cxobj *xt)
 {
-    cxobj *xb = NULL;
+    xml_iter_t it;
 
     if (!is_element(xt))
         return NULL;
-    while ((xb = xml_child_each(xt, xb, CX_BODY)) != NULL)
-        return xb;
-    return NULL;
+    xml_iter_init(&it, xt, CX_BODY);
+    return xml_iter_next(&it);
 }
 
 /*! Find and return the value of an xml child of specific type given prefix and name
@@ -1826,20 +3368,27 @@ xml_find_type(cxobj          *xt,
               const char     *name,
               enum cxobj_type type)
 {
-    cxobj *x = NULL;
-    int    pmatch;  /* prefix match */
-    char  *xprefix; /* xprefix */
+    xml_iter_t it;
+    cxobj     *x;
+    int        pmatch;  /* prefix match */
+    char      *xprefix; /* xprefix */
 
     if (!is_element(xt))
         return NULL;
-    while ((x = xml_child_each(xt, x, type)) != NULL) {
+#ifdef XML_NAME_INTERN
+    if (prefix == NULL && name != NULL &&
+        xt->x_childvec_len >= XML_FIND_INTERN_MIN)
+        return xml_find_interned(xt, xml_intern_find(name), name, type);
+#endif
+    xml_iter_init(&it, xt, type);
+    while ((x = xml_iter_next(&it)) != NULL) {
         if (prefix){
             xprefix = xml_prefix(x);
             pmatch = xprefix ? strcmp(prefix,xprefix)==0 : 0;
         }
         else
             pmatch = 1;
-        if (pmatch && (name==NULL || strcmp(name, xml_name(x)) == 0))
+        if (pmatch && (name==NULL || name == xml_name(x) || strcmp(name, xml_name(x)) == 0))
             return x;
     }
     return NULL;
@@ -1864,11 +3413,13 @@ char *
 xml_find_value(cxobj      *xt,
                const char *name)
 {
-    cxobj *x = NULL;
+    xml_iter_t it;
+    cxobj     *x;
 
     if (!is_element(xt))
         return NULL;
-    while ((x = xml_child_each(xt, x, -1)) != NULL)
+    xml_iter_init(&it, xt, CX_ERROR);
+    while ((x = xml_iter_next(&it)) != NULL)
         if (strcmp(name, xml_name(x)) == 0)
             return xml_value(x);
     return NULL;
@@ -1890,11 +3441,13 @@ char *
 xml_find_body(cxobj      *xt,
               const char *name)
 {
-    cxobj *x=NULL;
+    xml_iter_t it;
+    cxobj     *x;
 
     if (!is_element(xt))
         return NULL;
-    while ((x = xml_child_each(xt, x, -1)) != NULL)
+    xml_iter_init(&it, xt, CX_ERROR);
+    while ((x = xml_iter_next(&it)) != NULL)
         if (strcmp(name, xml_name(x)) == 0)
             return xml_body(x);
     return NULL;
@@ -1919,12 +3472,14 @@ xml_find_body_obj(cxobj      *xt,
                   const char *name,
                   char       *val)
 {
-    cxobj *x = NULL;
-    char  *bstr;
+    xml_iter_t it;
+    cxobj     *x;
+    char      *bstr;
 
     if (!is_element(xt))
         return NULL;
-    while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL) {
+    xml_iter_init(&it, xt, CX_ELMNT);
+    while ((x = xml_iter_next(&it)) != NULL) {
         if (strcmp(name, xml_name(x)))
             continue;
         if ((bstr = xml_body(x)) == NULL)
@@ -1935,10 +3490,28 @@ xml_find_body_obj(cxobj      *xt,
     return x;
 }
 
+/*! Credit memory of a single XML node to its memory tag, before it is freed
+ *
+ * The same parts are charged in xml_new, xml_child_append, xml_value_set, etc
+ * @param[in]  x  XML node
+ */
+static void
+xml_mem_credit(cxobj *x)
+{
+    int64_t sz;
+
+    if (is_element(x))
+        sz = sizeof(struct xml) + xml_childvec_heap(x)*sizeof(cxobj*);
+    else
+        sz = sizeof(struct xmlbody) + xml_xb(x)->xb_value_max;
+    clixon_mem_charge(xml_mem_tag(x), -sz);
+}
+
 /*! Free an xl sub-tree recursively, but do not remove it from parent
  *
  * @param[in]  x  the xml tree to be freed.
  * @see xml_purge where x is also removed from parent
+ * @note Arena chunks are freed when all their nodes are freed, see xml_arena_free
  */
 int
 xml_free(cxobj *x)
@@ -1949,19 +3522,24 @@ xml_free(cxobj *x)
     if (x == NULL){
         return 0;
     }
+    /* Shared frozen tree: release one reference */
+    if (is_element(x) && x->x_refcnt > 1){
+        x->x_refcnt--;
+        return 0;
+    }
+    if (xml_mem_tag(x) != CLIXON_MEM_TAG_NONE)
+        xml_mem_credit(x);
     if (x->x_name)
-        free(x->x_name);
+        xml_str_free(x->x_name, &x->x_alloc, XML_ALLOC_NAME, XML_ALLOC_NAME_INTERN);
     if (x->x_prefix)
-        free(x->x_prefix);
+        xml_str_free(x->x_prefix, &x->x_alloc, XML_ALLOC_PREFIX, XML_ALLOC_PREFIX_INTERN);
     switch (xml_type(x)){
     case CX_ELMNT:
         for (i=0; i<x->x_childvec_len; i++){
-            if ((xc = x->x_childvec[i]) != NULL){
+            if ((xc = x->x_childvec[xml_childvec_pos(x, i)]) != NULL)
                 xml_free(xc);
-                x->x_childvec[i] = NULL;
-            }
         }
-        if (x->x_childvec)
+        if (xml_childvec_heap(x))
             free(x->x_childvec);
         if (x->x_cv)
             cv_free(x->x_cv);
@@ -1969,17 +3547,24 @@ xml_free(cxobj *x)
             xml_nsctx_free(x->x_ns_cache);
 #ifdef XML_EXPLICIT_INDEX
         xml_search_index_free(x);
+#endif
+#ifdef XML_PATH_CACHE
+        if (x->x_path)
+            free(x->x_path);
 #endif
         break;
     case CX_BODY:
     case CX_ATTR:
-        if (x->x_value_cb)
-            cbuf_free(x->x_value_cb);
+        if (xml_xb(x)->xb_value_max)
+            free(xml_xb(x)->xb_value);
         break;
     default:
         break;
     }
-    free(x);
+    if (x->x_alloc & XML_ALLOC_NODE)
+        xml_arena_free(x);
+    else
+        free(x);
     _stats_xml_nr--;
     return 0;
 }
@@ -2012,6 +3597,7 @@ xml_copy_one(cxobj *x0,
     switch (xml_type(x0)){
     case CX_ELMNT:
         xml_spec_set(x1, xml_spec(x0));
+        xml_flag_set(x1, xml_flag(x0, XML_FLAG_OPAQUE));
         break;
     case CX_BODY:
     case CX_ATTR:
@@ -2024,7 +3610,7 @@ xml_copy_one(cxobj *x0,
     default:
         break;
     }
-    xml_flag_set(x1, xml_flag(x0, XML_FLAG_DEFAULT | XML_FLAG_TOP | XML_FLAG_ANYDATA | XML_FLAG_CACHE_DIRTY)); /* Maybe more flags */
+    xml_flag_set(x1, xml_flag(x0, XML_FLAG_DEFAULT | XML_FLAG_TOP | XML_FLAG_ANYDATA | XML_FLAG_CACHE_DIRTY | XML_FLAG_EDITED)); /* Maybe more flags */
     retval = 0;
  done:
     return retval;
@@ -2049,19 +3635,28 @@ int
 xml_copy(cxobj *x0,
          cxobj *x1)
 {
-    int    retval = -1;
-    cxobj *x;
-    cxobj *xcopy;
+    int        retval = -1;
+    xml_iter_t it;
+    cxobj     *x;
+    cxobj     *xcopy;
 
     if (xml_copy_one(x0, x1) <0)
         goto done;
-    x = NULL;
-    while ((x = xml_child_each(x0, x, -1)) != NULL) {
+    xml_iter_init(&it, x0, CX_ERROR);
+    while ((x = xml_iter_next(&it)) != NULL) {
         if ((xcopy = xml_new(xml_name(x), x1, xml_type(x))) == NULL)
             goto done;
         if (xml_copy(x, xcopy) < 0) /* recursion */
             goto done;
     }
+    /* Same value and spec: keep validated union member type */
+    if (is_element(x0) && is_element(x1) && x1->x_spec == x0->x_spec)
+        x1->x_union_type = x0->x_union_type;
+#ifdef XML_HASH_CACHE
+    /* Same subtree: keep hash, all descendants have been copied with theirs */
+    if (is_element(x0) && is_element(x1))
+        x1->x_hash = x0->x_hash;
+#endif
     retval = 0;
   done:
     return retval;
@@ -2077,6 +3672,7 @@ xml_copy(cxobj *x0,
  *   if ((x1 = xml_dup(x0)) == NULL)
  *      err;
  * @endcode
+ * @note Allocated from XML arena if enabled
  * @see xml_cp
  */
 cxobj *
@@ -2084,13 +3680,184 @@ xml_dup(cxobj *x0)
 {
     cxobj *x1;
 
+    xml_arena_push();
     if ((x1 = xml_new("new", NULL, xml_type(x0))) == NULL)
-        return NULL;
-    if (xml_copy(x0, x1) < 0)
-        return NULL;
+        goto done;
+    if (xml_copy(x0, x1) < 0){
+        xml_free(x1);
+        x1 = NULL;
+        goto done;
+    }
+ done:
+    xml_arena_pop();
     return x1;
 }
 
+/*! Freeze an XML tree so that it can be shared instead of copied
+ *
+ * A frozen tree is reference counted. Each xml_share adds a reference and each xml_free
+ * releases one. The tree is freed when the last reference is released.
+ * Only whole trees can be frozen, since a node has one parent.
+ * @param[in]  xt   XML tree root, ie without parent
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see xml_share   Share a frozen tree
+ * @see xml_mutable Make private copy before modification
+ */
+int
+xml_freeze(cxobj *xt)
+{
+    if (xt == NULL || !is_element(xt) || xml_parent(xt) != NULL){
+        clixon_err(OE_XML, EINVAL, "Only XML tree roots can be frozen");
+        return -1;
+    }
+    if (xt->x_refcnt == 0)
+        xt->x_refcnt = 1;
+    return 0;
+}
+
+/*! Share a frozen XML tree instead of copying it
+ *
+ * The returned tree is the same as xt and must not be modified unless xml_mutable is called
+ * first. Release with xml_free.
+ * @param[in]  xt   Frozen XML tree root, see xml_freeze
+ * @retval     xt   Shared tree
+ * @retval     NULL Error
+ * @code
+ *   if (xml_freeze(x0) < 0)
+ *      err;
+ *   if ((x1 = xml_share(x0)) == NULL)
+ *      err;
+ *   ...
+ *   if (xml_mutable(&x1) < 0) // x1 is now a private copy if x0 is still referenced
+ *      err;
+ * @endcode
+ */
+cxobj *
+xml_share(cxobj *xt)
+{
+    if (xt == NULL || !is_element(xt) || xt->x_refcnt == 0){
+        clixon_err(OE_XML, EINVAL, "XML tree is not frozen");
+        return NULL;
+    }
+    xt->x_refcnt++;
+    return xt;
+}
+
+/*! Check if XML tree root is shared, ie has more than one reference
+ *
+ * @param[in]  xt   XML tree root
+ * @retval     1    Shared, see xml_share
+ * @retval     0    Not shared
+ */
+int
+xml_shared(cxobj *xt)
+{
+    return xt != NULL && is_element(xt) && xt->x_refcnt > 1;
+}
+
+/*! Make XML tree modifiable before changing it in place
+ *
+ * If the tree is shared, the reference is released and replaced by a private copy.
+ * If this is the last reference, the tree is unfrozen and modified in place.
+ * No-op if the tree is not frozen.
+ * @param[in,out] xtp  XML tree root, replaced by a copy if shared
+ * @retval        0    OK
+ * @retval       -1    Error
+ * @see xml_freeze
+ */
+int
+xml_mutable(cxobj **xtp)
+{
+    cxobj *xt;
+    cxobj *x1;
+
+    if ((xt = *xtp) == NULL || !is_element(xt) || xt->x_refcnt == 0)
+        return 0;
+    if (xt->x_refcnt == 1){
+        xt->x_refcnt = 0;
+        return 0;
+    }
+    if ((x1 = xml_dup(xt)) == NULL)
+        return -1;
+    xt->x_refcnt--;
+    *xtp = x1;
+    return 0;
+}
+
+/*! Mix a string into a 64-bit hash, FNV-1a
+ */
+static uint64_t
+xml_hash_str(uint64_t    h,
+             const char *str)
+{
+    const unsigned char *p;
+
+    if (str == NULL)
+        return (h ^ 0xff) * 0x100000001b3ULL; /* Differs from empty string */
+    for (p = (const unsigned char *)str; *p; p++)
+        h = (h ^ *p) * 0x100000001b3ULL;
+    return h * 0x100000001b3ULL; /* Terminator */
+}
+
+/*! Mix a 64-bit value into a 64-bit hash
+ */
+static uint64_t
+xml_hash_mix(uint64_t h,
+             uint64_t v)
+{
+    h ^= v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    return h;
+}
+
+/*! Get structural hash of an XML subtree
+ *
+ * The hash covers type, name, prefix and value of all nodes, and the order of children,
+ * but not YANG binding or flags. Equal trees have equal hashes, and different trees have
+ * different hashes with high probability.
+ * Element hashes are cached and computed bottom-up, so that after a change only the
+ * changed node and its ancestors are computed again, see XML_HASH_CACHE.
+ * @param[in]  x    XML node
+ * @retval     h    Hash, never 0
+ * @code
+ *   if (xml_tree_hash(x0) == xml_tree_hash(x1))
+ *      ; // Most probably equal
+ * @endcode
+ */
+uint64_t
+xml_tree_hash(cxobj *x)
+{
+    uint64_t h = 0xcbf29ce484222325ULL;
+    int      i;
+    cxobj   *xc;
+
+#ifdef XML_HASH_CACHE
+    if (is_element(x) && x->x_hash != 0)
+        return x->x_hash;
+#endif
+    h = xml_hash_mix(h, xml_type(x));
+    h = xml_hash_str(h, xml_name(x));
+    h = xml_hash_str(h, xml_prefix(x));
+    if (is_element(x)){
+        for (i=0; i<x->x_childvec_len; i++)
+            if ((xc = x->x_childvec[xml_childvec_pos(x, i)]) != NULL)
+                h = xml_hash_mix(h, xml_tree_hash(xc));
+    }
+    else
+        h = xml_hash_str(h, xml_value(x));
+    /* Finalize, see splitmix64 */
+    h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+    if (h == 0)
+        h = 1;
+#ifdef XML_HASH_CACHE
+    if (is_element(x))
+        x->x_hash = h;
+#endif
+    return h;
+}
+
 #if 1 /* XXX At some point migrate this code to the clixon_xml_vec.[ch] API */
 /*! Append a new xml tree to an existing xml vector last in the list
  *
@@ -2308,6 +4075,73 @@ xml_apply_ancestor(cxobj        *xn,
     return retval;
 }
 
+/*! Register function that loads children of nodes marked with XML_FLAG_LAZY
+ *
+ * @param[in]  fn   Loader callback, or NULL to unregister
+ * @param[in]  arg  Argument given to fn
+ * @retval     0    OK
+ * @see xml_lazy_load
+ */
+int
+xml_lazy_register(xml_lazyfn_t *fn,
+                  void         *arg)
+{
+    _xml_lazy_fn = fn;
+    _xml_lazy_arg = arg;
+    return 0;
+}
+
+/*! Ensure children of XML node are loaded before they are accessed
+ *
+ * Called where a tree is traversed downwards, eg xpath steps and datastore edits.
+ * Also marks lazily loaded nodes as referenced for eviction policies, and parses
+ * raw anydata content, see xml_opaque_expand
+ * @param[in]  x   XML node
+ * @retval     0   OK
+ * @retval    -1   Error
+ * @see xml_lazy_register
+ */
+int
+xml_lazy_load(cxobj *x)
+{
+    if ((x->x_flags & XML_FLAG_OPAQUE) && xml_opaque_expand(x) < 0)
+        return -1;
+    if (x->x_flags & XML_FLAG_LAZY_LOADED)
+        x->x_flags |= XML_FLAG_LAZY_REF;
+    if ((x->x_flags & XML_FLAG_LAZY) == 0 || _xml_lazy_fn == NULL)
+        return 0;
+    return _xml_lazy_fn(x, _xml_lazy_arg);
+}
+
+/*! Apply callback for xml_lazy_load_recurse */
+static int
+xml_lazy_load_applyfn(cxobj *x,
+                      void  *arg)
+{
+    if (x->x_flags & XML_FLAG_LAZY_LOADED)
+        x->x_flags |= XML_FLAG_LAZY_REF;
+    if ((x->x_flags & XML_FLAG_LAZY) == 0)
+        return 0;
+    return _xml_lazy_fn(x, _xml_lazy_arg);
+}
+
+/*! Ensure all nodes in XML tree are loaded
+ *
+ * Raw anydata content is not parsed
+ * @param[in]  x   XML node
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+int
+xml_lazy_load_recurse(cxobj *x)
+{
+    if (_xml_lazy_fn == NULL)
+        return 0;
+    if (xml_apply0(x, CX_ELMNT, xml_lazy_load_applyfn, NULL) < 0)
+        return -1;
+    return 0;
+}
+
 /*! Is xpp ancestor of x?
  *
  * @param[in]   x       XML node
@@ -2631,8 +4465,60 @@ xml_search_vector_get(cxobj        *xp,
     return 0;
 }
 
+/*! Find exact position of list element in a search vector
+ *
+ * The binary search only finds some element with an equal index value. Since secondary
+ * indexes are typically not unique (eg oper-status), scan the equal range for xp itself. 
+ * @param[in]  xp      XML list element
+ * @param[in]  indexvar Name of index variable
+ * @param[in]  xvec    Search vector
+ * @param[out] ip      Position of xp if found, otherwise insertion position
+ * @retval     1       Found, xp is at *ip
+ * @retval     0       Not found
+ * @retval    -1       Error
+ */
+static int
+xml_search_vector_pos(cxobj       *xp,
+                      char        *indexvar,
+                      clixon_xvec *xvec,
+                      int         *ip)
+{
+    int    len;
+    int    i;
+    int    j;
+    int    eq = 0;
+    cxobj *xc;
+
+    len = clixon_xvec_len(xvec);
+    if ((i = xml_search_indexvar_binary_pos(xp, indexvar, xvec, 0, len, len, &eq)) < 0)
+        return -1;
+    *ip = i;
+    if (!eq)
+        return 0;
+    for (j=i; j>=0; j--){
+        xc = clixon_xvec_i(xvec, j);
+        if (xc == xp){
+            *ip = j;
+            return 1;
+        }
+        if (xml_cmp(xp, xc, 0, 0, indexvar) != 0)
+            break;
+    }
+    for (j=i+1; j<len; j++){
+        xc = clixon_xvec_i(xvec, j);
+        if (xc == xp){
+            *ip = j;
+            return 1;
+        }
+        if (xml_cmp(xp, xc, 0, 0, indexvar) != 0)
+            break;
+    }
+    return 0;
+}
+
 /*! Insert a new cxobj into search index vector for list for variable "name"
  *
+ * If the list element already is in the vector, nothing is done
  * @param[in] xp  XML parent object (the list element)
  * @param[in] xi  XML index object (that should be added)
  * @retval    0   OK
@@ -2647,7 +4533,7 @@ xml_search_child_insert(cxobj *xp,
     struct search_index *si;
     cxobj               *xpp;
     int                  i;
-    int                  len;
+    int                  ret;
 
     indexvar = xml_name(xi);
     if ((xpp = xml_parent(xp)) == NULL)
@@ -2658,11 +4544,11 @@ xml_search_child_insert(cxobj *xp,
         if ((si = xml_search_index_add(xpp, indexvar)) == NULL)
             goto done;
     }
-    /* Find element position using binary search and then remove */
-    len = clixon_xvec_len(si->si_xvec);
-    if ((i = xml_search_indexvar_binary_pos(xp, indexvar, si->si_xvec, 0, len, len, NULL)) < 0)
+    /* Find element position using binary search and then insert */
+    if ((ret = xml_search_vector_pos(xp, indexvar, si->si_xvec, &i)) < 0)
         goto done;
-    assert(clixon_xvec_i(si->si_xvec, i) != xp);
+    if (ret == 1) /* Already indexed */
+        goto ok;
     if (clixon_xvec_insert_pos(si->si_xvec, xp, i) < 0)
         goto done;
  ok:
@@ -2674,7 +4560,7 @@ xml_search_child_insert(cxobj *xp,
 /*! Remove a single cxobj from search vector 
  *
  * @param[in] xp    XML parent object (the list element)
- * @param[in] xi    XML index object (that should be added)
+ * @param[in] xi    XML index object (that should be removed)
  * @retval    0     OK
  * @retval   -1     Error
  */
@@ -2682,13 +4568,12 @@ int
 xml_search_child_rm(cxobj *xp,
                     cxobj *xi)
 {
-    int                 retval = -1;
-    cxobj              *xpp;
-    char               *indexvar;
-    int                 i;
-    int                 len;
+    int                  retval = -1;
+    cxobj               *xpp;
+    char                *indexvar;
+    int                  i;
+    int                  ret;
     struct search_index *si;
-    int                  eq = 0;
 
     indexvar = xml_name(xi);
     if ((xpp = xml_parent(xp)) == NULL)
@@ -2696,13 +4581,10 @@ xml_search_child_rm(cxobj *xp,
     /* Find base vector in grandparent */
     if ((si = xml_search_index_get(xpp, indexvar)) == NULL)
         goto ok;
-
     /* Find element using binary search and then remove */
-    len = clixon_xvec_len(si->si_xvec);
-    if ((i = xml_search_indexvar_binary_pos(xp, indexvar, si->si_xvec, 0, len, len, &eq)) < 0)
+    if ((ret = xml_search_vector_pos(xp, indexvar, si->si_xvec, &i)) < 0)
         goto done;
-        //    if (clixon_xvec_i(si->si_xvec, i) == xp)
-    if (eq)
+    if (ret == 1)
         if (clixon_xvec_rm_pos(si->si_xvec, i) < 0)
             goto done;
  ok:
@@ -2711,6 +4593,103 @@ xml_search_child_rm(cxobj *xp,
     return retval;
 }
 
+/*! Insert or remove all search indexes of a list element in its parent's search vectors
+ *
+ * Used when a whole list element is added or removed, eg a subtree copied by the
+ * state-data merge, or purged by text_modify.
+ * @param[in] xp    XML list element
+ * @param[in] add   1: insert, 0: remove
+ * @retval    0     OK
+ * @retval   -1     Error
+ */
+static int
+xml_search_list_update(cxobj *xp,
+                       int    add)
+{
+    cxobj     *xi;
+    yang_stmt *yi;
+
+    xi = NULL;
+    while ((xi = xml_child_each(xp, xi, CX_ELMNT)) != NULL){
+        if ((yi = xml_spec(xi)) == NULL ||
+            yang_flag_get(yi, YANG_FLAG_INDEX) == 0)
+            continue;
+        if (add){
+            if (xml_search_child_insert(xp, xi) < 0)
+                return -1;
+        }
+        else if (xml_search_child_rm(xp, xi) < 0)
+            return -1;
+    }
+    return 0;
+}
+
+/*! Is this XML object a list element that may have search indexes in its parent
+ *
+ * @param[in] x  XML object
+ * @retval    1  Yes
+ * @retval    0  No
+ */
+static int
+xml_search_list_p(cxobj *x)
+{
+    yang_stmt *y;
+
+    if ((y = xml_spec(x)) == NULL)
+        return 0;
+    if (yang_keyword_get(y) != Y_LIST)
+        return 0;
+    if (xml_parent(x) == NULL)
+        return 0;
+    return 1;
+}
+
+/*! Update search vectors of a search index leaf whose value is about to change
+ *
+ * Call with add=0 before the value is changed, and with add=1 after.
+ * The cached cligen value, which the search vector is sorted on, is reset.
+ * @param[in] xi    XML index leaf
+ * @param[in] add   1: insert, 0: remove
+ * @retval    0     OK
+ * @retval   -1     Error
+ * @see xml_value_set
+ */
+static int
+xml_search_value_update(cxobj *xi,
+                        int    add)
+{
+    if (add){
+        xml_cv_set(xi, NULL);
+        return xml_search_child_insert(xml_parent(xi), xi);
+    }
+    return xml_search_child_rm(xml_parent(xi), xi);
+}
+
+/*! Build search vectors of an existing XML tree recursively
+ *
+ * Search indexes are maintained incrementally when the XML tree is modified. Use this
+ * function if a search index is declared after the tree was created.
+ * @param[in] xt    XML tree
+ * @retval    0     OK
+ * @retval   -1     Error
+ * @see yang_search_index_add
+ */
+int
+xml_search_index_rebuild(cxobj *xt)
+{
+    cxobj *x;
+
+    x = NULL;
+    while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL){
+        if (xml_search_index_p(x) &&
+            xml_search_child_insert(xt, x) < 0)
+            return -1;
+        if (xml_search_index_rebuild(x) < 0)
+            return -1;
+    }
+    return 0;
+}
+
 /*! Iterator over xml children objects using (explicit) index variable
  *
  * @param[in] xparent xml tree node whose children should be iterated
@@ -0,0 +1,825 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, indicate
+  your decision by deleting the provisions above and replace them with the 
+  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Binary serialization of bound XML trees, used as datastore snapshot format
+ * and as reply format on the internal backend socket
+ *
+ * A snapshot is a header followed by the tree in pre-order. All integers are
+ * unsigned LEB128 varints, strings are a varint length (including the terminating
+ * null character, 0 means NULL) followed by the string:
+ *   header:  "CLXB" <version:u8> <fingerprint:varint>
+ *   element: CX_ELMNT <flags:u8> <yanglen> <yangidx>* <name> <prefix> <nr> <child>*
+ *   attr:    CX_ATTR <name> <prefix> <value>
+ *   body:    CX_BODY <name> <prefix> <value>
+ * The yang spec of an element is encoded as the child-index path from the yang
+ * spec of the parent element (or the top-level yang spec) to the yang spec of the
+ * element. yanglen is 0 if the element has no yang spec, 1 if it cannot be
+ * encoded (eg mount-points) and otherwise the number of indices plus two.
+ * The fingerprint is a hash of the yang spec, yang indices are only used if the
+ * fingerprint of the loading yang spec is equal.
+ * Children are written in their (sorted) cache order, so a tree that is bound on
+ * load is also sorted.
+ * XML_FLAG_OPAQUE, ie raw anydata content, is saved as bit 0x80 of the element flags.
+ * A message on the internal socket has the same format, but is escaped so that it
+ * contains no null characters: 0x00 and 0x01 are written as 0x01 followed by '0' and
+ * '1' respectively. In a message, elements below the envelope (eg rpc-reply/data)
+ * without yang spec, except in anydata, are marked as not encodable (yanglen 1) so
+ * that the receiver knows if the whole tree is bound.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stdint.h>
+#include <dirent.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_queue.h"
+#include "clixon_string.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_err.h"
+#include "clixon_log.h"
+#include "clixon_debug.h"
+#include "clixon_file.h"
+#include "clixon_netconf_lib.h"
+#include "clixon_xml_io.h"
+#include "clixon_xml_binary.h"
+
+/* Magic cookie and version of binary file format */
+#define XML_BINARY_MAGIC   "CLXB"
+#define XML_BINARY_VERSION 1
+
+/* Max length of yang child-index path of one element */
+#define XML_BINARY_YANGPATH_MAX 32
+
+/* Flags that are saved in binary format */
+#define XML_BINARY_FLAGS   XML_FLAG_DEFAULT
+
+/* Flag bit of XML_FLAG_OPAQUE in binary format, the element flags are one byte */
+#define XML_BINARY_OPAQUE  0x80
+
+/* Escape character of binary messages */
+#define XML_BINARY_ESC     0x01
+
+/* Binary write state, either to file or to escaped message buffer */
+struct xml_binary_out {
+    FILE             *xbo_f;     /* Output file, or NULL */
+    cbuf             *xbo_cb;    /* Output message buffer, or NULL */
+    int               xbo_env;   /* Levels of message envelope that may be unbound */
+    withdefaults_type xbo_wdef;  /* With-defaults of message */
+};
+typedef struct xml_binary_out xml_binary_out;
+
+/* Binary read state */
+struct xml_binary_buf {
+    const uint8_t *xbb_p;   /* Current read position */
+    const uint8_t *xbb_end; /* End of buffer */
+};
+typedef struct xml_binary_buf xml_binary_buf;
+
+/* Fingerprint cache, only recomputed if yang spec or YANG generation changes
+ * @see yang_stats_generation
+ */
+static yang_stmt *_fingerprint_yspec = NULL;
+static uint64_t   _fingerprint_gen = 0;
+static uint64_t   _fingerprint = 0;
+
+/*! Recursive FNV-1a hash of yang statements, keywords and arguments
+ */
+static uint64_t
+xml_binary_fingerprint1(yang_stmt *ys,
+                        uint64_t   h)
+{
+    char *arg;
+    int   i;
+
+    h = (h ^ (uint64_t)yang_keyword_get(ys)) * 0x100000001b3ULL;
+    if ((arg = yang_argument_get(ys)) != NULL)
+        while (*arg)
+            h = (h ^ (uint8_t)*arg++) * 0x100000001b3ULL;
+    h = (h ^ (uint64_t)yang_len_get(ys)) * 0x100000001b3ULL;
+    for (i = 0; i < yang_len_get(ys); i++)
+        h = xml_binary_fingerprint1(yang_child_i(ys, i), h);
+    return h;
+}
+
+/*! Compute fingerprint of yang spec, which identifies the child indices
+ *
+ * The fingerprint is cached, and recomputed when any YANG statement has been created or
+ * freed since, eg if modules are added or a yang spec is freed and another allocated at
+ * the same address
+ * @param[in]  yspec  Top-level yang spec
+ * @retval     fp     Fingerprint, 0 if yspec is NULL
+ */
+static uint64_t
+xml_binary_fingerprint(yang_stmt *yspec)
+{
+    uint64_t gen;
+
+    if (yspec == NULL)
+        return 0;
+    gen = yang_stats_generation();
+    if (yspec != _fingerprint_yspec || gen != _fingerprint_gen){
+        _fingerprint = xml_binary_fingerprint1(yspec, 0xcbf29ce484222325ULL);
+        _fingerprint_yspec = yspec;
+        _fingerprint_gen = gen;
+    }
+    return _fingerprint;
+}
+
+static int
+xml_binary_write_u8(xml_binary_out *xbo,
+                    uint8_t         b)
+{
+    if (xbo->xbo_f)
+        return putc(b, xbo->xbo_f) == EOF ? -1 : 0;
+    if (b == 0 || b == XML_BINARY_ESC){
+        if (cbuf_append(xbo->xbo_cb, XML_BINARY_ESC) < 0)
+            return -1;
+        b += '0';
+    }
+    return cbuf_append(xbo->xbo_cb, b);
+}
+
+static int
+xml_binary_write_uint(xml_binary_out *xbo,
+                      uint64_t        v)
+{
+    uint8_t b;
+
+    do {
+        b = v & 0x7f;
+        v >>= 7;
+        if (v)
+            b |= 0x80;
+        if (xml_binary_write_u8(xbo, b) < 0)
+            return -1;
+    } while (v);
+    return 0;
+}
+
+static int
+xml_binary_write_str(xml_binary_out *xbo,
+                     char           *str)
+{
+    size_t len;
+    char  *p;
+
+    if (str == NULL)
+        return xml_binary_write_uint(xbo, 0);
+    len = strlen(str) + 1;
+    if (xml_binary_write_uint(xbo, len) < 0)
+        return -1;
+    if (xbo->xbo_f)
+        return fwrite(str, 1, len, xbo->xbo_f) != len ? -1 : 0;
+    /* Append in bulk up to next escaped character */
+    while ((p = strchr(str, XML_BINARY_ESC)) != NULL){
+        if (cbuf_append_buf(xbo->xbo_cb, str, p - str) < 0 ||
+            xml_binary_write_u8(xbo, XML_BINARY_ESC) < 0)
+            return -1;
+        str = p + 1;
+    }
+    if (cbuf_append_buf(xbo->xbo_cb, str, strlen(str)) < 0)
+        return -1;
+    return xml_binary_write_u8(xbo, 0);
+}
+
+/*! Compute child-index path from anchor to yang node
+ *
+ * @param[in]  y       Yang spec of element
+ * @param[in]  anchor  Yang spec of parent element or top-level yang spec
+ * @param[out] path    Vector of child indices, from anchor and downwards
+ * @retval     n       Length of path
+ * @retval    -1       Path cannot be encoded
+ */
+static int
+xml_binary_yang_path(yang_stmt *y,
+                     yang_stmt *anchor,
+                     uint32_t  *path)
+{
+    uint32_t   rpath[XML_BINARY_YANGPATH_MAX];
+    yang_stmt *yp;
+    int        n = 0;
+    int        i;
+
+    while (y != anchor){
+        if ((yp = yang_parent_get(y)) == NULL || n == XML_BINARY_YANGPATH_MAX)
+            return -1;
+        for (i = 0; i < yang_len_get(yp); i++)
+            if (yang_child_i(yp, i) == y)
+                break;
+        if (i == yang_len_get(yp))
+            return -1;
+        rpath[n++] = i;
+        y = yp;
+    }
+    for (i = 0; i < n; i++)
+        path[i] = rpath[n-i-1];
+    return n;
+}
+
+/* Last computed yang path among siblings, list entries share the same yang spec */
+struct xml_binary_ypath {
+    yang_stmt *xby_y;                               /* Yang spec */
+    int        xby_len;                             /* Path length or -1 */
+    uint32_t   xby_path[XML_BINARY_YANGPATH_MAX];   /* Child indices */
+};
+typedef struct xml_binary_ypath xml_binary_ypath;
+
+/*! Check if message child should be written given with-defaults and depth
+ *
+ * @param[in]  xbo    Binary output
+ * @param[in]  xc     XML child
+ * @param[in]  depth  Depth of parent, -1 is unlimited
+ * @retval     1      Write child
+ * @retval     0      Skip child
+ * @retval    -1      Error
+ * @see xml2cbuf_recurse  for the corresponding XML output rules
+ */
+static int
+xml_binary_write_keep(xml_binary_out *xbo,
+                      cxobj          *xc,
+                      int32_t         depth)
+{
+    if (xml_type(xc) == CX_ATTR)
+        return 1;
+    if (depth == 1)
+        return 0;
+    if (xml_type(xc) != CX_ELMNT || xbo->xbo_f)
+        return 1;
+    return xml2output_wdef(xc, xbo->xbo_wdef, NULL);
+}
+
+/*! Write XML node and its children recursively in binary format
+ *
+ * @param[in]  xbo    Binary output
+ * @param[in]  x      XML node
+ * @param[in]  anchor Yang spec of parent, or top-level yang spec
+ * @param[in]  yspec  Top-level yang spec
+ * @param[in]  yp     Yang path of previous sibling (cache)
+ * @param[in]  level  Level of x, 0 is top
+ * @param[in]  depth  Max depth of message, -1 is unlimited
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+xml_binary_write_node(xml_binary_out   *xbo,
+                      cxobj            *x,
+                      yang_stmt        *anchor,
+                      yang_stmt        *yspec,
+                      xml_binary_ypath *yp,
+                      int               level,
+                      int32_t           depth)
+{
+    int              retval = -1;
+    enum cxobj_type  type;
+    yang_stmt       *y;
+    yang_stmt       *ya;
+    xml_binary_ypath ypc = {NULL, -1, {0,}};
+    int              i;
+    int              nr;
+    cxobj           *xc;
+    int              ret;
+
+    type = xml_type(x);
+    if (xml_binary_write_u8(xbo, type) < 0)
+        goto werr;
+    if (type == CX_ELMNT){
+        if (xml_binary_write_u8(xbo, xml_flag(x, XML_BINARY_FLAGS) |
+                                (xml_flag(x, XML_FLAG_OPAQUE)?XML_BINARY_OPAQUE:0)) < 0)
+            goto werr;
+        if ((y = xml_spec(x)) == NULL){
+            /* In a message, unbound elements outside envelope and anydata are marked */
+            if (xbo->xbo_cb && level >= xbo->xbo_env &&
+                !xml_flag(xml_parent(x), XML_FLAG_ANYDATA) &&
+                ((ya = xml_spec(xml_parent(x))) == NULL ||
+                 (yang_keyword_get(ya) != Y_ANYDATA && yang_keyword_get(ya) != Y_ANYXML))){
+                if (xml_binary_write_uint(xbo, 1) < 0)
+                    goto werr;
+            }
+            else if (xml_binary_write_uint(xbo, 0) < 0)
+                goto werr;
+        }
+        else{
+            if (y != yp->xby_y){
+                yp->xby_y = y;
+                yp->xby_len = xml_binary_yang_path(y, anchor, yp->xby_path);
+            }
+            if (yp->xby_len < 0){
+                if (xml_binary_write_uint(xbo, 1) < 0)
+                    goto werr;
+            }
+            else {
+                if (xml_binary_write_uint(xbo, yp->xby_len + 2) < 0)
+                    goto werr;
+                for (i = 0; i < yp->xby_len; i++)
+                    if (xml_binary_write_uint(xbo, yp->xby_path[i]) < 0)
+                        goto werr;
+            }
+        }
+    }
+    if (xml_binary_write_str(xbo, xml_name(x)) < 0)
+        goto werr;
+    if (xml_binary_write_str(xbo, xml_prefix(x)) < 0)
+        goto werr;
+    if (type != CX_ELMNT){
+        if (xml_binary_write_str(xbo, xml_value(x)) < 0)
+            goto werr;
+        goto ok;
+    }
+    /* Skipped children are marked in a first pass, since the number is written first */
+    nr = 0;
+    xc = NULL;
+    while ((xc = xml_child_each(x, xc, CX_ERROR)) != NULL){
+        if ((ret = xml_binary_write_keep(xbo, xc, depth)) < 0)
+            goto done;
+        if (ret == 0)
+            xml_flag_set(xc, XML_FLAG_TRANSIENT);
+        else
+            nr++;
+    }
+    if (xml_binary_write_uint(xbo, nr) < 0)
+        goto werr;
+    y = xml_spec(x);
+    xc = NULL;
+    while ((xc = xml_child_each(x, xc, CX_ERROR)) != NULL){
+        if (xml_flag(xc, XML_FLAG_TRANSIENT)){
+            xml_flag_reset(xc, XML_FLAG_TRANSIENT);
+            continue;
+        }
+        if (xml_binary_write_node(xbo, xc, y?y:yspec, yspec, &ypc, level+1,
+                                  depth>0?depth-1:depth) < 0)
+            goto done;
+    }
+ ok:
+    retval = 0;
+ done:
+    return retval;
+ werr:
+    clixon_err(OE_XML, errno, "write binary");
+    goto done;
+}
+
+/*! Write XML tree to file in binary format
+ *
+ * @param[in]  f      Output file
+ * @param[in]  xt     Top of XML tree, eg datastore cache
+ * @param[in]  yspec  Top-level yang spec, or NULL
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @note All nodes are written, also default values, ie as with-defaults report-all
+ * @see clixon_binary_parse_file
+ */
+int
+clixon_xml2binary_file(FILE      *f,
+                       cxobj     *xt,
+                       yang_stmt *yspec)
+{
+    int              retval = -1;
+    xml_binary_ypath yp = {NULL, -1, {0,}};
+    xml_binary_out   xbo = {f, NULL, 0, WITHDEFAULTS_REPORT_ALL};
+
+    if (xt == NULL){
+        clixon_err(OE_XML, EINVAL, "xt is NULL");
+        goto done;
+    }
+    if (fwrite(XML_BINARY_MAGIC, 1, strlen(XML_BINARY_MAGIC), f) != strlen(XML_BINARY_MAGIC) ||
+        putc(XML_BINARY_VERSION, f) == EOF ||
+        xml_binary_write_uint(&xbo, xml_binary_fingerprint(yspec)) < 0){
+        clixon_err(OE_XML, errno, "write binary");
+        goto done;
+    }
+    if (xml_binary_write_node(&xbo, xt, yspec, yspec, &yp, 0, -1) < 0)
+        goto done;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Append XML tree to buffer as binary message on the internal socket
+ *
+ * @param[in]  cb     Message buffer
+ * @param[in]  xt     XML tree, eg rpc-reply
+ * @param[in]  yspec  Top-level yang spec, or NULL
+ * @param[in]  env    Levels of envelope which may not have yang spec, eg 2 for rpc-reply/data
+ * @param[in]  depth  Max depth of tree, -1 is unlimited, as in clixon_xml2cbuf1
+ * @param[in]  wdef   With-defaults parameter, WITHDEFAULTS_REPORT_ALL_TAGGED not supported
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @note The message contains no null characters, and is not null-terminated
+ * @see clixon_binary_parse_string
+ */
+int
+clixon_xml2binary_cbuf(cbuf             *cb,
+                       cxobj            *xt,
+                       yang_stmt        *yspec,
+                       int               env,
+                       int32_t           depth,
+                       withdefaults_type wdef)
+{
+    int              retval = -1;
+    xml_binary_ypath yp = {NULL, -1, {0,}};
+    xml_binary_out   xbo = {NULL, cb, env, wdef};
+
+    if (xt == NULL){
+        clixon_err(OE_XML, EINVAL, "xt is NULL");
+        goto done;
+    }
+    if (wdef == WITHDEFAULTS_REPORT_ALL_TAGGED){
+        clixon_err(OE_XML, EINVAL, "with-defaults report-all-tagged not supported");
+        goto done;
+    }
+    if (cbuf_append_buf(cb, XML_BINARY_MAGIC, strlen(XML_BINARY_MAGIC)) < 0 ||
+        xml_binary_write_u8(&xbo, XML_BINARY_VERSION) < 0 ||
+        xml_binary_write_uint(&xbo, xml_binary_fingerprint(yspec)) < 0){
+        clixon_err(OE_XML, errno, "write binary");
+        goto done;
+    }
+    if (xml_binary_write_node(&xbo, xt, yspec, yspec, &yp, 0, depth) < 0)
+        goto done;
+    retval = 0;
+ done:
+    return retval;
+}
+
+static int
+xml_binary_read_u8(xml_binary_buf *xbb,
+                   uint8_t        *v)
+{
+    if (xbb->xbb_p >= xbb->xbb_end)
+        return -1;
+    *v = *xbb->xbb_p++;
+    return 0;
+}
+
+static int
+xml_binary_read_uint(xml_binary_buf *xbb,
+                     uint64_t       *v)
+{
+    uint8_t b;
+    int     shift = 0;
+
+    *v = 0;
+    do {
+        if (xbb->xbb_p >= xbb->xbb_end || shift > 63)
+            return -1;
+        b = *xbb->xbb_p++;
+        *v |= (uint64_t)(b & 0x7f) << shift;
+        shift += 7;
+    } while (b & 0x80);
+    return 0;
+}
+
+/*! Read string, return pointer into buffer, no copy is made
+ */
+static int
+xml_binary_read_str(xml_binary_buf *xbb,
+                    char          **str)
+{
+    uint64_t len;
+
+    if (xml_binary_read_uint(xbb, &len) < 0)
+        return -1;
+    if (len == 0){
+        *str = NULL;
+        return 0;
+    }
+    if (len > (uint64_t)(xbb->xbb_end - xbb->xbb_p) || xbb->xbb_p[len-1] != '\0')
+        return -1;
+    *str = (char*)xbb->xbb_p;
+    xbb->xbb_p += len;
+    return 0;
+}
+
+/*! Read XML node and its children recursively from binary buffer
+ *
+ * @param[in]  xbb    Binary buffer
+ * @param[in]  xp     XML parent
+ * @param[in]  anchor Yang spec of parent, or top-level yang spec
+ * @param[in]  yspec  Top-level yang spec, NULL: no binding
+ * @param[out] bound  Cleared if an element could not be bound
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+xml_binary_read_node(xml_binary_buf *xbb,
+                     cxobj          *xp,
+                     yang_stmt      *anchor,
+                     yang_stmt      *yspec,
+                     int            *bound)
+{
+    int        retval = -1;
+    uint8_t    type;
+    uint8_t    flags = 0;
+    uint64_t   ylen = 0;
+    uint64_t   idx;
+    yang_stmt *y = anchor;
+    char      *name;
+    char      *prefix;
+    char      *value;
+    uint64_t   nr;
+    uint64_t   i;
+    cxobj     *x;
+
+    if (xml_binary_read_u8(xbb, &type) < 0)
+        goto format;
+    if (type != CX_ELMNT && type != CX_ATTR && type != CX_BODY)
+        goto format;
+    if (type == CX_ELMNT){
+        if (xml_binary_read_u8(xbb, &flags) < 0 ||
+            xml_binary_read_uint(xbb, &ylen) < 0)
+            goto format;
+        if (ylen == 1)
+            *bound = 0;
+        for (i = 2; i < ylen; i++){
+            if (xml_binary_read_uint(xbb, &idx) < 0)
+                goto format;
+            if (y != NULL){
+                if (idx < yang_len_get(y))
+                    y = yang_child_i(y, idx);
+                else
+                    y = NULL;
+            }
+        }
+    }
+    if (xml_binary_read_str(xbb, &name) < 0 ||
+        xml_binary_read_str(xbb, &prefix) < 0 ||
+        name == NULL)
+        goto format;
+    if ((x = xml_new(name, xp, type)) == NULL)
+        goto done;
+    if (prefix && xml_prefix_set(x, prefix) < 0)
+        goto done;
+    if (type != CX_ELMNT){
+        if (xml_binary_read_str(xbb, &value) < 0)
+            goto format;
+        if (value && xml_value_set(x, value) < 0)
+            goto done;
+        goto ok;
+    }
+    xml_flag_set(x, flags & XML_BINARY_FLAGS);
+    if (flags & XML_BINARY_OPAQUE)
+        xml_flag_set(x, XML_FLAG_OPAQUE);
+    if (ylen < 2 || yspec == NULL)
+        y = NULL;
+    else if (y == NULL ||
+             (ylen > 2 && clicon_strcmp(yang_argument_get(y), name) != 0)){
+        y = NULL;
+        *bound = 0;
+    }
+    if (y)
+        xml_spec_set(x, y);
+    if (xml_binary_read_uint(xbb, &nr) < 0)
+        goto format;
+    for (i = 0; i < nr; i++)
+        if (xml_binary_read_node(xbb, x, y?y:yspec, yspec, bound) < 0)
+            goto done;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+ format:
+    clixon_err(OE_XML, 0, "Binary format error");
+    goto done;
+}
+
+/*! Parse binary file into XML tree
+ *
+ * A regular file is mapped, other streams such as decompressed files are read into a buffer,
+ * see clicon_file_buf
+ * @param[in]     fp    File descriptor to the binary file
+ * @param[in]     yb    YB_MODULE: bind yang specs from file if fingerprint matches, else YB_NONE
+ * @param[in]     yspec Yang specification, or NULL
+ * @param[in,out] xt    Pointer to (XML) parse tree. If empty, create.
+ * @param[out]    bound Set to 1 if whole tree is bound (and sorted), 0 if not
+ * @retval        0     OK
+ * @retval       -1     Error
+ * @code
+ *  cxobj *xt = NULL;
+ *  int    bound = 0;
+ *  if (clixon_binary_parse_file(fp, YB_MODULE, yspec, &xt, &bound) < 0)
+ *    err;
+ *  if (!bound)
+ *    xml_bind_yang(...);
+ *  xml_free(xt);
+ * @endcode
+ * @note If xt empty, a top-level symbol will be added so that <tree../> will be:  <top><tree.../></tree></top>
+ * @note Tree is allocated from XML arena if enabled, see xml_arena_enable
+ * @see clixon_xml2binary_file
+ */
+int
+clixon_binary_parse_file(FILE      *fp,
+                         yang_bind  yb,
+                         yang_stmt *yspec,
+                         cxobj    **xt,
+                         int       *bound)
+{
+    int             retval = -1;
+    char           *buf = NULL;
+    size_t          buflen = 0;
+    size_t          maplen = 0;
+    xml_binary_buf  xbb;
+    uint8_t         version;
+    uint64_t        fingerprint;
+    size_t          len;
+
+    if (xt == NULL){
+        clixon_err(OE_XML, EINVAL, "xt is NULL");
+        return -1;
+    }
+    *bound = 0;
+    xml_arena_push();
+    if (*xt == NULL)
+        if ((*xt = xml_new(XML_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
+            goto done;
+    /* Mapped, or read if eg decompressed */
+    if (clicon_file_buf(fp, &buf, &buflen, &maplen) < 0)
+        goto done;
+    if (buflen == 0){ /* Empty datastore */
+        retval = 0;
+        goto done;
+    }
+    xbb.xbb_p = (uint8_t *)buf;
+    xbb.xbb_end = xbb.xbb_p + buflen;
+    len = strlen(XML_BINARY_MAGIC);
+    if (buflen < len || memcmp(buf, XML_BINARY_MAGIC, len) != 0){
+        clixon_err(OE_XML, 0, "Not a binary datastore file");
+        goto done;
+    }
+    xbb.xbb_p += len;
+    if (xml_binary_read_u8(&xbb, &version) < 0 ||
+        xml_binary_read_uint(&xbb, &fingerprint) < 0){
+        clixon_err(OE_XML, 0, "Binary format error");
+        goto done;
+    }
+    if (version != XML_BINARY_VERSION){
+        clixon_err(OE_XML, 0, "Binary format version %u not supported", version);
+        goto done;
+    }
+    if (yb != YB_MODULE || yspec == NULL || fingerprint != xml_binary_fingerprint(yspec)){
+        clixon_debug(CLIXON_DBG_DATASTORE, "yang spec differs, not bound");
+        yspec = NULL;
+    }
+    else
+        *bound = 1;
+    if (xml_binary_read_node(&xbb, *xt, yspec, yspec, bound) < 0)
+        goto done;
+    retval = 0;
+ done:
+    if (retval < 0){
+        if (*xt){
+            xml_free(*xt);
+            *xt = NULL;
+        }
+        *bound = 0;
+    }
+    xml_arena_pop();
+    clicon_file_buf_free(buf, maplen);
+    return retval;
+}
+
+/*! Check if message on the internal socket is in binary format
+ *
+ * @param[in]  str  Received message
+ * @retval     1    Binary, parse with clixon_binary_parse_string
+ * @retval     0    Not binary, eg XML
+ */
+int
+clixon_binary_msg(const char *str)
+{
+    return strncmp(str, XML_BINARY_MAGIC, strlen(XML_BINARY_MAGIC)) == 0;
+}
+
+/*! Reset yang binding of an XML node, for xml_apply
+ */
+static int
+xml_binary_unbind(cxobj *x,
+                  void  *arg)
+{
+    xml_spec_set(x, NULL);
+    return 0;
+}
+
+/*! Parse binary message from the internal socket into XML tree
+ *
+ * @param[in]     str   Message, null-terminated
+ * @param[in]     yspec Yang specification, NULL: no binding
+ * @param[in,out] xt    Pointer to (XML) parse tree. If empty, create.
+ * @param[out]    bound Set to 1 if whole tree is bound, 0 if no node is bound
+ * @retval        0     OK
+ * @retval       -1     Error
+ * @see clixon_xml2binary_cbuf
+ */
+int
+clixon_binary_parse_string(const char *str,
+                           yang_stmt  *yspec,
+                           cxobj     **xt,
+                           int        *bound)
+{
+    int             retval = -1;
+    uint8_t        *buf = NULL;
+    size_t          len;
+    size_t          i;
+    size_t          j;
+    xml_binary_buf  xbb;
+    uint8_t         version;
+    uint64_t        fingerprint;
+    cxobj          *xtop = NULL;
+
+    *bound = 0;
+    if (!clixon_binary_msg(str)){
+        clixon_err(OE_XML, 0, "Not a binary message");
+        goto done;
+    }
+    len = strlen(str);
+    if ((buf = malloc(len)) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    /* Unescape */
+    for (i = j = 0; i < len; i++){
+        if (str[i] == XML_BINARY_ESC && i+1 < len)
+            buf[j++] = str[++i] - '0';
+        else
+            buf[j++] = str[i];
+    }
+    xbb.xbb_p = buf + strlen(XML_BINARY_MAGIC);
+    xbb.xbb_end = buf + j;
+    if (xml_binary_read_u8(&xbb, &version) < 0 ||
+        xml_binary_read_uint(&xbb, &fingerprint) < 0){
+        clixon_err(OE_XML, 0, "Binary format error");
+        goto done;
+    }
+    if (version != XML_BINARY_VERSION){
+        clixon_err(OE_XML, 0, "Binary format version %u not supported", version);
+        goto done;
+    }
+    if (yspec == NULL || fingerprint != xml_binary_fingerprint(yspec)){
+        clixon_debug(CLIXON_DBG_MSG, "yang spec differs, not bound");
+        yspec = NULL;
+    }
+    else
+        *bound = 1;
+    if ((xtop = *xt) == NULL)
+        if ((xtop = xml_new(XML_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
+            goto done;
+    if (xml_binary_read_node(&xbb, xtop, yspec, yspec, bound) < 0)
+        goto done;
+    if (yspec && *bound == 0)
+        if (xml_apply(xtop, CX_ELMNT, xml_binary_unbind, NULL) < 0)
+            goto done;
+    *xt = xtop;
+    xtop = NULL;
+    retval = 0;
+ done:
+    if (xtop && *xt == NULL)
+        xml_free(xtop);
+    if (buf)
+        free(buf);
+    return retval;
+}
@@ -79,6 +79,9 @@
 #include "clixon_xml_sort.h"
 #include "clixon_yang_type.h"
 #include "clixon_xml_map.h"
+#include "clixon_xml_io.h"
+#include "clixon_validate.h"
+#include "clixon_validate_minmax.h"
 #include "clixon_xml_bind.h"
 
 /*
@@ -86,6 +89,12 @@
  */
 static int _yang_unknown_anydata = 0;
 static int _netconf_message_id_optional = 0;
+static int _anydata_opaque = 0;
+
+/* Bulk mode parameters, see xml_bind_yang_bulk */
+struct xml_bind_bulk {
+    int bb_unique;  /* Check duplicate list and leaf-list entries */
+};
 
 /*! Kludge to equate unknown XML with anydata
  *
@@ -109,6 +118,18 @@ xml_bind_netconf_message_id_optional(int val)
     return 0;
 }
 
+/*! Keep content of anydata and anyxml configuration data as raw XML
+ *
+ * The problem with this is that its global and should be bound to a handle
+ * @see CLICON_XMLDB_ANYDATA_OPAQUE
+ */
+int
+xml_bind_anydata_opaque(int val)
+{
+    _anydata_opaque = val;
+    return 0;
+}
+
 /*! After yang binding, bodies of containers and lists are stripped from XML bodies
  *
  * May apply to other nodes?
@@ -166,12 +187,14 @@ populate_self_parent(clixon_handle h,
     char      *ns = NULL;    /* XML namespace of xt */
     char      *nsy = NULL;   /* Yang namespace of xt */
     cbuf      *cb = NULL;
+    int        nsmatch = 1;  /* Namespaces of xt and y match */
 
     name = xml_name(xt);
     /* optimization for massive lists - use the first element as role model */
     if (xsibling &&
         xml_child_nr_type(xt, CX_ATTR) == 0){
         y = xml_spec(xsibling);
+        nsmatch = xml_flag(xsibling, XML_FLAG_NS_SPEC) != 0;
         goto set;
     }
     if ((xp = xml_parent(xt)) == NULL){
@@ -192,6 +215,9 @@ populate_self_parent(clixon_handle h,
     }
     if (xml2ns(xt, xml_prefix(xt), &ns) < 0)
         goto done;
+    /* Common case: lookup of datanode with matching namespace */
+    if ((y = yang_find_datanode_ns(yparent, ns, name)) != NULL)
+        goto set;
     /* Special case since action is not a datanode */
     if ((y = yang_find(yparent, Y_ACTION, name)) == NULL)
         if ((y = yang_find_datanode(yparent, name)) == NULL){
@@ -240,6 +266,8 @@ populate_self_parent(clixon_handle h,
     }
  set:
     xml_spec_set(xt, y);
+    if (nsmatch)
+        xml_flag_set(xt, XML_FLAG_NS_SPEC);
 #ifdef XML_EXPLICIT_INDEX
     if (xml_search_index_p(xt))
         xml_search_child_insert(xp, xt);
@@ -350,6 +378,7 @@ populate_self_top(clixon_handle h,
         goto fail;
     }
     xml_spec_set(xt, y);
+    xml_flag_set(xt, XML_FLAG_NS_SPEC); /* Namespaces match */
     retval = 1;
  done:
     if (cb)
@@ -409,6 +438,91 @@ xml_bind_yang(clixon_handle h,
     goto done;
 }
 
+/*! Bulk mode: sort and edit-validate XML node after its subtree is bound
+ *
+ * Made while the node is hot in cache instead of separate tree passes.
+ * @param[in]  xt      XML node
+ * @param[in]  bb      Bulk mode parameters
+ * @param[in]  recurse Subtree of xt is not bound, sort it recursively
+ * @param[out] xerr    Reason for failure, or NULL
+ * @retval     1       OK
+ * @retval     0       Validation failed and xerr set
+ * @retval    -1       Error
+ * @see xml_bind_yang_bulk
+ */
+static int
+xml_bind_bulk_node(cxobj                *xt,
+                   struct xml_bind_bulk *bb,
+                   int                   recurse,
+                   cxobj               **xerr)
+{
+    int        retval = -1;
+    yang_stmt *y;
+    cbuf      *cb = NULL;
+    int        ret;
+
+    /* State data not allowed, cf xml_non_config_data */
+    if ((y = xml_spec(xt)) != NULL && !yang_config(y)){
+        if ((cb = cbuf_new()) == NULL){
+            clixon_err(OE_UNIX, errno, "cbuf_new");
+            goto done;
+        }
+        cprintf(cb, "module %s: state data node unexpected", yang_argument_get(ys_module(y)));
+        if (xerr && netconf_bad_element_xml(xerr, "application", yang_argument_get(y), cbuf_get(cb)) < 0)
+            goto done;
+        goto fail;
+    }
+    if ((ret = xml_yang_validate_list_key(xt, xerr)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
+    if (recurse){
+        if (xml_sort_recurse(xt) < 0)
+            goto done;
+    }
+    else if (xml_sort_level(xt) < 0)
+        goto done;
+    if (bb->bb_unique){
+        if ((ret = xml_yang_validate_unique(xt, xerr)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+    }
+    retval = 1;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Replace content of anydata configuration node with raw XML
+ *
+ * @param[in]   xt     XML tree node, bound
+ * @retval      1      Content is raw XML, children are not bound
+ * @retval      0      Not anydata or anyxml configuration node
+ * @retval     -1      Error
+ * @see xml_bind_anydata_opaque
+ */
+static int
+xml_bind_opaque(cxobj *xt)
+{
+    yang_stmt    *y;
+    enum rfc_6020 keyword;
+
+    if ((y = xml_spec(xt)) == NULL)
+        return 0;
+    keyword = yang_keyword_get(y);
+    if ((keyword != Y_ANYDATA && keyword != Y_ANYXML) ||
+        yang_config_ancestor(y) == 0)
+        return 0;
+    if (xml_opaque_make(xt) < 0)
+        return -1;
+    return 1;
+}
+
 /*! Bind yang opt
  *
  * @param[in]   h      Clixon handle (sometimes NULL)
@@ -416,18 +530,20 @@ xml_bind_yang(clixon_handle h,
  * @param[in]   yb     How to bind yang to XML top-level when parsing
  * @param[in]   yspec  Yang spec
  * @param[in]   xsibling
+ * @param[in]   bb     Bulk mode, or NULL
  * @param[out]  xerr   Reason for failure, or NULL
  * @retval      1      OK yang assignment made
  * @retval      0      Partial or no yang assigment made (at least one failed) and xerr set
  * @retval     -1      Error
  */
 static int
-xml_bind_yang0_opt(clixon_handle h,
-                   cxobj        *xt,
-                   yang_bind     yb,
-                   yang_stmt    *yspec,
-                   cxobj        *xsibling,
-                   cxobj       **xerr)
+xml_bind_yang0_opt(clixon_handle         h,
+                   cxobj                *xt,
+                   yang_bind             yb,
+                   yang_stmt            *yspec,
+                   cxobj                *xsibling,
+                   struct xml_bind_bulk *bb,
+                   cxobj               **xerr)
 {
     int        retval = -1;
     cxobj     *xc;           /* xml child */
@@ -441,6 +557,7 @@ xml_bind_yang0_opt(clixon_handle h,
     yang_bind  ybc;
     char      *prefix;
     yang_stmt *yspec1 = NULL;
+    int        recurse = 1; /* Children not bound, for bulk mode */
 
     switch (yb){
     case YB_MODULE:
@@ -461,6 +578,14 @@ xml_bind_yang0_opt(clixon_handle h,
     else if (ret == 2)     /* ret=2 for anyxml from parent^ */
         goto ok;
     strip_body_objects(xt);
+    if (_anydata_opaque){
+        if ((ret = xml_bind_opaque(xt)) < 0)
+            goto done;
+        if (ret == 1){
+            recurse = 0;
+            goto ok;
+        }
+    }
     ybc = YB_PARENT;
     if (h && clicon_option_bool(h, "CLICON_YANG_SCHEMA_MOUNT")){
         yspec1 = NULL;
@@ -501,15 +626,15 @@ xml_bind_yang0_opt(clixon_handle h,
         if (yc0 != NULL &&
             clicon_strcmp(name0, name) == 0 &&
             clicon_strcmp(prefix0, prefix) == 0){
-            if ((ret = xml_bind_yang0_opt(h, xc, ybc, yspec1, xc0, xerr)) < 0)
+            if ((ret = xml_bind_yang0_opt(h, xc, ybc, yspec1, xc0, bb, xerr)) < 0)
                 goto done;
         }
         else if (xsibling &&
                  (xs = xml_find_type(xsibling, prefix, name, CX_ELMNT)) != NULL){
-            if ((ret = xml_bind_yang0_opt(h, xc, ybc, yspec1, xs, xerr)) < 0)
+            if ((ret = xml_bind_yang0_opt(h, xc, ybc, yspec1, xs, bb, xerr)) < 0)
                 goto done;
         }
-        else if ((ret = xml_bind_yang0_opt(h, xc, ybc, yspec1, NULL, xerr)) < 0)
+        else if ((ret = xml_bind_yang0_opt(h, xc, ybc, yspec1, NULL, bb, xerr)) < 0)
             goto done;
         if (ret == 0)
             goto fail;
@@ -518,7 +643,14 @@ xml_bind_yang0_opt(clixon_handle h,
         name0 = xml_name(xc);
         prefix0 = xml_prefix(xc);
     }
+    recurse = 0;
  ok:
+    if (bb){
+        if ((ret = xml_bind_bulk_node(xt, bb, recurse, xerr)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+    }
     retval = 1;
  done:
     return retval;
@@ -527,29 +659,31 @@ xml_bind_yang0_opt(clixon_handle h,
     goto done;
 }
 
-/*! Find yang spec association of tree of XML nodes
+/*! Find yang spec association of tree of XML nodes, optionally in bulk mode
  *
  * @param[in]   h      Clixon handle (sometimes NULL)
  * @param[in]   xt     XML tree node
  * @param[in]   yb     How to bind yang to XML top-level when parsing
  * @param[in]   yspec  Yang spec
+ * @param[in]   bb     Bulk mode, or NULL
  * @param[out]  xerr   Reason for failure, or NULL
  * @retval      1      OK yang assignment made
  * @retval      0      Partial or no yang assigment made (at least one failed) and xerr set
  * @retval     -1      Error
- * Populate xt as top-level node
- * @see xml_bind_yang  If only children of xt should be populated, not xt itself
+ * @see xml_bind_yang0
  */
-int
-xml_bind_yang0(clixon_handle h,
-               cxobj        *xt,
-               yang_bind     yb,
-               yang_stmt    *yspec,
-               cxobj       **xerr)
+static int
+xml_bind_yang0_bulk(clixon_handle         h,
+                    cxobj                *xt,
+                    yang_bind             yb,
+                    yang_stmt            *yspec,
+                    struct xml_bind_bulk *bb,
+                    cxobj               **xerr)
 {
     int        retval = -1;
     cxobj     *xc;           /* xml child */
     int        ret;
+    int        recurse = 1;  /* Children not bound, for bulk mode */
 
     switch (yb){
     case YB_MODULE:
@@ -573,14 +707,142 @@ xml_bind_yang0(clixon_handle h,
     else if (ret == 2)     /* ret=2 for anyxml from parent^ */
         goto ok;
     strip_body_objects(xt);
+    if (_anydata_opaque){
+        if ((ret = xml_bind_opaque(xt)) < 0)
+            goto done;
+        if (ret == 1){
+            recurse = 0;
+            goto ok;
+        }
+    }
     xc = NULL;     /* Apply on children */
     while ((xc = xml_child_each(xt, xc, CX_ELMNT)) != NULL) {
-        if ((ret = xml_bind_yang0_opt(h, xc, YB_PARENT, yspec, NULL, xerr)) < 0)
+        if ((ret = xml_bind_yang0_opt(h, xc, YB_PARENT, yspec, NULL, bb, xerr)) < 0)
             goto done;
         if (ret == 0)
             goto fail;
     }
+    recurse = 0;
  ok:
+    if (bb){
+        if ((ret = xml_bind_bulk_node(xt, bb, recurse, xerr)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+    }
+    retval = 1;
+ done:
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Find yang spec association of a single XML node, not its children
+ *
+ * Used when binding incrementally as nodes are created, eg by the streaming parser.
+ * The attributes of xt must be present since namespaces are resolved, and with YB_PARENT
+ * the parent of xt must already be bound.
+ * @param[in]   h      Clixon handle (sometimes NULL)
+ * @param[in]   xt     XML tree node
+ * @param[in]   yb     YB_MODULE or YB_PARENT
+ * @param[in]   yspec  Yang spec
+ * @param[out]  xerr   Reason for failure, or NULL
+ * @retval      2      OK yang assignment not made because yang parent is anyxml or anydata
+ * @retval      1      OK yang assignment made
+ * @retval      0      Yang assigment not made and xerr set
+ * @retval     -1      Error
+ * @note Schema mount-points are not handled
+ * @see xml_bind_yang0  Recursive
+ * @see clixon_xml_parse_file_stream
+ */
+int
+xml_bind_yang_node(clixon_handle h,
+                   cxobj        *xt,
+                   yang_bind     yb,
+                   yang_stmt    *yspec,
+                   cxobj       **xerr)
+{
+    int retval = -1;
+
+    switch (yb){
+    case YB_MODULE:
+        retval = populate_self_top(h, xt, yspec, xerr);
+        break;
+    case YB_PARENT:
+        retval = populate_self_parent(h, xt, NULL, yspec, xerr);
+        break;
+    default:
+        clixon_err(OE_XML, EINVAL, "Invalid yang binding: %d", yb);
+        break;
+    }
+    return retval;
+}
+
+/*! Find yang spec association of tree of XML nodes
+ *
+ * @param[in]   h      Clixon handle (sometimes NULL)
+ * @param[in]   xt     XML tree node
+ * @param[in]   yb     How to bind yang to XML top-level when parsing
+ * @param[in]   yspec  Yang spec
+ * @param[out]  xerr   Reason for failure, or NULL
+ * @retval      1      OK yang assignment made
+ * @retval      0      Partial or no yang assigment made (at least one failed) and xerr set
+ * @retval     -1      Error
+ * Populate xt as top-level node
+ * @see xml_bind_yang  If only children of xt should be populated, not xt itself
+ */
+int
+xml_bind_yang0(clixon_handle h,
+               cxobj        *xt,
+               yang_bind     yb,
+               yang_stmt    *yspec,
+               cxobj       **xerr)
+{
+    return xml_bind_yang0_bulk(h, xt, yb, yspec, NULL, xerr);
+}
+
+/*! Bind, sort and edit-validate an XML tree in a single pass
+ *
+ * Same as xml_bind_yang followed by xml_non_config_data, xml_yang_validate_unique_recurse,
+ * xml_yang_validate_list_key_only and xml_sort_recurse, but each node is sorted and
+ * validated directly after its subtree is bound, while it is hot in cache.
+ * Intended for large edit-config payloads.
+ * @param[in]   h      Clixon handle
+ * @param[in]   xt     XML tree node, eg <config>, its children are populated
+ * @param[in]   yspec  Yang spec
+ * @param[in]   unique Check duplicate list and leaf-list entries
+ * @param[out]  xerr   Reason for failure, or NULL
+ * @retval      1      OK
+ * @retval      0      Binding or validation failed and xerr set
+ * @retval     -1      Error
+ * @note Validation errors may be reported in another order than with separate passes
+ * @see xml_bind_yang
+ */
+int
+xml_bind_yang_bulk(clixon_handle h,
+                   cxobj        *xt,
+                   yang_stmt    *yspec,
+                   int           unique,
+                   cxobj       **xerr)
+{
+    int    retval = -1;
+    cxobj *xc;         /* xml child */
+    int    ret;
+    struct xml_bind_bulk bb = {unique};
+
+    strip_body_objects(xt);
+    xc = NULL;     /* Apply on children */
+    while ((xc = xml_child_each(xt, xc, CX_ELMNT)) != NULL) {
+        if ((ret = xml_bind_yang0_bulk(h, xc, YB_MODULE, yspec, &bb, xerr)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+    }
+    if ((ret = xml_bind_bulk_node(xt, &bb, 0, xerr)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
     retval = 1;
  done:
     return retval;
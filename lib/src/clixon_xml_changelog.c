@@ -46,6 +46,7 @@
 #include <unistd.h>
 #include <errno.h>
 #include <string.h>
+#include <ctype.h>
 #include <limits.h>
 #include <stdint.h>
 #include <sys/types.h>
@@ -75,6 +76,7 @@
 #include "clixon_xml_map.h"
 #include "clixon_xml_io.h"
 #include "clixon_validate.h"
+#include "clixon_string.h"
 #include "clixon_xml_changelog.h"
 #include "clixon_xpath_ctx.h"
 #include "clixon_xpath.h"
@@ -358,6 +360,371 @@ changelog_iterate(clixon_handle h,
     goto done;
 }
 
+/*! Compiled changelog step, see changelog_compile
+ */
+typedef struct {
+    cxobj  *cs_xi;      /* Changelog step */
+    char   *cs_op;      /* Operation: rename, replace, insert or delete */
+    int     cs_len;     /* Number of where path components */
+    char  **cs_names;   /* Local name of each where path component */
+    char  **cs_ns;      /* Namespace of each where path component */
+    char   *cs_tag;     /* Rename tag (literal, unquoted) */
+    cxobj  *cs_new;     /* New xml (insert, replace) */
+    cvec   *cs_nsc;     /* Namespace context of step */
+} changelog_step;
+
+static void
+changelog_step_free(changelog_step *cs)
+{
+    int i;
+
+    if (cs->cs_names){
+        for (i=0; i<cs->cs_len; i++)
+            if (cs->cs_names[i])
+                free(cs->cs_names[i]);
+        free(cs->cs_names);
+    }
+    if (cs->cs_ns)
+        free(cs->cs_ns);
+    if (cs->cs_tag)
+        free(cs->cs_tag);
+    if (cs->cs_nsc)
+        xml_nsctx_free(cs->cs_nsc);
+    memset(cs, 0, sizeof(*cs));
+}
+
+/*! Compile a changelog step to a single-pass rewrite
+ *
+ * A step can be compiled if its where is an absolute path of prefixed node names without
+ * predicates, its op is rename, replace, insert or delete, it has no when, and a rename tag
+ * is a string literal. These steps can be applied in a single traversal.
+ * @param[in]  xi   Changelog step
+ * @param[out] cs   Compiled step, free with changelog_step_free
+ * @retval     1    OK, compiled
+ * @retval     0    Step cannot be compiled, apply it with changelog_op
+ * @retval    -1    Error
+ */
+static int
+changelog_compile(cxobj          *xi,
+                  changelog_step *cs)
+{
+    int    retval = -1;
+    char  *op;
+    char  *where;
+    char  *tag;
+    char **vec = NULL;
+    int    nvec;
+    char  *name;
+    char  *prefix;
+    char  *p;
+    size_t len;
+    int    i;
+
+    memset(cs, 0, sizeof(*cs));
+    cs->cs_xi = xi;
+    if ((op = xml_find_body(xi, "op")) == NULL ||
+        (where = xml_find_body(xi, "where")) == NULL)
+        goto fail;
+    if (strcmp(op, "rename") != 0 && strcmp(op, "replace") != 0 &&
+        strcmp(op, "insert") != 0 && strcmp(op, "delete") != 0)
+        goto fail;
+    if (xml_find_body(xi, "when") != NULL)
+        goto fail;
+    cs->cs_op = op;
+    cs->cs_new = xml_find(xi, "new");
+    if (strcmp(op, "rename") == 0){
+        if ((tag = xml_find_body(xi, "tag")) == NULL)
+            goto fail;
+        len = strlen(tag);
+        if (len < 3 || (tag[0] != '"' && tag[0] != '\'') || tag[len-1] != tag[0])
+            goto fail;
+        if (memchr(tag+1, tag[0], len-2) != NULL)
+            goto fail;
+        if ((cs->cs_tag = strndup(tag+1, len-2)) == NULL){
+            clixon_err(OE_UNIX, errno, "strndup");
+            goto done;
+        }
+    }
+    else if (cs->cs_new == NULL)
+        goto fail;
+    if (where[0] != '/' || where[1] == '\0')
+        goto fail;
+    for (p=where+1; *p; p++)
+        if (!isalnum(*p) && strchr(":/_.-", *p) == NULL)
+            goto fail;
+    if ((vec = clicon_strsep(where+1, "/", &nvec)) == NULL)
+        goto done;
+    if (xml_nsctx_node(xi, &cs->cs_nsc) < 0)
+        goto done;
+    if ((cs->cs_names = calloc(nvec, sizeof(char*))) == NULL ||
+        (cs->cs_ns = calloc(nvec, sizeof(char*))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    cs->cs_len = nvec;
+    for (i=0; i<nvec; i++){
+        if (nodeid_split(vec[i], &prefix, &name) < 0)
+            goto done;
+        cs->cs_names[i] = name;
+        if (prefix == NULL || strlen(name) == 0){
+            if (prefix)
+                free(prefix);
+            goto fail;
+        }
+        cs->cs_ns[i] = xml_nsctx_get(cs->cs_nsc, prefix);
+        free(prefix);
+        if (cs->cs_ns[i] == NULL)
+            goto fail;
+    }
+    retval = 1;
+ done:
+    if (vec)
+        free(vec);
+    return retval;
+ fail:
+    changelog_step_free(cs);
+    retval = 0;
+    goto done;
+}
+
+/*! Check if later steps may observe the tree differently if applied in a single pass
+ *
+ * Steps are applied along each path in step order. This is the same as applying them one
+ * by one, unless a later step renames, replaces or deletes a node above an earlier step's
+ * target, or inserts nodes that an earlier step would have matched.
+ * @param[in]  steps  Compiled steps
+ * @param[in]  nsteps Number of steps
+ * @retval     1      Conflict, apply the steps one by one
+ * @retval     0      No conflict
+ */
+static int
+changelog_conflict(changelog_step *steps,
+                   int             nsteps)
+{
+    changelog_step *csj;
+    changelog_step *csk;
+    cxobj          *x;
+    int             j;
+    int             k;
+    int             i;
+
+    for (j=1; j<nsteps; j++){
+        csj = &steps[j];
+        for (k=0; k<j; k++){
+            csk = &steps[k];
+            if (csj->cs_len >= csk->cs_len)
+                continue;
+            for (i=0; i<csj->cs_len; i++)
+                if (strcmp(csj->cs_names[i], csk->cs_names[i]) != 0 ||
+                    strcmp(csj->cs_ns[i], csk->cs_ns[i]) != 0)
+                    break;
+            if (i < csj->cs_len) /* Not a prefix */
+                continue;
+            if (strcmp(csj->cs_op, "insert") != 0)
+                return 1;
+            x = NULL;
+            while ((x = xml_child_each(csj->cs_new, x, CX_ELMNT)) != NULL)
+                if (strcmp(xml_name(x), csk->cs_names[i]) == 0)
+                    return 1;
+        }
+    }
+    return 0;
+}
+
+/*! Apply compiled changelog steps to a node and recursively to its children
+ *
+ * @param[in]  h       Clixon handle
+ * @param[in]  xt      Top-level XML tree
+ * @param[in]  x       Node matching the first depth components of the active steps
+ * @param[in]  depth   Number of matched path components, 0 for xt
+ * @param[in]  steps   Compiled steps
+ * @param[in]  active  Indexes of active steps, in step order
+ * @param[in]  nactive Number of active steps
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+changelog_apply(clixon_handle   h,
+                cxobj          *xt,
+                cxobj          *x,
+                int             depth,
+                changelog_step *steps,
+                int            *active,
+                int             nactive)
+{
+    int             retval = -1;
+    changelog_step *cs;
+    int            *sub = NULL;
+    int             nsub;
+    int            *csub = NULL;
+    int             ncsub;
+    cxobj         **xvec = NULL;
+    int             xlen;
+    cxobj          *xc;
+    char           *ns;
+    int             i;
+    int             j;
+
+    if ((sub = calloc(nactive, sizeof(int))) == NULL ||
+        (csub = calloc(nactive, sizeof(int))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    nsub = 0;
+    for (i=0; i<nactive; i++){
+        cs = &steps[active[i]];
+        /* An earlier step may have renamed or replaced x */
+        if (depth > 0){
+            if (xml2ns(x, xml_prefix(x), &ns) < 0)
+                goto done;
+            if (strcmp(xml_name(x), cs->cs_names[depth-1]) != 0 ||
+                ns == NULL || strcmp(ns, cs->cs_ns[depth-1]) != 0)
+                continue;
+        }
+        if (cs->cs_len > depth){
+            sub[nsub++] = active[i];
+            continue;
+        }
+        if (strcmp(cs->cs_op, "rename") == 0){
+            if (xml_name_set(x, cs->cs_tag) < 0)
+                goto done;
+        }
+        else if (strcmp(cs->cs_op, "replace") == 0){
+            if (changelog_replace(h, xt, x, cs->cs_new) < 0)
+                goto done;
+        }
+        else if (strcmp(cs->cs_op, "insert") == 0){
+            if (changelog_insert(h, xt, x, cs->cs_new) < 0)
+                goto done;
+        }
+        else if (strcmp(cs->cs_op, "delete") == 0){
+            if (changelog_delete(h, xt, x) < 0)
+                goto done;
+            goto ok;
+        }
+    }
+    if (nsub == 0)
+        goto ok;
+    /* Children may be deleted or renamed below, take a copy */
+    if ((xvec = calloc(xml_child_nr_type(x, CX_ELMNT) + 1, sizeof(cxobj*))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    xlen = 0;
+    xc = NULL;
+    while ((xc = xml_child_each(x, xc, CX_ELMNT)) != NULL){
+        for (j=0; j<nsub; j++)
+            if (strcmp(xml_name(xc), steps[sub[j]].cs_names[depth]) == 0)
+                break;
+        if (j < nsub)
+            xvec[xlen++] = xc;
+    }
+    for (i=0; i<xlen; i++){
+        xc = xvec[i];
+        if (xml2ns(xc, xml_prefix(xc), &ns) < 0)
+            goto done;
+        ncsub = 0;
+        for (j=0; j<nsub; j++){
+            cs = &steps[sub[j]];
+            if (strcmp(xml_name(xc), cs->cs_names[depth]) == 0 &&
+                ns && strcmp(ns, cs->cs_ns[depth]) == 0)
+                csub[ncsub++] = sub[j];
+        }
+        if (ncsub &&
+            changelog_apply(h, xt, xc, depth+1, steps, csub, ncsub) < 0)
+            goto done;
+    }
+ ok:
+    retval = 0;
+ done:
+    if (xvec)
+        free(xvec);
+    if (sub)
+        free(sub);
+    if (csub)
+        free(csub);
+    return retval;
+}
+
+/*! Apply all steps of a module's changelogs in a single pass if possible
+ *
+ * @param[in]  h       Clixon handle
+ * @param[in]  xt      XML to upgrade
+ * @param[in]  xchvec  Changelogs to apply, in order
+ * @param[in]  nxch    Number of changelogs
+ * @retval     1       OK, steps applied
+ * @retval     0       Steps cannot be compiled or conflict, nothing applied
+ * @retval    -1       Error
+ */
+static int
+changelog_single_pass(clixon_handle h,
+                      cxobj        *xt,
+                      cxobj       **xchvec,
+                      int           nxch)
+{
+    int             retval = -1;
+    cxobj         **vec = NULL;
+    size_t          veclen;
+    changelog_step *steps = NULL;
+    int            *active = NULL;
+    int             nsteps = 0;
+    int             n;
+    int             ret;
+    int             i;
+    int             j;
+
+    for (i=0; i<nxch; i++){
+        if (xpath_vec(xchvec[i], NULL, "step", &vec, &veclen) < 0)
+            goto done;
+        if (veclen){
+            if ((steps = realloc(steps, (nsteps+veclen)*sizeof(*steps))) == NULL){
+                clixon_err(OE_UNIX, errno, "realloc");
+                goto done;
+            }
+            for (j=0; j<veclen; j++){
+                if ((ret = changelog_compile(vec[j], &steps[nsteps])) < 0)
+                    goto done;
+                if (ret == 0)
+                    goto fail;
+                nsteps++;
+            }
+        }
+        if (vec){
+            free(vec);
+            vec = NULL;
+        }
+    }
+    if (nsteps == 0)
+        goto ok;
+    if (changelog_conflict(steps, nsteps))
+        goto fail;
+    if ((active = calloc(nsteps, sizeof(int))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    for (i=0; i<nsteps; i++)
+        active[i] = i;
+    if (changelog_apply(h, xt, xt, 0, steps, active, nsteps) < 0)
+        goto done;
+ ok:
+    retval = 1;
+ done:
+    clixon_debug(CLIXON_DBG_XML, "steps:%d retval:%d", nsteps, retval);
+    if (vec)
+        free(vec);
+    if (active)
+        free(active);
+    if (steps){
+        for (n=0; n<nsteps; n++)
+            changelog_step_free(&steps[n]);
+        free(steps);
+    }
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
 /*! Automatic upgrade using changelog
  *
  * @param[in]  h       Clixon handle 
@@ -391,6 +758,7 @@ xml_changelog_upgrade(clixon_handle h,
     char      *b;
     int        ret;
     int        i;
+    int        nxch;
     uint32_t   f;
     uint32_t   t;
 
@@ -409,6 +777,7 @@ xml_changelog_upgrade(clixon_handle h,
                   &vec, &veclen, ns) < 0)
         goto done;
     /* Get all changelogs in the interval [from,to]*/
+    nxch = 0;
     for (i=0; i<veclen; i++){
         xch = vec[i];
         f = t = 0;
@@ -420,11 +789,18 @@ xml_changelog_upgrade(clixon_handle h,
                 goto done;
         if ((f && from>f) || to<t)
             continue;
-        if ((ret = changelog_iterate(h, xt, xch)) < 0)
-            goto done;
-        if (ret == 0)
-            goto fail;
+        vec[nxch++] = xch;
     }
+    /* Apply all steps in one traversal, or else one step at a time */
+    if ((ret = changelog_single_pass(h, xt, vec, nxch)) < 0)
+        goto done;
+    if (ret == 0)
+        for (i=0; i<nxch; i++){
+            if ((ret = changelog_iterate(h, xt, vec[i])) < 0)
+                goto done;
+            if (ret == 0)
+                goto fail;
+        }
  ok:
     retval = 1;
  done:
@@ -395,6 +395,25 @@ xml_default(yang_stmt *yt,
     return retval;
 }
 
+/*! Fill in default values of one XML node, not recursively
+ *
+ * @param[in]   xn      XML node with yang spec
+ * @param[in]   state   If set expand defaults also for state data, otherwise only config
+ * @retval      0       OK
+ * @retval     -1       Error
+ * @see xml_default_recurse
+ */
+int
+xml_default_node(cxobj *xn,
+                 int    state)
+{
+    yang_stmt *yn;
+
+    if ((yn = (yang_stmt*)xml_spec(xn)) == NULL)
+        return 0;
+    return xml_default(yn, xn, state);
+}
+
 /*! Selectively recursively fill in default values in an XML tree using flags
  *
  * Skip nodes that are not either CHANGE or "flag" (typically ADD|DEL)
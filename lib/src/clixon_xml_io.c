@@ -55,6 +55,7 @@
 #include <fcntl.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <dirent.h>
 
 /* cligen */
 #include <cligen/cligen.h>
@@ -70,6 +71,7 @@
 #include "clixon_xml.h"
 #include "clixon_err.h"
 #include "clixon_log.h"
+#include "clixon_file.h"
 #include "clixon_debug.h"
 #include "clixon_options.h"
 #include "clixon_yang_module.h"
@@ -86,15 +88,12 @@
 #include "clixon_datastore.h"
 #include "clixon_xml_io.h"
 
-/*
- * Constants
- */
-/* Size of xml read buffer */
-#define BUFLEN 1024
-
 /* Forward */
 static int xml_diff2cbuf(cbuf *cb, cxobj *x0, cxobj *x1, int level, int skiptop);
 
+/* Current XML parser, see CLICON_XML_PARSER */
+static int _xml_parser_mode = XML_PARSER_BISON;
+
 /*------------------------------------------------------------------------
  * XML printing functions. Output a parse tree to file, string cligen buf
  *------------------------------------------------------------------------*/
@@ -107,8 +106,9 @@ static int xml_diff2cbuf(cbuf *cb, cxobj *x0, cxobj *x1, int level, int skiptop)
  * @retval      1    Keep it
  * @retval      0    Remove it
  * @retval     -1    Error
+ * @see clixon_xml2binary_cbuf  also uses this for binary output
  */
-static int
+int
 xml2output_wdef(cxobj            *x,
                 withdefaults_type wdef,
                 int              *tag)
@@ -194,19 +194,18 @@ xml2output_wdef(cxobj            *x,
 
 /*! Print an XML tree structure to an output stream and encode chars "<>&"
  *
- * @param[in]   f          UNIX output stream
+ * @param[in]   fo         Buffered output
  * @param[in]   x          Clixon xml tree
  * @param[in]   level      How many spaces to insert before each line
  * @param[in]   pretty     Insert \n and spaces to make the xml more readable.
  * @param[in]   prefix     Add string to beginning of each line (if pretty)
- * @param[in]   fn         Callback to make print function
  * @param[in]   autocliext How to handle autocli extensions: 0: ignore 1: follow
  * @param[in]   wdef       With-defaults parameter, default is WITHDEFAULTS_REPORT_ALL
  * @param[in]   multi      Multi-file split datastore, see CLICON_XMLDB_MULTI
  * @retval      0          OK
  * @retval     -1          Error
- * One can use clixon_xml2cbuf to get common code, but using fprintf is
- * much faster than using cbuf and then printing that,...
+ * Output is appended to the buffer which is flushed in large chunks after child elements,
+ * instead of one print call per tag, attribute and body.
  * wdef changes the output as follows:
  * - WITHDEFAULTS_REPORT_ALL        - keep as-is
  * - WITHDEFAULTS_TRIM              - remove defaults + equal value, and no-presence
@@ -215,24 +214,23 @@ xml2output_wdef(cxobj            *x,
  * @see xml2cbuf_recurse  same with cbuf
  */
 static int
-xml2file_recurse(FILE                *f,
+xml2file_recurse(clicon_file_out     *fo,
                  cxobj               *x,
                  int                  level,
                  int                  pretty,
                  char                *prefix,
-                 clicon_output_cb    *fn,
                  int                  autocliext,
                  withdefaults_type    wdef,
                  int                  multi)
 {
     int           retval = -1;
+    cbuf         *cb = fo->fo_cb;
     char         *name;
     char         *namespace;
     cxobj        *xc;
     int           hasbody;
     int           haselement;
     char         *val;
-    char         *encstr = NULL; /* xml encoded string */
     int           exist = 0;
     yang_stmt    *y;
     int           level1;
@@ -265,25 +263,34 @@ xml2file_recurse(FILE                *f,
     case CX_BODY:
         if ((val = xml_value(x)) == NULL) /* incomplete tree */
             break;
-        if (xml_chardata_encode(&encstr, 0, "%s", val) < 0)
+        if (xml_opaque_raw(x))
+            cbuf_append_str(cb, val);
+        else if (xml_chardata_cbuf_append(cb, 0, val) < 0)
             goto done;
-        (*fn)(f, "%s", encstr);
         break;
     case CX_ATTR:
-        (*fn)(f, " ");
-        if (namespace)
-            (*fn)(f, "%s:", namespace);
-        (*fn)(f, "%s=\"%s\"", name, xml_value(x));
+        cbuf_append(cb, ' ');
+        if (namespace){
+            cbuf_append_str(cb, namespace);
+            cbuf_append(cb, ':');
+        }
+        cprintf(cb, "%s=\"%s\"", name, xml_value(x));
         break;
     case CX_ELMNT:
-        if (pretty && prefix)
-            (*fn)(f, "%s", prefix);
-        (*fn)(f, "%*s<", pretty?level1:0, "");
-        if (namespace)
-            (*fn)(f, "%s:", namespace);
-        (*fn)(f, "%s", name);
+        if (pretty){
+            if (prefix)
+                cbuf_append_str(cb, prefix);
+            if (clixon_cbuf_indent(cb, abs(level1)) < 0) /* As "%*s" */
+                goto done;
+        }
+        cbuf_append(cb, '<');
+        if (namespace){
+            cbuf_append_str(cb, namespace);
+            cbuf_append(cb, ':');
+        }
+        cbuf_append_str(cb, name);
         if (tag) /* If default and WITHDEFAULTS_REPORT_ALL_TAGGED */
-            (*fn)(f, " wd:default=\"true\"");
+            cbuf_append_str(cb, " wd:default=\"true\"");
         hasbody = 0;
         haselement = 0;
         xc = NULL;
@@ -291,7 +298,7 @@ xml2file_recurse(FILE                *f,
         while ((xc = xml_child_each(x, xc, -1)) != NULL) {
             switch (xml_type(xc)){
             case CX_ATTR:
-                if (xml2file_recurse(f, xc, level+1, pretty, prefix, fn, autocliext, wdef, multi) < 0)
+                if (xml2file_recurse(fo, xc, level+1, pretty, prefix, autocliext, wdef, multi) < 0)
                     goto done;
                 break;
             case CX_BODY:
@@ -307,8 +314,9 @@ xml2file_recurse(FILE                *f,
         /* Check for special case <a/> instead of <a></a>:
          * Ie, no CX_BODY or CX_ELMNT child.
          */
-        if (hasbody==0 && haselement==0)
-            (*fn)(f, "/>");
+        /* Children of lazy node are not loaded but exist in sub-file */
+        if (hasbody==0 && haselement==0 && !xml_flag(x, XML_FLAG_LAZY))
+            cbuf_append_str(cb, "/>");
         else{
             /* Check if this is a multi-file split-point */
             if (multi && (y = xml_spec(x)) != NULL){
@@ -320,16 +328,15 @@ xml2file_recurse(FILE                *f,
                         goto done;
                     if (clixon_digest_hex(xpath, &hexstr) < 0)
                         goto done;
-                    (*fn)(f, " xmlns:%s=\"%s\"", CLIXON_LIB_PREFIX, CLIXON_LIB_NS);
-                    (*fn)(f, " %s:link=\"%s.xml\"", CLIXON_LIB_PREFIX, hexstr);
-                    (*fn)(f, "/>");
+                    cprintf(cb, " xmlns:%s=\"%s\"", CLIXON_LIB_PREFIX, CLIXON_LIB_NS);
+                    cprintf(cb, " %s:link=\"%s.xml\"", CLIXON_LIB_PREFIX, hexstr);
+                    cbuf_append_str(cb, "/>");
                 }
             }
             if (!subfile) {
-                (*fn)(f, ">");
-                if (pretty && hasbody == 0){
-                    (*fn)(f, "\n");
-                }
+                cbuf_append(cb, '>');
+                if (pretty && hasbody == 0)
+                    cbuf_append(cb, '\n');
             }
             xc = NULL;
             while ((xc = xml_child_each(x, xc, -1)) != NULL) {
@@ -347,10 +354,13 @@ xml2file_recurse(FILE                *f,
                         xa = xml_find_type(xc, IETF_NETCONF_WITH_DEFAULTS_ATTR_PREFIX, IETF_NETCONF_WITH_DEFAULTS_ATTR_NAMESPACE, CX_ATTR);
                     }
                 }
-                if (xml_type(xc) != CX_ATTR && !subfile)
-                        if (xml2file_recurse(f, xc, level+1, pretty, prefix,
-                                             fn, autocliext, wdef, multi) <0)
-                            goto done;
+                if (xml_type(xc) != CX_ATTR && !subfile){
+                    if (xml2file_recurse(fo, xc, level+1, pretty, prefix,
+                                         autocliext, wdef, multi) <0)
+                        goto done;
+                    if (clicon_file_out_check(fo) < 0)
+                        goto done;
+                }
                 if (xa){
                     if (xml_purge(xa) < 0)
                         goto done;
@@ -358,19 +368,22 @@ xml2file_recurse(FILE                *f,
             }
             if (subfile == 0){
                 if (pretty && hasbody==0){
-                    if (pretty && prefix)
-                        (*fn)(f, "%s", prefix);
-                    (*fn)(f, "%*s", level1, "");
+                    if (prefix)
+                        cbuf_append_str(cb, prefix);
+                    if (clixon_cbuf_indent(cb, abs(level1)) < 0)
+                        goto done;
+                }
+                cbuf_append_str(cb, "</");
+                if (namespace){
+                    cbuf_append_str(cb, namespace);
+                    cbuf_append(cb, ':');
                 }
-                (*fn)(f, "</");
-                if (namespace)
-                    (*fn)(f, "%s:", namespace);
-                (*fn)(f, "%s>", name);
+                cbuf_append_str(cb, name);
+                cbuf_append(cb, '>');
             }
         }
-        if (pretty){
-            (*fn)(f, "\n");
-        }
+        if (pretty)
+            cbuf_append(cb, '\n');
         break;
     default:
         break;
@@ -378,8 +391,6 @@ xml2file_recurse(FILE                *f,
  ok:
     retval = 0;
  done:
-    if (encstr)
-        free(encstr);
     if (xpath)
         free(xpath);
     if (hexstr)
@@ -419,23 +430,30 @@ clixon_xml2file1(FILE                *f,
                  withdefaults_type    wdef,
                  int                  multi)
 {
-    int   retval = 1;
-    cxobj *xc;
+    int             retval = 1;
+    cxobj          *xc;
+    clicon_file_out fo = {0,};
 
-    if (fn == NULL)
-        fn = fprintf;
+    if (clicon_file_out_init(&fo, f, fn) < 0)
+        goto done;
     if (skiptop){
         xc = NULL;
-        while ((xc = xml_child_each(xn, xc, CX_ELMNT)) != NULL)
-            if (xml2file_recurse(f, xc, level, pretty, prefix, fn, autocliext, wdef, multi) < 0)
+        while ((xc = xml_child_each(xn, xc, CX_ELMNT)) != NULL){
+            if (xml2file_recurse(&fo, xc, level, pretty, prefix, autocliext, wdef, multi) < 0)
+                goto done;
+            if (clicon_file_out_check(&fo) < 0)
                 goto done;
+        }
     }
     else {
-        if (xml2file_recurse(f, xn, level, pretty, prefix, fn, autocliext, wdef, multi) < 0)
+        if (xml2file_recurse(&fo, xn, level, pretty, prefix, autocliext, wdef, multi) < 0)
             goto done;
     }
+    if (clicon_file_out_flush(fo.fo_cb, &fo) < 0)
+        goto done;
     retval = 0;
  done:
+    clicon_file_out_free(&fo);
     return retval;
 }
 
@@ -482,7 +500,7 @@ int
 xml_print(FILE  *f,
           cxobj *x)
 {
-    return xml2file_recurse(f, x, 0, 1, NULL, fprintf, 0, WITHDEFAULTS_REPORT_ALL, 0);
+    return clixon_xml2file1(f, x, 0, 1, NULL, fprintf, 0, 0, WITHDEFAULTS_REPORT_ALL, 0);
 }
 
 /*! Dump cxobj structure with pointers and flags for debugging, internal function
@@ -548,6 +566,16 @@ xml_dump(FILE  *f,
  * - WITHDEFAULTS_REPORT_ALL_TAGGED
  * @see xml2file_recurse  same with FILE
  */
+/*! Flush state of streaming serialization
+ *
+ * @see clixon_xml2cbuf_stream
+ */
+struct xml_flush {
+    size_t               fl_size; /* Flush when output exceeds this size */
+    clixon_xml_flush_cb *fl_fn;   /* Flush callback */
+    void                *fl_arg;  /* Flush callback argument */
+};
+
 static int
 xml2cbuf_recurse(cbuf             *cb,
                  cxobj            *x,
@@ -555,7 +583,8 @@ xml2cbuf_recurse(cbuf             *cb,
                  int               pretty,
                  char             *prefix,
                  int32_t           depth,
-                 withdefaults_type wdef)
+                 withdefaults_type wdef,
+                 struct xml_flush *fl)
 {
     int        retval = -1;
     cxobj     *xc;
@@ -587,7 +616,9 @@ xml2cbuf_recurse(cbuf             *cb,
     case CX_BODY:
         if ((val = xml_value(x)) == NULL) /* incomplete tree */
             break;
-        if (xml_chardata_cbuf_append(cb, 0, val) < 0)
+        if (xml_opaque_raw(x))
+            cbuf_append_str(cb, val);
+        else if (xml_chardata_cbuf_append(cb, 0, val) < 0)
             goto done;
         break;
     case CX_ATTR:
@@ -601,11 +632,11 @@ xml2cbuf_recurse(cbuf             *cb,
     case CX_ELMNT:
         if (pretty){
             if (prefix)
-                cprintf(cb, "%s", prefix);
-            cprintf(cb, "%*s<", level1, "");
+                cbuf_append_str(cb, prefix);
+            if (clixon_cbuf_indent(cb, abs(level1)) < 0) /* As "%*s" */
+                goto done;
         }
-        else
-            cbuf_append_str(cb, "<");
+        cbuf_append(cb, '<');
         if (namespace){
             cbuf_append_str(cb, namespace);
             cbuf_append_str(cb, ":");
@@ -620,7 +651,7 @@ xml2cbuf_recurse(cbuf             *cb,
         while ((xc = xml_child_each(x, xc, -1)) != NULL)
             switch (xml_type(xc)){
             case CX_ATTR:
-                if (xml2cbuf_recurse(cb, xc, level+1, pretty, prefix, -1, wdef) < 0)
+                if (xml2cbuf_recurse(cb, xc, level+1, pretty, prefix, -1, wdef, NULL) < 0)
                     goto done;
                 break;
             case CX_BODY:
@@ -657,17 +688,23 @@ xml2cbuf_recurse(cbuf             *cb,
                             xa = xml_find_type(xc, IETF_NETCONF_WITH_DEFAULTS_ATTR_PREFIX, IETF_NETCONF_WITH_DEFAULTS_ATTR_NAMESPACE, CX_ATTR);
                         }
                     }
-                    if (xml2cbuf_recurse(cb, xc, level+1, pretty, prefix, depth-1, wdef) < 0)
+                    if (xml2cbuf_recurse(cb, xc, level+1, pretty, prefix, depth-1, wdef, fl) < 0)
                         goto done;
                     if (xa){
                         if (xml_purge(xa) < 0)
                             goto done;
                     }
+                    if (fl && cbuf_len(cb) >= fl->fl_size){
+                        if (fl->fl_fn(cb, fl->fl_arg) < 0)
+                            goto done;
+                        cbuf_reset(cb);
+                    }
                 }
             if (pretty && hasbody == 0){
                 if (prefix)
-                    cprintf(cb, "%s", prefix);
-                cprintf(cb, "%*s", level1, "");
+                    cbuf_append_str(cb, prefix);
+                if (clixon_cbuf_indent(cb, abs(level1)) < 0)
+                    goto done;
             }
             cbuf_append_str(cb, "</");
             if (namespace){
@@ -728,11 +765,11 @@ clixon_xml2cbuf1(cbuf                *cb,
     if (skiptop){
         xc = NULL;
         while ((xc = xml_child_each(xn, xc, CX_ELMNT)) != NULL)
-            if (xml2cbuf_recurse(cb, xc, level, pretty, prefix, depth, wdef) < 0)
+            if (xml2cbuf_recurse(cb, xc, level, pretty, prefix, depth, wdef, NULL) < 0)
                 goto done;
     }
     else {
-        if (xml2cbuf_recurse(cb, xn, level, pretty, prefix, depth, wdef) < 0)
+        if (xml2cbuf_recurse(cb, xn, level, pretty, prefix, depth, wdef, NULL) < 0)
             goto done;
     }
     retval = 0;
@@ -774,6 +811,177 @@ clixon_xml2cbuf(cbuf   *cb,
     return clixon_xml2cbuf1(cb, xn, level, pretty, prefix, depth, skiptop, 0);
 }
 
+/*! Print an XML tree to a cligen buffer and flush the buffer while serializing
+ *
+ * Serializes as clixon_xml2cbuf1, but whenever the buffer exceeds size after a child
+ * element, the flush callback is called and the buffer is reset.
+ * The output is thereby bounded regardless of tree size, eg for sending large
+ * replies in chunks. Output remaining after the tree is left in cb.
+ * @param[in,out] cb      Cligen buffer to write to
+ * @param[in]     xn      Top-level xml object
+ * @param[in]     pretty  Insert \n and spaces to make the xml more readable.
+ * @param[in]     depth   Limit levels of child resources: -1: all, 0: none, 1: node itself
+ * @param[in]     skiptop 0: Include top object 1: Skip top-object, only children,
+ * @param[in]     wdef    With-defaults parameter, default is WITHDEFAULTS_REPORT_ALL
+ * @param[in]     size    Flush when buffer exceeds this size
+ * @param[in]     fn      Flush callback
+ * @param[in]     arg     Flush callback argument
+ * @retval        0       OK
+ * @retval       -1       Error
+ * @see clixon_xml2cbuf1
+ */
+int
+clixon_xml2cbuf_stream(cbuf                *cb,
+                       cxobj               *xn,
+                       int                  pretty,
+                       int32_t              depth,
+                       int                  skiptop,
+                       withdefaults_type    wdef,
+                       size_t               size,
+                       clixon_xml_flush_cb *fn,
+                       void                *arg)
+{
+    int              retval = -1;
+    cxobj           *xc;
+    struct xml_flush fl = {size, fn, arg};
+
+    if (skiptop){
+        xc = NULL;
+        while ((xc = xml_child_each(xn, xc, CX_ELMNT)) != NULL)
+            if (xml2cbuf_recurse(cb, xc, 0, pretty, NULL, depth, wdef, &fl) < 0)
+                goto done;
+    }
+    else {
+        if (xml2cbuf_recurse(cb, xn, 0, pretty, NULL, depth, wdef, &fl) < 0)
+            goto done;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Print a node of a view of an XML tree, see clixon_xml2cbuf_view
+ */
+static int
+xml2cbuf_view_recurse(cbuf             *cb,
+                      cxobj            *x,
+                      int32_t           depth,
+                      withdefaults_type wdef,
+                      struct xml_flush *fl)
+{
+    int        retval = -1;
+    cxobj     *xc;
+    char      *prefix;
+    yang_stmt *y;
+    int        islist;
+    int        tag = 0;
+    int        ret;
+
+    if (depth == 0)
+        goto ok;
+    if (xml_flag(x, XML_FLAG_MARK))
+        return xml2cbuf_recurse(cb, x, 0, 0, NULL, depth, wdef, fl);
+    if ((y = xml_spec(x)) != NULL){
+        if ((ret = xml2output_wdef(x, wdef, &tag)) < 0)
+            goto done;
+        if (ret == 0)
+            goto ok;
+    }
+    islist = y && yang_keyword_get(y) == Y_LIST;
+    prefix = xml_prefix(x);
+    cbuf_append(cb, '<');
+    if (prefix){
+        cbuf_append_str(cb, prefix);
+        cbuf_append_str(cb, ":");
+    }
+    cbuf_append_str(cb, xml_name(x));
+    xc = NULL;
+    while ((xc = xml_child_each_attr(x, xc)) != NULL)
+        if (xml2cbuf_recurse(cb, xc, 0, 0, NULL, -1, wdef, NULL) < 0)
+            goto done;
+    cbuf_append_str(cb, ">");
+    /* Marked children and their ancestors, and keys of lists as xml_copy_marked */
+    xc = NULL;
+    while ((xc = xml_child_each(x, xc, CX_ELMNT)) != NULL){
+        if (xml_flag(xc, XML_FLAG_MARK|XML_FLAG_CHANGE)){
+            if (xml2cbuf_view_recurse(cb, xc, depth-1, wdef, fl) < 0)
+                goto done;
+        }
+        else if (islist){
+            if ((ret = yang_key_match(y, xml_name(xc), NULL)) < 0)
+                goto done;
+            if (ret && xml2cbuf_recurse(cb, xc, 0, 0, NULL, depth-1, wdef, fl) < 0)
+                goto done;
+        }
+        if (fl && cbuf_len(cb) >= fl->fl_size){
+            if (fl->fl_fn(cb, fl->fl_arg) < 0)
+                goto done;
+            cbuf_reset(cb);
+        }
+    }
+    cbuf_append_str(cb, "</");
+    if (prefix){
+        cbuf_append_str(cb, prefix);
+        cbuf_append_str(cb, ":");
+    }
+    cbuf_append_str(cb, xml_name(x));
+    cbuf_append_str(cb, ">");
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Print a view of an XML tree consisting of marked nodes and their ancestors
+ *
+ * Prints the children of xn as clixon_xml2cbuf1 would print a copy made by xml_copy_marked,
+ * but without copying: nodes with XML_FLAG_MARK are printed with their subtrees, and nodes
+ * with XML_FLAG_CHANGE (ancestors of marked nodes) with their attributes, list keys and
+ * flagged children. The tree is not modified.
+ * @param[in,out] cb      Cligen buffer to write to
+ * @param[in]     xn      Top-level xml object, not printed
+ * @param[in]     depth   Limit levels of child resources: -1: all, 0: none, 1: node itself
+ * @param[in]     wdef    With-defaults parameter, except WITHDEFAULTS_REPORT_ALL_TAGGED
+ * @param[in]     size    Flush when buffer exceeds this size, if fn is set
+ * @param[in]     fn      Flush callback, or NULL
+ * @param[in]     arg     Flush callback argument
+ * @retval        0       OK
+ * @retval       -1       Error
+ * @see xmldb_get0_view
+ */
+int
+clixon_xml2cbuf_view(cbuf                *cb,
+                     cxobj               *xn,
+                     int32_t              depth,
+                     withdefaults_type    wdef,
+                     size_t               size,
+                     clixon_xml_flush_cb *fn,
+                     void                *arg)
+{
+    int              retval = -1;
+    cxobj           *xc;
+    struct xml_flush fl = {size, fn, arg};
+
+    if (wdef == WITHDEFAULTS_REPORT_ALL_TAGGED){
+        clixon_err(OE_XML, EINVAL, "report-all-tagged not supported in view");
+        goto done;
+    }
+    xc = NULL;
+    while ((xc = xml_child_each(xn, xc, CX_ELMNT)) != NULL){
+        if (xml_flag(xn, XML_FLAG_MARK)){
+            if (xml2cbuf_recurse(cb, xc, 0, 0, NULL, depth, wdef, fn?&fl:NULL) < 0)
+                goto done;
+        }
+        else if (xml_flag(xc, XML_FLAG_MARK|XML_FLAG_CHANGE)){
+            if (xml2cbuf_view_recurse(cb, xc, depth, wdef, fn?&fl:NULL) < 0)
+                goto done;
+        }
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Print actual xml tree datastructures (not xml), mainly for debugging
  *
  * @param[in,out] cb          Cligen buffer to write to
@@ -817,10 +1025,33 @@ xmltree2cbuf(cbuf  *cb,
 /*--------------------------------------------------------------------
  * XML parsing functions. Create XML parse tree from string and file.
  *--------------------------------------------------------------------*/
+/*! Set XML parser
+ *
+ * Cant use option since there is no handle in xml parse functions
+ * @param[in]  mode   XML parser, see enum xml_parser_mode
+ * @retval     0      OK
+ */
+int
+xml_parser_mode_set(int mode)
+{
+    _xml_parser_mode = mode;
+    return 0;
+}
+
+/*! Get XML parser
+ */
+int
+xml_parser_mode_get(void)
+{
+    return _xml_parser_mode;
+}
+
 /*! Common internal xml parsing function string to parse-tree
  *
  * Given a string containing XML, parse into existing XML tree and return
  * @param[in]     str   Pointer to string containing XML definition.
+ * @param[in]     len   If > 0, str is a writable buffer of len characters followed by two null
+ *                      characters that is scanned in place, see clicon_file_buf
  * @param[in]     yb    How to bind yang to XML top-level when parsing
  * @param[in]     yspec Yang specification (only if bind is TOP or CONFIG)
  * @param[in,out] xtop  Top of XML parse tree. Assume created. Holds new tree.
@@ -831,6 +1062,7 @@ xmltree2cbuf(cbuf  *cb,
  * @see clixon_xml_parse_file
  * @see clixon_xml_parse_string
  * @see _json_parse
+ * @see clixon_xml_scan  used instead of the bison parser if CLICON_XML_PARSER is fast
  * @note special case is empty XML where the parser is not invoked.
  * It is questionable empty XML is legal. From https://www.w3.org/TR/2008/REC-xml-20081126 Sec 2.1:
  *    A well-formed document ... contains one or more elements.
@@ -845,6 +1077,7 @@ xmltree2cbuf(cbuf  *cb,
  */
 static int
 _xml_parse(const char *str,
+           size_t      len,
            yang_bind   yb,
            yang_stmt  *yspec,
            cxobj      *xt,
@@ -858,24 +1091,29 @@ _xml_parse(const char *str,
     int             i;
 
     clixon_debug(CLIXON_DBG_PARSE, "%s", str);
-    if (strlen(str) == 0){
+    if (len == 0 && strlen(str) == 0){
         return 1; /* OK */
     }
     if (xt == NULL){
         clixon_err(OE_XML, errno, "Unexpected NULL XML");
         return -1;
     }
-    if ((xy.xy_parse_string = strdup(str)) == NULL){
-        clixon_err(OE_XML, errno, "strdup");
-        return -1;
-    }
+    /* The lexer copies the string, unless it is a buffer scanned in place */
+    xy.xy_parse_string = (char*)str;
+    xy.xy_parse_len = len;
     xy.xy_xtop = xt;
     xy.xy_xparent = xt;
     xy.xy_yspec = yspec;
-    if (clixon_xml_parsel_init(&xy) < 0)
-        goto done;
-    if (clixon_xml_parseparse(&xy) != 0)  /* yacc returns 1 on error */
-        goto done;
+    if (_xml_parser_mode == XML_PARSER_FAST){
+        if (clixon_xml_scan(&xy) < 0)
+            goto done;
+    }
+    else {
+        if (clixon_xml_parsel_init(&xy) < 0)
+            goto done;
+        if (clixon_xml_parseparse(&xy) != 0)  /* yacc returns 1 on error */
+            goto done;
+    }
     /* Purge all top-level body objects */
     x = NULL;
     while ((x = xml_find_type(xt, NULL, "body", CX_BODY)) != NULL)
@@ -936,9 +1174,8 @@ _xml_parse(const char *str,
     retval = 1;
  done:
     clixon_debug(CLIXON_DBG_PARSE, "retval:%d", retval);
-    clixon_xml_parsel_exit(&xy);
-    if (xy.xy_parse_string != NULL)
-        free(xy.xy_parse_string);
+    if (xy.xy_lexbuf)
+        clixon_xml_parsel_exit(&xy);
     if (xy.xy_xvec)
         free(xy.xy_xvec);
     return retval;
@@ -972,6 +1209,7 @@ _xml_parse(const char *str,
  * @see clixon_json_parse_file
  * @note, If xt empty, a top-level symbol will be added so that <tree../> will be:  <top><tree.../></tree></top>
  * @note May block on file I/O
+ * @note Tree is allocated from XML arena if enabled, see xml_arena_enable
  */
 int
 clixon_xml_parse_file(FILE      *fp,
@@ -980,16 +1218,13 @@ clixon_xml_parse_file(FILE      *fp,
                       cxobj    **xt,
                       cxobj    **xerr)
 {
-    int   retval = -1;
-    int   ret;
-    int   len = 0;
-    char  ch;
-    char *xmlbuf = NULL;
-    char *ptr;
-    int   xmlbuflen = BUFLEN; /* start size */
-    int   oldxmlbuflen;
-    int   failed = 0;
-    int   xtempty; /* empty on entry */
+    int    retval = -1;
+    int    ret;
+    char  *xmlbuf = NULL;
+    size_t len = 0;
+    size_t maplen = 0;
+    int    failed = 0;
+    int    xtempty; /* empty on entry */
 
     if (xt == NULL || fp == NULL){
         clixon_err(OE_XML, EINVAL, "arg is NULL");
@@ -1000,49 +1235,204 @@ clixon_xml_parse_file(FILE      *fp,
         clixon_err(OE_XML, EINVAL, "yspec is required if yb == YB_MODULE");
         return -1;
     }
-    if ((xmlbuf = malloc(xmlbuflen)) == NULL){
-        clixon_err(OE_XML, errno, "malloc");
+    xml_arena_push();
+    /* Map or read file in one go and scan it in place */
+    if (clicon_file_buf(fp, &xmlbuf, &len, &maplen) < 0)
         goto done;
-    }
-    memset(xmlbuf, 0, xmlbuflen);
-    ptr = xmlbuf;
-    while (1){
-        if ((ret = fread(&ch, 1, 1, fp)) < 0){
-            clixon_err(OE_XML, errno, "read");
-            break;
-        }
-        if (ret != 0){
-            xmlbuf[len++] = ch;
-        }
-        if (ret == 0) {
-            if (*xt == NULL)
-                if ((*xt = xml_new(XML_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
-                    goto done;
-            if ((ret = _xml_parse(ptr, yb, yspec, *xt, xerr)) < 0)
-                goto done;
-            if (ret == 0)
-                failed++;
-            break;
-        }
-        if (len >= xmlbuflen-1){ /* Space: one for the null character */
-            oldxmlbuflen = xmlbuflen;
-            xmlbuflen *= 2;
-            if ((xmlbuf = realloc(xmlbuf, xmlbuflen)) == NULL){
-                clixon_err(OE_XML, errno, "realloc");
-                goto done;
-            }
-            memset(xmlbuf+oldxmlbuflen, 0, xmlbuflen-oldxmlbuflen);
-            ptr = xmlbuf;
-        }
-    } /* while */
+    if (*xt == NULL)
+        if ((*xt = xml_new(XML_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
+            goto done;
+    if ((ret = _xml_parse(xmlbuf, len, yb, yspec, *xt, xerr)) < 0)
+        goto done;
+    if (ret == 0)
+        failed++;
     retval = (failed==0) ? 1 : 0;
  done:
     if (retval < 0 && *xt && xtempty){
-        free(*xt);
+        xml_free(*xt);
         *xt = NULL;
     }
-    if (xmlbuf)
-        free(xmlbuf);
+    xml_arena_pop();
+    clicon_file_buf_free(xmlbuf, maplen);
+    return retval;
+}
+
+/*! State of streaming parse
+ *
+ * @see clixon_xml_parse_file_stream
+ */
+typedef struct {
+    cxobj               *xs_xtop;     /* Top of parse tree */
+    yang_stmt           *xs_yspec;    /* Top-level yang spec */
+    int                  xs_defaults; /* Fill in default values */
+    clixon_xml_entry_cb *xs_fn;       /* Entry callback, or NULL */
+    void                *xs_arg;      /* Entry callback argument */
+    cxobj              **xs_xerr;     /* Reason for failure */
+    int                  xs_failed;   /* Binding or entry callback failed */
+} xml_stream_t;
+
+/*! Streaming parse start-element callback: bind yang to the new element
+ *
+ * The element below the top is the wrapper, eg <config>, and is not bound. Its children are
+ * bound as module top-level nodes and other elements from their parent.
+ * @see xml_bind_yang_node
+ */
+static int
+xml_stream_start(cxobj *x,
+                 void  *arg)
+{
+    xml_stream_t *xs = (xml_stream_t *)arg;
+    cxobj        *xp;
+    int           ret;
+
+    if ((xp = xml_parent(x)) == xs->xs_xtop)
+        return 0;
+    if (xml_parent(xp) == xs->xs_xtop)
+        ret = xml_bind_yang_node(NULL, x, YB_MODULE, xs->xs_yspec, xs->xs_xerr);
+    else if (xml_spec(xp) == NULL) /* Below anydata */
+        return 0;
+    else
+        ret = xml_bind_yang_node(NULL, x, YB_PARENT, xs->xs_yspec, xs->xs_xerr);
+    if (ret < 0)
+        return -1;
+    if (ret == 0){
+        xs->xs_failed++;
+        return 1;
+    }
+    return 0;
+}
+
+/*! Streaming parse end-element callback: complete the element and hand over list entries
+ *
+ * The subtree of the element is complete: remove body of list or container, add defaults and
+ * sort its children. A top-most list entry is then given to the entry callback.
+ */
+static int
+xml_stream_end(cxobj *x,
+               void  *arg)
+{
+    xml_stream_t *xs = (xml_stream_t *)arg;
+    yang_stmt    *y;
+    cxobj        *xb;
+    cxobj        *xa;
+    int           ret;
+
+    if ((y = xml_spec(x)) == NULL)
+        return 0;
+    if (yang_keyword_get(y) != Y_LIST && yang_keyword_get(y) != Y_CONTAINER)
+        return 0;
+    if ((xb = xml_body_get(x)) != NULL && xml_purge(xb) < 0)
+        return -1;
+    if (xs->xs_defaults && xml_default_node(x, 0) < 0)
+        return -1;
+    if (xml_sort(x) < 0)
+        return -1;
+    if (xs->xs_fn == NULL || yang_keyword_get(y) != Y_LIST)
+        return 0;
+    /* Only top-most list entries, nested lists are part of their entry */
+    xa = x;
+    while ((xa = xml_parent(xa)) != NULL)
+        if ((y = xml_spec(xa)) != NULL && yang_keyword_get(y) == Y_LIST)
+            return 0;
+    if ((ret = xs->xs_fn(x, xs->xs_arg)) < 0)
+        return -1;
+    if (ret == 0){
+        xs->xs_failed++;
+        return 1;
+    }
+    return ret == 2 ? 2 : 0;
+}
+
+/*! Read an XML file and parse it as a stream with incremental yang binding
+ *
+ * Each element is bound to yang as soon as its start tag is parsed, and is completed as soon
+ * as its end tag is parsed: defaults are optionally added and its children are sorted.
+ * Each completed top-most list entry is given to the callback fn, which may consume it. It is
+ * then freed so that the tree never holds more than one entry with its ancestors, and a
+ * consumer that applies entries to a datastore can import a large file with bounded memory.
+ * The remaining tree, without consumed entries, is returned in xt.
+ * The file has a wrapper element, eg <config>, as datastore files and edit-config payloads.
+ * The file is mapped and not copied, see clicon_file_buf.
+ * @param[in]     fp       File containing XML
+ * @param[in]     yspec    Yang specification
+ * @param[in]     defaults If set, fill in default values
+ * @param[in]     fn       Entry callback, or NULL
+ * @param[in]     arg      Entry callback argument
+ * @param[out]    xt       XML parse tree, free with xml_free
+ * @param[out]    xerr     Pointer to XML error tree, if retval is 0
+ * @retval        1        Parse OK and all yang assignment made
+ * @retval        0        Yang assigment not made and xerr set, or entry callback failed
+ * @retval       -1        Error
+ * @code
+ *  if ((ret = clixon_xml_parse_file_stream(f, yspec, 1, entry_cb, arg, &xt, &xerr)) < 0)
+ *    err;
+ * @endcode
+ * @note The hand-written scanner is always used regardless of CLICON_XML_PARSER
+ * @note Not allocated from the XML arena since consumed entries are freed
+ * @note Schema mount-points are not bound
+ * @see clixon_xml_parse_file  Parses the whole file first and binds afterwards
+ */
+int
+clixon_xml_parse_file_stream(FILE                *fp,
+                             yang_stmt           *yspec,
+                             int                  defaults,
+                             clixon_xml_entry_cb *fn,
+                             void                *arg,
+                             cxobj              **xt,
+                             cxobj              **xerr)
+{
+    int             retval = -1;
+    clixon_xml_yacc xy = {0,};
+    xml_stream_t    xs = {0,};
+    char           *xmlbuf = NULL;
+    size_t          len = 0;
+    size_t          maplen = 0;
+    cxobj          *x;
+
+    if (xt == NULL || fp == NULL || yspec == NULL){
+        clixon_err(OE_XML, EINVAL, "arg is NULL");
+        return -1;
+    }
+    if (clicon_file_buf(fp, &xmlbuf, &len, &maplen) < 0)
+        goto done;
+    if ((*xt = xml_new(XML_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
+        goto done;
+    if (len == 0){
+        retval = 1;
+        goto done;
+    }
+    xs.xs_xtop = *xt;
+    xs.xs_yspec = yspec;
+    xs.xs_defaults = defaults;
+    xs.xs_fn = fn;
+    xs.xs_arg = arg;
+    xs.xs_xerr = xerr;
+    xy.xy_parse_string = xmlbuf;
+    xy.xy_parse_len = len;
+    xy.xy_xtop = *xt;
+    xy.xy_xparent = *xt;
+    xy.xy_yspec = yspec;
+    xy.xy_start = xml_stream_start;
+    xy.xy_end = xml_stream_end;
+    xy.xy_cbarg = &xs;
+    if (clixon_xml_scan(&xy) < 0)
+        goto done;
+    if (xs.xs_failed){
+        retval = 0;
+        goto done;
+    }
+    /* Purge all top-level body objects */
+    while ((x = xml_find_type(*xt, NULL, "body", CX_BODY)) != NULL)
+        xml_purge(x);
+    retval = 1;
+ done:
+    if (retval < 0 && *xt){
+        xml_free(*xt);
+        *xt = NULL;
+    }
+    if (xy.xy_xvec)
+        free(xy.xy_xvec);
+    clicon_file_buf_free(xmlbuf, maplen);
     return retval;
 }
 
@@ -1091,7 +1481,7 @@ clixon_xml_parse_string(const char *str,
         if ((*xt = xml_new(XML_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
             return -1;
     }
-    return _xml_parse(str, yb, yspec, *xt, xerr);
+    return _xml_parse(str, 0, yb, yspec, *xt, xerr);
 }
 
 /*! Read XML from var-arg list and parse it into xml tree
@@ -1184,6 +1574,135 @@ clixon_xml_attr_copy(cxobj *xin,
     return retval;
 }
 
+/*! Check if XML body is raw XML content of an anydata or anyxml node
+ *
+ * @param[in]  xb   XML body
+ * @retval     1    Yes, the body is printed verbatim
+ * @retval     0    No, regular character data
+ * @see xml_opaque_make
+ */
+int
+xml_opaque_raw(cxobj *xb)
+{
+    cxobj *xp;
+
+    return (xp = xml_parent(xb)) != NULL && xml_flag(xp, XML_FLAG_OPAQUE);
+}
+
+/*! Declare prefixes used in anydata content on the anydata node itself
+ *
+ * So that the raw content is self-contained together with the anydata node
+ * @param[in]  xn   XML element in anydata content
+ * @param[in]  arg  Anydata node
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+xml_opaque_ns_applyfn(cxobj *xn,
+                      void  *arg)
+{
+    cxobj *x = (cxobj *)arg;
+    cxobj *xp;
+    char  *prefix;
+    char  *ns = NULL;
+
+    if ((prefix = xml_prefix(xn)) == NULL)
+        return 0;
+    for (xp = xn; xp != NULL; xp = xml_parent(xp)){
+        if (xml_find_type(xp, "xmlns", prefix, CX_ATTR) != NULL)
+            return 0;
+        if (xp == x)
+            break;
+    }
+    if (xml2ns(x, prefix, &ns) < 0)
+        return -1;
+    if (ns && xmlns_set(x, prefix, ns) < 0)
+        return -1;
+    return 0;
+}
+
+/*! Replace content of anydata or anyxml node with a single raw XML body
+ *
+ * The content is then stored, copied and serialized as XML as one string, and only
+ * parsed again when a tree traversal descends into the node, see xml_lazy_load.
+ * Prefixes declared above the node and used in the content are declared on the node.
+ * A node with only character data is left as is.
+ * @param[in]  x    Anydata or anyxml XML node
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see xml_opaque_expand
+ * @see CLICON_XMLDB_ANYDATA_OPAQUE
+ */
+int
+xml_opaque_make(cxobj *x)
+{
+    int    retval = -1;
+    cbuf  *cb = NULL;
+    cxobj *xc;
+    cxobj *xb;
+    int    i;
+
+    if (xml_flag(x, XML_FLAG_OPAQUE) || xml_child_nr_type(x, CX_ELMNT) == 0)
+        goto ok;
+    if (xml_apply(x, CX_ELMNT, xml_opaque_ns_applyfn, x) < 0)
+        goto done;
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    xc = NULL;
+    while ((xc = xml_child_each(x, xc, CX_ERROR)) != NULL)
+        if (xml_type(xc) != CX_ATTR &&
+            clixon_xml2cbuf(cb, xc, 0, 0, NULL, -1, 0) < 0)
+            goto done;
+    i = 0;
+    while ((xc = xml_child_i(x, i)) != NULL){
+        if (xml_type(xc) == CX_ATTR)
+            i++;
+        else if (xml_purge(xc) < 0)
+            goto done;
+    }
+    if ((xb = xml_new("body", x, CX_BODY)) == NULL)
+        goto done;
+    if (xml_value_set(xb, cbuf_get(cb)) < 0)
+        goto done;
+    xml_flag_set(x, XML_FLAG_OPAQUE);
+ ok:
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Parse raw XML content of anydata or anyxml node into XML children
+ *
+ * The content is parsed in place so that namespaces are resolved from the ancestors
+ * @param[in]  x    XML node made by xml_opaque_make, otherwise no-op
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see xml_opaque_make
+ */
+int
+xml_opaque_expand(cxobj *x)
+{
+    int    retval = -1;
+    cxobj *xb;
+
+    if (!xml_flag(x, XML_FLAG_OPAQUE))
+        goto ok;
+    xml_flag_reset(x, XML_FLAG_OPAQUE);
+    if ((xb = xml_body_get(x)) == NULL)
+        goto ok;
+    /* Top-level bodies, ie xb, are purged after parsing */
+    if (_xml_parse(xml_value(xb), 0, YB_NONE, NULL, x, NULL) < 0)
+        goto done;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Print list keys
  */
 static int
@@ -91,10 +91,32 @@ typedef struct  {
     cxobj     *mt_x0c;
     cxobj     *mt_x1c;
     yang_stmt *mt_yc;
+    int        mt_pos;  /* Sorted position of x1c in base if no x0c, or -1 */
 } merge_twophase;
 
+/* Cursor for linear matching of a sorted run of list or leaf-list entries in the
+ * modification tree against the same, sorted, entries in the base tree.
+ */
+typedef struct {
+    yang_stmt *mc_yc;     /* Yang spec of current run, or NULL */
+    int        mc_sorted; /* Run and base entries are sorted so far */
+    int        mc_pos;    /* Next base child to compare */
+    int        mc_hi;     /* Index after last base child with yang spec mc_yc */
+    cxobj     *mc_prev;   /* Previous modification child in run */
+} merge_cursor;
+
+/* Size of cache of cl:ignore-compare extension lookups during one diff, see ignore_compare */
+#define IGNORE_COMPARE_CACHE 64
+
+/* Cached result of cl:ignore-compare extension lookup of one yang node */
+typedef struct {
+    yang_stmt *ic_ys;     /* Yang node, or NULL */
+    int        ic_ignore; /* Yang node has cl:ignore-compare extension */
+} ignore_compare_cache;
+
 /* Forward declaration */
-static int xml_diff1(cxobj *x0, cxobj *x1, cxobj ***x0vec, int *x0veclen,
+static int xml_diff1(cxobj *x0, cxobj *x1, int flag, ignore_compare_cache *icc,
+                     cxobj ***x0vec, int *x0veclen,
                      cxobj ***x1vec, int *x1veclen,
                      cxobj ***changed_x0, cxobj ***changed_x1, int *changedlen);
 
@@ -281,6 +303,92 @@ cvec2xml_1(cvec   *cvv,
     return retval;
 }
 
+/*! Get key values of a list or leaf-list entry
+ *
+ * @param[in]  x     List or leaf-list entry
+ * @param[in]  y     Yang spec of x
+ * @param[out] cvp   Vector of key values in key order, named by key. Free with cvec_free()
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see xmldb_get_page  where key values are used as list pagination cursors
+ */
+int
+xml_key_values(cxobj     *x,
+               yang_stmt *y,
+               cvec     **cvp)
+{
+    int     retval = -1;
+    cvec   *cvv = NULL;
+    cvec   *cvk;
+    cg_var *cvi = NULL;
+    cg_var *cv;
+    char   *keyname;
+    char   *val;
+
+    if ((cvv = cvec_new(0)) == NULL){
+        clixon_err(OE_UNIX, errno, "cvec_new");
+        goto done;
+    }
+    cvk = yang_keyword_get(y) == Y_LIST ? yang_cvec_get(y) : NULL;
+    do {
+        if (cvk){
+            if ((cvi = cvec_each(cvk, cvi)) == NULL)
+                break;
+            keyname = cv_string_get(cvi);
+            val = xml_find_body(x, keyname);
+        }
+        else {
+            keyname = xml_name(x);
+            val = xml_body(x);
+        }
+        if ((cv = cvec_add(cvv, CGV_STRING)) == NULL){
+            clixon_err(OE_UNIX, errno, "cvec_add");
+            goto done;
+        }
+        if (cv_name_set(cv, keyname) == NULL ||
+            cv_string_set(cv, val?val:"") == NULL){
+            clixon_err(OE_UNIX, errno, "cv_string_set");
+            goto done;
+        }
+    } while (cvk);
+    *cvp = cvv;
+    cvv = NULL;
+    retval = 0;
+ done:
+    if (cvv)
+        cvec_free(cvv);
+    return retval;
+}
+
+/*! Check if yang node has the cl:ignore-compare extension, using a lookup cache
+ *
+ * Diff and compare check the extension for every node in both trees. The yang lookup
+ * allocates a buffer and walks all yang children. Most nodes are list entries with the
+ * same yang as the previous, so a small cache of the results is enough.
+ * @param[in]  ys      Yang node
+ * @param[in]  icc     Cache with IGNORE_COMPARE_CACHE entries, zeroed before first call
+ * @param[out] extflag Set to 1 if yang node has the extension, 0 otherwise
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+ignore_compare(yang_stmt            *ys,
+               ignore_compare_cache *icc,
+               int                  *extflag)
+{
+    ignore_compare_cache *ic;
+
+    ic = &icc[((uintptr_t)ys >> 4) % IGNORE_COMPARE_CACHE];
+    if (ic->ic_ys != ys){
+        ic->ic_ys = NULL;
+        if (yang_extension_value(ys, "ignore-compare", CLIXON_LIB_NS, &ic->ic_ignore, NULL) < 0)
+            return -1;
+        ic->ic_ys = ys;
+    }
+    *extflag = ic->ic_ignore;
+    return 0;
+}
+
 /*! Handle order-by user(leaf)list for xml_diff
  *
  * Loop over sublists started by x0c and x1c respectively until end or yang is no longer yc
@@ -324,6 +432,8 @@ xml_diff_ordered_by_user(cxobj     *x0,
  *
  * @param[in]  x0         First XML tree
  * @param[in]  x1         Second XML tree
+ * @param[in]  flag       If set, skip equal x1 children (and their subtrees) not marked with flag
+ * @param[in]  icc        Cache of cl:ignore-compare lookups, see ignore_compare
  * @param[out] x0vec      Pointervector to XML nodes existing in only first tree
  * @param[out] x0veclen   Length of first vector
  * @param[out] x1vec      Pointervector to XML nodes existing in only second tree
@@ -348,11 +458,15 @@ xml_diff_ordered_by_user(cxobj     *x0,
  * @see xml_diff2cbuf, clixon_text_diff2cbuf  for +/- diff for XML and TEXT formats
  * @see text_diff2cbuf for curly
  * @see xml_tree_equal Equal or not
+ * Since children are sorted and system-ordered entries by key, this is a linear merge-join
+ * of the two child vectors.
  * @note reordering in ordered-by user is NOT supported
  */
 static int
 xml_diff1(cxobj     *x0,
           cxobj     *x1,
+          int        flag,
+          ignore_compare_cache *icc,
           cxobj   ***x0vec,
           int       *x0veclen,
           cxobj   ***x1vec,
@@ -384,7 +498,7 @@ xml_diff1(cxobj     *x0,
         y1c = NULL;
         /* If cl:ignore-compare extension, return equal */
         if (x0c && (y0c = xml_spec(x0c)) != NULL){
-            if (yang_extension_value(y0c, "ignore-compare", CLIXON_LIB_NS, &extflag, NULL) < 0)
+            if (ignore_compare(y0c, icc, &extflag) < 0)
                 goto done;
             if (extflag){ /* skip */
                 if (x1c) {
@@ -396,7 +510,7 @@ xml_diff1(cxobj     *x0,
             }
         }
         if (x1c && (y1c = xml_spec(x1c)) != NULL){
-            if (yang_extension_value(y1c, "ignore-compare", CLIXON_LIB_NS, &extflag, NULL) < 0)
+            if (ignore_compare(y1c, icc, &extflag) < 0)
                 goto done;
             if (extflag){ /* skip */
                 if (x1c) {
@@ -473,8 +587,15 @@ xml_diff1(cxobj     *x0,
                 if (cxvec_append(x1c, x1vec, x1veclen) < 0)
                     goto done;
             }
-            else if (y0c && yang_keyword_get(y0c) == Y_LEAF){
-                /* if x0c and x1c are leafs w bodies, then they may be changed */
+            else if (flag && xml_flag(x1c, flag) == 0)
+                ; /* Unmarked: subtree is not changed */
+#ifdef XML_HASH_CACHE
+            else if (flag == 0 && xml_tree_hash(x0c) == xml_tree_hash(x1c))
+                ; /* Identical subtrees */
+#endif
+            else if (y0c && (yang_keyword_get(y0c) == Y_LEAF ||
+                             xml_flag(x0c, XML_FLAG_OPAQUE) || xml_flag(x1c, XML_FLAG_OPAQUE))){
+                /* if x0c and x1c are leafs or raw anydata w bodies, then they may be changed */
                 b0 = xml_body(x0c);
                 b1 = xml_body(x1c);
                 if (b0 == NULL && b1 == NULL)
@@ -489,7 +610,7 @@ xml_diff1(cxobj     *x0,
                         goto done;
                 }
             }
-            else if (xml_diff1(x0c, x1c,
+            else if (xml_diff1(x0c, x1c, flag, icc,
                                x0vec, x0veclen,
                                x1vec, x1veclen,
                                changed_x0, changed_x1, changedlen)< 0)
@@ -520,6 +641,7 @@ xml_diff1(cxobj     *x0,
  * All xml vectors should be freed after use.
  * @see xml_tree_equal  same algorithm but do not bother with what has changed
  * @see clixon_xml_diff_print  same algorithm but print in +/- diff format
+ * @see xml_diff_flagged  incremental diff of marked subtrees only
  */
 int
 xml_diff(cxobj     *x0,
@@ -532,7 +654,46 @@ xml_diff(cxobj     *x0,
          cxobj   ***changed_x1,
          int       *changedlen)
 {
-    int retval = -1;
+    return xml_diff_flagged(x0, x1, 0,
+                            first, firstlen,
+                            second, secondlen,
+                            changed_x0, changed_x1, changedlen);
+}
+
+/*! Compute differences between two xml trees, skip unmarked subtrees of second tree
+ *
+ * Same as xml_diff but equal nodes in x1 not marked with flag are assumed to be unchanged
+ * including their subtrees, which are therefore not traversed.
+ * Only valid if all changes in x1 relative to x0 are marked with flag, including ancestors.
+ * @param[in]  x0         First XML tree
+ * @param[in]  x1         Second XML tree
+ * @param[in]  flag       Flag marking changed nodes in x1, eg XML_FLAG_EDITED
+ * @param[out] first      Pointervector to XML nodes existing in only first tree
+ * @param[out] firstlen   Length of first vector
+ * @param[out] second     Pointervector to XML nodes existing in only second tree
+ * @param[out] secondlen  Length of second vector
+ * @param[out] changed_x0 Pointervector to XML nodes changed orig value
+ * @param[out] changed_x1 Pointervector to XML nodes changed wanted value
+ * @param[out] changedlen Length of changed vector
+ * @retval     0          OK
+ * @retval    -1          Error
+ * All xml vectors should be freed after use.
+ * @see xml_diff  full diff
+ */
+int
+xml_diff_flagged(cxobj     *x0,
+                 cxobj     *x1,
+                 int        flag,
+                 cxobj   ***first,
+                 int       *firstlen,
+                 cxobj   ***second,
+                 int       *secondlen,
+                 cxobj   ***changed_x0,
+                 cxobj   ***changed_x1,
+                 int       *changedlen)
+{
+    int                  retval = -1;
+    ignore_compare_cache icc[IGNORE_COMPARE_CACHE] = {{0,},};
 
     *firstlen = 0;
     *secondlen = 0;
@@ -549,7 +710,12 @@ xml_diff(cxobj     *x0,
             goto done;
         goto ok;
     }
-    if (xml_diff1(x0, x1,
+#ifdef XML_HASH_CACHE
+    /* Hashing all of x1 would traverse unmarked subtrees */
+    if (flag == 0 && xml_tree_hash(x0) == xml_tree_hash(x1))
+        goto ok;
+#endif
+    if (xml_diff1(x0, x1, flag, icc,
                   first, firstlen,
                   second, secondlen,
                   changed_x0, changed_x1, changedlen) < 0)
@@ -560,19 +726,19 @@ xml_diff(cxobj     *x0,
     return retval;
 }
 
-/*! Compute if two XML trees are equal or not
+/*! Recursive help function to compute if two XML trees are equal or not
  *
  * @param[in]  x0   First XML tree
  * @param[in]  x1   Second XML tree
+ * @param[in]  icc  Cache of cl:ignore-compare lookups, see ignore_compare
  * @retval     1    Not equal
  * @retval     0    Equal
- * @see xml_diff which returns diff sets
- * @see xml_diff2cbuf   Diff buffer in XML
- * @see text_diff2cbuf  Diff buffer in curly
+ * @see xml_tree_equal
  */
-int
-xml_tree_equal(cxobj *x0,
-               cxobj *x1)
+static int
+xml_tree_equal1(cxobj                *x0,
+                cxobj                *x1,
+                ignore_compare_cache *icc)
 {
     int        retval = 1; /* Not equal */
     int        eq;
@@ -584,6 +750,10 @@ xml_tree_equal(cxobj *x0,
     cxobj     *x1c; /* x1 child */
     int        extflag = 0;
 
+#ifdef XML_HASH_CACHE
+    if (xml_tree_hash(x0) == xml_tree_hash(x1))
+        return 0;
+#endif
     /* Traverse x0 and x1 in lock-step */
     x0c = x1c = NULL;
     x0c = xml_child_each(x0, x0c, CX_ELMNT);
@@ -595,7 +765,7 @@ xml_tree_equal(cxobj *x0,
         y1c = NULL;
         /* If cl:ignore-compare extension, return equal */
         if (x0c && (y0c = xml_spec(x0c)) != NULL){
-            if (yang_extension_value(y0c, "ignore-compare", CLIXON_LIB_NS, &extflag, NULL) < 0)
+            if (ignore_compare(y0c, icc, &extflag) < 0)
                 goto done;
             if (extflag){ /* skip */
                 if (x1c) {
@@ -607,7 +777,7 @@ xml_tree_equal(cxobj *x0,
             }
         }
         if (x1c && (y1c = xml_spec(x1c)) != NULL){
-            if (yang_extension_value(y1c, "ignore-compare", CLIXON_LIB_NS, &extflag, NULL) < 0)
+            if (ignore_compare(y1c, icc, &extflag) < 0)
                 goto done;
             if (extflag){ /* skip */
                 if (x1c) {
@@ -634,8 +804,9 @@ xml_tree_equal(cxobj *x0,
                 goto done;
             }
             else
-                if (y0c && yang_keyword_get(y0c) == Y_LEAF){
-                    /* if x0c and x1c are leafs w bodies, then they may be changed */
+                if (y0c && (yang_keyword_get(y0c) == Y_LEAF ||
+                            xml_flag(x0c, XML_FLAG_OPAQUE) || xml_flag(x1c, XML_FLAG_OPAQUE))){
+                    /* if x0c and x1c are leafs or raw anydata w bodies, then they may be changed */
                     b0 = xml_body(x0c);
                     b1 = xml_body(x1c);
                     if (b0 == NULL && b1 == NULL)
@@ -647,7 +818,7 @@ xml_tree_equal(cxobj *x0,
                     }
                 }
                 else {
-                    eq = xml_tree_equal(x0c, x1c);
+                    eq = xml_tree_equal1(x0c, x1c, icc);
                     if (eq)
                         goto done;
                 }
@@ -661,6 +832,216 @@ xml_tree_equal(cxobj *x0,
     return retval;
 }
 
+/*! Compute if two XML trees are equal or not
+ *
+ * @param[in]  x0   First XML tree
+ * @param[in]  x1   Second XML tree
+ * @retval     1    Not equal
+ * @retval     0    Equal
+ * @see xml_diff which returns diff sets
+ * @see xml_diff2cbuf   Diff buffer in XML
+ * @see text_diff2cbuf  Diff buffer in curly
+ */
+int
+xml_tree_equal(cxobj *x0,
+               cxobj *x1)
+{
+    ignore_compare_cache icc[IGNORE_COMPARE_CACHE] = {{0,},};
+
+    return xml_tree_equal1(x0, x1, icc);
+}
+
+/*! Find the node in another tree at the same position as a node in a tree
+ *
+ * The other tree has the same top, eg a copy or another version of the same datastore.
+ * @param[in]  x      XML node
+ * @param[in]  xt     Top of other XML tree
+ * @param[out] xp     Corresponding node in xt, or NULL if not found
+ * @param[out] hit    Set if a proper ancestor of xp is marked with XML_FLAG_MARK
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+xml_rebase_locate(cxobj  *x,
+                  cxobj  *xt,
+                  cxobj **xp,
+                  int    *hit)
+{
+    cxobj *xup;
+    cxobj *x1 = NULL;
+
+    *xp = NULL;
+    if ((xup = xml_parent(x)) == NULL){
+        *xp = xt;
+        return 0;
+    }
+    if (xml_rebase_locate(xup, xt, &x1, hit) < 0)
+        return -1;
+    if (x1 == NULL)
+        return 0;
+    if (xml_parent(x1) != NULL && xml_flag(x1, XML_FLAG_MARK))
+        *hit = 1;
+    return match_base_child(x1, x, xml_spec(x), xp);
+}
+
+/*! Mark a node as changed with XML_FLAG_MARK and its ancestors with XML_FLAG_CHANGE
+ *
+ * @param[in]  x      XML node, or NULL
+ * @param[in]  flag   Flag to set on x
+ */
+static void
+xml_rebase_mark(cxobj *x,
+                int    flag)
+{
+    if (x == NULL)
+        return;
+    xml_flag_set(x, flag);
+    while ((x = xml_parent(x)) != NULL)
+        xml_flag_set(x, XML_FLAG_CHANGE);
+}
+
+/*! Three-way merge: apply the changes of a tree relative to its base onto a new base
+ *
+ * Let xp be a private tree forked from xb, and xr a tree that has also changed from xb,
+ * eg running committed by others. The result is a copy of xr with the changes of xp.
+ * Changes conflict only if they overlap: one tree changed a node, or an ancestor or
+ * descendant of it, that the other has also changed. Equal changes in both trees do not
+ * conflict.
+ * @param[in]  xb        Base tree
+ * @param[in]  xp        Tree with changes from xb to apply
+ * @param[in]  xr        New base, changed from xb
+ * @param[out] xnew      Copy of xr with the changes of xp applied. Free with xml_free
+ * @param[out] xconflict First conflicting node in xp or xb, if conflict
+ * @retval     1         OK, xnew set
+ * @retval     0         Conflict, xconflict set
+ * @retval    -1         Error
+ * @note All trees must be YANG bound
+ * @see xml_diff
+ */
+int
+xml_rebase(cxobj  *xb,
+           cxobj  *xp,
+           cxobj  *xr,
+           cxobj **xnew,
+           cxobj **xconflict)
+{
+    int     retval = -1;
+    cxobj  *xn = NULL;
+    cxobj **dvec = NULL;
+    int     dlen;
+    cxobj **avec = NULL;
+    int     alen;
+    cxobj **chvec0 = NULL;
+    cxobj **chvec1 = NULL;
+    int     chlen;
+    cxobj  *x;
+    cxobj  *xc;
+    int     hit = 0;
+    int     i;
+
+    if ((xn = xml_dup(xr)) == NULL)
+        goto done;
+    /* 1. Mark changes from base to new base in copy of new base */
+    if (xml_diff(xb, xr, &dvec, &dlen, &avec, &alen, &chvec0, &chvec1, &chlen) < 0)
+        goto done;
+    for (i=0; i<dlen; i++){
+        if (xml_rebase_locate(xml_parent(dvec[i]), xn, &x, &hit) < 0)
+            goto done;
+        xml_rebase_mark(x, XML_FLAG_CHANGE);
+    }
+    for (i=0; i<alen; i++){
+        if (xml_rebase_locate(avec[i], xn, &x, &hit) < 0)
+            goto done;
+        xml_rebase_mark(x, XML_FLAG_MARK);
+    }
+    for (i=0; i<chlen; i++){
+        if (xml_rebase_locate(chvec1[i], xn, &x, &hit) < 0)
+            goto done;
+        xml_rebase_mark(x, XML_FLAG_MARK);
+    }
+    free(dvec); dvec = NULL;
+    free(avec); avec = NULL;
+    free(chvec0); chvec0 = NULL;
+    free(chvec1); chvec1 = NULL;
+    /* 2. Apply changes from base to private tree, unless they overlap marked nodes */
+    if (xml_diff(xb, xp, &dvec, &dlen, &avec, &alen, &chvec0, &chvec1, &chlen) < 0)
+        goto done;
+    for (i=0; i<dlen; i++){ /* Deleted */
+        hit = 0;
+        if (xml_rebase_locate(dvec[i], xn, &x, &hit) < 0)
+            goto done;
+        if (x == NULL && !hit) /* Also deleted in new base */
+            continue;
+        if (x == NULL || hit || xml_flag(x, XML_FLAG_MARK|XML_FLAG_CHANGE)){
+            *xconflict = dvec[i];
+            goto fail;
+        }
+        if (xml_purge(x) < 0)
+            goto done;
+    }
+    for (i=0; i<chlen; i++){ /* Changed */
+        hit = 0;
+        if (xml_rebase_locate(chvec0[i], xn, &x, &hit) < 0)
+            goto done;
+        if (x != NULL && xml_flag(x, XML_FLAG_MARK) && !hit &&
+            xml_tree_equal(x, chvec1[i]) == 0) /* Same change in new base */
+            continue;
+        if (x == NULL || hit || xml_flag(x, XML_FLAG_MARK|XML_FLAG_CHANGE)){
+            *xconflict = chvec1[i];
+            goto fail;
+        }
+        xc = xml_parent(x);
+        if (xml_purge(x) < 0)
+            goto done;
+        if ((x = xml_dup(chvec1[i])) == NULL)
+            goto done;
+        if (xml_insert(xc, x, INS_LAST, NULL, NULL) < 0)
+            goto done;
+    }
+    for (i=0; i<alen; i++){ /* Added */
+        hit = 0;
+        if (xml_rebase_locate(xml_parent(avec[i]), xn, &x, &hit) < 0)
+            goto done;
+        if (x == NULL || hit ||
+            (xml_parent(x) != NULL && xml_flag(x, XML_FLAG_MARK))){
+            *xconflict = avec[i];
+            goto fail;
+        }
+        if (match_base_child(x, avec[i], xml_spec(avec[i]), &xc) < 0)
+            goto done;
+        if (xc != NULL){
+            if (xml_tree_equal(xc, avec[i]) == 0) /* Same add in new base */
+                continue;
+            *xconflict = avec[i];
+            goto fail;
+        }
+        if ((xc = xml_dup(avec[i])) == NULL)
+            goto done;
+        if (xml_insert(x, xc, INS_LAST, NULL, NULL) < 0)
+            goto done;
+    }
+    xml_apply0(xn, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset,
+               (void*)(XML_FLAG_MARK|XML_FLAG_CHANGE));
+    *xnew = xn;
+    xn = NULL;
+    retval = 1;
+ done:
+    if (xn)
+        xml_free(xn);
+    if (dvec)
+        free(dvec);
+    if (avec)
+        free(avec);
+    if (chvec0)
+        free(chvec0);
+    if (chvec1)
+        free(chvec1);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
 /*! Prune everything that does not pass test or have at least a child* does not
  *
  * @param[in]   xt      XML tree with some node marked
@@ -1209,12 +1590,94 @@ assign_namespace_body(cxobj *x0, /* source */
     return retval;
 }
 
+/*! Given child tree x1c, find matching child in base tree x0 using a merge cursor
+ *
+ * If x1c is a system-ordered list or leaf-list entry, and the entries of the modification
+ * tree are strictly increasing, the base entries are scanned linearly from the previous
+ * match. Merging m entries into n is then O(n+m) instead of O(m log n).
+ * Otherwise revert to match_base_child.
+ * @param[in]  x0      Base tree node
+ * @param[in]  x1c     Modification tree child
+ * @param[in]  yc      Yang spec of tree child
+ * @param[in]  mc      Merge cursor, initialized to zero before first child
+ * @param[out] x0cp    Matching base tree child (if any)
+ * @param[out] posp    Sorted position of x1c in x0 if no match and known, else -1
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @see match_base_child
+ */
+static int
+merge_cursor_match(cxobj        *x0,
+                   cxobj        *x1c,
+                   yang_stmt    *yc,
+                   merge_cursor *mc,
+                   cxobj       **x0cp,
+                   int          *posp)
+{
+    enum rfc_6020 keyw;
+    cvec         *cvk;
+    cg_var       *cvi;
+    cxobj        *xc;
+    int           ret;
+
+    *x0cp = NULL;
+    *posp = -1;
+    keyw = yang_keyword_get(yc);
+    if (keyw != Y_LIST && keyw != Y_LEAF_LIST)
+        goto binary;
+#ifndef STATE_ORDERED_BY_SYSTEM
+    if (yang_config_ancestor(yc) == 0)
+        goto binary;
+#endif
+    if (yang_find(yc, Y_ORDERED_BY, "user") != NULL)
+        goto binary;
+    if (mc->mc_yc != yc){ /* New run */
+        mc->mc_yc = yc;
+        mc->mc_prev = NULL;
+        if ((ret = xml_child_range_yang(x0, yc, &mc->mc_pos, &mc->mc_hi)) < 0)
+            return -1;
+        mc->mc_sorted = ret;
+    }
+    else if (mc->mc_sorted && xml_cmp(mc->mc_prev, x1c, 0, 0, NULL) >= 0)
+        mc->mc_sorted = 0; /* Not increasing, eg duplicates */
+    mc->mc_prev = x1c;
+    if (!mc->mc_sorted)
+        goto binary;
+    /* Entries without keys or value never match, see match_base_child */
+    if (keyw == Y_LEAF_LIST){
+        if (xml_body(x1c) == NULL)
+            goto binary;
+    }
+    else {
+        cvk = yang_cvec_get(yc);
+        cvi = NULL;
+        while ((cvi = cvec_each(cvk, cvi)) != NULL)
+            if (xml_find(x1c, cv_string_get(cvi)) == NULL)
+                goto binary;
+    }
+    while (mc->mc_pos < mc->mc_hi){
+        xc = xml_child_i(x0, mc->mc_pos);
+        if ((ret = xml_cmp(xc, x1c, 0, 0, NULL)) > 0)
+            break;
+        mc->mc_pos++;
+        if (ret == 0){
+            *x0cp = xc;
+            return 0;
+        }
+    }
+    *posp = mc->mc_pos;
+    return 0;
+ binary:
+    return match_base_child(x0, x1c, yc, x0cp);
+}
+
 /*! Merge a base tree x0 with x1 with yang spec y
  *
  * @param[in]  x0  Base xml tree (can be NULL in add scenarios)
  * @param[in]  y0  Yang spec corresponding to xml-node x0. NULL if x0 is NULL
  * @param[in]  x0p Parent of x0
  * @param[in]  x1  xml tree which modifies base
+ * @param[in]  pos Sorted position of x1 in x0p if x0 is NULL, or -1 if not known
  * @param[out] reason If retval=0 a malloced string
  * @retval     1      OK
  * @retval     0      Yang error, reason is set
@@ -1226,6 +1689,7 @@ xml_merge1(cxobj              *x0,  /* the target */
            yang_stmt          *y0,
            cxobj              *x0p,
            cxobj              *x1,  /* the source */
+           int                 pos,
            char              **reason)
 {
     int             retval = -1;
@@ -1240,6 +1704,8 @@ xml_merge1(cxobj              *x0,  /* the target */
     int             i;
     merge_twophase *twophase = NULL;
     int             twophase_len;
+    merge_cursor    mc = {0,};
+    int             ninsert;
     cvec           *nsc = NULL;
     cg_var         *cv;
     char           *ns;
@@ -1260,6 +1726,10 @@ xml_merge1(cxobj              *x0,  /* the target */
             if (xml_addsub(x0p, x1) < 0)
                 goto done;
         }
+        else if (pos >= 0){
+            if (xml_insert_pos_hint(x0p, x1, pos) < 0)
+                goto done;
+        }
         else
             if (xml_insert(x0p, x1, INS_LAST, NULL, NULL) < 0)
                 goto done;
@@ -1341,7 +1811,7 @@ xml_merge1(cxobj              *x0,  /* the target */
             }
             /* See if there is a corresponding node in the base tree */
             x0c = NULL;
-            if (yc && match_base_child(x0, x1c, yc, &x0c) < 0)
+            if (merge_cursor_match(x0, x1c, yc, &mc, &x0c, &twophase[i].mt_pos) < 0)
                 goto done;
             /* If x0 already has a value, do not replace it with a default value in x1 */
             if (x0c && xml_flag(x1c, XML_FLAG_DEFAULT))
@@ -1357,16 +1827,20 @@ xml_merge1(cxobj              *x0,  /* the target */
         twophase_len = i; /* Inital length included non-elements */
         /* Second run where actual merging is done 
          * Loop through children of the modification tree */
+        ninsert = 0; /* Positions are before any insertion, adjust for earlier inserts */
         for (i=0; i<twophase_len; i++){
             assert(twophase[i].mt_x1c);
             if ((ret = xml_merge1(twophase[i].mt_x0c,
                                   twophase[i].mt_yc,
                                   x0,
                                   twophase[i].mt_x1c,
+                                  twophase[i].mt_pos < 0 ? -1 : twophase[i].mt_pos + ninsert,
                                   reason)) < 0)
                 goto done;
             if (ret == 0)
                 goto fail;
+            if (twophase[i].mt_x0c == NULL)
+                ninsert++;
         }
         if (xml_parent(x0) == NULL &&
             xml_insert(x0p, x0, INS_LAST, NULL, NULL) < 0)
@@ -1414,6 +1888,8 @@ xml_merge(cxobj     *x0,
     int        i;
     merge_twophase *twophase = NULL;
     int        twophase_len;
+    merge_cursor mc = {0,};
+    int        ninsert;
     int        ret;
 
     if (x0 == NULL || x1 == NULL){
@@ -1457,7 +1933,7 @@ xml_merge(cxobj     *x0,
         }
         x0c = NULL;
         /* See if there is a corresponding node (x1c) in the base tree (x0) */
-        if (yc && match_base_child(x0, x1c, yc, &x0c) < 0)
+        if (merge_cursor_match(x0, x1c, yc, &mc, &x0c, &twophase[i].mt_pos) < 0)
             goto done;
         /* If x0 already has a value, do not replace it with a default value in x1 */
         if (x0c && xml_flag(x1c, XML_FLAG_DEFAULT))
@@ -1473,16 +1949,20 @@ xml_merge(cxobj     *x0,
     twophase_len = i; /* Inital length included non-elements */
     /* Second run where actual merging is done 
      * Loop through children of the modification tree */
+    ninsert = 0; /* Positions are before any insertion, adjust for earlier inserts */
     for (i=0; i<twophase_len; i++){
         assert(twophase[i].mt_x1c);
         if ((ret = xml_merge1(twophase[i].mt_x0c,
                               twophase[i].mt_yc,
                               x0,
                               twophase[i].mt_x1c,
+                              twophase[i].mt_pos < 0 ? -1 : twophase[i].mt_pos + ninsert,
                               reason)) < 0)
             goto done;
         if (ret == 0)
             goto fail;
+        if (twophase[i].mt_x0c == NULL)
+            ninsert++;
     }
     retval = 1; /* OK */
  done:
@@ -1498,6 +1978,7 @@ xml_merge(cxobj     *x0,
 
 /*! Given a YANG (enum) type node and a value, return the string containing corresponding int str
  *
+ * Uses the table of enums sorted by value made by ys_populate_type_enum if present
  * @param[in]  ytype   YANG type noden
  * @param[in]  valstr  Integer string value
  * @param[out] enumstr Value of enum, dont free
@@ -1513,11 +1994,36 @@ yang_valstr2enum(yang_stmt *ytype,
     yang_stmt *yenum;
     yang_stmt *yval; 
     int        inext;
+    cvec      *cvv;
+    cg_var    *cv;
+    int32_t    v;
+    int        lo;
+    int        hi;
+    int        mid;
 
     if (enumstr == NULL){
         clixon_err(OE_UNIX, EINVAL, "str is NULL");
         goto done;
     }
+    if ((cvv = yang_cvec_get(ytype)) != NULL && cvec_len(cvv) > 0){
+        if (parse_int32(valstr, &v, NULL) <= 0)
+            goto ok;
+        lo = 0;
+        hi = cvec_len(cvv) - 1;
+        while (lo <= hi){
+            mid = (lo + hi) / 2;
+            cv = cvec_i(cvv, mid);
+            if (cv_int32_get(cv) == v){
+                *enumstr = cv_name_get(cv);
+                break;
+            }
+            if (cv_int32_get(cv) < v)
+                lo = mid + 1;
+            else
+                hi = mid - 1;
+        }
+        goto ok;
+    }
     inext = 0;
     while ((yenum = yn_iter(ytype, &inext)) != NULL) {
         if ((yval = yang_find(yenum, Y_VALUE, NULL)) == NULL)
@@ -1527,6 +2033,7 @@ yang_valstr2enum(yang_stmt *ytype,
     }
     if (yenum)
         *enumstr = yang_argument_get(yenum);
+ ok:
     retval = 0;
  done:
     return retval;
@@ -1640,7 +2147,18 @@ yang_bits_pos(yang_stmt *ytype,
     yang_stmt *yprev;
     yang_stmt *ypos = NULL;
     int        inext;
+    cg_var    *cv;
 
+    /* Position set by ys_populate_type_bits */
+    if ((yprev = yang_find(ytype, Y_BIT, bitstr)) == NULL){
+        clixon_debug(CLIXON_DBG_YANG, "flag %s not found", bitstr);
+        goto fail;
+    }
+    if ((cv = yang_cv_get(yprev)) != NULL){
+        *bitpos = cv_uint32_get(cv);
+        retval = 1;
+        goto done;
+    }
     inext = 0;
     while ((yprev = yn_iter(ytype, &inext)) != NULL){
         /* Check for the given bit name (flag) */
@@ -1834,6 +2352,7 @@ yang_val2bitsstr(clixon_handle  h,
     yang_stmt *ypos;
     uint32_t   bitpos = 0;
     int        inext;
+    cg_var    *cv;
 
     if (cb == NULL){
         clixon_err(OE_UNIX, EINVAL, "cb is NULL");
@@ -1843,8 +2362,10 @@ yang_val2bitsstr(clixon_handle  h,
     inext = 0;
     while ((yprev = yn_iter(ytype, &inext)) != NULL && byte < inlen){
         if (yang_keyword_get(yprev) == Y_BIT) {
-            /* Use position from Y_POSITION statement if defined */
-            if ((ypos = yang_find(yprev, Y_POSITION, NULL)) != NULL){
+            /* Use position set by ys_populate_type_bits, or from Y_POSITION statement */
+            if ((cv = yang_cv_get(yprev)) != NULL)
+                bitpos = cv_uint32_get(cv);
+            else if ((ypos = yang_find(yprev, Y_POSITION, NULL)) != NULL){
                 if ((ret = parse_uint32(yang_argument_get(ypos), &bitpos, &reason)) < 0){
                     clixon_err(OE_UNIX, EINVAL, "cannot parse bit position val: %s", reason);
                     goto done;
@@ -2082,15 +2603,18 @@ yang_check_when_xpath(cxobj        *xn,
                       int          *nrp,
                       char        **xpathp)
 {
-    int        retval = 1;
-    yang_stmt *yc;
-    char      *xpath = NULL;
-    cxobj     *x = NULL;
-    int        nr = 0;
-    cvec      *nsc = NULL;
-    int        variant = 0;   /* ugly help variable to clean temporary object */
-
-    if (yang_when_canonical_xpath_get(yn, &xpath, &nsc) < 0)
+    int         retval = 1;
+    yang_stmt  *yc;
+    char       *xpath = NULL;
+    xpath_tree *xptree = NULL;
+    cxobj      *x = NULL;
+    int         nr = 0;
+    cvec       *nsc = NULL;
+    int         variant = 0;   /* ugly help variable to clean temporary object */
+
+    /* The xpaths are parsed once and cached in the when statements */
+    if ((yc = yang_when_get(NULL, yn)) != NULL &&
+        yang_xpath_cache_get(yc, 1, &xpath, &xptree, &nsc) < 0)
         goto done;
     if (xpath != NULL){
         x = xp;
@@ -2098,10 +2622,8 @@ yang_check_when_xpath(cxobj        *xn,
     }
     else if ((yc = yang_find(yn, Y_WHEN, NULL)) != NULL){
         /* "when" has xpath argument */
-        if ((xpath = strdup(yang_argument_get(yc))) == NULL){
-            clixon_err(OE_UNIX, errno, "strdup");
+        if (yang_xpath_cache_get(yc, 0, &xpath, &xptree, &nsc) < 0)
             goto done;
-        }
         /* Create dummy */
         if (xn == NULL){
             if ((x = xml_new(yang_argument_get(yn), xp, CX_ELMNT)) == NULL)
@@ -2111,30 +2633,27 @@ yang_check_when_xpath(cxobj        *xn,
         }
         else
             x = xn;
-        if (xml_nsctx_yang(yn, &nsc) < 0)
-            goto done;
         *hit = 1;
     }
     else
         *hit = 0;
-    if (x && xpath){
-        if ((nr = xpath_vec_bool(x, nsc, "%s", xpath)) < 0)
+    if (x && xptree){
+        if ((nr = xpath_tree_vec_bool(x, nsc, xptree)) < 0)
             goto done;
     }
     if (nrp)
         *nrp = nr;
     if (xpathp){
-        *xpathp = xpath;
-        xpath = NULL;
+        *xpathp = NULL;
+        if (xpath && (*xpathp = strdup(xpath)) == NULL){
+            clixon_err(OE_UNIX, errno, "strdup");
+            goto done;
+        }
     }
     retval = 0;
  done:
     if (variant)
         xml_purge(x);
-    if (xpath)
-        free(xpath);
-    if (nsc)
-        xml_nsctx_free(nsc);
     return retval;
 }
 
@@ -2349,6 +2868,10 @@ clixon_compare_xmls(cxobj            *xc1,
     char   filename2[MAXPATHLEN];
     cbuf  *cb = NULL;
 
+#ifdef XML_HASH_CACHE
+    if (xml_tree_hash(xc1) == xml_tree_hash(xc2))
+        return 0; /* Identical, no diff */
+#endif
     snprintf(filename1, sizeof(filename1), "/tmp/cliconXXXXXX");
     snprintf(filename2, sizeof(filename2), "/tmp/cliconXXXXXX");
     if ((fd = mkstemp(filename1)) < 0){
@@ -397,6 +397,78 @@ xml_nsctx_yang(yang_stmt *yn,
     return retval;
 }
 
+/*! Shared namespace context of a YANG module, see xml_nsctx_yang_shared
+ */
+struct nsctx_shared {
+    struct nsctx_shared *ns_next;  /* Next in bucket */
+    yang_stmt           *ns_ymod;  /* YANG module or submodule */
+    cvec                *ns_nsc;   /* Namespace context of ns_ymod, see xml_nsctx_yang */
+};
+
+#define NSCTX_SHARED_BUCKETS 256
+static struct nsctx_shared *_nsctx_shared[NSCTX_SHARED_BUCKETS] = {NULL,};
+
+/*! Get shared XML namespace context of a Yang node
+ *
+ * Same as xml_nsctx_yang, but the context only depends on the (sub)module of the node,
+ * so it is created once per module and shared by all callers.
+ * The context is freed when the module is freed, see xml_nsctx_yang_shared_free
+ * @param[in]  yn     Yang statement in module tree (or module itself)
+ * @retval     nsc    XML namespace context, do not modify or free
+ * @retval     NULL   Error
+ * @note Not thread-safe, intended for the main thread, eg validation
+ */
+cvec *
+xml_nsctx_yang_shared(yang_stmt *yn)
+{
+    struct nsctx_shared *ns;
+    yang_stmt           *ymod;
+    int                  i;
+
+    if ((ymod = ys_module(yn)) == NULL){
+        clixon_err(OE_YANG, ENOENT, "My yang module not found");
+        return NULL;
+    }
+    i = ((uintptr_t)ymod >> 4) % NSCTX_SHARED_BUCKETS;
+    for (ns = _nsctx_shared[i]; ns; ns = ns->ns_next)
+        if (ns->ns_ymod == ymod)
+            return ns->ns_nsc;
+    if ((ns = calloc(1, sizeof(*ns))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        return NULL;
+    }
+    if (xml_nsctx_yang(ymod, &ns->ns_nsc) < 0){
+        free(ns);
+        return NULL;
+    }
+    ns->ns_ymod = ymod;
+    ns->ns_next = _nsctx_shared[i];
+    _nsctx_shared[i] = ns;
+    return ns->ns_nsc;
+}
+
+/*! Free shared XML namespace context of a YANG module, if any
+ *
+ * @param[in]  ymod   YANG module or submodule, called when it is freed
+ */
+void
+xml_nsctx_yang_shared_free(yang_stmt *ymod)
+{
+    struct nsctx_shared **nsp;
+    struct nsctx_shared  *ns;
+
+    nsp = &_nsctx_shared[((uintptr_t)ymod >> 4) % NSCTX_SHARED_BUCKETS];
+    while ((ns = *nsp) != NULL){
+        if (ns->ns_ymod == ymod){
+            *nsp = ns->ns_next;
+            cvec_free(ns->ns_nsc);
+            free(ns);
+            break;
+        }
+        nsp = &ns->ns_next;
+    }
+}
+
 /*! Create and initialize XML namespace context from Yang spec
  *
  * That is, create a "canonical" XML namespace mapping from all loaded yang 
@@ -483,6 +555,38 @@ xml_nsctx_cbuf(cbuf *cb,
     return 0;
 }
 
+/*! Namespace of bound XML element from its YANG module
+ *
+ * Only if bind has checked that the namespace of x is that of its YANG node, and only for
+ * the prefix of x itself. Then no xmlns attributes or namespace cache need to be looked up.
+ * @param[in]  x       XML element
+ * @param[in]  prefix  Prefix to resolve, or NULL for default
+ * @retval     ns      Namespace, pointer into YANG
+ * @retval     NULL    Not applicable
+ * @see XML_FLAG_NS_SPEC
+ */
+static char *
+xml_spec_namespace(cxobj *x,
+                   char  *prefix)
+{
+    yang_stmt *ymod;
+    yang_stmt *yns;
+    char      *xprefix;
+
+    if (xml_flag(x, XML_FLAG_NS_SPEC) == 0)
+        return NULL;
+    xprefix = xml_prefix(x);
+    if (prefix == NULL ? xprefix != NULL : (xprefix == NULL || strcmp(prefix, xprefix) != 0))
+        return NULL;
+    if ((ymod = ys_module(xml_spec(x))) == NULL)
+        return NULL;
+    if (yang_keyword_get(ymod) == Y_SUBMODULE)
+        return yang_find_mynamespace(xml_spec(x));
+    if ((yns = yang_find(ymod, Y_NAMESPACE, NULL)) == NULL)
+        return NULL;
+    return yang_argument_get(yns);
+}
+
 /*! Given an xml tree return URI namespace recursively : default or localname given
  *
  * Given an XML tree and a prefix (or NULL) return URI namespace.
@@ -507,6 +611,8 @@ xml2ns(cxobj *x,
     char  *ns = NULL;
     cxobj *xp;
 
+    if ((ns = xml_spec_namespace(x, prefix)) != NULL)
+        goto ok;
     if ((ns = nscache_get(x, prefix)) != NULL)
         goto ok;
     if (prefix != NULL) /* xmlns:<prefix>="<uri>" */
@@ -674,8 +780,14 @@ xml2prefix(cxobj *xn,
     cxobj *xp;
     char  *prefix = NULL;
     char  *xaprefix;
+    char  *ns;
     int    ret;
 
+    if ((ns = xml_spec_namespace(xn, xml_prefix(xn))) != NULL &&
+        strcmp(ns, namespace) == 0){
+        prefix = xml_prefix(xn);
+        goto found;
+    }
     if (nscache_get_prefix(xn, namespace, &prefix) == 1) /* found */
         goto found;
     xa = NULL;
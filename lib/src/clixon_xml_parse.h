@@ -43,9 +43,23 @@
 /*
  * Types
  */
+/*! Element callback of the hand-written XML scanner
+ *
+ * @param[in]  x    XML element
+ * @param[in]  arg  Callback argument, see xy_cbarg
+ * @retval     2    Element is consumed and purged by the scanner (end callback only)
+ * @retval     1    Stop scanning
+ * @retval     0    OK, continue
+ * @retval    -1    Error
+ * @note Top-level elements are referenced by xy_xvec and must not be purged
+ * @see clixon_xml_scan
+ */
+typedef int (xml_scan_cb)(cxobj *x, void *arg);
+
 /*! XML parser yacc handler struct */
 struct clixon_xml_parse_yacc {
     char       *xy_parse_string; /* original (copy of) parse string */
+    size_t      xy_parse_len;    /* If set, scan parse string of this length in place */
     int         xy_linenum;      /* Number of \n in parsed buffer */
     void       *xy_lexbuf;       /* internal parse buffer from lex */
     cxobj      *xy_xtop;         /* cxobj top element (fixed) */
@@ -55,6 +69,9 @@ struct clixon_xml_parse_yacc {
     int         xy_lex_state;    /* lex return state */
     cxobj     **xy_xvec;         /* Vector of created top-level nodes (to know which are created) */
     int         xy_xlen;         /* Length of xy_xvec */
+    xml_scan_cb *xy_start;       /* If set, called after start tag and attributes (scanner only) */
+    xml_scan_cb *xy_end;         /* If set, called after end tag (scanner only) */
+    void       *xy_cbarg;        /* Argument of xy_start and xy_end */
 };
 typedef struct clixon_xml_parse_yacc clixon_xml_yacc;
 
@@ -73,4 +90,6 @@ int clixon_xml_parsel_linenr(void);
 int clixon_xml_parselex(void *);
 int clixon_xml_parseparse(void *);
 
+int clixon_xml_scan(clixon_xml_yacc *xy);
+
 #endif  /* _CLIXON_XML_PARSE_H_ */
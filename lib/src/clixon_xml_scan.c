@@ -0,0 +1,583 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, indicate
+  your decision by deleting the provisions above and replace them with the
+  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Hand-written XML scanner
+ * An alternative to the flex/bison XML parser in clixon_xml_parse.[ly] that scans the input
+ * in a single pass and creates the XML tree directly, without tokens or a parse stack.
+ * Character data is located with strcspn/strstr which libc implements with vector
+ * instructions, and is copied once into the text of the element with entities decoded.
+ * Whitespace and other text in elements with element children is skipped without creating
+ * body nodes, instead of being created and removed at the end tag.
+ * The resulting tree is the same as the bison parser, which is the reference.
+ * @see CLICON_XML_PARSER
+ * @see clixon_xml_parse.y
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <string.h>
+#include <stdint.h>
+#include <ctype.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_string.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_err.h"
+#include "clixon_log.h"
+#include "clixon_debug.h"
+#include "clixon_xml_vec.h"
+#include "clixon_xml_parse.h"
+
+/* Name characters, see namestart and namechar in clixon_xml_parse.l */
+#define XML_SCAN_NAMESTART(c) (((c) >= 'A' && (c) <= 'Z') || ((c) >= 'a' && (c) <= 'z') || (c) == '_')
+#define XML_SCAN_NAMECHAR(c)  (XML_SCAN_NAMESTART(c) || ((c) >= '0' && (c) <= '9') || (c) == '-' || (c) == '.')
+#define XML_SCAN_WHITE(c)     ((c) == ' ' || (c) == '\t' || (c) == '\n' || (c) == '\r')
+
+/*! Scanner state
+ */
+typedef struct {
+    clixon_xml_yacc *xs_xy;     /* Parser struct shared with the bison parser */
+    cbuf            *xs_text;   /* Text of current element, entities decoded */
+    cbuf            *xs_prefix; /* Scratch for prefixes */
+    cbuf            *xs_name;   /* Scratch for names */
+} xml_scan_t;
+
+/*! Report syntax error in the same format as the bison parser
+ *
+ * Line numbers are counted only on error
+ * @param[in]  xs  Scanner state
+ * @param[in]  p   Position of error
+ * @retval    -1   Always
+ * @see clixon_xml_parseerror
+ */
+static int
+xml_scan_error(xml_scan_t *xs,
+               char       *p)
+{
+    clixon_xml_yacc *xy = xs->xs_xy;
+    char             tok[64];
+    char            *q;
+    size_t           n;
+
+    xy->xy_linenum = 0;
+    for (q = xy->xy_parse_string; (q = memchr(q, '\n', p - q)) != NULL; q++)
+        xy->xy_linenum++;
+    for (n = 0; n < sizeof(tok)-1 && XML_SCAN_NAMECHAR(p[n]); n++)
+        tok[n] = p[n];
+    if (n == 0 && *p != '\0')
+        tok[n++] = *p;
+    tok[n] = '\0';
+    clixon_err(OE_XML, XMLPARSE_ERRNO, "xml_parse: line %d: syntax error: at or before: %s",
+               xy->xy_linenum, tok);
+    return -1;
+}
+
+static char *
+xml_scan_white(char *p)
+{
+    while (XML_SCAN_WHITE(*p))
+        p++;
+    return p;
+}
+
+/*! Return length of NCName at p, or 0 if none
+ */
+static size_t
+xml_scan_ncname(char *p)
+{
+    char *q = p;
+
+    if (!XML_SCAN_NAMESTART(*q))
+        return 0;
+    for (q++; XML_SCAN_NAMECHAR(*q); q++)
+        ;
+    return q - p;
+}
+
+/*! Scan qualified name: [prefix:]name
+ *
+ * @param[in]     xs     Scanner state
+ * @param[in,out] pp     Position, moved past name, or to error
+ * @param[out]    prefix Prefix in scratch buffer or NULL
+ * @param[out]    name   Name in scratch buffer
+ * @retval        1      OK
+ * @retval        0      Syntax error
+ * @retval       -1      Error
+ */
+static int
+xml_scan_qname(xml_scan_t *xs,
+               char      **pp,
+               char      **prefix,
+               char      **name)
+{
+    char  *p = *pp;
+    size_t n;
+
+    *prefix = NULL;
+    if ((n = xml_scan_ncname(p)) == 0)
+        return 0;
+    if (p[n] == ':'){
+        cbuf_reset(xs->xs_prefix);
+        if (cbuf_append_buf(xs->xs_prefix, p, n) < 0){
+            clixon_err(OE_XML, errno, "cbuf_append_buf");
+            return -1;
+        }
+        *prefix = cbuf_get(xs->xs_prefix);
+        p += n + 1;
+        if ((n = xml_scan_ncname(p)) == 0){
+            *pp = p;
+            return 0;
+        }
+    }
+    cbuf_reset(xs->xs_name);
+    if (cbuf_append_buf(xs->xs_name, p, n) < 0){
+        clixon_err(OE_XML, errno, "cbuf_append_buf");
+        return -1;
+    }
+    *name = cbuf_get(xs->xs_name);
+    *pp = p + n;
+    return 1;
+}
+
+/*! Scan single or double quoted string
+ *
+ * @param[in,out] pp   Position, moved past end quote
+ * @param[out]    val  Start of string (not terminated)
+ * @param[out]    len  Length of string
+ * @retval        1    OK
+ * @retval        0    Syntax error
+ */
+static int
+xml_scan_quoted(char  **pp,
+                char  **val,
+                size_t *len)
+{
+    char *p = *pp;
+    char *q;
+
+    if (*p != '"' && *p != '\'')
+        return 0;
+    if ((q = strchr(p+1, *p)) == NULL)
+        return 0;
+    *val = p + 1;
+    *len = q - p - 1;
+    *pp = q + 1;
+    return 1;
+}
+
+/*! Scan "name = quoted-value" in the XML declaration
+ *
+ * @retval  1  OK
+ * @retval  0  Syntax error
+ */
+static int
+xml_scan_declattr(char      **pp,
+                  const char *name,
+                  char      **val,
+                  size_t     *len)
+{
+    char  *p = *pp;
+    size_t n = strlen(name);
+
+    if (strncmp(p, name, n) != 0)
+        return 0;
+    p = xml_scan_white(p + n);
+    if (*p != '=')
+        return 0;
+    p = xml_scan_white(p + 1);
+    if (xml_scan_quoted(&p, val, len) == 0)
+        return 0;
+    *pp = xml_scan_white(p);
+    return 1;
+}
+
+/*! Scan XML declaration: <?xml version="1.0" encoding="UTF-8" standalone="yes"?>
+ *
+ * @param[in]     xs   Scanner state
+ * @param[in,out] pp   Position at "<?xml", moved past declaration, or to error
+ * @retval        1    OK
+ * @retval        0    Syntax error
+ * @retval       -1    Error
+ * @see xml_parse_version
+ * @see xml_parse_encoding
+ */
+static int
+xml_scan_xmldecl(xml_scan_t *xs,
+                 char      **pp)
+{
+    char  *p = xml_scan_white(*pp + 5);
+    char  *v;
+    size_t n;
+
+    if (xml_scan_declattr(&p, "version", &v, &n) == 0)
+        goto fail;
+    if (n != 3 || strncmp(v, "1.0", n) != 0){
+        clixon_err(OE_XML, XMLPARSE_ERRNO, "Unsupported XML version: %.*s expected 1.0", (int)n, v);
+        return -1;
+    }
+    if (strncmp(p, "encoding", 8) == 0){
+        if (xml_scan_declattr(&p, "encoding", &v, &n) == 0)
+            goto fail;
+        if (n != 5 || strncasecmp(v, "UTF-8", n) != 0){
+            clixon_err(OE_XML, XMLPARSE_ERRNO, "Unsupported XML encoding: %.*s expected UTF-8", (int)n, v);
+            return -1;
+        }
+    }
+    if (strncmp(p, "standalone", 10) == 0 &&
+        xml_scan_declattr(&p, "standalone", &v, &n) == 0)
+        goto fail;
+    if (strncmp(p, "?>", 2) != 0)
+        goto fail;
+    *pp = p + 2;
+    return 1;
+ fail:
+    *pp = p;
+    return 0;
+}
+
+/*! Decode entity or character reference at '&' and append to text
+ *
+ * Predefined entities are decoded. Character references are kept as is, as in the bison parser
+ * @param[in]     cb   Text buffer
+ * @param[in,out] pp   Position at '&', moved past entity
+ * @retval        1    OK
+ * @retval        0    Syntax error, unknown entity
+ * @see xml_chardata_encode
+ */
+static int
+xml_scan_entity(cbuf  *cb,
+                char **pp)
+{
+    char *p = *pp + 1;
+    char *q;
+    int   c = 0;
+
+    switch (*p){
+    case 'a':
+        if (strncmp(p, "amp;", 4) == 0){
+            c = '&';
+            p += 4;
+        }
+        else if (strncmp(p, "apos;", 5) == 0){
+            c = '\'';
+            p += 5;
+        }
+        break;
+    case 'l':
+        if (strncmp(p, "lt;", 3) == 0){
+            c = '<';
+            p += 3;
+        }
+        break;
+    case 'g':
+        if (strncmp(p, "gt;", 3) == 0){
+            c = '>';
+            p += 3;
+        }
+        break;
+    case 'q':
+        if (strncmp(p, "quot;", 5) == 0){
+            c = '"';
+            p += 5;
+        }
+        break;
+    case '#':
+        q = p + 1;
+        if (*q == 'x'){
+            for (q++; isxdigit((unsigned char)*q); q++)
+                ;
+            if (q == p + 2)
+                return 0;
+        }
+        else{
+            for (; isdigit((unsigned char)*q); q++)
+                ;
+            if (q == p + 1)
+                return 0;
+        }
+        if (*q != ';')
+            return 0;
+        cbuf_append_buf(cb, *pp, q + 1 - *pp);
+        *pp = q + 1;
+        return 1;
+    default:
+        break;
+    }
+    if (c == 0)
+        return 0;
+    cbuf_append(cb, c);
+    *pp = p;
+    return 1;
+}
+
+/*! Scan XML string and create XML tree
+ *
+ * Same input and output as the bison parser: elements are created under xy_xtop and
+ * top-level elements are added to xy_xvec.
+ * If xy_start or xy_end are set, they are called for each element after its start tag and
+ * attributes, and after its end tag respectively. Scanning stops if a callback returns 1.
+ * @param[in]  xy   XML parser struct, xy_parse_string is null-terminated
+ * @retval     0    OK, or stopped by callback
+ * @retval    -1    Error
+ * @see clixon_xml_parseparse  The bison parser
+ */
+int
+clixon_xml_scan(clixon_xml_yacc *xy)
+{
+    int        retval = -1;
+    xml_scan_t xs = {0,};
+    char      *p;
+    char      *q;
+    cxobj     *xtop = xy->xy_xtop;
+    cxobj     *xp;
+    cxobj     *x;
+    cxobj     *xa;
+    char      *prefix;
+    char      *name;
+    char      *v;
+    size_t     n;
+    int        ret;
+
+    xs.xs_xy = xy;
+    if ((xs.xs_text = cbuf_new()) == NULL ||
+        (xs.xs_prefix = cbuf_new()) == NULL ||
+        (xs.xs_name = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    p = xml_scan_white(xy->xy_parse_string);
+    if (strncmp(p, "<?xml", 5) == 0 && XML_SCAN_WHITE(p[5])){
+        if ((ret = xml_scan_xmldecl(&xs, &p)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+    }
+    xp = xtop;
+    while (*p != '\0'){
+        if (*p != '<'){
+            /* Only whitespace before first top-level element */
+            if (xp == xtop && xy->xy_xlen == 0){
+                p = xml_scan_white(p);
+                if (*p != '<' && *p != '\0')
+                    goto fail;
+                continue;
+            }
+            /* Character data up to next markup, entity or CR */
+            n = strcspn(p, "<&\r");
+            if (n && cbuf_append_buf(xs.xs_text, p, n) < 0){
+                clixon_err(OE_XML, errno, "cbuf_append_buf");
+                goto done;
+            }
+            p += n;
+            if (*p == '&'){
+                if (xml_scan_entity(xs.xs_text, &p) == 0)
+                    goto fail;
+            }
+            else if (*p == '\r'){ /* CR LF -> LF, CR -> LF */
+                cbuf_append(xs.xs_text, '\n');
+                if (*++p == '\n')
+                    p++;
+            }
+            continue;
+        }
+        switch (p[1]){
+        case '/': /* End tag */
+            if (xp == xtop)
+                goto fail;
+            p += 2;
+            if ((ret = xml_scan_qname(&xs, &p, &prefix, &name)) < 0)
+                goto done;
+            if (ret == 0)
+                goto fail;
+            p = xml_scan_white(p);
+            if (*p != '>')
+                goto fail;
+            p++;
+            if (clicon_strcmp(xml_name(xp), name) ||
+                clicon_strcmp(xml_prefix(xp), prefix)){
+                clixon_err(OE_XML, XMLPARSE_ERRNO, "Sanity check failed: %s%s%s vs %s%s%s",
+                           xml_prefix(xp)?xml_prefix(xp):"", xml_prefix(xp)?":":"", xml_name(xp),
+                           prefix?prefix:"", prefix?":":"", name);
+                goto done;
+            }
+            /* Text is kept only if there is no element child, see xml_parse_bslash */
+            if (cbuf_len(xs.xs_text) && xml_child_each(xp, NULL, CX_ELMNT) == NULL){
+                if ((x = xml_new("body", xp, CX_BODY)) == NULL)
+                    goto done;
+                if (xml_value_set(x, cbuf_get(xs.xs_text)) < 0)
+                    goto done;
+            }
+            cbuf_reset(xs.xs_text);
+            x = xp;
+            xp = xml_parent(xp);
+            if (xy->xy_end){
+                if ((ret = xy->xy_end(x, xy->xy_cbarg)) < 0)
+                    goto done;
+                if (ret == 1)
+                    goto ok;
+                if (ret == 2 && xml_purge(x) < 0)
+                    goto done;
+            }
+            break;
+        case '!':
+            if (strncmp(p, "<!--", 4) == 0){
+                if ((q = strstr(p + 4, "-->")) == NULL)
+                    goto fail;
+                p = q + 3;
+            }
+            else if (strncmp(p, "<![CDATA[", 9) == 0){
+                if ((q = strstr(p + 9, "]]>")) == NULL)
+                    goto fail;
+                /* CDATA is kept verbatim including delimiters */
+                if (cbuf_append_buf(xs.xs_text, p, q + 3 - p) < 0){
+                    clixon_err(OE_XML, errno, "cbuf_append_buf");
+                    goto done;
+                }
+                p = q + 3;
+            }
+            else
+                goto fail;
+            break;
+        case '?': /* Processing instruction, skipped */
+            p += 2;
+            if (xml_scan_ncname(p) == 0)
+                goto fail;
+            if ((q = strstr(p, "?>")) == NULL)
+                goto fail;
+            p = q + 2;
+            break;
+        default: /* Start tag */
+            p++;
+            if ((ret = xml_scan_qname(&xs, &p, &prefix, &name)) < 0)
+                goto done;
+            if (ret == 0)
+                goto fail;
+            /* Parent has an element child, its text is not kept */
+            cbuf_reset(xs.xs_text);
+            if ((x = xml_new(name, xp, CX_ELMNT)) == NULL)
+                goto done;
+            if (xml_prefix_set(x, prefix) < 0)
+                goto done;
+            if (xp == xtop &&
+                cxvec_append(x, &xy->xy_xvec, &xy->xy_xlen) < 0)
+                goto done;
+            while (1){
+                p = xml_scan_white(p);
+                if (*p == '>'){
+                    p++;
+                    if (xy->xy_start){
+                        if ((ret = xy->xy_start(x, xy->xy_cbarg)) < 0)
+                            goto done;
+                        if (ret == 1)
+                            goto ok;
+                    }
+                    xp = x;
+                    break;
+                }
+                if (*p == '/' && p[1] == '>'){
+                    p += 2;
+                    if (xy->xy_start){
+                        if ((ret = xy->xy_start(x, xy->xy_cbarg)) < 0)
+                            goto done;
+                        if (ret == 1)
+                            goto ok;
+                    }
+                    if (xy->xy_end){
+                        if ((ret = xy->xy_end(x, xy->xy_cbarg)) < 0)
+                            goto done;
+                        if (ret == 1)
+                            goto ok;
+                        if (ret == 2 && xml_purge(x) < 0)
+                            goto done;
+                    }
+                    break;
+                }
+                if ((ret = xml_scan_qname(&xs, &p, &prefix, &name)) < 0)
+                    goto done;
+                if (ret == 0)
+                    goto fail;
+                p = xml_scan_white(p);
+                if (*p != '=')
+                    goto fail;
+                p = xml_scan_white(p + 1);
+                if (xml_scan_quoted(&p, &v, &n) == 0)
+                    goto fail;
+                /* Duplicate attributes are overwritten, see xml_parse_attr */
+                if ((xa = xml_find_type(x, prefix, name, CX_ATTR)) == NULL){
+                    if ((xa = xml_new(name, x, CX_ATTR)) == NULL)
+                        goto done;
+                    if (xml_prefix_set(xa, prefix) < 0)
+                        goto done;
+                }
+                /* Attribute values are not decoded */
+                cbuf_reset(xs.xs_text);
+                if (cbuf_append_buf(xs.xs_text, v, n) < 0){
+                    clixon_err(OE_XML, errno, "cbuf_append_buf");
+                    goto done;
+                }
+                if (xml_value_set(xa, cbuf_get(xs.xs_text)) < 0)
+                    goto done;
+            }
+            cbuf_reset(xs.xs_text);
+            break;
+        }
+    }
+    if (xp != xtop) /* Unterminated element */
+        goto fail;
+ ok:
+    retval = 0;
+ done:
+    if (xs.xs_text)
+        cbuf_free(xs.xs_text);
+    if (xs.xs_prefix)
+        cbuf_free(xs.xs_prefix);
+    if (xs.xs_name)
+        cbuf_free(xs.xs_name);
+    return retval;
+ fail:
+    xml_scan_error(&xs, p);
+    goto done;
+}
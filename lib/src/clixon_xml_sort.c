@@ -46,6 +46,7 @@
 #include <unistd.h>
 #include <errno.h>
 #include <string.h>
+#include <ctype.h>
 #include <limits.h>
 #include <stdint.h>
 #include <assert.h>
@@ -133,6 +134,17 @@ xml_cv_cache(cxobj   *x,
         clixon_err(OE_YANG, EINVAL, "cv parse error: %s\n", reason);
         goto done;
     }
+#ifdef XML_NUM_CACHE
+    switch (cvtype){
+    case CGV_INT8: case CGV_INT16: case CGV_INT32: case CGV_INT64:
+    case CGV_UINT8: case CGV_UINT16: case CGV_UINT32: case CGV_UINT64:
+        /* Next node of this type is parsed directly, see xml_num_cache */
+        yang_flag_set(y, YANG_FLAG_INTEGER);
+        break;
+    default:
+        break;
+    }
+#endif
     if (xml_cv_set(x, cv) < 0)
         goto done;
  ok:
@@ -147,6 +159,129 @@ xml_cv_cache(cxobj   *x,
     return retval;
 }
 
+/*! Get value of a leaf or leaf-list node as a cligen variable of its yang type
+ *
+ * The value is parsed on the first call and cached in the node until its value changes
+ * @param[in]  x    XML node bound to yang
+ * @param[out] cvp  Value, owned by the node, do not free
+ * @retval     0    OK
+ * @retval    -1    Error, eg no yang binding or invalid value
+ */
+int
+xml_cv_get(cxobj   *x,
+           cg_var **cvp)
+{
+    return xml_cv_cache(x, cvp);
+}
+
+#ifdef XML_NUM_CACHE
+/*! Parse decimal integer string without allocation
+ *
+ * @param[in]  str  String, optional sign followed by decimal digits
+ * @param[out] neg  1 if negative
+ * @param[out] val  Absolute value if not negative, otherwise the int64 value
+ * @retval     1    OK
+ * @retval     0    Not a decimal integer or out of range
+ */
+static int
+xml_num_parse(const char *str,
+              int        *neg,
+              uint64_t   *val)
+{
+    uint64_t v = 0;
+    int      n = 0;
+    int      d;
+
+    if (*str == '-'){
+        n = 1;
+        str++;
+    }
+    else if (*str == '+')
+        str++;
+    if (*str == '\0')
+        return 0;
+    for (; *str; str++){
+        if (*str < '0' || *str > '9')
+            return 0;
+        d = *str - '0';
+        if (v > (UINT64_MAX - d) / 10)
+            return 0;
+        v = v*10 + d;
+    }
+    if (n){
+        if (v > (uint64_t)INT64_MAX + 1)
+            return 0;
+        if (v == 0)
+            n = 0;
+        else
+            v = (uint64_t)(-(int64_t)(v - 1) - 1);
+    }
+    *neg = n;
+    *val = v;
+    return 1;
+}
+
+/*! Get integer value of XML leaf, using or setting the inline cache
+ *
+ * Applies only if the yang type is known to be integer, see YANG_FLAG_INTEGER
+ * @param[in]  x    XML node
+ * @param[out] neg  1 if negative, ie val is an int64, otherwise val is an uint64
+ * @param[out] val  Integer value
+ * @retval     1    OK
+ * @retval     0    Not applicable, use xml_cv_cache
+ */
+static int
+xml_num_cache(cxobj    *x,
+              int      *neg,
+              uint64_t *val)
+{
+    yang_stmt *y;
+    char      *body;
+
+    if (xml_num_get(x, neg, val) == 1)
+        return 1;
+    if ((y = xml_spec(x)) == NULL ||
+        yang_flag_get(y, YANG_FLAG_INTEGER) == 0)
+        return 0;
+    if ((body = xml_body(x)) == NULL)
+        return 0;
+    if (xml_num_parse(body, neg, val) == 0)
+        return 0;
+    xml_num_set(x, *neg, *val);
+    return 1;
+}
+
+/*! Compare integer values of two XML leafs if both are integers
+ *
+ * @param[in]  x1   XML node 1
+ * @param[in]  x2   XML node 2
+ * @param[out] cmp  <0, 0 or >0 as cv_cmp
+ * @retval     1    Compared
+ * @retval     0    Not applicable, use cv_cmp
+ */
+static int
+xml_num_cmp(cxobj *x1,
+            cxobj *x2,
+            int   *cmp)
+{
+    int      neg1;
+    int      neg2;
+    uint64_t v1;
+    uint64_t v2;
+
+    if (xml_num_cache(x1, &neg1, &v1) == 0 ||
+        xml_num_cache(x2, &neg2, &v2) == 0)
+        return 0;
+    if (neg1 != neg2)
+        *cmp = neg1 ? -1 : 1;
+    else if (neg1)
+        *cmp = ((int64_t)v1 > (int64_t)v2) - ((int64_t)v1 < (int64_t)v2);
+    else
+        *cmp = (v1 > v2) - (v1 < v2);
+    return 1;
+}
+#endif /* XML_NUM_CACHE */
+
 static int
 xml_cv_cache_clear(cxobj *xt)
 {
@@ -311,6 +446,10 @@ xml_cmp(cxobj  *x1,
             equal = -1;
         else if (b2 == NULL)
             equal = 1;
+#ifdef XML_NUM_CACHE
+        else if (indexvar == NULL && xml_num_cmp(x1, x2, &equal) == 1)
+            ;
+#endif
         else{
             if (xml_cv_cache(x1, &cv1) < 0) /* error case */
                 goto done;
@@ -346,6 +485,10 @@ xml_cmp(cxobj  *x1,
                     equal = -1;
                 else if (b2 == NULL)
                     equal = 1;
+#ifdef XML_NUM_CACHE
+                else if (xml_num_cmp(x1b, x2b, &equal) == 1)
+                    ;
+#endif
                 else{
                     if (xml_cv_cache(x1b, &cv1) < 0) /* error case */
                         goto done;
@@ -385,6 +528,10 @@ xml_cmp(cxobj  *x1,
                     equal = -1;
                 else if (b2 == NULL)
                     equal = 1;
+#ifdef XML_NUM_CACHE
+                else if (xml_num_cmp(x1b, x2b, &equal) == 1)
+                    ;
+#endif
                 else{
                     if (xml_cv_cache(x1b, &cv1) < 0) /* error case */
                         goto done;
@@ -433,11 +580,225 @@ int
 xml_sort_by(cxobj *x,
             char  *indexvar)
 {
+    int nattr;
+
     xml_enumerate_children(x); /* This is to make sorting "stable", ie not change existing order */
-    qsort_r(xml_childvec_get(x), xml_child_nr(x), sizeof(cxobj *), xml_cmp_qsort, indexvar);
+    /* Attributes are first and not sorted */
+    if ((nattr = xml_child_nr_attr(x)) < xml_child_nr(x)){
+        qsort_r(xml_childvec_get(x) + nattr, xml_child_nr(x) - nattr, sizeof(cxobj *), xml_cmp_qsort, indexvar);
+        xml_childvec_reordered(x);
+    }
     return 0;
 }
 
+/*! Sort key value of a child, extracted once per sort
+ *
+ * Rank orders missing key < empty body < no value < value, as in xml_cmp
+ */
+struct xml_sort_key {
+    int     sk_rank;
+    cg_var *sk_cv;
+};
+
+/*! Child of a node being sorted with its sort keys, see xml_sort_keys
+ */
+struct xml_sort_elem {
+    cxobj               *se_x;
+    yang_stmt           *se_y;
+    enum cxobj_type      se_type;
+    int                  se_nr;    /* Existing order */
+    int                  se_order; /* yang_order */
+    int                  se_keep;  /* Ordered-by user or state: keep existing order */
+    int                  se_nkeys;
+    struct xml_sort_key *se_keys;
+};
+
+/*! Compare two sort elements, same result as xml_cmp with same set
+ *
+ * @see xml_cmp
+ */
+static int
+xml_sort_elem_cmp(const void *arg1,
+                  const void *arg2)
+{
+    const struct xml_sort_elem *e1 = (const struct xml_sort_elem *)arg1;
+    const struct xml_sort_elem *e2 = (const struct xml_sort_elem *)arg2;
+    const struct xml_sort_key  *k1;
+    const struct xml_sort_key  *k2;
+    int                         equal;
+    int                         i;
+
+    if (e1->se_type != e2->se_type){
+        if (e1->se_type == CX_ATTR)
+            return -1;
+        else if (e2->se_type == CX_ATTR)
+            return 1;
+    }
+    if (e1->se_y == NULL && e2->se_y == NULL)
+        return e1->se_nr - e2->se_nr;
+    if (e1->se_y == NULL)
+        return -1;
+    if (e2->se_y == NULL)
+        return 1;
+    if (e1->se_y != e2->se_y){
+        if ((equal = e1->se_order - e2->se_order) != 0)
+            return equal;
+        /* Different yang of same order, keys are not comparable */
+        return xml_cmp(e1->se_x, e2->se_x, 1, 0, NULL);
+    }
+    if (e1->se_keep)
+        return e1->se_nr - e2->se_nr;
+    switch (yang_keyword_get(e1->se_y)){
+    case Y_LEAF_LIST:
+    case Y_LIST:
+        equal = 0;
+        for (i = 0; i < e1->se_nkeys && equal == 0; i++){
+            k1 = &e1->se_keys[i];
+            k2 = &e2->se_keys[i];
+            if ((equal = k1->sk_rank - k2->sk_rank) == 0 && k1->sk_cv != NULL)
+                equal = cv_cmp(k1->sk_cv, k2->sk_cv);
+        }
+        return equal;
+    default:
+        return e1->se_nr - e2->se_nr;
+    }
+}
+
+/*! Extract sort key of an XML node, a leaf-list entry or a list key
+ *
+ * @param[in]  x    XML node, or NULL if list key is missing
+ * @param[out] sk   Sort key
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+xml_sort_key_get(cxobj               *x,
+                 struct xml_sort_key *sk)
+{
+    sk->sk_cv = NULL;
+    if (x == NULL)
+        sk->sk_rank = 0;
+    else if (xml_body(x) == NULL)
+        sk->sk_rank = 1;
+    else {
+        if (xml_cv_cache(x, &sk->sk_cv) < 0)
+            return -1;
+        sk->sk_rank = sk->sk_cv ? 3 : 2;
+    }
+    return 0;
+}
+
+/*! Sort children of an XML node with sort keys extracted once
+ *
+ * Key values are extracted into an array once instead of in every comparison, and
+ * children that are already sorted, which is the common case, are not moved.
+ * @param[in] x   XML node, children enumerated
+ * @retval    1   OK, sorted
+ * @retval    0   Key value could not be parsed, sort with xml_cmp
+ * @retval   -1   Error
+ */
+static int
+xml_sort_keys(cxobj *x)
+{
+    int                   retval = -1;
+    struct xml_sort_elem *vec = NULL;
+    struct xml_sort_elem *se;
+    struct xml_sort_key  *keys = NULL;
+    cxobj               **childvec;
+    cxobj                *xc;
+    cxobj                *xb;
+    yang_stmt            *y;
+    yang_stmt            *yprev = NULL;
+    cvec                 *cvk;
+    cg_var               *cvi;
+    int                   n;
+    int                   nkeys = 0;
+    int                   order = 0;
+    int                   keep = 0;
+    int                   i;
+    int                   k;
+
+    n = xml_child_nr(x);
+    childvec = xml_childvec_get(x);
+    if ((vec = calloc(n, sizeof(*vec))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    /* Count keys */
+    for (i = 0; i < n; i++){
+        if ((y = xml_spec(childvec[i])) == NULL)
+            continue;
+        if (yang_keyword_get(y) == Y_LEAF_LIST)
+            nkeys++;
+        else if (yang_keyword_get(y) == Y_LIST && (cvk = yang_cvec_get(y)) != NULL)
+            nkeys += cvec_len(cvk);
+    }
+    if (nkeys && (keys = calloc(nkeys, sizeof(*keys))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    k = 0;
+    for (i = 0; i < n; i++){
+        xc = childvec[i];
+        se = &vec[i];
+        se->se_x = xc;
+        se->se_type = xml_type(xc);
+        se->se_nr = xml_enumerate_get(xc);
+        if ((y = xml_spec(xc)) == NULL)
+            continue;
+        se->se_y = y;
+        if (y != yprev){ /* Siblings are mostly of the same yang */
+            order = yang_order(y);
+            keep = (
+#ifndef STATE_ORDERED_BY_SYSTEM
+                    yang_config(y)==0 ||
+#endif
+                    yang_find(y, Y_ORDERED_BY, "user") != NULL);
+            yprev = y;
+        }
+        se->se_order = order;
+        se->se_keep = keep;
+        if (keep)
+            continue;
+        se->se_keys = &keys[k];
+        if (yang_keyword_get(y) == Y_LEAF_LIST){
+            if (xml_sort_key_get(xc, &keys[k++]) < 0)
+                goto fallback;
+            se->se_nkeys = 1;
+        }
+        else if (yang_keyword_get(y) == Y_LIST){
+            cvk = yang_cvec_get(y); /* Use Y_LIST cache, see ys_populate_list() */
+            cvi = NULL;
+            while ((cvi = cvec_each(cvk, cvi)) != NULL) {
+                xb = xml_find(xc, cv_string_get(cvi));
+                if (xml_sort_key_get(xb, &keys[k++]) < 0)
+                    goto fallback;
+                se->se_nkeys++;
+            }
+        }
+    }
+    /* Linear check first: data written by clixon is already sorted */
+    for (i = 1; i < n; i++)
+        if (xml_sort_elem_cmp(&vec[i-1], &vec[i]) > 0)
+            break;
+    if (i < n){
+        qsort(vec, n, sizeof(*vec), xml_sort_elem_cmp);
+        for (i = 0; i < n; i++)
+            childvec[i] = vec[i].se_x;
+        xml_childvec_reordered(x);
+    }
+    retval = 1;
+ done:
+    if (vec)
+        free(vec);
+    if (keys)
+        free(keys);
+    return retval;
+ fallback:
+    retval = 0;
+    goto done;
+}
+
 /*! Sort children of an XML node 
  *
  * Assume populated by yang spec.
@@ -451,6 +812,7 @@ xml_sort_by(cxobj *x,
 int
 xml_sort(cxobj *x)
 {
+    int        ret;
 #ifndef STATE_ORDERED_BY_SYSTEM
     yang_stmt *ys;
 
@@ -459,7 +821,44 @@ xml_sort(cxobj *x)
         return 1;
 #endif
     xml_enumerate_children(x); /* This is to make sorting "stable", ie not change existing order */
-    qsort_r(xml_childvec_get(x), xml_child_nr(x), sizeof(cxobj *), xml_cmp_qsort, NULL);
+    if (xml_child_nr(x) < 2)
+        return 0;
+    if ((ret = xml_sort_keys(x)) < 0)
+        return -1;
+    if (ret == 0){ /* Attributes are first and not sorted */
+        qsort_r(xml_childvec_get(x) + xml_child_nr_attr(x), xml_child_nr(x) - xml_child_nr_attr(x),
+                sizeof(cxobj *), xml_cmp_qsort, NULL);
+        xml_childvec_reordered(x);
+    }
+    return 0;
+}
+
+/*! Sort children of XML node unless already sorted, no recursion
+ *
+ * @param[in]  xn      XML node
+ * @retval     1       OK, node is not sortable
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @see xml_sort_recurse
+ */
+int
+xml_sort_level(cxobj *xn)
+{
+    int        ret;
+#ifndef STATE_ORDERED_BY_SYSTEM
+    yang_stmt *ys;
+
+    /* Abort sort if non-config (=state) data, as xml_sort_verify */
+    if ((ys = xml_spec(xn)) != NULL && yang_config_ancestor(ys) == 0)
+        return 1;
+#endif
+    /* xml_sort checks if already sorted */
+    if ((ret = xml_sort(xn)) < 0)
+        return -1;
+    if (ret == 1) /* This node is not sortable */
+        return 1;
+    if (xml_cv_cache_clear(xn) < 0)
+        return -1;
     return 0;
 }
 
@@ -477,17 +876,10 @@ xml_sort_recurse(cxobj *xn)
     cxobj *x;
     int    ret;
 
-    ret = xml_sort_verify(xn, NULL);
+    if ((ret = xml_sort_level(xn)) < 0)
+        goto done;
     if (ret == 1) /* This node is not sortable */
         goto ok;
-    if (ret == -1){ /* not sorted */
-        if ((ret = xml_sort(xn)) < 0)
-            goto done;
-        if (ret == 1) /* This node is not sortable */
-            goto ok;
-    }
-    if (xml_cv_cache_clear(xn) < 0)
-        goto done;
     x = NULL;
     while ((x = xml_child_each(xn, x, CX_ELMNT)) != NULL) {
         if (xml_sort_recurse(x) < 0)
@@ -556,10 +948,10 @@ xml_find_keys_notsorted(cxobj   *xp,
     return retval;
 }
 
-/*! Find more equal objects in a vector up and down in the array of the present
+/*! Find more equal children up and down from the present
  *
- * @param[in]  childvec  Vector of children of parent
- * @param[in]  childlen  Length of child vector
+ * Children are accessed by position, which does not move the gap of the child vector
+ * @param[in]  xp        Parent XML node
  * @param[in]  x1        XML node to match
  * @param[in]  yangi     Yang order number (according to spec)
  * @param[in]  mid       Where to start from (may be in middle of interval)
@@ -568,8 +960,7 @@ xml_find_keys_notsorted(cxobj   *xp,
  * @retval    -1         Error
  */
 static int
-search_multi_equals(cxobj  **childvec,
-                    size_t   childlen,
+search_multi_equals(cxobj   *xp,
                     cxobj   *x1,
                     int      yangi,
                     int      mid,
@@ -581,9 +972,11 @@ search_multi_equals(cxobj  **childvec,
     cxobj     *xc;
     yang_stmt *yc;
     int        yi;
+    int        childlen;
 
+    childlen = xml_child_nr(xp);
     for (i=mid-1; i>=0; i--){ /* First decrement */
-        xc = childvec[i];
+        xc = xml_child_i(xp, i);
         yc = xml_spec(xc);
         if ((yi = yang_order(yc)) < -1)
             goto done;
@@ -595,7 +988,7 @@ search_multi_equals(cxobj  **childvec,
             goto done;
     }
     for (i=mid+1; i<childlen; i++){ /* Then increment */
-        xc = childvec[i];
+        xc = xml_child_i(xp, i);
         yc = xml_spec(xc);
         if ((yi = yang_order(yc)) < -1)
             goto done;
@@ -831,8 +1224,7 @@ xml_search_binary(cxobj   *xp,
         if (clixon_xvec_append(xvec, xc) < 0)
             goto done;
         /* there may be more? */
-        if (search_multi_equals(xml_childvec_get(xp), xml_child_nr(xp),
-                                x1, yangi, mid, skip1, xvec) < 0)
+        if (search_multi_equals(xp, x1, yangi, mid, skip1, xvec) < 0)
             goto done;
     }
     else if (cmp < 0)
@@ -870,7 +1262,6 @@ xml_search_yang(cxobj       *xp,
                 clixon_xvec *xvec)
 {
     int    retval = -1;
-    cxobj *xa;
     int    low = 0;
     int    upper = xml_child_nr(xp);
     int    sorted = 1;
@@ -881,11 +1272,8 @@ xml_search_yang(cxobj       *xp,
         goto done;
     }
     upper = xml_child_nr(xp);
-    /* Assume if there are any attributes, they are first in the list, mask
-       them by raising low to skip them */
-    for (low=0; low<upper; low++)
-        if ((xa = xml_child_i(xp, low)) == NULL || xml_type(xa) != CX_ATTR)
-            break;
+    /* Attributes are first in the list, mask them by raising low to skip them */
+    low = xml_child_nr_attr(xp);
 #ifndef STATE_ORDERED_BY_SYSTEM
     /* Find if non-config and if ordered-by-user */
     if (yang_config_ancestor(yc)==0)
@@ -903,6 +1291,207 @@ xml_search_yang(cxobj       *xp,
     return retval;
 }
 
+/*! Binary search of the first child with yang order above (strict) or not below yangi
+ *
+ * @retval  1   OK, see pos
+ * @retval  0   A child has no yang spec
+ * @retval -1   Error
+ */
+static int
+xml_child_bound(cxobj *xp,
+                int    yangi,
+                int    low,
+                int    upper,
+                int    strict,
+                int   *pos)
+{
+    int        mid;
+    cxobj     *xc;
+    yang_stmt *y;
+    int        yi;
+
+    while (low < upper){
+        mid = (low + upper) / 2;
+        xc = xml_child_i(xp, mid);
+        if (xml_type(xc) != CX_ELMNT || (y = xml_spec(xc)) == NULL)
+            return 0;
+        if ((yi = yang_order(y)) < -1)
+            return -1;
+        if (yi < yangi || (strict && yi == yangi))
+            low = mid + 1;
+        else
+            upper = mid;
+    }
+    *pos = low;
+    return 1;
+}
+
+/*! Find all children of xp with yang spec yc using binary search on yang order
+ *
+ * Children of a node with yang spec are sorted on yang order, so all instances of a list or
+ * leaf-list are adjacent regardless of ordered-by. If system ordered, the first and last
+ * are also the min and max entries.
+ * @param[in]  xp   Parent XML node
+ * @param[in]  yc   Yang spec of children
+ * @param[out] lo   Index of first child
+ * @param[out] hi   Index after last child, equal to lo if none
+ * @retval     1    OK, see lo and hi
+ * @retval     0    Not applicable, a child has no yang spec
+ * @retval    -1    Error
+ */
+int
+xml_child_range_yang(cxobj     *xp,
+                     yang_stmt *yc,
+                     int       *lo,
+                     int       *hi)
+{
+    int    ret;
+    int    low;
+    int    upper;
+    int    yangi;
+
+    if ((yangi = yang_order(yc)) < -1)
+        return -1;
+    upper = xml_child_nr(xp);
+    /* Attributes are first, see xml_search_yang */
+    low = xml_child_nr_attr(xp);
+    if ((ret = xml_child_bound(xp, yangi, low, upper, 0, lo)) <= 0)
+        return ret;
+    return xml_child_bound(xp, yangi, *lo, upper, 1, hi);
+}
+
+/*! Parse key predicates of an insert key attribute on the simple form [k='v'][k2="w"]
+ *
+ * Prefixes of key names are removed.
+ * @param[in]  key_val  Key attribute value, eg [ex:name='a']
+ * @param[out] cvkp     Key names and values, free with cvec_free
+ * @retval     1        OK
+ * @retval     0        Not on simple form
+ * @retval    -1        Error
+ */
+static int
+xml_insert_keys(char  *key_val,
+                cvec **cvkp)
+{
+    int   retval = -1;
+    cvec *cvk = NULL;
+    char *str = NULL;
+    char *p;
+    char *name;
+    char *val;
+    char *s;
+    char  q;
+
+    if ((str = strdup(key_val)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    if ((cvk = cvec_new(0)) == NULL){
+        clixon_err(OE_UNIX, errno, "cvec_new");
+        goto done;
+    }
+    p = str;
+    while (*p != '\0'){
+        if (*p++ != '[')
+            goto fail;
+        name = p;
+        while (isalnum((unsigned char)*p) || *p == '_' || *p == '-' || *p == '.' || *p == ':')
+            p++;
+        if (p == name || *p != '=')
+            goto fail;
+        *p++ = '\0';
+        if ((s = index(name, ':')) != NULL)
+            name = s+1;
+        if ((q = *p) != '\'' && q != '"')
+            goto fail;
+        val = ++p;
+        if ((p = index(p, q)) == NULL)
+            goto fail;
+        *p++ = '\0';
+        if (*p++ != ']')
+            goto fail;
+        if (cvec_add_string(cvk, name, val) < 0){
+            clixon_err(OE_UNIX, errno, "cvec_add_string");
+            goto done;
+        }
+    }
+    if (cvec_len(cvk) == 0)
+        goto fail;
+    *cvkp = cvk;
+    cvk = NULL;
+    retval = 1;
+ done:
+    if (cvk)
+        cvec_free(cvk);
+    if (str)
+        free(str);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Check if an ordered-by user entry is the anchor of an insert before/after
+ *
+ * @param[in]  xc       List or leaf-list entry
+ * @param[in]  cvk      List key names and values, or NULL for leaf-list
+ * @param[in]  key_val  Leaf-list value
+ * @retval     1        Match
+ * @retval     0        No match
+ */
+static int
+xml_insert_anchor(cxobj  *xc,
+                  cvec   *cvk,
+                  char   *key_val)
+{
+    cg_var *cv;
+    char   *b;
+
+    if (cvk == NULL)
+        return (b = xml_body(xc)) != NULL && strcmp(b, key_val) == 0;
+    cv = NULL;
+    while ((cv = cvec_each(cvk, cv)) != NULL)
+        if ((b = xml_find_body(xc, cv_name_get(cv))) == NULL ||
+            strcmp(b, cv_string_get(cv)) != 0)
+            return 0;
+    return 1;
+}
+
+/* Parent and position of the last ordered-by user insert, start of anchor search
+ * Batches of inserts typically refer to the previous entry, or to one close to it
+ */
+static cxobj *_insert_hint_xp = NULL;
+static int    _insert_hint_pos = 0;
+
+/*! Find insert position of xn after or before an anchor given by xpath predicates
+ *
+ * Fallback of xml_insert_userorder for keys not on simple predicate form
+ * @retval    i       Order where xn should be inserted into xp:s children
+ * @retval   -1       Error
+ */
+static int
+xml_insert_userorder_xpath(cxobj           *xp,
+                           cxobj           *xn,
+                           yang_stmt       *yn,
+                           enum insert_type ins,
+                           char            *key_val,
+                           cvec            *nsc_key)
+{
+    int    retval = -1;
+    int    i;
+    cxobj *xc;
+
+    if ((xc = xpath_first(xp, nsc_key, "%s%s", xml_name(xn), key_val)) == NULL)
+        clixon_err(OE_YANG, 0, "bad-attribute: key, missing-instance: %s", key_val);
+    else {
+        if ((i = xml_child_order(xp, xc)) < 0)
+            clixon_err(OE_YANG, 0, "internal error xpath found but not in child list");
+        else
+            retval = (ins==INS_BEFORE)?i:i+1;
+    }
+    return retval;
+}
+
 /*! Insert xn in xp:s sorted child list (special case of ordered-by user)
  *
  * @param[in] xp      Parent xml node. If NULL just remove from old parent.
@@ -922,6 +1511,8 @@ xml_search_yang(cxobj       *xp,
  * LEAF-LIST: RFC7950 7.7.9 
  *                       yang:insert="after"
  *                       yang:value="3des-cbc">blowfish-cbc</cipher>)
+ * First and last are found by binary search. The anchor of before/after is searched
+ * outwards from the position of the previous insert.
  */
 static int
 xml_insert_userorder(cxobj           *xp,
@@ -933,67 +1524,81 @@ xml_insert_userorder(cxobj           *xp,
                      cvec            *nsc_key)
 {
     int        retval = -1;
-    int        i;
-    cxobj     *xc;
-    yang_stmt *yc;
+    int        i = 0;
+    int        first;
+    int        end;
+    int        upper;
+    int        h;
+    int        d;
+    int        ret;
+    cvec      *cvk = NULL;
 
+    /* All entries of yn are adjacent, binary search the first and the end */
+    first = 0;
+    upper = mid;
+    while (first < upper){
+        i = (first + upper) / 2;
+        if (xml_spec(xml_child_i(xp, i)) == yn)
+            upper = i;
+        else
+            first = i + 1;
+    }
+    end = mid + 1;
+    upper = xml_child_nr(xp);
+    while (end < upper){
+        i = (end + upper) / 2;
+        if (xml_spec(xml_child_i(xp, i)) == yn)
+            end = i + 1;
+        else
+            upper = i;
+    }
     switch (ins){
     case INS_FIRST:
-        for (i=mid-1; i>=0; i--){ /* decrement */
-            xc = xml_child_i(xp, i);
-            yc = xml_spec(xc);
-            if (yc != yn){
-                retval = i+1;
-                goto done;
-            }
-        }
-        retval = i+1;
+        retval = first;
         break;
     case INS_LAST:
-        for (i=mid+1; i<xml_child_nr(xp); i++){ /* First increment */
-            xc = xml_child_i(xp, i);
-            yc = xml_spec(xc);
-            if (yc != yn){
-                retval = i;
-                goto done;
-            }
-        }
-        retval = i;
+        retval = end;
         break;
     case INS_BEFORE:
     case INS_AFTER: /* see retval handling different between before and after */
-        if (key_val == NULL)
+        if (key_val == NULL){
             /* shouldnt happen */
             clixon_err(OE_YANG, 0, "Missing key/value attribute when insert is before");
-        else{
-            switch (yang_keyword_get(yn)){
-            case Y_LEAF_LIST:
-                if ((xc = xpath_first(xp, nsc_key, "%s[.='%s']", xml_name(xn), key_val)) == NULL)
-                    clixon_err(OE_YANG, 0, "bad-attribute: value, missing-instance: %s", key_val);
-                else {
-                    if ((i = xml_child_order(xp, xc)) < 0)
-                        clixon_err(OE_YANG, 0, "internal error xpath found but not in child list");
-                    else
-                        retval = (ins==INS_BEFORE)?i:i+1;
-                }
-                break;
-            case Y_LIST:
-                if ((xc = xpath_first(xp, nsc_key, "%s%s", xml_name(xn), key_val)) == NULL)
-                    clixon_err(OE_YANG, 0, "bad-attribute: key, missing-instance: %s", key_val);
-                else {
-                    if ((i = xml_child_order(xp, xc)) < 0)
-                        clixon_err(OE_YANG, 0, "internal error xpath found but not in child list");
-                    else
-                        retval = (ins==INS_BEFORE)?i:i+1;
-                }
+            break;
+        }
+        if (yang_keyword_get(yn) == Y_LIST &&
+            (ret = xml_insert_keys(key_val, &cvk)) <= 0){
+            if (ret == 0) /* Not simple key predicates */
+                retval = xml_insert_userorder_xpath(xp, xn, yn, ins, key_val, nsc_key);
+            break;
+        }
+        /* Search outwards from the previous insert, or from mid */
+        h = (xp == _insert_hint_xp) ? _insert_hint_pos : mid;
+        if (h < first || h >= end)
+            h = mid;
+        for (d = 0; h - d >= first || h + d < end; d++){
+            if (h + d < end && xml_insert_anchor(xml_child_i(xp, h + d), cvk, key_val)){
+                i = h + d;
                 break;
-            default:
-                clixon_err(OE_YANG, 0, "insert only for leaf or leaf-list");
+            }
+            if (d > 0 && h - d >= first && xml_insert_anchor(xml_child_i(xp, h - d), cvk, key_val)){
+                i = h - d;
                 break;
-            } /* switch */
+            }
         }
+        if (h - d < first && h + d >= end)
+            clixon_err(OE_YANG, 0, "bad-attribute: %s, missing-instance: %s",
+                       yang_keyword_get(yn) == Y_LIST?"key":"value", key_val);
+        else
+            retval = (ins==INS_BEFORE)?i:i+1;
+        break;
     }
- done:
+    if (retval >= 0){
+        _insert_hint_xp = xp;
+        _insert_hint_pos = retval;
+    }
+    if (cvk)
+        cvec_free(cvk);
     return retval;
 }
 
@@ -1108,7 +1713,6 @@ xml_insert(cxobj           *xp,
            cvec            *nsc_key)
 {
     int        retval = -1;
-    cxobj     *xa;
     int        low = 0;
     int        upper;
     yang_stmt *y;
@@ -1128,11 +1732,8 @@ xml_insert(cxobj           *xp,
         goto done;
     }
     upper = xml_child_nr(xp);
-    /* Assume if there are any attributes, they are first in the list, mask
-       them by raising low to skip them */
-    for (low=0; low<upper; low++)
-        if ((xa = xml_child_i(xp, low)) == NULL || xml_type(xa)!=CX_ATTR)
-            break;
+    /* Attributes are first in the list, mask them by raising low to skip them */
+    low = xml_child_nr_attr(xp);
     /* Find if non-config and if ordered-by-user */
 #ifndef STATE_ORDERED_BY_SYSTEM
     if (yang_config_ancestor(y)==0)
@@ -1158,6 +1759,52 @@ xml_insert(cxobj           *xp,
     return retval;
 }
 
+/*! Insert xi as child to xp at a suggested position if it is the sorted place
+ *
+ * Same as xml_insert with INS_LAST but the suggested position is checked first against
+ * its neighbours, which is constant time. Used when inserting many entries in order.
+ * @param[in] xp      Parent xml node
+ * @param[in] xi      Child xml node to insert under xp, without parent
+ * @param[in] pos     Suggested position in xp:s children, or -1
+ * @retval    0       OK
+ * @retval   -1       Error
+ * @see xml_insert
+ */
+int
+xml_insert_pos_hint(cxobj *xp,
+                    cxobj *xi,
+                    int    pos)
+{
+    int        retval = -1;
+    yang_stmt *y;
+    cxobj     *xc;
+
+    if (pos < xml_child_nr_attr(xp) || pos > xml_child_nr(xp) ||
+        xml_parent(xi) != NULL || (y = xml_spec(xi)) == NULL)
+        return xml_insert(xp, xi, INS_LAST, NULL, NULL);
+#ifndef STATE_ORDERED_BY_SYSTEM
+    if (yang_config_ancestor(y)==0)
+        return xml_insert(xp, xi, INS_LAST, NULL, NULL);
+#endif
+    if ((yang_keyword_get(y) != Y_LIST && yang_keyword_get(y) != Y_LEAF_LIST) ||
+        yang_find(y, Y_ORDERED_BY, "user") != NULL)
+        return xml_insert(xp, xi, INS_LAST, NULL, NULL);
+    /* Previous child must be smaller and next child larger */
+    if (pos > xml_child_nr_attr(xp) &&
+        ((xc = xml_child_i(xp, pos-1)) == NULL || xml_cmp(xc, xi, 0, 0, NULL) >= 0))
+        return xml_insert(xp, xi, INS_LAST, NULL, NULL);
+    if (pos < xml_child_nr(xp) &&
+        ((xc = xml_child_i(xp, pos)) == NULL || xml_cmp(xi, xc, 0, 0, NULL) >= 0))
+        return xml_insert(xp, xi, INS_LAST, NULL, NULL);
+    if (xml_child_insert_pos(xp, xi, pos) < 0)
+        goto done;
+    xml_parent_set(xi, xp);
+    nscache_clear(xi);
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Verify all children of XML node are sorted according to xml_sort()
  *
  * @param[in]   x    XML node. Check its children
@@ -1342,6 +1989,9 @@ xml_find_noyang_name(cxobj       *xp,
     /* Go through children linearly */
     xc = NULL;
     while ((xc = xml_child_each(xp, xc, CX_ELMNT)) != NULL) {
+        /* Check name first, cheaper than namespace lookup */
+        if (strcmp(name, xml_name(xc)) != 0) /* Name does not match, skip */
+            continue;
         ns = NULL;
         if (xml2ns(xc, xml_prefix(xc), &ns) < 0)
             goto done;
@@ -1349,8 +1999,6 @@ xml_find_noyang_name(cxobj       *xp,
             continue;
         if (strcmp(ns0, ns) != 0) /* Namespace does not match, skip */
             continue;
-        if (strcmp(name, xml_name(xc)) != 0) /* Namespace does not match, skip */
-            continue;
         if (cvk){       /* Check indexes */
             if (xml_find_noyang_cvk(ns0, xc, cvk, xvec) < 0)
                 goto done;
@@ -76,6 +76,9 @@
 #include <syslog.h>
 #include <fcntl.h>
 #include <math.h>  /* NaN */
+#ifdef HAVE_LIBPTHREAD
+#include <pthread.h>
+#endif
 
 /* cligen */
 #include <cligen/cligen.h>
@@ -99,6 +102,8 @@
 #include "clixon_xpath.h"
 #include "clixon_xpath_parse.h"
 #include "clixon_xpath_eval.h"
+#include "clixon_xpath_compile.h"
+#include "clixon_xpath_function.h"
 
 /* Use apostrophe(') in xpath literals, eg a/[x='foo'], not double-quotes(")
  * If not set, use ": a/[x="foo"]
@@ -527,10 +532,18 @@ xpath_tree_free(xpath_tree *xs)
         free(xs->xs_s0);
     if (xs->xs_s1)
         free(xs->xs_s1);
+#ifdef XML_NAME_INTERN
+    if (xs->xs_iname)
+        xml_name_intern_free(xs->xs_iname);
+#endif
     if (xs->xs_c0)
         xpath_tree_free(xs->xs_c0);
     if (xs->xs_c1)
         xpath_tree_free(xs->xs_c1);
+    if (xs->xs_prog)
+        xpath_prog_free(xs->xs_prog);
+    if (xs->xs_fnarg)
+        xp_fnarg_free(xs->xs_fnarg);
     free(xs);
     return 0;
 }
@@ -588,6 +601,9 @@ xpath_parse(const char  *xpath,
     }
     xpath_parse_exit(&xpy);
     xpath_scan_exit(&xpy);
+    if (xpath_eval_mode_get() != XPATH_EVAL_INTERPRET &&
+        xpath_compile(xpy.xpy_top, &xpy.xpy_top->xs_prog) < 0)
+        goto done;
     if (xptree){
         *xptree = xpy.xpy_top;
         xpy.xpy_top = NULL;
@@ -602,10 +618,255 @@ xpath_parse(const char  *xpath,
     return retval;
 }
 
+/*! Cached parsed XPath
+ *
+ * Entries are in a bucket list and in an LRU list, most recently used first.
+ * An entry in use by an evaluation is not evicted, see xpc_ref
+ * @see xpath_cache_get
+ */
+struct xpath_cache {
+    struct xpath_cache *xpc_next;    /* Next in bucket */
+    struct xpath_cache *xpc_lru_prev;
+    struct xpath_cache *xpc_lru_next;
+    uint32_t            xpc_hash;
+    char               *xpc_str;     /* XPath string */
+    xpath_tree         *xpc_tree;    /* Parsed XPath */
+    int                 xpc_ref;     /* Number of ongoing evaluations */
+};
+
+/* Parsed XPath cache, see CLICON_XPATH_CACHE_SIZE */
+#define XPATH_CACHE_BUCKETS 1024
+static struct xpath_cache *_xpath_cache_vec[XPATH_CACHE_BUCKETS] = {NULL,};
+static struct xpath_cache *_xpath_cache_lru = NULL;      /* Most recently used */
+static struct xpath_cache *_xpath_cache_lru_tail = NULL; /* Least recently used */
+static uint32_t            _xpath_cache_size = 0;        /* Max number of entries, 0: disabled */
+static uint32_t            _xpath_cache_nr = 0;
+static uint64_t            _xpath_cache_hits = 0;
+static uint64_t            _xpath_cache_misses = 0;
+#ifdef HAVE_LIBPTHREAD
+/* The library may be used by multi-threaded applications, eg clients using the client API */
+static pthread_mutex_t     _xpath_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+#define XPATH_CACHE_LOCK()   pthread_mutex_lock(&_xpath_cache_mutex)
+#define XPATH_CACHE_UNLOCK() pthread_mutex_unlock(&_xpath_cache_mutex)
+#else
+#define XPATH_CACHE_LOCK()
+#define XPATH_CACHE_UNLOCK()
+#endif
+
+/*! FNV-1a hash of an XPath string
+ */
+static uint32_t
+xpath_cache_hash(const char *str)
+{
+    uint32_t h = 2166136261u;
+
+    while (*str){
+        h ^= (uint8_t)*str++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/*! Unlink entry from LRU list
+ */
+static void
+xpath_cache_lru_rm(struct xpath_cache *xpc)
+{
+    if (xpc->xpc_lru_prev)
+        xpc->xpc_lru_prev->xpc_lru_next = xpc->xpc_lru_next;
+    else
+        _xpath_cache_lru = xpc->xpc_lru_next;
+    if (xpc->xpc_lru_next)
+        xpc->xpc_lru_next->xpc_lru_prev = xpc->xpc_lru_prev;
+    else
+        _xpath_cache_lru_tail = xpc->xpc_lru_prev;
+    xpc->xpc_lru_prev = xpc->xpc_lru_next = NULL;
+}
+
+/*! Insert entry first in LRU list
+ */
+static void
+xpath_cache_lru_add(struct xpath_cache *xpc)
+{
+    xpc->xpc_lru_prev = NULL;
+    xpc->xpc_lru_next = _xpath_cache_lru;
+    if (_xpath_cache_lru)
+        _xpath_cache_lru->xpc_lru_prev = xpc;
+    else
+        _xpath_cache_lru_tail = xpc;
+    _xpath_cache_lru = xpc;
+}
+
+/*! Remove and free a cache entry
+ */
+static void
+xpath_cache_free1(struct xpath_cache *xpc)
+{
+    struct xpath_cache **xpp;
+
+    for (xpp = &_xpath_cache_vec[xpc->xpc_hash % XPATH_CACHE_BUCKETS]; *xpp; xpp = &(*xpp)->xpc_next)
+        if (*xpp == xpc){
+            *xpp = xpc->xpc_next;
+            break;
+        }
+    xpath_cache_lru_rm(xpc);
+    _xpath_cache_nr--;
+    if (xpc->xpc_tree)
+        xpath_tree_free(xpc->xpc_tree);
+    free(xpc->xpc_str);
+    free(xpc);
+}
+
+/*! Evict least recently used entries not in use until the cache is within its size
+ */
+static void
+xpath_cache_evict(void)
+{
+    struct xpath_cache *xpc;
+    struct xpath_cache *xprev;
+
+    xpc = _xpath_cache_lru_tail;
+    while (xpc && _xpath_cache_nr > _xpath_cache_size){
+        xprev = xpc->xpc_lru_prev;
+        if (xpc->xpc_ref == 0)
+            xpath_cache_free1(xpc);
+        xpc = xprev;
+    }
+}
+
+/*! Set max number of entries of the parsed XPath cache
+ *
+ * @param[in]  size  Max number of cached parsed XPaths, 0 disables the cache
+ * @retval     0     OK
+ * @see option CLICON_XPATH_CACHE_SIZE
+ */
+int
+xpath_cache_size_set(uint32_t size)
+{
+    XPATH_CACHE_LOCK();
+    _xpath_cache_size = size;
+    xpath_cache_evict();
+    XPATH_CACHE_UNLOCK();
+    return 0;
+}
+
+/*! Get statistics of the parsed XPath cache
+ *
+ * @param[out] nr      Number of cached parsed XPaths
+ * @param[out] hits    Number of lookups that found a parsed XPath
+ * @param[out] misses  Number of lookups that parsed the XPath
+ * @retval     0       OK
+ */
+int
+xpath_cache_stats(uint64_t *nr,
+                  uint64_t *hits,
+                  uint64_t *misses)
+{
+    XPATH_CACHE_LOCK();
+    *nr = _xpath_cache_nr;
+    *hits = _xpath_cache_hits;
+    *misses = _xpath_cache_misses;
+    XPATH_CACHE_UNLOCK();
+    return 0;
+}
+
+/*! Get parsed XPath from the cache, parse and cache it if not found
+ *
+ * Release the entry with xpath_cache_put after evaluation
+ * @param[in]  xpath   String with XPath 1.0 syntax
+ * @param[out] xptree  Parsed XPath, do not modify or free
+ * @param[out] xpcp    Cache entry, or NULL if not cached. In that case free xptree after use
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+xpath_cache_get(const char          *xpath,
+                xpath_tree         **xptree,
+                struct xpath_cache **xpcp)
+{
+    int                 retval = -1;
+    struct xpath_cache *xpc;
+    uint32_t            hash;
+    xpath_tree         *xpt = NULL;
+
+    *xpcp = NULL;
+    if (_xpath_cache_size == 0 || xpath == NULL)
+        return xpath_parse(xpath, xptree);
+    hash = xpath_cache_hash(xpath);
+    XPATH_CACHE_LOCK();
+    for (xpc = _xpath_cache_vec[hash % XPATH_CACHE_BUCKETS]; xpc; xpc = xpc->xpc_next)
+        if (xpc->xpc_hash == hash && strcmp(xpc->xpc_str, xpath) == 0)
+            break;
+    if (xpc != NULL){
+        _xpath_cache_hits++;
+        xpc->xpc_ref++;
+        xpath_cache_lru_rm(xpc);
+        xpath_cache_lru_add(xpc);
+        *xptree = xpc->xpc_tree;
+        *xpcp = xpc;
+        XPATH_CACHE_UNLOCK();
+        goto ok;
+    }
+    _xpath_cache_misses++;
+    XPATH_CACHE_UNLOCK();
+    if (xpath_parse(xpath, &xpt) < 0)
+        goto done;
+    if ((xpc = calloc(1, sizeof(*xpc))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    if ((xpc->xpc_str = strdup(xpath)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        free(xpc);
+        goto done;
+    }
+    xpc->xpc_hash = hash;
+    xpc->xpc_tree = xpt;
+    xpc->xpc_ref = 1;
+    xpt = NULL;
+    /* Another thread may have added the same XPath meanwhile, a duplicate is evicted eventually */
+    XPATH_CACHE_LOCK();
+    xpc->xpc_next = _xpath_cache_vec[hash % XPATH_CACHE_BUCKETS];
+    _xpath_cache_vec[hash % XPATH_CACHE_BUCKETS] = xpc;
+    xpath_cache_lru_add(xpc);
+    _xpath_cache_nr++;
+    xpath_cache_evict();
+    XPATH_CACHE_UNLOCK();
+    *xptree = xpc->xpc_tree;
+    *xpcp = xpc;
+ ok:
+    retval = 0;
+ done:
+    if (xpt)
+        xpath_tree_free(xpt);
+    return retval;
+}
+
+/*! Release a parsed XPath got from xpath_cache_get
+ *
+ * @param[in]  xptree  Parsed XPath
+ * @param[in]  xpc     Cache entry, or NULL if xptree is not cached
+ */
+static void
+xpath_cache_put(xpath_tree         *xptree,
+                struct xpath_cache *xpc)
+{
+    if (xpc == NULL){
+        if (xptree)
+            xpath_tree_free(xptree);
+        return;
+    }
+    XPATH_CACHE_LOCK();
+    xpc->xpc_ref--;
+    xpath_cache_evict();
+    XPATH_CACHE_UNLOCK();
+}
+
 /*! Given XML tree and xpath, parse xpath, eval it and return xpath context, 
  *
  * This is a raw form of xpath where you can do type conversion of the return
  * value, etc, not just a nodeset.
+ * The parsed xpath is cached, see CLICON_XPATH_CACHE_SIZE
  * @param[in]  xcur   XML-tree where to search
  * @param[in]  nsc    External XML namespace context, or NULL
  * @param[in]  xpath  String with XPath 1.0 syntax
@@ -628,13 +889,60 @@ xpath_vec_ctx(cxobj      *xcur,
               int         localonly,
               xp_ctx    **xrp)
 {
-    int         retval = -1;
-    xpath_tree *xptree = NULL;
-    xp_ctx      xc = {0,};
+    int                 retval = -1;
+    xpath_tree         *xptree = NULL;
+    struct xpath_cache *xpc = NULL;
     
     clixon_debug(CLIXON_DBG_XPATH | CLIXON_DBG_DETAIL, "%s", xpath);
-    if (xpath_parse(xpath, &xptree) < 0)
+    if (xpath_cache_get(xpath, &xptree, &xpc) < 0)
+        goto done;
+    if (xpath_tree_vec_ctx(xcur, nsc, xptree, localonly, xrp) < 0)
         goto done;
+    retval = 0;
+ done:
+    xpath_cache_put(xptree, xpc);
+    return retval;
+}
+
+/*! Given XML tree and parsed xpath, eval it and return xpath context
+ *
+ * As xpath_vec_ctx but with an already parsed xpath, eg from yang_xpath_cache_get
+ * @param[in]  xcur   XML-tree where to search
+ * @param[in]  nsc    External XML namespace context, or NULL
+ * @param[in]  xptree Parsed XPath
+ * @param[in]  localonly Skip prefix and namespace tests (non-standard)
+ * @param[out] xrp    Return XPath context
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see xpath_vec_ctx
+ */
+int
+xpath_tree_vec_ctx(cxobj      *xcur,
+                   cvec       *nsc,
+                   xpath_tree *xptree,
+                   int         localonly,
+                   xp_ctx    **xrp)
+{
+    int         retval = -1;
+    xp_ctx      xc = {0,};
+    xp_ctx     *xr = NULL;
+    cbuf       *cb = NULL;
+
+    if (xptree->xs_prog != NULL){
+        switch (xpath_eval_mode_get()){
+        case XPATH_EVAL_COMPILE:
+            if (xpath_prog_eval(xptree->xs_prog, xcur, nsc, localonly, xrp) < 0)
+                goto done;
+            goto ok;
+            break;
+        case XPATH_EVAL_DIFFERENTIAL:
+            if (xpath_prog_eval(xptree->xs_prog, xcur, nsc, localonly, &xr) < 0)
+                goto done;
+            break;
+        default:
+            break;
+        }
+    }
     xc.xc_type = XT_NODESET;
     xc.xc_node = xcur;
     xc.xc_initial = xcur;
@@ -642,14 +950,29 @@ xpath_vec_ctx(cxobj      *xcur,
         goto done;
     if (xp_eval(&xc, xptree, nsc, localonly, xrp) < 0)
         goto done;
+    if (xr && xpath_prog_cmp(xr, *xrp) == 0){
+        if ((cb = cbuf_new()) == NULL){
+            clixon_err(OE_XML, errno, "cbuf_new");
+            goto done;
+        }
+        xpath_tree2cbuf(xptree, cb);
+        clixon_err(OE_XML, 0, "XPath %s: compiled result has %d nodes, interpreted has %d",
+                   cbuf_get(cb), xr->xc_size, (*xrp)->xc_size);
+        ctx_free(*xrp);
+        *xrp = NULL;
+        goto done;
+    }
+ ok:
     retval = 0;
  done:
+    if (cb)
+        cbuf_free(cb);
+    if (xr)
+        ctx_free(xr);
     if (xc.xc_nodeset){
         free(xc.xc_nodeset);
         xc.xc_nodeset = NULL;
     }
-    if (xptree)
-        xpath_tree_free(xptree);
     return retval;
 }
 
@@ -944,7 +1267,8 @@ xpath_vec_bool(cxobj      *xcur,
     va_list    ap;
     size_t     len;
     char      *xpath = NULL;
-    xp_ctx    *xr = NULL;
+    xpath_tree *xptree = NULL;
+    struct xpath_cache *xpc = NULL;
     
     va_start(ap, xpformat);    
     len = vsnprintf(NULL, 0, xpformat, ap);
@@ -962,15 +1286,56 @@ xpath_vec_bool(cxobj      *xcur,
         goto done;
     }
     va_end(ap);
-    if (xpath_vec_ctx(xcur, nsc, xpath, 0, &xr) < 0)
+    if (xpath_cache_get(xpath, &xptree, &xpc) < 0)
+        goto done;
+    retval = xpath_tree_vec_bool(xcur, nsc, xptree);
+ done:
+    xpath_cache_put(xptree, xpc);
+    if (xpath)
+        free(xpath);
+    return retval;
+}
+
+/*! Given XML tree and parsed xpath, returns boolean
+ *
+ * As xpath_vec_bool but with an already parsed xpath, eg from yang_xpath_cache_get
+ * @param[in]  xcur     xml-tree where to search
+ * @param[in]  nsc      External XML namespace context, or NULL
+ * @param[in]  xptree   Parsed XPath
+ * @retval     1        True
+ * @retval     0        False
+ * @retval    -1        Error
+ */
+int
+xpath_tree_vec_bool(cxobj      *xcur,
+                    cvec       *nsc,
+                    xpath_tree *xptree)
+{
+    int        retval = -1;
+    xp_ctx    *xr = NULL;
+    xp_ctx     xc = {0,};
+    int        n;
+    int        ret;
+
+    /* Location path: stop at first node */
+    xc.xc_type = XT_NODESET;
+    xc.xc_node = xcur;
+    xc.xc_initial = xcur;
+    xc.xc_nodeset = &xcur;
+    xc.xc_size = 1;
+    if ((ret = xp_eval_count(&xc, xptree, nsc, 0, 1, &n)) < 0)
+        goto done;
+    if (ret == 1){
+        retval = n?1:0;
+        goto done;
+    }
+    if (xpath_tree_vec_ctx(xcur, nsc, xptree, 0, &xr) < 0)
         goto done;
     if (xr)
         retval = ctx2boolean(xr);
  done:
     if (xr)
         ctx_free(xr);
-    if (xpath)
-        free(xpath);
     return retval;
 }
 
@@ -1292,25 +1657,24 @@ xpath_count(cxobj      *xcur,
     return retval;
 }
 
-/*! Given an XML node, build an xpath recursively to root, internal function
+/*! Print the xpath step of a single XML node, ie without its ancestors
  *
  * @param[in]  x      XML object
+ * @param[in]  y      Yang spec of x, or NULL
  * @param[in]  nsc    Namespace context
- * @param[in]  spec   If set, recursively continue only to root without spec
- * @param[in]  apostrophe   If set, use apostrophe in xpath literals, eg a/[x='foo'], not double-quotes(") * @param[out] cb     XPath string as cbuf.
+ * @param[in]  apostrophe   If set, use apostrophe in xpath literals, eg a/[x='foo'], not double-quotes(")
+ * @param[out] cb     XPath string as cbuf.
  * @retval     0      OK
  * @retval    -1      Error. eg XML malformed
  */
 static int
-xml2xpath1(cxobj *x,
-           cvec  *nsc,
-           int    spec,
-           int    apostrophe,
-           cbuf  *cb)
+xml2xpath_step(cxobj     *x,
+               yang_stmt *y,
+               cvec      *nsc,
+               int        apostrophe,
+               cbuf      *cb)
 {
     int           retval = -1;
-    cxobj        *xp;
-    yang_stmt    *y = NULL;
     cvec         *cvk = NULL; /* vector of index keys */
     cg_var       *cvi;
     char         *keyname;
@@ -1320,22 +1684,7 @@ xml2xpath1(cxobj *x,
     enum rfc_6020 keyword;
     char         *prefix = NULL;
     char         *namespace;
-    
-    if ((xp = xml_parent(x)) == NULL)
-        goto ok;
-    y = xml_spec(x);
 
-    if (spec && y == NULL)
-        goto ok;
-    /* Strip top-level netconf anydata, eg from get-config protocol processing */
-    if (y != NULL){
-        if (yang_keyword_get(y) == Y_ANYXML)
-            goto ok;
-        if (yang_keyword_get(y) == Y_ANYDATA)
-            goto ok;
-    }
-    if (xml2xpath1(xp, nsc, spec, apostrophe, cb) < 0)
-        goto done;
     if (nsc){
         if (xml2ns(x, xml_prefix(x), &namespace) < 0)
             goto done;
@@ -1399,11 +1748,107 @@ xml2xpath1(cxobj *x,
             break;
         }
     }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Given an XML node, build an xpath recursively to root, internal function
+ *
+ * @param[in]  x      XML object
+ * @param[in]  nsc    Namespace context
+ * @param[in]  spec   If set, recursively continue only to root without spec
+ * @param[in]  apostrophe   If set, use apostrophe in xpath literals, eg a/[x='foo'], not double-quotes(") * @param[out] cb     XPath string as cbuf.
+ * @retval     0      OK
+ * @retval    -1      Error. eg XML malformed
+ */
+static int
+xml2xpath1(cxobj *x,
+           cvec  *nsc,
+           int    spec,
+           int    apostrophe,
+           cbuf  *cb)
+{
+    int           retval = -1;
+    cxobj        *xp;
+    yang_stmt    *y = NULL;
+
+    if ((xp = xml_parent(x)) == NULL)
+        goto ok;
+    y = xml_spec(x);
+    if (spec && y == NULL)
+        goto ok;
+    /* Strip top-level netconf anydata, eg from get-config protocol processing */
+    if (y != NULL){
+        if (yang_keyword_get(y) == Y_ANYXML)
+            goto ok;
+        if (yang_keyword_get(y) == Y_ANYDATA)
+            goto ok;
+    }
+    if (xml2xpath1(xp, nsc, spec, apostrophe, cb) < 0)
+        goto done;
+    if (xml2xpath_step(x, y, nsc, apostrophe, cb) < 0)
+        goto done;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+#ifdef XML_PATH_CACHE
+/*! Given an XML node, get xpath to root using and building per-node path cache
+ *
+ * Same as xml2xpath1 with no namespace context and no apostrophe. The path of the parent
+ * is looked up recursively in the cache, so that only the last step is printed for
+ * siblings, eg all changed entries of a list after a commit.
+ * @param[in]  x      XML object
+ * @param[in]  spec   If set, recursively continue only to root without spec
+ * @param[out] pathp  XPath string, cached in x, do not free
+ * @retval     0      OK
+ * @retval    -1      Error. eg XML malformed
+ * @see xml_path_cache_get
+ */
+static int
+xml2xpath_cached(cxobj *x,
+                 int    spec,
+                 char **pathp)
+{
+    int        retval = -1;
+    cxobj     *xp;
+    yang_stmt *y;
+    char      *ppath = NULL;
+    cbuf      *cb = NULL;
+
+    if ((*pathp = xml_path_cache_get(x, spec)) != NULL)
+        goto ok;
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    y = xml_spec(x);
+    if ((xp = xml_parent(x)) == NULL ||
+        (spec && y == NULL) ||
+        (y != NULL && (yang_keyword_get(y) == Y_ANYXML ||
+                       yang_keyword_get(y) == Y_ANYDATA)))
+        ;
+    else {
+        if (xml2xpath_cached(xp, spec, &ppath) < 0)
+            goto done;
+        cprintf(cb, "%s", ppath);
+        if (xml2xpath_step(x, y, NULL, 0, cb) < 0)
+            goto done;
+    }
+    if (xml_path_cache_set(x, spec, cbuf_get(cb)) < 0)
+        goto done;
+    *pathp = xml_path_cache_get(x, spec);
  ok:
     retval = 0;
  done:
+    if (cb)
+        cbuf_free(cb);
     return retval;
 }
+#endif /* XML_PATH_CACHE */
 
 /*! Given an XML node, build an xpath to root
  *
@@ -1438,13 +1883,22 @@ xml2xpath(cxobj *x,
           char **xpathp)
 {
     int   retval = -1;
-    cbuf *cb;
+    cbuf *cb = NULL;
     char *xpath = NULL;
 
-    if ((cb = cbuf_new()) == NULL){
-        clixon_err(OE_XML, errno, "cbuf_new");
-        goto done;
+#ifdef XML_PATH_CACHE
+    if (nsc == NULL && apostrophe == 0){
+        if (xml2xpath_cached(x, spec, &xpath) < 0)
+            goto done;
+        if (xpathp && (*xpathp = strdup(xpath)) == NULL){
+            clixon_err(OE_UNIX, errno, "strdup");
+            goto done;
+        }
+        goto ok;
     }
+#endif
+    if ((cb = clixon_cbuf_borrow(0)) == NULL)
+        goto done;
     if (xml2xpath1(x, nsc, spec, apostrophe, cb) < 0)
         goto done;
     /* XXX: see xpath in test statement,.. */
@@ -1456,10 +1910,13 @@ xml2xpath(cxobj *x,
         }
         xpath = NULL;
     }
+#ifdef XML_PATH_CACHE
+ ok:
+#endif
     retval = 0;
  done:
     if (cb)
-        cbuf_free(cb);
+        clixon_cbuf_release(cb);
     return retval;
 }
 
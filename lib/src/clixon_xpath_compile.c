@@ -0,0 +1,594 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, indicate
+  your decision by deleting the provisions above and replace them with the
+  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Compiled XPath evaluator
+ * A parsed XPath tree is compiled to a flat sequence of instructions operating on two
+ * node-set buffers that are swapped between steps, instead of the recursive evaluation in
+ * xp_eval() that allocates a context per tree node.
+ * Only a subset of XPath is compiled: location paths of child, self and parent steps with
+ * predicates that are and-joined equalities of a child or self and a literal, eg
+ *   /a/b[k='1' and j=2]/c
+ * Other XPaths are not compiled and are evaluated by xp_eval(), which is the reference.
+ * @see CLICON_XPATH_EVAL
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h> /* NaN */
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_map.h"
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_err.h"
+#include "clixon_log.h"
+#include "clixon_debug.h"
+#include "clixon_xpath_ctx.h"
+#include "clixon_xpath.h"
+#include "clixon_xpath_optimize.h"
+#include "clixon_xpath_eval.h"
+#include "clixon_xpath_compile.h"
+
+/* Initial size of node-set buffers */
+#define XPC_BUF_INIT 16
+
+/*! Instruction operation codes
+ */
+enum xpc_op{
+    XPC_ROOT,     /* Replace node-set with the root of the context node */
+    XPC_CHILD,    /* Replace node-set with children matching nodetest */
+    XPC_PARENT,   /* Replace node-set with parents */
+    XPC_EQ_STR,   /* Filter node-set: <child>|. = '<string>' */
+    XPC_EQ_NR,    /* Filter node-set: <child>|. = <number> */
+};
+
+/*! A compiled instruction
+ *
+ * Tree pointers refer to the xpath tree that owns the program
+ */
+struct xpc_instr{
+    enum xpc_op  xi_op;
+    xpath_tree  *xi_step;     /* XPC_CHILD: step, for xpath_optimize_check */
+    xpath_tree  *xi_nodetest; /* XPC_CHILD, XPC_EQ_*: nodetest, NULL is self */
+    char        *xi_str;      /* XPC_EQ_STR: literal */
+    double       xi_nr;       /* XPC_EQ_NR: number */
+};
+
+/*! Compiled XPath program
+ */
+struct xpath_prog{
+    int               xp_len;
+    int               xp_max;
+    struct xpc_instr *xp_vec;
+};
+
+/*! Node-set buffer, grown geometrically and reused between steps
+ */
+struct xpc_buf{
+    cxobj **xb_vec;
+    int     xb_len;
+    int     xb_max;
+};
+
+/* Current evaluation mode, see CLICON_XPATH_EVAL */
+static int _xpath_eval_mode = XPATH_EVAL_INTERPRET;
+
+/*! Set XPath evaluation mode
+ *
+ * Cant use option since there is no handle in xpath functions
+ * Only XPaths parsed after the mode is set are compiled
+ * @param[in]  mode   XPath evaluation mode, see enum xpath_eval_mode
+ * @retval     0      OK
+ */
+int
+xpath_eval_mode_set(int mode)
+{
+    _xpath_eval_mode = mode;
+    return 0;
+}
+
+/*! Get XPath evaluation mode
+ */
+int
+xpath_eval_mode_get(void)
+{
+    return _xpath_eval_mode;
+}
+
+/*! Append an instruction to a program
+ */
+static struct xpc_instr *
+xpc_instr_add(struct xpath_prog *xp,
+              enum xpc_op        op)
+{
+    struct xpc_instr *xi;
+
+    if (xp->xp_len >= xp->xp_max){
+        xp->xp_max = xp->xp_max ? 2*xp->xp_max : 8;
+        if ((xp->xp_vec = realloc(xp->xp_vec, xp->xp_max*sizeof(*xi))) == NULL){
+            clixon_err(OE_UNIX, errno, "realloc");
+            return NULL;
+        }
+    }
+    xi = &xp->xp_vec[xp->xp_len++];
+    memset(xi, 0, sizeof(*xi));
+    xi->xi_op = op;
+    return xi;
+}
+
+/*! Check that a step has no predicates
+ */
+static int
+xpc_step_nopred(xpath_tree *xs)
+{
+    return xs->xs_c1 == NULL || (xs->xs_c1->xs_c0 == NULL && xs->xs_c1->xs_c1 == NULL);
+}
+
+/*! Compile an equality of a child or self and a literal
+ *
+ * @param[in]  xp    Program
+ * @param[in]  xs    XPath tree of type RELEX
+ * @retval     1     Compiled
+ * @retval     0     Not compilable
+ * @retval    -1     Error
+ */
+static int
+xpc_compile_eq(struct xpath_prog *xp,
+               xpath_tree        *xs)
+{
+    struct xpc_instr *xi;
+    xpath_tree       *xa;
+    xpath_tree       *xl;
+    int               i;
+
+    if (xs->xs_type != XP_RELEX || xs->xs_int != XO_EQ)
+        return 0;
+    for (i=0; i<2; i++){
+        xa = xp_unwrap(i?xs->xs_c1:xs->xs_c0, 0);
+        xl = xp_unwrap(i?xs->xs_c0:xs->xs_c1, 0);
+        if (xa == NULL || xl == NULL)
+            continue;
+        /* Relative location path of a single step */
+        if (xa->xs_type != XP_LOCPATH || (xa = xa->xs_c0) == NULL ||
+            xa->xs_type != XP_RELLOCPATH || xa->xs_int != A_NAN || xa->xs_c1 ||
+            (xa = xa->xs_c0) == NULL || xa->xs_type != XP_STEP || !xpc_step_nopred(xa))
+            continue;
+        if (xa->xs_int == A_CHILD){
+            if (xa->xs_c0 == NULL || xa->xs_c0->xs_type != XP_NODE)
+                continue;
+        }
+        else if (xa->xs_int != A_SELF)
+            continue;
+        if (xl->xs_type == XP_PRIME_STR && xl->xs_s0 != NULL){
+            if ((xi = xpc_instr_add(xp, XPC_EQ_STR)) == NULL)
+                return -1;
+            xi->xi_str = xl->xs_s0;
+        }
+        else if (xl->xs_type == XP_PRIME_NR){
+            if ((xi = xpc_instr_add(xp, XPC_EQ_NR)) == NULL)
+                return -1;
+            xi->xi_nr = xl->xs_double;
+        }
+        else
+            continue;
+        xi->xi_nodetest = xa->xs_int == A_CHILD ? xa->xs_c0 : NULL;
+        return 1;
+    }
+    return 0;
+}
+
+/*! Compile an and-expression of equalities
+ *
+ * The conjuncts are compiled as consecutive filters
+ */
+static int
+xpc_compile_and(struct xpath_prog *xp,
+                xpath_tree        *xs)
+{
+    int ret;
+
+    if (xs->xs_type != XP_AND)
+        return 0;
+    if (xs->xs_int == XO_AND){
+        if (xs->xs_c0 == NULL || xs->xs_c1 == NULL)
+            return 0;
+        if ((ret = xpc_compile_and(xp, xs->xs_c0)) <= 0)
+            return ret;
+        return xpc_compile_eq(xp, xs->xs_c1);
+    }
+    if (xs->xs_int != A_NAN || xs->xs_c0 == NULL)
+        return 0;
+    return xpc_compile_eq(xp, xs->xs_c0);
+}
+
+/*! Compile predicates, each predicate filters the result of the previous
+ */
+static int
+xpc_compile_pred(struct xpath_prog *xp,
+                 xpath_tree        *xs)
+{
+    int         ret;
+    xpath_tree *xe;
+
+    if (xs->xs_type != XP_PRED)
+        return 0;
+    if (xs->xs_c0 && (ret = xpc_compile_pred(xp, xs->xs_c0)) <= 0)
+        return ret;
+    if ((xe = xs->xs_c1) == NULL)
+        return 1;
+    if (xe->xs_type != XP_EXP || xe->xs_int != A_NAN || xe->xs_c0 == NULL || xe->xs_c1)
+        return 0;
+    return xpc_compile_and(xp, xe->xs_c0);
+}
+
+/*! Compile a step
+ */
+static int
+xpc_compile_step(struct xpath_prog *xp,
+                 xpath_tree        *xs)
+{
+    struct xpc_instr *xi;
+    xpath_tree       *xn;
+
+    if (xs->xs_type != XP_STEP)
+        return 0;
+    switch (xs->xs_int){
+    case A_CHILD:
+        if ((xn = xs->xs_c0) == NULL ||
+            (xn->xs_type != XP_NODE && xn->xs_type != XP_NODE_FN))
+            return 0;
+        if ((xi = xpc_instr_add(xp, XPC_CHILD)) == NULL)
+            return -1;
+        xi->xi_step = xs;
+        xi->xi_nodetest = xn;
+        break;
+    case A_SELF:
+        break;
+    case A_PARENT:
+        if (xpc_instr_add(xp, XPC_PARENT) == NULL)
+            return -1;
+        break;
+    default:
+        return 0;
+    }
+    if (xs->xs_c1 == NULL)
+        return 1;
+    return xpc_compile_pred(xp, xs->xs_c1);
+}
+
+/*! Compile a relative location path of '/'-separated steps
+ */
+static int
+xpc_compile_rellocpath(struct xpath_prog *xp,
+                       xpath_tree        *xs)
+{
+    int ret;
+
+    if (xs->xs_type == XP_STEP)
+        return xpc_compile_step(xp, xs);
+    if (xs->xs_type != XP_RELLOCPATH || xs->xs_int != A_NAN || xs->xs_c0 == NULL)
+        return 0;
+    if ((ret = xpc_compile_rellocpath(xp, xs->xs_c0)) <= 0)
+        return ret;
+    if (xs->xs_c1 == NULL)
+        return 1;
+    return xpc_compile_step(xp, xs->xs_c1);
+}
+
+/*! Compile a parsed XPath into a program
+ *
+ * @param[in]  xptree  Parsed XPath
+ * @param[out] xpp     Compiled program, or NULL if not compilable. Free with xpath_prog_free
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+int
+xpath_compile(xpath_tree         *xptree,
+              struct xpath_prog **xpp)
+{
+    int                retval = -1;
+    struct xpath_prog *xp = NULL;
+    xpath_tree        *xs;
+    int                ret;
+
+    *xpp = NULL;
+    if ((xp = malloc(sizeof(*xp))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    memset(xp, 0, sizeof(*xp));
+    if ((xs = xp_unwrap(xptree, 0)) == NULL || xs->xs_type != XP_LOCPATH ||
+        (xs = xs->xs_c0) == NULL)
+        goto ok;
+    if (xs->xs_type == XP_ABSPATH){
+        /* Neither "/" nor "//" */
+        if (xs->xs_int != A_ROOT || (xs = xs->xs_c0) == NULL)
+            goto ok;
+        if (xpc_instr_add(xp, XPC_ROOT) == NULL)
+            goto done;
+    }
+    if ((ret = xpc_compile_rellocpath(xp, xs)) < 0)
+        goto done;
+    if (ret == 0)
+        goto ok;
+    *xpp = xp;
+    xp = NULL;
+ ok:
+    retval = 0;
+ done:
+    if (xp)
+        xpath_prog_free(xp);
+    return retval;
+}
+
+/*! Free compiled XPath program
+ */
+int
+xpath_prog_free(struct xpath_prog *xp)
+{
+    if (xp->xp_vec)
+        free(xp->xp_vec);
+    free(xp);
+    return 0;
+}
+
+/*! Append node to node-set buffer
+ */
+static int
+xpc_buf_append(struct xpc_buf *xb,
+               cxobj          *x)
+{
+    if (xb->xb_len >= xb->xb_max){
+        xb->xb_max = xb->xb_max ? 2*xb->xb_max : XPC_BUF_INIT;
+        if ((xb->xb_vec = realloc(xb->xb_vec, xb->xb_max*sizeof(cxobj*))) == NULL){
+            clixon_err(OE_UNIX, errno, "realloc");
+            return -1;
+        }
+    }
+    xb->xb_vec[xb->xb_len++] = x;
+    return 0;
+}
+
+/*! Compare body of one node with the literal of an equality filter, see xp_relop()
+ */
+static int
+xpc_eq_body(struct xpc_instr *xi,
+            cxobj            *x)
+{
+    char  *b;
+    double n;
+
+    b = xml_body(x);
+    if (xi->xi_op == XPC_EQ_STR)
+        return b == NULL ? strlen(xi->xi_str) == 0 : strcmp(b, xi->xi_str) == 0;
+    if (b == NULL || sscanf(b, "%lf", &n) != 1)
+        n = NAN;
+    return n == xi->xi_nr;
+}
+
+/*! Evaluate an equality filter on one node
+ *
+ * True if the node itself (self) or any child matching the nodetest has the literal value
+ * @retval  1    Match
+ * @retval  0    No match
+ * @retval -1    Error
+ */
+static int
+xpc_eq(struct xpc_instr *xi,
+       cxobj            *x,
+       cvec             *nsc,
+       int               localonly)
+{
+    cxobj *xc;
+
+    if (xi->xi_nodetest == NULL)
+        return xpc_eq_body(xi, x);
+    if (xml_lazy_load(x) < 0)
+        return -1;
+    xc = NULL;
+    while ((xc = xml_child_each(x, xc, CX_ELMNT)) != NULL) {
+        if (nodetest_eval(xc, xi->xi_nodetest, nsc, localonly) == 1 &&
+            xpc_eq_body(xi, xc))
+            return 1;
+    }
+    return 0;
+}
+
+/*! Evaluate a compiled XPath on an XML tree
+ *
+ * @param[in]  xp     Compiled program
+ * @param[in]  xcur   XML-tree where to search
+ * @param[in]  nsc    External XML namespace context, or NULL
+ * @param[in]  localonly Skip prefix and namespace tests (non-standard)
+ * @param[out] xrp    Return XPath context of type nodeset, free with ctx_free
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see xpath_tree_vec_ctx
+ */
+int
+xpath_prog_eval(struct xpath_prog *xp,
+                cxobj             *xcur,
+                cvec              *nsc,
+                int                localonly,
+                xp_ctx           **xrp)
+{
+    int               retval = -1;
+    struct xpc_buf    bufs[2] = {{NULL, 0, 0}, {NULL, 0, 0}};
+    struct xpc_buf   *cur = &bufs[0];
+    struct xpc_buf   *next = &bufs[1];
+    struct xpc_buf   *tmp;
+    struct xpc_instr *xi;
+    xp_ctx           *xr = NULL;
+    cxobj            *x;
+    cxobj            *xv;
+    cxobj           **vec;
+    int               veclen;
+    int               pc;
+    int               i;
+    int               j;
+    int               ret;
+
+    if ((xr = malloc(sizeof(*xr))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    memset(xr, 0, sizeof(*xr));
+    xr->xc_type = XT_NODESET;
+    xr->xc_node = xcur;
+    xr->xc_initial = xcur;
+    if (xpc_buf_append(cur, xcur) < 0)
+        goto done;
+    for (pc=0; pc<xp->xp_len; pc++){
+        xi = &xp->xp_vec[pc];
+        switch (xi->xi_op){
+        case XPC_ROOT:
+            x = xcur;
+#ifdef XML_PARENT_CANDIDATE
+            while (xml_parent(x) != NULL || xml_parent_candidate(x) != NULL)
+                x = xml_parent(x)?xml_parent(x):xml_parent_candidate(x);
+#else
+            while (xml_parent(x) != NULL)
+                x = xml_parent(x);
+#endif
+            cur->xb_len = 0;
+            if (xpc_buf_append(cur, x) < 0)
+                goto done;
+            break;
+        case XPC_CHILD:
+            next->xb_len = 0;
+            for (i=0; i<cur->xb_len; i++){
+                xv = cur->xb_vec[i];
+                if (xml_lazy_load(xv) < 0)
+                    goto done;
+                vec = NULL;
+                veclen = 0;
+                if ((ret = xpath_optimize_check(xi->xi_step, xv, &vec, &veclen)) < 0)
+                    goto done;
+                if (ret == 1){ /* binary search made */
+                    for (j=0; j<veclen; j++)
+                        if (xpc_buf_append(next, vec[j]) < 0){
+                            free(vec);
+                            goto done;
+                        }
+                    if (vec)
+                        free(vec);
+                    continue;
+                }
+                x = NULL;
+                while ((x = xml_child_each(xv, x, CX_ELMNT)) != NULL) {
+                    if (nodetest_eval(x, xi->xi_nodetest, nsc, localonly) == 1)
+                        if (xpc_buf_append(next, x) < 0)
+                            goto done;
+                }
+            }
+            tmp = cur; cur = next; next = tmp;
+            break;
+        case XPC_PARENT:
+            next->xb_len = 0;
+            for (i=0; i<cur->xb_len; i++){
+                x = cur->xb_vec[i];
+                if ((xv = xml_parent(x)) != NULL
+#ifdef XML_PARENT_CANDIDATE
+                    || (xv = xml_parent_candidate(x)) != NULL
+#endif
+                    )
+                    if (xpc_buf_append(next, xv) < 0)
+                        goto done;
+            }
+            tmp = cur; cur = next; next = tmp;
+            break;
+        case XPC_EQ_STR:
+        case XPC_EQ_NR: /* Filter in place */
+            j = 0;
+            for (i=0; i<cur->xb_len; i++){
+                if ((ret = xpc_eq(xi, cur->xb_vec[i], nsc, localonly)) < 0)
+                    goto done;
+                if (ret == 1)
+                    cur->xb_vec[j++] = cur->xb_vec[i];
+            }
+            cur->xb_len = j;
+            break;
+        }
+    }
+    if (cur->xb_len){
+        xr->xc_nodeset = cur->xb_vec;
+        xr->xc_size = cur->xb_len;
+        cur->xb_vec = NULL;
+    }
+    *xrp = xr;
+    xr = NULL;
+    retval = 0;
+ done:
+    if (bufs[0].xb_vec)
+        free(bufs[0].xb_vec);
+    if (bufs[1].xb_vec)
+        free(bufs[1].xb_vec);
+    if (xr)
+        ctx_free(xr);
+    return retval;
+}
+
+/*! Compare result of compiled and interpreted evaluation
+ *
+ * @param[in]  xc1   Compiled result
+ * @param[in]  xc2   Interpreted result
+ * @retval     1     Equal
+ * @retval     0     Not equal
+ */
+int
+xpath_prog_cmp(xp_ctx *xc1,
+               xp_ctx *xc2)
+{
+    int i;
+
+    if (xc1->xc_type != xc2->xc_type || xc1->xc_size != xc2->xc_size)
+        return 0;
+    for (i=0; i<xc1->xc_size; i++)
+        if (xc1->xc_nodeset[i] != xc2->xc_nodeset[i])
+            return 0;
+    return 1;
+}
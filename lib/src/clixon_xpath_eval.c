@@ -130,18 +130,28 @@ nodetest_eval_node(cxobj      *x,
     char *name2 = NULL;
 
     /* Namespaces is s0, name is s1 */
-    if (strcmp(xs->xs_s1, "*")==0)
-        return 1;
-    /* get namespace of xml tree */
-    if (xml2ns(x, prefix1, &nsxml) < 0)
-        goto done;
     prefix2 = xs->xs_s0;
     name2 = xs->xs_s1;
     /* Before going into namespaces, check name equality and filter out noteq  */
-    if (strcmp(name1, name2) != 0){
+#ifdef XML_NAME_INTERN
+    /* Both interned: equal only if same pointer */
+    if (xs->xs_iname && xml_name_interned(x)){
+        if (name1 != xs->xs_iname){
+            retval = 0; /* no match */
+            goto done;
+        }
+    }
+    else
+#endif
+    if (name2[0] == '*' && name2[1] == '\0')
+        return 1;
+    else if (name1 != name2 && strcmp(name1, name2) != 0){
         retval = 0; /* no match */
         goto done;
     }
+    /* get namespace of xml tree */
+    if (xml2ns(x, prefix1, &nsxml) < 0)
+        goto done;
     /* Here names are equal
      * Now look for namespaces
      * 1) prefix1 and prefix2 point to same namespace <<-- try this first
@@ -197,11 +207,17 @@ nodetest_eval_node_localonly(cxobj      *x,
     char *name2 = NULL;
 
     /* Namespaces is s0, name is s1 */
-    if (strcmp(xs->xs_s1, "*")==0){
+    name2 = xs->xs_s1;
+#ifdef XML_NAME_INTERN
+    if (xs->xs_iname && xml_name_interned(x)){
+        retval = (name1 == xs->xs_iname);
+        goto done;
+    }
+#endif
+    if (name2[0] == '*' && name2[1] == '\0'){
         retval = 1;
         goto done;
     }
-    name2 = xs->xs_s1;
     /* Before going into namespaces, check name equality and filter out noteq  */
     if (strcmp(name1, name2) == 0){
         retval = 1;
@@ -224,7 +240,7 @@ nodetest_eval_node_localonly(cxobj      *x,
  * - node() is true for any node of any type whatsoever.
  * - text() is true for any text node.
  */
-static int
+int
 nodetest_eval(cxobj      *x,
               xpath_tree *xs,
               cvec       *nsc,
@@ -280,6 +296,8 @@ nodetest_recursive(cxobj      *xn,
     cxobj **vec = *vec0;
     int     veclen = *vec0len;
 
+    if (xml_lazy_load(xn) < 0)
+        goto done;
     xsub = NULL;
     while ((xsub = xml_child_each(xn, xsub, node_type)) != NULL) {
         if (nodetest_eval(xsub, nodetest, nsc, localonly) == 1){
@@ -299,6 +317,206 @@ nodetest_recursive(cxobj      *xn,
     return retval;
 }
 
+/*! Skip single-child wrapper nodes of an xpath expression tree
+ *
+ * The grammar wraps a primary expression in a chain of expr/andexpr/relexpr/.../step nodes
+ * without operators. The wrappers are evaluated as pass-through by xp_eval().
+ * Descend until a node with an operator or a second child is found.
+ * @param[in]  xs       XPath tree
+ * @param[in]  locpath  If set, also skip location path wrappers, eg to find the step
+ * @retval     xs       First node that is not a plain wrapper
+ */
+xpath_tree *
+xp_unwrap(xpath_tree *xs,
+          int         locpath)
+{
+    while (xs && xs->xs_c1 == NULL && xs->xs_int == A_NAN && xs->xs_s1 == NULL){
+        switch (xs->xs_type){
+        case XP_LOCPATH:
+        case XP_RELLOCPATH:
+            if (!locpath)
+                return xs;
+            xs = xs->xs_c0;
+            break;
+        case XP_EXP:
+        case XP_AND:
+        case XP_RELEX:
+        case XP_ADD:
+        case XP_UNION:
+        case XP_PATHEXPR:
+        case XP_FILTEREXPR:
+        case XP_PRI0:
+            xs = xs->xs_c0;
+            break;
+        default:
+            return xs;
+        }
+    }
+    return xs;
+}
+
+/*! Count children of a node matching a nodetest without building a node-set
+ *
+ * If the node has a yang spec, config children are sorted on yang order, and the instances
+ * of a named child are found with binary search in the child vector
+ * @param[in]     xv        XML node
+ * @param[in]     nodetest  XPath tree of type NODE or NODE_FN
+ * @param[in]     nsc       XML Namespace context
+ * @param[in]     localonly Skip prefix and namespace tests (non-standard)
+ * @param[in]     exists    Stop at first match
+ * @param[in,out] count     Incremented with number of matching children
+ * @retval        0         OK
+ * @retval       -1         Error
+ */
+static int
+xp_count_children(cxobj      *xv,
+                  xpath_tree *nodetest,
+                  cvec       *nsc,
+                  int         localonly,
+                  int         exists,
+                  int        *count)
+{
+    int        retval = -1;
+    cxobj     *x;
+    yang_stmt *yp;
+    yang_stmt *yc;
+    int        lo;
+    int        hi;
+    int        ret;
+
+    if (xml_lazy_load(xv) < 0)
+        goto done;
+    if (nodetest->xs_type == XP_NODE &&
+        strcmp(nodetest->xs_s1, "*") != 0 &&
+        (yp = xml_spec(xv)) != NULL &&
+        yang_keyword_get(yp) != Y_SPEC &&
+        (yc = yang_find_datanode(yp, nodetest->xs_s1)) != NULL &&
+        yang_config_ancestor(yc) != 0){ /* state data may not be sorted */
+        if ((ret = xml_child_range_yang(xv, yc, &lo, &hi)) < 0)
+            goto done;
+        if (ret == 1){
+            if (lo == hi)
+                goto ok;
+            if (nodetest_eval(xml_child_i(xv, lo), nodetest, nsc, localonly) == 1){
+                *count += exists ? 1 : hi - lo;
+                goto ok;
+            }
+        }
+    }
+    x = NULL;
+    while ((x = xml_child_each(xv, x, CX_ELMNT)) != NULL) {
+        if (nodetest_eval(x, nodetest, nsc, localonly) == 1){
+            (*count)++;
+            if (exists)
+                break;
+        }
+    }
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Count the nodes of a location path, or check if it is empty, without building the node-set
+ *
+ * Applies if the last step of the path is a child step without predicates, eg count(a/b)
+ * or a/b in a boolean context. The path before the last step is evaluated with xp_eval and
+ * the children of the resulting nodes are counted.
+ * @param[in]  xc        Incoming context
+ * @param[in]  xs        XPath node tree
+ * @param[in]  nsc       XML Namespace context
+ * @param[in]  localonly Skip prefix and namespace tests (non-standard)
+ * @param[in]  exists    Stop at first node, count is then 0 or 1
+ * @param[out] count     Number of nodes
+ * @retval     1         OK, see count
+ * @retval     0         Not applicable, use xp_eval
+ * @retval    -1         Error
+ * @see xp_function_count
+ */
+int
+xp_eval_count(xp_ctx     *xc,
+              xpath_tree *xs,
+              cvec       *nsc,
+              int         localonly,
+              int         exists,
+              int        *count)
+{
+    int         retval = -1;
+    xpath_tree *xl;     /* Relative location path */
+    xpath_tree *xstep;  /* Last step */
+    xpath_tree *xpre = NULL; /* Relative location path before last step */
+    xp_ctx     *xr = NULL;
+    xp_ctx      xroot = {0,};
+    cxobj      *x;
+    cxobj      *xroot1;
+    int         abs = 0;
+    int         i;
+
+    if (xc->xc_descendant || xc->xc_type != XT_NODESET)
+        goto ok;
+    if ((xl = xp_unwrap(xs, 0)) == NULL || xl->xs_type != XP_LOCPATH || (xl = xl->xs_c0) == NULL)
+        goto ok;
+    if (xl->xs_type == XP_ABSPATH){
+        if (xl->xs_int != A_ROOT || (xl = xl->xs_c0) == NULL)
+            goto ok;
+        abs++;
+    }
+    if (xl->xs_type != XP_RELLOCPATH || xl->xs_int != A_NAN)
+        goto ok;
+    if (xl->xs_c1){
+        xpre = xl->xs_c0;
+        xstep = xl->xs_c1;
+    }
+    else
+        xstep = xl->xs_c0;
+    if (xstep == NULL || xstep->xs_type != XP_STEP || xstep->xs_int != A_CHILD ||
+        xstep->xs_c0 == NULL ||
+        (xstep->xs_c0->xs_type != XP_NODE && xstep->xs_c0->xs_type != XP_NODE_FN))
+        goto ok;
+    if (xstep->xs_c1 && (xstep->xs_c1->xs_c0 || xstep->xs_c1->xs_c1)) /* predicates */
+        goto ok;
+    if (abs){
+        /* Set context node to top node, as in xp_eval ABSPATH */
+        x = xc->xc_node;
+#ifdef XML_PARENT_CANDIDATE
+        while (xml_parent(x) != NULL || xml_parent_candidate(x) != NULL)
+            x = xml_parent(x)?xml_parent(x):xml_parent_candidate(x);
+#else
+        while (xml_parent(x) != NULL)
+            x = xml_parent(x);
+#endif
+        xroot1 = x;
+        xroot.xc_type = XT_NODESET;
+        xroot.xc_node = x;
+        xroot.xc_initial = xc->xc_initial;
+        xroot.xc_nodeset = &xroot1;
+        xroot.xc_size = 1;
+        xc = &xroot;
+    }
+    if (xpre){
+        if (xp_eval(xc, xpre, nsc, localonly, &xr) < 0)
+            goto done;
+        if (xr->xc_type != XT_NODESET)
+            goto ok;
+        xc = xr;
+    }
+    *count = 0;
+    for (i=0; i<xc->xc_size; i++){
+        if (xp_count_children(xc->xc_nodeset[i], xstep->xs_c0, nsc, localonly, exists, count) < 0)
+            goto done;
+        if (exists && *count)
+            break;
+    }
+    retval = 1;
+ done:
+    if (xr)
+        ctx_free(xr);
+    return retval;
+ ok: /* not applicable */
+    retval = 0;
+    goto done;
+}
+
 /*! Evaluate xpath step rule of an XML tree
  *
  * @param[in]  xc0       Incoming context
@@ -356,6 +574,8 @@ xp_eval_step(xp_ctx     *xc0,
             for (i=0; i<xc->xc_size; i++){
                 xv = xc->xc_nodeset[i];
                 x = NULL;
+                if (xml_lazy_load(xv) < 0)
+                    goto done;
                 if ((ret = xpath_optimize_check(xs, xv, &vec, &veclen)) < 0)
                     goto done;
                 if (ret == 0){/* regular code, no optimization made */
@@ -495,6 +715,8 @@ xp_eval_predicate(xp_ctx     *xc,
     int      i;
     cxobj   *x;
     xp_ctx  *xcc = NULL;
+    int      n;
+    int      ret;
 
     if (xs->xs_c0 != NULL){ /* eval previous predicates */
         if (xp_eval(xc, xs->xs_c0, nsc, localonly, &xr0) < 0)
@@ -533,6 +755,17 @@ xp_eval_predicate(xp_ctx     *xc,
              * evaluated with that node as the context node */
             if (cxvec_append(x, &xcc->xc_nodeset, &xcc->xc_size) < 0)
                 goto done;
+            /* Existence of a location path, eg [a/b], stop at first node */
+            if ((ret = xp_eval_count(xcc, xs->xs_c1, nsc, localonly, 1, &n)) < 0)
+                goto done;
+            if (ret == 1){
+                ctx_free(xcc);
+                xcc = NULL;
+                if (n)
+                    if (cxvec_append(x, &xr1->xc_nodeset, &xr1->xc_size) < 0)
+                        goto done;
+                continue;
+            }
             if (xp_eval(xcc, xs->xs_c1, nsc, localonly, &xrc) < 0)
                 goto done;
             ctx_free(xcc);
@@ -1191,77 +1424,15 @@ xp_eval(xp_ctx     *xc,
         break;
     case XP_PRIME_FN:
         if (xs->xs_s0){
-            switch (xs->xs_int){
-            case XPATHFN_CURRENT:
-                if (xp_function_current(xc, xs->xs_c0, nsc, localonly, xrp) < 0)
-                    goto done;
-                goto ok;
-                break;
-            case XPATHFN_DEREF:
-                if (xp_function_deref(xc, xs->xs_c0, nsc, localonly, xrp) < 0)
-                    goto done;
-                goto ok;
-                break;
-            case XPATHFN_DERIVED_FROM:
-                if (xp_function_derived_from(xc, xs->xs_c0, nsc, localonly, 0, xrp) < 0)
-                    goto done;
-                goto ok;
-                break;
-            case XPATHFN_DERIVED_FROM_OR_SELF:
-                if (xp_function_derived_from(xc, xs->xs_c0, nsc, localonly, 1, xrp) < 0)
-                    goto done;
-                goto ok;
-                break;
-            case XPATHFN_BIT_IS_SET:
-                if (xp_function_bit_is_set(xc, xs->xs_c0, nsc, localonly, xrp) < 0)
-                    goto done;
-                goto ok;
-                break;
-            case XPATHFN_POSITION:
-                if (xp_function_position(xc, xs->xs_c0, nsc, localonly, xrp) < 0)
-                    goto done;
-                goto ok;
-                break;
-            case XPATHFN_COUNT:
-                if (xp_function_count(xc, xs->xs_c0, nsc, localonly, xrp) < 0)
-                    goto done;
-                goto ok;
-                break;
-            case XPATHFN_NAME:
-                if (xp_function_name(xc, xs->xs_c0, nsc, localonly, xrp) < 0)
-                    goto done;
-                goto ok;
-                break;
-            case XPATHFN_CONTAINS:
-                if (xp_function_contains(xc, xs->xs_c0, nsc, localonly, xrp) < 0)
-                    goto done;
-                goto ok;
-                break;
-            case XPATHFN_BOOLEAN:
-                if (xp_function_boolean(xc, xs->xs_c0, nsc, localonly, xrp) < 0)
-                    goto done;
-                goto ok;
-                break;
-            case XPATHFN_NOT:
-                if (xp_function_not(xc, xs->xs_c0, nsc, localonly, xrp) < 0)
-                    goto done;
-                goto ok;
-                break;
-            case XPATHFN_TRUE:
-                if (xp_function_true(xc, xs->xs_c0, nsc, localonly, xrp) < 0)
-                    goto done;
-                goto ok;
-                break;
-            case XPATHFN_FALSE:
-                if (xp_function_false(xc, xs->xs_c0, nsc, localonly, xrp) < 0)
-                    goto done;
-                goto ok;
-                break;
-            default:
+            /* Function resolved when parsing, see xp_primary_function */
+            if (xs->xs_fn == NULL &&
+                (xs->xs_fn = xp_function_fn(xs->xs_int)) == NULL){
                 clixon_err(OE_XML, EFAULT, "XPath function not implemented: %s", xs->xs_s0);
                 goto done;
-                break;
             }
+            if (xs->xs_fn(xc, xs->xs_c0, nsc, localonly, xrp) < 0)
+                goto done;
+            goto ok;
         }
         break;
     default:
@@ -45,6 +45,9 @@ extern const map_str2int xpopmap[];
 /*
  * Prototypes
  */
+xpath_tree *xp_unwrap(xpath_tree *xs, int locpath);
+int nodetest_eval(cxobj *x, xpath_tree *xs, cvec *nsc, int localonly);
+int xp_eval_count(xp_ctx *xc, xpath_tree *xs, cvec *nsc, int localonly, int exists, int *count);
 int xp_eval(xp_ctx *xc, xpath_tree *xs, cvec *nsc, int localonly, xp_ctx **xrp);
 
 #endif /* _CLIXON_XPATH_EVAL_H */
@@ -67,6 +67,8 @@
 #include "clixon_debug.h"
 #include "clixon_options.h"
 #include "clixon_yang_type.h"
+#include "clixon_xml_nsctx.h"
+#include "clixon_regex.h"
 #include "clixon_xml_map.h"
 #include "clixon_yang_module.h"
 #include "clixon_validate.h"
@@ -136,6 +138,71 @@ xp_fnname_int2str(enum clixon_xpath_function code)
     return clicon_int2str(xpath_fnname_map, code);
 }
 
+/*! Pre-compiled constant argument of an xpath function call
+ *
+ * Cached on the argument list of the call in the xpath tree the first time the function is
+ * evaluated, and freed with the tree.
+ * The string argument is borrowed from the literal of the tree.
+ * @see xp_fnarg_get
+ */
+struct xp_fnarg {
+    char      *fa_str;     /* Literal string argument, or NULL if not constant */
+    void      *fa_regex;   /* re-match: compiled posix regex of fa_str */
+    char      *fa_prefix;  /* derived-from: prefix of identity */
+    char      *fa_id;      /* derived-from: identity without prefix */
+    yang_stmt *fa_yspec;   /* derived-from: yang spec of resolved identity */
+    char      *fa_ns;      /* derived-from: namespace of resolved identity */
+    yang_stmt *fa_ybase;   /* derived-from: resolved identity, may be NULL */
+};
+typedef struct xp_fnarg xp_fnarg;
+
+/*! Get constant argument cache of the second argument of a function call
+ *
+ * @param[in]  xs   XPath node tree of function arguments
+ * @retval     fa   Argument cache, fa_str is set if second argument is a literal
+ * @retval     NULL Error
+ */
+static xp_fnarg *
+xp_fnarg_get(struct xpath_tree *xs)
+{
+    xpath_tree *xl;
+    xp_fnarg   *fa;
+
+    if ((fa = xs->xs_fnarg) != NULL)
+        return fa;
+    if ((fa = malloc(sizeof(*fa))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        return NULL;
+    }
+    memset(fa, 0, sizeof(*fa));
+    if ((xl = xp_unwrap(xs->xs_c1, 0)) != NULL &&
+        xl->xs_type == XP_PRIME_STR)
+        fa->fa_str = xl->xs_s0;
+    xs->xs_fnarg = fa;
+    return fa;
+}
+
+/*! Free constant argument cache of a function call
+ *
+ * @param[in]  fa   Argument cache
+ * @retval     0    OK
+ * @see xpath_tree_free
+ */
+int
+xp_fnarg_free(xp_fnarg *fa)
+{
+    if (fa->fa_regex)
+        cligen_regex_posix_free(fa->fa_regex);
+    if (fa->fa_prefix)
+        free(fa->fa_prefix);
+    if (fa->fa_id)
+        free(fa->fa_id);
+    if (fa->fa_ns)
+        free(fa->fa_ns);
+    free(fa);
+    return 0;
+}
+
 int
 xp_function_current(xp_ctx            *xc0,
                     struct xpath_tree *xs,
@@ -162,6 +229,105 @@ xp_function_current(xp_ctx            *xc0,
     return retval;
 }
 
+/*! Eval xpath function re-match
+ *
+ * Signature: boolean re-match(string subject, string pattern)
+ * The pattern is a XSD regular expression, translated to posix.
+ * If the pattern is a literal, it is compiled once and cached in the xpath tree, otherwise it is
+ * compiled for each call.
+ * @param[in]  xc   Incoming context
+ * @param[in]  xs   XPath node tree
+ * @param[in]  nsc  XML Namespace context
+ * @param[in]  localonly Skip prefix and namespace tests (non-standard)
+ * @param[out] xrp  Resulting context
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see RFC 7950 Sec 10.2.1
+ * Example: re-match(., '\d{1,3}\.\d{1,3}\.\d{1,3}\.\d{1,3}')
+ */
+int
+xp_function_re_match(xp_ctx            *xc,
+                     struct xpath_tree *xs,
+                     cvec              *nsc,
+                     int                localonly,
+                     xp_ctx           **xrp)
+{
+    int       retval = -1;
+    xp_ctx   *xr0 = NULL;
+    xp_ctx   *xr1 = NULL;
+    xp_ctx   *xr = NULL;
+    char     *s0 = NULL;
+    char     *s1 = NULL;
+    char     *posix = NULL;
+    void     *re = NULL;
+    void     *re1 = NULL; /* Per-call regex if pattern is not a literal */
+    xp_fnarg *fa;
+    int       ret;
+
+    if (xs == NULL || xs->xs_c0 == NULL || xs->xs_c1 == NULL){
+        clixon_err(OE_XML, EINVAL, "re-match expects but did not get two arguments");
+        goto done;
+    }
+    if (xp_eval(xc, xs->xs_c0, nsc, localonly, &xr0) < 0)
+        goto done;
+    if (ctx2string(xr0, &s0) < 0)
+        goto done;
+    if ((fa = xp_fnarg_get(xs)) == NULL)
+        goto done;
+    if (fa->fa_str != NULL && fa->fa_regex != NULL)
+        re = fa->fa_regex;
+    else {
+        if (fa->fa_str == NULL){
+            if (xp_eval(xc, xs->xs_c1, nsc, localonly, &xr1) < 0)
+                goto done;
+            if (ctx2string(xr1, &s1) < 0)
+                goto done;
+        }
+        if (regexp_xsd2posix(fa->fa_str?fa->fa_str:s1, &posix) < 0)
+            goto done;
+        if ((ret = cligen_regex_posix_compile(posix, &re1)) < 0)
+            goto done;
+        if (ret == 0){
+            clixon_err(OE_XML, 0, "re-match: regexp compile fail: \"%s\"",
+                       fa->fa_str?fa->fa_str:s1);
+            goto done;
+        }
+        re = re1;
+        if (fa->fa_str != NULL){
+            fa->fa_regex = re1;
+            re1 = NULL;
+        }
+    }
+    if ((ret = cligen_regex_posix_exec(re, s0)) < 0)
+        goto done;
+    if ((xr = malloc(sizeof(*xr))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    memset(xr, 0, sizeof(*xr));
+    xr->xc_type = XT_BOOL;
+    xr->xc_bool = ret;
+    *xrp = xr;
+    xr = NULL;
+    retval = 0;
+ done:
+    if (re1)
+        cligen_regex_posix_free(re1);
+    if (posix)
+        free(posix);
+    if (xr0)
+        ctx_free(xr0);
+    if (xr1)
+        ctx_free(xr1);
+    if (xr)
+        ctx_free(xr);
+    if (s0)
+        free(s0);
+    if (s1)
+        free(s1);
+    return retval;
+}
+
 int
 xp_function_deref(xp_ctx            *xc0,
                   struct xpath_tree *xs,
@@ -180,6 +346,8 @@ xp_function_deref(xp_ctx            *xc0,
     yang_stmt  *yt;
     yang_stmt  *ypath;
     char       *path;
+    int         leafref = 0;
+    int         ret;
 
     /* Create new xc */
     if ((xc = ctx_dup(xc0)) == NULL)
@@ -193,27 +361,82 @@ xp_function_deref(xp_ctx            *xc0,
             goto done;
         if (strcmp(yang_argument_get(yt), "leafref") == 0){
             if ((ypath = yang_find(yt, Y_PATH, NULL)) != NULL){
-                path = yang_argument_get(ypath);
-                if ((xref = xpath_first(xv, nsc, "%s", path)) != NULL)
+                /* Absolute paths are looked up in an index of referred nodes if possible */
+                if ((ret = xml_leafref_index_lookup(xv, ys, ypath, &xref)) < 0)
+                    goto done;
+                if (ret == 0){
+                    path = yang_argument_get(ypath);
+                    xref = xpath_first(xv, nsc, "%s", path);
+                }
+                if (xref != NULL)
                     if (cxvec_append(xref, &vec, &veclen) < 0)
                         goto done;
             }
-            ctx_nodeset_replace(xc, vec, veclen);
+            leafref++;
         }
         else if (strcmp(yang_argument_get(yt), "identityref") == 0){
         }
     }
+    if (leafref){
+        ctx_nodeset_replace(xc, vec, veclen);
+        vec = NULL;
+    }
     *xrp = xc;
     xc = NULL;
     retval = 0;
  done:
+    if (vec)
+        free(vec);
     if (xc)
         ctx_free(xc);
     return retval;
 }
 
+/*! Helper function for derived-from(-and-self) - resolve base identity
+ *
+ * The resolved identity is cached in the argument cache and reused as long as the yang spec
+ * and the namespace of the identity prefix are the same.
+ * @param[in]  fa      Argument cache, fa_id is set
+ * @param[in]  yspec   Yang spec of node
+ * @param[in]  nsc     XML Namespace context
+ * @param[out] ybasep  Base identity or NULL if not found
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+derived_from_base(xp_fnarg  *fa,
+                  yang_stmt *yspec,
+                  cvec      *nsc,
+                  yang_stmt **ybasep)
+{
+    char      *ns;
+    yang_stmt *ymod;
+
+    if ((ns = xml_nsctx_get(nsc, fa->fa_prefix)) == NULL){
+        *ybasep = NULL;
+        return 0;
+    }
+    if (fa->fa_yspec != yspec || fa->fa_ns == NULL || strcmp(fa->fa_ns, ns) != 0){
+        if (fa->fa_ns)
+            free(fa->fa_ns);
+        if ((fa->fa_ns = strdup(ns)) == NULL){
+            clixon_err(OE_UNIX, errno, "strdup");
+            return -1;
+        }
+        fa->fa_yspec = yspec;
+        /* if ymodule is a sub-module, the identity may be found in a sub-module of ymod */
+        if ((ymod = yang_find_module_by_namespace(yspec, ns)) != NULL)
+            fa->fa_ybase = yang_find(ymod, Y_IDENTITY, fa->fa_id);
+        else
+            fa->fa_ybase = NULL;
+    }
+    *ybasep = fa->fa_ybase;
+    return 0;
+}
+
 /*! Helper function for derived-from(-and-self) - eval one node
  *
+ * @param[in]  fa   Argument cache with split base identity
  * @param[in]  nsc  XML Namespace context
  * @param[in]  self If set, implements derived_from_or_self
  * @retval     1    OK and match
@@ -221,26 +444,21 @@ xp_function_deref(xp_ctx            *xc0,
  * @retval    -1    Error
  */
 static int
-derived_from_one(char  *baseidentity,
-                 cvec  *nsc,
-                 cxobj *xleaf,
-                 int    self)
+derived_from_one(xp_fnarg *fa,
+                 cvec     *nsc,
+                 cxobj    *xleaf,
+                 int       self)
 {
     int        retval = -1;
     yang_stmt *yleaf;
     yang_stmt *ytype;
     yang_stmt *ybaseid;
     yang_stmt *ymod;
-    cvec      *idrefvec; /* Derived identityref list: (module:id)**/
     char      *node = NULL;
     char      *prefix = NULL;
     char      *id = NULL;
     cbuf      *cb = NULL;
-    char      *baseid = NULL;
 
-    /* Split baseidentity to get its id (w/o prefix) */
-    if (nodeid_split(baseidentity, NULL, &baseid) < 0)
-        goto done;
     if ((yleaf = xml_spec(xleaf)) == NULL)
         goto nomatch;
     if (yang_keyword_get(yleaf) != Y_LEAF && yang_keyword_get(yleaf) != Y_LEAF_LIST)
@@ -257,10 +475,10 @@ derived_from_one(char  *baseidentity,
      * yleaf type identityref{base interface-type;}
      */
     /* Just get the object corresponding to the base identity */
-    if ((ybaseid = yang_find_identity_nsc(ys_spec(yleaf), baseidentity, nsc)) == NULL)
+    if (derived_from_base(fa, ys_spec(yleaf), nsc, &ybaseid) < 0)
+        goto done;
+    if (ybaseid == NULL)
         goto nomatch;
-    /* Get its list of derived identities  */
-    idrefvec = yang_cvec_get(ybaseid);
     /* Get and split the leaf id reference */
     if ((node = xml_body(xleaf)) == NULL) /* It may not be empty */
         goto nomatch;
@@ -277,7 +495,7 @@ derived_from_one(char  *baseidentity,
     /* self special case, ie that the xleaf has a ref to itself */
     if (self &&
         ymod == ys_module(ybaseid) &&
-        strcmp(baseid, id) == 0){
+        strcmp(fa->fa_id, id) == 0){
         ; /* match */
     }
     else {
@@ -287,13 +505,11 @@ derived_from_one(char  *baseidentity,
             goto done;
         }
         cprintf(cb, "%s:%s", yang_argument_get(ymod), id);
-        if (cvec_find(idrefvec, cbuf_get(cb)) == NULL)
+        if (!yang_identity_derived(ybaseid, cbuf_get(cb)))
             goto nomatch;
     }
     retval = 1;
  done:
-    if (baseid)
-        free(baseid);
     if (cb)
         cbuf_free(cb);
     if (id)
@@ -308,6 +524,8 @@ derived_from_one(char  *baseidentity,
 
 /*! Eval xpath function derived-from(-and-self)
  *
+ * If the identity is a literal, it is split and resolved once and cached in the xpath tree,
+ * otherwise it is evaluated and split for each call.
  * @param[in]  xc   Incoming context
  * @param[in]  xs   XPath node tree
  * @param[in]  nsc  XML Namespace context
@@ -335,6 +553,8 @@ xp_function_derived_from(xp_ctx            *xc,
     xp_ctx    *xr1 = NULL;
     xp_ctx    *xr = NULL;
     char      *identity = NULL;
+    xp_fnarg  *fa;
+    xp_fnarg   fa0 = {0,}; /* Per-call cache if identity is not a literal */
     int        i;
     int        ret = 0;
 
@@ -348,11 +568,23 @@ xp_function_derived_from(xp_ctx            *xc,
         goto done;
     if (xr0->xc_type != XT_NODESET)
         goto done;
-    /* This evolves to a string identity */
-    if (xp_eval(xc, xs->xs_c1, nsc, localonly, &xr1) < 0)
-        goto done;
-    if (ctx2string(xr1, &identity) < 0)
+    if ((fa = xp_fnarg_get(xs)) == NULL)
         goto done;
+    if (fa->fa_str != NULL){
+        if (fa->fa_id == NULL &&
+            nodeid_split(fa->fa_str, &fa->fa_prefix, &fa->fa_id) < 0)
+            goto done;
+    }
+    else {
+        /* This evolves to a string identity */
+        if (xp_eval(xc, xs->xs_c1, nsc, localonly, &xr1) < 0)
+            goto done;
+        if (ctx2string(xr1, &identity) < 0)
+            goto done;
+        fa = &fa0;
+        if (nodeid_split(identity, &fa->fa_prefix, &fa->fa_id) < 0)
+            goto done;
+    }
     /* Allocate a return struct of type boolean */
     if ((xr = malloc(sizeof(*xr))) == NULL){
         clixon_err(OE_UNIX, errno, "malloc");
@@ -362,7 +594,7 @@ xp_function_derived_from(xp_ctx            *xc,
     xr->xc_type = XT_BOOL;
     /* ANY node is an identityref and its value an identity that is derived ... */
     for (i=0; i<xr0->xc_size; i++){
-        if ((ret = derived_from_one(identity, nsc, xr0->xc_nodeset[i], self)) < 0)
+        if ((ret = derived_from_one(fa, nsc, xr0->xc_nodeset[i], self)) < 0)
             goto done;
         if (ret == 1)
             break;
@@ -372,6 +604,12 @@ xp_function_derived_from(xp_ctx            *xc,
     xr = NULL;
     retval = 0;
  done:
+    if (fa0.fa_prefix)
+        free(fa0.fa_prefix);
+    if (fa0.fa_id)
+        free(fa0.fa_id);
+    if (fa0.fa_ns)
+        free(fa0.fa_ns);
     if (xr0)
         ctx_free(xr0);
     if (xr1)
@@ -383,6 +621,34 @@ xp_function_derived_from(xp_ctx            *xc,
     return retval;
 }
 
+/*! Eval xpath function derived-from
+ *
+ * @see xp_function_derived_from
+ */
+static int
+xp_function_derived_from0(xp_ctx            *xc,
+                          struct xpath_tree *xs,
+                          cvec              *nsc,
+                          int                localonly,
+                          xp_ctx           **xrp)
+{
+    return xp_function_derived_from(xc, xs, nsc, localonly, 0, xrp);
+}
+
+/*! Eval xpath function derived-from-or-self
+ *
+ * @see xp_function_derived_from
+ */
+static int
+xp_function_derived_from_or_self(xp_ctx            *xc,
+                                 struct xpath_tree *xs,
+                                 cvec              *nsc,
+                                 int                localonly,
+                                 xp_ctx           **xrp)
+{
+    return xp_function_derived_from(xc, xs, nsc, localonly, 1, xrp);
+}
+
 /*! Returns true if the first node value has a bit set
  *
  * The bit-is-set() function returns "true" if the first node in
@@ -506,20 +772,28 @@ xp_function_count(xp_ctx            *xc,
     int         retval = -1;
     xp_ctx     *xr = NULL;
     xp_ctx     *xr0 = NULL;
+    int         count = 0;
+    int         ret;
 
     if (xs == NULL || xs->xs_c0 == NULL){
         clixon_err(OE_XML, EINVAL, "count expects but did not get one argument");
         goto done;
     }
-    if (xp_eval(xc, xs->xs_c0, nsc, localonly, &xr0) < 0)
+    /* Count without building the node-set if possible */
+    if ((ret = xp_eval_count(xc, xs->xs_c0, nsc, localonly, 0, &count)) < 0)
         goto done;
+    if (ret == 0){
+        if (xp_eval(xc, xs->xs_c0, nsc, localonly, &xr0) < 0)
+            goto done;
+        count = xr0->xc_size;
+    }
     if ((xr = malloc(sizeof(*xr))) == NULL){
         clixon_err(OE_UNIX, errno, "malloc");
         goto done;
     }
     memset(xr, 0, sizeof(*xr));
     xr->xc_type = XT_NUMBER;
-    xr->xc_number = xr0->xc_size;
+    xr->xc_number = count;
     *xrp = xr;
     retval = 0;
  done:
@@ -664,14 +938,20 @@ xp_function_boolean(xp_ctx            *xc,
     xp_ctx     *xr = NULL;
     xp_ctx     *xr0 = NULL;
     int         bool;
+    int         ret;
 
     if (xs == NULL || xs->xs_c0 == NULL){
         clixon_err(OE_XML, EINVAL, "not expects but did not get one argument");
         goto done;
     }
-    if (xp_eval(xc, xs->xs_c0, nsc, localonly, &xr0) < 0)
+    /* Existence of a location path, stop at first node */
+    if ((ret = xp_eval_count(xc, xs->xs_c0, nsc, localonly, 1, &bool)) < 0)
         goto done;
-    bool = ctx2boolean(xr0);
+    if (ret == 0){
+        if (xp_eval(xc, xs->xs_c0, nsc, localonly, &xr0) < 0)
+            goto done;
+        bool = ctx2boolean(xr0);
+    }
     if ((xr = malloc(sizeof(*xr))) == NULL){
         clixon_err(OE_UNIX, errno, "malloc");
         goto done;
@@ -757,3 +1037,46 @@ xp_function_false(xp_ctx            *xc,
  done:
     return retval;
 }
+
+/*! XPath function implementations
+ *
+ * Not implemented functions are not present
+ * @see xp_function_fn
+ */
+static const struct {
+    enum clixon_xpath_function fd_code;
+    xpath_fn_t                *fd_fn;
+} xpath_fn_table[] = {
+    {XPATHFN_CURRENT,              xp_function_current},
+    {XPATHFN_RE_MATCH,             xp_function_re_match},
+    {XPATHFN_DEREF,                xp_function_deref},
+    {XPATHFN_DERIVED_FROM,         xp_function_derived_from0},
+    {XPATHFN_DERIVED_FROM_OR_SELF, xp_function_derived_from_or_self},
+    {XPATHFN_BIT_IS_SET,           xp_function_bit_is_set},
+    {XPATHFN_POSITION,             xp_function_position},
+    {XPATHFN_COUNT,                xp_function_count},
+    {XPATHFN_NAME,                 xp_function_name},
+    {XPATHFN_CONTAINS,             xp_function_contains},
+    {XPATHFN_BOOLEAN,              xp_function_boolean},
+    {XPATHFN_NOT,                  xp_function_not},
+    {XPATHFN_TRUE,                 xp_function_true},
+    {XPATHFN_FALSE,                xp_function_false},
+};
+
+/*! Translate xpath function code to its implementation
+ *
+ * Called when parsing so that evaluation calls the function directly
+ * @param[in]  code  XPath function code
+ * @retval     fn    Function implementation
+ * @retval     NULL  Not implemented
+ */
+xpath_fn_t *
+xp_function_fn(enum clixon_xpath_function code)
+{
+    int i;
+
+    for (i=0; i<sizeof(xpath_fn_table)/sizeof(xpath_fn_table[0]); i++)
+        if (xpath_fn_table[i].fd_code == code)
+            return xpath_fn_table[i].fd_fn;
+    return NULL;
+}
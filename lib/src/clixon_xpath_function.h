@@ -48,7 +48,7 @@
  */
 enum clixon_xpath_function{
     XPATHFN_CURRENT,                /* RFC 7950 10.1.1 */
-    XPATHFN_RE_MATCH,               /* RFC 7950 10.2.1 NYI */
+    XPATHFN_RE_MATCH,               /* RFC 7950 10.2.1 */
     XPATHFN_DEREF,                  /* RFC 7950 10.3.1 */
     XPATHFN_DERIVED_FROM,           /* RFC 7950 10.4.1 */
     XPATHFN_DERIVED_FROM_OR_SELF,   /* RFC 7950 10.4.2 */
@@ -92,8 +92,11 @@ enum clixon_xpath_function{
  */
 int xp_fnname_str2int(char *fnname);
 const char *xp_fnname_int2str(enum clixon_xpath_function code);
+xpath_fn_t *xp_function_fn(enum clixon_xpath_function code);
+int xp_fnarg_free(struct xp_fnarg *fa);
 
 int xp_function_current(xp_ctx *xc, struct xpath_tree *xs, cvec *nsc, int localonly, xp_ctx **xrp);
+int xp_function_re_match(xp_ctx *xc, struct xpath_tree *xs, cvec *nsc, int localonly, xp_ctx **xrp);
 int xp_function_deref(xp_ctx *xc, struct xpath_tree *xs, cvec *nsc, int localonly, xp_ctx **xrp);
 int xp_function_derived_from(xp_ctx *xc, struct xpath_tree *xs, cvec *nsc, int localonly, int self, xp_ctx **xrp);
 int xp_function_bit_is_set(xp_ctx *xc, struct xpath_tree *xs, cvec *nsc, int localonly, xp_ctx **xrp);
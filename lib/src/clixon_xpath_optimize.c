@@ -69,26 +69,64 @@
 #include "clixon_xpath_ctx.h"
 #include "clixon_xpath.h"
 #include "clixon_xpath_optimize.h"
+#include "clixon_xpath_eval.h"
 
 #ifdef XPATH_LIST_OPTIMIZE
-static xpath_tree *_xmtop = NULL; /* pattern match tree top */
-static xpath_tree *_xm = NULL;
-static xpath_tree *_xe = NULL;
 static int _optimize_enable = 1;
 static int _optimize_hits = 0;
+static int _optimize_rule_hits[XPATH_OPT_NR] = {0,};
+
+/*! Optimizer rule names, indexed by enum xpath_optimize_rule
+ */
+static const map_str2int xpath_optimize_rule_map[] = {
+    {"list-key",     XPATH_OPT_LIST_KEY},
+    {"leaf-list",    XPATH_OPT_LEAF_LIST},
+    {"search-index", XPATH_OPT_SEARCH_INDEX},
+    {NULL,           -1}
+};
 #endif /* XPATH_LIST_OPTIMIZE */
 
-/* XXX development in clixon_xpath_eval */
+/*! Get and reset optimization hit counters
+ *
+ * @param[out] hits     Total number of optimized steps (or NULL)
+ * @param[out] rulehits Vector of XPATH_OPT_NR hit counters, one per rule (or NULL)
+ * @retval     0        OK
+ * @see xpath_optimize_rule2str
+ */
 int
-xpath_list_optimize_stats(int *hits)
+xpath_list_optimize_stats(int *hits,
+                          int *rulehits)
 {
 #ifdef XPATH_LIST_OPTIMIZE
-    *hits = _optimize_hits;
+    int i;
+
+    if (hits)
+        *hits = _optimize_hits;
     _optimize_hits = 0;
+    for (i=0; i<XPATH_OPT_NR; i++){
+        if (rulehits)
+            rulehits[i] = _optimize_rule_hits[i];
+        _optimize_rule_hits[i] = 0;
+    }
 #endif
     return 0;
 }
 
+/*! Translate optimizer rule to string
+ *
+ * @param[in]  rule   Optimizer rule, see enum xpath_optimize_rule
+ * @retval     str    Name of rule, or NULL
+ */
+const char *
+xpath_optimize_rule2str(int rule)
+{
+#ifdef XPATH_LIST_OPTIMIZE
+    return clicon_int2str(xpath_optimize_rule_map, rule);
+#else
+    return NULL;
+#endif
+}
+
 /*! Enable xpath optimize
  *
  * Cant replace this with option since there is no handle in xpath functions,...
@@ -102,152 +140,218 @@ xpath_list_optimize_set(int enable)
     return 0;
 }
 
+/*! Reset xpath optimizer
+ */
 void
 xpath_optimize_exit(void)
 {
 #ifdef XPATH_LIST_OPTIMIZE
-    if (_xmtop)
-        xpath_tree_free(_xmtop);
+    xpath_list_optimize_stats(NULL, NULL);
 #endif
 }
 
 #ifdef XPATH_LIST_OPTIMIZE
-/*! Initialize xpath module
+/*! Match an equality <id>=<literal> or <literal>=<id>
  *
- * XXX move to clixon_xpath.c 
- * @see loop_preds
+ * <id> is a single child step without prefix and predicates, or "." (self)
+ * @param[in]  xs    XPath tree of type RELEX
+ * @param[out] id    Name of child, or "."
+ * @param[out] val   Literal value
+ * @retval     1     Match
+ * @retval     0     No match
  */
-int
-xpath_optimize_init(xpath_tree **xm,
-                    xpath_tree **xe)
+static int
+xpath_optimize_eq(xpath_tree *xs,
+                  char      **id,
+                  char      **val)
 {
-    int         retval = -1;
-    xpath_tree *xs;
+    xpath_tree *xi;
+    xpath_tree *xl;
+    xpath_tree *xn;
+    int         i;
 
-    if (_xm == NULL){
-        /* Initialize xpath-tree */
-        if (xpath_parse("_x[_y='_z']", &_xmtop) < 0)
-            goto done;
-        /* Go down two steps */
-        if ((_xm = xpath_tree_traverse(_xmtop, 0, 0, -1)) == NULL)
-            goto done;
-        /* get nodetest tree (_x) */
-        if ((xs = xpath_tree_traverse(_xm, 0, -1)) == NULL)
-            goto done;
-        xs->xs_match++;
-        /* get predicates [_y=_z][z=2] */
-        if ((xs = xpath_tree_traverse(_xm, 1, -1)) == NULL)
-            goto done;
-        xs->xs_match++;
-        /* get expression [_y=_z] */
-        if ((_xe = xpath_tree_traverse(xs, 1, -1)) == NULL)
-            goto done;
-        /* get keyname (_y) */
-        if ((xs = xpath_tree_traverse(_xe, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, -1)) == NULL)
-            goto done;
-        xs->xs_match++; /* in loop_preds get name in xs_s1 XXX: leaf-list is different */
-        /* get keyval (_z) */
-        if ((xs = xpath_tree_traverse(_xe, 0, 0, 1, 0, 0, 0, 0, -1)) == NULL)
-            goto done;
-        xs->xs_match++; /* in loop_preds get value in xs_s0 or xs_strnr */
+    if (xs->xs_type != XP_RELEX || xs->xs_int != XO_EQ)
+        return 0;
+    for (i=0; i<2; i++){
+        xi = xp_unwrap(i?xs->xs_c1:xs->xs_c0, 1);
+        xl = xp_unwrap(i?xs->xs_c0:xs->xs_c1, 1);
+        if (xi == NULL || xl == NULL || xi->xs_type != XP_STEP)
+            continue;
+        if (xi->xs_c1 && (xi->xs_c1->xs_c0 || xi->xs_c1->xs_c1)) /* predicates */
+            continue;
+        if (xl->xs_type == XP_PRIME_STR)
+            *val = xl->xs_s0;
+        else if (xl->xs_type == XP_PRIME_NR)
+            *val = xl->xs_strnr;
+        else
+            continue;
+        if (*val == NULL)
+            continue;
+        if (xi->xs_int == A_SELF)
+            *id = ".";
+        else if (xi->xs_int == A_CHILD &&
+                 (xn = xi->xs_c0) != NULL &&
+                 xn->xs_type == XP_NODE &&
+                 xn->xs_s1 != NULL &&
+                 strcmp(xn->xs_s1, "*") != 0)
+            *id = xn->xs_s1;
+        else
+            continue;
+        return 1;
     }
-    *xm = _xm;
-    *xe = _xe;
-    retval = 0;
- done:
-    return retval;
+    return 0;
+}
+
+/*! Add <id>=<val> pair to key vector
+ */
+static int
+xpath_optimize_cvk_add(cvec *cvk,
+                       char *id,
+                       char *val)
+{
+    cg_var *cvi;
+
+    if ((cvi = cvec_add(cvk, CGV_STRING)) == NULL){
+        clixon_err(OE_XML, errno, "cvec_add");
+        return -1;
+    }
+    cv_name_set(cvi, id);
+    cv_string_set(cvi, val);
+    return 0;
 }
 
+/*! Collect all equalities of an and-expression
+ *
+ * Every conjunct of an and-expression must hold, so each equality found is a filter of
+ * the predicate regardless of the other conjuncts.
+ * @param[in]  xs    XPath tree of type AND
+ * @param[out] cvk   Vector of <id>:<val> pairs
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+xpath_optimize_and(xpath_tree *xs,
+                   cvec       *cvk)
+{
+    xpath_tree *xr;
+    char       *id;
+    char       *val;
+
+    if (xs->xs_int == XO_AND){
+        if (xs->xs_c0 && xpath_optimize_and(xs->xs_c0, cvk) < 0)
+            return -1;
+        xr = xs->xs_c1;
+    }
+    else
+        xr = xs->xs_c0;
+    if ((xr = xp_unwrap(xr, 1)) == NULL)
+        return 0;
+    if (xr->xs_type == XP_AND)          /* Parenthesized and-expression */
+        return xpath_optimize_and(xr, cvk);
+    if (xpath_optimize_eq(xr, &id, &val) == 1)
+        return xpath_optimize_cvk_add(cvk, id, val);
+    return 0;
+}
 
-/*! Recursive function to loop over all EXPR and pattern match them
+/*! Recursive function to loop over all predicates and collect equalities
  *
+ * Predicates are applied in order, and a numeric predicate, eg [2], is positional relative
+ * to the nodes selected by earlier predicates. Therefore stop at the first predicate that
+ * may be numeric. All predicates are evaluated again on the optimized node-set.
  * @param[in]  xt    XPath tree of type PRED
- * @param[in]  xepat Pattern matching XPath tree of type EXPR
- * @param[out] cvk   Vector of <keyname>:<keyval> pairs
- * @retval     1     Match
- * @retval     0     No match
+ * @param[out] cvk   Vector of <id>:<val> pairs
+ * @retval     1     Continue with next predicate
+ * @retval     0     Stop, remaining predicates may be positional
  * @retval    -1     Error
- * @see xpath_optimize_init
  */
 static int
 loop_preds(xpath_tree *xt,
-           xpath_tree *xepat,
            cvec       *cvk)
 {
-    int          retval = -1;
-    int          ret;
-    xpath_tree  *xe;
-    xpath_tree **vec = NULL;
-    size_t       veclen = 0;
-    cg_var      *cvi;
+    int         ret;
+    xpath_tree *xe;
+    xpath_tree *xa;
 
-    if (xt->xs_type == XP_PRED && xt->xs_c0){
-        if ((ret = loop_preds(xt->xs_c0, xepat, cvk)) < 0)
-            goto done;
-        if (ret == 0)
-            goto ok;
+    if (xt->xs_type != XP_PRED)
+        return 0;
+    if (xt->xs_c0){
+        if ((ret = loop_preds(xt->xs_c0, cvk)) <= 0)
+            return ret;
     }
-    if ((xe = xt->xs_c1) && (xe->xs_type == XP_EXP)){
-        if ((ret = xpath_tree_eq(xepat, xe, &vec, &veclen)) < 0)
-            goto done;
-        if (ret == 0)
-            goto ok;
-        if (veclen != 2)
-            goto ok;
-        if ((cvi = cvec_add(cvk, CGV_STRING)) == NULL){
-            clixon_err(OE_XML, errno, "cvec_add");
-            goto done;
-        }
-        cv_name_set(cvi, vec[0]->xs_s1);
-        if (vec[1]->xs_type == XP_PRIME_NR)
-            cv_string_set(cvi, vec[1]->xs_strnr);
-        else
-            cv_string_set(cvi, vec[1]->xs_s0);
+    if ((xe = xt->xs_c1) == NULL)
+        return 1;
+    if (xe->xs_type != XP_EXP)
+        return 0;
+    if (xe->xs_int != A_NAN)            /* or-expression: boolean but no filter */
+        return 1;
+    if ((xa = xe->xs_c0) == NULL || xa->xs_type != XP_AND)
+        return 0;
+    if (xa->xs_int != A_NAN){           /* and-expression */
+        if (xpath_optimize_and(xa, cvk) < 0)
+            return -1;
+        return 1;
     }
-    retval = 1;
- done:
-    if (vec)
-        free(vec);
-    return retval;
- ok: /* no match, not special case */
-    retval = 0;
-    goto done;
+    if ((xe = xa->xs_c0) == NULL || xe->xs_type != XP_RELEX)
+        return 0;
+    if (xe->xs_int == A_NAN){           /* Neither relational nor boolean: may be a number */
+        if ((xe = xp_unwrap(xe, 1)) != NULL && xe->xs_type == XP_AND)
+            if (xpath_optimize_and(xe, cvk) < 0) /* ((a and b)) */
+                return -1;
+        return 0;
+    }
+    if (xpath_optimize_and(xa, cvk) < 0)
+        return -1;
+    return 1;
 }
 
-/*! Pattern matching to find fastpath
+/*! Find first <id>=<val> pair with a given id
+ */
+static cg_var *
+xpath_optimize_cvk_find(cvec *cvk,
+                        char *id)
+{
+    cg_var *cvi = NULL;
+
+    while ((cvi = cvec_each(cvk, cvi)) != NULL)
+        if (strcmp(cv_name_get(cvi), id) == 0)
+            break;
+    return cvi;
+}
+
+/*! Rule-based rewrite of a step into a binary search
  *
- * @param[in]  xt     XPath tree
+ * The equalities of the leading predicates are matched against the following rules:
+ * - list-key:     all keys of a list, in any order, eg y[k2='b'][k1='a'] or y[k1='a' and k2='b']
+ * - leaf-list:    a leaf-list value, eg y[.='a']
+ * - search-index: a leaf with the search_index extension, eg y[i='a']
+ * Other predicates are allowed, they are evaluated on the result.
+ * @param[in]  xt     XPath tree of type STEP
  * @param[in]  xv     XML base node
  * @param[out] xvec   Array of found nodes
- * @param[out] xlen   Len of xvec
- * @param[out] key
- * @param[out] keyval
+ * @param[out] rule   Rule that matched
  * @retval     1      Match
  * @retval     0      No match - use non-optimized lookup
  * @retval    -1      Error
- *  XPath:
- *  y[k=3] # corresponds to: <name>[<keyname>=<keyval>]
  */
 static int
 xpath_list_optimize_fn(xpath_tree  *xt,
                        cxobj       *xv,
-                       clixon_xvec *xvec)
+                       clixon_xvec *xvec,
+                       int         *rule)
 {
     int          retval = -1;
-    xpath_tree  *xm = NULL;
-    xpath_tree  *xem = NULL;
+    xpath_tree  *xn;
     char        *name;
     yang_stmt   *yp;
     yang_stmt   *yc;
-    cvec        *cvv = NULL;
-    xpath_tree **vec = NULL;
-    size_t       veclen = 0;
-    xpath_tree  *xtp;
-    int          ret;
-    cvec        *cvk = NULL; /* vector of index keys */
-    cg_var      *cvi;
-    int          i;
-    yang_stmt   *ypp;
+    cvec        *cvv;
+    cvec        *cvk = NULL; /* vector of collected equalities */
+    cvec        *cvi = NULL; /* vector of index keys in yang order */
+    cg_var      *cv;
+    cg_var      *ycv;
+#ifdef XML_EXPLICIT_INDEX
+    yang_stmt   *yi;
+#endif
 
     /* revert to non-optimized if no yang */
     if ((yp = xml_spec(xv)) == NULL)
@@ -255,63 +359,76 @@ xpath_list_optimize_fn(xpath_tree  *xt,
     /* or if not config data (state data should not be ordered) */
     if (yang_config_ancestor(yp) == 0)
         goto ok;
-    /* Check that there is no "outer" list. */
-    ypp = yp;
-    do {
-        if (yang_keyword_get(ypp) == Y_LIST)
-            goto ok;
-    } while((ypp = yang_parent_get(ypp)) != NULL);
-    /* Check yang and that only a list with key as index is a special case can do bin search 
-     * That is, ONLY check optimize cases of this type:_x[_y='_z']
-     * Should we extend this simple example and have more cases (all cases?)
-     */
-    xpath_optimize_init(&xm, &xem);
-    /* Here is where pattern is checked for equality and where variable binding is made (if
-     * equal) */
-    if ((ret = xpath_tree_eq(xm, xt, &vec, &veclen)) < 0)
-        goto done;
-    if (ret == 0)
-        goto ok; /* no match */
-    if (veclen != 2)
+    if ((xn = xt->xs_c0) == NULL ||
+        xn->xs_type != XP_NODE ||
+        (name = xn->xs_s1) == NULL ||
+        strcmp(name, "*") == 0)
         goto ok;
-    name = vec[0]->xs_s1;
-    /* Extract variables */
-    if ((yc = yang_find(yp, Y_LIST, name)) == NULL)
-#ifdef NOTYET /* leaf-list is not detected by xpath optimize detection */
-        if ((yc = yang_find(yp, Y_LEAF_LIST, name)) == NULL) /* XXX */
-#endif
-            goto ok;
-    /* Validate keys */
-    if ((cvv = yang_cvec_get(yc)) == NULL)
+    if (xt->xs_c1 == NULL || xt->xs_c1->xs_c1 == NULL) /* no predicates */
+        goto ok;
+    if ((yc = yang_find(yp, Y_LIST, name)) == NULL &&
+        (yc = yang_find(yp, Y_LEAF_LIST, name)) == NULL)
         goto ok;
-    xtp = vec[1];
     if ((cvk = cvec_new(0)) == NULL){
         clixon_err(OE_YANG, errno, "cvec_new");
         goto done;
     }
-    if ((ret = loop_preds(xtp, xem, cvk)) < 0)
+    if (loop_preds(xt->xs_c1, cvk) < 0)
         goto done;
-    if (ret == 0)
-        goto ok;
-
-    if (cvec_len(cvv) != cvec_len(cvk))
+    if (cvec_len(cvk) == 0)
         goto ok;
-    i = 0;
-    cvi = NULL;
-    while ((cvi = cvec_each(cvk, cvi)) != NULL) {
-        if (strcmp(cv_name_get(cvi), cv_string_get(cvec_i(cvv,i))))
+    if ((cvi = cvec_new(0)) == NULL){
+        clixon_err(OE_YANG, errno, "cvec_new");
+        goto done;
+    }
+    if (yang_keyword_get(yc) == Y_LEAF_LIST){
+        if ((cv = xpath_optimize_cvk_find(cvk, ".")) == NULL)
             goto ok;
-        i++;
+        if (xpath_optimize_cvk_add(cvi, ".", cv_string_get(cv)) < 0)
+            goto done;
+        *rule = XPATH_OPT_LEAF_LIST;
+    }
+    else {
+        /* Full key tuple, reordered in yang key order as required by binary search */
+        ycv = NULL;
+        if ((cvv = yang_cvec_get(yc)) != NULL && cvec_len(cvv)){
+            while ((ycv = cvec_each(cvv, ycv)) != NULL) {
+                if ((cv = xpath_optimize_cvk_find(cvk, cv_string_get(ycv))) == NULL)
+                    break;
+                if (xpath_optimize_cvk_add(cvi, cv_name_get(cv), cv_string_get(cv)) < 0)
+                    goto done;
+            }
+        }
+        if (cvv && cvec_len(cvv) && ycv == NULL)
+            *rule = XPATH_OPT_LIST_KEY;
+        else {
+#ifdef XML_EXPLICIT_INDEX
+            /* Single explicit search index */
+            cvec_reset(cvi);
+            cv = NULL;
+            while ((cv = cvec_each(cvk, cv)) != NULL) {
+                if ((yi = yang_find_datanode(yc, cv_name_get(cv))) != NULL &&
+                    yang_flag_get(yi, YANG_FLAG_INDEX) != 0)
+                    break;
+            }
+            if (cv == NULL)
+                goto ok;
+            if (xpath_optimize_cvk_add(cvi, cv_name_get(cv), cv_string_get(cv)) < 0)
+                goto done;
+            *rule = XPATH_OPT_SEARCH_INDEX;
+#else
+            goto ok;
+#endif
+        }
     }
-    /* Use 2a form since yc allready given to compute cvk */
-    if (clixon_xml_find_index(xv, yp, NULL, name, cvk, xvec) < 0)
+    if (clixon_xml_find_index(xv, yp, NULL, name, cvi, xvec) < 0)
         goto done;
     retval = 1; /* match */
  done:
-    if (vec)
-        free(vec);
     if (cvk)
         cvec_free(cvk);
+    if (cvi)
+        cvec_free(cvi);
     return retval;
  ok: /* no match, not special case */
     retval = 0;
@@ -321,6 +438,8 @@ xpath_list_optimize_fn(xpath_tree  *xt,
 
 /*! Identify XPath special cases and if match, use binary search.
  *
+ * Found nodes are appended to xvec0, since the step may be evaluated for several base nodes,
+ * eg for each entry of an outer list.
  * @retval  1  Optimization made, special case, use x (found if != NULL)
  * @retval  0  Dont optimize: not special case, do normal processing
  * @retval -1  Error
@@ -336,23 +455,23 @@ xpath_optimize_check(xpath_tree *xs,
     int          retval = -1;
     int          ret;
     clixon_xvec *xvec = NULL;
+    int          rule = -1;
+    int          i;
 
     if (!_optimize_enable)
         goto ok;
     else if ((xvec = clixon_xvec_new()) == NULL)
         goto done;
     /* Glue code since xpath code uses (old) cxobj ** and search code uses (new) clixon_xvec */
-    else if ((ret = xpath_list_optimize_fn(xs, xv, xvec)) < 0)
+    else if ((ret = xpath_list_optimize_fn(xs, xv, xvec, &rule)) < 0)
         goto done;
     else if (ret == 1){
-        if (xvec0 && *xvec0){
-            free(*xvec0);
-            *xvec0 = NULL;
-        }
-        if (clixon_xvec_extract(xvec, xvec0, xlen0, NULL) < 0){
-            goto done;
-        }
+        for (i=0; i<clixon_xvec_len(xvec); i++)
+            if (cxvec_append(clixon_xvec_i(xvec, i), xvec0, xlen0) < 0)
+                goto done;
         _optimize_hits++;
+        if (rule >= 0 && rule < XPATH_OPT_NR)
+            _optimize_rule_hits[rule]++;
         retval = 1; /* Optimized */
         goto done;
     }
@@ -366,4 +485,3 @@ xpath_optimize_check(xpath_tree *xs,
     return 0; /* use regular code */
 #endif
 }
-
@@ -219,6 +219,11 @@ xp_new(enum xp_type  type,
     xs->xs_s1  = s1;
     xs->xs_c0  = c0;
     xs->xs_c1  = c1;
+#ifdef XML_NAME_INTERN
+    /* Intern nodetest name so that it can be compared with XML node names by pointer */
+    if (type == XP_NODE && s1 && strcmp(s1, "*") != 0)
+        xs->xs_iname = xml_name_intern(s1); /* NULL on error: fallback to strcmp */
+#endif
  done:
     return xs;
 }
@@ -251,8 +256,7 @@ xp_primary_function(clixon_xpath_yacc *xpy,
     }
     fn = ret;
     switch (fn){
-    case XPATHFN_RE_MATCH:  /* Group of NOT IMPLEMENTED xpath functions */
-    case XPATHFN_ENUM_VALUE:
+    case XPATHFN_ENUM_VALUE:  /* Group of NOT IMPLEMENTED xpath functions */
     case XPATHFN_LAST:
     case XPATHFN_ID:
     case XPATHFN_LOCAL_NAME:
@@ -281,6 +285,7 @@ xp_primary_function(clixon_xpath_yacc *xpy,
         goto done;
         break;
     case XPATHFN_CURRENT:  /* Group of implemented xpath functions */
+    case XPATHFN_RE_MATCH:
     case XPATHFN_DEREF:
     case XPATHFN_DERIVED_FROM:
     case XPATHFN_BIT_IS_SET:
@@ -306,7 +311,8 @@ xp_primary_function(clixon_xpath_yacc *xpy,
     }
     if (cb)
         cbuf_free(cb);
-    xtret = xp_new(XP_PRIME_FN, fn, NULL, name, NULL, xpt, NULL);
+    if ((xtret = xp_new(XP_PRIME_FN, fn, NULL, name, NULL, xpt, NULL)) != NULL)
+        xtret->xs_fn = xp_function_fn(fn);
     name = NULL;
  done:
     if (name)
@@ -83,12 +83,14 @@
 #include "clixon_plugin.h"
 #include "clixon_data.h"
 #include "clixon_options.h"
+#include "clixon_regex.h"
 #include "clixon_yang_parse.h"
 #include "clixon_yang_sub_parse.h"
 #include "clixon_yang_parse_lib.h"
 #include "clixon_yang_cardinality.h"
 #include "clixon_yang_type.h"
 #include "clixon_yang_schema_mount.h"
+#include "clixon_memstats.h"
 #include "clixon_yang_internal.h" /* internal included by this file only, not API */
 
 #ifdef XML_EXPLICIT_INDEX
@@ -252,6 +254,9 @@ int
 yang_argument_set(yang_stmt *ys,
                   char      *arg)
 {
+    if (ys->ys_parent)
+        yang_find_index_reset(ys->ys_parent);
+    yang_flag_reset(ys, YANG_FLAG_ARG_SHARED);
     ys->ys_argument = arg; /* not strdup/copied */
     return 0;
 }
@@ -273,6 +278,9 @@ yang_argument_dup(yang_stmt *ys,
         clixon_err(OE_UNIX, errno, "strdup");
         return -1;
     }
+    if (ys->ys_parent)
+        yang_find_index_reset(ys->ys_parent);
+    yang_flag_reset(ys, YANG_FLAG_ARG_SHARED);
     ys->ys_argument = dup; /* not strdup/copied */
     return 0;
 }
@@ -673,6 +681,94 @@ yang_typecache_set(yang_stmt *ys,
     return 0;
 }
 
+/*! Free xpath cache of must or when statement
+ *
+ * @param[in]  yx  Xpath cache
+ */
+static int
+yang_xpath_cache_free(yang_xpath_cache *yx)
+{
+    if (yx->yx_xpath)
+        free(yx->yx_xpath);
+    if (yx->yx_tree)
+        xpath_tree_free(yx->yx_tree);
+    if (yx->yx_nsc)
+        xml_nsctx_free(yx->yx_nsc);
+    free(yx);
+    return 0;
+}
+
+/*! Get parsed xpath of a must or when statement, parse and cache it on first call
+ *
+ * @param[in]  ys        Yang must or when statement
+ * @param[in]  canonical Translate to canonical prefixes, for "when" of augment or uses
+ * @param[out] xpath     XPath string, or NULL. Do not free
+ * @param[out] xptree    Parsed xpath, or NULL. Do not free
+ * @param[out] nsc       Namespace context of xpath. Do not free
+ * @retval     0         OK
+ * @retval    -1         Error
+ * @note The cache is kept until the statement is freed, the first call decides canonical
+ * @see yang_when_canonical_xpath_get
+ */
+int
+yang_xpath_cache_get(yang_stmt          *ys,
+                     int                 canonical,
+                     char              **xpath,
+                     struct xpath_tree **xptree,
+                     cvec              **nsc)
+{
+    int               retval = -1;
+    yang_xpath_cache *yx = NULL;
+    cvec             *nsc0 = NULL;
+    char             *arg;
+
+    if (ys->ys_keyword != Y_MUST && ys->ys_keyword != Y_WHEN){
+        clixon_err(OE_YANG, EINVAL, "Expected must or when statement");
+        goto done;
+    }
+    if (ys->ys_xpathcache == NULL){
+        if ((yx = malloc(sizeof(*yx))) == NULL){
+            clixon_err(OE_UNIX, errno, "malloc");
+            goto done;
+        }
+        memset(yx, 0, sizeof(*yx));
+        if (xml_nsctx_yang(ys, &nsc0) < 0)
+            goto done;
+        if ((arg = yang_argument_get(ys)) != NULL){
+            if (canonical){
+                if (nsc0 &&
+                    xpath2canonical1(arg, nsc0, ys_spec(ys), 1, &yx->yx_xpath, &yx->yx_nsc, NULL) < 0)
+                    goto done;
+            }
+            else {
+                if ((yx->yx_xpath = strdup(arg)) == NULL){
+                    clixon_err(OE_UNIX, errno, "strdup");
+                    goto done;
+                }
+                yx->yx_nsc = nsc0;
+                nsc0 = NULL;
+            }
+        }
+        if (yx->yx_xpath && xpath_parse(yx->yx_xpath, &yx->yx_tree) < 0)
+            goto done;
+        ys->ys_xpathcache = yx;
+        yx = NULL;
+    }
+    if (xpath)
+        *xpath = ys->ys_xpathcache->yx_xpath;
+    if (xptree)
+        *xptree = ys->ys_xpathcache->yx_tree;
+    if (nsc)
+        *nsc = ys->ys_xpathcache->yx_nsc;
+    retval = 0;
+ done:
+    if (yx)
+        yang_xpath_cache_free(yx);
+    if (nsc0)
+        cvec_free(nsc0);
+    return retval;
+}
+
 /*! Get mymodule
  *
  * Shortcut to "my" module. Used by augmented and unknown nodes
@@ -729,6 +825,7 @@ yang_mymodule_set(yang_stmt *ys,
 
 /* Stats */
 static uint64_t _stats_yang_nr = 0;
+static uint64_t _stats_yang_gen = 0;
 
 /*! Get global statistics about YANG statements: created - freed
  *
@@ -742,6 +839,18 @@ yang_stats_global(uint64_t *nr)
     return 0;
 }
 
+/*! Get YANG generation: incremented each time a YANG statement is created or freed
+ *
+ * Stats of a YANG tree computed with yang_stats() remain valid as long as the generation
+ * is unchanged
+ * @retval  gen  Generation
+ */
+uint64_t
+yang_stats_generation(void)
+{
+    return _stats_yang_gen;
+}
+
 /*! Return the alloced memory of a single YANG obj
  *
  * @param[in]   y    YANG object
@@ -758,7 +867,7 @@ yang_stats_one(yang_stmt *ys,
 
     sz += sizeof(struct yang_stmt);
     sz += ys->ys_len*sizeof(struct yang_stmt*);
-    if (ys->ys_argument)
+    if (ys->ys_argument && yang_flag_get(ys, YANG_FLAG_ARG_SHARED) == 0x0)
         sz += strlen(ys->ys_argument) + 1;
     if (ys->ys_cvec)
         sz += cvec_size(ys->ys_cvec);
@@ -954,6 +1063,483 @@ ydomain_new(clixon_handle h,
     return NULL;
 }
 
+/*
+ * Child lookup index
+ * Nodes with many children, see YANG_FIND_INDEX_MIN, get a hash index on (keyword, argument)
+ * of their children. The index is built lazily on first lookup and is kept in a table external
+ * to the yang node (as the when and mymodule maps) to not increase the size of yang_stmt.
+ * Nodes with an index are marked with YANG_FLAG_FINDINDEX.
+ * On first lookup with namespace, datanodes are also indexed on (namespace, name) with
+ * choice/case/input/output flattened, see yang_find_datanode_ns. Since those keys depend on
+ * grandchildren, a change in a choice/case/input/output resets the index of its ancestors.
+ */
+#define YANG_INDEX_DATANODE (-1) /* Pseudo-keyword: any datanode, see yang_datanode() */
+#define YANG_INDEX_NSNAME   (-2) /* Pseudo-keyword: flattened datanode with namespace */
+
+/*! Index slot, one per (keyword, argument) key. First child in order wins.
+ */
+struct yang_index_slot {
+    yang_stmt *yx_ys;       /* Matching child, NULL if slot is empty */
+    int        yx_keyword;  /* Child keyword, 0 for any, or YANG_INDEX_DATANODE/NSNAME */
+    int        yx_anyarg;   /* Key matches any argument (argument is NULL in lookup) */
+    const char *yx_ns;      /* Namespace if YANG_INDEX_NSNAME */
+};
+
+/*! Child lookup index of one yang node
+ */
+struct yang_index {
+    struct yang_index      *yi_next;    /* Next in table bucket */
+    yang_stmt              *yi_node;    /* Indexed yang node */
+    yang_stmt             **yi_stmt;    /* Child vector when (re)built, detects direct changes */
+    uint32_t                yi_len;     /* Number of children when (re)built */
+    uint32_t                yi_size;    /* Number of slots, power of two */
+    uint32_t                yi_used;    /* Number of used slots */
+    int                     yi_include; /* Node has include children */
+    int                     yi_nested;  /* Node has choice/input/output children */
+    int                     yi_nsbuilt; /* YANG_INDEX_NSNAME keys are added */
+    struct yang_index_slot *yi_slots;
+};
+
+/* XXX: Global variables, see _yang_when_map */
+static struct yang_index **_yang_index_tab = NULL;
+static uint32_t            _yang_index_tabsize = 0; /* Power of two */
+static uint32_t            _yang_index_nr = 0;
+
+/*! Table bucket of a yang node
+ */
+static uint32_t
+yang_index_bucket(yang_stmt *yn,
+                  uint32_t   size)
+{
+    return (uint32_t)(((uintptr_t)yn >> 4) * 2654435761u) & (size - 1);
+}
+
+/*! Hash of a (keyword, argument) key
+ */
+static uint32_t
+yang_index_hash(int         keyword,
+                const char *argument)
+{
+    uint32_t    hash = 2166136261u;
+    const char *s;
+
+    if (argument != NULL)
+        for (s = argument; *s; s++)
+            hash = (hash ^ (unsigned char)*s) * 16777619u;
+    else
+        hash ^= 0x5bd1e995;
+    return hash ^ ((uint32_t)keyword * 2654435761u);
+}
+
+/*! Find slot in index given key
+ *
+ * @param[in]  yi       Index
+ * @param[in]  keyword  Keyword, 0 for any, or YANG_INDEX_DATANODE/NSNAME
+ * @param[in]  argument Argument, or NULL for any
+ * @param[in]  ns       Namespace if YANG_INDEX_NSNAME, otherwise NULL
+ * @retval     slot     Matching slot, or empty slot where key would be added
+ */
+static struct yang_index_slot *
+yang_index_slot(struct yang_index *yi,
+                int                keyword,
+                const char        *argument,
+                const char        *ns)
+{
+    struct yang_index_slot *yx;
+    uint32_t                i;
+
+    i = yang_index_hash(keyword, argument) & (yi->yi_size - 1);
+    while ((yx = &yi->yi_slots[i])->yx_ys != NULL){
+        if (yx->yx_keyword == keyword &&
+            yx->yx_anyarg == (argument == NULL) &&
+            (argument == NULL ||
+             strcmp(argument, yx->yx_ys->ys_argument) == 0) &&
+            (ns == NULL ||
+             ns == yx->yx_ns || strcmp(ns, yx->yx_ns) == 0))
+            break;
+        i = (i + 1) & (yi->yi_size - 1);
+    }
+    return yx;
+}
+
+/*! Add key for child to index unless already present (first child wins)
+ */
+static void
+yang_index_add1(struct yang_index *yi,
+                yang_stmt         *yc,
+                int                keyword,
+                int                anyarg)
+{
+    struct yang_index_slot *yx;
+
+    yx = yang_index_slot(yi, keyword, anyarg?NULL:yc->ys_argument, NULL);
+    if (yx->yx_ys == NULL){
+        yx->yx_ys = yc;
+        yx->yx_keyword = keyword;
+        yx->yx_anyarg = anyarg;
+        yi->yi_used++;
+    }
+}
+
+/*! Add all keys of a child to index
+ *
+ * @param[in]  yi  Index
+ * @param[in]  yc  Child yang node, last in child vector
+ * @retval     1   OK
+ * @retval     0   Index is full, needs rebuild
+ */
+static int
+yang_index_add(struct yang_index *yi,
+               yang_stmt         *yc)
+{
+    enum rfc_6020 keyw;
+
+    if ((yi->yi_used + 4) * 2 > yi->yi_size)
+        return 0;
+    keyw = yc->ys_keyword;
+    yang_index_add1(yi, yc, keyw, 1);
+    if (yc->ys_argument != NULL){
+        yang_index_add1(yi, yc, keyw, 0);
+        yang_index_add1(yi, yc, 0, 0);
+        if (yang_datanode(yc))
+            yang_index_add1(yi, yc, YANG_INDEX_DATANODE, 0);
+    }
+    switch (keyw){
+    case Y_INCLUDE:
+        yi->yi_include++;
+        break;
+    case Y_CHOICE:
+    case Y_INPUT:
+    case Y_OUTPUT:
+        yi->yi_nested++;
+        break;
+    default:
+        break;
+    }
+    return 1;
+}
+
+/*! (Re)build index from child vector
+ *
+ * @param[in]  yi    Index with yi_node set
+ * @param[in]  extra Number of additional keys to make room for
+ * @retval     0     OK
+ * @retval    -1   Error
+ */
+static int
+yang_index_build(struct yang_index *yi,
+                 uint32_t           extra)
+{
+    yang_stmt *yn = yi->yi_node;
+    yang_stmt *yc;
+    uint32_t   size;
+    uint32_t   i;
+
+    for (size = 16; size < 8*yn->ys_len + 2*extra; size <<= 1);
+    if (yi->yi_slots)
+        free(yi->yi_slots);
+    if ((yi->yi_slots = calloc(size, sizeof(*yi->yi_slots))) == NULL)
+        return -1;
+    yi->yi_size = size;
+    yi->yi_used = 0;
+    yi->yi_include = 0;
+    yi->yi_nested = 0;
+    yi->yi_nsbuilt = 0;
+    for (i=0; i<yn->ys_len; i++)
+        if ((yc = yn->ys_stmt[i]) != NULL)
+            yang_index_add(yi, yc);
+    yi->yi_stmt = yn->ys_stmt;
+    yi->yi_len = yn->ys_len;
+    return 0;
+}
+
+/*! Find existing index of yang node in table
+ */
+static struct yang_index *
+yang_index_find(yang_stmt *yn)
+{
+    struct yang_index *yi;
+
+    if (_yang_index_tab == NULL)
+        return NULL;
+    for (yi = _yang_index_tab[yang_index_bucket(yn, _yang_index_tabsize)]; yi; yi = yi->yi_next)
+        if (yi->yi_node == yn)
+            break;
+    return yi;
+}
+
+/*! Link new index into table, grow table if needed
+ *
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+static int
+yang_index_link(struct yang_index *yi)
+{
+    struct yang_index **tab;
+    struct yang_index  *yi1;
+    uint32_t            size;
+    uint32_t            i;
+    uint32_t            b;
+
+    if (_yang_index_nr >= _yang_index_tabsize){
+        size = _yang_index_tabsize ? 2*_yang_index_tabsize : 64;
+        if ((tab = calloc(size, sizeof(*tab))) == NULL)
+            return -1;
+        for (i=0; i<_yang_index_tabsize; i++)
+            while ((yi1 = _yang_index_tab[i]) != NULL){
+                _yang_index_tab[i] = yi1->yi_next;
+                b = yang_index_bucket(yi1->yi_node, size);
+                yi1->yi_next = tab[b];
+                tab[b] = yi1;
+            }
+        if (_yang_index_tab)
+            free(_yang_index_tab);
+        _yang_index_tab = tab;
+        _yang_index_tabsize = size;
+    }
+    b = yang_index_bucket(yi->yi_node, _yang_index_tabsize);
+    yi->yi_next = _yang_index_tab[b];
+    _yang_index_tab[b] = yi;
+    _yang_index_nr++;
+    return 0;
+}
+
+/*! Remove child lookup index of yang node itself, not of its ancestors
+ *
+ * @param[in]  yn  Yang node
+ * @see yang_find_index_reset
+ */
+static int
+yang_index_free(yang_stmt *yn)
+{
+    struct yang_index **yip;
+    struct yang_index  *yi;
+
+    if (yang_flag_get(yn, YANG_FLAG_FINDINDEX) == 0x0)
+        return 0;
+    yang_flag_reset(yn, YANG_FLAG_FINDINDEX);
+    if (_yang_index_tab == NULL)
+        return 0;
+    yip = &_yang_index_tab[yang_index_bucket(yn, _yang_index_tabsize)];
+    while ((yi = *yip) != NULL){
+        if (yi->yi_node == yn){
+            *yip = yi->yi_next;
+            if (yi->yi_slots)
+                free(yi->yi_slots);
+            free(yi);
+            _yang_index_nr--;
+            break;
+        }
+        yip = &yi->yi_next;
+    }
+    return 0;
+}
+
+/*! Get child lookup index of yang node, build it if needed
+ *
+ * @param[in]  yn  Yang node
+ * @retval     yi  Index
+ * @retval     NULL No index: too few children, or memory error (use linear scan)
+ */
+static struct yang_index *
+yang_index_get(yang_stmt *yn)
+{
+    struct yang_index *yi;
+
+    if (yang_flag_get(yn, YANG_FLAG_FINDINDEX) != 0x0){
+        if ((yi = yang_index_find(yn)) == NULL)
+            return NULL;
+        /* Child vector changed directly, not via yn_insert/ys_prune */
+        if (yi->yi_stmt != yn->ys_stmt || yi->yi_len != yn->ys_len)
+            if (yang_index_build(yi, 0) < 0){
+                yang_find_index_reset(yn);
+                return NULL;
+            }
+        return yi;
+    }
+    if (YANG_FIND_INDEX_MIN == 0 || yn->ys_len < YANG_FIND_INDEX_MIN)
+        return NULL;
+    if ((yi = calloc(1, sizeof(*yi))) == NULL)
+        return NULL;
+    yi->yi_node = yn;
+    if (yang_index_build(yi, 0) < 0 ||
+        yang_index_link(yi) < 0){
+        if (yi->yi_slots)
+            free(yi->yi_slots);
+        free(yi);
+        return NULL;
+    }
+    yang_flag_set(yn, YANG_FLAG_FINDINDEX);
+    return yi;
+}
+
+/*! Lookup child in index
+ *
+ * @param[in]  yi       Index
+ * @param[in]  keyword  Keyword, 0 for any, or YANG_INDEX_DATANODE
+ * @param[in]  argument Argument, or NULL for any
+ * @retval     ys       First matching child
+ * @retval     NULL     No match
+ */
+static yang_stmt *
+yang_index_lookup(struct yang_index *yi,
+                  int                keyword,
+                  const char        *argument)
+{
+    return yang_index_slot(yi, keyword, argument, NULL)->yx_ys;
+}
+
+/*! Collect datanodes of yang node, flattening choice/case/input/output
+ *
+ * @param[in]     yn    Yang node
+ * @param[in,out] vec   Vector of datanodes
+ * @param[in,out] len   Length of vector
+ * @retval        0     OK
+ * @retval       -1     Error
+ */
+static int
+yang_index_flatten(yang_stmt   *yn,
+                   yang_stmt ***vec,
+                   int         *len)
+{
+    yang_stmt *yc;
+    int        i;
+
+    for (i=0; i<yn->ys_len; i++){
+        if ((yc = yn->ys_stmt[i]) == NULL)
+            continue;
+        switch (yc->ys_keyword){
+        case Y_CHOICE:
+        case Y_CASE:
+        case Y_INPUT:
+        case Y_OUTPUT:
+            if (yang_index_flatten(yc, vec, len) < 0)
+                return -1;
+            break;
+        default:
+            if (yc->ys_argument == NULL || !yang_datanode(yc))
+                break;
+            if ((*vec = realloc(*vec, (*len+1)*sizeof(yang_stmt *))) == NULL)
+                return -1;
+            (*vec)[(*len)++] = yc;
+            break;
+        }
+    }
+    return 0;
+}
+
+/*! Add YANG_INDEX_NSNAME keys of all flattened datanodes to index (first wins)
+ *
+ * Made on first lookup with namespace, not at build, since resolving namespaces of
+ * children may itself use yang_find
+ * @param[in]  yi  Index
+ * @retval     0   OK
+ * @retval    -1   Error, index may be freed
+ */
+static int
+yang_index_ns_build(struct yang_index *yi)
+{
+    int                     retval = -1;
+    yang_stmt             **vec = NULL;
+    int                     len = 0;
+    const char            **nsvec = NULL;
+    struct yang_index_slot *yx;
+    yang_stmt              *yc;
+    int                     i;
+
+    if (yang_index_flatten(yi->yi_node, &vec, &len) < 0)
+        goto done;
+    if (len && (nsvec = calloc(len, sizeof(*nsvec))) == NULL)
+        goto done;
+    for (i=0; i<len; i++)
+        nsvec[i] = yang_find_mynamespace(vec[i]);
+    if ((yi->yi_used + len) * 2 > yi->yi_size &&
+        yang_index_build(yi, len) < 0){
+        yang_index_free(yi->yi_node);
+        goto done;
+    }
+    for (i=0; i<len; i++){
+        yc = vec[i];
+        if (nsvec[i] == NULL)
+            continue;
+        yx = yang_index_slot(yi, YANG_INDEX_NSNAME, yc->ys_argument, nsvec[i]);
+        if (yx->yx_ys == NULL){
+            yx->yx_ys = yc;
+            yx->yx_keyword = YANG_INDEX_NSNAME;
+            yx->yx_anyarg = 0;
+            yx->yx_ns = nsvec[i];
+            yi->yi_used++;
+        }
+    }
+    yi->yi_nsbuilt = 1;
+    retval = 0;
+ done:
+    if (vec)
+        free(vec);
+    if (nsvec)
+        free(nsvec);
+    return retval;
+}
+
+/*! Remove index of ancestors with flattened datanodes of a choice/case/input/output
+ *
+ * Only indexes with YANG_INDEX_NSNAME keys depend on grandchildren
+ * @param[in]  yn  Yang node
+ */
+static void
+yang_index_reset_up(yang_stmt *yn)
+{
+    struct yang_index *yi;
+
+    while (yn->ys_parent != NULL &&
+           (yn->ys_keyword == Y_CHOICE || yn->ys_keyword == Y_CASE ||
+            yn->ys_keyword == Y_INPUT || yn->ys_keyword == Y_OUTPUT)){
+        yn = yn->ys_parent;
+        if (yang_flag_get(yn, YANG_FLAG_FINDINDEX) != 0x0 &&
+            (yi = yang_index_find(yn)) != NULL &&
+            yi->yi_nsbuilt)
+            yang_index_free(yn);
+    }
+}
+
+/*! Remove child lookup index of yang node
+ *
+ * Must be called when children of a node are changed other than by appending with yn_insert,
+ * or when keyword or argument of a child is changed. It will be rebuilt on next lookup.
+ * @param[in]  yn  Yang node
+ * @retval     0   OK
+ * @see yang_find
+ */
+int
+yang_find_index_reset(yang_stmt *yn)
+{
+    yang_index_reset_up(yn);
+    return yang_index_free(yn);
+}
+
+/*! Update index of yang node after child appended, see yn_insert
+ */
+static void
+yang_index_append(yang_stmt *yn,
+                  yang_stmt *yc)
+{
+    struct yang_index *yi;
+
+    yang_index_reset_up(yn);
+    if (yang_flag_get(yn, YANG_FLAG_FINDINDEX) == 0x0)
+        return;
+    if ((yi = yang_index_find(yn)) != NULL &&
+        yi->yi_len + 1 == yn->ys_len &&
+        yang_index_add(yi, yc) == 1){
+        yi->yi_stmt = yn->ys_stmt;
+        yi->yi_len = yn->ys_len;
+        yi->yi_nsbuilt = 0; /* Rebuilt with new child on next lookup */
+    }
+    else
+        yang_index_free(yn);
+}
+
 /*! Create new yang node/statement given size
  *
  * Size parameter for variable size, eg extended YANG struct
@@ -975,6 +1561,8 @@ ys_new_sz(enum rfc_6020 keyw,
     memset(ys, 0, sz);
     ys->ys_keyword = keyw;
     _stats_yang_nr++;
+    _stats_yang_gen++;
+    clixon_mem_charge(CLIXON_MEM_TAG_YANG, sizeof(struct yang_stmt));
     return ys;
 }
 
@@ -991,6 +1579,21 @@ ys_new(enum rfc_6020 keyw)
     return ys_new_sz(keyw, sizeof(struct yang_stmt));
 }
 
+/*! Free choice membership table
+ *
+ * @param[in]  ycm  Choice membership table
+ */
+static int
+yang_choice_members_free(yang_choice_cache *ycm)
+{
+    if (ycm->ycm_node)
+        free(ycm->ycm_node);
+    if (ycm->ycm_branch)
+        free(ycm->ycm_branch);
+    free(ycm);
+    return 0;
+}
+
 /*! Free a single yang statement, dont remove children, called after children freed
  * 
  * @param[in]  ys   Yang node to remove 
@@ -1007,6 +1610,7 @@ ys_free1(yang_stmt *ys,
     cg_var         *cv;
     cvec           *cvv;
 
+    yang_index_free(ys); /* Not ancestors, they may be freed already */
     if ((cv = ys->ys_cv) != NULL){
         ys->ys_cv = NULL;
         cv_free(cv);
@@ -1016,7 +1620,8 @@ ys_free1(yang_stmt *ys,
         cvec_free(cvv);
     }
     if (ys->ys_argument){
-        free(ys->ys_argument);
+        if (yang_flag_get(ys, YANG_FLAG_ARG_SHARED) == 0x0)
+            free(ys->ys_argument);
         ys->ys_argument = NULL;
     }
     if (ys->ys_stmt)
@@ -1038,10 +1643,30 @@ ys_free1(yang_stmt *ys,
             ys->ys_typecache = NULL;
         }
         break;
+    case Y_MUST:
+    case Y_WHEN:
+        if (ys->ys_xpathcache){
+            yang_xpath_cache_free(ys->ys_xpathcache);
+            ys->ys_xpathcache = NULL;
+        }
+        break;
+    case Y_CHOICE:
+        if (ys->ys_choicemembers){
+            yang_choice_members_free(ys->ys_choicemembers);
+            ys->ys_choicemembers = NULL;
+        }
+        break;
     case Y_MODULE:
     case Y_SUBMODULE:
         if (ys->ys_filename)
             free(ys->ys_filename);
+        xml_nsctx_yang_shared_free(ys);
+        break;
+    case Y_IDENTITY:
+        if (ys->ys_idrefs){
+            clicon_hash_free(ys->ys_idrefs);
+            ys->ys_idrefs = NULL;
+        }
         break;
     default:
         break;
@@ -1049,6 +1674,8 @@ ys_free1(yang_stmt *ys,
     if (self){
         free(ys);
         _stats_yang_nr--;
+        _stats_yang_gen++;
+        clixon_mem_charge(CLIXON_MEM_TAG_YANG, -(int64_t)sizeof(struct yang_stmt));
     }
     return 0;
 }
@@ -1073,6 +1700,7 @@ ys_prune(yang_stmt *yp,
     if (i >= yp->ys_len)
         goto done;
     yc = yp->ys_stmt[i];
+    yang_find_index_reset(yp);
     if (i < yp->ys_len - 1){
         size = (yp->ys_len - i - 1)*sizeof(struct yang_stmt *);
         memmove(&yp->ys_stmt[i],
@@ -1136,6 +1764,7 @@ ys_freechildren(yang_stmt *ys)
         if ((yc = ys->ys_stmt[i]) != NULL)
             ys_free(yc);
     }
+    yang_find_index_reset(ys);
     ys->ys_len = 0;
     if (ys->ys_stmt){
         free(ys->ys_stmt);
@@ -1255,6 +1884,8 @@ ys_cp_one(yang_stmt *ynew,
     sz = sizeof(*yold);
     memcpy(ynew, yold, sz);
     yang_flag_reset(ynew, YANG_FLAG_WHEN); /* Dont inherit WHENs */
+    yang_flag_reset(ynew, YANG_FLAG_FINDINDEX); /* Index is built on demand */
+    yang_flag_reset(ynew, YANG_FLAG_ARG_SHARED); /* Argument is copied below */
     ynew->ys_parent = NULL;
     if (yold->ys_stmt)
         if ((ynew->ys_stmt = calloc(yold->ys_len, sizeof(yang_stmt *))) == NULL){
@@ -1287,6 +1918,16 @@ ys_cp_one(yang_stmt *ynew,
         if (yang_typecache_get(yold)) /* Dont copy type cache, use only original */
             yang_typecache_set(ynew, NULL);
         break;
+    case Y_MUST:
+    case Y_WHEN:
+        ynew->ys_xpathcache = NULL; /* Dont copy xpath cache, namespaces may differ */
+        break;
+    case Y_CHOICE:
+        ynew->ys_choicemembers = NULL; /* Refers to children of original */
+        break;
+    case Y_IDENTITY:
+        ynew->ys_idrefs = NULL; /* Made from derived list, see yang_identity_derived */
+        break;
     default:
         break;
     }
@@ -1415,6 +2056,7 @@ yn_insert(yang_stmt *ys_parent,
         return -1;
     ys_parent->ys_stmt[pos] = ys_child;
     ys_child->ys_parent = ys_parent;
+    yang_index_append(ys_parent, ys_child);
     return 0;
 }
 
@@ -1429,6 +2071,7 @@ yn_insert1(yang_stmt *ys_parent,
     if (yn_realloc(ys_parent) < 0)
         return -1;
     ys_parent->ys_stmt[pos] = ys_child;
+    yang_index_append(ys_parent, ys_child);
     return 0;
 }
 
@@ -1467,8 +2110,8 @@ yn_iter(yang_stmt *yparent,
  *
  * Find child given keyword and argument.
  * Special case: look in imported INPUTs as well (for (sub)modules.
- * This could need an optimized lookup, especially the INPUT case.
  * Most common use for the special case, ie in openconfig, is grouping and identity
+ * Nodes with many children use a hash index, see YANG_FIND_INDEX_MIN
  * @param[in]  yn         Yang node, current context node.
  * @param[in]  keyword    if 0 match any keyword. Actual type: enum rfc_6020
  * @param[in]  argument   String compare w argument. if NULL, match any.
@@ -1488,12 +2131,32 @@ yang_find(yang_stmt  *yn,
     yang_stmt *yspec;
     yang_stmt *ym;
     yang_stmt *yorig;
+    struct yang_index *yi;
 
     if (_yang_use_orig &&
         (yorig = yang_orig_get(yn)) != NULL &&
         uses_orig_ptr(keyword)){
         return yang_find(yorig, keyword, argument);
     }
+    if ((keyword != 0 || argument != NULL) &&
+        (yi = yang_index_get(yn)) != NULL){
+        if ((yret = yang_index_lookup(yi, keyword, argument)) != NULL ||
+            yi->yi_include == 0 ||
+            keyword == Y_NAMESPACE ||
+            (yang_keyword_get(yn) != Y_MODULE &&
+             yang_keyword_get(yn) != Y_SUBMODULE))
+            return yret;
+        /* Not found: extend search to include submodules as below */
+        yspec = ys_spec(yn);
+        for (i=0; i<yn->ys_len; i++){
+            ys = yn->ys_stmt[i];
+            if (yang_keyword_get(ys) == Y_INCLUDE &&
+                (ym = yang_find_module_by_name(yspec, yang_argument_get(ys))) != NULL &&
+                (yretsub = yang_find(ym, keyword, argument)) != NULL)
+                break;
+        }
+        return yretsub;
+    }
     for (i=0; i<yn->ys_len; i++){
         ys = yn->ys_stmt[i];
         if (keyword == 0 || ys->ys_keyword == keyword){
@@ -1530,6 +2193,8 @@ yang_find(yang_stmt  *yn,
  *
  * @see yang_find   Looks for any node
  * @note May deviate from RFC since it explores choice/case not just return it.
+ * @note With an index, a direct child is preferred before one in an earlier choice, but they
+ *       cannot have the same name in a valid YANG
  * XXX: differentiate between not found and error
  */
 yang_stmt *
@@ -1543,7 +2208,15 @@ yang_find_datanode(yang_stmt *yn,
     char      *name;
     int        inext;
     int        inext2;
+    struct yang_index *yi;
 
+    if (argument != NULL &&
+        (yi = yang_index_get(yn)) != NULL){
+        if ((ysmatch = yang_index_lookup(yi, YANG_INDEX_DATANODE, argument)) != NULL)
+            goto done;
+        if (yi->yi_nested == 0 && yi->yi_include == 0)
+            goto done;
+    }
     inext = 0;
     while ((ys = yn_iter(yn, &inext)) != NULL){
         if (yang_keyword_get(ys) == Y_CHOICE){ /* Look for its children */
@@ -1595,6 +2268,42 @@ yang_find_datanode(yang_stmt *yn,
     return ysmatch;
 }
 
+/*! Find child data node with matching namespace and argument
+ *
+ * As yang_find_datanode but the namespace of the child also has to match. Nodes with an
+ * index, see YANG_FIND_INDEX_MIN, are looked up in one step on (namespace, argument) with
+ * choice/case/input/output flattened. This is used when binding XML to YANG.
+ * @param[in]  yn         Yang node, current context node.
+ * @param[in]  ns         Namespace that child should match with
+ * @param[in]  argument   Argument that child should match with
+ * @retval     ymatch     Matching child
+ * @retval     NULL       No match, or no match of namespace
+ * @see yang_find_datanode
+ */
+yang_stmt *
+yang_find_datanode_ns(yang_stmt  *yn,
+                      const char *ns,
+                      char       *argument)
+{
+    yang_stmt         *ymatch = NULL;
+    struct yang_index *yi;
+    char              *nsy;
+
+    if (ns == NULL || argument == NULL)
+        goto done;
+    if ((yi = yang_index_get(yn)) != NULL &&
+        (yi->yi_nsbuilt || yang_index_ns_build(yi) == 0)){
+        ymatch = yang_index_slot(yi, YANG_INDEX_NSNAME, argument, ns)->yx_ys;
+        if (ymatch != NULL || yi->yi_include == 0)
+            goto done;
+    }
+    if ((ymatch = yang_find_datanode(yn, argument)) != NULL &&
+        ((nsy = yang_find_mynamespace(ymatch)) == NULL || strcmp(ns, nsy) != 0))
+        ymatch = NULL;
+ done:
+    return ymatch;
+}
+
 /*! Find child schema node with matching argument (container, leaf, etc)
  *
  * @param[in]  yn         Yang node, current context node.
@@ -1921,6 +2630,102 @@ yang_choice(yang_stmt *y)
     return yp;
 }
 
+/*! Add data nodes of a choice branch to choice membership table, through choice and case
+ *
+ * @param[in]  ycm     Choice membership table
+ * @param[in]  ys      Yang node in branch
+ * @param[in]  ybranch Case, or shortcut child of choice
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+yang_choice_members_add(yang_choice_cache *ycm,
+                        yang_stmt         *ys,
+                        yang_stmt         *ybranch)
+{
+    yang_stmt  *yc;
+    yang_stmt **vec;
+    int         inext;
+
+    switch (ys->ys_keyword){
+    case Y_CHOICE:
+    case Y_CASE:
+        inext = 0;
+        while ((yc = yn_iter(ys, &inext)) != NULL)
+            if (yang_choice_members_add(ycm, yc, ybranch) < 0)
+                return -1;
+        break;
+    default:
+        if (!yang_datanode(ys))
+            break;
+        if ((vec = realloc(ycm->ycm_node, (ycm->ycm_len+1)*sizeof(*vec))) == NULL){
+            clixon_err(OE_UNIX, errno, "realloc");
+            return -1;
+        }
+        ycm->ycm_node = vec;
+        if ((vec = realloc(ycm->ycm_branch, (ycm->ycm_len+1)*sizeof(*vec))) == NULL){
+            clixon_err(OE_UNIX, errno, "realloc");
+            return -1;
+        }
+        ycm->ycm_branch = vec;
+        ycm->ycm_node[ycm->ycm_len] = ys;
+        ycm->ycm_branch[ycm->ycm_len] = ybranch;
+        ycm->ycm_len++;
+        break;
+    }
+    return 0;
+}
+
+/*! Get data nodes of a choice and their case, build and cache the table on first call
+ *
+ * All data nodes in the choice are included, also those of nested choices. The branch
+ * of a data node is the case of the choice it belongs to, or the child of the choice in
+ * shortcut mode. Two data nodes with different branches can not coexist in a data tree.
+ * @param[in]  ychoice  Yang choice
+ * @param[out] nodes    Vector of data nodes. Do not free
+ * @param[out] branches Vector of case or shortcut child of choice of each data node
+ * @param[out] len      Length of vectors
+ * @retval     0        OK
+ * @retval    -1        Error
+ * @see yang_choice_case_get
+ */
+int
+yang_choice_members(yang_stmt   *ychoice,
+                    yang_stmt ***nodes,
+                    yang_stmt ***branches,
+                    int         *len)
+{
+    int                retval = -1;
+    yang_choice_cache *ycm = NULL;
+    yang_stmt         *yc;
+    int                inext = 0;
+
+    if (ychoice->ys_keyword != Y_CHOICE){
+        clixon_err(OE_YANG, EINVAL, "Expected choice statement");
+        goto done;
+    }
+    if (ychoice->ys_choicemembers == NULL){
+        if ((ycm = malloc(sizeof(*ycm))) == NULL){
+            clixon_err(OE_UNIX, errno, "malloc");
+            goto done;
+        }
+        memset(ycm, 0, sizeof(*ycm));
+        while ((yc = yn_iter(ychoice, &inext)) != NULL)
+            if (yang_choice_members_add(ycm, yc, yc) < 0)
+                goto done;
+        ychoice->ys_choicemembers = ycm;
+        ycm = NULL;
+    }
+    *nodes = ychoice->ys_choicemembers->ycm_node;
+    *branches = ychoice->ys_choicemembers->ycm_branch;
+    *len = ychoice->ys_choicemembers->ycm_len;
+    retval = 0;
+ done:
+    if (ycm)
+        yang_choice_members_free(ycm);
+    return retval;
+}
+
 /*! Find matching y in yp:s children, "yang order" of y when y is choice
  *
  * @param[in]  yp     Choice node
@@ -2995,8 +3800,22 @@ ys_populate_length(clixon_handle h,
     return retval;
 }
 
-/*! Assign enum values
+/*! Sort enums by value
+ */
+static int
+ys_enum_cmp(const void *a,
+            const void *b)
+{
+    int32_t va = cv_int32_get(yang_cv_get(*(yang_stmt **)a));
+    int32_t vb = cv_int32_get(yang_cv_get(*(yang_stmt **)b));
+
+    return va < vb ? -1 : va > vb;
+}
+
+/*! Assign enum values and make value to name table of the type
  *
+ * The value of each enum is set as cv of the enum and the type gets a cvec of enum
+ * names with values sorted by value, see yang_valstr2enum
  * @param[in] h    Clixon handle
  * @param[in] ys   The yang statement (type) to populate.
  * @retval    0    OK
@@ -3015,7 +3834,15 @@ ys_populate_type_enum(clixon_handle h,
     int        i = 0;
     cg_var    *cv = NULL;
     int        inext;
+    yang_stmt **vec = NULL;
+    int        len = 0;
+    int        j;
+    cvec      *cvv = NULL;
 
+    if ((vec = calloc(yang_len_get(ys) + 1, sizeof(*vec))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
     inext = 0;
     while ((yenum = yn_iter(ys, &inext)) != NULL) {
         if ((cv = cv_new(CGV_INT32)) == NULL){
@@ -3031,9 +3858,82 @@ ys_populate_type_enum(clixon_handle h,
         }
         cv_int32_set(cv, i++);
         yang_cv_set(yenum, cv);
+        if (yang_keyword_get(yenum) == Y_ENUM)
+            vec[len++] = yenum;
+    }
+    qsort(vec, len, sizeof(*vec), ys_enum_cmp);
+    if ((cvv = cvec_new(0)) == NULL){
+        clixon_err(OE_UNIX, errno, "cvec_new");
+        goto done;
+    }
+    for (j = 0; j < len; j++){
+        if ((cv = cvec_add(cvv, CGV_INT32)) == NULL ||
+            cv_name_set(cv, yang_argument_get(vec[j])) == NULL){
+            clixon_err(OE_UNIX, errno, "cvec_add");
+            goto done;
+        }
+        cv_int32_set(cv, cv_int32_get(yang_cv_get(vec[j])));
+    }
+    yang_cvec_set(ys, cvv);
+    cvv = NULL;
+    retval = 0;
+ done:
+    if (cvv)
+        cvec_free(cvv);
+    if (vec)
+        free(vec);
+    return retval;
+}
+
+/*! Assign bit positions
+ *
+ * The position of each bit is set as cv of the bit. A bit without position gets the
+ * position of the previous bit + 1, see yang_bits_pos
+ * @param[in] h    Clixon handle
+ * @param[in] ys   The yang statement (type) to populate.
+ * @retval    0    OK
+ * @retval   -1    Error
+ */
+static int
+ys_populate_type_bits(clixon_handle h,
+                      yang_stmt    *ys)
+{
+    int        retval = -1;
+    yang_stmt *ybit = NULL;
+    yang_stmt *ypos;
+    uint32_t   pos = 0;
+    int        first = 1;
+    cg_var    *cv = NULL;
+    char      *reason = NULL;
+    int        inext;
+    int        ret;
+
+    inext = 0;
+    while ((ybit = yn_iter(ys, &inext)) != NULL) {
+        if (yang_keyword_get(ybit) != Y_BIT)
+            continue;
+        if ((ypos = yang_find(ybit, Y_POSITION, NULL)) != NULL){
+            if ((ret = parse_uint32(yang_argument_get(ypos), &pos, &reason)) < 0){
+                clixon_err(OE_YANG, EINVAL, "cannot parse bit position val: %s", reason);
+                goto done;
+            }
+            if (ret == 0) /* Left to runtime check, see yang_bits_pos */
+                break;
+        }
+        else if (!first)
+            pos++;
+        first = 0;
+        if ((cv = cv_new(CGV_UINT32)) == NULL){
+            clixon_err(OE_YANG, errno, "cv_new");
+            goto done;
+        }
+        cv_uint32_set(cv, pos);
+        yang_cv_set(ybit, cv);
     }
     retval = 0;
  done:
+    if (reason)
+        free(reason);
     return retval;
 }
 
@@ -3074,11 +3974,58 @@ ys_populate_type(clixon_handle h,
         if (ys_populate_type_enum(h, ys) < 0)
             goto done;
     }
+    else if (strcmp(yang_argument_get(ys), "bits") == 0){
+        if (ys_populate_type_bits(h, ys) < 0)
+            goto done;
+    }
     retval = 0;
   done:
     return retval;
 }
 
+/*! Make hash set of derived identities from the derived identity list
+ *
+ * @param[in] ybaseid  Base identity
+ * @retval    0        OK
+ * @retval   -1        Error
+ */
+static int
+yang_identity_index(yang_stmt *ybaseid)
+{
+    cg_var *cv = NULL;
+
+    if ((ybaseid->ys_idrefs = clicon_hash_init()) == NULL)
+        return -1;
+    while ((cv = cvec_each(ybaseid->ys_cvec, cv)) != NULL)
+        if (clicon_hash_add(ybaseid->ys_idrefs, cv_name_get(cv), NULL, 0) == NULL)
+            return -1;
+    return 0;
+}
+
+/*! Check if an identity is derived from a base identity
+ *
+ * Uses the hash set of derived identities made by ys_populate_identity. The set is
+ * made from the derived list if missing, eg in a copy or a cached yang spec.
+ * @param[in] ybaseid  Base identity
+ * @param[in] idref    Identity in canonical form <module>:<id>
+ * @retval    1        idref is derived from ybaseid
+ * @retval    0        Not derived
+ */
+int
+yang_identity_derived(yang_stmt  *ybaseid,
+                      const char *idref)
+{
+    if (ybaseid->ys_idrefs == NULL && ybaseid->ys_cvec != NULL &&
+        yang_identity_index(ybaseid) < 0 && ybaseid->ys_idrefs){
+        clicon_hash_free(ybaseid->ys_idrefs);
+        ybaseid->ys_idrefs = NULL;
+    }
+    if (ybaseid->ys_idrefs)
+        return clicon_hash_lookup(ybaseid->ys_idrefs, idref) != NULL;
+    return ybaseid->ys_cvec != NULL &&
+        cvec_find(ybaseid->ys_cvec, (char*)idref) != NULL;
+}
+
 /*! Sanity check yang identity statement recursively and create derived id list
  *
  * Find base identities if any and add this identity to derived identity list.
@@ -3105,7 +4052,6 @@ ys_populate_identity(clixon_handle h,
     char           *id = NULL;
     cbuf           *cb = NULL;
     yang_stmt      *ymod;
-    cvec           *idrefvec; /* Derived identityref list: (module:id)**/
     int             inext;
 
     /* Top-call (no recursion) create idref
@@ -3139,17 +4085,19 @@ ys_populate_identity(clixon_handle h,
             goto done;
         }
         //          continue; /* root identity */
-        /* Check if derived id is already in base identifier 
-         * note that cvec is always created in ys_new()
-         */
-        idrefvec = yang_cvec_get(ybaseid);
-        if (cvec_find(idrefvec, idref) != NULL)
+        /* Check if derived id is already in base identifier */
+        if (yang_identity_derived(ybaseid, idref))
             continue;
-        /* Add derived id to ybaseid */
+        /* Add derived id to ybaseid, the list and the set used for lookups */
         if (yang_cvec_add(ybaseid, CGV_STRING, idref) == NULL){
             clixon_err(OE_UNIX, errno, "cv_new");
             goto done;
         }
+        if (ybaseid->ys_idrefs == NULL &&
+            (ybaseid->ys_idrefs = clicon_hash_init()) == NULL)
+            goto done;
+        if (clicon_hash_add(ybaseid->ys_idrefs, idref, NULL, 0) == NULL)
+            goto done;
         /* Transitive to the root */
         if (ys_populate_identity(h, ybaseid, idref) < 0)
             goto done;
@@ -3537,20 +4485,24 @@ ys_populate2(yang_stmt    *ys,
     return retval;
 }
 
-/*! Find feature and if-feature nodes, check features and remove disabled nodes
+/*! Find feature and if-feature nodes, check features and remove disabled nodes, internal
  *
- * @param[in] h   Clixon handle
- * @param[in] yt  Yang statement
- * @retval    1   OK
- * @retval    0   Feature not enabled: remove yt
- * @retval   -1   Error
- * @note On return 0 the over-lying function need to remove yt from its parent
- * @note cannot use yang_apply here since child-list is modified (destructive) 
- * @note if-features is parsed in full context here, previous restricted pass in ys_parse_sub
+ * @param[in] h        Clixon handle
+ * @param[in] yt       Yang statement
+ * @param[in] populate Set feature values from config (CLICON_FEATURE)
+ * @param[in] fn       Called for each disabled node, see yang_feature_disable, or NULL
+ * @param[in] arg      Argument to fn
+ * @retval    1        OK
+ * @retval    0        Feature not enabled: remove yt
+ * @retval   -1        Error
+ * @see yang_features
  */
-int
-yang_features(clixon_handle h,
-              yang_stmt    *yt)
+static int
+yang_features1(clixon_handle   h,
+               yang_stmt      *yt,
+               int             populate,
+               yang_applyfn_t *fn,
+               void           *arg)
 {
     int        retval = -1;
     int        i;
@@ -3575,24 +4527,30 @@ yang_features(clixon_handle h,
                 goto disabled;
         }
         else if (ys->ys_keyword == Y_FEATURE){
-                if (ys_populate_feature(h, ys) < 0)
-                    goto done;
+            if (populate &&
+                ys_populate_feature(h, ys) < 0)
+                goto done;
         }
         else
-            switch (yang_features(h, ys)){
+            switch (yang_features1(h, ys, populate, fn, arg)){
                 case -1: /* error */
                     goto done;
                     break;
                 case 0: /* disabled: remove ys */
                     /* Change datanodes YANG to ANYDATA, other nodes are removed
                      */
+                    yang_find_index_reset(yt);
                     if (yang_datanode(ys) && yang_config_ancestor(ys)){
                         ys->ys_keyword = Y_ANYDATA;
                         ys_freechildren(ys);
                         ys->ys_len = 0;
                         yang_flag_set(ys, YANG_FLAG_DISABLED);
+                        if (fn && fn(ys, arg) < 0)
+                            goto done;
                         break;
                     }
+                    if (fn && fn(ys, arg) < 0)
+                        goto done;
                     for (j=i+1; j<yt->ys_len; j++)
                         yt->ys_stmt[j-1] = yt->ys_stmt[j];
                     yt->ys_len--;
@@ -3613,6 +4571,73 @@ yang_features(clixon_handle h,
     goto done;
 }
 
+/*! Find feature and if-feature nodes, check features and remove disabled nodes
+ *
+ * @param[in] h   Clixon handle
+ * @param[in] yt  Yang statement
+ * @retval    1   OK
+ * @retval    0   Feature not enabled: remove yt
+ * @retval   -1   Error
+ * @note On return 0 the over-lying function need to remove yt from its parent
+ * @note cannot use yang_apply here since child-list is modified (destructive) 
+ * @note if-features is parsed in full context here, previous restricted pass in ys_parse_sub
+ */
+int
+yang_features(clixon_handle h,
+              yang_stmt    *yt)
+{
+    return yang_features1(h, yt, 1, NULL, NULL);
+}
+
+/*! Disable a feature in a loaded yang spec and remove the nodes depending on it
+ *
+ * Nodes whose if-feature becomes false are handled as when the spec was loaded: config
+ * data nodes are changed to anydata, other nodes are removed.
+ * fn is called for each such node, after it has been changed to anydata (YANG_FLAG_DISABLED
+ * is set), or before it is removed, in which case it must not be accessed after fn returns.
+ * @param[in] h       Clixon handle
+ * @param[in] yspec   Yang spec
+ * @param[in] module  Name of module defining the feature
+ * @param[in] feature Feature name
+ * @param[in] fn      Called for each disabled node, or NULL
+ * @param[in] arg     Argument to fn
+ * @retval    1       OK, feature disabled
+ * @retval    0       No such feature, or feature not enabled
+ * @retval   -1       Error
+ * @note Enabling a feature cannot be made incrementally since disabled nodes are removed,
+ *       the yang spec needs to be re-parsed
+ */
+int
+yang_feature_disable(clixon_handle   h,
+                     yang_stmt      *yspec,
+                     const char     *module,
+                     const char     *feature,
+                     yang_applyfn_t *fn,
+                     void           *arg)
+{
+    int        retval = -1;
+    yang_stmt *ymod;
+    yang_stmt *yf;
+    cg_var    *cv;
+    int        i;
+
+    if ((ymod = yang_find_module_by_name(yspec, (char*)module)) == NULL ||
+        (yf = yang_find(ymod, Y_FEATURE, (char*)feature)) == NULL ||
+        (cv = yang_cv_get(yf)) == NULL ||
+        cv_bool_get(cv) == 0){
+        retval = 0;
+        goto done;
+    }
+    clixon_debug(CLIXON_DBG_YANG, "%s:%s", module, feature);
+    cv_bool_set(cv, 0);
+    for (i=0; i<yang_len_get(yspec); i++)
+        if (yang_features1(h, yang_child_i(yspec, i), 0, fn, arg) < 0)
+            goto done;
+    retval = 1;
+ done:
+    return retval;
+}
+
 /*! Apply a function call recursively on all yang-stmt s recursively
  *
  * Recursively traverse all yang-nodes in a parse-tree and apply fn(arg) for 
@@ -3940,7 +4965,7 @@ yang_desc_schema_nodeid(yang_stmt    *yn,
     /* Make a namespace context from yang for the prefixes (names) of nodeid_cvv 
      * Requires yn exist in hierarchy
      */
-    if (xml_nsctx_yang(yn, &nsc) < 0)
+    if ((nsc = xml_nsctx_yang_shared(yn)) == NULL)
         goto done;
     /* Iterate through cvv to find schemanode using yn as relative starting point */
     if (schema_nodeid_iterate(yn, yspec, nodeid_cvv, nsc, yres) < 0)
@@ -3948,8 +4973,6 @@ yang_desc_schema_nodeid(yang_stmt    *yn,
  ok:
     retval = 0;
  done:
-    if (nsc)
-        cvec_free(nsc);
     if (nodeid_cvv)
         cvec_free(nodeid_cvv);
     return retval;
@@ -4002,6 +5025,44 @@ yang_config_ancestor(yang_stmt *ys)
     return 1;
 }
 
+/*! Check if a yang data node and all its descendants are configuration data
+ *
+ * Then no state data can be found in instances of the node
+ * @param[in]  y   Yang data node
+ * @retval     1   Configuration data only
+ * @retval     0   Node or some descendant is state data, or a mount-point
+ * @see yang_config_ancestor
+ */
+int
+yang_config_only(yang_stmt *y)
+{
+    yang_stmt *yc;
+    int        inext;
+
+    if (yang_flag_get(y, YANG_FLAG_STATE_LOCAL) != 0 ||
+        yang_flag_get(y, YANG_FLAG_MTPOINT_POTENTIAL) != 0)
+        return 0;
+    inext = 0;
+    while ((yc = yn_iter(y, &inext)) != NULL){
+        switch (yang_keyword_get(yc)){
+        case Y_CONTAINER:
+        case Y_LIST:
+        case Y_LEAF:
+        case Y_LEAF_LIST:
+        case Y_CHOICE:
+        case Y_CASE:
+        case Y_ANYDATA:
+        case Y_ANYXML:
+            if (yang_config_only(yc) == 0)
+                return 0;
+            break;
+        default:
+            break;
+        }
+    }
+    return 1;
+}
+
 /*! Given a yang node, translate the argument string to a cv vector
  *
  * @param[in]  ys         Yang statement 
@@ -4202,6 +5263,23 @@ yang_type_cache_get2(yang_stmt  *ytype,
     return retval;
 }
 
+/*! Get compiled regexps from yang type cache, no copy is made
+ *
+ * Unlike yang_type_cache_get2, the cached vector itself is returned
+ * @param[in]  ytype   Yang type statement
+ * @retval     regexps Cached vector of compiled regexps
+ * @retval     NULL    No cache or no regexps
+ */
+cvec *
+yang_type_cache_regexps(yang_stmt *ytype)
+{
+    yang_type_cache *ycache;
+
+    if ((ycache = yang_typecache_get(ytype)) == NULL)
+        return NULL;
+    return ycache->yc_regexps;
+}
+
 /*! Free yang type cache
  */
 static int
@@ -4233,6 +5311,10 @@ yang_type_cache_free(yang_type_cache *ycache)
                     cv_void_set(cv, NULL);
                 }
                 break;
+            case REGEXP_PCRE2:
+                regex_pcre2_free(cv_void_get(cv));
+                cv_void_set(cv, NULL);
+                break;
             default:
                 break;
             }
@@ -4425,6 +5507,84 @@ yang_list_index_add(yang_stmt *ys)
     return retval;
 }
 
+/*! Declare a search index on a list leaf at runtime, without search_index extension in YANG
+ *
+ * The leaf is then indexed in the same way as a leaf with cc:search_index.
+ * Search vectors are maintained when XML trees are modified, but trees created
+ * before the declaration need to be rebuilt.
+ * @param[in]  yspec          Yang spec
+ * @param[in]  schema_nodeid  Absolute schema node id of leaf with prefixes, eg /if:interfaces/if:interface/if:oper-status
+ * @retval     1              OK
+ * @retval     0              Not found or not a leaf in a list, warning logged
+ * @retval    -1              Error
+ * @code
+ *   if (yang_search_index_add(yspec, "/ex:x/ex:y/ex:z") < 0)
+ *      err;
+ *   if (xml_search_index_rebuild(xt) < 0)
+ *      err;
+ * @endcode
+ * @see xml_search_index_rebuild
+ * @see CLICON_XML_SEARCH_INDEX
+ */
+int
+yang_search_index_add(yang_stmt *yspec,
+                      char      *schema_nodeid)
+{
+    int        retval = -1;
+    yang_stmt *ys = NULL;
+    yang_stmt *yp;
+
+    if (yang_abs_schema_nodeid(yspec, schema_nodeid, &ys) < 0)
+        goto done;
+    if (ys == NULL ||
+        yang_keyword_get(ys) != Y_LEAF ||
+        (yp = yang_parent_get(ys)) == NULL ||
+        yang_keyword_get(yp) != Y_LIST){
+        clixon_log(NULL, LOG_WARNING, "search index %s is not a leaf in a list", schema_nodeid);
+        goto fail;
+    }
+    if (yang_list_index_add(ys) < 0)
+        goto done;
+    retval = 1;
+ done:
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Declare search indexes from config option CLICON_XML_SEARCH_INDEX
+ *
+ * Should be called after all yang modules are loaded and before any datastore is read
+ * @param[in]  h      Clixon handle
+ * @param[in]  yspec  Yang spec
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+int
+yang_search_index_options(clixon_handle h,
+                          yang_stmt    *yspec)
+{
+    int    retval = -1;
+    cxobj *xconf;
+    cxobj *x;
+
+    if ((xconf = clicon_conf_xml(h)) == NULL)
+        goto ok;
+    x = NULL;
+    while ((x = xml_child_each(xconf, x, CX_ELMNT)) != NULL) {
+        if (strcmp(xml_name(x), "CLICON_XML_SEARCH_INDEX") != 0 ||
+            xml_body(x) == NULL)
+            continue;
+        if (yang_search_index_add(yspec, xml_body(x)) < 0)
+            goto done;
+    }
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Callback for yang clixon search_index extension
  * 
  * @param[in] h    Clixon handle
@@ -4601,7 +5761,9 @@ yang_start(clixon_handle h)
 int
 yang_exit(clixon_handle h)
 {
-    yang_stmt *ymounts;
+    yang_stmt         *ymounts;
+    struct yang_index *yi;
+    uint32_t           i;
 
     if (_yang_when_map != NULL) {
         free(_yang_when_map);
@@ -4611,6 +5773,20 @@ yang_exit(clixon_handle h)
         free(_yang_mymodule_map);
         _yang_mymodule_map = NULL;
     }
+    if (_yang_index_tab != NULL) {
+        for (i=0; i<_yang_index_tabsize; i++)
+            while ((yi = _yang_index_tab[i]) != NULL){
+                _yang_index_tab[i] = yi->yi_next;
+                yang_flag_reset(yi->yi_node, YANG_FLAG_FINDINDEX);
+                if (yi->yi_slots)
+                    free(yi->yi_slots);
+                free(yi);
+            }
+        free(_yang_index_tab);
+        _yang_index_tab = NULL;
+        _yang_index_tabsize = 0;
+        _yang_index_nr = 0;
+    }
     if ((ymounts = clixon_yang_mounts_get(h)) != NULL){
         ys_free(ymounts);
     }
@@ -0,0 +1,1264 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, indicate
+  your decision by deleting the provisions above and replace them with the 
+  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Precompiled YANG schema cache, see CLICON_YANG_CACHE_DIR
+ *
+ * The fully expanded yang spec, ie after yang_parse_post with groupings, augments, deviations,
+ * populated cv:s and resolved types, is serialized to a cache file when the modules of
+ * CLICON_YANG_MAIN_DIR are loaded into an empty yang spec. Next time, the cache file is loaded
+ * instead of parsing if the key matches.
+ * A cache file is a header followed by the modules in pre-order. All integers are unsigned
+ * LEB128 varints, strings are a varint length (including the terminating null character,
+ * 0 means NULL) followed by the string, see also clixon_xml_binary.c:
+ *   header: "CLXY" <version:u8> <key> <nrfiles> (<filename> <size> <hash>)*
+ *   node:   <keyword> <flags> <fields:u8> <argument> <field>* <nr> <node>*
+ *   cv:     <type> <name> <cvflags:u8> [<dec64-n>] <value>
+ *   cvec:   <nr+1> <name> <cv>*   (0 means NULL)
+ * The key is a hash of the cache format, the options, the plugins and the yang files of the
+ * directory. In addition, each module and submodule file is listed with its size and hash of
+ * its content. Pointers to other yang nodes (original, when, my-module, resolved type, void cv:s)
+ * are encoded as the pre-order index of the node, starting with 1 (0 means NULL).
+ * The file name is a hash of the directory and the plugins, to keep separate caches for
+ * eg backend and cli.
+ * The cache file is mapped private and kept mapped: arguments of the loaded yang statements
+ * point into the mapping (YANG_FLAG_ARG_SHARED) so that their pages are shared in the page cache
+ * by all processes that load the same cache file, eg netconf sessions. Pages that are written
+ * to are copied.
+ * @note Extension callbacks of plugins are not called for a cached spec, only their effects on
+ *       the yang tree are kept
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <syslog.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/param.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_queue.h"
+#include "clixon_string.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_file.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_err.h"
+#include "clixon_log.h"
+#include "clixon_debug.h"
+#include "clixon_yang_module.h"
+#include "clixon_netconf_lib.h"
+#include "clixon_xml_io.h"
+#include "clixon_plugin.h"
+#include "clixon_data.h"
+#include "clixon_options.h"
+#include "clixon_yang_type.h"
+#include "clixon_yang_parse_lib.h"
+#include "clixon_yang_internal.h" /* internal included by this file only, not API */
+#include "clixon_yang_cache.h"
+
+/* Magic cookie, version and suffix of yang cache file */
+#define YANG_CACHE_MAGIC   "CLXY"
+#define YANG_CACHE_VERSION 1
+#define YANG_CACHE_SUFFIX  ".ycache"
+
+/* Dynamic flags that are not saved */
+#define YANG_CACHE_FLAGS_SKIP (YANG_FLAG_MARK|YANG_FLAG_TMP|YANG_FLAG_FINDINDEX|\
+                               YANG_FLAG_ARG_SHARED)
+
+/* Optional fields of a node */
+#define YC_F_CV       0x01 /* ys_cv */
+#define YC_F_CVEC     0x02 /* ys_cvec */
+#define YC_F_ORIG     0x04 /* ys_orig */
+#define YC_F_TYPE     0x08 /* Y_TYPE: type cache */
+#define YC_F_WHEN     0x10 /* when map */
+#define YC_F_MYMODULE 0x20 /* my-module map */
+#define YC_F_FILENAME 0x40 /* Y_MODULE/Y_SUBMODULE: filename */
+
+/* Pointer to pre-order index map entry */
+struct yang_cache_ptr {
+    yang_stmt *yp_ys;
+    uint64_t   yp_idx;
+};
+
+/* Yang cache write state */
+struct yang_cache_wr {
+    FILE                  *yw_f;
+    struct yang_cache_ptr *yw_ptrs;    /* Sorted on pointer */
+    size_t                 yw_len;
+    size_t                 yw_size;
+    int                    yw_nocache; /* Set if spec cannot be cached */
+};
+
+/* Pointer fixup of a node when reading, resolved when all nodes are read */
+enum yang_cache_fix {
+    YC_FIX_ORIG,
+    YC_FIX_WHEN,
+    YC_FIX_MYMODULE,
+    YC_FIX_RESOLVED,
+    YC_FIX_CV,       /* void ys_cv */
+    YC_FIX_CVEC,     /* void cv in ys_cvec */
+};
+
+struct yang_cache_fixup {
+    enum yang_cache_fix yf_kind;
+    yang_stmt          *yf_ys;
+    int                 yf_i;   /* cvec index if YC_FIX_CVEC */
+    uint64_t            yf_idx; /* Pre-order index of referenced node */
+};
+
+/* Yang cache read state */
+struct yang_cache_rd {
+    clixon_handle            yr_h;
+    const uint8_t           *yr_p;     /* Current read position */
+    const uint8_t           *yr_end;   /* End of buffer */
+    yang_stmt              **yr_vec;   /* Nodes in pre-order */
+    size_t                   yr_len;
+    size_t                   yr_size;
+    struct yang_cache_fixup *yr_fix;
+    size_t                   yr_fixlen;
+    size_t                   yr_fixsize;
+};
+
+/*! FNV-1a hash of a buffer
+ */
+static uint64_t
+yang_cache_hash(uint64_t    h,
+                const void *buf,
+                size_t      len)
+{
+    const uint8_t *p = buf;
+    size_t         i;
+
+    for (i = 0; i < len; i++)
+        h = (h ^ p[i]) * 0x100000001b3ULL;
+    return h;
+}
+
+static uint64_t
+yang_cache_hash_str(uint64_t    h,
+                    const char *str)
+{
+    if (str == NULL)
+        return yang_cache_hash(h, "", 1);
+    return yang_cache_hash(h, str, strlen(str) + 1);
+}
+
+/*! Hash of file content
+ *
+ * @param[in]  filename  File
+ * @param[out] size      File size
+ * @param[out] hash      Hash of content
+ * @retval     1         OK
+ * @retval     0         File cannot be read
+ */
+static int
+yang_cache_file_hash(const char *filename,
+                     uint64_t   *size,
+                     uint64_t   *hash)
+{
+    int          retval = 0;
+    int          fd;
+    struct stat  st;
+    void        *buf = MAP_FAILED;
+
+    if ((fd = open(filename, O_RDONLY)) < 0)
+        goto done;
+    if (fstat(fd, &st) < 0)
+        goto done;
+    *size = st.st_size;
+    *hash = 0xcbf29ce484222325ULL;
+    if (st.st_size > 0){
+        if ((buf = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED)
+            goto done;
+        *hash = yang_cache_hash(*hash, buf, st.st_size);
+    }
+    retval = 1;
+ done:
+    if (buf != MAP_FAILED)
+        munmap(buf, st.st_size);
+    if (fd >= 0)
+        close(fd);
+    return retval;
+}
+
+/*! Compute cache key and cache filename
+ *
+ * @param[in]  h        Clixon handle
+ * @param[in]  dir      Yang directory, see CLICON_YANG_MAIN_DIR
+ * @param[out] key      Cache key
+ * @param[out] filename Cache file, malloced, free with free()
+ * @retval     1        OK
+ * @retval     0        No cache dir
+ * @retval    -1        Error
+ */
+static int
+yang_cache_key(clixon_handle h,
+               const char   *dir,
+               uint64_t     *key,
+               char        **filename)
+{
+    int              retval = -1;
+    char            *cachedir;
+    struct dirent   *dp = NULL;
+    int              ndp;
+    int              i;
+    clixon_plugin_t *cp;
+    uint64_t         ctx;
+    cbuf            *cb = NULL;
+    cxobj           *xconf;
+
+    if ((cachedir = clicon_option_str(h, "CLICON_YANG_CACHE_DIR")) == NULL ||
+        strlen(cachedir) == 0){
+        retval = 0;
+        goto done;
+    }
+    /* Context: which cache file */
+    ctx = yang_cache_hash_str(0xcbf29ce484222325ULL, dir);
+    cp = NULL;
+    while ((cp = clixon_plugin_each(h, cp)) != NULL)
+        ctx = yang_cache_hash_str(ctx, clixon_plugin_name_get(cp));
+    /* Key: content of cache file */
+    *key = yang_cache_hash(ctx, (uint8_t[]){YANG_CACHE_VERSION}, 1);
+    if ((ndp = clicon_file_dirent(dir, &dp, "\\.yang$", S_IFREG)) < 0)
+        goto done;
+    for (i = 0; i < ndp; i++)
+        *key = yang_cache_hash_str(*key, dp[i].d_name);
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    /* All options, eg CLICON_FEATURE, CLICON_YANG_DIR */
+    if ((xconf = clicon_conf_xml(h)) != NULL &&
+        clixon_xml2cbuf(cb, xconf, 0, 0, NULL, -1, 0) < 0)
+        goto done;
+    *key = yang_cache_hash_str(*key, cbuf_get(cb));
+    cbuf_reset(cb);
+    cprintf(cb, "%s/%016llx%s", cachedir, (unsigned long long)ctx, YANG_CACHE_SUFFIX);
+    if ((*filename = strdup(cbuf_get(cb))) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    retval = 1;
+ done:
+    if (dp)
+        free(dp);
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+static int
+yang_cache_write_uint(FILE    *f,
+                      uint64_t v)
+{
+    uint8_t b;
+
+    do {
+        b = v & 0x7f;
+        v >>= 7;
+        if (v)
+            b |= 0x80;
+        if (putc(b, f) == EOF)
+            return -1;
+    } while (v);
+    return 0;
+}
+
+static int
+yang_cache_write_str(FILE       *f,
+                     const char *str)
+{
+    size_t len;
+
+    if (str == NULL)
+        return yang_cache_write_uint(f, 0);
+    len = strlen(str) + 1;
+    if (yang_cache_write_uint(f, len) < 0)
+        return -1;
+    if (fwrite(str, 1, len, f) != len)
+        return -1;
+    return 0;
+}
+
+static int
+yang_cache_ptr_cmp(const void *a,
+                   const void *b)
+{
+    const struct yang_cache_ptr *pa = a;
+    const struct yang_cache_ptr *pb = b;
+
+    return (pa->yp_ys > pb->yp_ys) - (pa->yp_ys < pb->yp_ys);
+}
+
+/*! Add node to pre-order index map, not yet sorted
+ */
+static int
+yang_cache_ptr_add(yang_stmt *ys,
+                   void      *arg)
+{
+    struct yang_cache_wr  *yw = arg;
+    struct yang_cache_ptr *ptrs;
+
+    if (yw->yw_len == yw->yw_size){
+        yw->yw_size = yw->yw_size ? 2*yw->yw_size : 1024;
+        if ((ptrs = realloc(yw->yw_ptrs, yw->yw_size*sizeof(*ptrs))) == NULL){
+            clixon_err(OE_UNIX, errno, "realloc");
+            return -1;
+        }
+        yw->yw_ptrs = ptrs;
+    }
+    yw->yw_ptrs[yw->yw_len].yp_ys = ys;
+    yw->yw_len++;
+    yw->yw_ptrs[yw->yw_len-1].yp_idx = yw->yw_len;
+    return 0;
+}
+
+/*! Pre-order index of node, 0 if NULL. Marks spec as not cacheable if not found
+ */
+static uint64_t
+yang_cache_ptr_idx(struct yang_cache_wr *yw,
+                   yang_stmt            *ys)
+{
+    struct yang_cache_ptr  key = {ys, 0};
+    struct yang_cache_ptr *p;
+
+    if (ys == NULL)
+        return 0;
+    if ((p = bsearch(&key, yw->yw_ptrs, yw->yw_len, sizeof(key), yang_cache_ptr_cmp)) == NULL){
+        yw->yw_nocache++;
+        return 0;
+    }
+    return p->yp_idx;
+}
+
+/*! Write cligen variable
+ */
+static int
+yang_cache_write_cv(struct yang_cache_wr *yw,
+                    cg_var               *cv)
+{
+    int           retval = -1;
+    FILE         *f = yw->yw_f;
+    enum cv_type  type;
+    char         *str = NULL;
+
+    type = cv_type_get(cv);
+    if (yang_cache_write_uint(f, type) < 0 ||
+        yang_cache_write_str(f, cv_name_get(cv)) < 0 ||
+        putc(cv_flag(cv, 0xff), f) == EOF)
+        goto werr;
+    if (type == CGV_DEC64 &&
+        yang_cache_write_uint(f, cv_dec64_n_get(cv)) < 0)
+        goto werr;
+    if (cv_flag(cv, V_UNSET))
+        ;
+    else if (type == CGV_VOID){
+        if (yang_cache_write_uint(f, yang_cache_ptr_idx(yw, cv_void_get(cv))) < 0)
+            goto werr;
+    }
+    else if (type == CGV_STRING || type == CGV_REST){
+        if (yang_cache_write_str(f, cv_string_get(cv)) < 0)
+            goto werr;
+    }
+    else if (type != CGV_EMPTY && type != CGV_ERR){
+        if ((str = cv2str_dup(cv)) == NULL){
+            clixon_err(OE_UNIX, errno, "cv2str_dup");
+            goto done;
+        }
+        if (yang_cache_write_str(f, str) < 0)
+            goto werr;
+    }
+    retval = 0;
+ done:
+    if (str)
+        free(str);
+    return retval;
+ werr:
+    clixon_err(OE_UNIX, errno, "write yang cache");
+    goto done;
+}
+
+/*! Write cligen variable vector, or NULL
+ */
+static int
+yang_cache_write_cvec(struct yang_cache_wr *yw,
+                      cvec                 *cvv)
+{
+    cg_var *cv = NULL;
+
+    if (yang_cache_write_uint(yw->yw_f, cvv?cvec_len(cvv)+1:0) < 0)
+        goto werr;
+    if (cvv == NULL)
+        return 0;
+    if (yang_cache_write_str(yw->yw_f, cvec_name_get(cvv)) < 0)
+        goto werr;
+    while ((cv = cvec_each(cvv, cv)) != NULL)
+        if (yang_cache_write_cv(yw, cv) < 0)
+            return -1;
+    return 0;
+ werr:
+    clixon_err(OE_UNIX, errno, "write yang cache");
+    return -1;
+}
+
+/*! Write yang node and its children recursively
+ */
+static int
+yang_cache_write_node(struct yang_cache_wr *yw,
+                      yang_stmt            *ys)
+{
+    int              retval = -1;
+    FILE            *f = yw->yw_f;
+    uint8_t          fields = 0;
+    yang_type_cache *yc = NULL;
+    yang_stmt       *ywhen = NULL;
+    yang_stmt       *ymod = NULL;
+    uint32_t         i;
+
+    if (yang_flag_get(ys, YANG_FLAG_MOUNTPOINT))
+        yw->yw_nocache++;
+    if (ys->ys_cv)
+        fields |= YC_F_CV;
+    if (ys->ys_cvec)
+        fields |= YC_F_CVEC;
+    if (ys->ys_orig)
+        fields |= YC_F_ORIG;
+    switch (ys->ys_keyword){
+    case Y_ACTION:
+        if (ys->ys_action_cb)
+            yw->yw_nocache++;
+        break;
+    case Y_MODULE:
+    case Y_SUBMODULE:
+        if (ys->ys_filename)
+            fields |= YC_F_FILENAME;
+        break;
+    case Y_TYPE:
+        if ((yc = ys->ys_typecache) != NULL)
+            fields |= YC_F_TYPE;
+        break;
+    default:
+        break;
+    }
+    if (yang_flag_get(ys, YANG_FLAG_WHEN) &&
+        (ywhen = yang_when_get(NULL, ys)) != NULL)
+        fields |= YC_F_WHEN;
+    if (yang_flag_get(ys, YANG_FLAG_MYMODULE) &&
+        (ymod = yang_mymodule_get(ys)) != NULL)
+        fields |= YC_F_MYMODULE;
+    if (yang_cache_write_uint(f, ys->ys_keyword) < 0 ||
+        yang_cache_write_uint(f, ys->ys_flags & ~(YANG_CACHE_FLAGS_SKIP|YANG_FLAG_WHEN|YANG_FLAG_MYMODULE)) < 0 ||
+        putc(fields, f) == EOF ||
+        yang_cache_write_str(f, ys->ys_argument) < 0)
+        goto werr;
+    if (fields & YC_F_CV)
+        if (yang_cache_write_cv(yw, ys->ys_cv) < 0)
+            goto done;
+    if (fields & YC_F_CVEC)
+        if (yang_cache_write_cvec(yw, ys->ys_cvec) < 0)
+            goto done;
+    if (fields & YC_F_ORIG)
+        if (yang_cache_write_uint(f, yang_cache_ptr_idx(yw, ys->ys_orig)) < 0)
+            goto werr;
+    if (fields & YC_F_FILENAME)
+        if (yang_cache_write_str(f, ys->ys_filename) < 0)
+            goto werr;
+    if (fields & YC_F_TYPE){
+        if (yang_cache_write_uint(f, yang_cache_ptr_idx(yw, yc->yc_resolved)) < 0 ||
+            yang_cache_write_uint(f, yc->yc_options) < 0 ||
+            yang_cache_write_uint(f, yc->yc_fraction) < 0)
+            goto werr;
+        /* Compiled regexps are not saved, they are compiled from patterns on load */
+        if (yang_cache_write_cvec(yw, yc->yc_cvv) < 0 ||
+            yang_cache_write_cvec(yw, yc->yc_patterns) < 0)
+            goto done;
+    }
+    if (fields & YC_F_WHEN)
+        if (yang_cache_write_uint(f, yang_cache_ptr_idx(yw, ywhen)) < 0)
+            goto werr;
+    if (fields & YC_F_MYMODULE)
+        if (yang_cache_write_uint(f, yang_cache_ptr_idx(yw, ymod)) < 0)
+            goto werr;
+    if (yang_cache_write_uint(f, ys->ys_len) < 0)
+        goto werr;
+    for (i = 0; i < ys->ys_len; i++)
+        if (yang_cache_write_node(yw, ys->ys_stmt[i]) < 0)
+            goto done;
+    retval = 0;
+ done:
+    return retval;
+ werr:
+    clixon_err(OE_UNIX, errno, "write yang cache");
+    goto done;
+}
+
+/*! Save fully expanded yang spec to cache file
+ *
+ * Called after yang_parse_post of modules in an empty yang spec. A yang spec that cannot be
+ * cached, eg modules not parsed from files or with mount-points, is silently skipped.
+ * @param[in]  h      Clixon handle
+ * @param[in]  dir    Yang directory, see CLICON_YANG_MAIN_DIR
+ * @param[in]  yspec  Yang spec
+ * @retval     0      OK, or not cached
+ * @retval    -1      Error
+ * @see yang_cache_load
+ */
+int
+yang_cache_save(clixon_handle h,
+                const char   *dir,
+                yang_stmt    *yspec)
+{
+    int                  retval = -1;
+    struct yang_cache_wr yw = {NULL,};
+    char                *filename = NULL;
+    char                *tmpfile = NULL;
+    uint64_t             key;
+    uint64_t             size;
+    uint64_t             hash;
+    const char          *file;
+    yang_stmt           *ym;
+    uint32_t             i;
+    int                  ret;
+
+    if ((ret = yang_cache_key(h, dir, &key, &filename)) < 0)
+        goto done;
+    if (ret == 0)
+        goto ok;
+    for (i = 0; i < yspec->ys_len; i++)
+        if (yang_apply(yspec->ys_stmt[i], -1, yang_cache_ptr_add, 0, &yw) < 0)
+            goto done;
+    qsort(yw.yw_ptrs, yw.yw_len, sizeof(*yw.yw_ptrs), yang_cache_ptr_cmp);
+    if ((tmpfile = malloc(strlen(filename) + 5)) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    sprintf(tmpfile, "%s.tmp", filename);
+    if ((yw.yw_f = fopen(tmpfile, "w")) == NULL){
+        clixon_log(h, LOG_WARNING, "%s: %s: %s", __FUNCTION__, tmpfile, strerror(errno));
+        goto ok;
+    }
+    if (fwrite(YANG_CACHE_MAGIC, 1, strlen(YANG_CACHE_MAGIC), yw.yw_f) != strlen(YANG_CACHE_MAGIC) ||
+        putc(YANG_CACHE_VERSION, yw.yw_f) == EOF ||
+        yang_cache_write_uint(yw.yw_f, key) < 0 ||
+        yang_cache_write_uint(yw.yw_f, yspec->ys_len) < 0)
+        goto werr;
+    /* Module files, checked on load */
+    for (i = 0; i < yspec->ys_len; i++){
+        ym = yspec->ys_stmt[i];
+        if ((file = yang_filename_get(ym)) == NULL ||
+            yang_cache_file_hash(file, &size, &hash) == 0){
+            yw.yw_nocache++;
+            break;
+        }
+        if (yang_cache_write_str(yw.yw_f, file) < 0 ||
+            yang_cache_write_uint(yw.yw_f, size) < 0 ||
+            yang_cache_write_uint(yw.yw_f, hash) < 0)
+            goto werr;
+    }
+    for (i = 0; i < yspec->ys_len && yw.yw_nocache == 0; i++)
+        if (yang_cache_write_node(&yw, yspec->ys_stmt[i]) < 0)
+            goto done;
+    if (fclose(yw.yw_f) < 0){
+        yw.yw_f = NULL;
+        goto werr;
+    }
+    yw.yw_f = NULL;
+    if (yw.yw_nocache){
+        clixon_debug(CLIXON_DBG_YANG, "yang spec cannot be cached");
+        unlink(tmpfile);
+        goto ok;
+    }
+    if (rename(tmpfile, filename) < 0){
+        clixon_err(OE_UNIX, errno, "rename %s", filename);
+        unlink(tmpfile);
+        goto done;
+    }
+    clixon_debug(CLIXON_DBG_YANG, "saved %s", filename);
+ ok:
+    retval = 0;
+ done:
+    if (yw.yw_f){
+        fclose(yw.yw_f);
+        unlink(tmpfile);
+    }
+    if (yw.yw_ptrs)
+        free(yw.yw_ptrs);
+    if (filename)
+        free(filename);
+    if (tmpfile)
+        free(tmpfile);
+    return retval;
+ werr:
+    clixon_err(OE_UNIX, errno, "write %s", tmpfile);
+    goto done;
+}
+
+static int
+yang_cache_read_u8(struct yang_cache_rd *yr,
+                   uint8_t              *v)
+{
+    if (yr->yr_p >= yr->yr_end)
+        return -1;
+    *v = *yr->yr_p++;
+    return 0;
+}
+
+static int
+yang_cache_read_uint(struct yang_cache_rd *yr,
+                     uint64_t             *v)
+{
+    uint8_t b;
+    int     shift = 0;
+
+    *v = 0;
+    do {
+        if (yr->yr_p >= yr->yr_end || shift > 63)
+            return -1;
+        b = *yr->yr_p++;
+        *v |= (uint64_t)(b & 0x7f) << shift;
+        shift += 7;
+    } while (b & 0x80);
+    return 0;
+}
+
+/*! Read string, return pointer into buffer, no copy is made
+ */
+static int
+yang_cache_read_str(struct yang_cache_rd *yr,
+                    char                **str)
+{
+    uint64_t len;
+
+    if (yang_cache_read_uint(yr, &len) < 0)
+        return -1;
+    if (len == 0){
+        *str = NULL;
+        return 0;
+    }
+    if (len > (uint64_t)(yr->yr_end - yr->yr_p) || yr->yr_p[len-1] != '\0')
+        return -1;
+    *str = (char*)yr->yr_p;
+    yr->yr_p += len;
+    return 0;
+}
+
+/*! Register pointer fixup, resolved when all nodes are read
+ */
+static int
+yang_cache_fixup_add(struct yang_cache_rd *yr,
+                     enum yang_cache_fix   kind,
+                     yang_stmt            *ys,
+                     int                   i,
+                     uint64_t              idx)
+{
+    struct yang_cache_fixup *fix;
+
+    if (idx == 0)
+        return 0;
+    if (yr->yr_fixlen == yr->yr_fixsize){
+        yr->yr_fixsize = yr->yr_fixsize ? 2*yr->yr_fixsize : 256;
+        if ((fix = realloc(yr->yr_fix, yr->yr_fixsize*sizeof(*fix))) == NULL){
+            clixon_err(OE_UNIX, errno, "realloc");
+            return -1;
+        }
+        yr->yr_fix = fix;
+    }
+    fix = &yr->yr_fix[yr->yr_fixlen++];
+    fix->yf_kind = kind;
+    fix->yf_ys = ys;
+    fix->yf_i = i;
+    fix->yf_idx = idx;
+    return 0;
+}
+
+/*! Read cligen variable
+ *
+ * @param[in]  yr    Read state
+ * @param[in]  cv    Cligen variable, created with type, see yang_cache_read_cvtype
+ * @param[out] idx   Pre-order index of node if void cv
+ * @retval     1     OK
+ * @retval     0     Format error
+ * @retval    -1     Error
+ */
+static int
+yang_cache_read_cv(struct yang_cache_rd *yr,
+                   cg_var               *cv,
+                   uint64_t             *idx)
+{
+    enum cv_type type;
+    char        *name;
+    char        *str;
+    char        *reason = NULL;
+    uint8_t      flags;
+    uint64_t     v;
+    int          ret;
+
+    *idx = 0;
+    type = cv_type_get(cv);
+    if (yang_cache_read_str(yr, &name) < 0 ||
+        yang_cache_read_u8(yr, &flags) < 0)
+        return 0;
+    if (name && cv_name_set(cv, name) == NULL){
+        clixon_err(OE_UNIX, errno, "cv_name_set");
+        return -1;
+    }
+    if (type == CGV_DEC64){
+        if (yang_cache_read_uint(yr, &v) < 0)
+            return 0;
+        cv_dec64_n_set(cv, v);
+    }
+    if (flags & V_UNSET)
+        ;
+    else if (type == CGV_VOID){
+        if (yang_cache_read_uint(yr, idx) < 0)
+            return 0;
+    }
+    else if (type == CGV_STRING || type == CGV_REST){
+        if (yang_cache_read_str(yr, &str) < 0)
+            return 0;
+        if (str && cv_string_set(cv, str) == NULL){
+            clixon_err(OE_UNIX, errno, "cv_string_set");
+            return -1;
+        }
+    }
+    else if (type != CGV_EMPTY && type != CGV_ERR){
+        if (yang_cache_read_str(yr, &str) < 0 || str == NULL)
+            return 0;
+        if ((ret = cv_parse1(str, cv, &reason)) < 0){
+            clixon_err(OE_UNIX, errno, "cv_parse1");
+            return -1;
+        }
+        if (reason)
+            free(reason);
+        if (ret == 0)
+            return 0;
+    }
+    cv_flag_set(cv, flags);
+    return 1;
+}
+
+/*! Read cligen variable type and create it
+ */
+static cg_var *
+yang_cache_read_cvnew(struct yang_cache_rd *yr,
+                      cvec                 *cvv)
+{
+    uint64_t type;
+    cg_var  *cv;
+
+    if (yang_cache_read_uint(yr, &type) < 0)
+        return NULL;
+    if (cvv)
+        cv = cvec_add(cvv, type);
+    else
+        cv = cv_new(type);
+    return cv;
+}
+
+/*! Read cligen variable vector
+ *
+ * @param[in]  yr    Read state
+ * @param[in]  ys    Yang node, for void cv fixups if fix
+ * @param[in]  fix   Register void cv fixups of ys_cvec
+ * @param[out] cvvp  Cligen vector or NULL
+ * @retval     1     OK
+ * @retval     0     Format error
+ * @retval    -1     Error
+ */
+static int
+yang_cache_read_cvec(struct yang_cache_rd *yr,
+                     yang_stmt            *ys,
+                     int                   fix,
+                     cvec                **cvvp)
+{
+    int      retval = -1;
+    cvec    *cvv = NULL;
+    cg_var  *cv;
+    char    *name;
+    uint64_t len;
+    uint64_t i;
+    uint64_t idx;
+    int      ret;
+
+    *cvvp = NULL;
+    if (yang_cache_read_uint(yr, &len) < 0)
+        goto fail;
+    if (len == 0)
+        goto ok;
+    if (yang_cache_read_str(yr, &name) < 0)
+        goto fail;
+    if ((cvv = cvec_new(0)) == NULL){
+        clixon_err(OE_UNIX, errno, "cvec_new");
+        goto done;
+    }
+    if (name && cvec_name_set(cvv, name) == NULL){
+        clixon_err(OE_UNIX, errno, "cvec_name_set");
+        goto done;
+    }
+    for (i = 0; i < len - 1; i++){
+        if ((cv = yang_cache_read_cvnew(yr, cvv)) == NULL)
+            goto fail;
+        if ((ret = yang_cache_read_cv(yr, cv, &idx)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+        if (idx && (fix == 0 ||
+                    yang_cache_fixup_add(yr, YC_FIX_CVEC, ys, i, idx) < 0))
+            goto done;
+    }
+    *cvvp = cvv;
+    cvv = NULL;
+ ok:
+    retval = 1;
+ done:
+    if (cvv)
+        cvec_free(cvv);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Read yang node and its children recursively
+ *
+ * @param[in]  yr    Read state
+ * @param[in]  yp    Yang parent
+ * @param[in]  i     Child index in parent
+ * @retval     1     OK
+ * @retval     0     Format error
+ * @retval    -1     Error
+ */
+static int
+yang_cache_read_node(struct yang_cache_rd *yr,
+                     yang_stmt            *yp,
+                     uint32_t              i)
+{
+    int              retval = -1;
+    yang_stmt       *ys;
+    yang_stmt      **vec;
+    uint64_t         keyword;
+    uint64_t         flags;
+    uint8_t          fields;
+    char            *str;
+    cg_var          *cv;
+    cvec            *cvv = NULL;
+    cvec            *patterns = NULL;
+    cvec            *regexps = NULL;
+    uint64_t         idx;
+    uint64_t         resolved = 0;
+    uint64_t         options;
+    uint64_t         fraction;
+    uint64_t         len;
+    uint64_t         j;
+    int              ret;
+
+    if (yang_cache_read_uint(yr, &keyword) < 0 ||
+        yang_cache_read_uint(yr, &flags) < 0 ||
+        yang_cache_read_u8(yr, &fields) < 0 ||
+        yang_cache_read_str(yr, &str) < 0)
+        goto fail;
+    if ((ys = ys_new(keyword)) == NULL)
+        goto done;
+    yp->ys_stmt[i] = ys;
+    ys->ys_parent = yp;
+    ys->ys_flags = flags;
+    if (str){ /* Not copied, points into mapping */
+        ys->ys_argument = str;
+        ys->ys_flags |= YANG_FLAG_ARG_SHARED;
+    }
+    if (yr->yr_len == yr->yr_size){
+        yr->yr_size = yr->yr_size ? 2*yr->yr_size : 1024;
+        if ((vec = realloc(yr->yr_vec, yr->yr_size*sizeof(*vec))) == NULL){
+            clixon_err(OE_UNIX, errno, "realloc");
+            goto done;
+        }
+        yr->yr_vec = vec;
+    }
+    yr->yr_vec[yr->yr_len++] = ys;
+    if (fields & YC_F_CV){
+        if ((cv = yang_cache_read_cvnew(yr, NULL)) == NULL)
+            goto fail;
+        ys->ys_cv = cv;
+        if ((ret = yang_cache_read_cv(yr, cv, &idx)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+        if (yang_cache_fixup_add(yr, YC_FIX_CV, ys, 0, idx) < 0)
+            goto done;
+    }
+    if (fields & YC_F_CVEC){
+        if ((ret = yang_cache_read_cvec(yr, ys, 1, &ys->ys_cvec)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+    }
+    if (fields & YC_F_ORIG){
+        if (yang_cache_read_uint(yr, &idx) < 0)
+            goto fail;
+        if (yang_cache_fixup_add(yr, YC_FIX_ORIG, ys, 0, idx) < 0)
+            goto done;
+    }
+    if (fields & YC_F_FILENAME){
+        if (yang_cache_read_str(yr, &str) < 0)
+            goto fail;
+        if (str && yang_filename_set(ys, str) < 0)
+            goto done;
+    }
+    if (fields & YC_F_TYPE){
+        if (yang_cache_read_uint(yr, &resolved) < 0 ||
+            yang_cache_read_uint(yr, &options) < 0 ||
+            yang_cache_read_uint(yr, &fraction) < 0)
+            goto fail;
+        if ((ret = yang_cache_read_cvec(yr, ys, 0, &cvv)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+        if ((ret = yang_cache_read_cvec(yr, ys, 0, &patterns)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+        if (patterns && cvec_len(patterns) > 0){
+            if ((regexps = cvec_new(0)) == NULL){
+                clixon_err(OE_UNIX, errno, "cvec_new");
+                goto done;
+            }
+            if (compile_pattern2regexp(yr->yr_h, ys, patterns, regexps) < 1)
+                goto done;
+        }
+        if (yang_type_cache_set2(ys, NULL, options, cvv, patterns, fraction,
+                                 clicon_yang_regexp(yr->yr_h), regexps) < 0)
+            goto done;
+        if (yang_cache_fixup_add(yr, YC_FIX_RESOLVED, ys, 0, resolved) < 0)
+            goto done;
+    }
+    if (fields & YC_F_WHEN){
+        if (yang_cache_read_uint(yr, &idx) < 0)
+            goto fail;
+        if (yang_cache_fixup_add(yr, YC_FIX_WHEN, ys, 0, idx) < 0)
+            goto done;
+    }
+    if (fields & YC_F_MYMODULE){
+        if (yang_cache_read_uint(yr, &idx) < 0)
+            goto fail;
+        if (yang_cache_fixup_add(yr, YC_FIX_MYMODULE, ys, 0, idx) < 0)
+            goto done;
+    }
+    if (yang_cache_read_uint(yr, &len) < 0 ||
+        len > (uint64_t)(yr->yr_end - yr->yr_p))
+        goto fail;
+    if (len){
+        if ((ys->ys_stmt = calloc(len, sizeof(*ys->ys_stmt))) == NULL){
+            clixon_err(OE_UNIX, errno, "calloc");
+            goto done;
+        }
+        for (j = 0; j < len; j++){
+            ys->ys_len = j + 1; /* Only read children are freed on error */
+            if ((ret = yang_cache_read_node(yr, ys, j)) < 0)
+                goto done;
+            if (ret == 0)
+                goto fail;
+        }
+    }
+    retval = 1;
+ done:
+    if (cvv)
+        cvec_free(cvv);
+    if (patterns)
+        cvec_free(patterns);
+    if (regexps)
+        cvec_free(regexps);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Resolve pointer fixups when all nodes are read
+ *
+ * @retval     1     OK
+ * @retval     0     Format error, index out of range
+ * @retval    -1     Error
+ */
+static int
+yang_cache_fixup(struct yang_cache_rd *yr)
+{
+    struct yang_cache_fixup *fix;
+    yang_stmt               *ys;
+    yang_stmt               *yref;
+    size_t                   i;
+
+    for (i = 0; i < yr->yr_fixlen; i++)
+        if (yr->yr_fix[i].yf_idx > yr->yr_len)
+            return 0;
+    for (i = 0; i < yr->yr_fixlen; i++){
+        fix = &yr->yr_fix[i];
+        ys = fix->yf_ys;
+        yref = yr->yr_vec[fix->yf_idx - 1];
+        switch (fix->yf_kind){
+        case YC_FIX_ORIG:
+            ys->ys_orig = yref;
+            break;
+        case YC_FIX_WHEN:
+            if (yang_when_set(yr->yr_h, ys, yref) < 0)
+                return -1;
+            break;
+        case YC_FIX_MYMODULE:
+            if (yang_mymodule_set(ys, yref) < 0)
+                return -1;
+            break;
+        case YC_FIX_RESOLVED:
+            ys->ys_typecache->yc_resolved = yref;
+            break;
+        case YC_FIX_CV:
+            cv_void_set(ys->ys_cv, yref);
+            break;
+        case YC_FIX_CVEC:
+            cv_void_set(cvec_i(ys->ys_cvec, fix->yf_i), yref);
+            break;
+        }
+    }
+    return 1;
+}
+
+/*! Free modules of yang spec read so far
+ */
+static void
+yang_cache_free_modules(yang_stmt *yspec)
+{
+    uint32_t i;
+
+    for (i = 0; i < yspec->ys_len; i++)
+        if (yspec->ys_stmt[i])
+            ys_free(yspec->ys_stmt[i]);
+    yspec->ys_len = 0;
+    if (yspec->ys_stmt){
+        free(yspec->ys_stmt);
+        yspec->ys_stmt = NULL;
+    }
+}
+
+/*! Load fully expanded yang spec from cache file
+ *
+ * Only made if yang spec is empty. On mismatch, fall back to parsing after which the cache
+ * is saved with yang_cache_save.
+ * @note The mapping of the cache file is kept for the lifetime of the process, also if the
+ *       yang spec is freed
+ * @param[in]  h      Clixon handle
+ * @param[in]  dir    Yang directory, see CLICON_YANG_MAIN_DIR
+ * @param[in]  yspec  Yang spec, empty
+ * @retval     1      Loaded from cache
+ * @retval     0      Not loaded: no cache dir, no cache file or it does not match
+ * @retval    -1      Error
+ * @see yang_cache_save
+ */
+int
+yang_cache_load(clixon_handle h,
+                const char   *dir,
+                yang_stmt    *yspec)
+{
+    int                  retval = -1;
+    struct yang_cache_rd yr = {h, NULL, NULL, NULL, 0, 0, NULL, 0, 0};
+    char                *filename = NULL;
+    int                  fd = -1;
+    struct stat          st = {0,};
+    void                *buf = MAP_FAILED;
+    size_t               len;
+    uint8_t              version;
+    uint64_t             key;
+    uint64_t             key0;
+    uint64_t             nr;
+    uint64_t             size0;
+    uint64_t             hash0;
+    uint64_t             size;
+    uint64_t             hash;
+    uint64_t             i;
+    char                *file;
+    int                  ret;
+
+    if (yspec->ys_len != 0)
+        goto miss;
+    if ((ret = yang_cache_key(h, dir, &key, &filename)) < 0)
+        goto done;
+    if (ret == 0)
+        goto miss;
+    if ((fd = open(filename, O_RDONLY)) < 0)
+        goto miss;
+    if (fstat(fd, &st) < 0 || st.st_size == 0)
+        goto miss;
+    /* Writable but private: a write to a shared argument copies the page */
+    if ((buf = mmap(NULL, st.st_size, PROT_READ|PROT_WRITE, MAP_PRIVATE, fd, 0)) == MAP_FAILED)
+        goto miss;
+    yr.yr_p = buf;
+    yr.yr_end = yr.yr_p + st.st_size;
+    len = strlen(YANG_CACHE_MAGIC);
+    if ((size_t)st.st_size < len || memcmp(buf, YANG_CACHE_MAGIC, len) != 0)
+        goto miss;
+    yr.yr_p += len;
+    if (yang_cache_read_u8(&yr, &version) < 0 ||
+        version != YANG_CACHE_VERSION ||
+        yang_cache_read_uint(&yr, &key0) < 0 ||
+        key0 != key ||
+        yang_cache_read_uint(&yr, &nr) < 0 ||
+        nr > (uint64_t)(yr.yr_end - yr.yr_p))
+        goto miss;
+    /* Check that no module or submodule file has changed */
+    for (i = 0; i < nr; i++){
+        if (yang_cache_read_str(&yr, &file) < 0 || file == NULL ||
+            yang_cache_read_uint(&yr, &size0) < 0 ||
+            yang_cache_read_uint(&yr, &hash0) < 0)
+            goto miss;
+        if (yang_cache_file_hash(file, &size, &hash) == 0 ||
+            size != size0 || hash != hash0){
+            clixon_debug(CLIXON_DBG_YANG, "%s changed", file);
+            goto miss;
+        }
+    }
+    if (yspec->ys_stmt)
+        free(yspec->ys_stmt);
+    if ((yspec->ys_stmt = calloc(nr, sizeof(*yspec->ys_stmt))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    for (i = 0; i < nr; i++){
+        yspec->ys_len = i + 1;
+        if ((ret = yang_cache_read_node(&yr, yspec, i)) < 0)
+            goto done;
+        if (ret == 0)
+            goto bad;
+    }
+    if ((ret = yang_cache_fixup(&yr)) < 0)
+        goto done;
+    if (ret == 0)
+        goto bad;
+    clixon_debug(CLIXON_DBG_YANG, "loaded %s", filename);
+    buf = MAP_FAILED; /* Keep mapping, arguments point into it */
+    retval = 1;
+ done:
+    if (retval < 0)
+        yang_cache_free_modules(yspec);
+    if (yr.yr_vec)
+        free(yr.yr_vec);
+    if (yr.yr_fix)
+        free(yr.yr_fix);
+    if (buf != MAP_FAILED)
+        munmap(buf, st.st_size);
+    if (fd >= 0)
+        close(fd);
+    if (filename)
+        free(filename);
+    return retval;
+ bad:
+    clixon_log(h, LOG_WARNING, "Yang cache %s: format error, ignored", filename);
+    yang_cache_free_modules(yspec);
+ miss:
+    retval = 0;
+    goto done;
+}
+
+/*! Digest of the yang modules of a spec, the options and the plugins
+ *
+ * Used as key of caches of data generated from a yang spec, eg the autocli cache.
+ * Each module and submodule is hashed by name, file name and content of its file.
+ * All options are included, eg CLICON_FEATURE and the autocli configuration.
+ * @param[in]  h       Clixon handle
+ * @param[in]  yspec   Yang spec
+ * @param[out] digest  Digest
+ * @retval     1       OK
+ * @retval     0       A module is not read from a file, no digest
+ * @retval    -1       Error
+ */
+int
+yang_spec_digest(clixon_handle h,
+                 yang_stmt    *yspec,
+                 uint64_t     *digest)
+{
+    int              retval = -1;
+    uint64_t         d;
+    uint64_t         size;
+    uint64_t         hash;
+    yang_stmt       *ym;
+    const char      *filename;
+    clixon_plugin_t *cp;
+    cbuf            *cb = NULL;
+    cxobj           *xconf;
+    int              inext;
+
+    d = 0xcbf29ce484222325ULL;
+    inext = 0;
+    while ((ym = yn_iter(yspec, &inext)) != NULL){
+        if (yang_keyword_get(ym) != Y_MODULE && yang_keyword_get(ym) != Y_SUBMODULE)
+            continue;
+        if ((filename = yang_filename_get(ym)) == NULL ||
+            yang_cache_file_hash(filename, &size, &hash) == 0){
+            retval = 0;
+            goto done;
+        }
+        d = yang_cache_hash_str(d, yang_argument_get(ym));
+        d = yang_cache_hash_str(d, filename);
+        d = yang_cache_hash(d, &size, sizeof(size));
+        d = yang_cache_hash(d, &hash, sizeof(hash));
+    }
+    cp = NULL;
+    while ((cp = clixon_plugin_each(h, cp)) != NULL)
+        d = yang_cache_hash_str(d, clixon_plugin_name_get(cp));
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if ((xconf = clicon_conf_xml(h)) != NULL &&
+        clixon_xml2cbuf(cb, xconf, 0, 0, NULL, -1, 0) < 0)
+        goto done;
+    d = yang_cache_hash_str(d, cbuf_get(cb));
+    *digest = d;
+    retval = 1;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
@@ -60,6 +60,24 @@ struct yang_type_cache{
 };
 typedef struct yang_type_cache yang_type_cache;
 
+/*! Yang xpath cache. Must and when statements cache their parsed xpath here
+ */
+struct yang_xpath_cache{
+    char              *yx_xpath;    /* XPath, canonical if when of augment or uses */
+    struct xpath_tree *yx_tree;     /* Parsed xpath, or NULL */
+    cvec              *yx_nsc;      /* Namespace context of xpath */
+};
+typedef struct yang_xpath_cache yang_xpath_cache;
+
+/*! Yang choice cache. Data nodes of a choice and their case or shortcut child
+ */
+struct yang_choice_cache{
+    int                ycm_len;
+    struct yang_stmt **ycm_node;    /* Data nodes, through nested choice and case */
+    struct yang_stmt **ycm_branch;  /* Case, or shortcut child of choice, of data node */
+};
+typedef struct yang_choice_cache yang_choice_cache;
+
 /*! yang statement 
  *
  * This is an internal type, not exposed in the API
@@ -112,6 +130,10 @@ struct yang_stmt {
         rpc_callback_t  *ysu_action_cb; /* Y_ACTION: Action callback list*/
         char            *ysu_filename;  /* Y_MODULE/Y_SUBMODULE: For debug/errors: filename */
         yang_type_cache *ysu_typecache; /* Y_TYPE: cache all typedef data except unions */
+        yang_xpath_cache *ysu_xpathcache; /* Y_MUST/Y_WHEN: parsed xpath */
+        yang_choice_cache *ysu_choicemembers; /* Y_CHOICE: data nodes and their cases */
+        clicon_hash_t  *ysu_idrefs;     /* Y_IDENTITY: set of derived <module>:<id>, same
+                                           as ys_cvec, see ys_populate_identity */
     } u;
 };
 
@@ -119,5 +141,8 @@ struct yang_stmt {
 #define ys_action_cb      u.ysu_action_cb
 #define ys_filename       u.ysu_filename
 #define ys_typecache      u.ysu_typecache
+#define ys_xpathcache     u.ysu_xpathcache
+#define ys_choicemembers  u.ysu_choicemembers
+#define ys_idrefs         u.ysu_idrefs
 
 #endif  /* _CLIXON_YANG_INTERNAL_H_ */
@@ -341,7 +341,24 @@ yang_modules_state_get(clixon_handle    h,
     int         i;
 
     msid = clicon_option_str(h, "CLICON_MODULE_SET_ID"); /* In RFC 8525 changed to "content-id" */
-    if ((xc = clicon_modst_cache_get(h, brief)) != NULL){
+    /* The full tree is rebuilt if YANG has changed since it was cached, the brief tree is
+     * kept as loaded at startup for the datastore */
+    if ((xc = clicon_modst_cache_get(h, brief)) != NULL &&
+        !brief && clicon_modst_cache_gen(h, brief) != yang_stats_generation())
+        xc = NULL;
+    if (xc != NULL && (xpath == NULL || strcmp(xpath, "/") == 0)){
+        /* Whole tree: copy the cache without xpath and pruning */
+        if ((x = xml_dup(xc)) == NULL)
+            goto done;
+        if ((x = xml_wrap(x, "top")) == NULL)
+            goto done;
+        if ((ret = netconf_trymerge(x, yspec, xret)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+        goto ok;
+    }
+    if (xc != NULL){
         cxobj *xw; /* tmp top wrap object */
         /* xc is here: <modules-state>... 
          * need to wrap it for xpath: <top><modules-state> */
@@ -396,6 +413,7 @@ yang_modules_state_get(clixon_handle    h,
         if (ret == 0)
             goto fail;
     }
+ ok:
     retval = 1;
  done:
     if (xvec)
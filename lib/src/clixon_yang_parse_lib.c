@@ -97,6 +97,7 @@
 #include "clixon_yang_type.h"
 #include "clixon_yang_parse.h"
 #include "clixon_yang_cardinality.h"
+#include "clixon_yang_cache.h"
 #include "clixon_plugin.h"
 #include "clixon_yang_internal.h"
 #include "clixon_yang_sub_parse.h"
@@ -681,6 +682,8 @@ yang_expand_uses_node(clixon_handle h,
      */
     if (glen > 0){
         int oldbuflen = yn->ys_len;
+
+        yang_find_index_reset(yn);
         /* size of existing elements up from i+1 (not uses-stmt) */
         size = (yang_len_get(yn) - i - 1)*sizeof(struct yang_stmt *);
         yn->ys_len += glen;
@@ -766,6 +769,7 @@ yang_expand_uses_node(clixon_handle h,
         yang_flag_set(yg, YANG_FLAG_GROUPING);
         k++;
     }
+    yang_find_index_reset(yn); /* Children assigned directly above */
     /* Remove the grouping copy */
     ygrouping2->ys_len = 0; /* Cant do with get access function */
     ys_free(ygrouping2);
@@ -916,6 +920,7 @@ yang_parse_str(char         *str,
  * @retval ymod      Top-level yang (sub)module
  * @retval NULL      Error 
  * @note this function simply parse a yang spec, no dependencies or checks
+ * The file is read in blocks, sized after the file if it is a regular file
  */
 yang_stmt *
 yang_parse_file(FILE       *fp,
@@ -923,13 +928,15 @@ yang_parse_file(FILE       *fp,
                 yang_stmt  *yspec)
 {
     char         *buf = NULL;
-    int           i;
-    char          c;
-    int           len;
+    size_t        i;
+    size_t        len;
     yang_stmt    *ymod = NULL;
-    int           ret;
+    size_t        ret;
+    struct stat   st;
 
     len = BUFLEN; /* any number is fine */
+    if (fstat(fileno(fp), &st) == 0 && S_ISREG(st.st_mode) && (size_t)st.st_size >= len)
+        len = st.st_size + 1;
     if ((buf = malloc(len)) == NULL){
         clixon_err(OE_XML, errno, "malloc");
         goto done;
@@ -937,12 +944,6 @@ yang_parse_file(FILE       *fp,
     memset(buf, 0, len);
     i = 0; /* position in buf */
     while (1){ /* read the whole file */
-        if ((ret = fread(&c, 1, 1, fp)) < 0){
-            clixon_err(OE_XML, errno, "read");
-            break;
-        }
-        if (ret == 0)
-            break; /* eof */
         if (i == len-1){
             if ((buf = realloc(buf, 2*len)) == NULL){
                 clixon_err(OE_XML, errno, "realloc");
@@ -951,8 +952,15 @@ yang_parse_file(FILE       *fp,
             memset(buf+len, 0, len);
             len *= 2;
         }
-        buf[i++] = (char)(c&0xff);
-    } /* read a line */
+        if ((ret = fread(buf+i, 1, len-1-i, fp)) == 0){
+            if (ferror(fp)){
+                clixon_err(OE_XML, errno, "read");
+                goto done;
+            }
+            break; /* eof */
+        }
+        i += ret;
+    }
     if ((ymod = yang_parse_str(buf, name, yspec)) < 0)
         goto done;
   done:
@@ -1733,6 +1741,25 @@ yang_spec_parse_file(clixon_handle h,
     return retval;
 }
 
+/*! Prefetch yang file, let the kernel read it in the background
+ *
+ * Files of a directory are prefetched before they are parsed one by one.
+ * @param[in]  filename  Yang file
+ */
+static void
+yang_file_prefetch(const char *filename)
+{
+#ifdef POSIX_FADV_WILLNEED
+    int fd;
+
+    /* Errors are reported when the file is parsed */
+    if ((fd = open(filename, O_RDONLY)) >= 0){
+        (void)posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+        close(fd);
+    }
+#endif
+}
+
 /*! Load all yang modules in directory
  *
  * @param[in]  h     Clicon handle
@@ -1748,6 +1775,8 @@ yang_spec_parse_file(clixon_handle h,
  * 3) If only x@rev.yang's found, prefer newest (newest revision)
  * There is also an extra failsafe which may not be necessary, which removes
  * the oldest module if 1-3 for some reason fails.
+ * If CLICON_YANG_CACHE_DIR is set and yspec is empty, the expanded modules are loaded from a
+ * cache file if it matches, otherwise saved to it after parsing, see yang_cache_load
  */
 int
 yang_spec_load_dir(clixon_handle h,
@@ -1770,6 +1799,7 @@ yang_spec_load_dir(clixon_handle h,
     uint32_t       rev0; /* revision in existing module */
     char          *oldbase = NULL;
     int            taken = 0;
+    int            ret;
 
     /* Get yang files names from yang module directory. Note that these
      * are sorted alphatetically:
@@ -1783,6 +1813,18 @@ yang_spec_load_dir(clixon_handle h,
         goto ok;
     /* Apply post steps on new modules, ie ones after modmin. */
     modmin = yang_len_get(yspec);
+    /* Load fully expanded modules from cache, if enabled and yspec is empty */
+    if (modmin == 0){
+        if ((ret = yang_cache_load(h, dir, yspec)) < 0)
+            goto done;
+        if (ret == 1)
+            goto ok;
+    }
+    /* Start reading all files, they are parsed one at a time below */
+    for (i = 0; i < ndp; i++) {
+        snprintf(filename, MAXPATHLEN-1, "%s/%s", dir, dp[i].d_name);
+        yang_file_prefetch(filename);
+    }
     /* Load all yang files in dir */
     for (i = 0; i < ndp; i++) {
         /* base = module name [+ @rev ] + .yang */
@@ -1851,6 +1893,8 @@ yang_spec_load_dir(clixon_handle h,
     }
     if (yang_parse_post(h, yspec, modmin) < 0)
         goto done;
+    if (modmin == 0 && yang_cache_save(h, dir, yspec) < 0)
+        goto done;
  ok:
     retval = 0;
   done:
@@ -68,6 +68,7 @@
  * - yang_mount_set(): ymnt + xpath -> yspec
  * - xml_yang_mount_get(): xmnt-> yspec
  * - xml_yang_mount_set(): xmnt -> yspec
+ * - xml_yang_mount_del(): xmnt -> remove yspec reference, free on last
  * - yang_mount_get_yspec_any(): ymnt -> yspec
  * - yang_mounto_freeall(): ymnt-> free cvec
  * - yang_mount_xmnt2ymnt_xpath(): xmnt -> ymnt + xpath
@@ -119,6 +120,7 @@
 #include "clixon_plugin.h"
 #include "clixon_xml_bind.h"
 #include "clixon_xml_nsctx.h"
+#include "clixon_digest.h"
 #include "clixon_yang_schema_mount.h"
 
 /*! Check if YANG node is a RFC 8528 YANG schema mount
@@ -415,6 +417,52 @@ xml_yang_mount_set(clixon_handle h,
     return retval;
 }
 
+/*! Remove yangspec mount-point of XML mount-point node
+ *
+ * The mount-point xpath is removed from the yspec. The yspec is shared by all mount-points in
+ * its cvec, when the last is removed the yspec is freed.
+ * @param[in]  h      Clixon handle
+ * @param[in]  xmnt   XML mount-point
+ * @retval     1      OK, yspec is freed
+ * @retval     0      OK, yspec is kept or no yspec
+ * @retval    -1      Error
+ * @note No XML, in any datastore, may be bound to the yspec when it is freed
+ */
+int
+xml_yang_mount_del(clixon_handle h,
+                   cxobj        *xmnt)
+{
+    int        retval = -1;
+    yang_stmt *ymnt = NULL;
+    yang_stmt *yspec = NULL;
+    char      *xpath = NULL;
+    int        ret;
+
+    if ((ret = yang_mount_xmnt2ymnt_xpath(h, xmnt, &ymnt, &xpath)) < 0)
+        goto done;
+    if (ret == 0)
+        goto ok;
+    if (yang_mount_get(ymnt, xpath, &yspec) < 0)
+        goto done;
+    if (yspec == NULL)
+        goto ok;
+    if (yang_cvec_rm(yspec, xpath) < 0)
+        goto done;
+    if (yang_cvec_get(yspec) != NULL)
+        goto ok;
+    clixon_debug(CLIXON_DBG_YANG, "free yang-spec: %p", yspec);
+    ys_prune_self(yspec);
+    ys_free(yspec);
+    retval = 1;
+ done:
+    if (xpath)
+        free(xpath);
+    return retval;
+ ok:
+    retval = 0;
+    goto done;
+}
+
 /*! Find schema mounts - callback function for xml_apply
  *
  * @param[in]  x    XML node  
@@ -703,68 +751,89 @@ yang_schema_mount_statedata(clixon_handle h,
     goto done;
 }
 
-/*! Given xml mount-point and yanglib, find existing yspec
+/*! qsort callback for string vectors */
+static int
+yang_schema_strcmp(const void *a,
+                   const void *b)
+{
+    return strcmp(*(char **)a, *(char **)b);
+}
+
+/*! Compute content digest of the module-sets of a yang-library
  *
- * Get and loop through all XML from xt mount-points.
- * Get xyanglib and if equal to xt, find and return yspec
- * @param[in]   h        Clixon handle
- * @param[in]   xt       XML tree node
+ * Each module-set entry (modules, import-only modules, etc) is printed and the entries are
+ * sorted so that the digest does not depend on the order of the entries.
+ * Other yang-library content, such as content-id, is not included.
  * @param[in]   xyanglib yanglib in XML
- * @param[out]  yspecp   Yang spec
+ * @param[in]   domain   YANG domain
+ * @param[out]  digest   Malloced digest as HEX string, free after use
  * @retval      0        OK
  * @retval     -1        Error
+ * @see yang_schema_yanglib_parse_mount
  */
 static int
-yang_schema_find_share(clixon_handle h,
-                       cxobj        *xt,
-                       cxobj        *xyanglib,
-                       yang_stmt   **yspecp)
+yang_schema_yanglib_digest(cxobj *xyanglib,
+                           char  *domain,
+                           char **digest)
 {
     int     retval = -1;
-    cvec   *cvv = NULL;
-    cg_var *cv;
-    cxobj  *xroot;
-    cxobj  *xmnt;
-    cxobj  *xylib;
-    int     config = 1;
-    int     ret;
+    cbuf   *cb = NULL;
+    cxobj  *xs;
+    cxobj  *x;
+    char  **vec = NULL;
+    char  **vec1;
+    int     len = 0;
+    int     i;
 
-    xroot = xml_root(xt);
-    /* Get all XML mtpoints */
-    if (yang_mount_xtop2xmnt(xroot, &cvv) < 0)
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_YANG, errno, "cbuf_new");
         goto done;
-    /* Loop through XML mount-points */
-    cv = NULL;
-    while ((cv = cvec_each(cvv, cv)) != NULL) {
-        xmnt = cv_void_get(cv);
-        if (xmnt == xt)
-            continue;
-        xylib = NULL;
-        /* Get xyanglib */
-        if (clixon_plugin_yang_mount_all(h, xmnt, &config, NULL, &xylib) < 0)
-            goto done;
-        if (xylib == NULL)
-            continue;
-        /* Check if equal */
-        if (xml_tree_equal(xyanglib, xylib) == 1)
+    }
+    xs = NULL;
+    while ((xs = xml_child_each(xyanglib, xs, CX_ELMNT)) != NULL) {
+        if (strcmp(xml_name(xs), "module-set") != 0)
             continue;
-        /* Find and return yspec */
-        *yspecp = NULL;
-        if ((ret = xml_yang_mount_get(h, xmnt, NULL, NULL, yspecp)) < 0)
-            goto done;
-        if (ret == 1 && *yspecp != NULL)
-            break;
+        x = NULL;
+        while ((x = xml_child_each(xs, x, CX_ELMNT)) != NULL) {
+            cbuf_reset(cb);
+            if (clixon_xml2cbuf(cb, x, 0, 0, NULL, -1, 0) < 0)
+                goto done;
+            if ((vec1 = realloc(vec, (len+1)*sizeof(char*))) == NULL){
+                clixon_err(OE_UNIX, errno, "realloc");
+                goto done;
+            }
+            vec = vec1;
+            if ((vec[len] = strdup(cbuf_get(cb))) == NULL){
+                clixon_err(OE_UNIX, errno, "strdup");
+                goto done;
+            }
+            len++;
+        }
     }
+    if (len > 1)
+        qsort(vec, len, sizeof(char*), yang_schema_strcmp);
+    cbuf_reset(cb);
+    cprintf(cb, "%s", domain);
+    for (i = 0; i < len; i++)
+        cprintf(cb, "\n%s", vec[i]);
+    if (clixon_digest_hex(cbuf_get(cb), digest) < 0)
+        goto done;
     retval = 0;
  done:
-    if (cvv)
-        cvec_free(cvv);
+    for (i = 0; i < len; i++)
+        free(vec[i]);
+    if (vec)
+        free(vec);
+    if (cb)
+        cbuf_free(cb);
     return retval;
 }
 
 /*! Get yanglib from user plugin callback, parse it and mount it
  *
- * Optionally check for shared yspec
+ * If CLICON_YANG_SCHEMA_MOUNT_SHARE is set, yspecs are named by the digest of the module-set
+ * and an existing yspec of the same digest in the domain is shared, so that each distinct
+ * module-set is parsed once.
  * @param[in]  h   Clixon handle
  * @param[in]  xt  XML tree node
  * @retval     1   OK
@@ -784,6 +853,7 @@ yang_schema_yanglib_parse_mount(clixon_handle h,
     yang_stmt *yspec1 = NULL;
     char      *xpath = NULL;
     char      *domain = NULL;
+    char      *digest = NULL;
     cbuf      *cb = NULL;
     int        ret;
     static unsigned int nr = 0;
@@ -816,16 +886,19 @@ yang_schema_yanglib_parse_mount(clixon_handle h,
         if ((ydomain = ydomain_new(h, domain)) == NULL)
             goto done;
     }
-    /* Optimization: find equal yspec from other mount-point */
-    if (clicon_option_bool(h, "CLICON_YANG_SCHEMA_MOUNT_SHARE")) {
-        if (yang_schema_find_share(h, xt, xyanglib, &yspec0) < 0)
-            goto done;
-    }
     if ((cb = cbuf_new()) == NULL){
         clixon_err(OE_YANG, errno, "cbuf_new");
         goto done;
     }
-    cprintf(cb, "%u", nr++);
+    /* Optimization: find yspec of equal module-set from other mount-point */
+    if (clicon_option_bool(h, "CLICON_YANG_SCHEMA_MOUNT_SHARE")) {
+        if (yang_schema_yanglib_digest(xyanglib, domain, &digest) < 0)
+            goto done;
+        yspec0 = yang_find(ydomain, Y_SPEC, digest);
+        cprintf(cb, "%s", digest);
+    }
+    else
+        cprintf(cb, "%u", nr++);
     if ((yspec1 = yspec_new_shared(h, xpath, domain, cbuf_get(cb), yspec0)) < 0)
         goto done;
     /* Either yspec0 = NULL and yspec1 is new, or yspec0 == yspec1 != NULL (shared) */
@@ -844,6 +917,8 @@ yang_schema_yanglib_parse_mount(clixon_handle h,
  done:
     if (cb)
         cbuf_free(cb);
+    if (digest)
+        free(digest);
     if (xpath)
         free(xpath);
     if (yspec1)
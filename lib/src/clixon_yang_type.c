@@ -180,7 +180,7 @@ yang_builtin(char *type)
  * @see match_regexp  in cligen code
  * @see yang_type_resolve_restrictions  where patterns is set
  */
-static int
+int
 compile_pattern2regexp(clixon_handle h,
                        yang_stmt    *ytype,
                        cvec         *patterns,
@@ -850,6 +850,8 @@ ys_cv_validate_leafref(clixon_handle h,
  * @retval     1      Validation OK
  * @retval     0      Validation not OK, malloced reason is returned. Free reason with free()
  * @retval    -1      Error (fatal), with errno set to indicate error
+ * @note If the member type is resolved in the type cache, its cached compiled regexps are used
+ *       directly
  */
 static int
 ys_cv_validate_union_one(clixon_handle h,
@@ -865,23 +867,33 @@ ys_cv_validate_union_one(clixon_handle h,
     cvec        *cvv = NULL;
     cvec        *regexps = NULL;
     cvec        *patterns = NULL;
+    cvec        *rxs;           /* compiled regexps, cached or in regexps */
     uint8_t      fraction = 0;
     char        *restype;
     enum cv_type cvtype;
     cg_var      *cvt=NULL;
     yang_stmt   *ysubt = NULL;
+    int          ret;
 
-    if ((regexps = cvec_new(0)) == NULL){
-        clixon_err(OE_UNIX, errno, "cvec_new");
-        goto done;
-    }
-    if ((patterns = cvec_new(0)) == NULL){
-        clixon_err(OE_UNIX, errno, "cvec_new");
+    if ((ret = yang_type_cache_get2(yt, &yrestype, &options, &cvv,
+                                    NULL, NULL, &fraction)) < 0)
         goto done;
+    if (ret == 1) /* Resolved type cache: no copying */
+        rxs = yang_type_cache_regexps(yt);
+    else {
+        if ((regexps = cvec_new(0)) == NULL){
+            clixon_err(OE_UNIX, errno, "cvec_new");
+            goto done;
+        }
+        if ((patterns = cvec_new(0)) == NULL){
+            clixon_err(OE_UNIX, errno, "cvec_new");
+            goto done;
+        }
+        if (yang_type_resolve(ys, ys, yt, &yrestype, &options, &cvv, patterns, regexps,
+                              &fraction) < 0)
+            goto done;
+        rxs = regexps;
     }
-    if (yang_type_resolve(ys, ys, yt, &yrestype, &options, &cvv, patterns, regexps,
-                          &fraction) < 0)
-        goto done;
     if (yrestype == NULL){
         clixon_err(OE_YANG, 0, "result-type should not be NULL");
         goto done;
@@ -917,7 +929,7 @@ ys_cv_validate_union_one(clixon_handle h,
         if (retval == 0)
             goto done;
         if ((retval = cv_validate1(h, cvt, cvtype, options, cvv,
-                                   regexps, yrestype, restype, reason)) < 0)
+                                   rxs, yrestype, restype, reason)) < 0)
             goto done;
     }
  done:
@@ -1015,7 +1027,6 @@ ys_cv_validate(clixon_handle h,
     cg_var         *ycv;        /* cv of yang-statement */
     int             options = 0;
     cvec           *cvv = NULL;
-    cvec           *patterns = NULL;
     cvec           *regexps = NULL;
     enum cv_type    cvtype;
     char           *origtype = NULL;  /* orig type */
@@ -1033,17 +1044,14 @@ ys_cv_validate(clixon_handle h,
         goto done;
     }
     ycv = yang_cv_get(ys);
-    if ((patterns = cvec_new(0)) == NULL){
-        clixon_err(OE_UNIX, errno, "cvec_new");
-        goto done;
-    }
     if ((regexps = cvec_new(0)) == NULL){
         clixon_err(OE_UNIX, errno, "cvec_new");
         goto done;
     }
+    /* Pattern strings are not needed, only compiled regexps */
     if (yang_type_get(ys, &origtype, &yrestype,
                       &options, &cvv,
-                      patterns,
+                      NULL,
                       regexps,
                       &fraction) < 0)
         goto done;
@@ -1109,8 +1117,6 @@ ys_cv_validate(clixon_handle h,
         free(origtype);
     if (regexps)
         cvec_free(regexps);
-    if (patterns)
-        cvec_free(patterns);
     if (cvt)
         cv_free(cvt);
     return retval;
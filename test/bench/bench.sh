@@ -0,0 +1,91 @@
+#!/usr/bin/env bash
+# Run clixon library micro-benchmarks on large lists, see doc/scaling/large-lists.md
+# and clixon_bench.c. Results are printed as one JSON object (or CSV line) per benchmark
+# and list size, eg for trend tracking.
+# The parameters are shown below (under Default values)
+# Examples
+# 1. Build and run all benchmarks on 1000, 10000 and 100000 entries
+#    ./bench.sh
+# 2. Only xpath benchmarks on one million entries as CSV
+#    sizes=1000000 only=xpath format=csv ./bench.sh
+# 3. Arena allocation from transparent huge pages
+#    arena=true hugepages=transparent ./bench.sh
+# Build clixon_bench first with: (cd ..; make clixon_bench)
+
+set -eu
+
+# Default values
+: ${sizes:="1000 10000 100000"} # List sizes, up to 10000000
+: ${reps:=10}          # Timed runs of each benchmark
+: ${lookups:=1000}     # Lookups in each xpath and hash lookup run
+: ${only:=}            # Only run benchmarks with this name prefix
+: ${format:=json}      # Output format: json or csv
+: ${arena:=false}      # CLICON_XML_ARENA
+: ${hugepages:=none}   # CLICON_XML_ARENA_HUGEPAGES: none, transparent or explicit
+: ${numa:=-1}          # CLICON_XML_ARENA_NUMA_NODE
+: ${bench:=$(dirname $0)/../clixon_bench} # Benchmark program
+: ${YANG_INSTALLDIR:=/usr/local/share/clixon}
+
+dir=$(mktemp -d /tmp/clixon_bench.XXXXXX)
+trap "rm -rf $dir" EXIT
+
+cfg=$dir/conf.xml
+fyang=$dir/scaling.yang
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_XML_ARENA>$arena</CLICON_XML_ARENA>
+  <CLICON_XML_ARENA_HUGEPAGES>$hugepages</CLICON_XML_ARENA_HUGEPAGES>
+  <CLICON_XML_ARENA_NUMA_NODE>$numa</CLICON_XML_ARENA_NUMA_NODE>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module scaling{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix sc;
+   container x {
+      description "top-level container";
+      list y {
+         description "List with potential large number of elements";
+         key "a";
+         leaf a {
+            description "key in list";
+            type int32;
+         }
+         leaf b {
+            description "payload data";
+            type string;
+         }
+      }
+      list z {
+         description "Ordered-by user list, filled by insert-user";
+         ordered-by user;
+         key "a";
+         leaf a {
+            type int32;
+         }
+      }
+   }
+}
+EOF
+
+opts="-f $cfg -r $reps -q $lookups -o $format"
+if [ -n "$only" ]; then
+    opts="$opts -b $only"
+fi
+
+first=true
+for n in $sizes; do
+    if [ $format = csv ] && ! $first; then
+        # Only one CSV header
+        $bench $opts -n $n | tail -n +2
+    else
+        $bench $opts -n $n
+    fi
+    first=false
+done
@@ -0,0 +1,1022 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, indicate
+  your decision by deleting the provisions above and replace them with the
+  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * In-process micro-benchmarks of clixon library hot paths
+ * The data is the large list of doc/scaling/large-lists.md:
+ *   <x><y><a>0</a><b>0</b></y>...<y><a>N-1</a><b>N-1</b></y></x>
+ * generated in memory. Each benchmark is run a number of times and the min, median and max
+ * time of a run is printed as one JSON object per line, or as CSV, for trend tracking.
+ * Only the measured operation is timed, setup such as parsing input trees is not.
+ * See bench.sh
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <syslog.h>
+#include <time.h>
+#include <sys/types.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include <clixon/clixon.h>
+#include <clixon/clixon_xpath_optimize.h>
+
+/* Command line options to be passed to getopt(3) */
+#define BENCH_OPTS "hD:f:n:r:q:b:o:"
+
+/* Namespace of the large-lists model */
+#define BENCH_NS "urn:example:clixon"
+
+/*! Output format of results */
+enum bench_format{
+    BENCH_JSON,
+    BENCH_CSV
+};
+
+/*! Benchmark state, shared input data of all benchmarks
+ */
+struct bench {
+    clixon_handle     b_h;
+    yang_stmt        *b_yspec;
+    cvec             *b_nsc;    /* Namespace context of xpaths */
+    int               b_n;      /* Number of list entries */
+    int               b_reps;   /* Number of timed runs of each benchmark */
+    int               b_q;      /* Number of lookups in each xpath run */
+    enum bench_format b_format;
+    char             *b_xml;    /* Generated XML of N entries */
+    char             *b_json;   /* Same as JSON */
+    cxobj            *b_xt;     /* Parsed and bound XML tree */
+    cxobj            *b_xt1;    /* Changed copy of b_xt for diff and merge */
+    uint64_t         *b_ns;     /* Time of each run in ns, b_reps entries */
+    char            **b_keys;   /* Hash keys "interface<i>", b_n entries */
+};
+
+/*! Benchmark function, runs the operation once with timing
+ *
+ * @param[in]  b   Benchmark state
+ * @param[out] ns  Time of the operation in nanoseconds, setup excluded
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+typedef int (bench_fn_t)(struct bench *b, uint64_t *ns);
+
+/*! Current monotonic time in nanoseconds
+ */
+static uint64_t
+bench_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec*1000000000ULL + ts.tv_nsec;
+}
+
+static int
+bench_ns_cmp(const void *a,
+             const void *b)
+{
+    uint64_t na = *(const uint64_t *)a;
+    uint64_t nb = *(const uint64_t *)b;
+
+    return na < nb ? -1 : na > nb;
+}
+
+/*! Parse a copy of the generated XML, optionally bind it to YANG
+ */
+static int
+bench_xml_parse1(struct bench *b,
+                 yang_bind     yb,
+                 cxobj       **xtp)
+{
+    int    retval = -1;
+    cxobj *xerr = NULL;
+    int    ret;
+
+    if ((ret = clixon_xml_parse_string(b->b_xml, yb, b->b_yspec, xtp, &xerr)) < 0)
+        goto done;
+    if (ret == 0){
+        clixon_err_netconf(b->b_h, OE_XML, EINVAL, xerr, "Parse bench data");
+        goto done;
+    }
+    retval = 0;
+ done:
+    if (xerr)
+        xml_free(xerr);
+    return retval;
+}
+
+/*! XML parse without YANG binding */
+static int
+bench_xml_parse(struct bench *b,
+                uint64_t     *ns)
+{
+    cxobj   *xt = NULL;
+    uint64_t t0;
+
+    t0 = bench_now();
+    if (bench_xml_parse1(b, YB_NONE, &xt) < 0)
+        return -1;
+    *ns = bench_now() - t0;
+    xml_free(xt);
+    return 0;
+}
+
+/*! JSON parse, RFC 7951 module-qualified names require YANG binding */
+static int
+bench_json_parse(struct bench *b,
+                 uint64_t     *ns)
+{
+    cxobj   *xt = NULL;
+    cxobj   *xerr = NULL;
+    uint64_t t0;
+    int      ret;
+
+    t0 = bench_now();
+    if ((ret = clixon_json_parse_string(b->b_json, 1, YB_MODULE, b->b_yspec, &xt, &xerr)) < 0)
+        return -1;
+    *ns = bench_now() - t0;
+    if (ret == 0){
+        clixon_err_netconf(b->b_h, OE_JSON, EINVAL, xerr, "Parse bench data");
+        xml_free(xerr);
+        return -1;
+    }
+    xml_free(xt);
+    return 0;
+}
+
+/*! YANG binding of a parsed tree, includes sorting */
+static int
+bench_bind(struct bench *b,
+           uint64_t     *ns)
+{
+    int      retval = -1;
+    cxobj   *xt = NULL;
+    cxobj   *xerr = NULL;
+    uint64_t t0;
+    int      ret;
+
+    if (bench_xml_parse1(b, YB_NONE, &xt) < 0)
+        goto done;
+    t0 = bench_now();
+    if ((ret = xml_bind_yang(b->b_h, xt, YB_MODULE, b->b_yspec, &xerr)) < 0)
+        goto done;
+    *ns = bench_now() - t0;
+    if (ret == 0){
+        clixon_err_netconf(b->b_h, OE_YANG, EINVAL, xerr, "Bind bench data");
+        goto done;
+    }
+    retval = 0;
+ done:
+    if (xerr)
+        xml_free(xerr);
+    if (xt)
+        xml_free(xt);
+    return retval;
+}
+
+/*! Sort of list entries in random order */
+static int
+bench_sort(struct bench *b,
+           uint64_t     *ns)
+{
+    cxobj   *xc;
+    cxobj   *xj;
+    uint64_t t0;
+    int      len;
+    int      i;
+    int      j;
+
+    if ((xc = xml_child_i_type(b->b_xt, 0, CX_ELMNT)) == NULL)
+        return 0;
+    /* Fisher-Yates shuffle of the list entries, same sequence in each run */
+    srandom(b->b_n);
+    len = xml_child_nr(xc);
+    for (i=len-1; i>0; i--){
+        j = random() % (i+1);
+        xj = xml_child_i(xc, j);
+        xml_child_i_set(xc, j, xml_child_i(xc, i));
+        xml_child_i_set(xc, i, xj);
+    }
+    t0 = bench_now();
+    if (xml_sort(xc) < 0)
+        return -1;
+    *ns = bench_now() - t0;
+    return 0;
+}
+
+/*! Insert entries in order in the middle of the list, and remove them
+ *
+ * Without the child vector gap, each insert and remove moves half of the list
+ */
+static int
+bench_insert(struct bench *b,
+             uint64_t     *ns)
+{
+    int      retval = -1;
+    cxobj   *xc;
+    cxobj  **vec = NULL;
+    uint64_t t0;
+    int      mid;
+    int      i;
+
+    if ((xc = xml_child_i_type(b->b_xt, 0, CX_ELMNT)) == NULL)
+        return 0;
+    if ((vec = calloc(b->b_q, sizeof(cxobj*))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    for (i=0; i<b->b_q; i++)
+        if ((vec[i] = xml_new("y", NULL, CX_ELMNT)) == NULL)
+            goto done;
+    mid = xml_child_nr(xc)/2;
+    t0 = bench_now();
+    for (i=0; i<b->b_q; i++){
+        if (xml_child_insert_pos(xc, vec[i], mid+i) < 0)
+            goto done;
+        xml_parent_set(vec[i], xc);
+    }
+    for (i=b->b_q-1; i>=0; i--)
+        if (xml_child_rm(xc, mid+i) < 0)
+            goto done;
+    *ns = bench_now() - t0;
+    retval = 0;
+ done:
+    if (vec){
+        for (i=0; i<b->b_q; i++)
+            if (vec[i] && xml_parent(vec[i]) == NULL)
+                xml_free(vec[i]);
+        free(vec);
+    }
+    return retval;
+}
+
+/*! Insert entries of an ordered-by user list, each after the previous one
+ *
+ * The insert anchor is given as a key, as in edit-config insert="after"
+ */
+static int
+bench_insert_user(struct bench *b,
+                  uint64_t     *ns)
+{
+    int        retval = -1;
+    cxobj     *xc;
+    cxobj     *xp = NULL;
+    cxobj    **vec = NULL;
+    cxobj     *xa;
+    yang_stmt *yz;
+    cbuf      *cb = NULL;
+    uint64_t   t0;
+    uint64_t   t;
+    int        i;
+
+    if ((xc = xml_child_i_type(b->b_xt, 0, CX_ELMNT)) == NULL ||
+        (yz = yang_find(xml_spec(xc), Y_LIST, "z")) == NULL)
+        return 0;
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if ((vec = calloc(b->b_q, sizeof(cxobj*))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    if ((xp = xml_new("x", NULL, CX_ELMNT)) == NULL)
+        goto done;
+    xml_spec_set(xp, xml_spec(xc));
+    for (i=0; i<b->b_q; i++){
+        if ((vec[i] = xml_new("z", NULL, CX_ELMNT)) == NULL)
+            goto done;
+        xml_spec_set(vec[i], yz);
+        cbuf_reset(cb);
+        cprintf(cb, "%d", i);
+        if ((xa = xml_new_body("a", vec[i], cbuf_get(cb))) == NULL)
+            goto done;
+        xml_spec_set(xa, yang_find(yz, Y_LEAF, "a"));
+    }
+    t = 0;
+    for (i=0; i<b->b_q; i++){
+        cbuf_reset(cb);
+        if (i)
+            cprintf(cb, "[a='%d']", i-1);
+        t0 = bench_now();
+        if (xml_insert(xp, vec[i], i?INS_AFTER:INS_LAST, i?cbuf_get(cb):NULL, NULL) < 0)
+            goto done;
+        t += bench_now() - t0;
+    }
+    *ns = t;
+    retval = 0;
+ done:
+    if (vec){
+        for (i=0; i<b->b_q; i++)
+            if (vec[i] && xml_parent(vec[i]) == NULL)
+                xml_free(vec[i]);
+        free(vec);
+    }
+    if (xp)
+        xml_free(xp);
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Random lookups of list entries with xpath, according to the global optimize and eval mode
+ */
+static int
+bench_xpath1(struct bench *b,
+             uint64_t     *ns)
+{
+    cxobj  **vec = NULL;
+    size_t   veclen;
+    uint64_t t0;
+    int      i;
+
+    srandom(b->b_n);
+    t0 = bench_now();
+    for (i=0; i<b->b_q; i++){
+        if (xpath_vec(b->b_xt, b->b_nsc, "/x/y[a='%ld']/b", &vec, &veclen,
+                      random() % b->b_n) < 0)
+            return -1;
+        if (vec){
+            free(vec);
+            vec = NULL;
+        }
+    }
+    *ns = bench_now() - t0;
+    return 0;
+}
+
+static int
+bench_xpath_opt_interpret(struct bench *b,
+                          uint64_t     *ns)
+{
+    xpath_list_optimize_set(1);
+    xpath_eval_mode_set(XPATH_EVAL_INTERPRET);
+    return bench_xpath1(b, ns);
+}
+
+static int
+bench_xpath_opt_compile(struct bench *b,
+                        uint64_t     *ns)
+{
+    xpath_list_optimize_set(1);
+    xpath_eval_mode_set(XPATH_EVAL_COMPILE);
+    return bench_xpath1(b, ns);
+}
+
+static int
+bench_xpath_noopt_interpret(struct bench *b,
+                            uint64_t     *ns)
+{
+    xpath_list_optimize_set(0);
+    xpath_eval_mode_set(XPATH_EVAL_INTERPRET);
+    return bench_xpath1(b, ns);
+}
+
+static int
+bench_xpath_noopt_compile(struct bench *b,
+                          uint64_t     *ns)
+{
+    xpath_list_optimize_set(0);
+    xpath_eval_mode_set(XPATH_EVAL_COMPILE);
+    return bench_xpath1(b, ns);
+}
+
+/*! Diff of the tree and a copy with every tenth entry changed */
+static int
+bench_diff(struct bench *b,
+           uint64_t     *ns)
+{
+    cxobj  **first = NULL;
+    cxobj  **second = NULL;
+    cxobj  **changed_x0 = NULL;
+    cxobj  **changed_x1 = NULL;
+    int      firstlen = 0;
+    int      secondlen = 0;
+    int      changedlen = 0;
+    uint64_t t0;
+
+    t0 = bench_now();
+    if (xml_diff(b->b_xt, b->b_xt1,
+                 &first, &firstlen, &second, &secondlen,
+                 &changed_x0, &changed_x1, &changedlen) < 0)
+        return -1;
+    *ns = bench_now() - t0;
+    if (first)
+        free(first);
+    if (second)
+        free(second);
+    if (changed_x0)
+        free(changed_x0);
+    if (changed_x1)
+        free(changed_x1);
+    return 0;
+}
+
+/*! Merge of the changed copy into a copy of the tree */
+static int
+bench_merge(struct bench *b,
+            uint64_t     *ns)
+{
+    int      retval = -1;
+    cxobj   *x0;
+    char    *reason = NULL;
+    uint64_t t0;
+    int      ret;
+
+    if ((x0 = xml_dup(b->b_xt)) == NULL)
+        goto done;
+    t0 = bench_now();
+    if ((ret = xml_merge(x0, b->b_xt1, b->b_yspec, &reason)) < 0)
+        goto done;
+    *ns = bench_now() - t0;
+    if (ret == 0){
+        clixon_err(OE_XML, EINVAL, "Merge bench data: %s", reason);
+        goto done;
+    }
+    retval = 0;
+ done:
+    if (reason)
+        free(reason);
+    if (x0)
+        xml_free(x0);
+    return retval;
+}
+
+/*! Full YANG validation of the tree */
+static int
+bench_validate(struct bench *b,
+               uint64_t     *ns)
+{
+    cxobj   *xerr = NULL;
+    uint64_t t0;
+    int      ret;
+
+    t0 = bench_now();
+    if ((ret = xml_yang_validate_all_top(b->b_h, b->b_xt, &xerr)) < 0)
+        return -1;
+    *ns = bench_now() - t0;
+    if (ret == 0){
+        clixon_err_netconf(b->b_h, OE_YANG, EINVAL, xerr, "Validate bench data");
+        xml_free(xerr);
+        return -1;
+    }
+    return 0;
+}
+
+/*! Serialize the tree as XML */
+static int
+bench_xml_print(struct bench *b,
+                uint64_t     *ns)
+{
+    cbuf    *cb;
+    uint64_t t0;
+
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        return -1;
+    }
+    t0 = bench_now();
+    if (clixon_xml2cbuf(cb, b->b_xt, 0, 0, NULL, -1, 1) < 0){
+        cbuf_free(cb);
+        return -1;
+    }
+    *ns = bench_now() - t0;
+    cbuf_free(cb);
+    return 0;
+}
+
+/*! Serialize the tree as JSON */
+static int
+bench_json_print(struct bench *b,
+                 uint64_t     *ns)
+{
+    cbuf    *cb;
+    uint64_t t0;
+
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        return -1;
+    }
+    t0 = bench_now();
+    if (clixon_json2cbuf(cb, b->b_xt, 0, 1, 0) < 0){
+        cbuf_free(cb);
+        return -1;
+    }
+    *ns = bench_now() - t0;
+    cbuf_free(cb);
+    return 0;
+}
+
+/*! Add all keys to a hash table
+ */
+static int
+bench_hash_add(struct bench *b,
+               uint64_t     *ns)
+{
+    clicon_hash_t *hash;
+    uint64_t       t0;
+    int            i;
+
+    if ((hash = clicon_hash_init()) == NULL)
+        return -1;
+    t0 = bench_now();
+    for (i=0; i<b->b_n; i++)
+        if (clicon_hash_add(hash, b->b_keys[i], &i, sizeof(i)) == NULL)
+            return -1;
+    *ns = bench_now() - t0;
+    clicon_hash_free(hash);
+    return 0;
+}
+
+/*! Random lookups of keys in a hash table
+ */
+static int
+bench_hash_lookup(struct bench *b,
+                  uint64_t     *ns)
+{
+    clicon_hash_t *hash;
+    uint64_t       t0;
+    int            i;
+
+    if ((hash = clicon_hash_init()) == NULL)
+        return -1;
+    for (i=0; i<b->b_n; i++)
+        if (clicon_hash_add(hash, b->b_keys[i], &i, sizeof(i)) == NULL)
+            return -1;
+    srandom(b->b_n);
+    t0 = bench_now();
+    for (i=0; i<b->b_q; i++)
+        if (clicon_hash_lookup(hash, b->b_keys[random() % b->b_n]) == NULL)
+            return -1;
+    *ns = bench_now() - t0;
+    clicon_hash_free(hash);
+    return 0;
+}
+
+/*
+ * Reference: the earlier clicon_hash, fixed 1031 bucket lists and a sum of characters as
+ * hash function, for comparison with the hash-add and hash-lookup benchmarks.
+ * Adding is quadratic in the number of keys on large sizes, since the keys only hash
+ * to a few buckets.
+ */
+#define CHAINED_SIZE 1031
+
+struct chained {
+    struct chained *c_next;
+    char           *c_key;
+    void           *c_val;
+};
+
+static uint32_t
+chained_bucket(const char *str)
+{
+    uint32_t n = 0;
+
+    while(*str)
+        n += (uint32_t)*str++;
+    return n % CHAINED_SIZE;
+}
+
+static struct chained *
+chained_lookup(struct chained **vec,
+               const char      *key)
+{
+    struct chained *c;
+
+    for (c = vec[chained_bucket(key)]; c; c = c->c_next)
+        if (strcmp(c->c_key, key) == 0)
+            return c;
+    return NULL;
+}
+
+static int
+chained_add(struct chained **vec,
+            const char      *key,
+            void            *val,
+            size_t           vlen)
+{
+    struct chained *c;
+    uint32_t        bkt;
+
+    if ((c = chained_lookup(vec, key)) == NULL){
+        if ((c = calloc(1, sizeof(*c))) == NULL ||
+            (c->c_key = strdup(key)) == NULL){
+            clixon_err(OE_UNIX, errno, "calloc");
+            return -1;
+        }
+        bkt = chained_bucket(key);
+        c->c_next = vec[bkt];
+        vec[bkt] = c;
+    }
+    if (c->c_val)
+        free(c->c_val);
+    if ((c->c_val = malloc(vlen)) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        return -1;
+    }
+    memcpy(c->c_val, val, vlen);
+    return 0;
+}
+
+static void
+chained_free(struct chained **vec)
+{
+    struct chained *c;
+    int             i;
+
+    for (i=0; i<CHAINED_SIZE; i++)
+        while ((c = vec[i]) != NULL){
+            vec[i] = c->c_next;
+            free(c->c_key);
+            free(c->c_val);
+            free(c);
+        }
+    free(vec);
+}
+
+/*! Add all keys to the earlier hash table
+ */
+static int
+bench_hash_chained_add(struct bench *b,
+                       uint64_t     *ns)
+{
+    struct chained **vec;
+    uint64_t         t0;
+    int              i;
+
+    if ((vec = calloc(CHAINED_SIZE, sizeof(*vec))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        return -1;
+    }
+    t0 = bench_now();
+    for (i=0; i<b->b_n; i++)
+        if (chained_add(vec, b->b_keys[i], &i, sizeof(i)) < 0)
+            return -1;
+    *ns = bench_now() - t0;
+    chained_free(vec);
+    return 0;
+}
+
+/*! Random lookups of keys in the earlier hash table
+ */
+static int
+bench_hash_chained_lookup(struct bench *b,
+                          uint64_t     *ns)
+{
+    struct chained **vec;
+    uint64_t         t0;
+    int              i;
+
+    if ((vec = calloc(CHAINED_SIZE, sizeof(*vec))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        return -1;
+    }
+    for (i=0; i<b->b_n; i++)
+        if (chained_add(vec, b->b_keys[i], &i, sizeof(i)) < 0)
+            return -1;
+    srandom(b->b_n);
+    t0 = bench_now();
+    for (i=0; i<b->b_q; i++)
+        if (chained_lookup(vec, b->b_keys[random() % b->b_n]) == NULL)
+            return -1;
+    *ns = bench_now() - t0;
+    chained_free(vec);
+    return 0;
+}
+
+/*! All benchmarks, in the order they are run
+ */
+static const struct {
+    const char *bn_name;
+    bench_fn_t *bn_fn;
+} bench_vec[] = {
+    {"xml-parse",              bench_xml_parse},
+    {"json-parse",             bench_json_parse},
+    {"bind",                   bench_bind},
+    {"sort",                   bench_sort},
+    {"insert",                 bench_insert},
+    {"insert-user",            bench_insert_user},
+    {"xpath-opt-interpret",    bench_xpath_opt_interpret},
+    {"xpath-opt-compile",      bench_xpath_opt_compile},
+    {"xpath-noopt-interpret",  bench_xpath_noopt_interpret},
+    {"xpath-noopt-compile",    bench_xpath_noopt_compile},
+    {"diff",                   bench_diff},
+    {"merge",                  bench_merge},
+    {"validate",               bench_validate},
+    {"xml-print",              bench_xml_print},
+    {"json-print",             bench_json_print},
+    {"hash-add",               bench_hash_add},
+    {"hash-lookup",            bench_hash_lookup},
+    {"hash-chained-add",       bench_hash_chained_add},
+    {"hash-chained-lookup",    bench_hash_chained_lookup},
+    {NULL,                     NULL}
+};
+
+/*! Generate XML and JSON of N entries, parse and bind them
+ *
+ * @param[in]  b   Benchmark state
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+static int
+bench_data(struct bench *b)
+{
+    int    retval = -1;
+    cbuf  *cbx = NULL;
+    cbuf  *cbj = NULL;
+    cxobj *xc;
+    cxobj *xy;
+    cxobj *xb;
+    int    i;
+
+    if ((cbx = cbuf_new()) == NULL ||
+        (cbj = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cbx, "<x xmlns=\"%s\">", BENCH_NS);
+    cprintf(cbj, "{\"scaling:x\":{\"y\":[");
+    for (i=0; i<b->b_n; i++){
+        cprintf(cbx, "<y><a>%d</a><b>%d</b></y>", i, i);
+        cprintf(cbj, "%s{\"a\":%d,\"b\":\"%d\"}", i?",":"", i, i);
+    }
+    cprintf(cbx, "</x>");
+    cprintf(cbj, "]}}");
+    if ((b->b_xml = strdup(cbuf_get(cbx))) == NULL ||
+        (b->b_json = strdup(cbuf_get(cbj))) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    if (bench_xml_parse1(b, YB_MODULE, &b->b_xt) < 0)
+        goto done;
+    /* Changed copy: every tenth payload is modified */
+    if ((b->b_xt1 = xml_dup(b->b_xt)) == NULL)
+        goto done;
+    if ((xc = xml_child_i_type(b->b_xt1, 0, CX_ELMNT)) != NULL){
+        xy = NULL;
+        i = 0;
+        while ((xy = xml_child_each(xc, xy, CX_ELMNT)) != NULL) {
+            if (i++ % 10)
+                continue;
+            if ((xb = xml_find_type(xy, NULL, "b", CX_ELMNT)) != NULL &&
+                xml_value_set(xml_body_get(xb), "changed") < 0)
+                goto done;
+        }
+    }
+    if ((b->b_nsc = xml_nsctx_init(NULL, BENCH_NS)) == NULL)
+        goto done;
+    if ((b->b_keys = calloc(b->b_n, sizeof(char*))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    for (i=0; i<b->b_n; i++){
+        cbuf_reset(cbx);
+        cprintf(cbx, "interface%d", i);
+        if ((b->b_keys[i] = strdup(cbuf_get(cbx))) == NULL){
+            clixon_err(OE_UNIX, errno, "strdup");
+            goto done;
+        }
+    }
+    retval = 0;
+ done:
+    if (cbx)
+        cbuf_free(cbx);
+    if (cbj)
+        cbuf_free(cbj);
+    return retval;
+}
+
+/*! Print result of one benchmark
+ */
+static void
+bench_print(struct bench *b,
+            const char   *name,
+            int           ops)
+{
+    uint64_t *v = b->b_ns;
+    int       n = b->b_reps;
+
+    qsort(v, n, sizeof(*v), bench_ns_cmp);
+    switch (b->b_format){
+    case BENCH_JSON:
+        fprintf(stdout, "{\"bench\":\"%s\",\"entries\":%d,\"reps\":%d,\"ops\":%d,"
+                "\"min_ns\":%" PRIu64 ",\"median_ns\":%" PRIu64 ",\"max_ns\":%" PRIu64 "}\n",
+                name, b->b_n, n, ops, v[0], v[n/2], v[n-1]);
+        break;
+    case BENCH_CSV:
+        fprintf(stdout, "%s,%d,%d,%d,%" PRIu64 ",%" PRIu64 ",%" PRIu64 "\n",
+                name, b->b_n, n, ops, v[0], v[n/2], v[n-1]);
+        break;
+    }
+    fflush(stdout);
+}
+
+/*! Run one benchmark b_reps times after one untimed warm-up run
+ */
+static int
+bench_run(struct bench *b,
+          const char   *name,
+          bench_fn_t   *fn)
+{
+    uint64_t ns = 0;
+    int      i;
+
+    if (fn(b, &ns) < 0)
+        return -1;
+    for (i=0; i<b->b_reps; i++){
+        ns = 0;
+        if (fn(b, &ns) < 0)
+            return -1;
+        b->b_ns[i] = ns;
+    }
+    bench_print(b, name, strncmp(name, "xpath", 5)==0 || strstr(name, "lookup") ||
+                strncmp(name, "insert", 6) == 0 ? b->b_q : 1);
+    return 0;
+}
+
+static void
+usage(clixon_handle h,
+      char         *argv0)
+{
+    fprintf(stderr, "usage:%s [options]\n"
+            "where options are\n"
+            "\t-h \t\tHelp\n"
+            "\t-D <level>\tDebug\n"
+            "\t-f <file>\tClixon config file with the large-lists YANG\n"
+            "\t-n <nr>\t\tNumber of list entries (default: 1000)\n"
+            "\t-r <nr>\t\tTimed runs of each benchmark (default: 10)\n"
+            "\t-q <nr>\t\tLookups in each xpath and hash lookup run (default: 1000)\n"
+            "\t-b <name>\tOnly run benchmark(s) with this name prefix\n"
+            "\t-o json|csv\tOutput format (default: json)\n",
+            argv0);
+    exit(0);
+}
+
+int
+main(int    argc,
+     char **argv)
+{
+    int           retval = -1;
+    clixon_handle h;
+    struct bench  b = {0,};
+    char         *str;
+    char         *only = NULL;
+    int           dbg = 0;
+    int           c;
+    int           i;
+
+    if ((h = clixon_handle_init()) == NULL)
+        goto done;
+    clixon_log_init(h, "clixon_bench", LOG_DEBUG, CLIXON_LOG_STDERR);
+    if (clixon_err_init(h) < 0)
+        goto done;
+    b.b_h = h;
+    b.b_n = 1000;
+    b.b_reps = 10;
+    b.b_q = 1000;
+    b.b_format = BENCH_JSON;
+    optind = 1;
+    opterr = 0;
+    while ((c = getopt(argc, argv, BENCH_OPTS)) != -1)
+        switch (c) {
+        case 'h':
+            usage(h, argv[0]);
+            break;
+        case 'D':
+            if ((dbg = clixon_debug_str2key(optarg)) < 0 &&
+                sscanf(optarg, "%d", &dbg) != 1){
+                usage(h, argv[0]);
+            }
+            break;
+        case 'f':
+            clicon_option_str_set(h, "CLICON_CONFIGFILE", optarg);
+            break;
+        case 'n':
+            b.b_n = atoi(optarg);
+            break;
+        case 'r':
+            b.b_reps = atoi(optarg);
+            break;
+        case 'q':
+            b.b_q = atoi(optarg);
+            break;
+        case 'b':
+            only = optarg;
+            break;
+        case 'o':
+            if (strcmp(optarg, "json") == 0)
+                b.b_format = BENCH_JSON;
+            else if (strcmp(optarg, "csv") == 0)
+                b.b_format = BENCH_CSV;
+            else
+                usage(h, argv[0]);
+            break;
+        default:
+            usage(h, argv[0]);
+            break;
+        }
+    if (b.b_n < 1 || b.b_reps < 1 || b.b_q < 1)
+        usage(h, argv[0]);
+    clixon_debug_init(h, dbg);
+    if (clicon_options_main(h) < 0)
+        goto done;
+    xml_arena_enable(clicon_option_bool(h, "CLICON_XML_ARENA"));
+    xml_arena_layout(clicon_xml_arena_hugepages(h),
+                     clicon_option_int(h, "CLICON_XML_ARENA_NUMA_NODE"));
+    yang_start(h);
+    if ((b.b_yspec = yspec_new1(h, YANG_DOMAIN_TOP, YANG_DATA_TOP)) == NULL)
+        goto done;
+    if ((str = clicon_yang_main_file(h)) != NULL){
+        if (yang_spec_parse_file(h, str, b.b_yspec) < 0)
+            goto done;
+    }
+    if ((str = clicon_yang_module_main(h)) != NULL){
+        if (yang_spec_parse_module(h, str, clicon_yang_module_revision(h), b.b_yspec) < 0)
+            goto done;
+    }
+    if ((str = clicon_yang_main_dir(h)) != NULL){
+        if (yang_spec_load_dir(h, str, b.b_yspec) < 0)
+            goto done;
+    }
+    if ((b.b_ns = calloc(b.b_reps, sizeof(*b.b_ns))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    if (bench_data(&b) < 0)
+        goto done;
+    if (b.b_format == BENCH_CSV)
+        fprintf(stdout, "bench,entries,reps,ops,min_ns,median_ns,max_ns\n");
+    for (i=0; bench_vec[i].bn_name; i++){
+        if (only && strncmp(bench_vec[i].bn_name, only, strlen(only)) != 0)
+            continue;
+        if (bench_run(&b, bench_vec[i].bn_name, bench_vec[i].bn_fn) < 0)
+            goto done;
+    }
+    retval = 0;
+ done:
+    if (b.b_ns)
+        free(b.b_ns);
+    if (b.b_xml)
+        free(b.b_xml);
+    if (b.b_json)
+        free(b.b_json);
+    if (b.b_xt)
+        xml_free(b.b_xt);
+    if (b.b_xt1)
+        xml_free(b.b_xt1);
+    if (b.b_nsc)
+        cvec_free(b.b_nsc);
+    if (b.b_keys){
+        for (i=0; i<b.b_n; i++)
+            if (b.b_keys[i])
+                free(b.b_keys[i]);
+        free(b.b_keys);
+    }
+    if (h){
+        xpath_optimize_exit();
+        yang_exit(h);
+        if (clicon_conf_xml(h))
+            xml_free(clicon_conf_xml(h));
+        clixon_handle_exit(h);
+    }
+    clixon_err_exit();
+    clixon_log_exit();
+    return retval==0 ? 0 : 255;
+}
@@ -0,0 +1,802 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, indicate
+  your decision by deleting the provisions above and replace them with the
+  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Load generator of the scaling benchmark suite, see scale.sh
+ * A number of concurrent clients send requests to the backend internal socket, to
+ * clixon_netconf processes, or to restconf over HTTP/1.1. Each client has one
+ * outstanding request at a time. The latency of each request is measured, and the
+ * throughput and latency percentiles of all clients are printed as one JSON object.
+ * Requests are made from a template file where %1$u is replaced by a random key
+ * number, so that requests are spread over list entries, and %2$u by a sequence number
+ * unique over all clients, eg a new value of an edit. %2$u may only be used together
+ * with %1$u. A literal % is written %%.
+ * A restconf template is a request line "<method> <path>", header lines, an empty line
+ * and the body, eg:
+ *   PUT /restconf/data/scaling:x/y=%1$u
+ *   Content-Type: application/yang-data+json
+ *
+ *   {"scaling:y":[{"a":%1$u,"b":"%1$u"}]}
+ * No clixon library calls are made, so that clients do not share any state.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <netdb.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+/* Command line options to be passed to getopt(3) */
+#define LOAD_OPTS "hp:t:c:n:w:k:s:e:a:o:l:"
+
+/* NETCONF 1.0 end of message */
+#define LOAD_EOM "]]>]]>"
+
+/*! Protocol of the clients */
+enum load_proto{
+    LOAD_BACKEND,  /* Backend internal socket, NETCONF chunked framing */
+    LOAD_NETCONF,  /* clixon_netconf process per client, NETCONF EOM framing */
+    LOAD_RESTCONF  /* HTTP/1.1 connection per client */
+};
+
+/*! Load state, shared by all clients and read-only while clients run
+ */
+struct load {
+    enum load_proto   l_proto;
+    char             *l_tmpl;    /* Request template */
+    int               l_clients; /* Number of concurrent clients */
+    int               l_n;       /* Timed requests per client */
+    int               l_warmup;  /* Untimed requests per client before timed requests */
+    int               l_keys;    /* Keys are random in [0, l_keys) */
+    char             *l_sock;    /* Backend UNIX socket */
+    char             *l_cmd;     /* NETCONF client command */
+    char             *l_host;    /* Restconf host */
+    char             *l_port;    /* Restconf port */
+    pthread_barrier_t l_barrier; /* Start of timed requests */
+};
+
+/*! One client, run by one thread
+ */
+struct load_client {
+    struct load *lc_load;
+    int          lc_id;
+    int          lc_out;      /* Socket or pipe to server */
+    int          lc_in;       /* Socket or pipe from server */
+    pid_t        lc_pid;      /* NETCONF client process */
+    pthread_t    lc_thread;
+    unsigned int lc_seed;     /* Random key seed */
+    unsigned int lc_seq;      /* Number of requests made */
+    char         lc_buf[65536]; /* Input buffer */
+    size_t       lc_off;
+    size_t       lc_len;
+    char        *lc_msg;      /* Received message */
+    size_t       lc_msglen;
+    size_t       lc_msgsize;
+    char        *lc_req;      /* Expanded request */
+    size_t       lc_reqsize;
+    char        *lc_http;     /* HTTP request */
+    size_t       lc_httpsize;
+    int          lc_status;   /* HTTP status of last reply */
+    int          lc_close;    /* Server closes HTTP connection after reply */
+    uint64_t    *lc_ns;       /* Latency of each timed request in ns */
+    int          lc_done;     /* Number of timed requests made */
+    int          lc_errors;   /* Error replies, and requests not made */
+};
+
+/*! Current monotonic time in nanoseconds
+ */
+static uint64_t
+load_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec*1000000000ULL + ts.tv_nsec;
+}
+
+static int
+load_ns_cmp(const void *a,
+            const void *b)
+{
+    uint64_t na = *(const uint64_t *)a;
+    uint64_t nb = *(const uint64_t *)b;
+
+    return na < nb ? -1 : na > nb;
+}
+
+/*! Read a file into a string
+ */
+static char *
+load_file(const char *filename)
+{
+    FILE  *f;
+    char  *str = NULL;
+    long   len;
+
+    if ((f = fopen(filename, "r")) == NULL){
+        fprintf(stderr, "fopen %s: %s\n", filename, strerror(errno));
+        return NULL;
+    }
+    if (fseek(f, 0, SEEK_END) < 0 || (len = ftell(f)) < 0 || fseek(f, 0, SEEK_SET) < 0)
+        goto done;
+    if ((str = malloc(len+1)) == NULL)
+        goto done;
+    if (fread(str, 1, len, f) != (size_t)len){
+        free(str);
+        str = NULL;
+        goto done;
+    }
+    str[len] = '\0';
+    while (len > 0 && str[len-1] == '\n') /* Trailing newlines of editors */
+        str[--len] = '\0';
+ done:
+    fclose(f);
+    return str;
+}
+
+/*! Write all of a buffer
+ */
+static int
+load_write(int         fd,
+           const char *buf,
+           size_t      len)
+{
+    ssize_t n;
+
+    while (len > 0){
+        if ((n = write(fd, buf, len)) < 0){
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        buf += n;
+        len -= n;
+    }
+    return 0;
+}
+
+/*! Next input byte
+ *
+ * @retval  c   Byte
+ * @retval -1   Error or EOF
+ */
+static int
+load_getc(struct load_client *lc)
+{
+    ssize_t n;
+
+    if (lc->lc_off == lc->lc_len){
+        do {
+            n = read(lc->lc_in, lc->lc_buf, sizeof(lc->lc_buf));
+        } while (n < 0 && errno == EINTR);
+        if (n <= 0)
+            return -1;
+        lc->lc_off = 0;
+        lc->lc_len = n;
+    }
+    return (unsigned char)lc->lc_buf[lc->lc_off++];
+}
+
+/*! Append a byte to received message
+ */
+static int
+load_msg_add(struct load_client *lc,
+             int                 c)
+{
+    char *p;
+
+    if (lc->lc_msglen + 2 > lc->lc_msgsize){
+        if ((p = realloc(lc->lc_msg, lc->lc_msgsize*2)) == NULL)
+            return -1;
+        lc->lc_msg = p;
+        lc->lc_msgsize *= 2;
+    }
+    lc->lc_msg[lc->lc_msglen++] = c;
+    lc->lc_msg[lc->lc_msglen] = '\0';
+    return 0;
+}
+
+/*! Receive a NETCONF 1.0 message ending with ]]>]]>
+ */
+static int
+load_rcv_eom(struct load_client *lc)
+{
+    size_t eomlen = strlen(LOAD_EOM);
+    int    c;
+
+    lc->lc_msglen = 0;
+    while ((c = load_getc(lc)) >= 0){
+        if (load_msg_add(lc, c) < 0)
+            return -1;
+        if (c == '>' && lc->lc_msglen >= eomlen &&
+            strcmp(lc->lc_msg + lc->lc_msglen - eomlen, LOAD_EOM) == 0)
+            return 0;
+    }
+    return -1;
+}
+
+/*! Receive a NETCONF 1.1 chunked message, RFC 6242
+ */
+static int
+load_rcv_chunked(struct load_client *lc)
+{
+    size_t size;
+    int    c;
+
+    lc->lc_msglen = 0;
+    while (1){
+        if (load_getc(lc) != '\n' || load_getc(lc) != '#')
+            return -1;
+        if ((c = load_getc(lc)) == '#')
+            return load_getc(lc) == '\n' ? 0 : -1;
+        size = 0;
+        while (c >= '0' && c <= '9'){
+            size = size*10 + c - '0';
+            c = load_getc(lc);
+        }
+        if (c != '\n' || size == 0)
+            return -1;
+        while (size--){
+            if ((c = load_getc(lc)) < 0 || load_msg_add(lc, c) < 0)
+                return -1;
+        }
+    }
+}
+
+/*! Read one CRLF-terminated line of HTTP header or chunk size into lc_msg from pos
+ */
+static int
+load_rcv_line(struct load_client *lc,
+              size_t             *pos)
+{
+    int c;
+
+    *pos = lc->lc_msglen;
+    while ((c = load_getc(lc)) >= 0){
+        if (c == '\n'){
+            if (lc->lc_msglen > *pos && lc->lc_msg[lc->lc_msglen-1] == '\r')
+                lc->lc_msg[--lc->lc_msglen] = '\0';
+            return 0;
+        }
+        if (load_msg_add(lc, c) < 0)
+            return -1;
+    }
+    return -1;
+}
+
+/*! Receive an HTTP/1.1 response, body with Content-Length or chunked
+ */
+static int
+load_rcv_http(struct load_client *lc)
+{
+    size_t pos;
+    size_t len = 0;
+    int    chunked = 0;
+    char  *line;
+    int    c;
+
+    lc->lc_msglen = 0;
+    lc->lc_close = 0;
+    if (load_rcv_line(lc, &pos) < 0 ||
+        sscanf(lc->lc_msg, "HTTP/%*s %d", &lc->lc_status) != 1)
+        return -1;
+    while (1){
+        if (load_rcv_line(lc, &pos) < 0)
+            return -1;
+        line = lc->lc_msg + pos;
+        if (*line == '\0')
+            break;
+        if (strncasecmp(line, "Content-Length:", 15) == 0)
+            len = strtoul(line+15, NULL, 10);
+        else if (strncasecmp(line, "Transfer-Encoding:", 18) == 0 && strstr(line, "chunked"))
+            chunked = 1;
+        else if (strncasecmp(line, "Connection:", 11) == 0 && strstr(line, "close"))
+            lc->lc_close = 1;
+    }
+    if (lc->lc_status == 204 || lc->lc_status == 304 || lc->lc_status < 200)
+        return 0;
+    if (!chunked){
+        while (len--)
+            if ((c = load_getc(lc)) < 0 || load_msg_add(lc, c) < 0)
+                return -1;
+        return 0;
+    }
+    while (1){
+        if (load_rcv_line(lc, &pos) < 0)
+            return -1;
+        if ((len = strtoul(lc->lc_msg + pos, NULL, 16)) == 0)
+            break;
+        while (len--)
+            if ((c = load_getc(lc)) < 0 || load_msg_add(lc, c) < 0)
+                return -1;
+        if (load_rcv_line(lc, &pos) < 0) /* CRLF after chunk */
+            return -1;
+    }
+    do { /* Trailer */
+        if (load_rcv_line(lc, &pos) < 0)
+            return -1;
+    } while (lc->lc_msg[pos] != '\0');
+    return 0;
+}
+
+/*! Connect client to server
+ */
+static int
+load_connect(struct load_client *lc)
+{
+    struct load       *l = lc->lc_load;
+    struct sockaddr_un sun;
+    struct addrinfo    hints;
+    struct addrinfo   *ai = NULL;
+    int                in[2];
+    int                out[2];
+    int                s = -1;
+    int                one = 1;
+    const char        *hello = "<hello xmlns=\"urn:ietf:params:xml:ns:netconf:base:1.0\">"
+        "<capabilities><capability>urn:ietf:params:netconf:base:1.0</capability></capabilities>"
+        "</hello>" LOAD_EOM;
+
+    lc->lc_off = lc->lc_len = 0;
+    switch (l->l_proto){
+    case LOAD_BACKEND:
+        if ((s = socket(AF_UNIX, SOCK_STREAM, 0)) < 0)
+            goto err;
+        memset(&sun, 0, sizeof(sun));
+        sun.sun_family = AF_UNIX;
+        strncpy(sun.sun_path, l->l_sock, sizeof(sun.sun_path)-1);
+        if (connect(s, (struct sockaddr *)&sun, sizeof(sun)) < 0)
+            goto err;
+        lc->lc_in = lc->lc_out = s;
+        break;
+    case LOAD_NETCONF:
+        if (pipe(in) < 0 || pipe(out) < 0)
+            goto err;
+        if ((lc->lc_pid = fork()) < 0)
+            goto err;
+        if (lc->lc_pid == 0){
+            dup2(out[0], 0);
+            dup2(in[1], 1);
+            close(in[0]); close(in[1]);
+            close(out[0]); close(out[1]);
+            execl("/bin/sh", "sh", "-c", l->l_cmd, (char *)NULL);
+            _exit(127);
+        }
+        close(in[1]);
+        close(out[0]);
+        lc->lc_in = in[0];
+        lc->lc_out = out[1];
+        /* The client command does not send hello (-q), replies use EOM framing */
+        if (load_write(lc->lc_out, hello, strlen(hello)) < 0)
+            goto err;
+        break;
+    case LOAD_RESTCONF:
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        if (getaddrinfo(l->l_host, l->l_port, &hints, &ai) != 0){
+            fprintf(stderr, "getaddrinfo %s:%s failed\n", l->l_host, l->l_port);
+            return -1;
+        }
+        if ((s = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol)) < 0)
+            goto err;
+        if (connect(s, ai->ai_addr, ai->ai_addrlen) < 0)
+            goto err;
+        freeaddrinfo(ai);
+        ai = NULL;
+        /* Requests are written at once, do not wait for more */
+        setsockopt(s, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        lc->lc_in = lc->lc_out = s;
+        break;
+    }
+    return 0;
+ err:
+    fprintf(stderr, "client %d connect: %s\n", lc->lc_id, strerror(errno));
+    if (ai)
+        freeaddrinfo(ai);
+    if (s != -1)
+        close(s);
+    return -1;
+}
+
+/*! Disconnect client from server
+ */
+static void
+load_disconnect(struct load_client *lc)
+{
+    int status;
+
+    if (lc->lc_out != -1)
+        close(lc->lc_out);
+    if (lc->lc_in != -1 && lc->lc_in != lc->lc_out)
+        close(lc->lc_in);
+    lc->lc_in = lc->lc_out = -1;
+    if (lc->lc_pid > 0){
+        waitpid(lc->lc_pid, &status, 0);
+        lc->lc_pid = 0;
+    }
+}
+
+/*! Expand request template with a random key and a sequence number
+ */
+static int
+load_expand(struct load_client *lc)
+{
+    struct load *l = lc->lc_load;
+    unsigned int key;
+    unsigned int seq;
+    int          len;
+    char        *p;
+
+    key = rand_r(&lc->lc_seed) % l->l_keys;
+    seq = lc->lc_seq++ * l->l_clients + lc->lc_id;
+    while ((len = snprintf(lc->lc_req, lc->lc_reqsize, l->l_tmpl, key, seq)) >= (int)lc->lc_reqsize){
+        if ((p = realloc(lc->lc_req, len+1)) == NULL)
+            return -1;
+        lc->lc_req = p;
+        lc->lc_reqsize = len+1;
+    }
+    return len;
+}
+
+/*! Build an HTTP/1.1 request in lc_http
+ *
+ * @param[in]  lc       Client
+ * @param[in]  line     Method and path
+ * @param[in]  headers  Header lines separated by newline, or NULL
+ * @param[in]  body     Body
+ * @retval     len      Length of request
+ * @retval    -1        Error
+ */
+static int
+load_http(struct load_client *lc,
+          const char         *line,
+          const char         *headers,
+          const char         *body)
+{
+    size_t size;
+    size_t len = 0;
+    char  *p;
+    char  *q;
+
+    size = strlen(line) + (headers?strlen(headers)*2:0) + strlen(body) + 128;
+    if (size > lc->lc_httpsize){
+        if ((p = realloc(lc->lc_http, size)) == NULL)
+            return -1;
+        lc->lc_http = p;
+        lc->lc_httpsize = size;
+    }
+    p = lc->lc_http;
+    len += sprintf(p+len, "%s HTTP/1.1\r\nHost: localhost\r\n", line);
+    while (headers && *headers){
+        if ((q = strchr(headers, '\n')) == NULL)
+            q = (char *)headers + strlen(headers);
+        len += sprintf(p+len, "%.*s\r\n", (int)(q-headers), headers);
+        headers = *q ? q+1 : q;
+    }
+    len += sprintf(p+len, "Content-Length: %zu\r\n\r\n%s", strlen(body), body);
+    return len;
+}
+
+/*! Send one request and receive its reply
+ *
+ * @retval  1   OK
+ * @retval  0   Error reply
+ * @retval -1   Error, eg closed connection
+ */
+static int
+load_request(struct load_client *lc)
+{
+    struct load *l = lc->lc_load;
+    char         hdr[64];
+    char        *body;
+    char        *path;
+    char        *headers;
+    int          len;
+    int          ret;
+
+    if (lc->lc_in == -1 && load_connect(lc) < 0)
+        return -1;
+    if ((len = load_expand(lc)) < 0)
+        return -1;
+    switch (l->l_proto){
+    case LOAD_BACKEND:
+        snprintf(hdr, sizeof(hdr), "\n#%d\n", len);
+        if (load_write(lc->lc_out, hdr, strlen(hdr)) < 0 ||
+            load_write(lc->lc_out, lc->lc_req, len) < 0 ||
+            load_write(lc->lc_out, "\n##\n", 4) < 0 ||
+            load_rcv_chunked(lc) < 0)
+            return -1;
+        return strstr(lc->lc_msg, "<rpc-error") == NULL;
+    case LOAD_NETCONF:
+        if (load_write(lc->lc_out, lc->lc_req, len) < 0 ||
+            load_write(lc->lc_out, LOAD_EOM, strlen(LOAD_EOM)) < 0 ||
+            load_rcv_eom(lc) < 0)
+            return -1;
+        return strstr(lc->lc_msg, "<rpc-error") == NULL;
+    case LOAD_RESTCONF:
+        /* Request line, headers, empty line and body */
+        path = lc->lc_req;
+        if ((body = strstr(path, "\n\n")) != NULL){
+            *body = '\0';
+            body += 2;
+        }
+        else
+            body = "";
+        if ((headers = strchr(path, '\n')) != NULL)
+            *headers++ = '\0';
+        if ((len = load_http(lc, path, headers, body)) < 0)
+            return -1;
+        if (load_write(lc->lc_out, lc->lc_http, len) < 0 ||
+            load_rcv_http(lc) < 0)
+            return -1;
+        ret = lc->lc_status < 400;
+        if (lc->lc_close)
+            load_disconnect(lc);
+        return ret;
+    }
+    return -1;
+}
+
+/*! Client thread: warm-up requests, wait for all clients, then timed requests
+ */
+static void *
+load_client_run(void *arg)
+{
+    struct load_client *lc = (struct load_client *)arg;
+    struct load        *l = lc->lc_load;
+    uint64_t            t0;
+    int                 ret = 1;
+    int                 i;
+
+    for (i=0; i<l->l_warmup && ret >= 0; i++)
+        ret = load_request(lc);
+    pthread_barrier_wait(&l->l_barrier);
+    for (i=0; i<l->l_n && ret >= 0; i++){
+        t0 = load_now();
+        if ((ret = load_request(lc)) < 0)
+            break;
+        lc->lc_ns[lc->lc_done++] = load_now() - t0;
+        if (ret == 0)
+            lc->lc_errors++;
+    }
+    if (ret < 0){
+        fprintf(stderr, "client %d: connection failed after %d requests\n", lc->lc_id, lc->lc_done);
+        lc->lc_errors += l->l_n - lc->lc_done;
+    }
+    load_disconnect(lc);
+    return NULL;
+}
+
+static void
+usage(char *argv0)
+{
+    fprintf(stderr, "usage:%s [options]\n"
+            "where options are\n"
+            "\t-h \t\tHelp\n"
+            "\t-p <proto>\tbackend, netconf or restconf (default: backend)\n"
+            "\t-t <file>\tRequest template, %%1$u is replaced by a random key, %%2$u by a sequence number\n"
+            "\t-c <nr>\t\tConcurrent clients (default: 1)\n"
+            "\t-n <nr>\t\tTimed requests per client (default: 100)\n"
+            "\t-w <nr>\t\tUntimed warm-up requests per client (default: 1)\n"
+            "\t-k <nr>\t\tKeys are random numbers less than this (default: 1000)\n"
+            "\t-s <path>\tBackend UNIX socket, see CLICON_SOCK\n"
+            "\t-e <cmd>\tNETCONF client command without hello, eg \"clixon_netconf -qf <file>\"\n"
+            "\t-a <host:port>\tRestconf HTTP address (default: localhost:80)\n"
+            "\t-o <name>\tOperation name in result (default: template file name)\n"
+            "\t-l <json>\tJSON members first in result, eg '\"profile\":\"depth\",\"size\":4'\n",
+            argv0);
+    exit(0);
+}
+
+int
+main(int    argc,
+     char **argv)
+{
+    int                 retval = -1;
+    struct load         l = {0,};
+    struct load_client *lcv = NULL;
+    struct load_client *lc;
+    uint64_t           *ns = NULL;
+    uint64_t            t0;
+    uint64_t            t1;
+    char               *tfile = NULL;
+    char               *op = NULL;
+    char               *label = NULL;
+    char               *addr = "localhost:80";
+    char               *p;
+    double              secs;
+    int                 done = 0;
+    int                 errors = 0;
+    int                 c;
+    int                 i;
+
+    l.l_proto = LOAD_BACKEND;
+    l.l_clients = 1;
+    l.l_n = 100;
+    l.l_warmup = 1;
+    l.l_keys = 1000;
+    optind = 1;
+    opterr = 0;
+    while ((c = getopt(argc, argv, LOAD_OPTS)) != -1)
+        switch (c) {
+        case 'p':
+            if (strcmp(optarg, "backend") == 0)
+                l.l_proto = LOAD_BACKEND;
+            else if (strcmp(optarg, "netconf") == 0)
+                l.l_proto = LOAD_NETCONF;
+            else if (strcmp(optarg, "restconf") == 0)
+                l.l_proto = LOAD_RESTCONF;
+            else
+                usage(argv[0]);
+            break;
+        case 't':
+            tfile = optarg;
+            break;
+        case 'c':
+            l.l_clients = atoi(optarg);
+            break;
+        case 'n':
+            l.l_n = atoi(optarg);
+            break;
+        case 'w':
+            l.l_warmup = atoi(optarg);
+            break;
+        case 'k':
+            l.l_keys = atoi(optarg);
+            break;
+        case 's':
+            l.l_sock = optarg;
+            break;
+        case 'e':
+            l.l_cmd = optarg;
+            break;
+        case 'a':
+            addr = optarg;
+            break;
+        case 'o':
+            op = optarg;
+            break;
+        case 'l':
+            label = optarg;
+            break;
+        case 'h':
+        default:
+            usage(argv[0]);
+            break;
+        }
+    if (tfile == NULL || l.l_clients < 1 || l.l_n < 1 || l.l_warmup < 0 || l.l_keys < 1 ||
+        (l.l_proto == LOAD_BACKEND && l.l_sock == NULL) ||
+        (l.l_proto == LOAD_NETCONF && l.l_cmd == NULL))
+        usage(argv[0]);
+    if ((l.l_host = strdup(addr)) == NULL)
+        goto done;
+    if ((p = strrchr(l.l_host, ':')) != NULL){
+        *p = '\0';
+        l.l_port = p+1;
+    }
+    else
+        l.l_port = "80";
+    if (op == NULL)
+        op = (p = strrchr(tfile, '/')) ? p+1 : tfile;
+    if ((l.l_tmpl = load_file(tfile)) == NULL)
+        goto done;
+    signal(SIGPIPE, SIG_IGN);
+    if ((lcv = calloc(l.l_clients, sizeof(*lcv))) == NULL)
+        goto done;
+    /* Connect all clients before any request */
+    for (i=0; i<l.l_clients; i++){
+        lc = &lcv[i];
+        lc->lc_load = &l;
+        lc->lc_id = i;
+        lc->lc_in = lc->lc_out = -1;
+        lc->lc_seed = i + 1;
+        lc->lc_msgsize = 4096;
+        lc->lc_reqsize = strlen(l.l_tmpl) + 256;
+        if ((lc->lc_msg = malloc(lc->lc_msgsize)) == NULL ||
+            (lc->lc_req = malloc(lc->lc_reqsize)) == NULL ||
+            (lc->lc_ns = calloc(l.l_n, sizeof(uint64_t))) == NULL)
+            goto done;
+        if (load_connect(lc) < 0)
+            goto done;
+    }
+    pthread_barrier_init(&l.l_barrier, NULL, l.l_clients + 1);
+    for (i=0; i<l.l_clients; i++)
+        if (pthread_create(&lcv[i].lc_thread, NULL, load_client_run, &lcv[i]) != 0){
+            fprintf(stderr, "pthread_create: %s\n", strerror(errno));
+            exit(1); /* Other threads wait on barrier */
+        }
+    pthread_barrier_wait(&l.l_barrier);
+    t0 = load_now();
+    for (i=0; i<l.l_clients; i++)
+        pthread_join(lcv[i].lc_thread, NULL);
+    t1 = load_now();
+    pthread_barrier_destroy(&l.l_barrier);
+    /* Merge latencies of all clients */
+    if ((ns = calloc(l.l_clients * l.l_n, sizeof(uint64_t))) == NULL)
+        goto done;
+    for (i=0; i<l.l_clients; i++){
+        memcpy(ns + done, lcv[i].lc_ns, lcv[i].lc_done * sizeof(uint64_t));
+        done += lcv[i].lc_done;
+        errors += lcv[i].lc_errors;
+    }
+    qsort(ns, done, sizeof(*ns), load_ns_cmp);
+    secs = (t1 - t0) / 1e9;
+    fprintf(stdout, "{%s%s\"proto\":\"%s\",\"op\":\"%s\",\"clients\":%d,\"requests\":%d,"
+            "\"errors\":%d,\"secs\":%.3f,\"rps\":%.1f,"
+            "\"p50_us\":%.1f,\"p99_us\":%.1f,\"max_us\":%.1f}\n",
+            label?label:"", label?",":"",
+            l.l_proto==LOAD_BACKEND?"backend":l.l_proto==LOAD_NETCONF?"netconf":"restconf",
+            op, l.l_clients, done, errors, secs, secs>0?done/secs:0.0,
+            done?ns[done*50/100]/1e3:0.0,
+            done?ns[done*99/100]/1e3:0.0,
+            done?ns[done-1]/1e3:0.0);
+    fflush(stdout);
+    retval = 0;
+ done:
+    if (retval < 0)
+        fprintf(stderr, "%s: setup failed\n", argv[0]);
+    if (lcv){
+        for (i=0; i<l.l_clients; i++){
+            lc = &lcv[i];
+            load_disconnect(lc);
+            if (lc->lc_msg)
+                free(lc->lc_msg);
+            if (lc->lc_req)
+                free(lc->lc_req);
+            if (lc->lc_http)
+                free(lc->lc_http);
+            if (lc->lc_ns)
+                free(lc->lc_ns);
+        }
+        free(lcv);
+    }
+    if (ns)
+        free(ns);
+    if (l.l_tmpl)
+        free(l.l_tmpl);
+    if (l.l_host)
+        free(l.l_host);
+    return retval == 0 ? 0 : 1;
+}
@@ -0,0 +1,409 @@
+#!/usr/bin/env bash
+# Scaling benchmark suite, see README.md
+# Generates parametric YANG and data for a profile, starts backend and restconf, and
+# drives backend, netconf and restconf with concurrent clients using clixon_load.
+# Results are printed as one JSON object per line:
+# - per profile size, protocol, operation and number of clients: throughput and
+#   p50/p99/max latency
+# - per profile size: startup time and RSS of backend and restconf
+# The parameters are shown below (under Default values)
+# Profiles:
+#   depth    Nested containers and lists, fanout entries in each list, sizes are depths
+#   breadth  One list with width leafs in each entry, sizes are numbers of entries
+#   mounts   Entries with a mount point each (RFC 8528), sizes are numbers of mount points
+#   schema   Generated modules with leafs leafs each, sizes are numbers of modules
+# Examples
+# 1. Build and run all profiles
+#    (cd ..; make clixon_load); ./scale.sh
+# 2. Deep trees with 1, 10 and 100 restconf clients
+#    profiles=depth sizes="4 8" protos=restconf clients="1 10 100" ./scale.sh
+# 3. Baseline and an option to evaluate, eg edit-scoped direct commit
+#    profiles=breadth ./scale.sh > base.json
+#    profiles=breadth options="<CLICON_XMLDB_RUNNING_DIRECT>true</CLICON_XMLDB_RUNNING_DIRECT>" ./scale.sh > direct.json
+# Needs root (sudo) to start the daemons, as the tests
+
+cd $(dirname $0)/..
+. ./lib.sh
+
+# Default values
+: ${profiles:="depth breadth mounts schema"} # Profiles to run
+: ${sizes:=}              # Sizes of each profile, default per profile below
+: ${protos:="backend netconf restconf"} # Protocols of clients
+: ${ops:="get edit"}      # get: read one leaf, edit: edit one leaf with autocommit
+: ${clients:="1 10"}      # Numbers of concurrent clients
+: ${reqs:=100}            # Timed requests per client
+: ${warmup:=10}           # Untimed requests per client
+: ${fanout:=4}            # depth: entries in each list
+: ${width:=10}            # breadth: leafs in each list entry
+: ${mentries:=10}         # mounts: list entries in each mount point
+: ${leafs:=10}            # schema: leafs in each module
+: ${options:=}            # Extra clixon-config options of all runs, eg feature options
+: ${load:=$(pwd)/clixon_load} # Load generator
+: ${resdir:=}             # If set, also save results in $resdir/scale-<arch>.json
+
+APPNAME=example
+cfg=$dir/scale-conf.xml
+fyang=$dir/scaling.yang
+fmount=$dir/scaling-mount.yang
+ydir=$dir/yang
+sock=/usr/local/var/run/$APPNAME.sock
+MOUNTARGS=
+
+if [ ! -x ${load%% *} ]; then
+    echo "$load not found, build it with: (cd $(pwd); make clixon_load)" >&2
+    exit 1
+fi
+# Same group as other clients for access to the backend socket
+if [ -n "$CLICON_GROUP" ] && [[ "$clixon_netconf" == sudo* ]]; then
+    load="sudo -g ${CLICON_GROUP} $load"
+fi
+
+# Print result line, also to the result file
+function result()
+{
+    echo "$1"
+    if [ -n "$resdir" ]; then
+        echo "$1" >> $resdir/scale-$(arch).json
+    fi
+}
+
+# Generate config file
+# 1: Extra options of the profile
+function genconfig()
+{
+    cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_FEATURE>clixon-restconf:allow-auth-none</CLICON_FEATURE>
+  <CLICON_YANG_DIR>$dir</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_SOCK>$sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_PRETTY>false</CLICON_XMLDB_PRETTY>
+  $1
+  $options
+  $(restconf_config none false http)
+</clixon-config>
+EOF
+}
+
+# Write netconf and restconf request templates of get and edit of one leaf
+# %1$u is a random key and %2$u a sequence number, see clixon_load.c
+# 1: get-config xpath filter of the leaf, with prefix m
+# 2: namespace of prefix m
+# 3: edit-config config of the leaf
+# 4: restconf path of the leaf after /restconf/data/
+# 5: restconf PUT body of the leaf in JSON
+function gentmpl()
+{
+    echo "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"$1\" xmlns:m=\"$2\"/></get-config></rpc>" > $dir/get.xml
+    echo "GET /restconf/data/$4
+Accept: application/yang-data+json" > $dir/get.http
+    echo "<rpc $DEFAULTNS><edit-config xmlns:cl=\"http://clicon.org/lib\" cl:autocommit=\"true\"><target><candidate/></target><config>$3</config></edit-config></rpc>" > $dir/edit.xml
+    echo "PUT /restconf/data/$4
+Content-Type: application/yang-data+json
+
+$5" > $dir/edit.http
+}
+
+# Nested containers and lists, fanout entries in each list
+#   container c1 { list l { key name; container c2 { ... list l { key name; leaf v }}}}
+# 1: depth
+function gendepth()
+{
+    depth=$1
+    {
+        echo "module scaling{ yang-version 1.1; namespace \"urn:example:clixon\"; prefix sc;"
+        for (( d=1; d<=$depth; d++ )); do
+            echo "container c$d { list l { key name; leaf name { type uint32; }"
+        done
+        echo "leaf v { type uint32; }"
+        for (( d=1; d<=$depth; d++ )); do
+            echo "}}"
+        done
+        echo "}"
+    } > $fyang
+    # fanout^depth leaf entries
+    echo -n "<${DATASTORE_TOP}>" > $dir/startup_db
+    gendepth1 1 $depth "" >> $dir/startup_db
+    echo "</${DATASTORE_TOP}>" >> $dir/startup_db
+    xpath=
+    config=
+    path=
+    for (( d=1; d<=$depth; d++ )); do
+        xpath+="/m:c$d/m:l[m:name='%1\$u']"
+        path+="/c$d/l=%1\$u"
+    done
+    for (( d=$depth; d>=1; d-- )); do
+        config="<c$d><l><name>%1\$u</name>$config"
+    done
+    config="<c1 xmlns=\"urn:example:clixon\">${config#<c1>}<v>%2\$u</v>"
+    for (( d=$depth; d>=1; d-- )); do
+        config+="</l></c$d>"
+    done
+    gentmpl "$xpath/m:v" urn:example:clixon "$config" "scaling:${path#/}/v" "{\"scaling:v\":%2\$u}"
+    keys=$fanout
+    genconfig "<CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>"
+}
+
+# Recursive data of gendepth
+# 1: level
+# 2: depth
+function gendepth1()
+{
+    local level=$1
+    local depth=$2
+    local i
+    if [ $level -eq 1 ]; then
+        echo -n "<c1 xmlns=\"urn:example:clixon\">"
+    else
+        echo -n "<c$level>"
+    fi
+    for (( i=0; i<$fanout; i++ )); do
+        echo -n "<l><name>$i</name>"
+        if [ $level -eq $depth ]; then
+            echo -n "<v>$i</v>"
+        else
+            gendepth1 $((level+1)) $depth
+        fi
+        echo -n "</l>"
+    done
+    echo -n "</c$level>"
+}
+
+# One list with width leafs in each entry
+# 1: entries
+function genbreadth()
+{
+    nr=$1
+    {
+        echo "module scaling{ yang-version 1.1; namespace \"urn:example:clixon\"; prefix sc;"
+        echo "container x { list y { key a; leaf a { type uint32; }"
+        for (( j=0; j<$width; j++ )); do
+            echo "leaf b$j { type uint32; }"
+        done
+        echo "}}}"
+    } > $fyang
+    entry=
+    for (( j=0; j<$width; j++ )); do
+        entry+="<b$j>0</b$j>"
+    done
+    {
+        echo -n "<${DATASTORE_TOP}><x xmlns=\"urn:example:clixon\">"
+        for (( i=0; i<$nr; i++ )); do
+            echo -n "<y><a>$i</a>$entry</y>"
+        done
+        echo "</x></${DATASTORE_TOP}>"
+    } > $dir/startup_db
+    gentmpl "/m:x/m:y[m:a='%1\$u']/m:b0" urn:example:clixon "<x xmlns=\"urn:example:clixon\"><y><a>%1\$u</a><b0>%2\$u</b0></y></x>" "scaling:x/y=%1\$u/b0" "{\"scaling:b0\":%2\$u}"
+    keys=$nr
+    genconfig "<CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>"
+}
+
+# Entries with a mount point each, the example plugin mounts scaling-mount
+# 1: mount points
+function genmounts()
+{
+    nr=$1
+    cat <<EOF > $fyang
+module scaling{
+  yang-version 1.1;
+  namespace "urn:example:clixon";
+  prefix sc;
+  import ietf-yang-schema-mount {
+    prefix yangmnt;
+  }
+  container top{
+    list mylist{
+      key name;
+      leaf name{
+        type uint32;
+      }
+      container root{
+        presence "Otherwise root is not visible";
+        yangmnt:mount-point "mylabel";
+      }
+    }
+  }
+}
+EOF
+    cat <<EOF > $fmount
+module scaling-mount{
+  yang-version 1.1;
+  namespace "urn:example:mount";
+  prefix mnt;
+  container mnt{
+    list e{
+      key k;
+      leaf k{
+        type uint32;
+      }
+      leaf v{
+        type uint32;
+      }
+    }
+  }
+}
+EOF
+    entry="<mnt xmlns=\"urn:example:mount\">"
+    for (( j=0; j<$mentries; j++ )); do
+        entry+="<e><k>$j</k><v>0</v></e>"
+    done
+    entry+="</mnt>"
+    {
+        echo -n "<${DATASTORE_TOP}><top xmlns=\"urn:example:clixon\">"
+        for (( i=0; i<$nr; i++ )); do
+            echo -n "<mylist><name>$i</name><root>$entry</root></mylist>"
+        done
+        echo "</top></${DATASTORE_TOP}>"
+    } > $dir/startup_db
+    gentmpl "/ex:top/ex:mylist[ex:name='%1\$u']/ex:root/m:mnt/m:e[m:k='0']/m:v\" xmlns:ex=\"urn:example:clixon" urn:example:mount "<top xmlns=\"urn:example:clixon\"><mylist><name>%1\$u</name><root><mnt xmlns=\"urn:example:mount\"><e><k>0</k><v>%2\$u</v></e></mnt></root></mylist></top>" "scaling:top/mylist=%1\$u/root/scaling-mount:mnt/e=0/v" "{\"scaling-mount:v\":%2\$u}"
+    keys=$nr
+    MOUNTARGS="-- -m scaling-mount -M urn:example:mount"
+    genconfig "<CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_YANG_LIBRARY>true</CLICON_YANG_LIBRARY>
+  <CLICON_YANG_SCHEMA_MOUNT>true</CLICON_YANG_SCHEMA_MOUNT>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_RESTCONF_DIR>/usr/local/lib/$APPNAME/restconf</CLICON_RESTCONF_DIR>"
+}
+
+# Generated modules sc<i>, each with a container of leafs leafs
+# 1: modules
+function genschema()
+{
+    nr=$1
+    rm -rf $ydir
+    mkdir $ydir
+    echo -n "<${DATASTORE_TOP}>" > $dir/startup_db
+    for (( i=0; i<$nr; i++ )); do
+        {
+            echo "module sc$i{ yang-version 1.1; namespace \"urn:example:sc$i\"; prefix sc$i;"
+            echo "container c { description \"Generated container\";"
+            for (( j=0; j<$leafs; j++ )); do
+                echo "leaf l$j { type uint32; description \"Generated leaf\"; }"
+            done
+            echo "}}"
+        } > $ydir/sc$i.yang
+        echo -n "<c xmlns=\"urn:example:sc$i\"><l0>0</l0></c>" >> $dir/startup_db
+    done
+    echo "</${DATASTORE_TOP}>" >> $dir/startup_db
+    gentmpl "/m:c/m:l0" "urn:example:sc%1\$u" "<c xmlns=\"urn:example:sc%1\$u\"><l0>%2\$u</l0></c>" "sc%1\$u:c/l0" "{\"sc%1\$u:l0\":%2\$u}"
+    keys=$nr
+    genconfig "<CLICON_YANG_MAIN_DIR>$ydir</CLICON_YANG_MAIN_DIR>"
+}
+
+# RSS and peak RSS in kB of a daemon
+# 1: process name
+function rss()
+{
+    # Newest, not a sudo parent
+    pid=$(pgrep -n -f "$1.*$cfg")
+    if [ -z "$pid" ]; then
+        echo -n "null,null"
+    else
+        sudo awk '/^VmRSS/ {r=$2} /^VmHWM/ {h=$2} END {printf "%d,%d", r, h}' /proc/$pid/status
+    fi
+}
+
+# Run one profile size: startup time, load of each protocol, op and nr of clients, RSS
+# 1: profile
+# 2: size
+function runsize()
+{
+    profile=$1
+    size=$2
+    label="\"profile\":\"$profile\",\"size\":$size"
+    MOUNTARGS=
+    new "generate $profile $size"
+    gen$profile $size
+    startup_db=$(cat $dir/startup_db)
+
+    sudo clixon_backend -zf $cfg > /dev/null 2>&1
+    stop_restconf_pre > /dev/null 2>&1
+    # Startup time: read, validate and commit startup once and quit
+    t0=$(date +%s%N)
+    sudo $clixon_backend -F1 -D $DBG -s startup -f $cfg $MOUNTARGS > /dev/null 2>&1
+    if [ $? -ne 0 ]; then
+        err "backend startup of $profile $size"
+    fi
+    t1=$(date +%s%N)
+    startup_ms=$(( (t1 - t0) / 1000000 ))
+    echo "$startup_db" > $dir/startup_db
+
+    new "start backend -s startup -f $cfg $MOUNTARGS"
+    start_backend -s startup -f $cfg $MOUNTARGS
+    wait_backend
+    rss0=$(rss clixon_backend)
+    if [[ " $protos " == *" restconf "* ]]; then
+        new "start restconf -f $cfg $MOUNTARGS"
+        start_restconf -f $cfg $MOUNTARGS
+        wait_restconf http
+    fi
+    for c in $clients; do
+        for pr in $protos; do
+            for op in $ops; do
+                new "$profile $size $pr $op $c clients"
+                case $pr in
+                    backend)
+                        args="-p backend -s $sock -t $dir/$op.xml"
+                        ;;
+                    netconf)
+                        args="-p netconf -t $dir/$op.xml"
+                        ;;
+                    restconf)
+                        args="-p restconf -a localhost:80 -t $dir/$op.http"
+                        ;;
+                esac
+                # netconf command is quoted, other args are not
+                if [ $pr = netconf ]; then
+                    res=$($load $args -e "$clixon_netconf -qf $cfg" -c $c -n $reqs -w $warmup -k $keys -o $op -l "$label")
+                else
+                    res=$($load $args -c $c -n $reqs -w $warmup -k $keys -o $op -l "$label")
+                fi
+                if [ $? -ne 0 ]; then
+                    err "clixon_load $args" "$res"
+                fi
+                result "$res"
+            done
+        done
+    done
+    rss1=$(rss clixon_backend)
+    rssrc=null,null
+    if [[ " $protos " == *" restconf "* ]]; then
+        rssrc=$(rss clixon_restconf)
+        stop_restconf
+    fi
+    result "{$label,\"startup_ms\":$startup_ms,\"backend_rss_kb\":${rss0%,*},\"backend_load_rss_kb\":${rss1%,*},\"backend_hwm_kb\":${rss1#*,},\"restconf_rss_kb\":${rssrc%,*},\"restconf_hwm_kb\":${rssrc#*,}}"
+    stop_backend -f $cfg
+}
+
+if [ -n "$resdir" ] && [ ! -d $resdir ]; then
+    mkdir -p $resdir
+fi
+
+for profile in $profiles; do
+    case $profile in
+        depth)
+            psizes=${sizes:-"2 4 6"}
+            ;;
+        breadth)
+            psizes=${sizes:-"1000 10000 100000"}
+            ;;
+        mounts)
+            psizes=${sizes:-"10 100 1000"}
+            ;;
+        schema)
+            psizes=${sizes:-"10 100 1000"}
+            ;;
+        *)
+            echo "Unknown profile: $profile" >&2
+            exit 1
+            ;;
+    esac
+    for size in $psizes; do
+        runsize $profile $size
+    done
+done
+
+rm -rf $dir
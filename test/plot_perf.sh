@@ -8,6 +8,8 @@
 #    run=false plot=true resdir=/tmp/plots term=x11 ./plot_perf.sh
 # 3. Use existing data plot i686 and armv7l data as png
 #    archs="i686 armv7l" run=false plot=true resdir=/tmp/plots term=png ./plot_perf.sh 
+# 4. Measure single entry operations in edit-scoped mode, see CLICON_XMLDB_RUNNING_DIRECT_SPARSE
+#    sparse=true run=true plot=false to=100000 step=10000 resdir=/tmp/sparse ./plot_perf.sh
 # Need gnuplot installed
 
 set -u
@@ -27,6 +29,7 @@ arch=$(arch)
 : ${archs=$arch} # Plotting can be made for many architectures (not run)
 : ${protos="netconf restconf"}
 : ${state=true} # Generate state data and netconf get state plot
+: ${sparse=false} # Edit-scoped single entry operations, netconf edits running directly
 
 # 0 prefix to protect against shell dynamic binding)
 to0=$to
@@ -80,6 +83,19 @@ module scaling{
 }
 EOF
 
+# Edit-scoped mode: direct commit of the edit paths, journal instead of datastore writes
+if $sparse; then
+    ncdb=running
+    SPARSECONFIG="<CLICON_XMLDB_RUNNING_DIRECT>true</CLICON_XMLDB_RUNNING_DIRECT>
+  <CLICON_XMLDB_RUNNING_DIRECT_SPARSE>true</CLICON_XMLDB_RUNNING_DIRECT_SPARSE>
+  <CLICON_VALIDATE_INCREMENTAL>true</CLICON_VALIDATE_INCREMENTAL>
+  <CLICON_XMLDB_JOURNAL>true</CLICON_XMLDB_JOURNAL>
+  <CLICON_RESTCONF_STARTUP_DONTUPDATE>true</CLICON_RESTCONF_STARTUP_DONTUPDATE>"
+else
+    ncdb=candidate
+    SPARSECONFIG=
+fi
+
 RESTCONFIG=$(restconf_config none false)
 cat <<EOF > $cfg
 <clixon-config xmlns="http://clicon.org/config">
@@ -94,6 +110,7 @@ cat <<EOF > $cfg
   <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
   <CLICON_XMLDB_PRETTY>false</CLICON_XMLDB_PRETTY>
   <CLICON_VALIDATE_STATE_XML>false</CLICON_VALIDATE_STATE_XML>
+  $SPARSECONFIG
   $RESTCONFIG
 </clixon-config>
 EOF
@@ -167,7 +184,7 @@ function runnetconf()
             else # reqs != 0
                 { time -p for (( i=0; i<$reqs; i++ )); do
                     rnd=$(( ( RANDOM % $nr ) ));
-                    rpc=$(chunked_framing "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><x xmlns=\"urn:example:clixon\"><y><a>$rnd</a><b>$rnd</b></y></x></config></edit-config></rpc>")
+                    rpc=$(chunked_framing "<rpc $DEFAULTNS><edit-config><target><$ncdb/></target><config><x xmlns=\"urn:example:clixon\"><y><a>$rnd</a><b>$rnd</b></y></x></config></edit-config></rpc>")
                     if [ $i == 0 ]; then
                         echo -n "$DEFAULTHELLO";
                     fi       
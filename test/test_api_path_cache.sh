@@ -0,0 +1,170 @@
+#!/usr/bin/env bash
+# Cache of yang nodes of api-paths, CLICON_API_PATH_CACHE_SIZE
+# The cache is keyed by the api-path without key values. Check with RESTCONF that
+# api-paths of the same structure but other key values, and erroneous keys, give the
+# same results with the cache, with a cache of one entry, and without the cache
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Skip if no restconf
+if [ -z "${WITH_RESTCONF}" ]; then
+    rm -rf $dir
+    if [ "$s" = $0 ]; then exit 0; else return 0; fi # skip
+fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/example.yang
+fyang2=$dir/example-augment.yang
+
+# Define default restconfig config: RESTCONFIG
+RESTCONFIG=$(restconf_config none false)
+if [ $? -ne 0 ]; then
+    err1 "Error when generating certs"
+fi
+
+cat <<EOF > $fyang
+module example{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container table{
+      list parameter{
+         key name;
+         leaf name{
+            type uint32;
+         }
+         list sub{
+            key "k1 k2";
+            leaf k1{
+               type string;
+            }
+            leaf k2{
+               type string;
+            }
+            leaf value{
+               type string;
+            }
+         }
+      }
+   }
+}
+EOF
+
+cat <<EOF > $fyang2
+module example-augment{
+   yang-version 1.1;
+   namespace "urn:example:augment";
+   prefix aug;
+   import example {
+      prefix ex;
+   }
+   augment "/ex:table/ex:parameter" {
+      leaf extra{
+         type string;
+      }
+   }
+}
+EOF
+
+# 1: CLICON_API_PATH_CACHE_SIZE
+function testrun() {
+    size=$1
+
+    cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_FEATURE>clixon-restconf:allow-auth-none</CLICON_FEATURE> <!-- Use auth-type=none -->
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_DIR>$dir</CLICON_YANG_MAIN_DIR>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>$dir/restconf.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_API_PATH_CACHE_SIZE>$size</CLICON_API_PATH_CACHE_SIZE>
+  $RESTCONFIG
+</clixon-config>
+EOF
+
+    new "test params: -f $cfg"
+    if [ $BE -ne 0 ]; then
+        new "kill old backend"
+        sudo clixon_backend -zf $cfg
+        if [ $? -ne 0 ]; then
+            err
+        fi
+        new "start backend -s init -f $cfg"
+        start_backend -s init -f $cfg
+    fi
+
+    new "wait backend"
+    wait_backend
+
+    if [ $RC -ne 0 ]; then
+        new "kill old restconf daemon"
+        stop_restconf_pre
+
+        new "start restconf daemon"
+        start_restconf -f $cfg
+    fi
+
+    new "wait restconf"
+    wait_restconf
+
+    new "size $size: restconf PUT config"
+    expectpart "$(curl $CURLOPTS -X PUT -H "Content-Type: application/yang-data+json" -d '{"example:table":{"parameter":[{"name":1,"sub":[{"k1":"a","k2":"b","value":"ab"}],"example-augment:extra":"x1"},{"name":2,"sub":[{"k1":"c","k2":"d","value":"cd"}],"example-augment:extra":"x2"}]}}' $RCPROTO://localhost/restconf/data/example:table)" 0 "HTTP/$HVER 201"
+
+    for i in 1 2; do
+        new "size $size: restconf GET parameter=$i"
+        expectpart "$(curl $CURLOPTS -X GET $RCPROTO://localhost/restconf/data/example:table/parameter=$i/example-augment:extra)" 0 "HTTP/$HVER 200" "{\"example-augment:extra\":\"x$i\"}"
+    done
+
+    new "size $size: restconf GET parameter=1/sub=a,b"
+    expectpart "$(curl $CURLOPTS -X GET $RCPROTO://localhost/restconf/data/example:table/parameter=1/sub=a,b/value)" 0 "HTTP/$HVER 200" '{"example:value":"ab"}'
+
+    new "size $size: restconf GET parameter=2/sub=c,d"
+    expectpart "$(curl $CURLOPTS -X GET $RCPROTO://localhost/restconf/data/example:table/parameter=2/sub=c,d/value)" 0 "HTTP/$HVER 200" '{"example:value":"cd"}'
+
+    new "size $size: restconf GET keys of other entry"
+    expectpart "$(curl $CURLOPTS -X GET $RCPROTO://localhost/restconf/data/example:table/parameter=2/sub=a,b/value)" 0 "HTTP/$HVER 404"
+
+    new "size $size: restconf GET wrong number of keys"
+    expectpart "$(curl $CURLOPTS -X GET $RCPROTO://localhost/restconf/data/example:table/parameter=1/sub=a)" 0 "HTTP/$HVER 400" "List key sub length mismatch"
+
+    new "size $size: restconf GET unknown element"
+    expectpart "$(curl $CURLOPTS -X GET $RCPROTO://localhost/restconf/data/example:table/parameter=1/nosuch)" 0 "HTTP/$HVER 400" "unknown-element"
+
+    new "size $size: restconf DELETE parameter=1/sub=a,b"
+    expectpart "$(curl $CURLOPTS -X DELETE $RCPROTO://localhost/restconf/data/example:table/parameter=1/sub=a,b)" 0 "HTTP/$HVER 204"
+
+    new "size $size: restconf GET deleted entry"
+    expectpart "$(curl $CURLOPTS -X GET $RCPROTO://localhost/restconf/data/example:table/parameter=1/sub=a,b)" 0 "HTTP/$HVER 404"
+
+    new "size $size: restconf GET remaining entry"
+    expectpart "$(curl $CURLOPTS -X GET $RCPROTO://localhost/restconf/data/example:table/parameter=2/sub=c,d)" 0 "HTTP/$HVER 200" '{"example:sub":\[{"k1":"c","k2":"d","value":"cd"}\]}'
+
+    if [ $RC -ne 0 ]; then
+        new "Kill restconf daemon"
+        stop_restconf
+    fi
+
+    if [ $BE -ne 0 ]; then
+        new "Kill backend"
+        # Check if premature kill
+        pid=$(pgrep -u root -f clixon_backend)
+        if [ -z "$pid" ]; then
+            err "backend already dead"
+        fi
+        stop_backend -f $cfg
+    fi
+}
+
+for size in 1024 1 0; do
+    testrun $size
+done
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,133 @@
+#!/usr/bin/env bash
+# Autocli cache tests, see CLICON_CLI_AUTOCLI_CACHE_DIR
+# Start cli twice, check that the cache file is written and used, and that a changed
+# yang file invalidates the cache
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+cdir=$dir/cache
+fyang=$dir/clixon-example.yang
+clidir=$dir/cli
+
+test -d $cdir || mkdir $cdir
+test -d $clidir || mkdir $clidir
+
+# Generate autocli for these modules
+AUTOCLI=$(autocli_config clixon-example kw-nokey false)
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_CLISPEC_DIR>$clidir</CLICON_CLISPEC_DIR>
+  <CLICON_CLI_DIR>/usr/local/lib/$APPNAME/cli</CLICON_CLI_DIR>
+  <CLICON_CLI_MODE>$APPNAME</CLICON_CLI_MODE>
+  <CLICON_CLI_AUTOCLI_CACHE_DIR>$cdir</CLICON_CLI_AUTOCLI_CACHE_DIR>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  ${AUTOCLI}
+</clixon-config>
+EOF
+
+# Arg 1: extra leaf
+function testyang()
+{
+    cat <<EOF > $fyang
+module clixon-example{
+    yang-version 1.1;
+    namespace "urn:example:clixon";
+    prefix ex;
+    container table{
+        list parameter{
+            key name;
+            leaf name{
+                type string;
+            }
+            leaf xleaf{
+                type string;
+            }
+            $1
+        }
+    }
+}
+EOF
+}
+
+cat <<EOF > $clidir/ex.cli
+CLICON_MODE="example";
+CLICON_PROMPT="%U@%H %W> ";
+CLICON_PLUGIN="example_cli";
+
+set @datamodel, cli_auto_set();
+show("Show a particular state of the system"){
+    configuration("Show configuration"), cli_show_auto_mode("candidate", "xml", false, false);
+}
+EOF
+
+testyang ""
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -z -f $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+for i in 1 2; do
+    new "cli expand leaf ($i)"
+    expectpart "$(echo "set table parameter a ?" | $clixon_cli -f $cfg 2>&1)" 0 "xleaf" --not-- "yleaf"
+
+    new "cli set leaf ($i)"
+    expectpart "$($clixon_cli -1 -f $cfg set table parameter a xleaf 42)" 0 "^$"
+
+    new "Check cache file ($i)"
+    f=$cdir/basemodel.clispec
+    if [ ! -f $f ]; then
+        err "cache file $f" "none"
+    fi
+    if [ "$(head -c 16 $f)" != "# clixon autocli" ]; then
+        err "# clixon autocli" "$(head -c 16 $f)"
+    fi
+done
+
+new "Change yang: add leaf yleaf"
+testyang "leaf yleaf{ type string; }"
+
+new "cli expand new leaf"
+expectpart "$(echo "set table parameter a ?" | $clixon_cli -f $cfg 2>&1)" 0 "xleaf" "yleaf"
+
+new "cli set new leaf yleaf"
+expectpart "$($clixon_cli -1 -f $cfg set table parameter a yleaf 17)" 0 "^$"
+
+new "cli show config"
+expectpart "$($clixon_cli -1 -f $cfg show config)" 0 "<table xmlns=\"urn:example:clixon\"><parameter><name>a</name><xleaf>42</xleaf><yleaf>17</yleaf></parameter></table>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -216,6 +216,9 @@ expectpart "$($clixon_cli -1 -f $cfg -l o show config $format pretty-print)" 0 "
 new "cli check show config $format non-auto"
 expectpart "$($clixon_cli -1 -f $cfg -l o show config $format config)" 0 "clixon-example:table {" "parameter x {" "array1 \[" "parameter y {"
 
+new "cli check show config $format paged"
+expectpart "$($clixon_cli -1 -f $cfg -l o -o CLICON_CLI_SHOW_PAGED=true show config $format config)" 0 "clixon-example:table {" "parameter x {" "array1 \[" "parameter y {" "clixon-example:table2"
+
 new "cli check show auto $format table"
 expectpart "$($clixon_cli -1 -f $cfg -l o show auto $format table)" 0 
 
@@ -0,0 +1,119 @@
+#!/usr/bin/env bash
+# Get replies sent to clients in chunks, CLICON_BACKEND_STREAM_CHUNK
+# Get a large config with and without chunks, also from read workers, and check
+# that the replies are equal
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/clixon-example.yang
+
+: ${perfnr:=2000}
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module clixon-example{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container table{
+      list parameter{
+         key name;
+         leaf name{
+            type uint32;
+         }
+         leaf value{
+            type string;
+         }
+      }
+   }
+}
+EOF
+
+new "generate $perfnr list entries"
+echo -n "<table xmlns=\"urn:example:clixon\">" > $dir/config.xml
+for (( i=0; i<$perfnr; i++ )); do
+    echo -n "<parameter><name>$i</name><value>value of entry $i</value></parameter>" >> $dir/config.xml
+done
+echo -n "</table>" >> $dir/config.xml
+
+# 1: CLICON_BACKEND_STREAM_CHUNK
+# 2: CLICON_BACKEND_READ_WORKERS
+function testrun() {
+    chunk=$1
+    workers=$2
+
+    new "test params: -f $cfg -o CLICON_BACKEND_STREAM_CHUNK=$chunk -o CLICON_BACKEND_READ_WORKERS=$workers"
+    if [ $BE -ne 0 ]; then
+        new "kill old backend"
+        sudo clixon_backend -zf $cfg
+        if [ $? -ne 0 ]; then
+            err
+        fi
+        new "start backend -s init -f $cfg -o CLICON_BACKEND_STREAM_CHUNK=$chunk -o CLICON_BACKEND_READ_WORKERS=$workers"
+        start_backend -s init -f $cfg -o CLICON_BACKEND_STREAM_CHUNK=$chunk -o CLICON_BACKEND_READ_WORKERS=$workers
+    fi
+
+    new "wait backend"
+    wait_backend
+
+    new "edit large config"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config>$(cat $dir/config.xml)</config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    new "commit"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    new "get-config large config"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data>$(cat $dir/config.xml)</data></rpc-reply>"
+
+    new "get-config large config to file"
+    echo "$HELLONO11<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>]]>]]>" | $clixon_netconf -qf $cfg > $dir/get-$chunk-$workers.out
+
+    new "get with filter"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get><filter type=\"xpath\" select=\"/ex:table/ex:parameter[ex:name='17']\" xmlns:ex=\"urn:example:clixon\"/></get></rpc>" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>17</name><value>value of entry 17</value></parameter></table></data></rpc-reply>"
+
+    new "get-config error reply"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><notexist/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><rpc-error>"
+
+    if [ $BE -ne 0 ]; then
+        new "Kill backend"
+        # Check if premature kill
+        pid=$(pgrep -u root -f clixon_backend)
+        if [ -z "$pid" ]; then
+            err "backend already dead"
+        fi
+        stop_backend -f $cfg
+    fi
+}
+
+testrun 0 0
+testrun 1024 0
+testrun 1024 2
+
+new "Check chunked reply is equal to whole reply"
+if ! cmp -s $dir/get-0-0.out $dir/get-1024-0.out; then
+    err "$(head -c 200 $dir/get-0-0.out)" "$(head -c 200 $dir/get-1024-0.out)"
+fi
+
+new "Check chunked reply from read worker is equal to whole reply"
+if ! cmp -s $dir/get-0-0.out $dir/get-1024-2.out; then
+    err "$(head -c 200 $dir/get-0-0.out)" "$(head -c 200 $dir/get-1024-2.out)"
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
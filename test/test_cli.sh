@@ -249,6 +249,10 @@ expectpart "$($clixon_cli -1 -f $cfg -l o load $dir/foo cli)" 0 "^$"
 new "cli check load"
 expectpart "$($clixon_cli -1 -f $cfg -l o show conf cli)" 0 "interfaces interface eth/0/0 ipv4"
 
+new "cli load with error reports line"
+(head -1 $dir/foo; echo "notacommand") > $dir/bar
+expectpart "$($clixon_cli -1 -f $cfg -l o load $dir/bar cli 2>&1)" 255 "$dir/bar: line 2: notacommand"
+
 new "cli debug set"
 expectpart "$($clixon_cli -1 -f $cfg -l o debug cli 1)" 0 "^$"
 
@@ -267,6 +271,10 @@ expectpart "$($clixon_cli -1 -f $cfg set table parameter foobar)" 0 "^$"
 new "cli bug with choice+dbexpand: part2, make same choice"
 expectpart "$($clixon_cli -1 -f $cfg choicebug foobar)" 0 "^$"
 
+# Expanded values are cached in the cli session until candidate changes
+new "cli dbexpand after change of candidate in other session"
+expectpart "$((echo "choicebug ?"; sleep 1; $clixon_cli -1 -f $cfg set table parameter fum; echo "choicebug ?") | $clixon_cli -f $cfg 2>&1)" 0 "foobar" "fum"
+
 new "cli discard"
 expectpart "$($clixon_cli -1 -f $cfg discard)" 0 "^$"
 
@@ -0,0 +1,162 @@
+#!/usr/bin/env bash
+# Batch of edits of a loaded CLI file, CLICON_CLI_BATCH_SIZE
+# Load files of CLI commands and check the number of edit-config rpcs handled by the
+# backend using the rpc latency counters, and that the result is the same as running
+# the commands one by one
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/clixon-example.yang
+fclispec=$dir/clispec.cli
+fload=$dir/load.cli
+
+: ${perfnr:=10}
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_CLI_MODE>$APPNAME</CLICON_CLI_MODE>
+  <CLICON_CLI_DIR>/usr/local/lib/$APPNAME/cli</CLICON_CLI_DIR>
+  <CLICON_CLISPEC_DIR>$dir</CLICON_CLISPEC_DIR>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_LATENCY_STATS>true</CLICON_LATENCY_STATS>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module clixon-example{
+    yang-version 1.1;
+    namespace "urn:example:clixon";
+    prefix ex;
+    container table{
+        list parameter{
+            key name;
+            leaf name{
+                type uint32;
+            }
+            leaf value{
+                type string;
+            }
+        }
+    }
+}
+EOF
+
+cat <<EOF > $fclispec
+CLICON_MODE="example";
+CLICON_PROMPT="%U@%H %w> ";
+CLICON_PLUGIN="example_cli";
+
+# Autocli syntax tree operations
+set @datamodel, cli_auto_set();
+delete("Delete a configuration item") @datamodel, cli_auto_del();
+commit("Commit the changes"), cli_commit();
+discard("Discard edits (rollback 0)"), discard_changes();
+show("Show a particular state of the system"){
+    configuration("Show configuration"), cli_show_auto_mode("candidate", "xml", true, false);
+}
+load("Load configuration from CLI file") <filename:string>("Filename (local filename)"), load_config_file("filename", "merge", "cli");
+EOF
+
+# Print number of edit-config rpcs handled by the backend
+function editconfigs() {
+    echo "$HELLONO11<rpc $DEFAULTNS><stats xmlns=\"http://clicon.org/lib\"/></rpc>]]>]]>" | $clixon_netconf -qf $cfg | sed -n 's/.*<histogram><type>rpc<\/type><name>edit-config<\/name><count>\([0-9]*\)<\/count>.*/\1/p'
+}
+
+# Load file and check number of edit-config rpcs
+# 1: CLICON_CLI_BATCH_SIZE
+# 2: expected number of edit-config
+function load() {
+    n0=$(editconfigs)
+    [ -z "$n0" ] && n0=0
+
+    new "load $fload with batch size $1"
+    expectpart "$($clixon_cli -1 -f $cfg -o CLICON_CLI_BATCH_SIZE=$1 load $fload 2>&1)" 0 "^$"
+
+    new "Check $2 edit-config with batch size $1"
+    n1=$(editconfigs)
+    if [ $((n1 - n0)) -ne $2 ]; then
+        err "$2" "$((n1 - n0))"
+    fi
+}
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "generate $perfnr set commands"
+rm -f $fload
+for (( i=0; i<$perfnr; i++ )); do
+    echo "set table parameter $i value v$i" >> $fload
+done
+
+# No limit, all edits in one edit-config
+load 0 1
+
+new "Check all entries are loaded"
+expectpart "$($clixon_cli -1 -f $cfg show configuration)" 0 "<name>0</name>" "<value>v0</value>" "<name>$((perfnr - 1))</name>" "<value>v$((perfnr - 1))</value>"
+
+new "discard"
+expectpart "$($clixon_cli -1 -f $cfg discard)" 0 "^$"
+
+# Edits are sent when the batch is full
+load 3 $(((perfnr + 2) / 3))
+
+new "Check all entries are loaded"
+expectpart "$($clixon_cli -1 -f $cfg show configuration)" 0 "<name>0</name>" "<value>v0</value>" "<name>$((perfnr - 1))</name>" "<value>v$((perfnr - 1))</value>"
+
+new "discard"
+expectpart "$($clixon_cli -1 -f $cfg discard)" 0 "^$"
+
+new "generate file with commit and overlapping edits"
+cat <<EOF > $fload
+set table parameter 1 value a
+set table parameter 2 value b
+commit
+set table parameter 3 value c
+set table parameter 4 value d
+delete table parameter 3
+EOF
+
+# Commit sends the batch before it runs, and the delete overlaps the set of entry 3
+load 0 3
+
+new "Check result is same as commands one by one"
+expectpart "$($clixon_cli -1 -f $cfg show configuration)" 0 "<name>1</name>" "<value>a</value>" "<name>4</name>" "<value>d</value>" --not-- "<name>3</name>"
+
+new "Check commit is done before later edits"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>1</name><value>a</value></parameter><parameter><name>2</name><value>b</value></parameter></table></data></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
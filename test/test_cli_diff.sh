@@ -172,6 +172,9 @@ expectpart "$($clixon_cli -1 -f $cfg show compare xml)" 0 "<table xmlns=\"urn:ex
 new "check compare text"
 expectpart "$($clixon_cli -1 -f $cfg show compare text)" 0 "^\ *table {" "^\-\ *parameter a {" "^+\ *parameter c {" "^\-\ *value \"98\";" "^+\ *value \"99\";"
 
+new "netconf datastore-diff of changed subtrees only"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><datastore-diff xmlns=\"http://clicon.org/lib\"><source>running</source><target>candidate</target></datastore-diff></rpc>" "" "<rpc-reply $DEFAULTNS><source xmlns=\"http://clicon.org/lib\"><top xmlns=\"urn:example:clixon\"><section><name>x</name><table><parameter><name>a</name><value>17</value></parameter><parameter><name>d</name><value>98</value></parameter></table></section></top></source><target xmlns=\"http://clicon.org/lib\"><top xmlns=\"urn:example:clixon\"><section><name>x</name><table><parameter><name>c</name><value>72</value></parameter><parameter><name>d</name><value>99</value></parameter></table></section></top></target></rpc-reply>"
+
 new "delete section x"
 expectpart "$($clixon_cli -1 -f $cfg delete top section x)" 0 "^$"
 
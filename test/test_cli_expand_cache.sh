@@ -0,0 +1,142 @@
+#!/usr/bin/env bash
+# Cache of expand_dbvar completion values, CLICON_CLI_EXPAND_CACHE_SIZE
+# Complete list keys several times in one CLI session and check that the values are
+# fetched from the backend once with the cache and every time without it, using the
+# backend rpc latency counters. Check also that a change of the datastore is completed
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/clixon-example.yang
+fclispec=$dir/clispec.cli
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_CLI_MODE>$APPNAME</CLICON_CLI_MODE>
+  <CLICON_CLI_DIR>/usr/local/lib/$APPNAME/cli</CLICON_CLI_DIR>
+  <CLICON_CLISPEC_DIR>$dir</CLICON_CLISPEC_DIR>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_LATENCY_STATS>true</CLICON_LATENCY_STATS>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module clixon-example{
+    yang-version 1.1;
+    namespace "urn:example:clixon";
+    prefix ex;
+    container table{
+        list parameter{
+            key name;
+            leaf name{
+                type string;
+            }
+            leaf value{
+                type string;
+            }
+        }
+    }
+}
+EOF
+
+cat <<EOF > $fclispec
+CLICON_MODE="example";
+CLICON_PROMPT="%U@%H %w> ";
+CLICON_PLUGIN="example_cli";
+
+# Autocli syntax tree operations
+set @datamodel, cli_auto_set();
+delete("Delete a configuration item") @datamodel, cli_auto_del();
+commit("Commit the changes"), cli_commit();
+quit("Quit"), cli_quit();
+EOF
+
+# Print number of get-config rpcs handled by the backend
+function getconfigs() {
+    echo "$HELLONO11<rpc $DEFAULTNS><stats xmlns=\"http://clicon.org/lib\"/></rpc>]]>]]>" | $clixon_netconf -qf $cfg | sed -n 's/.*<histogram><type>rpc<\/type><name>get-config<\/name><count>\([0-9]*\)<\/count>.*/\1/p'
+}
+
+# Complete parameter names four times in one CLI session
+# 1: CLICON_CLI_EXPAND_CACHE_SIZE
+function complete() {
+    printf "set table parameter ?\nset table parameter ?\nset table parameter ?\nset table parameter ?\n" | $clixon_cli -f $cfg -o CLICON_CLI_EXPAND_CACHE_SIZE=$1 2>&1
+}
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "cli set parameter alpha"
+expectpart "$($clixon_cli -1 -f $cfg set table parameter alpha value 1)" 0 "^$"
+
+new "cli set parameter beta"
+expectpart "$($clixon_cli -1 -f $cfg set table parameter beta value 2)" 0 "^$"
+
+for size in 16 0; do
+    n0=$(getconfigs)
+    [ -z "$n0" ] && n0=0
+
+    new "cache size $size: complete parameter names"
+    expectpart "$(complete $size)" 0 alpha beta
+
+    n1=$(getconfigs)
+    eval "delta$size=$((n1 - n0))"
+done
+
+new "Check completions with cache fetch values less often"
+if [ $delta16 -ge $delta0 ]; then
+    err "< $delta0" "$delta16"
+fi
+
+n0=$(getconfigs)
+
+new "Complete, edit and complete again in same session"
+ret=$(printf "set table parameter ?\nset table parameter gamma value 3\nset table parameter ?\n" | $clixon_cli -f $cfg 2>&1)
+expectpart "$ret" 0 alpha beta
+
+new "Check completion after edit lists new value"
+# The echo of the edit command also contains gamma
+nr=$(echo "$ret" | grep -v "gamma value 3" | grep -c gamma)
+if [ $nr -lt 1 ]; then
+    err ">= 1" "$nr"
+fi
+
+new "Check edit invalidates cached values"
+n1=$(getconfigs)
+if [ $((n1 - n0)) -lt 2 ]; then
+    err ">= 2" "$((n1 - n0))"
+fi
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,115 @@
+#!/usr/bin/env bash
+# Group commit, see CLICON_COMMIT_GROUP_WINDOW
+# Two sessions edit and commit concurrently. Both get a reply, and a failing
+# group is rejected for all sessions
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/test.yang
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_COMMIT_GROUP_WINDOW>500</CLICON_COMMIT_GROUP_WINDOW>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module $APPNAME{
+  yang-version 1.1;
+  namespace "urn:example:clixon";
+  prefix ex;
+  container a {
+     leaf x { type uint32; }
+     must "not(x > 10)" { error-message "a too large"; }
+  }
+  container b {
+     leaf x { type uint32; }
+  }
+}
+EOF
+
+# Edit and commit in a session of its own, in background
+# Args:
+# 1: edit-config xml
+# 2: output file
+function editcommit()
+{
+    config=$1
+    out=$2
+
+    $clixon_netconf -qf $cfg > $out <<EOF &
+${DEFAULTHELLO}$(chunked_framing "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config>$config</config></edit-config></rpc>")$(chunked_framing "<rpc $DEFAULTNS><commit/></rpc>")
+EOF
+}
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "Two concurrent commits"
+editcommit "<a xmlns=\"urn:example:clixon\"><x>1</x></a>" $dir/out1
+editcommit "<b xmlns=\"urn:example:clixon\"><x>1</x></b>" $dir/out2
+wait
+
+for f in $dir/out1 $dir/out2; do
+    new "Both edit and commit ok in $f"
+    n=$(grep -o "<ok/>" $f | wc -l)
+    if [ $n -ne 2 ]; then
+        err "2 ok" "$(cat $f)"
+    fi
+done
+
+new "Running contains both commits"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><a xmlns=\"urn:example:clixon\"><x>1</x></a><b xmlns=\"urn:example:clixon\"><x>1</x></b></data></rpc-reply>"
+
+new "Two concurrent commits, one invalid"
+editcommit "<a xmlns=\"urn:example:clixon\"><x>99</x></a>" $dir/out1
+editcommit "<b xmlns=\"urn:example:clixon\"><x>2</x></b>" $dir/out2
+wait
+
+for f in $dir/out1 $dir/out2; do
+    new "Commit fails in $f"
+    match=$(grep "a too large" $f)
+    if [ -z "$match" ]; then
+        err "a too large" "$(cat $f)"
+    fi
+done
+
+new "Running is unchanged"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><a xmlns=\"urn:example:clixon\"><x>1</x></a><b xmlns=\"urn:example:clixon\"><x>1</x></b></data></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
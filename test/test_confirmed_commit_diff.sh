@@ -0,0 +1,151 @@
+#!/usr/bin/env bash
+# Confirmed commit with rollback stored as reverse diffs, CLICON_BACKEND_ROLLBACK_DIFF
+# Check that rollback restores entries and positions of ordered-by user list and leaf-list,
+# and that an edit of running in the confirm window is also rolled back
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/clixon-example.yang
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_FEATURE>ietf-netconf:confirmed-commit</CLICON_FEATURE>
+  <CLICON_FEATURE>ietf-netconf:writable-running</CLICON_FEATURE>
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_BACKEND_ROLLBACK_DIFF>true</CLICON_BACKEND_ROLLBACK_DIFF>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module clixon-example{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container table{
+      list parameter{
+         key name;
+         ordered-by user;
+         leaf name{
+            type string;
+         }
+         leaf value{
+            type string;
+         }
+      }
+      leaf-list order{
+         type string;
+         ordered-by user;
+      }
+      leaf x{
+         type string;
+      }
+   }
+}
+EOF
+
+# Original config
+CONFA="<table xmlns=\"urn:example:clixon\"><parameter><name>a</name><value>1</value></parameter><parameter><name>b</name><value>2</value></parameter><parameter><name>c</name><value>3</value></parameter><order>x</order><order>y</order><order>z</order></table>"
+# b deleted, c moved first, a changed, d added, leaf-list reordered with z first and w added
+CONFB="<table xmlns=\"urn:example:clixon\"><parameter><name>c</name><value>3</value></parameter><parameter><name>a</name><value>10</value></parameter><parameter><name>d</name><value>4</value></parameter><order>z</order><order>x</order><order>w</order></table>"
+
+function rpc() {
+  expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS>$1</rpc>" "" "<rpc-reply $DEFAULTNS>$2</rpc-reply>"
+}
+
+# Replace candidate with CONFB and make a persistent confirmed-commit
+# 1: persist
+# 2: timeout
+function confirmed_b() {
+  new "edit candidate"
+  rpc "<edit-config><target><candidate/></target><default-operation>replace</default-operation><config>$CONFB</config></edit-config>" "<ok/>"
+
+  new "confirmed-commit persist $1"
+  rpc "<commit><confirmed/><persist>$1</persist><confirm-timeout>$2</confirm-timeout></commit>" "<ok/>"
+
+  new "running is changed"
+  rpc "<get-config><source><running/></source></get-config>" "<data>$CONFB</data>"
+}
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "edit candidate"
+rpc "<edit-config><target><candidate/></target><config>$CONFA</config></edit-config>" "<ok/>"
+
+new "commit"
+rpc "<commit/>" "<ok/>"
+
+confirmed_b p1 60
+
+new "Check reverse diff is stored"
+[ -f $dir/rollback.diff ] || err "$dir/rollback.diff" "none"
+
+new "Check running is not copied"
+[ -s $dir/rollback_db ] && err "no rollback_db" "$dir/rollback_db"
+
+new "cancel-commit"
+rpc "<cancel-commit><persist-id>p1</persist-id></cancel-commit>" "<ok/>"
+
+new "running is restored with positions"
+rpc "<get-config><source><running/></source></get-config>" "<data>$CONFA</data>"
+
+new "Check reverse diff is removed"
+[ -f $dir/rollback.diff ] && err "no rollback.diff" "$dir/rollback.diff"
+
+confirmed_b p2 60
+
+new "edit running in confirm window"
+rpc "<edit-config><target><running/></target><config><table xmlns=\"urn:example:clixon\"><x>1</x><order>v</order></table></config></edit-config>" "<ok/>"
+
+new "Check rollback db is created from reverse diff"
+[ -s $dir/rollback_db ] || err "$dir/rollback_db" "none"
+[ -f $dir/rollback.diff ] && err "no rollback.diff" "$dir/rollback.diff"
+
+new "cancel-commit"
+rpc "<cancel-commit><persist-id>p2</persist-id></cancel-commit>" "<ok/>"
+
+new "running is restored, also edit of running"
+rpc "<get-config><source><running/></source></get-config>" "<data>$CONFA</data>"
+
+confirmed_b p3 2
+
+new "Wait for rollback timeout"
+sleep 3
+
+new "running is restored after timeout"
+rpc "<get-config><source><running/></source></get-config>" "<data>$CONFA</data>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
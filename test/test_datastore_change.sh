@@ -0,0 +1,94 @@
+#!/usr/bin/env bash
+# Datastore generations and change feed, see CLICON_STREAM_DATASTORE_CHANGE
+# Subscribe to the DATASTORE-CHANGE stream, edit and commit, and check notifications
+# and generations of datastore-stamp
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/test.yang
+fout=$dir/notify.out
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_STREAM_DATASTORE_CHANGE>true</CLICON_STREAM_DATASTORE_CHANGE>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module $APPNAME{
+  yang-version 1.1;
+  namespace "urn:example:clixon";
+  prefix ex;
+  container a {
+     leaf x { type uint32; }
+  }
+  container b {
+     leaf y { type uint32; }
+  }
+}
+EOF
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "asynchronous subscription of DATASTORE-CHANGE"
+(echo "$HELLONO11<rpc $DEFAULTNS><create-subscription xmlns=\"urn:ietf:params:xml:ns:netmod:notification\"><stream>DATASTORE-CHANGE</stream></create-subscription></rpc>]]>]]>"; sleep 3) | $clixon_netconf -qf $cfg > $fout &
+sleep 1
+
+new "edit-config"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><a xmlns=\"urn:example:clixon\"><x>1</x></a></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "commit"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+wait
+
+new "candidate edit notification"
+if ! grep -q "<datastore-change xmlns=\"http://clicon.org/lib\"><datastore>candidate</datastore><generation>[0-9]*</generation><node>example:a</node></datastore-change>" $fout; then
+    err "candidate datastore-change" "$(cat $fout)"
+fi
+
+new "running commit notification"
+if ! grep -q "<datastore-change xmlns=\"http://clicon.org/lib\"><datastore>running</datastore><generation>[0-9]*</generation><node>example:a</node></datastore-change>" $fout; then
+    err "running datastore-change" "$(cat $fout)"
+fi
+
+new "datastore-stamp has generation"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><datastore-stamp xmlns=\"http://clicon.org/lib\"><node>example:a</node></datastore-stamp></rpc>" "" "<rpc-reply $DEFAULTNS><etag xmlns=\"http://clicon.org/lib\">[0-9a-f-]*</etag><generation xmlns=\"http://clicon.org/lib\">[1-9][0-9]*</generation>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
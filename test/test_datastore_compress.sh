@@ -0,0 +1,128 @@
+#!/usr/bin/env bash
+# Compressed datastore files, see CLICON_XMLDB_COMPRESS
+# Start from an uncompressed running file, commit, check that the file is written compressed
+# and that it is read after restart, in xml and binary format
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+if [ "${WITH_LIBZSTD}" != yes ]; then
+    echo "Skipping test, zstd support not enabled."
+    rm -rf $dir
+    if [ "$s" = $0 ]; then exit 0; else return 0; fi
+fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/test.yang
+
+cat <<EOF > $fyang
+module $APPNAME{
+  yang-version 1.1;
+  namespace "urn:example:clixon";
+  prefix ex;
+  container a {
+     leaf-list x { type uint32; }
+  }
+}
+EOF
+
+# 1: datastore format
+function testrun(){
+    format=$1
+
+    cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_FORMAT>$format</CLICON_XMLDB_FORMAT>
+  <CLICON_XMLDB_COMPRESS>zstd</CLICON_XMLDB_COMPRESS>
+  <CLICON_XMLDB_COMPRESS_LEVEL>1</CLICON_XMLDB_COMPRESS_LEVEL>
+</clixon-config>
+EOF
+
+    if [ $BE -ne 0 ]; then
+        new "kill old backend"
+        sudo clixon_backend -zf $cfg
+        if [ $? -ne 0 ]; then
+            err
+        fi
+        new "start backend -s init -f $cfg"
+        start_backend -s init -f $cfg
+    fi
+
+    new "wait backend"
+    wait_backend
+
+    new "edit-config"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><a xmlns=\"urn:example:clixon\"><x>1</x><x>2</x></a></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    new "commit"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    if [ $BE -ne 0 ]; then
+        new "Kill backend"
+        stop_backend -f $cfg
+
+        new "running file is zstd compressed"
+        magic=$(sudo head -c 4 $dir/running_db | od -An -tx1 | tr -d ' \n')
+        if [ "$magic" != "28b52ffd" ]; then
+            err "28b52ffd" "$magic"
+        fi
+
+        new "start backend -s running -f $cfg"
+        start_backend -s running -f $cfg
+    fi
+
+    new "wait backend"
+    wait_backend
+
+    new "get-config after restart"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><a xmlns=\"urn:example:clixon\"><x>1</x><x>2</x></a></data></rpc-reply>"
+
+    if [ $BE -ne 0 ]; then
+        new "Kill backend"
+        # Check if premature kill
+        pid=$(pgrep -u root -f clixon_backend)
+        if [ -z "$pid" ]; then
+            err "backend already dead"
+        fi
+        stop_backend -f $cfg
+    fi
+}
+
+for format in xml binary; do
+    new "compressed datastore format $format"
+    testrun $format
+done
+
+new "uncompressed running file is read"
+cat <<EOF > $dir/running_db
+<config><a xmlns="urn:example:clixon"><x>3</x></a></config>
+EOF
+sed -i 's/<CLICON_XMLDB_FORMAT>binary/<CLICON_XMLDB_FORMAT>xml/' $cfg
+if [ $BE -ne 0 ]; then
+    new "start backend -s running -f $cfg"
+    start_backend -s running -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "get-config uncompressed"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><a xmlns=\"urn:example:clixon\"><x>3</x></a></data></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
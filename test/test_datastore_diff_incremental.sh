@@ -0,0 +1,127 @@
+#!/usr/bin/env bash
+# Incremental commit diff, CLICON_XMLDB_DIFF_INCREMENTAL
+# Make the same commit with adds, deletes, changes and a reorder of an ordered-by user list
+# with and without incremental diff, and check that the transaction vectors logged by the example
+# plugin are equal
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/trans.yang
+flog=$dir/backend.log
+
+cat <<EOF > $fyang
+module trans{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container x {
+      list y {
+         key "a";
+         leaf a {
+            type int32;
+         }
+         leaf b {
+            type int32;
+         }
+      }
+      list u {
+         key "k";
+         ordered-by user;
+         leaf k {
+            type string;
+         }
+      }
+      leaf z {
+         type string;
+      }
+   }
+}
+EOF
+
+function rpc() {
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS>$1</rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+}
+
+for inc in false true; do
+    cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_SOCK>$dir/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_DIFF_INCREMENTAL>$inc</CLICON_XMLDB_DIFF_INCREMENTAL>
+</clixon-config>
+EOF
+    sudo rm -f $flog
+    touch $flog
+
+    new "test params: -f $cfg -l f$flog -- -t"
+    if [ $BE -ne 0 ]; then
+        new "kill old backend"
+        sudo clixon_backend -zf $cfg
+        if [ $? -ne 0 ]; then
+            err
+        fi
+        new "start backend -s init -f $cfg -l f$flog -- -t"
+        start_backend -s init -f $cfg -l f$flog -- -t # -t means transaction logging
+    fi
+
+    new "wait backend"
+    wait_backend
+
+    new "incremental $inc: base config"
+    rpc "<edit-config><target><candidate/></target><config><x xmlns='urn:example:clixon'><y><a>1</a><b>1</b></y><y><a>2</a><b>2</b></y><y><a>3</a><b>3</b></y><u><k>a</k></u><u><k>b</k></u><u><k>c</k></u><z>0</z></x></config></edit-config>"
+
+    new "incremental $inc: commit base"
+    rpc "<commit/>"
+
+    new "incremental $inc: delete y 1"
+    rpc "<edit-config><target><candidate/></target><config><x xmlns='urn:example:clixon' xmlns:nc='urn:ietf:params:xml:ns:netconf:base:1.0'><y nc:operation='delete'><a>1</a></y></x></config></edit-config>"
+
+    new "incremental $inc: change y 2 and z, add y 4"
+    rpc "<edit-config><target><candidate/></target><config><x xmlns='urn:example:clixon'><y><a>2</a><b>20</b></y><y><a>4</a><b>4</b></y><z>1</z></x></config></edit-config>"
+
+    new "incremental $inc: move u c first"
+    rpc "<edit-config><target><candidate/></target><config><x xmlns='urn:example:clixon' xmlns:nc='urn:ietf:params:xml:ns:netconf:base:1.0' xmlns:yang='urn:ietf:params:xml:ns:yang:1'><u nc:operation='merge' yang:insert='first'><k>c</k></u></x></config></edit-config>"
+
+    new "incremental $inc: commit"
+    rpc "<commit/>"
+
+    if [ $BE -ne 0 ]; then
+        new "Kill backend"
+        # Check if premature kill
+        pid=$(pgrep -u root -f clixon_backend)
+        if [ -z "$pid" ]; then
+            err "backend already dead"
+        fi
+        stop_backend -f $cfg
+    fi
+
+    # Vectors of the last commit, without transaction id
+    id=$(grep "transaction_log [0-9]* main_commit " $flog | tail -1 | sed 's/.*transaction_log \([0-9]*\) .*/\1/')
+    grep "transaction_log $id main_commit " $flog | sed 's/.*transaction_log [0-9]* //' > $dir/diff-$inc
+done
+
+new "Check commit has add, del and change vectors"
+for v in add del change; do
+    if ! grep -q "main_commit $v: " $dir/diff-false; then
+        err "$v" "$(cat $dir/diff-false)"
+    fi
+done
+
+new "Check incremental diff is equal to full diff"
+if ! cmp -s $dir/diff-false $dir/diff-true; then
+    err "$(cat $dir/diff-false)" "$(cat $dir/diff-true)"
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
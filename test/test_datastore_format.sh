@@ -168,6 +168,15 @@ for format in cli text xml json; do
 
 done
 
+new "cli delete all"
+expectpart "$($clixon_cli -1 -f $cfg -l o delete all)" 0 "^$"
+
+new "cli load text with fast text syntax parser"
+expectpart "$($clixon_cli -1 -f $cfg -o CLICON_TEXT_SYNTAX_PARSER=fast -l o load $formatdir/config.text text)" 0 "^$"
+
+new "cli check compare text fast parser"
+expectpart "$($clixon_cli -1 -f $cfg -l o show compare xml)" 0 "^$" --not-- "i"
+
 if [ $BE -ne 0 ]; then
     new "Kill backend"
     # Check if premature kill
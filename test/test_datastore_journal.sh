@@ -0,0 +1,181 @@
+#!/usr/bin/env bash
+# Datastore journal tests
+# Edits are appended to journal, compacted on shutdown, and replayed on startup
+# Journal is compacted after CLICON_XMLDB_JOURNAL_COMPACT entries, and synced with CLICON_XMLDB_JOURNAL_SYNC
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+# include err() and new() functions and creates $dir
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/clixon-example.yang
+fclispec=$dir/clispec.cli
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>$IETFRFC</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_CLI_MODE>$APPNAME</CLICON_CLI_MODE>
+  <CLICON_CLI_DIR>/usr/local/lib/$APPNAME/cli</CLICON_CLI_DIR>
+  <CLICON_CLISPEC_DIR>$dir</CLICON_CLISPEC_DIR>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_JOURNAL>true</CLICON_XMLDB_JOURNAL>
+  <CLICON_XMLDB_JOURNAL_COMPACT>3</CLICON_XMLDB_JOURNAL_COMPACT>
+  <CLICON_XMLDB_JOURNAL_SYNC>true</CLICON_XMLDB_JOURNAL_SYNC>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module clixon-example{
+    yang-version 1.1;
+    namespace "urn:example:clixon";
+    prefix ex;
+    container table{
+        list parameter{
+            key name;
+            leaf name{
+                type string;
+            }
+            leaf value{
+                type string;
+            }
+            choice c{
+                leaf x{
+                    type string;
+                }
+                leaf y{
+                    type string;
+                }
+            }
+        }
+    }
+}
+EOF
+
+cat <<EOF > $fclispec
+CLICON_MODE="example";
+CLICON_PROMPT="%U@%H %w> ";
+CLICON_PLUGIN="example_cli";
+
+# Autocli syntax tree operations
+set @datamodel, cli_auto_set();
+delete("Delete a configuration item") @datamodel, cli_auto_del();
+commit("Commit the changes"), cli_commit();
+quit("Quit"), cli_quit();
+show("Show a particular state of the system"){
+    configuration("Show configuration"), cli_show_auto_mode("running", "xml", false, false);
+}
+EOF
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -z -f $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "cli configure parameter b"
+expectpart "$($clixon_cli -1 -f $cfg set table parameter b value 17)" 0 "^$"
+
+new "cli configure parameter a"
+expectpart "$($clixon_cli -1 -f $cfg set table parameter a y 42)" 0 "^$"
+
+new "Check candidate journal has two entries"
+sudo chmod 666 $dir/candidate_db.journal
+ret=$(grep -c "<edit " $dir/candidate_db.journal)
+if [ "$ret" != 2 ]; then
+    err "2" "$ret"
+fi
+
+new "Check candidate_db is not rewritten"
+if grep -q "<name>b</name>" $dir/candidate_db; then
+    err "no b" "$(cat $dir/candidate_db)"
+fi
+
+new "cli configure parameter c"
+expectpart "$($clixon_cli -1 -f $cfg set table parameter c value 3)" 0 "^$"
+
+new "Check candidate journal has three entries"
+ret=$(grep -c "<edit " $dir/candidate_db.journal)
+if [ "$ret" != 3 ]; then
+    err "3" "$ret"
+fi
+
+new "cli configure parameter d"
+expectpart "$($clixon_cli -1 -f $cfg set table parameter d value 4)" 0 "^$"
+
+new "Check journal is compacted after CLICON_XMLDB_JOURNAL_COMPACT entries"
+if [ -f $dir/candidate_db.journal ]; then
+    err "no journal" "$(cat $dir/candidate_db.journal)"
+fi
+if ! grep -q "<name>d</name>" $dir/candidate_db; then
+    err "d" "$(cat $dir/candidate_db)"
+fi
+
+new "cli configure parameter e is journaled again"
+expectpart "$($clixon_cli -1 -f $cfg set table parameter e value 5)" 0 "^$"
+sudo chmod 666 $dir/candidate_db.journal
+ret=$(grep -c "<edit " $dir/candidate_db.journal)
+if [ "$ret" != 1 ]; then
+    err "1" "$ret"
+fi
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    stop_backend -f $cfg
+
+    new "Check journal is compacted on shutdown"
+    if [ -f $dir/candidate_db.journal ]; then
+        err "no journal" "$(cat $dir/candidate_db.journal)"
+    fi
+    if ! grep -q "<name>b</name>" $dir/candidate_db; then
+        err "b" "$(cat $dir/candidate_db)"
+    fi
+
+    new "Write running journal entry"
+    sudo rm -f $dir/running_db $dir/running_db.journal
+    echo "<config/>" > $dir/running_db
+    entry='<edit xmlns:nc="urn:ietf:params:xml:ns:netconf:base:1.0" operation="merge"><config><table xmlns="urn:example:clixon"><parameter><name>c</name><value>99</value></parameter></table></config></edit>'
+    printf "%d\n%s" ${#entry} "$entry" > $dir/running_db.journal
+    # Truncated last entry is ignored
+    printf "300\n<edit" >> $dir/running_db.journal
+
+    new "start backend -s running -f $cfg"
+    start_backend -s running -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "cli show config replayed from journal"
+expectpart "$($clixon_cli -1 -f $cfg show config)" 0 "^<table xmlns=\"urn:example:clixon\"><parameter><name>c</name><value>99</value></parameter></table>$"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
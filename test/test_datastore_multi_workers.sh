@@ -0,0 +1,171 @@
+#!/usr/bin/env bash
+# Datastore split with parallel workers, CLICON_XMLDB_MULTI_WORKERS
+# Several mount-points are split into sub-files, which are written by workers on commit
+# and prefetched by workers when running is read on startup
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/clixon-example.yang
+fyang1=$dir/clixon-mount1.yang
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>${dir}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_YANG_LIBRARY>true</CLICON_YANG_LIBRARY>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_MULTI>true</CLICON_XMLDB_MULTI>
+  <CLICON_XMLDB_MULTI_WORKERS>4</CLICON_XMLDB_MULTI_WORKERS>
+  <CLICON_YANG_SCHEMA_MOUNT>true</CLICON_YANG_SCHEMA_MOUNT>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module clixon-example{
+  yang-version 1.1;
+  namespace "urn:example:clixon";
+  prefix ex;
+  import ietf-yang-schema-mount {
+    prefix yangmnt;
+  }
+  import clixon-lib {
+    prefix cl;
+  }
+  container top{
+    list mylist{
+      key name;
+      leaf name{
+        type string;
+      }
+      container root{
+         presence "Otherwise root is not visible";
+         yangmnt:mount-point "mylabel"{
+            description "Root for other yang models";
+         }
+         cl:xmldb-split{
+           description "Multi-XMLDB: split datastore here";
+         }
+      }
+    }
+  }
+}
+EOF
+
+cat <<EOF > $fyang1
+module clixon-mount1{
+   yang-version 1.1;
+   namespace "urn:example:mount1";
+   prefix m1;
+   container mount1{
+      list mylist1{
+         key name1;
+         leaf name1{
+            type string;
+         }
+         leaf value1 {
+            type string;
+         }
+      }
+   }
+}
+EOF
+
+# Mount-point entry
+# 1: name
+# 2: value
+function entry()
+{
+    echo "<mylist><name>$1</name><root><mount1 xmlns=\"urn:example:mount1\"><mylist1><name1>$1</name1><value1>$2</value1></mylist1></mount1></root></mylist>"
+}
+
+function rpc() {
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS>$1</rpc>" "" "<rpc-reply $DEFAULTNS>$2</rpc-reply>"
+}
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg -- -m clixon-mount1 -M urn:example:mount1"
+    start_backend -s init -f $cfg -- -m clixon-mount1 -M urn:example:mount1
+fi
+
+new "wait backend"
+wait_backend
+
+new "Add mount-points"
+rpc "<edit-config><target><candidate/></target><config><top xmlns=\"urn:example:clixon\"><mylist><name>x1</name><root/></mylist><mylist><name>x2</name><root/></mylist><mylist><name>x3</name><root/></mylist><mylist><name>x4</name><root/></mylist></top></config></edit-config>" "<ok/>"
+
+new "netconf commit"
+rpc "<commit/>" "<ok/>"
+
+new "Add data to all mount-points"
+rpc "<edit-config><target><candidate/></target><config><top xmlns=\"urn:example:clixon\">$(entry x1 a)$(entry x2 a)$(entry x3 a)$(entry x4 a)</top></config></edit-config>" "<ok/>"
+
+new "netconf commit"
+rpc "<commit/>" "<ok/>"
+
+new "Check running has one sub-file per mount-point"
+sudo chmod 755 $dir/running.d
+ret=$(ls $dir/running.d/*.xml | wc -l)
+if [ $ret -ne 5 ]; then
+    err "5" "$ret"
+fi
+
+new "Change data of two mount-points"
+rpc "<edit-config><target><candidate/></target><config><top xmlns=\"urn:example:clixon\">$(entry x2 b)$(entry x4 b)</top></config></edit-config>" "<ok/>"
+
+new "netconf commit"
+rpc "<commit/>" "<ok/>"
+
+CONF="<top xmlns=\"urn:example:clixon\">$(entry x1 a)$(entry x2 b)$(entry x3 a)$(entry x4 b)</top>"
+
+new "Check running"
+rpc "<get-config><source><running/></source></get-config>" "<data>$CONF</data>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    stop_backend -f $cfg
+
+    new "start backend -s running -f $cfg -- -m clixon-mount1 -M urn:example:mount1"
+    start_backend -s running -f $cfg -- -m clixon-mount1 -M urn:example:mount1
+fi
+
+new "wait backend"
+wait_backend
+
+new "Check running after restart"
+rpc "<get-config><source><running/></source></get-config>" "<data>$CONF</data>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    stop_backend -f $cfg
+fi
+
+sudo rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,139 @@
+#!/usr/bin/env bash
+# Binary snapshot of running for local frontends, CLICON_XMLDB_SNAPSHOT
+# Check that the snapshot is published on commit, and that get-config of running from
+# cli and netconf follows commits
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/clixon-example.yang
+fclispec=$dir/clispec.cli
+fsnap=$dir/running.snapshot
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_CLI_MODE>$APPNAME</CLICON_CLI_MODE>
+  <CLICON_CLI_DIR>/usr/local/lib/$APPNAME/cli</CLICON_CLI_DIR>
+  <CLICON_CLISPEC_DIR>$dir</CLICON_CLISPEC_DIR>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_SNAPSHOT>$fsnap</CLICON_XMLDB_SNAPSHOT>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module clixon-example{
+    yang-version 1.1;
+    namespace "urn:example:clixon";
+    prefix ex;
+    container table{
+        list parameter{
+            key name;
+            leaf name{
+                type string;
+            }
+            leaf value{
+                type string;
+            }
+        }
+    }
+}
+EOF
+
+cat <<EOF > $fclispec
+CLICON_MODE="example";
+CLICON_PROMPT="%U@%H %w> ";
+CLICON_PLUGIN="example_cli";
+
+# Autocli syntax tree operations
+set @datamodel, cli_auto_set();
+delete("Delete a configuration item") @datamodel, cli_auto_del();
+commit("Commit the changes"), cli_commit();
+show("Show a particular state of the system"){
+    running("Show running"), cli_show_auto_mode("running", "xml", false, false);
+}
+quit("Quit"), cli_quit();
+EOF
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "cli set parameter a"
+expectpart "$($clixon_cli -1 -f $cfg set table parameter a value 42)" 0 "^$"
+
+new "cli commit"
+expectpart "$($clixon_cli -1 -f $cfg commit)" 0 "^$"
+
+new "Check snapshot is published"
+[ -s $fsnap ] || err "$fsnap" "none"
+sum0=$(sudo md5sum $fsnap | cut -d' ' -f1)
+
+new "cli show running from snapshot"
+expectpart "$($clixon_cli -1 -f $cfg show running)" 0 "^<table xmlns=\"urn:example:clixon\"><parameter><name>a</name><value>42</value></parameter></table>$"
+
+new "cli set parameter b"
+expectpart "$($clixon_cli -1 -f $cfg set table parameter b value 17)" 0 "^$"
+
+new "cli show running is not changed by candidate"
+expectpart "$($clixon_cli -1 -f $cfg show running)" 0 "^<table xmlns=\"urn:example:clixon\"><parameter><name>a</name><value>42</value></parameter></table>$"
+
+new "cli commit"
+expectpart "$($clixon_cli -1 -f $cfg commit)" 0 "^$"
+
+new "Check snapshot is updated on commit"
+sum1=$(sudo md5sum $fsnap | cut -d' ' -f1)
+if [ "$sum0" = "$sum1" ]; then
+    err "new snapshot" "$sum1"
+fi
+
+new "cli show running from updated snapshot"
+expectpart "$($clixon_cli -1 -f $cfg show running)" 0 "^<table xmlns=\"urn:example:clixon\"><parameter><name>a</name><value>42</value></parameter><parameter><name>b</name><value>17</value></parameter></table>$"
+
+new "netconf get-config running"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>a</name><value>42</value></parameter><parameter><name>b</name><value>17</value></parameter></table></data></rpc-reply>"
+
+new "netconf get-config running with xpath filter"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:table/ex:parameter[ex:name='b']\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>b</name><value>17</value></parameter></table></data></rpc-reply>"
+
+new "cli delete parameter a"
+expectpart "$($clixon_cli -1 -f $cfg delete table parameter a)" 0 "^$"
+
+new "cli commit"
+expectpart "$($clixon_cli -1 -f $cfg commit)" 0 "^$"
+
+new "cli show running after delete"
+expectpart "$($clixon_cli -1 -f $cfg show running)" 0 "^<table xmlns=\"urn:example:clixon\"><parameter><name>b</name><value>17</value></parameter></table>$"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
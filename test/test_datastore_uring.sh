@@ -0,0 +1,130 @@
+#!/usr/bin/env bash
+# Datastore file I/O with io_uring, CLICON_XMLDB_IO_URING
+# Write a large running datastore and several commits in a row, restart the backend from
+# running, and check that the datastore file is complete with and without io_uring
+# If clixon is not built with liburing, the option is ignored and the test still holds
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/clixon-example.yang
+
+# Number of list entries, large enough for several reads of the datastore file
+: ${perfnr:=20000}
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module clixon-example{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container table{
+      list parameter{
+         key name;
+         leaf name{
+            type uint32;
+         }
+         leaf value{
+            type string;
+         }
+      }
+   }
+}
+EOF
+
+new "generate $perfnr list entries"
+echo -n "<table xmlns=\"urn:example:clixon\">" > $dir/config.xml
+for (( i=0; i<$perfnr; i++ )); do
+    echo -n "<parameter><name>$i</name><value>value of entry $i of the large datastore</value></parameter>" >> $dir/config.xml
+done
+echo -n "</table>" >> $dir/config.xml
+
+# 1: CLICON_XMLDB_IO_URING
+# 2: startup mode
+function start() {
+    if [ $BE -ne 0 ]; then
+        new "kill old backend"
+        sudo clixon_backend -zf $cfg
+        if [ $? -ne 0 ]; then
+            err
+        fi
+        new "start backend -s $2 -f $cfg -o CLICON_XMLDB_IO_URING=$1"
+        start_backend -s $2 -f $cfg -o CLICON_XMLDB_IO_URING=$1
+    fi
+
+    new "wait backend"
+    wait_backend
+}
+
+function stop() {
+    if [ $BE -ne 0 ]; then
+        new "Kill backend"
+        # Check if premature kill
+        pid=$(pgrep -u root -f clixon_backend)
+        if [ -z "$pid" ]; then
+            err "backend already dead"
+        fi
+        stop_backend -f $cfg
+    fi
+}
+
+# 1: CLICON_XMLDB_IO_URING
+function testrun() {
+    uring=$1
+
+    sudo rm -f $dir/running_db $dir/candidate_db
+    start $uring init
+
+    new "uring $uring: edit large config"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config>$(cat $dir/config.xml)</config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    new "uring $uring: commit"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    # Writes of the datastore file are coalesced
+    for v in 1 2 3 4 5; do
+        new "uring $uring: edit and commit value $v"
+        expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><table xmlns=\"urn:example:clixon\"><parameter><name>0</name><value>$v</value></parameter></table></config></edit-config></rpc><rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply><rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+    done
+
+    stop
+
+    new "uring $uring: Check datastore file is complete"
+    expectpart "$(sudo tail -c 200 $dir/running_db)" 0 "<name>$((perfnr - 1))</name>" "</table>"
+
+    new "uring $uring: Check no temporary datastore file is left"
+    if sudo test -e $dir/running_db.tmp; then
+        err "no $dir/running_db.tmp" "$dir/running_db.tmp"
+    fi
+
+    start $uring running
+
+    new "uring $uring: get-config of last entry after restart"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:table/ex:parameter[ex:name='$((perfnr - 1))']\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>$((perfnr - 1))</name><value>value of entry $((perfnr - 1)) of the large datastore</value></parameter></table></data></rpc-reply>"
+
+    new "uring $uring: get-config of last committed value after restart"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:table/ex:parameter[ex:name='0']\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>0</name><value>5</value></parameter></table></data></rpc-reply>"
+
+    stop
+}
+
+testrun false
+testrun true
+
+sudo rm -rf $dir
+
+new "endtest"
+endtest
@@ -3,6 +3,7 @@
 # - XML and JSON
 # - save and load config files
 # Pretty and not
+# Arena allocation and copy-on-write datastores
 
 # Magic line must be first in script (see README.md)
 s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
@@ -89,10 +90,12 @@ EOF
 # Restconf test routine with arguments:
 # 1. format: xml/json
 # 2. pretty: false/true - pretty-printed XMLDB
+# 3. arena: false/true - XML arena allocation and copy-on-write datastores (optional)
 function testrun()
 {
     format=$1
     pretty=$2
+    arena=${3:-false}
     
     if [ $BE -ne 0 ]; then
         new "kill old backend"
@@ -100,8 +103,8 @@ function testrun()
         if [ $? -ne 0 ]; then
             err
         fi
-        new "start backend -s init -f $cfg -o CLICON_XMLDB_FORMAT=$format -o CLICON_XMLDB_PRETTY=$pretty"
-        start_backend -s init -f $cfg -o CLICON_XMLDB_FORMAT=$format -o CLICON_XMLDB_PRETTY=$pretty
+        new "start backend -s init -f $cfg -o CLICON_XMLDB_FORMAT=$format -o CLICON_XMLDB_PRETTY=$pretty -o CLICON_XML_ARENA=$arena -o CLICON_XMLDB_COPY_ON_WRITE=$arena"
+        start_backend -s init -f $cfg -o CLICON_XMLDB_FORMAT=$format -o CLICON_XMLDB_PRETTY=$pretty -o CLICON_XML_ARENA=$arena -o CLICON_XMLDB_COPY_ON_WRITE=$arena
     fi
 
     new "wait backend"
@@ -173,6 +176,29 @@ EOF
     
     new "cli show config xml"
     expectpart "$($clixon_cli -1 -f $cfg show config)" 0 "^<table xmlns=\"urn:example:clixon\"><parameter><name>a</name><value>42</value></parameter></table>$"
+
+    if [ "$arena" = true ]; then
+        new "cli commit"
+        expectpart "$($clixon_cli -1 -f $cfg commit)" 0 "^$"
+
+        new "cli configure parameter b"
+        expectpart "$($clixon_cli -1 -f $cfg set table parameter b value 17)" 0 "^$"
+
+        new "running is not changed by edit of candidate"
+        expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>a</name><value>42</value></parameter></table></data></rpc-reply>"
+
+        new "discard shares running with candidate"
+        expectpart "$($clixon_cli -1 -f $cfg discard)" 0 "^$"
+
+        new "cli configure parameter c"
+        expectpart "$($clixon_cli -1 -f $cfg set table parameter c value 99)" 0 "^$"
+
+        new "cli show config xml"
+        expectpart "$($clixon_cli -1 -f $cfg show config)" 0 "^<table xmlns=\"urn:example:clixon\"><parameter><name>a</name><value>42</value></parameter><parameter><name>c</name><value>99</value></parameter></table>$"
+
+        new "running is not changed after discard and edit"
+        expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>a</name><value>42</value></parameter></table></data></rpc-reply>"
+    fi
     
     if [ $BE -ne 0 ]; then
         new "Kill backend"
@@ -195,6 +221,9 @@ for format in xml json; do
     done
 done
 
+new "test db with arena and copy-on-write"
+testrun xml false true
+
 # Negative test, load yang-invalid xml
 if [ $BE -ne 0 ]; then
     new "kill old backend"
@@ -0,0 +1,100 @@
+#!/usr/bin/env bash
+# Asynchronous debug messages, CLICON_DEBUG_RING
+# Check that debug messages are written to the log via the ring in the cli and in the
+# forked backend, and that messages that do not fit in the ring are dropped and counted
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/example.yang
+flog=$dir/clixon.log
+fbelog=$dir/backend.log
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>$dir/backend.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_CLI_MODE>$APPNAME</CLICON_CLI_MODE>
+  <CLICON_CLI_DIR>/usr/local/lib/$APPNAME/cli</CLICON_CLI_DIR>
+  <CLICON_CLISPEC_DIR>/usr/local/lib/$APPNAME/clispec</CLICON_CLISPEC_DIR>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module example{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container table{
+      list parameter{
+         key name;
+         leaf name{
+            type string;
+         }
+      }
+   }
+}
+EOF
+
+new "test params: -f $cfg -o CLICON_DEBUG_RING=65536 -D msg -D detail -lf$fbelog"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    sudo rm -f $fbelog
+    new "start backend -s init -f $cfg -o CLICON_DEBUG_RING=65536 -D msg -D detail -lf$fbelog"
+    start_backend -s init -f $cfg -o CLICON_DEBUG_RING=65536 -D msg -D detail -lf$fbelog
+fi
+
+new "wait backend"
+wait_backend
+
+for ring in 0 65536; do
+    new "cli debug with ring $ring"
+    rm -f $flog
+    expectpart "$($clixon_cli -1 -f $cfg -lf$flog -D msg -o CLICON_DEBUG_RING=$ring show configuration)" 0
+
+    new "Check cli debug messages with ring $ring"
+    expectpart "$(cat $flog)" 0 "Send" "Recv" --not-- "debug messages dropped"
+done
+
+new "cli debug with ring smaller than messages"
+rm -f $flog
+expectpart "$($clixon_cli -1 -f $cfg -lf$flog -D msg -o CLICON_DEBUG_RING=16 show configuration)" 0
+
+new "Check cli debug messages are dropped"
+expectpart "$(cat $flog)" 0 "debug messages dropped" --not-- "Send"
+
+new "netconf edit-config"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><table xmlns=\"urn:example:clixon\"><parameter><name>a</name></parameter></table></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "netconf get-config"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>a</name></parameter></table></data></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Check backend debug messages of forked daemon"
+    sleep 1
+    expectpart "$(sudo cat $fbelog)" 0 "Recv" "edit-config" --not-- "debug messages dropped"
+
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    stop_backend -f $cfg
+fi
+
+sudo rm -rf $dir
+
+new "endtest"
+endtest
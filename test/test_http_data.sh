@@ -252,6 +252,12 @@ TP/$HVER 200" "Content-Type: text/html" "<title>Welcome to Clixon!</title>"
             err1 "$dir/foo.png $dir/www/data/example.css should be equal" "Not equal"
         fi
 
+        new "WWW get byte range"
+        expectpart "$(curl $CURLOPTS -X GET -H 'Accept: text/html' -H 'Range: bytes=2-8' $proto://localhost/data/index.html)" 0 "HTTP/$HVER 206" "Content-Range: bytes 2-8/" "Content-Length: 7" "DOCTYPE" --not-- "<title>Welcome to Clixon!</title>"
+
+        new "WWW get byte range not satisfiable"
+        expectpart "$(curl $CURLOPTS -X GET -H 'Accept: text/html' -H 'Range: bytes=100000-' $proto://localhost/data/index.html)" 0 "HTTP/$HVER 416" "Content-Range: bytes \*/"
+
         # negative errors
         new "WWW get http not found"
         expectpart "$(curl $CURLOPTS -X GET -H 'Accept: text/html' $proto://localhost/data/notfound.html)" 0 "HTTP/$HVER 404" "Content-Type: text/html" "<title>404 Not Found</title>"
@@ -0,0 +1,174 @@
+#!/usr/bin/env bash
+# Leafref target indexes kept between validations, CLICON_XMLDB_LEAFREF_INDEX
+# A must statement uses deref() of a leafref to check the referred list entry.
+# Check validation results with and without the index, also after edits and commits
+# of the referred list that drop the index
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/example.yang
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module example{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container interfaces{
+      list interface{
+         key name;
+         leaf name{
+            type string;
+         }
+         leaf enabled{
+            type boolean;
+            default true;
+         }
+      }
+   }
+   container routes{
+      list route{
+         key prefix;
+         leaf prefix{
+            type string;
+         }
+         leaf interface{
+            type leafref{
+               path "/ex:interfaces/ex:interface/ex:name";
+            }
+            must "deref(.)/../ex:enabled = 'true'"{
+               error-message "Interface must be enabled";
+            }
+         }
+      }
+   }
+}
+EOF
+
+# Edit candidate
+# 1: config
+function edit() {
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config>$1</config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+}
+
+# Validate candidate
+# 1: expected reply
+function validate() {
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>" "" "<rpc-reply $DEFAULTNS>$1"
+}
+
+# Route of an interface
+# 1: prefix
+# 2: interface
+function route() {
+    echo "<routes xmlns=\"urn:example:clixon\"><route><prefix>$1</prefix><interface>$2</interface></route></routes>"
+}
+
+# Interface
+# 1: name
+# 2: enabled
+function interface() {
+    echo "<interfaces xmlns=\"urn:example:clixon\"><interface><name>$1</name><enabled>$2</enabled></interface></interfaces>"
+}
+
+# 1: CLICON_XMLDB_LEAFREF_INDEX
+function testrun() {
+    index=$1
+
+    new "test params: -f $cfg -o CLICON_XMLDB_LEAFREF_INDEX=$index"
+    if [ $BE -ne 0 ]; then
+        new "kill old backend"
+        sudo clixon_backend -zf $cfg
+        if [ $? -ne 0 ]; then
+            err
+        fi
+        new "start backend -s init -f $cfg -o CLICON_XMLDB_LEAFREF_INDEX=$index"
+        start_backend -s init -f $cfg -o CLICON_XMLDB_LEAFREF_INDEX=$index
+    fi
+
+    new "wait backend"
+    wait_backend
+
+    new "index $index: add interfaces"
+    edit "$(interface eth0 true)$(interface eth1 false)"
+
+    new "index $index: add route of enabled interface"
+    edit "$(route 10.0.0.0/8 eth0)"
+
+    new "index $index: validate"
+    validate "<ok/></rpc-reply>"
+
+    new "index $index: commit"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    new "index $index: add route of disabled interface"
+    edit "$(route 11.0.0.0/8 eth1)"
+
+    new "index $index: validate fails on deref of disabled interface"
+    validate "<rpc-error><error-type>application</error-type><error-tag>operation-failed</error-tag>.*<error-message>Interface must be enabled</error-message>"
+
+    new "index $index: enable interface"
+    edit "$(interface eth1 true)"
+
+    new "index $index: validate after edit of referred list"
+    validate "<ok/></rpc-reply>"
+
+    new "index $index: add route of missing interface"
+    edit "$(route 12.0.0.0/8 eth2)"
+
+    new "index $index: validate fails on missing interface"
+    validate "<rpc-error><error-type>application</error-type><error-tag>data-missing</error-tag><error-app-tag>instance-required</error-app-tag>"
+
+    new "index $index: add interface"
+    edit "$(interface eth2 true)"
+
+    new "index $index: validate after add to referred list"
+    validate "<ok/></rpc-reply>"
+
+    new "index $index: commit"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    new "index $index: disable committed interface"
+    edit "$(interface eth0 false)"
+
+    new "index $index: validate fails after commit and edit"
+    validate "<rpc-error><error-type>application</error-type><error-tag>operation-failed</error-tag>.*<error-message>Interface must be enabled</error-message>"
+
+    new "index $index: discard"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><discard-changes/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    new "index $index: validate after discard"
+    validate "<ok/></rpc-reply>"
+
+    if [ $BE -ne 0 ]; then
+        new "Kill backend"
+        # Check if premature kill
+        pid=$(pgrep -u root -f clixon_backend)
+        if [ -z "$pid" ]; then
+            err "backend already dead"
+        fi
+        stop_backend -f $cfg
+    fi
+}
+
+testrun false
+testrun true
+
+rm -rf $dir
+
+new "endtest"
+endtest
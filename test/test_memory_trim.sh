@@ -0,0 +1,108 @@
+#!/usr/bin/env bash
+# Memory of transient trees returned to the OS after operations, see CLICON_MEMORY_TRIM
+# Edit a large list in candidate, discard it again and check that arena memory is trimmed
+# The system allocator is only trimmed if at least CLICON_MEMORY_TRIM_THRESHOLD bytes are
+# returned, which is checked in the backend debug log
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/test.yang
+flog=$dir/backend.log
+
+: ${perfnr:=5000}
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_MEMORY_TRIM>heap</CLICON_MEMORY_TRIM>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module $APPNAME{
+  yang-version 1.1;
+  namespace "urn:example:clixon";
+  prefix ex;
+  container a {
+    list b {
+      key k;
+      leaf k { type uint32; }
+      leaf v { type string; }
+    }
+  }
+}
+EOF
+
+new "generate $perfnr list entries"
+echo -n "<a xmlns=\"urn:example:clixon\">" > $dir/config.xml
+for (( i=0; i<$perfnr; i++ )); do
+    echo -n "<b><k>$i</k><v>value of entry $i</v></b>" >> $dir/config.xml
+done
+echo -n "</a>" >> $dir/config.xml
+
+# 1: CLICON_MEMORY_TRIM_THRESHOLD
+# 2: true if the system allocator is expected to be trimmed
+function testrun() {
+    threshold=$1
+    trimmed=$2
+
+    new "test params: -f $cfg -o CLICON_MEMORY_TRIM_THRESHOLD=$threshold"
+    if [ $BE -ne 0 ]; then
+        new "kill old backend"
+        sudo clixon_backend -zf $cfg
+        if [ $? -ne 0 ]; then
+            err
+        fi
+        sudo rm -f $flog
+        new "start backend -s init -f $cfg -o CLICON_MEMORY_TRIM_THRESHOLD=$threshold -D backend -lf$flog"
+        start_backend -s init -f $cfg -o CLICON_MEMORY_TRIM_THRESHOLD=$threshold -D backend -lf$flog
+    fi
+
+    new "wait backend"
+    wait_backend
+
+    new "edit-config large list"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config>$(cat $dir/config.xml)</config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    new "discard-changes"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><discard-changes/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    new "arena memory is trimmed"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><stats xmlns=\"http://clicon.org/lib\"/></rpc>" "" "<memory-trimmed>[1-9][0-9]*</memory-trimmed>"
+
+    if [ $BE -ne 0 ]; then
+        if $trimmed; then
+            new "threshold $threshold: system allocator is trimmed"
+            expectpart "$(sudo cat $flog)" 0 "malloc_trim after"
+        else
+            new "threshold $threshold: system allocator is not trimmed"
+            expectpart "$(sudo cat $flog)" 0 --not-- "malloc_trim after"
+        fi
+
+        new "Kill backend"
+        # Check if premature kill
+        pid=$(pgrep -u root -f clixon_backend)
+        if [ -z "$pid" ]; then
+            err "backend already dead"
+        fi
+        # kill backend
+        stop_backend -f $cfg
+    fi
+}
+
+testrun 1 true
+testrun 1000000000 false
+
+sudo rm -rf $dir
+
+new "endtest"
+endtest
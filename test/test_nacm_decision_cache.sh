@@ -0,0 +1,168 @@
+#!/usr/bin/env bash
+# Cache of NACM RPC validation decisions, CLICON_NACM_DECISION_CACHE_SIZE
+# Check that repeated rpcs of a user hit the cache, that the number of cached decisions
+# is limited, that a change of the NACM config is not hidden by the cache, and that
+# 0 disables the cache
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+# Common NACM scripts
+. ./nacm.sh
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/nacm-example.yang
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_NACM_MODE>internal</CLICON_NACM_MODE>
+  <CLICON_NACM_CREDENTIALS>none</CLICON_NACM_CREDENTIALS>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module nacm-example{
+  yang-version 1.1;
+  namespace "urn:example:nacm";
+  prefix nex;
+  import ietf-netconf-acm {
+        prefix nacm;
+  }
+  leaf x{
+    type int32;
+    description "something to edit";
+  }
+}
+EOF
+
+# Rules from RFC8341 A.2, kill-session denied for limited group
+# 1: action of kill-session rule
+function rules() {
+    cat <<EOF
+   <nacm xmlns="urn:ietf:params:xml:ns:yang:ietf-netconf-acm">
+     <enable-nacm>true</enable-nacm>
+     <read-default>deny</read-default>
+     <write-default>permit</write-default>
+     <exec-default>permit</exec-default>
+     $NGROUPS
+     <rule-list>
+       <name>limited-acl</name>
+       <group>limited</group>
+       <rule>
+         <name>kill-session</name>
+         <module-name>ietf-netconf</module-name>
+         <rpc-name>kill-session</rpc-name>
+         <access-operations>exec</access-operations>
+         <action>$1</action>
+       </rule>
+     </rule-list>
+     $NADMIN
+   </nacm>
+EOF
+}
+
+# Kill-session as a user
+# 1: user
+# 2: expected reply
+function killsession() {
+    new "kill-session as $1"
+    expecteof_netconf "$clixon_netconf -qf $cfg -U $1" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><kill-session><session-id>44</session-id></kill-session></rpc>" "" "<rpc-reply $DEFAULTNS>$2</rpc-reply>"
+}
+
+DENIED="<rpc-error><error-type>application</error-type><error-tag>access-denied</error-tag><error-severity>error</error-severity><error-message>access denied</error-message></rpc-error>"
+
+# Print a counter of the NACM decision cache from the stats rpc
+# 1: nr, hits or misses
+function nacmstat() {
+    echo "$HELLONO11<rpc $DEFAULTNS><stats xmlns=\"http://clicon.org/lib\"/></rpc>]]>]]>" | $clixon_netconf -qf $cfg -U andy | sed -n "s/.*<nacm-cache-$1>\([0-9]*\)<\/nacm-cache-$1>.*/\1/p"
+}
+
+# 1: CLICON_NACM_DECISION_CACHE_SIZE
+function testrun() {
+    size=$1
+
+    new "test params: -f $cfg -o CLICON_NACM_DECISION_CACHE_SIZE=$size"
+    if [ $BE -ne 0 ]; then
+        new "kill old backend"
+        sudo clixon_backend -zf $cfg
+        if [ $? -ne 0 ]; then
+            err
+        fi
+        new "start backend -s init -f $cfg -o CLICON_NACM_DECISION_CACHE_SIZE=$size"
+        start_backend -s init -f $cfg -o CLICON_NACM_DECISION_CACHE_SIZE=$size
+    fi
+
+    new "wait backend"
+    wait_backend
+
+    new "set nacm rules"
+    expecteof_netconf "$clixon_netconf -qf $cfg -U andy" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config>$(rules deny)</config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    new "commit"
+    expecteof_netconf "$clixon_netconf -qf $cfg -U andy" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    killsession wilma "$DENIED"
+    hits0=$(nacmstat hits)
+    killsession wilma "$DENIED"
+    hits1=$(nacmstat hits)
+    killsession bam-bam "$DENIED"
+    killsession andy "<ok/>"
+    killsession guest "<ok/>"
+
+    if [ $size -eq 0 ]; then
+        new "Check cache is disabled"
+        for c in nr hits misses; do
+            ret=$(nacmstat $c)
+            if [ "$ret" != 0 ]; then
+                err "0" "$c: $ret"
+            fi
+        done
+    else
+        new "Check repeated rpc hits the cache"
+        if [ $hits1 -le $hits0 ]; then
+            err "hits > $hits0" "$hits1"
+        fi
+
+        new "Check number of cached decisions is limited"
+        ret=$(nacmstat nr)
+        if [ $ret -gt $size ]; then
+            err "<= $size" "$ret"
+        fi
+    fi
+
+    new "permit kill-session for limited group"
+    expecteof_netconf "$clixon_netconf -qf $cfg -U andy" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><default-operation>replace</default-operation><config>$(rules permit)</config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    new "commit"
+    expecteof_netconf "$clixon_netconf -qf $cfg -U andy" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    killsession wilma "<ok/>"
+
+    if [ $BE -ne 0 ]; then
+        new "Kill backend"
+        # Check if premature kill
+        pid=$(pgrep -u root -f clixon_backend)
+        if [ -z "$pid" ]; then
+            err "backend already dead"
+        fi
+        stop_backend -f $cfg
+    fi
+}
+
+for size in 2 0; do
+    testrun $size
+done
+
+rm -rf $dir
+
+new "endtest"
+endtest
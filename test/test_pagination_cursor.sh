@@ -0,0 +1,105 @@
+#!/usr/bin/env bash
+# Continuation tokens of partial-state pagination, CLICON_PAGINATION_CURSOR_TIMEOUT
+# The example pagination callback sets a token of the next page and logs when it is
+# given back. Check sequential pages in one session with and without expired tokens
+# The example-social yang file is used
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fexample=$dir/example-social.yang
+fstate=$dir/mystate.xml
+flog=$dir/backend.log
+
+# Common example-module spec (fexample must be set)
+. ./example_social.sh
+
+# Number of audit-log entries
+: ${perfnr:=100}
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>$IETFRFC</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_DIR>$dir</CLICON_YANG_MAIN_DIR>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_PAGINATION_CURSOR_TIMEOUT>2</CLICON_PAGINATION_CURSOR_TIMEOUT>
+</clixon-config>
+EOF
+
+new "generate state with $perfnr list entries"
+echo "<audit-logs xmlns=\"https://example.com/ns/example-social\">" > $fstate
+for (( i=0; i<$perfnr; i++ )); do
+    echo "<audit-log><timestamp>2021-09-05T18:48:11Z</timestamp><member-id>bob$i</member-id><source-ip>192.168.1.32</source-ip><request>POST</request><outcome>true</outcome></audit-log>" >> $fstate
+done
+echo -n "</audit-logs>" >> $fstate # No CR
+
+xpath="/es:audit-logs/es:audit-log"
+
+# Get rpc of a page of audit-logs with netconf 1.0 framing
+# 1: offset
+function page() {
+    echo "<rpc $DEFAULTNS><get content=\"nonconfig\"><filter type=\"xpath\" select=\"$xpath\" xmlns:es=\"https://example.com/ns/example-social\"/><list-pagination xmlns=\"urn:ietf:params:xml:ns:yang:ietf-list-pagination-nc\"><offset>$1</offset><limit>10</limit></list-pagination></get></rpc>]]>]]>"
+}
+
+# Get three sequential pages in one session
+# 1: seconds between pages
+function pages() {
+    (echo "$HELLONO11$(page 0)"; sleep $1; page 10; sleep $1; page 20; sleep 1) | $clixon_netconf -qf $cfg
+}
+
+new "test params: -f $cfg -l f$flog -- -siS $fstate -x $xpath"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    sudo rm -f $flog
+    new "start backend -s init -f $cfg -l f$flog -- -siS $fstate -x $xpath"
+    start_backend -s init -f $cfg -l f$flog -- -siS $fstate -x $xpath
+fi
+
+new "wait backend"
+wait_backend
+
+new "Get sequential pages"
+ret=$(pages 0)
+expectpart "$ret" 0 "<member-id>bob0</member-id>" "<member-id>bob9</member-id>" "<member-id>bob10</member-id>" "<member-id>bob19</member-id>" "<member-id>bob20</member-id>" "<member-id>bob29</member-id>" --not-- "<member-id>bob30</member-id>"
+
+new "Check tokens of next pages are given back"
+expectpart "$(sudo cat $flog)" 0 "example_pagination: cursor 10" "example_pagination: cursor 20"
+
+new "Get page in other session does not get token"
+sudo truncate -s 0 $flog
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get content=\"nonconfig\"><filter type=\"xpath\" select=\"$xpath\" xmlns:es=\"https://example.com/ns/example-social\"/><list-pagination xmlns=\"urn:ietf:params:xml:ns:yang:ietf-list-pagination-nc\"><offset>10</offset><limit>10</limit></list-pagination></get></rpc>" "" "<member-id>bob10</member-id>"
+expectpart "$(sudo cat $flog)" 0 --not-- "example_pagination: cursor"
+
+new "Get pages with expired tokens"
+ret=$(pages 3)
+expectpart "$ret" 0 "<member-id>bob0</member-id>" "<member-id>bob19</member-id>" "<member-id>bob29</member-id>" --not-- "<member-id>bob30</member-id>"
+
+new "Check expired tokens are not given back"
+expectpart "$(sudo cat $flog)" 0 --not-- "example_pagination: cursor"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -419,6 +419,19 @@ testlimit 6 0 0 ""
 new "A.3.7. limit=2 offset=2"
 testlimit 2 2 2 "11 7"
 
+# Cursors are base64 encoded keys: MTE= is 11 and NQ== is 5
+filter="<filter type=\"xpath\" select=\"/es:members/es:member[es:member-id='alice']/es:favorites/es:uint8-numbers\" xmlns:es=\"https://example.com/ns/example-social\"/>"
+lpns="urn:ietf:params:xml:ns:yang:ietf-list-pagination"
+
+new "A.3.6. empty cursor limit=2"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source>$filter<list-pagination xmlns=\"urn:ietf:params:xml:ns:yang:ietf-list-pagination-nc\"><limit>2</limit><cursor/></list-pagination></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><members xmlns=\"https://example.com/ns/example-social\"><member><member-id>alice</member-id><favorites><uint8-numbers lp:next=\"MTE=\" xmlns:lp=\"$lpns\">17</uint8-numbers><uint8-numbers>13</uint8-numbers></favorites></member></members></data></rpc-reply>"
+
+new "A.3.6. cursor=5 limit=2"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source>$filter<list-pagination xmlns=\"urn:ietf:params:xml:ns:yang:ietf-list-pagination-nc\"><limit>2</limit><cursor>NQ==</cursor></list-pagination></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><members xmlns=\"https://example.com/ns/example-social\"><member><member-id>alice</member-id><favorites><uint8-numbers lp:previous=\"MTE=\" xmlns:lp=\"$lpns\">5</uint8-numbers><uint8-numbers>3</uint8-numbers></favorites></member></members></data></rpc-reply>"
+
+new "A.3.6. cursor not found"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source>$filter<list-pagination xmlns=\"urn:ietf:params:xml:ns:yang:ietf-list-pagination-nc\"><limit>2</limit><cursor>NDI=</cursor></list-pagination></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>invalid-value</error-tag><error-severity>error</error-severity><error-message>list-pagination cursor not found</error-message></rpc-error></rpc-reply>"
+
 if [ $RC -ne 0 ]; then
     new "Kill restconf daemon"
     stop_restconf
@@ -0,0 +1,83 @@
+#!/usr/bin/env bash
+# JSON parser performance test, see CLICON_JSON_PARSER
+# Load a large JSON startup datastore with the bison parser and the fast scanner
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Number of list entries in file
+: ${perfnr:=20000}
+
+APPNAME=example
+
+cfg=$dir/scaling-conf.xml
+fyang=$dir/scaling.yang
+sj=$dir/sj.json
+
+cat <<EOF > $fyang
+module scaling{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ip;
+   container x {
+     list y {
+       key "a";
+       leaf a {
+         type int32;
+       }
+       leaf b {
+         type string;
+       }
+     }
+   }
+}
+EOF
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>$dir</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_FORMAT>json</CLICON_XMLDB_FORMAT>
+  <CLICON_FEATURE>ietf-netconf:startup</CLICON_FEATURE>
+  <CLICON_JSON_PARSER>bison</CLICON_JSON_PARSER>
+</clixon-config>
+EOF
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg -y $fyang
+    if [ $? -ne 0 ]; then
+        err
+    fi
+fi
+
+new "generate json startup config ($sj) with $perfnr entries"
+echo -n '{"config":{"scaling:x":{"y":[' > $sj
+for (( i=0; i<$perfnr; i++ )); do
+    if [ $i -ne 0 ]; then
+        echo -n "," >> $sj
+    fi
+    echo -n "{\"a\":$i,\"b\":\"entry \\\"$i\\\"\"}" >> $sj
+done
+echo "]}}}" >> $sj
+
+sdb=$dir/startup_db
+for parser in bison fast; do
+    sudo rm -f $sdb
+    cp $sj $sdb
+    sudo chmod 666 $sdb
+    sed -i "s/<CLICON_JSON_PARSER>.*</<CLICON_JSON_PARSER>$parser</" $cfg
+    new "Startup json $parser"
+    # Cannot use start_backend here due to expected error case
+    { time -p sudo $clixon_backend -F1 -D $DBG -s startup -f $cfg -y $fyang 2> /dev/null; } 2>&1 | awk '/real/ {print $2}'
+done
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,211 @@
+#!/usr/bin/env bash
+# Backend plugin callbacks in forked workers
+# Two plugins compiled from the same source both set CLIXON_PLUGIN_STATEDATA_WORKER and
+# CLIXON_PLUGIN_TRANS_INDEPENDENT. Check that their statedata and trans_commit callbacks
+# run in workers, that results are merged, and that a failed commit reverts the other plugin
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/example-workers.yang
+cfile=$dir/example-workers.c
+pdir=$dir/plugin
+
+if [ ! -d $pdir ]; then
+    mkdir $pdir
+fi
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_DIR>$pdir</CLICON_BACKEND_DIR>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module example-workers{
+    yang-version 1.1;
+    namespace "urn:example:workers";
+    prefix ex;
+    container c {
+       leaf v {
+          type string;
+       }
+       leaf fail {
+          description "Name of plugin whose commit fails";
+          type string;
+       }
+    }
+    container st {
+       config false;
+       list p {
+          key name;
+          leaf name {
+             type string;
+          }
+          leaf worker {
+             description "Callback is called in another process than the backend";
+             type boolean;
+          }
+       }
+    }
+}
+EOF
+
+cat<<EOF > $cfile
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/syslog.h>
+/* cligen */
+#include <cligen/cligen.h>
+/* Clixon */
+#include <clixon/clixon.h>
+#include <clixon/clixon_backend.h>
+
+static pid_t _backend_pid = 0;
+
+/* Write a file in the test dir, an effect outside the backend process */
+static int
+workers_file(const char *what)
+{
+    FILE *f;
+    char  path[256];
+
+    snprintf(path, sizeof(path), "%s/%s-%s", TEST_DIR, what, PLUGIN_NAME);
+    if ((f = fopen(path, "w")) == NULL){
+        clixon_err(OE_UNIX, errno, "fopen");
+        return -1;
+    }
+    fprintf(f, "%s\n", getpid() != _backend_pid ? "worker" : "backend");
+    fclose(f);
+    return 0;
+}
+
+static int
+workers_statedata(clixon_handle h,
+                  cvec         *nsc,
+                  char         *xpath,
+                  cxobj        *xstate)
+{
+    return clixon_xml_parse_va(YB_NONE, NULL, &xstate, NULL,
+                               "<st xmlns=\"urn:example:workers\"><p><name>%s</name><worker>%s</worker></p></st>",
+                               PLUGIN_NAME, getpid() != _backend_pid ? "true" : "false");
+}
+
+static int
+workers_commit(clixon_handle    h,
+               transaction_data td)
+{
+    char *fail;
+
+    fail = xml_find_body(xpath_first(transaction_target(td), NULL, "c"), "fail");
+    if (fail && strcmp(fail, PLUGIN_NAME) == 0){
+        clixon_err(OE_PLUGIN, 0, "Commit of plugin %s failed", PLUGIN_NAME);
+        return -1;
+    }
+    return workers_file("commit");
+}
+
+static int
+workers_revert(clixon_handle    h,
+               transaction_data td)
+{
+    return workers_file("revert");
+}
+
+clixon_plugin_api *clixon_plugin_init(clixon_handle h);
+
+static clixon_plugin_api api = {
+    PLUGIN_NAME,
+    clixon_plugin_init,
+    .ca_statedata=workers_statedata,
+    .ca_trans_commit=workers_commit,
+    .ca_trans_revert=workers_revert,
+    .ca_trans_flags=CLIXON_PLUGIN_TRANS_INDEPENDENT | CLIXON_PLUGIN_STATEDATA_WORKER
+};
+
+clixon_plugin_api *
+clixon_plugin_init(clixon_handle h)
+{
+    _backend_pid = getpid();
+    return &api;
+}
+EOF
+
+for p in a b; do
+    new "compile plugin $p"
+    expectpart "$($CC -g -Wall -rdynamic -fPIC -shared -I/usr/local/include -DPLUGIN_NAME=\"$p\" -DTEST_DIR=\"$dir\" $cfile -o $pdir/example-workers-$p.so)" 0 ""
+done
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "get state of both plugins from workers"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get><filter type=\"xpath\" select=\"/ex:st\" xmlns:ex=\"urn:example:workers\"/></get></rpc>" "" "<rpc-reply $DEFAULTNS><data><st xmlns=\"urn:example:workers\"><p><name>a</name><worker>true</worker></p><p><name>b</name><worker>true</worker></p></st></data></rpc-reply>"
+
+new "edit v"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:workers\"><v>1</v></c></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "commit"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+for p in a b; do
+    new "commit of plugin $p in worker"
+    expectpart "$(cat $dir/commit-$p)" 0 "worker"
+done
+
+new "edit v and fail of plugin b"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:workers\"><v>2</v><fail>b</fail></c></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "commit fails with error of plugin b"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "Commit of plugin b failed"
+
+new "plugin a is reverted"
+expectpart "$(cat $dir/revert-a)" 0 "backend"
+
+new "plugin b is not reverted"
+if [ -f $dir/revert-b ]; then
+    err "no $dir/revert-b" "$dir/revert-b"
+fi
+
+new "running is unchanged"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:workers\"><v>1</v></c></data></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,113 @@
+#!/usr/bin/env bash
+# Private candidate datastores per session, see CLICON_XMLDB_PRIVATE_CANDIDATE
+# Edits of one session are not seen by others, commit rebases on running and fails on
+# conflicting changes
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/test.yang
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_COPY_ON_WRITE>true</CLICON_XMLDB_COPY_ON_WRITE>
+  <CLICON_XMLDB_PRIVATE_CANDIDATE>true</CLICON_XMLDB_PRIVATE_CANDIDATE>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module $APPNAME{
+  yang-version 1.1;
+  namespace "urn:example:clixon";
+  prefix ex;
+  container a {
+     leaf x { type uint32; }
+     leaf y { type uint32; }
+  }
+}
+EOF
+
+# Netconf 1.0 rpc with end-of-message framing
+function rpc(){
+    echo "<rpc $DEFAULTNS>$1</rpc>]]>]]>"
+}
+
+# Edit candidate
+# 1: children of a
+function edit(){
+    rpc "<edit-config><target><candidate/></target><config><a xmlns=\"urn:example:clixon\">$1</a></config></edit-config>"
+}
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "edit and get private candidate in one session"
+expecteof "$clixon_netconf -qf $cfg" 0 "$HELLONO11$(edit "<x>1</x>")$(rpc "<get-config><source><candidate/></source></get-config>")" "<rpc-reply $DEFAULTNS><data><a xmlns=\"urn:example:clixon\"><x>1</x></a></data></rpc-reply>]]>]]>"
+
+new "other session does not see edit"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data/></rpc-reply>"
+
+new "asynchronous session edits y and commits after 2s"
+(echo "$HELLONO11$(edit "<y>5</y>")"; sleep 2; rpc "<commit/>"; sleep 1) | $clixon_netconf -qf $cfg > /dev/null &
+sleep 1
+
+new "edit x and commit"
+expecteof "$clixon_netconf -qf $cfg" 0 "$HELLONO11$(edit "<x>3</x>")$(rpc "<commit/>")" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>"
+
+wait
+
+new "running has both commits"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><a xmlns=\"urn:example:clixon\"><x>3</x><y>5</y></a></data></rpc-reply>"
+
+new "asynchronous session edits x and commits after 2s"
+(echo "$HELLONO11$(edit "<x>4</x>")"; sleep 2; rpc "<commit/>"; sleep 1) | $clixon_netconf -qf $cfg > $dir/conflict.out &
+sleep 1
+
+new "edit same x and commit"
+expecteof "$clixon_netconf -qf $cfg" 0 "$HELLONO11$(edit "<x>5</x>")$(rpc "<commit/>")" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>"
+
+wait
+
+new "conflicting commit fails"
+if ! grep -q "Commit conflict with running at" $dir/conflict.out; then
+    err "Commit conflict" "$(cat $dir/conflict.out)"
+fi
+
+new "running has first commit"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><a xmlns=\"urn:example:clixon\"><x>5</x><y>5</y></a></data></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
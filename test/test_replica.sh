@@ -0,0 +1,131 @@
+#!/usr/bin/env bash
+# Read-only replica of running, see CLICON_BACKEND_REPLICA_OF
+# Start a primary and a replica backend, commit on the primary and check that running of
+# the replica follows, that writes to the replica are rejected, and promote the replica
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+cfgr=$dir/conf_replica.xml
+fyang=$dir/test.yang
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_STREAM_DATASTORE_CHANGE>true</CLICON_STREAM_DATASTORE_CHANGE>
+</clixon-config>
+EOF
+
+cat <<EOF > $cfgr
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfgr</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME-replica.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME-replica.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_BACKEND_REPLICA_OF>/usr/local/var/run/$APPNAME.sock</CLICON_BACKEND_REPLICA_OF>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module $APPNAME{
+  yang-version 1.1;
+  namespace "urn:example:clixon";
+  prefix ex;
+  container a {
+     leaf x { type uint32; }
+  }
+  container b {
+     leaf y { type uint32; }
+  }
+}
+EOF
+
+# Edit and commit on primary
+# 1: config
+function commit(){
+    new "edit-config primary"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config>$1</config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    new "commit primary"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+    sleep 1
+}
+
+new "test params: -f $cfg -f $cfgr"
+if [ $BE -ne 0 ]; then
+    new "kill old backends"
+    sudo clixon_backend -zf $cfgr
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start primary backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait primary backend"
+wait_backend
+
+commit "<a xmlns=\"urn:example:clixon\"><x>1</x></a>"
+
+if [ $BE -ne 0 ]; then
+    new "start replica backend -s init -f $cfgr"
+    start_backend -s init -f $cfgr
+fi
+
+new "wait replica backend"
+cfg0=$cfg
+cfg=$cfgr
+wait_backend
+cfg=$cfg0
+
+new "replica has running of primary"
+expecteof_netconf "$clixon_netconf -qf $cfgr" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><a xmlns=\"urn:example:clixon\"><x>1</x></a></data></rpc-reply>"
+
+commit "<a xmlns=\"urn:example:clixon\"><x>2</x></a><b xmlns=\"urn:example:clixon\"><y>3</y></b>"
+
+new "replica follows commit"
+expecteof_netconf "$clixon_netconf -qf $cfgr" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><a xmlns=\"urn:example:clixon\"><x>2</x></a><b xmlns=\"urn:example:clixon\"><y>3</y></b></data></rpc-reply>"
+
+commit "<b xmlns=\"urn:example:clixon\" xmlns:nc=\"urn:ietf:params:xml:ns:netconf:base:1.0\" nc:operation=\"delete\"/>"
+
+new "replica follows delete"
+expecteof_netconf "$clixon_netconf -qf $cfgr" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><a xmlns=\"urn:example:clixon\"><x>2</x></a></data></rpc-reply>"
+
+new "edit-config replica fails"
+expecteof_netconf "$clixon_netconf -qf $cfgr" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><a xmlns=\"urn:example:clixon\"><x>5</x></a></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>operation-not-supported</error-tag><error-severity>error</error-severity><error-message>Read-only replica, write to the primary</error-message></rpc-error></rpc-reply>"
+
+new "promote replica"
+expecteof_netconf "$clixon_netconf -qf $cfgr" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><replica-promote $LIBNS/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "edit-config promoted replica"
+expecteof_netconf "$clixon_netconf -qf $cfgr" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><a xmlns=\"urn:example:clixon\"><x>5</x></a></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "commit promoted replica"
+expecteof_netconf "$clixon_netconf -qf $cfgr" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+commit "<a xmlns=\"urn:example:clixon\"><x>7</x></a>"
+
+new "promoted replica does not follow primary"
+expecteof_netconf "$clixon_netconf -qf $cfgr" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><a xmlns=\"urn:example:clixon\"><x>5</x></a></data></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backends"
+    stop_backend -f $cfgr
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,155 @@
+#!/usr/bin/env bash
+# Compression of native restconf replies, CLICON_RESTCONF_COMPRESS
+# Check gzip and deflate replies, that they decompress to the uncompressed reply, and
+# that small replies and clients not accepting compression get uncompressed replies
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Skip if other than native
+if [ "${WITH_RESTCONF}" != "native" ]; then
+    rm -rf $dir
+    if [ "$s" = $0 ]; then exit 0; else return 0; fi # skip
+fi
+
+# Skip if not built with zlib
+if ! ${HAVE_LIBZ}; then
+    echo "...skipped: zlib not enabled"
+    rm -rf $dir
+    if [ "$s" = $0 ]; then exit 0; else return 0; fi
+fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/restconf.yang
+
+: ${perfnr:=100}
+
+# Define default restconfig config: RESTCONFIG
+RESTCONFIG=$(restconf_config none false)
+if [ $? -ne 0 ]; then
+    err1 "Error when generating certs"
+fi
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_FEATURE>clixon-restconf:allow-auth-none</CLICON_FEATURE> <!-- Use auth-type=none -->
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>$dir/restconf.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_RESTCONF_COMPRESS>200</CLICON_RESTCONF_COMPRESS>
+  $RESTCONFIG
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module example{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container table{
+      list parameter{
+         key name;
+         leaf name{
+            type uint32;
+         }
+         leaf value{
+            type string;
+         }
+      }
+   }
+}
+EOF
+
+new "generate $perfnr list entries"
+echo -n '{"example:table":{"parameter":[' > $dir/config.json
+for (( i=0; i<$perfnr; i++ )); do
+    if [ $i -ne 0 ]; then
+        echo -n ',' >> $dir/config.json
+    fi
+    echo -n "{\"name\":$i,\"value\":\"value of entry $i\"}" >> $dir/config.json
+done
+echo -n ']}}' >> $dir/config.json
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    sudo pkill -f clixon_backend # to be sure
+
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+if [ $RC -ne 0 ]; then
+    new "kill old restconf daemon"
+    stop_restconf_pre
+
+    new "start restconf daemon"
+    start_restconf -f $cfg
+fi
+
+new "wait restconf"
+wait_restconf
+
+new "restconf PUT large config"
+expectpart "$(curl $CURLOPTS -X PUT -H "Content-Type: application/yang-data+json" -d @$dir/config.json $RCPROTO://localhost/restconf/data/example:table)" 0 "HTTP/$HVER 201"
+
+new "restconf GET uncompressed"
+expectpart "$(curl $CURLOPTS -X GET $RCPROTO://localhost/restconf/data/example:table)" 0 "HTTP/$HVER 200" "$(cat $dir/config.json | sed 's/\[/\\[/g;s/\]/\\]/g')" --not-- "Content-Encoding"
+
+new "restconf GET gzip"
+expectpart "$(curl $CURLOPTS --compressed -H "Accept-Encoding: gzip" -X GET $RCPROTO://localhost/restconf/data/example:table)" 0 "HTTP/$HVER 200" "Content-Encoding: gzip" "Vary: Accept-Encoding" "$(cat $dir/config.json | sed 's/\[/\\[/g;s/\]/\\]/g')"
+
+new "restconf GET deflate"
+expectpart "$(curl $CURLOPTS --compressed -H "Accept-Encoding: deflate" -X GET $RCPROTO://localhost/restconf/data/example:table)" 0 "HTTP/$HVER 200" "Content-Encoding: deflate" "$(cat $dir/config.json | sed 's/\[/\\[/g;s/\]/\\]/g')"
+
+new "restconf GET gzip is preferred"
+expectpart "$(curl $CURLOPTS --compressed -H "Accept-Encoding: deflate, gzip" -X GET $RCPROTO://localhost/restconf/data/example:table)" 0 "HTTP/$HVER 200" "Content-Encoding: gzip"
+
+new "restconf GET gzip not accepted with q=0"
+expectpart "$(curl $CURLOPTS -H "Accept-Encoding: gzip;q=0" -X GET $RCPROTO://localhost/restconf/data/example:table)" 0 "HTTP/$HVER 200" --not-- "Content-Encoding"
+
+new "restconf GET small reply is not compressed"
+expectpart "$(curl $CURLOPTS --compressed -H "Accept-Encoding: gzip" -X GET $RCPROTO://localhost/restconf/data/example:table/parameter=17)" 0 "HTTP/$HVER 200" '{"example:parameter":\[{"name":17,"value":"value of entry 17"}\]}' --not-- "Content-Encoding"
+
+new "Check compressed reply is smaller"
+curl $CURLOPTS -X GET $RCPROTO://localhost/restconf/data/example:table > $dir/plain.out
+curl $CURLOPTS -H "Accept-Encoding: gzip" -X GET $RCPROTO://localhost/restconf/data/example:table > $dir/gzip.out
+plain=$(stat -c %s $dir/plain.out)
+gz=$(stat -c %s $dir/gzip.out)
+if [ $gz -ge $plain ]; then
+    err "< $plain" "$gz"
+fi
+
+if [ $RC -ne 0 ]; then
+    new "Kill restconf daemon"
+    stop_restconf
+fi
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -43,6 +43,9 @@ fi
 # Force to HTTP 1.1 no SSL due to netcat
 RCPROTO=http
 
+# HTTP/1 request parser of native restconf: bison or fast, see CLICON_RESTCONF_HTTP1_PARSER
+: ${HTTP1PARSER:=bison}
+
 APPNAME=example
 
 cfg=$dir/conf.xml
@@ -73,6 +76,7 @@ cat <<EOF > $cfg
   <CLICON_CLISPEC_DIR>/usr/local/lib/$APPNAME/clispec</CLICON_CLISPEC_DIR>
   <CLICON_CLI_DIR>/usr/local/lib/$APPNAME/cli</CLICON_CLI_DIR>
   <CLICON_CLI_MODE>$APPNAME</CLICON_CLI_MODE>
+  <CLICON_RESTCONF_HTTP1_PARSER>$HTTP1PARSER</CLICON_RESTCONF_HTTP1_PARSER>
   $RESTCONFIG
 </clixon-config>
 EOF
@@ -0,0 +1,161 @@
+#!/usr/bin/env bash
+# Restconf entity tags and conditional GET of configuration data
+# RFC 8040 Sec 3.4.1, RFC 7232
+# Check ETag, If-None-Match, If-Modified-Since and response cache invalidation on commit
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/example.yang
+
+# Define default restconfig config: RESTCONFIG
+RESTCONFIG=$(restconf_config none false)
+if [ $? -ne 0 ]; then
+    err1 "Error when generating certs"
+fi
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_FEATURE>clixon-restconf:allow-auth-none</CLICON_FEATURE> <!-- Use auth-type=none -->
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>$dir/restconf.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_RESTCONF_ETAG>true</CLICON_RESTCONF_ETAG>
+  <CLICON_RESTCONF_CACHE>4</CLICON_RESTCONF_CACHE>
+  $RESTCONFIG
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module example{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container table{
+      list parameter{
+         key name;
+         leaf name{
+            type string;
+         }
+         leaf value{
+            type string;
+         }
+      }
+   }
+   container other{
+      leaf x{
+         type string;
+      }
+   }
+}
+EOF
+
+# Get entity tag of a GET request
+# 1: path
+function getetag()
+{
+    curl $CURLOPTS -X GET $RCPROTO://localhost/restconf/data/$1 | grep -i "^etag:" | awk '{print $2}' | tr -d '\r'
+}
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    sudo pkill -f clixon_backend # to be sure
+
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+if [ $RC -ne 0 ]; then
+    new "kill old restconf daemon"
+    stop_restconf_pre
+
+    new "start restconf daemon"
+    start_restconf -f $cfg
+fi
+
+new "wait restconf"
+wait_restconf
+
+new "restconf POST initial tree"
+expectpart "$(curl $CURLOPTS -X POST -H "Content-Type: application/yang-data+json" -d '{"example:table":{"parameter":{"name":"x","value":"42"}}}' $RCPROTO://localhost/restconf/data)" 0 "HTTP/$HVER 201"
+
+new "restconf POST other tree"
+expectpart "$(curl $CURLOPTS -X POST -H "Content-Type: application/yang-data+json" -d '{"example:other":{"x":"a"}}' $RCPROTO://localhost/restconf/data)" 0 "HTTP/$HVER 201"
+
+new "GET returns ETag and Last-Modified"
+expectpart "$(curl $CURLOPTS -X GET $RCPROTO://localhost/restconf/data/example:table)" 0 "HTTP/$HVER 200" "ETag: \"" "Last-Modified: " '{"example:table":{"parameter":\[{"name":"x","value":"42"}\]}}'
+
+etag=$(getetag example:table)
+if [ -z "$etag" ]; then
+    err "ETag" "none"
+fi
+etago=$(getetag example:other)
+
+new "GET If-None-Match equal etag: 304"
+expectpart "$(curl $CURLOPTS -X GET -H "If-None-Match: $etag" $RCPROTO://localhost/restconf/data/example:table)" 0 "HTTP/$HVER 304" "ETag: $etag"
+
+new "GET If-None-Match list of etags: 304"
+expectpart "$(curl $CURLOPTS -X GET -H "If-None-Match: \"0-0\", $etag" $RCPROTO://localhost/restconf/data/example:table)" 0 "HTTP/$HVER 304"
+
+new "GET If-None-Match other etag: 200"
+expectpart "$(curl $CURLOPTS -X GET -H "If-None-Match: \"0-0\"" $RCPROTO://localhost/restconf/data/example:table)" 0 "HTTP/$HVER 200" '{"example:table":{"parameter":\[{"name":"x","value":"42"}\]}}'
+
+new "GET If-Modified-Since future: 304"
+expectpart "$(curl $CURLOPTS -X GET -H "If-Modified-Since: Fri, 01 Jan 2100 00:00:00 GMT" $RCPROTO://localhost/restconf/data/example:table)" 0 "HTTP/$HVER 304"
+
+new "GET If-Modified-Since past: 200"
+expectpart "$(curl $CURLOPTS -X GET -H "If-Modified-Since: Thu, 01 Jan 2015 00:00:00 GMT" $RCPROTO://localhost/restconf/data/example:table)" 0 "HTTP/$HVER 200"
+
+new "GET cached reply"
+expectpart "$(curl $CURLOPTS -X GET $RCPROTO://localhost/restconf/data/example:table)" 0 "HTTP/$HVER 200" "ETag: $etag" '{"example:table":{"parameter":\[{"name":"x","value":"42"}\]}}'
+
+new "restconf PUT changes table"
+expectpart "$(curl $CURLOPTS -X PUT -H "Content-Type: application/yang-data+json" -d '{"example:value":"99"}' $RCPROTO://localhost/restconf/data/example:table/parameter=x/value)" 0 "HTTP/$HVER 204"
+
+new "GET If-None-Match old etag after commit: 200 and new data"
+expectpart "$(curl $CURLOPTS -X GET -H "If-None-Match: $etag" $RCPROTO://localhost/restconf/data/example:table)" 0 "HTTP/$HVER 200" '{"example:table":{"parameter":\[{"name":"x","value":"99"}\]}}'
+
+new "Check etag changed"
+etag2=$(getetag example:table)
+if [ "$etag" = "$etag2" ]; then
+    err "new ETag" "$etag2"
+fi
+
+new "GET If-None-Match other unchanged top-level node: 304"
+expectpart "$(curl $CURLOPTS -X GET -H "If-None-Match: $etago" $RCPROTO://localhost/restconf/data/example:other)" 0 "HTTP/$HVER 304"
+
+if [ $RC -ne 0 ]; then
+    new "Kill restconf daemon"
+    stop_restconf
+fi
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,152 @@
+#!/usr/bin/env bash
+# Pool of per-user backend sessions in restconf, CLICON_SOCK_SESSIONS
+# Check that each user gets a backend session, that the least recently used session is
+# re-bound when the pool is full, and that a session killed by the backend is replaced
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/restconf.yang
+
+# Define default restconfig config: RESTCONFIG
+RESTCONFIG=$(restconf_config user false)
+if [ $? -ne 0 ]; then
+    err1 "Error when generating certs"
+fi
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_RESTCONF_DIR>/usr/local/lib/$APPNAME/restconf</CLICON_RESTCONF_DIR>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_NETCONF_MONITORING>true</CLICON_NETCONF_MONITORING>
+  <CLICON_SOCK_SESSIONS>2</CLICON_SOCK_SESSIONS>
+  $RESTCONFIG
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module example{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container table{
+      list parameter{
+         key name;
+         leaf name{
+            type string;
+         }
+         leaf value{
+            type string;
+         }
+      }
+   }
+}
+EOF
+
+# Print backend sessions
+function sessions() {
+    echo "$HELLONO11<rpc $DEFAULTNS><get><filter type=\"subtree\"><netconf-state xmlns=\"urn:ietf:params:xml:ns:yang:ietf-netconf-monitoring\"><sessions/></netconf-state></filter></get></rpc>]]>]]>" | $clixon_netconf -qf $cfg
+}
+
+# Print session-id of backend session of a user
+# 1: username
+function session_id() {
+    sessions | sed -n "s/.*<session-id>\([0-9]*\)<\/session-id><transport[^>]*>[^<]*<\/transport><username>$1<\/username>.*/\1/p"
+}
+
+# Restconf GET as a user
+# 1: username
+function get() {
+    new "restconf GET as $1"
+    expectpart "$(curl -u $1:bar $CURLOPTS -X GET $RCPROTO://localhost/restconf/data/example:table)" 0 "HTTP/$HVER 200" '{"example:table":{"parameter":\[{"name":"a","value":"42"}\]}}'
+}
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+if [ $RC -ne 0 ]; then
+    new "kill old restconf daemon"
+    stop_restconf_pre
+
+    new "start restconf daemon"
+    start_restconf -f $cfg
+fi
+
+new "wait restconf"
+wait_restconf
+
+new "restconf POST as andy"
+expectpart "$(curl -u andy:bar $CURLOPTS -X POST -H "Content-Type: application/yang-data+json" -d '{"example:parameter":[{"name":"a","value":"42"}]}' $RCPROTO://localhost/restconf/data/example:table)" 0 "HTTP/$HVER 201"
+
+get wilma
+get andy
+get wilma
+
+new "Check one backend session per user"
+expectpart "$(sessions)" 0 "<username>andy</username>" "<username>wilma</username>"
+
+id0=$(session_id wilma)
+
+get guest
+sleep 1
+
+new "Check least recently used session is re-bound"
+expectpart "$(sessions)" 0 "<username>guest</username>" "<username>wilma</username>" --not-- "<username>andy</username>"
+
+new "Check session of wilma is kept"
+id1=$(session_id wilma)
+if [ "$id0" != "$id1" ]; then
+    err "$id0" "$id1"
+fi
+
+new "kill-session of wilma"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><kill-session><session-id>$id1</session-id></kill-session></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+get wilma
+
+new "Check killed session is replaced"
+id2=$(session_id wilma)
+if [ -z "$id2" -o "$id2" = "$id1" ]; then
+    err "new session-id" "$id2"
+fi
+
+if [ $RC -ne 0 ]; then
+    new "Kill restconf daemon"
+    stop_restconf
+fi
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,148 @@
+#!/usr/bin/env bash
+# Restconf GET replies serialized while sent, CLICON_RESTCONF_STREAM_CHUNK
+# Get a large config with and without streaming and check that the bodies are equal.
+# Native http/2 streamed replies have no Content-Length
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Skip if no restconf
+if [ -z "${WITH_RESTCONF}" ]; then
+    rm -rf $dir
+    if [ "$s" = $0 ]; then exit 0; else return 0; fi # skip
+fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/restconf.yang
+
+: ${perfnr:=1000}
+
+# Define default restconfig config: RESTCONFIG
+RESTCONFIG=$(restconf_config none false)
+if [ $? -ne 0 ]; then
+    err1 "Error when generating certs"
+fi
+
+cat <<EOF > $fyang
+module example{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container table{
+      list parameter{
+         key name;
+         leaf name{
+            type uint32;
+         }
+         leaf value{
+            type string;
+         }
+      }
+   }
+}
+EOF
+
+new "generate $perfnr list entries"
+echo -n '{"example:table":{"parameter":[' > $dir/config.json
+for (( i=0; i<$perfnr; i++ )); do
+    if [ $i -ne 0 ]; then
+        echo -n ',' >> $dir/config.json
+    fi
+    echo -n "{\"name\":$i,\"value\":\"value of entry $i\"}" >> $dir/config.json
+done
+echo -n ']}}' >> $dir/config.json
+
+# 1: CLICON_RESTCONF_STREAM_CHUNK
+function testrun() {
+    chunk=$1
+
+    cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_FEATURE>clixon-restconf:allow-auth-none</CLICON_FEATURE> <!-- Use auth-type=none -->
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>$dir/restconf.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_RESTCONF_STREAM_CHUNK>$chunk</CLICON_RESTCONF_STREAM_CHUNK>
+  $RESTCONFIG
+</clixon-config>
+EOF
+
+    new "test params: -f $cfg"
+    if [ $BE -ne 0 ]; then
+        new "kill old backend"
+        sudo clixon_backend -zf $cfg
+        if [ $? -ne 0 ]; then
+            err
+        fi
+        new "start backend -s init -f $cfg"
+        start_backend -s init -f $cfg
+    fi
+
+    new "wait backend"
+    wait_backend
+
+    if [ $RC -ne 0 ]; then
+        new "kill old restconf daemon"
+        stop_restconf_pre
+
+        new "start restconf daemon"
+        start_restconf -f $cfg
+    fi
+
+    new "wait restconf"
+    wait_restconf
+
+    new "chunk $chunk: restconf PUT large config"
+    expectpart "$(curl $CURLOPTS -X PUT -H "Content-Type: application/yang-data+json" -d @$dir/config.json $RCPROTO://localhost/restconf/data/example:table)" 0 "HTTP/$HVER 201"
+
+    new "chunk $chunk: restconf GET large config"
+    curl $CURLOPTS -X GET $RCPROTO://localhost/restconf/data/example:table > $dir/get-$chunk.out
+    expectpart "$(cat $dir/get-$chunk.out)" 0 "HTTP/$HVER 200" "$(cat $dir/config.json | sed 's/\[/\\[/g;s/\]/\\]/g')"
+
+    if [ $chunk -ne 0 -a "${WITH_RESTCONF}" = "native" -a "$HVER" = 2 ]; then
+        new "chunk $chunk: streamed http/2 reply has no Content-Length"
+        expectpart "$(cat $dir/get-$chunk.out)" 0 "HTTP/$HVER 200" --not-- "Content-Length"
+    fi
+
+    new "chunk $chunk: restconf GET small reply"
+    expectpart "$(curl $CURLOPTS -X GET $RCPROTO://localhost/restconf/data/example:table/parameter=17)" 0 "HTTP/$HVER 200" '{"example:parameter":\[{"name":17,"value":"value of entry 17"}\]}'
+
+    new "chunk $chunk: restconf GET missing instance"
+    expectpart "$(curl $CURLOPTS -X GET $RCPROTO://localhost/restconf/data/example:table/parameter=$perfnr)" 0 "HTTP/$HVER 404"
+
+    # Body without headers
+    sed -n '/^{/,$p' $dir/get-$chunk.out > $dir/body-$chunk.out
+
+    if [ $RC -ne 0 ]; then
+        new "Kill restconf daemon"
+        stop_restconf
+    fi
+
+    if [ $BE -ne 0 ]; then
+        new "Kill backend"
+        # Check if premature kill
+        pid=$(pgrep -u root -f clixon_backend)
+        if [ -z "$pid" ]; then
+            err "backend already dead"
+        fi
+        stop_backend -f $cfg
+    fi
+}
+
+testrun 0
+testrun 1024
+
+new "Check streamed body is equal to whole body"
+if ! cmp -s $dir/body-0.out $dir/body-1024.out; then
+    err "$(head -c 200 $dir/body-0.out)" "$(head -c 200 $dir/body-1024.out)"
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
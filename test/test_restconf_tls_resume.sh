@@ -0,0 +1,145 @@
+#!/usr/bin/env bash
+# TLS session resumption in native restconf
+# CLICON_RESTCONF_TLS_SESSION_CACHE and CLICON_RESTCONF_TLS_TICKETS
+# Reconnect with a saved TLS session and check whether the handshake is resumed, with
+# session cache, with tickets over several workers, and with neither
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Skip if other than native
+if [ "${WITH_RESTCONF}" != "native" ]; then
+    rm -rf $dir
+    if [ "$s" = $0 ]; then exit 0; else return 0; fi # skip
+fi
+
+# Skip if no openssl client
+if [ -z "$(type -p openssl)" ]; then
+    echo "...skipped: openssl not found"
+    rm -rf $dir
+    if [ "$s" = $0 ]; then exit 0; else return 0; fi
+fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/restconf.yang
+fsess=$dir/tls-session.pem
+
+# Always https
+RESTCONFIG=$(restconf_config none false https)
+if [ $? -ne 0 ]; then
+    err1 "Error when generating certs"
+fi
+
+cat <<EOF > $fyang
+module example{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   leaf x{
+      type string;
+   }
+}
+EOF
+
+# Connect and print session status of handshake, "New" or "Reused"
+# 1: s_client session option, -sess_out or -sess_in
+function tlsconnect() {
+    echo | openssl s_client -tls1_2 -connect localhost:443 $1 $fsess 2>/dev/null | sed -n 's/^\(New\|Reused\), .*/\1/p'
+}
+
+# 1: CLICON_RESTCONF_TLS_SESSION_CACHE
+# 2: CLICON_RESTCONF_TLS_TICKETS
+# 3: CLICON_RESTCONF_WORKERS
+# 4: expected status of reconnects: New or Reused
+function testrun() {
+    cache=$1
+    tickets=$2
+    workers=$3
+    expect=$4
+
+    cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_FEATURE>clixon-restconf:allow-auth-none</CLICON_FEATURE> <!-- Use auth-type=none -->
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>$dir/restconf.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_RESTCONF_TLS_SESSION_CACHE>$cache</CLICON_RESTCONF_TLS_SESSION_CACHE>
+  <CLICON_RESTCONF_TLS_TICKETS>$tickets</CLICON_RESTCONF_TLS_TICKETS>
+  <CLICON_RESTCONF_WORKERS>$workers</CLICON_RESTCONF_WORKERS>
+  $RESTCONFIG
+</clixon-config>
+EOF
+
+    new "test params: -f $cfg cache:$cache tickets:$tickets workers:$workers"
+    if [ $BE -ne 0 ]; then
+        new "kill old backend"
+        sudo clixon_backend -zf $cfg
+        if [ $? -ne 0 ]; then
+            err
+        fi
+        new "start backend -s init -f $cfg"
+        start_backend -s init -f $cfg
+    fi
+
+    new "wait backend"
+    wait_backend
+
+    if [ $RC -ne 0 ]; then
+        new "kill old restconf daemon"
+        stop_restconf_pre
+
+        new "start restconf daemon"
+        start_restconf -f $cfg
+    fi
+
+    new "wait restconf"
+    wait_restconf
+
+    new "cache:$cache tickets:$tickets: first connect makes new session"
+    rm -f $fsess
+    ret=$(tlsconnect -sess_out)
+    if [ "$ret" != New ]; then
+        err "New" "$ret"
+    fi
+
+    for i in 1 2 3 4; do
+        new "cache:$cache tickets:$tickets: reconnect $i is $expect"
+        ret=$(tlsconnect -sess_in)
+        if [ "$ret" != $expect ]; then
+            err "$expect" "$ret"
+        fi
+    done
+
+    new "restconf GET"
+    expectpart "$(curl $CURLOPTS -X GET https://localhost/restconf/data/example:x)" 0 "HTTP/$HVER 404"
+
+    if [ $RC -ne 0 ]; then
+        new "Kill restconf daemon"
+        stop_restconf
+    fi
+
+    if [ $BE -ne 0 ]; then
+        new "Kill backend"
+        # Check if premature kill
+        pid=$(pgrep -u root -f clixon_backend)
+        if [ -z "$pid" ]; then
+            err "backend already dead"
+        fi
+        stop_backend -f $cfg
+    fi
+}
+
+testrun 0 false 0 New
+testrun 128 false 0 Reused
+testrun 0 true 0 Reused
+testrun 0 true 3 Reused
+
+rm -rf $dir
+
+new "endtest"
+endtest
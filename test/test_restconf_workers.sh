@@ -0,0 +1,157 @@
+#!/usr/bin/env bash
+# Native restconf with worker processes, CLICON_RESTCONF_WORKERS
+# Check parallel requests, that an exited worker is restarted, and that workers are
+# terminated with the restconf process
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Skip if other than native
+if [ "${WITH_RESTCONF}" != "native" ]; then
+    rm -rf $dir
+    if [ "$s" = $0 ]; then exit 0; else return 0; fi # skip
+fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/restconf.yang
+
+# Define default restconfig config: RESTCONFIG
+RESTCONFIG=$(restconf_config none false)
+if [ $? -ne 0 ]; then
+    err1 "Error when generating certs"
+fi
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_FEATURE>clixon-restconf:allow-auth-none</CLICON_FEATURE> <!-- Use auth-type=none -->
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>$dir/restconf.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_RESTCONF_WORKERS>3</CLICON_RESTCONF_WORKERS>
+  $RESTCONFIG
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module example{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container table{
+      list parameter{
+         key name;
+         leaf name{
+            type string;
+         }
+         leaf value{
+            type string;
+         }
+      }
+   }
+}
+EOF
+
+# Print pids of restconf worker processes, ie whose parent is also clixon_restconf
+function workers()
+{
+    for p in $(pgrep -x clixon_restconf); do
+        pp=$(ps -o ppid= -p $p | tr -d ' ')
+        if [ "$(ps -o comm= -p $pp)" = clixon_restconf ]; then
+            echo $p
+        fi
+    done
+}
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    sudo pkill -f clixon_backend # to be sure
+
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+if [ $RC -ne 0 ]; then
+    new "kill old restconf daemon"
+    stop_restconf_pre
+
+    new "start restconf daemon"
+    start_restconf -f $cfg
+fi
+
+new "wait restconf"
+wait_restconf
+
+new "restconf POST"
+expectpart "$(curl $CURLOPTS -X POST -H "Content-Type: application/yang-data+json" -d '{"example:parameter":[{"name":"A","value":"42"}]}' $RCPROTO://localhost/restconf/data/example:table)" 0 "HTTP/$HVER 201"
+
+new "parallel restconf GET"
+for i in 1 2 3 4 5 6 7 8; do
+    curl $CURLOPTS -X GET $RCPROTO://localhost/restconf/data/example:table/parameter=A > $dir/get$i.out 2>&1 &
+done
+wait
+for i in 1 2 3 4 5 6 7 8; do
+    new "parallel restconf GET $i"
+    expectpart "$(cat $dir/get$i.out)" 0 "HTTP/$HVER 200" '{"example:parameter":\[{"name":"A","value":"42"}\]}'
+done
+
+if [ $RC -ne 0 ]; then
+    new "Check number of workers"
+    ret=$(workers | wc -l)
+    if [ $ret -ne 3 ]; then
+        err "3" "$ret"
+    fi
+
+    new "Kill one worker"
+    sudo kill $(workers | head -1)
+    sleep 2
+
+    new "Check worker is restarted"
+    ret=$(workers | wc -l)
+    if [ $ret -ne 3 ]; then
+        err "3" "$ret"
+    fi
+fi
+
+new "restconf GET after worker restart"
+expectpart "$(curl $CURLOPTS -X GET $RCPROTO://localhost/restconf/data/example:table/parameter=A)" 0 "HTTP/$HVER 200" '{"example:parameter":\[{"name":"A","value":"42"}\]}'
+
+if [ $RC -ne 0 ]; then
+    new "Kill restconf daemon"
+    stop_restconf
+
+    new "Check workers are terminated"
+    sleep 1
+    if [ -n "$(pgrep -x clixon_restconf)" ]; then
+        err "no clixon_restconf" "$(pgrep -x clixon_restconf)"
+    fi
+fi
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -213,7 +213,34 @@ REQ='{
   }
 }'
 new "RFC 8072 YANG Patch JSON: Error."
-expectpart "$(curl -u andy:bar $CURLOPTS -X PATCH -H 'Content-Type: application/yang-patch+json' -H 'Accept: application/yang-patch+json' $RCPROTO://localhost/restconf/data/ietf-interfaces:interfaces -d "$REQ")" 0 "HTTP/$HVER 204"
+expectpart "$(curl -u andy:bar $CURLOPTS -X PATCH -H 'Content-Type: application/yang-patch+json' -H 'Accept: application/yang-patch+json' $RCPROTO://localhost/restconf/data/ietf-interfaces:interfaces -d "$REQ")" 0 "HTTP/$HVER 200" '{"ietf-yang-patch:yang-patch-status":{"patch-id":"alan-test-patch","ok":\[null\]}}'
+
+new "RFC 8072 YANG Patch JSON: all edits applied in order"
+expectpart "$(curl -u andy:bar $CURLOPTS -X GET $RCPROTO://localhost/restconf/data/ietf-interfaces:interfaces?content=config)" 0 "HTTP/$HVER 200" '{"name":"eth2","type":"iana-if-type:atm","enabled":true}' '{"name":"eth4","type":"iana-if-type:atm","enabled":false}' --not-- '"eth1"'
+
+# Second edit fails, no edit is applied
+REQ='{
+  "ietf-yang-patch:yang-patch": {
+    "patch-id": "alan-test-patch-fail",
+    "edit": [
+      {
+        "edit-id": "edit-1",
+        "operation": "delete",
+        "target": "/interface=eth4"
+      },
+      {
+        "edit-id": "edit-2",
+        "operation": "delete",
+        "target": "/interface=eth9"
+      }
+    ]
+  }
+}'
+new "RFC 8072 YANG Patch JSON: per-edit error"
+expectpart "$(curl -u andy:bar $CURLOPTS -X PATCH -H 'Content-Type: application/yang-patch+json' -H 'Accept: application/yang-patch+json' $RCPROTO://localhost/restconf/data/ietf-interfaces:interfaces -d "$REQ")" 0 "HTTP/$HVER 409" '{"ietf-yang-patch:yang-patch-status":{"patch-id":"alan-test-patch-fail","edit-status":{"edit":\[{"edit-id":"edit-2","errors":' 'data-missing'
+
+new "RFC 8072 YANG Patch JSON: failed patch not applied"
+expectpart "$(curl -u andy:bar $CURLOPTS -X GET $RCPROTO://localhost/restconf/data/ietf-interfaces:interfaces?content=config)" 0 "HTTP/$HVER 200" '"eth4"'
 #
 # Create artist in jukebox example
 REQ='{"example-jukebox:artist":[{"name":"Foo Fighters"}]}'
@@ -308,7 +335,31 @@ REQ='{
   }
 }'
 new "RFC 8072 YANG Patch JSON jukebox example: Error."
-expectpart "$(curl -u andy:bar $CURLOPTS -X PATCH -H 'Content-Type: application/yang-patch+json' -H 'Accept: application/yang-patch+json' $RCPROTO://localhost/restconf/data/example-jukebox:jukebox/playlist=Foo-One -d "$REQ")" 0 "HTTP/$HVER 201"
+expectpart "$(curl -u andy:bar $CURLOPTS -X PATCH -H 'Content-Type: application/yang-patch+json' -H 'Accept: application/yang-patch+json' $RCPROTO://localhost/restconf/data/example-jukebox:jukebox/playlist=Foo-One -d "$REQ")" 0 "HTTP/$HVER 200" '"ok":\[null\]'
+
+new "RFC 8072 YANG Patch JSON jukebox example: insert order"
+expectpart "$(curl -u andy:bar $CURLOPTS -X GET $RCPROTO://localhost/restconf/data/example-jukebox:jukebox/playlist=Foo-One?content=config)" 0 "HTTP/$HVER 200" '"index":1,.*"index":5,.*"index":2,.*"index":6,.*"index":24,.*"index":4,.*"index":3,'
+
+# Move song 4 first
+REQ='{
+  "ietf-yang-patch:yang-patch": {
+    "patch-id": "alan-test-patch-move",
+    "edit": [
+      {
+        "edit-id": "edit-1",
+        "operation": "move",
+        "target": "/song=4",
+        "where" : "first"
+      }
+    ]
+  }
+}'
+new "RFC 8072 YANG Patch JSON jukebox move"
+expectpart "$(curl -u andy:bar $CURLOPTS -X PATCH -H 'Content-Type: application/yang-patch+json' -H 'Accept: application/yang-patch+json' $RCPROTO://localhost/restconf/data/example-jukebox:jukebox/playlist=Foo-One -d "$REQ")" 0 "HTTP/$HVER 200" '"ok":\[null\]'
+
+new "RFC 8072 YANG Patch JSON jukebox example: move order"
+expectpart "$(curl -u andy:bar $CURLOPTS -X GET $RCPROTO://localhost/restconf/data/example-jukebox:jukebox/playlist=Foo-One?content=config)" 0 "HTTP/$HVER 200" '"song":\[{"index":4,'
+
 
 # Uncomment to get info about playlist in jukebox example
 #new "RFC 8072 YANG Patch jukebox example get : Error."
@@ -0,0 +1,119 @@
+#!/usr/bin/env bash
+# Edit-scoped direct commit to running, see CLICON_XMLDB_RUNNING_DIRECT_SPARSE
+# Only the paths of the edit are diffed. Entries are validated against the rest of
+# running, running is restored if validation fails, and an autocommit edit of candidate
+# is committed directly
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/test.yang
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_RUNNING_DIRECT>true</CLICON_XMLDB_RUNNING_DIRECT>
+  <CLICON_XMLDB_RUNNING_DIRECT_SPARSE>true</CLICON_XMLDB_RUNNING_DIRECT_SPARSE>
+  <CLICON_VALIDATE_INCREMENTAL>true</CLICON_VALIDATE_INCREMENTAL>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module $APPNAME{
+  yang-version 1.1;
+  namespace "urn:example:clixon";
+  prefix ex;
+  container a {
+     list y {
+        key name;
+        leaf name { type string; }
+        leaf v {
+           type uint32;
+           must "not(. > 10)" { error-message "v too large"; }
+        }
+     }
+  }
+  container b {
+     leaf r {
+        type leafref { path "/ex:a/ex:y/ex:name"; }
+     }
+  }
+}
+EOF
+
+# Edit running
+# 1: children of a
+function edita(){
+    echo "<rpc $DEFAULTNS><edit-config><target><running/></target><config><a xmlns=\"urn:example:clixon\" xmlns:nc=\"${BASENS}\">$1</a></config></edit-config></rpc>"
+}
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "Add entries"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "$(edita "<y><name>bar</name><v>1</v></y><y><name>foo</name><v>1</v></y>")" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "Edit running b with leafref to entry"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><running/></target><config><b xmlns=\"urn:example:clixon\"><r>foo</r></b></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "Change one entry"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "$(edita "<y><name>bar</name><v>2</v></y>")" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "Change one entry invalid must"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "$(edita "<y><name>bar</name><v>99</v></y>")" "" "<error-message>v too large</error-message>"
+
+new "Delete entry referred to by leafref"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "$(edita "<y nc:operation=\"delete\"><name>foo</name></y>")" "" "<error-tag>data-missing</error-tag><error-app-tag>instance-required</error-app-tag>"
+
+new "Running is restored"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><a xmlns=\"urn:example:clixon\"><y><name>bar</name><v>2</v></y><y><name>foo</name><v>1</v></y></a><b xmlns=\"urn:example:clixon\"><r>foo</r></b></data></rpc-reply>"
+
+new "Autocommit edit of candidate"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config cl:autocommit=\"true\" xmlns:cl=\"http://clicon.org/lib\"><target><candidate/></target><config><a xmlns=\"urn:example:clixon\"><y><name>bar</name><v>3</v></y></a></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "Running has autocommit edit"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:a/ex:y[ex:name='bar']\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><a xmlns=\"urn:example:clixon\"><y><name>bar</name><v>3</v></y></a></data></rpc-reply>"
+
+new "Candidate has autocommit edit"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><candidate/></source><filter type=\"xpath\" select=\"/ex:a/ex:y[ex:name='bar']\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><a xmlns=\"urn:example:clixon\"><y><name>bar</name><v>3</v></y></a></data></rpc-reply>"
+
+new "Delete one entry"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "$(edita "<y nc:operation=\"delete\"><name>bar</name></y>")" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "Running after delete"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><a xmlns=\"urn:example:clixon\"><y><name>foo</name><v>1</v></y></a><b xmlns=\"urn:example:clixon\"><r>foo</r></b></data></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,158 @@
+#!/usr/bin/env bash
+# SNMP table snapshots, CLICON_SNMP_TABLE_CACHE_TTL
+# Walk and bulk get a table, change the state of the backend, and check that the change
+# is seen at once without a TTL, and only when the snapshot has expired with a TTL
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Re-use main example backend state callbacks
+APPNAME=example
+
+if [ ${ENABLE_NETSNMP} != "yes" ]; then
+    echo "Skipping test, Net-SNMP support not enabled."
+    rm -rf $dir
+    if [ "$s" = $0 ]; then exit 0; else return 0; fi
+fi
+
+cfg=$dir/conf_startup.xml
+fyang=$dir/clixon-example.yang
+fstate=$dir/state.xml
+
+# AgentX unix socket
+SOCK=/var/run/snmp.sock
+
+MIB=".1.3.6.1.4.1.8072.200"
+OID15="${MIB}.2.1"          # netSnmpIETFWGTable
+OID18="${MIB}.2.1.1.2.42"   # nsIETFWGChair1 of row 42
+
+cat <<EOF > $fyang
+module clixon-example{
+  yang-version 1.1;
+  namespace "urn:example:clixon";
+  prefix ex;
+  import CLIXON-TYPES-MIB {
+      prefix "clixon-types";
+  }
+}
+EOF
+
+# Write state of table with two rows, that the backend reads on each request
+# 1: chair of row 42
+function state() {
+    cat <<EOF > $fstate
+<CLIXON-TYPES-MIB xmlns="urn:ietf:params:xml:ns:yang:smiv2:CLIXON-TYPES-MIB">
+  <clixonIETFWGTable>
+    <clixonIETFWGEntry>
+      <nsIETFWGName>42</nsIETFWGName>
+      <nsIETFWGChair1>$1</nsIETFWGChair1>
+      <nsIETFWGChair2>Chair2a</nsIETFWGChair2>
+    </clixonIETFWGEntry>
+    <clixonIETFWGEntry>
+      <nsIETFWGName>43</nsIETFWGName>
+      <nsIETFWGChair1>Chair1b</nsIETFWGChair1>
+      <nsIETFWGChair2>Chair2b</nsIETFWGChair2>
+    </clixonIETFWGEntry>
+  </clixonIETFWGTable>
+</CLIXON-TYPES-MIB>
+EOF
+}
+
+# 1: CLICON_SNMP_TABLE_CACHE_TTL in milliseconds
+function testrun() {
+    ttl=$1
+
+    cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>${YANG_STANDARD_DIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>${MIB_GENERATED_YANG_DIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>$dir/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_SNMP_AGENT_SOCK>unix:$SOCK</CLICON_SNMP_AGENT_SOCK>
+  <CLICON_SNMP_MIB>CLIXON-TYPES-MIB</CLICON_SNMP_MIB>
+  <CLICON_SNMP_TABLE_CACHE_TTL>$ttl</CLICON_SNMP_TABLE_CACHE_TTL>
+</clixon-config>
+EOF
+
+    state Chair1a
+
+    new "test params: -s init -f $cfg -- -sS $fstate"
+    if [ $BE -ne 0 ]; then
+        new "kill old backend"
+        sudo clixon_backend -zf $cfg
+        if [ $? -ne 0 ]; then
+            err "Failed to start backend"
+        fi
+
+        sudo pkill -f clixon_backend
+
+        new "Starting backend"
+        start_backend -s init -f $cfg -- -sS $fstate
+    fi
+
+    new "wait backend"
+    wait_backend
+
+    if [ $SN -ne 0 ]; then
+        new "Terminating any old clixon_snmp processes"
+        sudo killall -q clixon_snmp
+
+        new "Starting clixon_snmp"
+        start_snmp $cfg
+    fi
+
+    new "wait snmp"
+    wait_snmp
+
+    new "ttl $ttl: walk table"
+    expectpart "$($snmpwalk $OID15)" 0 "Chair1a" "Chair2a" "Chair1b" "Chair2b"
+
+    new "ttl $ttl: bulk get table"
+    expectpart "$($snmpbulkget $OID15)" 0 "Chair1a" "Chair2a" "Chair1b" "Chair2b"
+
+    new "ttl $ttl: get column of row"
+    expectpart "$($snmpget $OID18)" 0 "$OID18 = STRING: \"Chair1a\""
+
+    # Change made by other client than clixon_snmp
+    state Chair1c
+
+    if [ $ttl -eq 0 ]; then
+        new "ttl $ttl: walk sees change at once"
+        expectpart "$($snmpwalk $OID15)" 0 "Chair1c" "Chair1b" --not-- "Chair1a"
+    else
+        new "ttl $ttl: walk within ttl sees snapshot"
+        expectpart "$($snmpwalk $OID15)" 0 "Chair1a" "Chair1b" --not-- "Chair1c"
+
+        sleep $((ttl / 1000 + 1))
+
+        new "ttl $ttl: walk after ttl sees change"
+        expectpart "$($snmpwalk $OID15)" 0 "Chair1c" "Chair1b" --not-- "Chair1a"
+    fi
+
+    new "ttl $ttl: get column of changed row"
+    expectpart "$($snmpget $OID18)" 0 "$OID18 = STRING: \"Chair1c\""
+
+    stop_snmp
+    if [ $BE -ne 0 ]; then
+        new "Kill backend"
+        # Check if premature kill
+        pid=$(pgrep -u root -f clixon_backend)
+        if [ -z "$pid" ]; then
+            err "backend already dead"
+        fi
+        stop_backend -f $cfg
+    fi
+}
+
+testrun 0
+testrun 3000
+
+rm -rf $dir
+
+new "endtest"
+endtest
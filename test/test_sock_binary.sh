@@ -0,0 +1,156 @@
+#!/usr/bin/env bash
+# Binary encoding of replies on the backend socket, CLICON_SOCK_BINARY
+# Edit and read config with cli and restconf with and without binary encoding, and check
+# that the results are equal
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/clixon-example.yang
+fclispec=$dir/clispec.cli
+
+# Define default restconfig config: RESTCONFIG
+RESTCONFIG=$(restconf_config none false)
+if [ $? -ne 0 ]; then
+    err1 "Error when generating certs"
+fi
+
+cat <<EOF > $fyang
+module clixon-example{
+    yang-version 1.1;
+    namespace "urn:example:clixon";
+    prefix ex;
+    container table{
+        list parameter{
+            key name;
+            leaf name{
+                type string;
+            }
+            leaf value{
+                type uint32;
+            }
+            leaf-list tag{
+                type string;
+            }
+        }
+    }
+}
+EOF
+
+cat <<EOF > $fclispec
+CLICON_MODE="example";
+CLICON_PROMPT="%U@%H %w> ";
+CLICON_PLUGIN="example_cli";
+
+# Autocli syntax tree operations
+set @datamodel, cli_auto_set();
+delete("Delete a configuration item") @datamodel, cli_auto_del();
+commit("Commit the changes"), cli_commit();
+show("Show a particular state of the system"){
+    configuration("Show configuration"), cli_show_auto_mode("candidate", "xml", false, false);
+    running("Show running"), cli_show_auto_mode("running", "xml", false, false);
+}
+quit("Quit"), cli_quit();
+EOF
+
+# 1: CLICON_SOCK_BINARY
+function testrun() {
+    binary=$1
+
+    cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_FEATURE>clixon-restconf:allow-auth-none</CLICON_FEATURE> <!-- Use auth-type=none -->
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_CLI_MODE>$APPNAME</CLICON_CLI_MODE>
+  <CLICON_CLI_DIR>/usr/local/lib/$APPNAME/cli</CLICON_CLI_DIR>
+  <CLICON_CLISPEC_DIR>$dir</CLICON_CLISPEC_DIR>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_SOCK_BINARY>$binary</CLICON_SOCK_BINARY>
+  $RESTCONFIG
+</clixon-config>
+EOF
+
+    new "test params: -f $cfg"
+    if [ $BE -ne 0 ]; then
+        new "kill old backend"
+        sudo clixon_backend -zf $cfg
+        if [ $? -ne 0 ]; then
+            err
+        fi
+        new "start backend -s init -f $cfg"
+        start_backend -s init -f $cfg
+    fi
+
+    new "wait backend"
+    wait_backend
+
+    if [ $RC -ne 0 ]; then
+        new "kill old restconf daemon"
+        stop_restconf_pre
+
+        new "start restconf daemon"
+        start_restconf -f $cfg
+    fi
+
+    new "wait restconf"
+    wait_restconf
+
+    new "binary $binary: cli set parameter a"
+    expectpart "$($clixon_cli -1 -f $cfg set table parameter a value 42)" 0 "^$"
+
+    new "binary $binary: cli set parameter a tag"
+    expectpart "$($clixon_cli -1 -f $cfg set table parameter a tag x)" 0 "^$"
+
+    new "binary $binary: cli commit"
+    expectpart "$($clixon_cli -1 -f $cfg commit)" 0 "^$"
+
+    new "binary $binary: restconf POST parameter b"
+    expectpart "$(curl $CURLOPTS -X POST -H "Content-Type: application/yang-data+json" -d '{"clixon-example:parameter":[{"name":"b","value":17,"tag":["y","z"]}]}' $RCPROTO://localhost/restconf/data/clixon-example:table)" 0 "HTTP/$HVER 201"
+
+    new "binary $binary: restconf POST invalid value"
+    expectpart "$(curl $CURLOPTS -X POST -H "Content-Type: application/yang-data+json" -d '{"clixon-example:parameter":[{"name":"c","value":"notanumber"}]}' $RCPROTO://localhost/restconf/data/clixon-example:table)" 0 "HTTP/$HVER 400" "invalid-value"
+
+    new "binary $binary: cli show running"
+    expectpart "$($clixon_cli -1 -f $cfg show running)" 0 "^<table xmlns=\"urn:example:clixon\"><parameter><name>a</name><value>42</value><tag>x</tag></parameter><parameter><name>b</name><value>17</value><tag>y</tag><tag>z</tag></parameter></table>$"
+
+    new "binary $binary: restconf GET"
+    expectpart "$(curl $CURLOPTS -X GET $RCPROTO://localhost/restconf/data/clixon-example:table)" 0 "HTTP/$HVER 200" '{"clixon-example:table":{"parameter":\[{"name":"a","value":42,"tag":\["x"\]},{"name":"b","value":17,"tag":\["y","z"\]}\]}}'
+
+    new "binary $binary: restconf GET with-defaults report-all-tagged"
+    expectpart "$(curl $CURLOPTS -X GET $RCPROTO://localhost/restconf/data/clixon-example:table/parameter=b?with-defaults=report-all-tagged)" 0 "HTTP/$HVER 200" '{"clixon-example:parameter":\[{"name":"b","value":17,"tag":\["y","z"\]}\]}'
+
+    new "binary $binary: netconf get-config"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>a</name><value>42</value><tag>x</tag></parameter><parameter><name>b</name><value>17</value><tag>y</tag><tag>z</tag></parameter></table></data></rpc-reply>"
+
+    if [ $RC -ne 0 ]; then
+        new "Kill restconf daemon"
+        stop_restconf
+    fi
+
+    if [ $BE -ne 0 ]; then
+        new "Kill backend"
+        # Check if premature kill
+        pid=$(pgrep -u root -f clixon_backend)
+        if [ -z "$pid" ]; then
+            err "backend already dead"
+        fi
+        stop_backend -f $cfg
+    fi
+}
+
+for binary in false true; do
+    testrun $binary
+done
+
+rm -rf $dir
+
+new "endtest"
+endtest
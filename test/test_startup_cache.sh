@@ -0,0 +1,184 @@
+#!/usr/bin/env bash
+# Cache of parsed startup input files, CLICON_STARTUP_CACHE_DIR
+# Start the backend with an extra XML file and an external NACM file, restart and check
+# that the cached trees are used, and that a changed extra XML file is parsed again
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+# Common NACM scripts
+. ./nacm.sh
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/clixon-example.yang
+nacmfile=$dir/nacmfile
+fextra=$dir/extra.xml
+cachedir=$dir/cache
+flog=$dir/backend.log
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_NACM_MODE>external</CLICON_NACM_MODE>
+  <CLICON_NACM_FILE>$nacmfile</CLICON_NACM_FILE>
+  <CLICON_NACM_CREDENTIALS>none</CLICON_NACM_CREDENTIALS>
+  <CLICON_STARTUP_CACHE_DIR>$cachedir</CLICON_STARTUP_CACHE_DIR>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module clixon-example{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container table{
+      list parameter{
+         key name;
+         leaf name{
+            type string;
+         }
+         leaf value{
+            type string;
+         }
+      }
+   }
+}
+EOF
+
+# Write is only permitted for the admin group
+cat <<EOF > $nacmfile
+   <nacm xmlns="urn:ietf:params:xml:ns:yang:ietf-netconf-acm">
+     <enable-nacm>true</enable-nacm>
+     <read-default>permit</read-default>
+     <write-default>deny</write-default>
+     <exec-default>permit</exec-default>
+     $NGROUPS
+     $NADMIN
+   </nacm>
+EOF
+
+# Write extra XML file
+# 1: value of parameter
+function extra() {
+    cat <<EOF > $fextra
+<config>
+   <table xmlns="urn:example:clixon">
+      <parameter>
+         <name>extra</name>
+         <value>$1</value>
+      </parameter>
+   </table>
+</config>
+EOF
+}
+
+function start() {
+    if [ $BE -ne 0 ]; then
+        new "kill old backend"
+        sudo clixon_backend -zf $cfg
+        if [ $? -ne 0 ]; then
+            err
+        fi
+        sudo rm -f $flog
+        new "start backend -s init -f $cfg -c $fextra -D backend -lf$flog"
+        start_backend -s init -f $cfg -c $fextra -D backend -lf$flog
+    fi
+
+    new "wait backend"
+    wait_backend
+}
+
+function stop() {
+    if [ $BE -ne 0 ]; then
+        new "Kill backend"
+        # Check if premature kill
+        pid=$(pgrep -u root -f clixon_backend)
+        if [ -z "$pid" ]; then
+            err "backend already dead"
+        fi
+        stop_backend -f $cfg
+    fi
+}
+
+# Check running and NACM of external file
+# 1: value of extra parameter
+function check() {
+    new "Check extra XML in running"
+    expecteof_netconf "$clixon_netconf -qf $cfg -U andy" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>extra</name><value>$1</value></parameter></table></data></rpc-reply>"
+
+    new "Check external NACM denies write of limited user"
+    expecteof_netconf "$clixon_netconf -qf $cfg -U wilma" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><table xmlns=\"urn:example:clixon\"><parameter><name>x</name></parameter></table></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>access-denied</error-tag>"
+
+    new "Check external NACM permits write of admin"
+    expecteof_netconf "$clixon_netconf -qf $cfg -U andy" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><table xmlns=\"urn:example:clixon\"><parameter><name>x</name></parameter></table></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+}
+
+new "test params: -f $cfg -c $fextra"
+
+sudo rm -rf $cachedir
+mkdir $cachedir
+extra 1
+
+start
+check 1
+stop
+
+new "Check cache files are written"
+for f in extraxml.bin extraxml.bin.digest nacm.bin nacm.bin.digest; do
+    if ! sudo test -s $cachedir/$f; then
+        err "$cachedir/$f" "none"
+    fi
+done
+
+if [ $BE -ne 0 ]; then
+    new "Check first start validates extra XML"
+    expectpart "$(sudo cat $flog)" 0 --not-- "Extra XML unchanged, skip validation"
+fi
+
+md5=$(sudo md5sum $cachedir/extraxml.bin.digest)
+mtime_extraxml=$(sudo stat -c %Y $cachedir/extraxml.bin)
+mtime_nacm=$(sudo stat -c %Y $cachedir/nacm.bin)
+sleep 1 # Different modification time if written
+
+start
+check 1
+stop
+
+if [ $BE -ne 0 ]; then
+    new "Check restart uses cached extra XML"
+    expectpart "$(sudo cat $flog)" 0 "Extra XML unchanged, skip validation"
+fi
+
+new "Check cache files are not written on restart"
+if [ "$(sudo stat -c %Y $cachedir/extraxml.bin)" != $mtime_extraxml -o "$(sudo stat -c %Y $cachedir/nacm.bin)" != $mtime_nacm ]; then
+    err "unchanged cache files" "written"
+fi
+
+new "change extra XML file"
+extra 2
+
+start
+check 2
+stop
+
+if [ $BE -ne 0 ]; then
+    new "Check changed extra XML is validated"
+    expectpart "$(sudo cat $flog)" 0 --not-- "Extra XML unchanged, skip validation"
+fi
+
+new "Check digest of changed extra XML"
+if [ "$(sudo md5sum $cachedir/extraxml.bin.digest)" = "$md5" ]; then
+    err "new digest" "$md5"
+fi
+
+sudo rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,106 @@
+#!/usr/bin/env bash
+# Validated startup snapshot, see CLICON_STARTUP_SNAPSHOT
+# Start the backend in startup mode, restart it with an unchanged startup db and check the
+# same snapshot is used, then change startup and check a new snapshot is written
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/test.yang
+snapshot=$dir/startup.snapshot
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_FEATURE>ietf-netconf:startup</CLICON_FEATURE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_STARTUP_SNAPSHOT>$snapshot</CLICON_STARTUP_SNAPSHOT>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module $APPNAME{
+  yang-version 1.1;
+  namespace "urn:example:clixon";
+  prefix ex;
+  container a {
+     leaf x { type uint32; }
+     leaf y { type uint32; default 7; }
+  }
+}
+EOF
+
+# Start backend in startup mode and check running
+# 1: value of x in startup and running
+function testrun(){
+    val=$1
+
+    if [ $BE -ne 0 ]; then
+        new "kill old backend"
+        sudo clixon_backend -zf $cfg
+        if [ $? -ne 0 ]; then
+            err
+        fi
+        new "start backend -s startup -f $cfg"
+        start_backend -s startup -f $cfg
+    fi
+
+    new "wait backend"
+    wait_backend
+
+    new "get-config running x=$val"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><a xmlns=\"urn:example:clixon\"><x>$val</x></a></data></rpc-reply>"
+
+    if [ $BE -ne 0 ]; then
+        new "Kill backend"
+        # Check if premature kill
+        pid=$(pgrep -u root -f clixon_backend)
+        if [ -z "$pid" ]; then
+            err "backend already dead"
+        fi
+        stop_backend -f $cfg
+    fi
+}
+
+sudo rm -f $snapshot $snapshot.digest
+echo "<${DATASTORE_TOP}><a xmlns=\"urn:example:clixon\"><x>1</x></a></${DATASTORE_TOP}>" > $dir/startup_db
+
+testrun 1
+
+new "snapshot and digest written"
+if [ ! -s $snapshot -o ! -s $snapshot.digest ]; then
+    err "$snapshot and $snapshot.digest" "not found"
+fi
+digest1=$(cat $snapshot.digest)
+
+new "restart with unchanged startup"
+testrun 1
+
+new "snapshot digest unchanged"
+digest2=$(cat $snapshot.digest)
+if [ "$digest1" != "$digest2" ]; then
+    err "$digest1" "$digest2"
+fi
+
+echo "<${DATASTORE_TOP}><a xmlns=\"urn:example:clixon\"><x>2</x></a></${DATASTORE_TOP}>" > $dir/startup_db
+
+new "restart with changed startup"
+testrun 2
+
+new "snapshot digest changed"
+digest3=$(cat $snapshot.digest)
+if [ "$digest1" = "$digest3" ]; then
+    err "digest changed" "$digest3"
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
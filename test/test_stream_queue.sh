@@ -0,0 +1,127 @@
+#!/usr/bin/env bash
+# Notification queues of slow clients, CLICON_STREAM_QUEUE_MAX and CLICON_STREAM_QUEUE_POLICY
+# A client subscribes to large periodic push-updates and does not read them.
+# Check that the backend does not block on the client, and that notifications are
+# dropped, or the client disconnected, when the queue of the client exceeds its max size
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/clixon-example.yang
+
+: ${perfnr:=1000}
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_NETCONF_MONITORING>true</CLICON_NETCONF_MONITORING>
+  <CLICON_STREAM_YANG_PUSH>true</CLICON_STREAM_YANG_PUSH>
+  <CLICON_STREAM_QUEUE_MAX>200000</CLICON_STREAM_QUEUE_MAX>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module clixon-example{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container table{
+      list parameter{
+         key name;
+         leaf name{
+            type uint32;
+         }
+         leaf value{
+            type string;
+         }
+      }
+   }
+}
+EOF
+
+new "generate $perfnr list entries"
+echo -n "<table xmlns=\"urn:example:clixon\">" > $dir/config.xml
+for (( i=0; i<$perfnr; i++ )); do
+    echo -n "<parameter><name>$i</name><value>value of entry $i</value></parameter>" >> $dir/config.xml
+done
+echo -n "</table>" >> $dir/config.xml
+
+# Print number of backend sessions
+function nrsessions() {
+    echo "$HELLONO11<rpc $DEFAULTNS><get><filter type=\"subtree\"><netconf-state xmlns=\"urn:ietf:params:xml:ns:yang:ietf-netconf-monitoring\"><sessions/></netconf-state></filter></get></rpc>]]>]]>" | $clixon_netconf -qf $cfg | grep -o "<session>" | wc -l
+}
+
+# 1: CLICON_STREAM_QUEUE_POLICY
+function testrun() {
+    policy=$1
+
+    new "test params: -f $cfg -o CLICON_STREAM_QUEUE_POLICY=$policy"
+    if [ $BE -ne 0 ]; then
+        new "kill old backend"
+        sudo clixon_backend -zf $cfg
+        if [ $? -ne 0 ]; then
+            err
+        fi
+        new "start backend -s init -f $cfg -o CLICON_STREAM_QUEUE_POLICY=$policy"
+        start_backend -s init -f $cfg -o CLICON_STREAM_QUEUE_POLICY=$policy
+    fi
+
+    new "wait backend"
+    wait_backend
+
+    new "edit large config"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config>$(cat $dir/config.xml)</config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    new "commit"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    new "$policy: slow client subscribes to periodic push of running and does not read"
+    (echo "$HELLONO11<rpc $DEFAULTNS><establish-push xmlns=\"http://clicon.org/lib\"><period>10</period></establish-push></rpc>]]>]]>"; sleep 10) | $clixon_netconf -qf $cfg | sleep 10 &
+    slowpid=$!
+    sleep 5
+
+    new "$policy: backend is not blocked by slow client"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:table/ex:parameter[ex:name='17']\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>17</name><value>value of entry 17</value></parameter></table></data></rpc-reply>"
+
+    new "$policy: notifications of slow client are dropped"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get><filter type=\"subtree\"><netconf-state xmlns=\"urn:ietf:params:xml:ns:yang:ietf-netconf-monitoring\"><statistics/></netconf-state></filter></get></rpc>" "" "<dropped-notifications[^>]*>[1-9][0-9]*</dropped-notifications>"
+
+    new "$policy: Check sessions"
+    ret=$(nrsessions)
+    if [ $policy = drop ]; then
+        if [ $ret -ne 2 ]; then # slow client and this client
+            err "2" "$ret"
+        fi
+    elif [ $ret -ne 1 ]; then # slow client is disconnected
+        err "1" "$ret"
+    fi
+
+    kill $slowpid 2> /dev/null
+    wait
+
+    if [ $BE -ne 0 ]; then
+        new "Kill backend"
+        # Check if premature kill
+        pid=$(pgrep -u root -f clixon_backend)
+        if [ -z "$pid" ]; then
+            err "backend already dead"
+        fi
+        stop_backend -f $cfg
+    fi
+}
+
+testrun drop
+testrun disconnect
+
+rm -rf $dir
+
+new "endtest"
+endtest
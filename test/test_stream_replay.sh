@@ -0,0 +1,132 @@
+#!/usr/bin/env bash
+# Stream replay buffers, CLICON_STREAM_REPLAY_DIR and CLICON_STREAM_RETENTION_SIZE
+# Check that replay of a stream survives a backend restart with a replay directory, and
+# that the size retention drops the oldest events
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/example.yang
+replaydir=$dir/replay
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_BACKEND_REGEXP>example_backend.so$</CLICON_BACKEND_REGEXP>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_STREAM_RETENTION>60</CLICON_STREAM_RETENTION>
+  <CLICON_STREAM_REPLAY_DIR>$replaydir</CLICON_STREAM_REPLAY_DIR>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module example {
+   namespace "urn:example:clixon";
+   prefix ex;
+   notification event {
+      leaf event-class {
+         type string;
+      }
+      container reportingEntity {
+         leaf card {
+            type string;
+         }
+      }
+      leaf severity {
+         type string;
+      }
+   }
+}
+EOF
+
+# Start backend
+# 1: seconds between example notifications
+# 2: CLICON_STREAM_RETENTION_SIZE
+function start() {
+    if [ $BE -ne 0 ]; then
+        new "kill old backend"
+        sudo clixon_backend -zf $cfg
+        if [ $? -ne 0 ]; then
+            err
+        fi
+        new "start backend -s init -f $cfg -o CLICON_STREAM_RETENTION_SIZE=$2 -- -n $1"
+        start_backend -s init -f $cfg -o CLICON_STREAM_RETENTION_SIZE=$2 -- -n $1
+    fi
+
+    new "wait backend"
+    wait_backend
+}
+
+function stop() {
+    if [ $BE -ne 0 ]; then
+        new "Kill backend"
+        # Check if premature kill
+        pid=$(pgrep -u root -f clixon_backend)
+        if [ -z "$pid" ]; then
+            err "backend already dead"
+        fi
+        stop_backend -f $cfg
+    fi
+}
+
+# Print number of replayed events in a time interval
+# 1: startTime
+# 2: stopTime
+function replay() {
+    (echo "$HELLONO11<rpc $DEFAULTNS><create-subscription xmlns=\"urn:ietf:params:xml:ns:netmod:notification\"><stream>EXAMPLE</stream><startTime>$1</startTime><stopTime>$2</stopTime></create-subscription></rpc>]]>]]>"; sleep 2) | $clixon_netconf -qf $cfg | grep -o "<event-class>fault</event-class>" | wc -l
+}
+
+new "test params: -f $cfg"
+
+sudo rm -rf $replaydir
+mkdir $replaydir
+t0=$(date -u +"%Y-%m-%dT%H:%M:%SZ")
+
+start 1 0
+sleep 4
+stop
+
+t1=$(date -u +"%Y-%m-%dT%H:%M:%SZ")
+
+new "Check replay file is written"
+[ -s $replaydir/EXAMPLE.replay ] || err "$replaydir/EXAMPLE.replay" "none"
+
+# No new events during replay
+start 1000 0
+
+new "Check replay after restart"
+ret=$(replay $t0 $t1)
+if [ $ret -lt 3 ]; then
+    err ">= 3" "$ret"
+fi
+
+stop
+
+sudo rm -rf $replaydir
+mkdir $replaydir
+t0=$(date -u +"%Y-%m-%dT%H:%M:%SZ")
+
+# One serialized event is about 250 bytes
+start 1 400
+sleep 4
+
+new "Check size retention drops oldest events"
+ret=$(replay $t0 $(date -u +"%Y-%m-%dT%H:%M:%SZ"))
+if [ $ret -lt 1 -o $ret -gt 2 ]; then
+    err "1-2" "$ret"
+fi
+
+stop
+
+sudo rm -rf $dir
+
+new "endtest"
+endtest
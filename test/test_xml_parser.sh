@@ -0,0 +1,138 @@
+#!/usr/bin/env bash
+# Hand-written XML scanner, see CLICON_XML_PARSER
+# Run NETCONF edits and startup with the fast parser and check that the resulting trees are
+# the same as with the bison parser
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/test.yang
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XML_PARSER>fast</CLICON_XML_PARSER>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module $APPNAME{
+  yang-version 1.1;
+  namespace "urn:example:clixon";
+  prefix ex;
+  container a {
+     list x {
+        key k;
+        leaf k { type string; }
+        leaf v { type string; }
+     }
+  }
+}
+EOF
+
+# Pretty-printed startup with declaration, comment, entities and CDATA
+cat <<EOF > $dir/startup_db
+<?xml version="1.0" encoding="UTF-8"?>
+<${DATASTORE_TOP}>
+   <!-- startup -->
+   <a xmlns="urn:example:clixon">
+      <x>
+         <k>a</k>
+         <v>x &amp; &lt;y&gt;</v>
+      </x>
+      <x>
+         <k>b</k>
+         <v><![CDATA[<z>]]></v>
+      </x>
+   </a>
+</${DATASTORE_TOP}>
+EOF
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s startup -f $cfg"
+    start_backend -s startup -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "Get startup config"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><a xmlns=\"urn:example:clixon\"><x><k>a</k><v>x &amp; &lt;y&gt;</v></x><x><k>b</k><v><![CDATA[<z>]]></v></x></a></data></rpc-reply>"
+
+new "Edit with whitespace, prefixes and attributes"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS>
+  <edit-config>
+    <target><candidate/></target>
+    <config>
+      <ex:a xmlns:ex='urn:example:clixon' xmlns:nc='${BASENS}'>
+        <ex:x nc:operation='delete'><ex:k>a</ex:k></ex:x>
+        <ex:x><ex:k>c</ex:k><ex:v> c&amp;d </ex:v></ex:x>
+      </ex:a>
+    </config>
+  </edit-config>
+</rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "Get candidate"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><a xmlns=\"urn:example:clixon\"><x><k>b</k><v><![CDATA[<z>]]></v></x><x><k>c</k><v> c&amp;d </v></x></a></data></rpc-reply>"
+
+new "Non-xml"
+expecteof "$clixon_netconf -qf $cfg" 0 "This is not XML]]>]]>" "<rpc-reply xmlns=\"${BASENS}\"><rpc-error><error-type>rpc</error-type><error-tag>operation-failed</error-tag><error-severity>error</error-severity><error-message>xml_parse: line 0: syntax error: at or before: This</error-message></rpc-error></rpc-reply>]]>]]>" 2> /dev/null
+
+new "Mismatched end tag"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><get-config></get></rpc>]]>]]>" "<rpc-reply xmlns=\"${BASENS}\"><rpc-error><error-type>rpc</error-type><error-tag>operation-failed</error-tag><error-severity>error</error-severity><error-message>Sanity check failed: get-config vs get</error-message></rpc-error></rpc-reply>]]>]]>" 2> /dev/null
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    stop_backend -f $cfg
+fi
+
+# Extra XML is merged into running entry by entry as it is parsed
+cat <<EOF > $dir/extra_db
+<${DATASTORE_TOP}>
+   <a xmlns="urn:example:clixon">
+      <x><k>d</k><v>extra</v></x>
+      <x><k>b</k><v>replaced</v></x>
+   </a>
+</${DATASTORE_TOP}>
+EOF
+
+if [ $BE -ne 0 ]; then
+    new "start backend -s startup -f $cfg -c $dir/extra_db"
+    start_backend -s startup -f $cfg -c $dir/extra_db
+fi
+
+new "wait backend"
+wait_backend
+
+new "Get merged extra config"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><a xmlns=\"urn:example:clixon\"><x><k>a</k><v>x &amp; &lt;y&gt;</v></x><x><k>b</k><v>replaced</v></x><x><k>d</k><v>extra</v></x></a></data></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,129 @@
+#!/usr/bin/env bash
+# Cache of parsed XPaths, CLICON_XPATH_CACHE_SIZE
+# Check that repeated XPath filters hit the cache, that the number of cached XPaths
+# is limited by the option, and that 0 disables the cache
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/clixon-example.yang
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module clixon-example{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container table{
+      list parameter{
+         key name;
+         leaf name{
+            type string;
+         }
+         leaf value{
+            type string;
+         }
+      }
+   }
+}
+EOF
+
+# Get a parameter with an xpath filter
+# 1: name
+function getparam() {
+    new "get parameter $1"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:table/ex:parameter[ex:name='$1']\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>$1</name><value>$1$1</value></parameter></table></data></rpc-reply>"
+}
+
+# Print a counter of the xpath cache from the stats rpc
+# 1: nr, hits or misses
+function xpstat() {
+    echo "$HELLONO11<rpc $DEFAULTNS><stats xmlns=\"http://clicon.org/lib\"/></rpc>]]>]]>" | $clixon_netconf -qf $cfg | sed -n "s/.*<xpath-cache-$1>\([0-9]*\)<\/xpath-cache-$1>.*/\1/p"
+}
+
+# 1: CLICON_XPATH_CACHE_SIZE
+function testrun() {
+    size=$1
+
+    new "test params: -f $cfg -o CLICON_XPATH_CACHE_SIZE=$size"
+    if [ $BE -ne 0 ]; then
+        new "kill old backend"
+        sudo clixon_backend -zf $cfg
+        if [ $? -ne 0 ]; then
+            err
+        fi
+        new "start backend -s init -f $cfg -o CLICON_XPATH_CACHE_SIZE=$size"
+        start_backend -s init -f $cfg -o CLICON_XPATH_CACHE_SIZE=$size
+    fi
+
+    new "wait backend"
+    wait_backend
+
+    new "edit candidate"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><table xmlns=\"urn:example:clixon\"><parameter><name>a</name><value>aa</value></parameter><parameter><name>b</name><value>bb</value></parameter><parameter><name>c</name><value>cc</value></parameter><parameter><name>d</name><value>dd</value></parameter></table></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    new "commit"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    getparam a
+    hits0=$(xpstat hits)
+    getparam a
+    hits1=$(xpstat hits)
+    getparam b
+    getparam c
+    getparam d
+    getparam a
+
+    if [ $size -eq 0 ]; then
+        new "Check cache is disabled"
+        for c in nr hits misses; do
+            ret=$(xpstat $c)
+            if [ "$ret" != 0 ]; then
+                err "0" "$c: $ret"
+            fi
+        done
+    else
+        new "Check repeated xpath hits the cache"
+        if [ $hits1 -le $hits0 ]; then
+            err "hits > $hits0" "$hits1"
+        fi
+
+        new "Check number of cached xpaths is limited"
+        ret=$(xpstat nr)
+        if [ $ret -gt $size ]; then
+            err "<= $size" "$ret"
+        fi
+    fi
+
+    if [ $BE -ne 0 ]; then
+        new "Kill backend"
+        # Check if premature kill
+        pid=$(pgrep -u root -f clixon_backend)
+        if [ -z "$pid" ]; then
+            err "backend already dead"
+        fi
+        stop_backend -f $cfg
+    fi
+}
+
+for size in 2 0; do
+    testrun $size
+done
+
+rm -rf $dir
+
+new "endtest"
+endtest
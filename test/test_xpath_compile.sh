@@ -0,0 +1,105 @@
+#!/usr/bin/env bash
+# Compiled XPath evaluation, see CLICON_XPATH_EVAL
+# Run in differential mode where compiled XPaths are also interpreted and an error is
+# returned if the results differ
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/test.yang
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_XPATH_EVAL>differential</CLICON_XPATH_EVAL>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module $APPNAME{
+  yang-version 1.1;
+  namespace "urn:example:clixon";
+  prefix ex;
+  container a {
+     list x {
+        key "k1 k2";
+        leaf k1 { type string; }
+        leaf k2 { type string; }
+        leaf v { type string; }
+        list y {
+           key n;
+           leaf n { type string; }
+           leaf v { type string; }
+        }
+        leaf-list l { type string; }
+     }
+  }
+}
+EOF
+
+XML="<a xmlns=\"urn:example:clixon\"><x><k1>a</k1><k2>b</k2><v>ab</v><y><n>n1</n><v>ab1</v></y><y><n>n2</n><v>ab2</v></y><l>l1</l><l>l2</l></x><x><k1>a</k1><k2>c</k2><v>ac</v><y><n>n2</n><v>ac2</v></y></x><x><k1>b</k1><k2>b</k2><v>bb</v></x></a>"
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "Add config"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config>$XML</config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "netconf commit"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "Child steps and keys"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type='xpath' select=\"/ex:a/ex:x[ex:k1='a'][ex:k2='b']/ex:v\" xmlns:ex='urn:example:clixon'/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><a xmlns=\"urn:example:clixon\"><x><k1>a</k1><k2>b</k2><v>ab</v></x></a></data></rpc-reply>"
+
+new "And-joined keys"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type='xpath' select=\"/ex:a/ex:x[ex:k1='a' and ex:k2='c']/ex:y/ex:n\" xmlns:ex='urn:example:clixon'/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><a xmlns=\"urn:example:clixon\"><x><k1>a</k1><k2>c</k2><y><n>n2</n></y></x></a></data></rpc-reply>"
+
+new "Parent step"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type='xpath' select=\"/ex:a/ex:x/ex:y[ex:v='ac2']/../ex:v\" xmlns:ex='urn:example:clixon'/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><a xmlns=\"urn:example:clixon\"><x><k1>a</k1><k2>c</k2><v>ac</v></x></a></data></rpc-reply>"
+
+new "Self step"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type='xpath' select=\"/ex:a/ex:x/ex:l[.='l2']\" xmlns:ex='urn:example:clixon'/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><a xmlns=\"urn:example:clixon\"><x><k1>a</k1><k2>b</k2><l>l2</l></x></a></data></rpc-reply>"
+
+new "Reversed equality"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type='xpath' select=\"/ex:a/ex:x['bb'=ex:v]/ex:k2\" xmlns:ex='urn:example:clixon'/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><a xmlns=\"urn:example:clixon\"><x><k1>b</k1><k2>b</k2></x></a></data></rpc-reply>"
+
+new "Number no match"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type='xpath' select=\"/ex:a/ex:x[ex:v=1]\" xmlns:ex='urn:example:clixon'/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data/></rpc-reply>"
+
+new "Not compiled: or"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type='xpath' select=\"/ex:a/ex:x[ex:v='ab' or ex:v='bb']/ex:k2\" xmlns:ex='urn:example:clixon'/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><a xmlns=\"urn:example:clixon\"><x><k1>a</k1><k2>b</k2></x><x><k1>b</k1><k2>b</k2></x></a></data></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
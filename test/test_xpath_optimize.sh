@@ -0,0 +1,111 @@
+#!/usr/bin/env bash
+# XPath list optimization, see XPATH_LIST_OPTIMIZE
+# Check that optimized lookups of multiple keys in any order, and-joined keys,
+# leaf-lists, nested lists and positional predicates give the same result as linear search
+# Also count() and existence checks that do not build node-sets
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/test.yang
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module $APPNAME{
+  yang-version 1.1;
+  namespace "urn:example:clixon";
+  prefix ex;
+  container a {
+     list x {
+        key "k1 k2";
+        leaf k1 { type string; }
+        leaf k2 { type string; }
+        leaf v { type string; }
+        list y {
+           key n;
+           leaf n { type string; }
+           leaf v { type string; }
+        }
+        leaf-list l { type string; }
+     }
+  }
+}
+EOF
+
+XML="<a xmlns=\"urn:example:clixon\"><x><k1>a</k1><k2>b</k2><v>ab</v><y><n>n1</n><v>ab1</v></y><y><n>n2</n><v>ab2</v></y><l>l1</l><l>l2</l></x><x><k1>a</k1><k2>c</k2><v>ac</v><y><n>n2</n><v>ac2</v></y></x><x><k1>b</k1><k2>b</k2><v>bb</v></x></a>"
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "Add config"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config>$XML</config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "netconf commit"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "Keys in reverse order"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type='xpath' select=\"/ex:a/ex:x[ex:k2='b'][ex:k1='a']/ex:v\" xmlns:ex='urn:example:clixon'/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><a xmlns=\"urn:example:clixon\"><x><k1>a</k1><k2>b</k2><v>ab</v></x></a></data></rpc-reply>"
+
+new "And-joined keys"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type='xpath' select=\"/ex:a/ex:x[ex:k1='a' and ex:k2='c']/ex:v\" xmlns:ex='urn:example:clixon'/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><a xmlns=\"urn:example:clixon\"><x><k1>a</k1><k2>c</k2><v>ac</v></x></a></data></rpc-reply>"
+
+new "Keys and non-key predicate"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type='xpath' select=\"/ex:a/ex:x[ex:k1='a' and ex:k2='c' and ex:v='ab']/ex:v\" xmlns:ex='urn:example:clixon'/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data/></rpc-reply>"
+
+new "Nested list in all outer entries"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type='xpath' select=\"/ex:a/ex:x/ex:y[ex:n='n2']/ex:v\" xmlns:ex='urn:example:clixon'/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><a xmlns=\"urn:example:clixon\"><x><k1>a</k1><k2>b</k2><y><n>n2</n><v>ab2</v></y></x><x><k1>a</k1><k2>c</k2><y><n>n2</n><v>ac2</v></y></x></a></data></rpc-reply>"
+
+new "Leaf-list value"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type='xpath' select=\"/ex:a/ex:x[ex:k1='a'][ex:k2='b']/ex:l[.='l2']\" xmlns:ex='urn:example:clixon'/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><a xmlns=\"urn:example:clixon\"><x><k1>a</k1><k2>b</k2><l>l2</l></x></a></data></rpc-reply>"
+
+new "Positional predicate before keys"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type='xpath' select=\"/ex:a/ex:x[3][ex:k1='b'][ex:k2='b']/ex:v\" xmlns:ex='urn:example:clixon'/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><a xmlns=\"urn:example:clixon\"><x><k1>b</k1><k2>b</k2><v>bb</v></x></a></data></rpc-reply>"
+
+new "Existence predicate"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type='xpath' select=\"/ex:a/ex:x[ex:y]/ex:v\" xmlns:ex='urn:example:clixon'/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><a xmlns=\"urn:example:clixon\"><x><k1>a</k1><k2>b</k2><v>ab</v></x><x><k1>a</k1><k2>c</k2><v>ac</v></x></a></data></rpc-reply>"
+
+new "Count predicate"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type='xpath' select=\"/ex:a/ex:x[count(ex:y)=2]/ex:v\" xmlns:ex='urn:example:clixon'/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><a xmlns=\"urn:example:clixon\"><x><k1>a</k1><k2>b</k2><v>ab</v></x></a></data></rpc-reply>"
+
+new "Not existence predicate"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type='xpath' select=\"/ex:a/ex:x[not(ex:l)]/ex:v\" xmlns:ex='urn:example:clixon'/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><a xmlns=\"urn:example:clixon\"><x><k1>a</k1><k2>c</k2><v>ac</v></x><x><k1>b</k1><k2>b</k2><v>bb</v></x></a></data></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
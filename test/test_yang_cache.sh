@@ -0,0 +1,179 @@
+#!/usr/bin/env bash
+# Precompiled YANG schema cache tests
+# Start backend and cli twice, check that yang is loaded from cache, and that a changed
+# yang file invalidates the cache
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+# include err() and new() functions and creates $dir
+
+cfg=$dir/conf_yang.xml
+ydir=$dir/yang
+cdir=$dir/cache
+fyang=$ydir/clixon-example.yang
+fclispec=$dir/clispec.cli
+
+test -d $ydir || mkdir $ydir
+test -d $cdir || mkdir $cdir
+chmod 777 $cdir
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>$IETFRFC</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_DIR>$ydir</CLICON_YANG_MAIN_DIR>
+  <CLICON_YANG_CACHE_DIR>$cdir</CLICON_YANG_CACHE_DIR>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_CLI_MODE>$APPNAME</CLICON_CLI_MODE>
+  <CLICON_CLI_DIR>/usr/local/lib/$APPNAME/cli</CLICON_CLI_DIR>
+  <CLICON_CLISPEC_DIR>$dir</CLICON_CLISPEC_DIR>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+</clixon-config>
+EOF
+
+# Yang with typedef pattern, grouping and augment to check expanded spec
+# Arg 1: extra leaf
+function testyang()
+{
+    cat <<EOF > $fyang
+module clixon-example{
+    yang-version 1.1;
+    namespace "urn:example:clixon";
+    prefix ex;
+    typedef id {
+        type string {
+            pattern '[a-z]+';
+        }
+    }
+    grouping value {
+        leaf value{
+            type int32 {
+                range "0..100";
+            }
+            default 7;
+        }
+    }
+    container table{
+        list parameter{
+            key name;
+            leaf name{
+                type id;
+            }
+            uses value;
+        }
+    }
+    augment "/ex:table/ex:parameter" {
+        leaf x{
+            type string;
+        }
+        $1
+    }
+}
+EOF
+}
+
+cat <<EOF > $fclispec
+CLICON_MODE="example";
+CLICON_PROMPT="%U@%H %w> ";
+CLICON_PLUGIN="example_cli";
+
+# Autocli syntax tree operations
+set @datamodel, cli_auto_set();
+delete("Delete a configuration item") @datamodel, cli_auto_del();
+commit("Commit the changes"), cli_commit();
+quit("Quit"), cli_quit();
+show("Show a particular state of the system"){
+    configuration("Show configuration"), cli_show_auto_mode("running", "xml", false, false);
+}
+EOF
+
+testyang ""
+
+for i in 1 2; do
+    if [ $BE -ne 0 ]; then
+        new "kill old backend"
+        sudo clixon_backend -z -f $cfg
+        if [ $? -ne 0 ]; then
+            err
+        fi
+        new "start backend -s init -f $cfg ($i)"
+        start_backend -s init -f $cfg
+    fi
+
+    new "wait backend"
+    wait_backend
+
+    new "netconf set invalid pattern ($i)"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><table xmlns=\"urn:example:clixon\"><parameter><name>A1</name></parameter></table></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    new "netconf validate invalid pattern ($i)"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>" "" "<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>bad-element</error-tag><error-info><bad-element>name</bad-element></error-info><error-severity>error</error-severity><error-message>regexp match fail:"
+
+    new "netconf discard-changes ($i)"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><discard-changes/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    new "cli configure parameter a ($i)"
+    expectpart "$($clixon_cli -1 -f $cfg set table parameter a x 42)" 0 "^$"
+
+    new "cli commit ($i)"
+    expectpart "$($clixon_cli -1 -f $cfg commit)" 0 "^$"
+
+    new "netconf get default from grouping ($i)"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><with-defaults xmlns=\"urn:ietf:params:xml:ns:yang:ietf-netconf-with-defaults\">report-all</with-defaults></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>a</name><value>7</value><x>42</x></parameter></table></data></rpc-reply>"
+
+    new "Check cache file ($i)"
+    f=$(ls $cdir/*.ycache | head -1)
+    if [ -z "$f" ]; then
+        err "cache file" "none"
+    fi
+    if [ "$(sudo head -c 4 $f)" != "CLXY" ]; then
+        err "CLXY" "$(sudo head -c 4 $f)"
+    fi
+
+    if [ $BE -ne 0 ]; then
+        new "Kill backend"
+        stop_backend -f $cfg
+    fi
+done
+
+new "Change yang: add leaf y"
+testyang "leaf y{ type string; }"
+
+if [ $BE -ne 0 ]; then
+    new "start backend -s running -f $cfg"
+    start_backend -s running -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "cli configure new leaf y"
+expectpart "$($clixon_cli -1 -f $cfg set table parameter a y 17)" 0 "^$"
+
+new "cli commit"
+expectpart "$($clixon_cli -1 -f $cfg commit)" 0 "^$"
+
+new "cli show config"
+expectpart "$($clixon_cli -1 -f $cfg show config)" 0 "^<table xmlns=\"urn:example:clixon\"><parameter><name>a</name><x>42</x><y>17</y></parameter></table>$"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
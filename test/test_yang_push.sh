@@ -0,0 +1,127 @@
+#!/usr/bin/env bash
+# On-change subscriptions, see CLICON_STREAM_YANG_PUSH
+# Establish subscriptions with and without selection and dampening, commit, and check
+# push-change-update notifications. Check that periodic subscriptions share push-update
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/test.yang
+fout=$dir/notify.out
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_STREAM_YANG_PUSH>true</CLICON_STREAM_YANG_PUSH>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module $APPNAME{
+  yang-version 1.1;
+  namespace "urn:example:clixon";
+  prefix ex;
+  container a {
+     leaf x { type uint32; }
+  }
+  container b {
+     leaf y { type uint32; }
+  }
+}
+EOF
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "establish-push of candidate fails"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><establish-push xmlns=\"http://clicon.org/lib\"><datastore>candidate</datastore></establish-push></rpc>" "" "<rpc-reply $DEFAULTNS><rpc-error>"
+
+new "asynchronous subscription of a with dampening"
+(echo "$HELLONO11<rpc $DEFAULTNS><establish-push xmlns=\"http://clicon.org/lib\"><xpath xmlns:ex=\"urn:example:clixon\">/ex:a</xpath><dampening-period>200</dampening-period></establish-push></rpc>]]>]]>"; sleep 5) | $clixon_netconf -qf $cfg > $fout &
+sleep 1
+
+new "edit-config a and b"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><a xmlns=\"urn:example:clixon\"><x>1</x></a><b xmlns=\"urn:example:clixon\"><y>1</y></b></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "commit"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "edit-config a within dampening period"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><a xmlns=\"urn:example:clixon\"><x>2</x></a></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "commit"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+wait
+
+new "establish-push reply"
+if ! grep -q "<rpc-reply $DEFAULTNS><id xmlns=\"http://clicon.org/lib\">[0-9]*</id></rpc-reply>" $fout; then
+    err "establish-push reply" "$(cat $fout)"
+fi
+
+new "first commit update"
+if ! grep -q "<push-change-update xmlns=\"http://clicon.org/lib\"><id>[0-9]*</id><datastore>running</datastore><datastore-changes><yang-patch><patch-id>0</patch-id><edit><edit-id>1</edit-id><operation>create</operation><target>/example:a</target><value><a xmlns=\"urn:example:clixon\"><x>1</x></a></value></edit></yang-patch></datastore-changes></push-change-update>" $fout; then
+    err "first push-change-update" "$(cat $fout)"
+fi
+
+new "second commit update after dampening"
+if ! grep -q "<patch-id>1</patch-id><edit><edit-id>1</edit-id><operation>replace</operation><target>/example:a/x</target><value><x xmlns=\"urn:example:clixon\">2</x></value></edit>" $fout; then
+    err "second push-change-update" "$(cat $fout)"
+fi
+
+new "b not selected"
+if grep -q "/example:b" $fout; then
+    err "no b" "$(cat $fout)"
+fi
+
+new "two asynchronous periodic subscriptions of a"
+for i in 1 2; do
+    (echo "$HELLONO11<rpc $DEFAULTNS><establish-push xmlns=\"http://clicon.org/lib\"><xpath xmlns:ex=\"urn:example:clixon\">/ex:a</xpath><period>200</period></establish-push></rpc>]]>]]>"; sleep 4) | $clixon_netconf -qf $cfg > $dir/periodic$i.out &
+done
+
+wait
+
+new "periodic subscriptions share one update"
+for i in 1 2; do
+    if ! grep -q "<push-update xmlns=\"http://clicon.org/lib\"><id>[0-9]*</id><id>[0-9]*</id><datastore>running</datastore><datastore-contents><a xmlns=\"urn:example:clixon\"><x>2</x></a></datastore-contents></push-update>" $dir/periodic$i.out; then
+        err "push-update" "$(cat $dir/periodic$i.out)"
+    fi
+done
+
+new "delete-push of other session fails"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><delete-push xmlns=\"http://clicon.org/lib\"><id>1</id></delete-push></rpc>" "" "<rpc-reply $DEFAULTNS><rpc-error>.*No such subscription"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
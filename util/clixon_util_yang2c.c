@@ -0,0 +1,568 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2016 Olof Hagsand and Benny Holmgren
+  Copyright (C) 2017-2019 Olof Hagsand
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC (Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+ *
+ * Generate a C header with typed accessors of the data nodes of a YANG module
+ * The header contains:
+ * - An enum of schema node ids and a vector of their yang specs, resolved once at
+ *   plugin init with <prefix>_yang2c_init()
+ * - Inline accessors of child nodes that find children by yang spec with binary search,
+ *   see xml_child_yang, and iterators and key lookup of lists
+ * - Typed value getters of leafs using the cached value of the node, see xml_cv_get
+ * so that plugins need no runtime xpath parsing or name comparisons for known paths.
+ * Example:
+ *   clixon_util_yang2c -f example.xml -m clixon-example > clixon_example_yang2c.h
+ * and in one source file of the plugin:
+ *   #define CLIXON_EXAMPLE_YANG2C_IMPL
+ *   #include "clixon_example_yang2c.h"
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <ctype.h>
+#include <unistd.h>
+#include <errno.h>
+#include <syslog.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include <clixon/clixon.h>
+
+/* Command line options to be passed to getopt(3) */
+#define YANG2C_OPTS "hD:f:m:p:o:"
+
+/*! One data node of the module
+ */
+struct y2c_node {
+    yang_stmt *yn_ys;      /* Yang spec */
+    int        yn_parent;  /* Index of parent node, -1 if top-level */
+    char      *yn_id;      /* C identifier, <prefix>_<path> */
+    char      *yn_eid;     /* Schema node id, <PREFIX>_<PATH> */
+};
+
+/*! Generator state
+ */
+struct y2c {
+    yang_stmt       *y_mod;     /* Yang module */
+    char            *y_prefix;  /* C identifier prefix */
+    struct y2c_node *y_nodes;   /* Data nodes in tree order */
+    int              y_len;
+    cvec            *y_names;   /* Generated function names, to detect collisions */
+};
+
+/*! Append name to cbuf as C identifier, other characters than alnum are replaced by _
+ */
+static void
+y2c_ident(cbuf       *cb,
+          const char *name,
+          int         upper)
+{
+    const char *s;
+
+    for (s = name; *s; s++){
+        if (isalnum((unsigned char)*s))
+            cprintf(cb, "%c", upper ? toupper((unsigned char)*s) : *s);
+        else
+            cprintf(cb, "_");
+    }
+}
+
+/*! Add a data node and, for containers and lists, its descendants
+ *
+ * Choice and case are transparent as in XML
+ * @param[in]  y       Generator state
+ * @param[in]  yp      Yang parent
+ * @param[in]  parent  Index of parent data node, -1 if top-level
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+y2c_walk(struct y2c *y,
+         yang_stmt  *yp,
+         int         parent)
+{
+    int              retval = -1;
+    yang_stmt       *yc;
+    yang_stmt       *ysub;
+    struct y2c_node *yn;
+    cbuf            *cb = NULL;
+    int              inext = 0;
+    int              i;
+
+    while ((yc = yn_iter(yp, &inext)) != NULL){
+        switch (yang_keyword_get(yc)){
+        case Y_CHOICE:
+        case Y_CASE:
+            if (y2c_walk(y, yc, parent) < 0)
+                goto done;
+            continue;
+        case Y_INCLUDE:
+            if (parent == -1 &&
+                (ysub = yang_find_module_by_name(ys_spec(yc), yang_argument_get(yc))) != NULL &&
+                y2c_walk(y, ysub, parent) < 0)
+                goto done;
+            continue;
+        case Y_CONTAINER:
+        case Y_LIST:
+        case Y_LEAF:
+        case Y_LEAF_LIST:
+        case Y_ANYDATA:
+        case Y_ANYXML:
+            break;
+        default:
+            continue;
+        }
+        if ((cb = cbuf_new()) == NULL){
+            clixon_err(OE_UNIX, errno, "cbuf_new");
+            goto done;
+        }
+        cprintf(cb, "%s_", parent == -1 ? y->y_prefix : y->y_nodes[parent].yn_id);
+        y2c_ident(cb, yang_argument_get(yc), 0);
+        if ((yn = realloc(y->y_nodes, (y->y_len+1)*sizeof(*yn))) == NULL){
+            clixon_err(OE_UNIX, errno, "realloc");
+            goto done;
+        }
+        y->y_nodes = yn;
+        yn = &y->y_nodes[y->y_len];
+        memset(yn, 0, sizeof(*yn));
+        yn->yn_ys = yc;
+        yn->yn_parent = parent;
+        if ((yn->yn_id = strdup(cbuf_get(cb))) == NULL){
+            clixon_err(OE_UNIX, errno, "strdup");
+            goto done;
+        }
+        cbuf_reset(cb);
+        y2c_ident(cb, yn->yn_id, 1);
+        if ((yn->yn_eid = strdup(cbuf_get(cb))) == NULL){
+            clixon_err(OE_UNIX, errno, "strdup");
+            goto done;
+        }
+        i = y->y_len++;
+        cbuf_free(cb);
+        cb = NULL;
+        if (yang_keyword_get(yc) == Y_CONTAINER || yang_keyword_get(yc) == Y_LIST)
+            if (y2c_walk(y, yc, i) < 0)
+                goto done;
+    }
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Register a generated function name, fail if already generated
+ */
+static int
+y2c_name(struct y2c *y,
+         const char *id,
+         const char *suffix)
+{
+    char name[512];
+
+    snprintf(name, sizeof(name), "%s%s", id, suffix);
+    if (cvec_find(y->y_names, name) != NULL){
+        clixon_err(OE_YANG, EEXIST, "Generated name %s is not unique, use another prefix", name);
+        return -1;
+    }
+    if (cvec_add_string(y->y_names, name, NULL) < 0){
+        clixon_err(OE_UNIX, errno, "cvec_add_string");
+        return -1;
+    }
+    return 0;
+}
+
+/*! Get cligen type of a leaf
+ */
+static int
+y2c_cvtype(yang_stmt    *ys,
+           enum cv_type *cvtype)
+{
+    yang_stmt *yrestype = NULL;
+
+    *cvtype = CGV_STRING;
+    if (yang_type_get(ys, NULL, &yrestype, NULL, NULL, NULL, NULL, NULL) < 0)
+        return -1;
+    if (yrestype)
+        yang2cv_type(yang_argument_get(yrestype), cvtype);
+    return 0;
+}
+
+/*! C type and cligen getter of typed leaf values, NULL if the value is returned as string
+ */
+static const char *
+y2c_ctype(enum cv_type cvtype,
+          const char **getter)
+{
+    switch (cvtype){
+    case CGV_INT8:   *getter = "cv_int8_get";   return "int8_t";
+    case CGV_INT16:  *getter = "cv_int16_get";  return "int16_t";
+    case CGV_INT32:  *getter = "cv_int32_get";  return "int32_t";
+    case CGV_INT64:  *getter = "cv_int64_get";  return "int64_t";
+    case CGV_UINT8:  *getter = "cv_uint8_get";  return "uint8_t";
+    case CGV_UINT16: *getter = "cv_uint16_get"; return "uint16_t";
+    case CGV_UINT32: *getter = "cv_uint32_get"; return "uint32_t";
+    case CGV_UINT64: *getter = "cv_uint64_get"; return "uint64_t";
+    case CGV_BOOL:   *getter = "cv_bool_get";   return "int";
+    default:
+        break;
+    }
+    return NULL;
+}
+
+/*! Print accessors of one data node
+ *
+ * @param[in]  y   Generator state
+ * @param[in]  i   Index of node
+ * @param[in]  f   Output file
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+static int
+y2c_print_node(struct y2c *y,
+               int         i,
+               FILE       *f)
+{
+    struct y2c_node *yn = &y->y_nodes[i];
+    enum rfc_6020    keyword = yang_keyword_get(yn->yn_ys);
+    cvec            *cvk;
+    yang_stmt       *ykey;
+    const char      *ctype;
+    const char      *getter;
+    enum cv_type     cvtype;
+    int              sorted;
+    int              j;
+
+    if (y2c_name(y, yn->yn_eid, "") < 0 ||
+        y2c_name(y, yn->yn_id, "") < 0)
+        return -1;
+    fprintf(f, "/*! Get %s %s of parent, NULL if not present */\n",
+            yang_key2str(keyword), yang_argument_get(yn->yn_ys));
+    fprintf(f, "static inline cxobj *\n%s(cxobj *xp)\n{\n", yn->yn_id);
+    fprintf(f, "    return xml_child_yang(xp, %s_yang[%s]);\n}\n\n", y->y_prefix, yn->yn_eid);
+    if (keyword == Y_LIST || keyword == Y_LEAF_LIST){
+        if (y2c_name(y, yn->yn_id, "_next") < 0)
+            return -1;
+        fprintf(f, "/*! Get next entry of %s after x */\n", yang_argument_get(yn->yn_ys));
+        fprintf(f, "static inline cxobj *\n%s_next(cxobj *xp, cxobj *x)\n{\n", yn->yn_id);
+        fprintf(f, "    return xml_child_yang_next(xp, x);\n}\n\n");
+    }
+    if (keyword == Y_LIST &&
+        (cvk = yang_cvec_get(yn->yn_ys)) != NULL && cvec_len(cvk) == 1 &&
+        (ykey = yang_find(yn->yn_ys, Y_LEAF, cv_string_get(cvec_i(cvk, 0)))) != NULL){
+        for (j = i+1; j < y->y_len; j++)
+            if (y->y_nodes[j].yn_ys == ykey)
+                break;
+        if (j < y->y_len){
+            if (y2c_cvtype(ykey, &cvtype) < 0)
+                return -1;
+            /* Binary search requires entries sorted on key as strings */
+            sorted = cvtype == CGV_STRING &&
+                yang_config(yn->yn_ys) &&
+                yang_find(yn->yn_ys, Y_ORDERED_BY, "user") == NULL;
+            if (y2c_name(y, yn->yn_id, "_find") < 0)
+                return -1;
+            fprintf(f, "/*! Find entry of %s with %s, NULL if not found */\n",
+                    yang_argument_get(yn->yn_ys), yang_argument_get(ykey));
+            fprintf(f, "static inline cxobj *\n%s_find(cxobj *xp, const char *key)\n{\n", yn->yn_id);
+            fprintf(f, "    return xml_child_yang_key(xp, %s_yang[%s], %s_yang[%s], key, %d);\n}\n\n",
+                    y->y_prefix, yn->yn_eid, y->y_prefix, y->y_nodes[j].yn_eid, sorted);
+        }
+    }
+    if (keyword != Y_LEAF && keyword != Y_LEAF_LIST)
+        return 0;
+    if (y2c_cvtype(yn->yn_ys, &cvtype) < 0)
+        return -1;
+    if ((ctype = y2c_ctype(cvtype, &getter)) != NULL){
+        if (y2c_name(y, yn->yn_id, "_value") < 0)
+            return -1;
+        fprintf(f, "/*! Get value of %s node x\n"
+                " * @retval  0  OK\n"
+                " * @retval -1  Error\n */\n", yang_argument_get(yn->yn_ys));
+        fprintf(f, "static inline int\n%s_value(cxobj *x, %s *val)\n{\n", yn->yn_id, ctype);
+        fprintf(f, "    cg_var *cv;\n\n");
+        fprintf(f, "    if (xml_cv_get(x, &cv) < 0)\n        return -1;\n");
+        fprintf(f, "    *val = %s(cv);\n    return 0;\n}\n\n", getter);
+        if (keyword == Y_LEAF){
+            if (y2c_name(y, yn->yn_id, "_get") < 0)
+                return -1;
+            fprintf(f, "/*! Get value of leaf %s of parent\n"
+                    " * @retval  1  OK\n"
+                    " * @retval  0  Not present\n"
+                    " * @retval -1  Error\n */\n", yang_argument_get(yn->yn_ys));
+            fprintf(f, "static inline int\n%s_get(cxobj *xp, %s *val)\n{\n", yn->yn_id, ctype);
+            fprintf(f, "    cxobj *x;\n\n");
+            fprintf(f, "    if ((x = %s(xp)) == NULL)\n        return 0;\n", yn->yn_id);
+            fprintf(f, "    if (%s_value(x, val) < 0)\n        return -1;\n", yn->yn_id);
+            fprintf(f, "    return 1;\n}\n\n");
+        }
+    }
+    else if (keyword == Y_LEAF){
+        if (y2c_name(y, yn->yn_id, "_get") < 0)
+            return -1;
+        fprintf(f, "/*! Get value of leaf %s of parent, NULL if not present */\n",
+                yang_argument_get(yn->yn_ys));
+        fprintf(f, "static inline char *\n%s_get(cxobj *xp)\n{\n", yn->yn_id);
+        fprintf(f, "    return xml_body(%s(xp));\n}\n\n", yn->yn_id);
+    }
+    return 0;
+}
+
+/*! Print header
+ *
+ * @param[in]  y   Generator state
+ * @param[in]  f   Output file
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+static int
+y2c_print(struct y2c *y,
+          FILE       *f)
+{
+    int              retval = -1;
+    struct y2c_node *yn;
+    yang_stmt       *yrev;
+    cbuf            *cbu = NULL;
+    char            *modname;
+    int              i;
+
+    if ((cbu = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    y2c_ident(cbu, y->y_prefix, 1);
+    modname = yang_argument_get(y->y_mod);
+    yrev = yang_find(y->y_mod, Y_REVISION, NULL);
+    fprintf(f, "/*\n * Generated by clixon_util_yang2c from YANG module %s%s%s, do not edit\n",
+            modname, yrev ? "@" : "", yrev ? yang_argument_get(yrev) : "");
+    fprintf(f, " * Include after <clixon/clixon.h>. Call %s_yang2c_init() at plugin init\n", y->y_prefix);
+    fprintf(f, " * after the YANG is loaded.\n");
+    fprintf(f, " * Define %s_YANG2C_IMPL in one source file before including this file.\n", cbuf_get(cbu));
+    fprintf(f, " */\n\n");
+    fprintf(f, "#ifndef _%s_YANG2C_H_\n#define _%s_YANG2C_H_\n\n", cbuf_get(cbu), cbuf_get(cbu));
+    fprintf(f, "/* Schema node ids */\nenum %s_yang2c {\n", y->y_prefix);
+    for (i=0; i<y->y_len; i++)
+        fprintf(f, "    %s,\n", y->y_nodes[i].yn_eid);
+    fprintf(f, "    %s_YANG2C_MAX\n};\n\n", cbuf_get(cbu));
+    fprintf(f, "/* Yang specs of schema nodes, indexed by schema node id */\n");
+    fprintf(f, "extern yang_stmt *%s_yang[%s_YANG2C_MAX];\n\n", y->y_prefix, cbuf_get(cbu));
+    fprintf(f, "int %s_yang2c_init(yang_stmt *yspec);\n\n", y->y_prefix);
+    for (i=0; i<y->y_len; i++)
+        if (y2c_print_node(y, i, f) < 0)
+            goto done;
+    fprintf(f, "#ifdef %s_YANG2C_IMPL\n", cbuf_get(cbu));
+    fprintf(f, "yang_stmt *%s_yang[%s_YANG2C_MAX];\n\n", y->y_prefix, cbuf_get(cbu));
+    fprintf(f, "static const struct {\n    int   parent;\n    char *ns;\n    char *name;\n");
+    fprintf(f, "} %s_yang2c_nodes[%s_YANG2C_MAX] = {\n", y->y_prefix, cbuf_get(cbu));
+    for (i=0; i<y->y_len; i++){
+        yn = &y->y_nodes[i];
+        fprintf(f, "    {%d, \"%s\", \"%s\"},\n", yn->yn_parent,
+                yang_find_mynamespace(yn->yn_ys), yang_argument_get(yn->yn_ys));
+    }
+    fprintf(f, "};\n\n");
+    fprintf(f, "/*! Resolve yang specs of schema nodes\n"
+            " * @param[in]  yspec  Yang spec\n"
+            " * @retval     0      OK\n"
+            " * @retval    -1      Error, YANG differs from generated header\n */\n");
+    fprintf(f, "int\n%s_yang2c_init(yang_stmt *yspec)\n{\n", y->y_prefix);
+    fprintf(f, "    yang_stmt *ymod;\n    int        i;\n\n");
+    fprintf(f, "    if ((ymod = yang_find_module_by_name(yspec, \"%s\")) == NULL){\n", modname);
+    fprintf(f, "        clixon_err(OE_YANG, ENOENT, \"Yang module %s not found\");\n", modname);
+    fprintf(f, "        return -1;\n    }\n");
+    fprintf(f, "    for (i=0; i<%s_YANG2C_MAX; i++){\n", cbuf_get(cbu));
+    fprintf(f, "        if (%s_yang2c_nodes[i].parent == -1)\n", y->y_prefix);
+    fprintf(f, "            %s_yang[i] = yang_find_datanode(ymod, %s_yang2c_nodes[i].name);\n",
+            y->y_prefix, y->y_prefix);
+    fprintf(f, "        else\n");
+    fprintf(f, "            %s_yang[i] = yang_find_datanode_ns(%s_yang[%s_yang2c_nodes[i].parent],\n",
+            y->y_prefix, y->y_prefix, y->y_prefix);
+    fprintf(f, "                                               %s_yang2c_nodes[i].ns, %s_yang2c_nodes[i].name);\n",
+            y->y_prefix, y->y_prefix);
+    fprintf(f, "        if (%s_yang[i] == NULL){\n", y->y_prefix);
+    fprintf(f, "            clixon_err(OE_YANG, ENOENT, \"Yang node %%s of %s not found, regenerate header\",\n", modname);
+    fprintf(f, "                       %s_yang2c_nodes[i].name);\n", y->y_prefix);
+    fprintf(f, "            return -1;\n        }\n    }\n    return 0;\n}\n");
+    fprintf(f, "#endif /* %s_YANG2C_IMPL */\n\n", cbuf_get(cbu));
+    fprintf(f, "#endif /* _%s_YANG2C_H_ */\n", cbuf_get(cbu));
+    retval = 0;
+ done:
+    if (cbu)
+        cbuf_free(cbu);
+    return retval;
+}
+
+static void
+usage(clixon_handle h,
+      char         *argv0)
+{
+    fprintf(stderr, "usage:%s [options]\n"
+            "where options are\n"
+            "\t-h \t\tHelp\n"
+            "\t-D <level>\tDebug\n"
+            "\t-f <file>\tClixon config file\n"
+            "\t-m <module>\tYANG module to generate accessors of\n"
+            "\t-p <prefix>\tC identifier prefix (default: module name)\n"
+            "\t-o <file>\tOutput header file (default: stdout)\n",
+            argv0);
+    exit(0);
+}
+
+int
+main(int    argc,
+     char **argv)
+{
+    int           retval = -1;
+    clixon_handle h;
+    struct y2c    y = {0,};
+    yang_stmt    *yspec = NULL;
+    char         *module = NULL;
+    char         *prefix = NULL;
+    char         *output = NULL;
+    char         *str;
+    cbuf         *cb = NULL;
+    FILE         *f = stdout;
+    int           dbg = 0;
+    int           c;
+    int           i;
+
+    if ((h = clixon_handle_init()) == NULL)
+        goto done;
+    clixon_log_init(h, "clixon_util_yang2c", LOG_DEBUG, CLIXON_LOG_STDERR);
+    if (clixon_err_init(h) < 0)
+        goto done;
+    optind = 1;
+    opterr = 0;
+    while ((c = getopt(argc, argv, YANG2C_OPTS)) != -1)
+        switch (c) {
+        case 'h':
+            usage(h, argv[0]);
+            break;
+        case 'D':
+            if ((dbg = clixon_debug_str2key(optarg)) < 0 &&
+                sscanf(optarg, "%d", &dbg) != 1){
+                usage(h, argv[0]);
+            }
+            break;
+        case 'f':
+            clicon_option_str_set(h, "CLICON_CONFIGFILE", optarg);
+            break;
+        case 'm':
+            module = optarg;
+            break;
+        case 'p':
+            prefix = optarg;
+            break;
+        case 'o':
+            output = optarg;
+            break;
+        default:
+            usage(h, argv[0]);
+            break;
+        }
+    if (module == NULL)
+        usage(h, argv[0]);
+    clixon_debug_init(h, dbg);
+    if (clicon_options_main(h) < 0)
+        goto done;
+    yang_start(h);
+    if ((yspec = yspec_new1(h, YANG_DOMAIN_TOP, YANG_DATA_TOP)) == NULL)
+        goto done;
+    if ((str = clicon_yang_main_file(h)) != NULL){
+        if (yang_spec_parse_file(h, str, yspec) < 0)
+            goto done;
+    }
+    if ((str = clicon_yang_module_main(h)) != NULL){
+        if (yang_spec_parse_module(h, str, clicon_yang_module_revision(h), yspec) < 0)
+            goto done;
+    }
+    if ((str = clicon_yang_main_dir(h)) != NULL){
+        if (yang_spec_load_dir(h, str, yspec) < 0)
+            goto done;
+    }
+    if ((y.y_mod = yang_find_module_by_name(yspec, module)) == NULL &&
+        yang_spec_parse_module(h, module, NULL, yspec) < 0)
+        goto done;
+    if (y.y_mod == NULL &&
+        (y.y_mod = yang_find_module_by_name(yspec, module)) == NULL){
+        clixon_err(OE_YANG, ENOENT, "Yang module %s not found", module);
+        goto done;
+    }
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    y2c_ident(cb, prefix ? prefix : module, 0);
+    y.y_prefix = cbuf_get(cb);
+    if ((y.y_names = cvec_new(0)) == NULL){
+        clixon_err(OE_UNIX, errno, "cvec_new");
+        goto done;
+    }
+    if (y2c_walk(&y, y.y_mod, -1) < 0)
+        goto done;
+    if (output && (f = fopen(output, "w")) == NULL){
+        clixon_err(OE_UNIX, errno, "fopen %s", output);
+        goto done;
+    }
+    if (y2c_print(&y, f) < 0)
+        goto done;
+    retval = 0;
+ done:
+    if (f && f != stdout)
+        fclose(f);
+    for (i=0; i<y.y_len; i++){
+        if (y.y_nodes[i].yn_id)
+            free(y.y_nodes[i].yn_id);
+        if (y.y_nodes[i].yn_eid)
+            free(y.y_nodes[i].yn_eid);
+    }
+    if (y.y_nodes)
+        free(y.y_nodes);
+    if (y.y_names)
+        cvec_free(y.y_names);
+    if (cb)
+        cbuf_free(cb);
+    if (h){
+        yang_exit(h);
+        if (clicon_conf_xml(h))
+            xml_free(clicon_conf_xml(h));
+        clixon_handle_exit(h);
+    }
+    clixon_err_exit();
+    clixon_log_exit();
+    return retval == 0 ? 0 : 255;
+}